@@ -18,9 +18,12 @@
 
 #include "cuda_stub.hpp"  // cudaStream_t
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace raft::bench::ann {
@@ -65,6 +68,13 @@ inline auto parse_memory_type(const std::string& memory_type) -> MemoryType
   }
 }
 
+/** The memory used by an algorithm (bytes). */
+struct MemoryUsage {
+  size_t current = 0;
+  // the maximum since the last reset
+  size_t peak = 0;
+};
+
 struct AlgoProperty {
   MemoryType dataset_memory_type;
   // neighbors/distances should have same memory type as queries
@@ -109,6 +119,25 @@ class AnnGPU {
    *   - ONLY IF THE ALGORITHM HAS PRODUCED ITS OUTPUT BY THE TIME IT SYNCHRONIZES WITH CPU.
    */
   [[nodiscard]] virtual auto uses_stream() const noexcept -> bool { return true; }
+  /**
+   * The device memory allocated by the algorithm through its memory resources (shared with its
+   * copies), or `std::nullopt` if the algorithm does not track it.
+   */
+  [[nodiscard]] virtual auto get_device_memory_usage() const -> std::optional<MemoryUsage>
+  {
+    return std::nullopt;
+  }
+  /** Start counting the peak of the device memory usage anew from the current usage. */
+  virtual void reset_device_memory_peak() {}
+  /**
+   * Algorithm-specific measurements of the searches done by this instance (not its copies), which
+   * the benchmark reports as counters.
+   */
+  [[nodiscard]] virtual auto get_search_counters() const
+    -> std::vector<std::pair<std::string, double>>
+  {
+    return {};
+  }
   virtual ~AnnGPU() noexcept = default;
 };
 
@@ -151,6 +180,32 @@ class ANN : public AnnBase {
   // and should not release dataset before searching is finished.
   virtual void set_search_dataset(const T* /*dataset*/, size_t /*nrow*/){};
 
+  /**
+   * Add `nrow` vectors to a built index, with the ids [first_id, first_id + nrow).
+   *
+   * The copies of the wrapper (see `copy()`) may be searching concurrently: the wrapper must not
+   * modify the index it shares with them. The extended index is seen by this object and its
+   * future copies only.
+   */
+  virtual void extend(const T* /*dataset*/, size_t /*first_id*/, size_t /*nrow*/)
+  {
+    throw std::runtime_error("extend is not supported by this algorithm");
+  }
+
+  /**
+   * Restrict the following searches to the rows of the index marked in `bitset` (host memory,
+   * bit `i % 32` of the word `i / 32` is set if the row `i` passes, `n_rows` bits in total).
+   * `nullptr` removes the filter.
+   *
+   * The filter is shared with the copies made after the call (see `copy()`).
+   */
+  virtual void set_search_filter(const std::uint32_t* bitset, size_t /*n_rows*/)
+  {
+    if (bitset != nullptr) {
+      throw std::runtime_error("filtered search is not supported by this algorithm");
+    }
+  }
+
   /**
    * Make a shallow copy of the ANN wrapper that shares the resources and ensures thread-safe access
    * to them. */
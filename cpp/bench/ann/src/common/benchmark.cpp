@@ -24,6 +24,7 @@
 #define JSON_DIAGNOSTICS 1
 #include <nlohmann/json.hpp>
 
+#include <cstdlib>
 #include <filesystem>
 #include <memory>
 #include <unordered_map>
@@ -108,4 +109,10 @@ REGISTER_ALGO_INSTANCE(std::uint8_t);
 
 #include "benchmark.hpp"
 
-int main(int argc, char** argv) { return raft::bench::ann::run_main(argc, argv); }
+int main(int argc, char** argv)
+{
+  // Load the kernels on their first launch rather than all the instantiations of libraft at the
+  // creation of the CUDA context; an explicit setting of the user takes precedence.
+  setenv("CUDA_MODULE_LOADING", "LAZY", 0);
+  return raft::bench::ann::run_main(argc, argv);
+}
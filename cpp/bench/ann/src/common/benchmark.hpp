@@ -26,16 +26,23 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <numeric>
+#include <optional>
+#include <random>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 namespace raft::bench::ann {
@@ -116,6 +123,19 @@ inline auto parse_algo_property(AlgoProperty prop, const nlohmann::json& conf) -
   return prop;
 };
 
+/** Report the peak memory usage since the last reset (and the current device memory usage). */
+template <typename AnnT>
+void insert_memory_counters(::benchmark::State& state, AnnT* algo)
+{
+  if (auto device_memory = get_device_memory_usage(algo); device_memory.has_value()) {
+    state.counters.insert({{"device_memory", device_memory->current},
+                           {"device_memory_peak", device_memory->peak}});
+  }
+  if (auto host_memory_peak = get_host_memory_peak(); host_memory_peak.has_value()) {
+    state.counters.insert({{"host_memory_peak", host_memory_peak.value()}});
+  }
+}
+
 template <typename T>
 void bench_build(::benchmark::State& state,
                  std::shared_ptr<const Dataset<T>> dataset,
@@ -148,6 +168,8 @@ void bench_build(::benchmark::State& state,
   const T* base_set      = dataset->base_set(algo_property.dataset_memory_type);
   std::size_t index_size = dataset->base_set_size();
 
+  reset_device_memory_peak(algo.get());
+  reset_host_memory_peak();
   cuda_timer gpu_timer{algo};
   {
     nvtx_case nvtx{state.name()};
@@ -165,10 +187,427 @@ void bench_build(::benchmark::State& state,
     state.counters.insert({"GPU", {gpu_timer.total_time(), benchmark::Counter::kAvgIterations}});
   }
   state.counters.insert({{"index_size", index_size}});
+  insert_memory_counters(state, algo.get());
 
   if (state.skipped()) { return; }
   make_sure_parent_dir_exists(index.file);
   algo->save(index.file);
+  state.counters.insert({{"index_file_size", std::filesystem::file_size(index.file)}});
+}
+
+/**
+ * Arrivals of the queries of one benchmark thread in the open-loop mode.
+ *
+ * The queries arrive as a Poisson process at the given rate, independently of how fast they are
+ * served; the queries that have arrived but are not taken yet form the queue of the thread.
+ */
+struct poisson_arrivals {
+  using clock = std::chrono::steady_clock;
+
+  poisson_arrivals(double rate, std::uint64_t seed, clock::time_point start)
+    : gen_(seed), inter_arrival_(rate), next_(start + draw())
+  {
+  }
+
+  /**
+   * Wait till at least one query has arrived, and take the queued queries (at most `max_count`).
+   *
+   * @return the number of queries taken.
+   */
+  auto take(std::size_t max_count) -> std::size_t
+  {
+    auto now = clock::now();
+    if (next_ > now) {
+      std::this_thread::sleep_until(next_);
+      now = clock::now();
+    }
+    taken_.clear();
+    while (taken_.size() < max_count && next_ <= now) {
+      taken_.push_back(next_);
+      next_ += draw();
+    }
+    return taken_.size();
+  }
+
+  /** Append the latencies (seconds) of the taken queries, which are completed now. */
+  void complete(std::vector<double>& latencies) const
+  {
+    auto now = clock::now();
+    for (auto t : taken_) {
+      latencies.push_back(std::chrono::duration<double>(now - t).count());
+    }
+  }
+
+ private:
+  std::mt19937_64 gen_;
+  std::exponential_distribution<double> inter_arrival_;
+  clock::time_point next_;
+  std::vector<clock::time_point> taken_{};
+
+  auto draw() -> clock::duration
+  {
+    return std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(inter_arrival_(gen_)));
+  }
+};
+
+/** Query latencies of the open-loop mode, merged across the benchmark threads. */
+struct open_loop_latencies {
+  /** Drop the latencies left by a previous benchmark, e.g. if some of its threads failed. */
+  static void reset()
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    all_.clear();
+    n_arrived_ = 0;
+  }
+
+  /**
+   * Add the latencies of one thread.
+   *
+   * @return the latencies of all threads, to the last of `n_threads` threads to arrive.
+   */
+  static auto merge(const std::vector<double>& latencies, int n_threads)
+    -> std::optional<std::vector<double>>
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    all_.insert(all_.end(), latencies.begin(), latencies.end());
+    if (++n_arrived_ < n_threads) { return std::nullopt; }
+    n_arrived_ = 0;
+    return std::make_optional(std::move(all_));
+  }
+
+ private:
+  static inline std::mutex mutex_;
+  static inline std::vector<double> all_;
+  static inline int n_arrived_{0};
+};
+
+/** Settings of the mixed workload mode (`--mode=mixed`). */
+struct mixed_workload_params {
+  /** Fraction of the base set left out of the initial index and inserted while searching. */
+  double insert_fraction = 0.1;
+  /** Number of vectors added to the index by one `extend` call. */
+  std::size_t insert_batch = 10000;
+};
+
+/** Fraction of the neighbors of the first `n_rows` queries found in their `k` ground truth ones. */
+inline auto calc_recall(const AnnBase::index_type* neighbors,
+                        const std::int32_t* gt,
+                        std::uint32_t max_k,
+                        std::uint32_t k,
+                        std::size_t n_rows) -> double
+{
+  std::size_t match_count = 0;
+  for (std::size_t i = 0; i < n_rows; i++) {
+    for (std::uint32_t j = 0; j < k; j++) {
+      auto act_idx = std::int32_t(neighbors[i * k + j]);
+      for (std::uint32_t l = 0; l < k; l++) {
+        if (act_idx == gt[i * max_k + l]) {
+          match_count++;
+          break;
+        }
+      }
+    }
+  }
+  return static_cast<double>(match_count) / static_cast<double>(n_rows * k);
+}
+
+/**
+ * State of a mixed workload run shared by the search threads and the writer thread.
+ *
+ * The writer extends a private copy of the latest index and publishes it; the search threads pick
+ * up the published index before their next batch.
+ */
+template <typename T>
+struct mixed_workload_state {
+  std::mutex mutex;
+  std::unique_ptr<ANN<T>> published{nullptr};
+  std::atomic<int> generation{0};
+  std::atomic<bool> extending{false};
+  std::atomic<bool> stop{false};
+  std::thread writer;
+  std::string writer_error;
+  // (inserted rows, seconds since the start, recall) after every extend
+  std::vector<std::tuple<std::size_t, double, double>> timeline;
+  double extend_time     = 0;
+  std::size_t n_extends  = 0;
+  int n_finished_threads = 0;
+  // Search times and batch counts of all threads, while the writer extends the index or not.
+  double ingest_time   = 0;
+  double idle_time     = 0;
+  std::size_t n_ingest = 0;
+  std::size_t n_idle   = 0;
+
+  /** Get a copy of the latest index, if it's newer than `generation`. */
+  void refresh(std::unique_ptr<ANN<T>>& algo, int& algo_generation)
+  {
+    if (algo && algo_generation == generation.load()) { return; }
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!published) { throw std::runtime_error("The index is not available"); }
+    algo            = published->copy();
+    algo_generation = generation.load();
+  }
+};
+
+template <typename T>
+void mixed_workload_writer(mixed_workload_state<T>& mixed_state,
+                           std::shared_ptr<const Dataset<T>> dataset,
+                           mixed_workload_params params,
+                           AlgoProperty props,
+                           std::size_t n_initial,
+                           std::uint32_t k,
+                           std::size_t n_eval,
+                           int n_threads)
+{
+  // The writer gets its own stream and result buffer in the global pools.
+  raft::bench::ann::benchmark_thread_id = n_threads;
+  raft::bench::ann::benchmark_n_threads = n_threads + 1;
+  const bool has_gt                     = dataset->max_k() >= k;
+  const T* base_set                     = dataset->base_set(props.dataset_memory_type);
+  const T* query_set                    = dataset->query_set(props.query_memory_type);
+  using index_type                      = AnnBase::index_type;
+  auto& result_buf =
+    get_result_buffer_from_global_pool(n_eval * k * (sizeof(float) + sizeof(index_type)));
+  auto* neighbors = reinterpret_cast<index_type*>(result_buf.data(props.query_memory_type));
+  auto* distances = reinterpret_cast<float*>(neighbors + n_eval * k);
+
+  auto start       = std::chrono::high_resolution_clock::now();
+  auto eval_recall = [&]() {
+    if (!has_gt) { return std::numeric_limits<double>::quiet_NaN(); }
+    std::unique_ptr<ANN<T>> algo{nullptr};
+    int algo_generation = -1;
+    mixed_state.refresh(algo, algo_generation);
+    {
+      cuda_timer sync_timer{algo};
+      [[maybe_unused]] auto lap = sync_timer.lap();
+      algo->search(query_set, n_eval, k, neighbors, distances);
+    }
+    result_buf.transfer_data(MemoryType::Host, props.query_memory_type);
+    return calc_recall(reinterpret_cast<index_type*>(result_buf.data(MemoryType::Host)),
+                       dataset->gt_set(),
+                       dataset->max_k(),
+                       k,
+                       n_eval);
+  };
+  auto log_progress = [&](std::size_t n_inserted) {
+    auto elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start);
+    mixed_state.timeline.emplace_back(n_inserted, elapsed.count(), eval_recall());
+  };
+
+  try {
+    log_progress(n_initial);
+    const std::size_t n_rows = dataset->base_set_size();
+    for (std::size_t offset = n_initial; offset < n_rows; offset += params.insert_batch) {
+      if (mixed_state.stop.load()) { break; }
+      auto n = std::min(params.insert_batch, n_rows - offset);
+      std::unique_ptr<ANN<T>> next{nullptr};
+      {
+        std::lock_guard<std::mutex> guard(mixed_state.mutex);
+        next = mixed_state.published->copy();
+      }
+      mixed_state.extending.store(true);
+      auto extend_start = std::chrono::high_resolution_clock::now();
+      next->extend(base_set + offset * dataset->dim(), offset, n);
+      mixed_state.extend_time += std::chrono::duration<double>(
+                                   std::chrono::high_resolution_clock::now() - extend_start)
+                                   .count();
+      mixed_state.extending.store(false);
+      mixed_state.n_extends++;
+      {
+        std::lock_guard<std::mutex> guard(mixed_state.mutex);
+        mixed_state.published = std::move(next);
+        mixed_state.generation++;
+      }
+      log_progress(offset + n);
+    }
+  } catch (const std::exception& e) {
+    mixed_state.extending.store(false);
+    mixed_state.writer_error = e.what();
+  }
+}
+
+/**
+ * Search while another thread inserts the held out part of the base set into the index.
+ *
+ * The initial index is built in-process from the first `(1 - insert_fraction)` of the base set (it
+ * is not read from the index file). Every run starts from this initial index: the wrapper `extend`
+ * leaves the index shared with its copies intact.
+ */
+template <typename T>
+void bench_mixed(::benchmark::State& state,
+                 Configuration::Index index,
+                 std::size_t search_param_ix,
+                 std::shared_ptr<const Dataset<T>> dataset,
+                 Objective metric_objective,
+                 mixed_workload_params params)
+{
+  raft::bench::ann::benchmark_thread_id = state.thread_index();
+  raft::bench::ann::benchmark_n_threads = state.threads();
+  static mixed_workload_state<T> mixed_state;
+
+  const auto& sp_json = index.search_params[search_param_ix];
+  if (state.thread_index() == 0) { dump_parameters(state, sp_json); }
+  const std::uint32_t k            = sp_json["k"];
+  const std::size_t n_queries      = sp_json["n_queries"];
+  const std::size_t query_set_size = (dataset->query_set_size() / n_queries) * n_queries;
+  if (dataset->query_set_size() < n_queries) {
+    state.SkipWithError("Not enough queries in benchmark set.");
+    return;
+  }
+  const std::size_t n_rows    = dataset->base_set_size();
+  const std::size_t n_initial = n_rows - std::size_t(n_rows * params.insert_fraction);
+
+  progress_barrier load_barrier{};
+  if (load_barrier.arrive(1) == 0) {
+    static std::string initial_index_key = "";
+    auto key = index.name + index.build_param.dump() + "/" + std::to_string(n_initial);
+    ANN<T>* algo;
+    try {
+      if (!current_algo || key != initial_index_key ||
+          (algo = dynamic_cast<ANN<T>*>(current_algo.get())) == nullptr) {
+        current_algo.reset();
+        auto ualgo = ann::create_algo<T>(
+          index.algo, dataset->distance(), dataset->dim(), index.build_param, index.dev_list);
+        auto build_props = parse_algo_property(ualgo->get_preference(), index.build_param);
+        ualgo->build(dataset->base_set(build_props.dataset_memory_type), n_initial);
+        algo              = ualgo.get();
+        current_algo      = std::move(ualgo);
+        initial_index_key = key;
+      }
+      current_algo_props = std::make_unique<AlgoProperty>(
+        std::move(parse_algo_property(algo->get_preference(), sp_json)));
+      auto search_param              = ann::create_search_param<T>(index.algo, sp_json);
+      search_param->metric_objective = metric_objective;
+      if (search_param->needs_dataset()) {
+        algo->set_search_dataset(dataset->base_set(current_algo_props->dataset_memory_type),
+                                 dataset->base_set_size());
+      }
+      algo->set_search_param(*search_param);
+    } catch (const std::exception& e) {
+      state.SkipWithError("Failed to create an algo: " + std::string(e.what()));
+      return;
+    }
+
+    mixed_state.published = algo->copy();
+    mixed_state.generation.store(0);
+    mixed_state.extending.store(false);
+    mixed_state.stop.store(false);
+    mixed_state.writer_error.clear();
+    mixed_state.timeline.clear();
+    mixed_state.extend_time        = 0;
+    mixed_state.n_extends          = 0;
+    mixed_state.n_finished_threads = 0;
+    mixed_state.ingest_time        = 0;
+    mixed_state.idle_time          = 0;
+    mixed_state.n_ingest           = 0;
+    mixed_state.n_idle             = 0;
+    mixed_state.writer             = std::thread(mixed_workload_writer<T>,
+                                                 std::ref(mixed_state),
+                                                 dataset,
+                                                 params,
+                                                 *current_algo_props,
+                                                 n_initial,
+                                                 k,
+                                                 n_queries,
+                                                 state.threads());
+    load_barrier.arrive(state.threads());
+  } else {
+    load_barrier.wait(state.threads() * 2);
+  }
+  const T* query_set = dataset->query_set(current_algo_props->query_memory_type);
+
+  using index_type = AnnBase::index_type;
+  auto& result_buf =
+    get_result_buffer_from_global_pool(n_queries * k * (sizeof(float) + sizeof(index_type)));
+  auto* neighbors_ptr =
+    reinterpret_cast<index_type*>(result_buf.data(current_algo_props->query_memory_type));
+  auto* distances_ptr = reinterpret_cast<float*>(neighbors_ptr + n_queries * k);
+
+  std::size_t queries_processed = 0;
+  double ingest_time = 0, idle_time = 0;
+  std::size_t n_ingest = 0, n_idle = 0;
+  {
+    nvtx_case nvtx{state.name()};
+    std::unique_ptr<ANN<T>> algo{nullptr};
+    int algo_generation = -1;
+    try {
+      mixed_state.refresh(algo, algo_generation);
+    } catch (const std::exception& e) {
+      state.SkipWithError("Algo::copy: " + std::string(e.what()));
+    }
+    cuda_timer gpu_timer{algo};
+    std::ptrdiff_t batch_offset   = (state.thread_index() * n_queries) % query_set_size;
+    std::ptrdiff_t queries_stride = state.threads() * n_queries;
+    for (auto _ : state) {
+      [[maybe_unused]] auto ntx_lap = nvtx.lap();
+      bool ingest                   = false;
+      auto batch_start              = std::chrono::high_resolution_clock::now();
+      try {
+        // Switch to the latest extended index; the copy keeps the stream of this thread.
+        mixed_state.refresh(algo, algo_generation);
+        ingest                        = mixed_state.extending.load();
+        batch_start                   = std::chrono::high_resolution_clock::now();
+        [[maybe_unused]] auto gpu_lap = gpu_timer.lap();
+        algo->search(
+          query_set + batch_offset * dataset->dim(), n_queries, k, neighbors_ptr, distances_ptr);
+      } catch (const std::exception& e) {
+        state.SkipWithError("Benchmark loop: " + std::string(e.what()));
+        break;
+      }
+      auto batch_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() -
+                                                      batch_start)
+                          .count();
+      if (ingest || mixed_state.extending.load()) {
+        ingest_time += batch_time;
+        n_ingest++;
+      } else {
+        idle_time += batch_time;
+        n_idle++;
+      }
+      batch_offset = (batch_offset + queries_stride) % query_set_size;
+      queries_processed += n_queries;
+    }
+  }
+  state.SetItemsProcessed(queries_processed);
+  state.counters.insert({{"total_queries", queries_processed}});
+
+  // The last thread to finish stops the writer and reports the results of the run.
+  {
+    std::lock_guard<std::mutex> guard(mixed_state.mutex);
+    mixed_state.ingest_time += ingest_time;
+    mixed_state.idle_time += idle_time;
+    mixed_state.n_ingest += n_ingest;
+    mixed_state.n_idle += n_idle;
+    if (++mixed_state.n_finished_threads < state.threads()) { return; }
+  }
+  mixed_state.stop.store(true);
+  if (mixed_state.writer.joinable()) { mixed_state.writer.join(); }
+  mixed_state.published.reset();
+  if (!mixed_state.writer_error.empty()) {
+    state.SkipWithError("Extend: " + mixed_state.writer_error);
+    return;
+  }
+  auto mean           = [](double t, std::size_t n) { return n > 0 ? t / n : 0.0; };
+  auto latency_idle   = mean(mixed_state.idle_time, mixed_state.n_idle);
+  auto latency_ingest = mean(mixed_state.ingest_time, mixed_state.n_ingest);
+  state.counters.insert({{"Latency_idle", latency_idle},
+                         {"Latency_ingest", latency_ingest},
+                         {"extend_time", mean(mixed_state.extend_time, mixed_state.n_extends)},
+                         {"inserted_rows", std::get<0>(mixed_state.timeline.back()) - n_initial}});
+  if (latency_idle > 0 && latency_ingest > 0) {
+    state.counters.insert({{"latency_degradation", latency_ingest / latency_idle}});
+  }
+  if (!std::isnan(std::get<2>(mixed_state.timeline.front()))) {
+    state.counters.insert({{"Recall_initial", std::get<2>(mixed_state.timeline.front())},
+                           {"Recall_final", std::get<2>(mixed_state.timeline.back())}});
+  }
+  for (auto [n_inserted, elapsed, recall] : mixed_state.timeline) {
+    log_info("%s: %zu rows indexed after %.3f s, recall %.4f",
+             state.name().c_str(),
+             n_inserted,
+             elapsed,
+             recall);
+  }
 }
 
 template <typename T>
@@ -176,7 +615,8 @@ void bench_search(::benchmark::State& state,
                   Configuration::Index index,
                   std::size_t search_param_ix,
                   std::shared_ptr<const Dataset<T>> dataset,
-                  Objective metric_objective)
+                  Objective metric_objective,
+                  double target_qps)
 {
   // NB: these two thread-local vars can be used within algo wrappers
   raft::bench::ann::benchmark_thread_id = state.thread_index();
@@ -202,6 +642,18 @@ void bench_search(::benchmark::State& state,
     return;
   }
 
+  // Optionally, restrict the search to a part of the base set
+  const FilterSet* filter = nullptr;
+  if (sp_json.contains("filter_selectivity")) {
+    try {
+      auto filter_type = parse_filter_type(sp_json.value("filter_type", std::string("random")));
+      filter           = &dataset->filter(sp_json["filter_selectivity"], filter_type, k);
+    } catch (const std::exception& e) {
+      state.SkipWithError("Failed to create a filter: " + std::string(e.what()));
+      return;
+    }
+  }
+
   // Each thread start from a different offset, so that the queries that they process do not
   // overlap.
   std::ptrdiff_t batch_offset   = (state.thread_index() * n_queries) % query_set_size;
@@ -223,6 +675,7 @@ void bench_search(::benchmark::State& state,
   if (load_barrier.arrive(1) == 0) {
     // algo is static to cache it between close search runs to save time on index loading
     static std::string index_file = "";
+    static double load_time       = 0;
     if (index.file != index_file) {
       current_algo.reset();
       index_file = index.file;
@@ -234,9 +687,12 @@ void bench_search(::benchmark::State& state,
       if (!current_algo || (algo = dynamic_cast<ANN<T>*>(current_algo.get())) == nullptr) {
         auto ualgo = ann::create_algo<T>(
           index.algo, dataset->distance(), dataset->dim(), index.build_param, index.dev_list);
-        algo = ualgo.get();
+        algo            = ualgo.get();
+        auto load_start = std::chrono::high_resolution_clock::now();
         algo->load(index_file);
-        current_algo = std::move(ualgo);
+        auto load_end = std::chrono::high_resolution_clock::now();
+        load_time     = std::chrono::duration<double>(load_end - load_start).count();
+        current_algo  = std::move(ualgo);
       }
       search_param                   = ann::create_search_param<T>(index.algo, sp_json);
       search_param->metric_objective = metric_objective;
@@ -265,8 +721,26 @@ void bench_search(::benchmark::State& state,
       state.SkipWithError("An error occurred setting search parameters: " + std::string(ex.what()));
       return;
     }
+    try {
+      // The algo is reused by the following cases, so the filter is reset when not needed.
+      if (filter != nullptr) {
+        algo->set_search_filter(filter->bitset.data(), dataset->base_set_size());
+      } else {
+        algo->set_search_filter(nullptr, 0);
+      }
+    } catch (const std::exception& ex) {
+      state.SkipWithError("An error occurred setting the search filter: " + std::string(ex.what()));
+      return;
+    }
+    // The cost of keeping the index: the time to load it (maybe in a previous case, as the algo is
+    // cached) and its size on disk. The peak memory usage is counted from here.
+    state.counters.insert({{"load_time", load_time},
+                           {"index_file_size", std::filesystem::file_size(index_file)}});
+    reset_device_memory_peak(algo);
+    reset_host_memory_peak();
 
     query_set = dataset->query_set(current_algo_props->query_memory_type);
+    open_loop_latencies::reset();
     load_barrier.arrive(state.threads());
   } else {
     // All other threads will wait for the first thread to initialize the algo.
@@ -303,35 +777,88 @@ void bench_search(::benchmark::State& state,
     }
     // Initialize with algo, so that the timer.lap() object can sync with algo::get_sync_stream()
     cuda_timer gpu_timer{algo};
-    auto start = std::chrono::high_resolution_clock::now();
+    // In the open-loop mode, every iteration searches the queries that have arrived by then, at
+    // most up to the end of the current batch of `n_queries`.
+    const bool open_loop = target_qps > 0;
+    std::optional<poisson_arrivals> arrivals{std::nullopt};
+    std::vector<double> latencies{};
+    std::size_t batch_pos = 0;
+    auto start            = std::chrono::high_resolution_clock::now();
+    if (open_loop) {
+      arrivals.emplace(target_qps / state.threads(),
+                       std::uint64_t(state.thread_index()),
+                       std::chrono::steady_clock::now());
+    }
     for (auto _ : state) {
       [[maybe_unused]] auto ntx_lap = nvtx.lap();
-      [[maybe_unused]] auto gpu_lap = gpu_timer.lap();
+      std::size_t batch_size        = open_loop ? arrivals->take(n_queries - batch_pos) : n_queries;
       try {
-        algo->search(query_set + batch_offset * dataset->dim(),
-                     n_queries,
+        // The lap synchronizes with the algorithm stream on exit.
+        [[maybe_unused]] auto gpu_lap = gpu_timer.lap();
+        algo->search(query_set + (batch_offset + batch_pos) * dataset->dim(),
+                     batch_size,
                      k,
-                     neighbors_ptr + out_offset * k,
-                     distances_ptr + out_offset * k);
+                     neighbors_ptr + (out_offset + batch_pos) * k,
+                     distances_ptr + (out_offset + batch_pos) * k);
       } catch (const std::exception& e) {
         state.SkipWithError("Benchmark loop: " + std::string(e.what()));
         break;
       }
+      if (open_loop) { arrivals->complete(latencies); }
 
       // advance to the next batch
-      batch_offset = (batch_offset + queries_stride) % query_set_size;
-      out_offset   = (out_offset + n_queries) % query_set_size;
+      batch_pos += batch_size;
+      if (batch_pos == n_queries) {
+        batch_pos    = 0;
+        batch_offset = (batch_offset + queries_stride) % query_set_size;
+        out_offset   = (out_offset + n_queries) % query_set_size;
+      }
 
-      queries_processed += n_queries;
+      queries_processed += batch_size;
     }
     auto end      = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
-    if (state.thread_index() == 0) { state.counters.insert({{"end_to_end", duration}}); }
+    if (state.thread_index() == 0) {
+      state.counters.insert({{"end_to_end", duration}});
+      // gbench makes all threads finish their loops before any of them gets here
+      insert_memory_counters(state, current_algo.get());
+      for (auto [name, value] : get_search_counters(algo.get())) {
+        state.counters.insert({{name, value}});
+      }
+    }
     state.counters.insert({"Latency", {duration, benchmark::Counter::kAvgIterations}});
+    if (!index.dev_list.empty()) {
+      // To see how the throughput scales with the number of devices (see MultiGpuAnn)
+      const auto n_gpus = index.dev_list.size();
+      if (state.thread_index() == 0) { state.counters.insert({{"n_gpus", n_gpus}}); }
+      state.counters.insert(
+        {"qps_per_gpu", {double(queries_processed) / n_gpus, benchmark::Counter::kIsRate}});
+    }
 
     if (gpu_timer.active()) {
       state.counters.insert({"GPU", {gpu_timer.total_time(), benchmark::Counter::kAvgIterations}});
     }
+
+    if (open_loop) {
+      // Sum of the per-thread rates.
+      state.counters.insert({{"achieved_qps", queries_processed / duration}});
+      auto n_batches       = std::max<int64_t>(1, state.iterations());
+      auto mean_batch_size = double(queries_processed) / double(n_batches);
+      state.counters.insert(
+        {"mean_batch_size", {mean_batch_size, benchmark::Counter::kAvgThreads}});
+      auto all_latencies = open_loop_latencies::merge(latencies, state.threads());
+      if (all_latencies.has_value() && !all_latencies->empty()) {
+        auto& l = all_latencies.value();
+        std::sort(l.begin(), l.end());
+        auto percentile = [&l](double q) {
+          return l[std::min<std::size_t>(l.size() - 1, std::size_t(q * l.size()))];
+        };
+        state.counters.insert({{"target_qps", target_qps},
+                               {"Latency_p50", percentile(0.5)},
+                               {"Latency_p99", percentile(0.99)},
+                               {"Latency_p999", percentile(0.999)}});
+      }
+    }
   }
 
   state.SetItemsProcessed(queries_processed);
@@ -343,14 +870,17 @@ void bench_search(::benchmark::State& state,
 
   // Each thread calculates recall on their partition of queries.
   // evaluate recall
-  if (dataset->max_k() >= k) {
-    const std::int32_t* gt    = dataset->gt_set();
-    const std::uint32_t max_k = dataset->max_k();
+  if (filter != nullptr || dataset->max_k() >= k) {
+    // With a filter, the neighbors are compared to the ground truth of the filtered search.
+    const std::int32_t* gt    = filter != nullptr ? filter->gt.data() : dataset->gt_set();
+    const std::uint32_t max_k = filter != nullptr ? filter->k : dataset->max_k();
     result_buf.transfer_data(MemoryType::Host, current_algo_props->query_memory_type);
     auto* neighbors_host    = reinterpret_cast<index_type*>(result_buf.data(MemoryType::Host));
     std::size_t rows        = std::min(queries_processed, query_set_size);
     std::size_t match_count = 0;
-    std::size_t total_count = rows * static_cast<size_t>(k);
+    // Fewer than k rows may pass the filter
+    std::size_t row_k       = filter != nullptr ? std::min<std::size_t>(k, filter->n_passing) : k;
+    std::size_t total_count = rows * row_k;
 
     // We go through the groundtruth with same stride as the benchmark loop.
     size_t out_offset   = 0;
@@ -364,7 +894,8 @@ void bench_search(::benchmark::State& state,
             auto act_idx = std::int32_t(neighbors_host[i_out_idx * k + j]);
             for (std::uint32_t l = 0; l < k; l++) {
               auto exp_idx = gt[i_orig_idx * max_k + l];
-              if (act_idx == exp_idx) {
+              // the filtered ground truth is padded with -1
+              if (act_idx == exp_idx && exp_idx >= 0) {
                 match_count++;
                 break;
               }
@@ -380,6 +911,226 @@ void bench_search(::benchmark::State& state,
   }
 }
 
+/** A search configuration evaluated by `tune_search_params`. */
+struct tuning_candidate {
+  std::size_t search_param_ix;
+  double recall = 0;
+  double qps    = 0;
+};
+
+/**
+ * Rank the candidates by Pareto layers in (recall, QPS): rank 0 is the frontier, rank 1 is the
+ * frontier of the rest, and so on.
+ */
+inline auto pareto_ranks(const std::vector<tuning_candidate>& candidates) -> std::vector<int>
+{
+  auto dominates = [](const tuning_candidate& a, const tuning_candidate& b) {
+    return a.recall >= b.recall && a.qps >= b.qps && (a.recall > b.recall || a.qps > b.qps);
+  };
+  const auto n = candidates.size();
+  std::vector<int> ranks(n, -1);
+  std::size_t n_ranked = 0;
+  for (int rank = 0; n_ranked < n; rank++) {
+    std::vector<std::size_t> layer;
+    for (std::size_t i = 0; i < n; i++) {
+      if (ranks[i] >= 0) { continue; }
+      bool dominated = false;
+      for (std::size_t j = 0; j < n && !dominated; j++) {
+        dominated = (ranks[j] < 0 || ranks[j] == rank) && j != i &&
+                    dominates(candidates[j], candidates[i]);
+      }
+      if (!dominated) { layer.push_back(i); }
+    }
+    for (auto i : layer) {
+      ranks[i] = rank;
+    }
+    n_ranked += layer.size();
+  }
+  return ranks;
+}
+
+/**
+ * Search the first `n_eval` queries (rounded down to full batches) with the search parameters
+ * `sp_json`, and measure the recall and the single-thread throughput.
+ */
+template <typename T>
+auto evaluate_search_param(const std::unique_ptr<ANN<T>>& algo,
+                           const Configuration::Index& index,
+                           const nlohmann::json& sp_json,
+                           const Dataset<T>& dataset,
+                           Objective metric_objective,
+                           std::size_t n_eval) -> tuning_candidate
+{
+  const std::uint32_t k       = sp_json["k"];
+  const std::size_t n_queries = sp_json["n_queries"];
+  n_eval                      = std::max(n_queries, (n_eval / n_queries) * n_queries);
+
+  auto search_param              = ann::create_search_param<T>(index.algo, sp_json);
+  search_param->metric_objective = metric_objective;
+  auto props = parse_algo_property(algo->get_preference(), sp_json);
+  if (search_param->needs_dataset()) {
+    algo->set_search_dataset(dataset.base_set(props.dataset_memory_type), dataset.base_set_size());
+  }
+  algo->set_search_param(*search_param);
+  algo->set_search_filter(nullptr, 0);
+
+  using index_type = AnnBase::index_type;
+  const T* queries = dataset.query_set(props.query_memory_type);
+  auto& result_buf =
+    get_result_buffer_from_global_pool(n_eval * k * (sizeof(float) + sizeof(index_type)));
+  auto* neighbors = reinterpret_cast<index_type*>(result_buf.data(props.query_memory_type));
+  auto* distances = reinterpret_cast<float*>(neighbors + n_eval * k);
+
+  cuda_timer sync_timer{algo};
+  auto search_batch = [&](std::size_t offset) {
+    [[maybe_unused]] auto lap = sync_timer.lap();
+    algo->search(queries + offset * dataset.dim(),
+                 n_queries,
+                 k,
+                 neighbors + offset * k,
+                 distances + offset * k);
+  };
+  // warm-up, so that the first-call overheads do not penalize the short evaluations
+  search_batch(0);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (std::size_t offset = 0; offset < n_eval; offset += n_queries) {
+    search_batch(offset);
+  }
+  auto duration =
+    std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+  result_buf.transfer_data(MemoryType::Host, props.query_memory_type);
+  tuning_candidate result{};
+  result.recall = calc_recall(reinterpret_cast<index_type*>(result_buf.data(MemoryType::Host)),
+                              dataset.gt_set(),
+                              dataset.max_k(),
+                              k,
+                              n_eval);
+  result.qps    = double(n_eval) / duration;
+  return result;
+}
+
+/**
+ * Reduce the search parameters of an index to its Pareto frontier in (recall, QPS) by successive
+ * halving.
+ *
+ * All configurations are first evaluated on a small part of the query set; the best half of them
+ * by Pareto rank (but at least the whole frontier) is evaluated again on twice as many queries, and
+ * so on until the last round uses the whole query set. Within a Pareto layer, the configurations
+ * reaching `target_recall` are preferred, then the faster ones. The index is left unchanged if
+ * the tuning is not possible (no ground truth, no index file, or filtered search parameters).
+ */
+template <typename T>
+auto tune_search_params(std::shared_ptr<const Dataset<T>> dataset,
+                        Configuration::Index index,
+                        Objective metric_objective,
+                        double target_recall) -> Configuration::Index
+{
+  const auto n_params = index.search_params.size();
+  if (n_params <= 1) { return index; }
+  for (const auto& sp_json : index.search_params) {
+    if (sp_json.contains("filter_selectivity") || dataset->max_k() < sp_json["k"] ||
+        dataset->query_set_size() < sp_json["n_queries"]) {
+      log_warn("%s: the tuning needs the ground truth of unfiltered searches; keeping all %zu "
+               "search configurations.",
+               index.name.c_str(),
+               n_params);
+      return index;
+    }
+  }
+  if (!file_exists(index.file)) {
+    log_warn("%s: the index file is missing; keeping all search configurations.",
+             index.name.c_str());
+    return index;
+  }
+
+  std::vector<tuning_candidate> candidates(n_params);
+  std::vector<tuning_candidate> survivors;
+  try {
+    auto algo = ann::create_algo<T>(
+      index.algo, dataset->distance(), dataset->dim(), index.build_param, index.dev_list);
+    algo->load(index.file);
+
+    const std::size_t n_total = dataset->query_set_size();
+    int n_rounds              = 1;
+    while ((std::size_t{1} << n_rounds) < n_params) {
+      n_rounds++;
+    }
+    for (std::size_t i = 0; i < n_params; i++) {
+      candidates[i].search_param_ix = i;
+    }
+    survivors = candidates;
+    for (int round = 0; round < n_rounds; round++) {
+      const std::size_t n_eval = std::max<std::size_t>(1, n_total >> (n_rounds - 1 - round));
+      for (auto& c : survivors) {
+        auto r   = evaluate_search_param<T>(
+          algo, index, index.search_params[c.search_param_ix], *dataset, metric_objective, n_eval);
+        c.recall = r.recall;
+        c.qps    = r.qps;
+      }
+      auto ranks = pareto_ranks(survivors);
+      if (round + 1 == n_rounds) {
+        std::vector<tuning_candidate> frontier;
+        for (std::size_t i = 0; i < survivors.size(); i++) {
+          if (ranks[i] == 0) { frontier.push_back(survivors[i]); }
+        }
+        survivors = std::move(frontier);
+        break;
+      }
+      std::vector<std::size_t> order(survivors.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        const auto& x = survivors[a];
+        const auto& y = survivors[b];
+        return std::make_tuple(ranks[a], x.recall < target_recall, -x.qps) <
+               std::make_tuple(ranks[b], y.recall < target_recall, -y.qps);
+      });
+      auto n_frontier = std::count(ranks.begin(), ranks.end(), 0);
+      auto n_keep     = std::max<std::size_t>((survivors.size() + 1) / 2, n_frontier);
+      std::vector<tuning_candidate> kept;
+      for (std::size_t i = 0; i < n_keep; i++) {
+        kept.push_back(survivors[order[i]]);
+      }
+      survivors = std::move(kept);
+    }
+  } catch (const std::exception& e) {
+    log_warn("%s: the tuning failed (%s); keeping all search configurations.",
+             index.name.c_str(),
+             e.what());
+    return index;
+  }
+
+  std::sort(survivors.begin(), survivors.end(), [](const auto& a, const auto& b) {
+    return a.recall < b.recall;
+  });
+  const tuning_candidate* best = nullptr;
+  for (const auto& c : survivors) {
+    if (c.recall >= target_recall && (best == nullptr || c.qps > best->qps)) { best = &c; }
+  }
+  log_info("%s: %zu of %zu search configurations are on the Pareto frontier",
+           index.name.c_str(),
+           survivors.size(),
+           n_params);
+  for (const auto& c : survivors) {
+    log_info("  recall %.4f, %.0f QPS: %s%s",
+             c.recall,
+             c.qps,
+             index.search_params[c.search_param_ix].dump().c_str(),
+             &c == best ? " (fastest reaching the target recall)" : "");
+  }
+  if (best == nullptr) {
+    log_warn(
+      "%s: no search configuration reaches the recall %g", index.name.c_str(), target_recall);
+  }
+
+  std::vector<nlohmann::json> frontier_params;
+  for (const auto& c : survivors) {
+    frontier_params.push_back(index.search_params[c.search_param_ix]);
+  }
+  index.search_params = std::move(frontier_params);
+  return index;
+}
+
 inline void printf_usage()
 {
   ::benchmark::PrintDefaultHelp();
@@ -389,7 +1140,10 @@ inline void printf_usage()
           "          [--data_prefix=<prefix>]\n"
           "          [--index_prefix=<prefix>]\n"
           "          [--override_kv=<key:value1:value2:...:valueN>]\n"
-          "          [--mode=<latency|throughput>\n"
+          "          [--mode=<latency|throughput|open_loop|mixed>\n"
+          "          [--target_qps=<qps>]\n"
+          "          [--insert_fraction=<fraction>] [--insert_batch=<n_rows>]\n"
+          "          [--tune_recall=<recall>]\n"
           "          [--threads=min[:max]]\n"
           "          <conf>.json\n"
           "\n"
@@ -408,10 +1162,24 @@ inline void printf_usage()
           " override a build/search key one or more times multiplying the number of configurations;"
           " you can use this parameter multiple times to get the Cartesian product of benchmark"
           " configs.\n"
-          "  --mode=<latency|throughput>"
+          "  --mode=<latency|throughput|open_loop|mixed>"
           " run the benchmarks in latency (accumulate times spent in each batch) or "
-          " throughput (pipeline batches and measure end-to-end) mode\n"
-          "  --threads=min[:max] specify the number threads to use for throughput benchmark."
+          " throughput (pipeline batches and measure end-to-end) mode, or in the open_loop mode:"
+          " the queries arrive at random (Poisson) times at the rate --target_qps, independently"
+          " of the search, every thread searches the queries queued up by then (up to n_queries"
+          " at once), and the percentiles of the query latencies are reported\n"
+          "  --target_qps=<qps> the total arrival rate of the queries in the open_loop mode\n"
+          "  In the mixed mode, the index is built from a part of the base set, and a writer thread"
+          " inserts the rest of it with `extend` while the benchmark threads search\n"
+          "  --insert_fraction=<fraction> the part of the base set inserted in the mixed mode"
+          " (default = 0.1)\n"
+          "  --insert_batch=<n_rows> the number of rows inserted by one extend call in the mixed"
+          " mode (default = 10000)\n"
+          "  --tune_recall=<recall> in the search mode, evaluate the search configurations of every"
+          " index on growing parts of the query set, keep only those on the recall/QPS Pareto"
+          " frontier, and benchmark these; the fastest one reaching <recall> is logged\n"
+          "  --threads=min[:max] specify the number threads to use for throughput, open_loop or"
+          " mixed benchmark."
           " Power of 2 values between 'min' and 'max' will be used. If only 'min' is specified,"
           " then a single test is run with 'min' threads. By default min=1, max=<num hyper"
           " threads>.\n");
@@ -440,25 +1208,40 @@ template <typename T>
 void register_search(std::shared_ptr<const Dataset<T>> dataset,
                      std::vector<Configuration::Index> indices,
                      Objective metric_objective,
-                     const std::vector<int>& threads)
+                     const std::vector<int>& threads,
+                     double target_qps,
+                     std::optional<mixed_workload_params> mixed)
 {
   for (auto index : indices) {
     for (std::size_t i = 0; i < index.search_params.size(); i++) {
       auto suf = static_cast<std::string>(index.search_params[i]["override_suffix"]);
       index.search_params[i].erase("override_suffix");
 
-      auto* b = ::benchmark::RegisterBenchmark(
-                  index.name + suf, bench_search<T>, index, i, dataset, metric_objective)
-                  ->Unit(benchmark::kMillisecond)
-                  /**
-                   * The following are important for getting accuracy QPS measurements on both CPU
-                   * and GPU These make sure that
-                   *   - `end_to_end` ~ (`Time` * `Iterations`)
-                   *   - `items_per_second` ~ (`total_queries` / `end_to_end`)
-                   *   - Throughput = `items_per_second`
-                   */
-                  ->MeasureProcessCPUTime()
-                  ->UseRealTime();
+      auto* b = mixed.has_value()
+                  ? ::benchmark::RegisterBenchmark(index.name + suf,
+                                                   bench_mixed<T>,
+                                                   index,
+                                                   i,
+                                                   dataset,
+                                                   metric_objective,
+                                                   mixed.value())
+                  : ::benchmark::RegisterBenchmark(index.name + suf,
+                                                   bench_search<T>,
+                                                   index,
+                                                   i,
+                                                   dataset,
+                                                   metric_objective,
+                                                   target_qps);
+      b->Unit(benchmark::kMillisecond)
+        /**
+         * The following are important for getting accuracy QPS measurements on both CPU
+         * and GPU These make sure that
+         *   - `end_to_end` ~ (`Time` * `Iterations`)
+         *   - `items_per_second` ~ (`total_queries` / `end_to_end`)
+         *   - Throughput = `items_per_second`
+         */
+        ->MeasureProcessCPUTime()
+        ->UseRealTime();
       if (metric_objective == Objective::THROUGHPUT) {
         if (index.algo.find("faiss_gpu") != std::string::npos) {
           log_warn(
@@ -480,7 +1263,10 @@ void dispatch_benchmark(const Configuration& conf,
                         std::string index_prefix,
                         kv_series override_kv,
                         Objective metric_objective,
-                        const std::vector<int>& threads)
+                        const std::vector<int>& threads,
+                        double target_qps,
+                        std::optional<mixed_workload_params> mixed,
+                        std::optional<double> tune_recall)
 {
   if (cudart.found()) {
     for (auto [key, value] : cuda_info()) {
@@ -548,8 +1334,11 @@ void dispatch_benchmark(const Configuration& conf,
     for (auto& index : indices) {
       index.search_params = apply_overrides(index.search_params, override_kv);
       index.file          = combine_path(index_prefix, index.file);
+      if (tune_recall.has_value()) {
+        index = tune_search_params<T>(dataset, index, metric_objective, tune_recall.value());
+      }
     }
-    register_search<T>(dataset, indices, metric_objective, threads);
+    register_search<T>(dataset, indices, metric_objective, threads, target_qps, mixed);
   }
 }
 
@@ -574,17 +1363,21 @@ inline auto parse_string_flag(const char* arg, const char* pat, std::string& res
 
 inline auto run_main(int argc, char** argv) -> int
 {
-  bool force_overwrite        = false;
-  bool build_mode             = false;
-  bool search_mode            = false;
-  std::string data_prefix     = "data";
-  std::string index_prefix    = "index";
-  std::string new_override_kv = "";
-  std::string mode            = "latency";
-  std::string threads_arg_txt = "";
-  std::vector<int> threads    = {1, -1};  // min_thread, max_thread
-  std::string log_level_str   = "";
-  int raft_log_level          = raft::logger::get(RAFT_NAME).get_level();
+  bool force_overwrite            = false;
+  bool build_mode                 = false;
+  bool search_mode                = false;
+  std::string data_prefix         = "data";
+  std::string index_prefix        = "index";
+  std::string new_override_kv     = "";
+  std::string mode                = "latency";
+  std::string threads_arg_txt     = "";
+  std::string target_qps_txt      = "";
+  std::string insert_fraction_txt = "";
+  std::string insert_batch_txt    = "";
+  std::string tune_recall_txt     = "";
+  std::vector<int> threads        = {1, -1};  // min_thread, max_thread
+  std::string log_level_str       = "";
+  int raft_log_level              = raft::logger::get(RAFT_NAME).get_level();
   kv_series override_kv{};
 
   char arg0_default[] = "benchmark";  // NOLINT
@@ -610,6 +1403,10 @@ inline auto run_main(int argc, char** argv) -> int
         parse_string_flag(argv[i], "--mode", mode) ||
         parse_string_flag(argv[i], "--override_kv", new_override_kv) ||
         parse_string_flag(argv[i], "--threads", threads_arg_txt) ||
+        parse_string_flag(argv[i], "--target_qps", target_qps_txt) ||
+        parse_string_flag(argv[i], "--insert_fraction", insert_fraction_txt) ||
+        parse_string_flag(argv[i], "--insert_batch", insert_batch_txt) ||
+        parse_string_flag(argv[i], "--tune_recall", tune_recall_txt) ||
         parse_string_flag(argv[i], "--raft_log_level", log_level_str)) {
       if (!log_level_str.empty()) {
         raft_log_level = std::stoi(log_level_str);
@@ -648,11 +1445,48 @@ inline auto run_main(int argc, char** argv) -> int
   Objective metric_objective = Objective::LATENCY;
   if (mode == "throughput") { metric_objective = Objective::THROUGHPUT; }
 
+  // The open-loop mode measures the latency of the queries, with one or more threads serving them.
+  double target_qps = 0;
+  bool open_loop    = mode == "open_loop";
+  if (open_loop) {
+    if (!target_qps_txt.empty()) { target_qps = std::stod(target_qps_txt); }
+    if (target_qps <= 0) {
+      log_error("The open_loop mode requires a positive --target_qps");
+      return -1;
+    }
+    if (threads[1] == -1) { threads[1] = threads[0]; }
+    // Multiple threads call the algorithm concurrently, as in the throughput mode.
+    if (threads[1] > 1) { metric_objective = Objective::THROUGHPUT; }
+  }
+
+  // The mixed mode searches concurrently with the writer thread, as in the throughput mode.
+  std::optional<mixed_workload_params> mixed{std::nullopt};
+  if (mode == "mixed") {
+    mixed.emplace();
+    if (!insert_fraction_txt.empty()) { mixed->insert_fraction = std::stod(insert_fraction_txt); }
+    if (!insert_batch_txt.empty()) { mixed->insert_batch = std::stoull(insert_batch_txt); }
+    if (mixed->insert_fraction <= 0 || mixed->insert_fraction >= 1 || mixed->insert_batch == 0) {
+      log_error("The mixed mode requires 0 < --insert_fraction < 1 and a positive --insert_batch");
+      return -1;
+    }
+    metric_objective = Objective::THROUGHPUT;
+  }
+
+  // Prune the search configurations to their Pareto frontier before benchmarking them.
+  std::optional<double> tune_recall{std::nullopt};
+  if (!tune_recall_txt.empty()) {
+    tune_recall = std::stod(tune_recall_txt);
+    if (*tune_recall <= 0 || *tune_recall > 1) {
+      log_error("--tune_recall must be in (0, 1]");
+      return -1;
+    }
+  }
+
   int max_threads =
     (metric_objective == Objective::THROUGHPUT) ? std::thread::hardware_concurrency() : 1;
   if (threads[1] == -1) threads[1] = max_threads;
 
-  if (metric_objective == Objective::LATENCY) {
+  if (metric_objective == Objective::LATENCY && !open_loop) {
     if (threads[0] != 1 || threads[1] != 1) {
       log_warn("Latency mode enabled. Overriding threads arg, running with single thread.");
       threads = {1, 1};
@@ -686,7 +1520,10 @@ inline auto run_main(int argc, char** argv) -> int
                               index_prefix,
                               override_kv,
                               metric_objective,
-                              threads);
+                              threads,
+                              target_qps,
+                              mixed,
+                              tune_recall);
   } else if (dtype == "half") {
     dispatch_benchmark<half>(conf,
                              force_overwrite,
@@ -696,7 +1533,10 @@ inline auto run_main(int argc, char** argv) -> int
                              index_prefix,
                              override_kv,
                              metric_objective,
-                             threads);
+                             threads,
+                             target_qps,
+                             mixed,
+                             tune_recall);
   } else if (dtype == "uint8") {
     dispatch_benchmark<std::uint8_t>(conf,
                                      force_overwrite,
@@ -706,7 +1546,10 @@ inline auto run_main(int argc, char** argv) -> int
                                      index_prefix,
                                      override_kv,
                                      metric_objective,
-                                     threads);
+                                     threads,
+                                     target_qps,
+                                     mixed,
+                                     tune_recall);
   } else if (dtype == "int8") {
     dispatch_benchmark<std::int8_t>(conf,
                                     force_overwrite,
@@ -716,7 +1559,10 @@ inline auto run_main(int argc, char** argv) -> int
                                     index_prefix,
                                     override_kv,
                                     metric_objective,
-                                    threads);
+                                    threads,
+                                    target_qps,
+                                    mixed,
+                                    tune_recall);
   } else {
     log_error("datatype '%s' is not supported", dtype.c_str());
     return -1;
@@ -129,6 +129,9 @@ class Configuration {
         if (index.dev_list.empty()) { throw std::runtime_error("dev_list shouln't be empty!"); }
         index.dev_list.shrink_to_fit();
         index.build_param["multigpu"] = conf["multigpu"];
+        if (conf.contains("multigpu_mode")) {
+          index.build_param["multigpu_mode"] = conf.at("multigpu_mode");
+        }
       }
 
       for (auto param : conf.at("search_params")) {
@@ -39,6 +39,7 @@ ________________________________________________________________________________
 #ifdef ANN_BENCH_LINK_CUDART
 #include <dlfcn.h>
 
+#include <cstdlib>
 #include <cstring>
 #endif
 #else
@@ -135,11 +136,27 @@ namespace stub {
   return cudaSuccess;
 }
 
+[[gnu::weak, gnu::noinline]] cudaError_t cudaMemcpyAsync(
+  void* dst, const void* src, size_t count, enum cudaMemcpyKind kind, cudaStream_t stream)
+{
+  return cudaSuccess;
+}
+
 [[gnu::weak, gnu::noinline]] cudaError_t cudaMalloc(void** ptr, size_t size)
 {
   *ptr = nullptr;
   return cudaSuccess;
 }
+[[gnu::weak, gnu::noinline]] cudaError_t cudaMallocHost(void** ptr, size_t size)
+{
+  *ptr = malloc(size);
+  return cudaSuccess;
+}
+[[gnu::weak, gnu::noinline]] cudaError_t cudaFreeHost(void* ptr)
+{
+  free(ptr);
+  return cudaSuccess;
+}
 [[gnu::weak, gnu::noinline]] cudaError_t cudaMemset(void* devPtr, int value, size_t count)
 {
   return cudaSuccess;
@@ -216,7 +233,10 @@ namespace stub {
     cudart.found() ? cudart.sym<decltype(&stub::fun)>(#fun) : &stub::fun
 
 RAFT_DECLARE_CUDART(cudaMemcpy);
+RAFT_DECLARE_CUDART(cudaMemcpyAsync);
 RAFT_DECLARE_CUDART(cudaMalloc);
+RAFT_DECLARE_CUDART(cudaMallocHost);
+RAFT_DECLARE_CUDART(cudaFreeHost);
 RAFT_DECLARE_CUDART(cudaMemset);
 RAFT_DECLARE_CUDART(cudaFree);
 RAFT_DECLARE_CUDART(cudaStreamCreate);
@@ -20,18 +20,102 @@
 #include <errno.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <queue>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace raft::bench::ann {
 
+namespace detail {
+
+template <typename T>
+inline auto to_float(T x) -> float
+{
+#ifndef BUILD_CPU_ONLY
+  if constexpr (std::is_same_v<T, half>) { return __half2float(x); }
+#endif
+  return static_cast<float>(x);
+}
+
+/** The distance used to rank the neighbors (smaller is closer). */
+template <typename T>
+auto host_distance(const T* x, const T* y, int dim, bool inner_product) -> float
+{
+  float d = 0;
+  if (inner_product) {
+    for (int i = 0; i < dim; i++) {
+      d -= to_float(x[i]) * to_float(y[i]);
+    }
+  } else {
+    for (int i = 0; i < dim; i++) {
+      auto diff = to_float(x[i]) - to_float(y[i]);
+      d += diff * diff;
+    }
+  }
+  return d;
+}
+
+/** Run `f(begin, end)` on the chunks of [0, n) using all host threads. */
+template <typename F>
+void parallel_for_chunks(size_t n, size_t chunk_size, F f)
+{
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> threads;
+  auto n_threads = std::min<size_t>(std::max<unsigned>(1, std::thread::hardware_concurrency()),
+                                    (n + chunk_size - 1) / chunk_size);
+  for (unsigned t = 0; t < n_threads; t++) {
+    threads.emplace_back([&]() {
+      for (size_t begin = next.fetch_add(chunk_size); begin < n;
+           begin        = next.fetch_add(chunk_size)) {
+        f(begin, std::min(n, begin + chunk_size));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+/**
+ * Allocate `size` bytes of host memory (page-aligned, zero-filled lazily), asking the kernel to
+ * back it with transparent huge pages. Release with `huge_page_free`.
+ */
+inline auto huge_page_alloc(size_t size) -> void*
+{
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    throw std::runtime_error("mmap error: Value of errno " + std::to_string(errno) + ", " +
+                             std::string(strerror(errno)));
+  }
+  // Only a hint: the memory is still usable if THP is disabled on this system.
+  madvise(ptr, size, MADV_HUGEPAGE);
+  return ptr;
+}
+
+inline void huge_page_free(void* ptr, size_t size) noexcept { munmap(ptr, size); }
+
+}  // namespace detail
+
 // http://big-ann-benchmarks.com/index.html:
 // binary format that starts with 8 bytes of data consisting of num_points(uint32_t)
 // num_dimensions(uint32) followed by num_pts x num_dimensions x sizeof(type) bytes of
@@ -67,12 +151,18 @@ class BinFile {
   {
     assert(read_mode_);
     if (!fp_) { open_file_(); }
-    size_t total = static_cast<size_t>(nrows_) * ndims_;
-    if (fread(data, sizeof(T), total, fp_) != total) {
-      throw std::runtime_error("fread() BinFile " + file_ + " failed");
-    }
+    read_rows_(data, 0, nrows_);
   }
 
+#ifndef BUILD_CPU_ONLY
+  /**
+   * Read the (subset of the) file to the device memory `data`, without a host copy of the whole
+   * set: the file is read in chunks to two pinned staging buffers, so that reading a chunk overlaps
+   * with the host-to-device transfer of the previous one.
+   */
+  void read_to_device(T* data) const;
+#endif
+
   void write(const T* data, uint32_t nrows, uint32_t ndims)
   {
     assert(!read_mode_);
@@ -115,6 +205,7 @@ class BinFile {
  private:
   void check_suffix_();
   void open_file_() const;
+  void read_rows_(T* data, size_t first_row, size_t n_rows) const;
 
   std::string file_;
   bool read_mode_;
@@ -202,6 +293,77 @@ void BinFile<T>::open_file_() const
   }
 }
 
+/**
+ * Read the rows [first_row, first_row + n_rows) of the (subset of the) file with concurrent
+ * `pread` calls on disjoint chunks, which keeps more requests in flight than a single `fread` on
+ * NVMe drives and network filesystems, and also spreads the first-touch page faults of `data`.
+ */
+template <typename T>
+void BinFile<T>::read_rows_(T* data, size_t first_row, size_t n_rows) const
+{
+  constexpr size_t kChunkBytes = size_t{16} << 20;
+  const size_t row_bytes       = size_t{ndims_} * sizeof(T);
+  const size_t offset = 2 * sizeof(uint32_t) + (size_t{subset_first_row_} + first_row) * row_bytes;
+  auto* dst           = reinterpret_cast<uint8_t*>(data);
+  const int fid       = fileno(fp_);
+  std::atomic<bool> failed{false};
+  detail::parallel_for_chunks(n_rows * row_bytes, kChunkBytes, [&](size_t begin, size_t end) {
+    while (begin < end && !failed) {
+      auto n = pread(fid, dst + begin, end - begin, offset + begin);
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n <= 0) {
+        failed = true;
+        return;
+      }
+      begin += n;
+    }
+  });
+  if (failed) { throw std::runtime_error("pread() BinFile " + file_ + " failed"); }
+}
+
+#ifndef BUILD_CPU_ONLY
+template <typename T>
+void BinFile<T>::read_to_device(T* data) const
+{
+  assert(read_mode_);
+  if (!fp_) { open_file_(); }
+  constexpr size_t kStagingBytes = size_t{64} << 20;
+  const size_t row_bytes         = size_t{ndims_} * sizeof(T);
+  const size_t chunk_rows        = std::max<size_t>(1, kStagingBytes / row_bytes);
+  cudaStream_t stream;
+  cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking);
+  T* staging[2];
+  cudaEvent_t copied[2];
+  for (int i = 0; i < 2; i++) {
+    cudaMallocHost(reinterpret_cast<void**>(&staging[i]), chunk_rows * row_bytes);
+    cudaEventCreate(&copied[i]);
+  }
+  auto release = [&]() {
+    cudaStreamSynchronize(stream);
+    for (int i = 0; i < 2; i++) {
+      cudaEventDestroy(copied[i]);
+      cudaFreeHost(staging[i]);
+    }
+    cudaStreamDestroy(stream);
+  };
+  try {
+    for (size_t first = 0, i = 0; first < nrows_; first += chunk_rows, i ^= 1) {
+      auto n = std::min<size_t>(chunk_rows, nrows_ - first);
+      // Wait until the transfer from this buffer two chunks ago is done.
+      if (first >= 2 * chunk_rows) { cudaEventSynchronize(copied[i]); }
+      read_rows_(staging[i], first, n);
+      cudaMemcpyAsync(
+        data + first * ndims_, staging[i], n * row_bytes, cudaMemcpyHostToDevice, stream);
+      cudaEventRecord(copied[i], stream);
+    }
+  } catch (...) {
+    release();
+    throw;
+  }
+  release();
+}
+#endif
+
 template <typename T>
 void BinFile<T>::check_suffix_()
 {
@@ -237,6 +399,36 @@ void BinFile<T>::check_suffix_()
   }
 }
 
+enum class FilterType {
+  // every row passes the filter independently with the probability `selectivity`
+  kRandom,
+  // the passing rows are whole clusters of the base set, so some queries have no passing rows
+  // nearby
+  kClustered,
+};
+
+inline auto parse_filter_type(const std::string& filter_type) -> FilterType
+{
+  if (filter_type == "random") {
+    return FilterType::kRandom;
+  } else if (filter_type == "clustered") {
+    return FilterType::kClustered;
+  } else {
+    throw std::runtime_error("invalid filter type: '" + filter_type + "'");
+  }
+}
+
+/** A subset of the base set to restrict the search to, and the ground truth of such a search. */
+struct FilterSet {
+  // Bit `i % 32` of the word `i / 32` is set if the row `i` of the base set passes the filter
+  // (the layout of `raft::core::bitset<uint32_t, IdxT>`).
+  std::vector<std::uint32_t> bitset;
+  size_t n_passing = 0;
+  // The ids of the `k` nearest passing rows for every query, padded with -1 if fewer rows pass.
+  std::vector<std::int32_t> gt;
+  uint32_t k = 0;
+};
+
 template <typename T>
 class Dataset {
  public:
@@ -279,6 +471,13 @@ class Dataset {
   const T* query_set_on_gpu() const;
   const T* mapped_base_set() const;
 
+  /**
+   * Generate a filter that lets through the part `selectivity` of the base set, and find the `k`
+   * nearest passing neighbors of the queries by brute force on the host.
+   * The result is cached, as it takes a while to compute. Safe to call from concurrent threads.
+   */
+  auto filter(double selectivity, FilterType type, uint32_t k) const -> const FilterSet&;
+
   auto query_set(MemoryType memory_type) const -> const T*
   {
     switch (memory_type) {
@@ -302,6 +501,8 @@ class Dataset {
   virtual void load_gt_set_() const    = 0;
   virtual void load_query_set_() const = 0;
   virtual void map_base_set_() const   = 0;
+  /** Fill the device buffer `data` with the base set; by default, through the host base set. */
+  virtual void load_base_set_to_device_(T* data) const;
 
   std::string name_;
   std::string distance_;
@@ -312,12 +513,21 @@ class Dataset {
   mutable T* d_query_set_     = nullptr;
   mutable T* mapped_base_set_ = nullptr;
   mutable int32_t* gt_set_    = nullptr;
+  // non-zero if `base_set_` is allocated by `detail::huge_page_alloc` rather than `new[]`
+  mutable size_t base_set_alloc_size_ = 0;
+
+  mutable std::map<std::tuple<double, FilterType, uint32_t>, std::unique_ptr<FilterSet>> filters_;
+  mutable std::mutex filters_mutex_;
 };
 
 template <typename T>
 Dataset<T>::~Dataset()
 {
-  delete[] base_set_;
+  if (base_set_alloc_size_ > 0) {
+    detail::huge_page_free(base_set_, base_set_alloc_size_);
+  } else {
+    delete[] base_set_;
+  }
   delete[] query_set_;
   delete[] gt_set_;
 #ifndef BUILD_CPU_ONLY
@@ -331,14 +541,26 @@ const T* Dataset<T>::base_set_on_gpu() const
 {
 #ifndef BUILD_CPU_ONLY
   if (!d_base_set_) {
-    base_set();
     cudaMalloc((void**)&d_base_set_, base_set_size() * dim() * sizeof(T));
-    cudaMemcpy(d_base_set_, base_set_, base_set_size() * dim() * sizeof(T), cudaMemcpyHostToDevice);
+    if (base_set_) {
+      cudaMemcpy(
+        d_base_set_, base_set_, base_set_size() * dim() * sizeof(T), cudaMemcpyHostToDevice);
+    } else {
+      load_base_set_to_device_(d_base_set_);
+    }
   }
 #endif
   return d_base_set_;
 }
 
+template <typename T>
+void Dataset<T>::load_base_set_to_device_(T* data) const
+{
+#ifndef BUILD_CPU_ONLY
+  cudaMemcpy(data, base_set(), base_set_size() * dim() * sizeof(T), cudaMemcpyHostToDevice);
+#endif
+}
+
 template <typename T>
 const T* Dataset<T>::query_set_on_gpu() const
 {
@@ -360,6 +582,120 @@ const T* Dataset<T>::mapped_base_set() const
   return mapped_base_set_;
 }
 
+template <typename T>
+auto Dataset<T>::filter(double selectivity, FilterType type, uint32_t k) const -> const FilterSet&
+{
+  std::lock_guard<std::mutex> guard(filters_mutex_);
+  auto key = std::make_tuple(selectivity, type, k);
+  if (auto it = filters_.find(key); it != filters_.end()) { return *(it->second); }
+  if (!(selectivity > 0 && selectivity <= 1)) {
+    throw std::runtime_error("filter selectivity must be in (0, 1], got " +
+                             std::to_string(selectivity));
+  }
+
+  constexpr std::uint64_t kSeed = 137;
+  const size_t n_rows           = base_set_size();
+  const size_t n_queries        = query_set_size();
+  const int d                   = dim();
+  const T* base                 = base_set();
+  const T* queries              = query_set();
+  const bool inner_product      = distance() == "inner_product";
+
+  auto res = std::make_unique<FilterSet>();
+  res->bitset.resize((n_rows + 31) / 32, 0);
+  auto pass = [&res](size_t i) { res->bitset[i / 32] |= std::uint32_t{1} << (i % 32); };
+
+  std::mt19937_64 rng(kSeed);
+  if (type == FilterType::kRandom) {
+    std::bernoulli_distribution coin(selectivity);
+    for (size_t i = 0; i < n_rows; i++) {
+      if (coin(rng)) {
+        pass(i);
+        res->n_passing++;
+      }
+    }
+  } else {
+    // Split the base set around a few random pivots and let through the whole groups in a random
+    // order (the last one partially) until the target number of rows is reached.
+    constexpr size_t kNumGroups = 100;
+    const size_t n_groups       = std::min(kNumGroups, n_rows);
+    std::vector<size_t> pivots(n_groups);
+    std::uniform_int_distribution<size_t> row_dist(0, n_rows - 1);
+    for (auto& p : pivots) {
+      p = row_dist(rng);
+    }
+    std::vector<std::uint8_t> labels(n_rows);
+    detail::parallel_for_chunks(n_rows, 4096, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        float best = std::numeric_limits<float>::max();
+        for (size_t j = 0; j < n_groups; j++) {
+          auto dist = detail::host_distance(base + i * d, base + pivots[j] * d, d, false);
+          if (dist < best) {
+            best      = dist;
+            labels[i] = std::uint8_t(j);
+          }
+        }
+      }
+    });
+    std::vector<size_t> group_sizes(n_groups, 0);
+    for (auto l : labels) {
+      group_sizes[l]++;
+    }
+    std::vector<size_t> order(n_groups);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    // The quota of rows to let through from every group
+    auto target = static_cast<size_t>(std::ceil(selectivity * n_rows));
+    std::vector<size_t> quota(n_groups, 0);
+    for (auto g : order) {
+      quota[g] = std::min(group_sizes[g], target);
+      target -= quota[g];
+    }
+    for (size_t i = 0; i < n_rows; i++) {
+      if (quota[labels[i]] > 0) {
+        quota[labels[i]]--;
+        pass(i);
+        res->n_passing++;
+      }
+    }
+  }
+  if (res->n_passing == 0) {
+    throw std::runtime_error("the filter with selectivity " + std::to_string(selectivity) +
+                             " rejects all rows of the base set");
+  }
+
+  res->k = k;
+  res->gt.resize(n_queries * k, -1);
+  detail::parallel_for_chunks(n_queries, 1, [&](size_t begin, size_t end) {
+    for (size_t q = begin; q < end; q++) {
+      // max-heap of the k nearest passing rows found so far
+      std::priority_queue<std::pair<float, size_t>> best;
+      for (size_t w = 0; w < res->bitset.size(); w++) {
+        for (auto word = res->bitset[w]; word != 0; word &= word - 1) {
+          size_t i  = w * 32 + __builtin_ctz(word);
+          auto dist = detail::host_distance(queries + q * d, base + i * d, d, inner_product);
+          if (best.size() < k) {
+            best.emplace(dist, i);
+          } else if (dist < best.top().first) {
+            best.pop();
+            best.emplace(dist, i);
+          }
+        }
+      }
+      for (auto j = best.size(); j > 0; j--) {
+        res->gt[q * k + j - 1] = static_cast<std::int32_t>(best.top().second);
+        best.pop();
+      }
+    }
+  });
+  log_info("Generated a %s filter of the selectivity %g (%zu of %zu rows pass)",
+           type == FilterType::kRandom ? "random" : "clustered",
+           selectivity,
+           res->n_passing,
+           n_rows);
+  return *(filters_[key] = std::move(res));
+}
+
 template <typename T>
 class BinDataset : public Dataset<T> {
  public:
@@ -381,6 +717,7 @@ class BinDataset : public Dataset<T> {
   void load_query_set_() const override;
   void load_gt_set_() const override;
   void map_base_set_() const override;
+  void load_base_set_to_device_(T* data) const override;
 
   mutable int dim_               = 0;
   mutable uint32_t max_k_        = 0;
@@ -462,10 +799,20 @@ size_t BinDataset<T>::base_set_size() const
 template <typename T>
 void BinDataset<T>::load_base_set_() const
 {
-  this->base_set_ = new T[base_set_size() * dim()];
+  auto size                  = base_set_size() * dim() * sizeof(T);
+  this->base_set_            = reinterpret_cast<T*>(detail::huge_page_alloc(size));
+  this->base_set_alloc_size_ = size;
   base_file_.read(this->base_set_);
 }
 
+template <typename T>
+void BinDataset<T>::load_base_set_to_device_(T* data) const
+{
+#ifndef BUILD_CPU_ONLY
+  base_file_.read_to_device(data);
+#endif
+}
+
 template <typename T>
 void BinDataset<T>::load_query_set_() const
 {
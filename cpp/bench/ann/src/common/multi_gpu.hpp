@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "ann_types.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace raft::bench::ann {
+
+enum class MultiGpuMode {
+  // every device keeps a copy of the whole index and serves its own benchmark threads
+  kReplicate,
+  // every device keeps an index of a part of the dataset, all of them serve every query
+  kShard,
+};
+
+inline auto parse_multi_gpu_mode(const std::string& mode) -> MultiGpuMode
+{
+  if (mode == "replicate") {
+    return MultiGpuMode::kReplicate;
+  } else if (mode == "shard") {
+    return MultiGpuMode::kShard;
+  } else {
+    throw std::runtime_error("invalid multi-GPU mode: '" + mode + "'");
+  }
+}
+
+#ifndef BUILD_CPU_ONLY
+
+/** Set the current device for the lifetime of the object. */
+class scoped_device {
+ public:
+  explicit scoped_device(int device)
+  {
+    cudaGetDevice(&prev_device_);
+    cudaSetDevice(device);
+  }
+  ~scoped_device() noexcept { cudaSetDevice(prev_device_); }
+  scoped_device(const scoped_device&)            = delete;
+  scoped_device& operator=(const scoped_device&) = delete;
+
+ private:
+  int prev_device_ = 0;
+};
+
+/**
+ * Run any single-GPU algorithm on several devices.
+ *
+ * The wrapper creates an instance of the algorithm on every device of `dev_list` and takes the
+ * queries and returns the results in the host memory.
+ *
+ *   - kReplicate: every instance indexes the whole dataset. A copy of the wrapper (see `copy()`)
+ *     uses only the device `dev_list[benchmark_thread_id % dev_list.size()]`, so the benchmark
+ *     threads are spread evenly among the devices. The index is saved once and loaded on every
+ *     device.
+ *   - kShard: the instance `i` indexes the `i`-th contiguous part of the dataset. Every search is
+ *     done on all devices in parallel (one host thread per device), and the results are merged on
+ *     the host. The parts are saved in the files `<file>.shard<i>`, and `<file>` lists their sizes.
+ */
+template <typename T>
+class MultiGpuAnn : public ANN<T>, public AnnGPU {
+ public:
+  using typename ANN<T>::AnnSearchParam;
+  using factory_type = std::function<std::unique_ptr<ANN<T>>()>;
+
+  MultiGpuAnn(Metric metric,
+              int dim,
+              const std::vector<int>& dev_list,
+              MultiGpuMode mode,
+              const factory_type& make_algo)
+    : ANN<T>(metric, dim), mode_(mode)
+  {
+    if (dev_list.empty()) { throw std::runtime_error("the multi-GPU device list is empty"); }
+    for (auto device : dev_list) {
+      scoped_device dev{device};
+      parts_.emplace_back(device, make_algo());
+    }
+  }
+
+  ~MultiGpuAnn() noexcept
+  {
+    // The algorithms and the buffers must be released on their devices.
+    for (auto& part : parts_) {
+      scoped_device dev{part.device};
+      part.algo.reset();
+      part.release_buffers();
+    }
+  }
+
+  void build(const T* dataset, size_t nrow) override
+  {
+    set_part_sizes(nrow);
+    for_each_part([this, dataset](part_type& part) {
+      part.algo->build(part.part_of(dataset, this->dim_), part.rows);
+    });
+  }
+
+  void set_search_param(const AnnSearchParam& param) override
+  {
+    for_each_part([&param](part_type& part) { part.algo->set_search_param(param); });
+  }
+
+  void set_search_dataset(const T* dataset, size_t nrow) override
+  {
+    if (mode_ == MultiGpuMode::kReplicate) { set_part_sizes(nrow); }
+    for_each_part([this, dataset](part_type& part) {
+      part.algo->set_search_dataset(part.part_of(dataset, this->dim_), part.rows);
+    });
+  }
+
+  void set_search_filter(const std::uint32_t* bitset, size_t n_rows) override
+  {
+    if (mode_ == MultiGpuMode::kReplicate || bitset == nullptr) {
+      for_each_part([=](part_type& part) { part.algo->set_search_filter(bitset, n_rows); });
+      return;
+    }
+    for_each_part([bitset](part_type& part) {
+      // Re-pack the bits of the part, as its offset is not a multiple of 32 in general.
+      std::vector<std::uint32_t> part_bitset((part.rows + 31) / 32, 0);
+      for (size_t i = 0; i < part.rows; i++) {
+        auto j = part.offset + i;
+        if ((bitset[j / 32] >> (j % 32)) & 1u) { part_bitset[i / 32] |= 1u << (i % 32); }
+      }
+      part.algo->set_search_filter(part_bitset.data(), part.rows);
+    });
+  }
+
+  void search(const T* queries,
+              int batch_size,
+              int k,
+              AnnBase::index_type* neighbors,
+              float* distances) const override
+  {
+    if (mode_ == MultiGpuMode::kReplicate) {
+      auto& part = parts_[parts_.size() == 1 ? 0 : benchmark_thread_id % parts_.size()];
+      scoped_device dev{part.device};
+      part.search(queries, batch_size, k, neighbors, distances, this->dim_);
+      return;
+    }
+    std::vector<std::vector<AnnBase::index_type>> part_neighbors(parts_.size());
+    std::vector<std::vector<float>> part_distances(parts_.size());
+    for_each_part([&](part_type& part) {
+      auto i = &part - parts_.data();
+      part_neighbors[i].resize(size_t(batch_size) * k);
+      part_distances[i].resize(size_t(batch_size) * k);
+      part.search(
+        queries, batch_size, k, part_neighbors[i].data(), part_distances[i].data(), this->dim_);
+      // The ids are local to the part
+      for (auto& id : part_neighbors[i]) {
+        if (id < part.rows) { id += part.offset; }
+      }
+    });
+    merge_parts(part_neighbors, part_distances, batch_size, k, neighbors, distances);
+  }
+
+  void save(const std::string& file) const override
+  {
+    if (mode_ == MultiGpuMode::kReplicate) {
+      scoped_device dev{parts_[0].device};
+      parts_[0].algo->save(file);
+      return;
+    }
+    std::ofstream of(file);
+    for (size_t i = 0; i < parts_.size(); i++) {
+      scoped_device dev{parts_[i].device};
+      parts_[i].algo->save(file + ".shard" + std::to_string(i));
+      of << parts_[i].offset << " " << parts_[i].rows << "\n";
+    }
+    if (!of) { throw std::runtime_error("failed to write " + file); }
+  }
+
+  void load(const std::string& file) override
+  {
+    if (mode_ == MultiGpuMode::kReplicate) {
+      for_each_part([&file](part_type& part) { part.algo->load(file); });
+      return;
+    }
+    std::ifstream in(file);
+    for (auto& part : parts_) {
+      if (!(in >> part.offset >> part.rows)) {
+        throw std::runtime_error("the index " + file + " has fewer shards than the devices");
+      }
+    }
+    for_each_part([this, &file](part_type& part) {
+      part.algo->load(file + ".shard" + std::to_string(&part - parts_.data()));
+    });
+  }
+
+  AlgoProperty get_preference() const override
+  {
+    AlgoProperty property;
+    property.dataset_memory_type = MemoryType::Host;
+    property.query_memory_type   = MemoryType::Host;
+    return property;
+  }
+
+  // The results are on the host by the end of the search.
+  [[nodiscard]] auto get_sync_stream() const noexcept -> cudaStream_t override { return nullptr; }
+  [[nodiscard]] auto uses_stream() const noexcept -> bool override { return false; }
+
+  [[nodiscard]] auto get_device_memory_usage() const -> std::optional<MemoryUsage> override
+  {
+    std::optional<MemoryUsage> total{std::nullopt};
+    for (const auto& part : parts_) {
+      auto usage = raft::bench::ann::get_device_memory_usage(part.algo.get());
+      if (usage.has_value()) {
+        if (!total.has_value()) { total.emplace(); }
+        total->current += usage->current;
+        total->peak += usage->peak;
+      }
+    }
+    return total;
+  }
+
+  void reset_device_memory_peak() override
+  {
+    for (auto& part : parts_) {
+      raft::bench::ann::reset_device_memory_peak(part.algo.get());
+    }
+  }
+
+  auto copy() -> std::unique_ptr<ANN<T>> override
+  {
+    // In the replicate mode, the copy keeps only the device of the current benchmark thread.
+    std::vector<size_t> ixs;
+    if (mode_ == MultiGpuMode::kReplicate) {
+      ixs.push_back(benchmark_thread_id % parts_.size());
+    } else {
+      for (size_t i = 0; i < parts_.size(); i++) {
+        ixs.push_back(i);
+      }
+    }
+    std::vector<part_type> parts;
+    for (auto i : ixs) {
+      scoped_device dev{parts_[i].device};
+      parts.emplace_back(parts_[i].device, parts_[i].algo->copy());
+      parts.back().offset  = parts_[i].offset;
+      parts.back().rows    = parts_[i].rows;
+      parts.back().dataset = parts_[i].dataset;
+    }
+    return std::unique_ptr<ANN<T>>(
+      new MultiGpuAnn<T>(this->metric_, this->dim_, mode_, std::move(parts)));
+  }
+
+  [[nodiscard]] auto n_devices() const -> size_t { return parts_.size(); }
+
+ private:
+  struct part_type {
+    int device;
+    std::unique_ptr<ANN<T>> algo;
+    // The rows of the dataset indexed by this part
+    size_t offset = 0;
+    size_t rows   = 0;
+    // A device copy of the dataset part, if the algorithm needs one (shared with the copies)
+    std::shared_ptr<T> dataset{nullptr};
+    // The device buffers of the queries and results (not shared with the copies)
+    mutable void* buffer       = nullptr;
+    mutable size_t buffer_size = 0;
+
+    part_type(int device, std::unique_ptr<ANN<T>>&& algo) : device(device), algo(std::move(algo))
+    {
+    }
+    part_type(part_type&& other) noexcept
+      : device(other.device),
+        algo(std::move(other.algo)),
+        offset(other.offset),
+        rows(other.rows),
+        dataset(std::move(other.dataset)),
+        buffer(std::exchange(other.buffer, nullptr)),
+        buffer_size(std::exchange(other.buffer_size, 0))
+    {
+    }
+    part_type(const part_type&)            = delete;
+    part_type& operator=(const part_type&) = delete;
+    part_type& operator=(part_type&&)      = delete;
+
+    void release_buffers() const
+    {
+      if (buffer != nullptr) { cudaFree(buffer); }
+      buffer      = nullptr;
+      buffer_size = 0;
+    }
+
+    /** The part of the host `data` indexed by this part, in the memory the algorithm expects. */
+    auto part_of(const T* data, int dim) -> const T*
+    {
+      const T* host_part = data + offset * dim;
+      if (algo->get_preference().dataset_memory_type != MemoryType::Device) { return host_part; }
+      T* ptr = nullptr;
+      cudaMalloc(reinterpret_cast<void**>(&ptr), rows * dim * sizeof(T));
+      cudaMemcpy(ptr, host_part, rows * dim * sizeof(T), cudaMemcpyHostToDevice);
+      dataset = std::shared_ptr<T>(ptr, [device = device](T* p) {
+        scoped_device dev{device};
+        cudaFree(p);
+      });
+      return ptr;
+    }
+
+    /** Search the host queries on the current device, put the results to the host memory. */
+    void search(const T* queries,
+                int batch_size,
+                int k,
+                AnnBase::index_type* neighbors,
+                float* distances,
+                int dim) const
+    {
+      if (algo->get_preference().query_memory_type != MemoryType::Device) {
+        algo->search(queries, batch_size, k, neighbors, distances);
+        return;
+      }
+      size_t queries_size   = size_t(batch_size) * dim * sizeof(T);
+      size_t neighbors_size = size_t(batch_size) * k * sizeof(AnnBase::index_type);
+      size_t distances_size = size_t(batch_size) * k * sizeof(float);
+      size_t required       = queries_size + neighbors_size + distances_size;
+      if (buffer_size < required) {
+        release_buffers();
+        if (cudaMalloc(&buffer, required) != cudaSuccess) {
+          buffer = nullptr;
+          throw std::runtime_error("failed to allocate the multi-GPU search buffers");
+        }
+        buffer_size = required;
+      }
+      auto* queries_dev   = reinterpret_cast<T*>(buffer);
+      auto* neighbors_dev = reinterpret_cast<AnnBase::index_type*>(
+        reinterpret_cast<std::uint8_t*>(buffer) + queries_size);
+      auto* distances_dev =
+        reinterpret_cast<float*>(reinterpret_cast<std::uint8_t*>(neighbors_dev) + neighbors_size);
+      auto gpu_algo = dynamic_cast<AnnGPU*>(algo.get());
+      cudaStream_t stream =
+        gpu_algo != nullptr && gpu_algo->uses_stream() ? gpu_algo->get_sync_stream() : nullptr;
+      cudaMemcpyAsync(queries_dev, queries, queries_size, cudaMemcpyHostToDevice, stream);
+      algo->search(queries_dev, batch_size, k, neighbors_dev, distances_dev);
+      cudaMemcpyAsync(neighbors, neighbors_dev, neighbors_size, cudaMemcpyDeviceToHost, stream);
+      cudaMemcpyAsync(distances, distances_dev, distances_size, cudaMemcpyDeviceToHost, stream);
+      cudaStreamSynchronize(stream);
+    }
+  };
+
+  MultiGpuAnn(Metric metric, int dim, MultiGpuMode mode, std::vector<part_type>&& parts)
+    : ANN<T>(metric, dim), mode_(mode), parts_(std::move(parts))
+  {
+  }
+
+  void set_part_sizes(size_t nrow)
+  {
+    for (size_t i = 0; i < parts_.size(); i++) {
+      if (mode_ == MultiGpuMode::kReplicate) {
+        parts_[i].offset = 0;
+        parts_[i].rows   = nrow;
+      } else {
+        parts_[i].offset = nrow * i / parts_.size();
+        parts_[i].rows   = nrow * (i + 1) / parts_.size() - parts_[i].offset;
+      }
+    }
+  }
+
+  /** Run `f` on all parts in parallel, each in its own host thread with its device set. */
+  template <typename F>
+  void for_each_part(F f) const
+  {
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(parts_.size());
+    for (size_t i = 0; i < parts_.size(); i++) {
+      threads.emplace_back([this, &f, &errors, i]() {
+        try {
+          scoped_device dev{parts_[i].device};
+          f(const_cast<part_type&>(parts_[i]));
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (auto& error : errors) {
+      if (error) { std::rethrow_exception(error); }
+    }
+  }
+
+  /** Select the best `k` of the results of all parts for every query. */
+  void merge_parts(const std::vector<std::vector<AnnBase::index_type>>& part_neighbors,
+                   const std::vector<std::vector<float>>& part_distances,
+                   int batch_size,
+                   int k,
+                   AnnBase::index_type* neighbors,
+                   float* distances) const
+  {
+    const bool greater_is_better = this->metric_ == Metric::kInnerProduct;
+    std::vector<std::pair<float, AnnBase::index_type>> candidates;
+    for (size_t q = 0; q < size_t(batch_size); q++) {
+      candidates.clear();
+      for (size_t p = 0; p < parts_.size(); p++) {
+        for (size_t j = q * k; j < (q + 1) * k; j++) {
+          candidates.emplace_back(part_distances[p][j], part_neighbors[p][j]);
+        }
+      }
+      auto by_distance = [greater_is_better](const auto& a, const auto& b) {
+        return greater_is_better ? a.first > b.first : a.first < b.first;
+      };
+      std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), by_distance);
+      for (size_t j = 0; j < size_t(k); j++) {
+        distances[q * k + j] = candidates[j].first;
+        neighbors[q * k + j] = candidates[j].second;
+      }
+    }
+  }
+
+  MultiGpuMode mode_;
+  std::vector<part_type> parts_;
+};
+
+#endif
+
+}  // namespace raft::bench::ann
@@ -32,11 +32,13 @@
 #include <cstring>
 #include <ctime>
 #include <filesystem>
+#include <fstream>
 #include <functional>
 #include <mutex>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace raft::bench::ann {
@@ -149,6 +151,54 @@ struct cuda_timer {
   }
 };
 
+/** The device memory usage of the algorithm, if it implements `AnnGPU` and tracks it. */
+template <typename AnnT>
+inline auto get_device_memory_usage(AnnT* algo) -> std::optional<MemoryUsage>
+{
+  auto gpu_ann = dynamic_cast<AnnGPU*>(algo);
+  return gpu_ann != nullptr ? gpu_ann->get_device_memory_usage() : std::nullopt;
+}
+
+template <typename AnnT>
+inline void reset_device_memory_peak(AnnT* algo)
+{
+  auto gpu_ann = dynamic_cast<AnnGPU*>(algo);
+  if (gpu_ann != nullptr) { gpu_ann->reset_device_memory_peak(); }
+}
+
+/** The algorithm-specific search counters, if the algorithm implements `AnnGPU`. */
+template <typename AnnT>
+inline auto get_search_counters(AnnT* algo) -> std::vector<std::pair<std::string, double>>
+{
+  auto gpu_ann = dynamic_cast<AnnGPU*>(algo);
+  return gpu_ann != nullptr ? gpu_ann->get_search_counters()
+                            : std::vector<std::pair<std::string, double>>{};
+}
+
+/** The peak resident set size of the process (bytes), or `std::nullopt` if it is unknown. */
+inline auto get_host_memory_peak() -> std::optional<size_t>
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0) {
+      // The value is in kB
+      return std::stoull(line.substr(6)) * 1024;
+    }
+  }
+  return std::nullopt;
+}
+
+/**
+ * Reset the peak resident set size of the process to the current one.
+ * This is best effort: it may be not permitted, and then the peak is counted from the start.
+ */
+inline void reset_host_memory_peak()
+{
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (clear_refs) { clear_refs << "5"; }
+}
+
 #ifndef BUILD_CPU_ONLY
 // ATM, rmm::stream does not support passing in flags; hence this helper type.
 struct non_blocking_stream {
@@ -168,13 +218,14 @@ struct non_blocking_stream {
 };
 
 namespace detail {
-inline std::vector<non_blocking_stream> global_stream_pool(0);
+// Indexed by the device and the benchmark thread
+inline std::vector<std::vector<non_blocking_stream>> global_stream_pool(0);
 inline std::mutex gsp_mutex;
 }  // namespace detail
 #endif
 
 /**
- * Get a stream associated with the current benchmark thread.
+ * Get a stream associated with the current benchmark thread (on the current device).
  *
  * Note, the streams are reused between the benchmark cases.
  * This makes it easier to profile and analyse multiple benchmark cases in one timeline using tools
@@ -183,11 +234,18 @@ inline std::mutex gsp_mutex;
 inline auto get_stream_from_global_pool() -> cudaStream_t
 {
 #ifndef BUILD_CPU_ONLY
+  int device = 0;
+  cudaGetDevice(&device);
   std::lock_guard guard(detail::gsp_mutex);
-  if (int(detail::global_stream_pool.size()) < benchmark_n_threads) {
-    detail::global_stream_pool.resize(benchmark_n_threads);
+  if (int(detail::global_stream_pool.size()) <= device) {
+    detail::global_stream_pool.resize(device + 1);
+  }
+  // The streams are created on the current device, which is the same for all of them in a row.
+  auto& device_streams = detail::global_stream_pool[device];
+  if (int(device_streams.size()) < benchmark_n_threads) {
+    device_streams.resize(benchmark_n_threads);
   }
-  return detail::global_stream_pool[benchmark_thread_id].view();
+  return device_streams[benchmark_thread_id].view();
 #else
   return nullptr;
 #endif
@@ -130,6 +130,9 @@ void parse_search_param(const nlohmann::json& conf,
     param.refine_ratio = conf.at("refine_ratio");
     if (param.refine_ratio < 1.0f) { throw std::runtime_error("refine_ratio should be >= 1.0"); }
   }
+  if (conf.contains("refine_memory_type")) {
+    param.refine_mem = raft::bench::ann::parse_allocator(conf.at("refine_memory_type"));
+  }
 }
 #endif
 
@@ -227,21 +230,6 @@ void parse_build_param(const nlohmann::json& conf,
   }
 }
 
-raft::bench::ann::AllocatorType parse_allocator(std::string mem_type)
-{
-  if (mem_type == "device") {
-    return raft::bench::ann::AllocatorType::Device;
-  } else if (mem_type == "host_pinned") {
-    return raft::bench::ann::AllocatorType::HostPinned;
-  } else if (mem_type == "host_huge_page") {
-    return raft::bench::ann::AllocatorType::HostHugePage;
-  }
-  THROW(
-    "Invalid value for memory type %s, must be one of [\"device\", \"host_pinned\", "
-    "\"host_huge_page\"",
-    mem_type.c_str());
-}
-
 template <typename T, typename IdxT>
 void parse_search_param(const nlohmann::json& conf,
                         typename raft::bench::ann::RaftCagra<T, IdxT>::SearchParam& param)
@@ -264,12 +252,21 @@ void parse_search_param(const nlohmann::json& conf,
     }
   }
   if (conf.contains("graph_memory_type")) {
-    param.graph_mem = parse_allocator(conf.at("graph_memory_type"));
+    param.graph_mem = raft::bench::ann::parse_allocator(conf.at("graph_memory_type"));
   }
   if (conf.contains("internal_dataset_memory_type")) {
-    param.dataset_mem = parse_allocator(conf.at("internal_dataset_memory_type"));
+    param.dataset_mem =
+      raft::bench::ann::parse_allocator(conf.at("internal_dataset_memory_type"));
+  }
+  if (conf.contains("persistent")) { param.p.persistent = conf.at("persistent"); }
+  if (conf.contains("persistent_lifetime")) {
+    param.p.persistent_lifetime = conf.at("persistent_lifetime");
   }
+  param.cuda_graph = conf.value("cuda_graph", false);
   // Same ratio as in IVF-PQ
   param.refine_ratio = conf.value("refine_ratio", 1.0f);
+  if (conf.contains("refine_memory_type")) {
+    param.refine_mem = raft::bench::ann::parse_allocator(conf.at("refine_memory_type"));
+  }
 }
 #endif
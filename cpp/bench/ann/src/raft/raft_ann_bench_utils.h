@@ -15,8 +15,11 @@
  */
 #pragma once
 
+#include "../common/cuda_huge_page_resource.hpp"
+#include "../common/cuda_pinned_resource.hpp"
 #include "../common/util.hpp"
 
+#include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/device_resources.hpp>
 #include <raft/core/host_mdarray.hpp>
@@ -25,6 +28,7 @@
 #include <raft/core/operators.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/refine.cuh>
+#include <raft/neighbors/sample_filter.cuh>
 #include <raft/util/cudart_utils.hpp>
 
 #include <rmm/cuda_stream_view.hpp>
@@ -33,9 +37,17 @@
 #include <rmm/mr/device/failure_callback_resource_adaptor.hpp>
 #include <rmm/mr/device/managed_memory_resource.hpp>
 #include <rmm/mr/device/pool_memory_resource.hpp>
+#include <rmm/mr/device/statistics_resource_adaptor.hpp>
+#include <rmm/resource_ref.hpp>
 
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace raft::bench::ann {
 
@@ -51,6 +63,137 @@ inline raft::distance::DistanceType parse_metric_type(raft::bench::ann::Metric m
   }
 }
 
+/** Where the wrappers keep the data used in the search (see `placement_resources`). */
+enum class AllocatorType { HostPinned, HostHugePage, Device, Managed };
+
+inline auto parse_allocator(const std::string& mem_type) -> AllocatorType
+{
+  if (mem_type == "device") {
+    return AllocatorType::Device;
+  } else if (mem_type == "host_pinned") {
+    return AllocatorType::HostPinned;
+  } else if (mem_type == "host_huge_page") {
+    return AllocatorType::HostHugePage;
+  } else if (mem_type == "managed") {
+    return AllocatorType::Managed;
+  }
+  throw std::runtime_error("invalid memory type: '" + mem_type +
+                           "', must be one of \"device\", \"host_pinned\", \"host_huge_page\" "
+                           "or \"managed\"");
+}
+
+inline std::string allocator_to_string(AllocatorType mem_type)
+{
+  switch (mem_type) {
+    case AllocatorType::Device: return "device";
+    case AllocatorType::HostPinned: return "host_pinned";
+    case AllocatorType::HostHugePage: return "host_huge_page";
+    case AllocatorType::Managed: return "managed";
+    default: return "<invalid allocator type>";
+  }
+}
+
+/**
+ * The memory resources of the placements selectable by the `*_memory_type` search parameters of
+ * the wrappers. All of them are accessible from the device; `host_huge_page` only on the systems
+ * with HMM or with the hardware support for the device access to the system memory.
+ */
+class placement_resources {
+ public:
+  auto get_mr(AllocatorType mem_type) -> rmm::device_async_resource_ref
+  {
+    switch (mem_type) {
+      case AllocatorType::HostPinned: return &pinned_;
+      case AllocatorType::HostHugePage: return &huge_page_;
+      case AllocatorType::Managed: return &managed_;
+      default: return rmm::mr::get_current_device_resource();
+    }
+  }
+
+ private:
+  raft::mr::cuda_pinned_resource pinned_;
+  raft::mr::cuda_huge_page_resource huge_page_;
+  rmm::mr::managed_memory_resource managed_;
+};
+
+/**
+ * Copy a row-major matrix (in any memory) to a new buffer of the placement `mem_type`.
+ * The wrappers share the result among their copies.
+ */
+template <typename T, typename IdxT>
+auto copy_to_placement(const raft::resources& res,
+                       placement_resources& mrs,
+                       AllocatorType mem_type,
+                       const T* src,
+                       IdxT n_rows,
+                       IdxT n_cols) -> std::shared_ptr<raft::device_matrix<T, IdxT, row_major>>
+{
+  auto dst = std::make_shared<raft::device_matrix<T, IdxT, row_major>>(
+    raft::make_device_mdarray<T, IdxT>(
+      res, mrs.get_mr(mem_type), raft::make_extents<IdxT>(n_rows, n_cols)));
+  raft::copy(dst->data_handle(), src, dst->size(), resource::get_cuda_stream(res));
+  resource::sync_stream(res);
+  return dst;
+}
+
+/**
+ * A copy of a matrix in the placement selected by a search parameter (e.g. the dataset used in the
+ * refinement); the copies of a wrapper share it, and `update` makes a new one only when the source
+ * or the placement change.
+ */
+template <typename T, typename IdxT>
+class placed_matrix {
+ public:
+  using view_type = raft::device_matrix_view<const T, IdxT, row_major>;
+
+  /** Return `src` itself if `mem_type` is empty, or its copy in the memory of that type. */
+  auto update(const raft::resources& res,
+              placement_resources& mrs,
+              std::optional<AllocatorType> mem_type,
+              view_type src) -> view_type
+  {
+    if (!mem_type.has_value() || src.data_handle() == nullptr) {
+      copy_.reset();
+      return src;
+    }
+    if (!copy_ || copy_->src != src.data_handle() || copy_->mem_type != *mem_type ||
+        copy_->data->extent(0) != src.extent(0)) {
+      RAFT_LOG_DEBUG("copying a matrix to the memory space: %s",
+                     allocator_to_string(*mem_type).c_str());
+      copy_ = std::make_shared<placed>(placed{
+        src.data_handle(),
+        *mem_type,
+        copy_to_placement(res, mrs, *mem_type, src.data_handle(), src.extent(0), src.extent(1))});
+    }
+    return raft::make_const_mdspan(copy_->data->view());
+  }
+
+ private:
+  struct placed {
+    const T* src;
+    AllocatorType mem_type;
+    std::shared_ptr<raft::device_matrix<T, IdxT, row_major>> data;
+  };
+  std::shared_ptr<placed> copy_;
+};
+
+/**
+ * Whether the kernels can read the memory at `ptr` directly: device and managed memory, and the
+ * pinned (page-locked) host memory.
+ */
+template <typename T>
+auto is_device_accessible(const T* ptr) -> bool
+{
+  if (ptr == nullptr) { return false; }
+  cudaPointerAttributes attr;
+  if (cudaPointerGetAttributes(&attr, ptr) != cudaSuccess) {
+    // reset the error status
+    cudaGetLastError();
+    return false;
+  }
+  return attr.type != cudaMemoryTypeUnregistered;
+}
+
 /** Report a more verbose error with a backtrace when OOM occurs on RMM side. */
 inline auto rmm_oom_callback(std::size_t bytes, void*) -> bool
 {
@@ -77,13 +220,15 @@ class shared_raft_resources {
  public:
   using pool_mr_type  = rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource>;
   using mr_type       = rmm::mr::failure_callback_resource_adaptor<pool_mr_type>;
+  using stats_mr_type = rmm::mr::statistics_resource_adaptor<mr_type>;
   using large_mr_type = rmm::mr::managed_memory_resource;
 
   shared_raft_resources()
   try : orig_resource_{rmm::mr::get_current_device_resource()},
     pool_resource_(orig_resource_, 1024 * 1024 * 1024ull),
-    resource_(&pool_resource_, rmm_oom_callback, nullptr), large_mr_() {
-    rmm::mr::set_current_device_resource(&resource_);
+    resource_(&pool_resource_, rmm_oom_callback, nullptr), stats_resource_(&resource_),
+    large_mr_() {
+    rmm::mr::set_current_device_resource(&stats_resource_);
   } catch (const std::exception& e) {
     auto cuda_status = cudaGetLastError();
     size_t free      = 0;
@@ -110,11 +255,33 @@ class shared_raft_resources {
     return static_cast<rmm::mr::device_memory_resource*>(&large_mr_);
   }
 
+  /**
+   * The memory allocated through the pool (the pool itself may reserve more); the managed memory of
+   * the large workspace is not counted.
+   */
+  auto get_memory_usage() const -> MemoryUsage
+  {
+    auto bytes = stats_resource_.get_bytes_counter();
+    return MemoryUsage{size_t(peak_base_ + bytes.value), size_t(peak_base_ + bytes.peak)};
+  }
+
+  void reset_memory_peak()
+  {
+    // The counters pushed on top of the stack count the allocations from zero.
+    if (peak_counters_pushed_) { stats_resource_.pop_counters(); }
+    peak_base_ = stats_resource_.get_bytes_counter().value;
+    stats_resource_.push_counters();
+    peak_counters_pushed_ = true;
+  }
+
  private:
   rmm::mr::device_memory_resource* orig_resource_;
   pool_mr_type pool_resource_;
   mr_type resource_;
+  stats_mr_type stats_resource_;
   large_mr_type large_mr_;
+  int64_t peak_base_         = 0;
+  bool peak_counters_pushed_ = false;
 };
 
 /**
@@ -169,6 +336,13 @@ class configured_raft_resources {
   /** Get the main stream */
   [[nodiscard]] auto get_sync_stream() const noexcept { return resource::get_cuda_stream(*res_); }
 
+  /** The device memory usage, shared among the copies (see `shared_raft_resources`). */
+  [[nodiscard]] auto get_memory_usage() const -> MemoryUsage
+  {
+    return shared_res_->get_memory_usage();
+  }
+  void reset_memory_peak() { shared_res_->reset_memory_peak(); }
+
  private:
   /** The resources shared among multiple raft handles / threads. */
   std::shared_ptr<shared_raft_resources> shared_res_;
@@ -206,7 +380,8 @@ void refine_helper(const raft::resources& res,
   extents_type dim        = queries.extent(1);
   extents_type k0         = candidates.extent(1);
 
-  if (raft::get_device_for_address(dataset.data_handle()) >= 0) {
+  // The device-side refinement reads the rows of the dataset wherever they are placed.
+  if (is_device_accessible(dataset.data_handle())) {
     auto dataset_device = raft::make_device_matrix_view<const data_type, extents_type>(
       dataset.data_handle(), dataset.extent(0), dataset.extent(1));
     auto queries_device = raft::make_device_matrix_view<const data_type, extents_type>(
@@ -252,4 +427,157 @@ void refine_helper(const raft::resources& res,
   }
 }
 
+/**
+ * A device copy of the search filter passed to `ANN::set_search_filter`.
+ * The wrappers keep it by a shared pointer, so that their copies share it.
+ */
+struct device_search_filter {
+  rmm::device_uvector<std::uint32_t> bitset;
+  size_t n_rows;
+
+  /** Create a filter, or return nullptr if `bitset` is nullptr (no filtering). */
+  static auto make(const raft::resources& res, const std::uint32_t* bitset, size_t n_rows)
+    -> std::shared_ptr<device_search_filter>
+  {
+    if (bitset == nullptr) { return nullptr; }
+    auto stream = resource::get_cuda_stream(res);
+    auto filter = std::shared_ptr<device_search_filter>(
+      new device_search_filter{rmm::device_uvector<std::uint32_t>((n_rows + 31) / 32, stream),
+                               n_rows});
+    raft::copy(filter->bitset.data(), bitset, filter->bitset.size(), stream);
+    resource::sync_stream(res);
+    return filter;
+  }
+
+  template <typename IdxT>
+  auto sample_filter() -> raft::neighbors::filtering::bitset_filter<std::uint32_t, IdxT>
+  {
+    return raft::neighbors::filtering::bitset_filter<std::uint32_t, IdxT>(
+      raft::core::bitset_view<std::uint32_t, IdxT>(bitset.data(), IdxT(n_rows)));
+  }
+};
+
+/**
+ * A search captured in a CUDA graph and replayed as long as its arguments (the `key`) stay the
+ * same, which saves the host-side launch overhead of its kernels.
+ *
+ * A graph is launched in the stream of the wrapper that captured it, hence the copies start empty.
+ */
+class captured_search_graph {
+ public:
+  captured_search_graph() = default;
+  captured_search_graph(const captured_search_graph&) : captured_search_graph{} {}
+  auto operator=(const captured_search_graph&) -> captured_search_graph&
+  {
+    reset();
+    return *this;
+  }
+  ~captured_search_graph() noexcept { reset(); }
+
+  /** Drop the captured graph, e.g. when the search parameters change. */
+  void reset() noexcept
+  {
+    if (exec_ != nullptr) { RAFT_CUDA_TRY_NO_THROW(cudaGraphExecDestroy(exec_)); }
+    exec_ = nullptr;
+    key_.clear();
+  }
+
+  /**
+   * Launch the graph of `search` in `stream`, capturing it anew if there is none for `key`.
+   * `prepare` runs before the capture, to do the host-side work and the allocations of the search.
+   * If the search cannot be captured, it runs directly from then on.
+   */
+  template <typename PrepareF, typename SearchF>
+  void run(cudaStream_t stream,
+           const std::vector<std::uintptr_t>& key,
+           PrepareF prepare,
+           SearchF search)
+  {
+    if (exec_ != nullptr && key == key_) {
+      RAFT_CUDA_TRY(cudaGraphLaunch(exec_, stream));
+      return;
+    }
+    reset();
+    if (!capture_error_.empty()) {
+      search();
+      return;
+    }
+    prepare();
+    cudaGraph_t graph = nullptr;
+    RAFT_CUDA_TRY(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+    try {
+      search();
+    } catch (const std::exception& e) {
+      capture_error_ = e.what();
+    }
+    auto status = cudaStreamEndCapture(stream, &graph);
+    if (status != cudaSuccess && capture_error_.empty()) {
+      capture_error_ = cudaGetErrorString(status);
+    }
+    if (!capture_error_.empty()) {
+      if (graph != nullptr) { RAFT_CUDA_TRY_NO_THROW(cudaGraphDestroy(graph)); }
+      // clear the capture error
+      cudaGetLastError();
+      RAFT_LOG_WARN("The search cannot be captured in a CUDA graph, running it directly: %s",
+                    capture_error_.c_str());
+      search();
+      return;
+    }
+    try {
+      count_nodes(graph);
+      RAFT_CUDA_TRY(cudaGraphInstantiateWithFlags(&exec_, graph, 0));
+    } catch (...) {
+      RAFT_CUDA_TRY_NO_THROW(cudaGraphDestroy(graph));
+      throw;
+    }
+    RAFT_CUDA_TRY(cudaGraphDestroy(graph));
+    key_ = key;
+    n_captures_++;
+    RAFT_CUDA_TRY(cudaGraphLaunch(exec_, stream));
+  }
+
+  /**
+   * The composition of the last captured graph (the operations launched by one search) and the
+   * number of captures, as benchmark counters.
+   */
+  [[nodiscard]] auto counters() const -> std::vector<std::pair<std::string, double>>
+  {
+    if (!capture_error_.empty()) { return {{"graph_capture_failed", 1}}; }
+    return {{"graph_captures", double(n_captures_)},
+            {"graph_kernels", double(n_kernels_)},
+            {"graph_memcpys", double(n_memcpys_)},
+            {"graph_memsets", double(n_memsets_)},
+            {"graph_other_nodes", double(n_other_nodes_)}};
+  }
+
+ private:
+  cudaGraphExec_t exec_ = nullptr;
+  std::vector<std::uintptr_t> key_{};
+  std::string capture_error_{};
+  size_t n_captures_    = 0;
+  size_t n_kernels_     = 0;
+  size_t n_memcpys_     = 0;
+  size_t n_memsets_     = 0;
+  size_t n_other_nodes_ = 0;
+
+  void count_nodes(cudaGraph_t graph)
+  {
+    size_t n_nodes = 0;
+    RAFT_CUDA_TRY(cudaGraphGetNodes(graph, nullptr, &n_nodes));
+    std::vector<cudaGraphNode_t> nodes(n_nodes);
+    RAFT_CUDA_TRY(cudaGraphGetNodes(graph, nodes.data(), &n_nodes));
+    n_kernels_ = n_memcpys_ = n_memsets_ = n_other_nodes_ = 0;
+    for (auto node : nodes) {
+      cudaGraphNodeType type;
+      RAFT_CUDA_TRY(cudaGraphNodeGetType(node, &type));
+      switch (type) {
+        case cudaGraphNodeTypeKernel: n_kernels_++; break;
+        case cudaGraphNodeTypeMemcpy: n_memcpys_++; break;
+        case cudaGraphNodeTypeMemset: n_memsets_++; break;
+        default: n_other_nodes_++;
+      }
+    }
+  }
+};
+
 }  // namespace raft::bench::ann
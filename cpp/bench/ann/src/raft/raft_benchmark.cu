@@ -15,6 +15,7 @@
  */
 
 #include "../common/ann_types.hpp"
+#include "../common/multi_gpu.hpp"
 #include "raft_ann_bench_param_parser.h"
 
 #include <raft/core/logger.hpp>
@@ -41,12 +42,16 @@ std::unique_ptr<raft::bench::ann::ANN<T>> create_algo(const std::string& algo,
                                                       const nlohmann::json& conf,
                                                       const std::vector<int>& dev_list)
 {
-  // stop compiler warning; not all algorithms support multi-GPU so it may not be used
-  (void)dev_list;
-
   [[maybe_unused]] raft::bench::ann::Metric metric = parse_metric(distance);
   std::unique_ptr<raft::bench::ann::ANN<T>> ann;
 
+  // With the "multigpu" device list, run an instance of the algorithm on every device
+  if (!dev_list.empty()) {
+    auto mode = parse_multi_gpu_mode(conf.value("multigpu_mode", std::string("replicate")));
+    return std::make_unique<raft::bench::ann::MultiGpuAnn<T>>(
+      metric, dim, dev_list, mode, [&]() { return create_algo<T>(algo, distance, dim, conf, {}); });
+  }
+
   if constexpr (std::is_same_v<T, float>) {
 #ifdef RAFT_ANN_BENCH_USE_RAFT_BRUTE_FORCE
     if (algo == "raft_brute_force") {
@@ -52,6 +52,14 @@ class RaftCagraHnswlib : public ANN<T>, public AnnGPU {
     return cagra_build_.get_sync_stream();
   }
 
+  // Only the build is done on the GPU
+  [[nodiscard]] auto get_device_memory_usage() const -> std::optional<MemoryUsage> override
+  {
+    return cagra_build_.get_device_memory_usage();
+  }
+
+  void reset_device_memory_peak() override { cagra_build_.reset_device_memory_peak(); }
+
   // to enable dataset access from GPU memory
   AlgoProperty get_preference() const override
   {
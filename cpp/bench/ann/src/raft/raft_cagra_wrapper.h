@@ -16,12 +16,11 @@
 #pragma once
 
 #include "../common/ann_types.hpp"
-#include "../common/cuda_huge_page_resource.hpp"
-#include "../common/cuda_pinned_resource.hpp"
 #include "raft_ann_bench_utils.h"
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/device_resources.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/logger.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/distance/distance_types.hpp>
@@ -39,6 +38,7 @@
 #include <rmm/resource_ref.hpp>
 
 #include <cassert>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -46,10 +46,11 @@
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace raft::bench::ann {
 
-enum class AllocatorType { HostPinned, HostHugePage, Device };
 template <typename T, typename IdxT>
 class RaftCagra : public ANN<T>, public AnnGPU {
  public:
@@ -60,6 +61,10 @@ class RaftCagra : public ANN<T>, public AnnGPU {
     float refine_ratio;
     AllocatorType graph_mem   = AllocatorType::Device;
     AllocatorType dataset_mem = AllocatorType::Device;
+    // Copy the dataset used in the refinement to this memory (by default, use the benchmark's)
+    std::optional<AllocatorType> refine_mem = std::nullopt;
+    // Capture the search in a CUDA graph and replay it (see `captured_search_graph`)
+    bool cuda_graph = false;
     auto needs_dataset() const -> bool override { return true; }
   };
 
@@ -101,6 +106,8 @@ class RaftCagra : public ANN<T>, public AnnGPU {
 
   void set_search_dataset(const T* dataset, size_t nrow) override;
 
+  void extend(const T* dataset, size_t first_id, size_t nrow) override;
+
   void search(const T* queries,
               int batch_size,
               int k,
@@ -117,6 +124,20 @@ class RaftCagra : public ANN<T>, public AnnGPU {
     return handle_.get_sync_stream();
   }
 
+  [[nodiscard]] auto get_device_memory_usage() const -> std::optional<MemoryUsage> override
+  {
+    return handle_.get_memory_usage();
+  }
+
+  void reset_device_memory_peak() override { handle_.reset_memory_peak(); }
+
+  [[nodiscard]] auto get_search_counters() const
+    -> std::vector<std::pair<std::string, double>> override
+  {
+    return cuda_graph_ ? search_graph_.graph.counters()
+                       : std::vector<std::pair<std::string, double>>{};
+  }
+
   // to enable dataset access from GPU memory
   AlgoProperty get_preference() const override
   {
@@ -128,13 +149,13 @@ class RaftCagra : public ANN<T>, public AnnGPU {
   void save(const std::string& file) const override;
   void load(const std::string&) override;
   void save_to_hnswlib(const std::string& file) const;
+  void set_search_filter(const std::uint32_t* bitset, size_t n_rows) override;
   std::unique_ptr<ANN<T>> copy() override;
 
  private:
   // handle_ must go first to make sure it dies last and all memory allocated in pool
   configured_raft_resources handle_{};
-  raft::mr::cuda_pinned_resource mr_pinned_;
-  raft::mr::cuda_huge_page_resource mr_huge_page_;
+  placement_resources mrs_;
   AllocatorType graph_mem_;
   AllocatorType dataset_mem_;
   float refine_ratio_;
@@ -143,19 +164,31 @@ class RaftCagra : public ANN<T>, public AnnGPU {
   bool shall_include_dataset_;
   raft::neighbors::cagra::search_params search_params_;
   std::shared_ptr<raft::neighbors::cagra::index<T, IdxT>> index_;
+  std::shared_ptr<device_search_filter> filter_;
+  bool cuda_graph_ = false;
+  /** The search plan and the CUDA graph of this copy of the wrapper. */
+  struct search_graph_state {
+    raft::neighbors::cagra::search_workspace workspace;
+    captured_search_graph graph;
+
+    search_graph_state() = default;
+    // The copies start empty, as the workspace must not be used by concurrent searches.
+    search_graph_state(const search_graph_state&) : search_graph_state{} {}
+    auto operator=(const search_graph_state&) -> search_graph_state&
+    {
+      workspace.reset();
+      graph.reset();
+      return *this;
+    }
+  };
+  mutable search_graph_state search_graph_;
   int dimension_;
   std::shared_ptr<raft::device_matrix<IdxT, int64_t, row_major>> graph_;
   std::shared_ptr<raft::device_matrix<T, int64_t, row_major>> dataset_;
   std::shared_ptr<raft::device_matrix_view<const T, int64_t, row_major>> input_dataset_v_;
-
-  inline rmm::device_async_resource_ref get_mr(AllocatorType mem_type)
-  {
-    switch (mem_type) {
-      case (AllocatorType::HostPinned): return &mr_pinned_;
-      case (AllocatorType::HostHugePage): return &mr_huge_page_;
-      default: return rmm::mr::get_current_device_resource();
-    }
-  }
+  std::optional<AllocatorType> refine_mem_ = std::nullopt;
+  placed_matrix<T, int64_t> refine_dataset_;
+  raft::device_matrix_view<const T, int64_t, row_major> refine_dataset_v_{nullptr, 0, 0};
 };
 
 template <typename T, typename IdxT>
@@ -180,30 +213,24 @@ void RaftCagra<T, IdxT>::build(const T* dataset, size_t nrow)
                                                     include_dataset)));
 }
 
-inline std::string allocator_to_string(AllocatorType mem_type)
-{
-  if (mem_type == AllocatorType::Device) {
-    return "device";
-  } else if (mem_type == AllocatorType::HostPinned) {
-    return "host_pinned";
-  } else if (mem_type == AllocatorType::HostHugePage) {
-    return "host_huge_page";
-  }
-  return "<invalid allocator type>";
-}
-
 template <typename T, typename IdxT>
 void RaftCagra<T, IdxT>::set_search_param(const AnnSearchParam& param)
 {
   auto search_param = dynamic_cast<const SearchParam&>(param);
   search_params_    = search_param.p;
   refine_ratio_     = search_param.refine_ratio;
+  if (search_param.cuda_graph && search_param.p.persistent) {
+    throw std::invalid_argument("cuda_graph and persistent search modes are mutually exclusive");
+  }
+  cuda_graph_ = search_param.cuda_graph;
+  // The captured search refers to the old parameters, graph and dataset.
+  search_graph_ = search_graph_state{};
   if (search_param.graph_mem != graph_mem_) {
     // Move graph to correct memory space
     graph_mem_ = search_param.graph_mem;
     RAFT_LOG_DEBUG("moving graph to new memory space: %s", allocator_to_string(graph_mem_).c_str());
     // We create a new graph and copy to it from existing graph
-    auto mr        = get_mr(graph_mem_);
+    auto mr        = mrs_.get_mr(graph_mem_);
     auto new_graph = make_device_mdarray<IdxT, int64_t>(
       handle_, mr, make_extents<int64_t>(index_->graph().extent(0), index_->graph_degree()));
 
@@ -228,7 +255,7 @@ void RaftCagra<T, IdxT>::set_search_param(const AnnSearchParam& param)
     RAFT_LOG_DEBUG("moving dataset to new memory space: %s",
                    allocator_to_string(dataset_mem_).c_str());
 
-    auto mr = get_mr(dataset_mem_);
+    auto mr = mrs_.get_mr(dataset_mem_);
     raft::neighbors::cagra::detail::copy_with_padding(handle_, *dataset_, *input_dataset_v_, mr);
 
     auto dataset_view = raft::make_device_strided_matrix_view<const T, int64_t>(
@@ -237,6 +264,11 @@ void RaftCagra<T, IdxT>::set_search_param(const AnnSearchParam& param)
 
     need_dataset_update_ = false;
   }
+
+  refine_mem_ = search_param.refine_mem;
+  if (refine_ratio_ > 1.0f) {
+    refine_dataset_v_ = refine_dataset_.update(handle_, mrs_, refine_mem_, *input_dataset_v_);
+  }
 }
 
 template <typename T, typename IdxT>
@@ -255,6 +287,45 @@ void RaftCagra<T, IdxT>::set_search_dataset(const T* dataset, size_t nrow)
   }
 }
 
+template <typename T, typename IdxT>
+void RaftCagra<T, IdxT>::extend(const T* dataset, size_t first_id, size_t nrow)
+{
+  using ds_idx_type = decltype(index_->data().n_rows());
+  auto* strided_dset =
+    dynamic_cast<const raft::neighbors::strided_dataset<T, ds_idx_type>*>(&index_->data());
+  if (strided_dset == nullptr || index_->graph_id_bits() != 0 ||
+      index_->removed_bitset().has_value()) {
+    throw std::runtime_error(
+      "extend needs an uncompressed dataset and graph, and no removed samples");
+  }
+  // The dataset attached for the search may hold more rows than the graph (the whole base set).
+  auto n_rows = index_->graph().extent(0);
+  if (first_id != static_cast<size_t>(n_rows)) {
+    throw std::invalid_argument("The new ids must follow the ids of the index");
+  }
+
+  // The out-of-place extend leaves the index searched by the copies of this wrapper intact: the
+  // new index only refers to the graph and the dataset of the old one, and cagra::extend replaces
+  // both with its own extended copies.
+  auto next = std::make_shared<raft::neighbors::cagra::index<T, IdxT>>(handle_, index_->metric());
+  auto old_rows = raft::make_device_strided_matrix_view<const T, int64_t>(
+    strided_dset->view().data_handle(), n_rows, this->dim_, strided_dset->stride());
+  next->update_dataset(handle_, old_rows);
+  next->update_graph(handle_, index_->graph());
+
+  raft::neighbors::cagra::extend_params params;
+  if (is_device_accessible(dataset)) {
+    auto new_rows = raft::make_device_matrix_view<const T, int64_t>(dataset, nrow, this->dim_);
+    raft::neighbors::cagra::extend(handle_, params, new_rows, *next);
+  } else {
+    auto new_rows = raft::make_host_matrix_view<const T, int64_t>(dataset, nrow, this->dim_);
+    raft::neighbors::cagra::extend(handle_, params, new_rows, *next);
+  }
+  index_ = std::move(next);
+  // The captured search refers to the old index.
+  search_graph_ = search_graph_state{};
+}
+
 template <typename T, typename IdxT>
 void RaftCagra<T, IdxT>::save(const std::string& file) const
 {
@@ -274,6 +345,13 @@ void RaftCagra<T, IdxT>::load(const std::string& file)
     std::move(raft::neighbors::cagra::deserialize<T, IdxT>(handle_, file)));
 }
 
+template <typename T, typename IdxT>
+void RaftCagra<T, IdxT>::set_search_filter(const std::uint32_t* bitset, size_t n_rows)
+{
+  filter_       = device_search_filter::make(handle_, bitset, n_rows);
+  search_graph_ = search_graph_state{};
+}
+
 template <typename T, typename IdxT>
 std::unique_ptr<ANN<T>> RaftCagra<T, IdxT>::copy()
 {
@@ -301,8 +379,62 @@ void RaftCagra<T, IdxT>::search_base(
   auto neighbors_view = raft::make_device_matrix_view<IdxT, int64_t>(neighbors_IdxT, batch_size, k);
   auto distances_view = raft::make_device_matrix_view<float, int64_t>(distances, batch_size, k);
 
-  raft::neighbors::cagra::search(
-    handle_, search_params_, *index_, queries_view, neighbors_view, distances_view);
+  if (cuda_graph_) {
+    // The plan of the search is prepared in the workspace before the capture and reused by the
+    // replays; a new batch size, k, or buffers need a new capture.
+    auto& workspace = search_graph_.workspace;
+    std::vector<std::uintptr_t> key{reinterpret_cast<std::uintptr_t>(queries),
+                                    reinterpret_cast<std::uintptr_t>(neighbors_IdxT),
+                                    reinterpret_cast<std::uintptr_t>(distances),
+                                    std::uintptr_t(batch_size),
+                                    std::uintptr_t(k)};
+    auto prepare = [&]() {
+      if (filter_) {
+        raft::neighbors::cagra::prepare_search(handle_,
+                                               search_params_,
+                                               *index_,
+                                               batch_size,
+                                               k,
+                                               workspace,
+                                               filter_->sample_filter<IdxT>());
+      } else {
+        raft::neighbors::cagra::prepare_search(
+          handle_, search_params_, *index_, batch_size, k, workspace);
+      }
+    };
+    auto search = [&]() {
+      if (filter_) {
+        raft::neighbors::cagra::search_with_filtering(handle_,
+                                                      search_params_,
+                                                      *index_,
+                                                      queries_view,
+                                                      neighbors_view,
+                                                      distances_view,
+                                                      workspace,
+                                                      filter_->sample_filter<IdxT>());
+      } else {
+        raft::neighbors::cagra::search(handle_,
+                                       search_params_,
+                                       *index_,
+                                       queries_view,
+                                       neighbors_view,
+                                       distances_view,
+                                       workspace);
+      }
+    };
+    search_graph_.graph.run(resource::get_cuda_stream(handle_), key, prepare, search);
+  } else if (filter_) {
+    raft::neighbors::cagra::search_with_filtering(handle_,
+                                                  search_params_,
+                                                  *index_,
+                                                  queries_view,
+                                                  neighbors_view,
+                                                  distances_view,
+                                                  filter_->sample_filter<IdxT>());
+  } else {
+    raft::neighbors::cagra::search(
+      handle_, search_params_, *index_, queries_view, neighbors_view, distances_view);
+  }
 
   if constexpr (sizeof(IdxT) != sizeof(AnnBase::index_type)) {
     raft::linalg::unaryOp(neighbors,
@@ -333,7 +465,7 @@ void RaftCagra<T, IdxT>::search(
     search_base(
       queries, batch_size, k0, candidate_ixs.data_handle(), candidate_dists.data_handle());
     refine_helper(
-      res, *input_dataset_v_, queries_v, candidate_ixs, k, neighbors, distances, index_->metric());
+      res, refine_dataset_v_, queries_v, candidate_ixs, k, neighbors, distances, index_->metric());
   }
 }
 }  // namespace raft::bench::ann
@@ -29,12 +29,15 @@
 #include <raft/util/cudart_utils.hpp>
 
 #include <cassert>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 namespace raft::bench::ann {
 
@@ -72,6 +75,13 @@ class RaftIvfFlatGpu : public ANN<T>, public AnnGPU {
     return handle_.get_sync_stream();
   }
 
+  [[nodiscard]] auto get_device_memory_usage() const -> std::optional<MemoryUsage> override
+  {
+    return handle_.get_memory_usage();
+  }
+
+  void reset_device_memory_peak() override { handle_.reset_memory_peak(); }
+
   // to enable dataset access from GPU memory
   AlgoProperty get_preference() const override
   {
@@ -82,6 +92,8 @@ class RaftIvfFlatGpu : public ANN<T>, public AnnGPU {
   }
   void save(const std::string& file) const override;
   void load(const std::string&) override;
+  void extend(const T* dataset, size_t first_id, size_t nrow) override;
+  void set_search_filter(const std::uint32_t* bitset, size_t n_rows) override;
   std::unique_ptr<ANN<T>> copy() override;
 
  private:
@@ -90,6 +102,7 @@ class RaftIvfFlatGpu : public ANN<T>, public AnnGPU {
   BuildParam index_params_;
   raft::neighbors::ivf_flat::search_params search_params_;
   std::shared_ptr<raft::neighbors::ivf_flat::index<T, IdxT>> index_;
+  std::shared_ptr<device_search_filter> filter_;
   int device_;
   int dimension_;
 };
@@ -124,6 +137,23 @@ void RaftIvfFlatGpu<T, IdxT>::load(const std::string& file)
   return;
 }
 
+template <typename T, typename IdxT>
+void RaftIvfFlatGpu<T, IdxT>::extend(const T* dataset, size_t first_id, size_t nrow)
+{
+  std::vector<IdxT> ids(nrow);
+  std::iota(ids.begin(), ids.end(), IdxT(first_id));
+  // The out-of-place extend leaves the index searched by the copies of this wrapper intact.
+  index_ = std::make_shared<raft::neighbors::ivf_flat::index<T, IdxT>>(std::move(
+    raft::neighbors::ivf_flat::extend(handle_, *index_, dataset, ids.data(), IdxT(nrow))));
+  resource::sync_stream(handle_);
+}
+
+template <typename T, typename IdxT>
+void RaftIvfFlatGpu<T, IdxT>::set_search_filter(const std::uint32_t* bitset, size_t n_rows)
+{
+  filter_ = device_search_filter::make(handle_, bitset, n_rows);
+}
+
 template <typename T, typename IdxT>
 std::unique_ptr<ANN<T>> RaftIvfFlatGpu<T, IdxT>::copy()
 {
@@ -145,15 +175,28 @@ void RaftIvfFlatGpu<T, IdxT>::search(
     neighbors_storage.emplace(batch_size * k, resource::get_cuda_stream(handle_));
     neighbors_IdxT = neighbors_storage->data();
   }
-  raft::neighbors::ivf_flat::search(handle_,
-                                    search_params_,
-                                    *index_,
-                                    queries,
-                                    batch_size,
-                                    k,
-                                    neighbors_IdxT,
-                                    distances,
-                                    resource::get_workspace_resource(handle_));
+  if (filter_) {
+    raft::neighbors::ivf_flat::search_with_filtering(handle_,
+                                                     search_params_,
+                                                     *index_,
+                                                     queries,
+                                                     batch_size,
+                                                     k,
+                                                     neighbors_IdxT,
+                                                     distances,
+                                                     resource::get_workspace_resource(handle_),
+                                                     filter_->sample_filter<IdxT>());
+  } else {
+    raft::neighbors::ivf_flat::search(handle_,
+                                      search_params_,
+                                      *index_,
+                                      queries,
+                                      batch_size,
+                                      k,
+                                      neighbors_IdxT,
+                                      distances,
+                                      resource::get_workspace_resource(handle_));
+  }
   if constexpr (sizeof(IdxT) != sizeof(AnnBase::index_type)) {
     raft::linalg::unaryOp(neighbors,
                           neighbors_IdxT,
@@ -32,7 +32,11 @@
 #include <raft/neighbors/refine.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <cstdint>
+#include <numeric>
+#include <optional>
 #include <type_traits>
+#include <vector>
 
 namespace raft::bench::ann {
 
@@ -45,6 +49,8 @@ class RaftIvfPQ : public ANN<T>, public AnnGPU {
   struct SearchParam : public AnnSearchParam {
     raft::neighbors::ivf_pq::search_params pq_param;
     float refine_ratio = 1.0f;
+    // Copy the dataset used in the refinement to this memory (by default, use the benchmark's)
+    std::optional<AllocatorType> refine_mem = std::nullopt;
     auto needs_dataset() const -> bool override { return refine_ratio > 1.0f; }
   };
 
@@ -77,6 +83,13 @@ class RaftIvfPQ : public ANN<T>, public AnnGPU {
     return handle_.get_sync_stream();
   }
 
+  [[nodiscard]] auto get_device_memory_usage() const -> std::optional<MemoryUsage> override
+  {
+    return handle_.get_memory_usage();
+  }
+
+  void reset_device_memory_peak() override { handle_.reset_memory_peak(); }
+
   // to enable dataset access from GPU memory
   AlgoProperty get_preference() const override
   {
@@ -87,6 +100,8 @@ class RaftIvfPQ : public ANN<T>, public AnnGPU {
   }
   void save(const std::string& file) const override;
   void load(const std::string&) override;
+  void extend(const T* dataset, size_t first_id, size_t nrow) override;
+  void set_search_filter(const std::uint32_t* bitset, size_t n_rows) override;
   std::unique_ptr<ANN<T>> copy() override;
 
  private:
@@ -95,9 +110,13 @@ class RaftIvfPQ : public ANN<T>, public AnnGPU {
   BuildParam index_params_;
   raft::neighbors::ivf_pq::search_params search_params_;
   std::shared_ptr<raft::neighbors::ivf_pq::index<IdxT>> index_;
+  std::shared_ptr<device_search_filter> filter_;
   int dimension_;
   float refine_ratio_ = 1.0;
   raft::device_matrix_view<const T, IdxT> dataset_;
+  placement_resources mrs_;
+  placed_matrix<T, IdxT> refine_dataset_;
+  raft::device_matrix_view<const T, IdxT> refine_dataset_v_;
 };
 
 template <typename T, typename IdxT>
@@ -122,6 +141,23 @@ void RaftIvfPQ<T, IdxT>::build(const T* dataset, size_t nrow)
     .swap(index_);
 }
 
+template <typename T, typename IdxT>
+void RaftIvfPQ<T, IdxT>::extend(const T* dataset, size_t first_id, size_t nrow)
+{
+  std::vector<IdxT> ids(nrow);
+  std::iota(ids.begin(), ids.end(), IdxT(first_id));
+  // The out-of-place extend leaves the index searched by the copies of this wrapper intact.
+  index_ = std::make_shared<raft::neighbors::ivf_pq::index<IdxT>>(std::move(
+    raft::neighbors::ivf_pq::extend(handle_, *index_, dataset, ids.data(), IdxT(nrow))));
+  resource::sync_stream(handle_);
+}
+
+template <typename T, typename IdxT>
+void RaftIvfPQ<T, IdxT>::set_search_filter(const std::uint32_t* bitset, size_t n_rows)
+{
+  filter_ = device_search_filter::make(handle_, bitset, n_rows);
+}
+
 template <typename T, typename IdxT>
 std::unique_ptr<ANN<T>> RaftIvfPQ<T, IdxT>::copy()
 {
@@ -135,6 +171,9 @@ void RaftIvfPQ<T, IdxT>::set_search_param(const AnnSearchParam& param)
   search_params_    = search_param.pq_param;
   refine_ratio_     = search_param.refine_ratio;
   assert(search_params_.n_probes <= index_params_.n_lists);
+  if (refine_ratio_ > 1.0f) {
+    refine_dataset_v_ = refine_dataset_.update(handle_, mrs_, search_param.refine_mem, dataset_);
+  }
 }
 
 template <typename T, typename IdxT>
@@ -165,8 +204,18 @@ void RaftIvfPQ<T, IdxT>::search_base(
     raft::make_device_matrix_view<IdxT, uint32_t>(neighbors_IdxT, batch_size, k);
   auto distances_view = raft::make_device_matrix_view<float, uint32_t>(distances, batch_size, k);
 
-  raft::neighbors::ivf_pq::search(
-    handle_, search_params_, *index_, queries_view, neighbors_view, distances_view);
+  if (filter_) {
+    raft::neighbors::ivf_pq::search_with_filtering(handle_,
+                                                   search_params_,
+                                                   *index_,
+                                                   queries_view,
+                                                   neighbors_view,
+                                                   distances_view,
+                                                   filter_->sample_filter<IdxT>());
+  } else {
+    raft::neighbors::ivf_pq::search(
+      handle_, search_params_, *index_, queries_view, neighbors_view, distances_view);
+  }
 
   if constexpr (sizeof(IdxT) != sizeof(AnnBase::index_type)) {
     raft::linalg::unaryOp(neighbors,
@@ -197,7 +246,7 @@ void RaftIvfPQ<T, IdxT>::search(
     search_base(
       queries, batch_size, k0, candidate_ixs.data_handle(), candidate_dists.data_handle());
     refine_helper(
-      res, dataset_, queries_v, candidate_ixs, k, neighbors, distances, index_->metric());
+      res, refine_dataset_v_, queries_v, candidate_ixs, k, neighbors, distances, index_->metric());
   }
 }
 }  // namespace raft::bench::ann
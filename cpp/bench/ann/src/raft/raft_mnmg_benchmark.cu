@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The distributed (multi-node multi-GPU) build benchmark. It is launched with MPI, one rank per
+ * GPU:
+ *
+ *   mpirun -n <N> RAFT_MNMG_ANN_BENCH --base_file=<file.fbin> [options] [benchmark options]
+ *
+ * Every case runs on the groups of the first 1, 2, 4, ..., N ranks, which gives the scaling curve
+ * in one launch. A group of g ranks shares the base set: rank r reads the r-th contiguous part of
+ * it (strong scaling, the size of the whole set is fixed), or g parts of a fixed size (weak
+ * scaling). The time of an iteration is the time of the slowest rank.
+ */
+
+#include "../common/dataset.hpp"
+#include "../common/util.hpp"
+
+#include <raft/cluster/kmeans_mg.cuh>
+#include <raft/comms/mpi_comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_resources.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/neighbors/cagra.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <benchmark/benchmark.h>
+#include <mpi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace raft::bench::ann::mnmg {
+
+enum class Scaling {
+  // the whole base set is fixed and split among the ranks
+  kStrong,
+  // every rank gets a fixed number of rows
+  kWeak,
+};
+
+struct config {
+  std::string base_file;
+  Scaling scaling = Scaling::kStrong;
+  // strong: the rows of the whole set (0: the whole file); weak: the rows per rank (0: the whole
+  // file split among all the ranks)
+  size_t n_rows = 0;
+  std::vector<std::string> algos{"kmeans", "ivf_flat", "cagra"};
+  int iterations = 1;
+  // k-means / IVF
+  uint32_t n_lists                = 1024;
+  int kmeans_n_iters              = 20;
+  double kmeans_trainset_fraction = 0.5;
+  // CAGRA
+  raft::neighbors::cagra::index_params cagra_params{};
+};
+
+/** The rows of the base set read by a rank of a group. */
+struct partition {
+  size_t first_row;
+  size_t n_rows;
+  size_t total_rows;
+};
+
+inline auto world_rank() -> int
+{
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  return rank;
+}
+
+inline auto world_size() -> int
+{
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  return size;
+}
+
+inline auto make_partition(const config& conf, size_t file_rows, int rank, int group_size)
+  -> partition
+{
+  if (conf.scaling == Scaling::kStrong) {
+    size_t total = conf.n_rows == 0 ? file_rows : std::min(conf.n_rows, file_rows);
+    size_t part  = total / group_size;
+    size_t rem   = total % group_size;
+    size_t r     = rank;
+    return {r * part + std::min(r, rem), part + (r < rem ? 1 : 0), total};
+  }
+  size_t part = conf.n_rows == 0 ? file_rows / world_size() : conf.n_rows;
+  if (part * group_size > file_rows) {
+    throw std::runtime_error("the base set has " + std::to_string(file_rows) + " rows, " +
+                             std::to_string(group_size) + " ranks need " +
+                             std::to_string(part * group_size));
+  }
+  return {rank * part, part, part * group_size};
+}
+
+/** The first `size` ranks of MPI_COMM_WORLD, with a RAFT handle over their communicator. */
+class rank_group {
+ public:
+  explicit rank_group(int size) : size_(size)
+  {
+    int rank = world_rank();
+    MPI_Comm_split(MPI_COMM_WORLD, rank < size ? 0 : MPI_UNDEFINED, rank, &comm_);
+    if (comm_ != MPI_COMM_NULL) {
+      res_.emplace();
+      raft::comms::initialize_mpi_comms(&*res_, comm_);
+    }
+  }
+  ~rank_group() noexcept
+  {
+    // The NCCL communicator of the handle goes first.
+    res_.reset();
+    if (comm_ != MPI_COMM_NULL) { MPI_Comm_free(&comm_); }
+  }
+  rank_group(const rank_group&)            = delete;
+  rank_group& operator=(const rank_group&) = delete;
+
+  [[nodiscard]] auto active() const -> bool { return comm_ != MPI_COMM_NULL; }
+  [[nodiscard]] auto size() const -> int { return size_; }
+  [[nodiscard]] auto res() -> raft::device_resources& { return *res_; }
+
+ private:
+  int size_;
+  MPI_Comm comm_ = MPI_COMM_NULL;
+  std::optional<raft::device_resources> res_;
+};
+
+/** Take every `ratio`-th row of the local part as the k-means training set (as ivf_flat::build). */
+inline auto make_trainset(raft::resources const& res,
+                          raft::device_matrix_view<const float, int64_t> data,
+                          const config& conf,
+                          uint32_t n_lists) -> raft::device_matrix<float, int>
+{
+  auto n_rows = size_t(data.extent(0));
+  auto dim    = size_t(data.extent(1));
+  auto ratio  = std::max<size_t>(
+    1, n_rows / std::max<size_t>(conf.kmeans_trainset_fraction * n_rows, n_lists));
+  auto n_train  = n_rows / ratio;
+  auto trainset = raft::make_device_matrix<float, int>(res, n_train, dim);
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data_handle(),
+                                  sizeof(float) * dim,
+                                  data.data_handle(),
+                                  sizeof(float) * dim * ratio,
+                                  sizeof(float) * dim,
+                                  n_train,
+                                  cudaMemcpyDefault,
+                                  resource::get_cuda_stream(res)));
+  return trainset;
+}
+
+/** Train the coarse (IVF) centers over the parts of all the ranks of the group. */
+inline void fit_centers(raft::resources const& res,
+                        raft::device_matrix_view<const float, int> trainset,
+                        const config& conf,
+                        raft::device_matrix_view<float, int> centers)
+{
+  raft::cluster::kmeans::KMeansParams params;
+  params.n_clusters = conf.n_lists;
+  params.max_iter   = conf.kmeans_n_iters;
+  float inertia;
+  int n_iter;
+  raft::cluster::kmeans::fit_mg(res,
+                                params,
+                                trainset,
+                                std::nullopt,
+                                centers,
+                                raft::make_host_scalar_view(&inertia),
+                                raft::make_host_scalar_view(&n_iter));
+}
+
+/**
+ * The distributed IVF-Flat build: the centers are trained together, and every rank fills the lists
+ * of its own index with its part (the ids are the rows of the whole set).
+ */
+inline void build_ivf_flat(raft::resources const& res,
+                           raft::device_matrix_view<const float, int64_t> data,
+                           const partition& part,
+                           const config& conf)
+{
+  auto stream   = resource::get_cuda_stream(res);
+  auto dim      = uint32_t(data.extent(1));
+  auto trainset = make_trainset(res, data, conf, conf.n_lists);
+  raft::neighbors::ivf_flat::index_params params;
+  params.n_lists = conf.n_lists;
+  raft::neighbors::ivf_flat::index<float, int64_t> index(res, params, dim);
+  fit_centers(res,
+              raft::make_const_mdspan(trainset.view()),
+              conf,
+              raft::make_device_matrix_view<float, int>(index.centers().data_handle(),
+                                                        index.n_lists(),
+                                                        index.dim()));
+  RAFT_CUDA_TRY(cudaMemsetAsync(
+    index.list_sizes().data_handle(), 0, index.list_sizes().size() * sizeof(uint32_t), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(
+    index.data_ptrs().data_handle(), 0, index.data_ptrs().size() * sizeof(float*), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(
+    index.inds_ptrs().data_handle(), 0, index.inds_ptrs().size() * sizeof(int64_t*), stream));
+  std::fill_n(index.accum_sorted_sizes().data_handle(), index.accum_sorted_sizes().size(), 0);
+
+  auto ids = raft::make_device_vector<int64_t, int64_t>(res, part.n_rows);
+  raft::linalg::map_offset(res, ids.view(), raft::add_const_op<int64_t>{int64_t(part.first_row)});
+  raft::neighbors::ivf_flat::extend(
+    res, data, std::make_optional(raft::make_const_mdspan(ids.view())), &index);
+}
+
+/** Silences the benchmark output of all but the first rank. */
+class silent_reporter : public ::benchmark::BenchmarkReporter {
+ public:
+  auto ReportContext(const Context&) -> bool override { return true; }
+  void ReportRuns(const std::vector<Run>&) override {}
+};
+
+// The mean time of a case on one rank, the base of the scaling efficiency
+inline std::map<std::string, double> single_rank_time;
+
+void bench_build(::benchmark::State& state,
+                 const config& conf,
+                 const std::string& algo,
+                 int group_size)
+{
+  size_t file_rows;
+  int dim;
+  BinFile<float>(conf.base_file, "r").get_shape(&file_rows, &dim);
+
+  rank_group group{group_size};
+  auto part = make_partition(conf, file_rows, world_rank(), group_size);
+  std::optional<raft::device_matrix<float, int64_t>> data;
+  std::optional<raft::device_matrix<float, int>> trainset;
+  std::optional<raft::device_matrix<float, int>> centers;
+  if (group.active()) {
+    auto& res = group.res();
+    data.emplace(raft::make_device_matrix<float, int64_t>(res, part.n_rows, dim));
+    BinFile<float>(conf.base_file, "r", uint32_t(part.first_row), uint32_t(part.n_rows))
+      .read_to_device(data->data_handle());
+    if (algo == "kmeans") {
+      trainset.emplace(
+        make_trainset(res, raft::make_const_mdspan(data->view()), conf, conf.n_lists));
+      centers.emplace(raft::make_device_matrix<float, int>(res, conf.n_lists, dim));
+    }
+    resource::sync_stream(res);
+  }
+
+  double total_time      = 0;
+  double total_imbalance = 0;
+  for (auto _ : state) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    double local_time = 0;
+    if (group.active()) {
+      auto& res  = group.res();
+      auto start = std::chrono::steady_clock::now();
+      auto view  = raft::make_const_mdspan(data->view());
+      if (algo == "kmeans") {
+        fit_centers(res, raft::make_const_mdspan(trainset->view()), conf, centers->view());
+      } else if (algo == "ivf_flat") {
+        build_ivf_flat(res, view, part, conf);
+      } else if (algo == "cagra") {
+        // Every rank builds the graph of its own shard.
+        raft::neighbors::cagra::build<float, uint32_t>(res, conf.cagra_params, view);
+      }
+      resource::sync_stream(res);
+      local_time =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    double max_time, sum_time;
+    MPI_Allreduce(&local_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&local_time, &sum_time, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    state.SetIterationTime(max_time);
+    total_time += max_time;
+    total_imbalance += max_time * group_size / std::max(sum_time, 1e-9);
+  }
+
+  auto iterations = double(state.iterations());
+  auto mean_time  = total_time / iterations;
+  if (group_size == 1) { single_rank_time[algo] = mean_time; }
+
+  state.counters["n_ranks"]    = group_size;
+  state.counters["total_rows"] = part.total_rows;
+  state.counters["rows_per_s"] =
+    ::benchmark::Counter(part.total_rows, ::benchmark::Counter::kIsIterationInvariantRate);
+  // the slowest rank over the mean
+  state.counters["imbalance"] = total_imbalance / iterations;
+  auto base                   = single_rank_time.find(algo);
+  if (base != single_rank_time.end()) {
+    // strong: T(1) / (g * T(g)); weak: T(1) / T(g)
+    auto ideal_time = conf.scaling == Scaling::kStrong ? base->second / group_size : base->second;
+    state.counters["scaling_efficiency"] = ideal_time / mean_time;
+  }
+}
+
+void register_build(const config& conf)
+{
+  std::vector<int> group_sizes;
+  for (int g = 1; g < world_size(); g *= 2) {
+    group_sizes.push_back(g);
+  }
+  group_sizes.push_back(world_size());
+  auto scaling = conf.scaling == Scaling::kStrong ? "strong" : "weak";
+  for (const auto& algo : conf.algos) {
+    for (auto g : group_sizes) {
+      auto name = algo + "/" + scaling + "/ranks:" + std::to_string(g);
+      ::benchmark::RegisterBenchmark(name.c_str(), bench_build, conf, algo, g)
+        ->Iterations(conf.iterations)
+        ->UseManualTime()
+        ->Unit(::benchmark::kSecond);
+    }
+  }
+}
+
+inline void printf_usage()
+{
+  fprintf(stderr,
+          "usage: mpirun -n <N> [this binary] --base_file=<file.fbin> [--scaling=strong|weak]\n"
+          "  [--rows=<n>] [--algos=kmeans,ivf_flat,cagra] [--iterations=<n>] [--n_lists=<n>]\n"
+          "  [--kmeans_n_iters=<n>] [--kmeans_trainset_fraction=<f>] [--graph_degree=<n>]\n"
+          "  [--intermediate_graph_degree=<n>] [--graph_build_algo=IVF_PQ|NN_DESCENT]\n"
+          "  [benchmark options]\n"
+          "  --scaling: strong (default), the rows of the whole set are fixed;\n"
+          "             weak, every rank gets the same number of rows\n"
+          "  --rows: the rows of the whole set (strong), or of every rank (weak)\n"
+          "  The cases run on the groups of the first 1, 2, 4, ..., N ranks.\n");
+}
+
+inline auto parse_flag(const char* arg, const char* pat, std::string& result) -> bool
+{
+  auto n = strlen(pat);
+  if (strncmp(pat, arg, n) == 0 && arg[n] == '=') {
+    result = arg + n + 1;
+    return true;
+  }
+  return false;
+}
+
+inline auto run_main(int argc, char** argv) -> int
+{
+  config conf;
+  std::string scaling, rows, algos, iterations, n_lists, kmeans_n_iters, trainset_fraction,
+    graph_degree, intermediate_graph_degree, graph_build_algo;
+  std::vector<char*> rest{argv[0]};
+  for (int i = 1; i < argc; i++) {
+    if (parse_flag(argv[i], "--base_file", conf.base_file) ||
+        parse_flag(argv[i], "--scaling", scaling) || parse_flag(argv[i], "--rows", rows) ||
+        parse_flag(argv[i], "--algos", algos) ||
+        parse_flag(argv[i], "--iterations", iterations) ||
+        parse_flag(argv[i], "--n_lists", n_lists) ||
+        parse_flag(argv[i], "--kmeans_n_iters", kmeans_n_iters) ||
+        parse_flag(argv[i], "--kmeans_trainset_fraction", trainset_fraction) ||
+        parse_flag(argv[i], "--graph_degree", graph_degree) ||
+        parse_flag(argv[i], "--intermediate_graph_degree", intermediate_graph_degree) ||
+        parse_flag(argv[i], "--graph_build_algo", graph_build_algo)) {
+      continue;
+    }
+    // Only the first rank writes the benchmark output file.
+    if (world_rank() != 0 && strncmp(argv[i], "--benchmark_out", 15) == 0) { continue; }
+    rest.push_back(argv[i]);
+  }
+  if (conf.base_file.empty()) {
+    printf_usage();
+    return -1;
+  }
+  if (scaling == "weak") {
+    conf.scaling = Scaling::kWeak;
+  } else if (!scaling.empty() && scaling != "strong") {
+    log_error("invalid --scaling=%s", scaling.c_str());
+    return -1;
+  }
+  if (!rows.empty()) { conf.n_rows = std::stoull(rows); }
+  if (!algos.empty()) { conf.algos = split(algos, ','); }
+  for (const auto& algo : conf.algos) {
+    if (algo != "kmeans" && algo != "ivf_flat" && algo != "cagra") {
+      log_error("unknown algorithm '%s'", algo.c_str());
+      return -1;
+    }
+  }
+  if (!iterations.empty()) { conf.iterations = std::stoi(iterations); }
+  if (!n_lists.empty()) { conf.n_lists = std::stoul(n_lists); }
+  if (!kmeans_n_iters.empty()) { conf.kmeans_n_iters = std::stoi(kmeans_n_iters); }
+  if (!trainset_fraction.empty()) { conf.kmeans_trainset_fraction = std::stod(trainset_fraction); }
+  if (!graph_degree.empty()) { conf.cagra_params.graph_degree = std::stoul(graph_degree); }
+  if (!intermediate_graph_degree.empty()) {
+    conf.cagra_params.intermediate_graph_degree = std::stoul(intermediate_graph_degree);
+  }
+  if (graph_build_algo == "NN_DESCENT") {
+    conf.cagra_params.build_algo = raft::neighbors::cagra::graph_build_algo::NN_DESCENT;
+  } else if (!graph_build_algo.empty() && graph_build_algo != "IVF_PQ") {
+    log_error("invalid --graph_build_algo=%s", graph_build_algo.c_str());
+    return -1;
+  }
+
+  register_build(conf);
+  int bench_argc = int(rest.size());
+  ::benchmark::Initialize(&bench_argc, rest.data(), printf_usage);
+  if (::benchmark::ReportUnrecognizedArguments(bench_argc, rest.data())) return -1;
+  if (world_rank() == 0) {
+    ::benchmark::RunSpecifiedBenchmarks();
+  } else {
+    silent_reporter reporter;
+    ::benchmark::RunSpecifiedBenchmarks(&reporter);
+  }
+  ::benchmark::Shutdown();
+  return 0;
+}
+
+}  // namespace raft::bench::ann::mnmg
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc, &argv);
+  // One GPU per rank of a node
+  {
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+    int local_rank, n_devices;
+    MPI_Comm_rank(node_comm, &local_rank);
+    MPI_Comm_free(&node_comm);
+    RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+    RAFT_CUDA_TRY(cudaSetDevice(local_rank % n_devices));
+  }
+  int ret = raft::bench::ann::mnmg::run_main(argc, argv);
+  MPI_Finalize();
+  return ret;
+}
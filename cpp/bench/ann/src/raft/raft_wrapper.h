@@ -74,6 +74,11 @@ class RaftGpu : public ANN<T>, public AnnGPU {
   {
     return handle_.get_sync_stream();
   }
+  [[nodiscard]] auto get_device_memory_usage() const -> std::optional<MemoryUsage> override
+  {
+    return handle_.get_memory_usage();
+  }
+  void reset_device_memory_peak() override { handle_.reset_memory_peak(); }
   void set_search_dataset(const T* dataset, size_t nrow) override;
   void save(const std::string& file) const override;
   void load(const std::string&) override;
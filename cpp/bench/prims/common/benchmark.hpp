@@ -21,11 +21,13 @@
 #include <raft/core/device_resources.hpp>
 #include <raft/core/interruptible.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_properties.hpp>
 #include <raft/random/make_blobs.cuh>
 #include <raft/util/cudart_utils.hpp>
 
 #include <rmm/cuda_device.hpp>
 #include <rmm/cuda_stream.hpp>
+#include <rmm/cuda_stream_pool.hpp>
 #include <rmm/cuda_stream_view.hpp>
 #include <rmm/device_buffer.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
@@ -34,7 +36,14 @@
 
 #include <benchmark/benchmark.h>
 
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace raft::bench {
 
@@ -74,6 +83,7 @@ struct cuda_event_timer {
  private:
   ::benchmark::State* state_;
   rmm::cuda_stream_view stream_;
+  double* total_seconds_;
   cudaEvent_t start_;
   cudaEvent_t stop_;
 
@@ -81,9 +91,12 @@ struct cuda_event_timer {
   /**
    * @param state  the benchmark::State whose timer we are going to update.
    * @param stream CUDA stream we are measuring time on.
+   * @param total_seconds if not null, the measured time is also added to it.
    */
-  cuda_event_timer(::benchmark::State& state, rmm::cuda_stream_view stream)
-    : state_(&state), stream_(stream)
+  cuda_event_timer(::benchmark::State& state,
+                   rmm::cuda_stream_view stream,
+                   double* total_seconds = nullptr)
+    : state_(&state), stream_(stream), total_seconds_(total_seconds)
   {
     RAFT_CUDA_TRY(cudaEventCreate(&start_));
     RAFT_CUDA_TRY(cudaEventCreate(&stop_));
@@ -104,11 +117,152 @@ struct cuda_event_timer {
     float milliseconds = 0.0f;
     RAFT_CUDA_TRY_NO_THROW(cudaEventElapsedTime(&milliseconds, start_, stop_));
     state_->SetIterationTime(milliseconds / 1000.f);
+    if (total_seconds_ != nullptr) { *total_seconds_ += milliseconds / 1000.0; }
     RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(start_));
     RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(stop_));
   }
 };
 
+/** The peak throughput of a device, the roof of the roofline counters. */
+struct device_peak {
+  /** The device memory bandwidth. */
+  double bytes_per_second;
+  /** The FP32 throughput of the CUDA cores (fused multiply-add counted as two operations). */
+  double flops_per_second;
+};
+
+/** The FP32 cores per SM of the compute capability `major.minor`. */
+inline auto fp32_cores_per_sm(int major, int minor) -> int
+{
+  switch (major) {
+    case 6: return minor == 0 ? 64 : 128;
+    case 7: return 64;
+    case 8: return minor == 0 ? 64 : 128;
+    default: return 128;
+  }
+}
+
+inline auto get_device_peak(raft::resources const& handle) -> device_peak
+{
+  auto& prop = resource::get_device_properties(handle);
+  int device_id, clock_khz, memory_clock_khz;
+  RAFT_CUDA_TRY(cudaGetDevice(&device_id));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&clock_khz, cudaDevAttrClockRate, device_id));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&memory_clock_khz, cudaDevAttrMemoryClockRate, device_id));
+  // double data rate
+  double bandwidth = 2.0 * memory_clock_khz * 1e3 * (prop.memoryBusWidth / 8);
+  double flops =
+    2.0 * clock_khz * 1e3 * prop.multiProcessorCount * fp32_cores_per_sm(prop.major, prop.minor);
+  return {bandwidth, flops};
+}
+
+/**
+ * Host threads that call a function at the same time, each with its own `raft::device_resources`
+ * on a stream of a pool (and its own workspace), the way an application issues small concurrent
+ * calls from several threads.
+ */
+class concurrent_runner {
+ public:
+  explicit concurrent_runner(int n_threads) : stream_pool_(n_threads), done_(n_threads)
+  {
+    int device_id;
+    RAFT_CUDA_TRY(cudaGetDevice(&device_id));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&start_, cudaEventDisableTiming));
+    for (int i = 0; i < n_threads; i++) {
+      resources_.emplace_back(std::make_unique<raft::device_resources>(stream_pool_.get_stream(i)));
+      RAFT_CUDA_TRY(cudaEventCreateWithFlags(&done_[i], cudaEventDisableTiming));
+    }
+    for (int i = 0; i < n_threads; i++) {
+      threads_.emplace_back([this, i, device_id]() { worker(i, device_id); });
+    }
+  }
+
+  ~concurrent_runner() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+      generation_++;
+    }
+    start_cv_.notify_all();
+    for (auto& t : threads_) {
+      t.join();
+    }
+    for (auto& e : done_) {
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(e));
+    }
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(start_));
+  }
+
+  [[nodiscard]] auto size() const -> int { return resources_.size(); }
+
+  /**
+   * Call `f(res, i)` on every thread `i`. The work of the threads is ordered after the work
+   * submitted to `stream` before the call, and the work submitted to `stream` after the call is
+   * ordered after the work of the threads. Returns when all the threads have returned; rethrows
+   * the first exception of the threads.
+   */
+  void run(rmm::cuda_stream_view stream, std::function<void(const raft::device_resources&, int)> f)
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(start_, stream));
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_    = std::move(f);
+    pending_ = size();
+    error_   = nullptr;
+    generation_++;
+    start_cv_.notify_all();
+    done_cv_.wait(lock, [this]() { return pending_ == 0; });
+    task_ = nullptr;
+    if (error_) { std::rethrow_exception(error_); }
+    for (auto& e : done_) {
+      RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, e));
+    }
+  }
+
+ private:
+  rmm::cuda_stream_pool stream_pool_;
+  std::vector<std::unique_ptr<raft::device_resources>> resources_;
+  std::vector<std::thread> threads_;
+  cudaEvent_t start_;
+  std::vector<cudaEvent_t> done_;
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  std::function<void(const raft::device_resources&, int)> task_;
+  uint64_t generation_ = 0;
+  int pending_         = 0;
+  bool stop_           = false;
+  std::exception_ptr error_;
+
+  void worker(int i, int device_id)
+  {
+    RAFT_CUDA_TRY_NO_THROW(cudaSetDevice(device_id));
+    auto& res           = *resources_[i];
+    auto stream         = resource::get_cuda_stream(res);
+    uint64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_cv_.wait(lock, [&]() { return generation_ != generation; });
+        generation = generation_;
+        if (stop_) { return; }
+      }
+      std::exception_ptr error;
+      try {
+        RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, start_));
+        task_(res, i);
+        RAFT_CUDA_TRY(cudaEventRecord(done_[i], stream));
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (error && !error_) { error_ = error; }
+      if (--pending_ == 0) { done_cv_.notify_one(); }
+    }
+  }
+};
+
 /** Main fixture to be inherited and used by all other c++ benchmarks */
 class fixture {
  private:
@@ -147,6 +301,29 @@ class fixture {
   virtual void allocate_temp_buffers(const ::benchmark::State& state) {}
   virtual void deallocate_temp_buffers(const ::benchmark::State& state) {}
 
+  /**
+   * Add the roofline counters of the work declared with `set_work_per_iteration`:
+   *   - `GB/s`, `bw_peak_%`: the achieved device memory throughput and its share of the peak
+   *   - `TFLOP/s`, `flop_peak_%`, `flop_per_byte`: the same for the floating-point operations,
+   *     and the arithmetic intensity (only if the flops are declared)
+   * The time is the one measured by `loop_on_state`.
+   */
+  void report_roofline(::benchmark::State& state)
+  {
+    if (work_bytes_ <= 0 || measured_seconds_ <= 0) { return; }
+    auto peak                   = get_device_peak(handle);
+    auto iterations             = double(state.iterations());
+    auto bytes_rate             = work_bytes_ * iterations / measured_seconds_;
+    state.counters["GB/s"]      = bytes_rate * 1e-9;
+    state.counters["bw_peak_%"] = 100.0 * bytes_rate / peak.bytes_per_second;
+    if (work_flops_ > 0) {
+      auto flops_rate                 = work_flops_ * iterations / measured_seconds_;
+      state.counters["TFLOP/s"]       = flops_rate * 1e-12;
+      state.counters["flop_peak_%"]   = 100.0 * flops_rate / peak.flops_per_second;
+      state.counters["flop_per_byte"] = work_flops_ / work_bytes_;
+    }
+  }
+
  protected:
   /** The helper that writes zeroes to some buffer in GPU memory to flush the L2 cache.  */
   void flush_L2_cache()
@@ -154,6 +331,17 @@ class fixture {
     RAFT_CUDA_TRY(cudaMemsetAsync(scratch_buf_.data(), 0, scratch_buf_.size(), stream));
   }
 
+  /**
+   * Declare the work of one iteration: the bytes read from and written to the device memory (the
+   * minimum the operation needs), and the floating-point operations. The harness then reports the
+   * achieved throughput and its share of the device peak (see `report_roofline`).
+   */
+  void set_work_per_iteration(double bytes, double flops = 0)
+  {
+    work_bytes_ = bytes;
+    work_flops_ = flops;
+  }
+
   /**
    * The helper to be used inside `run_benchmark`, to loop over the state and record time using the
    * cuda_event_timer.
@@ -161,12 +349,48 @@ class fixture {
   template <typename Lambda>
   void loop_on_state(::benchmark::State& state, Lambda benchmark_func, bool flush_L2 = true)
   {
+    measured_seconds_ = 0;
     for (auto _ : state) {
       if (flush_L2) { flush_L2_cache(); }
-      cuda_event_timer timer(state, stream);
+      cuda_event_timer timer(state, stream, &measured_seconds_);
       benchmark_func();
     }
   }
+
+  /**
+   * The helper to be used inside `run_benchmark` instead of `loop_on_state` to measure
+   * `n_concurrent` instances of a call running at the same time: every iteration, each instance
+   * `i` calls `benchmark_func(res, i)` from its own host thread, with its own resources on its own
+   * stream (see `concurrent_runner`). The iteration time spans all of them, and the counters
+   * report the aggregate rate of the calls. The declared work (`set_work_per_iteration`) is that
+   * of all the instances together.
+   */
+  template <typename Lambda>
+  void loop_on_state_concurrent(::benchmark::State& state,
+                                int n_concurrent,
+                                Lambda benchmark_func,
+                                bool flush_L2 = true)
+  {
+    if (!runner_ || runner_->size() != n_concurrent) {
+      runner_ = std::make_unique<concurrent_runner>(n_concurrent);
+    }
+    measured_seconds_ = 0;
+    for (auto _ : state) {
+      if (flush_L2) { flush_L2_cache(); }
+      cuda_event_timer timer(state, stream, &measured_seconds_);
+      runner_->run(stream, benchmark_func);
+    }
+    state.counters["n_concurrent"] = n_concurrent;
+    if (measured_seconds_ > 0) {
+      state.counters["calls/s"] = n_concurrent * double(state.iterations()) / measured_seconds_;
+    }
+  }
+
+ private:
+  std::unique_ptr<concurrent_runner> runner_;
+  double work_bytes_       = 0;
+  double work_flops_       = 0;
+  double measured_seconds_ = 0;
 };
 
 /** Indicates the dataset size. */
@@ -266,6 +490,7 @@ class Fixture : public ::benchmark::Fixture {
   {
     fixture_->run_benchmark(state);
     fixture_->generate_metrics(state);
+    fixture_->report_roofline(state);
   }
 };  // class Fixture
 
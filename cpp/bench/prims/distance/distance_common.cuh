@@ -28,6 +28,20 @@ struct distance_params {
   bool isRowMajor;
 };  // struct distance_params
 
+/** The floating-point operations per element pair and dimension of a metric. */
+constexpr auto flops_per_term(raft::distance::DistanceType metric) -> double
+{
+  switch (metric) {
+    // the GEMM-based metrics: a fused multiply-add
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::CosineExpanded:
+    case raft::distance::DistanceType::InnerProduct: return 2;
+    // subtract, then abs or square, then add
+    default: return 3;
+  }
+}
+
 template <typename T, raft::distance::DistanceType DType>
 struct distance : public fixture {
   distance(const distance_params& p)
@@ -43,6 +57,8 @@ struct distance : public fixture {
     worksize = raft::distance::getWorkspaceSize<DType, T, T, T>(
       x.data(), y.data(), params.m, params.n, params.k);
     workspace.resize(worksize, stream);
+    double m = p.m, n = p.n, k = p.k;
+    set_work_per_iteration((m * k + n * k + m * n) * sizeof(T), flops_per_term(DType) * m * n * k);
   }
 
   void run_benchmark(::benchmark::State& state) override
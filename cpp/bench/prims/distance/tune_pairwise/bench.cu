@@ -21,32 +21,44 @@
 // 1. Fast compile times to maintain iteration speed.
 // 2. Create benchmarks that can inform the design of the kernels.
 //
+// 3. Tune the policy chosen by the library dispatch.
+//
 // Non-goals:
 //
-// 1. Measure every distance operation. Instead measures just one distance
-//    operation at the same time.
-// 2. Be useful for finding performance regressions. This is handled by the
+// 1. Be useful for finding performance regressions. This is handled by the
 //    normal benchmarks.
 //
-// So far, both goals are partly achieved.
+// So far, the goals are partly achieved.
 //
 // RE (1), COMPILE TIMES: kernel.cu is fast to compile. This file is not.
 // When the internals of a pairwise distance kernel is changed, this file is not
 // recompiled.
 //
 // RE 2, benchmarks with intent: this file contains a benchmark to check the
-// maximal throughput of a kernel. Measuring other things, like performance on
-// skinny or wide matrices is not yet implemented.
+// maximal throughput of a kernel.
+//
+// RE 3, tuning: the tuning benchmark times every vec_len of the tunable ops on
+// the shapes of each bucket of the tuned policy table. The script
+// cpp/scripts/heuristics/pairwise_distance/generate_tuned_policy.py turns its
+// JSON output into raft/distance/detail/pairwise_matrix/tuned_policy_table.hpp:
+//
+//   ./TUNE_DISTANCE --benchmark_filter=tuning_bench \
+//     --benchmark_out_format=json --benchmark_out=tune_distance.json
 
 #include "kernel.cuh"  // launch_kernel
 
 #include <common/benchmark.hpp>  // RAFT_BENCH_REGISTER
 
-#include <raft/distance/detail/pairwise_matrix/params.cuh>  // pairwise_matrix_params
+#include <raft/distance/detail/pairwise_matrix/params.cuh>        // pairwise_matrix_params
+#include <raft/distance/detail/pairwise_matrix/tuned_policy.cuh>  // tuning_shape_bucket
+#include <raft/util/cudart_utils.hpp>                             // raft::getMultiProcessorCount
 
 #include <rmm/device_uvector.hpp>  // rmm::device_uvector
 
 #include <algorithm>  // std::min
+#include <sstream>    // std::ostringstream
+#include <string>     // std::string
+#include <utility>    // std::pair
 #include <vector>     // std::vector
 
 namespace raft::bench::distance::tune {
@@ -64,16 +76,29 @@ namespace raft::bench::distance::tune {
 //
 // - Multiple iterations over Kblk are executed (num_k_iters).
 struct throughput_param {
+  std::string op;
+  int vec_len;
   int num_waves;
   int occupancy;
   int num_k_iters;
 };
 
-const std::vector<throughput_param> throughput_params{
-  // 32 waves, requested occupancy of 4, and 32 k iterations typically achieves
-  // maximum throughput. No need to pick higher values.
-  {32, 4, 32},
-};
+// All vec_len of the tunable ops, vec_len = 1 of the others.
+std::vector<throughput_param> make_throughput_params()
+{
+  std::vector<throughput_param> params;
+  for (const auto& op : distance_ops()) {
+    for (int vec_len : {1, 2, 4}) {
+      if (vec_len > 1 && !is_tunable(op)) { continue; }
+      // 32 waves, requested occupancy of 4, and 32 k iterations typically achieves
+      // maximum throughput. No need to pick higher values.
+      params.push_back({op, vec_len, 32, 4, 32});
+    }
+  }
+  return params;
+}
+
+const std::vector<throughput_param> throughput_params = make_throughput_params();
 
 struct throughput_bench : public fixture {
   const throughput_param p;
@@ -82,14 +107,16 @@ struct throughput_bench : public fixture {
 
   void run_benchmark(::benchmark::State& state) override
   {
+    state.SetLabel(p.op + "#vec_len=" + std::to_string(p.vec_len));
+
     // Get block size:
     int block_m, block_n, block_k;
-    get_block_size(block_m, block_n, block_k);
+    get_block_size(p.vec_len, block_m, block_n, block_k);
 
     // Determine number of blocks that will be launched. This informs the size
     // of the inputs as well as the grid size.
     const int num_sms       = raft::getMultiProcessorCount();
-    const int max_occupancy = get_max_occupancy();
+    const int max_occupancy = get_max_occupancy(p.op, p.vec_len);
     const int occupancy     = std::min(p.occupancy, max_occupancy);
     const int num_blocks    = occupancy * num_sms;
     dim3 grid(num_blocks);
@@ -123,7 +150,7 @@ struct throughput_bench : public fixture {
       IdxT(m), IdxT(n), IdxT(k), ldx, ldy, ld_out, x, y, x_norm, y_norm, out, fin_op, row_major};
 
     // Run benchmark
-    loop_on_state(state, [&]() { launch_kernel(kparams, grid, stream); });
+    loop_on_state(state, [&]() { launch_kernel(p.op, p.vec_len, kparams, grid, stream); });
 
     // Report metrics. We don't report flop/s because we do not know for each
     // distance operation how many flops it costs. For L2_unexp and l1, we can
@@ -152,4 +179,93 @@ struct throughput_bench : public fixture {
 
 RAFT_BENCH_REGISTER(throughput_bench, "", throughput_params);
 
+// Tuning benchmark.
+//
+// Goal: Time the kernels that the library dispatch can choose from on the
+// shapes of each bucket of the tuned policy table.
+//
+// The grid is chosen as in the library dispatch. The counters identify the
+// entry of the table the measurement belongs to.
+struct tuning_param {
+  std::string op;
+  int vec_len;
+  int m;
+  int n;
+  int k;
+};
+
+// Two shapes per k bucket of tuning_shape_bucket: a small and a large output,
+// each once square and once skinny.
+std::vector<tuning_param> make_tuning_params()
+{
+  const std::vector<std::pair<int, int>> out_shapes{
+    {1024, 1024}, {64, 16384}, {8192, 8192}, {512, 65536}};
+  const std::vector<int> ks{8, 16, 32, 64, 128, 256, 512, 1024};
+
+  std::vector<tuning_param> params;
+  for (const auto& op : distance_ops()) {
+    if (!is_tunable(op)) { continue; }
+    for (int vec_len : {1, 2, 4}) {
+      for (auto [m, n] : out_shapes) {
+        for (int k : ks) {
+          params.push_back({op, vec_len, m, n, k});
+        }
+      }
+    }
+  }
+  return params;
+}
+
+const std::vector<tuning_param> tuning_params = make_tuning_params();
+
+struct tuning_bench : public fixture {
+  const tuning_param p;
+
+  tuning_bench(const tuning_param& p_) : p(p_) {}
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label;
+    label << p.op << "#vec_len=" << p.vec_len << "#m=" << p.m << "#n=" << p.n << "#k=" << p.k;
+    state.SetLabel(label.str());
+
+    size_t m = p.m;
+    size_t n = p.n;
+    size_t k = p.k;
+
+    rmm::device_uvector<DataT> x_vec(m * k, stream);
+    rmm::device_uvector<DataT> y_vec(n * k, stream);
+    rmm::device_uvector<DataT> x_norm_vec(m, stream);
+    rmm::device_uvector<DataT> y_norm_vec(n, stream);
+    rmm::device_uvector<OutT> out_vec(m * n, stream);
+
+    IdxT ldx    = row_major ? k : m;
+    IdxT ldy    = row_major ? k : n;
+    IdxT ld_out = row_major ? n : m;
+
+    pairwise_matrix_params kparams{IdxT(m),
+                                   IdxT(n),
+                                   IdxT(k),
+                                   ldx,
+                                   ldy,
+                                   ld_out,
+                                   x_vec.data(),
+                                   y_vec.data(),
+                                   x_norm_vec.data(),
+                                   y_norm_vec.data(),
+                                   out_vec.data(),
+                                   FinOpT{},
+                                   row_major};
+
+    loop_on_state(state, [&]() { launch_kernel(p.op, p.vec_len, kparams, dim3(0), stream); });
+
+    state.counters["sm"]           = raft::distance::detail::tuning_device_sm();
+    state.counters["data_bytes"]   = sizeof(DataT);
+    state.counters["shape_bucket"] = raft::distance::detail::tuning_shape_bucket(m, n, k);
+    state.counters["vec_len"]      = p.vec_len;
+  }
+};
+
+RAFT_BENCH_REGISTER(tuning_bench, "", tuning_params);
+
 }  // namespace raft::bench::distance::tune
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2023-2024, NVIDIA CORPORATION.
+ * Copyright (c) 2023, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -16,73 +16,136 @@
 
 #include "kernel.cuh"
 
-#include <raft/distance/detail/pairwise_matrix/kernel_sm60.cuh>  // pairwise_matrix_sm60_wrapper
-#include <raft/linalg/contractions.cuh>                          // raft::linalg::Policy4x4
+#include <raft/core/error.hpp>                                    // RAFT_FAIL
+#include <raft/distance/detail/pairwise_matrix/kernel_sm60.cuh>   // pairwise_matrix_sm60_wrapper
+#include <raft/distance/detail/pairwise_matrix/tuned_policy.cuh>  // tuning_name
+#include <raft/linalg/contractions.cuh>                           // raft::linalg::Policy4x4
 #include <raft/util/arch.cuh>  // raft::util::arch::SM_compute_arch
 
+#include <algorithm>  // std::min
+#include <tuple>      // std::tuple, std::apply
+
 namespace raft::bench::distance::tune {
 
-// Distance op
-using OpT                  = raft::distance::detail::ops::lp_unexp_distance_op<DataT, AccT, IdxT>;
-constexpr float metric_arg = 2.0;
-OpT distance_op{metric_arg};
+namespace ops = raft::distance::detail::ops;
+
+// Distance ops. The correlation op is missing, because it needs the
+// precomputed sums of the rows in addition to the norms.
+auto make_distance_ops(IdxT k)
+{
+  return std::make_tuple(ops::canberra_distance_op<DataT, AccT, IdxT>{},
+                         ops::cosine_distance_op<DataT, AccT, IdxT>{},
+                         ops::dice_distance_op<DataT, AccT, IdxT>{},
+                         ops::hamming_distance_op<DataT, AccT, IdxT>{k},
+                         ops::hellinger_distance_op<DataT, AccT, IdxT>{},
+                         ops::inner_product_distance_op<DataT, AccT, IdxT>{},
+                         ops::l1_distance_op<DataT, AccT, IdxT>{},
+                         ops::l2_exp_distance_op<DataT, AccT, IdxT>{false},
+                         ops::l2_unexp_distance_op<DataT, AccT, IdxT>{false},
+                         ops::l_inf_distance_op<DataT, AccT, IdxT>{},
+                         ops::lp_unexp_distance_op<DataT, AccT, IdxT>{DataT(2)},
+                         ops::russel_rao_distance_op<DataT, AccT, IdxT>{k});
+}
 
 // Kernel policy
-constexpr int vec_len = 1;
-using Policy          = typename raft::linalg::Policy4x4<DataT, vec_len>::Policy;
+template <int vec_len>
+using Policy = typename raft::linalg::Policy4x4<DataT, vec_len>::Policy;
 
 // Architecture
 namespace arch                 = raft::util::arch;
 constexpr auto sm_compat_range = arch::SM_range(arch::SM_min(), arch::SM_future());
 
-void launch_kernel(pairwise_matrix_params params, dim3 grid, cudaStream_t stream)
+// Calls f(distance_op, wrapper) with the kernel wrapper of the named op and
+// vec_len. As in dispatch_sm60.cuh, the ops with an expensive inner loop are
+// only compiled with vec_len = 1.
+template <typename F>
+void with_kernel(const std::string& op, int vec_len, pairwise_matrix_params params, F&& f)
 {
-  dim3 block(Policy::Nthreads);
-  int smem_size = OpT::shared_mem_size<Policy>();
-
-  // Obtain function pointer to kernel
-  auto kernel = raft::distance::detail::pairwise_matrix_kernel<Policy,
-                                                               row_major,
-                                                               decltype(sm_compat_range),
-                                                               OpT,
-                                                               IdxT,
-                                                               DataT,
-                                                               OutT,
-                                                               FinOpT>;
-
-  kernel<<<grid, block, smem_size, stream>>>(distance_op, params);
-  RAFT_CUDA_TRY(cudaGetLastError());
+  bool found = false;
+  auto visit = [&](auto distance_op) {
+    using OpT = decltype(distance_op);
+    if (found || op != raft::distance::detail::tuning_name<OpT>) { return; }
+    found = true;
+
+    auto g = [&](auto vec_len_c) {
+      constexpr int vec_len_op = OpT::expensive_inner_loop ? 1 : decltype(vec_len_c)::value;
+      auto wrapper = raft::distance::detail::make_pairwise_matrix_sm60_wrapper<Policy<vec_len_op>,
+                                                                               row_major>(
+        distance_op, params, sm_compat_range);
+      f(distance_op, wrapper);
+    };
+    switch (vec_len) {
+      case 4: g(std::integral_constant<int, 4>()); break;
+      case 2: g(std::integral_constant<int, 2>()); break;
+      default: g(std::integral_constant<int, 1>()); break;
+    }
+  };
+  std::apply([&](auto... distance_op) { (visit(distance_op), ...); }, make_distance_ops(params.k));
+  if (!found) { RAFT_FAIL("Unknown distance op: %s", op.c_str()); }
 }
 
-void get_block_size(int& m, int& n, int& k)
+// Parameters of an empty problem, to query the kernel attributes
+pairwise_matrix_params empty_params()
 {
-  m = Policy::Mblk;
-  n = Policy::Nblk;
-  k = Policy::Kblk;
+  return pairwise_matrix_params{
+    1, 1, 1, 1, 1, 1, nullptr, nullptr, nullptr, nullptr, nullptr, FinOpT{}, row_major};
 }
 
-void* get_kernel_ptr()
+std::vector<std::string> distance_ops()
 {
-  auto kernel = raft::distance::detail::pairwise_matrix_kernel<Policy,
-                                                               row_major,
-                                                               decltype(sm_compat_range),
-                                                               OpT,
-                                                               IdxT,
-                                                               DataT,
-                                                               OutT,
-                                                               FinOpT>;
-  return reinterpret_cast<void*>(kernel);
+  std::vector<std::string> names;
+  std::apply(
+    [&](auto... distance_op) {
+      (names.push_back(raft::distance::detail::tuning_name<decltype(distance_op)>), ...);
+    },
+    make_distance_ops(1));
+  return names;
 }
 
-int get_max_occupancy()
+bool is_tunable(const std::string& op)
 {
-  void* kernel_ptr = get_kernel_ptr();
-  int max_occupancy;
-  int smem_size = OpT::shared_mem_size<Policy>();
+  bool tunable = false;
+  std::apply(
+    [&](auto... distance_op) {
+      ((tunable |= op == raft::distance::detail::tuning_name<decltype(distance_op)> &&
+                   !decltype(distance_op)::expensive_inner_loop),
+       ...);
+    },
+    make_distance_ops(1));
+  return tunable;
+}
 
-  RAFT_CUDA_TRY(cudaOccupancyMaxActiveBlocksPerMultiprocessor(
-    &max_occupancy, kernel_ptr, Policy::Nthreads, smem_size));
+void launch_kernel(
+  const std::string& op, int vec_len, pairwise_matrix_params params, dim3 grid, cudaStream_t stream)
+{
+  with_kernel(op, vec_len, params, [&](auto distance_op, auto wrapper) {
+    if (grid.x != 0) { wrapper.grid = grid; }
+    wrapper.launch(distance_op, params, stream);
+  });
+}
 
+void get_block_size(int vec_len, int& m, int& n, int& k)
+{
+  auto f = [&](auto policy) {
+    m = decltype(policy)::Mblk;
+    n = decltype(policy)::Nblk;
+    k = decltype(policy)::Kblk;
+  };
+  switch (vec_len) {
+    case 4: f(Policy<4>{}); break;
+    case 2: f(Policy<2>{}); break;
+    default: f(Policy<1>{}); break;
+  }
+}
+
+int get_max_occupancy(const std::string& op, int vec_len)
+{
+  int max_occupancy;
+  with_kernel(op, vec_len, empty_params(), [&](auto, auto wrapper) {
+    auto kernel_ptr = reinterpret_cast<void*>(wrapper.kernel_ptr);
+    RAFT_CUDA_TRY(cudaOccupancyMaxActiveBlocksPerMultiprocessor(
+      &max_occupancy, kernel_ptr, wrapper.block.x, wrapper.smem_size));
+  });
   return max_occupancy;
 }
 
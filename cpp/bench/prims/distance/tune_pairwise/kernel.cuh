@@ -19,9 +19,12 @@
 #include <raft/distance/detail/distance_ops/all_ops.cuh>    // lp_unexp_distance_op
 #include <raft/distance/detail/pairwise_matrix/params.cuh>  // pairwise_matrix_params
 
+#include <string>  // std::string
+#include <vector>  // std::vector
+
 namespace raft::bench::distance::tune {
 
-// Launch one specific kernel with the following template parameters
+// Launch the kernels with the following template parameters
 constexpr bool row_major = true;
 using DataT              = float;
 using AccT               = float;
@@ -33,12 +36,22 @@ using FinOpT = raft::identity_op;
 using pairwise_matrix_params =
   raft::distance::detail::pairwise_matrix_params<IdxT, DataT, OutT, FinOpT>;
 
-// Launches kernel
-void launch_kernel(pairwise_matrix_params, dim3, cudaStream_t);
+// The distance ops compiled into the benchmark, by their names in the tuned
+// policy table (see raft/distance/detail/pairwise_matrix/tuned_policy.cuh).
+std::vector<std::string> distance_ops();
+
+// Whether the kernel of the op is compiled with vec_len > 1, i.e. whether the
+// dispatch can choose its vec_len (see dispatch_sm60.cuh).
+bool is_tunable(const std::string& op);
+
+// Launches the kernel of the op with Policy4x4<DataT, vec_len>. If grid.x is
+// zero, the grid is chosen the same way as in the library dispatch.
+void launch_kernel(
+  const std::string& op, int vec_len, pairwise_matrix_params, dim3 grid, cudaStream_t);
 
 // Describes the block size that is decided by the policy
-void get_block_size(int& m, int& n, int& k);
+void get_block_size(int vec_len, int& m, int& n, int& k);
 
-int get_max_occupancy();
+int get_max_occupancy(const std::string& op, int vec_len);
 
 }  // namespace raft::bench::distance::tune
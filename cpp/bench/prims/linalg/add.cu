@@ -28,7 +28,11 @@ struct add_inputs {
 
 template <typename T>
 struct add : public fixture {
-  add(const add_inputs& p) : params(p), ptr0(p.len, stream), ptr1(p.len, stream) {}
+  add(const add_inputs& p) : params(p), ptr0(p.len, stream), ptr1(p.len, stream)
+  {
+    // read two inputs, write one output
+    set_work_per_iteration(3.0 * p.len * sizeof(T), p.len);
+  }
 
   void run_benchmark(::benchmark::State& state) override
   {
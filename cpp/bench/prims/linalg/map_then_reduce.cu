@@ -33,7 +33,10 @@ struct Identity {
 
 template <typename T>
 struct map_then_reduce : public fixture {
-  map_then_reduce(const map_then_reduce_inputs& p) : params(p), in(p.len, stream), out(1, stream) {}
+  map_then_reduce(const map_then_reduce_inputs& p) : params(p), in(p.len, stream), out(1, stream)
+  {
+    set_work_per_iteration((double(p.len) + 1) * sizeof(T), p.len);
+  }
 
   void run_benchmark(::benchmark::State& state) override
   {
@@ -32,6 +32,9 @@ struct reduce : public fixture {
   reduce(bool along_rows, const input_size& p)
     : input_size(p), along_rows(along_rows), in(p.rows * p.cols, stream), out(p.rows, stream)
   {
+    double n_in  = double(p.rows) * p.cols;
+    double n_out = along_rows ? p.rows : p.cols;
+    set_work_per_iteration((n_in + n_out) * sizeof(T), n_in);
   }
 
   void run_benchmark(::benchmark::State& state) override
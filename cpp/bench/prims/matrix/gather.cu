@@ -55,6 +55,11 @@ struct Gather : public fixture {
       matrix_h(this->handle)
   {
     rmm::mr::set_current_device_resource(&pool_mr);
+    if (!p.host) {
+      // read the map (and stencil) and the gathered rows, write the output rows
+      double per_row = sizeof(MapT) + 2.0 * p.cols * sizeof(T) + (Conditional ? sizeof(T) : 0);
+      set_work_per_iteration(per_row * p.map_length);
+    }
   }
 
   ~Gather() { rmm::mr::set_current_device_resource(old_mr); }
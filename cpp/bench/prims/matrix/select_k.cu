@@ -61,6 +61,10 @@ struct selection : public fixture {
       out_ids_(p.batch_size * p.k, stream)
   {
     raft::sparse::iota_fill(in_ids_.data(), IdxT(p.batch_size), IdxT(p.len), stream);
+    // read the input keys (and ids), write the selected keys and ids
+    double in_bytes  = sizeof(KeyT) + (p.use_index_input ? sizeof(IdxT) : 0);
+    double out_bytes = sizeof(KeyT) + sizeof(IdxT);
+    set_work_per_iteration(double(p.batch_size) * (p.len * in_bytes + p.k * out_bytes));
     raft::random::RngState state{42};
 
     KeyT min_value = -1.0;
@@ -103,6 +107,7 @@ struct selection : public fixture {
       label_stream << params_.batch_size << "#" << params_.len << "#" << params_.k;
       if (params_.use_same_leading_bits) { label_stream << "#same-leading-bits"; }
       if (params_.frac_infinities > 0) { label_stream << "#infs-" << params_.frac_infinities; }
+      if (params_.sorted) { label_stream << "#sorted"; }
       state.SetLabel(label_stream.str());
       common::nvtx::range case_scope("%s - %s", state.name().c_str(), label_stream.str().c_str());
       int iter = 0;
@@ -124,7 +129,7 @@ struct selection : public fixture {
                                      raft::make_device_matrix_view<IdxT, int64_t>(
                                        out_ids_.data(), params_.batch_size, params_.k),
                                      params_.select_min,
-                                     false,
+                                     params_.sorted,
                                      Algo);
       });
     } catch (raft::exception& e) {
@@ -217,6 +222,11 @@ const std::vector<select::params> kInputs{
   {1000, 10000, 128, true, false, false, true, 1.0},
   {1000, 10000, 256, true, false, false, true, 1.0},
   {1000, 10000, 256, true, false, false, true, 0.999},
+
+  // large k with the sorted output (e.g. re-ranking)
+  {10000, 32768, 4096, true, false, false, true, 0.0, true},
+  {10000, 32768, 8192, true, false, false, true, 0.0, true},
+  {1000, 65536, 16384, true, false, false, true, 0.0, true},
 };
 
 #define SELECTION_REGISTER(KeyT, IdxT, A)                             \
@@ -295,7 +305,7 @@ void add_select_k_dataset_benchmarks()
 
   size_t grid_increment = 1;
   std::vector<int> k_vals;
-  for (size_t k = 0; k < 13; k += grid_increment) {
+  for (size_t k = 0; k < 15; k += grid_increment) {
     k_vals.push_back(1 << k);
   }
   // Add in values just past the limit for warp/faiss select
@@ -318,7 +328,7 @@ void add_select_k_dataset_benchmarks()
   std::default_random_engine rng(42);
   std::uniform_real_distribution<> row_dist(0, 13);
   std::uniform_real_distribution<> col_dist(10, 28);
-  std::uniform_real_distribution<> k_dist(0, 13);
+  std::uniform_real_distribution<> k_dist(0, 15);
   for (size_t i = 0; i < 1024; ++i) {
     auto row = static_cast<size_t>(pow(2, row_dist(rng)));
     auto col = static_cast<size_t>(pow(2, col_dist(rng)));
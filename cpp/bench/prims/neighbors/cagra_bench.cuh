@@ -18,7 +18,9 @@
 
 #include <common/benchmark.hpp>
 
+#include <raft/core/host_mdarray.hpp>
 #include <raft/neighbors/cagra.cuh>
+#include <raft/neighbors/nn_descent_types.hpp>
 #include <raft/neighbors/sample_filter.cuh>
 #include <raft/random/rng.cuh>
 #include <raft/util/itertools.hpp>
@@ -26,6 +28,8 @@
 #include <thrust/sequence.h>
 
 #include <optional>
+#include <ostream>
+#include <sstream>
 
 namespace raft::bench::neighbors {
 
@@ -199,10 +203,165 @@ inline const std::vector<params> generate_inputs()
 
 const std::vector<params> kCagraInputs = generate_inputs();
 
+/** The phases of the CAGRA index build, each timed separately. */
+enum class build_stage {
+  /** `build_knn_graph` using IVF-PQ */
+  kKnnGraphIvfPq,
+  /** `build_knn_graph` using NN-descent */
+  kKnnGraphNnDescent,
+  /** `sort_knn_graph` of a random graph */
+  kSortKnnGraph,
+  /** `optimize` of a sorted random graph */
+  kOptimize
+};
+
+inline auto operator<<(std::ostream& os, const build_stage& s) -> std::ostream&
+{
+  switch (s) {
+    case build_stage::kKnnGraphIvfPq: return os << "knn_graph_ivf_pq";
+    case build_stage::kKnnGraphNnDescent: return os << "knn_graph_nn_descent";
+    case build_stage::kSortKnnGraph: return os << "sort_knn_graph";
+    case build_stage::kOptimize: return os << "optimize";
+  }
+  return os;
+}
+
+struct build_params {
+  /** Size of the dataset. */
+  size_t n_samples;
+  /** Number of dimensions in the dataset. */
+  int n_dims;
+  /** Degree of the kNN graph (the input of `optimize`). */
+  int intermediate_degree;
+  /** Degree of the optimized graph. */
+  int graph_degree;
+  build_stage stage;
+};
+
+inline auto operator<<(std::ostream& os, const build_params& p) -> std::ostream&
+{
+  os << p.stage << "#" << p.n_samples << "#" << p.n_dims << "#" << p.intermediate_degree << "#"
+     << p.graph_degree;
+  return os;
+}
+
+/**
+ * The build phases of a CAGRA index, which `cagra::build` runs one after another. The sort and the
+ * optimize phases start from a random graph, so their timings do not depend on the kNN graph
+ * algorithm. `sort_knn_graph` works in-place: the following iterations re-sort a sorted graph,
+ * which takes the same work since the distances are recomputed and the sort is not adaptive.
+ */
+template <typename T, typename IdxT>
+struct CagraBuildBench : public fixture {
+  explicit CagraBuildBench(const build_params& ps)
+    : fixture(true),
+      params_(ps),
+      dataset_(make_device_matrix<T, int64_t>(handle, ps.n_samples, ps.n_dims)),
+      knn_graph_(make_host_matrix<IdxT, int64_t>(ps.n_samples, ps.intermediate_degree)),
+      optimized_graph_(make_host_matrix<IdxT, int64_t>(ps.n_samples, ps.graph_degree))
+  {
+    raft::random::RngState state{42};
+    if constexpr (std::is_integral_v<T>) {
+      raft::random::uniformInt(handle,
+                               state,
+                               dataset_.data_handle(),
+                               dataset_.size(),
+                               std::numeric_limits<T>::min(),
+                               std::numeric_limits<T>::max());
+    } else {
+      raft::random::uniform(handle, state, dataset_.data_handle(), dataset_.size(), T(-1), T(1));
+    }
+
+    if (ps.stage == build_stage::kSortKnnGraph || ps.stage == build_stage::kOptimize) {
+      auto knn_graph_d =
+        make_device_matrix<IdxT, int64_t>(handle, ps.n_samples, ps.intermediate_degree);
+      raft::random::uniformInt<IdxT>(
+        handle, state, knn_graph_d.data_handle(), knn_graph_d.size(), 0, ps.n_samples - 1);
+      raft::copy(knn_graph_.data_handle(), knn_graph_d.data_handle(), knn_graph_.size(), stream);
+      resource::sync_stream(handle);
+      if (ps.stage == build_stage::kOptimize) {
+        raft::neighbors::cagra::sort_knn_graph(
+          handle, make_const_mdspan(dataset_.view()), knn_graph_.view());
+      }
+    }
+    resource::sync_stream(handle);
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params_;
+    state.SetLabel(label_stream.str());
+
+    auto dataset_v = make_const_mdspan(dataset_.view());
+    switch (params_.stage) {
+      case build_stage::kKnnGraphIvfPq:
+        loop_on_state(state, [&]() {
+          raft::neighbors::cagra::build_knn_graph(this->handle, dataset_v, knn_graph_.view());
+        });
+        break;
+      case build_stage::kKnnGraphNnDescent: {
+        raft::neighbors::experimental::nn_descent::index_params nn_descent_params;
+        nn_descent_params.graph_degree              = params_.intermediate_degree;
+        nn_descent_params.intermediate_graph_degree = 1.5 * params_.intermediate_degree;
+        loop_on_state(state, [&]() {
+          raft::neighbors::cagra::build_knn_graph(
+            this->handle, dataset_v, knn_graph_.view(), nn_descent_params);
+        });
+      } break;
+      case build_stage::kSortKnnGraph:
+        loop_on_state(state, [&]() {
+          raft::neighbors::cagra::sort_knn_graph(this->handle, dataset_v, knn_graph_.view());
+        });
+        break;
+      case build_stage::kOptimize:
+        loop_on_state(state, [&]() {
+          raft::neighbors::cagra::optimize(
+            this->handle, knn_graph_.view(), optimized_graph_.view());
+        });
+        break;
+    }
+
+    state.counters["n_rows"]              = params_.n_samples;
+    state.counters["n_cols"]              = params_.n_dims;
+    state.counters["intermediate_degree"] = params_.intermediate_degree;
+    state.counters["graph_degree"]        = params_.graph_degree;
+    state.counters["rows_per_s"] =
+      ::benchmark::Counter(params_.n_samples, ::benchmark::Counter::kIsIterationInvariantRate);
+  }
+
+ private:
+  const build_params params_;
+  raft::device_matrix<T, int64_t, row_major> dataset_;
+  raft::host_matrix<IdxT, int64_t, row_major> knn_graph_;
+  raft::host_matrix<IdxT, int64_t, row_major> optimized_graph_;
+};
+
+inline const std::vector<build_params> generate_build_inputs()
+{
+  return raft::util::itertools::product<build_params>(
+    {100000ull, 1000000ull},  // n_samples
+    {96, 768},                // dataset dim
+    {64, 128},                // intermediate (knn graph) degree
+    {32},                     // graph degree
+    {build_stage::kKnnGraphIvfPq,
+     build_stage::kKnnGraphNnDescent,
+     build_stage::kSortKnnGraph,
+     build_stage::kOptimize});
+}
+
+const std::vector<build_params> kCagraBuildInputs = generate_build_inputs();
+
 #define CAGRA_REGISTER(ValT, IdxT, inputs)                \
   namespace BENCHMARK_PRIVATE_NAME(knn) {                 \
   using AnnCagra = CagraBench<ValT, IdxT>;                \
   RAFT_BENCH_REGISTER(AnnCagra, #ValT "/" #IdxT, inputs); \
   }
 
+#define CAGRA_BUILD_REGISTER(ValT, IdxT, inputs)               \
+  namespace BENCHMARK_PRIVATE_NAME(knn) {                      \
+  using AnnCagraBuild = CagraBuildBench<ValT, IdxT>;           \
+  RAFT_BENCH_REGISTER(AnnCagraBuild, #ValT "/" #IdxT, inputs); \
+  }
+
 }  // namespace raft::bench::neighbors
@@ -148,8 +148,9 @@ struct ivf_flat_knn {
 
   ivf_flat_knn(const raft::device_resources& handle, const params& ps, const ValT* data) : ps(ps)
   {
-    index_params.n_lists = 4096;
-    index_params.metric  = raft::distance::DistanceType::L2Expanded;
+    index_params.n_lists   = 4096;
+    index_params.metric    = raft::distance::DistanceType::L2Expanded;
+    search_params.n_probes = 20;
     index.emplace(raft::neighbors::ivf_flat::build(
       handle, index_params, data, IdxT(ps.n_samples), uint32_t(ps.n_dims)));
   }
@@ -159,7 +160,6 @@ struct ivf_flat_knn {
               dist_t* out_dists,
               IdxT* out_idxs)
   {
-    search_params.n_probes = 20;
     raft::neighbors::ivf_flat::search(handle,
                                       search_params,
                                       *index,
@@ -183,8 +183,9 @@ struct ivf_pq_knn {
 
   ivf_pq_knn(const raft::device_resources& handle, const params& ps, const ValT* data) : ps(ps)
   {
-    index_params.n_lists = 4096;
-    index_params.metric  = raft::distance::DistanceType::L2Expanded;
+    index_params.n_lists   = 4096;
+    index_params.metric    = raft::distance::DistanceType::L2Expanded;
+    search_params.n_probes = 20;
     auto data_view = raft::make_device_matrix_view<const ValT, IdxT>(data, ps.n_samples, ps.n_dims);
     index.emplace(raft::neighbors::ivf_pq::build(handle, index_params, data_view));
   }
@@ -194,7 +195,6 @@ struct ivf_pq_knn {
               dist_t* out_dists,
               IdxT* out_idxs)
   {
-    search_params.n_probes = 20;
     auto queries_view =
       raft::make_device_matrix_view<const ValT, uint32_t>(search_items, ps.n_queries, ps.n_dims);
     auto idxs_view = raft::make_device_matrix_view<IdxT, uint32_t>(out_idxs, ps.n_queries, ps.k);
@@ -249,8 +249,9 @@ struct ivf_flat_filter_knn {
   ivf_flat_filter_knn(const raft::device_resources& handle, const params& ps, const ValT* data)
     : ps(ps), removed_indices_bitset_(handle, ps.n_samples)
   {
-    index_params.n_lists = 4096;
-    index_params.metric  = raft::distance::DistanceType::L2Expanded;
+    index_params.n_lists   = 4096;
+    index_params.metric    = raft::distance::DistanceType::L2Expanded;
+    search_params.n_probes = 20;
     index.emplace(raft::neighbors::ivf_flat::build(
       handle, index_params, data, IdxT(ps.n_samples), uint32_t(ps.n_dims)));
     auto removed_indices =
@@ -267,7 +268,6 @@ struct ivf_flat_filter_knn {
               dist_t* out_dists,
               IdxT* out_idxs)
   {
-    search_params.n_probes = 20;
     auto queries_view =
       raft::make_device_matrix_view<const ValT, IdxT>(search_items, ps.n_queries, ps.n_dims);
     auto neighbors_view = raft::make_device_matrix_view<IdxT, IdxT>(out_idxs, ps.n_queries, ps.k);
@@ -297,8 +297,9 @@ struct ivf_pq_filter_knn {
   ivf_pq_filter_knn(const raft::device_resources& handle, const params& ps, const ValT* data)
     : ps(ps), removed_indices_bitset_(handle, ps.n_samples)
   {
-    index_params.n_lists = 4096;
-    index_params.metric  = raft::distance::DistanceType::L2Expanded;
+    index_params.n_lists   = 4096;
+    index_params.metric    = raft::distance::DistanceType::L2Expanded;
+    search_params.n_probes = 20;
     auto data_view = raft::make_device_matrix_view<const ValT, IdxT>(data, ps.n_samples, ps.n_dims);
     index.emplace(raft::neighbors::ivf_pq::build(handle, index_params, data_view));
     auto removed_indices =
@@ -315,7 +316,6 @@ struct ivf_pq_filter_knn {
               dist_t* out_dists,
               IdxT* out_idxs)
   {
-    search_params.n_probes = 20;
     auto queries_view =
       raft::make_device_matrix_view<const ValT, uint32_t>(search_items, ps.n_queries, ps.n_dims);
     auto neighbors_view =
@@ -490,6 +490,70 @@ struct knn : public fixture {
   rmm::device_uvector<IdxT> out_idxs_;
 };
 
+/**
+ * Small searches issued at the same time from `n_concurrent` threads, each on its own stream and
+ * with its own queries and outputs, against one shared index. A search that fills the device on
+ * its own, or that serializes on a shared resource, does not scale with `n_concurrent`.
+ */
+template <typename ValT, typename IdxT, typename ImplT>
+struct knn_concurrent : public fixture {
+  knn_concurrent(const params& p, const int& n_concurrent)
+    : fixture(true), params_(p), n_concurrent_(n_concurrent), data_(p.n_samples * p.n_dims, stream)
+  {
+    raft::random::RngState state{42};
+    gen_data(state, data_.data(), data_.size());
+    for (int i = 0; i < n_concurrent; i++) {
+      search_items_.emplace_back(p.n_queries * p.n_dims, stream);
+      out_dists_.emplace_back(p.n_queries * p.k, stream);
+      out_idxs_.emplace_back(p.n_queries * p.k, stream);
+      gen_data(state, search_items_.back().data(), search_items_.back().size());
+    }
+    index_.emplace(handle, params_, data_.data());
+    stream.synchronize();
+  }
+
+  void gen_data(raft::random::RngState& state, ValT* ptr, size_t n)  // NOLINT
+  {
+    using T               = ValT;
+    constexpr T kRangeMax = std::is_integral_v<T> ? std::numeric_limits<T>::max() : T(1);
+    constexpr T kRangeMin = std::is_integral_v<T> ? std::numeric_limits<T>::min() : T(-1);
+    if constexpr (std::is_integral_v<T>) {
+      raft::random::uniformInt(handle, state, ptr, n, kRangeMin, kRangeMax);
+    } else {
+      raft::random::uniform(handle, state, ptr, n, kRangeMin, kRangeMax);
+    }
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params_ << "#" << n_concurrent_;
+    state.SetLabel(label_stream.str());
+    try {
+      auto search = [this](const raft::device_resources& res, int i) {
+        index_->search(res, search_items_[i].data(), out_dists_[i].data(), out_idxs_[i].data());
+      };
+      loop_on_state_concurrent(state, n_concurrent_, search);
+      state.counters["queries/s"] = ::benchmark::Counter(
+        double(params_.n_queries) * n_concurrent_, ::benchmark::Counter::kIsIterationInvariantRate);
+    } catch (raft::exception& e) {
+      state.SkipWithError(e.what());
+    } catch (std::bad_alloc& e) {
+      state.SkipWithError(e.what());
+    }
+  }
+
+ private:
+  const params params_;
+  const int n_concurrent_;
+  // the brute-force "index" is a pointer to the data
+  rmm::device_uvector<ValT> data_;
+  std::optional<ImplT> index_;
+  std::vector<rmm::device_uvector<ValT>> search_items_;
+  std::vector<rmm::device_uvector<typename ImplT::dist_t>> out_dists_;
+  std::vector<rmm::device_uvector<IdxT>> out_idxs_;
+};
+
 inline const std::vector<params> kInputs{
   {2000000, 128, 1000, 32, 0}, {10000000, 128, 1000, 32, 0}, {10000, 8192, 1000, 32, 0}};
 
@@ -500,6 +564,15 @@ const std::vector<params> kInputsFilter =
                                          {size_t(255)},                             // k
                                          {0.0, 0.02, 0.04, 0.08, 0.16, 0.32, 0.64}  // removed_ratio
   );
+// Small batches, as in the online serving
+const std::vector<params> kInputsSmallBatch =
+  raft::util::itertools::product<params>({size_t(2000000)},                     // n_samples
+                                         {size_t(128)},                         // n_dim
+                                         {size_t(1), size_t(10), size_t(100)},  // n_queries
+                                         {size_t(32)},                          // k
+                                         {0.0}                                  // removed_ratio
+  );
+inline const std::vector<int> kConcurrency{1, 2, 4, 8, 16};
 inline const std::vector<TransferStrategy> kAllStrategies{
   TransferStrategy::NO_COPY, TransferStrategy::MAP_PINNED, TransferStrategy::MANAGED};
 inline const std::vector<TransferStrategy> kNoCopyOnly{TransferStrategy::NO_COPY};
@@ -513,4 +586,10 @@ inline const std::vector<Scope> kAllScopes{Scope::BUILD_SEARCH, Scope::SEARCH, S
   RAFT_BENCH_REGISTER(KNN, #ValT "/" #IdxT "/" #ImplT, inputs, strats, scope); \
   }
 
+#define KNN_CONCURRENT_REGISTER(ValT, IdxT, ImplT, inputs, concurrency)   \
+  namespace BENCHMARK_PRIVATE_NAME(knn) {                                 \
+  using KNN = knn_concurrent<ValT, IdxT, ImplT<ValT, IdxT>>;              \
+  RAFT_BENCH_REGISTER(KNN, #ValT "/" #IdxT "/" #ImplT, inputs, concurrency); \
+  }
+
 }  // namespace raft::bench::spatial
@@ -19,5 +19,6 @@
 namespace raft::bench::spatial {
 
 KNN_REGISTER(float, int64_t, brute_force_knn, kInputs, kAllStrategies, kScopeFull);
+KNN_CONCURRENT_REGISTER(float, int64_t, brute_force_knn, kInputsSmallBatch, kConcurrency);
 
 }  // namespace raft::bench::spatial
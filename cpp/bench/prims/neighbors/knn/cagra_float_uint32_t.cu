@@ -19,5 +19,6 @@
 namespace raft::bench::neighbors {
 
 CAGRA_REGISTER(float, uint32_t, kCagraInputs);
+CAGRA_BUILD_REGISTER(float, uint32_t, kCagraBuildInputs);
 
 }  // namespace raft::bench::neighbors
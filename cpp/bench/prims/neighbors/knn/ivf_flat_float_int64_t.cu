@@ -19,5 +19,6 @@
 namespace raft::bench::spatial {
 
 KNN_REGISTER(float, int64_t, ivf_flat_knn, kInputs, kNoCopyOnly, kAllScopes);
+KNN_CONCURRENT_REGISTER(float, int64_t, ivf_flat_knn, kInputsSmallBatch, kConcurrency);
 
 }  // namespace raft::bench::spatial
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "power_law.cuh"
+
+#include <common/benchmark.hpp>
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/sparse/distance/distance.cuh>
+#include <raft/util/itertools.hpp>
+
+#include <sstream>
+#include <vector>
+
+namespace raft::bench::sparse {
+
+struct distance_inputs {
+  // the rows of x (the rows of y and the columns are given by the matrix shape)
+  int x_row_scale;
+  power_law_params y;
+  raft::distance::DistanceType metric;
+};
+
+inline auto operator<<(std::ostream& os, const distance_inputs& p) -> std::ostream&
+{
+  os << "2^" << p.x_row_scale << "#" << p.y << "#metric=" << int(p.metric);
+  return os;
+}
+
+template <typename value_t>
+struct pairwise_distance : public fixture {
+  explicit pairwise_distance(const distance_inputs& p)
+    : fixture(true),
+      params(p),
+      x(make_power_law_csr<value_t>(
+        handle,
+        power_law_params{p.x_row_scale, p.y.col_scale, p.y.entries_per_row, p.y.a, p.y.b, p.y.c},
+        42)),
+      y(make_power_law_csr<value_t>(handle, p.y, 137)),
+      out(raft::make_device_matrix<value_t, int>(handle, x.n_rows, y.n_rows))
+  {
+    set_work_per_iteration(x.size_bytes() + y.size_bytes() + double(out.size()) * sizeof(value_t));
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params << "#nnz=" << x.nnz << "," << y.nnz;
+    state.SetLabel(label_stream.str());
+    loop_on_state(state, [this]() {
+      raft::sparse::distance::pairwise_distance(
+        handle, x.view(), y.view(), out.view(), params.metric);
+    });
+  }
+
+ private:
+  distance_inputs params;
+  csr_input<value_t> x, y;
+  raft::device_matrix<value_t, int> out;
+};
+
+const std::vector<distance_inputs> distance_input_vecs =
+  raft::util::itertools::product<distance_inputs>(
+    {10, 12},
+    {power_law_params{14, 16, 16}, power_law_params{14, 20, 64}},
+    {raft::distance::DistanceType::L2Expanded,
+     raft::distance::DistanceType::InnerProduct,
+     raft::distance::DistanceType::CosineExpanded,
+     raft::distance::DistanceType::L1,
+     raft::distance::DistanceType::JaccardExpanded});
+
+RAFT_BENCH_REGISTER(pairwise_distance<float>, "", distance_input_vecs);
+
+}  // namespace raft::bench::sparse
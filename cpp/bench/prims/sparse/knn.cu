@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "power_law.cuh"
+
+#include <common/benchmark.hpp>
+
+#include <raft/distance/distance_types.hpp>
+#include <raft/sparse/neighbors/brute_force.cuh>
+#include <raft/util/itertools.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <sstream>
+#include <vector>
+
+namespace raft::bench::sparse {
+
+struct knn_inputs {
+  int query_row_scale;
+  power_law_params index;
+  int k;
+  raft::distance::DistanceType metric;
+};
+
+inline auto operator<<(std::ostream& os, const knn_inputs& p) -> std::ostream&
+{
+  os << "2^" << p.query_row_scale << "#" << p.index << "#k=" << p.k
+     << "#metric=" << int(p.metric);
+  return os;
+}
+
+template <typename value_t>
+struct brute_force_knn : public fixture {
+  explicit brute_force_knn(const knn_inputs& p)
+    : fixture(true),
+      params(p),
+      queries(make_power_law_csr<value_t>(handle,
+                                          power_law_params{p.query_row_scale,
+                                                           p.index.col_scale,
+                                                           p.index.entries_per_row,
+                                                           p.index.a,
+                                                           p.index.b,
+                                                           p.index.c},
+                                          42)),
+      index(make_power_law_csr<value_t>(handle, p.index, 137)),
+      out_ids(size_t(queries.n_rows) * p.k, stream),
+      out_dists(size_t(queries.n_rows) * p.k, stream)
+  {
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params << "#nnz=" << queries.nnz << "," << index.nnz;
+    state.SetLabel(label_stream.str());
+    loop_on_state(state, [this]() {
+      raft::sparse::neighbors::brute_force::knn<int, value_t>(index.indptr.data(),
+                                                              index.indices.data(),
+                                                              index.values.data(),
+                                                              index.nnz,
+                                                              index.n_rows,
+                                                              index.n_cols,
+                                                              queries.indptr.data(),
+                                                              queries.indices.data(),
+                                                              queries.values.data(),
+                                                              queries.nnz,
+                                                              queries.n_rows,
+                                                              queries.n_cols,
+                                                              out_ids.data(),
+                                                              out_dists.data(),
+                                                              params.k,
+                                                              handle,
+                                                              2 << 14,
+                                                              2 << 14,
+                                                              params.metric);
+    });
+  }
+
+ private:
+  knn_inputs params;
+  csr_input<value_t> queries, index;
+  rmm::device_uvector<int> out_ids;
+  rmm::device_uvector<value_t> out_dists;
+};
+
+const std::vector<knn_inputs> knn_input_vecs = raft::util::itertools::product<knn_inputs>(
+  {10, 14},
+  {power_law_params{16, 16, 16}, power_law_params{18, 20, 32}},
+  {10, 64},
+  {raft::distance::DistanceType::L2Expanded, raft::distance::DistanceType::CosineExpanded});
+
+RAFT_BENCH_REGISTER(brute_force_knn<float>, "", knn_input_vecs);
+
+}  // namespace raft::bench::sparse
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/rmat_rectangular_generator.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/sparse/convert/csr.cuh>
+#include <raft/sparse/coo.hpp>
+#include <raft/sparse/op/reduce.cuh>
+#include <raft/sparse/op/sort.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace raft::bench::sparse {
+
+/**
+ * The shape of a power-law (R-MAT) sparse matrix of 2^row_scale x 2^col_scale. The default
+ * probabilities of the quadrants are those of the Graph500 generator.
+ */
+struct power_law_params {
+  int row_scale;
+  int col_scale;
+  // the mean number of the generated entries per row (before the duplicates are merged)
+  int entries_per_row;
+  float a = 0.57f;
+  float b = 0.19f;
+  float c = 0.19f;
+};
+
+inline auto operator<<(std::ostream& os, const power_law_params& p) -> std::ostream&
+{
+  os << "2^" << p.row_scale << "x2^" << p.col_scale << "#" << p.entries_per_row;
+  return os;
+}
+
+/** A CSR matrix in the device memory. */
+template <typename value_t, typename index_t = int>
+struct csr_input {
+  index_t n_rows;
+  index_t n_cols;
+  index_t nnz;
+  rmm::device_uvector<index_t> indptr;
+  rmm::device_uvector<index_t> indices;
+  rmm::device_uvector<value_t> values;
+
+  auto view() const -> raft::device_csr_matrix_view<const value_t, index_t, index_t, index_t>
+  {
+    auto structure = raft::make_device_compressed_structure_view<index_t, index_t, index_t>(
+      const_cast<index_t*>(indptr.data()),
+      const_cast<index_t*>(indices.data()),
+      n_rows,
+      n_cols,
+      nnz);
+    return raft::make_device_csr_matrix_view<const value_t>(values.data(), structure);
+  }
+
+  /** The bytes of the arrays of the matrix. */
+  [[nodiscard]] auto size_bytes() const -> double
+  {
+    return double(n_rows + 1 + nnz) * sizeof(index_t) + double(nnz) * sizeof(value_t);
+  }
+};
+
+/**
+ * Generate a power-law CSR matrix: the edges of an R-MAT graph (`rmat_rectangular_gen`) become
+ * the entries, with the values drawn uniformly from (0, 1]. The duplicates are merged, so the
+ * matrix has somewhat fewer than `2^row_scale * entries_per_row` entries; the row lengths and the
+ * column frequencies both follow a power law.
+ */
+template <typename value_t, typename index_t = int>
+auto make_power_law_csr(raft::resources const& res, const power_law_params& p, uint64_t seed)
+  -> csr_input<value_t, index_t>
+{
+  auto stream  = resource::get_cuda_stream(res);
+  auto n_rows  = index_t(1) << p.row_scale;
+  auto n_cols  = index_t(1) << p.col_scale;
+  auto n_edges = n_rows * index_t(p.entries_per_row);
+
+  // The same quadrant probabilities on every level of the recursion
+  auto max_scale = std::max(p.row_scale, p.col_scale);
+  std::vector<float> theta_h;
+  for (int i = 0; i < max_scale; i++) {
+    theta_h.insert(theta_h.end(), {p.a, p.b, p.c, 1.0f - p.a - p.b - p.c});
+  }
+  auto theta = raft::make_device_vector<float, index_t>(res, theta_h.size());
+  raft::update_device(theta.data_handle(), theta_h.data(), theta_h.size(), stream);
+
+  rmm::device_uvector<index_t> rows(n_edges, stream);
+  rmm::device_uvector<index_t> cols(n_edges, stream);
+  rmm::device_uvector<value_t> vals(n_edges, stream);
+  raft::random::RngState rng{seed};
+  raft::random::rmat_rectangular_gen(res,
+                                     rng,
+                                     raft::make_const_mdspan(theta.view()),
+                                     raft::make_device_vector_view(rows.data(), n_edges),
+                                     raft::make_device_vector_view(cols.data(), n_edges),
+                                     index_t(p.row_scale),
+                                     index_t(p.col_scale));
+  raft::random::uniform(res, rng, vals.data(), n_edges, value_t(0), value_t(1));
+  raft::sparse::op::coo_sort(
+    n_rows, n_cols, n_edges, rows.data(), cols.data(), vals.data(), stream);
+
+  raft::sparse::COO<value_t, index_t> coo(stream);
+  raft::sparse::op::max_duplicates(
+    res, coo, rows.data(), cols.data(), vals.data(), n_edges, n_rows, n_cols);
+
+  csr_input<value_t, index_t> out{n_rows,
+                                  n_cols,
+                                  coo.nnz,
+                                  rmm::device_uvector<index_t>(n_rows + 1, stream),
+                                  rmm::device_uvector<index_t>(coo.nnz, stream),
+                                  rmm::device_uvector<value_t>(coo.nnz, stream)};
+  raft::sparse::convert::sorted_coo_to_csr(coo.rows(), coo.nnz, out.indptr.data(), n_rows, stream);
+  raft::update_device(out.indptr.data() + n_rows, &out.nnz, 1, stream);
+  raft::copy(out.indices.data(), coo.cols(), coo.nnz, stream);
+  raft::copy(out.values.data(), coo.vals(), coo.nnz, stream);
+  resource::sync_stream(res);
+  return out;
+}
+
+}  // namespace raft::bench::sparse
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "power_law.cuh"
+
+#include <common/benchmark.hpp>
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/random/rng.cuh>
+#include <raft/sparse/linalg/spmm.hpp>
+#include <raft/util/itertools.hpp>
+
+#include <sstream>
+#include <vector>
+
+namespace raft::bench::sparse {
+
+struct spmm_inputs {
+  power_law_params x;
+  // the columns of the dense matrices y and z
+  int n_dense_cols;
+};
+
+inline auto operator<<(std::ostream& os, const spmm_inputs& p) -> std::ostream&
+{
+  os << p.x << "#" << p.n_dense_cols;
+  return os;
+}
+
+/** z = x * y with a power-law sparse x and row-major dense y and z. */
+template <typename value_t>
+struct spmm : public fixture {
+  explicit spmm(const spmm_inputs& p)
+    : fixture(true),
+      params(p),
+      x(make_power_law_csr<value_t>(handle, p.x, 42)),
+      y(raft::make_device_matrix<value_t, int>(handle, x.n_cols, p.n_dense_cols)),
+      z(raft::make_device_matrix<value_t, int>(handle, x.n_rows, p.n_dense_cols))
+  {
+    raft::random::RngState rng{137};
+    raft::random::uniform(handle, rng, y.data_handle(), y.size(), value_t(-1), value_t(1));
+    resource::sync_stream(handle);
+    // every entry of x multiplies a row of y
+    double flops = 2.0 * x.nnz * p.n_dense_cols;
+    double bytes = x.size_bytes() + double(y.size() + z.size()) * sizeof(value_t);
+    set_work_per_iteration(bytes, flops);
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params << "#nnz=" << x.nnz;
+    state.SetLabel(label_stream.str());
+    loop_on_state(state, [this]() {
+      value_t alpha = 1;
+      value_t beta  = 0;
+      raft::sparse::linalg::spmm(handle,
+                                 false,
+                                 false,
+                                 &alpha,
+                                 x.view(),
+                                 raft::make_const_mdspan(y.view()),
+                                 &beta,
+                                 z.view());
+    });
+  }
+
+ private:
+  spmm_inputs params;
+  csr_input<value_t> x;
+  raft::device_matrix<value_t, int> y, z;
+};
+
+const std::vector<spmm_inputs> spmm_input_vecs = raft::util::itertools::product<spmm_inputs>(
+  {power_law_params{16, 16, 16}, power_law_params{20, 20, 16}, power_law_params{20, 18, 64}},
+  {16, 64, 256});
+
+RAFT_BENCH_REGISTER(spmm<float>, "", spmm_input_vecs);
+
+}  // namespace raft::bench::sparse
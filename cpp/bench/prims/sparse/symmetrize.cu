@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "power_law.cuh"
+
+#include <common/benchmark.hpp>
+
+#include <raft/sparse/convert/coo.cuh>
+#include <raft/sparse/coo.hpp>
+#include <raft/sparse/linalg/symmetrize.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <sstream>
+#include <vector>
+
+namespace raft::bench::sparse {
+
+template <typename value_t>
+struct symmetrize : public fixture {
+  explicit symmetrize(const power_law_params& p)
+    : fixture(true),
+      params(p),
+      in(make_power_law_csr<value_t>(handle, p, 42)),
+      in_rows(in.nnz, stream)
+  {
+    raft::sparse::convert::csr_to_coo(
+      in.indptr.data(), in.n_rows, in_rows.data(), in.nnz, stream);
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params << "#nnz=" << in.nnz;
+    state.SetLabel(label_stream.str());
+    int out_nnz = 0;
+    loop_on_state(state, [this, &out_nnz]() {
+      raft::sparse::COO<value_t> out(stream);
+      raft::sparse::linalg::symmetrize(handle,
+                                       in_rows.data(),
+                                       in.indices.data(),
+                                       in.values.data(),
+                                       in.n_rows,
+                                       in.n_cols,
+                                       in.nnz,
+                                       out);
+      out_nnz = out.nnz;
+    });
+    state.counters["out_nnz"] = out_nnz;
+  }
+
+ private:
+  power_law_params params;
+  csr_input<value_t> in;
+  rmm::device_uvector<int> in_rows;
+};
+
+// square matrices: the adjacency matrices of the directed power-law graphs
+const std::vector<power_law_params> symmetrize_input_vecs{
+  {16, 16, 8}, {18, 18, 16}, {20, 20, 16}, {22, 22, 32}};
+
+RAFT_BENCH_REGISTER(symmetrize<float>, "", symmetrize_input_vecs);
+
+}  // namespace raft::bench::sparse
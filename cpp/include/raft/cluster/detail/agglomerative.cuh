@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
@@ -30,12 +31,17 @@
 #include <thrust/fill.h>
 #include <thrust/for_each.h>
 #include <thrust/functional.h>
+#include <thrust/gather.h>
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
+#include <thrust/remove.h>
+#include <thrust/sequence.h>
 #include <thrust/sort.h>
 #include <thrust/tuple.h>
 
 #include <cstddef>
+#include <limits>
+#include <vector>
 
 namespace raft::cluster::detail {
 template <typename value_idx, typename value_t>
@@ -80,15 +86,8 @@ class UnionFind {
 };
 
 /**
- * Agglomerative labeling on host. This has not been found to be a bottleneck
- * in the algorithm. A parallel version of this can be done using a parallel
- * variant of Kruskal's MST algorithm
- * (ref http://cucis.ece.northwestern.edu/publications/pdf/HenPat12.pdf),
- * which breaks apart the sorted MST results into overlapping subsets and
- * independently runs Kruskal's algorithm on each subset, merging them back
- * together into a single hierarchy when complete. Unfortunately,
- * this is nontrivial and the speedup wouldn't be useful until this
- * becomes a bottleneck.
+ * Agglomerative labeling on host, with a sequential union-find over the sorted
+ * MST edges. See build_dendrogram_device for the parallel version.
  *
  * @tparam value_idx
  * @tparam value_t
@@ -154,6 +153,216 @@ void build_dendrogram_host(raft::resources const& handle,
   raft::update_device(out_delta, out_delta_h.data(), n_edges, stream);
 }
 
+/** The smallest index of the remaining MST edges incident to every cluster. */
+template <typename value_idx>
+RAFT_KERNEL dendrogram_min_edge_kernel(const value_idx* edges,
+                                       value_idx n_edges,
+                                       const value_idx* rows,
+                                       const value_idx* cols,
+                                       const value_idx* comp,
+                                       value_idx* min_edge)
+{
+  value_idx tid = blockDim.x * blockIdx.x + threadIdx.x;
+  if (tid >= n_edges) { return; }
+  value_idx i = edges[tid];
+  atomicMin(min_edge + comp[rows[i]], i);
+  atomicMin(min_edge + comp[cols[i]], i);
+}
+
+/**
+ * Merges the two clusters of every remaining MST edge that is the smallest edge of both: no
+ * edge processed before it in Kruskal's order touches them, so that they are the clusters the
+ * sequential union-find would merge.
+ */
+template <typename value_idx>
+RAFT_KERNEL dendrogram_merge_kernel(const value_idx* edges,
+                                    value_idx n_edges,
+                                    const value_idx* rows,
+                                    const value_idx* cols,
+                                    const value_idx* comp,
+                                    const value_idx* min_edge,
+                                    value_idx n_leaves,
+                                    value_idx* cluster_size,
+                                    value_idx* merged_into,
+                                    value_idx* children,
+                                    value_idx* out_size,
+                                    bool* merged)
+{
+  value_idx tid = blockDim.x * blockIdx.x + threadIdx.x;
+  if (tid >= n_edges) { return; }
+  value_idx i  = edges[tid];
+  value_idx aa = comp[rows[i]];
+  value_idx bb = comp[cols[i]];
+  merged[tid]  = min_edge[aa] == i && min_edge[bb] == i;
+  if (!merged[tid]) { return; }
+  value_idx size             = cluster_size[aa] + cluster_size[bb];
+  children[2 * i]            = aa;
+  children[2 * i + 1]        = bb;
+  out_size[i]                = size;
+  cluster_size[n_leaves + i] = size;
+  merged_into[aa]            = n_leaves + i;
+  merged_into[bb]            = n_leaves + i;
+}
+
+/**
+ * Agglomerative labeling on device, producing the same dendrogram as build_dendrogram_host.
+ *
+ * In every round, each cluster finds its smallest remaining MST edge, and the edges that are the
+ * smallest of both their clusters are merged in parallel (a cluster takes part in one merge per
+ * round, and the new cluster of edge i is always n_leaves + i). The globally smallest remaining
+ * edge is always merged, and on typical MSTs a constant fraction of the edges are, which gives a
+ * logarithmic number of rounds. Long chains of increasing edges merge one edge per round though:
+ * when a round merges less than 1/kDendrogramMinProgress of the remaining edges, the remaining
+ * ones are processed by a host union-find started from the clusters built so far.
+ *
+ * @tparam value_idx
+ * @tparam value_t
+ * @param[in] handle the raft handle
+ * @param[in] rows src edges of the sorted MST
+ * @param[in] cols dst edges of the sorted MST
+ * @param[in] nnz the number of edges in the sorted MST
+ * @param[out] children children of output
+ * @param[out] out_delta distances of output
+ * @param[out] out_size cluster sizes of output
+ */
+template <typename value_idx, typename value_t, int tpb = 256>
+void build_dendrogram_device(raft::resources const& handle,
+                             const value_idx* rows,
+                             const value_idx* cols,
+                             const value_t* data,
+                             size_t nnz,
+                             value_idx* children,
+                             value_t* out_delta,
+                             value_idx* out_size)
+{
+  constexpr value_idx kDendrogramMinProgress = 32;
+
+  auto stream        = resource::get_cuda_stream(handle);
+  auto thrust_policy = resource::get_thrust_policy(handle);
+  if (nnz == 0) { return; }
+  raft::copy_async(out_delta, data, nnz, stream);
+
+  value_idx n_leaves   = nnz + 1;
+  value_idx n_clusters = 2 * nnz + 1;
+
+  // the cluster of every vertex, and the cluster every cluster was merged into
+  rmm::device_uvector<value_idx> comp(n_leaves, stream);
+  rmm::device_uvector<value_idx> merged_into(n_clusters, stream);
+  rmm::device_uvector<value_idx> cluster_size(n_clusters, stream);
+  rmm::device_uvector<value_idx> min_edge(n_clusters, stream);
+  thrust::sequence(thrust_policy, comp.begin(), comp.end());
+  thrust::fill(thrust_policy, merged_into.begin(), merged_into.end(), -1);
+  thrust::fill(thrust_policy, cluster_size.begin(), cluster_size.begin() + n_leaves, 1);
+
+  // the remaining edges, in Kruskal's order
+  rmm::device_uvector<value_idx> edges(nnz, stream);
+  rmm::device_uvector<bool> merged(nnz, stream);
+  thrust::sequence(thrust_policy, edges.begin(), edges.end());
+  value_idx n_edges = nnz;
+
+  while (n_edges > 0) {
+    value_idx n_blocks = ceildiv(n_edges, (value_idx)tpb);
+    thrust::fill(
+      thrust_policy, min_edge.begin(), min_edge.end(), std::numeric_limits<value_idx>::max());
+    dendrogram_min_edge_kernel<<<n_blocks, tpb, 0, stream>>>(
+      edges.data(), n_edges, rows, cols, comp.data(), min_edge.data());
+    dendrogram_merge_kernel<<<n_blocks, tpb, 0, stream>>>(edges.data(),
+                                                          n_edges,
+                                                          rows,
+                                                          cols,
+                                                          comp.data(),
+                                                          min_edge.data(),
+                                                          n_leaves,
+                                                          cluster_size.data(),
+                                                          merged_into.data(),
+                                                          children,
+                                                          out_size,
+                                                          merged.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // a cluster is merged at most once per round: a single hop brings the vertices to their root
+    thrust::for_each_n(thrust_policy,
+                       comp.begin(),
+                       n_leaves,
+                       [merged_into = merged_into.data()] __device__(value_idx& c) {
+                         if (merged_into[c] != -1) { c = merged_into[c]; }
+                       });
+
+    auto edges_end = thrust::remove_if(
+      thrust_policy, edges.begin(), edges.begin() + n_edges, merged.begin(), raft::identity_op{});
+    value_idx n_remaining = edges_end - edges.begin();
+    bool stalled          = (n_edges - n_remaining) * kDendrogramMinProgress < n_edges;
+    n_edges               = n_remaining;
+    if (stalled) { break; }
+  }
+  if (n_edges == 0) { return; }
+
+  // Finish the remaining edges on host, in Kruskal's order, from the current clusters.
+  std::vector<value_idx> edges_h(n_edges);
+  std::vector<value_idx> rows_h(n_edges);
+  std::vector<value_idx> cols_h(n_edges);
+  std::vector<value_idx> comp_h(n_leaves);
+  std::vector<value_idx> size_h(n_clusters);
+  {
+    rmm::device_uvector<value_idx> ends(n_edges, stream);
+    raft::update_host(edges_h.data(), edges.data(), n_edges, stream);
+    thrust::gather(thrust_policy, edges.begin(), edges.begin() + n_edges, rows, ends.begin());
+    raft::update_host(rows_h.data(), ends.data(), n_edges, stream);
+    thrust::gather(thrust_policy, edges.begin(), edges.begin() + n_edges, cols, ends.begin());
+    raft::update_host(cols_h.data(), ends.data(), n_edges, stream);
+    raft::update_host(comp_h.data(), comp.data(), n_leaves, stream);
+    raft::update_host(size_h.data(), cluster_size.data(), n_clusters, stream);
+    resource::sync_stream(handle, stream);
+  }
+
+  std::vector<value_idx> parent(n_clusters, -1);
+  auto find = [&parent](value_idx c) {
+    value_idx root = c;
+    while (parent[root] != -1) {
+      root = parent[root];
+    }
+    while (parent[c] != -1 && parent[c] != root) {
+      value_idx next = parent[c];
+      parent[c]      = root;
+      c              = next;
+    }
+    return root;
+  };
+  std::vector<value_idx> children_h(2 * n_edges);
+  std::vector<value_idx> out_size_h(n_edges);
+  for (value_idx e = 0; e < n_edges; e++) {
+    value_idx i           = edges_h[e];
+    value_idx aa          = find(comp_h[rows_h[e]]);
+    value_idx bb          = find(comp_h[cols_h[e]]);
+    children_h[2 * e]     = aa;
+    children_h[2 * e + 1] = bb;
+    out_size_h[e]         = size_h[aa] + size_h[bb];
+    size_h[n_leaves + i]  = out_size_h[e];
+    parent[aa]            = n_leaves + i;
+    parent[bb]            = n_leaves + i;
+  }
+
+  rmm::device_uvector<value_idx> children_d(2 * n_edges, stream);
+  rmm::device_uvector<value_idx> out_size_d(n_edges, stream);
+  raft::update_device(children_d.data(), children_h.data(), 2 * n_edges, stream);
+  raft::update_device(out_size_d.data(), out_size_h.data(), n_edges, stream);
+  thrust::for_each_n(thrust_policy,
+                     thrust::make_counting_iterator<value_idx>(0),
+                     n_edges,
+                     [edges      = edges.data(),
+                      children_d = children_d.data(),
+                      out_size_d = out_size_d.data(),
+                      children,
+                      out_size] __device__(value_idx e) {
+                       value_idx i         = edges[e];
+                       children[2 * i]     = children_d[2 * e];
+                       children[2 * i + 1] = children_d[2 * e + 1];
+                       out_size[i]         = out_size_d[e];
+                     });
+  // the host buffers must outlive the copies
+  resource::sync_stream(handle, stream);
+}
+
 template <typename value_idx>
 RAFT_KERNEL write_levels_kernel(const value_idx* children, value_idx* parents, value_idx n_vertices)
 {
@@ -31,6 +31,8 @@
 
 #include <rmm/device_uvector.hpp>
 
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/transform.h>
 #include <thrust/tuple.h>
@@ -69,39 +71,25 @@ struct distance_graph_impl<raft::cluster::LinkageDistance::KNN_GRAPH, value_idx,
            rmm::device_uvector<value_t>& data,
            int c)
   {
-    auto stream        = resource::get_cuda_stream(handle);
     auto thrust_policy = resource::get_thrust_policy(handle);
 
     // Need to symmetrize knn into undirected graph
-    raft::sparse::COO<value_t, value_idx> knn_graph_coo(stream);
-
-    raft::sparse::neighbors::knn_graph(handle, X, m, n, metric, knn_graph_coo, c);
-
-    indices.resize(knn_graph_coo.nnz, stream);
-    data.resize(knn_graph_coo.nnz, stream);
+    raft::sparse::neighbors::knn_graph(handle, X, m, n, metric, indptr, indices, data, c);
 
     // self-loops get max distance
-    auto transform_in = thrust::make_zip_iterator(
-      thrust::make_tuple(knn_graph_coo.rows(), knn_graph_coo.cols(), knn_graph_coo.vals()));
-
-    thrust::transform(thrust_policy,
-                      transform_in,
-                      transform_in + knn_graph_coo.nnz,
-                      knn_graph_coo.vals(),
-                      [=] __device__(const thrust::tuple<value_idx, value_idx, value_t>& tup) {
-                        bool self_loop = thrust::get<0>(tup) == thrust::get<1>(tup);
-                        return (self_loop * std::numeric_limits<value_t>::max()) +
-                               (!self_loop * thrust::get<2>(tup));
-                      });
-
-    raft::sparse::convert::sorted_coo_to_csr(
-      knn_graph_coo.rows(), knn_graph_coo.nnz, indptr.data(), m + 1, stream);
-
-    // TODO: Wouldn't need to copy here if we could compute knn
-    // graph directly on the device uvectors
-    // ref: https://github.com/rapidsai/raft/issues/227
-    raft::copy_async(indices.data(), knn_graph_coo.cols(), knn_graph_coo.nnz, stream);
-    raft::copy_async(data.data(), knn_graph_coo.vals(), knn_graph_coo.nnz, stream);
+    const value_idx* indptr_ptr  = indptr.data();
+    const value_idx* indices_ptr = indices.data();
+    value_t* data_ptr            = data.data();
+    thrust::for_each_n(thrust_policy,
+                       thrust::make_counting_iterator<value_idx>(0),
+                       m,
+                       [=] __device__(value_idx row) {
+                         for (value_idx i = indptr_ptr[row]; i < indptr_ptr[row + 1]; i++) {
+                           if (indices_ptr[i] == row) {
+                             data_ptr[i] = std::numeric_limits<value_t>::max();
+                           }
+                         }
+                       });
   }
 };
 
@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <raft/cluster/detail/kmeans_bounds.cuh>
 #include <raft/cluster/detail/kmeans_common.cuh>
 #include <raft/cluster/kmeans_types.hpp>
 #include <raft/common/nvtx.hpp>
@@ -26,6 +27,7 @@
 #include <raft/core/mdarray.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/deadline.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
@@ -51,6 +53,7 @@
 #include <ctime>
 #include <optional>
 #include <random>
+#include <vector>
 
 namespace raft {
 namespace cluster {
@@ -270,6 +273,56 @@ void kmeansPlusPlus(raft::resources const& handle,
   }  /// <<<< Step-5 >>>
 }
 
+/**
+ * Divide the weighted sums of the samples assigned to each cluster by the cluster weights; the
+ * clusters without samples keep their current centroid.
+ *
+ * @param[in] handle
+ * @param[in] centroids matrix of current centroids (size n_clusters, n_features)
+ * @param[in] weight_per_cluster sum of sample weights per cluster (size n_clusters)
+ * @param[inout] new_centroids [in] the weighted sums of the samples of each cluster
+ *                             [out] the updated centroids (size n_clusters, n_features)
+ */
+template <typename DataT, typename IndexT>
+void finalize_centroids(raft::resources const& handle,
+                        raft::device_matrix_view<const DataT, IndexT, row_major> centroids,
+                        raft::device_vector_view<DataT, IndexT> weight_per_cluster,
+                        raft::device_matrix_view<DataT, IndexT, row_major> new_centroids)
+{
+  // Computes new_centroids[i] = new_centroids[i]/weight_per_cluster[i] where
+  //   new_centroids[n_clusters x n_features] - 2D array, new_centroids[i] has sum of all the
+  //   samples assigned to cluster-i
+  //   weight_per_cluster[n_clusters] - 1D array, weight_per_cluster[i] contains sum of weights in
+  //   cluster-i.
+  // Note - when weight_per_cluster[i] is 0, new_centroids[i] is reset to 0
+  raft::linalg::matrixVectorOp(new_centroids.data_handle(),
+                               new_centroids.data_handle(),
+                               weight_per_cluster.data_handle(),
+                               new_centroids.extent(1),
+                               new_centroids.extent(0),
+                               true,
+                               false,
+                               raft::div_checkzero_op{},
+                               resource::get_cuda_stream(handle));
+
+  // copy centroids[i] to new_centroids[i] when weight_per_cluster[i] is 0
+  cub::ArgIndexInputIterator<DataT*> itr_wt(weight_per_cluster.data_handle());
+  raft::matrix::gather_if(
+    const_cast<DataT*>(centroids.data_handle()),
+    static_cast<int>(centroids.extent(1)),
+    static_cast<int>(centroids.extent(0)),
+    itr_wt,
+    itr_wt,
+    static_cast<int>(weight_per_cluster.size()),
+    new_centroids.data_handle(),
+    [=] __device__(raft::KeyValuePair<ptrdiff_t, DataT> map) {  // predicate
+      // copy when the sum of weights in the cluster is 0
+      return map.value == 0;
+    },
+    raft::key_op{},
+    resource::get_cuda_stream(handle));
+}
+
 /**
  *
  * @tparam DataT
@@ -323,38 +376,140 @@ void update_centroids(raft::resources const& handle,
                                    (IndexT)n_clusters,
                                    resource::get_cuda_stream(handle));
 
-  // Computes new_centroids[i] = new_centroids[i]/weight_per_cluster[i] where
-  //   new_centroids[n_clusters x n_features] - 2D array, new_centroids[i] has sum of all the
-  //   samples assigned to cluster-i
-  //   weight_per_cluster[n_clusters] - 1D array, weight_per_cluster[i] contains sum of weights in
-  //   cluster-i.
-  // Note - when weight_per_cluster[i] is 0, new_centroids[i] is reset to 0
-  raft::linalg::matrixVectorOp(new_centroids.data_handle(),
-                               new_centroids.data_handle(),
-                               weight_per_cluster.data_handle(),
-                               new_centroids.extent(1),
-                               new_centroids.extent(0),
-                               true,
-                               false,
-                               raft::div_checkzero_op{},
-                               resource::get_cuda_stream(handle));
+  finalize_centroids<DataT, IndexT>(handle, centroids, weight_per_cluster, new_centroids);
+}
 
-  // copy centroids[i] to new_centroids[i] when weight_per_cluster[i] is 0
-  cub::ArgIndexInputIterator<DataT*> itr_wt(weight_per_cluster.data_handle());
-  raft::matrix::gather_if(
-    const_cast<DataT*>(centroids.data_handle()),
-    static_cast<int>(centroids.extent(1)),
-    static_cast<int>(centroids.extent(0)),
-    itr_wt,
-    itr_wt,
-    static_cast<int>(weight_per_cluster.size()),
-    new_centroids.data_handle(),
-    [=] __device__(raft::KeyValuePair<ptrdiff_t, DataT> map) {  // predicate
-      // copy when the sum of weights in the cluster is 0
-      return map.value == 0;
-    },
-    raft::key_op{},
-    resource::get_cuda_stream(handle));
+/**
+ * The Lloyd iterations of kmeans_fit_main, where the assignment step only recomputes the distances
+ * of the samples that may change clusters (Hamerly's algorithm, see bounded_assign).
+ *
+ * After the centroids move by p(c), the lower bound of a sample decreases by the largest move of
+ * the centroids other than its own, and its distance to its centroid is recomputed exactly in the
+ * next assignment step, which costs O(n_samples * n_features).
+ */
+template <typename DataT, typename IndexT>
+void kmeans_fit_main_bounds(raft::resources const& handle,
+                            const KMeansParams& params,
+                            raft::device_matrix_view<const DataT, IndexT> X,
+                            raft::device_vector_view<const DataT, IndexT> weight,
+                            raft::device_matrix_view<DataT, IndexT> centroidsRawData,
+                            raft::host_scalar_view<DataT> inertia,
+                            raft::host_scalar_view<IndexT> n_iter,
+                            rmm::device_uvector<char>& workspace)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_main_bounds");
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  bool sqrt_metric    = params.metric == raft::distance::DistanceType::L2SqrtExpanded;
+
+  kmeans_bounds<DataT, IndexT> bounds(n_samples, stream);
+  rmm::device_uvector<DataT> L2NormBuf_OR_DistBuf(0, stream);
+  auto newCentroids = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+  auto wtInCluster  = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  auto shift        = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  std::vector<DataT> h_shift(n_clusters);
+  auto centroids = raft::make_device_matrix_view<const DataT, IndexT>(
+    centroidsRawData.data_handle(), n_clusters, n_features);
+
+  // the cost of the current assignment, from the exact distances of the samples to their centroid
+  auto clusterCost = raft::make_device_scalar<DataT>(handle, 0);
+  auto cost        = [&]() {
+    raft::linalg::mapThenSumReduce(
+      clusterCost.data_handle(),
+      n_samples,
+      [sqrt_metric] __device__(DataT u, DataT w) { return (sqrt_metric ? u : u * u) * w; },
+      stream,
+      static_cast<const DataT*>(bounds.upper.data()),
+      weight.data_handle());
+    DataT result = 0;
+    raft::copy(&result, clusterCost.data_handle(), 1, stream);
+    resource::sync_stream(handle, stream);
+    return result;
+  };
+
+  DataT priorClusteringCost = 0;
+  for (n_iter[0] = 1; n_iter[0] <= params.max_iter; ++n_iter[0]) {
+    resource::check_interrupted(handle);
+    IndexT n_reassigned = bounded_assign<DataT, IndexT>(
+      handle, params, X, centroids, bounds, n_iter[0] == 1, L2NormBuf_OR_DistBuf, workspace);
+    RAFT_LOG_DEBUG("KMeans.fit: Iteration-%d: %d samples reassigned", n_iter[0], n_reassigned);
+
+    update_centroids(handle,
+                     X,
+                     weight,
+                     centroids,
+                     bounds.labels.data(),
+                     wtInCluster.view(),
+                     newCentroids.view(),
+                     workspace);
+
+    // the move of every centroid
+    assigned_distance<DataT, IndexT>(handle,
+                                     newCentroids.data_handle(),
+                                     centroids.data_handle(),
+                                     static_cast<const IndexT*>(nullptr),
+                                     n_clusters,
+                                     n_features,
+                                     shift.data_handle());
+    raft::copy(h_shift.data(), shift.data_handle(), n_clusters, stream);
+    raft::copy(
+      centroidsRawData.data_handle(), newCentroids.data_handle(), newCentroids.size(), stream);
+
+    bool done = false;
+    if (params.inertia_check) {
+      DataT curClusteringCost = cost();
+      ASSERT(curClusteringCost != (DataT)0.0,
+             "Too few points and centroids being found is getting 0 cost from "
+             "centers");
+      if (n_iter[0] > 1) {
+        DataT delta = curClusteringCost / priorClusteringCost;
+        if (delta > 1 - params.tol) done = true;
+      }
+      priorClusteringCost = curClusteringCost;
+    }
+    resource::sync_stream(handle, stream);
+
+    DataT sqrdNormError = 0;
+    IndexT max_id       = 0;
+    DataT max_shift     = 0;
+    DataT second_shift  = 0;
+    for (IndexT c = 0; c < n_clusters; c++) {
+      sqrdNormError += h_shift[c] * h_shift[c];
+      if (h_shift[c] > max_shift) {
+        second_shift = max_shift;
+        max_shift    = h_shift[c];
+        max_id       = c;
+      } else if (h_shift[c] > second_shift) {
+        second_shift = h_shift[c];
+      }
+    }
+    if (sqrdNormError < params.tol) done = true;
+
+    // The other centroids may have come closer by their largest move. The centroids have already
+    // moved, so the bounds are updated even on the last iteration, before the final assignment.
+    raft::linalg::map_offset(
+      handle,
+      raft::make_device_vector_view<DataT, IndexT>(bounds.lower.data(), n_samples),
+      [lower = bounds.lower.data(), labels = bounds.labels.data(), max_id, max_shift, second_shift]
+      __device__(IndexT i) { return lower[i] - (labels[i] == max_id ? second_shift : max_shift); });
+
+    if (done) {
+      RAFT_LOG_DEBUG("Threshold triggered after %d iterations. Terminating early.", n_iter[0]);
+      break;
+    }
+  }
+
+  // the final assignment
+  bounded_assign<DataT, IndexT>(
+    handle, params, X, centroids, bounds, false, L2NormBuf_OR_DistBuf, workspace);
+  inertia[0] = cost();
+
+  RAFT_LOG_DEBUG("KMeans.fit: completed after %d iterations with %f inertia[0] ",
+                 n_iter[0] > params.max_iter ? n_iter[0] - 1 : n_iter[0],
+                 inertia[0]);
 }
 
 // TODO: Resizing is needed to use mdarray instead of rmm::device_uvector
@@ -368,6 +523,11 @@ void kmeans_fit_main(raft::resources const& handle,
                      raft::host_scalar_view<IndexT> n_iter,
                      rmm::device_uvector<char>& workspace)
 {
+  if (params.use_bounds) {
+    kmeans_fit_main_bounds<DataT, IndexT>(
+      handle, params, X, weight, centroidsRawData, inertia, n_iter, workspace);
+    return;
+  }
   common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_main");
   logger::get(RAFT_NAME).set_level(params.verbosity);
   cudaStream_t stream = resource::get_cuda_stream(handle);
@@ -419,6 +579,7 @@ void kmeans_fit_main(raft::resources const& handle,
 
   DataT priorClusteringCost = 0;
   for (n_iter[0] = 1; n_iter[0] <= params.max_iter; ++n_iter[0]) {
+    resource::check_interrupted(handle);
     RAFT_LOG_DEBUG(
       "KMeans.fit: Iteration-%d: fitting the model using the initialized "
       "cluster centers",
@@ -839,6 +1000,9 @@ void kmeans_fit(raft::resources const& handle,
   RAFT_EXPECTS(n_clusters > 0, "invalid parameter (n_clusters<=0)");
   RAFT_EXPECTS(params.tol > 0, "invalid parameter (tol<=0)");
   RAFT_EXPECTS(params.oversampling_factor >= 0, "invalid parameter (oversampling_factor<0)");
+  RAFT_EXPECTS(!params.use_bounds || params.metric == raft::distance::DistanceType::L2Expanded ||
+                 params.metric == raft::distance::DistanceType::L2SqrtExpanded,
+               "invalid parameter (use_bounds requires an L2Expanded or L2SqrtExpanded metric)");
   RAFT_EXPECTS((int)centroids.extent(0) == params.n_clusters,
                "invalid parameter (centroids.extent(0) != n_clusters)");
   RAFT_EXPECTS(centroids.extent(1) == n_features,
@@ -19,50 +19,195 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/error.hpp>
 #include <raft/core/host_mdarray.hpp>
+#include <raft/core/interruptible.hpp>
 #include <raft/core/logger.hpp>
+#include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/stats/dispersion.cuh>
 
 #include <thrust/host_vector.h>
 
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
 namespace raft::cluster::detail {
 
+/** The outcome of the k-means fit of one candidate number of clusters. */
 template <typename value_t, typename idx_t>
-void compute_dispersion(raft::resources const& handle,
-                        raft::device_matrix_view<const value_t, idx_t> X,
-                        KMeansParams& params,
-                        raft::device_matrix_view<value_t, idx_t> centroids_view,
-                        raft::device_vector_view<idx_t> labels,
-                        raft::device_vector_view<idx_t> clusterSizes,
-                        rmm::device_uvector<char>& workspace,
-                        raft::host_vector_view<value_t> clusterDispertionView,
-                        raft::host_vector_view<value_t> resultsView,
-                        raft::host_scalar_view<value_t> residual,
-                        raft::host_scalar_view<idx_t> n_iter,
-                        int val,
-                        idx_t n,
-                        idx_t d)
-{
-  auto centroids_const_view =
-    raft::make_device_matrix_view<const value_t, idx_t>(centroids_view.data_handle(), val, d);
+struct find_k_candidate {
+  value_t residual;
+  value_t dispersion;
+  idx_t n_iter;
+};
 
-  idx_t* clusterSizes_ptr = clusterSizes.data_handle();
-  auto cluster_sizes_view =
-    raft::make_device_vector_view<const idx_t, idx_t>(clusterSizes_ptr, val);
+template <typename value_t, typename idx_t>
+auto fit_candidate(raft::resources const& handle,
+                   raft::device_matrix_view<const value_t, idx_t> X,
+                   KMeansParams params,
+                   idx_t k) -> find_k_candidate<value_t, idx_t>
+{
+  idx_t n = X.extent(0);
+  idx_t d = X.extent(1);
 
-  params.n_clusters = val;
+  auto centroids    = raft::make_device_matrix<value_t, idx_t>(handle, k, d);
+  auto clusterSizes = raft::make_device_vector<idx_t, idx_t>(handle, k);
+  auto labels       = raft::make_device_vector<idx_t, idx_t>(handle, n);
+  rmm::device_uvector<char> workspace(0, resource::get_cuda_stream(handle));
 
+  find_k_candidate<value_t, idx_t> result{};
+  params.n_clusters = k;
   raft::cluster::detail::kmeans_fit_predict<value_t, idx_t>(
-    handle, params, X, std::nullopt, std::make_optional(centroids_view), labels, residual, n_iter);
+    handle,
+    params,
+    X,
+    std::nullopt,
+    std::make_optional(centroids.view()),
+    raft::make_device_vector_view<idx_t, idx_t>(labels.data_handle(), n),
+    raft::make_host_scalar_view<value_t>(&result.residual),
+    raft::make_host_scalar_view<idx_t>(&result.n_iter));
 
-  detail::countLabels(handle, labels.data_handle(), clusterSizes.data_handle(), n, val, workspace);
+  detail::countLabels(handle, labels.data_handle(), clusterSizes.data_handle(), n, k, workspace);
 
-  resultsView[val]           = residual[0];
-  clusterDispertionView[val] = raft::stats::cluster_dispersion(
-    handle, centroids_const_view, cluster_sizes_view, std::nullopt, n);
+  result.dispersion = raft::stats::cluster_dispersion(handle,
+                                                      raft::make_const_mdspan(centroids.view()),
+                                                      raft::make_const_mdspan(clusterSizes.view()),
+                                                      std::nullopt,
+                                                      n);
+  return result;
 }
 
+/**
+ * The fits of the candidate numbers of clusters of find_k, run at most once each.
+ *
+ * With a stream pool, the fits that the search is likely to need next are started ahead, each on
+ * a stream of the pool driven by its own host thread, while the search waits for the current one.
+ * The speculative fits that the search moves away from are stopped early through
+ * raft::interruptible, at the next synchronization of their stream.
+ */
+template <typename value_t, typename idx_t>
+class find_k_candidates {
+ public:
+  find_k_candidates(raft::resources const& handle,
+                    raft::device_matrix_view<const value_t, idx_t> X,
+                    const KMeansParams& params)
+    : handle_(handle), X_(X), params_(params)
+  {
+    for (size_t i = 0; i < resource::get_stream_pool_size(handle); i++) {
+      free_streams_.push_back(i);
+    }
+    if (!free_streams_.empty()) { resource::wait_stream_pool_on_stream(handle); }
+  }
+
+  ~find_k_candidates() noexcept
+  {
+    for (auto& [k, fit] : pending_) {
+      stop(fit);
+    }
+  }
+
+  find_k_candidates(const find_k_candidates&)            = delete;
+  find_k_candidates& operator=(const find_k_candidates&) = delete;
+
+  /** The fit with k clusters: cached, waited for if it runs ahead, or run on the main stream. */
+  auto get(idx_t k) -> find_k_candidate<value_t, idx_t>
+  {
+    if (auto it = done_.find(k); it != done_.end()) { return it->second; }
+    if (auto it = pending_.find(k); it != pending_.end()) {
+      auto result = it->second.result.get();
+      free_streams_.push_back(it->second.stream_id);
+      pending_.erase(it);
+      if (result.has_value()) { return done_.emplace(k, *result).first->second; }
+    }
+    return done_.emplace(k, fit_candidate<value_t, idx_t>(handle_, X_, params_, k)).first->second;
+  }
+
+  /** Start the fit with k clusters ahead, if a stream of the pool is free. */
+  void prefetch(idx_t k)
+  {
+    if (free_streams_.empty() || done_.count(k) > 0 || pending_.count(k) > 0) { return; }
+    size_t stream_id = free_streams_.back();
+    free_streams_.pop_back();
+
+    // The copy of the handle is made here, as the main thread may add resources to the original
+    // while the fit runs; its stream-bound resources are not shared with the main stream.
+    auto worker        = std::make_shared<raft::resources>(handle_);
+    auto worker_stream = resource::get_stream_from_stream_pool(handle_, stream_id);
+    resource::set_cuda_stream(*worker, worker_stream);
+    resource::set_cuda_stream_pool(*worker, nullptr);
+    worker->add_resource_factory(
+      std::make_shared<resource::thrust_policy_resource_factory>(worker_stream));
+    worker->add_resource_factory(
+      std::make_shared<resource::cublas_resource_factory>(worker_stream));
+
+    pending_fit fit;
+    fit.stream_id = stream_id;
+    std::promise<std::shared_ptr<raft::interruptible>> token;
+    fit.token  = token.get_future();
+    fit.result = std::async(
+      std::launch::async,
+      [worker, X = X_, params = params_, k](auto token) -> std::optional<candidate_t> {
+        token.set_value(raft::interruptible::get_token());
+        try {
+          auto result = fit_candidate<value_t, idx_t>(*worker, X, params, k);
+          resource::sync_stream(*worker);
+          return result;
+        } catch (const raft::interrupted_exception&) {
+          resource::get_cuda_stream(*worker).synchronize_no_throw();
+          return std::nullopt;
+        }
+      },
+      std::move(token));
+    pending_.emplace(k, std::move(fit));
+  }
+
+  /** Stop the fits running ahead, except the one with k clusters. */
+  void cancel_except(idx_t k)
+  {
+    for (auto it = pending_.begin(); it != pending_.end();) {
+      if (it->first == k) {
+        ++it;
+        continue;
+      }
+      auto result = stop(it->second);
+      if (result.has_value()) { done_.emplace(it->first, *result); }
+      free_streams_.push_back(it->second.stream_id);
+      it = pending_.erase(it);
+    }
+  }
+
+ private:
+  using candidate_t = find_k_candidate<value_t, idx_t>;
+
+  struct pending_fit {
+    size_t stream_id;
+    std::future<std::shared_ptr<raft::interruptible>> token;
+    std::future<std::optional<candidate_t>> result;
+  };
+
+  static auto stop(pending_fit& fit) noexcept -> std::optional<candidate_t>
+  {
+    try {
+      fit.token.get()->cancel();
+      return fit.result.get();
+    } catch (...) {
+      return std::nullopt;
+    }
+  }
+
+  raft::resources const& handle_;
+  raft::device_matrix_view<const value_t, idx_t> X_;
+  KMeansParams params_;
+  std::vector<size_t> free_streams_;
+  std::map<idx_t, candidate_t> done_;
+  std::map<idx_t, pending_fit> pending_;
+};
+
 template <typename idx_t, typename value_t>
 void find_k(raft::resources const& handle,
             raft::device_matrix_view<const value_t, idx_t> X,
@@ -83,16 +228,6 @@ void find_k(raft::resources const& handle,
   RAFT_EXPECTS(kmax <= n, "kmax must be <= number of data samples in X");
   RAFT_EXPECTS(tol >= 0, "tolerance must be >= 0");
   RAFT_EXPECTS(maxiter >= 0, "maxiter must be >= 0");
-  // Allocate memory
-  // Device memory
-
-  auto centroids    = raft::make_device_matrix<value_t, idx_t>(handle, kmax, X.extent(1));
-  auto clusterSizes = raft::make_device_vector<idx_t>(handle, kmax);
-  auto labels       = raft::make_device_vector<idx_t>(handle, n);
-
-  rmm::device_uvector<char> workspace(0, resource::get_cuda_stream(handle));
-
-  idx_t* clusterSizes_ptr = clusterSizes.data_handle();
 
   // Host memory
   auto results           = raft::make_host_vector<value_t>(kmax + 1);
@@ -115,68 +250,38 @@ void find_k(raft::resources const& handle,
   params.max_iter = maxiter;
   params.tol      = tol;
 
-  auto centroids_view =
-    raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), left, d);
-  compute_dispersion<value_t, idx_t>(handle,
-                                     X,
-                                     params,
-                                     centroids_view,
-                                     labels.view(),
-                                     clusterSizes.view(),
-                                     workspace,
-                                     clusterDispertionView,
-                                     resultsView,
-                                     residual,
-                                     n_iter,
-                                     left,
-                                     n,
-                                     d);
+  // The fits are deterministic: a candidate k is fit once, and reused by the retries below.
+  find_k_candidates<value_t, idx_t> candidates(handle, X, params);
+  auto compute_dispersion = [&](int val) {
+    auto candidate             = candidates.get(val);
+    resultsView[val]           = candidate.residual;
+    clusterDispertionView[val] = candidate.dispersion;
+    residual[0]                = candidate.residual;
+    n_iter[0]                  = candidate.n_iter;
+  };
+
+  candidates.prefetch(right);
+  candidates.prefetch(mid);
+  compute_dispersion(left);
 
   // eval right edge0
   resultsView[right] = 1e20;
   while (resultsView[right] > resultsView[left] && tests < 3) {
-    centroids_view =
-      raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), right, d);
-    compute_dispersion<value_t, idx_t>(handle,
-                                       X,
-                                       params,
-                                       centroids_view,
-                                       labels.view(),
-                                       clusterSizes.view(),
-                                       workspace,
-                                       clusterDispertionView,
-                                       resultsView,
-                                       residual,
-                                       n_iter,
-                                       right,
-                                       n,
-                                       d);
-
+    compute_dispersion(right);
     tests += 1;
   }
 
   objective[0] = (n - left) / (left - 1) * clusterDispertionView[left] / resultsView[left];
   objective[1] = (n - right) / (right - 1) * clusterDispertionView[right] / resultsView[right];
   while (left < right - 1) {
+    // the next probe is the middle of either half, fit ahead while mid is evaluated
+    candidates.prefetch(((unsigned int)left + (unsigned int)mid) >> 1);
+    candidates.prefetch(((unsigned int)mid + (unsigned int)right) >> 1);
+
     resultsView[mid] = 1e20;
     tests            = 0;
     while (resultsView[mid] > resultsView[left] && tests < 3) {
-      centroids_view =
-        raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), mid, d);
-      compute_dispersion<value_t, idx_t>(handle,
-                                         X,
-                                         params,
-                                         centroids_view,
-                                         labels.view(),
-                                         clusterSizes.view(),
-                                         workspace,
-                                         clusterDispertionView,
-                                         resultsView,
-                                         residual,
-                                         n_iter,
-                                         mid,
-                                         n,
-                                         d);
+      compute_dispersion(mid);
 
       if (resultsView[mid] > resultsView[left] && (mid + 1) < right) {
         mid += 1;
@@ -203,6 +308,9 @@ void find_k(raft::resources const& handle,
     }
     oldmid = mid;
     mid    = ((unsigned int)right + (unsigned int)left) >> 1;
+
+    // the fit ahead in the other half is not needed anymore
+    candidates.cancel_except(mid);
   }
 
   best_k[0]    = right;
@@ -210,21 +318,10 @@ void find_k(raft::resources const& handle,
   objective[1] = (n - oldmid) / (oldmid - 1) * clusterDispertionView[oldmid] / resultsView[oldmid];
   if (objective[1] < objective[0]) { best_k[0] = left; }
 
-  // if best_k isn't what we just ran, re-run to get correct centroids and dist data on return->
-  // this saves memory
-  if (best_k[0] != oldmid) {
-    auto centroids_view =
-      raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), best_k[0], d);
-
-    params.n_clusters = best_k[0];
-    raft::cluster::detail::kmeans_fit_predict<value_t, idx_t>(handle,
-                                                              params,
-                                                              X,
-                                                              std::nullopt,
-                                                              std::make_optional(centroids_view),
-                                                              labels.view(),
-                                                              residual,
-                                                              n_iter);
-  }
+  // the residual and iterations of the best k, from its (cached) fit
+  candidates.cancel_except(best_k[0]);
+  auto best   = candidates.get(best_k[0]);
+  residual[0] = best.residual;
+  n_iter[0]   = best.n_iter;
 }
-}  // namespace raft::cluster::detail
\ No newline at end of file
+}  // namespace raft::cluster::detail
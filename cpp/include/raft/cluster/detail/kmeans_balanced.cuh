@@ -22,7 +22,10 @@
 #include <raft/core/cudart_utils.hpp>
 #include <raft/core/logger.hpp>
 #include <raft/core/operators.hpp>
+#include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/deadline.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/distance/distance.cuh>
@@ -34,6 +37,7 @@
 #include <raft/linalg/matrix_vector_op.cuh>
 #include <raft/linalg/norm.cuh>
 #include <raft/linalg/normalize.cuh>
+#include <raft/linalg/reduce.cuh>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/matrix/argmin.cuh>
 #include <raft/matrix/gather.cuh>
@@ -49,7 +53,11 @@
 #include <thrust/gather.h>
 #include <thrust/transform.h>
 
+#include <omp.h>
+
+#include <exception>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <tuple>
 #include <type_traits>
@@ -170,6 +178,194 @@ inline std::enable_if_t<std::is_floating_point_v<MathT>> predict_core(
   }
 }
 
+constexpr static inline int kPredictMappedTileRows  = 64;
+constexpr static inline int kPredictMappedTileCols  = 64;
+constexpr static inline int kPredictMappedTileDepth = 16;
+constexpr static inline int kPredictMappedThreads   = 256;
+
+/**
+ * Assign every row of the dataset to its closest center, converting the data to MathT as it is
+ * loaded into shared memory.
+ *
+ * A block of 16 x 16 threads computes the dot products of a tile of 64 rows with tiles of 64
+ * centers (4 x 4 per thread), and keeps the best center of each of its rows in registers. With
+ * `centers_norm` the criterion is the L2 distance (up to the norm of the row, which does not
+ * change the argmin), otherwise the inner product.
+ */
+template <typename T, typename MathT, typename IdxT, typename LabelT, typename MappingOpT>
+__launch_bounds__(kPredictMappedThreads) RAFT_KERNEL
+  predict_mapped_kernel(const T* dataset,
+                        const MathT* centers,
+                        const MathT* centers_norm,
+                        IdxT n_rows,
+                        IdxT n_clusters,
+                        IdxT dim,
+                        LabelT* labels,
+                        MappingOpT mapping_op)
+{
+  constexpr int kRows   = kPredictMappedTileRows;
+  constexpr int kCols   = kPredictMappedTileCols;
+  constexpr int kDepth  = kPredictMappedTileDepth;
+  constexpr int kSide   = 16;
+  constexpr int kPerRow = kRows / kSide;
+  constexpr int kPerCol = kCols / kSide;
+  // the tiles are stored depth-major, padded against bank conflicts of the loads
+  __shared__ MathT x_tile[kDepth][kRows + 1];
+  __shared__ MathT c_tile[kDepth][kCols + 1];
+
+  const int tx    = threadIdx.x % kSide;
+  const int ty    = threadIdx.x / kSide;
+  const IdxT row0 = IdxT(blockIdx.x) * kRows;
+
+  MathT best_val[kPerRow];
+  IdxT best_idx[kPerRow];
+#pragma unroll
+  for (int i = 0; i < kPerRow; i++) {
+    best_val[i] = std::numeric_limits<MathT>::max();
+    best_idx[i] = 0;
+  }
+
+  for (IdxT col0 = 0; col0 < n_clusters; col0 += kCols) {
+    MathT acc[kPerRow][kPerCol];
+#pragma unroll
+    for (int i = 0; i < kPerRow; i++) {
+#pragma unroll
+      for (int j = 0; j < kPerCol; j++) {
+        acc[i][j] = 0;
+      }
+    }
+
+    for (IdxT d0 = 0; d0 < dim; d0 += kDepth) {
+      __syncthreads();
+      for (int e = threadIdx.x; e < kRows * kDepth; e += kPredictMappedThreads) {
+        int r    = e / kDepth;
+        int d    = e % kDepth;
+        IdxT row = row0 + r;
+        IdxT col = col0 + r;
+
+        x_tile[d][r] = row < n_rows && d0 + d < dim
+                         ? MathT(mapping_op(dataset[size_t(row) * dim + d0 + d]))
+                         : MathT(0);
+        c_tile[d][r] =
+          col < n_clusters && d0 + d < dim ? centers[size_t(col) * dim + d0 + d] : MathT(0);
+      }
+      __syncthreads();
+#pragma unroll
+      for (int d = 0; d < kDepth; d++) {
+        MathT a[kPerRow];
+        MathT b[kPerCol];
+#pragma unroll
+        for (int i = 0; i < kPerRow; i++) {
+          a[i] = x_tile[d][ty + i * kSide];
+        }
+#pragma unroll
+        for (int j = 0; j < kPerCol; j++) {
+          b[j] = c_tile[d][tx + j * kSide];
+        }
+#pragma unroll
+        for (int i = 0; i < kPerRow; i++) {
+#pragma unroll
+          for (int j = 0; j < kPerCol; j++) {
+            acc[i][j] += a[i] * b[j];
+          }
+        }
+      }
+    }
+
+#pragma unroll
+    for (int j = 0; j < kPerCol; j++) {
+      IdxT col = col0 + tx + j * kSide;
+      if (col >= n_clusters) { continue; }
+      MathT c_norm = centers_norm != nullptr ? centers_norm[col] : MathT(0);
+#pragma unroll
+      for (int i = 0; i < kPerRow; i++) {
+        MathT val = centers_norm != nullptr ? c_norm - 2 * acc[i][j] : -acc[i][j];
+        if (val < best_val[i]) {
+          best_val[i] = val;
+          best_idx[i] = col;
+        }
+      }
+    }
+  }
+
+  // merge the candidates of the 16 threads sharing the rows, the smallest index first on ties
+#pragma unroll
+  for (int i = 0; i < kPerRow; i++) {
+#pragma unroll
+    for (int offset = kSide / 2; offset > 0; offset >>= 1) {
+      MathT other_val = raft::shfl_xor(best_val[i], offset, kSide);
+      IdxT other_idx  = raft::shfl_xor(best_idx[i], offset, kSide);
+      if (other_val < best_val[i] || (other_val == best_val[i] && other_idx < best_idx[i])) {
+        best_val[i] = other_val;
+        best_idx[i] = other_idx;
+      }
+    }
+    IdxT row = row0 + ty + i * kSide;
+    if (tx == 0 && row < n_rows) { labels[row] = static_cast<LabelT>(best_idx[i]); }
+  }
+}
+
+/**
+ * @brief Predict labels for a dataset that is not of type MathT, without materializing the
+ * converted data: the conversion is fused in the distance kernel.
+ *
+ * @tparam T      element type
+ * @tparam MathT  type of the centroids and mapped data
+ * @tparam IdxT   index type
+ * @tparam LabelT label type
+ * @tparam MappingOpT type of the mapping function
+ *
+ * @param[in] handle The raft handle.
+ * @param[in] params Structure containing the hyper-parameters
+ * @param[in] centers Pointer to the row-major matrix of cluster centers [n_clusters, dim]
+ * @param[in] n_clusters Number of clusters/centers
+ * @param[in] dim Dimensionality of the data
+ * @param[in] dataset Pointer to the data [n_rows, dim]
+ * @param[in] n_rows Number samples in the `dataset`
+ * @param[out] labels Output predictions [n_rows]
+ * @param[in] mapping_op Mapping operation from T to MathT
+ * @param[inout] mr Memory resource to use for temporary allocations
+ */
+template <typename T, typename MathT, typename IdxT, typename LabelT, typename MappingOpT>
+void predict_mapped(const raft::resources& handle,
+                    const kmeans_balanced_params& params,
+                    const MathT* centers,
+                    IdxT n_clusters,
+                    IdxT dim,
+                    const T* dataset,
+                    IdxT n_rows,
+                    LabelT* labels,
+                    MappingOpT mapping_op,
+                    rmm::device_async_resource_ref mr)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<MathT> centers_norm(0, stream, mr);
+  switch (params.metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded: {
+      centers_norm.resize(n_clusters, stream);
+      raft::linalg::rowNorm<MathT, IdxT>(
+        centers_norm.data(), centers, dim, n_clusters, raft::linalg::L2Norm, true, stream);
+    } break;
+    case raft::distance::DistanceType::InnerProduct: break;
+    default: {
+      RAFT_FAIL("The chosen distance metric is not supported (%d)", int(params.metric));
+    }
+  }
+  if (n_rows == 0) { return; }
+  auto n_blocks = raft::ceildiv<size_t>(n_rows, kPredictMappedTileRows);
+  predict_mapped_kernel<<<n_blocks, kPredictMappedThreads, 0, stream>>>(
+    dataset,
+    centers,
+    centers_norm.size() > 0 ? centers_norm.data() : nullptr,
+    n_rows,
+    n_clusters,
+    dim,
+    labels,
+    mapping_op);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 /**
  * @brief Suggest a minibatch size for kmeans prediction.
  *
@@ -183,15 +379,13 @@ inline std::enable_if_t<std::is_floating_point_v<MathT>> predict_core(
  * @param[in] n_rows Number of samples in the dataset
  * @param[in] dim Number of features in the dataset
  * @param[in] metric Distance metric
- * @param[in] needs_conversion Whether the data needs to be converted to MathT
  * @return A suggested minibatch size and the expected memory cost per-row (in bytes)
  */
 template <typename MathT, typename IdxT>
 constexpr auto calc_minibatch_size(IdxT n_clusters,
                                    IdxT n_rows,
                                    IdxT dim,
-                                   raft::distance::DistanceType metric,
-                                   bool needs_conversion) -> std::tuple<IdxT, size_t>
+                                   raft::distance::DistanceType metric) -> std::tuple<IdxT, size_t>
 {
   n_clusters = std::max<IdxT>(1, n_clusters);
 
@@ -210,9 +404,6 @@ constexpr auto calc_minibatch_size(IdxT n_clusters,
     }
   }
 
-  // If we need to convert to MathT, space required for the converted batch.
-  if (!needs_conversion) { mem_per_row += sizeof(MathT) * dim; }
-
   // Heuristic: calculate the minibatch size in order to use at most 1GB of memory.
   IdxT minibatch_size = (1 << 30) / mem_per_row;
   minibatch_size      = 64 * div_rounding_up_safe(minibatch_size, IdxT{64});
@@ -312,40 +503,42 @@ void calc_centers_and_sizes(const raft::resources& handle,
                                stream);
 }
 
-/** Computes the L2 norm of the dataset, converting to MathT if necessary */
+/** Computes the L2 norm of the dataset, converting to MathT on the fly if necessary */
 template <typename T, typename MathT, typename IdxT, typename MappingOpT>
 void compute_norm(const raft::resources& handle,
                   MathT* dataset_norm,
                   const T* dataset,
                   IdxT dim,
                   IdxT n_rows,
-                  MappingOpT mapping_op,
-                  std::optional<rmm::device_async_resource_ref> mr = std::nullopt)
+                  MappingOpT mapping_op)
 {
   common::nvtx::range<common::nvtx::domain::raft> fun_scope("compute_norm");
   auto stream = resource::get_cuda_stream(handle);
-  rmm::device_uvector<MathT> mapped_dataset(
-    0, stream, mr.value_or(resource::get_workspace_resource(handle)));
-
-  const MathT* dataset_ptr = nullptr;
-
-  if (std::is_same_v<MathT, T>) {
-    dataset_ptr = reinterpret_cast<const MathT*>(dataset);
+  if constexpr (std::is_same_v<MathT, T>) {
+    raft::linalg::rowNorm<MathT, IdxT>(
+      dataset_norm, dataset, dim, n_rows, raft::linalg::L2Norm, true, stream);
   } else {
-    mapped_dataset.resize(n_rows * dim, stream);
-
-    linalg::unaryOp(mapped_dataset.data(), dataset, n_rows * dim, mapping_op, stream);
-
-    dataset_ptr = static_cast<const MathT*>(mapped_dataset.data());
+    raft::linalg::reduce<T, MathT, IdxT>(dataset_norm,
+                                         dataset,
+                                         dim,
+                                         n_rows,
+                                         MathT(0),
+                                         true,
+                                         true,
+                                         stream,
+                                         false,
+                                         [mapping_op] __device__(T x, IdxT) {
+                                           MathT y = mapping_op(x);
+                                           return y * y;
+                                         });
   }
-
-  raft::linalg::rowNorm<MathT, IdxT>(
-    dataset_norm, dataset_ptr, dim, n_rows, raft::linalg::L2Norm, true, stream);
 }
 
 /**
  * @brief Predict labels for the dataset.
  *
+ * When T is not MathT, the data is converted on the fly by the distance kernel (predict_mapped).
+ *
  * @tparam T element type
  * @tparam MathT type of the centroids and mapped data
  * @tparam IdxT index type
@@ -362,7 +555,8 @@ void compute_norm(const raft::resources& handle,
  * @param[out] labels Output predictions [n_rows]
  * @param[in] mapping_op Mapping operation from T to MathT
  * @param[inout] mr (optional) memory resource to use for temporary allocations
- * @param[in] dataset_norm (optional) Pre-computed norms of each row in the dataset [n_rows]
+ * @param[in] dataset_norm (optional) Pre-computed norms of each row in the dataset [n_rows]; not
+ *   needed when T is not MathT
  */
 template <typename T, typename MathT, typename IdxT, typename LabelT, typename MappingOpT>
 void predict(const raft::resources& handle,
@@ -381,46 +575,43 @@ void predict(const raft::resources& handle,
   common::nvtx::range<common::nvtx::domain::raft> fun_scope(
     "predict(%zu, %u)", static_cast<size_t>(n_rows), n_clusters);
   auto mem_res = mr.value_or(resource::get_workspace_resource(handle));
-  auto [max_minibatch_size, _mem_per_row] =
-    calc_minibatch_size<MathT>(n_clusters, n_rows, dim, params.metric, std::is_same_v<T, MathT>);
-  rmm::device_uvector<MathT> cur_dataset(
-    std::is_same_v<T, MathT> ? 0 : max_minibatch_size * dim, stream, mem_res);
-  bool need_compute_norm =
-    dataset_norm == nullptr && (params.metric == raft::distance::DistanceType::L2Expanded ||
-                                params.metric == raft::distance::DistanceType::L2SqrtExpanded);
-  rmm::device_uvector<MathT> cur_dataset_norm(
-    need_compute_norm ? max_minibatch_size : 0, stream, mem_res);
-  const MathT* dataset_norm_ptr = nullptr;
-  auto cur_dataset_ptr          = cur_dataset.data();
-  for (IdxT offset = 0; offset < n_rows; offset += max_minibatch_size) {
-    IdxT minibatch_size = std::min<IdxT>(max_minibatch_size, n_rows - offset);
-
-    if constexpr (std::is_same_v<T, MathT>) {
-      cur_dataset_ptr = const_cast<MathT*>(dataset + offset * dim);
-    } else {
-      linalg::unaryOp(
-        cur_dataset_ptr, dataset + offset * dim, minibatch_size * dim, mapping_op, stream);
-    }
+  if constexpr (!std::is_same_v<T, MathT>) {
+    // the conversion is fused in the distance kernel, the batches are not materialized
+    predict_mapped(
+      handle, params, centers, n_clusters, dim, dataset, n_rows, labels, mapping_op, mem_res);
+  } else {
+    auto [max_minibatch_size, _mem_per_row] =
+      calc_minibatch_size<MathT>(n_clusters, n_rows, dim, params.metric);
+    bool need_compute_norm =
+      dataset_norm == nullptr && (params.metric == raft::distance::DistanceType::L2Expanded ||
+                                  params.metric == raft::distance::DistanceType::L2SqrtExpanded);
+    rmm::device_uvector<MathT> cur_dataset_norm(
+      need_compute_norm ? max_minibatch_size : 0, stream, mem_res);
+    const MathT* dataset_norm_ptr = nullptr;
+    for (IdxT offset = 0; offset < n_rows; offset += max_minibatch_size) {
+      IdxT minibatch_size          = std::min<IdxT>(max_minibatch_size, n_rows - offset);
+      const MathT* cur_dataset_ptr = dataset + offset * dim;
+
+      // Compute the norm now if it hasn't been pre-computed.
+      if (need_compute_norm) {
+        compute_norm(
+          handle, cur_dataset_norm.data(), cur_dataset_ptr, dim, minibatch_size, mapping_op);
+        dataset_norm_ptr = cur_dataset_norm.data();
+      } else if (dataset_norm != nullptr) {
+        dataset_norm_ptr = dataset_norm + offset;
+      }
 
-    // Compute the norm now if it hasn't been pre-computed.
-    if (need_compute_norm) {
-      compute_norm(
-        handle, cur_dataset_norm.data(), cur_dataset_ptr, dim, minibatch_size, mapping_op, mem_res);
-      dataset_norm_ptr = cur_dataset_norm.data();
-    } else if (dataset_norm != nullptr) {
-      dataset_norm_ptr = dataset_norm + offset;
+      predict_core(handle,
+                   params,
+                   centers,
+                   n_clusters,
+                   dim,
+                   cur_dataset_ptr,
+                   dataset_norm_ptr,
+                   minibatch_size,
+                   labels + offset,
+                   mem_res);
     }
-
-    predict_core(handle,
-                 params,
-                 centers,
-                 n_clusters,
-                 dim,
-                 cur_dataset_ptr,
-                 dataset_norm_ptr,
-                 minibatch_size,
-                 labels + offset,
-                 mem_res);
   }
 }
 
@@ -631,6 +822,7 @@ void balancing_em_iters(const raft::resources& handle,
   auto stream                = resource::get_cuda_stream(handle);
   uint32_t balancing_counter = balancing_pullback;
   for (uint32_t iter = 0; iter < n_iters; iter++) {
+    resource::check_interrupted(handle);
     // Balancing step - move the centers around to equalize cluster sizes
     // (but not on the first iteration)
     if (iter > 0 && adjust_centers(cluster_centers,
@@ -822,6 +1014,10 @@ inline auto arrange_fine_clusters(IdxT n_clusters,
  *   2. Predict fine cluster
  *   3. Refince the fine cluster centers
  *
+ *  When the handle has a stream pool, the mesoclusters are processed concurrently, each host
+ *  thread running the small EM problems of its mesoclusters on its own stream of the pool (with
+ *  its own training buffers), so that the small mesoclusters do not leave the GPU idle.
+ *
  *  As a result, the fine clusters are what is returned by `build_hierarchical`;
  *  this function returns the total number of fine clusters, which can be checked to be
  *  the same as the requested number of clusters.
@@ -855,29 +1051,16 @@ auto build_fine_clusters(const raft::resources& handle,
                          rmm::device_async_resource_ref device_memory) -> IdxT
 {
   auto stream = resource::get_cuda_stream(handle);
-  rmm::device_uvector<IdxT> mc_trainset_ids_buf(mesocluster_size_max, stream, managed_memory);
-  rmm::device_uvector<MathT> mc_trainset_buf(mesocluster_size_max * dim, stream, device_memory);
-  rmm::device_uvector<MathT> mc_trainset_norm_buf(mesocluster_size_max, stream, device_memory);
-  auto mc_trainset_ids  = mc_trainset_ids_buf.data();
-  auto mc_trainset      = mc_trainset_buf.data();
-  auto mc_trainset_norm = mc_trainset_norm_buf.data();
-
-  // label (cluster ID) of each vector
-  rmm::device_uvector<LabelT> mc_trainset_labels(mesocluster_size_max, stream, device_memory);
-
-  rmm::device_uvector<MathT> mc_trainset_ccenters(
-    fine_clusters_nums_max * dim, stream, device_memory);
-  // number of vectors in each cluster
-  rmm::device_uvector<CounterT> mc_trainset_csizes_tmp(
-    fine_clusters_nums_max, stream, device_memory);
 
-  // Training clusters in each meso-cluster
-  IdxT n_clusters_done = 0;
+  // The ids of the training samples of all the mesoclusters, grouped by mesocluster, in a single
+  // pass over the labels.
+  std::vector<IdxT> mc_offsets(n_mesoclusters + 1, 0);
+  for (IdxT j = 0; j < n_rows; j++) {
+    auto& count = mc_offsets[labels_mptr[j] + 1];
+    if (count < mesocluster_size_max) { count++; }
+  }
   for (IdxT i = 0; i < n_mesoclusters; i++) {
-    IdxT k = 0;
-    for (IdxT j = 0; j < n_rows && k < mesocluster_size_max; j++) {
-      if (labels_mptr[j] == LabelT(i)) { mc_trainset_ids[k++] = j; }
-    }
+    IdxT k = mc_offsets[i + 1];
     if (k != static_cast<IdxT>(mesocluster_sizes[i]))
       RAFT_LOG_WARN("Incorrect mesocluster size at %d. %zu vs %zu",
                     static_cast<int>(i),
@@ -888,43 +1071,112 @@ auto build_fine_clusters(const raft::resources& handle,
       RAFT_EXPECTS(fine_clusters_nums[i] == 0,
                    "Number of fine clusters must be zero for the empty mesocluster (got %d)",
                    static_cast<int>(fine_clusters_nums[i]));
-      continue;
     } else {
       RAFT_EXPECTS(fine_clusters_nums[i] > 0,
                    "Number of fine clusters must be non-zero for a non-empty mesocluster");
     }
-
-    cub::TransformInputIterator<MathT, MappingOpT, const T*> mapping_itr(dataset_mptr, mapping_op);
-    raft::matrix::gather(mapping_itr, dim, n_rows, mc_trainset_ids, k, mc_trainset, stream);
-    if (params.metric == raft::distance::DistanceType::L2Expanded ||
-        params.metric == raft::distance::DistanceType::L2SqrtExpanded) {
-      thrust::gather(resource::get_thrust_policy(handle),
-                     mc_trainset_ids,
-                     mc_trainset_ids + k,
-                     dataset_norm_mptr,
-                     mc_trainset_norm);
+    mc_offsets[i + 1] += mc_offsets[i];
+  }
+  rmm::device_uvector<IdxT> mc_trainset_ids_buf(mc_offsets[n_mesoclusters], stream, managed_memory);
+  auto mc_trainset_ids = mc_trainset_ids_buf.data();
+  {
+    std::vector<IdxT> mc_fill(mc_offsets.begin(), mc_offsets.end() - 1);
+    resource::sync_stream(handle, stream);
+    for (IdxT j = 0; j < n_rows; j++) {
+      auto l = labels_mptr[j];
+      if (mc_fill[l] < mc_offsets[l + 1]) { mc_trainset_ids[mc_fill[l]++] = j; }
     }
+  }
 
-    build_clusters(handle,
-                   params,
-                   dim,
-                   mc_trainset,
-                   k,
-                   fine_clusters_nums[i],
-                   mc_trainset_ccenters.data(),
-                   mc_trainset_labels.data(),
-                   mc_trainset_csizes_tmp.data(),
-                   mapping_op,
-                   device_memory,
-                   mc_trainset_norm);
+  IdxT n_clusters_done = 0;
+  for (IdxT i = 0; i < n_mesoclusters; i++) {
+    if (mc_offsets[i + 1] > mc_offsets[i]) { n_clusters_done += fine_clusters_nums[i]; }
+  }
 
-    raft::copy(cluster_centers + (dim * fine_clusters_csum[i]),
-               mc_trainset_ccenters.data(),
-               fine_clusters_nums[i] * dim,
-               stream);
-    resource::sync_stream(handle, stream);
-    n_clusters_done += fine_clusters_nums[i];
+  // One worker (host thread and stream) per stream of the pool, or the main stream alone.
+  int n_workers =
+    std::max<int>(1, std::min<size_t>(resource::get_stream_pool_size(handle), n_mesoclusters));
+  if (n_workers > 1) { resource::wait_stream_pool_on_stream(handle); }
+  std::exception_ptr worker_error = nullptr;
+
+  // Training clusters in each meso-cluster
+#pragma omp parallel num_threads(n_workers)
+  {
+    int worker = n_workers > 1 ? omp_get_thread_num() : 0;
+    raft::resources worker_handle(handle);
+    if (n_workers > 1) {
+      // the stream-bound resources of the handle are not shared with the other workers
+      auto worker_stream = resource::get_stream_from_stream_pool(handle, worker);
+      resource::set_cuda_stream(worker_handle, worker_stream);
+      resource::set_cuda_stream_pool(worker_handle, nullptr);
+      worker_handle.add_resource_factory(
+        std::make_shared<resource::thrust_policy_resource_factory>(worker_stream));
+      worker_handle.add_resource_factory(
+        std::make_shared<resource::cublas_resource_factory>(worker_stream));
+    }
+    auto worker_stream = resource::get_cuda_stream(worker_handle);
+
+    rmm::device_uvector<MathT> mc_trainset_buf(0, worker_stream, device_memory);
+    rmm::device_uvector<MathT> mc_trainset_norm_buf(0, worker_stream, device_memory);
+    // label (cluster ID) of each vector
+    rmm::device_uvector<LabelT> mc_trainset_labels(0, worker_stream, device_memory);
+    rmm::device_uvector<MathT> mc_trainset_ccenters(0, worker_stream, device_memory);
+    // number of vectors in each cluster
+    rmm::device_uvector<CounterT> mc_trainset_csizes_tmp(0, worker_stream, device_memory);
+
+#pragma omp for schedule(dynamic)
+    for (IdxT i = 0; i < n_mesoclusters; i++) {
+      IdxT k = mc_offsets[i + 1] - mc_offsets[i];
+      if (k == 0) { continue; }
+      try {
+        if (mc_trainset_buf.size() == 0) {
+          mc_trainset_buf.resize(mesocluster_size_max * dim, worker_stream);
+          mc_trainset_norm_buf.resize(mesocluster_size_max, worker_stream);
+          mc_trainset_labels.resize(mesocluster_size_max, worker_stream);
+          mc_trainset_ccenters.resize(fine_clusters_nums_max * dim, worker_stream);
+          mc_trainset_csizes_tmp.resize(fine_clusters_nums_max, worker_stream);
+        }
+        auto mc_trainset      = mc_trainset_buf.data();
+        auto mc_trainset_norm = mc_trainset_norm_buf.data();
+        const IdxT* ids       = mc_trainset_ids + mc_offsets[i];
+
+        cub::TransformInputIterator<MathT, MappingOpT, const T*> mapping_itr(dataset_mptr,
+                                                                             mapping_op);
+        raft::matrix::gather(mapping_itr, dim, n_rows, ids, k, mc_trainset, worker_stream);
+        if (params.metric == raft::distance::DistanceType::L2Expanded ||
+            params.metric == raft::distance::DistanceType::L2SqrtExpanded) {
+          thrust::gather(resource::get_thrust_policy(worker_handle),
+                         ids,
+                         ids + k,
+                         dataset_norm_mptr,
+                         mc_trainset_norm);
+        }
+
+        build_clusters(worker_handle,
+                       params,
+                       dim,
+                       mc_trainset,
+                       k,
+                       fine_clusters_nums[i],
+                       mc_trainset_ccenters.data(),
+                       mc_trainset_labels.data(),
+                       mc_trainset_csizes_tmp.data(),
+                       mapping_op,
+                       device_memory,
+                       mc_trainset_norm);
+
+        raft::copy(cluster_centers + (dim * fine_clusters_csum[i]),
+                   mc_trainset_ccenters.data(),
+                   fine_clusters_nums[i] * dim,
+                   worker_stream);
+        resource::sync_stream(worker_handle, worker_stream);
+      } catch (...) {
+#pragma omp critical
+        if (!worker_error) { worker_error = std::current_exception(); }
+      }
+    }
   }
+  if (worker_error) { std::rethrow_exception(worker_error); }
   return n_clusters_done;
 }
 
@@ -971,7 +1223,7 @@ void build_hierarchical(const raft::resources& handle,
   rmm::mr::managed_memory_resource managed_memory;
   rmm::device_async_resource_ref device_memory = resource::get_workspace_resource(handle);
   auto [max_minibatch_size, mem_per_row] =
-    calc_minibatch_size<MathT>(n_clusters, n_rows, dim, params.metric, std::is_same_v<T, MathT>);
+    calc_minibatch_size<MathT>(n_clusters, n_rows, dim, params.metric);
 
   // Precompute the L2 norm of the dataset if relevant.
   const MathT* dataset_norm = nullptr;
@@ -986,8 +1238,7 @@ void build_hierarchical(const raft::resources& handle,
                    dataset + dim * offset,
                    dim,
                    minibatch_size,
-                   mapping_op,
-                   device_memory);
+                   mapping_op);
     }
     dataset_norm = (const MathT*)dataset_norm_buf.data();
   }
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/distance/pairwise_distance_reduce.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/reduction.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft::cluster::detail {
+
+/**
+ * The state of the bound-based (Hamerly) Lloyd iterations: for every sample, the label of its
+ * closest centroid, the distance to it (the upper bound of Hamerly), and a lower bound of the
+ * distance to all the other centroids.
+ */
+template <typename DataT, typename IndexT>
+struct kmeans_bounds {
+  rmm::device_uvector<IndexT> labels;
+  rmm::device_uvector<DataT> upper;
+  rmm::device_uvector<DataT> lower;
+
+  kmeans_bounds(IndexT n_samples, cudaStream_t stream)
+    : labels(n_samples, stream), upper(n_samples, stream), lower(n_samples, stream)
+  {
+  }
+};
+
+/**
+ * out[i] = ||x_i - c_{labels[i]}||, one warp per row; labels == nullptr stands for labels[i] = i.
+ */
+template <typename DataT, typename IndexT>
+RAFT_KERNEL assigned_distance_kernel(const DataT* x,
+                                     const DataT* centroids,
+                                     const IndexT* labels,
+                                     IndexT n_rows,
+                                     IndexT n_features,
+                                     DataT* out)
+{
+  IndexT row = (IndexT(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize;
+  int lane   = threadIdx.x % WarpSize;
+  if (row >= n_rows) { return; }
+  const DataT* x_row = x + size_t(row) * n_features;
+  const DataT* c_row = centroids + size_t(labels == nullptr ? row : labels[row]) * n_features;
+  DataT acc          = 0;
+  for (IndexT j = lane; j < n_features; j += WarpSize) {
+    DataT diff = x_row[j] - c_row[j];
+    acc += diff * diff;
+  }
+  acc = raft::warpReduce(acc);
+  if (lane == 0) { out[row] = raft::sqrt(acc); }
+}
+
+template <typename DataT, typename IndexT>
+void assigned_distance(raft::resources const& handle,
+                       const DataT* x,
+                       const DataT* centroids,
+                       const IndexT* labels,
+                       IndexT n_rows,
+                       IndexT n_features,
+                       DataT* out)
+{
+  if (n_rows == 0) { return; }
+  constexpr int kBlockSize = 256;
+  auto n_blocks            = raft::ceildiv<size_t>(size_t(n_rows) * WarpSize, kBlockSize);
+  assigned_distance_kernel<<<n_blocks, kBlockSize, 0, resource::get_cuda_stream(handle)>>>(
+    x, centroids, labels, n_rows, n_features, out);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * The assignment step of Hamerly's algorithm.
+ *
+ * With s(c) half the distance of the centroid c to its closest other centroid, a sample x whose
+ * distance u to its centroid satisfies u <= max(lower(x), s(label(x))) cannot be closer to another
+ * centroid, by the triangle inequality: it keeps its label. The other samples are reassigned, by
+ * batches of `params.batch_samples`, and get the distances to their two closest centroids as the
+ * new bounds. When `all_samples` is set (e.g. in the first iteration), all the samples are
+ * reassigned.
+ *
+ * On exit the labels are the closest centroids and bounds.upper their exact distances.
+ *
+ * @return the number of samples reassigned
+ */
+template <typename DataT, typename IndexT>
+IndexT bounded_assign(raft::resources const& handle,
+                      const KMeansParams& params,
+                      raft::device_matrix_view<const DataT, IndexT> X,
+                      raft::device_matrix_view<const DataT, IndexT> centroids,
+                      kmeans_bounds<DataT, IndexT>& bounds,
+                      bool all_samples,
+                      rmm::device_uvector<DataT>& L2NormBuf_OR_DistBuf,
+                      rmm::device_uvector<char>& workspace)
+{
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = centroids.extent(0);
+  IndexT* labels      = bounds.labels.data();
+  DataT* upper        = bounds.upper.data();
+  DataT* lower        = bounds.lower.data();
+
+  // half the distance of each centroid to its closest other centroid
+  auto half_gap       = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  DataT* half_gap_ptr = half_gap.data_handle();
+  thrust::fill(resource::get_thrust_policy(handle),
+               half_gap_ptr,
+               half_gap_ptr + n_clusters,
+               std::numeric_limits<DataT>::max());
+  raft::distance::pairwise_distance_reduce<raft::distance::DistanceType::L2SqrtExpanded>(
+    handle, centroids, centroids, [half_gap_ptr] __device__(IndexT row, IndexT col, DataT dist) {
+      if (row != col) { raft::myAtomicMin(half_gap_ptr + row, dist / 2); }
+    });
+
+  // the candidates to a reassignment
+  rmm::device_uvector<IndexT> candidates(n_samples, stream);
+  IndexT n_candidates = n_samples;
+  if (all_samples) {
+    thrust::copy(resource::get_thrust_policy(handle),
+                 thrust::make_counting_iterator<IndexT>(0),
+                 thrust::make_counting_iterator<IndexT>(n_samples),
+                 candidates.data());
+  } else {
+    assigned_distance<DataT, IndexT>(
+      handle, X.data_handle(), centroids.data_handle(), labels, n_samples, n_features, upper);
+    auto end = thrust::copy_if(resource::get_thrust_policy(handle),
+                               thrust::make_counting_iterator<IndexT>(0),
+                               thrust::make_counting_iterator<IndexT>(n_samples),
+                               candidates.data(),
+                               [labels, upper, lower, half_gap_ptr] __device__(IndexT i) {
+                                 return upper[i] > raft::max(lower[i], half_gap_ptr[labels[i]]);
+                               });
+    n_candidates = end - candidates.data();
+  }
+
+  auto batch_size = std::min<IndexT>(std::max(params.batch_samples, 1), n_samples);
+  auto batch      = raft::make_device_matrix<DataT, IndexT>(handle, batch_size, n_features);
+  auto batch_norm = raft::make_device_vector<DataT, IndexT>(handle, batch_size);
+  auto batch_min =
+    raft::make_device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT>(handle, batch_size);
+  auto batch_second = raft::make_device_vector<DataT, IndexT>(handle, batch_size);
+
+  for (IndexT offset = 0; offset < n_candidates; offset += batch_size) {
+    IndexT n_rows      = std::min<IndexT>(batch_size, n_candidates - offset);
+    const IndexT* rows = candidates.data() + offset;
+    raft::matrix::gather(
+      X.data_handle(), n_features, n_samples, rows, n_rows, batch.data_handle(), stream);
+    auto batch_view =
+      raft::make_device_matrix_view<const DataT, IndexT>(batch.data_handle(), n_rows, n_features);
+    raft::linalg::rowNorm(batch_norm.data_handle(),
+                          batch.data_handle(),
+                          n_features,
+                          n_rows,
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+
+    // the closest centroid
+    detail::minClusterAndDistanceCompute<DataT, IndexT>(
+      handle,
+      batch_view,
+      centroids,
+      raft::make_device_vector_view<raft::KeyValuePair<IndexT, DataT>, IndexT>(
+        batch_min.data_handle(), n_rows),
+      raft::make_device_vector_view<const DataT, IndexT>(batch_norm.data_handle(), n_rows),
+      L2NormBuf_OR_DistBuf,
+      raft::distance::DistanceType::L2Expanded,
+      params.batch_samples,
+      params.batch_centroids,
+      workspace);
+
+    // the second closest one
+    auto* min_ptr     = batch_min.data_handle();
+    DataT* second_ptr = batch_second.data_handle();
+    thrust::fill(resource::get_thrust_policy(handle),
+                 second_ptr,
+                 second_ptr + n_rows,
+                 std::numeric_limits<DataT>::max());
+    raft::distance::pairwise_distance_reduce<raft::distance::DistanceType::L2SqrtExpanded>(
+      handle,
+      batch_view,
+      centroids,
+      [min_ptr, second_ptr] __device__(IndexT row, IndexT col, DataT dist) {
+        if (col != min_ptr[row].key) { raft::myAtomicMin(second_ptr + row, dist); }
+      });
+
+    thrust::for_each_n(
+      resource::get_thrust_policy(handle),
+      thrust::make_counting_iterator<IndexT>(0),
+      n_rows,
+      [rows, min_ptr, second_ptr, labels, upper, lower] __device__(IndexT r) {
+        IndexT i  = rows[r];
+        labels[i] = min_ptr[r].key;
+        upper[i]  = raft::sqrt(raft::max(min_ptr[r].value, DataT(0)));
+        lower[i]  = second_ptr[r];
+      });
+  }
+  return n_candidates;
+}
+
+}  // namespace raft::cluster::detail
@@ -0,0 +1,731 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/detail/kmeans.cuh>
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/common/nvtx.hpp>
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map_then_reduce.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/reduce_cols_by_key.cuh>
+#include <raft/linalg/reduce_rows_by_key.cuh>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+#include <thrust/transform.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace raft::cluster::detail {
+
+// =========================================================
+// Helpers for the ranks of the communicator
+// =========================================================
+
+/** The number of local samples of every rank. */
+inline std::vector<int64_t> allgather_sizes(raft::resources const& handle, int64_t n_local)
+{
+  const auto& comm    = resource::get_comms(handle);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  rmm::device_scalar<int64_t> local(n_local, stream);
+  rmm::device_uvector<int64_t> all(comm.get_size(), stream);
+  comm.allgather(local.data(), all.data(), 1, stream);
+  std::vector<int64_t> sizes(comm.get_size());
+  raft::copy(sizes.data(), all.data(), sizes.size(), stream);
+  RAFT_EXPECTS(comm.sync_stream(stream) == comms::status_t::SUCCESS, "allgather failed");
+  return sizes;
+}
+
+/**
+ * Gather the rows of all the ranks, in the order of the ranks, into `all_rows`.
+ *
+ * @return the total number of rows
+ */
+template <typename DataT, typename IndexT>
+IndexT allgather_rows(raft::resources const& handle,
+                      const DataT* local_rows,
+                      IndexT n_local_rows,
+                      IndexT n_features,
+                      rmm::device_uvector<DataT>& all_rows)
+{
+  const auto& comm    = resource::get_comms(handle);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto sizes          = allgather_sizes(handle, n_local_rows);
+
+  std::vector<size_t> recv_counts(sizes.size());
+  std::vector<size_t> displs(sizes.size());
+  size_t n_total = 0;
+  for (size_t r = 0; r < sizes.size(); r++) {
+    recv_counts[r] = sizes[r] * n_features;
+    displs[r]      = n_total;
+    n_total += recv_counts[r];
+  }
+  all_rows.resize(n_total, stream);
+  comm.allgatherv(local_rows, all_rows.data(), recv_counts.data(), displs.data(), stream);
+  return static_cast<IndexT>(n_total / n_features);
+}
+
+/**
+ * Select `n_rows` distinct samples uniformly at random among the samples of all the ranks.
+ *
+ * The global ids are drawn on host from `seed`, which must be the same on every rank, so that all
+ * the ranks agree on them without communicating. Each rank collects its own rows, and the rows are
+ * then gathered on all the ranks into `rows`.
+ */
+template <typename DataT, typename IndexT>
+void sample_rows_mg(raft::resources const& handle,
+                    raft::device_matrix_view<const DataT, IndexT> X,
+                    const std::vector<int64_t>& rank_sizes,
+                    IndexT n_rows,
+                    uint64_t seed,
+                    rmm::device_uvector<DataT>& rows)
+{
+  const auto& comm    = resource::get_comms(handle);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_features     = X.extent(1);
+  int64_t n_global    = std::accumulate(rank_sizes.begin(), rank_sizes.end(), int64_t(0));
+  RAFT_EXPECTS(n_global >= n_rows, "invalid parameter (less samples than requested centroids)");
+
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int64_t> dis(0, n_global - 1);
+  std::set<int64_t> picked;
+  while (static_cast<IndexT>(picked.size()) < n_rows) {
+    picked.insert(dis(gen));
+  }
+
+  int64_t begin =
+    std::accumulate(rank_sizes.begin(), rank_sizes.begin() + comm.get_rank(), int64_t(0));
+  int64_t end = begin + rank_sizes[comm.get_rank()];
+  std::vector<IndexT> h_local_ids;
+  for (auto id : picked) {
+    if (id >= begin && id < end) { h_local_ids.push_back(static_cast<IndexT>(id - begin)); }
+  }
+
+  auto n_local = static_cast<IndexT>(h_local_ids.size());
+  rmm::device_uvector<IndexT> local_ids(n_local, stream);
+  rmm::device_uvector<DataT> local_rows(n_local * n_features, stream);
+  raft::copy(local_ids.data(), h_local_ids.data(), n_local, stream);
+  if (n_local > 0) {
+    raft::matrix::gather(X.data_handle(),
+                         n_features,
+                         X.extent(0),
+                         local_ids.data(),
+                         n_local,
+                         local_rows.data(),
+                         stream);
+  }
+  allgather_rows<DataT, IndexT>(handle, local_rows.data(), n_local, n_features, rows);
+}
+
+/** Scale the weights of all the ranks, so that they sum up to the global number of samples. */
+template <typename DataT, typename IndexT>
+void checkWeightMG(raft::resources const& handle,
+                   raft::device_vector_view<DataT, IndexT> weight,
+                   int64_t n_global,
+                   rmm::device_uvector<char>& workspace)
+{
+  const auto& comm    = resource::get_comms(handle);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto wt_aggr        = raft::make_device_scalar<DataT>(handle, 0);
+  auto n_samples      = weight.extent(0);
+
+  size_t temp_storage_bytes = 0;
+  RAFT_CUDA_TRY(cub::DeviceReduce::Sum(
+    nullptr, temp_storage_bytes, weight.data_handle(), wt_aggr.data_handle(), n_samples, stream));
+  workspace.resize(temp_storage_bytes, stream);
+  RAFT_CUDA_TRY(cub::DeviceReduce::Sum(workspace.data(),
+                                       temp_storage_bytes,
+                                       weight.data_handle(),
+                                       wt_aggr.data_handle(),
+                                       n_samples,
+                                       stream));
+  comm.allreduce(wt_aggr.data_handle(), wt_aggr.data_handle(), 1, comms::op_t::SUM, stream);
+  DataT wt_sum = 0;
+  raft::copy(&wt_sum, wt_aggr.data_handle(), 1, stream);
+  resource::sync_stream(handle, stream);
+
+  if (wt_sum != static_cast<DataT>(n_global)) {
+    RAFT_LOG_DEBUG(
+      "[Warning!] KMeans: normalizing the user provided sample weight to "
+      "sum up to %zu samples",
+      static_cast<size_t>(n_global));
+
+    auto scale = static_cast<DataT>(n_global) / wt_sum;
+    raft::linalg::unaryOp(weight.data_handle(),
+                          weight.data_handle(),
+                          n_samples,
+                          raft::mul_const_op<DataT>{scale},
+                          stream);
+  }
+}
+
+// =========================================================
+// Init functions
+// =========================================================
+
+/**
+ * Scalable k-means++ (k-means||) over the samples of all the ranks.
+ *
+ * This is initScalableKMeansPlusPlus, where the cluster costs are summed over the ranks, every rank
+ * samples the potential centroids among its own samples, and the sampled ones are gathered on all
+ * the ranks. The potential centroids are reclustered into n_clusters on the rank 0, and broadcast.
+ */
+template <typename DataT, typename IndexT>
+void initScalableKMeansPlusPlusMG(raft::resources const& handle,
+                                  const KMeansParams& params,
+                                  raft::device_matrix_view<const DataT, IndexT> X,
+                                  raft::device_matrix_view<DataT, IndexT> centroidsRawData,
+                                  rmm::device_uvector<char>& workspace)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("initScalableKMeansPlusPlusMG");
+  const auto& comm    = resource::get_comms(handle);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  auto metric         = params.metric;
+  auto rank_sizes     = allgather_sizes(handle, n_samples);
+
+  // the ranks sample independently
+  raft::random::RngState rng(params.rng_state.seed + comm.get_rank(), params.rng_state.type);
+
+  // <<<< Step-1 >>> : C <- sample a point uniformly at random from X
+  rmm::device_uvector<DataT> centroidsBuf(0, stream);
+  sample_rows_mg<DataT, IndexT>(handle, X, rank_sizes, 1, params.rng_state.seed, centroidsBuf);
+  auto potentialCentroids =
+    raft::make_device_matrix_view<DataT, IndexT>(centroidsBuf.data(), 1, n_features);
+
+  // device buffer to flag the samples that are chosen as potential centroids
+  auto isSampleCentroid = raft::make_device_vector<uint8_t, IndexT>(handle, n_samples);
+  thrust::fill(resource::get_thrust_policy(handle),
+               isSampleCentroid.data_handle(),
+               isSampleCentroid.data_handle() + isSampleCentroid.size(),
+               0);
+  // <<< End of Step-1 >>>
+
+  rmm::device_uvector<DataT> L2NormBuf_OR_DistBuf(0, stream);
+
+  // L2 norm of X: ||x||^2
+  auto L2NormX = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::rowNorm(L2NormX.data_handle(),
+                          X.data_handle(),
+                          X.extent(1),
+                          X.extent(0),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  auto minClusterDistanceVec = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  auto uniformRands          = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  rmm::device_scalar<DataT> clusterCost(stream);
+
+  // the cost phi_X(C) over the samples of all the ranks
+  auto global_cost = [&]() {
+    detail::minClusterDistanceCompute<DataT, IndexT>(handle,
+                                                     X,
+                                                     potentialCentroids,
+                                                     minClusterDistanceVec.view(),
+                                                     L2NormX.view(),
+                                                     L2NormBuf_OR_DistBuf,
+                                                     params.metric,
+                                                     params.batch_samples,
+                                                     params.batch_centroids,
+                                                     workspace);
+    detail::computeClusterCost(handle,
+                               minClusterDistanceVec.view(),
+                               workspace,
+                               raft::make_device_scalar_view(clusterCost.data()),
+                               raft::identity_op{},
+                               raft::add_op{});
+    comm.allreduce(clusterCost.data(), clusterCost.data(), 1, comms::op_t::SUM, stream);
+    return clusterCost.value(stream);
+  };
+
+  // <<< Step-2 >>>: psi <- phi_X (C)
+  auto psi = global_cost();
+  // <<< End of Step-2 >>>
+
+  // Scalable kmeans++ paper claims 8 rounds is sufficient
+  int niter = std::min(8, (int)ceil(log(psi)));
+  RAFT_LOG_DEBUG("KMeans||: psi = %g, log(psi) = %g, niter = %d ", psi, log(psi), niter);
+
+  // <<<< Step-3 >>> : for O( log(psi) ) times do
+  rmm::device_uvector<DataT> CpRaw(0, stream);
+  rmm::device_uvector<DataT> CpAll(0, stream);
+  for (int iter = 0; iter < niter; ++iter) {
+    RAFT_LOG_DEBUG("KMeans|| - Iteration %d: # potential centroids sampled - %d",
+                   iter,
+                   potentialCentroids.extent(0));
+
+    psi = global_cost();
+
+    // <<<< Step-4 >>> : Sample each point x in X independently and identify new
+    // potentialCentroids
+    raft::random::uniform(
+      handle, rng, uniformRands.data_handle(), uniformRands.extent(0), (DataT)0, (DataT)1);
+
+    detail::SamplingOp<DataT, IndexT> select_op(psi,
+                                                params.oversampling_factor,
+                                                n_clusters,
+                                                uniformRands.data_handle(),
+                                                isSampleCentroid.data_handle());
+
+    detail::sampleCentroids<DataT, IndexT>(handle,
+                                           X,
+                                           minClusterDistanceVec.view(),
+                                           isSampleCentroid.view(),
+                                           select_op,
+                                           CpRaw,
+                                           workspace);
+    IndexT n_sampled = allgather_rows<DataT, IndexT>(
+      handle, CpRaw.data(), CpRaw.size() / n_features, n_features, CpAll);
+    /// <<<< End of Step-4 >>>>
+
+    /// <<<< Step-5 >>> : C = C U C'
+    centroidsBuf.resize(centroidsBuf.size() + CpAll.size(), stream);
+    raft::copy(centroidsBuf.data() + centroidsBuf.size() - CpAll.size(),
+               CpAll.data(),
+               CpAll.size(),
+               stream);
+
+    IndexT tot_centroids = potentialCentroids.extent(0) + n_sampled;
+    potentialCentroids =
+      raft::make_device_matrix_view<DataT, IndexT>(centroidsBuf.data(), tot_centroids, n_features);
+    /// <<<< End of Step-5 >>>
+  }  /// <<<< Step-6 >>>
+
+  RAFT_LOG_DEBUG("KMeans||: total # potential centroids sampled - %d",
+                 potentialCentroids.extent(0));
+
+  if ((int)potentialCentroids.extent(0) > n_clusters) {
+    // <<< Step-7 >>>: For x in C, set w_x to be the number of pts closest to X
+    auto weight = raft::make_device_vector<DataT, IndexT>(handle, potentialCentroids.extent(0));
+
+    detail::countSamplesInCluster<DataT, IndexT>(
+      handle, params, X, L2NormX.view(), potentialCentroids, workspace, weight.view());
+    comm.allreduce(
+      weight.data_handle(), weight.data_handle(), weight.size(), comms::op_t::SUM, stream);
+    // <<< end of Step-7 >>>
+
+    // Step-8: Recluster the weighted points in C into k clusters; C is small, the rank 0 does it
+    // alone, so that all the ranks end up with exactly the same centroids.
+    if (comm.get_rank() == 0) {
+      detail::kmeansPlusPlus<DataT, IndexT>(
+        handle, params, potentialCentroids, centroidsRawData, workspace);
+
+      auto inertia = make_host_scalar<DataT>(0);
+      auto n_iter  = make_host_scalar<IndexT>(0);
+      KMeansParams default_params;
+      default_params.n_clusters = params.n_clusters;
+
+      detail::kmeans_fit_main<DataT, IndexT>(handle,
+                                             default_params,
+                                             potentialCentroids,
+                                             weight.view(),
+                                             centroidsRawData,
+                                             inertia.view(),
+                                             n_iter.view(),
+                                             workspace);
+    }
+    comm.bcast(centroidsRawData.data_handle(), centroidsRawData.size(), 0, stream);
+
+  } else if ((int)potentialCentroids.extent(0) < n_clusters) {
+    // supplement with random
+    auto n_random_clusters = n_clusters - potentialCentroids.extent(0);
+
+    RAFT_LOG_DEBUG(
+      "[Warning!] KMeans||: found fewer than %d centroids during "
+      "initialization (found %d centroids, remaining %d centroids will be "
+      "chosen randomly from input samples)",
+      n_clusters,
+      potentialCentroids.extent(0),
+      n_random_clusters);
+
+    rmm::device_uvector<DataT> randomCentroids(0, stream);
+    sample_rows_mg<DataT, IndexT>(handle,
+                                  X,
+                                  rank_sizes,
+                                  static_cast<IndexT>(n_random_clusters),
+                                  params.rng_state.seed + 1,
+                                  randomCentroids);
+    raft::copy(
+      centroidsRawData.data_handle(), randomCentroids.data(), randomCentroids.size(), stream);
+
+    // copy centroids generated during kmeans|| iteration to the buffer
+    raft::copy(centroidsRawData.data_handle() + n_random_clusters * n_features,
+               potentialCentroids.data_handle(),
+               potentialCentroids.size(),
+               stream);
+  } else {
+    // found the required n_clusters
+    raft::copy(centroidsRawData.data_handle(),
+               potentialCentroids.data_handle(),
+               potentialCentroids.size(),
+               stream);
+  }
+}
+
+// =========================================================
+// Distributed k-means
+// =========================================================
+
+/**
+ * The Lloyd iterations of kmeans_fit_main over the samples of all the ranks.
+ *
+ * Every rank assigns its own samples, and computes the weighted sums and the weights of the samples
+ * of each cluster. These partial results are summed over the ranks with an allreduce, after which
+ * all the ranks hold the same centroids, and take the same decisions.
+ */
+template <typename DataT, typename IndexT>
+void kmeans_fit_main_mg(raft::resources const& handle,
+                        const KMeansParams& params,
+                        raft::device_matrix_view<const DataT, IndexT> X,
+                        raft::device_vector_view<const DataT, IndexT> weight,
+                        raft::device_matrix_view<DataT, IndexT> centroidsRawData,
+                        raft::host_scalar_view<DataT> inertia,
+                        raft::host_scalar_view<IndexT> n_iter,
+                        rmm::device_uvector<char>& workspace)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_main_mg");
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+  const auto& comm    = resource::get_comms(handle);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  auto metric         = params.metric;
+
+  // the allreduces go on a stream of the pool if there is one, to overlap the computation
+  comms::collective_pipeline pipeline(comm, stream, resource::get_next_usable_stream(handle));
+
+  auto minClusterAndDistance =
+    raft::make_device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT>(handle, n_samples);
+  rmm::device_uvector<DataT> L2NormBuf_OR_DistBuf(0, stream);
+  auto newCentroids = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+  auto wtInCluster  = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  rmm::device_scalar<DataT> clusterCostD(stream);
+
+  // L2 norm of X: ||x||^2
+  auto L2NormX = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  auto l2normx_view =
+    raft::make_device_vector_view<const DataT, IndexT>(L2NormX.data_handle(), n_samples);
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::rowNorm(L2NormX.data_handle(),
+                          X.data_handle(),
+                          X.extent(1),
+                          X.extent(0),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  auto centroids = raft::make_device_matrix_view<const DataT, IndexT>(
+    centroidsRawData.data_handle(), n_clusters, n_features);
+
+  DataT priorClusteringCost = 0;
+  for (n_iter[0] = 1; n_iter[0] <= params.max_iter; ++n_iter[0]) {
+    RAFT_LOG_DEBUG("KMeans.fit_mg: Iteration-%d", n_iter[0]);
+
+    detail::minClusterAndDistanceCompute<DataT, IndexT>(handle,
+                                                        X,
+                                                        centroids,
+                                                        minClusterAndDistance.view(),
+                                                        l2normx_view,
+                                                        L2NormBuf_OR_DistBuf,
+                                                        params.metric,
+                                                        params.batch_samples,
+                                                        params.batch_centroids,
+                                                        workspace);
+
+    detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
+    cub::TransformInputIterator<IndexT,
+                                detail::KeyValueIndexOp<IndexT, DataT>,
+                                raft::KeyValuePair<IndexT, DataT>*>
+      itr(minClusterAndDistance.data_handle(), conversion_op);
+
+    // partial sums and weights of the local samples of each cluster, the allreduce of the sums
+    // overlapping the computation of the weights
+    workspace.resize(n_samples, stream);
+    raft::linalg::reduce_rows_by_key((DataT*)X.data_handle(),
+                                     X.extent(1),
+                                     itr,
+                                     weight.data_handle(),
+                                     workspace.data(),
+                                     X.extent(0),
+                                     X.extent(1),
+                                     (IndexT)n_clusters,
+                                     newCentroids.data_handle(),
+                                     stream);
+    pipeline.allreduce(newCentroids.data_handle(),
+                       newCentroids.data_handle(),
+                       newCentroids.size(),
+                       comms::op_t::SUM);
+    raft::linalg::reduce_cols_by_key(weight.data_handle(),
+                                     itr,
+                                     wtInCluster.data_handle(),
+                                     (IndexT)1,
+                                     (IndexT)n_samples,
+                                     (IndexT)n_clusters,
+                                     stream);
+    pipeline.allreduce(
+      wtInCluster.data_handle(), wtInCluster.data_handle(), wtInCluster.size(), comms::op_t::SUM);
+    pipeline.wait();
+
+    finalize_centroids<DataT, IndexT>(handle, centroids, wtInCluster.view(), newCentroids.view());
+
+    // the squared norm between the newCentroids and the original centroids
+    auto sqrdNorm = raft::make_device_scalar(handle, DataT(0));
+    raft::linalg::mapThenSumReduce(sqrdNorm.data_handle(),
+                                   newCentroids.size(),
+                                   raft::sqdiff_op{},
+                                   stream,
+                                   centroids.data_handle(),
+                                   newCentroids.data_handle());
+
+    DataT sqrdNormError = 0;
+    raft::copy(&sqrdNormError, sqrdNorm.data_handle(), sqrdNorm.size(), stream);
+
+    raft::copy(
+      centroidsRawData.data_handle(), newCentroids.data_handle(), newCentroids.size(), stream);
+
+    bool done = false;
+    if (params.inertia_check) {
+      // calculate cluster cost phi_x(C)
+      detail::computeClusterCost(handle,
+                                 minClusterAndDistance.view(),
+                                 workspace,
+                                 raft::make_device_scalar_view(clusterCostD.data()),
+                                 raft::value_op{},
+                                 raft::add_op{});
+      comm.allreduce(clusterCostD.data(), clusterCostD.data(), 1, comms::op_t::SUM, stream);
+
+      DataT curClusteringCost = clusterCostD.value(stream);
+
+      ASSERT(curClusteringCost != (DataT)0.0,
+             "Too few points and centroids being found is getting 0 cost from "
+             "centers");
+
+      if (n_iter[0] > 1) {
+        DataT delta = curClusteringCost / priorClusteringCost;
+        if (delta > 1 - params.tol) done = true;
+      }
+      priorClusteringCost = curClusteringCost;
+    }
+
+    resource::sync_stream(handle, stream);
+    if (sqrdNormError < params.tol) done = true;
+
+    if (done) {
+      RAFT_LOG_DEBUG("Threshold triggered after %d iterations. Terminating early.", n_iter[0]);
+      break;
+    }
+  }
+
+  detail::minClusterAndDistanceCompute<DataT, IndexT>(handle,
+                                                      X,
+                                                      centroids,
+                                                      minClusterAndDistance.view(),
+                                                      l2normx_view,
+                                                      L2NormBuf_OR_DistBuf,
+                                                      params.metric,
+                                                      params.batch_samples,
+                                                      params.batch_centroids,
+                                                      workspace);
+
+  thrust::transform(resource::get_thrust_policy(handle),
+                    minClusterAndDistance.data_handle(),
+                    minClusterAndDistance.data_handle() + minClusterAndDistance.size(),
+                    weight.data_handle(),
+                    minClusterAndDistance.data_handle(),
+                    [=] __device__(const raft::KeyValuePair<IndexT, DataT> kvp, DataT wt) {
+                      raft::KeyValuePair<IndexT, DataT> res;
+                      res.value = kvp.value * wt;
+                      res.key   = kvp.key;
+                      return res;
+                    });
+
+  // calculate cluster cost phi_x(C) over all the ranks
+  detail::computeClusterCost(handle,
+                             minClusterAndDistance.view(),
+                             workspace,
+                             raft::make_device_scalar_view(clusterCostD.data()),
+                             raft::value_op{},
+                             raft::add_op{});
+  comm.allreduce(clusterCostD.data(), clusterCostD.data(), 1, comms::op_t::SUM, stream);
+
+  inertia[0] = clusterCostD.value(stream);
+
+  RAFT_LOG_DEBUG("KMeans.fit_mg: completed after %d iterations with %f inertia[0] ",
+                 n_iter[0] > params.max_iter ? n_iter[0] - 1 : n_iter[0],
+                 inertia[0]);
+}
+
+/**
+ * See raft::cluster::kmeans::fit_mg for docs.
+ */
+template <typename DataT, typename IndexT>
+void kmeans_fit_mg(raft::resources const& handle,
+                   const KMeansParams& params,
+                   raft::device_matrix_view<const DataT, IndexT> X,
+                   std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+                   raft::device_matrix_view<DataT, IndexT> centroids,
+                   raft::host_scalar_view<DataT> inertia,
+                   raft::host_scalar_view<IndexT> n_iter)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_mg");
+  RAFT_EXPECTS(resource::comms_initialized(handle),
+               "kmeans_fit_mg requires a handle with an initialized communicator");
+  const auto& comm    = resource::get_comms(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  if (sample_weight.has_value())
+    RAFT_EXPECTS(sample_weight.value().extent(0) == n_samples,
+                 "invalid parameter (sample_weight!=n_samples)");
+  RAFT_EXPECTS(n_clusters > 0, "invalid parameter (n_clusters<=0)");
+  RAFT_EXPECTS(params.tol > 0, "invalid parameter (tol<=0)");
+  RAFT_EXPECTS(params.init != KMeansParams::InitMethod::KMeansPlusPlus ||
+                 params.oversampling_factor > 0,
+               "invalid parameter (oversampling_factor<=0), the distributed k-means++ "
+               "initialization is k-means||");
+  RAFT_EXPECTS((int)centroids.extent(0) == params.n_clusters,
+               "invalid parameter (centroids.extent(0) != n_clusters)");
+  RAFT_EXPECTS(centroids.extent(1) == n_features,
+               "invalid parameter (centroids.extent(1) != n_features)");
+
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+
+  auto rank_sizes  = allgather_sizes(handle, n_samples);
+  int64_t n_global = std::accumulate(rank_sizes.begin(), rank_sizes.end(), int64_t(0));
+  RAFT_EXPECTS(n_global >= n_clusters, "invalid parameter (less samples than n_clusters)");
+
+  rmm::device_uvector<char> workspace(0, stream);
+  auto weight = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  if (sample_weight.has_value())
+    raft::copy(weight.data_handle(), sample_weight.value().data_handle(), n_samples, stream);
+  else
+    thrust::fill(resource::get_thrust_policy(handle),
+                 weight.data_handle(),
+                 weight.data_handle() + weight.size(),
+                 1);
+  checkWeightMG<DataT, IndexT>(handle, weight.view(), n_global, workspace);
+
+  auto centroidsRawData = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+
+  auto n_init = params.n_init;
+  if (params.init == KMeansParams::InitMethod::Array && n_init != 1) {
+    RAFT_LOG_DEBUG(
+      "Explicit initial center position passed: performing only one init in "
+      "k-means instead of n_init=%d",
+      n_init);
+    n_init = 1;
+  }
+
+  // The seeds are the same on all the ranks
+  std::mt19937 gen(params.rng_state.seed);
+  inertia[0] = std::numeric_limits<DataT>::max();
+
+  for (auto seed_iter = 0; seed_iter < n_init; ++seed_iter) {
+    KMeansParams iter_params   = params;
+    iter_params.rng_state.seed = gen();
+
+    DataT iter_inertia    = std::numeric_limits<DataT>::max();
+    IndexT n_current_iter = 0;
+    if (iter_params.init == KMeansParams::InitMethod::Random) {
+      RAFT_LOG_DEBUG(
+        "KMeans.fit_mg (Iteration-%d/%d): initialize cluster centers by randomly choosing from "
+        "the input data.",
+        seed_iter + 1,
+        n_init);
+      rmm::device_uvector<DataT> rows(0, stream);
+      sample_rows_mg<DataT, IndexT>(
+        handle, X, rank_sizes, n_clusters, iter_params.rng_state.seed, rows);
+      raft::copy(centroidsRawData.data_handle(), rows.data(), rows.size(), stream);
+    } else if (iter_params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+      RAFT_LOG_DEBUG(
+        "KMeans.fit_mg (Iteration-%d/%d): initialize cluster centers using k-means|| algorithm.",
+        seed_iter + 1,
+        n_init);
+      initScalableKMeansPlusPlusMG<DataT, IndexT>(
+        handle, iter_params, X, centroidsRawData.view(), workspace);
+    } else if (iter_params.init == KMeansParams::InitMethod::Array) {
+      RAFT_LOG_DEBUG(
+        "KMeans.fit_mg (Iteration-%d/%d): initialize cluster centers from the ndarray array "
+        "input passed to init argument (broadcast from the rank 0).",
+        seed_iter + 1,
+        n_init);
+      raft::copy(
+        centroidsRawData.data_handle(), centroids.data_handle(), n_clusters * n_features, stream);
+      comm.bcast(centroidsRawData.data_handle(), centroidsRawData.size(), 0, stream);
+    } else {
+      THROW("unknown initialization method to select initial centers");
+    }
+
+    detail::kmeans_fit_main_mg<DataT, IndexT>(handle,
+                                              iter_params,
+                                              X,
+                                              raft::make_const_mdspan(weight.view()),
+                                              centroidsRawData.view(),
+                                              raft::make_host_scalar_view<DataT>(&iter_inertia),
+                                              raft::make_host_scalar_view<IndexT>(&n_current_iter),
+                                              workspace);
+    if (iter_inertia < inertia[0]) {
+      inertia[0] = iter_inertia;
+      n_iter[0]  = n_current_iter;
+      raft::copy(
+        centroids.data_handle(), centroidsRawData.data_handle(), n_clusters * n_features, stream);
+    }
+    RAFT_LOG_DEBUG("KMeans.fit_mg after iteration-%d/%d: inertia - %f, n_iter[0] - %d",
+                   seed_iter + 1,
+                   n_init,
+                   inertia[0],
+                   n_iter[0]);
+  }
+  resource::sync_stream(handle, stream);
+}
+
+}  // namespace raft::cluster::detail
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/detail/kmeans.cuh>
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/common/nvtx.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/map_then_reduce.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/reduce_cols_by_key.cuh>
+#include <raft/linalg/reduce_rows_by_key.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace raft::cluster::detail {
+
+/**
+ * One step of the mini-batch k-means of Sculley (2010), "Web-scale k-means clustering".
+ *
+ * Every sample x assigned to the center c moves it with the per-center learning rate
+ * 1 / counts[c], c <- (1 - 1 / counts[c]) c + x / counts[c], so that a center is the running mean
+ * of all the samples it has been assigned. Since the assignments of a batch are computed
+ * beforehand, the sequential updates of a center amount to
+ *   c <- (counts[c] c + sum of its batch samples) / (counts[c] + its batch count),
+ * which is what this step computes for all the centers at once.
+ */
+template <typename DataT, typename IndexT>
+void minibatch_step(raft::resources const& handle,
+                    const KMeansParams& params,
+                    raft::device_matrix_view<const DataT, IndexT> batch,
+                    raft::device_matrix_view<DataT, IndexT> centroids,
+                    raft::device_vector_view<DataT, IndexT> counts,
+                    rmm::device_uvector<DataT>& batch_weights,
+                    rmm::device_uvector<DataT>& batch_norms,
+                    rmm::device_uvector<raft::KeyValuePair<IndexT, DataT>>& min_cluster_and_dist,
+                    rmm::device_uvector<DataT>& batch_sums,
+                    rmm::device_uvector<DataT>& batch_counts,
+                    rmm::device_uvector<DataT>& L2NormBuf_OR_DistBuf,
+                    rmm::device_scalar<DataT>& batch_cost,
+                    rmm::device_uvector<char>& workspace)
+{
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = batch.extent(0);
+  auto n_features     = batch.extent(1);
+  auto n_clusters     = centroids.extent(0);
+
+  if (batch_weights.size() < static_cast<size_t>(n_samples)) {
+    batch_weights.resize(n_samples, stream);
+    thrust::fill(resource::get_thrust_policy(handle),
+                 batch_weights.data(),
+                 batch_weights.data() + batch_weights.size(),
+                 1);
+  }
+  batch_norms.resize(n_samples, stream);
+  min_cluster_and_dist.resize(n_samples, stream);
+
+  if (params.metric == raft::distance::DistanceType::L2Expanded ||
+      params.metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::rowNorm(batch_norms.data(),
+                          batch.data_handle(),
+                          n_features,
+                          n_samples,
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  auto min_cluster_and_dist_view =
+    raft::make_device_vector_view<raft::KeyValuePair<IndexT, DataT>, IndexT>(
+      min_cluster_and_dist.data(), n_samples);
+  detail::minClusterAndDistanceCompute<DataT, IndexT>(
+    handle,
+    batch,
+    raft::make_device_matrix_view<const DataT, IndexT>(
+      centroids.data_handle(), n_clusters, n_features),
+    min_cluster_and_dist_view,
+    raft::make_device_vector_view<const DataT, IndexT>(batch_norms.data(), n_samples),
+    L2NormBuf_OR_DistBuf,
+    params.metric,
+    params.batch_samples,
+    params.batch_centroids,
+    workspace);
+
+  detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
+  cub::TransformInputIterator<IndexT,
+                              detail::KeyValueIndexOp<IndexT, DataT>,
+                              raft::KeyValuePair<IndexT, DataT>*>
+    labels(min_cluster_and_dist.data(), conversion_op);
+
+  // the sum and the number of the batch samples assigned to each center
+  workspace.resize(n_samples, stream);
+  raft::linalg::reduce_rows_by_key(batch.data_handle(),
+                                   n_features,
+                                   labels,
+                                   batch_weights.data(),
+                                   workspace.data(),
+                                   n_samples,
+                                   n_features,
+                                   n_clusters,
+                                   batch_sums.data(),
+                                   stream);
+  raft::linalg::reduce_cols_by_key(batch_weights.data(),
+                                   labels,
+                                   batch_counts.data(),
+                                   (IndexT)1,
+                                   n_samples,
+                                   n_clusters,
+                                   stream);
+
+  // the centers without samples in this batch are left unchanged
+  const DataT* sums_ptr   = batch_sums.data();
+  const DataT* bcount_ptr = batch_counts.data();
+  const DataT* count_ptr  = counts.data_handle();
+  const DataT* c_ptr      = centroids.data_handle();
+  raft::linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<DataT, IndexT>(centroids.data_handle(), centroids.size()),
+    [sums_ptr, bcount_ptr, count_ptr, c_ptr, n_features] __device__(IndexT i) {
+      IndexT c      = i / n_features;
+      DataT n_batch = bcount_ptr[c];
+      if (n_batch == DataT(0)) { return c_ptr[i]; }
+      return (count_ptr[c] * c_ptr[i] + sums_ptr[i]) / (count_ptr[c] + n_batch);
+    });
+  raft::linalg::map(handle,
+                    counts,
+                    raft::add_op{},
+                    raft::make_const_mdspan(counts),
+                    raft::make_device_vector_view<const DataT, IndexT>(bcount_ptr, n_clusters));
+
+  detail::computeClusterCost(handle,
+                             min_cluster_and_dist_view,
+                             workspace,
+                             raft::make_device_scalar_view(batch_cost.data()),
+                             raft::value_op{},
+                             raft::add_op{});
+}
+
+/**
+ * See raft::cluster::kmeans::fit_minibatch for docs.
+ */
+template <typename DataT, typename IndexT, typename BatchIterator>
+void kmeans_fit_minibatch(raft::resources const& handle,
+                          const KMeansParams& params,
+                          BatchIterator first,
+                          BatchIterator last,
+                          raft::device_matrix_view<DataT, IndexT> centroids,
+                          raft::host_scalar_view<DataT> inertia,
+                          raft::host_scalar_view<IndexT> n_iter)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_minibatch");
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_clusters     = params.n_clusters;
+  auto n_features     = centroids.extent(1);
+  RAFT_EXPECTS(first != last, "invalid parameter (no batches to fit)");
+  RAFT_EXPECTS(n_clusters > 0, "invalid parameter (n_clusters<=0)");
+  RAFT_EXPECTS(params.tol > 0, "invalid parameter (tol<=0)");
+  RAFT_EXPECTS((int)centroids.extent(0) == params.n_clusters,
+               "invalid parameter (centroids.extent(0) != n_clusters)");
+
+  rmm::device_uvector<DataT> batch_data(0, stream);
+  // Copy a host batch to the device; the stream is synchronized, so that the iterator is free to
+  // reuse the host memory of the batch once it is advanced.
+  auto load_batch = [&](raft::host_matrix_view<const DataT, IndexT> host_batch) {
+    RAFT_EXPECTS(host_batch.extent(1) == n_features,
+                 "invalid parameter (batch.extent(1) != centroids.extent(1))");
+    batch_data.resize(host_batch.size(), stream);
+    raft::copy(batch_data.data(), host_batch.data_handle(), host_batch.size(), stream);
+    resource::sync_stream(handle, stream);
+    return raft::make_device_matrix_view<const DataT, IndexT>(
+      batch_data.data(), host_batch.extent(0), n_features);
+  };
+
+  rmm::device_uvector<char> workspace(0, stream);
+  if (params.init == KMeansParams::InitMethod::Array) {
+    RAFT_LOG_DEBUG("KMeans.fit_minibatch: initialize cluster centers from the input array.");
+  } else {
+    // the centers are initialized from the first batch
+    auto batch = load_batch(*first);
+    RAFT_EXPECTS(batch.extent(0) >= n_clusters,
+                 "invalid parameter (the first batch has less rows than n_clusters)");
+    if (params.init == KMeansParams::InitMethod::Random) {
+      RAFT_LOG_DEBUG("KMeans.fit_minibatch: initialize cluster centers from random samples.");
+      initRandom<DataT, IndexT>(handle, params, batch, centroids);
+    } else if (params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+      RAFT_LOG_DEBUG("KMeans.fit_minibatch: initialize cluster centers using k-means++.");
+      if (params.oversampling_factor == 0)
+        detail::kmeansPlusPlus<DataT, IndexT>(handle, params, batch, centroids, workspace);
+      else
+        detail::initScalableKMeansPlusPlus<DataT, IndexT>(
+          handle, params, batch, centroids, workspace);
+    } else {
+      THROW("unknown initialization method to select initial centers");
+    }
+  }
+
+  // the number of samples assigned to each center so far
+  auto counts = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  thrust::fill(resource::get_thrust_policy(handle),
+               counts.data_handle(),
+               counts.data_handle() + counts.size(),
+               0);
+  auto prev_centroids = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+
+  rmm::device_uvector<DataT> batch_weights(0, stream);
+  rmm::device_uvector<DataT> batch_norms(0, stream);
+  rmm::device_uvector<raft::KeyValuePair<IndexT, DataT>> min_cluster_and_dist(0, stream);
+  rmm::device_uvector<DataT> batch_sums(n_clusters * n_features, stream);
+  rmm::device_uvector<DataT> batch_counts(n_clusters, stream);
+  rmm::device_uvector<DataT> L2NormBuf_OR_DistBuf(0, stream);
+  rmm::device_scalar<DataT> batch_cost(stream);
+
+  for (n_iter[0] = 1; n_iter[0] <= params.max_iter; ++n_iter[0]) {
+    raft::copy(prev_centroids.data_handle(), centroids.data_handle(), centroids.size(), stream);
+
+    // Each pass visits all the batches once; the cost of a batch is measured with the centers
+    // it is assigned to, before its own update.
+    inertia[0] = 0;
+    for (auto it = first; it != last; ++it) {
+      auto batch = load_batch(*it);
+      if (batch.extent(0) == 0) { continue; }
+      minibatch_step<DataT, IndexT>(handle,
+                                    params,
+                                    batch,
+                                    centroids,
+                                    counts.view(),
+                                    batch_weights,
+                                    batch_norms,
+                                    min_cluster_and_dist,
+                                    batch_sums,
+                                    batch_counts,
+                                    L2NormBuf_OR_DistBuf,
+                                    batch_cost,
+                                    workspace);
+      inertia[0] += batch_cost.value(stream);
+    }
+
+    auto sqrd_norm = raft::make_device_scalar(handle, DataT(0));
+    raft::linalg::mapThenSumReduce(sqrd_norm.data_handle(),
+                                   centroids.size(),
+                                   raft::sqdiff_op{},
+                                   stream,
+                                   prev_centroids.data_handle(),
+                                   centroids.data_handle());
+    DataT sqrd_norm_error = 0;
+    raft::copy(&sqrd_norm_error, sqrd_norm.data_handle(), 1, stream);
+    resource::sync_stream(handle, stream);
+
+    RAFT_LOG_DEBUG("KMeans.fit_minibatch: pass-%d, inertia %f, center shift %f",
+                   n_iter[0],
+                   inertia[0],
+                   sqrd_norm_error);
+    if (sqrd_norm_error < params.tol) { break; }
+  }
+  if (n_iter[0] > params.max_iter) { n_iter[0] = params.max_iter; }
+}
+
+/**
+ * See raft::cluster::kmeans::fit_minibatch for docs (the overload taking a host matrix).
+ */
+template <typename DataT, typename IndexT>
+void kmeans_fit_minibatch(raft::resources const& handle,
+                          const KMeansParams& params,
+                          raft::host_matrix_view<const DataT, IndexT> X,
+                          raft::device_matrix_view<DataT, IndexT> centroids,
+                          raft::host_scalar_view<DataT> inertia,
+                          raft::host_scalar_view<IndexT> n_iter)
+{
+  RAFT_EXPECTS(params.batch_samples > 0, "invalid parameter (batch_samples<=0)");
+  auto n_samples  = X.extent(0);
+  auto n_features = X.extent(1);
+  std::vector<raft::host_matrix_view<const DataT, IndexT>> batches;
+  for (IndexT offset = 0; offset < n_samples; offset += params.batch_samples) {
+    auto rows = std::min<IndexT>(params.batch_samples, n_samples - offset);
+    batches.push_back(raft::make_host_matrix_view<const DataT, IndexT>(
+      X.data_handle() + size_t(offset) * n_features, rows, n_features));
+  }
+  kmeans_fit_minibatch<DataT, IndexT>(
+    handle, params, batches.begin(), batches.end(), centroids, inertia, n_iter);
+}
+
+}  // namespace raft::cluster::detail
@@ -107,14 +107,14 @@ void single_linkage(raft::resources const& handle,
   rmm::device_uvector<value_t> out_delta(n_edges, stream);
   rmm::device_uvector<value_idx> out_size(n_edges, stream);
   // Create dendrogram
-  detail::build_dendrogram_host<value_idx, value_t>(handle,
-                                                    mst_rows.data(),
-                                                    mst_cols.data(),
-                                                    mst_data.data(),
-                                                    n_edges,
-                                                    out->children,
-                                                    out_delta.data(),
-                                                    out_size.data());
+  detail::build_dendrogram_device<value_idx, value_t>(handle,
+                                                      mst_rows.data(),
+                                                      mst_cols.data(),
+                                                      mst_data.data(),
+                                                      n_edges,
+                                                      out->children,
+                                                      out_delta.data(),
+                                                      out_size.data());
   detail::extract_flattened_clusters(handle, out->labels, out->children, n_clusters, m);
 
   out->m                      = m;
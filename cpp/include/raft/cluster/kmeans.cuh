@@ -17,6 +17,7 @@
 
 #include <raft/cluster/detail/kmeans.cuh>
 #include <raft/cluster/detail/kmeans_auto_find_k.cuh>
+#include <raft/cluster/detail/kmeans_minibatch.cuh>
 #include <raft/cluster/kmeans_types.hpp>
 #include <raft/core/kvp.hpp>
 #include <raft/core/mdarray.hpp>
@@ -98,6 +99,107 @@ template <typename DataT, typename IndexT>
   detail::kmeans_fit<DataT, IndexT>(handle, params, X, sample_weight, centroids, inertia, n_iter);
 }
 
+/**
+ * @brief Find clusters with the mini-batch k-means algorithm, streaming the data from the host.
+ *
+ * Unlike `fit`, which runs full-batch Lloyd iterations, every batch of samples moves the centers
+ * it is assigned to with a per-center learning rate (Sculley, 2010, "Web-scale k-means
+ * clustering"), so that a center is the running mean of all the samples assigned to it so far.
+ * Only one batch lives on the device at a time, and a single pass over the data gives
+ * approximate centers of a dataset that does not fit in device memory. The batches should be in
+ * random order.
+ *
+ * Unless init is InitMethod::Array, the centers are initialized from the first batch, which must
+ * have at least n_clusters rows. Each iteration is a pass over all the batches; the fit stops
+ * after params.max_iter passes, or when the squared shift of the centers over a pass is below
+ * params.tol.
+ *
+ * @code{.cpp}
+ *   #include <raft/core/resources.hpp>
+ *   #include <raft/cluster/kmeans.cuh>
+ *   using namespace raft::cluster;
+ *   ...
+ *   raft::resources handle;
+ *   raft::cluster::KMeansParams params;
+ *   params.max_iter = 1;
+ *   // any iterator over raft::host_matrix_view<const float, int64_t> batches, e.g. read from files
+ *   std::vector<raft::host_matrix_view<const float, int64_t>> batches = ...;
+ *   auto centroids = raft::make_device_matrix<float, int64_t>(handle, params.n_clusters, dim);
+ *   float inertia;
+ *   int64_t n_iter;
+ *   kmeans::fit_minibatch(handle,
+ *                         params,
+ *                         batches.begin(),
+ *                         batches.end(),
+ *                         centroids.view(),
+ *                         raft::make_host_scalar_view(&inertia),
+ *                         raft::make_host_scalar_view(&n_iter));
+ * @endcode
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @tparam BatchIterator a forward iterator whose value converts to
+ *                       raft::host_matrix_view<const DataT, IndexT>; the host memory of a batch
+ *                       is only read before the iterator is advanced
+ * @param[in]     handle    The raft handle.
+ * @param[in]     params    Parameters for KMeans model.
+ *                          The sample weights are not supported, all the samples weigh 1.
+ * @param[in]     first     Iterator to the first batch of samples, in row-major format.
+ *                          [dim = batch_size x n_features]
+ * @param[in]     last      Iterator past the last batch of samples.
+ * @param[inout]  centroids [in] When init is InitMethod::Array, use
+ *                          centroids as the initial cluster centers.
+ *                          [out] The generated centroids.
+ *                          [dim = n_clusters x n_features]
+ * @param[out]    inertia   Sum of squared distances of the samples of the last pass to their
+ *                          closest cluster center, each measured before the update of its batch.
+ * @param[out]    n_iter    Number of passes run.
+ */
+template <typename DataT, typename IndexT, typename BatchIterator>
+void fit_minibatch(raft::resources const& handle,
+                   const KMeansParams& params,
+                   BatchIterator first,
+                   BatchIterator last,
+                   raft::device_matrix_view<DataT, IndexT> centroids,
+                   raft::host_scalar_view<DataT> inertia,
+                   raft::host_scalar_view<IndexT> n_iter)
+{
+  detail::kmeans_fit_minibatch<DataT, IndexT>(
+    handle, params, first, last, centroids, inertia, n_iter);
+}
+
+/**
+ * @brief Find clusters with the mini-batch k-means algorithm, streaming a host matrix to the device
+ *   in batches of params.batch_samples rows.
+ *
+ * See the iterator overload of `fit_minibatch` for the details.
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @param[in]     handle    The raft handle.
+ * @param[in]     params    Parameters for KMeans model.
+ * @param[in]     X         Host training instances to cluster, in row-major format, in random
+ *                          order.
+ *                          [dim = n_samples x n_features]
+ * @param[inout]  centroids [in] When init is InitMethod::Array, use
+ *                          centroids as the initial cluster centers.
+ *                          [out] The generated centroids.
+ *                          [dim = n_clusters x n_features]
+ * @param[out]    inertia   Sum of squared distances of the samples of the last pass to their
+ *                          closest cluster center, each measured before the update of its batch.
+ * @param[out]    n_iter    Number of passes run.
+ */
+template <typename DataT, typename IndexT>
+void fit_minibatch(raft::resources const& handle,
+                   const KMeansParams& params,
+                   raft::host_matrix_view<const DataT, IndexT> X,
+                   raft::device_matrix_view<DataT, IndexT> centroids,
+                   raft::host_scalar_view<DataT> inertia,
+                   raft::host_scalar_view<IndexT> n_iter)
+{
+  detail::kmeans_fit_minibatch<DataT, IndexT>(handle, params, X, centroids, inertia, n_iter);
+}
+
 /**
  * @brief Predict the closest cluster each sample in X belongs to.
  *
@@ -271,6 +373,10 @@ template <typename DataT, typename IndexT>
  * Automatically find the optimal value of k using a binary search.
  * This method maximizes the Calinski-Harabasz Index while minimizing the per-cluster inertia.
  *
+ * Each candidate k is fit once. When the handle has a stream pool, the candidates the search may
+ * probe next are fit ahead, concurrently on the streams of the pool, and stopped early when the
+ * search moves away from them; each concurrent fit needs its own temporary memory.
+ *
  *  @code{.cpp}
  *   #include <raft/core/handle.hpp>
  *   #include <raft/cluster/kmeans.cuh>
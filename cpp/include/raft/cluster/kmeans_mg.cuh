@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/detail/kmeans_mg.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+
+#include <optional>
+
+namespace raft::cluster::kmeans {
+
+/**
+ * @brief Find clusters with the k-means algorithm over the samples of all the ranks of a
+ *   communicator (multi-node multi-GPU).
+ *
+ * Every rank holds a partition of the training data, and calls this function collectively with
+ * the same parameters. In each iteration the ranks assign their own samples, and sum their partial
+ * cluster sums and weights with an allreduce of size n_clusters x n_features, so that the data
+ * never leaves its rank. On exit all the ranks hold the same centroids.
+ *
+ * The centroids are initialized with the k-means|| algorithm (InitMethod::KMeansPlusPlus, which
+ * requires oversampling_factor > 0): the ranks sample the potential centroids in parallel, which
+ * are gathered and reclustered on the rank 0. InitMethod::Random draws the samples uniformly among
+ * all the ranks, and InitMethod::Array uses the centroids of the rank 0.
+ *
+ * @code{.cpp}
+ *   #include <raft/cluster/kmeans_mg.cuh>
+ *   #include <raft/comms/std_comms.hpp>
+ *   using namespace raft::cluster;
+ *   ...
+ *   raft::resources handle;
+ *   raft::comms::build_comms_nccl_only(&handle, nccl_comm, n_ranks, rank);
+ *   raft::cluster::KMeansParams params;
+ *   // the local partition of the training data
+ *   auto X = raft::make_device_matrix<float, int>(handle, n_local_samples, n_features);
+ *   auto centroids = raft::make_device_matrix<float, int>(handle, params.n_clusters, n_features);
+ *   float inertia;
+ *   int n_iter;
+ *   kmeans::fit_mg(handle,
+ *                  params,
+ *                  raft::make_const_mdspan(X.view()),
+ *                  std::nullopt,
+ *                  centroids.view(),
+ *                  raft::make_host_scalar_view(&inertia),
+ *                  raft::make_host_scalar_view(&n_iter));
+ * @endcode
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @param[in]     handle        The raft handle, with an initialized communicator.
+ * @param[in]     params        Parameters for KMeans model, the same on all the ranks.
+ * @param[in]     X             The local training instances to cluster. The data must
+ *                              be in row-major format.
+ *                              [dim = n_local_samples x n_features]
+ * @param[in]     sample_weight Optional weights for each local observation in X.
+ *                              [len = n_local_samples]
+ * @param[inout]  centroids     [in] When init is InitMethod::Array, use the
+ *                              centroids of the rank 0 as the initial cluster centers.
+ *                              [out] The generated centroids, the same on all the ranks.
+ *                              [dim = n_clusters x n_features]
+ * @param[out]    inertia       Sum of squared distances of the samples of all the ranks to
+ *                              their closest cluster center.
+ * @param[out]    n_iter        Number of iterations run.
+ */
+template <typename DataT, typename IndexT>
+void fit_mg(raft::resources const& handle,
+            const KMeansParams& params,
+            raft::device_matrix_view<const DataT, IndexT> X,
+            std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+            raft::device_matrix_view<DataT, IndexT> centroids,
+            raft::host_scalar_view<DataT> inertia,
+            raft::host_scalar_view<IndexT> n_iter)
+{
+  detail::kmeans_fit_mg<DataT, IndexT>(
+    handle, params, X, sample_weight, centroids, inertia, n_iter);
+}
+
+}  // namespace raft::cluster::kmeans
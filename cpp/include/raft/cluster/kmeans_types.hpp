@@ -111,6 +111,15 @@ struct KMeansParams : kmeans_base_params {
   int batch_centroids = 0;  //
 
   bool inertia_check = false;
+
+  /**
+   * Skip the distance computations that cannot change the assignment of a sample, using the
+   * triangle inequality (Hamerly's algorithm). Every sample keeps the distance to its centroid and
+   * a lower bound of the distance to the other ones; only the samples whose bounds overlap are
+   * reassigned. This pays off with many clusters, when few samples move in the late iterations.
+   * Only supported with the L2Expanded and L2SqrtExpanded metrics.
+   */
+  bool use_bounds = false;
 };
 
 }  // namespace raft::cluster::kmeans
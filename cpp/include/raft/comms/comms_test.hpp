@@ -107,6 +107,30 @@ bool test_collective_reducescatter(raft::resources const& handle, int root)
   return detail::test_collective_reducescatter(handle, root);
 }
 
+/**
+ * @brief A simple sanity check that NCCL is able to perform a collective alltoall
+ *
+ * @param[in] handle the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ *  @param[in] root the root rank id
+ */
+bool test_collective_alltoall(raft::resources const& handle, int root)
+{
+  return detail::test_collective_alltoall(handle, root);
+}
+
+/**
+ * @brief A simple sanity check that NCCL is able to perform a collective alltoallv
+ *
+ * @param[in] handle the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ *  @param[in] root the root rank id
+ */
+bool test_collective_alltoallv(raft::resources const& handle, int root)
+{
+  return detail::test_collective_alltoallv(handle, root);
+}
+
 /**
  * A simple sanity check that UCX is able to send messages between all ranks
  *
@@ -119,6 +143,19 @@ bool test_pointToPoint_simple_send_recv(raft::resources const& h, int numTrials)
   return detail::test_pointToPoint_simple_send_recv(h, numTrials);
 }
 
+/**
+ * A simple sanity check that the UCX point-to-point path is able to send device buffers of
+ * irregular sizes between all ranks.
+ *
+ * @param[in] h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param[in] numTrials number of iterations of all-to-all messaging to perform
+ */
+bool test_pointToPoint_device_isend_irecv(raft::resources const& h, int numTrials)
+{
+  return detail::test_pointToPoint_device_isend_irecv(h, numTrials);
+}
+
 /**
  * A simple sanity check that device is able to send OR receive.
  *
@@ -196,6 +196,21 @@ class mpi_comms : public comms_iface {
     *request = req_id;
   }
 
+  // the device buffers are passed to MPI as is, which needs a CUDA-aware MPI
+  void device_isend(
+    const void* buf, size_t size, int dest, int tag, request_t* request, cudaStream_t stream) const
+  {
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    isend(buf, size, dest, tag, request);
+  }
+
+  void device_irecv(
+    void* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const
+  {
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    irecv(buf, size, source, tag, request);
+  }
+
   void waitall(int count, request_t array_of_requests[]) const
   {
     std::vector<MPI_Request> requests;
@@ -359,6 +374,65 @@ class mpi_comms : public comms_iface {
                                     stream));
   }
 
+  void alltoall(const void* sendbuff,
+                void* recvbuff,
+                size_t count,
+                datatype_t datatype,
+                cudaStream_t stream) const
+  {
+    size_t dtype_size = get_datatype_size(datatype);
+    // ncclSend/ncclRecv pairs need to be inside ncclGroupStart/ncclGroupEnd to avoid deadlock
+    RAFT_NCCL_TRY(ncclGroupStart());
+    for (int r = 0; r < get_size(); ++r) {
+      RAFT_NCCL_TRY(ncclSend(static_cast<const char*>(sendbuff) + count * r * dtype_size,
+                             count,
+                             get_nccl_datatype(datatype),
+                             r,
+                             nccl_comm_,
+                             stream));
+      RAFT_NCCL_TRY(ncclRecv(static_cast<char*>(recvbuff) + count * r * dtype_size,
+                             count,
+                             get_nccl_datatype(datatype),
+                             r,
+                             nccl_comm_,
+                             stream));
+    }
+    RAFT_NCCL_TRY(ncclGroupEnd());
+  }
+
+  void alltoallv(const void* sendbuf,
+                 const size_t* sendcounts,
+                 const size_t* sdispls,
+                 void* recvbuf,
+                 const size_t* recvcounts,
+                 const size_t* rdispls,
+                 datatype_t datatype,
+                 cudaStream_t stream) const
+  {
+    size_t dtype_size = get_datatype_size(datatype);
+    // ncclSend/ncclRecv pairs need to be inside ncclGroupStart/ncclGroupEnd to avoid deadlock
+    RAFT_NCCL_TRY(ncclGroupStart());
+    for (int r = 0; r < get_size(); ++r) {
+      if (sendcounts[r] > 0) {
+        RAFT_NCCL_TRY(ncclSend(static_cast<const char*>(sendbuf) + sdispls[r] * dtype_size,
+                               sendcounts[r],
+                               get_nccl_datatype(datatype),
+                               r,
+                               nccl_comm_,
+                               stream));
+      }
+      if (recvcounts[r] > 0) {
+        RAFT_NCCL_TRY(ncclRecv(static_cast<char*>(recvbuf) + rdispls[r] * dtype_size,
+                               recvcounts[r],
+                               get_nccl_datatype(datatype),
+                               r,
+                               nccl_comm_,
+                               stream));
+      }
+    }
+    RAFT_NCCL_TRY(ncclGroupEnd());
+  }
+
   status_t sync_stream(cudaStream_t stream) const { return nccl_sync_stream(nccl_comm_, stream); }
 
   // if a thread is sending & receiving at the same time, use device_sendrecv to avoid deadlock
@@ -39,6 +39,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <deque>
 #include <exception>
 #include <memory>
 #include <thread>
@@ -125,6 +126,10 @@ class std_comms : public comms_iface {
 
   ~std_comms()
   {
+    for (auto& pending : pending_device_p2p_) {
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(pending.second.ready));
+    }
+    pending_device_p2p_.clear();
     requests_in_flight_.clear();
     free_requests_.clear();
 
@@ -215,214 +220,46 @@ class std_comms : public comms_iface {
 
   void isend(const void* buf, size_t size, int dest, int tag, request_t* request) const
   {
-    if (std::holds_alternative<ucxx_worker_t>(ucx_objects_.worker)) {
-      get_request_id(request);
-
-      ucxx::Endpoint* ep_ptr = (*std::get<ucxx_endpoint_array_t>(ucx_objects_.endpoints))[dest];
-
-      ucp_tag_t ucp_tag = build_message_tag(get_rank(), tag);
-      auto ucxx_req     = ep_ptr->tagSend(const_cast<void*>(buf), size, ucxx::Tag(ucp_tag));
-
-      requests_in_flight_.insert(std::make_pair(*request, ucxx_req));
-    } else {
-      ASSERT(std::get<ucp_worker_t>(ucx_objects_.worker) != nullptr,
-             "ERROR: UCX comms not initialized on communicator.");
-
-      get_request_id(request);
-      ucp_ep_h ep_ptr = (*std::get<ucp_endpoint_array_t>(ucx_objects_.endpoints))[dest];
-
-      ucp_request* ucp_req = (ucp_request*)malloc(sizeof(ucp_request));
-
-      this->ucp_handler_.ucp_isend(ucp_req, ep_ptr, buf, size, tag, default_tag_mask, get_rank());
-
-      requests_in_flight_.insert(std::make_pair(*request, ucp_req));
-    }
+    get_request_id(request);
+    post_isend(buf, size, dest, tag, *request);
   }
 
   void irecv(void* buf, size_t size, int source, int tag, request_t* request) const
   {
-    if (std::holds_alternative<ucxx_worker_t>(ucx_objects_.worker)) {
-      get_request_id(request);
-
-      ucxx::Endpoint* ep_ptr = (*std::get<ucxx_endpoint_array_t>(ucx_objects_.endpoints))[source];
-
-      ucp_tag_t ucp_tag = build_message_tag(get_rank(), tag);
-      auto ucxx_req =
-        ep_ptr->tagRecv(buf, size, ucxx::Tag(ucp_tag), ucxx::TagMask(default_tag_mask));
-
-      requests_in_flight_.insert(std::make_pair(*request, ucxx_req));
-    } else {
-      ASSERT(std::get<ucp_worker_t>(ucx_objects_.worker) != nullptr,
-             "ERROR: UCX comms not initialized on communicator.");
-
-      get_request_id(request);
-
-      ucp_ep_h ep_ptr = (*std::get<ucp_endpoint_array_t>(ucx_objects_.endpoints))[source];
-
-      ucp_tag_t tag_mask = default_tag_mask;
+    get_request_id(request);
+    post_irecv(buf, size, source, tag, *request);
+  }
 
-      ucp_request* ucp_req = (ucp_request*)malloc(sizeof(ucp_request));
-      ucp_handler_.ucp_irecv(ucp_req,
-                             std::get<ucp_worker_t>(ucx_objects_.worker),
-                             ep_ptr,
-                             buf,
-                             size,
-                             tag,
-                             tag_mask,
-                             source);
+  /**
+   * The UCX tag send and receive handle device memory natively (over NVLink, or IB with
+   * GPUDirect RDMA when available), so the device buffers are not staged through the host. The
+   * transfer is posted once the work submitted to `stream` before the call has completed: the
+   * readiness is tracked with an event rather than by synchronizing the stream, and the requests
+   * whose event is not complete yet are posted by the next device point-to-point call or by
+   * `waitall`.
+   */
+  void device_isend(
+    const void* buf, size_t size, int dest, int tag, request_t* request, cudaStream_t stream) const
+  {
+    get_request_id(request);
+    defer_device_p2p(true, const_cast<void*>(buf), size, dest, tag, *request, stream);
+  }
 
-      requests_in_flight_.insert(std::make_pair(*request, ucp_req));
-    }
+  void device_irecv(
+    void* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const
+  {
+    get_request_id(request);
+    defer_device_p2p(false, buf, size, source, tag, *request, stream);
   }
 
   void waitall(int count, request_t array_of_requests[]) const
   {
-    if (std::holds_alternative<ucxx_worker_t>(ucx_objects_.worker)) {
-      ucxx_worker_t worker = std::get<ucxx_worker_t>(ucx_objects_.worker);
-
-      std::vector<std::shared_ptr<ucxx::Request>> requests;
-      requests.reserve(count);
-
-      time_t start = time(NULL);
-
-      for (int i = 0; i < count; ++i) {
-        auto req_it = requests_in_flight_.find(array_of_requests[i]);
-        ASSERT(requests_in_flight_.end() != req_it,
-               "ERROR: waitall on invalid request: %d",
-               array_of_requests[i]);
-        requests.push_back(std::get<std::shared_ptr<ucxx::Request>>(req_it->second));
-        free_requests_.insert(req_it->first);
-        requests_in_flight_.erase(req_it);
-      }
-
-      while (requests.size() > 0) {
-        time_t now = time(NULL);
-
-        // Timeout if we have not gotten progress or completed any requests
-        // in 10 or more seconds.
-        ASSERT(now - start < 10, "Timed out waiting for requests.");
-
-        for (std::vector<std::shared_ptr<ucxx::Request>>::iterator it = requests.begin();
-             it != requests.end();) {
-          bool restart = false;  // resets the timeout when any progress was made
-
-          if (worker->isProgressThreadRunning()) {
-            // Wait for a UCXX progress thread roundtrip, prevent waiting for longer
-            // than 10ms for each operation, will retry in next iteration.
-            ucxx::utils::CallbackNotifier callbackNotifierPre{};
-            (void)worker->registerGenericPre(
-              [&callbackNotifierPre]() { callbackNotifierPre.set(); }, 10000000 /* 10ms */);
-            callbackNotifierPre.wait();
-
-            ucxx::utils::CallbackNotifier callbackNotifierPost{};
-            (void)worker->registerGenericPost(
-              [&callbackNotifierPost]() { callbackNotifierPost.set(); }, 10000000 /* 10ms */);
-            callbackNotifierPost.wait();
-          } else {
-            // Causes UCXX to progress through the send/recv message queue
-            while (!worker->progress()) {
-              restart = true;
-            }
-          }
-
-          auto req = *it;
-
-          // If the message needs release, we know it will be sent/received
-          // asynchronously, so we will need to track and verify its state
-          if (req->isCompleted()) {
-            auto status = req->getStatus();
-            ASSERT(req->getStatus() == UCS_OK,
-                   "UCX Request Error: %d (%s)\n",
-                   status,
-                   ucs_status_string(status));
-          }
-
-          // If a message was sent synchronously (eg. completed before
-          // `isend`/`irecv` completed) or an asynchronous message
-          // is complete, we can go ahead and clean it up.
-          if (req->isCompleted()) {
-            restart = true;
-
-            auto status = req->getStatus();
-            ASSERT(req->getStatus() == UCS_OK,
-                   "UCX Request Error: %d (%s)\n",
-                   status,
-                   ucs_status_string(status));
-
-            // remove from pending requests
-            it = requests.erase(it);
-          } else {
-            ++it;
-          }
-          // if any progress was made, reset the timeout start time
-          if (restart) { start = time(NULL); }
-        }
-      }
-    } else {
-      ucp_worker_t worker = std::get<ucp_worker_t>(ucx_objects_.worker);
-      ASSERT(worker != nullptr, "ERROR: UCX comms not initialized on communicator.");
-
-      std::vector<ucp_request*> requests;
-      requests.reserve(count);
-
-      time_t start = time(NULL);
-
-      for (int i = 0; i < count; ++i) {
-        auto req_it = requests_in_flight_.find(array_of_requests[i]);
-        ASSERT(requests_in_flight_.end() != req_it,
-               "ERROR: waitall on invalid request: %d",
-               array_of_requests[i]);
-        requests.push_back(std::get<ucp_request*>(req_it->second));
-        free_requests_.insert(req_it->first);
-        requests_in_flight_.erase(req_it);
-      }
-
-      while (requests.size() > 0) {
-        time_t now = time(NULL);
-
-        // Timeout if we have not gotten progress or completed any requests
-        // in 10 or more seconds.
-        ASSERT(now - start < 10, "Timed out waiting for requests.");
-
-        for (std::vector<ucp_request*>::iterator it = requests.begin(); it != requests.end();) {
-          bool restart = false;  // resets the timeout when any progress was made
-
-          // Causes UCP to progress through the send/recv message queue
-          while (ucp_worker_progress(worker) != 0) {
-            restart = true;
-          }
-
-          auto req = *it;
-
-          // If the message needs release, we know it will be sent/received
-          // asynchronously, so we will need to track and verify its state
-          if (req->needs_release) {
-            ASSERT(UCS_PTR_IS_PTR(req->req), "UCX Request Error. Request is not valid UCX pointer");
-            ASSERT(!UCS_PTR_IS_ERR(req->req), "UCX Request Error: %d\n", UCS_PTR_STATUS(req->req));
-            ASSERT(req->req->completed == 1 || req->req->completed == 0,
-                   "request->completed not a valid value: %d\n",
-                   req->req->completed);
-          }
-
-          // If a message was sent synchronously (eg. completed before
-          // `isend`/`irecv` completed) or an asynchronous message
-          // is complete, we can go ahead and clean it up.
-          if (!req->needs_release || req->req->completed == 1) {
-            restart = true;
-
-            // perform cleanup
-            ucp_handler_.free_ucp_request(req);
-
-            // remove from pending requests
-            it = requests.erase(it);
-          } else {
-            ++it;
-          }
-          // if any progress was made, reset the timeout start time
-          if (restart) { start = time(NULL); }
-        }
-      }
+    // the device point-to-point requests wait for their buffers (not for their whole stream)
+    for (auto& pending : pending_device_p2p_) {
+      RAFT_CUDA_TRY(cudaEventSynchronize(pending.second.ready));
     }
+    post_ready_device_p2p();
+    wait_posted(count, array_of_requests);
   }
 
   void allreduce(const void* sendbuff,
@@ -572,6 +409,65 @@ class std_comms : public comms_iface {
                                     stream));
   }
 
+  void alltoall(const void* sendbuff,
+                void* recvbuff,
+                size_t count,
+                datatype_t datatype,
+                cudaStream_t stream) const
+  {
+    size_t dtype_size = get_datatype_size(datatype);
+    // ncclSend/ncclRecv pairs need to be inside ncclGroupStart/ncclGroupEnd to avoid deadlock
+    RAFT_NCCL_TRY(ncclGroupStart());
+    for (int r = 0; r < get_size(); ++r) {
+      RAFT_NCCL_TRY(ncclSend(static_cast<const char*>(sendbuff) + count * r * dtype_size,
+                             count,
+                             get_nccl_datatype(datatype),
+                             r,
+                             nccl_comm_,
+                             stream));
+      RAFT_NCCL_TRY(ncclRecv(static_cast<char*>(recvbuff) + count * r * dtype_size,
+                             count,
+                             get_nccl_datatype(datatype),
+                             r,
+                             nccl_comm_,
+                             stream));
+    }
+    RAFT_NCCL_TRY(ncclGroupEnd());
+  }
+
+  void alltoallv(const void* sendbuf,
+                 const size_t* sendcounts,
+                 const size_t* sdispls,
+                 void* recvbuf,
+                 const size_t* recvcounts,
+                 const size_t* rdispls,
+                 datatype_t datatype,
+                 cudaStream_t stream) const
+  {
+    size_t dtype_size = get_datatype_size(datatype);
+    // ncclSend/ncclRecv pairs need to be inside ncclGroupStart/ncclGroupEnd to avoid deadlock
+    RAFT_NCCL_TRY(ncclGroupStart());
+    for (int r = 0; r < get_size(); ++r) {
+      if (sendcounts[r] > 0) {
+        RAFT_NCCL_TRY(ncclSend(static_cast<const char*>(sendbuf) + sdispls[r] * dtype_size,
+                               sendcounts[r],
+                               get_nccl_datatype(datatype),
+                               r,
+                               nccl_comm_,
+                               stream));
+      }
+      if (recvcounts[r] > 0) {
+        RAFT_NCCL_TRY(ncclRecv(static_cast<char*>(recvbuf) + rdispls[r] * dtype_size,
+                               recvcounts[r],
+                               get_nccl_datatype(datatype),
+                               r,
+                               nccl_comm_,
+                               stream));
+      }
+    }
+    RAFT_NCCL_TRY(ncclGroupEnd());
+  }
+
   status_t sync_stream(cudaStream_t stream) const { return nccl_sync_stream(nccl_comm_, stream); }
 
   // if a thread is sending & receiving at the same time, use device_sendrecv to avoid deadlock
@@ -637,6 +533,259 @@ class std_comms : public comms_iface {
   void group_end() const { RAFT_NCCL_TRY(ncclGroupEnd()); }
 
  private:
+  void post_isend(const void* buf, size_t size, int dest, int tag, request_t request) const
+  {
+    if (std::holds_alternative<ucxx_worker_t>(ucx_objects_.worker)) {
+      ucxx::Endpoint* ep_ptr = (*std::get<ucxx_endpoint_array_t>(ucx_objects_.endpoints))[dest];
+
+      ucp_tag_t ucp_tag = build_message_tag(get_rank(), tag);
+      auto ucxx_req     = ep_ptr->tagSend(const_cast<void*>(buf), size, ucxx::Tag(ucp_tag));
+
+      requests_in_flight_.insert(std::make_pair(request, ucxx_req));
+    } else {
+      ASSERT(std::get<ucp_worker_t>(ucx_objects_.worker) != nullptr,
+             "ERROR: UCX comms not initialized on communicator.");
+
+      ucp_ep_h ep_ptr = (*std::get<ucp_endpoint_array_t>(ucx_objects_.endpoints))[dest];
+
+      ucp_request* ucp_req = (ucp_request*)malloc(sizeof(ucp_request));
+
+      this->ucp_handler_.ucp_isend(ucp_req, ep_ptr, buf, size, tag, default_tag_mask, get_rank());
+
+      requests_in_flight_.insert(std::make_pair(request, ucp_req));
+    }
+  }
+
+  void post_irecv(void* buf, size_t size, int source, int tag, request_t request) const
+  {
+    if (std::holds_alternative<ucxx_worker_t>(ucx_objects_.worker)) {
+      ucxx::Endpoint* ep_ptr = (*std::get<ucxx_endpoint_array_t>(ucx_objects_.endpoints))[source];
+
+      ucp_tag_t ucp_tag = build_message_tag(get_rank(), tag);
+      auto ucxx_req =
+        ep_ptr->tagRecv(buf, size, ucxx::Tag(ucp_tag), ucxx::TagMask(default_tag_mask));
+
+      requests_in_flight_.insert(std::make_pair(request, ucxx_req));
+    } else {
+      ASSERT(std::get<ucp_worker_t>(ucx_objects_.worker) != nullptr,
+             "ERROR: UCX comms not initialized on communicator.");
+
+      ucp_ep_h ep_ptr = (*std::get<ucp_endpoint_array_t>(ucx_objects_.endpoints))[source];
+
+      ucp_tag_t tag_mask = default_tag_mask;
+
+      ucp_request* ucp_req = (ucp_request*)malloc(sizeof(ucp_request));
+      ucp_handler_.ucp_irecv(ucp_req,
+                             std::get<ucp_worker_t>(ucx_objects_.worker),
+                             ep_ptr,
+                             buf,
+                             size,
+                             tag,
+                             tag_mask,
+                             source);
+
+      requests_in_flight_.insert(std::make_pair(request, ucp_req));
+    }
+  }
+
+  void wait_posted(int count, request_t array_of_requests[]) const
+  {
+    if (std::holds_alternative<ucxx_worker_t>(ucx_objects_.worker)) {
+      ucxx_worker_t worker = std::get<ucxx_worker_t>(ucx_objects_.worker);
+
+      std::vector<std::shared_ptr<ucxx::Request>> requests;
+      requests.reserve(count);
+
+      time_t start = time(NULL);
+
+      for (int i = 0; i < count; ++i) {
+        auto req_it = requests_in_flight_.find(array_of_requests[i]);
+        ASSERT(requests_in_flight_.end() != req_it,
+               "ERROR: waitall on invalid request: %d",
+               array_of_requests[i]);
+        requests.push_back(std::get<std::shared_ptr<ucxx::Request>>(req_it->second));
+        free_requests_.insert(req_it->first);
+        requests_in_flight_.erase(req_it);
+      }
+
+      while (requests.size() > 0) {
+        time_t now = time(NULL);
+
+        // Timeout if we have not gotten progress or completed any requests
+        // in 10 or more seconds.
+        ASSERT(now - start < 10, "Timed out waiting for requests.");
+
+        for (std::vector<std::shared_ptr<ucxx::Request>>::iterator it = requests.begin();
+             it != requests.end();) {
+          bool restart = false;  // resets the timeout when any progress was made
+
+          if (worker->isProgressThreadRunning()) {
+            // Wait for a UCXX progress thread roundtrip, prevent waiting for longer
+            // than 10ms for each operation, will retry in next iteration.
+            ucxx::utils::CallbackNotifier callbackNotifierPre{};
+            (void)worker->registerGenericPre(
+              [&callbackNotifierPre]() { callbackNotifierPre.set(); }, 10000000 /* 10ms */);
+            callbackNotifierPre.wait();
+
+            ucxx::utils::CallbackNotifier callbackNotifierPost{};
+            (void)worker->registerGenericPost(
+              [&callbackNotifierPost]() { callbackNotifierPost.set(); }, 10000000 /* 10ms */);
+            callbackNotifierPost.wait();
+          } else {
+            // Causes UCXX to progress through the send/recv message queue
+            while (!worker->progress()) {
+              restart = true;
+            }
+          }
+
+          auto req = *it;
+
+          // If the message needs release, we know it will be sent/received
+          // asynchronously, so we will need to track and verify its state
+          if (req->isCompleted()) {
+            auto status = req->getStatus();
+            ASSERT(req->getStatus() == UCS_OK,
+                   "UCX Request Error: %d (%s)\n",
+                   status,
+                   ucs_status_string(status));
+          }
+
+          // If a message was sent synchronously (eg. completed before
+          // `isend`/`irecv` completed) or an asynchronous message
+          // is complete, we can go ahead and clean it up.
+          if (req->isCompleted()) {
+            restart = true;
+
+            auto status = req->getStatus();
+            ASSERT(req->getStatus() == UCS_OK,
+                   "UCX Request Error: %d (%s)\n",
+                   status,
+                   ucs_status_string(status));
+
+            // remove from pending requests
+            it = requests.erase(it);
+          } else {
+            ++it;
+          }
+          // if any progress was made, reset the timeout start time
+          if (restart) { start = time(NULL); }
+        }
+      }
+    } else {
+      ucp_worker_t worker = std::get<ucp_worker_t>(ucx_objects_.worker);
+      ASSERT(worker != nullptr, "ERROR: UCX comms not initialized on communicator.");
+
+      std::vector<ucp_request*> requests;
+      requests.reserve(count);
+
+      time_t start = time(NULL);
+
+      for (int i = 0; i < count; ++i) {
+        auto req_it = requests_in_flight_.find(array_of_requests[i]);
+        ASSERT(requests_in_flight_.end() != req_it,
+               "ERROR: waitall on invalid request: %d",
+               array_of_requests[i]);
+        requests.push_back(std::get<ucp_request*>(req_it->second));
+        free_requests_.insert(req_it->first);
+        requests_in_flight_.erase(req_it);
+      }
+
+      while (requests.size() > 0) {
+        time_t now = time(NULL);
+
+        // Timeout if we have not gotten progress or completed any requests
+        // in 10 or more seconds.
+        ASSERT(now - start < 10, "Timed out waiting for requests.");
+
+        for (std::vector<ucp_request*>::iterator it = requests.begin(); it != requests.end();) {
+          bool restart = false;  // resets the timeout when any progress was made
+
+          // Causes UCP to progress through the send/recv message queue
+          while (ucp_worker_progress(worker) != 0) {
+            restart = true;
+          }
+
+          auto req = *it;
+
+          // If the message needs release, we know it will be sent/received
+          // asynchronously, so we will need to track and verify its state
+          if (req->needs_release) {
+            ASSERT(UCS_PTR_IS_PTR(req->req), "UCX Request Error. Request is not valid UCX pointer");
+            ASSERT(!UCS_PTR_IS_ERR(req->req), "UCX Request Error: %d\n", UCS_PTR_STATUS(req->req));
+            ASSERT(req->req->completed == 1 || req->req->completed == 0,
+                   "request->completed not a valid value: %d\n",
+                   req->req->completed);
+          }
+
+          // If a message was sent synchronously (eg. completed before
+          // `isend`/`irecv` completed) or an asynchronous message
+          // is complete, we can go ahead and clean it up.
+          if (!req->needs_release || req->req->completed == 1) {
+            restart = true;
+
+            // perform cleanup
+            ucp_handler_.free_ucp_request(req);
+
+            // remove from pending requests
+            it = requests.erase(it);
+          } else {
+            ++it;
+          }
+          // if any progress was made, reset the timeout start time
+          if (restart) { start = time(NULL); }
+        }
+      }
+    }
+  }
+
+  /** A device point-to-point transfer waiting for the work producing (or using) its buffer. */
+  struct pending_device_p2p_t {
+    cudaEvent_t ready;
+    bool is_send;
+    void* buf;
+    size_t size;
+    int peer;
+    int tag;
+  };
+
+  void defer_device_p2p(bool is_send,
+                        void* buf,
+                        size_t size,
+                        int peer,
+                        int tag,
+                        request_t request,
+                        cudaStream_t stream) const
+  {
+    ASSERT(peer >= 0 && peer < num_ranks_, "ERROR: invalid peer rank: %d", peer);
+    cudaEvent_t ready;
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&ready, cudaEventDisableTiming));
+    RAFT_CUDA_TRY(cudaEventRecord(ready, stream));
+    pending_device_p2p_.emplace_back(request,
+                                     pending_device_p2p_t{ready, is_send, buf, size, peer, tag});
+    post_ready_device_p2p();
+  }
+
+  /**
+   * Post the pending device transfers whose buffer is ready. They are posted in the order they
+   * were issued, which the tag matching relies on, so a transfer not ready yet holds the next ones.
+   */
+  void post_ready_device_p2p() const
+  {
+    while (!pending_device_p2p_.empty()) {
+      auto& [request, op] = pending_device_p2p_.front();
+      auto queried        = cudaEventQuery(op.ready);
+      if (queried == cudaErrorNotReady) { break; }
+      RAFT_CUDA_TRY(queried);
+      if (op.is_send) {
+        post_isend(op.buf, op.size, op.peer, op.tag, request);
+      } else {
+        post_irecv(op.buf, op.size, op.peer, op.tag, request);
+      }
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(op.ready));
+      pending_device_p2p_.pop_front();
+    }
+  }
+
   ncclComm_t nccl_comm_;
   cudaStream_t stream_;
 
@@ -656,6 +805,7 @@ class std_comms : public comms_iface {
                              std::variant<struct ucp_request*, std::shared_ptr<ucxx::Request>>>
     requests_in_flight_;
   mutable std::unordered_set<request_t> free_requests_;
+  mutable std::deque<std::pair<request_t, pending_device_p2p_t>> pending_device_p2p_;
 };
 }  // namespace detail
 }  // end namespace comms
@@ -24,6 +24,7 @@
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <numeric>
 
@@ -301,6 +302,106 @@ bool test_collective_reducescatter(raft::resources const& handle, int root)
   return temp_h == communicator.get_size();
 }
 
+/**
+ * @brief A simple sanity check that NCCL is able to perform a collective alltoall
+ *
+ * @param[in] handle the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ *  @param[in] root the root rank id (unused: all the ranks are equivalent)
+ */
+bool test_collective_alltoall(raft::resources const& handle, int root)
+{
+  comms_t const& communicator = resource::get_comms(handle);
+  const int n_ranks           = communicator.get_size();
+  const int rank              = communicator.get_rank();
+  constexpr size_t count      = 2;
+
+  // the block for rank r holds rank * n_ranks + r
+  std::vector<int> sends(n_ranks * count);
+  for (int r = 0; r < n_ranks; r++) {
+    std::fill(sends.begin() + r * count, sends.begin() + (r + 1) * count, rank * n_ranks + r);
+  }
+
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+
+  rmm::device_uvector<int> temp_d(sends.size(), stream);
+  rmm::device_uvector<int> recv_d(sends.size(), stream);
+
+  RAFT_CUDA_TRY(cudaMemcpyAsync(
+    temp_d.data(), sends.data(), sends.size() * sizeof(int), cudaMemcpyHostToDevice, stream));
+
+  communicator.alltoall(temp_d.data(), recv_d.data(), count, stream);
+  communicator.sync_stream(stream);
+  std::vector<int> temp_h(sends.size(), -1);
+  RAFT_CUDA_TRY(cudaMemcpyAsync(
+    temp_h.data(), recv_d.data(), sizeof(int) * temp_h.size(), cudaMemcpyDeviceToHost, stream));
+  resource::sync_stream(handle, stream);
+  communicator.barrier();
+
+  for (int r = 0; r < n_ranks; r++) {
+    auto block = temp_h.begin() + r * count;
+    if (std::any_of(block, block + count, [&](int v) { return v != r * n_ranks + rank; })) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief A simple sanity check that NCCL is able to perform a collective alltoallv
+ *
+ * @param[in] handle the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ *  @param[in] root the root rank id (unused: all the ranks are equivalent)
+ */
+bool test_collective_alltoallv(raft::resources const& handle, int root)
+{
+  comms_t const& communicator = resource::get_comms(handle);
+  const int n_ranks           = communicator.get_size();
+  const int rank              = communicator.get_rank();
+
+  // every rank sends r + 1 copies of its id to the rank r
+  std::vector<size_t> sendcounts(n_ranks);
+  std::iota(sendcounts.begin(), sendcounts.end(), size_t{1});
+  std::vector<size_t> sdispls(n_ranks + 1, 0);
+  std::partial_sum(sendcounts.begin(), sendcounts.end(), sdispls.begin() + 1);
+  std::vector<size_t> recvcounts(n_ranks, rank + 1);
+  std::vector<size_t> rdispls(n_ranks);
+  for (int r = 0; r < n_ranks; r++) {
+    rdispls[r] = r * (rank + 1);
+  }
+
+  std::vector<int> sends(sdispls.back(), rank);
+
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+
+  rmm::device_uvector<int> temp_d(sends.size(), stream);
+  rmm::device_uvector<int> recv_d(n_ranks * (rank + 1), stream);
+
+  RAFT_CUDA_TRY(cudaMemcpyAsync(
+    temp_d.data(), sends.data(), sends.size() * sizeof(int), cudaMemcpyHostToDevice, stream));
+
+  communicator.alltoallv(temp_d.data(),
+                         sendcounts.data(),
+                         sdispls.data(),
+                         recv_d.data(),
+                         recvcounts.data(),
+                         rdispls.data(),
+                         stream);
+  communicator.sync_stream(stream);
+  std::vector<int> temp_h(recv_d.size(), -1);
+  RAFT_CUDA_TRY(cudaMemcpyAsync(
+    temp_h.data(), recv_d.data(), sizeof(int) * temp_h.size(), cudaMemcpyDeviceToHost, stream));
+  resource::sync_stream(handle, stream);
+  communicator.barrier();
+
+  for (int r = 0; r < n_ranks; r++) {
+    auto block = temp_h.begin() + rdispls[r];
+    if (std::any_of(block, block + rank + 1, [r](int v) { return v != r; })) { return false; }
+  }
+  return true;
+}
+
 /**
  * A simple sanity check that UCX is able to send messages between all ranks
  *
@@ -366,6 +467,71 @@ bool test_pointToPoint_simple_send_recv(raft::resources const& h, int numTrials)
   return ret;
 }
 
+/**
+ * A simple sanity check that the UCX point-to-point path is able to send device buffers of
+ * irregular sizes between all ranks.
+ *
+ * @param[in] h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param[in] numTrials number of iterations of all-to-all messaging to perform
+ */
+bool test_pointToPoint_device_isend_irecv(raft::resources const& h, int numTrials)
+{
+  comms_t const& communicator = resource::get_comms(h);
+  int const rank              = communicator.get_rank();
+  int const size              = communicator.get_size();
+  cudaStream_t stream         = resource::get_cuda_stream(h);
+
+  // the message from rank s to rank d holds s + d + 1 copies of s
+  auto message_size = [](int s, int d) { return size_t(s + d + 1); };
+
+  bool ret = true;
+  for (int i = 0; i < numTrials; i++) {
+    std::vector<rmm::device_uvector<int>> received_data;
+    std::vector<rmm::device_uvector<int>> sent_data;
+    std::vector<request_t> requests(2 * (size - 1));
+    int request_idx = 0;
+    for (int r = 0; r < size; ++r) {
+      if (r == rank) { continue; }
+      received_data.emplace_back(message_size(r, rank), stream);
+      communicator.device_irecv(received_data.back().data(),
+                                received_data.back().size(),
+                                r,
+                                0,
+                                requests.data() + request_idx++,
+                                stream);
+    }
+    for (int r = 0; r < size; ++r) {
+      if (r == rank) { continue; }
+      std::vector<int> h_sent(message_size(rank, r), rank);
+      sent_data.emplace_back(h_sent.size(), stream);
+      raft::update_device(sent_data.back().data(), h_sent.data(), h_sent.size(), stream);
+      communicator.device_isend(sent_data.back().data(),
+                                sent_data.back().size(),
+                                r,
+                                0,
+                                requests.data() + request_idx++,
+                                stream);
+    }
+
+    communicator.waitall(requests.size(), requests.data());
+
+    int idx = 0;
+    for (int r = 0; r < size; ++r) {
+      if (r == rank) { continue; }
+      std::vector<int> h_received(message_size(r, rank), -1);
+      raft::update_host(h_received.data(), received_data[idx++].data(), h_received.size(), stream);
+      communicator.sync_stream(stream);
+      if (std::any_of(h_received.begin(), h_received.end(), [r](int v) { return v != r; })) {
+        ret = false;
+      }
+    }
+    communicator.barrier();
+  }
+
+  return ret;
+}
+
 /**
  * A simple sanity check that device is able to send OR receive.
  *
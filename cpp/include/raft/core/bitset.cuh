@@ -19,6 +19,7 @@
 #include <raft/core/bitset.hpp>
 #include <raft/core/device_container_policy.hpp>
 #include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/linalg/map.cuh>
@@ -27,8 +28,15 @@
 #include <raft/util/popc.cuh>
 
 #include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
 
 #include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/transform_reduce.h>
+
+#include <algorithm>
 
 namespace raft::core {
 
@@ -165,6 +173,164 @@ double bitset_view<bitset_t, index_t>::sparsity(const raft::resources& res) cons
   return static_cast<double>((1.0 * (size_h - count_h)) / (1.0 * size_h));
 }
 
+namespace detail {
+
+/** The element `i` of a bitset of `n_bits` bits, with the bits past the end cleared. */
+template <typename bitset_t, typename index_t>
+_RAFT_DEVICE inline auto bitset_element(const bitset_t* bits, index_t i, index_t n_bits)
+  -> bitset_t
+{
+  constexpr index_t bits_per_element = sizeof(bitset_t) * 8;
+  const bitset_t element             = bits[i];
+  const index_t first_bit            = i * bits_per_element;
+  if (n_bits - first_bit >= bits_per_element) { return element; }
+  const index_t tail_len = n_bits - first_bit;
+  return element & bitset_t((bitset_t{1} << tail_len) - bitset_t{1});
+}
+
+template <typename bitset_t>
+_RAFT_DEVICE inline auto bitset_popc(bitset_t element) -> int
+{
+  if constexpr (sizeof(bitset_t) == 8) {
+    return raft::detail::popc(uint64_t{element});
+  } else {  // popc is not overloaded for 16 and 8 bit elements
+    return raft::detail::popc(uint32_t{element});
+  }
+}
+
+/** A mixing function of the 64-bit state (splitmix64), to choose the sampled elements. */
+_RAFT_HOST_DEVICE inline auto bitset_sample_hash(uint64_t x) -> uint64_t
+{
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+/** Every thread writes the indices of the set bits of one element, from `offsets[i]` on. */
+template <typename bitset_t, typename index_t>
+RAFT_KERNEL bitset_to_indices_kernel(const bitset_t* bits,
+                                     index_t n_bits,
+                                     index_t n_elements,
+                                     const index_t* offsets,
+                                     index_t* out)
+{
+  constexpr index_t bits_per_element = sizeof(bitset_t) * 8;
+  const index_t i                    = index_t(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (i >= n_elements) { return; }
+  auto element = bitset_element(bits, i, n_bits);
+  index_t pos  = offsets[i];
+  while (element != bitset_t{0}) {
+    int bit;
+    if constexpr (sizeof(bitset_t) == 8) {
+      bit = __ffsll(static_cast<long long>(element)) - 1;
+    } else {
+      bit = __ffs(static_cast<int>(uint32_t{element})) - 1;
+    }
+    out[pos++] = i * bits_per_element + index_t(bit);
+    element &= bitset_t(element - bitset_t{1});
+  }
+}
+
+template <typename bitset_t>
+struct bitset_combine_op {
+  bitset_op op;
+
+  _RAFT_DEVICE inline auto operator()(bitset_t a, bitset_t b) const -> bitset_t
+  {
+    switch (op) {
+      case bitset_op::AND: return bitset_t(a & b);
+      case bitset_op::OR: return bitset_t(a | b);
+      case bitset_op::XOR: return bitset_t(a ^ b);
+      default: return a & bitset_t(~b);
+    }
+  }
+};
+
+}  // namespace detail
+
+template <typename bitset_t, typename index_t>
+double bitset_view<bitset_t, index_t>::estimate_selectivity(const raft::resources& res,
+                                                           index_t n_samples,
+                                                           uint64_t seed) const
+{
+  const index_t n_bits = this->size();
+  if (n_bits == 0) { return 1.0; }
+  const index_t n_elem = n_elements();
+  if (n_samples >= n_elem) { return static_cast<double>(this->count(res)) / double(n_bits); }
+  RAFT_EXPECTS(n_samples > 0, "n_samples must be positive");
+
+  // Every sampled element stands for the elements of its stratum, so the estimate of the number
+  // of set bits is the sum of the popcounts weighted by the lengths of the strata.
+  const bitset_t* bits = bitset_ptr_;
+  auto weighted_popc   = [bits, n_bits, n_elem, n_samples, seed] __device__(index_t s) {
+    const auto begin   = uint64_t(s) * n_elem / n_samples;
+    const auto end     = uint64_t(s + 1) * n_elem / n_samples;
+    const auto i       = begin + detail::bitset_sample_hash(seed ^ s) % (end - begin);
+    const auto element = detail::bitset_element(bits, index_t(i), n_bits);
+    return double(detail::bitset_popc(element)) * double(end - begin);
+  };
+  const double set_bits =
+    thrust::transform_reduce(resource::get_thrust_policy(res),
+                             thrust::make_counting_iterator<index_t>(0),
+                             thrust::make_counting_iterator<index_t>(n_samples),
+                             weighted_popc,
+                             0.0,
+                             thrust::plus<double>{});
+  return std::min(set_bits / double(n_bits), 1.0);
+}
+
+template <typename bitset_t, typename index_t>
+void bitset_view<bitset_t, index_t>::combine(const raft::resources& res,
+                                             bitset_view<const bitset_t, index_t> other,
+                                             bitset_op op) const
+{
+  RAFT_EXPECTS(other.size() == size(), "The bitsets must have the same size");
+  auto out = raft::make_device_vector_view<bitset_t, index_t>(bitset_ptr_, n_elements());
+  auto in  = raft::make_device_vector_view<const bitset_t, index_t>(bitset_ptr_, n_elements());
+  raft::linalg::map(res, out, detail::bitset_combine_op<bitset_t>{op}, in, other.to_mdspan());
+}
+
+template <typename bitset_t, typename index_t>
+auto bitset_view<bitset_t, index_t>::to_indices(
+  const raft::resources& res, raft::device_vector_view<index_t, index_t> indices) const -> index_t
+{
+  auto stream          = resource::get_cuda_stream(res);
+  const index_t n_bits = this->size();
+  const index_t n_elem = n_elements();
+  if (n_elem == 0) { return 0; }
+
+  // offsets[i] is the number of set bits before the element i, offsets[n_elem] the total
+  rmm::device_uvector<index_t> offsets(n_elem + 1, stream, resource::get_workspace_resource(res));
+  const bitset_t* bits = bitset_ptr_;
+  thrust::transform_exclusive_scan(
+    resource::get_thrust_policy(res),
+    thrust::make_counting_iterator<index_t>(0),
+    thrust::make_counting_iterator<index_t>(n_elem + 1),
+    offsets.begin(),
+    [bits, n_bits, n_elem] __device__(index_t i) {
+      return i < n_elem ? index_t(detail::bitset_popc(detail::bitset_element(bits, i, n_bits)))
+                        : index_t(0);
+    },
+    index_t(0),
+    thrust::plus<index_t>{});
+  index_t n_set = 0;
+  raft::update_host(&n_set, offsets.data() + n_elem, 1, stream);
+  resource::sync_stream(res);
+  RAFT_EXPECTS(indices.extent(0) >= n_set,
+               "The output holds %zu indices but %zu bits are set",
+               size_t(indices.extent(0)),
+               size_t(n_set));
+
+  constexpr int kBlockSize = 256;
+  detail::bitset_to_indices_kernel<bitset_t, index_t>
+    <<<raft::ceildiv<index_t>(n_elem, kBlockSize), kBlockSize, 0, stream>>>(
+      bits, n_bits, n_elem, offsets.data(), indices.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  resource::sync_stream(res);
+  return n_set;
+}
+
 template <typename bitset_t, typename index_t>
 bitset<bitset_t, index_t>::bitset(const raft::resources& res,
                                   raft::device_vector_view<const index_t, index_t> mask_index,
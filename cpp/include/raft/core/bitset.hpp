@@ -23,12 +23,26 @@
 #include <raft/util/integer_utils.hpp>
 
 #include <cmath>
+#include <type_traits>
 
 namespace raft::core {
 /**
  * @defgroup bitset Bitset
  * @{
  */
+
+/** @brief Bitwise operation combining two bitsets, see `bitset_view::combine`. */
+enum class bitset_op {
+  /** Keep the bits set in both bitsets. */
+  AND,
+  /** Keep the bits set in either bitset. */
+  OR,
+  /** Keep the bits set in exactly one bitset. */
+  XOR,
+  /** Keep the bits of the first bitset that are not set in the second one. */
+  AND_NOT
+};
+
 /**
  * @brief View of a RAFT Bitset.
  *
@@ -57,6 +71,18 @@ struct bitset_view {
     : bitset_ptr_{bitset_span.data_handle()}, bitset_len_{bitset_len}
   {
   }
+  /**
+   * @brief Create a read-only view from a view of mutable bits.
+   *
+   * @param other View of the same bitset
+   */
+  template <typename other_t,
+            typename = std::enable_if_t<std::is_same_v<bitset_t, const other_t> &&
+                                        !std::is_const_v<other_t>>>
+  _RAFT_HOST_DEVICE bitset_view(const bitset_view<other_t, index_t>& other)
+    : bitset_ptr_{other.data()}, bitset_len_{other.size()}
+  {
+  }
   /**
    * @brief Device function to test if a given index is set in the bitset.
    *
@@ -163,6 +189,54 @@ struct bitset_view {
    */
   double sparsity(const raft::resources& res) const;
 
+  /**
+   * @brief Estimate the fraction of set bits (the selectivity of a filter) from a sample of the
+   * elements.
+   *
+   * The elements are split in `n_samples` strata of consecutive elements and one element is drawn
+   * in every stratum, so that the estimate is unbiased and stays accurate for clustered bits (e.g.
+   * the contiguous id ranges of a tenant). The cost is independent of the size of the bitset; when
+   * `n_samples` is not smaller than the number of elements, the exact fraction is returned.
+   *
+   * This API will synchronize on the stream of `res`.
+   *
+   * @param res RAFT resources
+   * @param n_samples Number of elements to read
+   * @param seed Seed of the choice of the elements within the strata
+   * @return double The estimated fraction of set bits, 1.0 for an empty bitset
+   */
+  double estimate_selectivity(const raft::resources& res,
+                              index_t n_samples = 1024,
+                              uint64_t seed     = 0) const;
+
+  /**
+   * @brief Combine the bits of another bitset into this one: `this = this op other`.
+   *
+   * The elements are processed with vectorized loads and stores.
+   *
+   * @param res RAFT resources
+   * @param other Bitset of the same size
+   * @param op Bitwise operation
+   */
+  void combine(const raft::resources& res,
+               bitset_view<const bitset_t, index_t> other,
+               bitset_op op) const;
+
+  /**
+   * @brief Write the indices of the set bits to `indices`, in increasing order.
+   *
+   * The position of the indices of every element is given by the prefix sum of the popcounts of
+   * the elements. `indices` must hold at least `count(res)` values.
+   *
+   * This API will synchronize on the stream of `res`.
+   *
+   * @param[in] res RAFT resources
+   * @param[out] indices The indices of the set bits
+   * @return index_t Number of set bits, i.e. of indices written
+   */
+  auto to_indices(const raft::resources& res,
+                  raft::device_vector_view<index_t, index_t> indices) const -> index_t;
+
   /**
    * @brief Calculates the number of `bitset_t` elements required to store a bitset.
    *
@@ -310,6 +384,24 @@ struct bitset {
    * @param default_value Value to set the bits to (true or false)
    */
   void reset(const raft::resources& res, bool default_value = true);
+  /**
+   * @brief Combine the bits of another bitset into this one: `this = this op other`.
+   *
+   * For example, the non-deleted samples of a tenant:
+   * @code{.cpp}
+   *  tenant_filter.combine(res, deleted.view(), raft::core::bitset_op::AND_NOT);
+   * @endcode
+   *
+   * @param res RAFT resources
+   * @param other Bitset of the same size
+   * @param op Bitwise operation
+   */
+  void combine(const raft::resources& res,
+               bitset_view<const bitset_t, index_t> other,
+               bitset_op op)
+  {
+    view().combine(res, other, op);
+  }
   /**
    * @brief Returns the number of bits set to true in count_gpu_scalar.
    *
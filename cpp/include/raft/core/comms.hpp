@@ -17,9 +17,11 @@
 #pragma once
 
 #include <raft/core/error.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
 
 #include <cuda_runtime.h>
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -140,6 +142,16 @@ class comms_iface {
 
   virtual void irecv(void* buf, size_t size, int source, int tag, request_t* request) const = 0;
 
+  virtual void device_isend(const void* buf,
+                            size_t size,
+                            int dest,
+                            int tag,
+                            request_t* request,
+                            cudaStream_t stream) const = 0;
+
+  virtual void device_irecv(
+    void* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const = 0;
+
   virtual void waitall(int count, request_t array_of_requests[]) const = 0;
 
   virtual void allreduce(const void* sendbuff,
@@ -203,6 +215,21 @@ class comms_iface {
                              op_t op,
                              cudaStream_t stream) const = 0;
 
+  virtual void alltoall(const void* sendbuff,
+                        void* recvbuff,
+                        size_t count,
+                        datatype_t datatype,
+                        cudaStream_t stream) const = 0;
+
+  virtual void alltoallv(const void* sendbuf,
+                         const size_t* sendcounts,
+                         const size_t* sdispls,
+                         void* recvbuf,
+                         const size_t* recvcounts,
+                         const size_t* rdispls,
+                         datatype_t datatype,
+                         cudaStream_t stream) const = 0;
+
   // if a thread is sending & receiving at the same time, use device_sendrecv to avoid deadlock
   virtual void device_send(const void* buf, size_t size, int dest, cudaStream_t stream) const = 0;
 
@@ -324,7 +351,58 @@ class comms_t {
   }
 
   /**
-   * Synchronize on an array of request_t objects returned from isend/irecv
+   * Performs an asynchronous point-to-point send of device memory, ordered after the work
+   * submitted to `stream` before the call.
+   *
+   * Unlike `device_send`, the transfer does not go through NCCL: it is a UCX tag send of the device
+   * buffer (over NVLink, or IB with GPUDirect RDMA when available), so the messages of irregular
+   * sizes do not pay for a NCCL group, and it completes in `waitall()` without synchronizing
+   * `stream`. The buffer must not be modified until then.
+   * @tparam value_t the type of data to send
+   * @param buf pointer to array of device data to send
+   * @param size number of elements in buf
+   * @param dest destination rank
+   * @param tag a tag to use for the receiver to filter
+   * @param request pointer to hold returned request_t object.
+   * 		This will be used in `waitall()` to synchronize until the message is delivered (or fails).
+   * @param stream the stream the data to send is produced on
+   */
+  template <typename value_t>
+  void device_isend(const value_t* buf,
+                    size_t size,
+                    int dest,
+                    int tag,
+                    request_t* request,
+                    cudaStream_t stream) const
+  {
+    impl_->device_isend(
+      static_cast<const void*>(buf), size * sizeof(value_t), dest, tag, request, stream);
+  }
+
+  /**
+   * Performs an asynchronous point-to-point receive into device memory, ordered after the work
+   * submitted to `stream` before the call (see `device_isend`). The data can be used on any stream
+   * once `waitall()` returns.
+   * @tparam value_t the type of data to be received
+   * @param buf pointer to (initialized) array of device memory that will hold received data
+   * @param size number of elements in buf
+   * @param source source rank
+   * @param tag a tag to use for message filtering
+   * @param request pointer to hold returned request_t object.
+   * 		This will be used in `waitall()` to synchronize until the message is delivered (or fails).
+   * @param stream the stream the previous uses of the buffer are on
+   */
+  template <typename value_t>
+  void device_irecv(
+    value_t* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const
+  {
+    impl_->device_irecv(
+      static_cast<void*>(buf), size * sizeof(value_t), source, tag, request, stream);
+  }
+
+  /**
+   * Synchronize on an array of request_t objects returned from isend/irecv or
+   * device_isend/device_irecv
    * @param count number of requests to synchronize on
    * @param array_of_requests an array of request_t objects returned from isend/irecv
    */
@@ -543,6 +621,61 @@ class comms_t {
                          stream);
   }
 
+  /**
+   * Sends a distinct block of data to every rank and receives a block from every rank
+   * @tparam value_t datatype of underlying buffers
+   * @param sendbuff buffer containing the blocks to send, the block for rank r at `r * count`
+   *                 (size count * num_ranks)
+   * @param recvbuff buffer to receive the blocks, the block from rank r at `r * count`
+   *                 (size count * num_ranks)
+   * @param count number of elements sent to and received from each rank
+   * @param stream CUDA stream to synchronize operation
+   */
+  template <typename value_t>
+  void alltoall(const value_t* sendbuff, value_t* recvbuff, size_t count, cudaStream_t stream) const
+  {
+    impl_->alltoall(static_cast<const void*>(sendbuff),
+                    static_cast<void*>(recvbuff),
+                    count,
+                    get_type<value_t>(),
+                    stream);
+  }
+
+  /**
+   * Sends a distinct block of data to every rank and receives a block from every rank, the blocks
+   * having different sizes
+   * @tparam value_t datatype of underlying buffers
+   * @param sendbuf buffer containing the blocks to send
+   * @param sendcounts pointer to an array (of length num_ranks size) containing the number of
+   *                   elements to send to each rank
+   * @param sdispls pointer to an array (of length num_ranks size) to specify the displacement
+   *                (relative to sendbuf) of the data sent to each rank
+   * @param recvbuf buffer to receive the blocks
+   * @param recvcounts pointer to an array (of length num_ranks size) containing the number of
+   *                   elements that are to be received from each rank
+   * @param rdispls pointer to an array (of length num_ranks size) to specify the displacement
+   *                (relative to recvbuf) at which to place the incoming data from each rank
+   * @param stream CUDA stream to synchronize operation
+   */
+  template <typename value_t>
+  void alltoallv(const value_t* sendbuf,
+                 const size_t* sendcounts,
+                 const size_t* sdispls,
+                 value_t* recvbuf,
+                 const size_t* recvcounts,
+                 const size_t* rdispls,
+                 cudaStream_t stream) const
+  {
+    impl_->alltoallv(static_cast<const void*>(sendbuf),
+                     sendcounts,
+                     sdispls,
+                     static_cast<void*>(recvbuf),
+                     recvcounts,
+                     rdispls,
+                     get_type<value_t>(),
+                     stream);
+  }
+
   /**
    * Performs a point-to-point send
    *
@@ -673,6 +806,121 @@ class comms_t {
   std::unique_ptr<comms_iface> impl_;
 };
 
+/**
+ * Overlap of the collectives with the computation producing their inputs.
+ *
+ * The collectives are issued on a dedicated communication stream, each one ordered after the work
+ * submitted to the compute stream before it was issued (through an event), so that the segments of
+ * a buffer can be reduced or gathered while the next ones are still being computed. `wait()` orders
+ * the compute stream after all the collectives issued so far; it is called by the destructor too.
+ *
+ * @code{.cpp}
+ *   raft::comms::collective_pipeline pipeline(comm, stream, comm_stream);
+ *   for (size_t offset = 0; offset < n; offset += chunk) {
+ *     compute(data + offset, chunk, stream);
+ *     pipeline.allreduce(data + offset, data + offset, chunk, raft::comms::op_t::SUM);
+ *   }
+ *   pipeline.wait();
+ * @endcode
+ *
+ * All the ranks must issue the same collectives in the same order, as with the comms_t collectives.
+ * When the two streams are the same, the collectives are simply serialized with the computation.
+ */
+class collective_pipeline {
+ public:
+  /**
+   * @param comms the communicator
+   * @param compute_stream the stream the inputs are computed on, and the outputs used on
+   * @param comm_stream the stream the collectives are issued on
+   */
+  collective_pipeline(comms_t const& comms, cudaStream_t compute_stream, cudaStream_t comm_stream)
+    : comms_(comms), compute_stream_(compute_stream), comm_stream_(comm_stream)
+  {
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&ready_, cudaEventDisableTiming));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&done_, cudaEventDisableTiming));
+  }
+
+  ~collective_pipeline()
+  {
+    if (issued_) { RAFT_CUDA_TRY_NO_THROW(cudaStreamWaitEvent(compute_stream_, done_, 0)); }
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(ready_));
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(done_));
+  }
+
+  collective_pipeline(collective_pipeline const&)            = delete;
+  collective_pipeline& operator=(collective_pipeline const&) = delete;
+
+  /**
+   * Allreduce of a segment, once the work submitted to the compute stream so far has completed.
+   * @tparam value_t datatype of the segment
+   * @param sendbuff data to reduce
+   * @param recvbuff buffer to hold the reduced result
+   * @param count number of elements in the segment
+   * @param op reduction operation to perform
+   */
+  template <typename value_t>
+  void allreduce(const value_t* sendbuff, value_t* recvbuff, size_t count, op_t op)
+  {
+    chain();
+    comms_.allreduce(sendbuff, recvbuff, count, op, comm_stream_);
+    complete();
+  }
+
+  /**
+   * Allgather of the segment [offset, offset + count) of the buffers of `total_count` elements of
+   * all the ranks, once the work submitted to the compute stream so far has completed. After the
+   * segments covering the buffers, `recvbuff` holds the buffer of every rank, in the rank order.
+   * @tparam value_t datatype of the segment
+   * @param sendbuff the segment of the local buffer (i.e. starting at `offset`)
+   * @param recvbuff the output of size `get_size() * total_count`
+   * @param offset the position of the segment in the buffers
+   * @param count number of elements in the segment
+   * @param total_count number of elements in the buffer of each rank
+   */
+  template <typename value_t>
+  void allgather(
+    const value_t* sendbuff, value_t* recvbuff, size_t offset, size_t count, size_t total_count)
+  {
+    int n_ranks = comms_.get_size();
+    recvcounts_.assign(n_ranks, count);
+    displs_.resize(n_ranks);
+    for (int r = 0; r < n_ranks; r++) {
+      displs_[r] = r * total_count + offset;
+    }
+    chain();
+    comms_.allgatherv(sendbuff, recvbuff, recvcounts_.data(), displs_.data(), comm_stream_);
+    complete();
+  }
+
+  /** Order the work submitted to the compute stream after all the collectives issued so far. */
+  void wait()
+  {
+    if (issued_) { RAFT_CUDA_TRY(cudaStreamWaitEvent(compute_stream_, done_, 0)); }
+  }
+
+ private:
+  void chain()
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(ready_, compute_stream_));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(comm_stream_, ready_, 0));
+  }
+
+  void complete()
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(done_, comm_stream_));
+    issued_ = true;
+  }
+
+  comms_t const& comms_;
+  cudaStream_t compute_stream_;
+  cudaStream_t comm_stream_;
+  cudaEvent_t ready_;
+  cudaEvent_t done_;
+  bool issued_ = false;
+  std::vector<size_t> recvcounts_;
+  std::vector<size_t> displs_;
+};
+
 /**
  * @}
  */
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define SPDLOG_HEADER_ONLY
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/sinks/sink.h>
+
+namespace spdlog::sinks {
+
+/**
+ * A sink handing the messages over to a background thread, which passes them to the target sink
+ * (e.g. a CallbackSink) and is the one applying the pattern and doing the output.
+ *
+ * The messages go through a bounded lock-free ring buffer (D. Vyukov's bounded queue), so that
+ * logging never takes a lock nor does I/O on the calling thread. When the buffer is full, the
+ * message is dropped rather than blocking the caller; `dropped()` counts them. `flush()` waits
+ * until the messages logged so far have been passed to the target, then flushes it.
+ */
+class AsyncSink : public sink {
+ public:
+  /**
+   * @param target the sink doing the output, on the background thread
+   * @param capacity the number of messages the buffer can hold, rounded up to a power of two
+   */
+  explicit AsyncSink(std::shared_ptr<sink> target, std::size_t capacity = 8192)
+    : _target{std::move(target)}
+  {
+    std::size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    _mask  = size - 1;
+    _slots = std::make_unique<slot[]>(size);
+    for (std::size_t i = 0; i < size; i++) {
+      _slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    _worker = std::thread([this]() { run(); });
+  }
+
+  ~AsyncSink() override
+  {
+    {
+      std::lock_guard<std::mutex> guard(_wake_mutex);
+      _running.store(false, std::memory_order_release);
+    }
+    _wake.notify_one();
+    _worker.join();
+  }
+
+  AsyncSink(const AsyncSink&)            = delete;
+  AsyncSink& operator=(const AsyncSink&) = delete;
+
+  void log(const details::log_msg& msg) override
+  {
+    auto pos = _head.load(std::memory_order_relaxed);
+    slot* s  = nullptr;
+    while (true) {
+      s         = &_slots[pos & _mask];
+      auto seq  = s->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+      } else if (diff < 0) {
+        // the buffer is full
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      } else {
+        pos = _head.load(std::memory_order_relaxed);
+      }
+    }
+    s->msg = details::log_msg_buffer(msg);
+    s->seq.store(pos + 1, std::memory_order_release);
+  }
+
+  void flush() override
+  {
+    auto target = _head.load(std::memory_order_acquire);
+    _wake.notify_one();
+    while (_tail.load(std::memory_order_acquire) < target) {
+      std::this_thread::yield();
+    }
+    _target->flush();
+  }
+
+  void set_pattern(const std::string& pattern) override { _target->set_pattern(pattern); }
+
+  void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override
+  {
+    _target->set_formatter(std::move(sink_formatter));
+  }
+
+  /** The number of messages dropped because the buffer was full. */
+  std::size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+ private:
+  struct slot {
+    std::atomic<std::size_t> seq;
+    details::log_msg_buffer msg;
+  };
+
+  /** How long the background thread sleeps when there is nothing to do. */
+  static constexpr std::chrono::milliseconds kPollInterval{2};
+
+  /** Pass the messages to the target until the sink is destroyed, then the remaining ones. */
+  void run()
+  {
+    auto pos = _tail.load(std::memory_order_relaxed);
+    while (true) {
+      auto& s = _slots[pos & _mask];
+      if (s.seq.load(std::memory_order_acquire) == pos + 1) {
+        try {
+          _target->log(s.msg);
+        } catch (...) {
+          // a failing output must not terminate the process from the background thread
+        }
+        s.msg = details::log_msg_buffer{};
+        s.seq.store(pos + _mask + 1, std::memory_order_release);
+        _tail.store(++pos, std::memory_order_release);
+        continue;
+      }
+      if (!_running.load(std::memory_order_acquire)) { break; }
+      std::unique_lock<std::mutex> lock(_wake_mutex);
+      _wake.wait_for(lock, kPollInterval);
+    }
+  }
+
+  std::shared_ptr<sink> _target;
+  std::unique_ptr<slot[]> _slots;
+  std::size_t _mask;
+  alignas(64) std::atomic<std::size_t> _head{0};
+  alignas(64) std::atomic<std::size_t> _tail{0};
+  std::atomic<std::size_t> _dropped{0};
+  std::atomic<bool> _running{true};
+  std::mutex _wake_mutex;
+  std::condition_variable _wake;
+  std::thread _worker;
+};
+
+}  // end namespace spdlog::sinks
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cuda_runtime.h>
+
+#ifdef RAFT_CUFILE_ENABLED
+#include <cufile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <string>
+
+namespace raft::detail {
+
+/**
+ * Whether raft was built with GPUDirect Storage (`RAFT_CUFILE`) and the cuFile driver could be
+ * opened. The driver is opened once per process and closed at exit.
+ */
+inline auto cufile_available() -> bool
+{
+#ifdef RAFT_CUFILE_ENABLED
+  static const bool opened = cuFileDriverOpen().err == CU_FILE_SUCCESS;
+  return opened;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Transfer `n_bytes` between device memory and a file at `offset` with GPUDirect Storage, i.e.
+ * without staging through host memory.
+ *
+ * The pending work of `stream` is waited for first, since cuFile is not ordered with the streams.
+ * The file is opened with `O_DIRECT` when the file system allows it; the transfers are fastest
+ * when `offset` and `n_bytes` are multiples of 4 KiB. When GDS is not available (not built with
+ * `RAFT_CUFILE`, no driver, or a file system it cannot handle), nothing is done and the function
+ * returns false, so that the caller can fall back to a copy through host memory.
+ *
+ * @param[in] filename the file, which must exist
+ * @param[in] write whether to write the device memory to the file (or read it from the file)
+ * @param[inout] dev_ptr the device memory
+ * @param[in] n_bytes the number of bytes to transfer
+ * @param[in] offset the position in the file
+ * @param[in] stream the stream that produces or consumes the device memory
+ * @return whether the transfer was done
+ */
+inline auto cufile_transfer(const std::string& filename,
+                            bool write,
+                            void* dev_ptr,
+                            uint64_t n_bytes,
+                            uint64_t offset,
+                            cudaStream_t stream) -> bool
+{
+#ifdef RAFT_CUFILE_ENABLED
+  if (n_bytes == 0 || !cufile_available()) { return false; }
+  const int flags = write ? O_WRONLY : O_RDONLY;
+  int fd          = ::open(filename.c_str(), flags | O_DIRECT);
+  if (fd < 0) { fd = ::open(filename.c_str(), flags); }
+  if (fd < 0) { return false; }
+  CUfileDescr_t descr{};
+  descr.handle.fd = fd;
+  descr.type      = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+  CUfileHandle_t handle;
+  if (cuFileHandleRegister(&handle, &descr).err != CU_FILE_SUCCESS) {
+    ::close(fd);
+    return false;
+  }
+  RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  bool done = true;
+  for (uint64_t pos = 0; pos < n_bytes;) {
+    const auto n = write ? cuFileWrite(handle, dev_ptr, n_bytes - pos, offset + pos, pos)
+                         : cuFileRead(handle, dev_ptr, n_bytes - pos, offset + pos, pos);
+    if (n <= 0) {
+      done = false;
+      break;
+    }
+    pos += n;
+  }
+  cuFileHandleDeregister(handle);
+  ::close(fd);
+  return done;
+#else
+  return false;
+#endif
+}
+
+}  // namespace raft::detail
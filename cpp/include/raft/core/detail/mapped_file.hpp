@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace raft::detail {
+
+/** Read-only memory mapping of a whole file. */
+class mapped_file {
+ public:
+  explicit mapped_file(const std::string& filename)
+  {
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+      ::close(fd_);
+      RAFT_FAIL("Cannot stat file %s", filename.c_str());
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+      void* ptr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+      if (ptr == MAP_FAILED) {
+        ::close(fd_);
+        RAFT_FAIL("Cannot map file %s", filename.c_str());
+      }
+      data_ = static_cast<const uint8_t*>(ptr);
+    }
+  }
+
+  ~mapped_file() noexcept
+  {
+    if (data_ != nullptr) { ::munmap(const_cast<uint8_t*>(data_), size_); }
+    if (fd_ >= 0) { ::close(fd_); }
+  }
+
+  mapped_file(const mapped_file&)            = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  [[nodiscard]] auto data() const noexcept -> const uint8_t* { return data_; }
+  [[nodiscard]] auto size() const noexcept -> size_t { return size_; }
+
+ private:
+  int fd_              = -1;
+  const uint8_t* data_ = nullptr;
+  size_t size_         = 0;
+};
+
+/** A file descriptor closed at the end of its lifetime, with positional reads and writes. */
+class file_descriptor {
+ public:
+  file_descriptor(const std::string& filename, int flags, mode_t mode = 0644)
+    : filename_(filename), fd_(::open(filename.c_str(), flags, mode))
+  {
+    if (fd_ < 0) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+  }
+
+  ~file_descriptor() noexcept
+  {
+    if (fd_ >= 0) { ::close(fd_); }
+  }
+
+  file_descriptor(const file_descriptor&)            = delete;
+  file_descriptor& operator=(const file_descriptor&) = delete;
+
+  /** Write `n_bytes` at `offset`, with as few system calls as the kernel allows. */
+  void write_all(const void* src, size_t n_bytes, uint64_t offset) const
+  {
+    auto* ptr = static_cast<const char*>(src);
+    while (n_bytes > 0) {
+      const auto n = ::pwrite(fd_, ptr, n_bytes, static_cast<off_t>(offset));
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n <= 0) { RAFT_FAIL("Error writing %zu bytes to %s", n_bytes, filename_.c_str()); }
+      ptr += n;
+      offset += n;
+      n_bytes -= n;
+    }
+  }
+
+  /** Read `n_bytes` at `offset`, with as few system calls as the kernel allows. */
+  void read_all(void* dst, size_t n_bytes, uint64_t offset) const
+  {
+    auto* ptr = static_cast<char*>(dst);
+    while (n_bytes > 0) {
+      const auto n = ::pread(fd_, ptr, n_bytes, static_cast<off_t>(offset));
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n <= 0) { RAFT_FAIL("Cannot read %zu bytes of %s", n_bytes, filename_.c_str()); }
+      ptr += n;
+      offset += n;
+      n_bytes -= n;
+    }
+  }
+
+  [[nodiscard]] auto size() const -> uint64_t
+  {
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) { RAFT_FAIL("Cannot stat file %s", filename_.c_str()); }
+    return static_cast<uint64_t>(st.st_size);
+  }
+
+ private:
+  std::string filename_;
+  int fd_ = -1;
+};
+
+}  // namespace raft::detail
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/cufile.hpp>
+#include <raft/core/detail/mapped_file.hpp>
+#include <raft/core/detail/mdspan_numpy_serializer.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resource/cuda_event.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace raft::detail::numpy_serializer {
+
+/*
+ * Whole files in the NumPy format (`.npy`), written and read with a few large positional I/O
+ * calls rather than through a stream. The header is padded to a multiple of 64 bytes, so that
+ * the payload of a mapped file is suitably aligned for any element type.
+ */
+
+/** Size of the pinned buffers staging the device arrays. */
+constexpr uint64_t kFileStagingChunkSize = 64 * 1024 * 1024;
+
+/** The NumPy preamble (magic string, version and header) of an array. */
+template <typename ElementType, typename LayoutPolicy, typename Extents>
+inline auto make_file_header(const Extents& extents) -> std::string
+{
+  static_assert(std::is_same_v<LayoutPolicy, raft::layout_c_contiguous> ||
+                  std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>,
+                "The serializer only supports row-major and column-major layouts");
+  std::vector<ndarray_len_t> shape;
+  for (typename Extents::rank_type i = 0; i < extents.rank(); ++i) {
+    shape.push_back(extents.extent(i));
+  }
+  const header_t header = {get_numpy_dtype<ElementType>(),
+                           std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>,
+                           shape};
+  std::ostringstream os;
+  write_header(os, header);
+  return os.str();
+}
+
+/**
+ * Read the header of a NumPy file, check that it holds an array of `ElementType` with the layout
+ * `LayoutPolicy` and the static extents of `Extents`, and return the extents of the array and the
+ * offset of its payload.
+ */
+template <typename ElementType, typename Extents, typename LayoutPolicy>
+inline auto read_file_header(const std::string& filename) -> std::pair<Extents, uint64_t>
+{
+  std::ifstream is(filename, std::ios::in | std::ios::binary);
+  if (!is) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+  const header_t header             = read_header(is);
+  const auto expected_dtype         = get_numpy_dtype<ElementType>();
+  const bool expected_fortran_order = std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>;
+  RAFT_EXPECTS(header.dtype == expected_dtype,
+               "Expected dtype %s but got %s instead",
+               expected_dtype.to_string().c_str(),
+               header.dtype.to_string().c_str());
+  RAFT_EXPECTS(header.fortran_order == expected_fortran_order,
+               "Wrong matrix layout; expected %s but got a different layout",
+               (expected_fortran_order ? "Fortran layout" : "C layout"));
+  RAFT_EXPECTS(Extents::rank() == header.shape.size(),
+               "Incorrect rank: expected %zu but got %zu",
+               static_cast<size_t>(Extents::rank()),
+               header.shape.size());
+  std::array<typename Extents::index_type, Extents::rank()> dims{};
+  for (typename Extents::rank_type i = 0; i < Extents::rank(); ++i) {
+    RAFT_EXPECTS(Extents::static_extent(i) == std::experimental::dynamic_extent ||
+                   static_cast<ndarray_len_t>(Extents::static_extent(i)) == header.shape[i],
+                 "Incorrect dimension: expected %zu but got %zu",
+                 static_cast<size_t>(Extents::static_extent(i)),
+                 static_cast<size_t>(header.shape[i]));
+    dims[i] = static_cast<typename Extents::index_type>(header.shape[i]);
+  }
+  return {Extents{dims}, static_cast<uint64_t>(is.tellg())};
+}
+
+/** Check that the file has the extents of the destination array, and return the payload offset. */
+template <typename ElementType, typename LayoutPolicy, typename Extents>
+inline auto check_file_header(const std::string& filename, const Extents& extents) -> uint64_t
+{
+  auto [file_extents, offset] = read_file_header<ElementType, Extents, LayoutPolicy>(filename);
+  for (typename Extents::rank_type i = 0; i < extents.rank(); ++i) {
+    RAFT_EXPECTS(file_extents.extent(i) == extents.extent(i),
+                 "Incorrect dimension: expected %zu but got %zu",
+                 static_cast<size_t>(extents.extent(i)),
+                 static_cast<size_t>(file_extents.extent(i)));
+  }
+  return offset;
+}
+
+/**
+ * Copy a device buffer to a file through two pinned staging buffers: one is written to the file
+ * while the next chunk is being copied into the other one.
+ */
+inline void write_device_bytes(const raft::resources& res,
+                               const file_descriptor& fd,
+                               const void* src,
+                               uint64_t n_bytes,
+                               uint64_t offset)
+{
+  if (n_bytes == 0) { return; }
+  auto stream      = resource::get_cuda_stream(res);
+  const auto chunk = std::min(kFileStagingChunkSize, n_bytes);
+  rmm::device_uvector<uint8_t> staging(
+    2 * chunk, stream, resource::get_pinned_workspace_resource(res));
+  auto copy_chunk = [&](uint64_t pos) {
+    auto* buf = staging.data() + ((pos / chunk) % 2) * chunk;
+    raft::copy(buf, static_cast<const uint8_t*>(src) + pos, std::min(chunk, n_bytes - pos), stream);
+  };
+  copy_chunk(0);
+  for (uint64_t pos = 0; pos < n_bytes; pos += chunk) {
+    resource::sync_stream(res);
+    // The other buffer was written to the file in the previous iteration.
+    if (pos + chunk < n_bytes) { copy_chunk(pos + chunk); }
+    fd.write_all(
+      staging.data() + ((pos / chunk) % 2) * chunk, std::min(chunk, n_bytes - pos), offset + pos);
+  }
+  resource::sync_stream(res);
+}
+
+/**
+ * Copy a part of a file to a device buffer through two pinned staging buffers: one is read from
+ * the file while the other one is being copied to the device.
+ */
+inline void read_device_bytes(const raft::resources& res,
+                              const file_descriptor& fd,
+                              void* dst,
+                              uint64_t n_bytes,
+                              uint64_t offset)
+{
+  if (n_bytes == 0) { return; }
+  auto stream      = resource::get_cuda_stream(res);
+  const auto chunk = std::min(kFileStagingChunkSize, n_bytes);
+  rmm::device_uvector<uint8_t> staging(
+    2 * chunk, stream, resource::get_pinned_workspace_resource(res));
+  std::array<resource::cuda_event_resource, 2> copied;
+  auto event = [&copied](uint64_t i) {
+    return *static_cast<cudaEvent_t*>(copied[i % 2].get_resource());
+  };
+  // The pinned workspace may hand out memory that earlier work on the stream still uses.
+  resource::sync_stream(res);
+  for (uint64_t pos = 0, i = 0; pos < n_bytes; pos += chunk, i++) {
+    const auto n = std::min(chunk, n_bytes - pos);
+    auto* buf    = staging.data() + (i % 2) * chunk;
+    // Wait until the copy issued from this buffer two chunks ago has finished.
+    if (i >= 2) { RAFT_CUDA_TRY(cudaEventSynchronize(event(i))); }
+    fd.read_all(buf, n, offset + pos);
+    raft::copy(static_cast<uint8_t*>(dst) + pos, buf, n, stream);
+    RAFT_CUDA_TRY(cudaEventRecord(event(i), stream));
+  }
+  resource::sync_stream(res);
+}
+
+template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
+inline void serialize_mdspan_file(
+  const raft::resources& res,
+  const std::string& filename,
+  const raft::mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+{
+  using value_type  = std::remove_cv_t<ElementType>;
+  const auto header = make_file_header<value_type, LayoutPolicy>(obj.extents());
+  // For contiguous layouts, size() == product of dimensions
+  const uint64_t n_bytes = obj.size() * sizeof(value_type);
+  file_descriptor fd(filename, O_WRONLY | O_CREAT | O_TRUNC);
+  fd.write_all(header.data(), header.size(), 0);
+  if constexpr (AccessorPolicy::is_device_accessible && !AccessorPolicy::is_host_accessible) {
+    // GPUDirect Storage when available, otherwise through pinned host buffers
+    if (!cufile_transfer(filename,
+                         true,
+                         const_cast<value_type*>(obj.data_handle()),
+                         n_bytes,
+                         header.size(),
+                         resource::get_cuda_stream(res))) {
+      write_device_bytes(res, fd, obj.data_handle(), n_bytes, header.size());
+    }
+  } else {
+    fd.write_all(obj.data_handle(), n_bytes, header.size());
+  }
+}
+
+template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
+inline void deserialize_mdspan_file(
+  const raft::resources& res,
+  const std::string& filename,
+  const raft::mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+{
+  const auto offset      = check_file_header<ElementType, LayoutPolicy>(filename, obj.extents());
+  const uint64_t n_bytes = obj.size() * sizeof(ElementType);
+  file_descriptor fd(filename, O_RDONLY);
+  RAFT_EXPECTS(fd.size() >= offset + n_bytes, "File %s is truncated", filename.c_str());
+  if constexpr (AccessorPolicy::is_device_accessible && !AccessorPolicy::is_host_accessible) {
+    if (!cufile_transfer(
+          filename, false, obj.data_handle(), n_bytes, offset, resource::get_cuda_stream(res))) {
+      read_device_bytes(res, fd, obj.data_handle(), n_bytes, offset);
+    }
+  } else {
+    fd.read_all(obj.data_handle(), n_bytes, offset);
+  }
+}
+
+}  // namespace raft::detail::numpy_serializer
@@ -24,9 +24,18 @@
 #include <rmm/mr/device/cuda_memory_resource.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
 
+#include <cuda_runtime_api.h>
+
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace raft {
 
@@ -89,6 +98,7 @@ struct device_resources_manager {
   {
     // Ensure that we destroy any pool memory resources before CUDA context is
     // lost
+    dispatch_slots_.clear();
     per_device_components_.clear();
   }
 
@@ -215,9 +225,19 @@ struct device_resources_manager {
       if (stream_count() != 0) { result = streams_->get_stream(get_thread_id() % stream_count()); }
       return result;
     }
+    // Get a primary stream by its index, or the default stream per thread if no stream count was
+    // set
+    [[nodiscard]] auto get_stream_by_index(std::size_t index) const
+    {
+      auto result = rmm::cuda_stream_per_thread;
+      if (stream_count() != 0) { result = streams_->get_stream(index % stream_count()); }
+      return result;
+    }
     // Get the total number of stream pools available for this
     // application
     [[nodiscard]] auto pool_count() const { return pools_.size(); }
+    // Get a stream pool by its index
+    [[nodiscard]] auto get_pool_by_index(std::size_t index) const { return pools_[index]; }
     // Get the stream pool assigned to this host thread. Note that the same stream pool
     // may be used by multiple threads, but any given thread will always use
     // the same stream pool
@@ -250,6 +270,104 @@ struct device_resources_manager {
     std::optional<std::size_t> workspace_allocation_limit_{std::nullopt};
   };
 
+  // A stream to which `dispatch` may submit work, with the work in flight on it: the number of
+  // submissions running on the host and the completion events of those already enqueued.
+  struct dispatch_slot {
+    dispatch_slot(int device_id,
+                  std::size_t index,
+                  rmm::cuda_stream_view stream,
+                  std::vector<std::shared_ptr<rmm::cuda_stream_pool>> pools,
+                  std::shared_ptr<rmm::mr::device_memory_resource> workspace_mr,
+                  std::optional<std::size_t> workspace_allocation_limit)
+      : device_id_{device_id},
+        index_{index},
+        stream_{stream},
+        pools_{std::move(pools)},
+        workspace_mr_{std::move(workspace_mr)},
+        workspace_allocation_limit_{workspace_allocation_limit}
+    {
+    }
+    dispatch_slot(dispatch_slot const&)            = delete;
+    dispatch_slot& operator=(dispatch_slot const&) = delete;
+    ~dispatch_slot()
+    {
+      auto scoped_device = device_setter{device_id_};
+      for (auto event : pending_) {
+        RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(event));
+      }
+      for (auto event : free_events_) {
+        RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(event));
+      }
+    }
+
+    // The number of submissions in flight on this slot. Completed events are recycled on the way.
+    [[nodiscard]] auto load()
+    {
+      auto lock = std::unique_lock{mutex_};
+      while (!pending_.empty() && cudaEventQuery(pending_.front()) == cudaSuccess) {
+        free_events_.push_back(pending_.front());
+        pending_.pop_front();
+      }
+      return active_ + pending_.size();
+    }
+
+    void begin()
+    {
+      auto lock = std::unique_lock{mutex_};
+      ++active_;
+    }
+
+    // Mark the end of a submission with an event recorded on the stream of the slot. This does
+    // not throw, as it also runs when the submission throws; if the event cannot be recorded, the
+    // work of the submission is simply not accounted for.
+    void end() noexcept
+    {
+      auto lock = std::unique_lock{mutex_};
+      --active_;
+      auto event = cudaEvent_t{};
+      if (free_events_.empty()) {
+        if (cudaEventCreateWithFlags(&event, cudaEventDisableTiming) != cudaSuccess) { return; }
+      } else {
+        event = free_events_.back();
+        free_events_.pop_back();
+      }
+      if (cudaEventRecord(event, stream_) == cudaSuccess) {
+        pending_.push_back(event);
+      } else {
+        free_events_.push_back(event);
+      }
+    }
+
+    // The device_resources of the calling thread for this slot
+    [[nodiscard]] auto const& get_device_resources() const
+    {
+      thread_local auto thread_resources =
+        std::map<std::pair<int, std::size_t>, std::unique_ptr<raft::device_resources>>{};
+      auto& result = thread_resources[std::make_pair(device_id_, index_)];
+      if (!result) {
+        auto pool = std::shared_ptr<rmm::cuda_stream_pool>{nullptr};
+        if (!pools_.empty()) { pool = pools_[get_thread_id() % pools_.size()]; }
+        result = std::make_unique<raft::device_resources>(
+          stream_, pool, workspace_mr_, workspace_allocation_limit_);
+      }
+      return *result;
+    }
+
+    [[nodiscard]] auto get_device_id() const { return device_id_; }
+
+   private:
+    int device_id_;
+    std::size_t index_;
+    rmm::cuda_stream_view stream_;
+    std::vector<std::shared_ptr<rmm::cuda_stream_pool>> pools_;
+    std::shared_ptr<rmm::mr::device_memory_resource> workspace_mr_;
+    std::optional<std::size_t> workspace_allocation_limit_;
+    std::mutex mutex_{};
+    std::size_t active_{};
+    std::deque<cudaEvent_t> pending_{};
+    std::vector<cudaEvent_t> free_events_{};
+  };
+
   // Mutex used to lock access to shared data until after the first
   // `get_device_resources` call in each thread
   mutable std::mutex manager_mutex_{};
@@ -259,6 +377,9 @@ struct device_resources_manager {
   // Container for underlying device resources to be re-used across host
   // threads for each device
   std::vector<resource_components> per_device_components_;
+  // The streams of each device used by `dispatch`, indexed by device id; built on first use
+  std::vector<std::vector<std::unique_ptr<dispatch_slot>>> dispatch_slots_;
+  std::atomic<bool> dispatch_slots_ready_{};
 
   // Return a lock for accessing shared data
   [[nodiscard]] auto get_lock() const { return std::unique_lock{manager_mutex_}; }
@@ -284,32 +405,98 @@ struct device_resources_manager {
       // resource parameters.
       params_finalized_ = true;
 
-      // Even if we have not yet built device_resources for the current
-      // device, we may have already built the underlying components, since
-      // multiple device_resources may point to the same components.
-      auto component_iter = std::find_if(
-        std::begin(per_device_components_),
-        std::end(per_device_components_),
-        [device_id](auto&& components) { return components.get_device_id() == device_id; });
-
-      if (component_iter == std::end(per_device_components_)) {
-        // Build components for this device if we have not yet done so on
-        // another thread
-        per_device_components_.emplace_back(device_id, params_);
-        component_iter = std::prev(std::end(per_device_components_));
-      }
+      auto& components   = get_components_(device_id);
       auto scoped_device = device_setter(device_id);
       // Build the device_resources object for this thread out of shared
       // components
-      thread_resources[device_id].emplace(component_iter->get_stream(),
-                                          component_iter->get_pool(),
-                                          component_iter->get_workspace_memory_resource(),
-                                          component_iter->get_workspace_allocation_limit());
+      thread_resources[device_id].emplace(components.get_stream(),
+                                          components.get_pool(),
+                                          components.get_workspace_memory_resource(),
+                                          components.get_workspace_allocation_limit());
     }
 
     return thread_resources[device_id].value();
   }
 
+  // Retrieve the underlying resources of a device, building them if needed. The manager lock must
+  // be held by the caller.
+  auto& get_components_(int device_id)
+  {
+    // Even if we have not yet built device_resources for the current
+    // device, we may have already built the underlying components, since
+    // multiple device_resources may point to the same components.
+    auto component_iter = std::find_if(
+      std::begin(per_device_components_),
+      std::end(per_device_components_),
+      [device_id](auto&& components) { return components.get_device_id() == device_id; });
+
+    if (component_iter == std::end(per_device_components_)) {
+      // Build components for this device if we have not yet done so on
+      // another thread
+      per_device_components_.emplace_back(device_id, params_);
+      component_iter = std::prev(std::end(per_device_components_));
+    }
+    return *component_iter;
+  }
+
+  // Build the dispatch slots of all the devices: one per primary stream, or a single one using
+  // the default stream per thread if no stream count was set.
+  void init_dispatch_slots_()
+  {
+    if (dispatch_slots_ready_.load(std::memory_order_acquire)) { return; }
+    auto lock = get_lock();
+    if (dispatch_slots_ready_.load(std::memory_order_relaxed)) { return; }
+    params_finalized_ = true;
+    auto device_count = 0;
+    RAFT_CUDA_TRY(cudaGetDeviceCount(&device_count));
+    RAFT_EXPECTS(device_count != 0, "No CUDA devices found");
+    dispatch_slots_.resize(device_count);
+    for (auto device_id = 0; device_id < device_count; ++device_id) {
+      auto& components = get_components_(device_id);
+      auto pools       = std::vector<std::shared_ptr<rmm::cuda_stream_pool>>{};
+      for (auto i = std::size_t{}; i < components.pool_count(); ++i) {
+        pools.push_back(components.get_pool_by_index(i));
+      }
+      auto n_streams = std::max<std::size_t>(components.stream_count(), 1);
+      for (auto i = std::size_t{}; i < n_streams; ++i) {
+        dispatch_slots_[device_id].push_back(
+          std::make_unique<dispatch_slot>(device_id,
+                                          i,
+                                          components.get_stream_by_index(i),
+                                          pools,
+                                          components.get_workspace_memory_resource(),
+                                          components.get_workspace_allocation_limit()));
+      }
+    }
+    dispatch_slots_ready_.store(true, std::memory_order_release);
+  }
+
+  // Choose the slot with the least work in flight, among the slots of one or all the devices.
+  // Ties go to different slots for different threads.
+  auto& select_dispatch_slot_(std::optional<int> device_id)
+  {
+    init_dispatch_slots_();
+    auto candidates = std::vector<dispatch_slot*>{};
+    for (auto& slots : dispatch_slots_) {
+      for (auto& slot : slots) {
+        if (!device_id || slot->get_device_id() == *device_id) { candidates.push_back(slot.get()); }
+      }
+    }
+    RAFT_EXPECTS(!candidates.empty(), "Invalid device id");
+    auto offset = get_thread_id();
+    auto* best  = candidates[offset % candidates.size()];
+    auto least  = best->load();
+    for (auto i = std::size_t{1}; i < candidates.size() && least != 0; ++i) {
+      auto* slot = candidates[(offset + i) % candidates.size()];
+      auto load  = slot->load();
+      if (load < least) {
+        best  = slot;
+        least = load;
+      }
+    }
+    return *best;
+  }
+
   // Thread-safe setter for the number of streams
   void set_streams_per_device_(std::optional<std::size_t> num_streams)
   {
@@ -436,6 +623,53 @@ struct device_resources_manager {
     return get_manager().get_device_resources_(device_id);
   }
 
+  /**
+   * @brief Run work on the least loaded stream of one or all the devices
+   *
+   * `dispatch` calls `f` on the calling thread with the `device_resources` of the stream with the
+   * least work in flight, and returns its result. The device of that stream is current during the
+   * call. The work in flight on a stream is the number of `dispatch` calls currently running `f`
+   * for it plus the number of those whose work enqueued on the stream has not completed yet, as
+   * tracked by an event recorded on the stream after each call. Unlike `get_device_resources`,
+   * which pins each host thread to a stream, this evens out the load when some threads submit
+   * much more work than others.
+   *
+   * The streams are the primary streams of each device (see `set_streams_per_device`). If no
+   * stream count was set, each device has a single slot using the default stream per thread, and
+   * only the devices are balanced. Work submitted by `f` to other streams (e.g. to the stream
+   * pool) is not tracked, unless `f` joins them back to the main stream.
+   *
+   * @code
+   * raft::device_resources_manager::set_streams_per_device(4);
+   * // on any thread
+   * raft::device_resources_manager::dispatch([&](raft::device_resources const& res) {
+   *   raft::neighbors::cagra::search(res, params, index, queries, neighbors, distances);
+   * });
+   * @endcode
+   *
+   * Note that the outputs of `f` are ready only after its stream has been synchronized, e.g. by
+   * calling `res.sync_stream()` in `f`.
+   *
+   * @param f callable taking a `raft::device_resources const&`
+   * @param device_id If provided, the device whose streams are considered. Defaults to all the
+   * devices.
+   */
+  template <typename F>
+  static auto dispatch(F&& f, std::optional<int> device_id = std::nullopt)
+    -> std::invoke_result_t<F, raft::device_resources const&>
+  {
+    auto& slot         = get_manager().select_dispatch_slot_(device_id);
+    auto scoped_device = device_setter{slot.get_device_id()};
+    auto const& res    = slot.get_device_resources();
+    slot.begin();
+    // Record the completion event even if f throws, so that the slot stays balanced.
+    struct end_guard {
+      dispatch_slot& slot;
+      ~end_guard() { slot.end(); }
+    } guard{slot};
+    return std::forward<F>(f)(res);
+  }
+
   /**
    * @brief Set the total number of CUDA streams to be used per device
    *
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace raft {
+
+/**
+ * @defgroup host_thread_pool Host thread pool
+ * @{
+ */
+
+/**
+ * @brief A work-stealing pool of host threads for the host phases of the algorithms.
+ *
+ * Unlike the independent OpenMP parallel regions, which start a team of `omp_get_max_threads()`
+ * threads per calling thread, all the loops submitted to one pool share its fixed set of threads;
+ * the concurrent callers (e.g. many serving threads) divide the cores among themselves instead of
+ * oversubscribing them.
+ *
+ * A parallel loop is split into a few chunks per thread, and a ticket of the loop is pushed to the
+ * deques of the workers. A worker runs the tickets from its own deque and, once that is empty,
+ * steals them from the others; every thread holding a ticket (and the caller itself) claims the
+ * chunks of the loop one by one until none is left, so the loop balances itself. The caller only
+ * helps with its own loop, hence the nested loops do not deadlock, and the thread index passed to
+ * the chunks is unique within a loop.
+ *
+ * The pool is attached to `raft::resources` by `raft::resource::set_host_thread_pool`; by default,
+ * all resources share `host_thread_pool::default_pool()`.
+ */
+class host_thread_pool {
+ public:
+  /** The number of chunks per thread a loop is split into (for the load balancing). */
+  static constexpr int64_t kChunksPerThread = 4;
+
+  /**
+   * @param n_threads the thread budget, including the calling thread (hence, the pool starts
+   *   `n_threads - 1` workers); zero means the number of the hardware threads.
+   */
+  explicit host_thread_pool(size_t n_threads = 0)
+  {
+    if (n_threads == 0) { n_threads = std::max<size_t>(1, std::thread::hardware_concurrency()); }
+    for (size_t i = 1; i < n_threads; i++) {
+      queues_.emplace_back(std::make_unique<ticket_queue>());
+    }
+    for (size_t i = 1; i < n_threads; i++) {
+      workers_.emplace_back([this, i]() { work(i); });
+    }
+  }
+
+  host_thread_pool(const host_thread_pool&)                    = delete;
+  auto operator=(const host_thread_pool&) -> host_thread_pool& = delete;
+
+  ~host_thread_pool() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto& w : workers_) {
+      w.join();
+    }
+  }
+
+  /** The process-wide pool with a thread per hardware thread. */
+  static auto default_pool() -> std::shared_ptr<host_thread_pool>
+  {
+    static auto pool = std::make_shared<host_thread_pool>();
+    return pool;
+  }
+
+  /** The maximum number of threads working on a loop (the workers and the caller). */
+  [[nodiscard]] auto n_threads() const noexcept -> size_t { return workers_.size() + 1; }
+
+  /**
+   * @brief Run `f(chunk_begin, chunk_end, thread_index)` over the chunks of [begin, end).
+   *
+   * The chunks are at least `grain` long (except the last). The `thread_index` is in
+   * [0, n_threads()) and no two chunks running at the same time share it, so it can address the
+   * per-thread buffers of the loop. The first exception thrown by `f` is rethrown by the caller
+   * once the running chunks finish; the chunks not started by then are skipped.
+   */
+  template <typename Func>
+  void parallel_for_chunks(int64_t begin, int64_t end, Func&& f, int64_t grain = 1)
+  {
+    if (end <= begin) { return; }
+    const int64_t n          = end - begin;
+    const size_t caller      = current_thread_index();
+    const int64_t max_chunks = static_cast<int64_t>(n_threads()) * kChunksPerThread;
+    grain                    = std::max<int64_t>(grain, 1);
+    const int64_t n_chunks   = std::min<int64_t>((n + grain - 1) / grain, max_chunks);
+    if (n_chunks <= 1 || workers_.empty()) { return f(begin, end, caller); }
+
+    auto j       = std::make_shared<job>();
+    j->n_chunks  = n_chunks;
+    j->run_chunk = [&f, begin, n, n_chunks](int64_t c, size_t thread_index) {
+      f(begin + n * c / n_chunks, begin + n * (c + 1) / n_chunks, thread_index);
+    };
+    // The caller takes a part of the work, hence one ticket less than the chunks is enough
+    const auto n_tickets = std::min<size_t>(n_chunks - 1, workers_.size());
+    for (size_t t = 0; t < n_tickets; t++) {
+      auto& q = *queues_[next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tickets.push_back(j);
+      n_tickets_++;
+    }
+    // Lock-unlock, so that a worker checking for the tickets right now does not miss the wake-up
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    sleep_cv_.notify_all();
+
+    j->help(caller);
+    {
+      std::unique_lock<std::mutex> lock(j->mutex);
+      j->cv.wait(lock, [&j]() { return j->done.load() == j->n_chunks; });
+    }
+    if (j->error) { std::rethrow_exception(j->error); }
+  }
+
+  /** Run `f(i)` for every `i` in [begin, end); see `parallel_for_chunks`. */
+  template <typename Func>
+  void parallel_for(int64_t begin, int64_t end, Func&& f, int64_t grain = 1)
+  {
+    parallel_for_chunks(
+      begin,
+      end,
+      [&f](int64_t chunk_begin, int64_t chunk_end, size_t) {
+        for (int64_t i = chunk_begin; i < chunk_end; i++) {
+          f(i);
+        }
+      },
+      grain);
+  }
+
+ private:
+  /** A parallel loop: its chunks are claimed by the threads holding the tickets. */
+  struct job {
+    std::function<void(int64_t, size_t)> run_chunk;
+    int64_t n_chunks = 0;
+    std::atomic<int64_t> next{0};
+    std::atomic<int64_t> done{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    void help(size_t thread_index)
+    {
+      for (int64_t c = next.fetch_add(1); c < n_chunks; c = next.fetch_add(1)) {
+        if (!failed.load(std::memory_order_relaxed)) {
+          try {
+            run_chunk(c, thread_index);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) { error = std::current_exception(); }
+            failed = true;
+          }
+        }
+        if (done.fetch_add(1) + 1 == n_chunks) {
+          std::lock_guard<std::mutex> lock(mutex);
+          cv.notify_all();
+        }
+      }
+    }
+  };
+
+  struct ticket_queue {
+    std::mutex mutex;
+    std::deque<std::shared_ptr<job>> tickets;
+  };
+
+  struct thread_state {
+    const host_thread_pool* pool = nullptr;
+    size_t index                 = 0;
+  };
+
+  static auto this_thread_state() -> thread_state&
+  {
+    thread_local thread_state state;
+    return state;
+  }
+
+  /** The index of a worker of this pool, or zero for the other threads. */
+  [[nodiscard]] auto current_thread_index() const -> size_t
+  {
+    auto& state = this_thread_state();
+    return state.pool == this ? state.index : 0;
+  }
+
+  /** Take a ticket from the own deque (the newest) or steal one from another (the oldest). */
+  auto take_ticket(size_t index) -> std::shared_ptr<job>
+  {
+    const size_t n_queues = queues_.size();
+    for (size_t k = 0; k < n_queues; k++) {
+      auto& q = *queues_[(index - 1 + k) % n_queues];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.tickets.empty()) { continue; }
+      std::shared_ptr<job> j;
+      if (k == 0) {
+        j = std::move(q.tickets.back());
+        q.tickets.pop_back();
+      } else {
+        j = std::move(q.tickets.front());
+        q.tickets.pop_front();
+      }
+      n_tickets_--;
+      return j;
+    }
+    return nullptr;
+  }
+
+  void work(size_t index)
+  {
+    this_thread_state() = thread_state{this, index};
+    while (true) {
+      if (auto j = take_ticket(index); j) {
+        j->help(index);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      sleep_cv_.wait(lock, [this]() { return stop_ || n_tickets_.load() > 0; });
+      if (stop_) { return; }
+    }
+  }
+
+  std::vector<std::unique_ptr<ticket_queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<size_t> n_tickets_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  bool stop_ = false;
+};
+
+/** @} */
+
+}  // namespace raft
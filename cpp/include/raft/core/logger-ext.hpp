@@ -17,6 +17,7 @@
 
 #include <raft/core/detail/macros.hpp>  // RAFT_INLINE_CONDITIONAL
 
+#include <cstddef>        // std::size_t
 #include <memory>         // std::unique_ptr
 #include <string>         // std::string
 #include <unordered_map>  // std::unordered_map
@@ -86,6 +87,29 @@ class logger {
    */
   void set_flush(void (*flush)());
 
+  /**
+   * @brief Enable or disable the asynchronous mode
+   *
+   * In the asynchronous mode, `log` only expands the message and pushes it to a lock-free ring
+   * buffer; a background thread applies the pattern and passes it to the callback (or stdout). The
+   * logging calls then stay cheap on the hot paths. When the buffer is full, the messages are
+   * dropped rather than blocking the caller. `flush` waits for the messages logged so far.
+   *
+   * @param[in] enabled whether to log asynchronously
+   * @param[in] capacity the number of messages the buffer can hold
+   */
+  void set_async(bool enabled, std::size_t capacity = 8192);
+
+  /**
+   * @brief Tells whether the logger is in the asynchronous mode
+   */
+  bool is_async() const;
+
+  /**
+   * @brief The number of messages dropped because the buffer of the asynchronous mode was full
+   */
+  std::size_t dropped_messages() const;
+
   /**
    * @brief Tells whether messages will be logged for the given log level
    *
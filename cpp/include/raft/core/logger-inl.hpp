@@ -31,6 +31,7 @@
 #include "logger-ext.hpp"
 
 #define SPDLOG_HEADER_ONLY
+#include <raft/core/detail/async_sink.hpp>
 #include <raft/core/detail/callback_sink.hpp>
 #include <raft/core/detail/macros.hpp>  // RAFT_INLINE_CONDITIONAL
 
@@ -74,6 +75,8 @@ class logger::impl {  // defined privately here
                       //     can now change without recompiling callers ...
  public:
   std::shared_ptr<spdlog::sinks::callback_sink_mt> sink;
+  // set in the asynchronous mode, in front of `sink`
+  std::shared_ptr<spdlog::sinks::AsyncSink> async_sink;
   std::shared_ptr<spdlog::logger> spdlogger;
   std::string cur_pattern;
   int cur_level;
@@ -117,6 +120,26 @@ RAFT_INLINE_CONDITIONAL void logger::set_callback(void (*callback)(int lvl, cons
 
 RAFT_INLINE_CONDITIONAL void logger::set_flush(void (*flush)()) { pimpl->sink->set_flush(flush); }
 
+RAFT_INLINE_CONDITIONAL void logger::set_async(bool enabled, std::size_t capacity)
+{
+  if (enabled == is_async()) { return; }
+  if (enabled) {
+    pimpl->async_sink = std::make_shared<spdlog::sinks::AsyncSink>(pimpl->sink, capacity);
+    pimpl->spdlogger->sinks() = {pimpl->async_sink};
+  } else {
+    pimpl->spdlogger->sinks() = {pimpl->sink};
+    // drains the buffer and joins the background thread
+    pimpl->async_sink.reset();
+  }
+}
+
+RAFT_INLINE_CONDITIONAL bool logger::is_async() const { return pimpl->async_sink != nullptr; }
+
+RAFT_INLINE_CONDITIONAL std::size_t logger::dropped_messages() const
+{
+  return pimpl->async_sink ? pimpl->async_sink->dropped() : 0;
+}
+
 RAFT_INLINE_CONDITIONAL bool logger::should_log_for(int level) const
 {
   level        = raft::detail::convert_level_to_spdlog(level);
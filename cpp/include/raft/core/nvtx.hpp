@@ -17,6 +17,8 @@
 #pragma once
 
 #include <raft/core/detail/nvtx.hpp>
+#include <raft/core/resource/detail/memory_scope.hpp>
+#include <raft/core/resource/detail/timing_scope.hpp>
 
 #include <optional>
 
@@ -84,6 +86,12 @@ struct raft {
 /**
  * @brief Push a named NVTX range.
  *
+ * While a `raft::resource::memory_tracker` is alive, the range is also a memory scope: the
+ * allocations of tracked memory resources made by this thread within the range are attributed to
+ * it (see `raft/core/resource/memory_tracking.hpp`). While a `raft::resource::scope_profiler` is
+ * installed on this thread, the GPU time of the range is measured as well (see
+ * `raft/core/resource/scope_profiling.hpp`).
+ *
  * @tparam Domain optional struct that defines the NVTX domain message;
  *   You can create a new domain with a custom message as follows:
  *   \code{.cpp}
@@ -97,6 +105,8 @@ template <typename Domain = domain::app, typename... Args>
 inline void push_range(const char* format, Args... args)
 {
   detail::push_range<Domain, Args...>(format, args...);
+  raft::resource::detail::push_memory_scope(format);
+  raft::resource::detail::push_timing_scope(format);
 }
 
 /**
@@ -112,7 +122,9 @@ inline void push_range(const char* format, Args... args)
 template <typename Domain = domain::app>
 inline void pop_range()
 {
+  raft::resource::detail::pop_timing_scope();
   detail::pop_range<Domain>();
+  raft::resource::detail::pop_memory_scope();
 }
 
 /**
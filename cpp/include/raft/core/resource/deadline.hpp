@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/interruptible.hpp>
+#include <raft/core/resource/resource_types.hpp>
+#include <raft/core/resources.hpp>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+
+namespace raft::resource {
+
+/** The time point an operation must be complete by; empty if there is no limit. */
+using deadline_t = std::optional<std::chrono::steady_clock::time_point>;
+
+class deadline_resource : public resource {
+ public:
+  explicit deadline_resource(deadline_t deadline) : deadline_(deadline) {}
+  void* get_resource() override { return &deadline_; }
+
+  ~deadline_resource() override {}
+
+ private:
+  deadline_t deadline_;
+};
+
+/**
+ * Factory that knows how to construct a
+ * specific raft::resource to populate
+ * the res_t.
+ */
+class deadline_resource_factory : public resource_factory {
+ public:
+  explicit deadline_resource_factory(deadline_t deadline = std::nullopt) : deadline_(deadline) {}
+  resource_type get_resource_type() override { return resource_type::DEADLINE; }
+  resource* make_resource() override { return new deadline_resource(deadline_); }
+
+ private:
+  deadline_t deadline_;
+};
+
+/**
+ * @defgroup resource_deadline Deadline resource functions
+ * @{
+ */
+
+/**
+ * Load the deadline from a res (and populate it on the res if needed).
+ * @param res raft res object for managing resources
+ * @return the deadline, or an empty optional if there is none
+ */
+inline auto get_deadline(resources const& res) -> deadline_t
+{
+  if (!res.has_resource_factory(resource_type::DEADLINE)) {
+    res.add_resource_factory(std::make_shared<deadline_resource_factory>());
+  }
+  return *res.get_resource<deadline_t>(resource_type::DEADLINE);
+};
+
+/**
+ * Set a deadline on a res: the long-running algorithms using this res (e.g. the k-means, CAGRA
+ * and NN-descent builds) throw `raft::interrupted_exception` at their next cancellation
+ * checkpoint once the deadline has passed.
+ *
+ * @param res raft res object for managing resources
+ * @param deadline the time point to stop at, or an empty optional to remove the deadline
+ */
+inline void set_deadline(resources const& res, deadline_t deadline)
+{
+  res.add_resource_factory(std::make_shared<deadline_resource_factory>(deadline));
+}
+
+/**
+ * Set a deadline on a res at a given time from now (see `set_deadline`).
+ * @param res raft res object for managing resources
+ * @param timeout the time available from now
+ */
+template <typename Rep, typename Period>
+inline void set_timeout(resources const& res, std::chrono::duration<Rep, Period> timeout)
+{
+  set_deadline(res,
+               std::chrono::steady_clock::now() +
+                 std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+}
+
+/**
+ * A cancellation checkpoint of a long-running host loop.
+ *
+ * This is a cancellation point for an interruptible thread (`raft::interruptible::yield`), and it
+ * checks the deadline of the res. The iterative algorithms call it between their iterations, so
+ * that a cancelled or expired request releases its resources without waiting for the end of the
+ * algorithm; the work already submitted to the stream is not waited for.
+ *
+ * @param res raft res object for managing resources
+ *
+ * @throw raft::interrupted_exception if the thread was cancelled or the deadline has passed.
+ */
+inline void check_interrupted(resources const& res)
+{
+  interruptible::yield();
+  auto deadline = get_deadline(res);
+  if (deadline.has_value() && std::chrono::steady_clock::now() >= *deadline) {
+    throw interrupted_exception("The deadline of the operation has passed.");
+  }
+}
+
+/**
+ * @}
+ */
+}  // namespace raft::resource
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace raft::resource::detail {
+
+/** Number of live memory trackers: the scopes are recorded only while there is one. */
+inline auto memory_trackers_alive() -> std::atomic<int>&
+{
+  static std::atomic<int> n_trackers{0};
+  return n_trackers;
+}
+
+/**
+ * The memory scopes entered by the current thread, innermost last. The scopes entered while no
+ * tracker is alive are kept as empty placeholders, so that the pushes and pops stay balanced.
+ */
+inline auto memory_scope_stack() -> std::vector<std::string>&
+{
+  thread_local std::vector<std::string> stack;
+  return stack;
+}
+
+/**
+ * The name of the scope of an NVTX range: the format of the range up to its formatted arguments,
+ * e.g. "ivf_pq::build" for "ivf_pq::build(%zu, %u)".
+ */
+inline auto scope_name(const char* format) -> std::string
+{
+  auto length = std::strcspn(format, "(%");
+  while (length > 0 && format[length - 1] == ' ') {
+    length--;
+  }
+  return std::string(format, length);
+}
+
+/** Enter a memory scope named after an NVTX range (see `scope_name`). */
+inline void push_memory_scope(const char* format)
+{
+  auto& stack = memory_scope_stack();
+  if (memory_trackers_alive().load(std::memory_order_relaxed) == 0) {
+    stack.emplace_back();
+    return;
+  }
+  stack.push_back(scope_name(format));
+}
+
+inline void pop_memory_scope()
+{
+  auto& stack = memory_scope_stack();
+  if (!stack.empty()) { stack.pop_back(); }
+}
+
+/** The non-empty names of the scopes of the current thread, outermost first. */
+inline auto current_memory_scopes() -> std::vector<std::string>
+{
+  std::vector<std::string> scopes;
+  for (auto& name : memory_scope_stack()) {
+    if (!name.empty()) { scopes.push_back(name); }
+  }
+  return scopes;
+}
+
+}  // namespace raft::resource::detail
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+namespace raft::resource::detail {
+
+/** A receiver of the NVTX ranges pushed and popped by a thread. */
+class scope_listener {
+ public:
+  virtual ~scope_listener() = default;
+
+  virtual void on_push(const char* format) = 0;
+  virtual void on_pop()                    = 0;
+};
+
+/** The listener of the ranges of the current thread, if any. */
+inline auto thread_scope_listener() -> scope_listener*&
+{
+  thread_local scope_listener* listener = nullptr;
+  return listener;
+}
+
+inline void push_timing_scope(const char* format)
+{
+  if (auto* listener = thread_scope_listener(); listener != nullptr) { listener->on_push(format); }
+}
+
+inline void pop_timing_scope()
+{
+  if (auto* listener = thread_scope_listener(); listener != nullptr) { listener->on_pop(); }
+}
+
+}  // namespace raft::resource::detail
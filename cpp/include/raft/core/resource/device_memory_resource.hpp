@@ -20,11 +20,14 @@
 #include <raft/core/resources.hpp>
 #include <raft/util/cudart_utils.hpp>
 
+#include <rmm/aligned.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 #include <rmm/mr/device/limiting_resource_adaptor.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
 #include <rmm/mr/device/pool_memory_resource.hpp>
+#include <rmm/mr/pinned_host_memory_resource.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <optional>
 
@@ -289,6 +292,207 @@ inline void set_large_workspace_resource(resources const& res,
   res.add_resource_factory(std::make_shared<large_workspace_resource_factory>(mr));
 };
 
+/**
+ * Factory that knows how to construct a specific raft::resource to populate
+ * the resources instance.
+ */
+class pinned_workspace_resource_factory : public resource_factory {
+ public:
+  explicit pinned_workspace_resource_factory(
+    std::shared_ptr<rmm::mr::device_memory_resource> mr = {nullptr},
+    std::optional<std::size_t> allocation_limit         = std::nullopt)
+    : allocation_limit_(allocation_limit.value_or(kDefaultAllocationLimit)),
+      mr_(mr ? mr : default_pool_resource(allocation_limit_))
+  {
+  }
+
+  auto get_resource_type() -> resource_type override
+  {
+    return resource_type::PINNED_WORKSPACE_RESOURCE;
+  }
+  auto make_resource() -> resource* override
+  {
+    return new limiting_memory_resource(mr_, allocation_limit_, std::nullopt);
+  }
+
+  /**
+   * Construct a pool of pinned host memory. The pool starts empty and never releases the memory
+   * it has obtained, so that the page-locking cudaHostAlloc calls happen only while it grows.
+   */
+  static inline auto default_pool_resource(std::size_t limit)
+    -> std::shared_ptr<rmm::mr::device_memory_resource>
+  {
+    // The upstream is stateless and outlives all the pools.
+    static rmm::mr::pinned_host_memory_resource upstream{};
+    // Leave some room for fragmentation on top of the limit, as for the device workspace pool.
+    constexpr std::size_t kHalfGb = 512lu * 1024lu * 1024lu;
+    auto max_size                 = std::min<std::size_t>(limit + kHalfGb, limit * 3lu / 2lu);
+    RAFT_LOG_DEBUG(
+      "Setting the pinned workspace pool resource; memory limit = %zu, max pool size = %zu.",
+      limit,
+      max_size);
+    return std::make_shared<rmm::mr::pool_memory_resource<rmm::mr::pinned_host_memory_resource>>(
+      &upstream, 0, rmm::align_up(max_size, rmm::CUDA_ALLOCATION_ALIGNMENT));
+  }
+
+ private:
+  // 1 GiB of page-locked host memory by default
+  static constexpr std::size_t kDefaultAllocationLimit = 1024lu * 1024lu * 1024lu;
+
+  std::size_t allocation_limit_;
+  std::shared_ptr<rmm::mr::device_memory_resource> mr_;
+};
+
+/**
+ * Load a temp pinned host workspace resource from a resources instance (and populate it on the
+ * res if needed).
+ *
+ * The memory of this resource is page-locked host memory, accessible from the host and from the
+ * device. It is meant for the staging buffers of host-device transfers, which would otherwise
+ * page-lock new memory on every call. The allocations are stream-ordered: as a block released on
+ * a stream may be reused while the work enqueued on that stream before the release is running,
+ * the host must synchronize with the stream after the allocation before it touches the memory.
+ *
+ * @param res raft resources object for managing resources
+ * @return pinned memory resource object
+ */
+inline auto get_pinned_workspace_resource(resources const& res)
+  -> rmm::mr::limiting_resource_adaptor<rmm::mr::device_memory_resource>*
+{
+  if (!res.has_resource_factory(resource_type::PINNED_WORKSPACE_RESOURCE)) {
+    res.add_resource_factory(std::make_shared<pinned_workspace_resource_factory>());
+  }
+  return res.get_resource<rmm::mr::limiting_resource_adaptor<rmm::mr::device_memory_resource>>(
+    resource_type::PINNED_WORKSPACE_RESOURCE);
+};
+
+/** Get the total size of the pinned workspace resource. */
+inline auto get_pinned_workspace_total_bytes(resources const& res) -> size_t
+{
+  return get_pinned_workspace_resource(res)->get_allocation_limit();
+};
+
+/** Get the available size of the pinned workspace resource. */
+inline auto get_pinned_workspace_free_bytes(resources const& res) -> size_t
+{
+  const auto* p = get_pinned_workspace_resource(res);
+  return p->get_allocation_limit() - p->get_allocated_bytes();
+};
+
+/**
+ * Set a temporary pinned host workspace resource on a resources instance.
+ *
+ * @param res raft resources object for managing resources
+ * @param mr an optional RMM memory resource providing pinned host memory; by default, a pool of
+ *   pinned host memory bounded by the allocation limit
+ * @param allocation_limit
+ *   the total amount of memory in bytes available to the temporary pinned workspace resources.
+ */
+inline void set_pinned_workspace_resource(
+  resources const& res,
+  std::shared_ptr<rmm::mr::device_memory_resource> mr = {nullptr},
+  std::optional<std::size_t> allocation_limit         = std::nullopt)
+{
+  res.add_resource_factory(
+    std::make_shared<pinned_workspace_resource_factory>(mr, allocation_limit));
+};
+
+/**
+ * A resource holding a shared memory resource: the objects allocated from it keep a copy of the
+ * pointer, so the memory resource outlives the resources instance if necessary.
+ */
+class shared_memory_resource : public resource {
+ public:
+  explicit shared_memory_resource(std::shared_ptr<rmm::mr::device_memory_resource> mr) : mr_(mr) {}
+  ~shared_memory_resource() override = default;
+  auto get_resource() -> void* override { return &mr_; }
+
+ private:
+  std::shared_ptr<rmm::mr::device_memory_resource> mr_;
+};
+
+/**
+ * Factory that knows how to construct a specific raft::resource to populate
+ * the resources instance.
+ */
+class ivf_list_resource_factory : public resource_factory {
+ public:
+  explicit ivf_list_resource_factory(
+    std::shared_ptr<rmm::mr::device_memory_resource> mr = {nullptr})
+    : mr_{mr ? mr : workspace_resource_factory::default_plain_resource()}
+  {
+  }
+  auto get_resource_type() -> resource_type override { return resource_type::IVF_LIST_RESOURCE; }
+  auto make_resource() -> resource* override { return new shared_memory_resource(mr_); }
+
+  /**
+   * Construct a pool for the IVF lists. The pool starts at `initial_size` and grows
+   * geometrically (by at least its current size); the blocks released by the lists are coalesced
+   * and reused by the next allocations, and the pool returns its memory only when destroyed.
+   */
+  static inline auto default_pool_resource(std::size_t initial_size)
+    -> std::shared_ptr<rmm::mr::device_memory_resource>
+  {
+    RAFT_LOG_DEBUG("Setting the IVF list pool resource; initial pool size = %zu.", initial_size);
+    return std::make_shared<rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource>>(
+      rmm::mr::get_current_device_resource(),
+      rmm::align_up(initial_size, rmm::CUDA_ALLOCATION_ALIGNMENT));
+  }
+
+ private:
+  std::shared_ptr<rmm::mr::device_memory_resource> mr_;
+};
+
+/**
+ * Load the memory resource of the IVF lists from a resources instance (and populate it on the res
+ * if needed).
+ *
+ * The lists of the IVF indexes (`ivf_flat`, `ivf_pq`) are allocated from this resource when they
+ * are created or grown by `build` and `extend`. By default, it is the current device resource.
+ * Every list keeps a copy of the returned pointer, hence the resource lives as long as the lists
+ * allocated from it.
+ *
+ * @param res raft resources object for managing resources
+ * @return the shared device memory resource
+ */
+inline auto get_ivf_list_resource(resources const& res)
+  -> std::shared_ptr<rmm::mr::device_memory_resource>
+{
+  if (!res.has_resource_factory(resource_type::IVF_LIST_RESOURCE)) {
+    res.add_resource_factory(std::make_shared<ivf_list_resource_factory>());
+  }
+  return *res.get_resource<std::shared_ptr<rmm::mr::device_memory_resource>>(
+    resource_type::IVF_LIST_RESOURCE);
+};
+
+/**
+ * Set the memory resource of the IVF lists on a resources instance.
+ *
+ * @param res raft resources object for managing resources
+ * @param mr an optional RMM device_memory_resource
+ */
+inline void set_ivf_list_resource(resources const& res,
+                                  std::shared_ptr<rmm::mr::device_memory_resource> mr = {nullptr})
+{
+  res.add_resource_factory(std::make_shared<ivf_list_resource_factory>(mr));
+};
+
+/**
+ * Allocate the IVF lists from a pool (arena) of device memory.
+ *
+ * The lists grow by reallocation: every `extend` that overflows the capacity of a list allocates
+ * a bigger one and releases the old. With thousands of lists and the long-lived indexes, this
+ * turns into many device allocations and fragments the memory; the pool serves these from its
+ * large upstream blocks and reuses the released blocks of the lists within itself.
+ *
+ * @param res raft resources object for managing resources
+ * @param initial_size the initial size of the pool in bytes
+ */
+inline void set_ivf_list_to_pool_resource(resources const& res, std::size_t initial_size = 0)
+{
+  set_ivf_list_resource(res, ivf_list_resource_factory::default_pool_resource(initial_size));
+};
+
 /** @} */
 
 }  // namespace raft::resource
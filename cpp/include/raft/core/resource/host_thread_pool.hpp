@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/host_thread_pool.hpp>
+#include <raft/core/resource/resource_types.hpp>
+#include <raft/core/resources.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace raft::resource {
+
+class host_thread_pool_resource : public resource {
+ public:
+  explicit host_thread_pool_resource(std::shared_ptr<host_thread_pool> pool)
+    : pool_(std::move(pool))
+  {
+  }
+  void* get_resource() override { return pool_.get(); }
+
+  ~host_thread_pool_resource() override {}
+
+ private:
+  std::shared_ptr<host_thread_pool> pool_;
+};
+
+/**
+ * Factory that knows how to construct a
+ * specific raft::resource to populate
+ * the res_t.
+ */
+class host_thread_pool_resource_factory : public resource_factory {
+ public:
+  explicit host_thread_pool_resource_factory(std::shared_ptr<host_thread_pool> pool = {nullptr})
+    : pool_(pool ? std::move(pool) : host_thread_pool::default_pool())
+  {
+  }
+  resource_type get_resource_type() override { return resource_type::HOST_THREAD_POOL; }
+  resource* make_resource() override { return new host_thread_pool_resource(pool_); }
+
+ private:
+  std::shared_ptr<host_thread_pool> pool_;
+};
+
+/**
+ * @defgroup resource_host_thread_pool Host thread pool resource functions
+ * @{
+ */
+
+/**
+ * Load the host thread pool from a res (and populate it on the res if needed).
+ *
+ * Unless set explicitly, this is the process-wide `host_thread_pool::default_pool()`, so the host
+ * phases called with different res objects share the same threads.
+ *
+ * @param res raft res object for managing resources
+ * @return the host thread pool
+ */
+inline auto get_host_thread_pool(resources const& res) -> host_thread_pool&
+{
+  if (!res.has_resource_factory(resource_type::HOST_THREAD_POOL)) {
+    res.add_resource_factory(std::make_shared<host_thread_pool_resource_factory>());
+  }
+  return *res.get_resource<host_thread_pool>(resource_type::HOST_THREAD_POOL);
+};
+
+/**
+ * Set the host thread pool on a res; the pool may be shared by many res objects.
+ *
+ * @param res raft res object for managing resources
+ * @param pool the pool, or nullptr to use the process-wide default pool
+ */
+inline void set_host_thread_pool(resources const& res, std::shared_ptr<host_thread_pool> pool)
+{
+  res.add_resource_factory(std::make_shared<host_thread_pool_resource_factory>(std::move(pool)));
+};
+
+/**
+ * Limit the host phases of the algorithms using this res to a new pool of `n_threads` threads
+ * (including the calling thread).
+ *
+ * @param res raft res object for managing resources
+ * @param n_threads the thread budget
+ */
+inline void set_host_thread_budget(resources const& res, std::size_t n_threads)
+{
+  set_host_thread_pool(res, std::make_shared<host_thread_pool>(n_threads));
+};
+
+/** @} */
+
+}  // namespace raft::resource
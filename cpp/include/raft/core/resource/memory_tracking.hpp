@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/resource/detail/memory_scope.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace raft::resource {
+
+/**
+ * \defgroup memory_tracking Memory accounting
+ * @{
+ */
+
+/** The memory allocated within a scope, including its nested scopes. */
+struct memory_usage {
+  /** bytes currently allocated */
+  std::size_t current_bytes{0};
+  /** the maximum of `current_bytes` since the tracker was created or `reset_peaks` was called */
+  std::size_t peak_bytes{0};
+  /** number of allocations made */
+  std::size_t n_allocations{0};
+};
+
+/**
+ * @brief Accounting of the allocations of the tracked memory resources by scope.
+ *
+ * A scope is an NVTX range (`raft::common::nvtx::range`): every raft algorithm opens one, named
+ * after the algorithm, e.g. "ivf_pq::build" or "cagra::search". An allocation is attributed to
+ * the path of the scopes open on the allocating thread, e.g. "ivf_pq::build/ivf_pq::train", and to
+ * all the enclosing paths; the path "" holds the total. Hence, the peak of a scope is the memory
+ * needed to run it.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  auto tracker = std::make_shared<raft::resource::memory_tracker>();
+ *  raft::resource::set_tracked_workspace_resources(res, tracker);
+ *  // optionally, track the remaining allocations (e.g. of the index) as well
+ *  raft::resource::tracking_memory_resource global(
+ *    raft::resource::workspace_resource_factory::default_plain_resource(), tracker);
+ *  rmm::mr::set_current_device_resource(&global);
+ *
+ *  auto index = raft::neighbors::ivf_pq::build(res, params, dataset);
+ *  for (auto& [scope, usage] : tracker->report()) {
+ *    std::cout << scope << ": " << usage.peak_bytes << std::endl;
+ *  }
+ * @endcode
+ *
+ * The scopes are recorded only while a tracker is alive, and only the scopes of the allocating
+ * thread count: the allocations made by helper threads are attributed to the total alone.
+ */
+class memory_tracker {
+ public:
+  memory_tracker() { detail::memory_trackers_alive()++; }
+  ~memory_tracker() { detail::memory_trackers_alive()--; }
+
+  memory_tracker(const memory_tracker&)                    = delete;
+  memory_tracker(memory_tracker&&)                         = delete;
+  auto operator=(const memory_tracker&) -> memory_tracker& = delete;
+  auto operator=(memory_tracker&&) -> memory_tracker&      = delete;
+
+  /** The usage of every scope path seen so far, including the total (path ""). */
+  [[nodiscard]] auto report() const -> std::map<std::string, memory_usage>
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return std::map<std::string, memory_usage>(scopes_.begin(), scopes_.end());
+  }
+
+  /** The usage of a scope path, e.g. "ivf_pq::build" or "ivf_pq::build/ivf_pq::train". */
+  [[nodiscard]] auto usage(const std::string& scope) const -> memory_usage
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = scopes_.find(scope);
+    return it == scopes_.end() ? memory_usage{} : it->second;
+  }
+
+  /** The usage of all the tracked allocations. */
+  [[nodiscard]] auto total() const -> memory_usage { return usage(""); }
+
+  /** Start measuring the peaks anew from the memory currently allocated. */
+  void reset_peaks()
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto& [scope, usage] : scopes_) {
+      usage.peak_bytes = usage.current_bytes;
+    }
+  }
+
+  /** Record an allocation in the scopes of the calling thread. */
+  void on_allocate(void* ptr, std::size_t bytes)
+  {
+    auto scopes = detail::current_memory_scopes();
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto& record = allocations_[ptr];
+    record.first = bytes;
+    record.second.clear();
+    std::string path;
+    for (std::size_t i = 0; i <= scopes.size(); i++) {
+      if (i > 0) { path += (i > 1 ? "/" : "") + scopes[i - 1]; }
+      auto& usage = scopes_[path];
+      usage.current_bytes += bytes;
+      usage.peak_bytes = std::max(usage.peak_bytes, usage.current_bytes);
+      usage.n_allocations++;
+      record.second.push_back(&usage);
+    }
+  }
+
+  /** Release an allocation from the scopes it was attributed to. */
+  void on_deallocate(void* ptr)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = allocations_.find(ptr);
+    if (it == allocations_.end()) { return; }
+    for (auto* usage : it->second.second) {
+      usage->current_bytes -= it->second.first;
+    }
+    allocations_.erase(it);
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  // the elements of an unordered_map are never moved, so the records can point to them
+  std::unordered_map<std::string, memory_usage> scopes_;
+  std::unordered_map<void*, std::pair<std::size_t, std::vector<memory_usage*>>> allocations_;
+};
+
+/**
+ * @brief A memory resource adaptor reporting the allocations of its upstream to a tracker.
+ */
+class tracking_memory_resource : public rmm::mr::device_memory_resource {
+ public:
+  tracking_memory_resource(std::shared_ptr<rmm::mr::device_memory_resource> upstream,
+                           std::shared_ptr<memory_tracker> tracker)
+    : upstream_(std::move(upstream)), tracker_(std::move(tracker))
+  {
+  }
+
+  [[nodiscard]] auto get_upstream() const -> std::shared_ptr<rmm::mr::device_memory_resource>
+  {
+    return upstream_;
+  }
+  [[nodiscard]] auto get_tracker() const -> std::shared_ptr<memory_tracker> { return tracker_; }
+
+ private:
+  auto do_allocate(std::size_t bytes, rmm::cuda_stream_view stream) -> void* override
+  {
+    void* ptr = upstream_->allocate(bytes, stream);
+    if (bytes > 0) { tracker_->on_allocate(ptr, bytes); }
+    return ptr;
+  }
+
+  void do_deallocate(void* ptr, std::size_t bytes, rmm::cuda_stream_view stream) override
+  {
+    if (bytes > 0) { tracker_->on_deallocate(ptr); }
+    upstream_->deallocate(ptr, bytes, stream);
+  }
+
+  std::shared_ptr<rmm::mr::device_memory_resource> upstream_;
+  std::shared_ptr<memory_tracker> tracker_;
+};
+
+/**
+ * Replace the workspace and the large workspace resources of a resources instance by resources
+ * reporting their allocations to `tracker`. The limit of the workspace is kept.
+ *
+ * @param res raft resources object for managing resources
+ * @param tracker the accounting of the allocations
+ * @param mr an optional RMM device_memory_resource to allocate from; by default, the global
+ *   memory resource (`rmm::mr::get_current_device_resource()`)
+ */
+inline void set_tracked_workspace_resources(
+  resources const& res,
+  std::shared_ptr<memory_tracker> tracker,
+  std::shared_ptr<rmm::mr::device_memory_resource> mr = {nullptr})
+{
+  auto limit   = get_workspace_total_bytes(res);
+  auto tracked = std::make_shared<tracking_memory_resource>(
+    mr ? mr : workspace_resource_factory::default_plain_resource(), std::move(tracker));
+  set_workspace_resource(res, tracked, limit);
+  set_large_workspace_resource(res, tracked);
+}
+
+/** @} */
+
+}  // namespace raft::resource
@@ -28,25 +28,29 @@ namespace raft::resource {
  */
 enum resource_type {
   // device-specific resource types
-  CUBLAS_HANDLE = 0,         // cublas handle
-  CUSOLVER_DN_HANDLE,        // cusolver dn handle
-  CUSOLVER_SP_HANDLE,        // cusolver sp handle
-  CUSPARSE_HANDLE,           // cusparse handle
-  CUDA_STREAM_VIEW,          // view of a cuda stream
-  CUDA_STREAM_POOL,          // cuda stream pool
-  CUDA_STREAM_SYNC_EVENT,    // cuda event for syncing streams
-  COMMUNICATOR,              // raft communicator
-  SUB_COMMUNICATOR,          // raft sub communicator
-  DEVICE_PROPERTIES,         // cuda device properties
-  DEVICE_ID,                 // cuda device id
-  STREAM_VIEW,               // view of a cuda stream or a placeholder in
-                             // CUDA-free builds
-  THRUST_POLICY,             // thrust execution policy
-  WORKSPACE_RESOURCE,        // rmm device memory resource for small temporary allocations
-  CUBLASLT_HANDLE,           // cublasLt handle
-  CUSTOM,                    // runtime-shared default-constructible resource
-  LARGE_WORKSPACE_RESOURCE,  // rmm device memory resource for somewhat large temporary allocations
-  NCCL_CLIQUE,               // nccl clique
+  CUBLAS_HANDLE = 0,          // cublas handle
+  CUSOLVER_DN_HANDLE,         // cusolver dn handle
+  CUSOLVER_SP_HANDLE,         // cusolver sp handle
+  CUSPARSE_HANDLE,            // cusparse handle
+  CUDA_STREAM_VIEW,           // view of a cuda stream
+  CUDA_STREAM_POOL,           // cuda stream pool
+  CUDA_STREAM_SYNC_EVENT,     // cuda event for syncing streams
+  COMMUNICATOR,               // raft communicator
+  SUB_COMMUNICATOR,           // raft sub communicator
+  DEVICE_PROPERTIES,          // cuda device properties
+  DEVICE_ID,                  // cuda device id
+  STREAM_VIEW,                // view of a cuda stream or a placeholder in
+                              // CUDA-free builds
+  THRUST_POLICY,              // thrust execution policy
+  WORKSPACE_RESOURCE,         // rmm device memory resource for small temporary allocations
+  CUBLASLT_HANDLE,            // cublasLt handle
+  CUSTOM,                     // runtime-shared default-constructible resource
+  LARGE_WORKSPACE_RESOURCE,   // rmm device memory resource for somewhat large temporary allocations
+  NCCL_CLIQUE,                // nccl clique
+  PINNED_WORKSPACE_RESOURCE,  // rmm pinned host memory resource for temporary staging buffers
+  DEADLINE,                   // time limit of the long-running algorithms
+  IVF_LIST_RESOURCE,          // rmm device memory resource for the lists of the IVF indexes
+  HOST_THREAD_POOL,           // pool of host threads shared by the host phases of the algorithms
 
   LAST_KEY  // reserved for the last key
 };
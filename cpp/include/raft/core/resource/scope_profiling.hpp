@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/detail/memory_scope.hpp>
+#include <raft/core/resource/detail/timing_scope.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/cuda_stream_view.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace raft::resource {
+
+/**
+ * \defgroup scope_profiling GPU time by scope
+ * @{
+ */
+
+/** The GPU time spent in a scope, including its nested scopes. */
+struct scope_timing {
+  /** number of times the scope was entered */
+  std::size_t n_calls{0};
+  /** total time in milliseconds */
+  double total_ms{0};
+  /** shortest call in milliseconds */
+  double min_ms{std::numeric_limits<double>::infinity()};
+  /** longest call in milliseconds */
+  double max_ms{0};
+
+  /** mean time of a call in milliseconds */
+  [[nodiscard]] auto mean_ms() const -> double { return n_calls > 0 ? total_ms / n_calls : 0.0; }
+};
+
+/**
+ * @brief A lightweight profiler measuring the GPU time of the NVTX ranges, without CUPTI.
+ *
+ * A scope is an NVTX range (`raft::common::nvtx::range`): every raft algorithm opens one, named
+ * after the algorithm, e.g. "ivf_pq::search", and the main stages of the algorithms open nested
+ * ones. While the profiler is installed, a pair of CUDA events is recorded on the main stream of
+ * the resources around every range entered by the installing thread. The time of a scope is the
+ * time between its two events, i.e. the GPU time of the work submitted to that stream within the
+ * range (including idle gaps, e.g. while the host prepares the next kernel). The scopes are
+ * identified by their path, e.g. "ivf_pq::search/ivf_pq::search::select", like the scopes of the
+ * `raft::resource::memory_tracker`.
+ *
+ * The events are resolved lazily, so the profiler does not synchronize the stream except when a
+ * report is requested; it can stay installed in a production loop, and `report()` gives the
+ * latency breakdown accumulated since the last `reset()`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  raft::resource::scope_profiler profiler(res);
+ *  raft::neighbors::ivf_pq::search(res, params, index, queries, neighbors, distances);
+ *  std::cout << profiler.to_string();
+ * @endcode
+ *
+ * The profiler is installed on the constructing thread until its destruction; it must be destroyed
+ * on that thread, and the ranges should be balanced within its lifetime. The work submitted by
+ * the algorithms to other streams (e.g. of the stream pool) is timed only as far as the main stream
+ * waits for it.
+ */
+class scope_profiler : public detail::scope_listener {
+ public:
+  /**
+   * Install a profiler on the current thread.
+   *
+   * @param res the resources whose main stream is timed
+   */
+  explicit scope_profiler(resources const& res)
+    : stream_(get_cuda_stream(res)), previous_(detail::thread_scope_listener())
+  {
+    detail::thread_scope_listener() = this;
+  }
+
+  ~scope_profiler() override
+  {
+    detail::thread_scope_listener() = previous_;
+    for (auto& scope : open_) {
+      free_.push_back(scope.second);
+    }
+    for (auto& call : pending_) {
+      free_.push_back(call.start);
+      free_.push_back(call.stop);
+    }
+    for (auto event : free_) {
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(event));
+    }
+  }
+
+  scope_profiler(const scope_profiler&)                    = delete;
+  scope_profiler(scope_profiler&&)                         = delete;
+  auto operator=(const scope_profiler&) -> scope_profiler& = delete;
+  auto operator=(scope_profiler&&) -> scope_profiler&      = delete;
+
+  /**
+   * The timing of every scope path completed so far. This waits for the completion of the work
+   * of the scopes on the stream.
+   */
+  [[nodiscard]] auto report() -> std::map<std::string, scope_timing>
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    collect(true);
+    return timings_;
+  }
+
+  /** The timing of a scope path, e.g. "ivf_pq::search" or "ivf_pq::search/ivf_pq::select". */
+  [[nodiscard]] auto timing(const std::string& scope) -> scope_timing
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    collect(true);
+    auto it = timings_.find(scope);
+    return it == timings_.end() ? scope_timing{} : it->second;
+  }
+
+  /** The report as an indented tree, one scope per line. */
+  [[nodiscard]] auto to_string() -> std::string
+  {
+    std::ostringstream os;
+    for (auto& [path, t] : report()) {
+      auto depth = std::count(path.begin(), path.end(), '/');
+      auto name  = path.substr(path.rfind('/') + 1);
+      os << std::string(2 * depth, ' ') << name << ": " << t.n_calls << " calls, total "
+         << t.total_ms << " ms, mean " << t.mean_ms() << " ms, min " << t.min_ms << " ms, max "
+         << t.max_ms << " ms\n";
+    }
+    return os.str();
+  }
+
+  /** Forget the timings measured so far. */
+  void reset()
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    collect(true);
+    timings_.clear();
+  }
+
+  /** Record the start of a range. */
+  void on_push(const char* format) override
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto name  = detail::scope_name(format);
+    auto path  = open_.empty() ? name : open_.back().first + "/" + name;
+    auto start = acquire_event();
+    RAFT_CUDA_TRY(cudaEventRecord(start, stream_));
+    open_.emplace_back(std::move(path), start);
+  }
+
+  /** Record the end of the innermost range. */
+  void on_pop() override
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    // the ranges entered before the installation of the profiler are ignored
+    if (open_.empty()) { return; }
+    auto stop = acquire_event();
+    RAFT_CUDA_TRY(cudaEventRecord(stop, stream_));
+    pending_.push_back(call_t{std::move(open_.back().first), open_.back().second, stop});
+    open_.pop_back();
+    if (pending_.size() >= kMaxPending) { collect(false); }
+  }
+
+ private:
+  struct call_t {
+    std::string path;
+    cudaEvent_t start;
+    cudaEvent_t stop;
+  };
+
+  /** The number of unresolved calls after which the completed ones are resolved. */
+  static constexpr std::size_t kMaxPending = 256;
+
+  auto acquire_event() -> cudaEvent_t
+  {
+    if (!free_.empty()) {
+      auto event = free_.back();
+      free_.pop_back();
+      return event;
+    }
+    cudaEvent_t event;
+    RAFT_CUDA_TRY(cudaEventCreate(&event));
+    return event;
+  }
+
+  /**
+   * Add the times of the pending calls to the timings. The calls are recorded on a single stream,
+   * so they complete in the order of their ends; without `wait`, stop at the first call which is
+   * not complete yet.
+   */
+  void collect(bool wait)
+  {
+    while (!pending_.empty()) {
+      auto& call = pending_.front();
+      if (wait) {
+        RAFT_CUDA_TRY(cudaEventSynchronize(call.stop));
+      } else {
+        auto status = cudaEventQuery(call.stop);
+        if (status == cudaErrorNotReady) { break; }
+        RAFT_CUDA_TRY(status);
+      }
+      float ms = 0;
+      RAFT_CUDA_TRY(cudaEventElapsedTime(&ms, call.start, call.stop));
+      auto& t = timings_[call.path];
+      t.n_calls++;
+      t.total_ms += ms;
+      t.min_ms = std::min<double>(t.min_ms, ms);
+      t.max_ms = std::max<double>(t.max_ms, ms);
+      free_.push_back(call.start);
+      free_.push_back(call.stop);
+      pending_.pop_front();
+    }
+  }
+
+  rmm::cuda_stream_view stream_;
+  detail::scope_listener* previous_;
+  std::mutex mutex_;
+  // the scopes currently open (path and start event), innermost last
+  std::vector<std::pair<std::string, cudaEvent_t>> open_;
+  std::deque<call_t> pending_;
+  std::vector<cudaEvent_t> free_;
+  std::map<std::string, scope_timing> timings_;
+};
+
+/** @} */
+
+}  // namespace raft::resource
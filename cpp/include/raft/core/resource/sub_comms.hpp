@@ -16,8 +16,22 @@
 #pragma once
 
 #include <raft/core/comms.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/resource_types.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace raft::resource {
 class sub_comms_resource : public resource {
@@ -75,6 +89,99 @@ inline void set_subcomm(resources const& res,
   sub_comms->insert(std::make_pair(key, subcomm));
 }
 
+/** The key of the sub-communicator of the ranks of the same node (see `init_topology_subcomms`). */
+inline constexpr const char* node_subcomm_key = "node";
+/**
+ * The key of the sub-communicator of the ranks with the same rank in their node, across the nodes
+ * (see `init_topology_subcomms`).
+ */
+inline constexpr const char* cross_node_subcomm_key = "cross_node";
+
+/**
+ * Split the communicator of `res` by the topology of the cluster, and register the two levels as
+ * sub-communicators: `node_subcomm_key`, the ranks running on the same host (whose GPUs are linked
+ * by NVLink or PCIe), and `cross_node_subcomm_key`, the ranks with the same local rank on every
+ * node (the rank 0 of the nodes together, the ranks 1 together, etc.).
+ *
+ * The nodes are identified by their host name, which all the ranks exchange: this is a collective
+ * operation of the communicator of `res`. The ranks keep their relative order in both levels.
+ */
+inline void init_topology_subcomms(resources const& res)
+{
+  auto const& comm = get_comms(res);
+  auto stream      = get_cuda_stream(res);
+  int n_ranks      = comm.get_size();
+
+  constexpr size_t kNameLength = HOST_NAME_MAX + 1;
+  std::vector<char> names(kNameLength * n_ranks, 0);
+  char* own_name = names.data() + kNameLength * comm.get_rank();
+  RAFT_EXPECTS(gethostname(own_name, kNameLength - 1) == 0, "ERROR: gethostname failed");
+  rmm::device_uvector<char> d_names(names.size(), stream);
+  char* d_own_name = d_names.data() + kNameLength * comm.get_rank();
+  raft::update_device(d_own_name, own_name, kNameLength, stream);
+  comm.allgather(d_own_name, d_names.data(), kNameLength, stream);
+  raft::update_host(names.data(), d_names.data(), names.size(), stream);
+  RAFT_EXPECTS(comm.sync_stream(stream) == comms::status_t::SUCCESS, "allgather failed");
+
+  // the node of a rank is numbered by the first rank of its host, and its local rank is the number
+  // of the ranks before it on the host
+  std::vector<int> node(n_ranks), local_rank(n_ranks, 0);
+  auto name_of = [&names](int r) { return names.data() + kNameLength * r; };
+  for (int r = 0; r < n_ranks; r++) {
+    node[r] = r;
+    for (int q = 0; q < r; q++) {
+      if (std::strncmp(name_of(q), name_of(r), kNameLength) == 0) {
+        if (node[r] == r) { node[r] = q; }
+        local_rank[r]++;
+      }
+    }
+  }
+  // comm_split expects the keys to be the ranks in the sub-communicators
+  int rank       = comm.get_rank();
+  int cross_rank = 0;
+  for (int q = 0; q < rank; q++) {
+    if (local_rank[q] == local_rank[rank]) { cross_rank++; }
+  }
+
+  set_subcomm(res,
+              node_subcomm_key,
+              std::make_shared<comms::comms_t>(comm.comm_split(node[rank], local_rank[rank])));
+  set_subcomm(res,
+              cross_node_subcomm_key,
+              std::make_shared<comms::comms_t>(comm.comm_split(local_rank[rank], cross_rank)));
+}
+
+/**
+ * An allreduce over the communicator of `res` keeping most of the traffic within the nodes: the
+ * buffers are reduced on the rank 0 of every node, then reduced across the nodes by these ranks
+ * only, and the result broadcast within every node.
+ *
+ * Needs `init_topology_subcomms(res)` to have been called. All the ranks must call it.
+ *
+ * @tparam value_t datatype of the buffers
+ * @param res the resources holding the topology sub-communicators
+ * @param sendbuff data to reduce
+ * @param recvbuff buffer to hold the reduced result (can be `sendbuff`)
+ * @param count number of elements in the buffers
+ * @param op reduction operation to perform
+ * @param stream stream to submit the operations to
+ */
+template <typename value_t>
+void hierarchical_allreduce(resources const& res,
+                            const value_t* sendbuff,
+                            value_t* recvbuff,
+                            size_t count,
+                            comms::op_t op,
+                            cudaStream_t stream)
+{
+  auto const& node_comm = get_subcomm(res, node_subcomm_key);
+  node_comm.reduce(sendbuff, recvbuff, count, op, 0, stream);
+  if (node_comm.get_rank() == 0) {
+    get_subcomm(res, cross_node_subcomm_key).allreduce(recvbuff, recvbuff, count, op, stream);
+  }
+  node_comm.bcast(recvbuff, count, 0, stream);
+}
+
 /**
  * @}
  */
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <raft/core/detail/mapped_file.hpp>
+#include <raft/core/detail/mdspan_numpy_file.hpp>
 #include <raft/core/detail/mdspan_numpy_serializer.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdspan.hpp>
@@ -24,6 +26,8 @@
 #include <raft/core/resources.hpp>
 
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
 /**
@@ -154,6 +158,108 @@ inline void deserialize_mdspan(
   deserialize_mdspan(handle, is, obj);
 }
 
+/**
+ * @brief Write an mdspan to a file in the NumPy format (`.npy`).
+ *
+ * Unlike `serialize_mdspan`, which goes through a `std::ostream`, the payload is written with a
+ * few large positional writes. The arrays in device memory are written with GPUDirect Storage
+ * when raft is built with `RAFT_CUFILE` and the file system supports it; otherwise they are copied
+ * through two pinned buffers of the pinned workspace
+ * (@ref raft::resource::get_pinned_workspace_resource), so that the copies from the device overlap
+ * the writes to the file. The file can be read back with
+ * `deserialize_mdspan`, `deserialize_mdspan_file` or `deserialize_mdspan_mmap`, or by NumPy.
+ *
+ * @param[in] handle the raft handle
+ * @param[in] filename the path of the file, truncated if it exists
+ * @param[in] obj a contiguous host, device or managed mdspan
+ */
+template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
+inline void serialize_mdspan_file(
+  const raft::resources& handle,
+  const std::string& filename,
+  const raft::mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+{
+  detail::numpy_serializer::serialize_mdspan_file(handle, filename, obj);
+}
+
+/**
+ * @brief Read an mdspan written by `serialize_mdspan_file` (or any `.npy` file).
+ *
+ * The dtype, the layout and the extents of the file must match those of `obj`. The arrays in
+ * device memory are read with GPUDirect Storage when available (see `serialize_mdspan_file`), or
+ * else through two pinned buffers: one is read from the file while the other one is copied to the
+ * device.
+ *
+ * @param[in] handle the raft handle
+ * @param[in] filename the path of the file
+ * @param[out] obj a contiguous host, device or managed mdspan
+ */
+template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
+inline void deserialize_mdspan_file(
+  const raft::resources& handle,
+  const std::string& filename,
+  const raft::mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+{
+  detail::numpy_serializer::deserialize_mdspan_file(handle, filename, obj);
+}
+
+/**
+ * @brief A read-only host mdspan over a memory-mapped `.npy` file.
+ *
+ * The mapping is released when the last copy of the object is destroyed; the views must not
+ * outlive it.
+ */
+template <typename ElementType, typename Extents, typename LayoutPolicy = raft::layout_c_contiguous>
+class mapped_mdspan {
+ public:
+  using view_type = raft::host_mdspan<const ElementType, Extents, LayoutPolicy>;
+
+  mapped_mdspan(std::shared_ptr<const detail::mapped_file> file, view_type view)
+    : file_(std::move(file)), view_(view)
+  {
+  }
+
+  /** The content of the file; the pages are read on first access. */
+  [[nodiscard]] auto view() const noexcept -> view_type { return view_; }
+
+ private:
+  std::shared_ptr<const detail::mapped_file> file_;
+  view_type view_;
+};
+
+/**
+ * @brief Map a `.npy` file in memory and view it without copying.
+ *
+ * The dtype and the layout of the file must be `ElementType` and `LayoutPolicy`, and its shape must
+ * agree with the static extents of `Extents`; the dynamic extents are taken from the file.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  raft::serialize_mdspan_file(handle, "dataset.npy", dataset.view());
+ *  auto mapped = raft::deserialize_mdspan_mmap<float, raft::matrix_extent<int64_t>>("dataset.npy");
+ *  auto view   = mapped.view();  // host_matrix_view<const float, int64_t>
+ * @endcode
+ *
+ * @param[in] filename the path of the file
+ */
+template <typename ElementType, typename Extents, typename LayoutPolicy = raft::layout_c_contiguous>
+inline auto deserialize_mdspan_mmap(const std::string& filename)
+  -> mapped_mdspan<ElementType, Extents, LayoutPolicy>
+{
+  auto [extents, offset] =
+    detail::numpy_serializer::read_file_header<ElementType, Extents, LayoutPolicy>(filename);
+  RAFT_EXPECTS(offset % alignof(ElementType) == 0,
+               "The payload of %s is not aligned for its dtype",
+               filename.c_str());
+  auto file = std::make_shared<const detail::mapped_file>(filename);
+  typename mapped_mdspan<ElementType, Extents, LayoutPolicy>::view_type view(
+    reinterpret_cast<const ElementType*>(file->data() + offset), extents);
+  RAFT_EXPECTS(file->size() >= offset + view.size() * sizeof(ElementType),
+               "File %s is truncated",
+               filename.c_str());
+  return {std::move(file), view};
+}
+
 template <typename T>
 inline void serialize_scalar(const raft::resources&, std::ostream& os, const T& value)
 {
@@ -22,6 +22,7 @@
 #include <raft/distance/detail/pairwise_matrix/dispatch.cuh>
 #include <raft/distance/detail/pairwise_matrix/dispatch_sm60.cuh>
 #include <raft/distance/detail/pairwise_matrix/dispatch_sm80.cuh>
+#include <raft/distance/detail/pairwise_matrix/dispatch_sm90.cuh>
 #include <raft/distance/distance_types.hpp>
 #include <raft/linalg/gemm.cuh>
 #include <raft/linalg/norm.cuh>
@@ -15,10 +15,25 @@
  */
 
 #pragma once
+#include <raft/core/math.hpp>
 #include <raft/util/cuda_dev_essentials.cuh>  // DI
 
 namespace raft::distance::detail::ops {
 
+// Epilogue operator for CUTLASS based kernel
+template <typename DataT, typename AccT>
+struct hellinger_cutlass_op {
+  __device__ hellinger_cutlass_op() noexcept {}
+  __device__ AccT operator()(DataT aNorm, const DataT bNorm, DataT accVal) const noexcept
+  {
+    // Adjust to replace NaN in sqrt with 0 if input to sqrt is negative
+    const auto finalVal  = (1 - accVal);
+    const auto rectifier = (!signbit(finalVal));
+    return raft::sqrt(rectifier * finalVal);
+  }
+  __device__ AccT operator()(DataT aData) const noexcept { return aData; }
+};
+
 /**
  * @brief the Hellinger distance matrix calculation
  *
@@ -72,6 +87,11 @@ struct hellinger_distance_op {
       }
     }
   }
+
+  constexpr hellinger_cutlass_op<DataT, AccT> get_cutlass_op() const
+  {
+    return hellinger_cutlass_op<DataT, AccT>();
+  }
 };
 
 }  // namespace raft::distance::detail::ops
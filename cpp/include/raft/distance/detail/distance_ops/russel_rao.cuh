@@ -20,6 +20,24 @@
 
 namespace raft::distance::detail::ops {
 
+// Epilogue operator for CUTLASS based kernel
+template <typename DataT, typename AccT>
+struct russel_rao_cutlass_op {
+  AccT k;
+  AccT one_over_k;
+
+  __device__ russel_rao_cutlass_op() noexcept : k(0), one_over_k(0) {}
+  __device__ russel_rao_cutlass_op(AccT k_, AccT one_over_k_) noexcept
+    : k(k_), one_over_k(one_over_k_)
+  {
+  }
+  __device__ AccT operator()(DataT aNorm, const DataT bNorm, DataT accVal) const noexcept
+  {
+    return (k - accVal) * one_over_k;
+  }
+  __device__ AccT operator()(DataT aData) const noexcept { return aData; }
+};
+
 /**
  * @brief the Russell Rao distance matrix calculation
  *
@@ -69,6 +87,11 @@ struct russel_rao_distance_op {
       }
     }
   }
+
+  constexpr russel_rao_cutlass_op<DataT, AccT> get_cutlass_op() const
+  {
+    return russel_rao_cutlass_op<DataT, AccT>(k, one_over_k);
+  }
 };
 
 }  // namespace raft::distance::detail::ops
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>                                  // RAFT_EXPECTS
+#include <raft/core/operators.hpp>                              // raft::identity_op
+#include <raft/distance/detail/distance_ops/cosine.cuh>         // ops::cosine_distance_op
+#include <raft/distance/detail/distance_ops/inner_product.cuh>  // ops::inner_product_distance_op
+#include <raft/distance/detail/distance_ops/l2_exp.cuh>         // ops::l2_exp_distance_op
+#include <raft/distance/detail/pairwise_distance_base.cuh>      // PairwiseDistances
+#include <raft/distance/distance_types.hpp>                     // DistanceType
+#include <raft/util/cuda_utils.cuh>                             // raft::ceildiv, raft::shfl
+
+#include <algorithm>  // std::min
+#include <cstddef>    // size_t
+#include <limits>     // std::numeric_limits
+
+namespace raft {
+namespace distance {
+namespace detail {
+
+/** The largest number of neighbors of the fused top-k kernel. */
+constexpr int kFusedTopKMaxK = 32;
+
+/**
+ * Insert (value, key) into the sorted list of the K best pairs found so far.
+ *
+ * All the indices are compile-time constants, so that the lists stay in registers.
+ */
+template <int K, bool SelectMin, typename DataT, typename IdxT>
+DI void topk_insert(DataT (&vals)[K], IdxT (&keys)[K], DataT value, IdxT key)
+{
+  auto better = [](DataT a, DataT b) { return SelectMin ? a < b : a > b; };
+  if (!better(value, vals[K - 1])) { return; }
+  bool placed = false;
+#pragma unroll
+  for (int j = K - 1; j > 0; j--) {
+    if (!placed) {
+      if (better(value, vals[j - 1])) {
+        vals[j] = vals[j - 1];
+        keys[j] = keys[j - 1];
+      } else {
+        vals[j] = value;
+        keys[j] = key;
+        placed  = true;
+      }
+    }
+  }
+  if (!placed) {
+    vals[0] = value;
+    keys[0] = key;
+  }
+}
+
+/**
+ * Fused distance and k-nearest-neighbor kernel.
+ *
+ * Every thread keeps the sorted list of the K best columns of each of its rows in registers. A
+ * block sweeps all the columns of its rows, then the lists of the threads that share a row are
+ * merged with warp shuffles, and the first `topk` pairs are written out.
+ */
+template <typename DataT, typename IdxT, typename P, int K, bool SelectMin, typename OpT>
+__launch_bounds__(P::Nthreads, 2) RAFT_KERNEL fusedDistanceNNTopKkernel(IdxT* out_idx,
+                                                                        DataT* out_dist,
+                                                                        const DataT* x,
+                                                                        const DataT* y,
+                                                                        const DataT* xn,
+                                                                        const DataT* yn,
+                                                                        IdxT m,
+                                                                        IdxT n,
+                                                                        IdxT k,
+                                                                        int topk,
+                                                                        OpT distance_op)
+{
+  extern __shared__ char smem[];
+
+  constexpr DataT worst =
+    SelectMin ? std::numeric_limits<DataT>::max() : std::numeric_limits<DataT>::lowest();
+  DataT vals[P::AccRowsPerTh][K];
+  IdxT keys[P::AccRowsPerTh][K];
+#pragma unroll
+  for (int i = 0; i < P::AccRowsPerTh; ++i) {
+#pragma unroll
+    for (int t = 0; t < K; ++t) {
+      vals[i][t] = worst;
+      keys[i][t] = 0;
+    }
+  }
+
+  // epilogue operation lambda for final value calculation
+  auto epilog_lambda = [n, &vals, &keys] __device__(DataT acc[P::AccRowsPerTh][P::AccColsPerTh],
+                                                    DataT * regxn,
+                                                    DataT * regyn,
+                                                    IdxT gridStrideX,
+                                                    IdxT gridStrideY) {
+    const auto acccolid = threadIdx.x % P::AccThCols;
+#pragma unroll
+    for (int i = 0; i < P::AccRowsPerTh; ++i) {
+#pragma unroll
+      for (int j = 0; j < P::AccColsPerTh; ++j) {
+        IdxT col = acccolid + j * P::AccThCols + gridStrideX;
+        if (col < n) { topk_insert<K, SelectMin>(vals[i], keys[i], acc[i][j], col); }
+      }
+    }
+  };
+
+  auto rowEpilog_lambda =
+    [m, topk, out_idx, out_dist, &vals, &keys, worst] __device__(IdxT gridStrideY) {
+      const auto accrowid = threadIdx.x / P::AccThCols;
+      const auto acccolid = threadIdx.x % P::AccThCols;
+      const auto lid      = raft::laneId();
+
+#pragma unroll
+      for (int i = 0; i < P::AccRowsPerTh; ++i) {
+        // Tree reduction: the first thread of the row ends up with the merged list.
+#pragma unroll
+        for (int j = P::AccThCols / 2; j > 0; j >>= 1) {
+          DataT other_vals[K];
+          IdxT other_keys[K];
+#pragma unroll
+          for (int t = 0; t < K; ++t) {
+            other_vals[t] = raft::shfl(vals[i][t], lid + j, P::AccThCols);
+            other_keys[t] = raft::shfl(keys[i][t], lid + j, P::AccThCols);
+          }
+#pragma unroll
+          for (int t = 0; t < K; ++t) {
+            topk_insert<K, SelectMin>(vals[i], keys[i], other_vals[t], other_keys[t]);
+          }
+        }
+
+        IdxT row = gridStrideY + accrowid + i * P::AccThRows;
+        if (acccolid == 0 && row < m) {
+#pragma unroll
+          for (int t = 0; t < K; ++t) {
+            if (t < topk) {
+              out_dist[row * topk + t] = vals[i][t];
+              out_idx[row * topk + t]  = keys[i][t];
+            }
+          }
+        }
+
+        // reset the lists for the next rows
+#pragma unroll
+        for (int t = 0; t < K; ++t) {
+          vals[i][t] = worst;
+          keys[i][t] = 0;
+        }
+      }
+    };
+
+  IdxT lda = k, ldb = k, ldd = n;
+  constexpr bool row_major = true;
+  constexpr bool write_out = false;
+  raft::identity_op fin_op{};
+  PairwiseDistances<DataT,
+                    DataT,  // OutT (unused in PairwiseDistances)
+                    IdxT,
+                    P,
+                    decltype(distance_op),
+                    decltype(epilog_lambda),
+                    decltype(fin_op),
+                    decltype(rowEpilog_lambda),
+                    row_major,
+                    write_out>
+    obj(x,
+        y,
+        m,
+        n,
+        k,
+        lda,
+        ldb,
+        ldd,
+        xn,
+        yn,
+        nullptr,  // Output pointer
+        smem,
+        distance_op,
+        epilog_lambda,
+        fin_op,
+        rowEpilog_lambda);
+  obj.run();
+}
+
+template <typename DataT, typename IdxT, typename P, int K, bool SelectMin, typename OpT>
+void fusedDistanceNNTopKLaunch(IdxT* out_idx,
+                               DataT* out_dist,
+                               const DataT* x,
+                               const DataT* y,
+                               const DataT* xn,
+                               const DataT* yn,
+                               IdxT m,
+                               IdxT n,
+                               IdxT k,
+                               int topk,
+                               OpT distance_op,
+                               cudaStream_t stream)
+{
+  auto kernel = fusedDistanceNNTopKkernel<DataT, IdxT, P, K, SelectMin, OpT>;
+  constexpr size_t shmemSize = OpT::template shared_mem_size<P>();
+
+  // A block sweeps all the columns of its rows, so that the lists of a row are merged within a
+  // warp; the blocks are only distributed along the rows.
+  int devId;
+  RAFT_CUDA_TRY(cudaGetDevice(&devId));
+  int numSMs;
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&numSMs, cudaDevAttrMultiProcessorCount, devId));
+  int numBlocksPerSm = 0;
+  RAFT_CUDA_TRY(
+    cudaOccupancyMaxActiveBlocksPerMultiprocessor(&numBlocksPerSm, kernel, P::Nthreads, shmemSize));
+  dim3 grid(1,
+            std::min<size_t>(raft::ceildiv<size_t>(m, P::Mblk),
+                             std::max<size_t>(1, size_t(numSMs) * numBlocksPerSm)));
+  dim3 blk(P::Nthreads);
+
+  kernel<<<grid, blk, shmemSize, stream>>>(
+    out_idx, out_dist, x, y, xn, yn, m, n, k, topk, distance_op);
+  RAFT_CUDA_TRY(cudaGetLastError());
+}
+
+template <typename DataT, typename IdxT, typename P, int K>
+void fusedDistanceNNTopKImpl(IdxT* out_idx,
+                             DataT* out_dist,
+                             const DataT* x,
+                             const DataT* y,
+                             const DataT* xn,
+                             const DataT* yn,
+                             IdxT m,
+                             IdxT n,
+                             IdxT k,
+                             int topk,
+                             raft::distance::DistanceType metric,
+                             cudaStream_t stream)
+{
+  using AccT = DataT;
+  switch (metric) {
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2Expanded: {
+      bool sqrt = metric == raft::distance::DistanceType::L2SqrtExpanded;
+      ops::l2_exp_distance_op<DataT, AccT, IdxT> distance_op{sqrt};
+      fusedDistanceNNTopKLaunch<DataT, IdxT, P, K, true>(
+        out_idx, out_dist, x, y, xn, yn, m, n, k, topk, distance_op, stream);
+    } break;
+    case raft::distance::DistanceType::CosineExpanded: {
+      ops::cosine_distance_op<DataT, AccT, IdxT> distance_op{};
+      fusedDistanceNNTopKLaunch<DataT, IdxT, P, K, true>(
+        out_idx, out_dist, x, y, xn, yn, m, n, k, topk, distance_op, stream);
+    } break;
+    case raft::distance::DistanceType::InnerProduct: {
+      ops::inner_product_distance_op<DataT, AccT, IdxT> distance_op{};
+      fusedDistanceNNTopKLaunch<DataT, IdxT, P, K, false>(
+        out_idx, out_dist, x, y, nullptr, nullptr, m, n, k, topk, distance_op, stream);
+    } break;
+    default: RAFT_FAIL("only L2, cosine and inner product metrics are supported");
+  }
+}
+
+/** Select the capacity K of the register lists, the smallest power of two that fits topk. */
+template <typename DataT, typename IdxT, typename P>
+void fusedDistanceNNTopKDispatch(IdxT* out_idx,
+                                 DataT* out_dist,
+                                 const DataT* x,
+                                 const DataT* y,
+                                 const DataT* xn,
+                                 const DataT* yn,
+                                 IdxT m,
+                                 IdxT n,
+                                 IdxT k,
+                                 int topk,
+                                 raft::distance::DistanceType metric,
+                                 cudaStream_t stream)
+{
+  RAFT_EXPECTS(topk > 0 && topk <= kFusedTopKMaxK,
+               "The number of neighbors must be in [1, %d]",
+               kFusedTopKMaxK);
+  if (topk <= 2) {
+    fusedDistanceNNTopKImpl<DataT, IdxT, P, 2>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  } else if (topk <= 4) {
+    fusedDistanceNNTopKImpl<DataT, IdxT, P, 4>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  } else if (topk <= 8) {
+    fusedDistanceNNTopKImpl<DataT, IdxT, P, 8>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  } else if (topk <= 16) {
+    fusedDistanceNNTopKImpl<DataT, IdxT, P, 16>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  } else {
+    fusedDistanceNNTopKImpl<DataT, IdxT, P, 32>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  }
+}
+
+}  // namespace detail
+}  // namespace distance
+}  // namespace raft
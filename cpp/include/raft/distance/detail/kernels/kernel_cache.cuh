@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "gram_matrix.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/detail/matrix.cuh>
+#include <raft/util/cache.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace raft::distance::kernels::detail {
+
+/**
+ * Cache of the rows of a kernel matrix K(x, x).
+ *
+ * Iterative solvers like SVM training request the kernel rows of a working set many times. The
+ * rows are stored in the set-associative LRU cache of `raft::cache::Cache`: on each request the
+ * rows already in the cache are collected, and the missing rows are evaluated together with a
+ * single call of the kernel, i.e. one GEMM between the dataset and the missing vectors.
+ *
+ * The dataset must be contiguous (either row or column major). The squared L2 norms of its rows
+ * are computed once, and passed to the kernel (they are only used by the RBF kernel).
+ *
+ * Example usage:
+ * @code{.cpp}
+ *   auto kernel = std::unique_ptr<GramMatrixBase<float>>(KernelFactory<float>::create(params));
+ *   KernelCache<float> cache(handle, kernel.get(), x, 1024);
+ *   // the kernel rows of the working set, out(i, j) = K(x_i, x_ws[j])
+ *   cache.get_rows(handle, ws_view, out_view);
+ * @endcode
+ */
+template <typename math_t>
+class KernelCache {
+ public:
+  /**
+   * @param [in] handle raft handle
+   * @param [in] kernel the kernel function, it must outlive the cache
+   * @param [in] x dense device matrix view of the dataset, size [n_rows * n_cols]
+   * @param [in] cache_size size of the cache in MiB
+   */
+  KernelCache(raft::resources const& handle,
+              GramMatrixBase<math_t>* kernel,
+              dense_input_matrix_view_t<math_t> x,
+              float cache_size = 200)
+    : kernel_(kernel),
+      x_(x),
+      n_rows_(x.extent(0)),
+      n_cols_(x.extent(1)),
+      is_row_major_(x.stride(1) == 1),
+      cache_(resource::get_cuda_stream(handle), x.extent(0), cache_size),
+      x_norm_(x.extent(0), resource::get_cuda_stream(handle)),
+      keys_(0, resource::get_cuda_stream(handle)),
+      cache_idx_(0, resource::get_cuda_stream(handle)),
+      key_to_col_(x.extent(0), resource::get_cuda_stream(handle)),
+      tile_(0, resource::get_cuda_stream(handle)),
+      x_batch_(0, resource::get_cuda_stream(handle)),
+      norm_batch_(0, resource::get_cuda_stream(handle))
+  {
+    int minor = is_row_major_ ? n_cols_ : n_rows_;
+    int ld    = is_row_major_ ? x.stride(0) : x.stride(1);
+    RAFT_EXPECTS(ld == minor, "KernelCache does not support the ld parameter");
+    raft::linalg::rowNorm(x_norm_.data(),
+                          x.data_handle(),
+                          n_cols_,
+                          n_rows_,
+                          raft::linalg::NormType::L2Norm,
+                          is_row_major_,
+                          resource::get_cuda_stream(handle));
+  }
+
+  KernelCache(const KernelCache& other)            = delete;
+  KernelCache& operator=(const KernelCache& other) = delete;
+
+  /**
+   * Get the kernel rows of a set of vectors.
+   *
+   * On exit out(i, j) = K(x_i, x_ws[j]). The rows that are not in the cache are evaluated, and
+   * stored in the cache if their cache set has room for them.
+   *
+   * @param [in] handle raft handle
+   * @param [in] ws indices of the vectors, in [0, n_rows), size [n_ws]
+   * @param [out] out the kernel rows, size [n_rows * n_ws]
+   */
+  void get_rows(raft::resources const& handle,
+                raft::device_vector_view<const int, int> ws,
+                raft::device_matrix_view<math_t, int, raft::col_major> out)
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    int n_ws    = ws.extent(0);
+    RAFT_EXPECTS(out.extent(0) == n_rows_ && out.extent(1) == n_ws,
+                 "The output must be of size [n_rows * n_ws]");
+    if (n_ws == 0) { return; }
+
+    keys_.resize(n_ws, stream);
+    cache_idx_.resize(n_ws, stream);
+    tile_.resize(size_t(n_rows_) * n_ws, stream);
+    raft::copy(keys_.data(), ws.data_handle(), n_ws, stream);
+
+    // keys_[0..n_cached-1] are found in the cache
+    int n_cached = 0;
+    cache_.GetCacheIdxPartitioned(keys_.data(), n_ws, cache_idx_.data(), &n_cached, stream);
+    cache_.GetVecs(cache_idx_.data(), n_cached, tile_.data(), stream);
+
+    int n_missing = n_ws - n_cached;
+    if (n_missing > 0) {
+      int* keys_new      = keys_.data() + n_cached;
+      int* cache_idx_new = cache_idx_.data() + n_cached;
+      math_t* tile_new   = tile_.data() + size_t(n_rows_) * n_cached;
+      // AssignCacheIdx permutes the keys, it has to come before the evaluation
+      cache_.AssignCacheIdx(keys_new, n_missing, cache_idx_new, stream);
+      compute_rows(handle, keys_new, n_missing, tile_new);
+      cache_.StoreVecs(tile_new, n_missing, n_missing, cache_idx_new, stream);
+    }
+
+    // The rows of the tile are in the order of keys_, collect them in the order of ws
+    int* key_to_col   = key_to_col_.data();
+    const int* keys   = keys_.data();
+    const math_t* src = tile_.data();
+    int n_rows        = n_rows_;
+    thrust::for_each_n(resource::get_thrust_policy(handle),
+                       thrust::make_counting_iterator(0),
+                       n_ws,
+                       [key_to_col, keys] __device__(int j) { key_to_col[keys[j]] = j; });
+    const int* ws_ptr = ws.data_handle();
+    raft::linalg::map_offset(
+      handle,
+      raft::make_device_vector_view<math_t, size_t>(out.data_handle(), size_t(n_rows) * n_ws),
+      [src, key_to_col, ws_ptr, n_rows] __device__(size_t i) {
+        size_t row = i % n_rows;
+        size_t col = key_to_col[ws_ptr[i / n_rows]];
+        return src[row + col * n_rows];
+      });
+  }
+
+  /** Return approximate cache size in MiB. */
+  float size_in_mib() const { return cache_.GetSizeInMiB(); }
+
+  /** Return the number of kernel rows that can be cached. */
+  int size() const { return cache_.GetSize(); }
+
+ private:
+  /** Evaluate the kernel rows of the vectors `keys`, out[i + j * n_rows] = K(x_i, x_keys[j]). */
+  void compute_rows(raft::resources const& handle, const int* keys, int n, math_t* out)
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    x_batch_.resize(size_t(n) * n_cols_, stream);
+    norm_batch_.resize(n, stream);
+    raft::matrix::detail::copyRows(
+      x_.data_handle(), n_rows_, n_cols_, x_batch_.data(), keys, n, stream, is_row_major_);
+    raft::matrix::detail::copyRows(
+      x_norm_.data(), n_rows_, 1, norm_batch_.data(), keys, n, stream, true);
+
+    // The rows of a row major [n, n_rows] output are the columns of a column major one
+    if (is_row_major_) {
+      auto batch = raft::make_device_strided_matrix_view<const math_t, int, layout_c_contiguous>(
+        x_batch_.data(), n, n_cols_, 0);
+      auto rows = raft::make_device_strided_matrix_view<math_t, int, layout_c_contiguous>(
+        out, n, n_rows_, 0);
+      kernel_->evaluate(handle, batch, x_, rows, norm_batch_.data(), x_norm_.data());
+    } else {
+      auto batch = raft::make_device_strided_matrix_view<const math_t, int, layout_f_contiguous>(
+        x_batch_.data(), n, n_cols_, 0);
+      auto rows = raft::make_device_strided_matrix_view<math_t, int, layout_f_contiguous>(
+        out, n_rows_, n, 0);
+      kernel_->evaluate(handle, x_, batch, rows, x_norm_.data(), norm_batch_.data());
+    }
+  }
+
+  GramMatrixBase<math_t>* kernel_;
+  dense_input_matrix_view_t<math_t> x_;
+  int n_rows_;
+  int n_cols_;
+  bool is_row_major_;
+
+  raft::cache::Cache<math_t> cache_;
+  rmm::device_uvector<math_t> x_norm_;
+
+  // workspace
+  rmm::device_uvector<int> keys_;
+  rmm::device_uvector<int> cache_idx_;
+  rmm::device_uvector<int> key_to_col_;
+  rmm::device_uvector<math_t> tile_;
+  rmm::device_uvector<math_t> x_batch_;
+  rmm::device_uvector<math_t> norm_batch_;
+};
+
+};  // end namespace raft::distance::kernels::detail
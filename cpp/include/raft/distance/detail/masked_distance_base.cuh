@@ -19,11 +19,29 @@
 #include <raft/util/cuda_utils.cuh>
 
 #include <cstddef>
+#include <cstdint>
 
 namespace raft {
 namespace distance {
 namespace detail {
 
+/**
+ * @brief The adjacency of the masked nearest neighbor computations as a list of entries.
+ *
+ * Entry `e` states that the rows of `x` set in the bitfield `masks[e]`, among the rows of the tile
+ * `tile_ids[e]` (of 64 rows), are adjacent to the group `group_ids[e]` of `y`. The entries are
+ * sorted by row tile. `chunk_ends` is the inclusive scan of the number of column tiles of the
+ * groups of the entries, i.e. of the work of the entries.
+ */
+template <typename IdxT>
+struct masked_sparse_work {
+  const IdxT* tile_ids;
+  const IdxT* group_ids;
+  const uint64_t* masks;
+  const IdxT* chunk_ends;
+  IdxT n_entries;
+};
+
 /**
  * @brief Device class for masked nearest neighbor computations.
  *
@@ -176,51 +194,107 @@ struct MaskedDistances : public BaseClass {
         auto tile_idx_n        = idx_g == 0 ? 0 : group_idxs[idx_g - 1];
         const auto group_end_n = group_idxs[idx_g];
         for (; tile_idx_n < group_end_n; tile_idx_n += P::Nblk) {
-          // We provide group_end_n to limit the number of unnecessary data
-          // points that are loaded from y.
-          this->ldgXY(tile_idx_m, tile_idx_n, 0, group_end_n);
+          process_tile(tile_idx_m, tile_idx_n, group_end_n, thread_adj);
+        }
+      }  // idx_g
+      rowEpilog_op(tile_idx_m);
+    }  // tile_idx_m
+  }
 
-          reset_accumulator();
-          this->stsXY();
-          __syncthreads();
-          this->switch_write_buffer();
+  /**
+   * Same as run, with the adjacency given as a list of (row tile, group) entries, see
+   * masked_sparse_work. The blocks process contiguous ranges of the column tiles of the entries,
+   * of equal length, so that the work of a block does not depend on how the groups are
+   * distributed over the rows.
+   */
+  DI void run_sparse(const masked_sparse_work<IdxT>& work)
+  {
+    if (work.n_entries == 0) { return; }
+    const IdxT n_chunks = work.chunk_ends[work.n_entries - 1];
+    const IdxT chunk_begin =
+      static_cast<IdxT>((static_cast<int64_t>(n_chunks) * blockIdx.x) / gridDim.x);
+    const IdxT chunk_end =
+      static_cast<IdxT>((static_cast<int64_t>(n_chunks) * (blockIdx.x + 1)) / gridDim.x);
+    if (chunk_begin >= chunk_end) { return; }
 
-          for (int kidx = P::Kblk; kidx < this->k; kidx += P::Kblk) {
-            this->ldgXY(tile_idx_m, tile_idx_n, kidx, group_end_n);
-            // Process all data in shared memory (previous k-block) and
-            // accumulate in registers.
-            if (thread_adj != 0) { accumulate(); }
-            this->stsXY();
-            __syncthreads();
-            this->switch_write_buffer();
-            this->switch_read_buffer();
-          }
-          if (thread_adj != 0) {
-            accumulate();  // last iteration
-          }
-          // The pre-condition for the loop over tile_idx_n is that write_buffer
-          // and read_buffer point to the same buffer. This flips read_buffer
-          // back so that it satisfies the pre-condition of this loop.
-          this->switch_read_buffer();
+    // The first entry whose column tiles extend past chunk_begin
+    IdxT entry = 0;
+    IdxT count = work.n_entries;
+    while (count > 0) {
+      IdxT half = count / 2;
+      if (work.chunk_ends[entry + half] <= chunk_begin) {
+        entry += half + 1;
+        count -= half + 1;
+      } else {
+        count = half;
+      }
+    }
 
-          if (useNorms) {
-            DataT regxn[P::AccRowsPerTh], regyn[P::AccColsPerTh];
-            load_norms(tile_idx_m, tile_idx_n, group_end_n, regxn, regyn);
-            if (thread_adj != 0) {
-              epilog_op(acc, thread_adj, regxn, regyn, tile_idx_n, tile_idx_m, group_end_n);
-            }
-          } else {
-            if (thread_adj != 0) {
-              epilog_op(acc, thread_adj, nullptr, nullptr, tile_idx_n, tile_idx_m, group_end_n);
-            }
-          }
-        }  // tile_idx_n
-      }    // idx_g
-      rowEpilog_op(tile_idx_m);
-    }  // tile_idx_m
+    IdxT row_tile = work.tile_ids[entry];
+    for (IdxT chunk = chunk_begin; chunk < chunk_end; chunk++) {
+      while (work.chunk_ends[entry] <= chunk) {
+        entry++;
+      }
+      // The rows of the previous tile are complete for this block
+      if (work.tile_ids[entry] != row_tile) {
+        rowEpilog_op(row_tile * P::Mblk);
+        row_tile = work.tile_ids[entry];
+      }
+      const IdxT idx_g             = work.group_ids[entry];
+      const IdxT group_begin_n     = idx_g == 0 ? 0 : group_idxs[idx_g - 1];
+      const IdxT group_end_n       = group_idxs[idx_g];
+      const IdxT entry_chunk_begin = entry == 0 ? 0 : work.chunk_ends[entry - 1];
+      const IdxT tile_idx_n        = group_begin_n + (chunk - entry_chunk_begin) * P::Nblk;
+      const int thread_adj         = compute_thread_adjacency(work.masks[entry]);
+      process_tile(row_tile * P::Mblk, tile_idx_n, group_end_n, thread_adj);
+    }
+    rowEpilog_op(row_tile * P::Mblk);
   }
 
  private:
+  /** Compute and reduce the distances of a tile of rows and a tile of columns of a group. */
+  DI void process_tile(IdxT tile_idx_m, IdxT tile_idx_n, IdxT group_end_n, int thread_adj)
+  {
+    // We provide group_end_n to limit the number of unnecessary data
+    // points that are loaded from y.
+    this->ldgXY(tile_idx_m, tile_idx_n, 0, group_end_n);
+
+    reset_accumulator();
+    this->stsXY();
+    __syncthreads();
+    this->switch_write_buffer();
+
+    for (int kidx = P::Kblk; kidx < this->k; kidx += P::Kblk) {
+      this->ldgXY(tile_idx_m, tile_idx_n, kidx, group_end_n);
+      // Process all data in shared memory (previous k-block) and
+      // accumulate in registers.
+      if (thread_adj != 0) { accumulate(); }
+      this->stsXY();
+      __syncthreads();
+      this->switch_write_buffer();
+      this->switch_read_buffer();
+    }
+    if (thread_adj != 0) {
+      accumulate();  // last iteration
+    }
+    // The pre-condition for the loop over tile_idx_n is that write_buffer
+    // and read_buffer point to the same buffer. This flips read_buffer
+    // back so that it satisfies the pre-condition of this loop.
+    this->switch_read_buffer();
+
+    if (useNorms) {
+      DataT regxn[P::AccRowsPerTh], regyn[P::AccColsPerTh];
+      load_norms(tile_idx_m, tile_idx_n, group_end_n, regxn, regyn);
+      if (thread_adj != 0) {
+        epilog_op(acc, thread_adj, regxn, regyn, tile_idx_n, tile_idx_m, group_end_n);
+      }
+    } else {
+      if (thread_adj != 0) {
+        epilog_op(acc, thread_adj, nullptr, nullptr, tile_idx_n, tile_idx_m, group_end_n);
+      }
+    }
+  }
+
   DI uint64_t get_block_adjacency(const uint64_t* adj, IdxT tile_idx_m, IdxT idx_group)
   {
     // A single element of `adj` contains exactly enough bits to indicate which
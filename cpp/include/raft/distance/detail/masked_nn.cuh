@@ -18,16 +18,27 @@
 
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/distance/detail/compress_to_bits.cuh>
 #include <raft/distance/detail/fused_distance_nn/fused_l2_nn.cuh>
 #include <raft/distance/detail/masked_distance_base.cuh>
 #include <raft/linalg/contractions.cuh>
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_uvector.hpp>
 
+#include <thrust/binary_search.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+
 #include <stdint.h>
 
+#include <algorithm>
 #include <limits>
 
 namespace raft {
@@ -41,7 +52,8 @@ template <typename DataT,
           typename ReduceOpT,
           typename KVPReduceOpT,
           typename CoreLambda,
-          typename FinalLambda>
+          typename FinalLambda,
+          bool Sparse = false>
 __launch_bounds__(P::Nthreads, 2) RAFT_KERNEL masked_l2_nn_kernel(OutT* min,
                                                                   const DataT* x,
                                                                   const DataT* y,
@@ -59,7 +71,8 @@ __launch_bounds__(P::Nthreads, 2) RAFT_KERNEL masked_l2_nn_kernel(OutT* min,
                                                                   ReduceOpT redOp,
                                                                   KVPReduceOpT pairRedOp,
                                                                   CoreLambda core_op,
-                                                                  FinalLambda fin_op)
+                                                                  FinalLambda fin_op,
+                                                                  masked_sparse_work<IdxT> work)
 {
   extern __shared__ char smem[];
 
@@ -181,7 +194,11 @@ __launch_bounds__(P::Nthreads, 2) RAFT_KERNEL masked_l2_nn_kernel(OutT* min,
         epilog_lambda,
         fin_op,
         rowEpilog_lambda);
-  obj.run();
+  if constexpr (Sparse) {
+    obj.run_sparse(work);
+  } else {
+    obj.run();
+  }
 }
 
 /**
@@ -318,7 +335,184 @@ void masked_l2_nn_impl(raft::resources const& handle,
                                             redOp,
                                             pairRedOp,
                                             core_lambda,
-                                            fin_op);
+                                            fin_op,
+                                            masked_sparse_work<IdxT>{});
+
+  RAFT_CUDA_TRY(cudaGetLastError());
+}
+
+/**
+ * @brief Wrapper for masked_l2_nn_kernel with the adjacency in the CSR format
+ *
+ * Same as masked_l2_nn_impl, except for the adjacency: `adj_indptr` and `adj_indices` give for
+ * each row of `x` the groups of `y` it is adjacent to. The adjacency is converted to a list of
+ * (row tile, group, bitfield of the rows) entries, hence the memory and the work are proportional
+ * to the number of nonzeros rather than to `m * num_groups`. The column tiles of all the entries
+ * are split evenly between the blocks.
+ *
+ * @param[in]  adj_indptr    Row offsets of the adjacency. Length = `m + 1`.
+ * @param[in]  adj_indices   Groups adjacent to the rows. Length = `adj_nnz`.
+ * @param[in]  adj_nnz       Number of nonzeros of the adjacency.
+ *
+ * See masked_l2_nn_impl for the other parameters.
+ */
+template <typename DataT, typename OutT, typename IdxT, typename ReduceOpT, typename KVPReduceOpT>
+void masked_l2_nn_csr_impl(raft::resources const& handle,
+                           OutT* out,
+                           const DataT* x,
+                           const DataT* y,
+                           const DataT* xn,
+                           const DataT* yn,
+                           const IdxT* adj_indptr,
+                           const IdxT* adj_indices,
+                           IdxT adj_nnz,
+                           const IdxT* group_idxs,
+                           IdxT num_groups,
+                           IdxT m,
+                           IdxT n,
+                           IdxT k,
+                           ReduceOpT redOp,
+                           KVPReduceOpT pairRedOp,
+                           bool sqrt,
+                           bool initOutBuffer)
+{
+  typedef typename linalg::Policy4x4<DataT, 1>::Policy P;
+
+  static_assert(P::Mblk == 64,
+                "masked_l2_nn_csr_impl only supports a policy with 64 rows per block.");
+
+  auto stream = resource::get_cuda_stream(handle);
+  auto ws_mr  = resource::get_workspace_resource(handle);
+  auto policy = resource::get_thrust_policy(handle);
+
+  // The (row tile, group) key and the row bit of every nonzero
+  rmm::device_uvector<IdxT> nz_rows{size_t(adj_nnz), stream, ws_mr};
+  rmm::device_uvector<int64_t> nz_keys{size_t(adj_nnz), stream, ws_mr};
+  rmm::device_uvector<uint64_t> nz_masks{size_t(adj_nnz), stream, ws_mr};
+  thrust::upper_bound(policy,
+                      adj_indptr + 1,
+                      adj_indptr + m + 1,
+                      thrust::make_counting_iterator<IdxT>(0),
+                      thrust::make_counting_iterator<IdxT>(adj_nnz),
+                      nz_rows.data());
+  thrust::transform(policy,
+                    nz_rows.data(),
+                    nz_rows.data() + adj_nnz,
+                    adj_indices,
+                    nz_keys.data(),
+                    [num_groups] __device__(IdxT row, IdxT group) {
+                      return static_cast<int64_t>(row / P::Mblk) * num_groups + group;
+                    });
+  thrust::transform(policy,
+                    nz_rows.data(),
+                    nz_rows.data() + adj_nnz,
+                    nz_masks.data(),
+                    [] __device__(IdxT row) { return uint64_t{1} << (row % P::Mblk); });
+
+  // Merge the nonzeros of a row tile and a group into an entry
+  thrust::sort_by_key(policy, nz_keys.data(), nz_keys.data() + adj_nnz, nz_masks.data());
+  rmm::device_uvector<int64_t> entry_keys{size_t(adj_nnz), stream, ws_mr};
+  rmm::device_uvector<uint64_t> entry_masks{size_t(adj_nnz), stream, ws_mr};
+  auto entries_end = thrust::reduce_by_key(policy,
+                                           nz_keys.data(),
+                                           nz_keys.data() + adj_nnz,
+                                           nz_masks.data(),
+                                           entry_keys.data(),
+                                           entry_masks.data(),
+                                           thrust::equal_to<int64_t>{},
+                                           thrust::bit_or<uint64_t>{});
+  IdxT n_entries = entries_end.first - entry_keys.data();
+
+  rmm::device_uvector<IdxT> tile_ids{size_t(n_entries), stream, ws_mr};
+  rmm::device_uvector<IdxT> group_ids{size_t(n_entries), stream, ws_mr};
+  rmm::device_uvector<IdxT> chunk_ends{size_t(n_entries), stream, ws_mr};
+  thrust::transform(policy,
+                    entry_keys.data(),
+                    entry_keys.data() + n_entries,
+                    tile_ids.data(),
+                    [num_groups] __device__(int64_t key) { return IdxT(key / num_groups); });
+  thrust::transform(policy,
+                    entry_keys.data(),
+                    entry_keys.data() + n_entries,
+                    group_ids.data(),
+                    [num_groups] __device__(int64_t key) { return IdxT(key % num_groups); });
+  thrust::transform_inclusive_scan(
+    policy,
+    group_ids.data(),
+    group_ids.data() + n_entries,
+    chunk_ends.data(),
+    [group_idxs] __device__(IdxT group) {
+      IdxT begin = group == 0 ? 0 : group_idxs[group - 1];
+      return raft::ceildiv<IdxT>(group_idxs[group] - begin, P::Nblk);
+    },
+    thrust::plus<IdxT>{});
+
+  rmm::device_uvector<int> ws_fused_nn{size_t(m), stream, ws_mr};
+  RAFT_CUDA_TRY(cudaMemsetAsync(ws_fused_nn.data(), 0, ws_fused_nn.size() * sizeof(int), stream));
+
+  // Initialize output buffer with keyvalue pairs as determined by the reduction
+  // operator (it will be called with maxVal).
+  constexpr auto maxVal = std::numeric_limits<DataT>::max();
+  if (initOutBuffer) {
+    dim3 grid(raft::ceildiv<int>(m, P::Nthreads));
+    dim3 block(P::Nthreads);
+
+    initKernel<DataT, OutT, IdxT, ReduceOpT><<<grid, block, 0, stream>>>(out, m, maxVal, redOp);
+    RAFT_CUDA_TRY(cudaGetLastError());
+  }
+  if (n_entries == 0) { return; }
+
+  // Accumulation operation lambda
+  auto core_lambda = [] __device__(DataT & acc, DataT & x, DataT & y) { acc += x * y; };
+  auto fin_op      = raft::identity_op{};
+
+  constexpr bool sparse     = true;
+  auto kernel               = masked_l2_nn_kernel<DataT,
+                                    OutT,
+                                    IdxT,
+                                    P,
+                                    ReduceOpT,
+                                    KVPReduceOpT,
+                                    decltype(core_lambda),
+                                    decltype(fin_op),
+                                    sparse>;
+  constexpr size_t smemSize = P::SmemSize + ((P::Mblk + P::Nblk) * sizeof(DataT));
+
+  // As many blocks as fit the device, they share the column tiles of all the entries.
+  IdxT n_chunks = 0;
+  raft::update_host(&n_chunks, chunk_ends.data() + n_entries - 1, 1, stream);
+  int dev_id;
+  RAFT_CUDA_TRY(cudaGetDevice(&dev_id));
+  int num_sms;
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&num_sms, cudaDevAttrMultiProcessorCount, dev_id));
+  int blocks_per_sm = 0;
+  RAFT_CUDA_TRY(
+    cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blocks_per_sm, kernel, P::Nthreads, smemSize));
+  resource::sync_stream(handle, stream);
+  dim3 block(P::Nthreads);
+  dim3 grid(std::max<int64_t>(1, std::min<int64_t>(n_chunks, int64_t(num_sms) * blocks_per_sm)));
+
+  masked_sparse_work<IdxT> work{
+    tile_ids.data(), group_ids.data(), entry_masks.data(), chunk_ends.data(), n_entries};
+  kernel<<<grid, block, smemSize, stream>>>(out,
+                                            x,
+                                            y,
+                                            xn,
+                                            yn,
+                                            nullptr,
+                                            group_idxs,
+                                            num_groups,
+                                            m,
+                                            n,
+                                            k,
+                                            sqrt,
+                                            maxVal,
+                                            ws_fused_nn.data(),
+                                            redOp,
+                                            pairRedOp,
+                                            core_lambda,
+                                            fin_op,
+                                            work);
 
   RAFT_CUDA_TRY(cudaGetLastError());
 }
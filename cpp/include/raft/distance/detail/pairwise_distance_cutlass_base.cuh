@@ -55,7 +55,8 @@ template <typename DataT,
           int VecLen,
           typename FinalLambda,
           typename OpT,
-          bool isRowMajor>
+          bool isRowMajor,
+          int NumStages = 3>
 std::enable_if_t<ops::has_cutlass_op<OpT>::value> cutlassDistanceKernel(const DataT* x,
                                                                         const DataT* y,
                                                                         const DataT* xn,
@@ -91,8 +92,6 @@ std::enable_if_t<ops::has_cutlass_op<OpT>::value> cutlassDistanceKernel(const Da
 
   typename EpilogueOutputOp::Params epilog_op_param(dist_op, fin_op);
 
-  // Number of pipelines you want to use
-  constexpr int NumStages = 3;
   // Alignment
   constexpr int Alignment = VecLen;
 
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/operators.hpp>                                   // raft::identity_op
+#include <raft/core/resource/cuda_stream.hpp>                        // get_cuda_stream
+#include <raft/core/resources.hpp>                                   // raft::resources
+#include <raft/distance/detail/distance_ops/all_ops.cuh>             // ops::*
+#include <raft/distance/detail/pairwise_distance_base.cuh>           // PairwiseDistances
+#include <raft/distance/detail/pairwise_matrix/dispatch_layout.cuh>  // dispatch_layout
+#include <raft/distance/detail/pairwise_matrix/params.cuh>           // pairwise_matrix_params
+#include <raft/distance/distance_types.hpp>                          // DistanceType
+#include <raft/linalg/contractions.cuh>                              // Policy4x4
+#include <raft/linalg/norm.cuh>                                      // rowNorm
+#include <raft/util/cuda_rt_essentials.hpp>                          // RAFT_CUDA_TRY
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>    // std::min
+#include <type_traits>  // std::conditional
+
+namespace raft::distance::detail {
+
+/**
+ * The pairwise distance kernel, where the distances of every tile are passed to `reduce_op`
+ * instead of being written out.
+ */
+template <typename Policy,
+          bool row_major,
+          typename OpT,
+          typename IdxT,
+          typename DataT,
+          typename ReduceOpT>
+__launch_bounds__(Policy::Nthreads, 2) RAFT_KERNEL pairwise_distance_reduce_kernel(
+  OpT distance_op,
+  pairwise_matrix_params<IdxT, DataT, typename OpT::AccT, raft::identity_op> params,
+  ReduceOpT reduce_op)
+{
+  using AccT = typename OpT::AccT;
+  extern __shared__ char smem[];
+
+  const IdxT m      = params.m;
+  const IdxT n      = params.n;
+  const int acc_row = threadIdx.x / Policy::AccThCols;
+  const int acc_col = threadIdx.x % Policy::AccThCols;
+
+  auto epilog_op = [=](AccT acc[Policy::AccRowsPerTh][Policy::AccColsPerTh],
+                       DataT*,
+                       DataT*,
+                       IdxT tile_idx_n,
+                       IdxT tile_idx_m) {
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+      const IdxT row = tile_idx_m + acc_row + i * Policy::AccThRows;
+#pragma unroll
+      for (int j = 0; j < Policy::AccColsPerTh; ++j) {
+        const IdxT col = tile_idx_n + acc_col + j * Policy::AccThCols;
+        if (row < m && col < n) {
+          // The inputs in column-major order have been swapped before the launch
+          if constexpr (row_major) {
+            reduce_op(row, col, acc[i][j]);
+          } else {
+            reduce_op(col, row, acc[i][j]);
+          }
+        }
+      }
+    }
+  };
+  auto row_epilog_op = raft::void_op();
+
+  constexpr bool write_out = false;
+  PairwiseDistances<DataT,
+                    AccT,
+                    IdxT,
+                    Policy,
+                    OpT,
+                    decltype(epilog_op),
+                    raft::identity_op,
+                    decltype(row_epilog_op),
+                    row_major,
+                    write_out>
+    obj(params.x,
+        params.y,
+        params.m,
+        params.n,
+        params.k,
+        params.ldx,
+        params.ldy,
+        params.ld_out,
+        params.x_norm,
+        params.y_norm,
+        params.out,
+        smem,
+        distance_op,
+        epilog_op,
+        params.fin_op,
+        row_epilog_op);
+  obj.run();
+}
+
+template <typename OpT, typename DataT, typename IdxT, typename ReduceOpT>
+void pairwise_distance_reduce_dispatch(OpT distance_op,
+                                       IdxT m,
+                                       IdxT n,
+                                       IdxT k,
+                                       const DataT* x,
+                                       const DataT* y,
+                                       const DataT* x_norm,
+                                       const DataT* y_norm,
+                                       ReduceOpT reduce_op,
+                                       cudaStream_t stream,
+                                       bool is_row_major)
+{
+  using AccT = typename OpT::AccT;
+
+  // Same as for pairwise_matrix_dispatch, without an output matrix.
+  IdxT ldx = is_row_major ? k : m;
+  IdxT ldy = is_row_major ? k : n;
+  pairwise_matrix_params<IdxT, DataT, AccT, raft::identity_op> params{
+    m, n, k, ldx, ldy, 0, x, y, x_norm, y_norm, nullptr, raft::identity_op{}, is_row_major};
+  if (!params.is_row_major) { params.flip_x_and_y(); }
+
+  int vec_len = determine_vec_len(params);
+  auto f      = [&](auto row_major, auto vec_len_aligned) {
+    constexpr int vec_len_op = OpT::expensive_inner_loop ? 1 : vec_len_aligned();
+    constexpr int vec_len    = std::min(vec_len_op, static_cast<int>(16 / sizeof(DataT)));
+
+    using RowPolicy = typename raft::linalg::Policy4x4<DataT, vec_len>::Policy;
+    using ColPolicy = typename raft::linalg::Policy4x4<DataT, vec_len>::ColPolicy;
+    using Policy    = typename std::conditional<row_major(), RowPolicy, ColPolicy>::type;
+
+    int smem_size = OpT::template shared_mem_size<Policy>();
+    auto kernel =
+      pairwise_distance_reduce_kernel<Policy, row_major(), OpT, IdxT, DataT, ReduceOpT>;
+    dim3 grid = launchConfigGenerator<Policy>(params.m, params.n, smem_size, kernel);
+    kernel<<<grid, Policy::Nthreads, smem_size, stream>>>(distance_op, params, reduce_op);
+    RAFT_CUDA_TRY(cudaGetLastError());
+  };
+  dispatch_layout(params.is_row_major, vec_len, f);
+}
+
+/**
+ * See raft::distance::pairwise_distance_reduce. The inputs are prepared as in distance_impl.
+ */
+template <raft::distance::DistanceType DistT, typename DataT, typename IdxT, typename ReduceOpT>
+void pairwise_distance_reduce(raft::resources const& handle,
+                              const DataT* x,
+                              const DataT* y,
+                              IdxT m,
+                              IdxT n,
+                              IdxT k,
+                              ReduceOpT reduce_op,
+                              bool is_row_major,
+                              DataT metric_arg)
+{
+  using raft::distance::DistanceType;
+  cudaStream_t stream = raft::resource::get_cuda_stream(handle);
+
+  if constexpr (DistT == DistanceType::L2Expanded || DistT == DistanceType::L2SqrtExpanded ||
+                DistT == DistanceType::CosineExpanded) {
+    rmm::device_uvector<DataT> norms(m + n, stream);
+    DataT* x_norm = norms.data();
+    DataT* y_norm = norms.data() + m;
+    if constexpr (DistT == DistanceType::CosineExpanded) {
+      raft::linalg::rowNorm(
+        x_norm, x, k, m, raft::linalg::L2Norm, is_row_major, stream, raft::sqrt_op{});
+      raft::linalg::rowNorm(
+        y_norm, y, k, n, raft::linalg::L2Norm, is_row_major, stream, raft::sqrt_op{});
+      ops::cosine_distance_op<DataT, DataT, IdxT> distance_op{};
+      pairwise_distance_reduce_dispatch(
+        distance_op, m, n, k, x, y, x_norm, y_norm, reduce_op, stream, is_row_major);
+    } else {
+      raft::linalg::rowNorm(
+        x_norm, x, k, m, raft::linalg::L2Norm, is_row_major, stream, raft::identity_op{});
+      raft::linalg::rowNorm(
+        y_norm, y, k, n, raft::linalg::L2Norm, is_row_major, stream, raft::identity_op{});
+      constexpr bool sqrt = DistT == DistanceType::L2SqrtExpanded;
+      ops::l2_exp_distance_op<DataT, DataT, IdxT> distance_op{sqrt};
+      pairwise_distance_reduce_dispatch(
+        distance_op, m, n, k, x, y, x_norm, y_norm, reduce_op, stream, is_row_major);
+    }
+  } else {
+    auto run = [&](auto distance_op) {
+      const DataT* x_norm = nullptr;
+      const DataT* y_norm = nullptr;
+      pairwise_distance_reduce_dispatch(
+        distance_op, m, n, k, x, y, x_norm, y_norm, reduce_op, stream, is_row_major);
+    };
+    if constexpr (DistT == DistanceType::L2Unexpanded) {
+      run(ops::l2_unexp_distance_op<DataT, DataT, IdxT>{false});
+    } else if constexpr (DistT == DistanceType::L2SqrtUnexpanded) {
+      run(ops::l2_unexp_distance_op<DataT, DataT, IdxT>{true});
+    } else if constexpr (DistT == DistanceType::L1) {
+      run(ops::l1_distance_op<DataT, DataT, IdxT>{});
+    } else if constexpr (DistT == DistanceType::Linf) {
+      run(ops::l_inf_distance_op<DataT, DataT, IdxT>{});
+    } else if constexpr (DistT == DistanceType::Canberra) {
+      run(ops::canberra_distance_op<DataT, DataT, IdxT>{});
+    } else if constexpr (DistT == DistanceType::LpUnexpanded) {
+      run(ops::lp_unexp_distance_op<DataT, DataT, IdxT>{metric_arg});
+    } else {
+      static_assert(DistT == DistanceType::L2Expanded,
+                    "pairwise_distance_reduce does not support this distance");
+    }
+  }
+}
+
+}  // namespace raft::distance::detail
@@ -36,19 +36,19 @@
 #include <raft/distance/detail/pairwise_matrix/params.cuh>         // pairwise_matrix_params
 #include <raft/util/arch.cuh>                                      // raft::util::arch::SM_*
 
-// NOTE: to minimize compile times, we do not include dispatch_sm80.cuh.
-// Including dispatch_sm80.cuh can slow down compile times (due to CUTLASS).
+// NOTE: to minimize compile times, we do not include dispatch_sm80.cuh and
+// dispatch_sm90.cuh. Including them can slow down compile times (due to CUTLASS).
 // Therefore, it is the including file's responsibility to include the correct
 // dispatch_smXX.cuh headers, as is done in raft/distance/detail/distance.cuh
 // and src/distance/detail/pairwise_matrix/dispatch_*.cu.
 
 namespace raft::distance::detail {
 
-// This forward-declaration ensures that we do not need to include
-// dispatch_sm80.cuh if we are not calling it in practice. This makes compiling
-// all the non-CUTLASS based distance instantiations faster. For CUTLASS-based
-// distances, dispatch_sm80.cuh has to be included by the file including this
-// file.
+// These forward-declarations ensure that we do not need to include
+// dispatch_sm80.cuh and dispatch_sm90.cuh if we are not calling them in practice.
+// This makes compiling all the non-CUTLASS based distance instantiations faster.
+// For CUTLASS-based distances, dispatch_sm80.cuh and dispatch_sm90.cuh have to be
+// included by the file including this file.
 template <typename OpT,
           typename IdxT,
           typename DataT,
@@ -60,6 +60,17 @@ void pairwise_matrix_sm80_dispatch(OpT,
                                    SM_compat_t,
                                    cudaStream_t);
 
+template <typename OpT,
+          typename IdxT,
+          typename DataT,
+          typename OutT,
+          typename FinOpT,
+          typename SM_compat_t>
+void pairwise_matrix_sm90_dispatch(OpT,
+                                   pairwise_matrix_params<IdxT, DataT, OutT, FinOpT>,
+                                   SM_compat_t,
+                                   cudaStream_t);
+
 template <typename OpT,
           typename DataT,
           typename AccT,
@@ -90,7 +101,8 @@ void pairwise_matrix_dispatch(OpT distance_op,
   if (!params.is_row_major) { params.flip_x_and_y(); }
 
   // Dispatch rule:
-  // - execute CUTLASS-based kernel on SM_80 and above
+  // - execute CUTLASS-based kernel with a deeper pipeline on SM_90 and above
+  // - execute CUTLASS-based kernel on SM_80
   // - execute normal kernel below SM_80
   namespace arch = raft::util::arch;
 
@@ -101,7 +113,8 @@ void pairwise_matrix_dispatch(OpT distance_op,
     auto any_range = arch::SM_range(arch::SM_min(), arch::SM_future());
     pairwise_matrix_sm60_dispatch(distance_op, params, any_range, stream);
   } else {
-    auto cutlass_range = arch::SM_range(arch::SM_80(), arch::SM_future());
+    auto sm90_range    = arch::SM_range(arch::SM_90(), arch::SM_future());
+    auto cutlass_range = arch::SM_range(arch::SM_80(), arch::SM_90());
     auto legacy_range  = arch::SM_range(arch::SM_min(), arch::SM_80());
 
     // Get pointer to SM60 kernel to determine the best compute architecture
@@ -113,8 +126,11 @@ void pairwise_matrix_dispatch(OpT distance_op,
     void* kernel_ptr  = reinterpret_cast<void*>(sm60_wrapper.kernel_ptr);
     auto runtime_arch = arch::kernel_virtual_arch(kernel_ptr);
 
-    if (cutlass_range.contains(runtime_arch)) {
-      // If device is SM_80 or later, use CUTLASS-based kernel.
+    if (sm90_range.contains(runtime_arch)) {
+      // If device is SM_90 or later, use CUTLASS-based kernel tuned for its shared memory.
+      pairwise_matrix_sm90_dispatch(distance_op, params, sm90_range, stream);
+    } else if (cutlass_range.contains(runtime_arch)) {
+      // If device is SM_80, use CUTLASS-based kernel.
       pairwise_matrix_sm80_dispatch(distance_op, params, cutlass_range, stream);
     } else {
       // Reuse kernel wrapper that we obtained above. This avoids performing the
@@ -17,6 +17,7 @@
 
 #include <raft/distance/detail/pairwise_matrix/dispatch_layout.cuh>  // dispatch_layout
 #include <raft/distance/detail/pairwise_matrix/kernel_sm60.cuh>      // pairwise_matrix_sm60_wrapper
+#include <raft/distance/detail/pairwise_matrix/tuned_policy.cuh>     // tuned_vec_len
 #include <raft/linalg/contractions.cuh>                              // raft::linalg::Policy4x4
 
 #include <algorithm>  // std::min
@@ -34,7 +35,7 @@ pairwise_matrix_sm60_wrapper<OpT, IdxT, DataT, OutT, FinOpT> pairwise_matrix_sm6
   pairwise_matrix_params<IdxT, DataT, OutT, FinOpT> params,
   SM_compat_t sm_compat_range)
 {
-  int vec_len = determine_vec_len(params);
+  int vec_len = tuned_vec_len<OpT>(params, determine_vec_len(params));
 
   // f takes compile-time constants row_major and vec_len aligned and returns
   // the corresponding kernel wrapper. The wrapper contains the launch
@@ -17,24 +17,37 @@
 
 #include <raft/distance/detail/pairwise_distance_cutlass_base.cuh>   // cutlassDistanceKernel
 #include <raft/distance/detail/pairwise_matrix/dispatch_layout.cuh>  // dispatch_layout
+#include <raft/util/cuda_rt_essentials.hpp>                          // RAFT_CUDA_TRY
 
-#include <algorithm>  // std::min
+#include <rmm/device_uvector.hpp>  // rmm::device_uvector
+
+#include <algorithm>  // std::min, std::max
 
 namespace raft::distance::detail {
 
-template <typename OpT,
+// Runs the CUTLASS-based kernel with a mainloop of NumStages pipeline stages.
+template <int NumStages,
+          typename OpT,
           typename IdxT,
           typename DataT,
           typename OutT,
-          typename FinOpT,
-          typename SM_compat_t>
-void pairwise_matrix_sm80_dispatch(OpT distance_op,
-                                   pairwise_matrix_params<IdxT, DataT, OutT, FinOpT> params,
-                                   SM_compat_t sm_compat_range,
-                                   cudaStream_t stream)
+          typename FinOpT>
+void pairwise_matrix_cutlass_dispatch(OpT distance_op,
+                                      pairwise_matrix_params<IdxT, DataT, OutT, FinOpT> params,
+                                      cudaStream_t stream)
 {
   int vec_len = determine_vec_len(params);
 
+  // The CUTLASS epilogue always loads a norm per row of x and y. The ops that do not use them (e.g.
+  // Hellinger, Russell-Rao) get zeros.
+  rmm::device_uvector<DataT> zero_norms(0, stream);
+  if constexpr (!OpT::use_norms) {
+    zero_norms.resize(std::max(params.m, params.n), stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(zero_norms.data(), 0, zero_norms.size() * sizeof(DataT), stream));
+    params.x_norm = zero_norms.data();
+    params.y_norm = zero_norms.data();
+  }
+
   // f takes compile-time constants row_major and vec_len aligned and runs the
   // corresponding cutlass launch code.
   auto f = [&](auto row_major, auto vec_len_aligned) {
@@ -45,20 +58,21 @@ void pairwise_matrix_sm80_dispatch(OpT distance_op,
     constexpr int vec_len = std::min(vec_len_aligned(), static_cast<int>(16 / sizeof(DataT)));
 
     using AccT = typename OpT::AccT;
-    cutlassDistanceKernel<DataT, AccT, OutT, IdxT, vec_len, FinOpT, OpT, row_major()>(params.x,
-                                                                                      params.y,
-                                                                                      params.x_norm,
-                                                                                      params.y_norm,
-                                                                                      params.m,
-                                                                                      params.n,
-                                                                                      params.k,
-                                                                                      params.ldx,
-                                                                                      params.ldy,
-                                                                                      params.ld_out,
-                                                                                      params.out,
-                                                                                      params.fin_op,
-                                                                                      distance_op,
-                                                                                      stream);
+    cutlassDistanceKernel<DataT, AccT, OutT, IdxT, vec_len, FinOpT, OpT, row_major(), NumStages>(
+      params.x,
+      params.y,
+      params.x_norm,
+      params.y_norm,
+      params.m,
+      params.n,
+      params.k,
+      params.ldx,
+      params.ldy,
+      params.ld_out,
+      params.out,
+      params.fin_op,
+      distance_op,
+      stream);
   };
 
   // Dispatch_layout calls f with appropriate compile time constants based on
@@ -66,4 +80,18 @@ void pairwise_matrix_sm80_dispatch(OpT distance_op,
   dispatch_layout(params.is_row_major, vec_len, f);
 }
 
+template <typename OpT,
+          typename IdxT,
+          typename DataT,
+          typename OutT,
+          typename FinOpT,
+          typename SM_compat_t>
+void pairwise_matrix_sm80_dispatch(OpT distance_op,
+                                   pairwise_matrix_params<IdxT, DataT, OutT, FinOpT> params,
+                                   SM_compat_t sm_compat_range,
+                                   cudaStream_t stream)
+{
+  pairwise_matrix_cutlass_dispatch<3>(distance_op, params, stream);
+}
+
 };  // namespace raft::distance::detail
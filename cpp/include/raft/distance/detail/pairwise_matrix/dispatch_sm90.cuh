@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#pragma once
+
+#include <raft/distance/detail/pairwise_matrix/dispatch_sm80.cuh>  // cutlass dispatch
+
+namespace raft::distance::detail {
+
+// Number of stages of the CUTLASS mainloop on SM90. Hopper has 228 KB of shared memory per SM, so
+// the tiles of deeper pipelines (16 KB per stage for both float and double) still leave room for
+// two thread blocks per SM, while hiding more of the latency of the global loads.
+constexpr int kSm90CutlassStages = 5;
+
+template <typename OpT,
+          typename IdxT,
+          typename DataT,
+          typename OutT,
+          typename FinOpT,
+          typename SM_compat_t>
+void pairwise_matrix_sm90_dispatch(OpT distance_op,
+                                   pairwise_matrix_params<IdxT, DataT, OutT, FinOpT> params,
+                                   SM_compat_t sm_compat_range,
+                                   cudaStream_t stream)
+{
+  pairwise_matrix_cutlass_dispatch<kSm90CutlassStages>(distance_op, params, stream);
+}
+
+};  // namespace raft::distance::detail
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/distance/detail/distance_ops/all_ops.cuh>                // ops::*
+#include <raft/distance/detail/pairwise_matrix/params.cuh>              // pairwise_matrix_params
+#include <raft/distance/detail/pairwise_matrix/tuned_policy_table.hpp>  // tuned_policy_table
+#include <raft/util/cuda_rt_essentials.hpp>                             // RAFT_CUDA_TRY
+
+#include <algorithm>  // std::min
+#include <cstdint>    // uint64_t
+#include <cstring>    // std::strcmp
+
+namespace raft::distance::detail {
+
+/**
+ * The name of a distance op in the tuned policy table, or nullptr if the op is not tuned.
+ * The TUNE_DISTANCE benchmark labels its measurements with the same names.
+ */
+template <typename OpT>
+constexpr const char* tuning_name = nullptr;
+
+#define RAFT_DISTANCE_TUNING_NAME(op_type, name)    \
+  template <typename DataT, typename AccT, typename IdxT> \
+  constexpr const char* tuning_name<ops::op_type<DataT, AccT, IdxT>> = name;
+
+RAFT_DISTANCE_TUNING_NAME(canberra_distance_op, "canberra")
+RAFT_DISTANCE_TUNING_NAME(cosine_distance_op, "cosine")
+RAFT_DISTANCE_TUNING_NAME(dice_distance_op, "dice")
+RAFT_DISTANCE_TUNING_NAME(hamming_distance_op, "hamming")
+RAFT_DISTANCE_TUNING_NAME(hellinger_distance_op, "hellinger")
+RAFT_DISTANCE_TUNING_NAME(inner_product_distance_op, "inner_product")
+RAFT_DISTANCE_TUNING_NAME(l1_distance_op, "l1")
+RAFT_DISTANCE_TUNING_NAME(l2_exp_distance_op, "l2_exp")
+RAFT_DISTANCE_TUNING_NAME(l2_unexp_distance_op, "l2_unexp")
+RAFT_DISTANCE_TUNING_NAME(l_inf_distance_op, "l_inf")
+RAFT_DISTANCE_TUNING_NAME(lp_unexp_distance_op, "lp_unexp")
+RAFT_DISTANCE_TUNING_NAME(russel_rao_distance_op, "russel_rao")
+
+#undef RAFT_DISTANCE_TUNING_NAME
+
+/**
+ * @brief: The shape bucket of a pairwise distance problem in the tuned policy table
+ *
+ * The buckets split the depth k at 16, 64 and 256 (the number of Kblk iterations) and the size of
+ * the output at 2^22 elements (whether the grid fills the device many times over).
+ */
+template <typename IdxT>
+int tuning_shape_bucket(IdxT m, IdxT n, IdxT k)
+{
+  int k_bucket   = k <= 16 ? 0 : k <= 64 ? 1 : k <= 256 ? 2 : 3;
+  bool large_out = uint64_t(m) * uint64_t(n) >= (uint64_t(1) << 22);
+  return k_bucket + (large_out ? 4 : 0);
+}
+
+/** The compute capability of the current device, 10 * major + minor. */
+inline int tuning_device_sm()
+{
+  int dev, major, minor;
+  RAFT_CUDA_TRY(cudaGetDevice(&dev));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, dev));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, dev));
+  return 10 * major + minor;
+}
+
+/**
+ * @brief: Limits the vec_len of the kernel policy to the tuned value
+ *
+ * The vec_len is the only policy parameter chosen at run time (see dispatch_layout), so the tuned
+ * value selects among the kernels that are instantiated anyway. Without an entry for the op, the
+ * device and the shape bucket, the widest aligned load is kept.
+ *
+ * @param params           Kernel parameters
+ * @param vec_len_aligned  The widest vec_len allowed by the alignment of the inputs
+ */
+template <typename OpT, typename IdxT, typename DataT, typename OutT, typename FinOpT>
+int tuned_vec_len(pairwise_matrix_params<IdxT, DataT, OutT, FinOpT> params, int vec_len_aligned)
+{
+  if constexpr (tuned_policy_table.empty() || OpT::expensive_inner_loop ||
+                tuning_name<OpT> == nullptr) {
+    return vec_len_aligned;
+  } else {
+    int sm     = tuning_device_sm();
+    int bucket = tuning_shape_bucket(params.m, params.n, params.k);
+    for (const auto& entry : tuned_policy_table) {
+      if (entry.sm == sm && entry.shape_bucket == bucket &&
+          entry.data_bytes == int(sizeof(DataT)) && std::strcmp(entry.op, tuning_name<OpT>) == 0) {
+        return std::min(vec_len_aligned, entry.vec_len);
+      }
+    }
+    return vec_len_aligned;
+  }
+}
+
+};  // namespace raft::distance::detail
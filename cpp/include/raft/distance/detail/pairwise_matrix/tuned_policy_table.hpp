@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is generated by cpp/scripts/heuristics/pairwise_distance/generate_tuned_policy.py
+// from the results of the TUNE_DISTANCE benchmark. Do not edit it by hand.
+
+#pragma once
+
+#include <array>  // std::array
+
+namespace raft::distance::detail {
+
+/** The tuned vec_len of a distance op on one architecture and shape bucket. */
+struct tuned_policy_entry {
+  // the name of the distance op, see `tuning_name` in tuned_policy.cuh
+  const char* op;
+  // sizeof(DataT)
+  int data_bytes;
+  // the compute capability of the device, 10 * major + minor
+  int sm;
+  // see `tuning_shape_bucket` in tuned_policy.cuh
+  int shape_bucket;
+  int vec_len;
+};
+
+inline constexpr std::array<tuned_policy_entry, 0> tuned_policy_table{};
+
+}  // namespace raft::distance::detail
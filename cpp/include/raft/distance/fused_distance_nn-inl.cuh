@@ -21,6 +21,7 @@
 
 #include <raft/core/resources.hpp>
 #include <raft/distance/detail/fused_distance_nn.cuh>
+#include <raft/distance/detail/fused_distance_nn/simt_topk_kernel.cuh>
 #include <raft/distance/fused_distance_nn_helpers.cuh>
 #include <raft/linalg/contractions.cuh>
 #include <raft/util/cuda_utils.cuh>
@@ -320,6 +321,79 @@ void fusedDistanceNNMinReduce(OutT* min,
                                      stream);
 }
 
+/**
+ * @brief Fused distance and k-nearest-neighbor computation in a single call.
+ *
+ * Generalizes fusedDistanceNN to a small number of neighbors: every thread keeps the best
+ * candidates of its rows in registers, so that neither the distance matrix nor the candidate
+ * lists are written to the global memory. Useful e.g. for the refinement of k-means, or for the
+ * second closest center needed by balanced k-means splits.
+ *
+ * The neighbors of a row are sorted, the closest first. For `InnerProduct` the largest inner
+ * products are selected.
+ *
+ * @tparam DataT     data type
+ * @tparam IdxT      indexing arithmetic type
+ *
+ * @param[out] out_idx    indices of the `topk` neighbors of the rows of `x`. Row major.
+ *                        Dim = `m x topk`. (on device)
+ * @param[out] out_dist   the corresponding distances. Row major. Dim = `m x topk`. (on device)
+ * @param[in]  x          first matrix. Row major. Dim = `m x k`. (on device).
+ * @param[in]  y          second matrix. Row major. Dim = `n x k`. (on device).
+ * @param[in]  xn         L2 squared norm of `x` for the L2 metrics, L2 norm for cosine, unused
+ *                        for inner product. Length = `m`. (on device).
+ * @param[in]  yn         L2 squared norm of `y` for the L2 metrics, L2 norm for cosine, unused
+ *                        for inner product. Length = `n`. (on device)
+ * @param[in]  m          gemm m
+ * @param[in]  n          gemm n
+ * @param[in]  k          gemm k
+ * @param[in]  topk       number of neighbors, in [1, min(32, n)]
+ * @param[in]  isRowMajor whether the input/output is row or column major.
+ * @param[in]  metric     Distance metric to be used (supports L2Expanded, L2SqrtExpanded,
+ *                        CosineExpanded and InnerProduct)
+ * @param[in]  stream     cuda stream
+ */
+template <typename DataT, typename IdxT>
+void fusedDistanceNNTopK(IdxT* out_idx,
+                         DataT* out_dist,
+                         const DataT* x,
+                         const DataT* y,
+                         const DataT* xn,
+                         const DataT* yn,
+                         IdxT m,
+                         IdxT n,
+                         IdxT k,
+                         int topk,
+                         bool isRowMajor,
+                         raft::distance::DistanceType metric,
+                         cudaStream_t stream)
+{
+  ASSERT(isRowMajor, "fusedDistanceNNTopK only supports row major inputs");
+  RAFT_EXPECTS(topk <= n, "The number of neighbors must not exceed the number of rows of y");
+
+  size_t bytes = sizeof(DataT) * k;
+  auto px      = reinterpret_cast<uintptr_t>(x);
+  auto py      = reinterpret_cast<uintptr_t>(y);
+  if (16 % sizeof(DataT) == 0 && bytes % 16 == 0 && px % 16 == 0 && py % 16 == 0) {
+    detail::fusedDistanceNNTopKDispatch<
+      DataT,
+      IdxT,
+      typename linalg::Policy4x4<DataT, 16 / sizeof(DataT)>::Policy>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  } else if (8 % sizeof(DataT) == 0 && bytes % 8 == 0 && px % 8 == 0 && py % 8 == 0) {
+    detail::fusedDistanceNNTopKDispatch<
+      DataT,
+      IdxT,
+      typename linalg::Policy4x4<DataT, 8 / sizeof(DataT)>::Policy>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  } else {
+    detail::fusedDistanceNNTopKDispatch<DataT,
+                                        IdxT,
+                                        typename linalg::Policy4x4<DataT, 1>::Policy>(
+      out_idx, out_dist, x, y, xn, yn, m, n, k, topk, metric, stream);
+  }
+}
+
 /** @} */
 
 }  // namespace distance
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <raft/distance/detail/kernels/gram_matrix.cuh>
+#include <raft/distance/detail/kernels/kernel_cache.cuh>
 #include <raft/distance/detail/kernels/kernel_factory.cuh>
 #include <raft/distance/distance.cuh>
 #include <raft/linalg/gemm.cuh>
@@ -26,6 +27,7 @@ namespace raft::distance::kernels {
 
 // TODO: Need to expose formal APIs for this that are more consistent w/ other APIs in RAFT
 using raft::distance::kernels::detail::GramMatrixBase;
+using raft::distance::kernels::detail::KernelCache;
 using raft::distance::kernels::detail::KernelFactory;
 
 };  // end namespace raft::distance::kernels
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/handle.hpp>
 #include <raft/distance/detail/masked_nn.cuh>
 #include <raft/distance/fused_l2_nn.cuh>
@@ -193,6 +194,88 @@ void masked_l2_nn(raft::resources const& handle,
                                                           params.initOutBuffer);
 }
 
+/**
+ * @brief Masked L2 distance and 1-nearest-neighbor computation with a sparse adjacency.
+ *
+ * Same as masked_l2_nn, with the adjacency between the rows of `x` and the groups of `y` given as
+ * a CSR structure: the columns of row `i` are the groups whose distances to `x_i` are computed.
+ * The memory used by the adjacency, and the scheduling of the work, are proportional to the
+ * number of nonzeros instead of `m * num_groups`. The work is split evenly between the thread
+ * blocks whatever the distribution of the nonzeros over the rows.
+ *
+ * @tparam DataT     data type
+ * @tparam OutT      output type to either store 1-NN indices and their minimum
+ *                   distances or store only the min distances. Accordingly, one
+ *                   has to pass an appropriate `ReduceOpT`
+ * @tparam IdxT      indexing arithmetic type
+ * @tparam ReduceOpT A struct to perform the final needed reduction operation
+ *                   and also to initialize the output array elements with the
+ *                   appropriate initial value needed for reduction.
+ *
+ * @param handle             RAFT handle for managing expensive resources
+ * @param params             Parameter struct specifying the reduction operations.
+ * @param[in]  x             First matrix. Row major. Dim = `m x k`.
+ *                           (on device).
+ * @param[in]  y             Second matrix. Row major. Dim = `n x k`.
+ *                           (on device).
+ * @param[in]  x_norm        L2 squared norm of `x`. Length = `m`. (on device).
+ * @param[in]  y_norm        L2 squared norm of `y`. Length = `n`. (on device)
+ * @param[in]  adj           The sparsity structure of the adjacency, `m` rows and
+ *                           `num_groups` columns. (on device)
+ * @param[in]  group_idxs    An array containing the *end* indices of each group
+ *                           in `y`, see masked_l2_nn. Length = `num_groups`.
+ * @param[out] out           will contain the reduced output (Length = `m`)
+ *                           (on device)
+ */
+template <typename DataT, typename OutT, typename IdxT, typename ReduceOpT, typename KVPReduceOpT>
+void masked_l2_nn(raft::resources const& handle,
+                  raft::distance::masked_l2_nn_params<ReduceOpT, KVPReduceOpT> params,
+                  raft::device_matrix_view<const DataT, IdxT, raft::layout_c_contiguous> x,
+                  raft::device_matrix_view<const DataT, IdxT, raft::layout_c_contiguous> y,
+                  raft::device_vector_view<const DataT, IdxT, raft::layout_c_contiguous> x_norm,
+                  raft::device_vector_view<const DataT, IdxT, raft::layout_c_contiguous> y_norm,
+                  raft::device_compressed_structure_view<IdxT, IdxT, IdxT> adj,
+                  raft::device_vector_view<const IdxT, IdxT, raft::layout_c_contiguous> group_idxs,
+                  raft::device_vector_view<OutT, IdxT, raft::layout_c_contiguous> out)
+{
+  IdxT m          = x.extent(0);
+  IdxT n          = y.extent(0);
+  IdxT k          = x.extent(1);
+  IdxT num_groups = group_idxs.extent(0);
+
+  // Match k dimension of x, y
+  RAFT_EXPECTS(x.extent(1) == y.extent(1), "Dimension of vectors in x and y must be equal.");
+  // Match x, x_norm and y, y_norm
+  RAFT_EXPECTS(m == x_norm.extent(0), "Length of `x_norm` must match input `x`.");
+  RAFT_EXPECTS(n == y_norm.extent(0), "Length of `y_norm` must match input `y` ");
+  // Match adj to x and group_idxs
+  RAFT_EXPECTS(m == adj.get_n_rows(), "#rows in `adj` must match input `x`.");
+  RAFT_EXPECTS(num_groups == adj.get_n_cols(), "#cols in `adj` must match length of `group_idxs`.");
+  // NOTE: We do not check if all indices in group_idxs actually points *inside* y.
+
+  // If there is no work to be done, return immediately.
+  if (m == 0 || n == 0 || k == 0 || num_groups == 0) { return; }
+
+  detail::masked_l2_nn_csr_impl<DataT, OutT, IdxT, ReduceOpT>(handle,
+                                                              out.data_handle(),
+                                                              x.data_handle(),
+                                                              y.data_handle(),
+                                                              x_norm.data_handle(),
+                                                              y_norm.data_handle(),
+                                                              adj.get_indptr().data(),
+                                                              adj.get_indices().data(),
+                                                              adj.get_nnz(),
+                                                              group_idxs.data_handle(),
+                                                              num_groups,
+                                                              m,
+                                                              n,
+                                                              k,
+                                                              params.redOp,
+                                                              params.pairRedOp,
+                                                              params.sqrt,
+                                                              params.initOutBuffer);
+}
+
 /** @} */
 
 }  // namespace distance
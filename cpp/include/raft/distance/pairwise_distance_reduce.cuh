@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/pairwise_distance_reduce.cuh>
+#include <raft/distance/distance_types.hpp>
+
+#include <type_traits>
+
+namespace raft::distance {
+
+/**
+ * \defgroup pairwise_distance_reduce Pairwise distance reductions
+ * @{
+ */
+
+/**
+ * @brief Compute the pairwise distances and reduce them on the fly, without storing the distance
+ * matrix.
+ *
+ * The distances are computed tile by tile, as by `pairwise_distance`. Instead of being written
+ * out, every distance goes through `reduce_op` in the epilogue of its tile, while it is still in
+ * registers. This suits the jobs that reduce the distance matrix right after computing it, such as
+ * counting the pairs under a threshold, histogramming or summing the distances of each row: the
+ * `m x n` matrix never hits the global memory.
+ *
+ * `reduce_op` is called once for every pair, by an unspecified thread and in an unspecified order,
+ * hence it usually accumulates its result with atomics. It must be copyable to the device, with
+ * the signature:
+ * @code{.cpp}
+ *   __device__ void operator()(IdxT row, IdxT col, DataT dist) const;
+ * @endcode
+ *
+ * Usage example:
+ * @code{.cpp}
+ * #include <raft/distance/pairwise_distance_reduce.cuh>
+ *
+ * // count the pairs closer than eps
+ * auto count = raft::make_device_scalar<unsigned long long>(handle, 0);
+ * auto* count_ptr = count.data_handle();
+ * raft::distance::pairwise_distance_reduce<raft::distance::DistanceType::L2SqrtExpanded>(
+ *   handle, raft::make_const_mdspan(x.view()), raft::make_const_mdspan(y.view()),
+ *   [=] __device__(int row, int col, float dist) {
+ *     if (dist < eps) { atomicAdd(count_ptr, 1ull); }
+ *   });
+ * @endcode
+ *
+ * The supported distances are L2Expanded, L2SqrtExpanded, L2Unexpanded, L2SqrtUnexpanded,
+ * CosineExpanded, L1, Linf, Canberra and LpUnexpanded.
+ *
+ * @tparam DistT the distance
+ * @tparam DataT input and distance type
+ * @tparam IdxT indexing type
+ * @tparam layout layout of the inputs, row- or column-major
+ * @tparam ReduceOpT type of the reduction
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] x first set of points [m, k]
+ * @param[in] y second set of points [n, k]
+ * @param[in] reduce_op the reduction, called with (row of x, row of y, distance) for every pair
+ * @param[in] metric_arg metric argument (used for Minkowski distance)
+ */
+template <raft::distance::DistanceType DistT,
+          typename DataT,
+          typename IdxT,
+          typename layout,
+          typename ReduceOpT>
+void pairwise_distance_reduce(raft::resources const& handle,
+                              raft::device_matrix_view<const DataT, IdxT, layout> x,
+                              raft::device_matrix_view<const DataT, IdxT, layout> y,
+                              ReduceOpT reduce_op,
+                              DataT metric_arg = 2.0f)
+{
+  RAFT_EXPECTS(x.extent(1) == y.extent(1), "Number of columns must be equal.");
+  RAFT_EXPECTS(x.is_exhaustive(), "Input x must be contiguous.");
+  RAFT_EXPECTS(y.is_exhaustive(), "Input y must be contiguous.");
+
+  constexpr auto is_rowmajor = std::is_same_v<layout, layout_c_contiguous>;
+
+  detail::pairwise_distance_reduce<DistT>(handle,
+                                          x.data_handle(),
+                                          y.data_handle(),
+                                          x.extent(0),
+                                          y.extent(0),
+                                          x.extent(1),
+                                          reduce_op,
+                                          is_rowmajor,
+                                          metric_arg);
+}
+
+/** @} */
+
+}  // namespace raft::distance
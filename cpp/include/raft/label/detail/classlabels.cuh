@@ -17,6 +17,7 @@
 #pragma once
 
 #include <raft/core/operators.hpp>
+#include <raft/label/detail/hash_labels.cuh>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
@@ -49,6 +50,12 @@ namespace detail {
 template <typename value_t>
 int getUniquelabels(rmm::device_uvector<value_t>& unique, value_t* y, size_t n, cudaStream_t stream)
 {
+  if constexpr (hashable_label_v<value_t>) {
+    // deduplicate with a hash table and sort only the unique labels
+    unique_labels<value_t> uniq(y, n, stream);
+    unique = std::move(uniq.sorted);
+    return unique.size();
+  }
   rmm::device_scalar<int> d_num_selected(stream);
   rmm::device_uvector<value_t> workspace(n, stream);
   size_t bytes  = 0;
@@ -164,6 +171,11 @@ template <typename Type, typename Lambda>
 void make_monotonic(
   Type* out, Type* in, size_t N, cudaStream_t stream, Lambda filter_op, bool zero_based = false)
 {
+  if constexpr (hashable_label_v<Type>) {
+    make_monotonic_hashed(out, in, N, stream, filter_op, zero_based);
+    return;
+  }
+
   static const size_t TPB_X = 256;
 
   dim3 blocks(raft::ceildiv(N, TPB_X));
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/util/bounded_hash_map.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+#include <rmm/exec_policy.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/sort.h>
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace raft {
+namespace label {
+namespace detail {
+
+/**
+ * The labels of these types are deduplicated with a hash table rather than by sorting all of them:
+ * the table slots are claimed with a compare-and-swap on the label itself.
+ */
+template <typename value_t>
+constexpr bool hashable_label_v =
+  std::is_integral_v<value_t> && (sizeof(value_t) == 4 || sizeof(value_t) == 8);
+
+/**
+ * Open addressing hash table of labels. The largest label marks the empty slots: it is never
+ * inserted, but flagged in `has_empty_key`.
+ */
+template <typename value_t>
+using label_table = raft::util::
+  bounded_hash_set<value_t, uint64_t, raft::util::hash::fmix, std::numeric_limits<value_t>::max()>;
+
+template <typename value_t>
+RAFT_KERNEL insert_labels_kernel(label_table<value_t> table,
+                                 const value_t* y,
+                                 size_t n,
+                                 bool* has_empty_key)
+{
+  size_t tid = threadIdx.x + size_t(blockIdx.x) * blockDim.x;
+  if (tid >= n) { return; }
+  value_t key = y[tid];
+  if (key == label_table<value_t>::empty_key) {
+    *has_empty_key = true;
+  } else {
+    table.insert(key);
+  }
+}
+
+template <typename value_t>
+struct is_occupied {
+  __device__ bool operator()(value_t key) const { return key != label_table<value_t>::empty_key; }
+};
+
+/**
+ * Hash table holding the unique labels of an array, and their sorted list.
+ *
+ * Only the unique labels are sorted, which avoids sorting the whole array when the labels repeat.
+ * The table is sized for a load factor of at most 1/2.
+ */
+template <typename value_t>
+struct unique_labels {
+  rmm::device_uvector<value_t> keys;
+  rmm::device_uvector<value_t> sorted;
+  uint32_t bitlen;
+
+  unique_labels(const value_t* y, size_t n, cudaStream_t stream)
+    : keys(0, stream), sorted(0, stream), bitlen(6)
+  {
+    while (label_table<value_t>::size(bitlen) < 2 * n) {
+      bitlen++;
+    }
+    size_t capacity = label_table<value_t>::size(bitlen);
+    keys.resize(capacity, stream);
+    auto policy = rmm::exec_policy(stream);
+    thrust::fill(policy, keys.begin(), keys.end(), label_table<value_t>::empty_key);
+
+    rmm::device_scalar<bool> has_empty_key(false, stream);
+    if (n > 0) {
+      constexpr int TPB_X = 256;
+      insert_labels_kernel<<<raft::ceildiv(n, size_t(TPB_X)), TPB_X, 0, stream>>>(
+        table(), y, n, has_empty_key.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+
+    rmm::device_uvector<value_t> compacted(capacity, stream);
+    auto end =
+      thrust::copy_if(policy, keys.begin(), keys.end(), compacted.begin(), is_occupied<value_t>{});
+    size_t n_keys = end - compacted.begin();
+    bool has_max  = has_empty_key.value(stream);
+    // the label used to mark the empty slots is the largest one, so it goes last when present
+    sorted.resize(n_keys + has_max, stream);
+    raft::copy(sorted.data(), compacted.data(), n_keys, stream);
+    thrust::sort(policy, sorted.begin(), sorted.begin() + n_keys);
+    if (has_max) {
+      thrust::fill_n(policy, sorted.begin() + n_keys, 1, label_table<value_t>::empty_key);
+    }
+  }
+
+  label_table<value_t> table() { return label_table<value_t>{keys.data(), bitlen}; }
+};
+
+/** Store the rank of every unique label in the slot of the label. */
+template <typename value_t, typename rank_t>
+RAFT_KERNEL rank_labels_kernel(label_table<value_t> table,
+                               const value_t* sorted,
+                               size_t n_unique,
+                               rank_t* ranks)
+{
+  size_t tid = threadIdx.x + size_t(blockIdx.x) * blockDim.x;
+  if (tid >= n_unique) { return; }
+  value_t key = sorted[tid];
+  if (key != label_table<value_t>::empty_key) { ranks[table.find(key)] = rank_t(tid); }
+}
+
+template <typename value_t, typename Lambda>
+RAFT_KERNEL map_hashed_label_kernel(label_table<value_t> table,
+                                    const value_t* ranks,
+                                    value_t max_rank,
+                                    const value_t* in,
+                                    value_t* out,
+                                    size_t n,
+                                    Lambda filter_op,
+                                    bool zero_based)
+{
+  size_t tid = threadIdx.x + size_t(blockIdx.x) * blockDim.x;
+  if (tid >= n) { return; }
+  value_t key = in[tid];
+  if (filter_op(key)) { return; }
+  value_t rank = key == label_table<value_t>::empty_key ? max_rank : ranks[table.find(key)];
+  out[tid]     = rank + !zero_based;
+}
+
+/**
+ * Hash-based make_monotonic: the labels are deduplicated in a hash table, whose slots then hold
+ * the rank of their label among the sorted unique labels, so that relabeling every element is a
+ * single lookup rather than a scan of the unique labels.
+ */
+template <typename value_t, typename Lambda>
+void make_monotonic_hashed(
+  value_t* out, const value_t* in, size_t N, cudaStream_t stream, Lambda filter_op, bool zero_based)
+{
+  constexpr int TPB_X = 256;
+  unique_labels<value_t> uniq(in, N, stream);
+  size_t n_unique = uniq.sorted.size();
+  if (n_unique == 0) { return; }
+
+  rmm::device_uvector<value_t> ranks(uniq.keys.size(), stream);
+  rank_labels_kernel<<<raft::ceildiv(n_unique, size_t(TPB_X)), TPB_X, 0, stream>>>(
+    uniq.table(), uniq.sorted.data(), n_unique, ranks.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  map_hashed_label_kernel<<<raft::ceildiv(N, size_t(TPB_X)), TPB_X, 0, stream>>>(
+    uniq.table(), ranks.data(), value_t(n_unique - 1), in, out, N, filter_op, zero_based);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+};  // namespace detail
+};  // namespace label
+};  // end namespace raft
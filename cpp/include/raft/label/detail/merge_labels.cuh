@@ -28,42 +28,75 @@ namespace raft {
 namespace label {
 namespace detail {
 
+/** Root of the equivalence class of label l in the forest R, with path halving. */
+template <typename value_idx>
+__device__ value_idx find_label_root(value_idx* R, value_idx l)
+{
+  volatile value_idx* parents = R;
+  value_idx parent            = parents[l];
+  while (parent != l) {
+    value_idx grandparent = parents[parent];
+    // only ever points a label closer to its root, so that racing writes are benign
+    if (grandparent != parent) { parents[l] = grandparent; }
+    l      = parent;
+    parent = grandparent;
+  }
+  return l;
+}
+
+template <typename value_idx>
+__device__ value_idx cas_label(value_idx* address, value_idx compare, value_idx val)
+{
+  if constexpr (sizeof(value_idx) == 4) {
+    return atomicCAS(reinterpret_cast<unsigned int*>(address), compare, val);
+  } else {
+    return atomicCAS(reinterpret_cast<unsigned long long int*>(address), compare, val);
+  }
+}
+
 /** Note: this is one possible implementation where we represent the label
  *  equivalence graph implicitly using labels_a, labels_b and mask.
- *  For an additional cost we can build the graph with edges
- *  E={(A[i], B[i]) | M[i]=1} and make this step faster */
+ *  Every masked point unites the classes of its two labels in the forest R, hooking the larger
+ *  root under the smaller one with a compare-and-swap (which retries when another thread hooked
+ *  that root first), so that the root of every class is its smallest label. A single pass over
+ *  the points builds the whole forest: there is no fixed point to iterate to. */
 template <typename value_idx, int TPB_X = 256>
-RAFT_KERNEL __launch_bounds__(TPB_X) propagate_label_kernel(const value_idx* __restrict__ labels_a,
-                                                            const value_idx* __restrict__ labels_b,
-                                                            value_idx* __restrict__ R,
-                                                            const bool* __restrict__ mask,
-                                                            bool* __restrict__ m,
-                                                            value_idx N)
+RAFT_KERNEL __launch_bounds__(TPB_X) union_label_kernel(const value_idx* __restrict__ labels_a,
+                                                        const value_idx* __restrict__ labels_b,
+                                                        value_idx* R,
+                                                        const bool* __restrict__ mask,
+                                                        value_idx N)
 {
   value_idx tid = threadIdx.x + blockIdx.x * TPB_X;
   if (tid < N) {
     if (__ldg((char*)mask + tid)) {
       // Note: labels are from 1 to N
-      value_idx la = __ldg(labels_a + tid) - 1;
-      value_idx lb = __ldg(labels_b + tid) - 1;
-      value_idx ra = R[la];
-      value_idx rb = R[lb];
-      if (ra != rb) {
-        *m = true;
-        // min(ra, rb) would be sufficient but this speeds up convergence
-        value_idx rmin = R[min(ra, rb)];
-        if (sizeof(value_idx) == 4) {
-          atomicMin((int*)(R + la), rmin);
-          atomicMin((int*)(R + lb), rmin);
-        } else if (sizeof(value_idx) == 8) {
-          atomicMin((long long int*)(R + la), rmin);
-          atomicMin((long long int*)(R + lb), rmin);
+      value_idx ra = find_label_root(R, __ldg(labels_a + tid) - 1);
+      value_idx rb = find_label_root(R, __ldg(labels_b + tid) - 1);
+      while (ra != rb) {
+        if (ra > rb) {
+          value_idx tmp = ra;
+          ra            = rb;
+          rb            = tmp;
         }
+        value_idx prev = cas_label(R + rb, rb, ra);
+        if (prev == rb) { break; }
+        // rb was hooked by another thread meanwhile: retry from its new root
+        rb = find_label_root(R, prev);
+        ra = find_label_root(R, ra);
       }
     }
   }
 }
 
+/** Point every label of the forest R directly to the root of its class. */
+template <typename value_idx, int TPB_X = 256>
+RAFT_KERNEL __launch_bounds__(TPB_X) compress_label_kernel(value_idx* R, value_idx N)
+{
+  value_idx tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N) { R[tid] = find_label_root(R, tid); }
+}
+
 template <typename value_idx, int TPB_X = 256>
 RAFT_KERNEL __launch_bounds__(TPB_X) reassign_label_kernel(value_idx* __restrict__ labels_a,
                                                            const value_idx* __restrict__ labels_b,
@@ -107,7 +140,8 @@ RAFT_KERNEL __launch_bounds__(TPB_X) reassign_label_kernel(value_idx* __restrict
  * @param[in]    labels_b    Second input label array
  * @param[in]    mask        Core point mask
  * @param[out]   R           label equivalence map
- * @param[in]    m           Working flag
+ * @param[in]    m           Working flag (unused: the merge no longer iterates to a fixed point on
+ *                           the host)
  * @param[in]    N           Number of points in the dataset
  * @param[in]    stream      CUDA stream
  */
@@ -134,18 +168,13 @@ void merge_labels(value_idx* labels_a,
   // The edges connect groups from the two labellings. Only points with true
   // mask can induce connection between groups.
 
-  // Step 1: compute connected components in the label equivalence graph
-  bool host_m;
-  do {
-    RAFT_CUDA_TRY(cudaMemsetAsync(m, false, sizeof(bool), stream));
-
-    propagate_label_kernel<value_idx, TPB_X>
-      <<<blocks, threads, 0, stream>>>(labels_a, labels_b, R, mask, m, N);
-    RAFT_CUDA_TRY(cudaPeekAtLastError());
-
-    raft::update_host(&host_m, m, 1, stream);
-    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
-  } while (host_m);
+  // Step 1: compute connected components in the label equivalence graph, with a union-find
+  // converging on the device in a fixed number of passes
+  union_label_kernel<value_idx, TPB_X>
+    <<<blocks, threads, 0, stream>>>(labels_a, labels_b, R, mask, N);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  compress_label_kernel<value_idx, TPB_X><<<blocks, threads, 0, stream>>>(R, N);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
 
   // Step 2: re-assign minimum equivalent label
   reassign_label_kernel<value_idx, TPB_X>
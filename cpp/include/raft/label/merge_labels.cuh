@@ -45,11 +45,15 @@ namespace label {
  * represent the connected components of graphs G_A and G_B, and the output
  * would be the connected components labels of G_A \union G_B.
  *
+ * The label equivalences are resolved with a union-find on the device, so the merge does not
+ * synchronize the stream.
+ *
  * @param[inout] labels_a    First input, and output label array (in-place)
  * @param[in]    labels_b    Second input label array
  * @param[in]    mask        Core point mask
  * @param[out]   R           label equivalence map
- * @param[in]    m           Working flag
+ * @param[in]    m           Working flag (unused: the merge no longer iterates to a fixed point on
+ *                           the host)
  * @param[in]    N           Number of points in the dataset
  * @param[in]    stream      CUDA stream
  */
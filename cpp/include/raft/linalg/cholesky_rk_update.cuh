@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/cholesky_rk_update.cuh"
+#include "linalg_types.hpp"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+
+namespace raft {
+namespace linalg {
+
+/**
+ * @defgroup cholesky_rk_update Rank k update of a Cholesky decomposition
+ * @{
+ */
+
+/**
+ * @brief Rank k update or downdate of a Cholesky decomposition.
+ *
+ * On entry, L is the Cholesky decomposition of the (n, n) matrix A. On exit, L is the Cholesky
+ * decomposition of A' = A + V V^T, or of A' = A - V V^T for a downdate, where V is an (n, k)
+ * matrix. For example, with A = X^T X, adding (or removing) the rows X_new of X is the update
+ * with V = X_new^T.
+ *
+ * Unlike applying k times raft::linalg::choleskyRank1Update, the update is computed by blocks with
+ * cuBLAS trsm, syrk and gemm calls, in O(n^2 k) flops.
+ *
+ * If uplo is raft::linalg::FillMode::LOWER, L stores the lower triangular matrix L with
+ * A = L * L^T. Otherwise L stores an upper triangular matrix U with A = U^T * U. The other
+ * triangle is not referenced.
+ *
+ * If A' is not positive definite, which can happen for a downdate, an exception is thrown and
+ * the content of L is undefined.
+ *
+ * @code{.cpp}
+ * auto L = raft::make_device_matrix<float, int, raft::col_major>(handle, n, n);
+ * // ... L is the lower Cholesky factor of A
+ * raft::linalg::cholesky_rank_k_update(handle, L.view(), raft::make_const_mdspan(V.view()));
+ * // L is now the lower Cholesky factor of A + V V^T
+ * @endcode
+ *
+ * @tparam ValueType the data-type of input/output
+ * @tparam IndexType Integer type used to for addressing
+ * @param[in] handle raft::resources
+ * @param[inout] L the (n, n) Cholesky factor to update, of type raft::device_matrix_view
+ * @param[in] V the (n, k) update, of type raft::device_matrix_view
+ * @param[in] downdate whether to subtract V V^T instead of adding it
+ * @param[in] uplo whether L stores a lower or an upper triangular factor
+ */
+template <typename ValueType, typename IndexType>
+void cholesky_rank_k_update(raft::resources const& handle,
+                            raft::device_matrix_view<ValueType, IndexType, raft::col_major> L,
+                            raft::device_matrix_view<const ValueType, IndexType, raft::col_major> V,
+                            bool downdate = false,
+                            FillMode uplo = FillMode::LOWER)
+{
+  RAFT_EXPECTS(L.extent(0) == L.extent(1), "L must be square");
+  RAFT_EXPECTS(V.extent(0) == L.extent(0), "Size mismatch between L and V");
+
+  auto fill = uplo == FillMode::LOWER ? CUBLAS_FILL_MODE_LOWER : CUBLAS_FILL_MODE_UPPER;
+  detail::choleskyRankKUpdate(handle,
+                              L.data_handle(),
+                              static_cast<int>(L.extent(0)),
+                              static_cast<int>(L.extent(0)),
+                              V.data_handle(),
+                              static_cast<int>(V.extent(1)),
+                              static_cast<int>(V.extent(0)),
+                              false,
+                              downdate,
+                              fill,
+                              resource::get_cuda_stream(handle));
+}
+
+/** @} */  // end of cholesky_rk_update
+
+};  // namespace linalg
+};  // namespace raft
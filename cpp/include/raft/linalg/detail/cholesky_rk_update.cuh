@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cublas_wrappers.hpp"
+#include "cusolver_wrappers.hpp"
+
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cublas_handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cusolver_dn_handle.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+namespace detail {
+
+/** Set the leading (n, n) block of the column major matrix a to the identity. */
+template <typename math_t>
+RAFT_KERNEL eye_kernel(math_t* a, int n, int lda)
+{
+  const int i = threadIdx.x + blockDim.x * blockIdx.x;
+  const int j = blockIdx.y;
+  if (i < n) { a[i + size_t(j) * lda] = i == j ? math_t(1) : math_t(0); }
+}
+
+/**
+ * Copy the lower triangle of the (n, n) matrix src into dst, where a matrix flagged as upper stores
+ * the transposed triangle in its upper part. With `fill`, the strict upper part of the lower dst
+ * is zeroed; otherwise the other triangle of dst is left untouched.
+ */
+template <typename math_t>
+RAFT_KERNEL copy_triangle_kernel(const math_t* src,
+                                 int ld_src,
+                                 bool src_upper,
+                                 math_t* dst,
+                                 int ld_dst,
+                                 bool dst_upper,
+                                 int n,
+                                 bool fill)
+{
+  const int i = threadIdx.x + blockDim.x * blockIdx.x;
+  const int j = blockIdx.y;
+  if (i >= n) { return; }
+  if (i >= j) {
+    math_t v = src_upper ? src[j + size_t(i) * ld_src] : src[i + size_t(j) * ld_src];
+    if (dst_upper) {
+      dst[j + size_t(i) * ld_dst] = v;
+    } else {
+      dst[i + size_t(j) * ld_dst] = v;
+    }
+  } else if (fill) {
+    dst[i + size_t(j) * ld_dst] = math_t(0);
+  }
+}
+
+template <typename math_t>
+void eye(math_t* a, int n, int lda, cudaStream_t stream)
+{
+  constexpr int TPB = 128;
+  eye_kernel<<<dim3(raft::ceildiv(n, TPB), n), TPB, 0, stream>>>(a, n, lda);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename math_t>
+void copy_triangle(const math_t* src,
+                   int ld_src,
+                   bool src_upper,
+                   math_t* dst,
+                   int ld_dst,
+                   bool dst_upper,
+                   int n,
+                   bool fill,
+                   cudaStream_t stream)
+{
+  constexpr int TPB = 128;
+  copy_triangle_kernel<<<dim3(raft::ceildiv(n, TPB), n), TPB, 0, stream>>>(
+    src, ld_src, src_upper, dst, ld_dst, dst_upper, n, fill);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Rank k update (or downdate) L' L'^T = L L^T + s V V^T of a Cholesky factor, with s = 1 (or -1).
+ *
+ * The columns of V are applied in chunks of at most kBlockSize, and for every chunk the factor is
+ * updated one column block at a time. With the partitions
+ *   L = [[L_11, 0], [L_21, L_22]], V = [[V_1], [V_2]]
+ * where L_11 is the (b, b) diagonal block, and
+ *   Z = L_11^-1 V_1,  C C^T = I + s Z Z^T,  R^T R = I + s Z^T Z,
+ * the updated block column is
+ *   L_11' = L_11 C,  L_21' = (L_21 + s V_2 Z^T) C^-T
+ * and the trailing factor L_22 gets the rank k update of the same sign with
+ *   V_2' = (V_2 - L_21 Z) R^-1.
+ * Every step is a trsm, syrk or gemm over the block column, or a potrf of a small matrix, so a
+ * rank k update costs O(n^2 k) flops in O(n k / kBlockSize^2) cuBLAS calls.
+ *
+ * V is a column major (n, k) matrix, or its transpose when trans_v.
+ */
+template <typename math_t>
+void choleskyRankKUpdate(raft::resources const& handle,
+                         math_t* L,
+                         int n,
+                         int ld,
+                         const math_t* V,
+                         int k,
+                         int ldv,
+                         bool trans_v,
+                         bool downdate,
+                         cublasFillMode_t uplo,
+                         cudaStream_t stream)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "raft::linalg::choleskyRankKUpdate(%d, %d)", n, k);
+  if (n == 0 || k == 0) { return; }
+  constexpr int kBlockSize = 64;
+
+  cublasHandle_t cublas_h       = resource::get_cublas_handle(handle);
+  cusolverDnHandle_t cusolver_h = resource::get_cusolver_dn_handle(handle);
+  const bool upper              = uplo == CUBLAS_FILL_MODE_UPPER;
+  const cublasOperation_t op    = upper ? CUBLAS_OP_T : CUBLAS_OP_N;
+  const math_t one              = 1;
+  const math_t zero             = 0;
+  const math_t minus_one        = -1;
+  const math_t sign             = downdate ? -1 : 1;
+
+  const int nb       = std::min(n, kBlockSize);
+  const int kb       = std::min(k, kBlockSize);
+  const int n_blocks = raft::ceildiv(n, nb);
+  const int n_chunks = raft::ceildiv(k, kb);
+
+  rmm::device_uvector<math_t> v_buf(size_t(n) * kb, stream);
+  rmm::device_uvector<math_t> w_buf(size_t(n) * kb, stream);
+  rmm::device_uvector<math_t> z(nb * kb, stream);
+  rmm::device_uvector<math_t> r(kb * kb, stream);
+  rmm::device_uvector<math_t> c(nb * nb, stream);
+  rmm::device_uvector<math_t> t(nb * nb, stream);
+  rmm::device_uvector<math_t> l11(nb * nb, stream);
+  int lwork_c = 0;
+  int lwork_r = 0;
+  RAFT_CUSOLVER_TRY(
+    cusolverDnpotrf_bufferSize(cusolver_h, CUBLAS_FILL_MODE_LOWER, nb, c.data(), nb, &lwork_c));
+  RAFT_CUSOLVER_TRY(
+    cusolverDnpotrf_bufferSize(cusolver_h, CUBLAS_FILL_MODE_UPPER, kb, r.data(), kb, &lwork_r));
+  const int lwork = std::max(lwork_c, lwork_r);
+  rmm::device_uvector<math_t> work(lwork, stream);
+  // the potrf infos are only checked at the end, to avoid synchronizing for every block
+  rmm::device_uvector<int> info(2 * n_blocks * n_chunks, stream);
+
+  for (int chunk = 0; chunk < n_chunks; chunk++) {
+    const int c0 = chunk * kb;
+    const int kc = std::min(kb, k - c0);
+    math_t* v    = v_buf.data();
+    math_t* w    = w_buf.data();
+    // v <- the columns [c0, c0 + kc) of V
+    const math_t* v_src = trans_v ? V + c0 : V + size_t(c0) * ldv;
+    RAFT_CUBLAS_TRY(cublasgeam(cublas_h,
+                               trans_v ? CUBLAS_OP_T : CUBLAS_OP_N,
+                               CUBLAS_OP_N,
+                               n,
+                               kc,
+                               &one,
+                               v_src,
+                               ldv,
+                               &zero,
+                               v,
+                               n,
+                               v,
+                               n,
+                               stream));
+
+    for (int blk = 0; blk < n_blocks; blk++) {
+      const int j0   = blk * nb;
+      const int b    = std::min(nb, n - j0);
+      const int rows = n - j0 - b;
+      math_t* L_11   = L + j0 + size_t(j0) * ld;
+      // L_21 for the lower factor, and L_21^T (the block row right of L_11) for the upper one
+      math_t* L_21  = upper ? L + j0 + size_t(j0 + b) * ld : L + j0 + b + size_t(j0) * ld;
+      int* info_blk = info.data() + 2 * (blk + n_blocks * chunk);
+
+      // Z = L_11^-1 V_1
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(z.data(),
+                                      nb * sizeof(math_t),
+                                      v + j0,
+                                      n * sizeof(math_t),
+                                      b * sizeof(math_t),
+                                      kc,
+                                      cudaMemcpyDeviceToDevice,
+                                      stream));
+      RAFT_CUBLAS_TRY(cublastrsm(cublas_h,
+                                 CUBLAS_SIDE_LEFT,
+                                 uplo,
+                                 op,
+                                 CUBLAS_DIAG_NON_UNIT,
+                                 b,
+                                 kc,
+                                 &one,
+                                 L_11,
+                                 ld,
+                                 z.data(),
+                                 nb,
+                                 stream));
+
+      // C C^T = I + s Z Z^T (lower), R^T R = I + s Z^T Z (upper)
+      eye(c.data(), b, nb, stream);
+      RAFT_CUBLAS_TRY(cublassyrk(cublas_h,
+                                 CUBLAS_FILL_MODE_LOWER,
+                                 CUBLAS_OP_N,
+                                 b,
+                                 kc,
+                                 &sign,
+                                 z.data(),
+                                 nb,
+                                 &one,
+                                 c.data(),
+                                 nb,
+                                 stream));
+      RAFT_CUSOLVER_TRY(cusolverDnpotrf(cusolver_h,
+                                        CUBLAS_FILL_MODE_LOWER,
+                                        b,
+                                        c.data(),
+                                        nb,
+                                        work.data(),
+                                        lwork,
+                                        info_blk,
+                                        stream));
+      eye(r.data(), kc, kb, stream);
+      RAFT_CUBLAS_TRY(cublassyrk(cublas_h,
+                                 CUBLAS_FILL_MODE_UPPER,
+                                 CUBLAS_OP_T,
+                                 kc,
+                                 b,
+                                 &sign,
+                                 z.data(),
+                                 nb,
+                                 &one,
+                                 r.data(),
+                                 kb,
+                                 stream));
+      RAFT_CUSOLVER_TRY(cusolverDnpotrf(cusolver_h,
+                                        CUBLAS_FILL_MODE_UPPER,
+                                        kc,
+                                        r.data(),
+                                        kb,
+                                        work.data(),
+                                        lwork,
+                                        info_blk + 1,
+                                        stream));
+
+      if (rows > 0) {
+        math_t* V_2 = v + j0 + b;
+        math_t* W_2 = w + j0 + b;
+        // W_2 = V_2 - L_21 Z
+        RAFT_CUDA_TRY(cudaMemcpy2DAsync(W_2,
+                                        n * sizeof(math_t),
+                                        V_2,
+                                        n * sizeof(math_t),
+                                        rows * sizeof(math_t),
+                                        kc,
+                                        cudaMemcpyDeviceToDevice,
+                                        stream));
+        RAFT_CUBLAS_TRY(cublasgemm(cublas_h,
+                                   op,
+                                   CUBLAS_OP_N,
+                                   rows,
+                                   kc,
+                                   b,
+                                   &minus_one,
+                                   L_21,
+                                   ld,
+                                   z.data(),
+                                   nb,
+                                   &one,
+                                   W_2,
+                                   n,
+                                   stream));
+
+        // L_21' = (L_21 + s V_2 Z^T) C^-T, or its transpose C^-1 (L_21^T + s Z V_2^T)
+        if (upper) {
+          RAFT_CUBLAS_TRY(cublasgemm(cublas_h,
+                                     CUBLAS_OP_N,
+                                     CUBLAS_OP_T,
+                                     b,
+                                     rows,
+                                     kc,
+                                     &sign,
+                                     z.data(),
+                                     nb,
+                                     V_2,
+                                     n,
+                                     &one,
+                                     L_21,
+                                     ld,
+                                     stream));
+          RAFT_CUBLAS_TRY(cublastrsm(cublas_h,
+                                     CUBLAS_SIDE_LEFT,
+                                     CUBLAS_FILL_MODE_LOWER,
+                                     CUBLAS_OP_N,
+                                     CUBLAS_DIAG_NON_UNIT,
+                                     b,
+                                     rows,
+                                     &one,
+                                     c.data(),
+                                     nb,
+                                     L_21,
+                                     ld,
+                                     stream));
+        } else {
+          RAFT_CUBLAS_TRY(cublasgemm(cublas_h,
+                                     CUBLAS_OP_N,
+                                     CUBLAS_OP_T,
+                                     rows,
+                                     b,
+                                     kc,
+                                     &sign,
+                                     V_2,
+                                     n,
+                                     z.data(),
+                                     nb,
+                                     &one,
+                                     L_21,
+                                     ld,
+                                     stream));
+          RAFT_CUBLAS_TRY(cublastrsm(cublas_h,
+                                     CUBLAS_SIDE_RIGHT,
+                                     CUBLAS_FILL_MODE_LOWER,
+                                     CUBLAS_OP_T,
+                                     CUBLAS_DIAG_NON_UNIT,
+                                     rows,
+                                     b,
+                                     &one,
+                                     c.data(),
+                                     nb,
+                                     L_21,
+                                     ld,
+                                     stream));
+        }
+
+        // V_2' = W_2 R^-1 updates the trailing factor in the next blocks
+        RAFT_CUBLAS_TRY(cublastrsm(cublas_h,
+                                   CUBLAS_SIDE_RIGHT,
+                                   CUBLAS_FILL_MODE_UPPER,
+                                   CUBLAS_OP_N,
+                                   CUBLAS_DIAG_NON_UNIT,
+                                   rows,
+                                   kc,
+                                   &one,
+                                   r.data(),
+                                   kb,
+                                   W_2,
+                                   n,
+                                   stream));
+        std::swap(v, w);
+      }
+
+      // L_11' = L_11 C, computed out of place since the other triangle of L is not referenced
+      copy_triangle(L_11, ld, upper, t.data(), nb, false, b, true, stream);
+      RAFT_CUBLAS_TRY(cublasgemm(cublas_h,
+                                 CUBLAS_OP_N,
+                                 CUBLAS_OP_N,
+                                 b,
+                                 b,
+                                 b,
+                                 &one,
+                                 t.data(),
+                                 nb,
+                                 c.data(),
+                                 nb,
+                                 &zero,
+                                 l11.data(),
+                                 nb,
+                                 stream));
+      copy_triangle(l11.data(), nb, false, L_11, ld, upper, b, false, stream);
+    }
+  }
+
+  std::vector<int> info_h(info.size());
+  raft::update_host(info_h.data(), info.data(), info.size(), stream);
+  resource::sync_stream(handle, stream);
+  ASSERT(std::all_of(info_h.begin(), info_h.end(), [](int i) { return i == 0; }),
+         "Error during Cholesky rank k %s: the result is not positive definite",
+         downdate ? "downdate" : "update");
+}
+
+}  // namespace detail
+}  // namespace linalg
+}  // namespace raft
@@ -685,6 +685,54 @@ inline cublasStatus_t cublasgelsBatched(cublasHandle_t handle,  // NOLINT
 
 /** @} */
 
+/**
+ * @defgroup geqrfbatched cublas geqrfbatched calls
+ * @{
+ */
+
+template <typename T>
+inline cublasStatus_t cublasgeqrfBatched(cublasHandle_t handle,  // NOLINT
+                                         int m,
+                                         int n,
+                                         T* const Aarray[],    // NOLINT
+                                         int lda,
+                                         T* const TauArray[],  // NOLINT
+                                         int* info,
+                                         int batchSize,
+                                         cudaStream_t stream);
+
+template <>
+inline cublasStatus_t cublasgeqrfBatched(cublasHandle_t handle,  // NOLINT
+                                         int m,
+                                         int n,
+                                         float* const Aarray[],    // NOLINT
+                                         int lda,
+                                         float* const TauArray[],  // NOLINT
+                                         int* info,
+                                         int batchSize,
+                                         cudaStream_t stream)
+{
+  RAFT_CUBLAS_TRY(cublasSetStream(handle, stream));
+  return cublasSgeqrfBatched(handle, m, n, Aarray, lda, TauArray, info, batchSize);
+}
+
+template <>
+inline cublasStatus_t cublasgeqrfBatched(cublasHandle_t handle,  // NOLINT
+                                         int m,
+                                         int n,
+                                         double* const Aarray[],    // NOLINT
+                                         int lda,
+                                         double* const TauArray[],  // NOLINT
+                                         int* info,
+                                         int batchSize,
+                                         cudaStream_t stream)
+{
+  RAFT_CUBLAS_TRY(cublasSetStream(handle, stream));
+  return cublasDgeqrfBatched(handle, m, n, Aarray, lda, TauArray, info, batchSize);
+}
+
+/** @} */
+
 /**
  * @defgroup geam cublas geam calls
  * @{
@@ -21,10 +21,15 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/custom_resource.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/linalg/linalg_types.hpp>
 #include <raft/util/cache.hpp>
 #include <raft/util/cuda_data_type.hpp>
 
+#include <cuda_bf16.h>
 #include <cuda_fp16.hpp>
+#if CUDART_VERSION >= 11080
+#include <cuda_fp8.h>
+#endif
 
 #include <cublasLt.h>
 
@@ -53,6 +58,44 @@ inline auto get_matmul_type<float, half, half, float>() -> cublasComputeType_t
   return CUBLAS_COMPUTE_32F;
 }
 template <>
+inline auto get_matmul_type<float, nv_bfloat16, nv_bfloat16, float>() -> cublasComputeType_t
+{
+  return CUBLAS_COMPUTE_32F;
+}
+template <>
+inline auto get_matmul_type<float, nv_bfloat16, nv_bfloat16, nv_bfloat16>() -> cublasComputeType_t
+{
+  return CUBLAS_COMPUTE_32F;
+}
+#if CUDART_VERSION >= 11080
+template <>
+inline auto get_matmul_type<float, __nv_fp8_e4m3, __nv_fp8_e4m3, float>() -> cublasComputeType_t
+{
+  return CUBLAS_COMPUTE_32F;
+}
+template <>
+inline auto get_matmul_type<float, __nv_fp8_e4m3, __nv_fp8_e4m3, half>() -> cublasComputeType_t
+{
+  return CUBLAS_COMPUTE_32F;
+}
+template <>
+inline auto get_matmul_type<float, __nv_fp8_e4m3, __nv_fp8_e4m3, nv_bfloat16>()
+  -> cublasComputeType_t
+{
+  return CUBLAS_COMPUTE_32F;
+}
+template <>
+inline auto get_matmul_type<float, __nv_fp8_e4m3, __nv_fp8_e5m2, float>() -> cublasComputeType_t
+{
+  return CUBLAS_COMPUTE_32F;
+}
+template <>
+inline auto get_matmul_type<float, __nv_fp8_e5m2, __nv_fp8_e4m3, float>() -> cublasComputeType_t
+{
+  return CUBLAS_COMPUTE_32F;
+}
+#endif
+template <>
 inline auto get_matmul_type<float, int8_t, int8_t, float>() -> cublasComputeType_t
 {
   return CUBLAS_COMPUTE_32F;
@@ -83,6 +126,42 @@ inline auto get_matmul_type<double, double, double, double>() -> cublasComputeTy
   return CUBLAS_COMPUTE_64F;
 }
 
+/** Whether A is an 8-bit floating point type, for which cublasLt has specific requirements. */
+template <typename A>
+constexpr bool is_fp8_v =
+#if CUDART_VERSION >= 11080
+  std::is_same_v<A, __nv_fp8_e4m3> || std::is_same_v<A, __nv_fp8_e5m2>;
+#else
+  false;
+#endif
+
+/**
+ * The element type of the bias of the cublasLt epilogues: the type of C, except for the fp8 inputs
+ * with a float C, whose bias is bf16.
+ */
+template <typename A, typename C>
+using matmul_bias_t = std::conditional_t<is_fp8_v<A> && std::is_same_v<C, float>, nv_bfloat16, C>;
+
+/** The cublasLt epilogue of a raft::linalg::Epilogue. */
+inline auto get_cublaslt_epilogue(Epilogue epilogue) -> cublasLtEpilogue_t
+{
+  switch (epilogue) {
+    case Epilogue::RELU: return CUBLASLT_EPILOGUE_RELU;
+    case Epilogue::BIAS: return CUBLASLT_EPILOGUE_BIAS;
+    case Epilogue::RELU_BIAS: return CUBLASLT_EPILOGUE_RELU_BIAS;
+    case Epilogue::GELU: return CUBLASLT_EPILOGUE_GELU;
+    case Epilogue::GELU_BIAS: return CUBLASLT_EPILOGUE_GELU_BIAS;
+    default: return CUBLASLT_EPILOGUE_DEFAULT;
+  }
+}
+
+/** Whether the cublasLt epilogue reads a bias vector. */
+inline auto epilogue_has_bias(cublasLtEpilogue_t epilogue) -> bool
+{
+  return epilogue == CUBLASLT_EPILOGUE_BIAS || epilogue == CUBLASLT_EPILOGUE_RELU_BIAS ||
+         epilogue == CUBLASLT_EPILOGUE_GELU_BIAS;
+}
+
 /** Unique representation of a matrix multiplication (assuming fixed types). */
 struct matmul_key_t {
   uint64_t m;
@@ -93,18 +172,21 @@ struct matmul_key_t {
   uint64_t ldc;
   bool trans_a;
   bool trans_b;
+  cublasLtEpilogue_t epilogue{CUBLASLT_EPILOGUE_DEFAULT};
 };
 
 inline auto operator==(const matmul_key_t& a, const matmul_key_t& b) -> bool
 {
   return a.m == b.m && a.n == b.n && a.k == b.k && a.lda == b.lda && a.ldb == b.ldb &&
-         a.ldc == b.ldc && a.trans_a == b.trans_a && a.trans_b == b.trans_b;
+         a.ldc == b.ldc && a.trans_a == b.trans_a && a.trans_b == b.trans_b &&
+         a.epilogue == b.epilogue;
 }
 
 struct matmul_key_hash {
   inline auto operator()(const matmul_key_t& x) const noexcept -> std::size_t
   {
-    return x.m * x.n * x.k + x.lda * x.ldb * x.ldc + size_t{x.trans_a} + size_t{x.trans_b} * 2;
+    return x.m * x.n * x.k + x.lda * x.ldb * x.ldc + size_t{x.trans_a} + size_t{x.trans_b} * 2 +
+           size_t(x.epilogue) * 4;
   }
 };
 
@@ -158,7 +240,10 @@ struct cublastlt_matmul_desc {
   inline operator cublasLtMatmulDesc_t() const noexcept { return res; }
 
   template <typename S, typename A, typename B, typename C, bool DevicePointerMode = false>
-  static inline auto for_matmul(bool transpose_a, bool transpose_b) -> cublastlt_matmul_desc
+  static inline auto for_matmul(bool transpose_a,
+                                bool transpose_b,
+                                cublasLtEpilogue_t epilogue = CUBLASLT_EPILOGUE_DEFAULT)
+    -> cublastlt_matmul_desc
   {
     auto desc = cublastlt_matmul_desc{get_matmul_type<S, A, B, C>(), get_cuda_data_type<S>()};
     if constexpr (DevicePointerMode) {
@@ -175,6 +260,10 @@ struct cublastlt_matmul_desc {
       RAFT_CUBLAS_TRY(cublasLtMatmulDescSetAttribute(
         desc, CUBLASLT_MATMUL_DESC_TRANSB, &trans_op, sizeof(trans_op)));
     }
+    if (epilogue != CUBLASLT_EPILOGUE_DEFAULT) {
+      RAFT_CUBLAS_TRY(cublasLtMatmulDescSetAttribute(
+        desc, CUBLASLT_MATMUL_DESC_EPILOGUE, &epilogue, sizeof(epilogue)));
+    }
     return desc;
   }
 };
@@ -191,7 +280,8 @@ struct matmul_desc {
   static inline auto create(raft::resources const& res, const matmul_key_t& args) -> matmul_desc
   {
     matmul_desc r{
-      cublastlt_matmul_desc::for_matmul<S, A, B, C, DevicePointerMode>(args.trans_a, args.trans_b),
+      cublastlt_matmul_desc::for_matmul<S, A, B, C, DevicePointerMode>(
+        args.trans_a, args.trans_b, args.epilogue),
       cublastlt_matrix_layout::for_matmul<A>(!(args.trans_a), args.m, args.k, args.lda),
       cublastlt_matrix_layout::for_matmul<B>(!(args.trans_b), args.k, args.n, args.ldb),
       cublastlt_matrix_layout::for_matmul<C>(true, args.m, args.n, args.ldc)};
@@ -222,6 +312,62 @@ struct matmul_cache {
     kDefaultSize};
 };
 
+/**
+ * The cublasLt matmul with an optional epilogue, on an explicit stream. The descriptors and the
+ * heuristics of every shape and epilogue are created once and cached in the resources.
+ */
+template <bool DevicePointerMode = false, typename S, typename A, typename B, typename C>
+void matmul_impl(raft::resources const& res,
+                 bool trans_a,
+                 bool trans_b,
+                 uint64_t m,
+                 uint64_t n,
+                 uint64_t k,
+                 const S* alpha,
+                 const A* a_ptr,
+                 uint64_t lda,
+                 const B* b_ptr,
+                 uint64_t ldb,
+                 const S* beta,
+                 C* c_ptr,
+                 uint64_t ldc,
+                 cublasLtEpilogue_t epilogue,
+                 const matmul_bias_t<A, C>* bias,
+                 cudaStream_t stream)
+{
+  common::nvtx::range<common::nvtx::domain::raft> batch_scope(
+    "linalg::matmul(m = %d, n = %d, k = %d)", m, n, k);
+  std::shared_ptr<matmul_desc> mm_desc{nullptr};
+  matmul_key_t mm_key{m, n, k, lda, ldb, ldc, trans_a, trans_b, epilogue};
+  auto& cache =
+    resource::get_custom_resource<matmul_cache<S, A, B, C, DevicePointerMode>>(res)->value;
+  if (!cache.get(mm_key, &mm_desc)) {
+    mm_desc.reset(new matmul_desc{matmul_desc::create<S, A, B, C, DevicePointerMode>(res, mm_key)});
+    cache.set(mm_key, mm_desc);
+  }
+  if (epilogue_has_bias(epilogue)) {
+    // The bias is not part of the cached plan, only its pointer changes between the calls
+    RAFT_CUBLAS_TRY(cublasLtMatmulDescSetAttribute(
+      mm_desc->desc, CUBLASLT_MATMUL_DESC_BIAS_POINTER, &bias, sizeof(bias)));
+  }
+  RAFT_CUBLAS_TRY(cublasLtMatmul(resource::get_cublaslt_handle(res),
+                                 mm_desc->desc,
+                                 alpha,
+                                 a_ptr,
+                                 mm_desc->a,
+                                 b_ptr,
+                                 mm_desc->b,
+                                 beta,
+                                 c_ptr,
+                                 mm_desc->c,
+                                 c_ptr,
+                                 mm_desc->c,
+                                 &(mm_desc->heuristics.algo),
+                                 nullptr,
+                                 0,
+                                 stream));
+}
+
 /**
  * Compatibility version of the cublasLt matmul wrapper: It takes the cudaStream_t argument
  * explicitly rather than through the raft::resources. This function is used by other legacy
@@ -248,32 +394,23 @@ template <bool DevicePointerMode = false, typename S, typename A, typename B, ty
                                   uint64_t ldc,
                                   cudaStream_t stream)
 {
-  common::nvtx::range<common::nvtx::domain::raft> batch_scope(
-    "linalg::matmul(m = %d, n = %d, k = %d)", m, n, k);
-  std::shared_ptr<matmul_desc> mm_desc{nullptr};
-  matmul_key_t mm_key{m, n, k, lda, ldb, ldc, trans_a, trans_b};
-  auto& cache =
-    resource::get_custom_resource<matmul_cache<S, A, B, C, DevicePointerMode>>(res)->value;
-  if (!cache.get(mm_key, &mm_desc)) {
-    mm_desc.reset(new matmul_desc{matmul_desc::create<S, A, B, C, DevicePointerMode>(res, mm_key)});
-    cache.set(mm_key, mm_desc);
-  }
-  RAFT_CUBLAS_TRY(cublasLtMatmul(resource::get_cublaslt_handle(res),
-                                 mm_desc->desc,
+  matmul_impl<DevicePointerMode>(res,
+                                 trans_a,
+                                 trans_b,
+                                 m,
+                                 n,
+                                 k,
                                  alpha,
                                  a_ptr,
-                                 mm_desc->a,
+                                 lda,
                                  b_ptr,
-                                 mm_desc->b,
+                                 ldb,
                                  beta,
                                  c_ptr,
-                                 mm_desc->c,
-                                 c_ptr,
-                                 mm_desc->c,
-                                 &(mm_desc->heuristics.algo),
+                                 ldc,
+                                 CUBLASLT_EPILOGUE_DEFAULT,
                                  nullptr,
-                                 0,
-                                 stream));
+                                 stream);
 }
 
 /**
@@ -334,4 +471,50 @@ void matmul(raft::resources const& res,
                        resource::get_cuda_stream(res));
 }
 
+/**
+ * @brief the wrapper of cublasLt matmul function with an epilogue
+ *  It computes the following equation: C = epilogue(alpha .* opA(A) * opB(B) + beta .* C)
+ *
+ * See the overload without the epilogue for the other parameters.
+ *
+ * @param [in] epilogue the cublasLt epilogue, applied before the store of C
+ * @param [in] bias the bias vector of m elements for the epilogues with a bias, nullptr otherwise
+ */
+template <bool DevicePointerMode = false, typename S, typename A, typename B, typename C>
+void matmul(raft::resources const& res,
+            bool trans_a,
+            bool trans_b,
+            uint64_t m,
+            uint64_t n,
+            uint64_t k,
+            const S* alpha,
+            const A* a_ptr,
+            uint64_t lda,
+            const B* b_ptr,
+            uint64_t ldb,
+            const S* beta,
+            C* c_ptr,
+            uint64_t ldc,
+            cublasLtEpilogue_t epilogue,
+            const matmul_bias_t<A, C>* bias)
+{
+  matmul_impl<DevicePointerMode>(res,
+                                 trans_a,
+                                 trans_b,
+                                 m,
+                                 n,
+                                 k,
+                                 alpha,
+                                 a_ptr,
+                                 lda,
+                                 b_ptr,
+                                 ldb,
+                                 beta,
+                                 c_ptr,
+                                 ldc,
+                                 epilogue,
+                                 bias,
+                                 resource::get_cuda_stream(res));
+}
+
 }  // namespace raft::linalg::detail
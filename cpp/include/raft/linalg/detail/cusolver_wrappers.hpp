@@ -301,6 +301,115 @@ inline cusolverStatus_t cusolverDnsyevj_bufferSize(  // NOLINT
 }
 /** @} */
 
+/**
+ * @defgroup syevjBatched cusolver syevjBatched operations
+ * @{
+ */
+template <typename T>
+cusolverStatus_t cusolverDnsyevjBatched(cusolverDnHandle_t handle,  // NOLINT
+                                        cusolverEigMode_t jobz,
+                                        cublasFillMode_t uplo,
+                                        int n,
+                                        T* A,
+                                        int lda,
+                                        T* W,
+                                        T* work,
+                                        int lwork,
+                                        int* info,
+                                        syevjInfo_t params,
+                                        int batchSize,
+                                        cudaStream_t stream);
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  float* A,
+  int lda,
+  float* W,
+  float* work,
+  int lwork,
+  int* info,
+  syevjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnSsyevjBatched(
+    handle, jobz, uplo, n, A, lda, W, work, lwork, info, params, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  double* A,
+  int lda,
+  double* W,
+  double* work,
+  int lwork,
+  int* info,
+  syevjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnDsyevjBatched(
+    handle, jobz, uplo, n, A, lda, W, work, lwork, info, params, batchSize);
+}
+
+template <typename T>
+cusolverStatus_t cusolverDnsyevjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  const T* A,
+  int lda,
+  const T* W,
+  int* lwork,
+  syevjInfo_t params,
+  int batchSize);
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  const float* A,
+  int lda,
+  const float* W,
+  int* lwork,
+  syevjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnSsyevjBatched_bufferSize(
+    handle, jobz, uplo, n, A, lda, W, lwork, params, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  const double* A,
+  int lda,
+  const double* W,
+  int* lwork,
+  syevjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnDsyevjBatched_bufferSize(
+    handle, jobz, uplo, n, A, lda, W, lwork, params, batchSize);
+}
+/** @} */
+
 /**
  * @defgroup syevd cusolver syevd operations
  * @{
@@ -696,6 +805,351 @@ inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdj(  // NOLINT
     handle, jobz, econ, m, n, A, lda, S, U, ldu, V, ldv, work, lwork, info, params);
 }
 
+template <typename T>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  const T* A,
+  int lda,
+  const T* S,
+  const T* U,
+  int ldu,
+  const T* V,
+  int ldv,
+  int* lwork,
+  gesvdjInfo_t params,
+  int batchSize);
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  const float* A,
+  int lda,
+  const float* S,
+  const float* U,
+  int ldu,
+  const float* V,
+  int ldv,
+  int* lwork,
+  gesvdjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnSgesvdjBatched_bufferSize(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, lwork, params, batchSize);
+}
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  const double* A,
+  int lda,
+  const double* S,
+  const double* U,
+  int ldu,
+  const double* V,
+  int ldv,
+  int* lwork,
+  gesvdjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnDgesvdjBatched_bufferSize(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, lwork, params, batchSize);
+}
+template <typename T>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  T* A,
+  int lda,
+  T* S,
+  T* U,
+  int ldu,
+  T* V,
+  int ldv,
+  T* work,
+  int lwork,
+  int* info,
+  gesvdjInfo_t params,
+  int batchSize,
+  cudaStream_t stream);
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  float* A,
+  int lda,
+  float* S,
+  float* U,
+  int ldu,
+  float* V,
+  int ldv,
+  float* work,
+  int lwork,
+  int* info,
+  gesvdjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnSgesvdjBatched(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, work, lwork, info, params, batchSize);
+}
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  double* A,
+  int lda,
+  double* S,
+  double* U,
+  int ldu,
+  double* V,
+  int ldv,
+  double* work,
+  int lwork,
+  int* info,
+  gesvdjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnDgesvdjBatched(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, work, lwork, info, params, batchSize);
+}
+
+template <typename T>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdaStridedBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int rank,
+  int m,
+  int n,
+  const T* A,
+  int lda,
+  long long int strideA,
+  const T* S,
+  long long int strideS,
+  const T* U,
+  int ldu,
+  long long int strideU,
+  const T* V,
+  int ldv,
+  long long int strideV,
+  int* lwork,
+  int batchSize);
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdaStridedBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int rank,
+  int m,
+  int n,
+  const float* A,
+  int lda,
+  long long int strideA,
+  const float* S,
+  long long int strideS,
+  const float* U,
+  int ldu,
+  long long int strideU,
+  const float* V,
+  int ldv,
+  long long int strideV,
+  int* lwork,
+  int batchSize)
+{
+  return cusolverDnSgesvdaStridedBatched_bufferSize(handle,
+                                                    jobz,
+                                                    rank,
+                                                    m,
+                                                    n,
+                                                    A,
+                                                    lda,
+                                                    strideA,
+                                                    S,
+                                                    strideS,
+                                                    U,
+                                                    ldu,
+                                                    strideU,
+                                                    V,
+                                                    ldv,
+                                                    strideV,
+                                                    lwork,
+                                                    batchSize);
+}
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdaStridedBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int rank,
+  int m,
+  int n,
+  const double* A,
+  int lda,
+  long long int strideA,
+  const double* S,
+  long long int strideS,
+  const double* U,
+  int ldu,
+  long long int strideU,
+  const double* V,
+  int ldv,
+  long long int strideV,
+  int* lwork,
+  int batchSize)
+{
+  return cusolverDnDgesvdaStridedBatched_bufferSize(handle,
+                                                    jobz,
+                                                    rank,
+                                                    m,
+                                                    n,
+                                                    A,
+                                                    lda,
+                                                    strideA,
+                                                    S,
+                                                    strideS,
+                                                    U,
+                                                    ldu,
+                                                    strideU,
+                                                    V,
+                                                    ldv,
+                                                    strideV,
+                                                    lwork,
+                                                    batchSize);
+}
+template <typename T>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdaStridedBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int rank,
+  int m,
+  int n,
+  const T* A,
+  int lda,
+  long long int strideA,
+  T* S,
+  long long int strideS,
+  T* U,
+  int ldu,
+  long long int strideU,
+  T* V,
+  int ldv,
+  long long int strideV,
+  T* work,
+  int lwork,
+  int* info,
+  double* h_R_nrmF,
+  int batchSize,
+  cudaStream_t stream);
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdaStridedBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int rank,
+  int m,
+  int n,
+  const float* A,
+  int lda,
+  long long int strideA,
+  float* S,
+  long long int strideS,
+  float* U,
+  int ldu,
+  long long int strideU,
+  float* V,
+  int ldv,
+  long long int strideV,
+  float* work,
+  int lwork,
+  int* info,
+  double* h_R_nrmF,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnSgesvdaStridedBatched(handle,
+                                         jobz,
+                                         rank,
+                                         m,
+                                         n,
+                                         A,
+                                         lda,
+                                         strideA,
+                                         S,
+                                         strideS,
+                                         U,
+                                         ldu,
+                                         strideU,
+                                         V,
+                                         ldv,
+                                         strideV,
+                                         work,
+                                         lwork,
+                                         info,
+                                         h_R_nrmF,
+                                         batchSize);
+}
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdaStridedBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int rank,
+  int m,
+  int n,
+  const double* A,
+  int lda,
+  long long int strideA,
+  double* S,
+  long long int strideS,
+  double* U,
+  int ldu,
+  long long int strideU,
+  double* V,
+  int ldv,
+  long long int strideV,
+  double* work,
+  int lwork,
+  int* info,
+  double* h_R_nrmF,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnDgesvdaStridedBatched(handle,
+                                         jobz,
+                                         rank,
+                                         m,
+                                         n,
+                                         A,
+                                         lda,
+                                         strideA,
+                                         S,
+                                         strideS,
+                                         U,
+                                         ldu,
+                                         strideU,
+                                         V,
+                                         ldv,
+                                         strideV,
+                                         work,
+                                         lwork,
+                                         info,
+                                         h_R_nrmF,
+                                         batchSize);
+}
+
 #if CUDART_VERSION >= 11010
 template <typename T>
 cusolverStatus_t cusolverDnxgesvdr_bufferSize(  // NOLINT
@@ -18,6 +18,7 @@
 
 #include "cusolver_wrappers.hpp"
 
+#include <raft/core/nvtx.hpp>
 #include <raft/core/resource/cusolver_dn_handle.hpp>
 #include <raft/core/resource/detail/stream_sync_event.hpp>
 #include <raft/core/resources.hpp>
@@ -218,17 +219,18 @@ void eigSelDC(raft::resources const& handle,
                                        d_dev_info.data(),
                                        stream));
   } else if (memUsage == COPY_INPUT) {
+    // eig_vectors only holds n_eig_vals columns, syevdx works on a full copy of the input
     d_eig_vectors.resize(n_rows * n_cols, stream);
     raft::matrix::copy(handle,
                        make_device_matrix_view<const math_t>(in, n_rows, n_cols),
-                       make_device_matrix_view(eig_vectors, n_rows, n_cols));
+                       make_device_matrix_view(d_eig_vectors.data(), n_rows, n_cols));
 
     RAFT_CUSOLVER_TRY(cusolverDnsyevdx(cusolverH,
                                        CUSOLVER_EIG_MODE_VECTOR,
                                        CUSOLVER_EIG_RANGE_I,
                                        CUBLAS_FILL_MODE_UPPER,
                                        static_cast<int64_t>(n_rows),
-                                       eig_vectors,
+                                       d_eig_vectors.data(),
                                        static_cast<int64_t>(n_cols),
                                        math_t(0.0),
                                        math_t(0.0),
@@ -319,6 +321,95 @@ void eigJacobi(raft::resources const& handle,
   RAFT_CUSOLVER_TRY(cusolverDnDestroySyevjInfo(syevj_params));
 }
 
+/**
+ * Eigen decompositions of a batch of column major symmetric (n, n) matrices stored one after the
+ * other. The matrices with up to 32 rows are decomposed together with syevjBatched (limited to
+ * 32 x 32 matrices), the larger ones one after the other with syevj, reusing the workspace.
+ */
+template <typename math_t>
+void eigJacobi_batched(raft::resources const& handle,
+                       const math_t* in,
+                       int n,
+                       int batch_size,
+                       math_t* eig_vectors,
+                       math_t* eig_vals,
+                       cudaStream_t stream,
+                       math_t tol = 1.e-7,
+                       int sweeps = 15)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "raft::linalg::eigJacobi_batched(%d, %d)", n, batch_size);
+  if (batch_size == 0 || n == 0) { return; }
+  cusolverDnHandle_t cusolverH = resource::get_cusolver_dn_handle(handle);
+
+  syevjInfo_t syevj_params = nullptr;
+  RAFT_CUSOLVER_TRY(cusolverDnCreateSyevjInfo(&syevj_params));
+  RAFT_CUSOLVER_TRY(cusolverDnXsyevjSetTolerance(syevj_params, tol));
+  RAFT_CUSOLVER_TRY(cusolverDnXsyevjSetMaxSweeps(syevj_params, sweeps));
+
+  // the solvers overwrite the input matrices with the eigenvectors
+  const size_t matrix_size = size_t(n) * n;
+  raft::copy(eig_vectors, in, matrix_size * batch_size, stream);
+
+  int lwork = 0;
+  if (n <= 32) {
+    RAFT_CUSOLVER_TRY(cusolverDnsyevjBatched_bufferSize(cusolverH,
+                                                        CUSOLVER_EIG_MODE_VECTOR,
+                                                        CUBLAS_FILL_MODE_UPPER,
+                                                        n,
+                                                        eig_vectors,
+                                                        n,
+                                                        eig_vals,
+                                                        &lwork,
+                                                        syevj_params,
+                                                        batch_size));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    rmm::device_uvector<int> dev_info(batch_size, stream);
+    RAFT_CUSOLVER_TRY(cusolverDnsyevjBatched(cusolverH,
+                                             CUSOLVER_EIG_MODE_VECTOR,
+                                             CUBLAS_FILL_MODE_UPPER,
+                                             n,
+                                             eig_vectors,
+                                             n,
+                                             eig_vals,
+                                             d_work.data(),
+                                             lwork,
+                                             dev_info.data(),
+                                             syevj_params,
+                                             batch_size,
+                                             stream));
+  } else {
+    RAFT_CUSOLVER_TRY(cusolverDnsyevj_bufferSize(cusolverH,
+                                                 CUSOLVER_EIG_MODE_VECTOR,
+                                                 CUBLAS_FILL_MODE_UPPER,
+                                                 n,
+                                                 eig_vectors,
+                                                 n,
+                                                 eig_vals,
+                                                 &lwork,
+                                                 syevj_params));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    rmm::device_uvector<int> dev_info(batch_size, stream);
+    for (int i = 0; i < batch_size; i++) {
+      RAFT_CUSOLVER_TRY(cusolverDnsyevj(cusolverH,
+                                        CUSOLVER_EIG_MODE_VECTOR,
+                                        CUBLAS_FILL_MODE_UPPER,
+                                        n,
+                                        eig_vectors + matrix_size * i,
+                                        n,
+                                        eig_vals + size_t(n) * i,
+                                        d_work.data(),
+                                        lwork,
+                                        dev_info.data() + i,
+                                        syevj_params,
+                                        stream));
+    }
+  }
+
+  RAFT_CUDA_TRY(cudaGetLastError());
+  RAFT_CUSOLVER_TRY(cusolverDnDestroySyevjInfo(syevj_params));
+}
+
 }  // namespace detail
 }  // namespace linalg
 }  // namespace raft
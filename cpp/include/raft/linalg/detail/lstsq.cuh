@@ -22,6 +22,7 @@
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/cusolver_dn_handle.hpp>
+#include <raft/linalg/detail/cholesky_rk_update.cuh>
 #include <raft/linalg/detail/cublas_wrappers.hpp>
 #include <raft/linalg/detail/cusolver_wrappers.hpp>
 #include <raft/linalg/eig.cuh>
@@ -454,6 +455,54 @@ void lstsqQR(raft::resources const& handle,
 
   RAFT_CUDA_TRY(cudaMemcpyAsync(w, b, sizeof(math_t) * n, cudaMemcpyDeviceToDevice, stream));
 }
+
+/** Updates the ordinary least squares solution `w = (A^T A)^-1 A^T b` after adding (or removing)
+ *  the rows `A_new` of `A` and `b_new` of `b`.
+ *  `L` is the lower Cholesky factor of `A^T A`, updated with a rank-k update. `Ab` is `A^T b`.
+ */
+template <typename math_t>
+void lstsqCholeskyUpdate(raft::resources const& handle,
+                         const math_t* A_new,
+                         const int n_rows,
+                         const int n_cols,
+                         const math_t* b_new,
+                         math_t* L,
+                         math_t* Ab,
+                         math_t* w,
+                         bool downdate,
+                         cudaStream_t stream)
+{
+  cusolverDnHandle_t cusolverH = resource::get_cusolver_dn_handle(handle);
+  const math_t sign            = downdate ? -1 : 1;
+
+  // L L^T <- L L^T +/- A_new^T A_new
+  choleskyRankKUpdate(handle,
+                      L,
+                      n_cols,
+                      n_cols,
+                      A_new,
+                      n_rows,
+                      n_rows,
+                      true,
+                      downdate,
+                      CUBLAS_FILL_MODE_LOWER,
+                      stream);
+
+  // Ab <- Ab +/- A_new^T b_new
+  if (n_rows > 0) {
+    raft::linalg::gemv(handle, A_new, n_rows, n_cols, b_new, Ab, true, sign, math_t(1), stream);
+  }
+
+  // w <- (L L^T)^-1 Ab
+  int info = 0;
+  rmm::device_scalar<int> d_info(stream);
+  raft::copy(w, Ab, n_cols, stream);
+  RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnpotrs(
+    cusolverH, CUBLAS_FILL_MODE_LOWER, n_cols, 1, L, n_cols, w, n_cols, d_info.data(), stream));
+  RAFT_CUDA_TRY(cudaMemcpyAsync(&info, d_info.data(), sizeof(int), cudaMemcpyDeviceToHost, stream));
+  RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  ASSERT(0 == info, "lstsq.h: Cholesky solve wasn't successful");
+}
 };  // namespace detail
 };  // namespace linalg
 };  // namespace raft
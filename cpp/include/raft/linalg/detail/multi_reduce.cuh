@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/reduction.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/tuple.h>
+
+#include <utility>
+
+namespace raft {
+namespace linalg {
+namespace detail {
+
+/**
+ * The reductions of a multi_reduce call as a single reduction over a tuple of accumulators, so
+ * that the kernels only see one accumulator type and one binary operation.
+ */
+template <typename IdxType, typename... Ops>
+struct fused_reduction_op {
+  using acc_t = thrust::tuple<typename Ops::out_type...>;
+  using index = std::index_sequence_for<Ops...>;
+
+  thrust::tuple<Ops...> ops;
+  thrust::tuple<typename Ops::out_type*...> outs;
+
+  HDI auto init() const -> acc_t { return init_impl(index{}); }
+
+  template <typename InType>
+  HDI auto lift(const InType& x, IdxType j) const -> acc_t
+  {
+    return lift_impl(x, j, index{});
+  }
+
+  HDI auto operator()(const acc_t& a, const acc_t& b) const -> acc_t
+  {
+    return reduce_impl(a, b, index{});
+  }
+
+  /** Apply the final ops and write the results of the reduction i */
+  HDI void store(IdxType i, const acc_t& acc) const { store_impl(i, acc, index{}); }
+
+ private:
+  template <size_t... I>
+  HDI auto init_impl(std::index_sequence<I...>) const -> acc_t
+  {
+    return acc_t(thrust::get<I>(ops).init...);
+  }
+
+  template <typename InType, size_t... I>
+  HDI auto lift_impl(const InType& x, IdxType j, std::index_sequence<I...>) const -> acc_t
+  {
+    return acc_t(thrust::get<I>(ops).main_op(x, j)...);
+  }
+
+  template <size_t... I>
+  HDI auto reduce_impl(const acc_t& a, const acc_t& b, std::index_sequence<I...>) const -> acc_t
+  {
+    return acc_t(thrust::get<I>(ops).reduce_op(thrust::get<I>(a), thrust::get<I>(b))...);
+  }
+
+  template <size_t... I>
+  HDI void store_impl(IdxType i, const acc_t& acc, std::index_sequence<I...>) const
+  {
+    ((thrust::get<I>(outs)[i] = thrust::get<I>(ops).final_op(thrust::get<I>(acc))), ...);
+  }
+};
+
+/** Reduce every contiguous row of length D with a warp, for the short rows */
+template <int TPB, typename InType, typename IdxType, typename FusedOp>
+RAFT_KERNEL __launch_bounds__(TPB)
+  multi_coalesced_thin_kernel(const InType* data, IdxType D, IdxType N, FusedOp fused_op)
+{
+  constexpr int kRowsPerBlock = TPB / WarpSize;
+  const IdxType i = threadIdx.x / WarpSize + kRowsPerBlock * static_cast<IdxType>(blockIdx.x);
+  if (i >= N) { return; }
+  const int lane = threadIdx.x % WarpSize;
+
+  auto acc        = fused_op.init();
+  const auto* row = data + i * D;
+  for (IdxType j = lane; j < D; j += WarpSize) {
+    acc = fused_op(acc, fused_op.lift(row[j], j));
+  }
+  acc = raft::logicalWarpReduce<WarpSize>(acc, fused_op);
+  if (lane == 0) { fused_op.store(i, acc); }
+}
+
+/** Reduce every contiguous row of length D with a thread block, for the long rows */
+template <int TPB, typename InType, typename IdxType, typename FusedOp>
+RAFT_KERNEL __launch_bounds__(TPB)
+  multi_coalesced_medium_kernel(const InType* data, IdxType D, FusedOp fused_op)
+{
+  using acc_t           = typename FusedOp::acc_t;
+  constexpr int kNWarps = TPB / WarpSize;
+  __shared__ alignas(acc_t) char smem[sizeof(acc_t) * kNWarps];
+  auto* warp_acc = reinterpret_cast<acc_t*>(smem);
+
+  const IdxType i = blockIdx.x;
+  auto acc        = fused_op.init();
+  const auto* row = data + i * D;
+  for (IdxType j = threadIdx.x; j < D; j += TPB) {
+    acc = fused_op(acc, fused_op.lift(row[j], j));
+  }
+  acc = raft::logicalWarpReduce<WarpSize>(acc, fused_op);
+  if (threadIdx.x % WarpSize == 0) { warp_acc[threadIdx.x / WarpSize] = acc; }
+  __syncthreads();
+  if (threadIdx.x == 0) {
+#pragma unroll
+    for (int w = 1; w < kNWarps; w++) {
+      acc = fused_op(acc, warp_acc[w]);
+    }
+    fused_op.store(i, acc);
+  }
+}
+
+/**
+ * Reduce the D columns of a row major (N, D) matrix, every block reducing 32 columns of a chunk of
+ * rows. With more than one chunk, the partial results go to `partials` (n_chunks, D) and are
+ * combined by multi_strided_final_kernel.
+ */
+template <int TPB_X, int TPB_Y, typename InType, typename IdxType, typename FusedOp>
+RAFT_KERNEL __launch_bounds__(TPB_X * TPB_Y)
+  multi_strided_kernel(const InType* data,
+                       IdxType D,
+                       IdxType N,
+                       IdxType rows_per_chunk,
+                       FusedOp fused_op,
+                       typename FusedOp::acc_t* partials)
+{
+  using acc_t = typename FusedOp::acc_t;
+  __shared__ alignas(acc_t) char smem[sizeof(acc_t) * TPB_X * TPB_Y];
+  auto* tile = reinterpret_cast<acc_t*>(smem);
+
+  const IdxType col     = threadIdx.x + TPB_X * static_cast<IdxType>(blockIdx.x);
+  const IdxType row_beg = rows_per_chunk * static_cast<IdxType>(blockIdx.y);
+  const IdxType row_end = raft::min(row_beg + rows_per_chunk, N);
+  auto acc              = fused_op.init();
+  if (col < D) {
+    for (IdxType r = row_beg + threadIdx.y; r < row_end; r += TPB_Y) {
+      acc = fused_op(acc, fused_op.lift(data[col + r * D], r));
+    }
+  }
+  tile[threadIdx.x + TPB_X * threadIdx.y] = acc;
+  __syncthreads();
+  if (threadIdx.y == 0 && col < D) {
+#pragma unroll
+    for (int y = 1; y < TPB_Y; y++) {
+      acc = fused_op(acc, tile[threadIdx.x + TPB_X * y]);
+    }
+    if (gridDim.y == 1) {
+      fused_op.store(col, acc);
+    } else {
+      partials[col + D * static_cast<IdxType>(blockIdx.y)] = acc;
+    }
+  }
+}
+
+template <typename IdxType, typename FusedOp>
+RAFT_KERNEL multi_strided_final_kernel(const typename FusedOp::acc_t* partials,
+                                       IdxType D,
+                                       IdxType n_chunks,
+                                       FusedOp fused_op)
+{
+  const IdxType col = threadIdx.x + blockDim.x * static_cast<IdxType>(blockIdx.x);
+  if (col >= D) { return; }
+  auto acc = partials[col];
+  for (IdxType c = 1; c < n_chunks; c++) {
+    acc = fused_op(acc, partials[col + D * c]);
+  }
+  fused_op.store(col, acc);
+}
+
+/**
+ * Apply all the reductions in a single pass over a row major (N, D) matrix, reducing either every
+ * row (coalesced) or every column (strided). The outputs have N or D elements respectively.
+ */
+template <typename InType, typename IdxType, typename... Ops>
+void multi_reduce(raft::resources const& handle,
+                  const InType* data,
+                  IdxType D,
+                  IdxType N,
+                  bool coalesced,
+                  thrust::tuple<typename Ops::out_type*...> outs,
+                  Ops... ops)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "raft::linalg::multi_reduce(%zu, %zu, %zu ops)", size_t(N), size_t(D), sizeof...(Ops));
+  using fused_t = fused_reduction_op<IdxType, Ops...>;
+  using acc_t   = typename fused_t::acc_t;
+  auto stream   = resource::get_cuda_stream(handle);
+  fused_t fused_op{thrust::make_tuple(ops...), outs};
+  if ((coalesced ? N : D) == 0) { return; }
+
+  if (coalesced) {
+    constexpr int TPB = 256;
+    if (D < 512) {
+      const IdxType n_blocks = raft::ceildiv<IdxType>(N, TPB / WarpSize);
+      multi_coalesced_thin_kernel<TPB><<<n_blocks, TPB, 0, stream>>>(data, D, N, fused_op);
+    } else {
+      multi_coalesced_medium_kernel<TPB><<<N, TPB, 0, stream>>>(data, D, fused_op);
+    }
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    return;
+  }
+
+  // Split the rows so that the skinny matrices still fill the device, every thread reducing at
+  // least kMinRowsPerThread rows of its column
+  constexpr int TPB_X                = WarpSize;
+  constexpr int TPB_Y                = 8;
+  constexpr IdxType kMinRowsPerThread = 16;
+  constexpr IdxType kTargetBlocks     = 2048;
+
+  const IdxType n_blocks_x     = raft::ceildiv<IdxType>(D, TPB_X);
+  const IdxType max_chunks     = raft::max<IdxType>(1, kTargetBlocks / n_blocks_x);
+  const IdxType min_rows       = TPB_Y * kMinRowsPerThread;
+  const IdxType rows_per_chunk = raft::max(min_rows, raft::ceildiv<IdxType>(N, max_chunks));
+  const IdxType n_chunks       = raft::max<IdxType>(1, raft::ceildiv<IdxType>(N, rows_per_chunk));
+
+  rmm::device_uvector<acc_t> partials(n_chunks > 1 ? n_chunks * D : 0, stream);
+  const dim3 grid(n_blocks_x, n_chunks);
+  const dim3 block(TPB_X, TPB_Y);
+  multi_strided_kernel<TPB_X, TPB_Y>
+    <<<grid, block, 0, stream>>>(data, D, N, rows_per_chunk, fused_op, partials.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  if (n_chunks > 1) {
+    constexpr int TPB = 256;
+    multi_strided_final_kernel<<<raft::ceildiv<IdxType>(D, TPB), TPB, 0, stream>>>(
+      partials.data(), D, n_chunks, fused_op);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+};  // end namespace detail
+};  // end namespace linalg
+};  // end namespace raft
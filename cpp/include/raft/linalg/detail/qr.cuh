@@ -19,13 +19,18 @@
 #include "cublas_wrappers.hpp"
 #include "cusolver_wrappers.hpp"
 
+#include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cusolver_dn_handle.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/matrix/triangular.cuh>
 
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/transform.h>
+
 #include <algorithm>
 
 namespace raft {
@@ -159,6 +164,116 @@ void qrGetQR(raft::resources const& handle,
                                     stream));
 }
 
+/**
+ * @brief Expand the Householder QR factorizations of a batch, one block per matrix: R is the upper
+ * triangle of the factorization, and the column c of Q is H_0 ... H_c e_c, since the reflectors
+ * H_j = I - tau_j v_j v_j^T with j > c leave e_c unchanged.
+ */
+template <typename math_t>
+RAFT_KERNEL qr_batched_expand_kernel(
+  const math_t* QR, const math_t* tau, math_t* Q, math_t* R, int n_rows, int n_cols)
+{
+  const size_t batch = blockIdx.x;
+  QR += batch * n_rows * n_cols;
+  tau += batch * n_cols;
+  Q += batch * n_rows * n_cols;
+  R += batch * n_cols * n_cols;
+
+  for (int idx = threadIdx.x; idx < n_cols * n_cols; idx += blockDim.x) {
+    int i  = idx % n_cols;
+    int j  = idx / n_cols;
+    R[idx] = i <= j ? QR[i + j * n_rows] : math_t(0);
+  }
+  for (int c = threadIdx.x; c < n_cols; c += blockDim.x) {
+    math_t* q = Q + size_t(c) * n_rows;
+    for (int i = 0; i < n_rows; i++) {
+      q[i] = i == c ? math_t(1) : math_t(0);
+    }
+    for (int j = c; j >= 0; j--) {
+      // v_j is 1 at row j, and the sub-diagonal part of the column j of the factorization below
+      const math_t* v = QR + size_t(j) * n_rows;
+      math_t w        = q[j];
+      for (int i = j + 1; i < n_rows; i++) {
+        w += v[i] * q[i];
+      }
+      w *= tau[j];
+      q[j] -= w;
+      for (int i = j + 1; i < n_rows; i++) {
+        q[i] -= w * v[i];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Calculate the QR decompositions of a batch of small matrices with a single batched
+ * cuBLAS factorization.
+ *
+ * Subject to the algorithm constraint `n_rows >= n_cols`.
+ *
+ * @param handle
+ * @param[in] M device pointer to the batch_size input matrices, column-major of size
+ *              [n_rows, n_cols] and stored one after the other
+ * @param[out] Q device pointer to the batch_size matrices Q, as M
+ * @param[out] R device pointer to the batch_size matrices R of size [n_cols, n_cols]
+ * @param n_rows
+ * @param n_cols
+ * @param batch_size
+ * @param stream
+ */
+template <typename math_t>
+void qrGetQR_batched(raft::resources const& handle,
+                     const math_t* M,
+                     math_t* Q,
+                     math_t* R,
+                     int n_rows,
+                     int n_cols,
+                     int batch_size,
+                     cudaStream_t stream)
+{
+  RAFT_EXPECTS(n_rows >= n_cols, "QR decomposition expects n_rows >= n_cols.");
+  if (batch_size == 0 || n_cols == 0) { return; }
+  cublasHandle_t cublas_h = resource::get_cublas_handle(handle);
+
+  size_t matrix_size = size_t(n_rows) * n_cols;
+  rmm::device_uvector<math_t> QR(matrix_size * batch_size, stream);
+  rmm::device_uvector<math_t> tau(size_t(n_cols) * batch_size, stream);
+  raft::copy(QR.data(), M, QR.size(), stream);
+
+  // cuBLAS takes the batch as arrays of device pointers
+  rmm::device_uvector<math_t*> QR_ptrs(batch_size, stream);
+  rmm::device_uvector<math_t*> tau_ptrs(batch_size, stream);
+  auto* QR_base  = QR.data();
+  auto* tau_base = tau.data();
+  thrust::transform(resource::get_thrust_policy(handle),
+                    thrust::make_counting_iterator(0),
+                    thrust::make_counting_iterator(batch_size),
+                    QR_ptrs.data(),
+                    [QR_base, matrix_size] __device__(int b) { return QR_base + b * matrix_size; });
+  thrust::transform(resource::get_thrust_policy(handle),
+                    thrust::make_counting_iterator(0),
+                    thrust::make_counting_iterator(batch_size),
+                    tau_ptrs.data(),
+                    [tau_base, n_cols] __device__(int b) { return tau_base + size_t(b) * n_cols; });
+
+  int info = 0;
+  RAFT_CUBLAS_TRY(cublasgeqrfBatched(cublas_h,
+                                     n_rows,
+                                     n_cols,
+                                     QR_ptrs.data(),
+                                     n_rows,
+                                     tau_ptrs.data(),
+                                     &info,
+                                     batch_size,
+                                     stream));
+  RAFT_EXPECTS(info == 0, "geqrfBatched: invalid parameter %d", -info);
+
+  constexpr int kBlockSize = 128;
+  qr_batched_expand_kernel<<<batch_size, kBlockSize, 0, stream>>>(
+    QR.data(), tau.data(), Q, R, n_rows, n_cols);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 };  // namespace detail
 };  // namespace linalg
 };  // namespace raft
@@ -16,11 +16,16 @@
 
 #pragma once
 
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/math.hpp>
+#include <raft/core/pinned_mdarray.hpp>
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/cusolver_dn_handle.hpp>
 #include <raft/linalg/eig.cuh>
 #include <raft/linalg/gemm.cuh>
+#include <raft/linalg/map.cuh>
 #include <raft/linalg/qr.cuh>
 #include <raft/linalg/svd.cuh>
 #include <raft/linalg/transpose.cuh>
@@ -32,7 +37,13 @@
 #include <raft/random/rng.cuh>
 #include <raft/util/cuda_utils.cuh>
 
+#include <rmm/device_uvector.hpp>
+
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <optional>
 
 namespace raft {
 namespace linalg {
@@ -508,6 +519,285 @@ void rsvdPerc(raft::resources const& handle,
                 stream);
 }
 
+/**
+ * @brief Streams the row blocks of a host matrix through the device, twice buffered.
+ *
+ * The rows of every block are copied to a pinned buffer, and from there to a device buffer on a
+ * copy stream, while the main stream works on the previous block. `consume(block, rows, row0,
+ * slot)` then enqueues the work on the block, a column major (n_cols, rows) matrix, on the main
+ * stream. The two slots alternate between the blocks.
+ */
+template <typename math_t, typename idx_t, typename ConsumeOp>
+void stream_row_blocks(raft::resources const& handle,
+                       raft::host_matrix_view<const math_t, idx_t, raft::row_major> M,
+                       int block_rows,
+                       std::array<std::optional<raft::pinned_vector<math_t, int64_t>>, 2>& staging,
+                       std::array<rmm::device_uvector<math_t>, 2>& blocks,
+                       ConsumeOp consume)
+{
+  cudaStream_t stream      = resource::get_cuda_stream(handle);
+  cudaStream_t copy_stream = resource::get_next_usable_stream(handle);
+  const int64_t n_rows     = M.extent(0);
+  const int64_t n_cols     = M.extent(1);
+  const int64_t n_blocks   = raft::ceildiv<int64_t>(n_rows, block_rows);
+
+  std::array<cudaEvent_t, 2> copied;
+  std::array<cudaEvent_t, 2> consumed;
+  for (int s = 0; s < 2; s++) {
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&copied[s], cudaEventDisableTiming));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&consumed[s], cudaEventDisableTiming));
+  }
+  for (int64_t b = 0; b < n_blocks; b++) {
+    const int s        = b % 2;
+    const int64_t row0 = b * block_rows;
+    const int rows     = std::min<int64_t>(block_rows, n_rows - row0);
+    // The staging buffer is free once the block before the previous one has been transferred,
+    // which leaves the host to fill it while the device works on the previous block
+    RAFT_CUDA_TRY(cudaEventSynchronize(copied[s]));
+    std::memcpy(staging[s]->data_handle(),
+                M.data_handle() + row0 * n_cols,
+                sizeof(math_t) * rows * n_cols);
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(copy_stream, consumed[s], 0u));
+    raft::copy(blocks[s].data(), staging[s]->data_handle(), rows * n_cols, copy_stream);
+    RAFT_CUDA_TRY(cudaEventRecord(copied[s], copy_stream));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, copied[s], 0u));
+    consume(static_cast<const math_t*>(blocks[s].data()), rows, row0, s);
+    RAFT_CUDA_TRY(cudaEventRecord(consumed[s], stream));
+  }
+  // The pinned buffers may be released once their last transfer is done
+  for (int s = 0; s < 2; s++) {
+    RAFT_CUDA_TRY(cudaEventSynchronize(copied[s]));
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(copied[s]));
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(consumed[s]));
+  }
+}
+
+/**
+ * @brief Out-of-core randomized SVD of a tall row major host matrix, see
+ * raft::linalg::rsvd_streaming.
+ *
+ * Every pass over the row blocks A_b accumulates Z = A^T A Omega = sum_b A_b^T (A_b Omega), so
+ * that the sketch Y = A Omega is only held a block at a time. The power iterations
+ * orthonormalize Z into the next Omega. After the last pass Q = Y T, with G = Y^T Y = Omega^T Z =
+ * W Lambda W^T and T = W Lambda^{-1/2}, has orthonormal columns, and B^T = A^T Q = Z T is the
+ * small (n_cols, l) projection. The SVD B^T = V Sigma Uhat^T gives S and V, and U = A (Omega T
+ * Uhat) takes one more pass. The eigenvalues of G below l * eps of the largest one, whose
+ * directions are lost in the Gram matrix, are dropped.
+ *
+ * Only (n_cols, l) matrices and the blocks live on the device, and U is written back to the host
+ * block by block.
+ */
+template <typename math_t, typename idx_t>
+void rsvd_streaming(raft::resources const& handle,
+                    raft::host_matrix_view<const math_t, idx_t, raft::row_major> M,
+                    math_t* S_vec,
+                    math_t* U,
+                    math_t* V,
+                    int k,
+                    int p,
+                    int n_power_iters,
+                    int block_rows,
+                    uint64_t seed)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "raft::linalg::rsvd_streaming(%zu, %zu, %d)", size_t(M.extent(0)), size_t(M.extent(1)), k);
+  cudaStream_t stream  = resource::get_cuda_stream(handle);
+  const int64_t n_rows = M.extent(0);
+  const int n          = M.extent(1);
+  const int l          = k + p;
+  RAFT_EXPECTS(k > 0 && p >= 0, "k must be positive and p non negative");
+  RAFT_EXPECTS(l <= n && l <= n_rows, "k + p must not exceed the dimensions of M");
+  RAFT_EXPECTS(block_rows > 0, "block_rows must be positive");
+  block_rows = std::min<int64_t>(block_rows, n_rows);
+
+  std::array<std::optional<raft::pinned_vector<math_t, int64_t>>, 2> staging;
+  std::array<rmm::device_uvector<math_t>, 2> blocks{
+    rmm::device_uvector<math_t>(int64_t(block_rows) * n, stream),
+    rmm::device_uvector<math_t>(int64_t(block_rows) * n, stream)};
+  for (int s = 0; s < 2; s++) {
+    staging[s].emplace(raft::make_pinned_vector<math_t, int64_t>(handle, int64_t(block_rows) * n));
+  }
+
+  rmm::device_uvector<math_t> omega(int64_t(n) * l, stream);
+  rmm::device_uvector<math_t> Z(int64_t(n) * l, stream);
+  rmm::device_uvector<math_t> Y(int64_t(block_rows) * l, stream);
+  raft::random::RngState state{seed};
+  raft::random::normal(handle, state, omega.data(), int64_t(n) * l, math_t(0), math_t(1));
+
+  // Z = A^T A Omega
+  auto sketch = [&](const math_t* block, int rows, int64_t, int) {
+    raft::linalg::gemm(handle,
+                       block,
+                       n,
+                       rows,
+                       omega.data(),
+                       Y.data(),
+                       rows,
+                       l,
+                       CUBLAS_OP_T,
+                       CUBLAS_OP_N,
+                       math_t(1),
+                       math_t(0),
+                       stream);
+    raft::linalg::gemm(handle,
+                       block,
+                       n,
+                       rows,
+                       Y.data(),
+                       Z.data(),
+                       n,
+                       l,
+                       CUBLAS_OP_N,
+                       CUBLAS_OP_N,
+                       math_t(1),
+                       math_t(1),
+                       stream);
+  };
+  for (int it = 0; it <= n_power_iters; it++) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(Z.data(), 0, sizeof(math_t) * Z.size(), stream));
+    stream_row_blocks(handle, M, block_rows, staging, blocks, sketch);
+    if (it < n_power_iters) { raft::linalg::qrGetQ(handle, Z.data(), omega.data(), n, l, stream); }
+  }
+
+  // T = W Lambda^{-1/2}, from the Gram matrix of the sketch
+  rmm::device_uvector<math_t> G(int64_t(l) * l, stream);
+  rmm::device_uvector<math_t> W(int64_t(l) * l, stream);
+  rmm::device_uvector<math_t> lambda(l, stream);
+  raft::linalg::gemm(handle,
+                     omega.data(),
+                     n,
+                     l,
+                     Z.data(),
+                     G.data(),
+                     l,
+                     l,
+                     CUBLAS_OP_T,
+                     CUBLAS_OP_N,
+                     math_t(1),
+                     math_t(0),
+                     stream);
+  raft::linalg::eigDC(handle, G.data(), l, l, W.data(), lambda.data(), stream);
+  const math_t* w_ptr      = W.data();
+  const math_t* lambda_ptr = lambda.data();
+  const math_t cutoff      = l * std::numeric_limits<math_t>::epsilon();
+  raft::linalg::map_offset(handle,
+                           raft::make_device_vector_view<math_t, int64_t>(G.data(), G.size()),
+                           [w_ptr, lambda_ptr, l, cutoff] __device__(int64_t i) {
+                             // the eigenvalues are in ascending order
+                             math_t lam = lambda_ptr[i / l];
+                             if (!(lam > cutoff * lambda_ptr[l - 1])) { return math_t(0); }
+                             return w_ptr[i] / raft::sqrt(lam);
+                           });
+
+  // B^T = Z T = V Sigma Uhat^T
+  rmm::device_uvector<math_t> Bt(int64_t(n) * l, stream);
+  rmm::device_uvector<math_t> sigma(l, stream);
+  rmm::device_uvector<math_t> V_full(V != nullptr ? int64_t(n) * l : 0, stream);
+  rmm::device_uvector<math_t> Uhat(U != nullptr ? int64_t(l) * l : 0, stream);
+  raft::linalg::gemm(handle,
+                     Z.data(),
+                     n,
+                     l,
+                     G.data(),
+                     Bt.data(),
+                     n,
+                     l,
+                     CUBLAS_OP_N,
+                     CUBLAS_OP_N,
+                     math_t(1),
+                     math_t(0),
+                     stream);
+  raft::linalg::svdQR(handle,
+                      Bt.data(),
+                      n,
+                      l,
+                      sigma.data(),
+                      V_full.data(),
+                      Uhat.data(),
+                      true,
+                      V != nullptr,
+                      U != nullptr,
+                      stream);
+  raft::copy(S_vec, sigma.data(), k, stream);
+  if (V != nullptr) { raft::copy(V, V_full.data(), int64_t(n) * k, stream); }
+  if (U == nullptr) { return; }
+
+  // U = A P with P = Omega T Uhat[:, :k], the blocks of U^T land in the row major host U
+  rmm::device_uvector<math_t> P(int64_t(n) * k, stream);
+  raft::linalg::gemm(handle,
+                     omega.data(),
+                     n,
+                     l,
+                     G.data(),
+                     Bt.data(),
+                     n,
+                     l,
+                     CUBLAS_OP_N,
+                     CUBLAS_OP_N,
+                     math_t(1),
+                     math_t(0),
+                     stream);
+  raft::linalg::gemm(handle,
+                     Bt.data(),
+                     n,
+                     l,
+                     Uhat.data(),
+                     P.data(),
+                     n,
+                     k,
+                     CUBLAS_OP_N,
+                     CUBLAS_OP_N,
+                     math_t(1),
+                     math_t(0),
+                     stream);
+
+  std::array<std::optional<raft::pinned_vector<math_t, int64_t>>, 2> u_staging;
+  std::array<rmm::device_uvector<math_t>, 2> u_blocks{
+    rmm::device_uvector<math_t>(int64_t(block_rows) * k, stream),
+    rmm::device_uvector<math_t>(int64_t(block_rows) * k, stream)};
+  std::array<cudaEvent_t, 2> u_copied;
+  // the rows pending in every staging buffer, written to U once their transfer is done
+  std::array<int64_t, 2> u_row0{-1, -1};
+  std::array<int, 2> u_rows{0, 0};
+  for (int s = 0; s < 2; s++) {
+    u_staging[s].emplace(
+      raft::make_pinned_vector<math_t, int64_t>(handle, int64_t(block_rows) * k));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&u_copied[s], cudaEventDisableTiming));
+  }
+  auto flush = [&](int s) {
+    if (u_row0[s] < 0) { return; }
+    RAFT_CUDA_TRY(cudaEventSynchronize(u_copied[s]));
+    std::memcpy(
+      U + u_row0[s] * k, u_staging[s]->data_handle(), sizeof(math_t) * int64_t(u_rows[s]) * k);
+    u_row0[s] = -1;
+  };
+  auto project = [&](const math_t* block, int rows, int64_t row0, int s) {
+    flush(s);
+    raft::linalg::gemm(handle,
+                       P.data(),
+                       n,
+                       k,
+                       block,
+                       u_blocks[s].data(),
+                       k,
+                       rows,
+                       CUBLAS_OP_T,
+                       CUBLAS_OP_N,
+                       math_t(1),
+                       math_t(0),
+                       stream);
+    raft::copy(u_staging[s]->data_handle(), u_blocks[s].data(), int64_t(rows) * k, stream);
+    RAFT_CUDA_TRY(cudaEventRecord(u_copied[s], stream));
+    u_row0[s] = row0;
+    u_rows[s] = rows;
+  };
+  stream_row_blocks(handle, M, block_rows, staging, blocks, project);
+  for (int s = 0; s < 2; s++) {
+    flush(s);
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(u_copied[s]));
+  }
+}
+
 };  // end namespace detail
 };  // end namespace linalg
 };  // end namespace raft
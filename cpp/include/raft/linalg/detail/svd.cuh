@@ -37,6 +37,8 @@
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <vector>
+
 namespace raft {
 namespace linalg {
 namespace detail {
@@ -240,6 +242,157 @@ void svdJacobi(raft::resources const& handle,
   RAFT_CUSOLVER_TRY(cusolverDnDestroyGesvdjInfo(gesvdj_params));
 }
 
+/**
+ * @brief Singular value decompositions of a batch of small matrices, in a single cuSOLVER call:
+ * the batched Jacobi method up to 32 x 32 matrices, which is its limit, and the approximate
+ * strided batched gesvda for the larger ones.
+ *
+ * The input matrices are column-major of size [n_rows, n_cols], n_rows >= n_cols, and stored one
+ * after the other, as are the n_cols singular values (in descending order), the left vectors of
+ * size [n_rows, n_cols] and the right vectors of size [n_cols, n_cols] of every matrix.
+ */
+template <typename math_t>
+void svdJacobi_batched(raft::resources const& handle,
+                       const math_t* in,
+                       int n_rows,
+                       int n_cols,
+                       int batch_size,
+                       math_t* sing_vals,
+                       math_t* left_sing_vecs,
+                       math_t* right_sing_vecs,
+                       bool gen_left_vec,
+                       bool gen_right_vec,
+                       math_t tol,
+                       int max_sweeps,
+                       cudaStream_t stream)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "raft::linalg::svdJacobi_batched(%d, %d, %d)", n_rows, n_cols, batch_size);
+  RAFT_EXPECTS(n_rows >= n_cols, "Batched SVD expects n_rows >= n_cols.");
+  if (batch_size == 0 || n_cols == 0) { return; }
+  cusolverDnHandle_t cusolverH = resource::get_cusolver_dn_handle(handle);
+
+  int m = n_rows;
+  int n = n_cols;
+  rmm::device_uvector<int> devInfo(batch_size, stream);
+  // the vectors which are not requested still get a buffer when the others are computed
+  bool gen_vecs = gen_left_vec || gen_right_vec;
+  auto jobz     = gen_vecs ? CUSOLVER_EIG_MODE_VECTOR : CUSOLVER_EIG_MODE_NOVECTOR;
+  rmm::device_uvector<math_t> V_tmp(
+    gen_vecs && !gen_right_vec ? size_t(n) * n * batch_size : 0, stream);
+  math_t* V = gen_right_vec ? right_sing_vecs : V_tmp.data();
+
+  if (m <= 32) {
+    // gesvdjBatched overwrites its input and returns the full m x m left vectors
+    rmm::device_uvector<math_t> A(size_t(m) * n * batch_size, stream);
+    raft::copy(A.data(), in, A.size(), stream);
+    rmm::device_uvector<math_t> U_full(
+      gen_vecs && (m != n || !gen_left_vec) ? size_t(m) * m * batch_size : 0, stream);
+    math_t* U = U_full.size() > 0 ? U_full.data() : left_sing_vecs;
+
+    gesvdjInfo_t gesvdj_params = NULL;
+    RAFT_CUSOLVER_TRY(cusolverDnCreateGesvdjInfo(&gesvdj_params));
+    RAFT_CUSOLVER_TRY(cusolverDnXgesvdjSetTolerance(gesvdj_params, tol));
+    RAFT_CUSOLVER_TRY(cusolverDnXgesvdjSetMaxSweeps(gesvdj_params, max_sweeps));
+    RAFT_CUSOLVER_TRY(cusolverDnXgesvdjSetSortEig(gesvdj_params, 1));
+
+    int lwork = 0;
+    RAFT_CUSOLVER_TRY(cusolverDngesvdjBatched_bufferSize(cusolverH,
+                                                         jobz,
+                                                         m,
+                                                         n,
+                                                         A.data(),
+                                                         m,
+                                                         sing_vals,
+                                                         U,
+                                                         m,
+                                                         V,
+                                                         n,
+                                                         &lwork,
+                                                         gesvdj_params,
+                                                         batch_size));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    RAFT_CUSOLVER_TRY(cusolverDngesvdjBatched(cusolverH,
+                                              jobz,
+                                              m,
+                                              n,
+                                              A.data(),
+                                              m,
+                                              sing_vals,
+                                              U,
+                                              m,
+                                              V,
+                                              n,
+                                              d_work.data(),
+                                              lwork,
+                                              devInfo.data(),
+                                              gesvdj_params,
+                                              batch_size,
+                                              stream));
+    RAFT_CUSOLVER_TRY(cusolverDnDestroyGesvdjInfo(gesvdj_params));
+
+    // the first n columns of every m x m matrix of left vectors
+    if (gen_left_vec && U != left_sing_vecs) {
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(left_sing_vecs,
+                                      sizeof(math_t) * m * n,
+                                      U,
+                                      sizeof(math_t) * m * m,
+                                      sizeof(math_t) * m * n,
+                                      batch_size,
+                                      cudaMemcpyDeviceToDevice,
+                                      stream));
+    }
+  } else {
+    rmm::device_uvector<math_t> U_tmp(
+      gen_vecs && !gen_left_vec ? size_t(m) * n * batch_size : 0, stream);
+    math_t* U = gen_left_vec ? left_sing_vecs : U_tmp.data();
+    std::vector<double> residual_norms(batch_size);
+
+    int lwork = 0;
+    RAFT_CUSOLVER_TRY(cusolverDngesvdaStridedBatched_bufferSize(cusolverH,
+                                                                jobz,
+                                                                n,
+                                                                m,
+                                                                n,
+                                                                in,
+                                                                m,
+                                                                (long long int)m * n,
+                                                                sing_vals,
+                                                                n,
+                                                                U,
+                                                                m,
+                                                                (long long int)m * n,
+                                                                V,
+                                                                n,
+                                                                (long long int)n * n,
+                                                                &lwork,
+                                                                batch_size));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    RAFT_CUSOLVER_TRY(cusolverDngesvdaStridedBatched(cusolverH,
+                                                     jobz,
+                                                     n,
+                                                     m,
+                                                     n,
+                                                     in,
+                                                     m,
+                                                     (long long int)m * n,
+                                                     sing_vals,
+                                                     n,
+                                                     U,
+                                                     m,
+                                                     (long long int)m * n,
+                                                     V,
+                                                     n,
+                                                     (long long int)n * n,
+                                                     d_work.data(),
+                                                     lwork,
+                                                     devInfo.data(),
+                                                     residual_norms.data(),
+                                                     batch_size,
+                                                     stream));
+  }
+}
+
 template <typename math_t>
 void svdReconstruction(raft::resources const& handle,
                        math_t* U,
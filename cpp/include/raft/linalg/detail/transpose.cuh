@@ -21,14 +21,21 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
 
+#include <rmm/device_uvector.hpp>
 #include <rmm/exec_policy.hpp>
 
 #include <thrust/for_each.h>
 #include <thrust/iterator/counting_iterator.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 
 namespace raft {
 namespace linalg {
@@ -277,6 +284,142 @@ void transpose_col_major_impl(
                             out.stride(1));
 }
 
+/**
+ * Index maps of the in-place transposition of a row-major (m, n) matrix, following the
+ * decomposition of Catanzaro, Keller and Garland, "A decomposition for in-place matrix
+ * transposition" (PPoPP 2014): with c = gcd(m, n), a = m / c and b = n / c, the transposition is
+ * a rotation of the columns (only needed when c > 1), a shuffle of the rows, and a shuffle of the
+ * columns. Each step permutes the elements of every row or column independently.
+ */
+struct inplace_transpose_rotate {
+  uint64_t m, b;
+  /** Source row of the element (i, j) for the column rotation. */
+  HDI uint64_t operator()(uint64_t i, uint64_t j) const { return (i + j / b) % m; }
+};
+
+struct inplace_transpose_row_shuffle {
+  uint64_t m, n, b;
+  /** Destination column of the element (i, j) for the row shuffle. */
+  HDI uint64_t operator()(uint64_t i, uint64_t j) const
+  {
+    return ((i + j / b) % m + (j * m) % n) % n;
+  }
+};
+
+struct inplace_transpose_col_shuffle {
+  uint64_t m, n, a;
+  /** Source row of the element (i, j) for the column shuffle. */
+  HDI uint64_t operator()(uint64_t i, uint64_t j) const
+  {
+    return (j % m + (i * n) % m + m - i / a) % m;
+  }
+};
+
+template <typename T, typename SrcRowOp>
+RAFT_KERNEL inplace_transpose_col_gather_kernel(const T* in,
+                                                uint64_t m,
+                                                uint64_t n,
+                                                uint64_t j0,
+                                                uint64_t w,
+                                                T* tmp,
+                                                SrcRowOp src_row)
+{
+  for (uint64_t k = blockIdx.x * uint64_t(blockDim.x) + threadIdx.x; k < m * w;
+       k += uint64_t(blockDim.x) * gridDim.x) {
+    uint64_t i = k / w;
+    uint64_t j = j0 + k % w;
+    tmp[k]     = in[src_row(i, j) * n + j];
+  }
+}
+
+template <typename T>
+RAFT_KERNEL inplace_transpose_col_store_kernel(const T* tmp,
+                                               uint64_t m,
+                                               uint64_t n,
+                                               uint64_t j0,
+                                               uint64_t w,
+                                               T* out)
+{
+  for (uint64_t k = blockIdx.x * uint64_t(blockDim.x) + threadIdx.x; k < m * w;
+       k += uint64_t(blockDim.x) * gridDim.x) {
+    out[(k / w) * n + j0 + k % w] = tmp[k];
+  }
+}
+
+template <typename T, typename DstColOp>
+RAFT_KERNEL inplace_transpose_row_scatter_kernel(const T* in,
+                                                 uint64_t n,
+                                                 uint64_t i0,
+                                                 uint64_t h,
+                                                 T* tmp,
+                                                 DstColOp dst_col)
+{
+  for (uint64_t k = blockIdx.x * uint64_t(blockDim.x) + threadIdx.x; k < h * n;
+       k += uint64_t(blockDim.x) * gridDim.x) {
+    uint64_t r                      = k / n;
+    uint64_t j                      = k % n;
+    tmp[r * n + dst_col(i0 + r, j)] = in[(i0 + r) * n + j];
+  }
+}
+
+/**
+ * @brief In-place transposition of a row-major (m, n) matrix into a row-major (n, m) matrix.
+ *
+ * The rows and columns are permuted by batches through a temporary buffer from the workspace
+ * resource, sized after the free workspace, but at least large enough to hold one row and one
+ * column.
+ */
+template <typename T>
+void transpose_inplace_row_major(raft::resources const& handle, T* inout, uint64_t m, uint64_t n)
+{
+  if (m <= 1 || n <= 1) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+  if (m == n && m * m <= uint64_t(std::numeric_limits<int>::max())) {
+    transpose(inout, int(m), stream);
+    return;
+  }
+
+  uint64_t c = std::gcd(m, n);
+  uint64_t a = m / c;
+  uint64_t b = n / c;
+
+  // Batches of columns (w columns of m elements) and rows (h rows of n elements).
+  constexpr uint64_t kMaxBatchCols = 256;
+
+  uint64_t budget = resource::get_workspace_free_bytes(handle) / (2 * sizeof(T));
+  uint64_t w      = std::clamp<uint64_t>(budget / m, 1, std::min(n, kMaxBatchCols));
+  uint64_t h      = std::clamp<uint64_t>(m * w / n, 1, m);
+  rmm::device_uvector<T> tmp(
+    std::max(m * w, h * n), stream, resource::get_workspace_resource(handle));
+
+  constexpr int kTpb = 256;
+
+  auto n_blocks = [](uint64_t size) {
+    return static_cast<int>(std::min<uint64_t>(raft::ceildiv<uint64_t>(size, kTpb), 65535));
+  };
+  auto permute_columns = [&](auto src_row) {
+    for (uint64_t j0 = 0; j0 < n; j0 += w) {
+      uint64_t wb = std::min(w, n - j0);
+      inplace_transpose_col_gather_kernel<<<n_blocks(m * wb), kTpb, 0, stream>>>(
+        inout, m, n, j0, wb, tmp.data(), src_row);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      inplace_transpose_col_store_kernel<<<n_blocks(m * wb), kTpb, 0, stream>>>(
+        tmp.data(), m, n, j0, wb, inout);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+  };
+
+  if (c > 1) { permute_columns(inplace_transpose_rotate{m, b}); }
+  for (uint64_t i0 = 0; i0 < m; i0 += h) {
+    uint64_t hb = std::min(h, m - i0);
+    inplace_transpose_row_scatter_kernel<<<n_blocks(hb * n), kTpb, 0, stream>>>(
+      inout, n, i0, hb, tmp.data(), inplace_transpose_row_shuffle{m, n, b});
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    raft::copy(inout + i0 * n, tmp.data(), hb * n, stream);
+  }
+  permute_columns(inplace_transpose_col_shuffle{m, n, a});
+}
+
 };  // end namespace detail
 };  // end namespace linalg
 };  // end namespace raft
@@ -218,6 +218,55 @@ void eig_jacobi(raft::resources const& handle,
             sweeps);
 }
 
+/**
+ * @brief eig decomps with Jacobi method of a batch of column-major symmetric matrices, e.g. many
+ * small covariance matrices.
+ *
+ * The batches are column-major 3D views of shape (n, n, batch size), i.e. the matrices are stored
+ * one after the other. The matrices with up to 32 rows are decomposed with a single batched
+ * cuSOLVER call (`syevjBatched`, limited to 32 x 32 matrices); the larger ones one after the other,
+ * sharing the workspace. The eigen values of every matrix are in ascending order.
+ * @tparam ValueType the data-type of input and output
+ * @tparam IntegerType Integer used for addressing
+ * @param handle raft::resources
+ * @param[in] in input batch of symmetric matrices of shape (n, n, batch size)
+ * @param[out] eig_vectors: eigenvectors output of shape (n, n, batch size)
+ * @param[out] eig_vals: eigen values output raft::device_matrix_view with layout raft::col_major
+ * of shape (n, batch size)
+ * @param[in] tol: error tolerance for the jacobi method. Algorithm stops when the
+                   Frobenius norm of the absolute error is below tol
+ * @param[in] sweeps: number of sweeps in the Jacobi algorithm. The more the better
+ * accuracy.
+ */
+template <typename ValueType, typename IndexType>
+void eig_jacobi_batched(
+  raft::resources const& handle,
+  raft::device_mdspan<const ValueType, extent_3d<IndexType>, raft::col_major> in,
+  raft::device_mdspan<ValueType, extent_3d<IndexType>, raft::col_major> eig_vectors,
+  raft::device_matrix_view<ValueType, IndexType, raft::col_major> eig_vals,
+  ValueType tol = 1.e-7,
+  int sweeps    = 15)
+{
+  IndexType n          = in.extent(0);
+  IndexType batch_size = in.extent(2);
+  RAFT_EXPECTS(in.extent(1) == n, "The input matrices must be square");
+  RAFT_EXPECTS(eig_vectors.extent(0) == n && eig_vectors.extent(1) == n &&
+                 eig_vectors.extent(2) == batch_size,
+               "Size mismatch between Input and Eigen Vectors");
+  RAFT_EXPECTS(eig_vals.extent(0) == n && eig_vals.extent(1) == batch_size,
+               "Size mismatch between Input and Eigen Values");
+
+  detail::eigJacobi_batched(handle,
+                            in.data_handle(),
+                            static_cast<int>(n),
+                            static_cast<int>(batch_size),
+                            eig_vectors.data_handle(),
+                            eig_vals.data_handle(),
+                            resource::get_cuda_stream(handle),
+                            tol,
+                            sweeps);
+}
+
 /** @} */  // end of eig
 
 };  // end namespace linalg
@@ -15,12 +15,16 @@
  */
 #pragma once
 
+#include "detail/cublas_wrappers.hpp"
 #include "detail/cublaslt_wrappers.hpp"
+#include "linalg_types.hpp"
 
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/host_mdspan.hpp>
+#include <raft/core/resource/cublas_handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/util/input_validation.hpp>
 
@@ -133,6 +137,202 @@ void gemm(raft::resources const& res,
   }
 }
 
+/**
+ * @brief The bias of the epilogues of the mixed precision GEMM: a vector of the type of Z, except
+ * for the fp8 inputs with a float Z, whose bias is bf16.
+ */
+template <typename InputType, typename OutputType, typename IndexType>
+using gemm_bias_view =
+  raft::device_vector_view<const detail::matmul_bias_t<InputType, OutputType>, IndexType>;
+
+/**
+ * @brief Mixed precision GEMM through cublasLt, with an optional fused epilogue
+ * It computes the following equation: Z = epilogue(alpha . X * Y + beta . Z)
+ *
+ * The inputs are half, bf16 or (with CUDA 11.8 and compute capability 8.9 or newer) fp8 e4m3/e5m2
+ * matrices, the products are accumulated in fp32 and Z is a float, half or bf16 matrix, e.g. half
+ * inputs with a float output use the tensor cores while keeping the accuracy of the output. The
+ * cublasLt descriptors and heuristics of every shape, layout and epilogue are created once and
+ * cached in the resources, so that the repeated calls only launch the matmul.
+ *
+ * The bias of the Epilogue::BIAS, RELU_BIAS and GELU_BIAS epilogues has one element per index of
+ * the contiguous dimension of Z, i.e. one per row of a col_major Z and one per column of a
+ * row_major Z, and is added before the activation. Its type is the type of Z, except for the fp8
+ * inputs with a float Z, whose bias is bf16. The fp8 inputs must have the K dimension contiguous,
+ * i.e. a row_major X and a col_major Y.
+ *
+ * @code{.cpp}
+ *   // a dense layer: relu(X * W + b), with one bias per output feature
+ *   auto x = raft::make_device_matrix<half, int>(handle, n_samples, n_in);
+ *   auto w = raft::make_device_matrix<half, int, raft::col_major>(handle, n_in, n_out);
+ *   auto b = raft::make_device_vector<float, int>(handle, n_out);
+ *   auto z = raft::make_device_matrix<float, int>(handle, n_samples, n_out);
+ *   raft::linalg::gemm(handle,
+ *                      raft::make_const_mdspan(x.view()),
+ *                      raft::make_const_mdspan(w.view()),
+ *                      z.view(),
+ *                      raft::linalg::Epilogue::RELU_BIAS,
+ *                      raft::make_const_mdspan(b.view()));
+ * @endcode
+ *
+ * @tparam InputTypeX Data type of X (half, nv_bfloat16, __nv_fp8_e4m3 or __nv_fp8_e5m2)
+ * @tparam InputTypeY Data type of Y (the type of X, or the other fp8 type)
+ * @tparam OutputType Data type of Z (float, half or nv_bfloat16)
+ * @tparam IndexType Type of index
+ * @tparam LayoutPolicyX layout of X
+ * @tparam LayoutPolicyY layout of Y
+ * @tparam LayoutPolicyZ layout of Z
+ * @param[in] res raft handle
+ * @param[in] x input raft::device_matrix_view of size M rows x K columns
+ * @param[in] y input raft::device_matrix_view of size K rows x N columns
+ * @param[inout] z output raft::device_matrix_view of size M rows x N columns
+ * @param[in] epilogue the operation fused before the store of Z
+ * @param[in] bias the bias vector of the bias epilogues, std::nullopt otherwise
+ * @param[in] alpha the scale of the product, default 1.0
+ * @param[in] beta the scale of the input Z, default 0.0
+ */
+template <typename InputTypeX,
+          typename InputTypeY,
+          typename OutputType,
+          typename IndexType,
+          typename LayoutPolicyX,
+          typename LayoutPolicyY,
+          typename LayoutPolicyZ>
+void gemm(raft::resources const& res,
+          raft::device_matrix_view<const InputTypeX, IndexType, LayoutPolicyX> x,
+          raft::device_matrix_view<const InputTypeY, IndexType, LayoutPolicyY> y,
+          raft::device_matrix_view<OutputType, IndexType, LayoutPolicyZ> z,
+          Epilogue epilogue,
+          std::optional<gemm_bias_view<InputTypeX, OutputType, IndexType>> bias = std::nullopt,
+          float alpha                                                           = 1.0f,
+          float beta                                                            = 0.0f)
+{
+  constexpr bool kFp8 = detail::is_fp8_v<InputTypeX> && detail::is_fp8_v<InputTypeY>;
+  static_assert(std::is_same_v<InputTypeX, InputTypeY> || kFp8,
+                "X and Y should have the same type, or both be fp8");
+  RAFT_EXPECTS(raft::is_row_or_column_major(x), "X is not contiguous");
+  RAFT_EXPECTS(raft::is_row_or_column_major(y), "Y is not contiguous");
+  RAFT_EXPECTS(raft::is_row_or_column_major(z), "Z is not contiguous");
+
+  RAFT_EXPECTS(x.extent(0) == z.extent(0), "Number of rows of X and Z should be equal");
+  RAFT_EXPECTS(y.extent(1) == z.extent(1), "Number of columns of Y and Z should be equal");
+  RAFT_EXPECTS(x.extent(1) == y.extent(0), "Number of columns of X and rows of Y should be equal");
+
+  constexpr auto kXColMajor = std::is_same_v<typename decltype(x)::layout_type, raft::col_major>;
+  constexpr auto kYColMajor = std::is_same_v<typename decltype(y)::layout_type, raft::col_major>;
+  constexpr auto kZColMajor = std::is_same_v<typename decltype(z)::layout_type, raft::col_major>;
+  static_assert(!kFp8 || (!kXColMajor && kYColMajor),
+                "The fp8 GEMM needs a row major X and a col major Y");
+
+  auto lt_epilogue = detail::get_cublaslt_epilogue(epilogue);
+  RAFT_EXPECTS(bias.has_value() == detail::epilogue_has_bias(lt_epilogue),
+               "A bias should be given for, and only for, the bias epilogues");
+  if (bias.has_value()) {
+    RAFT_EXPECTS(bias.value().extent(0) == z.extent(kZColMajor ? 0 : 1),
+                 "The bias should have one element per index of the contiguous dimension of Z");
+  }
+  const auto* bias_ptr = bias.has_value() ? bias.value().data_handle() : nullptr;
+
+  if constexpr (kZColMajor) {
+    return detail::matmul<false, float, InputTypeX, InputTypeY, OutputType>(
+      res,
+      !kXColMajor,
+      !kYColMajor,
+      static_cast<uint64_t>(z.extent(0)),
+      static_cast<uint64_t>(z.extent(1)),
+      static_cast<uint64_t>(x.extent(1)),
+      &alpha,
+      x.data_handle(),
+      static_cast<uint64_t>(x.extent(kXColMajor ? 0 : 1)),
+      y.data_handle(),
+      static_cast<uint64_t>(y.extent(kYColMajor ? 0 : 1)),
+      &beta,
+      z.data_handle(),
+      static_cast<uint64_t>(z.extent(0)),
+      lt_epilogue,
+      bias_ptr);
+  } else {
+    return detail::matmul<false, float, InputTypeY, InputTypeX, OutputType>(
+      res,
+      kYColMajor,
+      kXColMajor,
+      static_cast<uint64_t>(z.extent(1)),
+      static_cast<uint64_t>(z.extent(0)),
+      static_cast<uint64_t>(x.extent(1)),
+      &alpha,
+      y.data_handle(),
+      static_cast<uint64_t>(y.extent(kYColMajor ? 0 : 1)),
+      x.data_handle(),
+      static_cast<uint64_t>(x.extent(kXColMajor ? 0 : 1)),
+      &beta,
+      z.data_handle(),
+      static_cast<uint64_t>(z.extent(1)),
+      lt_epilogue,
+      bias_ptr);
+  }
+}
+
+/**
+ * @brief Strided batched GEMM for many small matrices, in a single cuBLAS call.
+ * It computes the following equation for every matrix b of the batch:
+ * Z[:, :, b] = alpha . op(X[:, :, b]) * op(Y[:, :, b]) + beta . Z[:, :, b]
+ *
+ * The batches are column-major 3D views of shape (rows, columns, batch size), i.e. the matrices
+ * are column-major and stored one after the other.
+ * @tparam ValueType Data type of input/output matrices (float/double)
+ * @tparam IndexType Type of index
+ * @param[in] res raft handle
+ * @param[in] trans_x whether to transpose the matrices of X
+ * @param[in] trans_y whether to transpose the matrices of Y
+ * @param[in] x input batch, op(X[:, :, b]) is of size M rows x K columns
+ * @param[in] y input batch, op(Y[:, :, b]) is of size K rows x N columns
+ * @param[inout] z output batch of size M rows x N columns x batch size
+ * @param[in] alpha optional raft::host_scalar_view, default 1.0
+ * @param[in] beta optional raft::host_scalar_view, default 0.0
+ */
+template <typename ValueType, typename IndexType>
+void gemm_batched(raft::resources const& res,
+                  bool trans_x,
+                  bool trans_y,
+                  raft::device_mdspan<const ValueType, extent_3d<IndexType>, raft::col_major> x,
+                  raft::device_mdspan<const ValueType, extent_3d<IndexType>, raft::col_major> y,
+                  raft::device_mdspan<ValueType, extent_3d<IndexType>, raft::col_major> z,
+                  std::optional<raft::host_scalar_view<ValueType>> alpha = std::nullopt,
+                  std::optional<raft::host_scalar_view<ValueType>> beta  = std::nullopt)
+{
+  IndexType m = z.extent(0);
+  IndexType n = z.extent(1);
+  IndexType k = trans_x ? x.extent(0) : x.extent(1);
+  RAFT_EXPECTS((trans_x ? x.extent(1) : x.extent(0)) == m, "op(X) and Z should have M rows");
+  RAFT_EXPECTS((trans_y ? y.extent(0) : y.extent(1)) == n, "op(Y) and Z should have N columns");
+  RAFT_EXPECTS((trans_y ? y.extent(1) : y.extent(0)) == k,
+               "op(X) should have as many columns as op(Y) has rows");
+  RAFT_EXPECTS(x.extent(2) == z.extent(2) && y.extent(2) == z.extent(2),
+               "X, Y and Z should have the same batch size");
+
+  ValueType alpha_value = alpha ? *alpha.value().data_handle() : ValueType(1);
+  ValueType beta_value  = beta ? *beta.value().data_handle() : ValueType(0);
+  RAFT_CUBLAS_TRY(detail::cublasgemmStridedBatched(resource::get_cublas_handle(res),
+                                                   trans_x ? CUBLAS_OP_T : CUBLAS_OP_N,
+                                                   trans_y ? CUBLAS_OP_T : CUBLAS_OP_N,
+                                                   m,
+                                                   n,
+                                                   k,
+                                                   &alpha_value,
+                                                   x.data_handle(),
+                                                   x.extent(0),
+                                                   int64_t(x.extent(0)) * x.extent(1),
+                                                   y.data_handle(),
+                                                   y.extent(0),
+                                                   int64_t(y.extent(0)) * y.extent(1),
+                                                   &beta_value,
+                                                   z.data_handle(),
+                                                   m,
+                                                   int64_t(m) * n,
+                                                   z.extent(2),
+                                                   resource::get_cuda_stream(res)));
+}
+
 /** @} */  // end of gemm
 
 }  // namespace raft::linalg
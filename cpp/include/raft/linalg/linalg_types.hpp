@@ -39,4 +39,11 @@ enum class FillMode { UPPER, LOWER };
  */
 enum class Operation { NON_TRANSPOSE, TRANSPOSE };
 
+/**
+ * @brief Enum for the elementwise operation fused at the end of a matrix multiplication, before
+ *        its result is stored. The bias variants add a vector broadcast along the output.
+ *
+ */
+enum class Epilogue { NONE, RELU, BIAS, RELU_BIAS, GELU, GELU_BIAS };
+
 }  // end namespace raft::linalg
\ No newline at end of file
@@ -243,6 +243,61 @@ void lstsq_qr(raft::resources const& handle,
           resource::get_cuda_stream(handle));
 }
 
+/**
+ * @brief Updates the solution of the linear ordinary least squares problem `Aw = b` after adding
+ *  (or removing) the rows `A_new` of `A` and `b_new` of `b`, for the streaming regressions.
+ *  (`w = (A^T A)^-1  A^T b`)
+ *
+ *  The state of the problem is the lower Cholesky factor `L` of `A^T A` and the vector `A^T b`,
+ *  which are updated in place with a rank-k update (raft::linalg::cholesky_rank_k_update), so
+ *  that adding k rows costs O(n_cols^2 k) instead of a factorization of `A^T A`. Before the first
+ *  batch, `L` can be set to `sqrt(alpha) I` and `A^T b` to zero, which solves the ridge
+ *  regression `(A^T A + alpha I) w = A^T b` with a small regularization alpha > 0.
+ *
+ * @code{.cpp}
+ *   // L = sqrt(alpha) I, Ab = 0
+ *   for (auto [A_batch, b_batch] : batches) {
+ *     raft::linalg::lstsq_cholesky_update(handle, A_batch, b_batch, L.view(), Ab.view(), w.view());
+ *   }
+ * @endcode
+ *
+ * @tparam ValueType the data-type of input/output
+ * @param[in] handle raft::resources
+ * @param[in] A_new the added rows of A, of type raft::device_matrix_view
+ * @param[in] b_new the added elements of b, of type raft::device_vector_view
+ * @param[inout] L the lower Cholesky factor of `A^T A`, of type raft::device_matrix_view
+ * @param[inout] Ab the vector `A^T b`, of type raft::device_vector_view
+ * @param[out] w output coefficient raft::device_vector_view
+ * @param[in] downdate whether the rows are removed from the problem instead of added
+ */
+template <typename ValueType, typename IndexType>
+void lstsq_cholesky_update(
+  raft::resources const& handle,
+  raft::device_matrix_view<const ValueType, IndexType, raft::col_major> A_new,
+  raft::device_vector_view<const ValueType, IndexType> b_new,
+  raft::device_matrix_view<ValueType, IndexType, raft::col_major> L,
+  raft::device_vector_view<ValueType, IndexType> Ab,
+  raft::device_vector_view<ValueType, IndexType> w,
+  bool downdate = false)
+{
+  RAFT_EXPECTS(L.extent(0) == L.extent(1), "L must be square");
+  RAFT_EXPECTS(A_new.extent(1) == L.extent(0), "Size mismatch between A_new and L");
+  RAFT_EXPECTS(A_new.extent(1) == w.size(), "Size mismatch between A_new and w");
+  RAFT_EXPECTS(A_new.extent(1) == Ab.size(), "Size mismatch between A_new and Ab");
+  RAFT_EXPECTS(A_new.extent(0) == b_new.size(), "Size mismatch between A_new and b_new");
+
+  detail::lstsqCholeskyUpdate(handle,
+                              A_new.data_handle(),
+                              A_new.extent(0),
+                              A_new.extent(1),
+                              b_new.data_handle(),
+                              L.data_handle(),
+                              Ab.data_handle(),
+                              w.data_handle(),
+                              downdate,
+                              resource::get_cuda_stream(handle));
+}
+
 /** @} */  // end of lstsq
 
 };  // namespace linalg
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/multi_reduce.cuh"
+#include "linalg_types.hpp"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/input_validation.hpp>
+
+#include <tuple>
+#include <utility>
+
+namespace raft {
+namespace linalg {
+
+/**
+ * @defgroup multi_reduce Fused Reductions Along Requested Dimension
+ * @{
+ */
+
+/**
+ * @brief One of the reductions applied by raft::linalg::multi_reduce, with the semantics of the
+ * arguments of raft::linalg::reduce.
+ *
+ * @tparam OutType the data type of the output and of the reduction
+ * @tparam MainLambda <pre>OutType (*MainLambda)(InType, IdxType);</pre>
+ * @tparam ReduceLambda <pre>OutType (*ReduceLambda)(OutType, OutType);</pre>
+ * @tparam FinalLambda <pre>OutType (*FinalLambda)(OutType);</pre>
+ */
+template <typename OutType,
+          typename MainLambda   = raft::identity_op,
+          typename ReduceLambda = raft::add_op,
+          typename FinalLambda  = raft::identity_op>
+struct reduction_op {
+  using out_type = OutType;
+
+  /** initial value of the reduction, which must be neutral for reduce_op */
+  OutType init;
+  /** elementwise operation applied before the reduction */
+  MainLambda main_op;
+  /** binary reduction operation */
+  ReduceLambda reduce_op;
+  /** elementwise operation applied before storing the result */
+  FinalLambda final_op;
+};
+
+/** @brief Create a raft::linalg::reduction_op, deducing its types. */
+template <typename OutType,
+          typename MainLambda   = raft::identity_op,
+          typename ReduceLambda = raft::add_op,
+          typename FinalLambda  = raft::identity_op>
+auto make_reduction_op(OutType init,
+                       MainLambda main_op     = raft::identity_op(),
+                       ReduceLambda reduce_op = raft::add_op(),
+                       FinalLambda final_op   = raft::identity_op())
+  -> reduction_op<OutType, MainLambda, ReduceLambda, FinalLambda>
+{
+  return {init, main_op, reduce_op, final_op};
+}
+
+/**
+ * @brief Compute several reductions of the input matrix along the requested dimension, in a single
+ *        pass over its memory.
+ *
+ *        Every reduction has its own output, initial value and lambdas, applied as
+ *        raft::linalg::reduce would. The reductions are fused into one over a tuple of
+ *        accumulators, so that computing e.g. the sum, the sum of squares, the minimum and the
+ *        maximum of every column reads the matrix once instead of four times. As with reduce,
+ *        the memory accesses are coalesced or strided depending on the layout and the dimension;
+ *        the strided reductions split the rows of the skinny matrices over several blocks and
+ *        combine the partial results without atomics, so that any accumulator type (e.g. a
+ *        mean/variance pair) can be used. Up to 10 reductions can be fused.
+ *
+ *        Unlike reduce, the sums are not compensated.
+ *
+ * @code{.cpp}
+ *   // the sum, minimum and maximum of every row
+ *   raft::linalg::multi_reduce(
+ *     handle,
+ *     data,
+ *     std::make_tuple(sums.view(), mins.view(), maxs.view()),
+ *     raft::linalg::Apply::ALONG_ROWS,
+ *     raft::linalg::make_reduction_op(0.0f),
+ *     raft::linalg::make_reduction_op(
+ *       std::numeric_limits<float>::max(), raft::identity_op{}, raft::min_op{}),
+ *     raft::linalg::make_reduction_op(
+ *       std::numeric_limits<float>::lowest(), raft::identity_op{}, raft::max_op{}));
+ * @endcode
+ *
+ * @tparam InElementType the input data-type of underlying raft::matrix_view
+ * @tparam LayoutPolicy The layout of Input (row or col major)
+ * @tparam IdxType Integer type used to for addressing
+ * @tparam OutElementTypes the output data-types of the reductions
+ * @tparam ReductionOps raft::linalg::reduction_op types, one per output
+ * @param[in] handle raft::resources
+ * @param[in] data Input of type raft::device_matrix_view
+ * @param[out] dots tuple of the outputs of type raft::device_vector_view, with one element per row
+ *   for raft::linalg::Apply::ALONG_ROWS and one per column for raft::linalg::Apply::ALONG_COLUMNS
+ * @param[in] apply whether to reduce every row or every column (using raft::linalg::Apply)
+ * @param[in] ops the reductions, in the order of the outputs
+ */
+template <typename InElementType,
+          typename LayoutPolicy,
+          typename IdxType,
+          typename... OutElementTypes,
+          typename... ReductionOps>
+void multi_reduce(raft::resources const& handle,
+                  raft::device_matrix_view<const InElementType, IdxType, LayoutPolicy> data,
+                  std::tuple<raft::device_vector_view<OutElementTypes, IdxType>...> dots,
+                  Apply apply,
+                  ReductionOps... ops)
+{
+  static_assert(sizeof...(OutElementTypes) == sizeof...(ReductionOps),
+                "multi_reduce needs one reduction op per output");
+  static_assert((std::is_same_v<OutElementTypes, typename ReductionOps::out_type> && ...),
+                "The output types must be the types of the reduction ops");
+  static_assert(sizeof...(ReductionOps) <= 10, "multi_reduce fuses up to 10 reductions");
+  RAFT_EXPECTS(raft::is_row_or_column_major(data), "Input must be contiguous");
+
+  auto constexpr row_major = std::is_same_v<typename decltype(data)::layout_type, raft::row_major>;
+  bool along_rows          = apply == Apply::ALONG_ROWS;
+  IdxType n_out            = along_rows ? data.extent(0) : data.extent(1);
+  std::apply(
+    [n_out](auto... out) {
+      RAFT_EXPECTS(((static_cast<IdxType>(out.size()) == n_out) && ...),
+                   "Every output should have one element per reduced row or column of Input");
+    },
+    dots);
+
+  // As a row major matrix of D columns and N rows
+  IdxType D = row_major ? data.extent(1) : data.extent(0);
+  IdxType N = row_major ? data.extent(0) : data.extent(1);
+  auto outs =
+    std::apply([](auto... out) { return thrust::make_tuple(out.data_handle()...); }, dots);
+  detail::multi_reduce(handle, data.data_handle(), D, N, row_major == along_rows, outs, ops...);
+}
+
+/** @} */  // end of group multi_reduce
+
+};  // end namespace linalg
+};  // end namespace raft
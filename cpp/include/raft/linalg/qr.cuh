@@ -20,6 +20,7 @@
 
 #include "detail/qr.cuh"
 
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 
@@ -118,6 +119,42 @@ void qr_get_qr(raft::resources const& handle,
           resource::get_cuda_stream(handle));
 }
 
+/**
+ * @brief Compute the QR decompositions of a batch of small matrices, with a single batched
+ * factorization instead of one call per matrix.
+ *
+ * The batches are column-major 3D views of shape (rows, columns, batch size), i.e. the matrices
+ * are column-major and stored one after the other. The matrices must have at least as many rows
+ * as columns.
+ * @param[in] handle raft::resources
+ * @param[in] M Input batch of shape (m, n, batch size)
+ * @param[out] Q Output batch of shape (m, n, batch size)
+ * @param[out] R Output batch of shape (n, n, batch size)
+ */
+template <typename ElementType, typename IndexType>
+void qr_get_qr_batched(
+  raft::resources const& handle,
+  raft::device_mdspan<const ElementType, extent_3d<IndexType>, raft::col_major> M,
+  raft::device_mdspan<ElementType, extent_3d<IndexType>, raft::col_major> Q,
+  raft::device_mdspan<ElementType, extent_3d<IndexType>, raft::col_major> R)
+{
+  RAFT_EXPECTS(Q.extent(0) == M.extent(0) && Q.extent(1) == M.extent(1) &&
+                 Q.extent(2) == M.extent(2),
+               "Size mismatch between Output and Input");
+  RAFT_EXPECTS(R.extent(0) == M.extent(1) && R.extent(1) == M.extent(1) &&
+                 R.extent(2) == M.extent(2),
+               "R should have dimensions n * n * batch size");
+
+  detail::qrGetQR_batched(handle,
+                          M.data_handle(),
+                          Q.data_handle(),
+                          R.data_handle(),
+                          M.extent(0),
+                          M.extent(1),
+                          M.extent(2),
+                          resource::get_cuda_stream(handle));
+}
+
 /** @} */
 
 };  // namespace linalg
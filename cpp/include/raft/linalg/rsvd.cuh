@@ -21,6 +21,7 @@
 #include "detail/rsvd.cuh"
 
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 
 namespace raft {
@@ -875,6 +876,106 @@ void randomized_svd(const raft::resources& handle,
   randomized_svd(handle, in, S, opt_u, opt_v, p, niters);
 }
 
+/**
+ * @brief out-of-core randomized singular value decomposition (RSVD) of a tall row major host
+ * matrix, by specifying no. of PCs and upsamples directly
+ *
+ * The matrix, which can be memory mapped from a file, never resides on the device: every pass
+ * streams its row blocks through two pinned and two device buffers, so that the transfer of a
+ * block overlaps the products of the previous one, and accumulates A^T (A Omega) into an
+ * (N, K + p) matrix. The power iterations take one pass each, and generating U one more. The
+ * device memory is bounded by (N + block_rows) * (K + p) values and two blocks, and U is written
+ * to the host block by block.
+ *
+ * The sketch is orthonormalized through its Gram matrix, which squares its condition number: the
+ * directions with a singular value below sqrt((K + p) * eps) of the largest one are dropped.
+ *
+ * @code{.cpp}
+ *   // a 1B x 512 float matrix mapped from a file
+ *   auto M = raft::make_host_matrix_view<const float, int64_t>(mapped_ptr, n_rows, 512);
+ *   auto S = raft::make_device_vector<float, int64_t>(handle, 16);
+ *   auto U = raft::make_host_matrix<float, int64_t>(n_rows, 16);
+ *   auto V = raft::make_device_matrix<float, int64_t, raft::col_major>(handle, 512, 16);
+ *   raft::linalg::rsvd_streaming(handle, M, S.view(), int64_t(16), U.view(), V.view());
+ * @endcode
+ *
+ * @tparam ValueType value type of parameters
+ * @tparam IndexType index type of parameters
+ * @tparam UType std::optional<raft::host_matrix_view<ValueType, IndexType, raft::row_major>> @c
+ * U_in
+ * @tparam VType std::optional<raft::device_matrix_view<ValueType, IndexType, raft::col_major>> @c
+ * V_in
+ * @param[in] handle raft::resources, whose stream pool, if any, provides the copy stream
+ * @param[in] M input raft::host_matrix_view with layout raft::row_major of shape (M, N)
+ * @param[out] S_vec singular values raft::device_vector_view of shape (K), in descending order
+ * @param[in] p no. of upsamples
+ * @param[out] U_in std::optional left singular vectors of raft::host_matrix_view with layout
+ * raft::row_major of shape (M, K)
+ * @param[out] V_in std::optional right singular vectors of raft::device_matrix_view with layout
+ * raft::col_major of shape (N, K)
+ * @param[in] n_power_iters no. of power iterations (2 is recommended)
+ * @param[in] block_rows no. of rows of A transferred to the device at once
+ * @param[in] seed seed of the random projection
+ */
+template <typename ValueType, typename IndexType, typename UType, typename VType>
+void rsvd_streaming(raft::resources const& handle,
+                    raft::host_matrix_view<const ValueType, IndexType, raft::row_major> M,
+                    raft::device_vector_view<ValueType, IndexType> S_vec,
+                    IndexType p,
+                    UType&& U_in,
+                    VType&& V_in,
+                    int n_power_iters    = 2,
+                    IndexType block_rows = 65536,
+                    uint64_t seed        = 0ULL)
+{
+  std::optional<raft::host_matrix_view<ValueType, IndexType, raft::row_major>> U =
+    std::forward<UType>(U_in);
+  std::optional<raft::device_matrix_view<ValueType, IndexType, raft::col_major>> V =
+    std::forward<VType>(V_in);
+  ValueType* U_ptr = nullptr;
+  ValueType* V_ptr = nullptr;
+
+  if (U) {
+    RAFT_EXPECTS(M.extent(0) == U.value().extent(0), "Number of rows in M should be equal to U");
+    RAFT_EXPECTS(S_vec.extent(0) == U.value().extent(1),
+                 "Number of columns in U should be equal to length of S");
+    U_ptr = U.value().data_handle();
+  }
+  if (V) {
+    RAFT_EXPECTS(M.extent(1) == V.value().extent(0), "Number of columns in M should be equal to V");
+    RAFT_EXPECTS(S_vec.extent(0) == V.value().extent(1),
+                 "Number of columns in V should be equal to length of S");
+    V_ptr = V.value().data_handle();
+  }
+  RAFT_EXPECTS(M.extent(1) > 0, "M must have at least one column");
+  RAFT_EXPECTS(block_rows <= IndexType(std::numeric_limits<int>::max() / M.extent(1)),
+               "A block of block_rows rows of M must have less than 2^31 elements");
+
+  detail::rsvd_streaming(handle,
+                         M,
+                         S_vec.data_handle(),
+                         U_ptr,
+                         V_ptr,
+                         S_vec.extent(0),
+                         p,
+                         n_power_iters,
+                         block_rows,
+                         seed);
+}
+
+/**
+ * @brief Overload of `rsvd_streaming` to help the
+ *   compiler find the above overload, in case users pass in
+ *   `std::nullopt` for one or both of the optional arguments.
+ *
+ * Please see above for documentation of `rsvd_streaming`.
+ */
+template <typename... Args, typename = std::enable_if_t<sizeof...(Args) == 4>>
+void rsvd_streaming(Args... args)
+{
+  rsvd_streaming(std::forward<Args>(args)..., std::nullopt, std::nullopt);
+}
+
 /** @} */  // end of group rsvd
 
 };  // end namespace linalg
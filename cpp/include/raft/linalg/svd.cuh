@@ -20,6 +20,7 @@
 
 #include "detail/svd.cuh"
 
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 
 #include <optional>
@@ -415,6 +416,96 @@ void svd_reconstruction(raft::resources const& handle,
                     resource::get_cuda_stream(handle));
 }
 
+/**
+ * @brief singular value decompositions (SVD) of a batch of small column major matrices, with a
+ * single batched cuSOLVER call instead of one call per matrix
+ *
+ * The batches are column-major 3D views of shape (rows, columns, batch size), i.e. the matrices
+ * are column-major and stored one after the other, and the matrices must have at least as many
+ * rows as columns. The matrices with up to 32 rows use the batched Jacobi method (`gesvdjBatched`,
+ * limited to 32 x 32 matrices). The larger ones use the strided batched `gesvdaStridedBatched`,
+ * which is accurate for well conditioned matrices, and ignores `tol` and `max_sweeps`.
+ * @tparam ValueType value type of parameters
+ * @tparam IndexType index type of parameters
+ * @param[in] handle raft::resources
+ * @param[in] in input batch of shape (M, N, batch size)
+ * @param[out] sing_vals singular values raft::device_matrix_view with layout raft::col_major of
+ * shape (N, batch size), in descending order
+ * @param[out] U std::optional left singular vectors of shape (M, N, batch size)
+ * @param[out] V std::optional right singular vectors of shape (N, N, batch size)
+ * @param[in] tol error tolerance for the Jacobi method
+ * @param[in] max_sweeps number of sweeps in the Jacobi method
+ */
+template <typename ValueType, typename IndexType>
+void svd_batched(
+  raft::resources const& handle,
+  raft::device_mdspan<const ValueType, extent_3d<IndexType>, raft::col_major> in,
+  raft::device_matrix_view<ValueType, IndexType, raft::col_major> sing_vals,
+  std::optional<raft::device_mdspan<ValueType, extent_3d<IndexType>, raft::col_major>> U =
+    std::nullopt,
+  std::optional<raft::device_mdspan<ValueType, extent_3d<IndexType>, raft::col_major>> V =
+    std::nullopt,
+  ValueType tol  = ValueType(1e-7),
+  int max_sweeps = 100)
+{
+  IndexType m          = in.extent(0);
+  IndexType n          = in.extent(1);
+  IndexType batch_size = in.extent(2);
+  RAFT_EXPECTS(sing_vals.extent(0) == n && sing_vals.extent(1) == batch_size,
+               "sing_vals should have dimensions n * batch size");
+  ValueType* left_sing_vecs_ptr  = nullptr;
+  ValueType* right_sing_vecs_ptr = nullptr;
+  if (U) {
+    RAFT_EXPECTS(U.value().extent(0) == m && U.value().extent(1) == n &&
+                   U.value().extent(2) == batch_size,
+                 "U should have dimensions m * n * batch size");
+    left_sing_vecs_ptr = U.value().data_handle();
+  }
+  if (V) {
+    RAFT_EXPECTS(V.value().extent(0) == n && V.value().extent(1) == n &&
+                   V.value().extent(2) == batch_size,
+                 "V should have dimensions n * n * batch size");
+    right_sing_vecs_ptr = V.value().data_handle();
+  }
+  detail::svdJacobi_batched(handle,
+                            in.data_handle(),
+                            m,
+                            n,
+                            batch_size,
+                            sing_vals.data_handle(),
+                            left_sing_vecs_ptr,
+                            right_sing_vecs_ptr,
+                            U.has_value(),
+                            V.has_value(),
+                            tol,
+                            max_sweeps,
+                            resource::get_cuda_stream(handle));
+}
+
+/**
+ * @brief Overload of `svd_batched` to help the
+ *   compiler find the above overload, in case users pass in
+ *   `std::nullopt` or views for one or both of the optional arguments.
+ *
+ * Please see above for documentation of `svd_batched`.
+ */
+template <typename ValueType, typename IndexType, typename UType, typename VType>
+void svd_batched(raft::resources const& handle,
+                 raft::device_mdspan<const ValueType, extent_3d<IndexType>, raft::col_major> in,
+                 raft::device_matrix_view<ValueType, IndexType, raft::col_major> sing_vals,
+                 UType&& U_in,
+                 VType&& V_in,
+                 ValueType tol  = ValueType(1e-7),
+                 int max_sweeps = 100)
+{
+  std::optional<raft::device_mdspan<ValueType, extent_3d<IndexType>, raft::col_major>> U =
+    std::forward<UType>(U_in);
+  std::optional<raft::device_mdspan<ValueType, extent_3d<IndexType>, raft::col_major>> V =
+    std::forward<VType>(V_in);
+
+  svd_batched(handle, in, sing_vals, U, V, tol, max_sweeps);
+}
+
 /** @} */  // end of group svd
 
 };  // end namespace linalg
@@ -102,6 +102,51 @@ auto transpose(raft::resources const& handle,
   }
 }
 
+/**
+ * @brief Transpose a contiguous matrix in place, without allocating a second matrix.
+ *
+ * A row-major (n_rows, n_cols) input becomes the row-major (n_cols, n_rows) transposed matrix in
+ * the same memory, and likewise for a column-major input. The matrix does not need to be square:
+ * the transposition is decomposed into independent permutations of the rows and of the columns
+ * (Catanzaro, Keller and Garland, "A decomposition for in-place matrix transposition"), applied by
+ * batches through a temporary buffer sized after the free workspace memory, and at least as large
+ * as one row and one column.
+ *
+ * @code{.cpp}
+ * auto m = raft::make_device_matrix<float, int64_t>(handle, n_rows, n_cols);
+ * auto m_t = raft::linalg::transpose_inplace(handle, m.view());
+ * // m_t is a (n_cols, n_rows) view of the same memory
+ * @endcode
+ *
+ * @tparam T Data type of matrix elements.
+ * @tparam IndexType Index type of matrix extent.
+ * @tparam LayoutPolicy Layout of the matrix, either raft::row_major or raft::col_major.
+ *
+ * @param[in]    handle raft handle for managing expensive cuda resources.
+ * @param[inout] inout  Matrix to transpose.
+ *
+ * @return A view of the transposed matrix, with the same layout as the input.
+ */
+template <typename T, typename IndexType, typename LayoutPolicy>
+auto transpose_inplace(raft::resources const& handle,
+                       raft::device_matrix_view<T, IndexType, LayoutPolicy> inout)
+  -> raft::device_matrix_view<T, IndexType, LayoutPolicy>
+{
+  static_assert(std::is_same_v<LayoutPolicy, layout_c_contiguous> ||
+                  std::is_same_v<LayoutPolicy, layout_f_contiguous>,
+                "The matrix must be contiguous.");
+  uint64_t n_rows = inout.extent(0);
+  uint64_t n_cols = inout.extent(1);
+  if constexpr (std::is_same_v<LayoutPolicy, layout_c_contiguous>) {
+    detail::transpose_inplace_row_major(handle, inout.data_handle(), n_rows, n_cols);
+  } else {
+    // a column-major (n_rows, n_cols) matrix is a row-major (n_cols, n_rows) matrix
+    detail::transpose_inplace_row_major(handle, inout.data_handle(), n_cols, n_rows);
+  }
+  return raft::make_device_matrix_view<T, IndexType, LayoutPolicy>(
+    inout.data_handle(), inout.extent(1), inout.extent(0));
+}
+
 /** @} */  // end of group transpose
 
 };  // end namespace linalg
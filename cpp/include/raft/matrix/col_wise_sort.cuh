@@ -22,6 +22,7 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/matrix/detail/columnWiseSort.cuh>
+#include <raft/matrix/detail/segmented_sort.cuh>
 
 namespace raft::matrix {
 
@@ -61,6 +62,9 @@ void sort_cols_per_row(const InType* in,
 /**
  * @brief sort columns within each row of row-major input matrix and return sorted indexes
  * modelled as key-value sort with key being input matrix and value being index of values
+ *
+ * The rows are sorted with raft::matrix::segmented_sort, which picks a warp, block or device-wide
+ * sort after the row length.
  * @tparam in_t: element type of input matrix
  * @tparam out_t: element type of output matrix
  * @tparam matrix_idx_t: integer type for matrix indexing
@@ -89,34 +93,16 @@ void sort_cols_per_row(raft::resources const& handle,
                  "Input and `sorted_keys` matrices must have the same shape.");
   }
 
-  size_t workspace_size = 0;
-  bool alloc_workspace  = false;
-
   in_t* keys = sorted_keys.has_value() ? sorted_keys.value().data_handle() : nullptr;
 
-  detail::sortColumnsPerRow<in_t, out_t>(in.data_handle(),
-                                         out.data_handle(),
-                                         in.extent(0),
-                                         in.extent(1),
-                                         alloc_workspace,
-                                         (void*)nullptr,
-                                         workspace_size,
-                                         resource::get_cuda_stream(handle),
-                                         keys);
-
-  if (alloc_workspace) {
-    auto workspace = raft::make_device_vector<char>(handle, workspace_size);
-
-    detail::sortColumnsPerRow<in_t, out_t>(in.data_handle(),
-                                           out.data_handle(),
-                                           in.extent(0),
-                                           in.extent(1),
-                                           alloc_workspace,
-                                           (void*)workspace.data_handle(),
-                                           workspace_size,
-                                           resource::get_cuda_stream(handle),
-                                           keys);
-  }
+  detail::sort_rows<in_t, out_t>(handle,
+                                 in.data_handle(),
+                                 static_cast<const out_t*>(nullptr),
+                                 keys,
+                                 out.data_handle(),
+                                 in.extent(0),
+                                 in.extent(1),
+                                 true);
 }
 
 /**
@@ -22,14 +22,20 @@
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/operators.hpp>
-#include <raft/core/pinned_mdarray.hpp>
 #include <raft/core/pinned_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/util/cuda_dev_essentials.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <rmm/device_uvector.hpp>
+
 #include <omp.h>
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <numeric>
 
 namespace raft {
 namespace matrix {
@@ -348,6 +354,9 @@ void gather_if(const InputIteratorT in,
 
 /**
  * Helper function to gather a set of vectors from a (host) dataset.
+ *
+ * Consecutive indices refer to contiguous rows of the dataset, which are copied at once: with
+ * sorted indices, as produced by subsampling, most of the batch is copied in long runs.
  */
 template <typename T, typename IdxT, typename MatIdxT = int64_t>
 void gather_buff(host_matrix_view<const T, MatIdxT> dataset,
@@ -356,17 +365,48 @@ void gather_buff(host_matrix_view<const T, MatIdxT> dataset,
                  pinned_matrix_view<T, MatIdxT> buff)
 {
   raft::common::nvtx::range<common::nvtx::domain::raft> fun_scope("gather_host_buff");
-  IdxT batch_size = std::min<IdxT>(buff.extent(0), indices.extent(0) - offset);
+  IdxT batch_size       = std::min<IdxT>(buff.extent(0), indices.extent(0) - offset);
+  size_t row_bytes      = sizeof(T) * buff.extent(1);
+  constexpr IdxT kChunk = 64;
+  IdxT n_chunks         = raft::ceildiv<IdxT>(batch_size, kChunk);
 
 #pragma omp for
-  for (IdxT i = 0; i < batch_size; i++) {
-    IdxT in_idx = indices(offset + i);
-    for (IdxT k = 0; k < buff.extent(1); k++) {
-      buff(i, k) = dataset(in_idx, k);
+  for (IdxT c = 0; c < n_chunks; c++) {
+    IdxT i   = c * kChunk;
+    IdxT end = std::min<IdxT>(batch_size, i + kChunk);
+    while (i < end) {
+      IdxT in_idx = indices(offset + i);
+      IdxT run    = 1;
+      while (i + run < end && indices(offset + i + run) == in_idx + run) {
+        run++;
+      }
+      std::memcpy(&buff(i, 0), &dataset(in_idx, 0), row_bytes * run);
+      i += run;
     }
   }
 }
 
+/** Scatter the rows of a batch back to their positions in the output matrix. */
+template <typename T, typename IdxT>
+RAFT_KERNEL scatter_rows_kernel(const T* in, size_t n_rows, size_t n_dim, const IdxT* rows, T* out)
+{
+  size_t n = n_rows * n_dim;
+  for (size_t k = blockIdx.x * size_t(blockDim.x) + threadIdx.x; k < n;
+       k += size_t(blockDim.x) * gridDim.x) {
+    size_t i                         = k / n_dim;
+    size_t j                         = k - i * n_dim;
+    out[size_t(rows[i]) * n_dim + j] = in[k];
+  }
+}
+
+/**
+ * Gather rows of a host dataset into a device matrix.
+ *
+ * The rows are gathered in pinned host buffers, in batches, while the previous batch is copied to
+ * the device. Unsorted indices are processed in increasing order, so that the contiguous rows
+ * are copied together and the host memory is read sequentially (which matters for memory mapped
+ * files); the batches are then scattered to their final positions on the device.
+ */
 template <typename T, typename IdxT, typename MatIdxT = int64_t>
 void gather(raft::resources const& res,
             host_matrix_view<const T, MatIdxT> dataset,
@@ -374,12 +414,31 @@ void gather(raft::resources const& res,
             raft::device_matrix_view<T, MatIdxT> output)
 {
   raft::common::nvtx::range<common::nvtx::domain::raft> fun_scope("gather");
+  auto stream       = resource::get_cuda_stream(res);
   IdxT n_dim        = output.extent(1);
   IdxT n_train      = output.extent(0);
   auto indices_host = raft::make_host_vector<IdxT, MatIdxT>(n_train);
-  raft::copy(
-    indices_host.data_handle(), indices.data_handle(), n_train, resource::get_cuda_stream(res));
+  raft::copy(indices_host.data_handle(), indices.data_handle(), n_train, stream);
   resource::sync_stream(res);
+  if (n_train == 0 || n_dim == 0) { return; }
+
+  // Positions of the indices in increasing order, when they are not sorted already.
+  bool sorted = std::is_sorted(indices_host.data_handle(), indices_host.data_handle() + n_train);
+
+  auto order          = raft::make_host_vector<IdxT, MatIdxT>(sorted ? 0 : n_train);
+  auto order_device   = raft::make_device_vector<IdxT, MatIdxT>(res, sorted ? 0 : n_train);
+  auto sorted_indices = raft::make_host_vector<IdxT, MatIdxT>(sorted ? 0 : n_train);
+  if (!sorted) {
+    std::iota(order.data_handle(), order.data_handle() + n_train, IdxT(0));
+    std::stable_sort(order.data_handle(), order.data_handle() + n_train, [&](IdxT a, IdxT b) {
+      return indices_host(a) < indices_host(b);
+    });
+    for (IdxT i = 0; i < n_train; i++) {
+      sorted_indices(i) = indices_host(order(i));
+    }
+    raft::copy(order_device.data_handle(), order.data_handle(), n_train, stream);
+  }
+  auto gather_indices = make_const_mdspan(sorted ? indices_host.view() : sorted_indices.view());
 
   const size_t buffer_size = 32768 * 1024;  // bytes
   const size_t max_batch_size =
@@ -387,9 +446,15 @@ void gather(raft::resources const& res,
   RAFT_LOG_DEBUG("Gathering data with batch size %zu", max_batch_size);
 
   // Gather the vector on the host in tmp buffers. We use two buffers to overlap H2D sync
-  // and gathering the data.
-  auto out_tmp1 = raft::make_pinned_matrix<T, MatIdxT>(res, max_batch_size, n_dim);
-  auto out_tmp2 = raft::make_pinned_matrix<T, MatIdxT>(res, max_batch_size, n_dim);
+  // and gathering the data. They come from the pinned workspace pool, which saves page-locking
+  // new host memory on every call.
+  auto pinned_mr = resource::get_pinned_workspace_resource(res);
+  rmm::device_uvector<T> out_tmp1(max_batch_size * n_dim, stream, pinned_mr);
+  rmm::device_uvector<T> out_tmp2(max_batch_size * n_dim, stream, pinned_mr);
+  // Unsorted batches are copied to the device in this buffer before they are scattered.
+  auto out_dev = raft::make_device_matrix<T, MatIdxT>(res, sorted ? 0 : max_batch_size, n_dim);
+  // The pool may hand out memory that earlier work on the stream still uses.
+  resource::sync_stream(res);
 
   // Usually a limited number of threads provide sufficient bandwidth for gathering data.
   int n_threads = std::min(omp_get_max_threads(), 32);
@@ -398,22 +463,35 @@ void gather(raft::resources const& res,
   // region here, to avoid repeated overhead within the device_offset loop.
 #pragma omp parallel num_threads(n_threads)
   {
-    auto view1 = out_tmp1.view();
-    auto view2 = out_tmp2.view();
-    gather_buff(dataset, make_const_mdspan(indices_host.view()), (MatIdxT)0, view1);
+    auto view1 = make_pinned_matrix_view<T, MatIdxT>(out_tmp1.data(), max_batch_size, n_dim);
+    auto view2 = make_pinned_matrix_view<T, MatIdxT>(out_tmp2.data(), max_batch_size, n_dim);
+    gather_buff(dataset, gather_indices, (MatIdxT)0, view1);
     for (MatIdxT device_offset = 0; device_offset < n_train; device_offset += max_batch_size) {
       MatIdxT batch_size = std::min<IdxT>(max_batch_size, n_train - device_offset);
 
 #pragma omp master
-      raft::copy(output.data_handle() + device_offset * n_dim,
-                 view1.data_handle(),
-                 batch_size * n_dim,
-                 resource::get_cuda_stream(res));
+      {
+        if (sorted) {
+          raft::copy(output.data_handle() + device_offset * n_dim,
+                     view1.data_handle(),
+                     batch_size * n_dim,
+                     stream);
+        } else {
+          raft::copy(out_dev.data_handle(), view1.data_handle(), batch_size * n_dim, stream);
+          size_t n_elems     = batch_size * n_dim;
+          const IdxT* rows   = order_device.data_handle() + device_offset;
+          constexpr int kTpb = 256;
+          int n_blocks       = std::min<size_t>(raft::ceildiv<size_t>(n_elems, kTpb), 65535);
+          scatter_rows_kernel<<<n_blocks, kTpb, 0, stream>>>(
+            out_dev.data_handle(), batch_size, n_dim, rows, output.data_handle());
+          RAFT_CUDA_TRY(cudaPeekAtLastError());
+        }
+      }
       // Start gathering the next batch on the host.
       MatIdxT host_offset = device_offset + batch_size;
       batch_size          = std::min<IdxT>(max_batch_size, n_train - host_offset);
       if (batch_size > 0) {
-        gather_buff(dataset, make_const_mdspan(indices_host.view()), host_offset, view2);
+        gather_buff(dataset, gather_indices, host_offset, view2);
       }
 #pragma omp master
       resource::sync_stream(res);
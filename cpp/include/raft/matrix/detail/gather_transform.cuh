@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/nvtx.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+namespace raft {
+namespace matrix {
+namespace detail {
+
+/** Tiling policy for the gather_transform kernel: each output row is processed by one logical
+ * warp, and a block processes RowsPerBlock rows. */
+template <int warpSize, int rpb>
+struct GatherTransformPolicy {
+  static constexpr int LogicalWarpSize = warpSize;
+  static constexpr int RowsPerBlock    = rpb;
+  static constexpr int ThreadsPerBlock = LogicalWarpSize * RowsPerBlock;
+};
+
+/** Gathered rows are kept in shared memory between the reduction and the transformation when
+ * they fit in this budget (per block), so that the source is only read once. */
+constexpr size_t kGatherTransformSmemBytes = 32 * 1024;
+
+template <typename Policy,
+          bool Staged,
+          typename InT,
+          typename MapT,
+          typename OutT,
+          typename IdxT,
+          typename AccT,
+          typename MainLambda,
+          typename ReduceLambda,
+          typename FinalLambda,
+          typename ElemLambda>
+RAFT_KERNEL __launch_bounds__(Policy::ThreadsPerBlock)
+  gather_transform_kernel(const InT* in,
+                          IdxT D,
+                          IdxT N,
+                          const MapT* map,
+                          IdxT map_length,
+                          OutT* out,
+                          AccT init,
+                          MainLambda main_op,
+                          ReduceLambda reduce_op,
+                          FinalLambda fin_op,
+                          ElemLambda elem_op)
+{
+  extern __shared__ __align__(16) char smem[];
+  IdxT i = threadIdx.y + (Policy::RowsPerBlock * static_cast<IdxT>(blockIdx.x));
+  if (i >= map_length) return;
+
+  IdxT in_row    = static_cast<IdxT>(map[i]);
+  const InT* src = in + static_cast<size_t>(in_row) * D;
+  InT* row_cache = reinterpret_cast<InT*>(smem) + static_cast<size_t>(threadIdx.y) * D;
+
+  AccT acc = init;
+  for (IdxT j = threadIdx.x; j < D; j += Policy::LogicalWarpSize) {
+    InT val = src[j];
+    if constexpr (Staged) { row_cache[j] = val; }
+    acc = reduce_op(acc, main_op(static_cast<AccT>(val), j));
+  }
+  acc = raft::logicalWarpReduce<Policy::LogicalWarpSize>(acc, reduce_op);
+  acc = fin_op(acc);
+
+  // Each lane reads back only the columns it has written, no synchronization is needed
+  OutT* dst = out + static_cast<size_t>(i) * D;
+  for (IdxT j = threadIdx.x; j < D; j += Policy::LogicalWarpSize) {
+    InT val;
+    if constexpr (Staged) {
+      val = row_cache[j];
+    } else {
+      val = src[j];
+    }
+    dst[j] = static_cast<OutT>(elem_op(val, acc, j));
+  }
+}
+
+template <typename Policy,
+          typename InT,
+          typename MapT,
+          typename OutT,
+          typename IdxT,
+          typename AccT,
+          typename MainLambda,
+          typename ReduceLambda,
+          typename FinalLambda,
+          typename ElemLambda>
+void gather_transform_launch(const InT* in,
+                             IdxT D,
+                             IdxT N,
+                             const MapT* map,
+                             IdxT map_length,
+                             OutT* out,
+                             AccT init,
+                             MainLambda main_op,
+                             ReduceLambda reduce_op,
+                             FinalLambda fin_op,
+                             ElemLambda elem_op,
+                             cudaStream_t stream)
+{
+  dim3 grid(ceildiv(map_length, (IdxT)Policy::RowsPerBlock), 1, 1);
+  dim3 block(Policy::LogicalWarpSize, Policy::RowsPerBlock, 1);
+  size_t smem_size = sizeof(InT) * static_cast<size_t>(D) * Policy::RowsPerBlock;
+  if (smem_size <= kGatherTransformSmemBytes) {
+    gather_transform_kernel<Policy, true><<<grid, block, smem_size, stream>>>(
+      in, D, N, map, map_length, out, init, main_op, reduce_op, fin_op, elem_op);
+  } else {
+    gather_transform_kernel<Policy, false><<<grid, block, 0, stream>>>(
+      in, D, N, map, map_length, out, init, main_op, reduce_op, fin_op, elem_op);
+  }
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Gather rows of a row-major matrix, reduce each gathered row to a value and write the
+ * transformed elements to the output in a single pass.
+ *
+ * For the output row i gathered from the input row map[i]:
+ *   acc       = fin_op(reduce_op_j(main_op(in(map[i], j), j)))
+ *   out(i, j) = elem_op(in(map[i], j), acc, j)
+ *
+ * The input pointer can be device memory or host memory accessible from the device (pinned or
+ * managed memory).
+ */
+template <typename InT,
+          typename MapT,
+          typename OutT,
+          typename IdxT,
+          typename AccT,
+          typename MainLambda,
+          typename ReduceLambda,
+          typename FinalLambda,
+          typename ElemLambda>
+void gather_transform(const InT* in,
+                      IdxT D,
+                      IdxT N,
+                      const MapT* map,
+                      IdxT map_length,
+                      OutT* out,
+                      AccT init,
+                      MainLambda main_op,
+                      ReduceLambda reduce_op,
+                      FinalLambda fin_op,
+                      ElemLambda elem_op,
+                      cudaStream_t stream)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "gather_transform(%zu rows, %zu cols)", size_t(map_length), size_t(D));
+  if (map_length == 0 || D == 0) return;
+  if (D <= IdxT(2)) {
+    gather_transform_launch<GatherTransformPolicy<2, 64>>(
+      in, D, N, map, map_length, out, init, main_op, reduce_op, fin_op, elem_op, stream);
+  } else if (D <= IdxT(4)) {
+    gather_transform_launch<GatherTransformPolicy<4, 32>>(
+      in, D, N, map, map_length, out, init, main_op, reduce_op, fin_op, elem_op, stream);
+  } else if (D <= IdxT(8)) {
+    gather_transform_launch<GatherTransformPolicy<8, 16>>(
+      in, D, N, map, map_length, out, init, main_op, reduce_op, fin_op, elem_op, stream);
+  } else if (D <= IdxT(16)) {
+    gather_transform_launch<GatherTransformPolicy<16, 8>>(
+      in, D, N, map, map_length, out, init, main_op, reduce_op, fin_op, elem_op, stream);
+  } else {
+    gather_transform_launch<GatherTransformPolicy<32, 4>>(
+      in, D, N, map, map_length, out, init, main_op, reduce_op, fin_op, elem_op, stream);
+  }
+}
+
+}  // namespace detail
+}  // namespace matrix
+}  // namespace raft
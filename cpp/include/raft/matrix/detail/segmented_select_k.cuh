@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/matrix/detail/select_k-inl.cuh>
+#include <raft/matrix/select_k_types.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace raft::matrix::detail {
+
+/**
+ * Select k smallest or largest key/values from each of the segments
+ * `[indptr[i], indptr[i + 1])` of the input, using one algorithm for all of them.
+ *
+ * `len` bounds the lengths of the segments; it determines the launch configuration of the
+ * selection kernels, and must not be smaller than `k`. The segments shorter than `k` are padded in
+ * the outputs. If `in_idx` is `nullptr`, the payload is the position of the value within its
+ * segment.
+ */
+template <typename T, typename IdxT>
+void select_k_segments(raft::resources const& handle,
+                       const T* in_val,
+                       const IdxT* in_idx,
+                       const IdxT* indptr,
+                       IdxT batch_size,
+                       IdxT len,
+                       IdxT k,
+                       T* out_val,
+                       IdxT* out_idx,
+                       bool select_min,
+                       bool sorted,
+                       SelectAlgo algo)
+{
+  if (algo == SelectAlgo::kAuto) { algo = choose_select_k_algorithm(batch_size, len, k); }
+
+  switch (algo) {
+    case SelectAlgo::kRadix8bits:
+    case SelectAlgo::kRadix11bits:
+    case SelectAlgo::kRadix11bitsExtraPass: {
+      if (algo == SelectAlgo::kRadix8bits) {
+        select::radix::select_k<T, IdxT, 8, 512, false>(handle,
+                                                        in_val,
+                                                        in_idx,
+                                                        batch_size,
+                                                        len,
+                                                        k,
+                                                        out_val,
+                                                        out_idx,
+                                                        select_min,
+                                                        true,
+                                                        indptr);
+      } else {
+        bool fused_last_filter = algo == SelectAlgo::kRadix11bits;
+        select::radix::select_k<T, IdxT, 11, 512, false>(handle,
+                                                         in_val,
+                                                         in_idx,
+                                                         batch_size,
+                                                         len,
+                                                         k,
+                                                         out_val,
+                                                         out_idx,
+                                                         select_min,
+                                                         fused_last_filter,
+                                                         indptr);
+      }
+
+      if (sorted) { sort_rows<T, IdxT>(handle, out_val, out_idx, batch_size, k, select_min); }
+
+      return;
+    }
+    case SelectAlgo::kWarpDistributed:
+      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_distributed>(
+        handle, in_val, in_idx, batch_size, len, k, out_val, out_idx, select_min, indptr);
+    case SelectAlgo::kWarpDistributedShm:
+      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_distributed_ext>(
+        handle, in_val, in_idx, batch_size, len, k, out_val, out_idx, select_min, indptr);
+    case SelectAlgo::kWarpAuto:
+      return select::warpsort::select_k<T, IdxT>(
+        handle, in_val, in_idx, batch_size, len, k, out_val, out_idx, select_min, indptr);
+    case SelectAlgo::kWarpImmediate:
+      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_immediate>(
+        handle, in_val, in_idx, batch_size, len, k, out_val, out_idx, select_min, indptr);
+    case SelectAlgo::kWarpFiltered:
+      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_filtered>(
+        handle, in_val, in_idx, batch_size, len, k, out_val, out_idx, select_min, indptr);
+    default: RAFT_FAIL("K-selection Algorithm not supported.");
+  }
+}
+
+/** The segments up to this length form the first bucket. */
+constexpr size_t kSegmentBucketBaseLen = 1024;
+/** Every next bucket holds the segments up to this many times longer. */
+constexpr size_t kSegmentBucketGrowth = 8;
+/** The last bucket holds all the remaining (longest) segments. */
+constexpr int kNumSegmentBuckets = 8;
+
+inline auto segment_bucket(size_t len) -> int
+{
+  int bucket = 0;
+  for (size_t bound = kSegmentBucketBaseLen; len > bound && bucket + 1 < kNumSegmentBuckets;
+       bound *= kSegmentBucketGrowth) {
+    bucket++;
+  }
+  return bucket;
+}
+
+/** Copy the input segments `rows` to the consecutive segments of a bucket, a block per segment. */
+template <typename T, typename IdxT>
+RAFT_KERNEL gather_segments_kernel(const T* in_val,
+                                   const IdxT* in_idx,
+                                   const IdxT* in_indptr,
+                                   const IdxT* rows,
+                                   const IdxT* bucket_indptr,
+                                   T* out_val,
+                                   IdxT* out_idx)
+{
+  const IdxT src = in_indptr[rows[blockIdx.x]];
+  const IdxT dst = bucket_indptr[blockIdx.x];
+  const IdxT len = bucket_indptr[blockIdx.x + 1] - dst;
+  for (IdxT i = threadIdx.x; i < len; i += blockDim.x) {
+    out_val[dst + i] = in_val[src + i];
+    if (in_idx != nullptr) { out_idx[dst + i] = in_idx[src + i]; }
+  }
+}
+
+/** Copy the k results of the bucket segments back to the output rows `rows`, a block per row. */
+template <typename T, typename IdxT>
+RAFT_KERNEL scatter_segments_kernel(
+  const T* bucket_val, const IdxT* bucket_idx, const IdxT* rows, IdxT k, T* out_val, IdxT* out_idx)
+{
+  const size_t src = size_t(blockIdx.x) * k;
+  const size_t dst = size_t(rows[blockIdx.x]) * k;
+  for (IdxT i = threadIdx.x; i < k; i += blockDim.x) {
+    out_val[dst + i] = bucket_val[src + i];
+    out_idx[dst + i] = bucket_idx[src + i];
+  }
+}
+
+/**
+ * See raft::matrix::segmented_select_k docs.
+ *
+ * The segments are grouped in buckets of similar lengths, and each bucket is processed by the
+ * algorithm chosen for its number of segments and its longest segment. This way, the short
+ * segments do not take the launch configuration sized for the longest one. A bucket is gathered
+ * into a compact CSR buffer unless it holds all the segments.
+ */
+template <typename T, typename IdxT>
+void segmented_select_k(raft::resources const& handle,
+                        const T* in_val,
+                        const IdxT* in_idx,
+                        const IdxT* indptr,
+                        size_t batch_size,
+                        int k,
+                        T* out_val,
+                        IdxT* out_idx,
+                        bool select_min,
+                        bool sorted,
+                        SelectAlgo algo)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "matrix::segmented_select_k(batch_size = %zu, k = %d)", batch_size, k);
+  if (batch_size == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  // The buckets are formed on the host, from the segment lengths.
+  std::vector<IdxT> indptr_h(batch_size + 1);
+  raft::update_host(indptr_h.data(), indptr, batch_size + 1, stream);
+  resource::sync_stream(handle);
+  if (indptr_h.back() == indptr_h.front()) {
+    // All the segments are empty: the outputs are only padding.
+    const size_t n_out = batch_size * size_t(k);
+    raft::linalg::map(handle,
+                      raft::make_device_vector_view<T, size_t>(out_val, n_out),
+                      raft::const_op<T>{select_min ? upper_bound<T>() : lower_bound<T>()});
+    raft::linalg::map(handle,
+                      raft::make_device_vector_view<IdxT, size_t>(out_idx, n_out),
+                      raft::const_op<IdxT>{std::numeric_limits<IdxT>::max()});
+    return;
+  }
+
+  std::array<std::vector<IdxT>, kNumSegmentBuckets> bucket_rows;
+  std::array<IdxT, kNumSegmentBuckets> bucket_max_len{};
+  for (size_t i = 0; i < batch_size; i++) {
+    const IdxT len = indptr_h[i + 1] - indptr_h[i];
+    const int b    = segment_bucket(len);
+    bucket_rows[b].push_back(IdxT(i));
+    // The launch configuration of the selection kernels is sized for at least `k` values.
+    bucket_max_len[b] = std::max({bucket_max_len[b], len, IdxT(k)});
+  }
+  for (int b = 0; b < kNumSegmentBuckets; b++) {
+    if (bucket_rows[b].size() != batch_size) { continue; }
+    return select_k_segments<T, IdxT>(handle,
+                                      in_val,
+                                      in_idx,
+                                      indptr,
+                                      IdxT(batch_size),
+                                      bucket_max_len[b],
+                                      IdxT(k),
+                                      out_val,
+                                      out_idx,
+                                      select_min,
+                                      sorted,
+                                      algo);
+  }
+
+  constexpr int kBlockSize = 256;
+  for (int b = 0; b < kNumSegmentBuckets; b++) {
+    const auto& rows    = bucket_rows[b];
+    const size_t n_rows = rows.size();
+    if (n_rows == 0) { continue; }
+
+    // The rows of the bucket followed by its indptr.
+    std::vector<IdxT> bucket_h(rows);
+    bucket_h.reserve(2 * n_rows + 1);
+    bucket_h.push_back(0);
+    for (auto row : rows) {
+      bucket_h.push_back(bucket_h.back() + (indptr_h[row + 1] - indptr_h[row]));
+    }
+    const IdxT nnz = bucket_h.back();
+    rmm::device_uvector<IdxT> bucket_d(bucket_h.size(), stream, mr);
+    raft::update_device(bucket_d.data(), bucket_h.data(), bucket_h.size(), stream);
+    const IdxT* rows_d   = bucket_d.data();
+    const IdxT* indptr_d = bucket_d.data() + n_rows;
+
+    rmm::device_uvector<T> vals(nnz, stream, mr);
+    rmm::device_uvector<IdxT> inds(in_idx != nullptr ? nnz : 0, stream, mr);
+    rmm::device_uvector<T> res_vals(n_rows * k, stream, mr);
+    rmm::device_uvector<IdxT> res_inds(n_rows * k, stream, mr);
+    gather_segments_kernel<T, IdxT><<<n_rows, kBlockSize, 0, stream>>>(
+      in_val, in_idx, indptr, rows_d, indptr_d, vals.data(), inds.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    select_k_segments<T, IdxT>(handle,
+                               vals.data(),
+                               in_idx != nullptr ? inds.data() : nullptr,
+                               indptr_d,
+                               IdxT(n_rows),
+                               bucket_max_len[b],
+                               IdxT(k),
+                               res_vals.data(),
+                               res_inds.data(),
+                               select_min,
+                               sorted,
+                               algo);
+    scatter_segments_kernel<T, IdxT><<<n_rows, kBlockSize, 0, stream>>>(
+      res_vals.data(), res_inds.data(), rows_d, IdxT(k), out_val, out_idx);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+}  // namespace raft::matrix::detail
@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/exec_policy.hpp>
+
+#include <cub/cub.cuh>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/transform.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace raft::matrix::detail {
+
+/** Rows up to this length are sorted by a single warp with cub::WarpMergeSort. */
+constexpr int64_t kSortRowsWarpMaxCols = 256;
+/** Rows up to this length are sorted by a thread block with cub::BlockRadixSort. */
+constexpr int64_t kSortRowsBlockMaxCols = 4096;
+
+template <typename KeyT, typename ValT, int ItemsPerThread, bool Ascending>
+RAFT_KERNEL sort_rows_warp_kernel(const KeyT* in_keys,
+                                  const ValT* in_vals,
+                                  KeyT* out_keys,
+                                  ValT* out_vals,
+                                  int64_t n_rows,
+                                  int64_t n_cols)
+{
+  constexpr int kWarpsPerBlock = 4;
+  using warp_sort              = cub::WarpMergeSort<KeyT, ItemsPerThread, WarpSize, ValT>;
+  __shared__ typename warp_sort::TempStorage storage[kWarpsPerBlock];
+
+  const int warp    = threadIdx.x / WarpSize;
+  const int lane    = threadIdx.x % WarpSize;
+  const int64_t row = int64_t(blockIdx.x) * kWarpsPerBlock + warp;
+  if (row >= n_rows) { return; }
+
+  const int64_t offset = row * n_cols;
+  const int valid      = static_cast<int>(n_cols);
+  const KeyT pad       = Ascending ? raft::upper_bound<KeyT>() : raft::lower_bound<KeyT>();
+  KeyT keys[ItemsPerThread];
+  ValT vals[ItemsPerThread];
+  cub::LoadDirectBlocked(lane, in_keys + offset, keys, valid, pad);
+  if (in_vals != nullptr) {
+    cub::LoadDirectBlocked(lane, in_vals + offset, vals, valid, ValT{});
+  } else {
+#pragma unroll
+    for (int i = 0; i < ItemsPerThread; i++) {
+      vals[i] = static_cast<ValT>(lane * ItemsPerThread + i);
+    }
+  }
+
+  warp_sort sort(storage[warp]);
+  if constexpr (Ascending) {
+    sort.StableSort(keys, vals, raft::less_op{}, valid, pad);
+  } else {
+    sort.StableSort(keys, vals, raft::greater_op{}, valid, pad);
+  }
+
+  if (out_keys != nullptr) { cub::StoreDirectBlocked(lane, out_keys + offset, keys, valid); }
+  if (out_vals != nullptr) { cub::StoreDirectBlocked(lane, out_vals + offset, vals, valid); }
+}
+
+template <typename KeyT, typename ValT, int BlockSize, int ItemsPerThread, bool Ascending>
+RAFT_KERNEL __launch_bounds__(BlockSize) sort_rows_block_kernel(const KeyT* in_keys,
+                                                                const ValT* in_vals,
+                                                                KeyT* out_keys,
+                                                                ValT* out_vals,
+                                                                int64_t n_cols)
+{
+  using block_load_keys =
+    cub::BlockLoad<KeyT, BlockSize, ItemsPerThread, cub::BLOCK_LOAD_TRANSPOSE>;
+  using block_load_vals =
+    cub::BlockLoad<ValT, BlockSize, ItemsPerThread, cub::BLOCK_LOAD_TRANSPOSE>;
+  using block_sort      = cub::BlockRadixSort<KeyT, BlockSize, ItemsPerThread, ValT>;
+  __shared__ union {
+    typename block_load_keys::TempStorage load_keys;
+    typename block_load_vals::TempStorage load_vals;
+    typename block_sort::TempStorage sort;
+  } storage;
+
+  const int64_t offset = int64_t(blockIdx.x) * n_cols;
+  const int valid      = static_cast<int>(n_cols);
+  // The sort is stable and the padding is at the end, so that it remains after the valid keys
+  const KeyT pad = Ascending ? raft::upper_bound<KeyT>() : raft::lower_bound<KeyT>();
+  KeyT keys[ItemsPerThread];
+  ValT vals[ItemsPerThread];
+  block_load_keys(storage.load_keys).Load(in_keys + offset, keys, valid, pad);
+  __syncthreads();
+  if (in_vals != nullptr) {
+    block_load_vals(storage.load_vals).Load(in_vals + offset, vals, valid, ValT{});
+    __syncthreads();
+  } else {
+#pragma unroll
+    for (int i = 0; i < ItemsPerThread; i++) {
+      vals[i] = static_cast<ValT>(threadIdx.x * ItemsPerThread + i);
+    }
+  }
+
+  if constexpr (Ascending) {
+    block_sort(storage.sort).SortBlockedToStriped(keys, vals);
+  } else {
+    block_sort(storage.sort).SortDescendingBlockedToStriped(keys, vals);
+  }
+
+  if (out_keys != nullptr) {
+    cub::StoreDirectStriped<BlockSize>(threadIdx.x, out_keys + offset, keys, valid);
+  }
+  if (out_vals != nullptr) {
+    cub::StoreDirectStriped<BlockSize>(threadIdx.x, out_vals + offset, vals, valid);
+  }
+}
+
+template <typename KeyT, typename ValT, int ItemsPerThread, bool Ascending>
+void sort_rows_warp(const KeyT* in_keys,
+                    const ValT* in_vals,
+                    KeyT* out_keys,
+                    ValT* out_vals,
+                    int64_t n_rows,
+                    int64_t n_cols,
+                    cudaStream_t stream)
+{
+  constexpr int kWarpsPerBlock = 4;
+  auto n_blocks                = raft::ceildiv<int64_t>(n_rows, kWarpsPerBlock);
+  sort_rows_warp_kernel<KeyT, ValT, ItemsPerThread, Ascending>
+    <<<n_blocks, kWarpsPerBlock * WarpSize, 0, stream>>>(
+      in_keys, in_vals, out_keys, out_vals, n_rows, n_cols);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename KeyT, typename ValT, int BlockSize, int ItemsPerThread, bool Ascending>
+void sort_rows_block(const KeyT* in_keys,
+                     const ValT* in_vals,
+                     KeyT* out_keys,
+                     ValT* out_vals,
+                     int64_t n_rows,
+                     int64_t n_cols,
+                     cudaStream_t stream)
+{
+  sort_rows_block_kernel<KeyT, ValT, BlockSize, ItemsPerThread, Ascending>
+    <<<n_rows, BlockSize, 0, stream>>>(in_keys, in_vals, out_keys, out_vals, n_cols);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Sort the rows of a row-major matrix with cub::DeviceSegmentedSort, in batches of rows small
+ * enough for its 32-bit item count.
+ */
+template <typename KeyT, typename ValT, bool Ascending>
+void sort_rows_device(raft::resources const& handle,
+                      const KeyT* in_keys,
+                      const ValT* in_vals,
+                      KeyT* out_keys,
+                      ValT* out_vals,
+                      int64_t n_rows,
+                      int64_t n_cols)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+  RAFT_EXPECTS(n_cols <= int64_t(std::numeric_limits<int>::max()),
+               "The rows are too long for the segmented sort");
+  int64_t batch_rows = std::max<int64_t>(1, std::numeric_limits<int>::max() / n_cols);
+  batch_rows         = std::min(batch_rows, n_rows);
+  size_t batch_size  = batch_rows * n_cols;
+
+  // cub needs the positions to sort them as values, and a distinct output for the keys
+  rmm::device_uvector<ValT> positions(in_vals == nullptr ? batch_size : 0, stream, mr);
+  rmm::device_uvector<KeyT> keys_buf(out_keys == nullptr ? batch_size : 0, stream, mr);
+  rmm::device_uvector<ValT> vals_buf(out_vals == nullptr ? batch_size : 0, stream, mr);
+  if (in_vals == nullptr) {
+    thrust::counting_iterator<int64_t> first(0);
+    thrust::transform(rmm::exec_policy(stream),
+                      first,
+                      first + batch_size,
+                      positions.data(),
+                      [n_cols] __device__(int64_t i) { return static_cast<ValT>(i % n_cols); });
+  }
+
+  auto segment_offsets = thrust::make_transform_iterator(thrust::counting_iterator<int>(0),
+                                                         raft::mul_const_op<int>(int(n_cols)));
+  size_t ws_size       = 0;
+  rmm::device_uvector<char> ws(0, stream, mr);
+
+  for (int64_t row = 0; row < n_rows; row += batch_rows) {
+    int rows        = static_cast<int>(std::min(batch_rows, n_rows - row));
+    int items       = static_cast<int>(rows * n_cols);
+    size_t offset   = row * n_cols;
+    const ValT* vin = in_vals == nullptr ? positions.data() : in_vals + offset;
+    KeyT* kout      = out_keys == nullptr ? keys_buf.data() : out_keys + offset;
+    ValT* vout      = out_vals == nullptr ? vals_buf.data() : out_vals + offset;
+
+    auto sort_pairs = [&](void* ws_ptr, size_t& size) {
+      if constexpr (Ascending) {
+        return cub::DeviceSegmentedSort::StableSortPairs(ws_ptr,
+                                                         size,
+                                                         in_keys + offset,
+                                                         kout,
+                                                         vin,
+                                                         vout,
+                                                         items,
+                                                         rows,
+                                                         segment_offsets,
+                                                         segment_offsets + 1,
+                                                         stream);
+      } else {
+        return cub::DeviceSegmentedSort::StableSortPairsDescending(ws_ptr,
+                                                                   size,
+                                                                   in_keys + offset,
+                                                                   kout,
+                                                                   vin,
+                                                                   vout,
+                                                                   items,
+                                                                   rows,
+                                                                   segment_offsets,
+                                                                   segment_offsets + 1,
+                                                                   stream);
+      }
+    };
+    RAFT_CUDA_TRY(sort_pairs(nullptr, ws_size));
+    if (ws_size > ws.size()) { ws.resize(ws_size, stream); }
+    RAFT_CUDA_TRY(sort_pairs(ws.data(), ws_size));
+  }
+}
+
+/**
+ * @brief Sort the elements of each row of a row-major matrix, together with their values.
+ *
+ * The algorithm depends on the length of the rows: a warp merge sort for the short rows, a block
+ * radix sort for the rows fitting in shared memory, and cub::DeviceSegmentedSort otherwise.
+ * The sort is stable. When in_vals is nullptr, the values are the positions of the keys in their
+ * row; out_keys or out_vals can be nullptr to skip the corresponding output.
+ */
+template <typename KeyT, typename ValT>
+void sort_rows(raft::resources const& handle,
+               const KeyT* in_keys,
+               const ValT* in_vals,
+               KeyT* out_keys,
+               ValT* out_vals,
+               int64_t n_rows,
+               int64_t n_cols,
+               bool ascending)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "sort_rows(%zu rows, %zu cols)", size_t(n_rows), size_t(n_cols));
+  if (n_rows == 0 || n_cols == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+
+  auto dispatch = [&](auto ascending_tag) {
+    constexpr bool kAsc = decltype(ascending_tag)::value;
+    if (n_cols <= 32) {
+      sort_rows_warp<KeyT, ValT, 1, kAsc>(
+        in_keys, in_vals, out_keys, out_vals, n_rows, n_cols, stream);
+    } else if (n_cols <= 64) {
+      sort_rows_warp<KeyT, ValT, 2, kAsc>(
+        in_keys, in_vals, out_keys, out_vals, n_rows, n_cols, stream);
+    } else if (n_cols <= 128) {
+      sort_rows_warp<KeyT, ValT, 4, kAsc>(
+        in_keys, in_vals, out_keys, out_vals, n_rows, n_cols, stream);
+    } else if (n_cols <= kSortRowsWarpMaxCols) {
+      sort_rows_warp<KeyT, ValT, 8, kAsc>(
+        in_keys, in_vals, out_keys, out_vals, n_rows, n_cols, stream);
+    } else if (n_cols <= 1024) {
+      sort_rows_block<KeyT, ValT, 128, 8, kAsc>(
+        in_keys, in_vals, out_keys, out_vals, n_rows, n_cols, stream);
+    } else if (n_cols <= 2048) {
+      sort_rows_block<KeyT, ValT, 256, 8, kAsc>(
+        in_keys, in_vals, out_keys, out_vals, n_rows, n_cols, stream);
+    } else if (n_cols <= kSortRowsBlockMaxCols && sizeof(KeyT) + sizeof(ValT) <= 12) {
+      sort_rows_block<KeyT, ValT, 256, 16, kAsc>(
+        in_keys, in_vals, out_keys, out_vals, n_rows, n_cols, stream);
+    } else {
+      sort_rows_device<KeyT, ValT, kAsc>(
+        handle, in_keys, in_vals, out_keys, out_vals, n_rows, n_cols);
+    }
+  };
+  if (ascending) {
+    dispatch(std::true_type{});
+  } else {
+    dispatch(std::false_type{});
+  }
+}
+
+/**
+ * @brief Sort the elements of each segment of a CSR-like array, together with their values.
+ *
+ * The segment i is [offsets[i], offsets[i + 1]). cub::DeviceSegmentedSort chooses the algorithm
+ * for each segment after its length. The sort is stable.
+ */
+template <typename KeyT, typename ValT, typename OffsetT>
+void segmented_sort(raft::resources const& handle,
+                    const KeyT* in_keys,
+                    const ValT* in_vals,
+                    KeyT* out_keys,
+                    ValT* out_vals,
+                    int64_t n_items,
+                    const OffsetT* offsets,
+                    int64_t n_segments,
+                    bool ascending)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "segmented_sort(%zu items, %zu segments)", size_t(n_items), size_t(n_segments));
+  RAFT_EXPECTS(n_items <= int64_t(std::numeric_limits<int>::max()) &&
+                 n_segments <= int64_t(std::numeric_limits<int>::max()),
+               "Too many items or segments for the segmented sort");
+  if (n_items == 0 || n_segments == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  size_t ws_size = 0;
+
+  auto sort = [&](void* ws_ptr, size_t& size) {
+    if (in_vals == nullptr) {
+      if (ascending) {
+        return cub::DeviceSegmentedSort::StableSortKeys(ws_ptr,
+                                                        size,
+                                                        in_keys,
+                                                        out_keys,
+                                                        int(n_items),
+                                                        int(n_segments),
+                                                        offsets,
+                                                        offsets + 1,
+                                                        stream);
+      }
+      return cub::DeviceSegmentedSort::StableSortKeysDescending(ws_ptr,
+                                                                size,
+                                                                in_keys,
+                                                                out_keys,
+                                                                int(n_items),
+                                                                int(n_segments),
+                                                                offsets,
+                                                                offsets + 1,
+                                                                stream);
+    }
+    if (ascending) {
+      return cub::DeviceSegmentedSort::StableSortPairs(ws_ptr,
+                                                       size,
+                                                       in_keys,
+                                                       out_keys,
+                                                       in_vals,
+                                                       out_vals,
+                                                       int(n_items),
+                                                       int(n_segments),
+                                                       offsets,
+                                                       offsets + 1,
+                                                       stream);
+    }
+    return cub::DeviceSegmentedSort::StableSortPairsDescending(ws_ptr,
+                                                               size,
+                                                               in_keys,
+                                                               out_keys,
+                                                               in_vals,
+                                                               out_vals,
+                                                               int(n_items),
+                                                               int(n_segments),
+                                                               offsets,
+                                                               offsets + 1,
+                                                               stream);
+  };
+  RAFT_CUDA_TRY(sort(nullptr, ws_size));
+  rmm::device_uvector<char> ws(ws_size, stream, mr);
+  RAFT_CUDA_TRY(sort(ws.data(), ws_size));
+}
+
+}  // namespace raft::matrix::detail
@@ -30,6 +30,9 @@
 
 #include <cub/cub.cuh>
 
+#include <algorithm>
+#include <type_traits>
+
 namespace raft::matrix::detail {
 
 /**
@@ -115,7 +118,7 @@ void segmented_sort_by_key(raft::resources const& handle,
                                              offsets,
                                              offsets + 1,
                                              0,
-                                             sizeof(ValT) * 8,
+                                             sizeof(KeyT) * 8,
                                              stream);
   } else {
     cub::DeviceSegmentedRadixSort::SortPairsDescending(nullptr,
@@ -129,7 +132,7 @@ void segmented_sort_by_key(raft::resources const& handle,
                                                        offsets,
                                                        offsets + 1,
                                                        0,
-                                                       sizeof(ValT) * 8,
+                                                       sizeof(KeyT) * 8,
                                                        stream);
   }
 
@@ -149,7 +152,7 @@ void segmented_sort_by_key(raft::resources const& handle,
                                              offsets,
                                              offsets + 1,
                                              0,
-                                             sizeof(ValT) * 8,
+                                             sizeof(KeyT) * 8,
                                              stream);
 
   } else {
@@ -165,7 +168,7 @@ void segmented_sort_by_key(raft::resources const& handle,
                                                        offsets,
                                                        offsets + 1,
                                                        0,
-                                                       sizeof(ValT) * 8,
+                                                       sizeof(KeyT) * 8,
                                                        stream);
   }
 
@@ -191,6 +194,97 @@ void segmented_sort_by_key(raft::resources const& handle,
                                     asc);
 }
 
+/** The largest shared memory footprint of the rows sorted in one block by `sort_rows`. */
+constexpr size_t kMaxBlockSortBytes = 32 * 1024;
+
+/**
+ * Sort every row of `len` key/values in place, the whole row held by one block.
+ *
+ * The rows are loaded in the blocked arrangement and completed with the sentinel keys, which the
+ * stable radix sort keeps behind the actual ones.
+ */
+template <typename KeyT, typename ValT, int BlockSize, int ItemsPerThread>
+RAFT_KERNEL __launch_bounds__(BlockSize)
+  block_sort_rows_kernel(KeyT* keys, ValT* values, int len, bool asc)
+{
+  constexpr auto kLoad  = cub::BLOCK_LOAD_WARP_TRANSPOSE;
+  constexpr auto kStore = cub::BLOCK_STORE_WARP_TRANSPOSE;
+  using load_keys_t     = cub::BlockLoad<KeyT, BlockSize, ItemsPerThread, kLoad>;
+  using load_vals_t     = cub::BlockLoad<ValT, BlockSize, ItemsPerThread, kLoad>;
+  using sort_t          = cub::BlockRadixSort<KeyT, BlockSize, ItemsPerThread, ValT>;
+  using store_keys_t    = cub::BlockStore<KeyT, BlockSize, ItemsPerThread, kStore>;
+  using store_vals_t    = cub::BlockStore<ValT, BlockSize, ItemsPerThread, kStore>;
+  __shared__ union {
+    typename load_keys_t::TempStorage load_keys;
+    typename load_vals_t::TempStorage load_vals;
+    typename sort_t::TempStorage sort;
+    typename store_keys_t::TempStorage store_keys;
+    typename store_vals_t::TempStorage store_vals;
+  } storage;
+
+  KeyT* row_keys   = keys + size_t(blockIdx.x) * len;
+  ValT* row_values = values + size_t(blockIdx.x) * len;
+  KeyT thread_keys[ItemsPerThread];
+  ValT thread_values[ItemsPerThread];
+  load_keys_t(storage.load_keys)
+    .Load(row_keys, thread_keys, len, asc ? upper_bound<KeyT>() : lower_bound<KeyT>());
+  __syncthreads();
+  load_vals_t(storage.load_vals).Load(row_values, thread_values, len, ValT{});
+  __syncthreads();
+  if (asc) {
+    sort_t(storage.sort).Sort(thread_keys, thread_values);
+  } else {
+    sort_t(storage.sort).SortDescending(thread_keys, thread_values);
+  }
+  __syncthreads();
+  store_keys_t(storage.store_keys).Store(row_keys, thread_keys, len);
+  __syncthreads();
+  store_vals_t(storage.store_vals).Store(row_values, thread_values, len);
+}
+
+/**
+ * Sort every row of a row-major [batch_size, len] key/value matrix in place.
+ *
+ * The rows short enough to fit the shared memory of a block are sorted in a single pass over the
+ * data; the longer ones by the device-wide segmented radix sort.
+ */
+template <typename KeyT, typename ValT>
+void sort_rows(raft::resources const& handle,
+               KeyT* keys,
+               ValT* values,
+               size_t batch_size,
+               int len,
+               bool asc)
+{
+  if (batch_size == 0 || len <= 1) { return; }
+  auto stream         = resource::get_cuda_stream(handle);
+  bool done           = false;
+  auto try_block_sort = [&](auto block_size, auto items_per_thread) {
+    constexpr int kBlockSize      = decltype(block_size)::value;
+    constexpr int kItemsPerThread = decltype(items_per_thread)::value;
+    constexpr int kCapacity       = kBlockSize * kItemsPerThread;
+    if constexpr (kCapacity * std::max(sizeof(KeyT), sizeof(ValT)) <= kMaxBlockSortBytes) {
+      if (done || len > kCapacity) { return; }
+      block_sort_rows_kernel<KeyT, ValT, kBlockSize, kItemsPerThread>
+        <<<batch_size, kBlockSize, 0, stream>>>(keys, values, len, asc);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      done = true;
+    }
+  };
+  try_block_sort(std::integral_constant<int, 128>{}, std::integral_constant<int, 4>{});
+  try_block_sort(std::integral_constant<int, 256>{}, std::integral_constant<int, 4>{});
+  try_block_sort(std::integral_constant<int, 256>{}, std::integral_constant<int, 8>{});
+  try_block_sort(std::integral_constant<int, 512>{}, std::integral_constant<int, 8>{});
+  try_block_sort(std::integral_constant<int, 512>{}, std::integral_constant<int, 16>{});
+  if (done) { return; }
+
+  auto offsets = make_device_mdarray<ValT, ValT>(
+    handle, resource::get_workspace_resource(handle), make_extents<ValT>(batch_size + 1));
+  raft::linalg::map_offset(handle, offsets.view(), mul_const_op<ValT>(len));
+  segmented_sort_by_key<KeyT, ValT>(
+    handle, keys, values, batch_size, batch_size * len, offsets.data_handle(), asc);
+}
+
 /**
  * Select k smallest or largest key/values from each row in the input data.
  *
@@ -282,17 +376,7 @@ void select_k(raft::resources const& handle,
                                                           fused_last_filter,
                                                           len_i);
       }
-      if (sorted) {
-        auto offsets = make_device_mdarray<IdxT, IdxT>(
-          handle, resource::get_workspace_resource(handle), make_extents<IdxT>(batch_size + 1));
-        raft::linalg::map_offset(handle, offsets.view(), mul_const_op<IdxT>(k));
-
-        auto keys = raft::make_device_vector_view<T, IdxT>(out_val, (IdxT)(batch_size * k));
-        auto vals = raft::make_device_vector_view<IdxT, IdxT>(out_idx, (IdxT)(batch_size * k));
-
-        segmented_sort_by_key<T, IdxT>(
-          handle, raft::make_const_mdspan(offsets.view()), keys, vals, select_min);
-      }
+      if (sorted) { sort_rows<T, IdxT>(handle, out_val, out_idx, batch_size, k, select_min); }
       return;
     }
     case SelectAlgo::kWarpDistributed:
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <cstdint>
+
+namespace raft::matrix::detail {
+
+/**
+ * Write the [n_rows, len] input candidates (len <= k) to the columns [0, k) of the rows of the
+ * output, whose leading dimension is `out_ld`. The columns [len, k) are filled with the `dummy_val`
+ * and `dummy_idx`. The `index_offset` is added to the indices of the candidates, which are their
+ * columns if `in_idx` is `nullptr`.
+ */
+template <typename T, typename IdxT>
+void copy_topk_candidates(raft::resources const& res,
+                          const T* in_val,
+                          const IdxT* in_idx,
+                          int64_t n_rows,
+                          int64_t len,
+                          IdxT index_offset,
+                          T* out_val,
+                          IdxT* out_idx,
+                          int64_t out_ld,
+                          int64_t k,
+                          T dummy_val,
+                          IdxT dummy_idx)
+{
+  auto count = thrust::make_counting_iterator<int64_t>(0);
+  thrust::for_each(
+    resource::get_thrust_policy(res), count, count + n_rows * k, [=] __device__(int64_t i) {
+      const int64_t row = i / k;
+      const int64_t col = i % k;
+      const int64_t out = row * out_ld + col;
+      if (col < len) {
+        const int64_t in = row * len + col;
+        out_val[out]     = in_val[in];
+        out_idx[out]     = index_offset + (in_idx != nullptr ? in_idx[in] : IdxT(col));
+      } else {
+        out_val[out] = dummy_val;
+        out_idx[out] = dummy_idx;
+      }
+    });
+}
+
+}  // namespace raft::matrix::detail
@@ -17,10 +17,13 @@
 #pragma once
 
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/pinned_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/matrix/detail/gather.cuh>
 #include <raft/matrix/detail/gather_inplace.cuh>
+#include <raft/matrix/detail/gather_transform.cuh>
 #include <raft/util/itertools.hpp>
 
 namespace raft::matrix {
@@ -142,6 +145,38 @@ void gather_if(const InputIteratorT in,
   detail::gather_if(in, D, N, map, stencil, map_length, out, pred_op, stream);
 }
 
+/**
+ * @brief Copies rows from a source matrix in host memory into a destination matrix in device
+ * memory according to a map.
+ *
+ * The host matrix does not need to be accessible from the device: it can be pageable memory or a
+ * memory mapped file. The rows are gathered by batches in pinned buffers, copying runs of
+ * consecutive indices at once, while the previous batch is copied to the device. Unsorted maps
+ * are processed in increasing order of the indices to read the source sequentially, and the rows
+ * are then scattered to their position on the device.
+ *
+ * @tparam matrix_t    Matrix element type
+ * @tparam map_t       Integer type of map elements
+ * @tparam idx_t       Integer type used for indexing
+ * @param[in]  handle  raft handle for managing resources
+ * @param[in]  in      Input matrix in host memory, dim = [N, D] (row-major)
+ * @param[in]  map     Map of row indices to gather, dim = [map_length]
+ * @param[out] out     Output matrix, dim = [map_length, D] (row-major)
+ */
+template <typename matrix_t, typename map_t, typename idx_t>
+void gather(const raft::resources& handle,
+            raft::host_matrix_view<const matrix_t, idx_t, row_major> in,
+            raft::device_vector_view<const map_t, idx_t> map,
+            raft::device_matrix_view<matrix_t, idx_t, row_major> out)
+{
+  RAFT_EXPECTS(out.extent(0) == map.extent(0),
+               "Number of rows in output matrix must equal the size of the map vector");
+  RAFT_EXPECTS(out.extent(1) == in.extent(1),
+               "Number of columns in input and output matrices must be equal.");
+
+  detail::gather(handle, in, map, out);
+}
+
 /**
  * @brief Conditionally copies rows according to a transformed map.
  *
@@ -330,6 +365,155 @@ void gather(raft::resources const& handle,
   detail::gather(handle, inout, map, transform_op, col_batch_size);
 }
 
+/**
+ * @brief Gathers rows of a matrix, and transforms and converts them in a single pass.
+ *
+ * For each output row i, the input row map[i] is read once and reduced to a row value
+ * (e.g. its norm), with the same operations as raft::linalg::row_normalize:
+ *
+ *   row_val   = fin_op(reduce_op(main_op(in(map[i], 0), 0), ..., main_op(in(map[i], D-1), D-1)))
+ *
+ * Then each element is transformed with the row value and its column index, and converted to the
+ * output type:
+ *
+ *   out(i, j) = out_t(elem_op(in(map[i], j), row_val, j))
+ *
+ * The column index lets elem_op apply per-column parameters, like the vectors of
+ * raft::matrix::linewise_op. This fuses the gather, the normalization and the type conversion
+ * usually chained when preparing the training set of an index.
+ *
+ * @code{.cpp}
+ * // gather the rows, L2-normalize them and convert them to half
+ * raft::matrix::gather_transform(
+ *   handle, dataset, indices, out.view(), 0.0f, raft::sq_op(), raft::add_op(), raft::sqrt_op(),
+ *   [] __device__(float x, float norm, int) { return norm > 1e-8f ? x / norm : x; });
+ * @endcode
+ *
+ * @tparam in_t          Input matrix element type
+ * @tparam map_t         Integer type of map elements
+ * @tparam out_t         Output matrix element type
+ * @tparam idx_t         Integer type used for indexing
+ * @tparam acc_t         Type of the row reduction
+ * @tparam main_op_t     Type of main_op
+ * @tparam reduce_op_t   Type of reduce_op
+ * @tparam fin_op_t      Type of fin_op
+ * @tparam elem_op_t     Type of elem_op, its result must be convertible to out_t
+ * @param[in]  handle    raft handle for managing resources
+ * @param[in]  in        Input matrix, dim = [N, D] (row-major)
+ * @param[in]  map       Map of row indices to gather, dim = [map_length]
+ * @param[out] out       Output matrix, dim = [map_length, D] (row-major)
+ * @param[in]  init      Identity element of reduce_op
+ * @param[in]  main_op   Operation applied to the elements and their column index before reducing
+ * @param[in]  reduce_op Operation to reduce a pair of values
+ * @param[in]  fin_op    Operation applied once to the reduction result of a row
+ * @param[in]  elem_op   Operation applied to each element, its row value and its column index
+ */
+template <typename in_t,
+          typename map_t,
+          typename out_t,
+          typename idx_t,
+          typename acc_t,
+          typename main_op_t,
+          typename reduce_op_t,
+          typename fin_op_t,
+          typename elem_op_t>
+void gather_transform(raft::resources const& handle,
+                      raft::device_matrix_view<const in_t, idx_t, row_major> in,
+                      raft::device_vector_view<const map_t, idx_t> map,
+                      raft::device_matrix_view<out_t, idx_t, row_major> out,
+                      acc_t init,
+                      main_op_t main_op,
+                      reduce_op_t reduce_op,
+                      fin_op_t fin_op,
+                      elem_op_t elem_op)
+{
+  RAFT_EXPECTS(out.extent(0) == map.extent(0),
+               "Number of rows in output matrix must equal the size of the map vector");
+  RAFT_EXPECTS(out.extent(1) == in.extent(1),
+               "Number of columns in input and output matrices must be equal.");
+
+  detail::gather_transform(in.data_handle(),
+                           in.extent(1),
+                           in.extent(0),
+                           map.data_handle(),
+                           map.extent(0),
+                           out.data_handle(),
+                           init,
+                           main_op,
+                           reduce_op,
+                           fin_op,
+                           elem_op,
+                           resource::get_cuda_stream(handle));
+}
+
+/**
+ * @brief Gathers rows of a matrix in pinned host memory, and transforms and converts them in a
+ * single pass.
+ *
+ * Same as the overload taking a device matrix, except that the kernel reads the gathered rows
+ * directly from pinned host memory, so only the selected rows are moved over the interconnect and
+ * no staging copy of the input is needed.
+ *
+ * @tparam in_t          Input matrix element type
+ * @tparam map_t         Integer type of map elements
+ * @tparam out_t         Output matrix element type
+ * @tparam idx_t         Integer type used for indexing
+ * @tparam acc_t         Type of the row reduction
+ * @tparam main_op_t     Type of main_op
+ * @tparam reduce_op_t   Type of reduce_op
+ * @tparam fin_op_t      Type of fin_op
+ * @tparam elem_op_t     Type of elem_op, its result must be convertible to out_t
+ * @param[in]  handle    raft handle for managing resources
+ * @param[in]  in        Input matrix in pinned host memory, dim = [N, D] (row-major)
+ * @param[in]  map       Map of row indices to gather, dim = [map_length]
+ * @param[out] out       Output matrix, dim = [map_length, D] (row-major)
+ * @param[in]  init      Identity element of reduce_op
+ * @param[in]  main_op   Operation applied to the elements and their column index before reducing
+ * @param[in]  reduce_op Operation to reduce a pair of values
+ * @param[in]  fin_op    Operation applied once to the reduction result of a row
+ * @param[in]  elem_op   Operation applied to each element, its row value and its column index
+ */
+template <typename in_t,
+          typename map_t,
+          typename out_t,
+          typename idx_t,
+          typename acc_t,
+          typename main_op_t,
+          typename reduce_op_t,
+          typename fin_op_t,
+          typename elem_op_t>
+void gather_transform(raft::resources const& handle,
+                      raft::pinned_matrix_view<const in_t, idx_t, row_major> in,
+                      raft::device_vector_view<const map_t, idx_t> map,
+                      raft::device_matrix_view<out_t, idx_t, row_major> out,
+                      acc_t init,
+                      main_op_t main_op,
+                      reduce_op_t reduce_op,
+                      fin_op_t fin_op,
+                      elem_op_t elem_op)
+{
+  RAFT_EXPECTS(out.extent(0) == map.extent(0),
+               "Number of rows in output matrix must equal the size of the map vector");
+  RAFT_EXPECTS(out.extent(1) == in.extent(1),
+               "Number of columns in input and output matrices must be equal.");
+
+  in_t* in_ptr = nullptr;
+  RAFT_CUDA_TRY(
+    cudaHostGetDevicePointer(reinterpret_cast<void**>(&in_ptr), (void*)in.data_handle(), 0));
+  detail::gather_transform(const_cast<const in_t*>(in_ptr),
+                           in.extent(1),
+                           in.extent(0),
+                           map.data_handle(),
+                           map.extent(0),
+                           out.data_handle(),
+                           init,
+                           main_op,
+                           reduce_op,
+                           fin_op,
+                           elem_op,
+                           resource::get_cuda_stream(handle));
+}
+
 /** @} */  // end of group matrix_gather
 
 }  // namespace raft::matrix
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "detail/segmented_select_k.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/select_k_types.hpp>
+
+#include <limits>
+#include <optional>
+
+namespace raft::matrix {
+
+/**
+ * @addtogroup select_k
+ * @{
+ */
+
+/**
+ * Select k smallest or largest key/values from each segment of the input data.
+ *
+ * The input `in_val` is a concatenation of `batch_size` segments of arbitrary lengths, the segment
+ * `i` being `in_val[offsets[i]:offsets[i + 1]]` (CSR-style offsets). This function selects `k`
+ * smallest/largest values in each segment and fills in the row-major matrix `out_val` of size
+ * (batch_size, k). Unlike `select_k`, the segments need not be padded to the same length.
+ *
+ * The segments are grouped in buckets of similar lengths; with `SelectAlgo::kAuto`, the
+ * algorithm is chosen per bucket. This requires the offsets on the host, hence the function
+ * synchronizes the stream of the `handle`.
+ *
+ * Example usage
+ * @code{.cpp}
+ *   using namespace raft;
+ *   // the concatenated segments and their offsets [n_segments + 1]
+ *   auto in_values = {... input device_vector_view<const float, int64_t> ...}
+ *   auto offsets   = {... input device_vector_view<const int64_t, int64_t> ...}
+ *   // prepare output arrays
+ *   auto out_extents = make_extents<int64_t>(offsets.extent(0) - 1, k);
+ *   auto out_values  = make_device_mdarray<float>(handle, out_extents);
+ *   auto out_indices = make_device_mdarray<int64_t>(handle, out_extents);
+ *   // search `k` smallest values in each segment
+ *   matrix::segmented_select_k<float, int64_t>(
+ *     handle, in_values, std::nullopt, offsets, out_values.view(), out_indices.view(), true);
+ * @endcode
+ *
+ * @tparam T
+ *   the type of the keys (what is being compared).
+ * @tparam IdxT
+ *   the index type (what is being selected together with the keys), also the type of the offsets.
+ *
+ * @param[in] handle container of reusable resources
+ * @param[in] in_val
+ *   input values [offsets[batch_size]];
+ *   these are compared and selected.
+ * @param[in] in_idx
+ *   optional input payload [offsets[batch_size]];
+ *   typically, these are indices of the corresponding `in_val`.
+ *   If `in_idx` is `std::nullopt`, the position of a value within its segment is implied.
+ * @param[in] offsets
+ *   the offsets of the segments in the inputs [batch_size + 1].
+ * @param[out] out_val
+ *   output values [batch_size, k];
+ *   the k smallest/largest values from each segment of the `in_val`. The segments shorter than `k`
+ *   are padded with the upper (lower) bound of `T`, if `select_min` (otherwise).
+ *   If all the segments are empty, all the outputs are the padding value.
+ * @param[out] out_idx
+ *   output payload (e.g. indices) [batch_size, k];
+ *   the payload selected together with `out_val`.
+ *   If all the segments are empty, it is filled with `std::numeric_limits<IdxT>::max()`.
+ * @param[in] select_min
+ *   whether to select k smallest (true) or largest (false) keys.
+ * @param[in] sorted
+ *   whether to make sure selected pairs are sorted by value
+ * @param[in] algo
+ *   the selection algorithm to use for all the buckets, or `SelectAlgo::kAuto` to choose it for
+ *   each bucket.
+ */
+template <typename T, typename IdxT>
+void segmented_select_k(raft::resources const& handle,
+                        raft::device_vector_view<const T, int64_t> in_val,
+                        std::optional<raft::device_vector_view<const IdxT, int64_t>> in_idx,
+                        raft::device_vector_view<const IdxT, int64_t> offsets,
+                        raft::device_matrix_view<T, int64_t, row_major> out_val,
+                        raft::device_matrix_view<IdxT, int64_t, row_major> out_idx,
+                        bool select_min,
+                        bool sorted     = false,
+                        SelectAlgo algo = SelectAlgo::kAuto)
+{
+  RAFT_EXPECTS(out_val.extent(1) <= int64_t(std::numeric_limits<int>::max()),
+               "output k must fit the int type.");
+  RAFT_EXPECTS(offsets.extent(0) > 0, "offsets must contain at least one element");
+  auto batch_size = offsets.extent(0) - 1;
+  auto k          = int(out_val.extent(1));
+  RAFT_EXPECTS(batch_size == out_val.extent(0), "batch sizes must be equal");
+  RAFT_EXPECTS(batch_size == out_idx.extent(0), "batch sizes must be equal");
+  if (in_idx.has_value()) {
+    RAFT_EXPECTS(in_val.extent(0) == in_idx->extent(0),
+                 "value and index input lengths must be equal");
+  }
+  RAFT_EXPECTS(int64_t(k) == out_idx.extent(1), "value and index output lengths must be equal");
+
+  return detail::segmented_select_k<T, IdxT>(handle,
+                                             in_val.data_handle(),
+                                             in_idx.has_value() ? in_idx->data_handle() : nullptr,
+                                             offsets.data_handle(),
+                                             batch_size,
+                                             k,
+                                             out_val.data_handle(),
+                                             out_idx.data_handle(),
+                                             select_min,
+                                             sorted,
+                                             algo);
+}
+
+/** @} */  // end of group select_k
+
+}  // namespace raft::matrix
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/segmented_sort.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resources.hpp>
+
+#include <optional>
+
+namespace raft::matrix {
+
+/**
+ * @defgroup segmented_sort Sort segments or rows of an array
+ * @{
+ */
+
+/**
+ * @brief Sort the keys of each row of a row-major matrix, together with their values.
+ *
+ * The algorithm is chosen after the length of the rows: rows up to 256 elements are sorted by a
+ * single warp (merge sort), rows up to 4096 elements by a thread block (radix sort in shared
+ * memory), and longer rows with cub::DeviceSegmentedSort. The sort is stable and NaN keys are not
+ * supported.
+ *
+ * Example usage
+ * @code{.cpp}
+ *   // sort the distances of each row and get the permuted neighbor ids
+ *   raft::matrix::segmented_sort<float, int64_t>(
+ *     handle, distances, neighbors, sorted_distances.view(), sorted_neighbors.view());
+ *   // sort the distances of each row and get their position in the row
+ *   raft::matrix::segmented_sort<float, int>(
+ *     handle, distances, std::nullopt, sorted_distances.view(), positions.view());
+ * @endcode
+ *
+ * @tparam KeyT the type of the keys (what is being compared).
+ * @tparam ValT the type of the values (what is moved together with the keys).
+ *
+ * @param[in] handle container of reusable resources
+ * @param[in] in_keys input keys [n_rows, n_cols]
+ * @param[in] in_vals optional input values [n_rows, n_cols]. If `std::nullopt`, the values are
+ *   the positions of the keys in their row.
+ * @param[out] out_keys sorted keys [n_rows, n_cols], must not overlap `in_keys`
+ * @param[out] out_vals optional values of the sorted keys [n_rows, n_cols]
+ * @param[in] ascending whether to sort the keys in ascending or descending order
+ */
+template <typename KeyT, typename ValT>
+void segmented_sort(raft::resources const& handle,
+                    raft::device_matrix_view<const KeyT, int64_t, row_major> in_keys,
+                    std::optional<raft::device_matrix_view<const ValT, int64_t, row_major>> in_vals,
+                    raft::device_matrix_view<KeyT, int64_t, row_major> out_keys,
+                    std::optional<raft::device_matrix_view<ValT, int64_t, row_major>> out_vals,
+                    bool ascending = true)
+{
+  RAFT_EXPECTS(in_keys.extent(0) == out_keys.extent(0) && in_keys.extent(1) == out_keys.extent(1),
+               "Input and output keys must have the same shape.");
+  if (in_vals.has_value()) {
+    RAFT_EXPECTS(in_vals->extent(0) == in_keys.extent(0) &&
+                   in_vals->extent(1) == in_keys.extent(1),
+                 "Input keys and values must have the same shape.");
+  }
+  if (out_vals.has_value()) {
+    RAFT_EXPECTS(out_vals->extent(0) == in_keys.extent(0) &&
+                   out_vals->extent(1) == in_keys.extent(1),
+                 "Input keys and output values must have the same shape.");
+  }
+
+  detail::sort_rows<KeyT, ValT>(handle,
+                                in_keys.data_handle(),
+                                in_vals.has_value() ? in_vals->data_handle() : nullptr,
+                                out_keys.data_handle(),
+                                out_vals.has_value() ? out_vals->data_handle() : nullptr,
+                                in_keys.extent(0),
+                                in_keys.extent(1),
+                                ascending);
+}
+
+/**
+ * @brief Sort the keys of each segment of an array, together with their values.
+ *
+ * The input is a concatenation of segments of arbitrary lengths, the segment `i` being
+ * `in_keys[offsets[i]:offsets[i + 1]]` (CSR-style offsets). The segments are sorted with
+ * cub::DeviceSegmentedSort, which chooses the algorithm after the length of each segment.
+ * The sort is stable.
+ *
+ * @tparam KeyT the type of the keys (what is being compared).
+ * @tparam ValT the type of the values (what is moved together with the keys).
+ * @tparam OffsetT the type of the offsets.
+ *
+ * @param[in] handle container of reusable resources
+ * @param[in] in_keys input keys [n_items]
+ * @param[in] in_vals optional input values [n_items]; `out_vals` must be given with them.
+ * @param[in] offsets the offsets of the segments [n_segments + 1]
+ * @param[out] out_keys sorted keys [n_items], must not overlap `in_keys`
+ * @param[out] out_vals optional values of the sorted keys [n_items]
+ * @param[in] ascending whether to sort the keys in ascending or descending order
+ */
+template <typename KeyT, typename ValT, typename OffsetT>
+void segmented_sort(raft::resources const& handle,
+                    raft::device_vector_view<const KeyT, int64_t> in_keys,
+                    std::optional<raft::device_vector_view<const ValT, int64_t>> in_vals,
+                    raft::device_vector_view<const OffsetT, int64_t> offsets,
+                    raft::device_vector_view<KeyT, int64_t> out_keys,
+                    std::optional<raft::device_vector_view<ValT, int64_t>> out_vals,
+                    bool ascending = true)
+{
+  RAFT_EXPECTS(offsets.extent(0) > 0, "offsets must contain at least one element");
+  RAFT_EXPECTS(in_keys.extent(0) == out_keys.extent(0),
+               "Input and output keys must have the same size.");
+  RAFT_EXPECTS(in_vals.has_value() == out_vals.has_value(),
+               "Values must be given both as input and as output, or not at all.");
+  if (in_vals.has_value()) {
+    RAFT_EXPECTS(in_vals->extent(0) == in_keys.extent(0) &&
+                   out_vals->extent(0) == in_keys.extent(0),
+                 "Keys and values must have the same size.");
+  }
+
+  detail::segmented_sort<KeyT, ValT, OffsetT>(
+    handle,
+    in_keys.data_handle(),
+    in_vals.has_value() ? in_vals->data_handle() : nullptr,
+    out_keys.data_handle(),
+    out_vals.has_value() ? out_vals->data_handle() : nullptr,
+    in_keys.extent(0),
+    offsets.data_handle(),
+    offsets.extent(0) - 1,
+    ascending);
+}
+
+/** @} */  // end of group segmented_sort
+
+}  // namespace raft::matrix
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "detail/select_k-inl.cuh"
+#include "detail/topk_accumulator.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/init.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cstdint>
+#include <optional>
+
+namespace raft::matrix {
+
+/**
+ * @addtogroup select_k
+ * @{
+ */
+
+/**
+ * @brief A running top-k of every row, merged with the candidates arriving in chunks.
+ *
+ * The candidates of the rows may be produced over time (tiles of a distance matrix, shards,
+ * streaming batches). Instead of keeping all the chunks for one final merge, each `push` selects
+ * the top-k of a chunk and merges it into the state of the accumulator right away. Hence the state
+ * is O(k) per row regardless of the number of chunks, and every candidate is read exactly once.
+ *
+ * The slots not yet filled by the candidates hold the upper (lower) bound of `T` if `select_min`
+ * (otherwise), and the index `upper_bound<IdxT>()`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft;
+ *   matrix::topk_accumulator<float, int64_t> acc(handle, n_queries, k, true);
+ *   for (int64_t offset = 0; offset < n_rows; offset += tile_rows) {
+ *     // the distances from the queries to the rows [offset, offset + tile_rows)
+ *     auto tile = {... device_matrix_view<const float, int64_t, row_major> ...};
+ *     acc.push(handle, tile, std::nullopt, offset);
+ *   }
+ *   acc.finalize(handle, distances.view(), neighbors.view());
+ * @endcode
+ *
+ * @tparam T the type of the keys (what is being compared).
+ * @tparam IdxT the index type (what is being selected together with the keys).
+ */
+template <typename T, typename IdxT>
+class topk_accumulator {
+ public:
+  /**
+   * @param[in] res raft resources
+   * @param[in] n_rows the number of rows
+   * @param[in] k the number of key/values kept per row
+   * @param[in] select_min whether to keep k smallest (true) or largest (false) keys.
+   */
+  topk_accumulator(raft::resources const& res, int64_t n_rows, int k, bool select_min)
+    : n_rows_(n_rows),
+      k_(k),
+      select_min_(select_min),
+      cand_val_(make_device_matrix<T, int64_t>(res, n_rows, 2 * int64_t(k))),
+      cand_idx_(make_device_matrix<IdxT, int64_t>(res, n_rows, 2 * int64_t(k))),
+      tmp_val_(make_device_matrix<T, int64_t>(res, n_rows, k)),
+      tmp_idx_(make_device_matrix<IdxT, int64_t>(res, n_rows, k))
+  {
+    RAFT_EXPECTS(k > 0, "k must be positive");
+    reset(res);
+  }
+
+  /** The number of rows. */
+  [[nodiscard]] auto n_rows() const noexcept -> int64_t { return n_rows_; }
+  /** The number of key/values kept per row. */
+  [[nodiscard]] auto k() const noexcept -> int { return k_; }
+  /** Whether the smallest (true) or the largest (false) keys are kept. */
+  [[nodiscard]] auto select_min() const noexcept -> bool { return select_min_; }
+
+  /** Forget all the candidates pushed so far. */
+  void reset(raft::resources const& res)
+  {
+    raft::matrix::fill(res, cand_val_.view(), dummy_val());
+    raft::matrix::fill(res, cand_idx_.view(), dummy_idx());
+    empty_ = true;
+  }
+
+  /**
+   * Merge a chunk of candidates into the running top-k.
+   *
+   * @param[in] res raft resources
+   * @param[in] chunk_val the candidate keys [n_rows, len]; `len` may differ between the chunks.
+   * @param[in] chunk_idx optional candidate values [n_rows, len]. If `std::nullopt`, the value of
+   *   a candidate is its column in the chunk plus the `index_offset`.
+   * @param[in] index_offset the value added to the columns of the chunk, when `chunk_idx` is
+   *   `std::nullopt`
+   */
+  void push(raft::resources const& res,
+            raft::device_matrix_view<const T, int64_t, row_major> chunk_val,
+            std::optional<raft::device_matrix_view<const IdxT, int64_t, row_major>> chunk_idx =
+              std::nullopt,
+            IdxT index_offset = 0)
+  {
+    const int64_t len = chunk_val.extent(1);
+    common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+      "matrix::topk_accumulator::push(%zu, %zu, k = %d)", size_t(n_rows_), size_t(len), k_);
+    RAFT_EXPECTS(chunk_val.extent(0) == n_rows_, "Number of rows in the chunk must match");
+    if (chunk_idx.has_value()) {
+      RAFT_EXPECTS(chunk_idx->extent(0) == n_rows_ && chunk_idx->extent(1) == len,
+                   "The shapes of the chunk keys and values must match");
+    }
+    if (len == 0) { return; }
+
+    // The top-k of the chunk are written next to the running top-k (or in place of it, if empty).
+    const int64_t ld  = 2 * int64_t(k_);
+    T* dst_val        = cand_val_.data_handle() + (empty_ ? 0 : k_);
+    IdxT* dst_idx     = cand_idx_.data_handle() + (empty_ ? 0 : k_);
+    const IdxT offset = chunk_idx.has_value() ? IdxT(0) : index_offset;
+    if (len <= k_) {
+      detail::copy_topk_candidates(res,
+                                   chunk_val.data_handle(),
+                                   chunk_idx.has_value() ? chunk_idx->data_handle() : nullptr,
+                                   n_rows_,
+                                   len,
+                                   offset,
+                                   dst_val,
+                                   dst_idx,
+                                   ld,
+                                   k_,
+                                   dummy_val(),
+                                   dummy_idx());
+    } else {
+      raft::matrix::select_k<T, IdxT>(res,
+                                      chunk_val,
+                                      chunk_idx,
+                                      tmp_val_.view(),
+                                      tmp_idx_.view(),
+                                      select_min_,
+                                      false);
+      detail::copy_topk_candidates(res,
+                                   tmp_val_.data_handle(),
+                                   tmp_idx_.data_handle(),
+                                   n_rows_,
+                                   int64_t(k_),
+                                   offset,
+                                   dst_val,
+                                   dst_idx,
+                                   ld,
+                                   k_,
+                                   dummy_val(),
+                                   dummy_idx());
+    }
+    if (empty_) {
+      empty_ = false;
+      return;
+    }
+
+    // Merge the 2k candidates of every row back into the first k columns
+    raft::matrix::select_k<T, IdxT>(res,
+                                    raft::make_const_mdspan(cand_val_.view()),
+                                    raft::make_const_mdspan(cand_idx_.view()),
+                                    tmp_val_.view(),
+                                    tmp_idx_.view(),
+                                    select_min_,
+                                    false);
+    detail::copy_topk_candidates(res,
+                                 tmp_val_.data_handle(),
+                                 tmp_idx_.data_handle(),
+                                 n_rows_,
+                                 int64_t(k_),
+                                 IdxT(0),
+                                 cand_val_.data_handle(),
+                                 cand_idx_.data_handle(),
+                                 ld,
+                                 k_,
+                                 dummy_val(),
+                                 dummy_idx());
+  }
+
+  /**
+   * Write the running top-k of every row, sorted by key. The accumulator is not modified, so
+   * it can be finalized again after more chunks are pushed.
+   *
+   * @param[in] res raft resources
+   * @param[out] out_val the top-k keys [n_rows, k]
+   * @param[out] out_idx the values of the top-k keys [n_rows, k]
+   */
+  void finalize(raft::resources const& res,
+                raft::device_matrix_view<T, int64_t, row_major> out_val,
+                raft::device_matrix_view<IdxT, int64_t, row_major> out_idx) const
+  {
+    RAFT_EXPECTS(out_val.extent(0) == n_rows_ && out_val.extent(1) == k_,
+                 "The output keys must be a [n_rows, k] matrix");
+    RAFT_EXPECTS(out_idx.extent(0) == n_rows_ && out_idx.extent(1) == k_,
+                 "The output values must be a [n_rows, k] matrix");
+    auto stream = resource::get_cuda_stream(res);
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(out_val.data_handle(),
+                                    sizeof(T) * k_,
+                                    cand_val_.data_handle(),
+                                    sizeof(T) * 2 * k_,
+                                    sizeof(T) * k_,
+                                    n_rows_,
+                                    cudaMemcpyDeviceToDevice,
+                                    stream));
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(out_idx.data_handle(),
+                                    sizeof(IdxT) * k_,
+                                    cand_idx_.data_handle(),
+                                    sizeof(IdxT) * 2 * k_,
+                                    sizeof(IdxT) * k_,
+                                    n_rows_,
+                                    cudaMemcpyDeviceToDevice,
+                                    stream));
+    detail::sort_rows<T, IdxT>(
+      res, out_val.data_handle(), out_idx.data_handle(), n_rows_, k_, select_min_);
+  }
+
+ private:
+  int64_t n_rows_;
+  int k_;
+  bool select_min_;
+  bool empty_ = true;
+  // [n_rows, 2k]: the running top-k in the first k columns, the candidates of a chunk next to it
+  device_matrix<T, int64_t> cand_val_;
+  device_matrix<IdxT, int64_t> cand_idx_;
+  // [n_rows, k]: the top-k of a chunk, then the merged top-k
+  device_matrix<T, int64_t> tmp_val_;
+  device_matrix<IdxT, int64_t> tmp_idx_;
+
+  [[nodiscard]] auto dummy_val() const -> T
+  {
+    return select_min_ ? upper_bound<T>() : lower_bound<T>();
+  }
+  [[nodiscard]] static auto dummy_idx() -> IdxT { return upper_bound<IdxT>(); }
+};
+
+/** @} */
+
+}  // namespace raft::matrix
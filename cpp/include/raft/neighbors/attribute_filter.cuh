@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+
+namespace raft::neighbors::filtering {
+
+/**
+ * @brief A clause of an `attribute_filter`: a range or a set of categories of one attribute.
+ */
+struct attribute_clause {
+  /** The maximum category id accepted by a category clause. */
+  static constexpr int64_t kMaxCategories = 256;
+
+  enum class kind : uint32_t { kRange = 0, kCategories = 1 };
+
+  uint32_t column;
+  kind type;
+  // kRange: the closed range [lo, hi]
+  int64_t lo;
+  int64_t hi;
+  // kCategories: the bitmask of the accepted categories [0, kMaxCategories)
+  uint64_t categories[kMaxCategories / 64];
+
+  inline _RAFT_HOST_DEVICE bool test(int64_t value) const
+  {
+    if (type == kind::kRange) { return lo <= value && value <= hi; }
+    if (value < 0 || value >= kMaxCategories) { return false; }
+    return (categories[value / 64] >> (value % 64)) & 1ull;
+  }
+};
+
+/**
+ * @brief Filter the samples by a conjunction of predicates on their attributes.
+ *
+ * The attributes are the columns of an `attribute_store` (one `int64_t` per sample). The predicate
+ * is evaluated inline by the search kernels, so no per-query bitset has to be prepared before the
+ * search; this matters for the filters that change with every batch, e.g. "the last 7 days" on a
+ * timestamp column.
+ *
+ * The filter is a two-argument sample filter, like `bitset_filter`: it is passed to
+ * `cagra::search_with_filtering` directly, and to the IVF searches through `ivf_to_sample_filter`.
+ * Being a new filter type, it requires the searches to be instantiated in the translation unit of
+ * the caller (i.e. the header-only mode), the same as any user-defined filter.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   filtering::attribute_store attrs(res, n_samples, 2);
+ *   attrs.update_column(res, 0, timestamps);  // device_vector_view<const int64_t, int64_t>
+ *   attrs.update_column(res, 1, categories);
+ *   auto filter = attrs.filter().and_range(0, now - 7 * 86400, now).and_categories(1, {3, 5});
+ *   cagra::search_with_filtering(res, search_params, index, queries, neighbors, distances, filter);
+ * @endcode
+ */
+struct attribute_filter {
+  static constexpr uint32_t kMaxClauses = 8;
+
+  // The columns of the attribute store [n_columns, n_samples]
+  const int64_t* columns;
+  int64_t n_samples;
+  uint32_t n_columns;
+  uint32_t n_clauses;
+  attribute_clause clauses[kMaxClauses];
+
+  /** Keep the samples whose attribute `column` is within [lo, hi]. */
+  auto and_range(uint32_t column, int64_t lo, int64_t hi) -> attribute_filter&
+  {
+    auto& c = add_clause(column, attribute_clause::kind::kRange);
+    c.lo    = lo;
+    c.hi    = hi;
+    return *this;
+  }
+
+  /** Keep the samples whose attribute `column` is one of the `categories`. */
+  auto and_categories(uint32_t column, std::initializer_list<int64_t> categories)
+    -> attribute_filter&
+  {
+    auto& c = add_clause(column, attribute_clause::kind::kCategories);
+    for (auto v : categories) {
+      RAFT_EXPECTS(0 <= v && v < attribute_clause::kMaxCategories,
+                   "The category ids must be in [0, %zu)",
+                   size_t(attribute_clause::kMaxCategories));
+      c.categories[v / 64] |= 1ull << (v % 64);
+    }
+    return *this;
+  }
+
+  inline _RAFT_HOST_DEVICE bool operator()(
+    // query index
+    const uint32_t query_ix,
+    // the index of the current sample
+    const uint32_t sample_ix) const
+  {
+    for (uint32_t i = 0; i < n_clauses; i++) {
+      const auto& c = clauses[i];
+      if (!c.test(columns[c.column * n_samples + sample_ix])) { return false; }
+    }
+    return true;
+  }
+
+ private:
+  auto add_clause(uint32_t column, attribute_clause::kind type) -> attribute_clause&
+  {
+    RAFT_EXPECTS(n_clauses < kMaxClauses, "At most %u clauses are supported", kMaxClauses);
+    RAFT_EXPECTS(column < n_columns, "No attribute column %u", column);
+    auto& c = clauses[n_clauses++];
+    c       = attribute_clause{column, type, 0, 0, {}};
+    return c;
+  }
+};
+
+/**
+ * @brief The columnar attributes of the samples of an index, in the device memory.
+ *
+ * The store holds `n_columns` columns of `int64_t`, one value per sample id of the index it is
+ * paired with: int ranges, category ids and timestamps are all stored as `int64_t`.
+ */
+class attribute_store {
+ public:
+  attribute_store(raft::resources const& res, int64_t n_samples, uint32_t n_columns)
+    : columns_(raft::make_device_matrix<int64_t, int64_t>(res, n_columns, n_samples))
+  {
+  }
+
+  [[nodiscard]] auto n_samples() const noexcept -> int64_t { return columns_.extent(1); }
+  [[nodiscard]] auto n_columns() const noexcept -> uint32_t { return columns_.extent(0); }
+
+  /** The values of the column [n_samples]. */
+  auto column(uint32_t i) noexcept -> raft::device_vector_view<int64_t, int64_t>
+  {
+    return raft::make_device_vector_view<int64_t, int64_t>(
+      columns_.data_handle() + i * n_samples(), n_samples());
+  }
+
+  /** Copy the values [n_samples] to the column `i`. */
+  void update_column(raft::resources const& res,
+                     uint32_t i,
+                     raft::device_vector_view<const int64_t, int64_t> values)
+  {
+    RAFT_EXPECTS(i < n_columns(), "No attribute column %u", i);
+    RAFT_EXPECTS(values.extent(0) == n_samples(), "The column must have one value per sample");
+    raft::copy(column(i).data_handle(),
+               values.data_handle(),
+               n_samples(),
+               resource::get_cuda_stream(res));
+  }
+
+  /** A filter that accepts every sample; narrow it with `and_range` / `and_categories`. */
+  [[nodiscard]] auto filter() const -> attribute_filter
+  {
+    return attribute_filter{columns_.data_handle(), n_samples(), n_columns(), 0, {}};
+  }
+
+ private:
+  raft::device_matrix<int64_t, int64_t, raft::row_major> columns_;
+};
+
+}  // namespace raft::neighbors::filtering
@@ -29,6 +29,11 @@ template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_
 void build_index(raft::resources const& handle,
                  BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index) RAFT_EXPLICIT;
 
+template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
+void extend(raft::resources const& handle,
+            BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index,
+            raft::device_matrix_view<const value_t, matrix_idx_t, row_major> X) RAFT_EXPLICIT;
+
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
 void all_knn_query(raft::resources const& handle,
                    BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index,
@@ -36,7 +41,8 @@ void all_knn_query(raft::resources const& handle,
                    idx_t* inds,
                    value_t* dists,
                    bool perform_post_filtering = true,
-                   float weight                = 1.0) RAFT_EXPLICIT;
+                   float weight                = 1.0,
+                   int_t n_probes              = 0) RAFT_EXPLICIT;
 
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
 void all_knn_query(raft::resources const& handle,
@@ -45,7 +51,8 @@ void all_knn_query(raft::resources const& handle,
                    raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,
                    int_t k,
                    bool perform_post_filtering = true,
-                   float weight                = 1.0) RAFT_EXPLICIT;
+                   float weight                = 1.0,
+                   int_t n_probes              = 0) RAFT_EXPLICIT;
 
 template <typename idx_t, typename value_t, typename int_t>
 void knn_query(raft::resources const& handle,
@@ -56,7 +63,8 @@ void knn_query(raft::resources const& handle,
                idx_t* inds,
                value_t* dists,
                bool perform_post_filtering = true,
-               float weight                = 1.0) RAFT_EXPLICIT;
+               float weight                = 1.0,
+               int_t n_probes              = 0) RAFT_EXPLICIT;
 
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
 void knn_query(raft::resources const& handle,
@@ -66,7 +74,8 @@ void knn_query(raft::resources const& handle,
                raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,
                int_t k,
                bool perform_post_filtering = true,
-               float weight                = 1.0) RAFT_EXPLICIT;
+               float weight                = 1.0,
+               int_t n_probes              = 0) RAFT_EXPLICIT;
 
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
 void eps_nn(raft::resources const& handle,
@@ -97,6 +106,11 @@ void eps_nn(raft::resources const& handle,
     raft::resources const& handle,                                                                 \
     raft::neighbors::ball_cover::BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index);      \
                                                                                                    \
+  extern template void raft::neighbors::ball_cover::extend<idx_t, value_t, int_t, matrix_idx_t>(   \
+    raft::resources const& handle,                                                                 \
+    raft::neighbors::ball_cover::BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index,       \
+    raft::device_matrix_view<const value_t, matrix_idx_t, row_major> X);                           \
+                                                                                                   \
   extern template void                                                                             \
   raft::neighbors::ball_cover::all_knn_query<idx_t, value_t, int_t, matrix_idx_t>(                 \
     raft::resources const& handle,                                                                 \
@@ -105,7 +119,8 @@ void eps_nn(raft::resources const& handle,
     idx_t* inds,                                                                                   \
     value_t* dists,                                                                                \
     bool perform_post_filtering,                                                                   \
-    float weight);                                                                                 \
+    float weight,                                                                                  \
+    int_t n_probes);                                                                               \
                                                                                                    \
   extern template void raft::neighbors::ball_cover::eps_nn<idx_t, value_t, int_t, matrix_idx_t>(   \
     raft::resources const& handle,                                                                 \
@@ -133,7 +148,8 @@ void eps_nn(raft::resources const& handle,
     raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,                              \
     int_t k,                                                                                       \
     bool perform_post_filtering,                                                                   \
-    float weight);                                                                                 \
+    float weight,                                                                                  \
+    int_t n_probes);                                                                               \
                                                                                                    \
   extern template void raft::neighbors::ball_cover::knn_query<idx_t, value_t, int_t>(              \
     raft::resources const& handle,                                                                 \
@@ -144,7 +160,8 @@ void eps_nn(raft::resources const& handle,
     idx_t* inds,                                                                                   \
     value_t* dists,                                                                                \
     bool perform_post_filtering,                                                                   \
-    float weight);                                                                                 \
+    float weight,                                                                                  \
+    int_t n_probes);                                                                               \
                                                                                                    \
   extern template void                                                                             \
   raft::neighbors::ball_cover::knn_query<idx_t, value_t, int_t, matrix_idx_t>(                     \
@@ -155,7 +172,8 @@ void eps_nn(raft::resources const& handle,
     raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,                              \
     int_t k,                                                                                       \
     bool perform_post_filtering,                                                                   \
-    float weight);
+    float weight,
+    int_t n_probes);
 
 instantiate_raft_neighbors_ball_cover(int64_t, float, int64_t, int64_t);
 
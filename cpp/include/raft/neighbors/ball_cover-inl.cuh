@@ -78,6 +78,53 @@ void build_index(raft::resources const& handle,
   index.set_index_trained();
 }
 
+/**
+ * Adds points to a built BallCoverIndex, keeping its landmarks.
+ *
+ * The index does not own its points: `X` holds the points of the index, followed by the new ones,
+ * and it replaces them in the index. The new points are assigned to their closest landmark and the
+ * radii of the landmarks grow accordingly, so the queries stay exact. As the number of landmarks
+ * does not change, the queries get slower when many points are added, in which case the index
+ * should rather be built again.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *
+ *  #include <raft/core/resources.hpp>
+ *  #include <raft/neighbors/ball_cover.cuh>
+ *  #include <raft/distance/distance_types.hpp>
+ *  using namespace raft::neighbors;
+ *
+ *  raft::resources handle;
+ *  ...
+ *  auto metric = raft::distance::DistanceType::L2Expanded;
+ *  // an index over the first m0 rows of X
+ *  BallCoverIndex index(handle, raft::make_device_matrix_view<const float, int64_t>(
+ *    X.data_handle(), m0, X.extent(1)), metric);
+ *  ball_cover::build_index(handle, index);
+ *  // add the other rows of X
+ *  ball_cover::extend(handle, index, raft::make_const_mdspan(X.view()));
+ * @endcode
+ *
+ * @tparam idx_t knn index type
+ * @tparam value_t knn value type
+ * @tparam int_t integral type for knn params
+ * @tparam matrix_idx_t matrix indexing type
+ * @param[in] handle library resource management handle
+ * @param[inout] index a built instance of BallCoverIndex
+ * @param[in] X the points of the index followed by the new ones [index.m + n_new, index.n]
+ */
+template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
+void extend(raft::resources const& handle,
+            BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index,
+            raft::device_matrix_view<const value_t, matrix_idx_t, row_major> X)
+{
+  RAFT_EXPECTS(index.is_index_trained(), "The index must be built before it is extended");
+  RAFT_EXPECTS(X.extent(1) == index.n, "The new points must have the dimensions of the index");
+  RAFT_EXPECTS(X.extent(0) >= index.m, "X must hold the points of the index, then the new ones");
+  raft::spatial::knn::detail::rbc_extend(handle, index, X);
+}
+
 /** @} */  // end group random_ball_cover
 
 /**
@@ -107,6 +154,12 @@ void build_index(raft::resources const& handle,
  *               based on how many relevant balls are ignored. Note that
  *               many datasets can still have great recall even by only
  *               looking in the closest landmark.
+ * @param[in] n_probes if positive, an approximate search is performed instead:
+ *               only the n_probes landmarks closest to each query (this
+ *               many balls at most) are searched, in order of increasing
+ *               distance, and the post-filtering is skipped. This trades
+ *               recall for speed when the exact results are not needed.
+ *               0 (default) performs the exact search.
  */
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
 void all_knn_query(raft::resources const& handle,
@@ -115,9 +168,11 @@ void all_knn_query(raft::resources const& handle,
                    idx_t* inds,
                    value_t* dists,
                    bool perform_post_filtering = true,
-                   float weight                = 1.0)
+                   float weight                = 1.0,
+                   int_t n_probes              = 0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
+  ASSERT(index.n <= 3 || index.metric != raft::distance::DistanceType::Haversine,
+         "only 2d and 3d vectors are supported with the haversine distance");
   if (index.metric == raft::distance::DistanceType::Haversine) {
     raft::spatial::knn::detail::rbc_all_knn_query(
       handle,
@@ -127,7 +182,8 @@ void all_knn_query(raft::resources const& handle,
       dists,
       spatial::knn::detail::HaversineFunc<value_t, int_t>(),
       perform_post_filtering,
-      weight);
+      weight,
+      n_probes);
   } else if (index.metric == raft::distance::DistanceType::L2SqrtExpanded ||
              index.metric == raft::distance::DistanceType::L2SqrtUnexpanded) {
     raft::spatial::knn::detail::rbc_all_knn_query(
@@ -138,7 +194,8 @@ void all_knn_query(raft::resources const& handle,
       dists,
       spatial::knn::detail::EuclideanFunc<value_t, int_t>(),
       perform_post_filtering,
-      weight);
+      weight,
+      n_probes);
   } else {
     RAFT_FAIL("Metric not supported");
   }
@@ -200,6 +257,12 @@ void all_knn_query(raft::resources const& handle,
  *               based on how many relevant balls are ignored. Note that
  *               many datasets can still have great recall even by only
  *               looking in the closest landmark.
+ * @param[in] n_probes if positive, an approximate search is performed instead:
+ *               only the n_probes landmarks closest to each query (this
+ *               many balls at most) are searched, in order of increasing
+ *               distance, and the post-filtering is skipped. This trades
+ *               recall for speed when the exact results are not needed.
+ *               0 (default) performs the exact search.
  */
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
 void all_knn_query(raft::resources const& handle,
@@ -208,9 +271,9 @@ void all_knn_query(raft::resources const& handle,
                    raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,
                    int_t k,
                    bool perform_post_filtering = true,
-                   float weight                = 1.0)
+                   float weight                = 1.0,
+                   int_t n_probes              = 0)
 {
-  RAFT_EXPECTS(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
   RAFT_EXPECTS(k <= index.m,
                "k must be less than or equal to the number of data points in the index");
   RAFT_EXPECTS(inds.extent(1) == dists.extent(1) && dists.extent(1) == static_cast<matrix_idx_t>(k),
@@ -220,8 +283,14 @@ void all_knn_query(raft::resources const& handle,
                "Number of rows in output indices and distances matrices must equal number of rows "
                "in index matrix.");
 
-  all_knn_query(
-    handle, index, k, inds.data_handle(), dists.data_handle(), perform_post_filtering, weight);
+  all_knn_query(handle,
+                index,
+                k,
+                inds.data_handle(),
+                dists.data_handle(),
+                perform_post_filtering,
+                weight,
+                n_probes);
 }
 
 /** @} */
@@ -253,6 +322,12 @@ void all_knn_query(raft::resources const& handle,
  *               based on how many relevant balls are ignored. Note that
  *               many datasets can still have great recall even by only
  *               looking in the closest landmark.
+ * @param[in] n_probes if positive, an approximate search is performed instead:
+ *               only the n_probes landmarks closest to each query (this
+ *               many balls at most) are searched, in order of increasing
+ *               distance, and the post-filtering is skipped. This trades
+ *               recall for speed when the exact results are not needed.
+ *               0 (default) performs the exact search.
  * @param[in] n_query_pts number of query points
  */
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx = std::int64_t>
@@ -264,9 +339,11 @@ void knn_query(raft::resources const& handle,
                idx_t* inds,
                value_t* dists,
                bool perform_post_filtering = true,
-               float weight                = 1.0)
+               float weight                = 1.0,
+               int_t n_probes              = 0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
+  ASSERT(index.n <= 3 || index.metric != raft::distance::DistanceType::Haversine,
+         "only 2d and 3d vectors are supported with the haversine distance");
   if (index.metric == raft::distance::DistanceType::Haversine) {
     raft::spatial::knn::detail::rbc_knn_query(handle,
                                               index,
@@ -277,7 +354,8 @@ void knn_query(raft::resources const& handle,
                                               dists,
                                               spatial::knn::detail::HaversineFunc<value_t, int_t>(),
                                               perform_post_filtering,
-                                              weight);
+                                              weight,
+                                              n_probes);
   } else if (index.metric == raft::distance::DistanceType::L2SqrtExpanded ||
              index.metric == raft::distance::DistanceType::L2SqrtUnexpanded) {
     raft::spatial::knn::detail::rbc_knn_query(handle,
@@ -289,7 +367,8 @@ void knn_query(raft::resources const& handle,
                                               dists,
                                               spatial::knn::detail::EuclideanFunc<value_t, int_t>(),
                                               perform_post_filtering,
-                                              weight);
+                                              weight,
+                                              n_probes);
   } else {
     RAFT_FAIL("Metric not supported");
   }
@@ -450,6 +529,12 @@ void eps_nn(raft::resources const& handle,
  *               based on how many relevant balls are ignored. Note that
  *               many datasets can still have great recall even by only
  *               looking in the closest landmark.
+ * @param[in] n_probes if positive, an approximate search is performed instead:
+ *               only the n_probes landmarks closest to each query (this
+ *               many balls at most) are searched, in order of increasing
+ *               distance, and the post-filtering is skipped. This trades
+ *               recall for speed when the exact results are not needed.
+ *               0 (default) performs the exact search.
  */
 template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
 void knn_query(raft::resources const& handle,
@@ -459,7 +544,8 @@ void knn_query(raft::resources const& handle,
                raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,
                int_t k,
                bool perform_post_filtering = true,
-               float weight                = 1.0)
+               float weight                = 1.0,
+               int_t n_probes              = 0)
 {
   RAFT_EXPECTS(k <= index.m,
                "k must be less than or equal to the number of data points in the index");
@@ -481,7 +567,8 @@ void knn_query(raft::resources const& handle,
             inds.data_handle(),
             dists.data_handle(),
             perform_post_filtering,
-            weight);
+            weight,
+            n_probes);
 }
 
 /** @} */
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/ball_cover_serialize.cuh"
+
+namespace raft::neighbors::ball_cover {
+
+/**
+ * \defgroup ball_cover_serialize Random Ball Cover Serialize
+ * @{
+ */
+
+/**
+ * Write the index to an output stream
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * The index does not own its points, which are not saved; the points reordered by landmark are.
+ *
+ * @code{.cpp}
+ * #include <raft/core/resources.hpp>
+ *
+ * raft::resources handle;
+ *
+ * // create an output stream
+ * std::ostream os(std::cout.rdbuf());
+ * // create an index with `BallCoverIndex index(handle, X, metric);`
+ * // and `ball_cover::build_index(handle, index);`
+ * raft::neighbors::ball_cover::serialize(handle, os, index);
+ * @endcode
+ *
+ * @tparam idx_t knn index type
+ * @tparam value_t knn value type
+ * @tparam int_t integral type for knn params
+ * @tparam matrix_idx_t matrix indexing type
+ *
+ * @param[in] handle the raft handle
+ * @param[in] os output stream
+ * @param[in] index a built ball cover index
+ */
+template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
+void serialize(raft::resources const& handle,
+               std::ostream& os,
+               const BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index)
+{
+  detail::serialize(handle, os, index);
+}
+
+/**
+ * Save the index to file.
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * @code{.cpp}
+ * #include <raft/core/resources.hpp>
+ *
+ * raft::resources handle;
+ *
+ * // create a string with a filepath
+ * std::string filename("/path/to/index");
+ * // create an index with `BallCoverIndex index(handle, X, metric);`
+ * // and `ball_cover::build_index(handle, index);`
+ * raft::neighbors::ball_cover::serialize(handle, filename, index);
+ * @endcode
+ *
+ * @tparam idx_t knn index type
+ * @tparam value_t knn value type
+ * @tparam int_t integral type for knn params
+ * @tparam matrix_idx_t matrix indexing type
+ *
+ * @param[in] handle the raft handle
+ * @param[in] filename the file name for saving the index
+ * @param[in] index a built ball cover index
+ */
+template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
+void serialize(raft::resources const& handle,
+               const std::string& filename,
+               const BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index)
+{
+  detail::serialize(handle, filename, index);
+}
+
+/**
+ * Load index from input stream
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * The index refers to the points it was built on (or extended with), which must be given again.
+ *
+ * @code{.cpp}
+ * #include <raft/core/resources.hpp>
+ *
+ * raft::resources handle;
+ *
+ * // create an input stream
+ * std::istream is(std::cin.rdbuf());
+ * // X: the points of the saved index, a device matrix view [m, n]
+ * auto index =
+ *   raft::neighbors::ball_cover::deserialize<int64_t, float, int64_t, int64_t>(handle, is, X);
+ * @endcode
+ *
+ * @tparam idx_t knn index type
+ * @tparam value_t knn value type
+ * @tparam int_t integral type for knn params
+ * @tparam matrix_idx_t matrix indexing type
+ *
+ * @param[in] handle the raft handle
+ * @param[in] is input stream
+ * @param[in] X the points of the saved index [m, n]
+ *
+ * @return raft::neighbors::ball_cover::BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>
+ */
+template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
+auto deserialize(raft::resources const& handle,
+                 std::istream& is,
+                 raft::device_matrix_view<const value_t, matrix_idx_t, row_major> X)
+  -> BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>
+{
+  return detail::deserialize<idx_t, value_t, int_t, matrix_idx_t>(handle, is, X);
+}
+
+/**
+ * Load index from file.
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * @code{.cpp}
+ * #include <raft/core/resources.hpp>
+ *
+ * raft::resources handle;
+ *
+ * // create a string with a filepath
+ * std::string filename("/path/to/index");
+ * // X: the points of the saved index, a device matrix view [m, n]
+ * using namespace raft::neighbors;
+ * auto index = ball_cover::deserialize<int64_t, float, int64_t, int64_t>(handle, filename, X);
+ * @endcode
+ *
+ * @tparam idx_t knn index type
+ * @tparam value_t knn value type
+ * @tparam int_t integral type for knn params
+ * @tparam matrix_idx_t matrix indexing type
+ *
+ * @param[in] handle the raft handle
+ * @param[in] filename the name of the file that stores the index
+ * @param[in] X the points of the saved index [m, n]
+ *
+ * @return raft::neighbors::ball_cover::BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>
+ */
+template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
+auto deserialize(raft::resources const& handle,
+                 const std::string& filename,
+                 raft::device_matrix_view<const value_t, matrix_idx_t, row_major> X)
+  -> BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>
+{
+  return detail::deserialize<idx_t, value_t, int_t, matrix_idx_t>(handle, filename, X);
+}
+
+/**@}*/
+
+}  // namespace raft::neighbors::ball_cover
@@ -101,6 +101,32 @@ class BallCoverIndex {
   {
   }
 
+  /**
+   * An index over `X` with the given number of landmarks, e.g. to deserialize an index whose points
+   * have been extended after it was built.
+   */
+  explicit BallCoverIndex(raft::resources const& handle_,
+                          raft::device_matrix_view<const value_t, matrix_idx, row_major> X_,
+                          value_int n_landmarks_,
+                          raft::distance::DistanceType metric_)
+    : handle(handle_),
+      X(X_),
+      m(X_.extent(0)),
+      n(X_.extent(1)),
+      metric(metric_),
+      n_landmarks(n_landmarks_),
+      R_indptr(raft::make_device_vector<value_idx, matrix_idx>(handle, n_landmarks_ + 1)),
+      R_1nn_cols(raft::make_device_vector<value_idx, matrix_idx>(handle, X_.extent(0))),
+      R_1nn_dists(raft::make_device_vector<value_t, matrix_idx>(handle, X_.extent(0))),
+      R_closest_landmark_dists(raft::make_device_vector<value_t, matrix_idx>(handle, X_.extent(0))),
+      R(raft::make_device_matrix<value_t, matrix_idx>(handle, n_landmarks_, X_.extent(1))),
+      X_reordered(
+        raft::make_device_matrix<value_t, matrix_idx>(handle, X_.extent(0), X_.extent(1))),
+      R_radius(raft::make_device_vector<value_t, matrix_idx>(handle, n_landmarks_)),
+      index_trained(false)
+  {
+  }
+
   auto get_R_indptr() const -> raft::device_vector_view<const value_idx, matrix_idx>
   {
     return R_indptr.view();
@@ -153,6 +179,20 @@ class BallCoverIndex {
   // This should only be set by internal functions
   void set_index_trained() { index_trained = true; }
 
+  /**
+   * Replace the index points by `X_`, reallocating the arrays of the points (their content is
+   * undefined afterwards). The landmarks are kept. This should only be called by internal functions.
+   */
+  void set_X(raft::device_matrix_view<const value_t, matrix_idx, row_major> X_)
+  {
+    X                        = X_;
+    m                        = X_.extent(0);
+    R_1nn_cols               = raft::make_device_vector<value_idx, matrix_idx>(handle, m);
+    R_1nn_dists              = raft::make_device_vector<value_t, matrix_idx>(handle, m);
+    R_closest_landmark_dists = raft::make_device_vector<value_t, matrix_idx>(handle, m);
+    X_reordered              = raft::make_device_matrix<value_t, matrix_idx>(handle, m, n);
+  }
+
   raft::resources const& handle;
 
   value_int m;
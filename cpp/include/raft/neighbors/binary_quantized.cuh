@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/binary_quantized_types.hpp>
+#include <raft/neighbors/detail/binary_quantized.cuh>
+
+#include <cstdint>
+
+namespace raft::neighbors::binary_quantized {
+
+/**
+ * @defgroup binary_quantized Binary-quantized index with the Hamming distance search
+ * @{
+ */
+
+/**
+ * @brief Build the binary-quantized index from the dataset.
+ *
+ * Every component of a vector becomes one bit: `x[j] > threshold[j]`, where the thresholds are
+ * zeros (`binarization::kSign`) or the per-dimension means of the dataset (`binarization::kMean`).
+ * The dataset may reside in the host or the device memory; it is binarized by batches and is not
+ * kept by the index.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   binary_quantized::index_params index_params;
+ *   index_params.thresholds = binary_quantized::binarization::kMean;
+ *   auto index = binary_quantized::build(handle, index_params, dataset);
+ *   binary_quantized::search_refined(
+ *     handle, binary_quantized::search_params{}, index, dataset, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam Accessor the memory type of the dataset (host or device)
+ *
+ * @param[in] res
+ * @param[in] params configure the index building; `metric` is the metric of `search_refined`
+ * @param[in] dataset a matrix view [n_rows, dim]
+ *
+ * @return the constructed index
+ */
+template <typename T, typename Accessor>
+auto build(raft::resources const& res,
+           const index_params& params,
+           mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset) -> index<T>
+{
+  return detail::build<T, Accessor>(res, params, dataset);
+}
+
+/**
+ * @brief Search the index by the Hamming distance between the binarized queries and the codes.
+ *
+ * The codes are scanned exhaustively, with `__popcll` on the 64-bit words of the codes. The
+ * distances are the numbers of the differing bits; the ties are broken arbitrarily.
+ *
+ * @tparam T data element type
+ *
+ * @param[in] res
+ * @param[in] params configure the search
+ * @param[in] idx the index
+ * @param[in] queries a device matrix view [n_queries, dim]
+ * @param[out] neighbors a device matrix view [n_queries, k]
+ * @param[out] distances a device matrix view to the Hamming distances [n_queries, k]
+ */
+template <typename T>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index<T>& idx,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+            raft::device_matrix_view<float, int64_t, row_major> distances)
+{
+  detail::search<T>(res, params, idx, queries, neighbors, distances);
+}
+
+/**
+ * @brief Search the index by the Hamming distance, then rerank the candidates by the exact
+ * distances.
+ *
+ * `k * params.refine_ratio` candidates per query are selected by `search`, and `raft::neighbors::
+ * refine` picks the `k` nearest of them by `idx.metric()` on the original dataset.
+ *
+ * @tparam T data element type
+ *
+ * @param[in] res
+ * @param[in] params configure the search
+ * @param[in] idx the index
+ * @param[in] dataset a device matrix view to the dataset the index was built from [n_rows, dim]
+ * @param[in] queries a device matrix view [n_queries, dim]
+ * @param[out] neighbors a device matrix view [n_queries, k]
+ * @param[out] distances a device matrix view to the exact distances [n_queries, k]
+ */
+template <typename T>
+void search_refined(raft::resources const& res,
+                    const search_params& params,
+                    const index<T>& idx,
+                    raft::device_matrix_view<const T, int64_t, row_major> dataset,
+                    raft::device_matrix_view<const T, int64_t, row_major> queries,
+                    raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+                    raft::device_matrix_view<float, int64_t, row_major> distances)
+{
+  detail::search_refined<T>(res, params, idx, dataset, queries, neighbors, distances);
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::binary_quantized
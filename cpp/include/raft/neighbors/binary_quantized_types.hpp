@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ann_types.hpp"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <cstdint>
+
+namespace raft::neighbors::binary_quantized {
+
+/**
+ * @addtogroup binary_quantized
+ * @{
+ */
+
+/** How the per-dimension thresholds of the binarization are chosen. */
+enum class binarization {
+  /** A bit is set if the component is positive. */
+  kSign = 0,
+  /** A bit is set if the component is greater than the mean of its dimension over the dataset. */
+  kMean = 1,
+};
+
+struct index_params : ann::index_params {
+  binarization thresholds = binarization::kSign;
+};
+
+struct search_params : ann::search_params {
+  /**
+   * The number of the Hamming candidates per neighbor passed to the exact refinement by
+   * `search_refined` (i.e. `k * refine_ratio` candidates per query).
+   */
+  uint32_t refine_ratio = 4;
+  /** The maximum number of queries searched at once; 0 means all of them. */
+  uint32_t max_queries = 0;
+};
+
+/**
+ * @brief The binary-quantized index: every vector is reduced to one bit per dimension, packed into
+ * `uint64_t` words, which takes 32 times less memory than `float` vectors.
+ *
+ * The index is searched by the Hamming distance between the codes. It is meant as the first stage
+ * of a search: the exact distances of the candidates are recomputed by `search_refined`.
+ *
+ * @tparam T data element type
+ */
+template <typename T>
+struct index : ann::index {
+ public:
+  index(const index&)                    = delete;
+  index(index&&)                         = default;
+  auto operator=(const index&) -> index& = delete;
+  auto operator=(index&&) -> index&      = default;
+  ~index()                               = default;
+
+  /** Construct an empty index of `n_rows` codes. */
+  index(raft::resources const& res,
+        raft::distance::DistanceType metric,
+        binarization thresholds,
+        int64_t n_rows,
+        uint32_t dim)
+    : ann::index(),
+      metric_(metric),
+      binarization_(thresholds),
+      dim_(dim),
+      codes_(raft::make_device_matrix<uint64_t, int64_t>(res, n_rows, n_words(dim))),
+      thresholds_(raft::make_device_vector<float, uint32_t>(res, dim))
+  {
+  }
+
+  /** The metric of the exact refinement. */
+  [[nodiscard]] constexpr inline auto metric() const noexcept -> raft::distance::DistanceType
+  {
+    return metric_;
+  }
+  /** How the thresholds have been chosen. */
+  [[nodiscard]] constexpr inline auto binarization_kind() const noexcept -> binarization
+  {
+    return binarization_;
+  }
+  /** Total length of the index (number of vectors). */
+  [[nodiscard]] inline auto size() const noexcept -> int64_t { return codes_.extent(0); }
+  /** Dimensionality of the data. */
+  [[nodiscard]] constexpr inline auto dim() const noexcept -> uint32_t { return dim_; }
+  /** The number of `uint64_t` words per code. */
+  [[nodiscard]] constexpr inline auto code_words() const noexcept -> uint32_t
+  {
+    return n_words(dim_);
+  }
+
+  /** The binary codes [size, code_words]; the bit `j % 64` of the word `j / 64` is dimension j. */
+  inline auto codes() noexcept -> device_matrix_view<uint64_t, int64_t, row_major>
+  {
+    return codes_.view();
+  }
+  [[nodiscard]] inline auto codes() const noexcept
+    -> device_matrix_view<const uint64_t, int64_t, row_major>
+  {
+    return codes_.view();
+  }
+
+  /** The per-dimension thresholds of the binarization [dim]. */
+  inline auto thresholds() noexcept -> device_vector_view<float, uint32_t>
+  {
+    return thresholds_.view();
+  }
+  [[nodiscard]] inline auto thresholds() const noexcept -> device_vector_view<const float, uint32_t>
+  {
+    return thresholds_.view();
+  }
+
+ private:
+  static constexpr inline auto n_words(uint32_t dim) -> uint32_t
+  {
+    return raft::div_rounding_up_safe<uint32_t>(dim, 64);
+  }
+
+  raft::distance::DistanceType metric_;
+  binarization binarization_;
+  uint32_t dim_;
+  raft::device_matrix<uint64_t, int64_t, row_major> codes_;
+  raft::device_vector<float, uint32_t> thresholds_;
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::binary_quantized
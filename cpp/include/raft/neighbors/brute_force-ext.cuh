@@ -16,13 +16,19 @@
 
 #pragma once
 
+#include <raft/core/bitmap.hpp>              // raft::core::bitmap_view
+#include <raft/core/device_csr_matrix.hpp>   // raft::device_sparsity_owning_csr_matrix
 #include <raft/core/device_mdspan.hpp>       // raft::device_matrix_view
+#include <raft/core/host_mdspan.hpp>         // raft::host_matrix_view
 #include <raft/core/operators.hpp>           // raft::identity_op
 #include <raft/core/resources.hpp>           // raft::resources
 #include <raft/distance/distance_types.hpp>  // raft::distance::DistanceType
 #include <raft/neighbors/brute_force_types.hpp>
 #include <raft/util/raft_explicit.hpp>  // RAFT_EXPLICIT
 
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
 #include <optional>
 
 #ifdef RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -37,7 +43,8 @@ inline void knn_merge_parts(
   raft::device_matrix_view<value_t, idx_t, row_major> out_keys,
   raft::device_matrix_view<idx_t, idx_t, row_major> out_values,
   size_t n_samples,
-  std::optional<raft::device_vector_view<idx_t, idx_t>> translations = std::nullopt) RAFT_EXPLICIT;
+  std::optional<raft::device_vector_view<idx_t, idx_t>> translations = std::nullopt,
+  bool select_min                                                     = true) RAFT_EXPLICIT;
 
 template <typename T, typename Accessor>
 index<T> build(raft::resources const& res,
@@ -65,6 +72,21 @@ void search(raft::resources const& res,
             raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
             raft::device_matrix_view<T, int64_t, row_major> distances) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void search(raft::resources const& res,
+            const index<T>& idx,
+            raft::host_matrix_view<const T, int64_t, row_major> queries,
+            raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::host_matrix_view<T, int64_t, row_major> distances) RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void search_with_filtering(raft::resources const& res,
+                           const index<T>& idx,
+                           raft::device_matrix_view<const T, int64_t, row_major> queries,
+                           raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                           raft::device_matrix_view<T, int64_t, row_major> distances,
+                           raft::core::bitmap_view<const uint32_t, int64_t> filter) RAFT_EXPLICIT;
+
 template <typename idx_t,
           typename value_t,
           typename matrix_idx,
@@ -81,6 +103,35 @@ void knn(raft::resources const& handle,
          std::optional<idx_t> global_id_offset = std::nullopt,
          epilogue_op distance_epilogue         = raft::identity_op()) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void knn_host_dataset(raft::resources const& res,
+                      raft::host_matrix_view<const T, int64_t, row_major> dataset,
+                      raft::device_matrix_view<const T, int64_t, row_major> queries,
+                      raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                      raft::device_matrix_view<T, int64_t, row_major> distances,
+                      raft::distance::DistanceType metric = distance::DistanceType::L2Unexpanded,
+                      float metric_arg                    = 2.0f,
+                      int64_t tile_rows                   = 1 << 20) RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void knn_low_precision(
+  raft::resources const& res,
+  raft::device_matrix_view<const T, int64_t, row_major> dataset,
+  raft::device_matrix_view<const T, int64_t, row_major> queries,
+  raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric = distance::DistanceType::L2Expanded,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms =
+    std::nullopt) RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void range_search(raft::resources const& res,
+                  const raft::neighbors::brute_force::index<T>& idx,
+                  raft::device_matrix_view<const T, int64_t, row_major> queries,
+                  T radius,
+                  raft::device_sparsity_owning_csr_matrix<T, int64_t, IdxT, int64_t>& out)
+  RAFT_EXPLICIT;
+
 template <typename value_t, typename idx_t, typename idx_layout, typename query_layout>
 void fused_l2_knn(raft::resources const& handle,
                   raft::device_matrix_view<const value_t, idx_t, idx_layout> index,
@@ -152,6 +203,20 @@ extern template void search<float, int64_t>(
   raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
   raft::device_matrix_view<float, int64_t, row_major> distances);
 
+extern template void search<float, int>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::host_matrix_view<const float, int64_t, row_major> queries,
+  raft::host_matrix_view<int, int64_t, row_major> neighbors,
+  raft::host_matrix_view<float, int64_t, row_major> distances);
+
+extern template void search<float, int64_t>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::host_matrix_view<const float, int64_t, row_major> queries,
+  raft::host_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::host_matrix_view<float, int64_t, row_major> distances);
+
 extern template raft::neighbors::brute_force::index<float> build<float>(
   raft::resources const& res,
   raft::device_matrix_view<const float, int64_t, row_major> dataset,
@@ -173,6 +238,58 @@ extern template raft::neighbors::brute_force::index<float> build<float>(
   raft::resources const& res,
   index_params const& params,
   raft::host_matrix_view<const float, int64_t, row_major> dataset);
+
+extern template void knn_host_dataset<float, int64_t>(
+  raft::resources const& res,
+  raft::host_matrix_view<const float, int64_t, row_major> dataset,
+  raft::device_matrix_view<const float, int64_t, row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric,
+  float metric_arg,
+  int64_t tile_rows);
+
+extern template void knn_low_precision<half, int64_t>(
+  raft::resources const& res,
+  raft::device_matrix_view<const half, int64_t, row_major> dataset,
+  raft::device_matrix_view<const half, int64_t, row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms);
+
+extern template void knn_low_precision<nv_bfloat16, int64_t>(
+  raft::resources const& res,
+  raft::device_matrix_view<const nv_bfloat16, int64_t, row_major> dataset,
+  raft::device_matrix_view<const nv_bfloat16, int64_t, row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms);
+
+extern template void knn_low_precision<int8_t, int64_t>(
+  raft::resources const& res,
+  raft::device_matrix_view<const int8_t, int64_t, row_major> dataset,
+  raft::device_matrix_view<const int8_t, int64_t, row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms);
+
+extern template void search_with_filtering<float, int64_t>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::device_matrix_view<const float, int64_t, row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::core::bitmap_view<const uint32_t, int64_t> filter);
+
+extern template void range_search<float, int64_t>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::device_matrix_view<const float, int64_t, row_major> queries,
+  float radius,
+  raft::device_sparsity_owning_csr_matrix<float, int64_t, int64_t, int64_t>& out);
 }  // namespace raft::neighbors::brute_force
 
 #define instantiate_raft_neighbors_brute_force_fused_l2_knn(            \
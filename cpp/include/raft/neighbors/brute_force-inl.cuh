@@ -16,14 +16,23 @@
 
 #pragma once
 
+#include <raft/core/bitmap.hpp>
 #include <raft/core/copy.cuh>
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/brute_force_types.hpp>
+#include <raft/neighbors/detail/host_query_staging.cuh>
 #include <raft/neighbors/detail/knn_brute_force.cuh>
+#include <raft/neighbors/detail/knn_brute_force_filtered.cuh>
+#include <raft/neighbors/detail/knn_brute_force_low_precision.cuh>
+#include <raft/neighbors/detail/knn_brute_force_range_search.cuh>
 #include <raft/spatial/knn/detail/fused_l2_knn.cuh>
 
+#include <optional>
+
 namespace raft::neighbors::brute_force {
 
 /**
@@ -78,6 +87,8 @@ namespace raft::neighbors::brute_force {
  * @param[out] out_values matrix of output values (size n_samples * k)
  * @param[in] n_samples number of rows in each partition
  * @param[in] translations optional vector of starting global id mappings for each local partition
+ * @param[in] select_min whether to keep the k smallest (e.g. distances) or the k largest
+ *   (e.g. similarities) keys
  */
 template <typename value_t, typename idx_t>
 inline void knn_merge_parts(
@@ -87,7 +98,8 @@ inline void knn_merge_parts(
   raft::device_matrix_view<value_t, idx_t, row_major> out_keys,
   raft::device_matrix_view<idx_t, idx_t, row_major> out_values,
   size_t n_samples,
-  std::optional<raft::device_vector_view<idx_t, idx_t>> translations = std::nullopt)
+  std::optional<raft::device_vector_view<idx_t, idx_t>> translations = std::nullopt,
+  bool select_min                                                     = true)
 {
   RAFT_EXPECTS(in_keys.extent(1) == in_values.extent(1) && in_keys.extent(0) == in_values.extent(0),
                "in_keys and in_values must have the same shape.");
@@ -102,15 +114,16 @@ inline void knn_merge_parts(
   if (translations.has_value()) { translations_ptr = translations.value().data_handle(); }
 
   auto n_parts = in_keys.extent(0) / n_samples;
-  detail::knn_merge_parts(in_keys.data_handle(),
+  detail::knn_merge_parts(handle,
+                          in_keys.data_handle(),
                           in_values.data_handle(),
                           out_keys.data_handle(),
                           out_values.data_handle(),
                           n_samples,
                           n_parts,
                           in_keys.extent(1),
-                          resource::get_cuda_stream(handle),
-                          translations_ptr);
+                          translations_ptr,
+                          select_min);
 }
 
 /**
@@ -449,5 +462,238 @@ void search(raft::resources const& res,
   raft::neighbors::detail::brute_force_search<T, IdxT>(res, idx, queries, neighbors, distances);
 }
 
+/**
+ * @brief Brute Force search with host-resident queries, writing the results to host memory.
+ *
+ * The queries are searched by batches, which are staged through pinned buffers of the pinned
+ * workspace (@ref raft::resource::get_pinned_workspace_resource). The transfers of a batch run on a
+ * stream of the stream pool of `res`, if any, so that they overlap with the search of the previous
+ * batch; without a stream pool, they are still done asynchronously.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] idx brute force index
+ * @param[in] queries a host matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a host matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& res,
+            const index<T>& idx,
+            raft::host_matrix_view<const T, int64_t, row_major> queries,
+            raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::host_matrix_view<T, int64_t, row_major> distances)
+{
+  const int64_t dim = queries.extent(1);
+  const int64_t k   = neighbors.extent(1);
+  raft::neighbors::detail::search_host_queries(
+    res,
+    queries,
+    neighbors,
+    distances,
+    [&](const T* queries_d, IdxT* neighbors_d, T* distances_d, int64_t n_rows) {
+      raft::neighbors::detail::brute_force_search<T, IdxT>(
+        res,
+        idx,
+        raft::make_device_matrix_view<const T, int64_t>(queries_d, n_rows, dim),
+        raft::make_device_matrix_view<IdxT, int64_t>(neighbors_d, n_rows, k),
+        raft::make_device_matrix_view<T, int64_t>(distances_d, n_rows, k));
+    });
+}
+
+/**
+ * @brief Brute Force search using the constructed index, restricted to the dataset rows allowed by
+ * a per-query bitmap.
+ *
+ * The bit (i, j) of the filter tells whether the dataset row j may be a neighbor of the query i.
+ * The distances are only computed at the allowed positions: the bitmap is converted to a CSR
+ * matrix, the inner products at its nonzeros are computed with `masked_matmul` and completed into
+ * distances, and the k nearest neighbors are selected from the CSR rows. The cost thus scales with
+ * the number of allowed pairs rather than with the size of the index, which pays off for
+ * selective filters. The rows with less than k allowed ids are padded with the index -1 and the
+ * largest (or the lowest, for the inner product) distance.
+ *
+ * Only the L2 (expanded or not), cosine and inner product metrics are supported.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = brute_force::build(res, dataset, raft::distance::DistanceType::L2Expanded);
+ *   // one bit per (query, dataset row) pair, set for the allowed rows
+ *   auto bits = raft::make_device_vector<uint32_t, int64_t>(
+ *     res, raft::ceildiv<int64_t>(n_queries * index.size(), 32));
+ *   ...
+ *   auto filter = raft::core::bitmap_view<const uint32_t, int64_t>(
+ *     bits.data_handle(), n_queries, index.size());
+ *   brute_force::search_with_filtering(res, index, queries, neighbors, distances, filter);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] idx brute force index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, idx.dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ * @param[in] filter a bitmap [n_queries, idx.size()] of the allowed dataset rows of every query
+ */
+template <typename T, typename IdxT>
+void search_with_filtering(raft::resources const& res,
+                           const index<T>& idx,
+                           raft::device_matrix_view<const T, int64_t, row_major> queries,
+                           raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                           raft::device_matrix_view<T, int64_t, row_major> distances,
+                           raft::core::bitmap_view<const uint32_t, int64_t> filter)
+{
+  raft::neighbors::detail::brute_force_search_filtered<T, IdxT>(
+    res, idx, queries, neighbors, distances, filter);
+}
+
+/**
+ * @brief Exact kNN search over a host-resident dataset, which may be larger than the GPU memory.
+ *
+ * The dataset is copied to the device tile by tile, `tile_rows` rows at a time. Every tile is
+ * searched on its own stream (using the stream pool of `res` if available), so that the copy of a
+ * tile overlaps with the search of the previous one; the top-k results of the tiles are merged
+ * with `knn_merge_parts` into the running result. Pin the dataset memory (e.g. with
+ * `cudaHostRegister` or `raft::make_pinned_matrix`) for the copies to be truly asynchronous.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // two streams to overlap the copies and the searches of the tiles
+ *   raft::resource::set_cuda_stream_pool(res, std::make_shared<rmm::cuda_stream_pool>(2));
+ *   brute_force::knn_host_dataset(res, dataset_host, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] dataset a host matrix view to a row-major matrix [n_rows, dim]
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, dim]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ * @param[in] metric distance metric to use
+ * @param[in] metric_arg the value of `p` for Minkowski (l-p) distances
+ * @param[in] tile_rows the number of dataset rows copied to the device at once (at least k); two
+ *   tiles reside in the device memory at a time
+ */
+template <typename T, typename IdxT>
+void knn_host_dataset(raft::resources const& res,
+                      raft::host_matrix_view<const T, int64_t, row_major> dataset,
+                      raft::device_matrix_view<const T, int64_t, row_major> queries,
+                      raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                      raft::device_matrix_view<T, int64_t, row_major> distances,
+                      raft::distance::DistanceType metric = distance::DistanceType::L2Unexpanded,
+                      float metric_arg                    = 2.0f,
+                      int64_t tile_rows                   = 1 << 20)
+{
+  raft::neighbors::detail::brute_force_search_host_dataset<T, IdxT>(
+    res, dataset, queries, neighbors, distances, metric, metric_arg, tile_rows);
+}
+
+/**
+ * @brief Exact kNN search over a low-precision (fp16, bf16 or int8) dataset.
+ *
+ * The dot products of the queries and the dataset rows are computed by the tensor core GEMMs of
+ * cuBLASLt with a wider accumulator (float for fp16/bf16, exact int32 for int8), and turned into
+ * the float distances with the precomputed row norms. Compared to a float dataset, this halves
+ * (fp16/bf16) or quarters (int8) the memory footprint and the bandwidth of the search.
+ *
+ * The dataset is processed tile by tile; the top-k candidates of every tile are kept and the final
+ * result is selected among them, so the temporary memory does not depend on the dataset size.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // `norms` holds the squared L2 norms of the dataset rows, computed once for all searches
+ *   brute_force::knn_low_precision<half, int64_t>(res,
+ *                                                 dataset,
+ *                                                 queries,
+ *                                                 neighbors,
+ *                                                 distances,
+ *                                                 raft::distance::DistanceType::L2Expanded,
+ *                                                 raft::make_const_mdspan(norms.view()));
+ * @endcode
+ *
+ * @tparam T data element type: `half`, `nv_bfloat16` or `int8_t`
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] dataset a device matrix view to a row-major matrix [n_rows, dim]; for int8 data, `dim`
+ *   must be a multiple of 4
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, dim]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ * @param[in] metric distance metric to use: L2 (expanded or not), inner product or cosine
+ * @param[in] dataset_norms optional squared L2 norms of the dataset rows [n_rows] (in float); they
+ *   are computed on the fly if not given (not used by the inner product)
+ */
+template <typename T, typename IdxT>
+void knn_low_precision(
+  raft::resources const& res,
+  raft::device_matrix_view<const T, int64_t, row_major> dataset,
+  raft::device_matrix_view<const T, int64_t, row_major> queries,
+  raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric = distance::DistanceType::L2Expanded,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms = std::nullopt)
+{
+  raft::neighbors::detail::brute_force_search_low_precision<T, IdxT>(
+    res, dataset, queries, neighbors, distances, metric, dataset_norms);
+}
+
+/**
+ * @brief Find all the neighbors within a radius of the queries.
+ *
+ * The result is a sparse [n_queries, index size] matrix in the CSR format: the row of a query holds
+ * the source indices of its neighbors (in increasing order) and the distances to them. The pairs
+ * are found in two passes over the same distance tiles - the neighbors are counted first, and
+ * written once the output is allocated - so the memory footprint scales with the number of the
+ * results rather than with the full distance matrix.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = brute_force::build(res, dataset, raft::distance::DistanceType::L2SqrtExpanded);
+ *   auto result = raft::make_device_csr_matrix<float, int64_t, int64_t, int64_t>(
+ *     res, queries.extent(0), index.size());
+ *   brute_force::range_search(res, index, queries, 0.5f, result);
+ *   // result.structure_view().get_indptr() holds the offsets of the neighbors of every query
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] idx brute force index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, idx.dim()]
+ * @param[in] radius the neighbors are the rows at a distance `<= radius`, or with a similarity
+ *   `>= radius` for the `InnerProduct` metric
+ * @param[out] out a sparsity-owning CSR matrix [n_queries, idx.size()]; its sparsity is set by the
+ *   search
+ */
+template <typename T, typename IdxT>
+void range_search(raft::resources const& res,
+                  const index<T>& idx,
+                  raft::device_matrix_view<const T, int64_t, row_major> queries,
+                  T radius,
+                  raft::device_sparsity_owning_csr_matrix<T, int64_t, IdxT, int64_t>& out)
+{
+  raft::neighbors::detail::brute_force_range_search<T, IdxT>(res, idx, queries, radius, out);
+}
+
 /** @} */  // end group brute_force_knn
 }  // namespace raft::neighbors::brute_force
@@ -77,6 +77,9 @@ namespace raft::neighbors::brute_force {
  * @param[in] index The index to query
  * @param[in] query A device matrix view to query for [n_queries, index->dim()]
  * @param[in] batch_size The size of each batch
+ * @param[in] prefetch Compute the next group of batches on a side stream (one of the stream pool
+ *   of `res` if any) while the current batch is processed, instead of when the iterator advances
+ *   to it. The index, query and `res` must outlive the returned object.
  */
 
 template <typename T, typename IdxT>
@@ -84,9 +87,10 @@ std::shared_ptr<batch_k_query<T, IdxT>> make_batch_k_query(
   const raft::resources& res,
   const raft::neighbors::brute_force::index<T>& index,
   raft::device_matrix_view<const T, int64_t, row_major> query,
-  int64_t batch_size)
+  int64_t batch_size,
+  bool prefetch = false)
 {
   return std::shared_ptr<batch_k_query<T, IdxT>>(
-    new detail::gpu_batch_k_query<T, IdxT>(res, index, query, batch_size));
+    new detail::gpu_batch_k_query<T, IdxT>(res, index, query, batch_size, prefetch));
 }
 }  // namespace raft::neighbors::brute_force
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/detail/knn_brute_force_mg.cuh>
+
+#include <optional>
+
+namespace raft::neighbors::brute_force {
+
+/**
+ * @brief Exact k-nearest neighbors over an index partitioned among the ranks of a communicator
+ *   (multi-node multi-GPU).
+ *
+ * Every rank holds a contiguous partition of the rows of the index, in the order of the ranks, and
+ * a partition of the queries, and calls this function collectively. The queries are all-gathered,
+ * every rank searches its partition of the index for all of them, and the candidates are sent
+ * back to the ranks owning the queries (all-to-all), where they are merged with
+ * `knn_merge_parts`. Only the queries and k candidates per query and rank cross the network; the
+ * index never leaves its rank.
+ *
+ * @code{.cpp}
+ *   #include <raft/comms/std_comms.hpp>
+ *   #include <raft/neighbors/brute_force_mg.cuh>
+ *   ...
+ *   raft::resources handle;
+ *   raft::comms::build_comms_nccl_only(&handle, nccl_comm, n_ranks, rank);
+ *   // the local partitions of the index and of the queries
+ *   auto neighbors = raft::make_device_matrix<int64_t, int64_t>(handle, n_local_queries, k);
+ *   auto distances = raft::make_device_matrix<float, int64_t>(handle, n_local_queries, k);
+ *   raft::neighbors::brute_force::knn_mg(
+ *     handle, index_part, queries_part, neighbors.view(), distances.view());
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle The raft handle, with an initialized communicator.
+ * @param[in] index The local partition of the index [n_local_rows, dim], at least k rows. The
+ *   rows of the rank `r` have the global ids following those of the ranks before it.
+ * @param[in] queries The local queries [n_local_queries, dim], possibly none.
+ * @param[out] neighbors The global ids of the neighbors of the local queries [n_local_queries, k]
+ * @param[out] distances The distances to the neighbors [n_local_queries, k]
+ * @param[in] metric The distance metric, the same on all the ranks
+ * @param[in] metric_arg The value of `p` for Minkowski (l-p) distances
+ */
+template <typename T, typename IdxT>
+void knn_mg(raft::resources const& handle,
+            raft::device_matrix_view<const T, IdxT, row_major> index,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::device_matrix_view<T, IdxT, row_major> distances,
+            raft::distance::DistanceType metric = raft::distance::DistanceType::L2Unexpanded,
+            std::optional<float> metric_arg     = std::make_optional<float>(2.0f))
+{
+  detail::knn_mg<T, IdxT>(handle, index, queries, neighbors, distances, metric, metric_arg);
+}
+
+}  // namespace raft::neighbors::brute_force
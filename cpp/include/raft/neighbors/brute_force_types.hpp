@@ -29,6 +29,8 @@
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/neighbors_types.hpp>
 
+#include <utility>
+
 namespace raft::neighbors::brute_force {
 /**
  * @addtogroup brute_force_knn
@@ -197,6 +199,10 @@ struct index : ann::index {
  * instantiated.  See the raft::neighbors::brute_force::make_batch_k_query
  * function for usage examples.
  *
+ * With `prefetch`, the iterator starts computing the next group of batches in the background as
+ * soon as the current batch is the last one of the loaded group, so that the GPU work overlaps
+ * with the processing of the current batch by the caller.
+ *
  * @tparam T data element type
  * @tparam IdxT type of the indices in the source dataset
  */
@@ -206,8 +212,13 @@ class batch_k_query {
   batch_k_query(const raft::resources& res,
                 int64_t index_size,
                 int64_t query_size,
-                int64_t batch_size)
-    : res(res), index_size(index_size), query_size(query_size), batch_size(batch_size)
+                int64_t batch_size,
+                bool prefetch = false)
+    : res(res),
+      index_size(index_size),
+      query_size(query_size),
+      batch_size(batch_size),
+      prefetch(prefetch)
   {
   }
   virtual ~batch_k_query() {}
@@ -221,10 +232,15 @@ class batch_k_query {
     using pointer    = const value_type*;
 
     iterator(const batch_k_query<T, IdxT>* query, int64_t offset = 0)
-      : current(query->res, 0, 0), batches(query->res, 0, 0), query(query), offset(offset)
+      : current(query->res, 0, 0),
+        batches(query->res, 0, 0),
+        next_batches(query->res, 0, 0),
+        query(query),
+        offset(offset)
     {
       query->load_batch(offset, query->batch_size, &batches);
       query->slice_batch(batches, offset, query->batch_size, &current);
+      prefetch_next();
     }
 
     reference operator*() const { return current; }
@@ -257,10 +273,16 @@ class batch_k_query {
     void advance(int64_t next_batch_size)
     {
       offset = std::min(offset + current.batch_size(), query->index_size);
+      if (offset + next_batch_size > batches.batch_size() && prefetched) {
+        query->wait_prefetch();
+        std::swap(batches, next_batches);
+        prefetched = false;
+      }
       if (offset + next_batch_size > batches.batch_size()) {
         query->load_batch(offset, next_batch_size, &batches);
       }
       query->slice_batch(batches, offset, next_batch_size, &current);
+      prefetch_next();
     }
 
     friend bool operator==(const iterator& lhs, const iterator& rhs)
@@ -270,6 +292,21 @@ class batch_k_query {
     friend bool operator!=(const iterator& lhs, const iterator& rhs) { return !(lhs == rhs); };
 
    protected:
+    /**
+     * Start loading the group of batches following the loaded one, if the next batch of the
+     * default size is past its end (only if the query prefetches).
+     */
+    void prefetch_next()
+    {
+      const auto next_offset = offset + current.batch_size();
+      if (!query->prefetch || prefetched || next_offset >= query->index_size ||
+          next_offset + query->batch_size <= batches.batch_size()) {
+        return;
+      }
+      query->prefetch_batch(next_offset, query->batch_size, &next_batches);
+      prefetched = true;
+    }
+
     // the current batch of data
     value_type current;
 
@@ -277,6 +314,10 @@ class batch_k_query {
     // through)
     value_type batches;
 
+    // the group of data loaded in the background to follow `batches` (if `prefetched`)
+    value_type next_batches;
+    bool prefetched = false;
+
     const batch_k_query<T, IdxT>* query;
     int64_t offset, current_batch_size;
   };
@@ -294,8 +335,21 @@ class batch_k_query {
                            int64_t batch_size,
                            value_type* output) const    = 0;
 
+  /**
+   * Start the same work as `load_batch` without waiting for it to complete, so that it overlaps
+   * with the processing of the current batch. The output can be used after `wait_prefetch`.
+   * The default implementation loads the batch synchronously.
+   */
+  virtual void prefetch_batch(int64_t offset, int64_t next_batch_size, value_type* output) const
+  {
+    load_batch(offset, next_batch_size, output);
+  }
+  /** Order the subsequent work of `res` after the last `prefetch_batch`. */
+  virtual void wait_prefetch() const {}
+
   const raft::resources& res;
   int64_t index_size, query_size, batch_size;
+  bool prefetch;
 };
 /** @} */
 
@@ -16,9 +16,14 @@
 
 #pragma once
 
+#include "detail/cagra/add_nodes.cuh"
 #include "detail/cagra/cagra_build.cuh"
 #include "detail/cagra/cagra_search.cuh"
+#include "detail/cagra/cagra_sharded.cuh"
+#include "detail/cagra/compressed_graph.cuh"
 #include "detail/cagra/graph_core.cuh"
+#include "detail/cagra/remove_nodes.cuh"
+#include "detail/cagra/reorder_nodes.cuh"
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_device_accessor.hpp>
@@ -30,6 +35,8 @@
 
 #include <rmm/cuda_stream_view.hpp>
 
+#include <vector>
+
 namespace raft::neighbors::cagra {
 
 /**
@@ -282,6 +289,276 @@ index<T, IdxT> build(raft::resources const& res,
   return detail::build<T, IdxT, Accessor>(res, params, dataset);
 }
 
+/**
+ * @brief Add new vectors to a CAGRA index
+ *
+ * Instead of rebuilding the graph from scratch, the new vectors are searched in the existing
+ * graph, and their neighbor lists are selected from the search results using the same rank-based
+ * pruning as in [cagra::optimize](#cagra::optimize). A few edges of the neighboring nodes are
+ * replaced by reverse edges pointing at the new nodes. Only the rows of the graph touched by the
+ * new nodes are modified.
+ *
+ * After the call, the index owns a device copy of the extended dataset and graph. The dataset of
+ * the index must be an uncompressed (strided) dataset.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   auto additional_dataset = raft::make_device_matrix<float, int64_t>(handle, add_size, dim);
+ *   // set_additional_dataset(additional_dataset.view());
+ *
+ *   cagra::extend_params params;
+ *   cagra::extend(res, params, raft::make_const_mdspan(additional_dataset.view()), index);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res raft resources
+ * @param[in] params extend params
+ * @param[in] additional_dataset additional dataset on host or device memory [n_rows, dim]
+ * @param[in,out] idx CAGRA index
+ */
+template <typename T,
+          typename IdxT = uint32_t,
+          typename Accessor =
+            host_device_accessor<std::experimental::default_accessor<T>, memory_type::device>>
+void extend(raft::resources const& res,
+            const extend_params& params,
+            mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> additional_dataset,
+            index<T, IdxT>& idx)
+{
+  detail::extend<T, IdxT, Accessor>(res, params, additional_dataset, idx);
+}
+
+/**
+ * @brief Mark samples of the index as removed.
+ *
+ * The removed samples stay in the graph and keep being used for traversal, but they are never
+ * returned by [cagra::search](#cagra::search) or
+ * [cagra::search_with_filtering](#cagra::search_with_filtering). Call
+ * [cagra::compact](#cagra::compact) to drop them from the index once enough samples are removed.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   auto ids = raft::make_device_vector<uint32_t, int64_t>(res, n_removed);
+ *   // set_removed_ids(ids.view());
+ *   cagra::remove(res, index, raft::make_const_mdspan(ids.view()));
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in,out] idx cagra index
+ * @param[in] ids a device vector of the ids of the samples to remove [n_removed]; each id must
+ *   be in [0, idx.size()), otherwise a raft::logic_error is thrown and the index is not modified
+ */
+template <typename T, typename IdxT>
+void remove(raft::resources const& res,
+            index<T, IdxT>& idx,
+            raft::device_vector_view<const IdxT, int64_t> ids)
+{
+  detail::remove<T, IdxT>(res, idx, ids);
+}
+
+/**
+ * @brief Drop the removed samples from the index.
+ *
+ * The edges pointing at the removed nodes are rewired to their live neighbors, and the dataset and
+ * graph of the index are rebuilt without the removed samples. The remaining samples are
+ * renumbered consecutively, preserving their order.
+ *
+ * Nothing is done if fewer than `min_removed_fraction * idx.size()` samples are removed; this
+ * allows calling compact after every removal and paying for it only once the threshold is
+ * reached.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   cagra::remove(res, index, raft::make_const_mdspan(ids.view()));
+ *   if (auto new_to_old = cagra::compact(res, index, 0.1f); new_to_old.has_value()) {
+ *     // new_to_old->view() maps the new sample ids to the ids before compaction
+ *   }
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in,out] idx cagra index
+ * @param[in] min_removed_fraction the fraction of removed samples triggering the compaction
+ *
+ * @return the mapping from the new to the previous sample ids [idx.size()], or std::nullopt if
+ *   the index has not been compacted.
+ */
+template <typename T, typename IdxT>
+auto compact(raft::resources const& res, index<T, IdxT>& idx, float min_removed_fraction = 0.0f)
+  -> std::optional<raft::device_vector<IdxT, int64_t>>
+{
+  return detail::compact<T, IdxT>(res, idx, min_removed_fraction);
+}
+
+/**
+ * @brief Renumber the nodes of the index to improve the memory locality of the search.
+ *
+ * The search gathers the dataset and graph rows of the visited nodes, which are spread over the
+ * whole index in the build order. This function clusters the dataset with the balanced k-means and
+ * stores the nodes of each cluster next to each other, permuting the dataset and the graph
+ * accordingly. The neighbors visited by a search then tend to share the cache lines, L2 cache and
+ * DRAM pages, which raises the effective bandwidth of the distance computation on large indices.
+ *
+ * The search returns the new ids; map them back with the returned array, for example with
+ * `raft::matrix::gather`. The sample ids passed to `cagra::remove` and to the search filters are
+ * the new ids as well.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   auto index      = cagra::build(res, index_params, dataset);
+ *   auto new_to_old = cagra::reorder(res, cagra::reorder_params{}, index);
+ *   cagra::search(res, search_params, index, queries, neighbors, distances);
+ *   // new_to_old(neighbors(i, j)) is the id of the neighbor in the original dataset
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params reorder parameters
+ * @param[in,out] idx cagra index with an uncompressed dataset and no removed samples
+ *
+ * @return the mapping from the new to the previous sample ids [idx.size()]
+ */
+template <typename T, typename IdxT>
+auto reorder(raft::resources const& res, const reorder_params& params, index<T, IdxT>& idx)
+  -> raft::device_vector<IdxT, int64_t>
+{
+  return detail::reorder<T, IdxT>(res, params, idx);
+}
+
+/**
+ * @brief Store the graph of the index with the bit-packed ids to reduce its memory footprint.
+ *
+ * The dense graph spends `sizeof(IdxT)` bytes per edge, which for a large graph degree is
+ * comparable to the size of a compressed (VPQ) dataset row. The compressed graph stores every
+ * edge in `ceil(log2(idx.size() + 1))` bits (e.g. 24 bits for up to 16M nodes), the rows padded
+ * to 32-bit words; the search kernels decode the ids on the fly. The dense graph is released.
+ *
+ * Extending, compacting, reordering and serializing the index require the dense graph: call
+ * `cagra::decompress_graph` first. Replacing the graph with `index::update_graph` drops the
+ * compressed graph.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   auto index = cagra::build(res, index_params, dataset);
+ *   cagra::compress_graph(res, index);
+ *   // index.graph_id_bits() > 0
+ *   cagra::search(res, search_params, index, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in,out] idx cagra index with at most 2^32 - 1 nodes
+ */
+template <typename T, typename IdxT>
+void compress_graph(raft::resources const& res, index<T, IdxT>& idx)
+{
+  detail::compress_graph<T, IdxT>(res, idx);
+}
+
+/**
+ * @brief Restore the dense graph of an index compressed by `cagra::compress_graph`.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in,out] idx cagra index
+ */
+template <typename T, typename IdxT>
+void decompress_graph(raft::resources const& res, index<T, IdxT>& idx)
+{
+  detail::decompress_graph<T, IdxT>(res, idx);
+}
+
+/**
+ * @brief Build a CAGRA index partitioned across multiple GPUs.
+ *
+ * The dataset is split into `device_ids.size()` contiguous, equally sized shards, and one CAGRA
+ * index is built for each shard on the corresponding device. The shards are built concurrently,
+ * each one by a separate host thread using the resources returned by
+ * `raft::device_resources_manager::get_device_resources(device_id)`; configure the manager
+ * (streams, memory pools) before calling this function if needed.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   int n_devices;
+ *   RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+ *   std::vector<int> device_ids(n_devices);
+ *   std::iota(device_ids.begin(), device_ids.end(), 0);
+ *   cagra::index_params index_params;
+ *   auto index = cagra::build_sharded(index_params, device_ids, raft::make_const_mdspan(dataset));
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the local indices of a shard
+ *
+ * @param[in] params parameters for building the index of every shard
+ * @param[in] device_ids the devices to place the shards on [n_shards]
+ * @param[in] dataset a matrix view (host accessible) to a row-major matrix [n_rows, dim]
+ *
+ * @return the sharded cagra index
+ */
+template <typename T,
+          typename IdxT = uint32_t,
+          typename Accessor =
+            host_device_accessor<std::experimental::default_accessor<T>, memory_type::host>>
+auto build_sharded(const index_params& params,
+                   const std::vector<int>& device_ids,
+                   mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset)
+  -> sharded_index<T, IdxT>
+{
+  return detail::build_sharded<T, IdxT, Accessor>(params, device_ids, dataset);
+}
+
+/**
+ * @brief Search a sharded CAGRA index.
+ *
+ * The queries are searched concurrently in all shards, and the per-shard results are merged into
+ * the global top-k on the device of `res` with `knn_merge_parts`. The returned neighbor ids refer
+ * to the rows of the whole dataset the index was built from.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   cagra::search_params search_params;
+ *   auto neighbors = raft::make_device_matrix<int64_t, int64_t>(res, n_queries, k);
+ *   auto distances = raft::make_device_matrix<float, int64_t>(res, n_queries, k);
+ *   cagra::search_sharded(res, search_params, index, queries, neighbors.view(), distances.view());
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the local indices of a shard
+ *
+ * @param[in] res raft resources of the device receiving the results
+ * @param[in] params configure the search of every shard
+ * @param[in] idx sharded cagra index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, idx.dim()]
+ * @param[out] neighbors a device matrix view to the global indices of the neighbors [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors
+ * [n_queries, k]
+ */
+template <typename T, typename IdxT>
+void search_sharded(raft::resources const& res,
+                    const search_params& params,
+                    const sharded_index<T, IdxT>& idx,
+                    raft::device_matrix_view<const T, int64_t, row_major> queries,
+                    raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+                    raft::device_matrix_view<float, int64_t, row_major> distances)
+{
+  detail::search_sharded<T, IdxT>(res, params, idx, queries, neighbors, distances);
+}
+
 /**
  * @brief Search ANN using the constructed index with the given sample filter.
  *
@@ -352,6 +629,57 @@ void search_with_filtering(raft::resources const& res,
     res, params, idx, queries_internal, neighbors_internal, distances_internal, sample_filter);
 }
 
+/**
+ * @brief Search ANN using the constructed index with the given sample filter, reusing the search
+ * plan and the temporary buffers cached in the workspace.
+ *
+ * See [cagra::search_workspace](#cagra::search_workspace) for the details.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @tparam CagraSampleFilterT Device filter function, with the signature
+ *         `(uint32_t query ix, uint32_t sample_ix) -> bool`
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx cagra index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ * @param[inout] workspace the search state kept between the calls
+ * @param[in] sample_filter a device filter function that greenlights samples for a given query
+ */
+template <typename T, typename IdxT, typename CagraSampleFilterT>
+void search_with_filtering(raft::resources const& res,
+                           const search_params& params,
+                           const index<T, IdxT>& idx,
+                           raft::device_matrix_view<const T, int64_t, row_major> queries,
+                           raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                           raft::device_matrix_view<float, int64_t, row_major> distances,
+                           search_workspace& workspace,
+                           CagraSampleFilterT sample_filter)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  using internal_IdxT     = typename std::make_unsigned<IdxT>::type;
+  auto neighbors_internal = raft::make_device_matrix_view<internal_IdxT, int64_t, row_major>(
+    reinterpret_cast<internal_IdxT*>(neighbors.data_handle()),
+    neighbors.extent(0),
+    neighbors.extent(1));
+
+  return cagra::detail::search_main<T, internal_IdxT, CagraSampleFilterT, IdxT>(
+    res, params, idx, queries, neighbors_internal, distances, sample_filter, &workspace);
+}
+
 /**
  * @brief Search ANN using the constructed index.
  *
@@ -382,6 +710,105 @@ void search(raft::resources const& res,
     res, params, idx, queries, neighbors, distances, none_filter_type{});
 }
 
+/**
+ * @brief Search ANN using the constructed index, reusing the search plan and the temporary buffers
+ * cached in the workspace.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   cagra::search_params search_params;
+ *   search_params.max_queries = max_batch_size;
+ *   cagra::search_workspace workspace;
+ *   // the first call allocates the workspace, the following ones do not allocate memory
+ *   cagra::search(res, search_params, index, queries, neighbors, distances, workspace);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx cagra index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ * @param[inout] workspace the search state kept between the calls
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index<T, IdxT>& idx,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::device_matrix_view<float, int64_t, row_major> distances,
+            search_workspace& workspace)
+{
+  using none_filter_type = raft::neighbors::filtering::none_cagra_sample_filter;
+  return cagra::search_with_filtering<T, IdxT, none_filter_type>(
+    res, params, idx, queries, neighbors, distances, workspace, none_filter_type{});
+}
+
+/**
+ * @brief Prepare the search plan in the workspace without searching.
+ *
+ * This is the setup step of a search captured in a CUDA graph: all the host-side decisions and
+ * the memory allocations of the search are done here, so that the following calls of
+ * `cagra::search` (or `cagra::search_with_filtering`) with the same workspace, parameters, index,
+ * number of queries and k are capture-safe. A captured search that does not find its plan in the
+ * workspace throws.
+ *
+ * Note, the multi-kernel search cannot terminate early while captured and always runs
+ * `max_iterations` iterations; the persistent search cannot be captured at all.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   cagra::search_workspace workspace;
+ *   cagra::prepare_search(res, search_params, index, n_queries, k, workspace);
+ *   auto stream = raft::resource::get_cuda_stream(res);
+ *   cudaGraph_t graph;
+ *   cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal);
+ *   cagra::search(res, search_params, index, queries, neighbors, distances, workspace);
+ *   cudaStreamEndCapture(stream, &graph);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @tparam CagraSampleFilterT Device filter function, with the signature
+ *         `(uint32_t query ix, uint32_t sample_ix) -> bool`
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx cagra index
+ * @param[in] n_queries number of queries of the search
+ * @param[in] k number of neighbors of the search
+ * @param[inout] workspace the workspace receiving the search plan
+ * @param[in] sample_filter the filter the search is going to be called with (only its type matters)
+ */
+template <typename T,
+          typename IdxT,
+          typename CagraSampleFilterT = raft::neighbors::filtering::none_cagra_sample_filter>
+void prepare_search(raft::resources const& res,
+                    const search_params& params,
+                    const index<T, IdxT>& idx,
+                    int64_t n_queries,
+                    int64_t k,
+                    search_workspace& workspace,
+                    CagraSampleFilterT sample_filter = CagraSampleFilterT())
+{
+  RAFT_EXPECTS(n_queries > 0, "The number of queries must be positive");
+  using internal_IdxT = typename std::make_unsigned<IdxT>::type;
+  // Only the shapes of the arguments are used to prepare the plan.
+  auto queries   = raft::make_device_matrix_view<const T, int64_t>(nullptr, n_queries, idx.dim());
+  auto neighbors = raft::make_device_matrix_view<internal_IdxT, int64_t>(nullptr, n_queries, k);
+  auto distances = raft::make_device_matrix_view<float, int64_t>(nullptr, n_queries, k);
+  cagra::detail::search_main<T, internal_IdxT, CagraSampleFilterT, IdxT>(
+    res, params, idx, queries, neighbors, distances, sample_filter, &workspace, true);
+}
+
 /** @} */  // end group cagra
 
 }  // namespace raft::neighbors::cagra
@@ -390,7 +817,12 @@ void search(raft::resources const& res,
 namespace raft::neighbors::experimental::cagra {
 using raft::neighbors::cagra::build;
 using raft::neighbors::cagra::build_knn_graph;
+using raft::neighbors::cagra::build_sharded;
+using raft::neighbors::cagra::compact;
+using raft::neighbors::cagra::extend;
 using raft::neighbors::cagra::optimize;
+using raft::neighbors::cagra::remove;
 using raft::neighbors::cagra::search;
+using raft::neighbors::cagra::search_sharded;
 using raft::neighbors::cagra::sort_knn_graph;
 }  // namespace raft::neighbors::experimental::cagra
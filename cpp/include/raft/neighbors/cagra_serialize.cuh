@@ -49,15 +49,19 @@ namespace raft::neighbors::cagra {
  * @param[in] os output stream
  * @param[in] index CAGRA index
  * @param[in] include_dataset Whether or not to write out the dataset to the file.
+ * @param[in] compress_graph Whether to write the graph with bit-packed ids (see
+ *   cagra::compress_graph); the packing and the unpacking at load time run on the device. A graph
+ *   already compressed in the index is always written bit-packed.
  *
  */
 template <typename T, typename IdxT>
 void serialize(raft::resources const& handle,
                std::ostream& os,
                const index<T, IdxT>& index,
-               bool include_dataset = true)
+               bool include_dataset = true,
+               bool compress_graph  = false)
 {
-  detail::serialize(handle, os, index, include_dataset);
+  detail::serialize(handle, os, index, include_dataset, compress_graph);
 }
 
 /**
@@ -84,19 +88,29 @@ void serialize(raft::resources const& handle,
  * @param[in] filename the file name for saving the index
  * @param[in] index CAGRA index
  * @param[in] include_dataset Whether or not to write out the dataset to the file.
+ * @param[in] compress_graph Whether to write the graph with bit-packed ids (see
+ *   cagra::compress_graph); the packing and the unpacking at load time run on the device. A graph
+ *   already compressed in the index is always written bit-packed.
  *
  */
 template <typename T, typename IdxT>
 void serialize(raft::resources const& handle,
                const std::string& filename,
                const index<T, IdxT>& index,
-               bool include_dataset = true)
+               bool include_dataset = true,
+               bool compress_graph  = false)
 {
-  detail::serialize(handle, filename, index, include_dataset);
+  detail::serialize(handle, filename, index, include_dataset, compress_graph);
 }
 
 /**
- * Write the CAGRA built index as a base layer HNSW index to an output stream
+ * Write the CAGRA built index as an HNSW index to an output stream
+ *
+ * The CAGRA graph is written as the base layer of the hnswlib index. If `include_hierarchy`, the
+ * upper layers are built as well, on the GPU: the levels of the nodes are sampled as in hnswlib and
+ * every upper level is linked by a brute-force kNN search over its nodes. The result is a complete
+ * hnswlib index, which hnswlib searches from the entry point of the top layer. Otherwise, the
+ * index contains only the base layer, which is searched from evenly spaced seeds.
  *
  * Experimental, both the API and the serialization format are subject to change.
  *
@@ -118,18 +132,22 @@ void serialize(raft::resources const& handle,
  * @param[in] handle the raft handle
  * @param[in] os output stream
  * @param[in] index CAGRA index
+ * @param[in] include_hierarchy whether to build and write the upper layers of the HNSW index
  *
  */
 template <typename T, typename IdxT>
 void serialize_to_hnswlib(raft::resources const& handle,
                           std::ostream& os,
-                          const raft::neighbors::cagra::index<T, IdxT>& index)
+                          const raft::neighbors::cagra::index<T, IdxT>& index,
+                          bool include_hierarchy = true)
 {
-  detail::serialize_to_hnswlib<T, IdxT>(handle, os, index);
+  detail::serialize_to_hnswlib<T, IdxT>(handle, os, index, include_hierarchy);
 }
 
 /**
- * Save a CAGRA build index in hnswlib base-layer-only serialized format
+ * Save a CAGRA build index in hnswlib serialized format
+ *
+ * The upper layers are included as in the stream overload above, if `include_hierarchy`.
  *
  * Experimental, both the API and the serialization format are subject to change.
  *
@@ -151,14 +169,16 @@ void serialize_to_hnswlib(raft::resources const& handle,
  * @param[in] handle the raft handle
  * @param[in] filename the file name for saving the index
  * @param[in] index CAGRA index
+ * @param[in] include_hierarchy whether to build and write the upper layers of the HNSW index
  *
  */
 template <typename T, typename IdxT>
 void serialize_to_hnswlib(raft::resources const& handle,
                           const std::string& filename,
-                          const raft::neighbors::cagra::index<T, IdxT>& index)
+                          const raft::neighbors::cagra::index<T, IdxT>& index,
+                          bool include_hierarchy = true)
 {
-  detail::serialize_to_hnswlib<T, IdxT>(handle, filename, index);
+  detail::serialize_to_hnswlib<T, IdxT>(handle, filename, index, include_hierarchy);
 }
 
 /**
@@ -225,6 +245,86 @@ index<T, IdxT> deserialize(raft::resources const& handle, const std::string& fil
   return detail::deserialize<T, IdxT>(handle, filename);
 }
 
+/**
+ * Save the index to file in a layout that can be memory-mapped by `deserialize_mmap`.
+ *
+ * The graph and the dataset are stored raw, at page-aligned offsets, so that loading the index
+ * does not need to parse the file. Only an uncompressed dataset (no VPQ) can be included, and the
+ * index must not contain removed samples.
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * @code{.cpp}
+ * #include <raft/core/resources.hpp>
+ * #include <raft/neighbors/cagra_serialize.cuh>
+ *
+ * raft::resources handle;
+ *
+ * // create a string with a filepath
+ * std::string filename("/path/to/index");
+ * // create an index with `auto index = raft::neighbors::cagra::build(...);`
+ * raft::neighbors::cagra::serialize_mmap(handle, filename, index);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle the raft handle
+ * @param[in] filename the file name for saving the index
+ * @param[in] index CAGRA index
+ * @param[in] include_dataset Whether or not to write out the dataset to the file.
+ */
+template <typename T, typename IdxT>
+void serialize_mmap(raft::resources const& handle,
+                    const std::string& filename,
+                    const index<T, IdxT>& index,
+                    bool include_dataset = true)
+{
+  detail::serialize_mmap(handle, filename, index, include_dataset);
+}
+
+/**
+ * Load an index saved by `serialize_mmap` by memory-mapping the file.
+ *
+ * The graph is copied to the device through pinned staging buffers, or read directly into device
+ * memory with GPUDirect Storage when raft is built with `RAFT_CUFILE` and the file system supports
+ * it. With `mmap_dataset_mode::HOST_MAPPED`, the dataset is not copied: the mapped pages are registered
+ * with CUDA and the index reads them over the PCIe bus. The mapping stays alive as long as the
+ * index holds the dataset.
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * @code{.cpp}
+ * #include <raft/core/resources.hpp>
+ * #include <raft/neighbors/cagra_serialize.cuh>
+ *
+ * raft::resources handle;
+ *
+ * // create a string with a filepath
+ * std::string filename("/path/to/index");
+ * using T    = float; // data element type
+ * using IdxT = uint32_t; // type of the index
+ * auto index = raft::neighbors::cagra::deserialize_mmap<T, IdxT>(
+ *   handle, filename, raft::neighbors::cagra::mmap_dataset_mode::HOST_MAPPED);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle the raft handle
+ * @param[in] filename the name of the file that stores the index
+ * @param[in] dataset_mode where to keep the dataset of the loaded index
+ *
+ * @return raft::neighbors::cagra::index<T, IdxT>
+ */
+template <typename T, typename IdxT>
+index<T, IdxT> deserialize_mmap(raft::resources const& handle,
+                                const std::string& filename,
+                                mmap_dataset_mode dataset_mode = mmap_dataset_mode::DEVICE)
+{
+  return detail::deserialize_mmap<T, IdxT>(handle, filename, dataset_mode);
+}
+
 /**@}*/
 
 }  // namespace raft::neighbors::cagra
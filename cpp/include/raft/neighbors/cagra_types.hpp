@@ -19,7 +19,9 @@
 #include "ann_types.hpp"
 #include "dataset.hpp"
 
+#include <raft/core/bitset.hpp>
 #include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_setter.hpp>
 #include <raft/core/error.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/logger.hpp>
@@ -36,6 +38,9 @@
 #include <optional>
 #include <string>
 #include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
 
 namespace raft::neighbors::cagra {
 /**
@@ -63,6 +68,19 @@ struct index_params : ann::index_params {
   graph_build_algo build_algo = graph_build_algo::IVF_PQ;
   /** Number of Iterations to run if building with NN_DESCENT */
   size_t nn_descent_niter = 20;
+  /**
+   * Build the graph out-of-core, for datasets whose graph does not fit into the device memory.
+   *
+   * The dataset and the intermediate graph stay in host memory and are accessed by the GPU
+   * in batches, or directly through page-locked mappings. Only per-batch buffers are allocated
+   * on the device. The dataset may be backed by a memory-mapped file. The host memory must
+   * accommodate the intermediate graph and, if it is not memory-mapped, the dataset.
+   *
+   * This mode trades build time for device memory and requires the IVF_PQ build algorithm.
+   * Consider combining it with `compression` or with building the index without the dataset,
+   * since otherwise the whole dataset is copied into the resulting index.
+   */
+  bool out_of_core = false;
   /**
    * Specify compression params if compression is desired.
    *
@@ -82,6 +100,17 @@ enum class search_algo {
 
 enum class hash_mode { HASH, SMALL, AUTO };
 
+/** Placement of the dataset of an index loaded by `cagra::deserialize_mmap`. */
+enum class mmap_dataset_mode {
+  /** Copy the dataset into the device memory. */
+  DEVICE,
+  /**
+   * Keep the dataset in the mapped file, page-locked and read by the device over the PCIe bus.
+   * This loads fast and spares the device memory, at the cost of a slower search.
+   */
+  HOST_MAPPED
+};
+
 struct search_params : ann::search_params {
   /** Maximum number of queries to search at the same time (batch size). Auto select when 0.*/
   size_t max_queries = 0;
@@ -124,10 +153,123 @@ struct search_params : ann::search_params {
   uint32_t num_random_samplings = 1;
   /** Bit mask used for initial random seed node selection. */
   uint64_t rand_xor_mask = 0x128394;
+
+  /**
+   * Whether to use the persistent version of the kernel (only SINGLE_CTA is supported).
+   *
+   * The persistent kernel stays resident on the GPU and serves the queries submitted by any number
+   * of host threads, hence it avoids the kernel launch latency of the small batches (one query per
+   * thread). Note, it occupies all the SMs of the device while running, so any other work on the
+   * same GPU is slowed down considerably until it stops. Device-wide synchronizing calls (such as
+   * cudaDeviceSynchronize or cudaFree) wait for the kernel to stop after `persistent_lifetime`.
+   *
+   * The search call is blocking in this mode (the stream of the resources handle is synchronized
+   * before and the results are ready on return).
+   *
+   * NOTE: this is experimental new API, consider it unsafe.
+   */
+  bool persistent = false;
+  /** Idle time in seconds after which the persistent kernel is stopped. */
+  float persistent_lifetime = 2;
+};
+
+struct extend_params {
+  /**
+   * The additional dataset is divided into chunks and added to the graph. This is the knob to
+   * adjust the tradeoff between the recall and operation throughput. Large chunk sizes can result
+   * in high throughput, but use more working memory (O(max_chunk_size*degree^2)). This can also
+   * degrade recall because no edges are added between the nodes in the same chunk. Auto select
+   * when 0.
+   */
+  uint32_t max_chunk_size = 0;
+};
+
+/** Parameters of `cagra::reorder`. */
+struct reorder_params {
+  /**
+   * The mean number of the nodes per cluster: the dataset is clustered into
+   * `ceil(size / cluster_size)` balanced clusters, whose nodes are stored next to each other.
+   */
+  uint32_t cluster_size = 1024;
+  /** The fraction of the dataset used to train the clusters. */
+  double kmeans_trainset_fraction = 0.1;
+  /** The number of the k-means iterations. */
+  uint32_t kmeans_n_iters = 20;
 };
 
 static_assert(std::is_aggregate_v<index_params>);
 static_assert(std::is_aggregate_v<search_params>);
+static_assert(std::is_aggregate_v<extend_params>);
+static_assert(std::is_aggregate_v<reorder_params>);
+
+/**
+ * @brief Reusable state of the CAGRA search.
+ *
+ * Every search call prepares a search plan and allocates its temporary buffers (hashmap, top-k
+ * workspace, intermediate results). When a workspace is passed to `cagra::search`, the plan of the
+ * first call is kept in it and reused by the following calls with the same configuration (search
+ * parameters, index dimensionality and graph degree, k, data and filter types). In the steady state
+ * the search then performs no memory allocation. A change of the configuration silently replaces
+ * the cached plan. To capture the search in a CUDA graph, prepare the workspace with
+ * `cagra::prepare_search` first.
+ *
+ * Note, with `search_params::max_queries = 0` the batch size is set by the first call; set it
+ * explicitly to the largest expected batch to size the workspace once.
+ *
+ * A workspace must not be used by several searches at the same time and must be used on the same
+ * device.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   cagra::search_params search_params;
+ *   search_params.max_queries = 8;
+ *   cagra::search_workspace workspace;
+ *   for (auto& batch : batches) {
+ *     // Only the first call allocates memory.
+ *     cagra::search(res, search_params, index, batch.queries, batch.neighbors, batch.distances,
+ *                   workspace);
+ *   }
+ * @endcode
+ */
+class search_workspace {
+ public:
+  search_workspace() = default;
+
+  search_workspace(const search_workspace&)                    = delete;
+  search_workspace(search_workspace&&)                         = default;
+  auto operator=(const search_workspace&) -> search_workspace& = delete;
+  auto operator=(search_workspace&&) -> search_workspace&      = default;
+  ~search_workspace()                                          = default;
+
+  /** Whether the workspace holds a search plan (i.e. it has been used by a search). */
+  [[nodiscard]] inline auto empty() const noexcept -> bool { return plan_ == nullptr; }
+
+  /** Release the cached search plan and its buffers. */
+  inline void reset() noexcept { plan_.reset(); }
+
+  /** The cached search plan, if it is of the type `PlanT`, or nullptr otherwise (internal). */
+  template <typename PlanT>
+  [[nodiscard]] auto plan() noexcept -> PlanT*
+  {
+    return plan_type_ == typeid(PlanT) ? static_cast<PlanT*>(plan_.get()) : nullptr;
+  }
+
+  /** Replace the cached search plan (internal). */
+  template <typename PlanT>
+  auto set_plan(std::unique_ptr<PlanT>&& plan) -> PlanT*
+  {
+    plan_.reset();
+    plan_type_ = typeid(PlanT);
+    plan_      = plan_ptr_type(plan.release(), [](void* p) { delete static_cast<PlanT*>(p); });
+    return static_cast<PlanT*>(plan_.get());
+  }
+
+ private:
+  using plan_ptr_type = std::unique_ptr<void, void (*)(void*)>;
+
+  plan_ptr_type plan_{nullptr, [](void*) {}};
+  std::type_index plan_type_{typeid(void)};
+};
 
 /**
  * @brief CAGRA index.
@@ -186,13 +328,42 @@ struct index : ann::index {
     return *dataset_;
   }
 
-  /** neighborhood graph [size, graph-degree] */
+  /**
+   * neighborhood graph [size, graph-degree]
+   *
+   * If the graph is compressed (`graph_id_bits() > 0`), the view points at the bit-packed rows
+   * (see cagra::compress_graph) and cannot be read as a dense matrix.
+   */
   [[nodiscard]] inline auto graph() const noexcept
     -> device_matrix_view<const IdxT, int64_t, row_major>
   {
     return graph_view_;
   }
 
+  /** The number of bits per id of the compressed graph, or zero if the graph is dense. */
+  [[nodiscard]] constexpr inline auto graph_id_bits() const noexcept -> uint32_t
+  {
+    return graph_id_bits_;
+  }
+
+  /** Number of samples marked as removed (see cagra::remove); these are skipped by the search. */
+  [[nodiscard]] constexpr inline auto num_removed() const noexcept -> IdxT { return num_removed_; }
+
+  /**
+   * Bitset of the removed samples [size]: a cleared bit marks a removed sample.
+   * Empty if no samples have been removed since the index was built or compacted.
+   */
+  [[nodiscard]] inline auto removed_bitset() const noexcept
+    -> const std::optional<raft::core::bitset<uint32_t, IdxT>>&
+  {
+    return removed_;
+  }
+  [[nodiscard]] inline auto removed_bitset() noexcept
+    -> std::optional<raft::core::bitset<uint32_t, IdxT>>&
+  {
+    return removed_;
+  }
+
   // Don't allow copying the index for performance reasons (try avoiding copying data)
   index(const index&)                    = delete;
   index(index&&)                         = default;
@@ -328,6 +499,19 @@ struct index : ann::index {
     dataset_ = std::move(dataset);
   }
 
+  /**
+   * Replace the bitset of the removed samples.
+   *
+   * @param removed the new bitset of the index size, or std::nullopt if no samples are removed
+   * @param num_removed the number of cleared bits in the bitset
+   */
+  void update_removed(std::optional<raft::core::bitset<uint32_t, IdxT>>&& removed,
+                      IdxT num_removed)
+  {
+    removed_     = std::move(removed);
+    num_removed_ = removed_.has_value() ? num_removed : IdxT{0};
+  }
+
   /**
    * Replace the graph with a new graph.
    *
@@ -337,9 +521,23 @@ struct index : ann::index {
   void update_graph(raft::resources const& res,
                     raft::device_matrix_view<const IdxT, int64_t, row_major> knn_graph)
   {
+    reset_packed_graph();
     graph_view_ = knn_graph;
   }
 
+  /**
+   * Replace the graph with a new graph.
+   *
+   * The index takes the ownership of the device array.
+   */
+  void update_graph(raft::resources const& res,
+                    raft::device_matrix<IdxT, int64_t, row_major>&& knn_graph)
+  {
+    reset_packed_graph();
+    graph_      = std::move(knn_graph);
+    graph_view_ = graph_.view();
+  }
+
   /**
    * Replace the graph with a new graph.
    *
@@ -349,6 +547,7 @@ struct index : ann::index {
                     raft::host_matrix_view<const IdxT, int64_t, row_major> knn_graph)
   {
     RAFT_LOG_DEBUG("Copying CAGRA knn graph from host to device");
+    reset_packed_graph();
     if ((graph_.extent(0) != knn_graph.extent(0)) || (graph_.extent(1) != knn_graph.extent(1))) {
       // clear existing memory before allocating to prevent OOM errors on large graphs
       if (graph_.size()) { graph_ = make_device_matrix<IdxT, int64_t>(res, 0, 0); }
@@ -361,11 +560,112 @@ struct index : ann::index {
     graph_view_ = graph_.view();
   }
 
+  /**
+   * Replace the graph with a bit-packed graph of `n_rows` rows of `graph_degree` ids of
+   * `graph_id_bits` bits (see cagra::compress_graph). The dense graph owned by the index, if any,
+   * is released.
+   */
+  void update_graph(raft::resources const& res,
+                    raft::device_vector<uint32_t, int64_t>&& packed_graph,
+                    int64_t n_rows,
+                    uint32_t graph_degree,
+                    uint32_t graph_id_bits)
+  {
+    RAFT_EXPECTS(graph_id_bits > 0 && graph_id_bits <= 32, "graph_id_bits must be in [1, 32]");
+    graph_         = make_device_matrix<IdxT, int64_t>(res, 0, 0);
+    packed_graph_  = std::move(packed_graph);
+    graph_id_bits_ = graph_id_bits;
+    graph_view_    = make_device_matrix_view<const IdxT, int64_t>(
+      reinterpret_cast<const IdxT*>(packed_graph_->data_handle()), n_rows, graph_degree);
+  }
+
  private:
+  void reset_packed_graph()
+  {
+    packed_graph_.reset();
+    graph_id_bits_ = 0;
+  }
+
   raft::distance::DistanceType metric_;
   raft::device_matrix<IdxT, int64_t, row_major> graph_;
   raft::device_matrix_view<const IdxT, int64_t, row_major> graph_view_;
+  std::optional<raft::device_vector<uint32_t, int64_t>> packed_graph_;
+  uint32_t graph_id_bits_ = 0;
   std::unique_ptr<neighbors::dataset<int64_t>> dataset_;
+  std::optional<raft::core::bitset<uint32_t, IdxT>> removed_;
+  IdxT num_removed_ = 0;
+};
+
+/**
+ * @brief CAGRA index partitioned across multiple GPUs.
+ *
+ * The dataset is split into contiguous row ranges, one per device; each shard is an independent
+ * CAGRA index residing on its device. The local ids of a shard are translated to the global
+ * dataset ids by adding the shard offset.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the local indices of a shard
+ */
+template <typename T, typename IdxT>
+struct sharded_index : ann::index {
+  static_assert(!raft::is_narrowing_v<uint32_t, IdxT>,
+                "IdxT must be able to represent all values of uint32_t");
+
+ public:
+  sharded_index(std::vector<int> device_ids,
+                std::vector<index<T, IdxT>>&& shards,
+                std::vector<int64_t> offsets)
+    : device_ids_(std::move(device_ids)), shards_(std::move(shards)), offsets_(std::move(offsets))
+  {
+    RAFT_EXPECTS(device_ids_.size() == shards_.size() && offsets_.size() == shards_.size() + 1,
+                 "Each shard must have a device id and an offset");
+  }
+
+  sharded_index(const sharded_index&)                    = delete;
+  sharded_index(sharded_index&&)                         = default;
+  auto operator=(const sharded_index&) -> sharded_index& = delete;
+  auto operator=(sharded_index&&) -> sharded_index&      = default;
+  ~sharded_index() noexcept
+  {
+    // Release the memory of each shard on its own device.
+    while (!shards_.empty()) {
+      raft::device_setter dev(device_ids_[shards_.size() - 1]);
+      shards_.pop_back();
+    }
+  }
+
+  /** Number of shards (devices). */
+  [[nodiscard]] inline auto n_shards() const noexcept -> size_t { return shards_.size(); }
+  /** Total number of vectors in the index. */
+  [[nodiscard]] inline auto size() const noexcept -> int64_t { return offsets_.back(); }
+  /** Dimensionality of the data. */
+  [[nodiscard]] inline auto dim() const noexcept -> uint32_t { return shards_.front().dim(); }
+  /** Distance metric used for clustering. */
+  [[nodiscard]] inline auto metric() const noexcept -> raft::distance::DistanceType
+  {
+    return shards_.front().metric();
+  }
+  /** Ids of the devices holding the shards [n_shards]. */
+  [[nodiscard]] inline auto device_ids() const noexcept -> const std::vector<int>&
+  {
+    return device_ids_;
+  }
+  /** Global id of the first vector of each shard, followed by the index size [n_shards + 1]. */
+  [[nodiscard]] inline auto offsets() const noexcept -> const std::vector<int64_t>&
+  {
+    return offsets_;
+  }
+  /** The index of a shard; it resides on the device `device_ids()[i]`. */
+  [[nodiscard]] inline auto shard(size_t i) noexcept -> index<T, IdxT>& { return shards_[i]; }
+  [[nodiscard]] inline auto shard(size_t i) const noexcept -> const index<T, IdxT>&
+  {
+    return shards_[i];
+  }
+
+ private:
+  std::vector<int> device_ids_;
+  std::vector<index<T, IdxT>> shards_;
+  std::vector<int64_t> offsets_;
 };
 
 /** @} */
@@ -374,10 +674,13 @@ struct index : ann::index {
 
 // TODO: Remove deprecated experimental namespace in 23.12 release
 namespace raft::neighbors::experimental::cagra {
+using raft::neighbors::cagra::extend_params;
 using raft::neighbors::cagra::graph_build_algo;
 using raft::neighbors::cagra::hash_mode;
 using raft::neighbors::cagra::index;
 using raft::neighbors::cagra::index_params;
 using raft::neighbors::cagra::search_algo;
 using raft::neighbors::cagra::search_params;
+using raft::neighbors::cagra::search_workspace;
+using raft::neighbors::cagra::sharded_index;
 }  // namespace raft::neighbors::experimental::cagra
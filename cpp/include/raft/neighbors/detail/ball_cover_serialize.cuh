@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/mdspan_numpy_serializer.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/core/serialize.hpp>
+#include <raft/neighbors/ball_cover_types.hpp>
+
+#include <fstream>
+#include <string>
+
+namespace raft::neighbors::ball_cover::detail {
+
+// Serialization version
+// No backward compatibility yet; that is, can't add additional fields without breaking
+// backward compatibility.
+constexpr int serialization_version = 1;
+
+/**
+ * Save the index to a stream. The points of the index are saved in the order of the landmarks;
+ * their original order is given by the 1-nn index.
+ *
+ * @param[in] handle the raft handle
+ * @param[in] os output stream
+ * @param[in] index_ a built ball cover index
+ */
+template <typename value_idx, typename value_t, typename value_int, typename matrix_idx>
+void serialize(raft::resources const& handle,
+               std::ostream& os,
+               const BallCoverIndex<value_idx, value_t, value_int, matrix_idx>& index_)
+{
+  RAFT_EXPECTS(index_.is_index_trained(), "The index must be built before it is saved");
+  RAFT_LOG_DEBUG("Saving ball cover index, size %zu, dim %zu, landmarks %zu",
+                 static_cast<size_t>(index_.m),
+                 static_cast<size_t>(index_.n),
+                 static_cast<size_t>(index_.n_landmarks));
+
+  std::string dtype_string = raft::detail::numpy_serializer::get_numpy_dtype<value_t>().to_string();
+  dtype_string.resize(4);
+  os << dtype_string;
+
+  serialize_scalar(handle, os, serialization_version);
+  serialize_scalar(handle, os, index_.m);
+  serialize_scalar(handle, os, index_.n);
+  serialize_scalar(handle, os, index_.n_landmarks);
+  serialize_scalar(handle, os, index_.get_metric());
+  serialize_mdspan(handle, os, index_.get_R());
+  serialize_mdspan(handle, os, index_.get_R_radius());
+  serialize_mdspan(handle, os, index_.get_R_indptr());
+  serialize_mdspan(handle, os, index_.get_R_1nn_cols());
+  serialize_mdspan(handle, os, index_.get_R_1nn_dists());
+  serialize_mdspan(handle, os, index_.get_R_closest_landmark_dists());
+  serialize_mdspan(handle, os, index_.get_X_reordered());
+  resource::sync_stream(handle);
+}
+
+template <typename value_idx, typename value_t, typename value_int, typename matrix_idx>
+void serialize(raft::resources const& handle,
+               const std::string& filename,
+               const BallCoverIndex<value_idx, value_t, value_int, matrix_idx>& index_)
+{
+  std::ofstream of(filename, std::ios::out | std::ios::binary);
+  if (!of) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+
+  detail::serialize(handle, of, index_);
+
+  of.close();
+  if (!of) { RAFT_FAIL("Error writing output %s", filename.c_str()); }
+}
+
+/**
+ * Load an index from a stream.
+ *
+ * @param[in] handle the raft handle
+ * @param[in] is input stream
+ * @param[in] X the points the index was built on, which the index refers to
+ */
+template <typename value_idx, typename value_t, typename value_int, typename matrix_idx>
+auto deserialize(raft::resources const& handle,
+                 std::istream& is,
+                 raft::device_matrix_view<const value_t, matrix_idx, row_major> X)
+  -> BallCoverIndex<value_idx, value_t, value_int, matrix_idx>
+{
+  char dtype_string[4];
+  is.read(dtype_string, 4);
+
+  auto ver = deserialize_scalar<int>(handle, is);
+  if (ver != serialization_version) {
+    RAFT_FAIL("serialization version mismatch, expected %d, got %d ", serialization_version, ver);
+  }
+  auto m           = deserialize_scalar<value_int>(handle, is);
+  auto n           = deserialize_scalar<value_int>(handle, is);
+  auto n_landmarks = deserialize_scalar<value_int>(handle, is);
+  auto metric      = deserialize_scalar<raft::distance::DistanceType>(handle, is);
+  RAFT_EXPECTS(static_cast<value_int>(X.extent(0)) == m && static_cast<value_int>(X.extent(1)) == n,
+               "The points must have the shape of the saved index (%zu x %zu)",
+               static_cast<size_t>(m),
+               static_cast<size_t>(n));
+
+  BallCoverIndex<value_idx, value_t, value_int, matrix_idx> index_(handle, X, n_landmarks, metric);
+
+  deserialize_mdspan(handle, is, index_.get_R());
+  deserialize_mdspan(handle, is, index_.get_R_radius());
+  deserialize_mdspan(handle, is, index_.get_R_indptr());
+  deserialize_mdspan(handle, is, index_.get_R_1nn_cols());
+  deserialize_mdspan(handle, is, index_.get_R_1nn_dists());
+  deserialize_mdspan(handle, is, index_.get_R_closest_landmark_dists());
+  deserialize_mdspan(handle, is, index_.get_X_reordered());
+  resource::sync_stream(handle);
+
+  index_.set_index_trained();
+  return index_;
+}
+
+template <typename value_idx, typename value_t, typename value_int, typename matrix_idx>
+auto deserialize(raft::resources const& handle,
+                 const std::string& filename,
+                 raft::device_matrix_view<const value_t, matrix_idx, row_major> X)
+  -> BallCoverIndex<value_idx, value_t, value_int, matrix_idx>
+{
+  std::ifstream is(filename, std::ios::in | std::ios::binary);
+
+  if (!is) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+
+  auto index_ = detail::deserialize<value_idx, value_t, value_int, matrix_idx>(handle, is, X);
+
+  is.close();
+
+  return index_;
+}
+
+}  // namespace raft::neighbors::ball_cover::detail
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/reduce.cuh>
+#include <raft/matrix/init.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/neighbors/binary_quantized_types.hpp>
+#include <raft/neighbors/refine.cuh>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+
+namespace raft::neighbors::binary_quantized::detail {
+
+/** The maximum number of the Hamming distances kept in the device memory at once. */
+constexpr int64_t kMaxDistanceTileElems = int64_t{1} << 26;
+/** The rows of a host dataset copied to the device at once by `build`. */
+constexpr int64_t kBuildBatchRows = int64_t{1} << 16;
+/** The queries are the y dimension of the grid of `hamming_kernel`. */
+constexpr int64_t kMaxGridY = 65535;
+
+/** Binarize the rows by the thresholds [dim]; one thread per output word. */
+template <typename T>
+RAFT_KERNEL binarize_kernel(const T* data,  // [n_rows, dim]
+                            int64_t n_rows,
+                            uint32_t dim,
+                            const float* thresholds,
+                            uint32_t n_words,
+                            uint64_t* codes)  // [n_rows, n_words]
+{
+  const uint64_t i = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (i >= static_cast<uint64_t>(n_rows) * n_words) { return; }
+  const uint64_t row   = i / n_words;
+  const uint32_t first = (i % n_words) * 64;
+  const uint32_t last  = min(dim, first + 64);
+  const T* x           = data + row * dim;
+  uint64_t code        = 0;
+  for (uint32_t j = first; j < last; j++) {
+    if (static_cast<float>(x[j]) > thresholds[j]) { code |= uint64_t{1} << (j - first); }
+  }
+  codes[i] = code;
+}
+
+/**
+ * The Hamming distances between the query codes and a range of the index codes:
+ * blockIdx.y is the query, the threads run over the codes. The query code is staged in the shared
+ * memory.
+ */
+RAFT_KERNEL hamming_kernel(const uint64_t* query_codes,  // [n_queries, n_words]
+                           const uint64_t* codes,        // [n_rows, n_words]
+                           int64_t n_rows,
+                           uint32_t n_words,
+                           float* distances)  // [n_queries, n_rows]
+{
+  extern __shared__ uint64_t query_code[];
+  const uint64_t q = blockIdx.y;
+  for (uint32_t w = threadIdx.x; w < n_words; w += blockDim.x) {
+    query_code[w] = query_codes[q * n_words + w];
+  }
+  __syncthreads();
+  const int64_t row = threadIdx.x + static_cast<int64_t>(blockDim.x) * blockIdx.x;
+  if (row >= n_rows) { return; }
+  const uint64_t* code = codes + row * n_words;
+  uint32_t d           = 0;
+  for (uint32_t w = 0; w < n_words; w++) {
+    d += __popcll(code[w] ^ query_code[w]);
+  }
+  distances[q * n_rows + row] = static_cast<float>(d);
+}
+
+/** Put the top-k of a tile to its columns of the merge buffers, shifting the ids by the tile. */
+RAFT_KERNEL scatter_tile_kernel(const float* tile_distances,  // [n_queries, k]
+                                const int64_t* tile_ids,      // [n_queries, k]
+                                int64_t n_queries,
+                                uint32_t k,
+                                uint32_t n_tiles,
+                                uint32_t tile,
+                                int64_t tile_offset,
+                                float* distances,  // [n_queries, n_tiles * k]
+                                int64_t* ids)      // [n_queries, n_tiles * k]
+{
+  const int64_t i = threadIdx.x + static_cast<int64_t>(blockDim.x) * blockIdx.x;
+  if (i >= n_queries * k) { return; }
+  const int64_t q   = i / k;
+  const int64_t dst = (q * n_tiles + tile) * k + i % k;
+  distances[dst]    = tile_distances[i];
+  ids[dst]          = tile_ids[i] + tile_offset;
+}
+
+template <typename T>
+void binarize(raft::resources const& res,
+              const T* data,
+              int64_t n_rows,
+              uint32_t dim,
+              const float* thresholds,
+              uint64_t* codes)
+{
+  if (n_rows == 0) { return; }
+  const uint32_t n_words      = raft::div_rounding_up_safe<uint32_t>(dim, 64);
+  constexpr uint32_t kThreads = 256;
+  const auto n_items          = static_cast<uint64_t>(n_rows) * n_words;
+  binarize_kernel<T>
+    <<<raft::ceildiv<uint64_t>(n_items, kThreads), kThreads, 0, resource::get_cuda_stream(res)>>>(
+      data, n_rows, dim, thresholds, n_words, codes);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename T, typename Accessor>
+auto build(raft::resources const& res,
+           const index_params& params,
+           mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset) -> index<T>
+{
+  const int64_t n_rows = dataset.extent(0);
+  const uint32_t dim   = dataset.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "binary_quantized::build(%zu, %u)", size_t(n_rows), dim);
+  auto stream = resource::get_cuda_stream(res);
+
+  index<T> idx(res, params.metric, params.thresholds, n_rows, dim);
+  auto thresholds = idx.thresholds();
+  raft::matrix::fill(res, thresholds, 0.0f);
+
+  using raft::spatial::knn::detail::utils::batch_load_iterator;
+  if (params.thresholds == binarization::kMean && n_rows > 0) {
+    batch_load_iterator<T> batches(dataset.data_handle(), n_rows, dim, kBuildBatchRows, stream);
+    for (const auto& batch : batches) {
+      raft::linalg::reduce(res,
+                           raft::make_device_matrix_view<const T, uint32_t>(
+                             batch.data(), static_cast<uint32_t>(batch.size()), dim),
+                           thresholds,
+                           0.0f,
+                           raft::linalg::Apply::ALONG_ROWS,
+                           true,
+                           raft::cast_op<float>{});
+    }
+    raft::linalg::map(res,
+                      thresholds,
+                      raft::mul_const_op<float>(1.0f / static_cast<float>(n_rows)),
+                      raft::make_const_mdspan(thresholds));
+  }
+
+  batch_load_iterator<T> batches(dataset.data_handle(), n_rows, dim, kBuildBatchRows, stream);
+  for (const auto& batch : batches) {
+    binarize<T>(res,
+                batch.data(),
+                batch.size(),
+                dim,
+                thresholds.data_handle(),
+                idx.codes().data_handle() + batch.offset() * idx.code_words());
+  }
+  return idx;
+}
+
+template <typename T>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index<T>& idx,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+            raft::device_matrix_view<float, int64_t, row_major> distances)
+{
+  const int64_t n_queries = queries.extent(0);
+  const int64_t n_rows    = idx.size();
+  const auto k            = static_cast<uint32_t>(neighbors.extent(1));
+  const uint32_t n_words  = idx.code_words();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "binary_quantized::search(%zu, %u)", size_t(n_queries), k);
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(), "Wrong dimensionality of the queries");
+  RAFT_EXPECTS(neighbors.extent(0) == n_queries && distances.extent(0) == n_queries &&
+                 distances.extent(1) == k,
+               "Wrong shape of the outputs");
+  RAFT_EXPECTS(k > 0 && k <= n_rows, "k must be in the range [1, index.size()]");
+  if (n_queries == 0) { return; }
+  auto stream = resource::get_cuda_stream(res);
+
+  // The queries of a batch are searched against the index by tiles of rows; the top-k of every
+  // tile are merged by another select_k, unless the whole index fits one tile. The batch size
+  // keeps both the tile of the distances [batch, tile_rows] and the merge buffers
+  // [batch, n_tiles * k] within kMaxDistanceTileElems.
+  int64_t batch_queries = kMaxDistanceTileElems / std::sqrt(double(k) * double(n_rows));
+  batch_queries         = std::clamp<int64_t>(batch_queries, 1, kMaxGridY);
+  batch_queries         = std::min(batch_queries, n_queries);
+  if (params.max_queries > 0) {
+    batch_queries = std::min<int64_t>(batch_queries, params.max_queries);
+  }
+  const int64_t min_tile_rows = std::max<int64_t>(k, kMaxDistanceTileElems / batch_queries);
+  const auto n_tiles = static_cast<uint32_t>(std::max<int64_t>(1, n_rows / min_tile_rows));
+  const int64_t max_tile_rows = raft::ceildiv<int64_t>(n_rows, n_tiles);
+
+  auto query_codes = raft::make_device_matrix<uint64_t, int64_t>(res, batch_queries, n_words);
+  auto tile_dists  = raft::make_device_matrix<float, int64_t>(res, batch_queries, max_tile_rows);
+  std::optional<raft::device_matrix<float, int64_t>> topk_dists;
+  std::optional<raft::device_matrix<int64_t, int64_t>> topk_ids;
+  std::optional<raft::device_matrix<float, int64_t>> merge_dists;
+  std::optional<raft::device_matrix<int64_t, int64_t>> merge_ids;
+  if (n_tiles > 1) {
+    topk_dists  = raft::make_device_matrix<float, int64_t>(res, batch_queries, k);
+    topk_ids    = raft::make_device_matrix<int64_t, int64_t>(res, batch_queries, k);
+    merge_dists = raft::make_device_matrix<float, int64_t>(res, batch_queries, n_tiles * k);
+    merge_ids   = raft::make_device_matrix<int64_t, int64_t>(res, batch_queries, n_tiles * k);
+  }
+
+  constexpr uint32_t kThreads = 256;
+  for (int64_t q0 = 0; q0 < n_queries; q0 += batch_queries) {
+    const int64_t nq = std::min(batch_queries, n_queries - q0);
+    binarize<T>(res,
+                queries.data_handle() + q0 * idx.dim(),
+                nq,
+                idx.dim(),
+                idx.thresholds().data_handle(),
+                query_codes.data_handle());
+    auto out_dists =
+      raft::make_device_matrix_view<float, int64_t>(distances.data_handle() + q0 * k, nq, k);
+    auto out_ids =
+      raft::make_device_matrix_view<int64_t, int64_t>(neighbors.data_handle() + q0 * k, nq, k);
+
+    for (uint32_t tile = 0; tile < n_tiles; tile++) {
+      const int64_t row_begin = n_rows * tile / n_tiles;
+      const int64_t tile_rows = n_rows * (tile + 1) / n_tiles - row_begin;
+      const dim3 grid(raft::ceildiv<int64_t>(tile_rows, kThreads), nq);
+      hamming_kernel<<<grid, kThreads, n_words * sizeof(uint64_t), stream>>>(
+        query_codes.data_handle(),
+        idx.codes().data_handle() + row_begin * n_words,
+        tile_rows,
+        n_words,
+        tile_dists.data_handle());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      auto tile_view = raft::make_device_matrix_view<const float, int64_t>(
+        tile_dists.data_handle(), nq, tile_rows);
+      if (n_tiles == 1) {
+        raft::matrix::select_k<float, int64_t>(
+          res, tile_view, std::nullopt, out_dists, out_ids, true, true);
+        continue;
+      }
+      raft::matrix::select_k<float, int64_t>(
+        res,
+        tile_view,
+        std::nullopt,
+        raft::make_device_matrix_view<float, int64_t>(topk_dists->data_handle(), nq, k),
+        raft::make_device_matrix_view<int64_t, int64_t>(topk_ids->data_handle(), nq, k),
+        true);
+      scatter_tile_kernel<<<raft::ceildiv<int64_t>(nq * k, kThreads), kThreads, 0, stream>>>(
+        topk_dists->data_handle(),
+        topk_ids->data_handle(),
+        nq,
+        k,
+        n_tiles,
+        tile,
+        row_begin,
+        merge_dists->data_handle(),
+        merge_ids->data_handle());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+    if (n_tiles > 1) {
+      raft::matrix::select_k<float, int64_t>(
+        res,
+        raft::make_device_matrix_view<const float, int64_t>(
+          merge_dists->data_handle(), nq, n_tiles * k),
+        raft::make_device_matrix_view<const int64_t, int64_t>(
+          merge_ids->data_handle(), nq, n_tiles * k),
+        out_dists,
+        out_ids,
+        true,
+        true);
+    }
+  }
+}
+
+template <typename T>
+void search_refined(raft::resources const& res,
+                    const search_params& params,
+                    const index<T>& idx,
+                    raft::device_matrix_view<const T, int64_t, row_major> dataset,
+                    raft::device_matrix_view<const T, int64_t, row_major> queries,
+                    raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+                    raft::device_matrix_view<float, int64_t, row_major> distances)
+{
+  RAFT_EXPECTS(dataset.extent(0) == idx.size() && dataset.extent(1) == idx.dim(),
+               "The dataset must be the one the index was built from");
+  const int64_t n_queries = queries.extent(0);
+  const int64_t k         = neighbors.extent(1);
+  const int64_t n_candidates =
+    std::min<int64_t>(idx.size(), k * std::max<uint32_t>(1, params.refine_ratio));
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "binary_quantized::search_refined(%zu, %zu, %zu)",
+    size_t(n_queries),
+    size_t(k),
+    size_t(n_candidates));
+
+  auto candidates = raft::make_device_matrix<int64_t, int64_t>(res, n_queries, n_candidates);
+  auto hamming    = raft::make_device_matrix<float, int64_t>(res, n_queries, n_candidates);
+  search<T>(res, params, idx, queries, candidates.view(), hamming.view());
+  raft::neighbors::refine<int64_t, T, float, int64_t>(res,
+                                                      dataset,
+                                                      queries,
+                                                      raft::make_const_mdspan(candidates.view()),
+                                                      neighbors,
+                                                      distances,
+                                                      idx.metric());
+}
+
+}  // namespace raft::neighbors::binary_quantized::detail
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "../../cagra_types.hpp"
+#include "cagra_search.cuh"
+
+#include <raft/core/bitset.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+
+#include <rmm/resource_ref.hpp>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::cagra::detail {
+
+template <class IdxT>
+RAFT_KERNEL kern_count_incoming_edges(const IdxT* const graph,  // [graph_size, degree]
+                                      const uint64_t graph_size,
+                                      const uint32_t degree,
+                                      uint32_t* const num_incoming_edges)  // [graph_size]
+{
+  const uint64_t i = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (i >= graph_size * degree) { return; }
+  const uint64_t dst = graph[i];
+  if (dst < graph_size) { atomicAdd(num_incoming_edges + dst, 1u); }
+}
+
+/**
+ * Insert the nodes of `additional_dataset` into the graph of `idx`.
+ *
+ * The rows [0, idx.size()) of `updated_graph` must contain the current graph of the index; the
+ * rows [idx.size(), idx.size() + additional_dataset.extent(0)) are filled by this function. Some
+ * of the edges of the existing nodes are replaced by the reverse edges pointing at the new nodes.
+ *
+ * For every batch of the new vectors:
+ *
+ *   1. Search `2 * graph_degree` nearest neighbors in the existing index.
+ *   2. Reorder the candidates by the number of 2-hop detours (the same rank-based criterion as in
+ *      `graph::optimize`), which only involves the candidate rows of the graph.
+ *   3. Replace the edge pointing at the most popular node in the second half of the neighbor list
+ *      of a few candidates by a reverse edge to the new node, and interleave the rank-based list of
+ *      the new node with the nodes whose incoming edges have been replaced.
+ */
+template <typename T, typename IdxT, typename Accessor>
+void add_node_core(raft::resources const& res,
+                   const index<T, IdxT>& idx,
+                   mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> additional_dataset,
+                   raft::host_matrix_view<IdxT, int64_t, row_major> updated_graph,
+                   uint32_t max_chunk_size)
+{
+  using internal_IdxT = typename std::make_unsigned<IdxT>::type;
+  using filter_type         = raft::neighbors::filtering::none_cagra_sample_filter;
+  using removed_filter_type = raft::neighbors::filtering::removed_cagra_sample_filter;
+
+  const uint32_t degree      = idx.graph_degree();
+  const uint32_t dim         = idx.dim();
+  const uint64_t old_size    = idx.size();
+  const uint64_t num_add     = additional_dataset.extent(0);
+  const uint64_t new_size    = old_size + num_add;
+  const uint32_t base_degree = std::min<uint64_t>(degree * 2, old_size);
+  auto stream                = resource::get_cuda_stream(res);
+
+  RAFT_EXPECTS(base_degree >= degree,
+               "The index must contain at least 2 * graph_degree (%u) nodes to be extended",
+               2 * degree);
+  RAFT_EXPECTS(updated_graph.extent(0) == static_cast<int64_t>(new_size) &&
+                 updated_graph.extent(1) == degree,
+               "The updated graph must have the shape [idx.size() + num_add, graph_degree]");
+
+  // Number of incoming edges of each node, used to select the edges to be replaced.
+  auto host_num_incoming_edges = raft::make_host_vector<uint32_t, int64_t>(new_size);
+  {
+    auto dev_num_incoming_edges = raft::make_device_vector<uint32_t, int64_t>(res, old_size);
+    RAFT_CUDA_TRY(cudaMemsetAsync(
+      dev_num_incoming_edges.data_handle(), 0, old_size * sizeof(uint32_t), stream));
+    constexpr uint32_t block_size = 256;
+    const uint64_t grid_size      = raft::div_rounding_up_safe<uint64_t>(old_size * degree, 256);
+    kern_count_incoming_edges<<<grid_size, block_size, 0, stream>>>(
+      reinterpret_cast<const internal_IdxT*>(idx.graph().data_handle()),
+      old_size,
+      degree,
+      dev_num_incoming_edges.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    raft::copy(host_num_incoming_edges.data_handle(),
+               dev_num_incoming_edges.data_handle(),
+               old_size,
+               stream);
+  }
+
+  search_params params;
+  params.itopk_size = std::max<size_t>(base_degree * 2, 256);
+
+  rmm::device_async_resource_ref mr = resource::get_workspace_resource(res);
+
+  auto neighbor_indices = raft::make_device_mdarray<internal_IdxT, int64_t>(
+    res, mr, raft::make_extents<int64_t>(max_chunk_size, base_degree));
+  auto neighbor_distances = raft::make_device_mdarray<float, int64_t>(
+    res, mr, raft::make_extents<int64_t>(max_chunk_size, base_degree));
+  auto host_neighbor_indices =
+    raft::make_host_matrix<internal_IdxT, int64_t>(max_chunk_size, base_degree);
+
+  raft::spatial::knn::detail::utils::batch_load_iterator<T> additional_dataset_batch(
+    additional_dataset.data_handle(), num_add, dim, max_chunk_size, stream, mr);
+
+  for (const auto& batch : additional_dataset_batch) {
+    const int64_t batch_size = batch.size();
+
+    // Step 1: obtain `base_degree` nearest neighbors of the new vectors among the existing nodes
+    auto queries_view =
+      raft::make_device_matrix_view<const T, int64_t>(batch.data(), batch_size, dim);
+    auto neighbor_indices_view = raft::make_device_matrix_view<internal_IdxT, int64_t>(
+      neighbor_indices.data_handle(), batch_size, base_degree);
+    auto neighbor_distances_view = raft::make_device_matrix_view<float, int64_t>(
+      neighbor_distances.data_handle(), batch_size, base_degree);
+    if (idx.num_removed() > 0) {
+      // The removed nodes must not become neighbors of the new ones.
+      search_main<T, internal_IdxT, removed_filter_type, IdxT>(
+        res,
+        params,
+        idx,
+        queries_view,
+        neighbor_indices_view,
+        neighbor_distances_view,
+        removed_filter_type{idx.removed_bitset()->data()});
+    } else {
+      search_main<T, internal_IdxT, filter_type, IdxT>(res,
+                                                       params,
+                                                       idx,
+                                                       queries_view,
+                                                       neighbor_indices_view,
+                                                       neighbor_distances_view,
+                                                       filter_type{});
+    }
+    raft::copy(host_neighbor_indices.data_handle(),
+               neighbor_indices.data_handle(),
+               batch_size * base_degree,
+               stream);
+    resource::sync_stream(res);
+
+    // Step 2: rank-based reordering of the candidates (only touches the candidate rows)
+#pragma omp parallel
+    {
+      std::vector<std::pair<IdxT, uint32_t>> detourable_node_count_list(base_degree);
+#pragma omp for
+      for (int64_t vec_i = 0; vec_i < batch_size; vec_i++) {
+        for (uint32_t i = 0; i < base_degree; i++) {
+          uint32_t detourable_node_count = 0;
+          const auto a_id                = host_neighbor_indices(vec_i, i);
+          for (uint32_t j = 0; j < i; j++) {
+            const auto b0_id = host_neighbor_indices(vec_i, j);
+            for (uint32_t k = 0; k < degree; k++) {
+              if (static_cast<uint64_t>(updated_graph(b0_id, k)) == a_id) {
+                detourable_node_count++;
+                break;
+              }
+            }
+          }
+          detourable_node_count_list[i] = std::make_pair(a_id, detourable_node_count);
+        }
+        std::stable_sort(detourable_node_count_list.begin(),
+                         detourable_node_count_list.end(),
+                         [](const auto& a, const auto& b) { return a.second < b.second; });
+        for (uint32_t i = 0; i < degree; i++) {
+          updated_graph(old_size + batch.offset() + vec_i, i) = detourable_node_count_list[i].first;
+        }
+      }
+    }
+
+    // Step 3: add the reverse edges. This modifies the rows of the existing nodes shared between
+    // the new nodes, hence it is done sequentially.
+    const uint32_t rev_edge_search_range = degree / 2;
+    const uint32_t num_rev_edges         = degree / 2;
+    std::vector<IdxT> rev_edges(num_rev_edges);
+    std::vector<IdxT> temp(degree);
+    for (int64_t vec_i = 0; vec_i < batch_size; vec_i++) {
+      const uint64_t target_new_node_id = old_size + batch.offset() + vec_i;
+      uint32_t num_found_rev_edges      = 0;
+      for (uint32_t i = 0; i < num_rev_edges; i++) {
+        const uint64_t target_node_id = updated_graph(target_new_node_id, i);
+
+        uint64_t replace_id                 = new_size;
+        uint32_t replace_id_j               = 0;
+        uint32_t replace_num_incoming_edges = 0;
+        for (int32_t j = degree - 1; j >= static_cast<int32_t>(rev_edge_search_range); j--) {
+          const uint64_t neighbor_id = updated_graph(target_node_id, j);
+          // Do not remove the edges pointing at the nodes inserted by this call
+          if (neighbor_id >= old_size) { continue; }
+          if (std::find(rev_edges.begin(), rev_edges.begin() + num_found_rev_edges, neighbor_id) !=
+              rev_edges.begin() + num_found_rev_edges) {
+            continue;
+          }
+          const uint32_t num_incoming_edges = host_num_incoming_edges(neighbor_id);
+          if (num_incoming_edges > replace_num_incoming_edges) {
+            replace_num_incoming_edges = num_incoming_edges;
+            replace_id                 = neighbor_id;
+            replace_id_j               = j;
+          }
+        }
+        // Only drop an edge if the node stays reachable from elsewhere
+        if (replace_id >= new_size || replace_num_incoming_edges <= 1) { continue; }
+        updated_graph(target_node_id, replace_id_j) = target_new_node_id;
+        host_num_incoming_edges(replace_id)--;
+        rev_edges[num_found_rev_edges++] = replace_id;
+      }
+      host_num_incoming_edges(target_new_node_id) = num_found_rev_edges;
+
+      // Interleave the rank-based neighbor list of the new node with the nodes that have lost an
+      // incoming edge above, so that they stay reachable through the new node.
+      const IdxT* rank_based_list = &updated_graph(target_new_node_id, 0);
+      uint32_t rank_based_i = 0, rev_edges_i = 0, num_added = 0;
+      bool take_rev_edge = false;
+      while (num_added < degree &&
+             (rank_based_i < degree || rev_edges_i < num_found_rev_edges)) {
+        const bool use_rev =
+          rank_based_i >= degree || (take_rev_edge && rev_edges_i < num_found_rev_edges);
+        const IdxT* list   = use_rev ? rev_edges.data() : rank_based_list;
+        uint32_t& list_i   = use_rev ? rev_edges_i : rank_based_i;
+        const uint32_t len = use_rev ? num_found_rev_edges : degree;
+        for (; list_i < len; list_i++) {
+          const auto candidate = list[list_i];
+          if (std::find(temp.begin(), temp.begin() + num_added, candidate) ==
+              temp.begin() + num_added) {
+            temp[num_added++] = candidate;
+            list_i++;
+            break;
+          }
+        }
+        take_rev_edge = !take_rev_edge;
+      }
+      // The existing nodes gain an incoming edge from the new node.
+      for (uint32_t i = 0; i < num_added; i++) {
+        if (static_cast<uint64_t>(temp[i]) < old_size) { host_num_incoming_edges(temp[i])++; }
+      }
+      // Duplicated search results may leave a few slots empty; fill them with the best candidate.
+      for (; num_added < degree; num_added++) {
+        temp[num_added] = rank_based_list[0];
+      }
+      for (uint32_t i = 0; i < degree; i++) {
+        updated_graph(target_new_node_id, i) = temp[i];
+      }
+    }
+    RAFT_LOG_DEBUG("# CAGRA extend: added %zu / %zu nodes",
+                   static_cast<size_t>(batch.offset() + batch_size),
+                   static_cast<size_t>(num_add));
+  }
+}
+
+template <typename T, typename IdxT, typename Accessor>
+void extend(raft::resources const& res,
+            const extend_params& params,
+            mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> additional_dataset,
+            index<T, IdxT>& idx)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::extend(%zu, %u)", static_cast<size_t>(additional_dataset.extent(0)), idx.dim());
+
+  using ds_idx_type  = decltype(idx.data().n_rows());
+  auto* strided_dset = dynamic_cast<const strided_dataset<T, ds_idx_type>*>(&idx.data());
+  RAFT_EXPECTS(strided_dset != nullptr,
+               "cagra::extend only supports an uncompressed dataset attached to the index");
+  RAFT_EXPECTS(additional_dataset.extent(1) == idx.dim(),
+               "The dimensionality of the additional dataset must match the index");
+  RAFT_EXPECTS(idx.graph_id_bits() == 0,
+               "The graph is compressed; call cagra::decompress_graph before extending the index");
+
+  const int64_t num_add  = additional_dataset.extent(0);
+  const int64_t old_size = idx.size();
+  const int64_t new_size = old_size + num_add;
+  const uint32_t degree  = idx.graph_degree();
+  const uint32_t stride  = strided_dset->stride();
+  auto stream            = resource::get_cuda_stream(res);
+  if (num_add == 0) { return; }
+
+  const uint32_t max_chunk_size =
+    params.max_chunk_size == 0 ? std::min<int64_t>(num_add, 1024) : params.max_chunk_size;
+
+  // Copy the current graph to the host and let the new rows be filled by add_node_core.
+  auto updated_graph = raft::make_host_matrix<IdxT, int64_t>(new_size, degree);
+  raft::copy(updated_graph.data_handle(), idx.graph().data_handle(), idx.graph().size(), stream);
+  resource::sync_stream(res);
+
+  add_node_core<T, IdxT, Accessor>(
+    res, idx, additional_dataset, updated_graph.view(), max_chunk_size);
+
+  // Concatenate the old and the new data, keeping the padded layout of the index dataset.
+  auto updated_dataset = raft::make_device_matrix<T, int64_t>(res, new_size, stride);
+  RAFT_CUDA_TRY(
+    cudaMemsetAsync(updated_dataset.data_handle(), 0, updated_dataset.size() * sizeof(T), stream));
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(updated_dataset.data_handle(),
+                                  sizeof(T) * stride,
+                                  strided_dset->view().data_handle(),
+                                  sizeof(T) * stride,
+                                  sizeof(T) * idx.dim(),
+                                  old_size,
+                                  cudaMemcpyDefault,
+                                  stream));
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(updated_dataset.data_handle() + old_size * stride,
+                                  sizeof(T) * stride,
+                                  additional_dataset.data_handle(),
+                                  sizeof(T) * idx.dim(),
+                                  sizeof(T) * idx.dim(),
+                                  num_add,
+                                  cudaMemcpyDefault,
+                                  stream));
+
+  using out_mdarray_type          = decltype(updated_dataset);
+  using out_layout_type           = typename out_mdarray_type::layout_type;
+  using out_container_policy_type = typename out_mdarray_type::container_policy_type;
+  using out_owning_type = owning_dataset<T, int64_t, out_layout_type, out_container_policy_type>;
+  auto out_layout = make_strided_layout(
+    raft::matrix_extent<int64_t>(new_size, idx.dim()), std::array<int64_t, 2>{stride, 1});
+
+  idx.update_dataset(res,
+                     std::make_unique<out_owning_type>(std::move(updated_dataset), out_layout));
+  idx.update_graph(res, raft::make_const_mdspan(updated_graph.view()));
+  if (idx.removed_bitset().has_value()) {
+    // The new samples are not removed.
+    idx.removed_bitset()->resize(res, static_cast<IdxT>(new_size), true);
+  }
+  resource::sync_stream(res);
+}
+
+}  // namespace raft::neighbors::cagra::detail
@@ -164,6 +164,7 @@ void build_knn_graph(raft::resources const& res,
       resource::sync_stream(res);
 
       raft::neighbors::detail::refine_host<int64_t, DataT, float, int64_t>(
+        res,
         dataset,
         queries_host_view,
         neighbors_host_view,
@@ -262,7 +263,8 @@ template <typename IdxT = uint32_t,
             host_device_accessor<std::experimental::default_accessor<IdxT>, memory_type::host>>
 void optimize(raft::resources const& res,
               mdspan<IdxT, matrix_extent<int64_t>, row_major, g_accessor> knn_graph,
-              raft::host_matrix_view<IdxT, int64_t, row_major> new_graph)
+              raft::host_matrix_view<IdxT, int64_t, row_major> new_graph,
+              bool out_of_core = false)
 {
   using internal_IdxT = typename std::make_unsigned<IdxT>::type;
 
@@ -279,7 +281,7 @@ void optimize(raft::resources const& res,
       knn_graph.extent(0),
       knn_graph.extent(1));
 
-  cagra::detail::graph::optimize(res, knn_graph_internal, new_graph_internal);
+  cagra::detail::graph::optimize(res, knn_graph_internal, new_graph_internal, out_of_core);
 }
 
 template <typename T,
@@ -313,15 +315,22 @@ index<T, IdxT> build(
     graph_degree = intermediate_degree;
   }
 
+  if (params.out_of_core) {
+    RAFT_EXPECTS(params.build_algo == graph_build_algo::IVF_PQ,
+                 "The out-of-core CAGRA build is only supported with the IVF_PQ build algorithm");
+    RAFT_LOG_INFO("Building the CAGRA graph out-of-core");
+  }
+
   std::optional<raft::host_matrix<IdxT, int64_t>> knn_graph(
     raft::make_host_matrix<IdxT, int64_t>(dataset.extent(0), intermediate_degree));
 
   if (params.build_algo == graph_build_algo::IVF_PQ) {
     build_knn_graph(res, dataset, knn_graph->view(), refine_rate, pq_build_params, search_params);
   } else {
-    RAFT_EXPECTS(
-      params.metric == raft::distance::DistanceType::L2Expanded,
-      "L2Expanded is the only distance metrics supported for CAGRA build with nn_descent");
+    RAFT_EXPECTS(params.metric == raft::distance::DistanceType::L2Expanded ||
+                   params.metric == raft::distance::DistanceType::InnerProduct,
+                 "Only L2Expanded or InnerProduct metric are supported for CAGRA build with "
+                 "nn_descent");
     // Use nn-descent to build CAGRA knn graph
     if (!nn_descent_params) {
       nn_descent_params                            = experimental::nn_descent::index_params();
@@ -329,13 +338,15 @@ index<T, IdxT> build(
       nn_descent_params->intermediate_graph_degree = 1.5 * intermediate_degree;
       nn_descent_params->max_iterations            = params.nn_descent_niter;
     }
+    // The knn graph must be built with the metric of the index
+    nn_descent_params->metric = params.metric;
     build_knn_graph<T, IdxT>(res, dataset, knn_graph->view(), *nn_descent_params);
   }
 
   auto cagra_graph = raft::make_host_matrix<IdxT, int64_t>(dataset.extent(0), graph_degree);
 
   RAFT_LOG_INFO("optimizing graph");
-  optimize<IdxT>(res, knn_graph->view(), cagra_graph.view());
+  optimize<IdxT>(res, knn_graph->view(), cagra_graph.view(), params.out_of_core);
 
   // free intermediate graph before trying to create the index
   knn_graph.reset();
@@ -53,6 +53,28 @@ struct CagraSampleFilterWithQueryIdOffset {
   }
 };
 
+/** Combines a user-defined filter with the removed samples of the index. */
+template <class CagraSampleFilterT>
+struct CagraSampleFilterWithRemoved {
+  raft::neighbors::filtering::removed_cagra_sample_filter removed;
+  CagraSampleFilterT filter;
+
+  _RAFT_DEVICE auto operator()(const uint32_t query_id, const uint32_t sample_id)
+  {
+    return removed(query_id, sample_id) && filter(query_id, sample_id);
+  }
+};
+
+/** Whether the filter already takes the removed samples of the index into account. */
+template <class CagraSampleFilterT>
+struct is_removal_aware_filter : std::false_type {};
+template <>
+struct is_removal_aware_filter<raft::neighbors::filtering::removed_cagra_sample_filter>
+  : std::true_type {};
+template <class CagraSampleFilterT>
+struct is_removal_aware_filter<CagraSampleFilterWithRemoved<CagraSampleFilterT>>
+  : std::true_type {};
+
 template <class CagraSampleFilterT>
 struct CagraSampleFilterT_Selector {
   using type = CagraSampleFilterWithQueryIdOffset<CagraSampleFilterT>;
@@ -61,6 +83,10 @@ template <>
 struct CagraSampleFilterT_Selector<raft::neighbors::filtering::none_cagra_sample_filter> {
   using type = raft::neighbors::filtering::none_cagra_sample_filter;
 };
+template <>
+struct CagraSampleFilterT_Selector<raft::neighbors::filtering::removed_cagra_sample_filter> {
+  using type = raft::neighbors::filtering::removed_cagra_sample_filter;
+};
 
 // A helper function to set a query id offset
 template <class CagraSampleFilterT>
@@ -78,6 +104,14 @@ inline
 {
   return filter;
 }
+template <>
+inline typename CagraSampleFilterT_Selector<
+  raft::neighbors::filtering::removed_cagra_sample_filter>::type
+set_offset<raft::neighbors::filtering::removed_cagra_sample_filter>(
+  raft::neighbors::filtering::removed_cagra_sample_filter filter, const uint32_t)
+{
+  return filter;
+}
 
 template <typename DatasetDescriptorT, typename CagraSampleFilterT>
 void search_main_core(
@@ -85,11 +119,14 @@ void search_main_core(
   search_params params,
   DatasetDescriptorT dataset_desc,
   raft::device_matrix_view<const typename DatasetDescriptorT::INDEX_T, int64_t, row_major> graph,
+  uint32_t graph_id_bits,
   raft::device_matrix_view<const typename DatasetDescriptorT::DATA_T, int64_t, row_major> queries,
   raft::device_matrix_view<typename DatasetDescriptorT::INDEX_T, int64_t, row_major> neighbors,
   raft::device_matrix_view<typename DatasetDescriptorT::DISTANCE_T, int64_t, row_major> distances,
   CagraSampleFilterT sample_filter    = CagraSampleFilterT(),
-  raft::distance::DistanceType metric = raft::distance::DistanceType::L2Expanded)
+  raft::distance::DistanceType metric = raft::distance::DistanceType::L2Expanded,
+  search_workspace* workspace         = nullptr,
+  bool plan_only                      = false)
 {
   RAFT_LOG_DEBUG("# dataset size = %lu, dim = %lu\n",
                  static_cast<size_t>(dataset_desc.size),
@@ -100,7 +137,8 @@ void search_main_core(
   RAFT_EXPECTS(queries.extent(1) == dataset_desc.dim, "Queries and index dim must match");
   const uint32_t topk = neighbors.extent(1);
 
-  cudaDeviceProp deviceProp = resource::get_device_properties(res);
+  const search_params requested_params = params;
+  cudaDeviceProp deviceProp            = resource::get_device_properties(res);
   if (params.max_queries == 0) {
     params.max_queries = std::min<size_t>(queries.extent(0), deviceProp.maxGridSize[1]);
   }
@@ -112,11 +150,33 @@ void search_main_core(
     dataset_desc.dim);
 
   using CagraSampleFilterT_s = typename CagraSampleFilterT_Selector<CagraSampleFilterT>::type;
-  std::unique_ptr<search_plan_impl<DatasetDescriptorT, CagraSampleFilterT_s>> plan =
-    factory<DatasetDescriptorT, CagraSampleFilterT_s>::create(
+  using plan_type            = search_plan_impl<DatasetDescriptorT, CagraSampleFilterT_s>;
+  // Reuse the plan cached in the workspace if it has been created for the same configuration.
+  plan_type* plan = workspace != nullptr ? workspace->plan<plan_type>() : nullptr;
+  if (plan != nullptr &&
+      !plan->matches(requested_params, dataset_desc.dim, graph.extent(1), topk, metric)) {
+    plan = nullptr;
+  }
+  // A search captured in a CUDA graph must neither allocate memory nor synchronize with the host,
+  // hence its plan must have been prepared in the workspace beforehand.
+  cudaStreamCaptureStatus capture_status = cudaStreamCaptureStatusNone;
+  RAFT_CUDA_TRY(cudaStreamIsCapturing(resource::get_cuda_stream(res), &capture_status));
+  if (capture_status != cudaStreamCaptureStatusNone) {
+    RAFT_EXPECTS(plan != nullptr,
+                 "A CAGRA search captured in a CUDA graph needs a workspace prepared by "
+                 "cagra::prepare_search with the same parameters and shapes");
+    RAFT_EXPECTS(!params.persistent, "The persistent search cannot be captured in a CUDA graph");
+  }
+  std::unique_ptr<plan_type> owned_plan;
+  if (plan == nullptr) {
+    owned_plan = factory<DatasetDescriptorT, CagraSampleFilterT_s>::create(
       res, params, dataset_desc.dim, graph.extent(1), topk, metric);
+    owned_plan->requested_params = requested_params;
+    plan = workspace != nullptr ? workspace->set_plan(std::move(owned_plan)) : owned_plan.get();
+  }
 
   plan->check(topk);
+  if (plan_only) { return; }
 
   RAFT_LOG_DEBUG("Cagra search");
   const uint32_t max_queries = plan->max_queries;
@@ -140,6 +200,7 @@ void search_main_core(
     (*plan)(res,
             dataset_desc,
             graph,
+            graph_id_bits,
             _topk_indices_ptr,
             _topk_distances_ptr,
             _query_ptr,
@@ -162,11 +223,14 @@ void launch_vpq_search_main_core(
   const vpq_dataset<DatasetT, DatasetIdxT>* vpq_dset,
   search_params params,
   raft::device_matrix_view<const InternalIdxT, int64_t, row_major> graph,
+  uint32_t graph_id_bits,
   raft::device_matrix_view<const T, int64_t, row_major> queries,
   raft::device_matrix_view<InternalIdxT, int64_t, row_major> neighbors,
   raft::device_matrix_view<DistanceT, int64_t, row_major> distances,
   CagraSampleFilterT sample_filter,
-  const raft::distance::DistanceType metric)
+  const raft::distance::DistanceType metric,
+  search_workspace* workspace,
+  bool plan_only)
 {
   RAFT_EXPECTS(vpq_dset->pq_bits() == 8, "Only pq_bits = 8 is supported for now");
   RAFT_EXPECTS(vpq_dset->pq_len() == 2 || vpq_dset->pq_len() == 4,
@@ -194,8 +258,18 @@ void launch_vpq_search_main_core(
                                   pq_scale,
                                   size_t(vpq_dset->n_rows()),
                                   vpq_dset->dim());
-      search_main_core(
-        res, params, dataset_desc, graph, queries, neighbors, distances, sample_filter, metric);
+      search_main_core(res,
+                       params,
+                       dataset_desc,
+                       graph,
+                       graph_id_bits,
+                       queries,
+                       neighbors,
+                       distances,
+                       sample_filter,
+                       metric,
+                       workspace,
+                       plan_only);
     } else if (vpq_dset->pq_len() == 4) {
       using dataset_desc_t = cagra_q_dataset_descriptor_t<T,
                                                           DatasetT,
@@ -212,8 +286,18 @@ void launch_vpq_search_main_core(
                                   pq_scale,
                                   size_t(vpq_dset->n_rows()),
                                   vpq_dset->dim());
-      search_main_core(
-        res, params, dataset_desc, graph, queries, neighbors, distances, sample_filter, metric);
+      search_main_core(res,
+                       params,
+                       dataset_desc,
+                       graph,
+                       graph_id_bits,
+                       queries,
+                       neighbors,
+                       distances,
+                       sample_filter,
+                       metric,
+                       workspace,
+                       plan_only);
     } else {
       RAFT_FAIL("Subspace dimension must be 2 or 4");
     }
@@ -240,6 +324,9 @@ void launch_vpq_search_main_core(
  * [n_queries, k]
  * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
  * k]
+ * @param[in] sample_filter a device filter function that greenlights samples for a given query
+ * @param[inout] workspace optional cache of the search plan reused across the calls
+ * @param[in] plan_only only prepare the search plan in the workspace, do not search
  */
 template <typename T,
           typename InternalIdxT,
@@ -252,8 +339,42 @@ void search_main(raft::resources const& res,
                  raft::device_matrix_view<const T, int64_t, row_major> queries,
                  raft::device_matrix_view<InternalIdxT, int64_t, row_major> neighbors,
                  raft::device_matrix_view<DistanceT, int64_t, row_major> distances,
-                 CagraSampleFilterT sample_filter = CagraSampleFilterT())
+                 CagraSampleFilterT sample_filter = CagraSampleFilterT(),
+                 search_workspace* workspace      = nullptr,
+                 bool plan_only                   = false)
 {
+  if constexpr (!is_removal_aware_filter<CagraSampleFilterT>::value) {
+    if (index.num_removed() > 0) {
+      // Skip the removed samples in addition to those rejected by the user filter.
+      using removed_filter_t = raft::neighbors::filtering::removed_cagra_sample_filter;
+      const removed_filter_t removed_filter{index.removed_bitset()->data()};
+      if constexpr (std::is_same_v<CagraSampleFilterT,
+                                   raft::neighbors::filtering::none_cagra_sample_filter>) {
+        return search_main<T, InternalIdxT, removed_filter_t, IdxT, DistanceT>(res,
+                                                                               params,
+                                                                               index,
+                                                                               queries,
+                                                                               neighbors,
+                                                                               distances,
+                                                                               removed_filter,
+                                                                               workspace,
+                                                                               plan_only);
+      } else {
+        using combined_filter_t = CagraSampleFilterWithRemoved<CagraSampleFilterT>;
+        return search_main<T, InternalIdxT, combined_filter_t, IdxT, DistanceT>(
+          res,
+          params,
+          index,
+          queries,
+          neighbors,
+          distances,
+          combined_filter_t{removed_filter, sample_filter},
+          workspace,
+          plan_only);
+      }
+    }
+  }
+
   const auto& graph   = index.graph();
   auto graph_internal = raft::make_device_matrix_view<const InternalIdxT, int64_t, row_major>(
     reinterpret_cast<const InternalIdxT*>(graph.data_handle()), graph.extent(0), graph.extent(1));
@@ -275,27 +396,42 @@ void search_main(raft::resources const& res,
                                                          params,
                                                          dataset_desc,
                                                          graph_internal,
+                                                         index.graph_id_bits(),
                                                          queries,
                                                          neighbors,
                                                          distances,
                                                          sample_filter,
-                                                         index.metric());
+                                                         index.metric(),
+                                                         workspace,
+                                                         plan_only);
   } else if (auto* vpq_dset = dynamic_cast<const vpq_dataset<float, ds_idx_type>*>(&index.data());
              vpq_dset != nullptr) {
     // Search using a compressed dataset
     RAFT_FAIL("FP32 VPQ dataset support is coming soon");
   } else if (auto* vpq_dset = dynamic_cast<const vpq_dataset<half, ds_idx_type>*>(&index.data());
              vpq_dset != nullptr) {
-    launch_vpq_search_main_core<T, half, ds_idx_type, InternalIdxT, DistanceT, CagraSampleFilterT>(
-      res,
-      vpq_dset,
-      params,
-      graph_internal,
-      queries,
-      neighbors,
-      distances,
-      sample_filter,
-      index.metric());
+    if constexpr (std::is_same_v<CagraSampleFilterT,
+                                 raft::neighbors::filtering::removed_cagra_sample_filter>) {
+      RAFT_FAIL("Removing samples from an index with a VPQ-compressed dataset is not supported");
+    } else {
+      launch_vpq_search_main_core<T,
+                                  half,
+                                  ds_idx_type,
+                                  InternalIdxT,
+                                  DistanceT,
+                                  CagraSampleFilterT>(res,
+                                                      vpq_dset,
+                                                      params,
+                                                      graph_internal,
+                                                      index.graph_id_bits(),
+                                                      queries,
+                                                      neighbors,
+                                                      distances,
+                                                      sample_filter,
+                                                      index.metric(),
+                                                      workspace,
+                                                      plan_only);
+    }
   } else if (auto* empty_dset = dynamic_cast<const empty_dataset<ds_idx_type>*>(&index.data());
              empty_dset != nullptr) {
     // Forgot to add a dataset.
@@ -305,6 +441,7 @@ void search_main(raft::resources const& res,
     // This is a logic error.
     RAFT_FAIL("Unrecognized dataset format");
   }
+  if (plan_only) { return; }
 
   static_assert(std::is_same_v<DistanceT, float>,
                 "only float distances are supported at the moment");
@@ -16,29 +16,49 @@
 
 #pragma once
 
+#include "compressed_graph.cuh"
+#include "utils.hpp"
+
+#include <raft/core/detail/cufile.hpp>
+#include <raft/core/detail/mapped_file.hpp>
+#include <raft/core/device_mdarray.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/mdarray.hpp>
 #include <raft/core/mdspan_types.hpp>
 #include <raft/core/nvtx.hpp>
+#include <raft/core/pinned_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/serialize.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/neighbors/brute_force.cuh>
 #include <raft/neighbors/cagra_types.hpp>
 #include <raft/neighbors/detail/dataset_serialize.hpp>
+#include <raft/util/integer_utils.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <memory>
+#include <optional>
+#include <random>
 #include <type_traits>
+#include <vector>
 
 namespace raft::neighbors::cagra::detail {
 
-constexpr int serialization_version = 4;
+constexpr int serialization_version = 5;
 
 /**
  * Save the index to file.
  *
  * Experimental, both the API and the serialization format are subject to change.
  *
+ * The graph is written bit-packed (see cagra::compress_graph) if it is compressed in the index or
+ * if `compress_graph` is set; the packing runs on the device.
+ *
  * @param[in] res the raft resource handle
  * @param[in] filename the file name for saving the index
  * @param[in] index_ CAGRA index
@@ -48,12 +68,15 @@ template <typename T, typename IdxT>
 void serialize(raft::resources const& res,
                std::ostream& os,
                const index<T, IdxT>& index_,
-               bool include_dataset)
+               bool include_dataset,
+               bool compress_graph = false)
 {
   common::nvtx::range<common::nvtx::domain::raft> fun_scope("cagra::serialize");
 
   RAFT_LOG_DEBUG(
     "Saving CAGRA index, size %zu, dim %u", static_cast<size_t>(index_.size()), index_.dim());
+  RAFT_EXPECTS(index_.num_removed() == 0,
+               "The index has removed samples; call cagra::compact before serializing it");
 
   std::string dtype_string = raft::detail::numpy_serializer::get_numpy_dtype<T>().to_string();
   dtype_string.resize(4);
@@ -64,7 +87,33 @@ void serialize(raft::resources const& res,
   serialize_scalar(res, os, index_.dim());
   serialize_scalar(res, os, index_.graph_degree());
   serialize_scalar(res, os, index_.metric());
-  serialize_mdspan(res, os, index_.graph());
+
+  const int64_t n_rows   = index_.graph().extent(0);
+  uint32_t graph_id_bits = index_.graph_id_bits();
+  if (graph_id_bits == 0 && compress_graph) {
+    graph_id_bits = graph_id_bits_for(n_rows);
+    // The all-ones id is reserved for the invalid edges
+    if (graph_id_bits > 32) { graph_id_bits = 0; }
+  }
+  serialize_scalar(res, os, graph_id_bits);
+  if (graph_id_bits == 0) {
+    serialize_mdspan(res, os, index_.graph());
+  } else {
+    std::optional<raft::device_vector<uint32_t, int64_t>> packed;
+    auto packed_ptr = reinterpret_cast<const uint32_t*>(index_.graph().data_handle());
+    if (index_.graph_id_bits() == 0) {
+      packed.emplace(pack_graph<IdxT>(res, index_.graph(), graph_id_bits));
+      packed_ptr = packed->data_handle();
+    }
+    auto packed_host = raft::make_host_vector<uint32_t, int64_t>(
+      n_rows * device::packed_graph_row_words(index_.graph_degree(), graph_id_bits));
+    raft::copy(packed_host.data_handle(),
+               packed_ptr,
+               packed_host.size(),
+               resource::get_cuda_stream(res));
+    resource::sync_stream(res);
+    serialize_mdspan(res, os, packed_host.view());
+  }
 
   include_dataset &= (index_.data().n_rows() > 0);
 
@@ -81,21 +130,126 @@ template <typename T, typename IdxT>
 void serialize(raft::resources const& res,
                const std::string& filename,
                const index<T, IdxT>& index_,
-               bool include_dataset)
+               bool include_dataset,
+               bool compress_graph = false)
 {
   std::ofstream of(filename, std::ios::out | std::ios::binary);
   if (!of) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
 
-  detail::serialize(res, of, index_, include_dataset);
+  detail::serialize(res, of, index_, include_dataset, compress_graph);
 
   of.close();
   if (!of) { RAFT_FAIL("Error writing output %s", filename.c_str()); }
 }
 
+/** The upper layers of an hnswlib index over the CAGRA dataset. */
+template <typename IdxT>
+struct hnsw_layers {
+  /** The top level of every node. */
+  std::vector<int> node_levels;
+  /** The nodes of every upper level `l` (at `l - 1`) in ascending order. */
+  std::vector<std::vector<IdxT>> level_nodes;
+  /** The links of the nodes of every upper level: [level_nodes[l - 1].size(), M]. */
+  std::vector<raft::host_matrix<IdxT, int64_t>> level_links;
+  /** The number of the links of the nodes of every upper level. */
+  std::vector<std::vector<uint32_t>> level_counts;
+  int max_level   = 0;
+  IdxT entrypoint = 0;
+};
+
+/**
+ * Build the upper layers of an hnswlib index.
+ *
+ * The levels of the nodes are sampled from the distribution used by hnswlib, and every node of an
+ * upper level is linked to its `M` nearest neighbors among the nodes of that level, found by a
+ * brute-force search on the GPU. The size of the levels decreases geometrically (by a factor of
+ * `M`), so this costs a small fraction of the CAGRA build.
+ */
+template <typename T, typename IdxT>
+auto build_hnsw_layers(raft::resources const& res,
+                       raft::device_matrix_view<const T, int64_t, layout_stride> dataset,
+                       raft::distance::DistanceType metric,
+                       size_t M,
+                       uint64_t seed) -> hnsw_layers<IdxT>
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("cagra::build_hnsw_layers");
+  const int64_t n_rows = dataset.extent(0);
+  const int64_t dim    = dataset.extent(1);
+  auto stream          = resource::get_cuda_stream(res);
+
+  hnsw_layers<IdxT> layers;
+  layers.node_levels.resize(n_rows);
+  const double mult = 1.0 / std::log(static_cast<double>(M));
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  for (int64_t i = 0; i < n_rows; i++) {
+    auto level            = static_cast<int>(-std::log(1.0 - uniform(rng)) * mult);
+    layers.node_levels[i] = level;
+    if (level > layers.max_level || i == 0) {
+      layers.max_level  = level;
+      layers.entrypoint = static_cast<IdxT>(i);
+    }
+  }
+  layers.level_nodes.resize(layers.max_level);
+  for (int64_t i = 0; i < n_rows; i++) {
+    for (int l = 1; l <= layers.node_levels[i]; l++) {
+      layers.level_nodes[l - 1].push_back(static_cast<IdxT>(i));
+    }
+  }
+
+  for (int l = 1; l <= layers.max_level; l++) {
+    const auto& nodes = layers.level_nodes[l - 1];
+    const auto n_l    = static_cast<int64_t>(nodes.size());
+    auto links        = raft::make_host_matrix<IdxT, int64_t>(n_l, M);
+    std::vector<uint32_t> counts(n_l, 0);
+    if (n_l > 1) {
+      // One more neighbor than needed, since every node finds itself
+      const auto k = static_cast<int64_t>(std::min<size_t>(M + 1, n_l));
+      auto nodes_d = raft::make_device_vector<IdxT, int64_t>(res, n_l);
+      auto level_d = raft::make_device_matrix<float, int64_t>(res, n_l, dim);
+      auto nbrs_d  = raft::make_device_matrix<int64_t, int64_t>(res, n_l, k);
+      auto dists_d = raft::make_device_matrix<float, int64_t>(res, n_l, k);
+      auto nbrs_h  = raft::make_host_matrix<int64_t, int64_t>(n_l, k);
+      raft::copy(nodes_d.data_handle(), nodes.data(), n_l, stream);
+      // Gather the rows of the level from the (padded) dataset
+      const T* data_ptr    = dataset.data_handle();
+      const int64_t ld     = dataset.stride(0);
+      const IdxT* node_ptr = nodes_d.data_handle();
+      raft::linalg::map_offset(res, level_d.view(), [=] __device__(int64_t i) {
+        return static_cast<float>(data_ptr[static_cast<int64_t>(node_ptr[i / dim]) * ld + i % dim]);
+      });
+      std::vector<raft::device_matrix_view<const float, int64_t, row_major>> level_index{
+        raft::make_const_mdspan(level_d.view())};
+      raft::neighbors::brute_force::knn<int64_t, float, int64_t>(
+        res,
+        level_index,
+        raft::make_const_mdspan(level_d.view()),
+        nbrs_d.view(),
+        dists_d.view(),
+        metric == raft::distance::DistanceType::InnerProduct
+          ? raft::distance::DistanceType::InnerProduct
+          : raft::distance::DistanceType::L2Expanded);
+      raft::copy(nbrs_h.data_handle(), nbrs_d.data_handle(), nbrs_d.size(), stream);
+      resource::sync_stream(res);
+      for (int64_t r = 0; r < n_l; r++) {
+        for (int64_t j = 0; j < k && counts[r] < M; j++) {
+          auto c = nbrs_h(r, j);
+          if (c == r || c < 0 || c >= n_l) { continue; }
+          links(r, counts[r]++) = nodes[c];
+        }
+      }
+    }
+    layers.level_links.push_back(std::move(links));
+    layers.level_counts.push_back(std::move(counts));
+  }
+  return layers;
+}
+
 template <typename T, typename IdxT>
 void serialize_to_hnswlib(raft::resources const& res,
                           std::ostream& os,
-                          const raft::neighbors::cagra::index<T, IdxT>& index_)
+                          const raft::neighbors::cagra::index<T, IdxT>& index_,
+                          bool include_hierarchy = true)
 {
   // static_assert(std::is_same_v<IdxT, int> or std::is_same_v<IdxT, uint32_t>,
   //               "An hnswlib index can only be trained with int32 or uint32 IdxT");
@@ -103,6 +257,10 @@ void serialize_to_hnswlib(raft::resources const& res,
   RAFT_LOG_DEBUG("Saving CAGRA index to hnswlib format, size %zu, dim %u",
                  static_cast<size_t>(index_.size()),
                  index_.dim());
+  RAFT_EXPECTS(index_.num_removed() == 0,
+               "The index has removed samples; call cagra::compact before serializing it");
+  RAFT_EXPECTS(index_.graph_id_bits() == 0,
+               "The graph is compressed; call cagra::decompress_graph before serializing it");
 
   // offset_level_0
   std::size_t offset_level_0 = 0;
@@ -125,41 +283,52 @@ void serialize_to_hnswlib(raft::resources const& res,
   // offset_data
   auto offset_data = static_cast<std::size_t>(index_.graph_degree() * sizeof(IdxT) + 4);
   os.write(reinterpret_cast<char*>(&offset_data), sizeof(std::size_t));
-  // max_level
-  int max_level = 1;
+
+  auto dataset = index_.dataset();
+  // Remove padding before saving the dataset
+  auto host_dataset = make_host_matrix<T, int64_t>(dataset.extent(0), dataset.extent(1));
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(host_dataset.data_handle(),
+                                  sizeof(T) * host_dataset.extent(1),
+                                  dataset.data_handle(),
+                                  sizeof(T) * dataset.stride(0),
+                                  sizeof(T) * host_dataset.extent(1),
+                                  dataset.extent(0),
+                                  cudaMemcpyDefault,
+                                  resource::get_cuda_stream(res)));
+  resource::sync_stream(res);
+
+  // The upper layers (if any) have degree M, the base layer is the CAGRA graph of degree 2 * M
+  auto M = static_cast<std::size_t>(index_.graph_degree() / 2);
+  // The level distribution is not defined for M < 2
+  include_hierarchy &= M >= 2 && index_.size() > 0;
+  std::optional<hnsw_layers<IdxT>> layers;
+  if (include_hierarchy) {
+    // Fixed seed to keep the exported files reproducible
+    layers = build_hnsw_layers<T, IdxT>(res, dataset, index_.metric(), M, 100);
+  }
+
+  // max_level; a base-layer-only index is marked by an entry point without upper layers
+  int max_level = layers.has_value() ? layers->max_level : 1;
   os.write(reinterpret_cast<char*>(&max_level), sizeof(int));
   // entrypoint_node
-  auto entrypoint_node = static_cast<int>(index_.size() / 2);
+  auto entrypoint_node = layers.has_value() ? static_cast<int>(layers->entrypoint)
+                                            : static_cast<int>(index_.size() / 2);
   os.write(reinterpret_cast<char*>(&entrypoint_node), sizeof(int));
   // max_M
-  auto max_M = static_cast<std::size_t>(index_.graph_degree() / 2);
+  auto max_M = M;
   os.write(reinterpret_cast<char*>(&max_M), sizeof(std::size_t));
   // max_M0
   std::size_t max_M0 = index_.graph_degree();
   os.write(reinterpret_cast<char*>(&max_M0), sizeof(std::size_t));
   // M
-  auto M = static_cast<std::size_t>(index_.graph_degree() / 2);
   os.write(reinterpret_cast<char*>(&M), sizeof(std::size_t));
-  // mult, can be anything
-  double mult = 0.42424242;
+  // mult, only used by hnswlib to insert new elements
+  double mult = layers.has_value() ? 1.0 / std::log(static_cast<double>(M)) : 0.42424242;
   os.write(reinterpret_cast<char*>(&mult), sizeof(double));
   // efConstruction, can be anything
   std::size_t efConstruction = 500;
   os.write(reinterpret_cast<char*>(&efConstruction), sizeof(std::size_t));
 
-  auto dataset = index_.dataset();
-  // Remove padding before saving the dataset
-  auto host_dataset = make_host_matrix<T, int64_t>(dataset.extent(0), dataset.extent(1));
-  RAFT_CUDA_TRY(cudaMemcpy2DAsync(host_dataset.data_handle(),
-                                  sizeof(T) * host_dataset.extent(1),
-                                  dataset.data_handle(),
-                                  sizeof(T) * dataset.stride(0),
-                                  sizeof(T) * host_dataset.extent(1),
-                                  dataset.extent(0),
-                                  cudaMemcpyDefault,
-                                  resource::get_cuda_stream(res)));
-  resource::sync_stream(res);
-
   auto graph = index_.graph();
   auto host_graph =
     raft::make_host_matrix<IdxT, int64_t, raft::row_major>(graph.extent(0), graph.extent(1));
@@ -195,22 +364,46 @@ void serialize_to_hnswlib(raft::resources const& res,
     os.write(reinterpret_cast<char*>(&i), sizeof(std::size_t));
   }
 
+  if (!layers.has_value()) {
+    for (std::size_t i = 0; i < index_.size(); i++) {
+      // zeroes
+      auto zero = 0;
+      os.write(reinterpret_cast<char*>(&zero), sizeof(int));
+    }
+    return;
+  }
+
+  // The upper layers of every element: the total size of its link lists, followed by a list of
+  // `M` links and their count per level.
+  const auto size_links_per_element = static_cast<unsigned int>(M * sizeof(IdxT) + 4);
+  std::vector<std::size_t> level_pos(layers->max_level, 0);
+  std::vector<IdxT> padding(M, 0);
   for (std::size_t i = 0; i < index_.size(); i++) {
-    // zeroes
-    auto zero = 0;
-    os.write(reinterpret_cast<char*>(&zero), sizeof(int));
+    const int level         = layers->node_levels[i];
+    unsigned int link_bytes = level * size_links_per_element;
+    os.write(reinterpret_cast<char*>(&link_bytes), sizeof(unsigned int));
+    for (int l = 1; l <= level; l++) {
+      // The nodes of a level are sorted, so the next one of the level is the current element.
+      const auto r     = level_pos[l - 1]++;
+      const auto count = layers->level_counts[l - 1][r];
+      const auto* row  = layers->level_links[l - 1].data_handle() + r * M;
+      os.write(reinterpret_cast<const char*>(&count), sizeof(uint32_t));
+      os.write(reinterpret_cast<const char*>(row), sizeof(IdxT) * count);
+      os.write(reinterpret_cast<const char*>(padding.data()), sizeof(IdxT) * (M - count));
+    }
   }
 }
 
 template <typename T, typename IdxT>
 void serialize_to_hnswlib(raft::resources const& res,
                           const std::string& filename,
-                          const raft::neighbors::cagra::index<T, IdxT>& index_)
+                          const raft::neighbors::cagra::index<T, IdxT>& index_,
+                          bool include_hierarchy = true)
 {
   std::ofstream of(filename, std::ios::out | std::ios::binary);
   if (!of) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
 
-  detail::serialize_to_hnswlib<T, IdxT>(res, of, index_);
+  detail::serialize_to_hnswlib<T, IdxT>(res, of, index_, include_hierarchy);
 
   of.close();
   if (!of) { RAFT_FAIL("Error writing output %s", filename.c_str()); }
@@ -241,12 +434,27 @@ auto deserialize(raft::resources const& res, std::istream& is) -> index<T, IdxT>
   auto dim          = deserialize_scalar<std::uint32_t>(res, is);
   auto graph_degree = deserialize_scalar<std::uint32_t>(res, is);
   auto metric       = deserialize_scalar<raft::distance::DistanceType>(res, is);
-
-  auto graph = raft::make_host_matrix<IdxT, int64_t>(n_rows, graph_degree);
-  deserialize_mdspan(res, is, graph.view());
+  auto id_bits      = deserialize_scalar<std::uint32_t>(res, is);
 
   index<T, IdxT> idx(res, metric);
-  idx.update_graph(res, raft::make_const_mdspan(graph.view()));
+  if (id_bits == 0) {
+    auto graph = raft::make_host_matrix<IdxT, int64_t>(n_rows, graph_degree);
+    deserialize_mdspan(res, is, graph.view());
+    idx.update_graph(res, raft::make_const_mdspan(graph.view()));
+  } else {
+    // Only the packed graph crosses the PCIe bus; it is unpacked on the device
+    const auto row_words = device::packed_graph_row_words(graph_degree, id_bits);
+    auto packed_host = raft::make_host_vector<uint32_t, int64_t>(int64_t(n_rows) * row_words);
+    auto packed      = raft::make_device_vector<uint32_t, int64_t>(res, packed_host.size());
+    deserialize_mdspan(res, is, packed_host.view());
+    raft::copy(packed.data_handle(),
+               packed_host.data_handle(),
+               packed_host.size(),
+               resource::get_cuda_stream(res));
+    idx.update_graph(
+      res, unpack_graph<IdxT>(res, packed.data_handle(), n_rows, graph_degree, id_bits));
+    resource::sync_stream(res);
+  }
   bool has_dataset = deserialize_scalar<bool>(res, is);
   if (has_dataset) {
     idx.update_dataset(res, neighbors::detail::deserialize_dataset<int64_t>(res, is));
@@ -267,4 +475,295 @@ auto deserialize(raft::resources const& res, const std::string& filename) -> ind
 
   return index;
 }
+
+/*
+ * The memory-mapped layout (`serialize_mmap`/`deserialize_mmap`).
+ *
+ * Unlike the stream format above, the arrays are stored raw at offsets aligned to
+ * `kMmapAlignment`, so that a mapping of the file can be used (or copied) without parsing:
+ *
+ *   [header | padding | graph [n_rows, graph_degree] | padding | dataset [n_rows, stride]]
+ *
+ * The dataset rows keep the padding (stride) of the device layout. All values are stored in the
+ * native byte order.
+ */
+constexpr char kMmapMagic[8]             = {'C', 'A', 'G', 'R', 'A', 'M', 'A', 'P'};
+constexpr int mmap_serialization_version = 1;
+constexpr uint64_t kMmapAlignment        = 64 * 1024;  // a multiple of any common page size
+constexpr uint64_t kMmapStagingChunkSize = 64 * 1024 * 1024;
+
+struct mmap_file_header {
+  char magic[8];
+  int32_t version;
+  char dtype[4];
+  uint32_t index_type_size;
+  uint32_t metric;
+  uint32_t dim;
+  uint32_t graph_degree;
+  uint32_t dataset_stride;  // zero when the dataset is not included
+  uint32_t reserved;
+  uint64_t n_rows;
+  uint64_t graph_offset;
+  uint64_t dataset_offset;
+  uint64_t file_size;
+};
+static_assert(std::is_trivially_copyable_v<mmap_file_header>);
+
+using raft::detail::mapped_file;
+
+/**
+ * A dataset kept in a memory-mapped file, page-locked and mapped into the device address space.
+ *
+ * The dataset owns the mapping of the file; it is released together with the index.
+ */
+template <typename DataT, typename IdxT>
+struct mapped_dataset : public strided_dataset<DataT, IdxT> {
+  using index_type = IdxT;
+  using value_type = DataT;
+  using typename strided_dataset<value_type, index_type>::view_type;
+
+  mapped_dataset(std::shared_ptr<const mapped_file> file,
+                 uint64_t offset,
+                 index_type n_rows,
+                 uint32_t dim,
+                 uint32_t stride)
+    : file_(std::move(file)),
+      registration_(reinterpret_cast<const value_type*>(file_->data() + offset),
+                    static_cast<size_t>(n_rows) * stride),
+      view_(make_device_strided_matrix_view<const value_type, index_type>(
+        registration_.data_handle(), n_rows, dim, stride))
+  {
+    RAFT_EXPECTS(
+      stride >= dim, "The row stride (%u) must not be smaller than dim (%u)", stride, dim);
+  }
+
+  [[nodiscard]] auto is_owning() const noexcept -> bool final { return true; }
+  [[nodiscard]] auto view() const noexcept -> view_type final { return view_; }
+
+ private:
+  std::shared_ptr<const mapped_file> file_;
+  device_mapped_host_memory<const value_type> registration_;
+  view_type view_;
+};
+
+/**
+ * Copy host memory (e.g. a mapped file) to the device through two pinned staging buffers: one is
+ * filled on the host while the other one is being copied to the device.
+ */
+inline void copy_to_device_staged(raft::resources const& res,
+                                  void* dst,
+                                  const void* src,
+                                  uint64_t n_bytes,
+                                  uint64_t chunk_size = kMmapStagingChunkSize)
+{
+  if (n_bytes == 0) { return; }
+  auto stream = resource::get_cuda_stream(res);
+  chunk_size   = std::min(chunk_size, n_bytes);
+  auto staging = raft::make_pinned_vector<uint8_t, uint64_t>(res, 2 * chunk_size);
+  using event_ptr =
+    std::unique_ptr<std::remove_pointer_t<cudaEvent_t>, cudaError_t (*)(cudaEvent_t)>;
+  std::vector<event_ptr> copied;
+  for (int i = 0; i < 2; i++) {
+    cudaEvent_t e;
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&e, cudaEventDisableTiming));
+    copied.emplace_back(e, cudaEventDestroy);
+  }
+  for (uint64_t offset = 0, i = 0; offset < n_bytes; offset += chunk_size, i++) {
+    const uint64_t n = std::min(chunk_size, n_bytes - offset);
+    auto* buf        = staging.data_handle() + (i % 2) * chunk_size;
+    // Wait until the copy issued from this buffer two chunks ago has finished.
+    if (i >= 2) { RAFT_CUDA_TRY(cudaEventSynchronize(copied[i % 2].get())); }
+    std::memcpy(buf, static_cast<const uint8_t*>(src) + offset, n);
+    RAFT_CUDA_TRY(cudaMemcpyAsync(
+      static_cast<uint8_t*>(dst) + offset, buf, n, cudaMemcpyHostToDevice, stream));
+    RAFT_CUDA_TRY(cudaEventRecord(copied[i % 2].get(), stream));
+  }
+  resource::sync_stream(res);
+}
+
+/**
+ * Load a part of a mapped file to the device: directly from the storage with GPUDirect Storage when
+ * available (the arrays are aligned to `kMmapAlignment`), otherwise through pinned buffers.
+ */
+inline void load_to_device(raft::resources const& res,
+                           const std::string& filename,
+                           const mapped_file& file,
+                           void* dst,
+                           uint64_t n_bytes,
+                           uint64_t offset)
+{
+  if (raft::detail::cufile_transfer(
+        filename, false, dst, n_bytes, offset, resource::get_cuda_stream(res))) {
+    return;
+  }
+  copy_to_device_staged(res, dst, file.data() + offset, n_bytes);
+}
+
+/** Write `n_rows` rows of a device matrix with the row length `dst_stride`, padded with zeros. */
+template <typename ElemT>
+void write_device_rows(raft::resources const& res,
+                       std::ostream& os,
+                       const ElemT* src,
+                       uint64_t n_rows,
+                       uint32_t row_length,
+                       uint32_t src_stride,
+                       uint32_t dst_stride)
+{
+  const uint64_t chunk_rows =
+    std::max<uint64_t>(1, kMmapStagingChunkSize / (sizeof(ElemT) * dst_stride));
+  // The padding of the rows is zero-filled once and never overwritten.
+  std::vector<ElemT> buf(std::min(chunk_rows, n_rows) * dst_stride, ElemT{});
+  for (uint64_t row = 0; row < n_rows; row += chunk_rows) {
+    const uint64_t n = std::min(chunk_rows, n_rows - row);
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(buf.data(),
+                                    sizeof(ElemT) * dst_stride,
+                                    src + row * src_stride,
+                                    sizeof(ElemT) * src_stride,
+                                    sizeof(ElemT) * row_length,
+                                    n,
+                                    cudaMemcpyDefault,
+                                    resource::get_cuda_stream(res)));
+    resource::sync_stream(res);
+    os.write(reinterpret_cast<const char*>(buf.data()), sizeof(ElemT) * n * dst_stride);
+  }
+}
+
+inline void write_zeros(std::ostream& os, uint64_t n_bytes)
+{
+  const std::vector<char> zeros(std::min<uint64_t>(n_bytes, kMmapAlignment), 0);
+  for (uint64_t n = 0; n < n_bytes; n += zeros.size()) {
+    os.write(zeros.data(), std::min<uint64_t>(zeros.size(), n_bytes - n));
+  }
+}
+
+/**
+ * Save the index to file in the memory-mapped layout.
+ *
+ * Only an uncompressed dataset can be included.
+ */
+template <typename T, typename IdxT>
+void serialize_mmap(raft::resources const& res,
+                    const std::string& filename,
+                    const index<T, IdxT>& index_,
+                    bool include_dataset)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("cagra::serialize_mmap");
+  RAFT_EXPECTS(index_.num_removed() == 0,
+               "The index has removed samples; call cagra::compact before serializing it");
+  RAFT_EXPECTS(index_.graph_id_bits() == 0,
+               "The graph is compressed; call cagra::decompress_graph before serializing it");
+
+  include_dataset &= (index_.data().n_rows() > 0);
+  const strided_dataset<T, int64_t>* dset = nullptr;
+  if (include_dataset) {
+    dset = dynamic_cast<const strided_dataset<T, int64_t>*>(&index_.data());
+    RAFT_EXPECTS(dset != nullptr,
+                 "The memory-mapped layout only supports an uncompressed dataset of type T");
+  }
+
+  mmap_file_header header{};
+  std::memcpy(header.magic, kMmapMagic, sizeof(header.magic));
+  header.version           = mmap_serialization_version;
+  std::string dtype_string = raft::detail::numpy_serializer::get_numpy_dtype<T>().to_string();
+  dtype_string.resize(sizeof(header.dtype));
+  std::memcpy(header.dtype, dtype_string.data(), sizeof(header.dtype));
+  header.index_type_size = sizeof(IdxT);
+  header.metric          = static_cast<uint32_t>(index_.metric());
+  header.dim             = index_.dim();
+  header.graph_degree    = index_.graph_degree();
+  header.dataset_stride  = dset != nullptr ? dset->stride() : 0;
+  header.n_rows          = index_.size();
+  header.graph_offset    = raft::round_up_safe<uint64_t>(sizeof(header), kMmapAlignment);
+  const uint64_t graph_end =
+    header.graph_offset + header.n_rows * header.graph_degree * sizeof(IdxT);
+  header.dataset_offset = dset != nullptr ? raft::round_up_safe(graph_end, kMmapAlignment) : 0;
+  header.file_size =
+    dset != nullptr ? header.dataset_offset + header.n_rows * header.dataset_stride * sizeof(T)
+                    : graph_end;
+
+  std::ofstream of(filename, std::ios::out | std::ios::binary);
+  if (!of) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+  of.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write_zeros(of, header.graph_offset - sizeof(header));
+  write_device_rows(res,
+                    of,
+                    index_.graph().data_handle(),
+                    header.n_rows,
+                    header.graph_degree,
+                    header.graph_degree,
+                    header.graph_degree);
+  if (dset != nullptr) {
+    write_zeros(of, header.dataset_offset - graph_end);
+    write_device_rows(res,
+                      of,
+                      dset->view().data_handle(),
+                      header.n_rows,
+                      header.dim,
+                      header.dataset_stride,
+                      header.dataset_stride);
+  }
+  of.close();
+  if (!of) { RAFT_FAIL("Error writing output %s", filename.c_str()); }
+}
+
+/** Load an index saved in the memory-mapped layout from file. */
+template <typename T, typename IdxT>
+auto deserialize_mmap(raft::resources const& res,
+                      const std::string& filename,
+                      mmap_dataset_mode dataset_mode) -> index<T, IdxT>
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("cagra::deserialize_mmap");
+
+  auto file = std::make_shared<const mapped_file>(filename);
+  mmap_file_header header;
+  RAFT_EXPECTS(file->size() >= sizeof(header), "File %s is too small", filename.c_str());
+  std::memcpy(&header, file->data(), sizeof(header));
+  RAFT_EXPECTS(std::memcmp(header.magic, kMmapMagic, sizeof(header.magic)) == 0,
+               "File %s is not a memory-mapped CAGRA index",
+               filename.c_str());
+  if (header.version != mmap_serialization_version) {
+    RAFT_FAIL("serialization version mismatch, expected %d, got %d ",
+              mmap_serialization_version,
+              header.version);
+  }
+  std::string dtype_string = raft::detail::numpy_serializer::get_numpy_dtype<T>().to_string();
+  dtype_string.resize(sizeof(header.dtype));
+  RAFT_EXPECTS(std::memcmp(header.dtype, dtype_string.data(), sizeof(header.dtype)) == 0 &&
+                 header.index_type_size == sizeof(IdxT),
+               "The data or index type of the file does not match the requested index type");
+  RAFT_EXPECTS(header.file_size <= file->size(), "File %s is truncated", filename.c_str());
+
+  index<T, IdxT> idx(res, static_cast<raft::distance::DistanceType>(header.metric));
+  auto graph = raft::make_device_matrix<IdxT, int64_t>(res, header.n_rows, header.graph_degree);
+  load_to_device(
+    res, filename, *file, graph.data_handle(), graph.size() * sizeof(IdxT), header.graph_offset);
+  idx.update_graph(res, std::move(graph));
+
+  if (header.dataset_stride == 0) { return idx; }
+  RAFT_EXPECTS(header.dataset_stride >= header.dim,
+               "File %s is corrupted: the dataset stride (%u) is smaller than dim (%u)",
+               filename.c_str(),
+               header.dataset_stride,
+               header.dim);
+  const auto n_rows = static_cast<int64_t>(header.n_rows);
+  if (dataset_mode == mmap_dataset_mode::HOST_MAPPED) {
+    idx.update_dataset(
+      res,
+      std::make_unique<mapped_dataset<T, int64_t>>(
+        std::move(file), header.dataset_offset, n_rows, header.dim, header.dataset_stride));
+  } else {
+    auto data = raft::make_device_matrix<T, int64_t>(res, n_rows, header.dataset_stride);
+    load_to_device(
+      res, filename, *file, data.data_handle(), data.size() * sizeof(T), header.dataset_offset);
+    using out_mdarray_type          = decltype(data);
+    using out_layout_type           = typename out_mdarray_type::layout_type;
+    using out_container_policy_type = typename out_mdarray_type::container_policy_type;
+    using out_owning_type = owning_dataset<T, int64_t, out_layout_type, out_container_policy_type>;
+    auto out_layout       = make_strided_layout(
+      raft::matrix_extent<int64_t>(n_rows, header.dim),
+      std::array<int64_t, 2>{static_cast<int64_t>(header.dataset_stride), 1});
+    idx.update_dataset(res, std::make_unique<out_owning_type>(std::move(data), out_layout));
+  }
+  return idx;
+}
 }  // namespace raft::neighbors::cagra::detail
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "../../cagra_types.hpp"
+#include "cagra_build.cuh"
+#include "cagra_search.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_resources_manager.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/detail/multi_device.hpp>
+#include <raft/neighbors/detail/sharded_search.cuh>
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace raft::neighbors::cagra::detail {
+
+using raft::neighbors::detail::for_each_device;
+
+template <typename T, typename IdxT, typename Accessor>
+auto build_sharded(const index_params& params,
+                   const std::vector<int>& device_ids,
+                   mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset)
+  -> sharded_index<T, IdxT>
+{
+  static_assert(Accessor::is_host_accessible,
+                "The dataset of a sharded index must be accessible from the host");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::build_sharded(%zu, %zu)", static_cast<size_t>(dataset.extent(0)), device_ids.size());
+  RAFT_EXPECTS(!device_ids.empty(), "At least one device is needed to build a sharded index");
+
+  const size_t n_shards = device_ids.size();
+  const int64_t n_rows  = dataset.extent(0);
+  const int64_t dim     = dataset.extent(1);
+  RAFT_EXPECTS(n_rows >= static_cast<int64_t>(n_shards), "Too few rows to create the shards");
+
+  // Balanced contiguous partitioning of the dataset.
+  std::vector<int64_t> offsets(n_shards + 1);
+  for (size_t i = 0; i <= n_shards; i++) {
+    offsets[i] = (n_rows / n_shards) * i + std::min<int64_t>(i, n_rows % n_shards);
+  }
+  RAFT_EXPECTS(offsets[1] - offsets[0] <= static_cast<int64_t>(std::numeric_limits<IdxT>::max()),
+               "The shards are too large for the index type; use more devices or a wider IdxT");
+
+  std::vector<std::optional<index<T, IdxT>>> shards(n_shards);
+  for_each_device(device_ids, [&](size_t i) {
+    const auto& shard_res = raft::device_resources_manager::get_device_resources(device_ids[i]);
+    auto shard_dataset    = mdspan<const T, matrix_extent<int64_t>, row_major, Accessor>(
+      dataset.data_handle() + offsets[i] * dim, offsets[i + 1] - offsets[i], dim);
+    shards[i].emplace(build<T, IdxT, Accessor>(shard_res, params, shard_dataset));
+    resource::sync_stream(shard_res);
+  });
+
+  std::vector<index<T, IdxT>> shard_indices;
+  shard_indices.reserve(n_shards);
+  for (auto& shard : shards) {
+    shard_indices.emplace_back(std::move(*shard));
+  }
+  return sharded_index<T, IdxT>(device_ids, std::move(shard_indices), std::move(offsets));
+}
+
+template <typename T, typename IdxT>
+void search_sharded(raft::resources const& res,
+                    const search_params& params,
+                    const sharded_index<T, IdxT>& idx,
+                    raft::device_matrix_view<const T, int64_t, row_major> queries,
+                    raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+                    raft::device_matrix_view<float, int64_t, row_major> distances)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::search_sharded(%zu, %zu)", static_cast<size_t>(queries.extent(0)), idx.n_shards());
+  RAFT_EXPECTS(queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+               "Number of rows in output neighbors and distances matrices must equal the number of "
+               "queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must be equal");
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  using internal_IdxT = typename std::make_unsigned<IdxT>::type;
+  using filter_type   = raft::neighbors::filtering::none_cagra_sample_filter;
+
+  // The local ids of a shard start at its first row.
+  std::vector<int64_t> id_offsets(idx.offsets().begin(), idx.offsets().begin() + idx.n_shards());
+
+  raft::neighbors::detail::search_shards<T, internal_IdxT, int64_t>(
+    res,
+    idx.device_ids(),
+    [&](size_t i) -> raft::resources const& {
+      return raft::device_resources_manager::get_device_resources(idx.device_ids()[i]);
+    },
+    [&](raft::resources const& dev_res,
+        size_t i,
+        raft::device_matrix_view<const T, int64_t, row_major> shard_queries,
+        raft::device_matrix_view<internal_IdxT, int64_t, row_major> shard_neighbors,
+        raft::device_matrix_view<float, int64_t, row_major> shard_distances) {
+      search_main<T, internal_IdxT, filter_type, IdxT>(dev_res,
+                                                       params,
+                                                       idx.shard(i),
+                                                       shard_queries,
+                                                       shard_neighbors,
+                                                       shard_distances,
+                                                       filter_type());
+    },
+    queries.data_handle(),
+    queries.extent(0),
+    queries.extent(1),
+    neighbors.extent(1),
+    neighbors.data_handle(),
+    distances.data_handle(),
+    std::max<int64_t>(queries.extent(0), 1),
+    std::make_optional(std::move(id_offsets)),
+    raft::distance::is_min_close(idx.metric()),
+    false);
+}
+
+}  // namespace raft::neighbors::cagra::detail
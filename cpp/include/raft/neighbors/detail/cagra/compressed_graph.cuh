@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "../../cagra_types.hpp"
+#include "device_common.hpp"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <cstdint>
+
+namespace raft::neighbors::cagra::detail {
+
+/**
+ * Pack the graph rows into `id_bits`-wide ids (see device::load_graph_edge); one thread per output
+ * word. The ids outside of [0, size) are stored as the all-ones (invalid) id.
+ */
+template <class IdxT>
+RAFT_KERNEL kern_pack_graph(const IdxT* const graph,  // [size, degree]
+                            const int64_t size,
+                            const uint32_t degree,
+                            const uint32_t id_bits,
+                            uint32_t* const packed)  // [size, row_words]
+{
+  const uint32_t row_words = device::packed_graph_row_words(degree, id_bits);
+  const uint64_t i         = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (i >= static_cast<uint64_t>(size) * row_words) { return; }
+  const uint64_t row  = i / row_words;
+  const uint32_t word = i % row_words;
+  const uint64_t mask = (uint64_t{1} << id_bits) - 1;
+
+  const uint32_t first_bit = word * 32;
+  const uint32_t last_j    = min(degree - 1, (first_bit + 31) / id_bits);
+  uint32_t out             = 0;
+  for (uint32_t j = first_bit / id_bits; j <= last_j; j++) {
+    const auto id       = static_cast<uint64_t>(graph[row * degree + j]);
+    const uint64_t code = id < static_cast<uint64_t>(size) ? id : mask;
+    const int64_t shift = static_cast<int64_t>(j) * id_bits - first_bit;
+    out |= static_cast<uint32_t>(shift >= 0 ? code << shift : code >> -shift);
+  }
+  packed[i] = out;
+}
+
+template <class IdxT>
+RAFT_KERNEL kern_unpack_graph(const uint32_t* const packed,  // [size, row_words]
+                              const int64_t size,
+                              const uint32_t degree,
+                              const uint32_t id_bits,
+                              IdxT* const graph)  // [size, degree]
+{
+  const uint64_t i = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (i >= static_cast<uint64_t>(size) * degree) { return; }
+  const auto id = device::load_graph_edge(packed, degree, id_bits, i / degree, i % degree);
+  graph[i] = id == utils::get_max_value<uint32_t>() ? utils::get_max_value<IdxT>() : IdxT(id);
+}
+
+/** The smallest id width that leaves the all-ones id free to mark the invalid edges. */
+inline auto graph_id_bits_for(int64_t size) -> uint32_t
+{
+  uint32_t bits = 1;
+  while (bits < 64 && (uint64_t{1} << bits) <= static_cast<uint64_t>(size)) {
+    bits++;
+  }
+  return bits;
+}
+
+/** Pack a dense graph [size, degree] into the rows of `id_bits`-wide ids on the device. */
+template <class IdxT>
+auto pack_graph(raft::resources const& res,
+                raft::device_matrix_view<const IdxT, int64_t, row_major> graph,
+                uint32_t id_bits) -> raft::device_vector<uint32_t, int64_t>
+{
+  const int64_t size       = graph.extent(0);
+  const auto degree        = static_cast<uint32_t>(graph.extent(1));
+  const uint32_t row_words = device::packed_graph_row_words(degree, id_bits);
+  auto packed              = raft::make_device_vector<uint32_t, int64_t>(res, size * row_words);
+  if (size > 0) {
+    constexpr uint32_t kBlockSize = 256;
+    const auto n_threads          = static_cast<uint64_t>(size) * row_words;
+    kern_pack_graph<IdxT><<<raft::ceildiv<uint64_t>(n_threads, kBlockSize),
+                            kBlockSize,
+                            0,
+                            resource::get_cuda_stream(res)>>>(
+      graph.data_handle(), size, degree, id_bits, packed.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  return packed;
+}
+
+/** Unpack the rows of `id_bits`-wide ids into a dense graph [size, degree] on the device. */
+template <class IdxT>
+auto unpack_graph(raft::resources const& res,
+                  const uint32_t* packed,
+                  int64_t size,
+                  uint32_t degree,
+                  uint32_t id_bits) -> raft::device_matrix<IdxT, int64_t>
+{
+  auto graph = raft::make_device_matrix<IdxT, int64_t>(res, size, degree);
+  if (size > 0) {
+    constexpr uint32_t kBlockSize = 256;
+    const auto n_threads          = static_cast<uint64_t>(size) * degree;
+    kern_unpack_graph<IdxT><<<raft::ceildiv<uint64_t>(n_threads, kBlockSize),
+                              kBlockSize,
+                              0,
+                              resource::get_cuda_stream(res)>>>(
+      packed, size, degree, id_bits, graph.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  return graph;
+}
+
+template <class T, class IdxT>
+void compress_graph(raft::resources const& res, index<T, IdxT>& idx)
+{
+  if (idx.graph_id_bits() > 0) { return; }
+  const int64_t size    = idx.graph().extent(0);
+  const uint32_t degree = idx.graph_degree();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::compress_graph(%zu, %u)", static_cast<size_t>(size), degree);
+
+  const uint32_t id_bits = graph_id_bits_for(size);
+  RAFT_EXPECTS(id_bits <= 32, "The compressed graph supports at most 2^32 - 1 nodes");
+  RAFT_LOG_DEBUG("Compressing the CAGRA graph to %u-bit ids (%u bytes per node instead of %zu)",
+                 id_bits,
+                 device::packed_graph_row_words(degree, id_bits) * 4,
+                 degree * sizeof(IdxT));
+
+  auto packed = pack_graph<IdxT>(res, idx.graph(), id_bits);
+  idx.update_graph(res, std::move(packed), size, degree, id_bits);
+}
+
+template <class T, class IdxT>
+void decompress_graph(raft::resources const& res, index<T, IdxT>& idx)
+{
+  const uint32_t id_bits = idx.graph_id_bits();
+  if (id_bits == 0) { return; }
+  const int64_t size    = idx.graph().extent(0);
+  const uint32_t degree = idx.graph_degree();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::decompress_graph(%zu, %u)", static_cast<size_t>(size), degree);
+
+  auto graph = unpack_graph<IdxT>(
+    res, reinterpret_cast<const uint32_t*>(idx.graph().data_handle()), size, degree, id_bits);
+  idx.update_graph(res, std::move(graph));
+}
+
+}  // namespace raft::neighbors::cagra::detail
@@ -130,9 +130,10 @@ _RAFT_DEVICE void compute_distance_to_child_nodes(
   const typename DATASET_DESCRIPTOR_T::QUERY_T* const query_buffer,
   // [dataset_dim, dataset_size]
   const DATASET_DESCRIPTOR_T& dataset_desc,
-  // [knn_k, dataset_size]
+  // [knn_k, dataset_size], bit-packed if graph_id_bits > 0
   const INDEX_T* const knn_graph,
   const std::uint32_t knn_k,
+  const std::uint32_t graph_id_bits,
   // hashmap
   INDEX_T* const visited_hashmap_ptr,
   const std::uint32_t hash_bitlen,
@@ -151,7 +152,7 @@ _RAFT_DEVICE void compute_distance_to_child_nodes(
     INDEX_T child_id             = invalid_index;
     if (smem_parent_id != invalid_index) {
       const auto parent_id = internal_topk_list[smem_parent_id] & ~index_msb_1_mask;
-      child_id             = knn_graph[(i % knn_k) + (static_cast<int64_t>(knn_k) * parent_id)];
+      child_id = load_graph_edge(knn_graph, knn_k, graph_id_bits, parent_id, i % knn_k);
     }
     if (child_id != invalid_index) {
       if (hashmap::insert(visited_hashmap_ptr, hash_bitlen, child_id) == 0) {
@@ -55,5 +55,42 @@ _RAFT_DEVICE inline T swizzling(T x)
   }
 }
 
+/**
+ * The number of 32-bit words per row of a bit-packed graph: `graph_degree` ids of `id_bits` bits
+ * each, the rows are padded to the word boundary.
+ */
+_RAFT_HOST_DEVICE inline uint32_t packed_graph_row_words(uint32_t graph_degree, uint32_t id_bits)
+{
+  return (graph_degree * id_bits + 31) / 32;
+}
+
+/**
+ * Read the edge `j` of the node `node` of the graph.
+ *
+ * If `id_bits == 0`, the graph is a dense [dataset_size, graph_degree] matrix. Otherwise the
+ * `knn_graph` pointer holds the rows of `packed_graph_row_words(graph_degree, id_bits)` 32-bit
+ * words with the ids of `id_bits` bits each (the lowest bits first); the all-ones id marks an
+ * invalid edge.
+ */
+template <class INDEX_T>
+_RAFT_DEVICE inline INDEX_T load_graph_edge(const INDEX_T* const knn_graph,
+                                            const uint32_t graph_degree,
+                                            const uint32_t id_bits,
+                                            const uint64_t node,
+                                            const uint32_t j)
+{
+  if (id_bits == 0) { return knn_graph[j + static_cast<uint64_t>(graph_degree) * node]; }
+  const auto* row = reinterpret_cast<const uint32_t*>(knn_graph) +
+                    static_cast<uint64_t>(packed_graph_row_words(graph_degree, id_bits)) * node;
+  const uint32_t bit   = j * id_bits;
+  const uint32_t word  = bit / 32;
+  const uint32_t shift = bit % 32;
+  uint64_t v           = row[word];
+  if (shift + id_bits > 32) { v |= static_cast<uint64_t>(row[word + 1]) << 32; }
+  const uint64_t mask = (uint64_t{1} << id_bits) - 1;
+  const uint64_t id   = (v >> shift) & mask;
+  return id == mask ? utils::get_max_value<INDEX_T>() : static_cast<INDEX_T>(id);
+}
+
 }  // namespace device
 }  // namespace raft::neighbors::cagra::detail
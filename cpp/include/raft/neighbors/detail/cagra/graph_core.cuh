@@ -17,26 +17,33 @@
 
 #include "utils.hpp"
 
+#include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_device_accessor.hpp>
 #include <raft/core/mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/deadline.hpp>
+#include <raft/core/resource/host_thread_pool.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
 #include <raft/util/bitonic_sort.cuh>
 #include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/integer_utils.hpp>
 
 #include <cuda_fp16.h>
 
 #include <float.h>
-#include <omp.h>
 #include <sys/time.h>
 
 #include <cassert>
 #include <climits>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <numeric>
+#include <optional>
 #include <random>
+#include <vector>
 
 namespace raft::neighbors::cagra::detail {
 namespace graph {
@@ -76,10 +83,12 @@ RAFT_KERNEL kern_sort(const DATA_T* const dataset,  // [dataset_chunk_size, data
                       const uint32_t dataset_dim,
                       IdxT* const knn_graph,  // [graph_chunk_size, graph_degree]
                       const uint32_t graph_size,
-                      const uint32_t graph_degree)
+                      const uint32_t graph_degree,
+                      const uint64_t graph_offset)  // id of the first node of the chunk
 {
-  const IdxT srcNode = (blockDim.x * blockIdx.x + threadIdx.x) / raft::WarpSize;
-  if (srcNode >= graph_size) { return; }
+  const IdxT srcRow = (blockDim.x * blockIdx.x + threadIdx.x) / raft::WarpSize;
+  if (srcRow >= graph_size) { return; }
+  const uint64_t srcNode = srcRow + graph_offset;
 
   const uint32_t lane_id = threadIdx.x % raft::WarpSize;
 
@@ -88,7 +97,7 @@ RAFT_KERNEL kern_sort(const DATA_T* const dataset,  // [dataset_chunk_size, data
 
   // Compute distance from a src node to its neighbors
   for (int k = 0; k < graph_degree; k++) {
-    const IdxT dstNode = knn_graph[k + static_cast<uint64_t>(graph_degree) * srcNode];
+    const IdxT dstNode = knn_graph[k + static_cast<uint64_t>(graph_degree) * srcRow];
     float dist         = 0.0;
     for (int d = lane_id; d < dataset_dim; d += raft::WarpSize) {
       float diff = spatial::knn::detail::utils::mapping<float>{}(
@@ -121,7 +130,7 @@ RAFT_KERNEL kern_sort(const DATA_T* const dataset,  // [dataset_chunk_size, data
   for (int i = 0; i < numElementsPerThread; i++) {
     const int k = i * raft::WarpSize + lane_id;
     if (k < graph_degree) {
-      knn_graph[k + (static_cast<uint64_t>(graph_degree) * srcNode)] = my_vals[i];
+      knn_graph[k + (static_cast<uint64_t>(graph_degree) * srcRow)] = my_vals[i];
     }
   }
 }
@@ -133,8 +142,8 @@ RAFT_KERNEL kern_prune(const IdxT* const knn_graph,  // [graph_chunk_size, graph
                        const uint32_t degree,
                        const uint32_t batch_size,
                        const uint32_t batch_id,
-                       uint8_t* const detour_count,          // [graph_chunk_size, graph_degree]
-                       uint32_t* const num_no_detour_edges,  // [graph_size]
+                       uint8_t* const detour_count,          // [batch_size, graph_degree]
+                       uint32_t* const num_no_detour_edges,  // [batch_size]
                        uint64_t* const stats)
 {
   __shared__ uint32_t smem_num_detour[MAX_DEGREE];
@@ -172,7 +181,7 @@ RAFT_KERNEL kern_prune(const IdxT* const knn_graph,  // [graph_chunk_size, graph
 
   uint32_t num_edges_no_detour = 0;
   for (uint32_t k = threadIdx.x; k < graph_degree; k += blockDim.x) {
-    detour_count[k + (graph_degree * iA)] = min(smem_num_detour[k], (uint32_t)255);
+    detour_count[k + (graph_degree * blockIdx.x)] = min(smem_num_detour[k], (uint32_t)255);
     if (smem_num_detour[k] == 0) { num_edges_no_detour++; }
   }
   num_edges_no_detour += __shfl_xor_sync(0xffffffff, num_edges_no_detour, 1);
@@ -183,24 +192,25 @@ RAFT_KERNEL kern_prune(const IdxT* const knn_graph,  // [graph_chunk_size, graph
   num_edges_no_detour = min(num_edges_no_detour, degree);
 
   if (threadIdx.x == 0) {
-    num_no_detour_edges[iA] = num_edges_no_detour;
+    num_no_detour_edges[blockIdx.x] = num_edges_no_detour;
     atomicAdd((unsigned long long int*)num_retain, (unsigned long long int)num_edges_no_detour);
     if (num_edges_no_detour >= degree) { atomicAdd((unsigned long long int*)num_full, 1); }
   }
 }
 
 template <class IdxT>
-RAFT_KERNEL kern_make_rev_graph(const IdxT* const dest_nodes,     // [graph_size]
+RAFT_KERNEL kern_make_rev_graph(const IdxT* const dest_nodes,     // [graph_size] (strided)
                                 IdxT* const rev_graph,            // [size, degree]
                                 uint32_t* const rev_graph_count,  // [graph_size]
                                 const uint32_t graph_size,
-                                const uint32_t degree)
+                                const uint32_t degree,
+                                const uint32_t dest_nodes_stride = 1)
 {
   const uint32_t tid  = threadIdx.x + (blockDim.x * blockIdx.x);
   const uint32_t tnum = blockDim.x * gridDim.x;
 
   for (uint32_t src_id = tid; src_id < graph_size; src_id += tnum) {
-    const IdxT dest_id = dest_nodes[src_id];
+    const IdxT dest_id = dest_nodes[uint64_t(src_id) * dest_nodes_stride];
     if (dest_id >= graph_size) continue;
 
     const uint32_t pos = atomicAdd(rev_graph_count + dest_id, 1);
@@ -209,7 +219,7 @@ RAFT_KERNEL kern_make_rev_graph(const IdxT* const dest_nodes,     // [graph_size
 }
 
 template <class T>
-uint64_t pos_in_array(T val, const T* array, uint64_t num)
+_RAFT_HOST_DEVICE uint64_t pos_in_array(T val, const T* array, uint64_t num)
 {
   for (uint64_t i = 0; i < num; i++) {
     if (val == array[i]) { return i; }
@@ -218,12 +228,80 @@ uint64_t pos_in_array(T val, const T* array, uint64_t num)
 }
 
 template <class T>
-void shift_array(T* array, uint64_t num)
+_RAFT_HOST_DEVICE void shift_array(T* array, uint64_t num)
 {
   for (uint64_t i = num; i > 0; i--) {
     array[i] = array[i - 1];
   }
 }
+
+/**
+ * Pick the `output_graph_degree` edges of every node with the smallest detour counts, in the
+ * order of the input graph among the equal counts (one thread per node).
+ */
+template <class IdxT>
+RAFT_KERNEL kern_select_edges(const IdxT* const input_graph,     // [graph_size, input_degree]
+                              const uint8_t* const detour_count,  // [graph_size, input_degree]
+                              IdxT* const output_graph,           // [graph_size, output_degree]
+                              const uint64_t graph_size,
+                              const uint32_t input_graph_degree,
+                              const uint32_t output_graph_degree)
+{
+  const uint64_t i = threadIdx.x + uint64_t(blockDim.x) * blockIdx.x;
+  if (i >= graph_size) { return; }
+  const uint8_t* counts = detour_count + input_graph_degree * i;
+  uint32_t pk           = 0;
+  uint32_t num_detour   = 0;
+  while (pk < output_graph_degree) {
+    uint32_t next_num_detour = 256;
+    for (uint32_t k = 0; k < input_graph_degree && pk < output_graph_degree; k++) {
+      const uint32_t num_detour_k = counts[k];
+      if (num_detour_k > num_detour) { next_num_detour = min(num_detour_k, next_num_detour); }
+      if (num_detour_k != num_detour) { continue; }
+      output_graph[pk + uint64_t(output_graph_degree) * i] =
+        input_graph[k + uint64_t(input_graph_degree) * i];
+      pk++;
+    }
+    // The output degree never exceeds the input one, so all the edges are eventually visited
+    if (next_num_detour == 256) { break; }
+    num_detour = next_num_detour;
+  }
+}
+
+/**
+ * Replace the unprotected edges of every node with its reverse edges, like the host loop of
+ * `optimize` (one thread per node).
+ */
+template <class IdxT>
+RAFT_KERNEL kern_merge_rev_graph(IdxT* const output_graph,               // [graph_size, degree]
+                                 const IdxT* const rev_graph,            // [graph_size, degree]
+                                 const uint32_t* const rev_graph_count,  // [graph_size]
+                                 const uint64_t graph_size,
+                                 const uint32_t degree,
+                                 const uint32_t num_protected_edges,
+                                 unsigned long long int* const num_replaced_edges)
+{
+  const uint64_t j = threadIdx.x + uint64_t(blockDim.x) * blockIdx.x;
+  if (j >= graph_size) { return; }
+  IdxT* const row        = output_graph + uint64_t(degree) * j;
+  uint64_t k             = min(rev_graph_count[j], degree);
+  uint32_t num_new_edges = 0;
+  while (k) {
+    k--;
+    const IdxT i = rev_graph[k + uint64_t(degree) * j];
+
+    const uint64_t pos = pos_in_array<IdxT>(i, row, degree);
+    if (pos < num_protected_edges) { continue; }
+    uint64_t num_shift = pos - num_protected_edges;
+    if (pos == degree) {
+      num_shift = degree - num_protected_edges - 1;
+      num_new_edges++;
+    }
+    shift_array<IdxT>(row + num_protected_edges, num_shift);
+    row[num_protected_edges] = i;
+  }
+  if (num_new_edges > 0) { atomicAdd(num_replaced_edges, (unsigned long long int)num_new_edges); }
+}
 }  // namespace
 
 template <typename DataT,
@@ -234,7 +312,8 @@ template <typename DataT,
             host_device_accessor<std::experimental::default_accessor<IdxT>, memory_type::host>>
 void sort_knn_graph(raft::resources const& res,
                     mdspan<const DataT, matrix_extent<int64_t>, row_major, d_accessor> dataset,
-                    mdspan<IdxT, matrix_extent<int64_t>, row_major, g_accessor> knn_graph)
+                    mdspan<IdxT, matrix_extent<int64_t>, row_major, g_accessor> knn_graph,
+                    bool out_of_core = false)
 {
   RAFT_EXPECTS(dataset.extent(0) == knn_graph.extent(0),
                "dataset size is expected to have the same number of graph index size");
@@ -246,27 +325,40 @@ void sort_knn_graph(raft::resources const& res,
   const uint32_t input_graph_degree = knn_graph.extent(1);
   IdxT* const input_graph_ptr       = knn_graph.data_handle();
 
-  auto d_input_graph = raft::make_device_matrix<IdxT, int64_t>(res, graph_size, input_graph_degree);
-
   //
   // Sorting kNN graph
   //
   const double time_sort_start = cur_time();
   RAFT_LOG_DEBUG("# Sorting kNN Graph on GPUs ");
 
-  auto d_dataset = raft::make_device_matrix<DataT, int64_t>(res, dataset_size, dataset_dim);
-  raft::copy(d_dataset.data_handle(),
-             dataset_ptr,
-             dataset_size * dataset_dim,
-             resource::get_cuda_stream(res));
-
-  raft::copy(d_input_graph.data_handle(),
-             input_graph_ptr,
-             graph_size * input_graph_degree,
-             resource::get_cuda_stream(res));
+  // In the out-of-core mode, the kernel reads the dataset directly from the host memory and the
+  // graph is sorted in batches of rows, so that neither of them has to fit in device memory.
+  const uint64_t batch_size =
+    out_of_core ? std::min<uint64_t>(graph_size, 1024 * 1024) : static_cast<uint64_t>(graph_size);
+  auto d_input_graph = raft::make_device_matrix<IdxT, int64_t>(res, batch_size, input_graph_degree);
+
+  std::optional<raft::device_matrix<DataT, int64_t>> d_dataset;
+  std::optional<device_mapped_host_memory<const DataT>> mapped_dataset;
+  const DataT* d_dataset_ptr = nullptr;
+  if (out_of_core) {
+    mapped_dataset.emplace(dataset_ptr, static_cast<size_t>(dataset_size) * dataset_dim);
+    d_dataset_ptr = mapped_dataset->data_handle();
+  } else {
+    d_dataset.emplace(raft::make_device_matrix<DataT, int64_t>(res, dataset_size, dataset_dim));
+    raft::copy(d_dataset->data_handle(),
+               dataset_ptr,
+               static_cast<size_t>(dataset_size) * dataset_dim,
+               resource::get_cuda_stream(res));
+    d_dataset_ptr = d_dataset->data_handle();
+  }
 
-  void (*kernel_sort)(
-    const DataT* const, const IdxT, const uint32_t, IdxT* const, const uint32_t, const uint32_t);
+  void (*kernel_sort)(const DataT* const,
+                      const IdxT,
+                      const uint32_t,
+                      IdxT* const,
+                      const uint32_t,
+                      const uint32_t,
+                      const uint64_t);
   if (input_graph_degree <= 32) {
     constexpr int numElementsPerThread = 1;
     kernel_sort                        = kern_sort<DataT, IdxT, numElementsPerThread>;
@@ -294,34 +386,168 @@ void sort_knn_graph(raft::resources const& res,
   }
   const auto block_size          = 256;
   const auto num_warps_per_block = block_size / raft::WarpSize;
-  const auto grid_size           = (graph_size + num_warps_per_block - 1) / num_warps_per_block;
-
-  RAFT_LOG_DEBUG(".");
-  kernel_sort<<<grid_size, block_size, 0, resource::get_cuda_stream(res)>>>(
-    d_dataset.data_handle(),
-    dataset_size,
-    dataset_dim,
-    d_input_graph.data_handle(),
-    graph_size,
-    input_graph_degree);
+
+  for (uint64_t offset = 0; offset < static_cast<uint64_t>(graph_size); offset += batch_size) {
+    resource::check_interrupted(res);
+    const uint64_t n_rows = std::min<uint64_t>(batch_size, graph_size - offset);
+    const auto grid_size  = (n_rows + num_warps_per_block - 1) / num_warps_per_block;
+    raft::copy(d_input_graph.data_handle(),
+               input_graph_ptr + offset * input_graph_degree,
+               n_rows * input_graph_degree,
+               resource::get_cuda_stream(res));
+
+    RAFT_LOG_DEBUG(".");
+    kernel_sort<<<grid_size, block_size, 0, resource::get_cuda_stream(res)>>>(
+      d_dataset_ptr,
+      dataset_size,
+      dataset_dim,
+      d_input_graph.data_handle(),
+      n_rows,
+      input_graph_degree,
+      offset);
+    raft::copy(input_graph_ptr + offset * input_graph_degree,
+               d_input_graph.data_handle(),
+               n_rows * input_graph_degree,
+               resource::get_cuda_stream(res));
+  }
   resource::sync_stream(res);
-  RAFT_LOG_DEBUG(".");
-  raft::copy(input_graph_ptr,
-             d_input_graph.data_handle(),
-             graph_size * input_graph_degree,
-             resource::get_cuda_stream(res));
   RAFT_LOG_DEBUG("\n");
 
   const double time_sort_end = cur_time();
   RAFT_LOG_DEBUG("# Sorting kNN graph time: %.1lf sec\n", time_sort_end - time_sort_start);
 }
 
+/**
+ * The device-resident path of `optimize`: the detour counts, the pruned graph and the reverse graph
+ * are all kept in the device memory, and only the final graph is copied back to the host.
+ *
+ * @return false, without modifying `new_graph`, if the buffers do not fit into the device memory.
+ */
+template <typename IdxT>
+bool optimize_on_device(raft::resources const& res,
+                        raft::host_matrix_view<IdxT, int64_t, row_major> knn_graph,
+                        raft::host_matrix_view<IdxT, int64_t, row_major> new_graph)
+{
+  auto stream                        = resource::get_cuda_stream(res);
+  const uint32_t input_graph_degree  = knn_graph.extent(1);
+  const uint32_t output_graph_degree = new_graph.extent(1);
+  const uint64_t graph_size          = new_graph.extent(0);
+
+  std::optional<device_matrix_view_from_host<IdxT, int64_t>> d_input_graph;
+  std::optional<raft::device_matrix<uint8_t, int64_t>> d_detour_count;
+  std::optional<raft::device_matrix<IdxT, int64_t>> d_output_graph;
+  std::optional<raft::device_matrix<IdxT, int64_t>> d_rev_graph;
+  std::optional<raft::device_vector<uint32_t, int64_t>> d_rev_graph_count;
+  try {
+    d_input_graph.emplace(res, knn_graph);
+    d_detour_count.emplace(
+      raft::make_device_matrix<uint8_t, int64_t>(res, graph_size, input_graph_degree));
+    d_output_graph.emplace(
+      raft::make_device_matrix<IdxT, int64_t>(res, graph_size, output_graph_degree));
+    d_rev_graph.emplace(
+      raft::make_device_matrix<IdxT, int64_t>(res, graph_size, output_graph_degree));
+    d_rev_graph_count.emplace(raft::make_device_vector<uint32_t, int64_t>(res, graph_size));
+  } catch (std::bad_alloc& e) {
+    RAFT_LOG_DEBUG("# The graph does not fit into the device memory (%s)", e.what());
+    return false;
+  }
+  auto dev_stats = raft::make_device_vector<uint64_t>(res, 2);
+  RAFT_CUDA_TRY(cudaMemsetAsync(dev_stats.data_handle(), 0, sizeof(uint64_t) * 2, stream));
+
+  // Prune unimportant edges (see `optimize`)
+  const double time_prune_start = cur_time();
+  constexpr int MAX_DEGREE      = 1024;
+  const uint32_t batch_size =
+    std::min(static_cast<uint32_t>(graph_size), static_cast<uint32_t>(256 * 1024));
+  const uint32_t num_batch = (graph_size + batch_size - 1) / batch_size;
+
+  auto d_num_no_detour_edges = raft::make_device_vector<uint32_t, int64_t>(res, batch_size);
+  for (uint32_t i_batch = 0; i_batch < num_batch; i_batch++) {
+    resource::check_interrupted(res);
+    // The kernel indexes its outputs from the start of the batch
+    const uint64_t batch_offset = static_cast<uint64_t>(batch_size) * i_batch;
+    auto* batch_detour_count    = d_detour_count->data_handle() + batch_offset * input_graph_degree;
+    kern_prune<MAX_DEGREE, IdxT><<<batch_size, 32, 0, stream>>>(d_input_graph->data_handle(),
+                                                                graph_size,
+                                                                input_graph_degree,
+                                                                output_graph_degree,
+                                                                batch_size,
+                                                                i_batch,
+                                                                batch_detour_count,
+                                                                d_num_no_detour_edges.data_handle(),
+                                                                dev_stats.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  constexpr uint32_t kBlockSize = 256;
+  const uint32_t n_blocks       = raft::ceildiv<uint64_t>(graph_size, kBlockSize);
+  kern_select_edges<IdxT><<<n_blocks, kBlockSize, 0, stream>>>(d_input_graph->data_handle(),
+                                                               d_detour_count->data_handle(),
+                                                               d_output_graph->data_handle(),
+                                                               graph_size,
+                                                               input_graph_degree,
+                                                               output_graph_degree);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  d_detour_count.reset();
+  d_input_graph.reset();
+
+  uint64_t host_stats[2];
+  raft::copy(host_stats, dev_stats.data_handle(), 2, stream);
+  resource::sync_stream(res);
+  RAFT_LOG_DEBUG(
+    "# Pruning time: %.1lf sec, "
+    "avg_no_detour_edges_per_node: %.2lf/%u, "
+    "nodes_with_no_detour_at_all_edges: %.1lf%%\n",
+    cur_time() - time_prune_start,
+    (double)host_stats[0] / graph_size,
+    output_graph_degree,
+    (double)host_stats[1] / graph_size * 100);
+
+  // Make the reverse graph, visiting the edges of the same rank of all the nodes at a time
+  const double time_make_start = cur_time();
+  RAFT_CUDA_TRY(cudaMemsetAsync(
+    d_rev_graph->data_handle(), 0xff, d_rev_graph->size() * sizeof(IdxT), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(
+    d_rev_graph_count->data_handle(), 0x00, graph_size * sizeof(uint32_t), stream));
+  for (uint32_t k = 0; k < output_graph_degree; k++) {
+    kern_make_rev_graph<<<1024, 256, 0, stream>>>(d_output_graph->data_handle() + k,
+                                                   d_rev_graph->data_handle(),
+                                                   d_rev_graph_count->data_handle(),
+                                                   graph_size,
+                                                   output_graph_degree,
+                                                   output_graph_degree);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  resource::sync_stream(res);
+  RAFT_LOG_DEBUG("# Making reverse graph time: %.1lf sec", cur_time() - time_make_start);
+
+  // Replace some edges with reverse edges
+  const double time_replace_start = cur_time();
+  auto num_replaced_edges         = raft::make_device_scalar<unsigned long long int>(res, 0);
+  kern_merge_rev_graph<IdxT><<<n_blocks, kBlockSize, 0, stream>>>(d_output_graph->data_handle(),
+                                                                  d_rev_graph->data_handle(),
+                                                                  d_rev_graph_count->data_handle(),
+                                                                  graph_size,
+                                                                  output_graph_degree,
+                                                                  output_graph_degree / 2,
+                                                                  num_replaced_edges.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  raft::copy(new_graph.data_handle(), d_output_graph->data_handle(), new_graph.size(), stream);
+  unsigned long long int num_replaced_edges_host = 0;
+  raft::copy(&num_replaced_edges_host, num_replaced_edges.data_handle(), 1, stream);
+  resource::sync_stream(res);
+  RAFT_LOG_DEBUG("# Replacing edges time: %.1lf sec", cur_time() - time_replace_start);
+  RAFT_LOG_DEBUG("# Average number of replaced edges per node: %.2f",
+                 (double)num_replaced_edges_host / graph_size);
+  return true;
+}
+
 template <typename IdxT = uint32_t,
           typename g_accessor =
             host_device_accessor<std::experimental::default_accessor<IdxT>, memory_type::host>>
 void optimize(raft::resources const& res,
               mdspan<IdxT, matrix_extent<int64_t>, row_major, g_accessor> knn_graph,
-              raft::host_matrix_view<IdxT, int64_t, row_major> new_graph)
+              raft::host_matrix_view<IdxT, int64_t, row_major> new_graph,
+              bool out_of_core = false)
 {
   RAFT_LOG_DEBUG(
     "# Pruning kNN graph (size=%lu, degree=%lu)\n", knn_graph.extent(0), knn_graph.extent(1));
@@ -336,23 +562,43 @@ void optimize(raft::resources const& res,
   auto output_graph_ptr              = new_graph.data_handle();
   const IdxT graph_size              = new_graph.extent(0);
 
+  constexpr int MAX_DEGREE = 1024;
+  if (input_graph_degree > MAX_DEGREE) {
+    RAFT_FAIL(
+      "The degree of input knn graph is too large (%u). "
+      "It must be equal to or smaller than %d.",
+      input_graph_degree,
+      1024);
+  }
+
+  // Unless the graph is to stay in the host memory, all the steps run on the device if it fits
+  // there; the host path below is the fallback.
+  if (!out_of_core &&
+      optimize_on_device<IdxT>(
+        res,
+        raft::make_host_matrix_view<IdxT, int64_t>(input_graph_ptr, graph_size, input_graph_degree),
+        new_graph)) {
+    return;
+  }
+
+  // The host loops below run on the thread pool of `res`; the cheap per-row loops are chunked by
+  // at least this many rows.
+  auto& pool                   = resource::get_host_thread_pool(res);
+  constexpr int64_t kPoolGrain = 1024;
+
   {
     //
     // Prune kNN graph
     //
-    auto d_detour_count =
-      raft::make_device_matrix<uint8_t, int64_t>(res, graph_size, input_graph_degree);
-
-    RAFT_CUDA_TRY(cudaMemsetAsync(d_detour_count.data_handle(),
-                                  0xff,
-                                  graph_size * input_graph_degree * sizeof(uint8_t),
-                                  resource::get_cuda_stream(res)));
+    const uint32_t batch_size =
+      std::min(static_cast<uint32_t>(graph_size), static_cast<uint32_t>(256 * 1024));
+    const uint32_t num_batch = (graph_size + batch_size - 1) / batch_size;
 
-    auto d_num_no_detour_edges = raft::make_device_vector<uint32_t, int64_t>(res, graph_size);
-    RAFT_CUDA_TRY(cudaMemsetAsync(d_num_no_detour_edges.data_handle(),
-                                  0x00,
-                                  graph_size * sizeof(uint32_t),
-                                  resource::get_cuda_stream(res)));
+    // The detour counts are computed on the device one batch at a time.
+    auto detour_count = raft::make_host_matrix<uint8_t, int64_t>(graph_size, input_graph_degree);
+    auto d_detour_count =
+      raft::make_device_matrix<uint8_t, int64_t>(res, batch_size, input_graph_degree);
+    auto d_num_no_detour_edges = raft::make_device_vector<uint32_t, int64_t>(res, batch_size);
 
     auto dev_stats  = raft::make_device_vector<uint64_t>(res, 2);
     auto host_stats = raft::make_host_vector<uint64_t>(2);
@@ -373,22 +619,16 @@ void optimize(raft::resources const& res,
     const double time_prune_start = cur_time();
     RAFT_LOG_DEBUG("# Pruning kNN Graph on GPUs\r");
 
+    // In the out-of-core mode, the kernel traverses the input graph directly in the host memory.
+    std::optional<device_mapped_host_memory<IdxT>> mapped_input_graph;
+    if (out_of_core) {
+      mapped_input_graph.emplace(input_graph_ptr, uint64_t(graph_size) * input_graph_degree);
+    }
     // Copy input_graph_ptr over to device if necessary
     device_matrix_view_from_host d_input_graph(
       res,
       raft::make_host_matrix_view<IdxT, int64_t>(input_graph_ptr, graph_size, input_graph_degree));
 
-    constexpr int MAX_DEGREE = 1024;
-    if (input_graph_degree > MAX_DEGREE) {
-      RAFT_FAIL(
-        "The degree of input knn graph is too large (%u). "
-        "It must be equal to or smaller than %d.",
-        input_graph_degree,
-        1024);
-    }
-    const uint32_t batch_size =
-      std::min(static_cast<uint32_t>(graph_size), static_cast<uint32_t>(256 * 1024));
-    const uint32_t num_batch = (graph_size + batch_size - 1) / batch_size;
     const dim3 threads_prune(32, 1, 1);
     const dim3 blocks_prune(batch_size, 1, 1);
 
@@ -396,6 +636,7 @@ void optimize(raft::resources const& res,
       dev_stats.data_handle(), 0, sizeof(uint64_t) * 2, resource::get_cuda_stream(res)));
 
     for (uint32_t i_batch = 0; i_batch < num_batch; i_batch++) {
+      resource::check_interrupted(res);
       kern_prune<MAX_DEGREE, IdxT>
         <<<blocks_prune, threads_prune, 0, resource::get_cuda_stream(res)>>>(
           d_input_graph.data_handle(),
@@ -407,6 +648,12 @@ void optimize(raft::resources const& res,
           d_detour_count.data_handle(),
           d_num_no_detour_edges.data_handle(),
           dev_stats.data_handle());
+      const uint64_t batch_offset = static_cast<uint64_t>(batch_size) * i_batch;
+      const uint64_t n_rows       = std::min<uint64_t>(batch_size, graph_size - batch_offset);
+      raft::copy(detour_count.data_handle() + batch_offset * input_graph_degree,
+                 d_detour_count.data_handle(),
+                 n_rows * input_graph_degree,
+                 resource::get_cuda_stream(res));
       resource::sync_stream(res);
       RAFT_LOG_DEBUG(
         "# Pruning kNN Graph on GPUs (%.1lf %%)\r",
@@ -415,16 +662,13 @@ void optimize(raft::resources const& res,
     resource::sync_stream(res);
     RAFT_LOG_DEBUG("\n");
 
-    host_matrix_view_from_device<uint8_t, int64_t> detour_count(res, d_detour_count.view());
-
     raft::copy(
       host_stats.data_handle(), dev_stats.data_handle(), 2, resource::get_cuda_stream(res));
     const auto num_keep = host_stats.data_handle()[0];
     const auto num_full = host_stats.data_handle()[1];
 
     // Create pruned kNN graph
-#pragma omp parallel for
-    for (uint64_t i = 0; i < graph_size; i++) {
+    pool.parallel_for(0, graph_size, [&](int64_t i) {
       // Find the `output_graph_degree` smallest detourable count nodes by checking the detourable
       // count of the neighbors while increasing the target detourable count from zero.
       uint64_t pk         = 0;
@@ -455,7 +699,7 @@ void optimize(raft::resources const& res,
                    "node %lu in the rank-based node reranking process",
                    output_graph_degree,
                    static_cast<uint64_t>(i));
-    }
+    });
 
     const double time_prune_end = cur_time();
     RAFT_LOG_DEBUG(
@@ -477,10 +721,12 @@ void optimize(raft::resources const& res,
     //
     const double time_make_start = cur_time();
 
+    std::optional<device_mapped_host_memory<IdxT>> mapped_rev_graph;
+    if (out_of_core) { mapped_rev_graph.emplace(rev_graph.data_handle(), rev_graph.size()); }
     device_matrix_view_from_host<IdxT, int64_t> d_rev_graph(res, rev_graph.view());
     RAFT_CUDA_TRY(cudaMemsetAsync(d_rev_graph.data_handle(),
                                   0xff,
-                                  graph_size * output_graph_degree * sizeof(IdxT),
+                                  rev_graph.size() * sizeof(IdxT),
                                   resource::get_cuda_stream(res)));
 
     auto d_rev_graph_count = raft::make_device_vector<uint32_t, int64_t>(res, graph_size);
@@ -493,10 +739,14 @@ void optimize(raft::resources const& res,
     auto d_dest_nodes = raft::make_device_vector<IdxT, int64_t>(res, graph_size);
 
     for (uint64_t k = 0; k < output_graph_degree; k++) {
-#pragma omp parallel for
-      for (uint64_t i = 0; i < graph_size; i++) {
-        dest_nodes.data_handle()[i] = output_graph_ptr[k + (output_graph_degree * i)];
-      }
+      resource::check_interrupted(res);
+      pool.parallel_for(
+        0,
+        graph_size,
+        [&](int64_t i) {
+          dest_nodes.data_handle()[i] = output_graph_ptr[k + (output_graph_degree * i)];
+        },
+        kPoolGrain);
       resource::sync_stream(res);
 
       raft::copy(d_dest_nodes.data_handle(),
@@ -521,7 +771,7 @@ void optimize(raft::resources const& res,
     if (d_rev_graph.allocated_memory()) {
       raft::copy(rev_graph.data_handle(),
                  d_rev_graph.data_handle(),
-                 graph_size * output_graph_degree,
+                 rev_graph.size(),
                  resource::get_cuda_stream(res));
     }
     raft::copy(rev_graph_count.data_handle(),
@@ -542,45 +792,58 @@ void optimize(raft::resources const& res,
     const uint64_t num_protected_edges = output_graph_degree / 2;
     RAFT_LOG_DEBUG("# num_protected_edges: %lu", num_protected_edges);
 
-    constexpr int _omp_chunk = 1024;
-#pragma omp parallel for schedule(dynamic, _omp_chunk)
-    for (uint64_t j = 0; j < graph_size; j++) {
-      uint64_t k = std::min(rev_graph_count.data_handle()[j], output_graph_degree);
-      while (k) {
-        k--;
-        uint64_t i = rev_graph.data_handle()[k + (output_graph_degree * j)];
-
-        uint64_t pos =
-          pos_in_array<IdxT>(i, output_graph_ptr + (output_graph_degree * j), output_graph_degree);
-        if (pos < num_protected_edges) { continue; }
-        uint64_t num_shift = pos - num_protected_edges;
-        if (pos == output_graph_degree) {
-          num_shift = output_graph_degree - num_protected_edges - 1;
+    pool.parallel_for_chunks(
+      0,
+      graph_size,
+      [&](int64_t begin, int64_t end, size_t thread_index) {
+        for (uint64_t j = begin; j < uint64_t(end); j++) {
+          uint64_t k = std::min(rev_graph_count.data_handle()[j], output_graph_degree);
+          while (k) {
+            k--;
+            uint64_t i = rev_graph.data_handle()[k + (output_graph_degree * j)];
+
+            uint64_t pos = pos_in_array<IdxT>(
+              i, output_graph_ptr + (output_graph_degree * j), output_graph_degree);
+            if (pos < num_protected_edges) { continue; }
+            uint64_t num_shift = pos - num_protected_edges;
+            if (pos == output_graph_degree) {
+              num_shift = output_graph_degree - num_protected_edges - 1;
+            }
+            shift_array<IdxT>(output_graph_ptr + num_protected_edges + (output_graph_degree * j),
+                              num_shift);
+            output_graph_ptr[num_protected_edges + (output_graph_degree * j)] = i;
+          }
         }
-        shift_array<IdxT>(output_graph_ptr + num_protected_edges + (output_graph_degree * j),
-                          num_shift);
-        output_graph_ptr[num_protected_edges + (output_graph_degree * j)] = i;
-      }
-      if ((omp_get_thread_num() == 0) && ((j % _omp_chunk) == 0)) {
-        RAFT_LOG_DEBUG("# Replacing reverse edges: %lu / %lu    ", j, graph_size);
-      }
-    }
+        if (thread_index == 0) {
+          RAFT_LOG_DEBUG("# Replacing reverse edges: %ld / %lu    ", end, graph_size);
+        }
+      },
+      kPoolGrain);
     RAFT_LOG_DEBUG("\n");
 
     const double time_replace_end = cur_time();
     RAFT_LOG_DEBUG("# Replacing edges time: %.1lf sec", time_replace_end - time_replace_start);
 
     /* stats */
-    uint64_t num_replaced_edges = 0;
-#pragma omp parallel for reduction(+ : num_replaced_edges)
-    for (uint64_t i = 0; i < graph_size; i++) {
-      for (uint64_t k = 0; k < output_graph_degree; k++) {
-        const uint64_t j = output_graph_ptr[k + (output_graph_degree * i)];
-        const uint64_t pos =
-          pos_in_array<IdxT>(j, output_graph_ptr + (output_graph_degree * i), output_graph_degree);
-        if (pos == output_graph_degree) { num_replaced_edges += 1; }
-      }
-    }
+    std::vector<uint64_t> num_replaced_edges_per_thread(pool.n_threads(), 0);
+    pool.parallel_for_chunks(
+      0,
+      graph_size,
+      [&](int64_t begin, int64_t end, size_t thread_index) {
+        uint64_t count = 0;
+        for (uint64_t i = begin; i < uint64_t(end); i++) {
+          for (uint64_t k = 0; k < output_graph_degree; k++) {
+            const uint64_t j   = output_graph_ptr[k + (output_graph_degree * i)];
+            const uint64_t pos = pos_in_array<IdxT>(
+              j, output_graph_ptr + (output_graph_degree * i), output_graph_degree);
+            if (pos == output_graph_degree) { count += 1; }
+          }
+        }
+        num_replaced_edges_per_thread[thread_index] += count;
+      },
+      kPoolGrain);
+    const uint64_t num_replaced_edges = std::accumulate(
+      num_replaced_edges_per_thread.begin(), num_replaced_edges_per_thread.end(), uint64_t{0});
     RAFT_LOG_DEBUG("# Average number of replaced edges per node: %.2f",
                    (double)num_replaced_edges / graph_size);
   }
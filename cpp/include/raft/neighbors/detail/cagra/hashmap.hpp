@@ -18,6 +18,7 @@
 #include "utils.hpp"
 
 #include <raft/core/detail/macros.hpp>
+#include <raft/util/bounded_hash_map.cuh>
 #include <raft/util/device_atomics.cuh>
 
 #include <cstdint>
@@ -30,40 +31,22 @@ namespace hashmap {
 
 _RAFT_HOST_DEVICE inline uint32_t get_size(const uint32_t bitlen) { return 1U << bitlen; }
 
+// The visited sets of the search are linear probing tables of node ids, hashed by folding their
+// high bits onto the low ones.
+template <class IdxT>
+using visited_set = raft::util::bounded_hash_set<IdxT, uint32_t, raft::util::hash::xor_fold>;
+
 template <class IdxT>
 _RAFT_DEVICE inline void init(IdxT* const table, const unsigned bitlen, unsigned FIRST_TID = 0)
 {
   if (threadIdx.x < FIRST_TID) return;
-  for (unsigned i = threadIdx.x - FIRST_TID; i < get_size(bitlen); i += blockDim.x - FIRST_TID) {
-    table[i] = utils::get_max_value<IdxT>();
-  }
+  visited_set<IdxT>{table, bitlen}.reset(threadIdx.x - FIRST_TID, blockDim.x - FIRST_TID);
 }
 
 template <class IdxT>
 _RAFT_DEVICE inline uint32_t insert(IdxT* const table, const uint32_t bitlen, const IdxT key)
 {
-  // Open addressing is used for collision resolution
-  const uint32_t size     = get_size(bitlen);
-  const uint32_t bit_mask = size - 1;
-#if 1
-  // Linear probing
-  IdxT index                = (key ^ (key >> bitlen)) & bit_mask;
-  constexpr uint32_t stride = 1;
-#else
-  // Double hashing
-  uint32_t index        = key & bit_mask;
-  const uint32_t stride = (key >> bitlen) * 2 + 1;
-#endif
-  for (unsigned i = 0; i < size; i++) {
-    const IdxT old = atomicCAS(&table[index], ~static_cast<IdxT>(0), key);
-    if (old == ~static_cast<IdxT>(0)) {
-      return 1;
-    } else if (old == key) {
-      return 0;
-    }
-    index = (index + stride) & bit_mask;
-  }
-  return 0;
+  return visited_set<IdxT>{table, bitlen}.insert(key);
 }
 
 template <unsigned TEAM_SIZE, class IdxT>
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "../../cagra_types.hpp"
+
+#include <raft/core/bitset.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <thrust/count.h>
+
+#include <omp.h>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::cagra::detail {
+
+template <class T, class IdxT>
+RAFT_KERNEL kern_gather_rows(const T* const src,       // [src_size, stride]
+                             const IdxT* const ids,    // [dst_size]
+                             const int64_t dst_size,
+                             const uint32_t dim,
+                             const uint32_t stride,
+                             T* const dst)  // [dst_size, stride]
+{
+  const uint64_t i = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (i >= static_cast<uint64_t>(dst_size) * dim) { return; }
+  const uint64_t row = i / dim;
+  const uint64_t col = i % dim;
+  dst[row * stride + col] = src[static_cast<uint64_t>(ids[row]) * stride + col];
+}
+
+/** Mark the samples `ids` of the index as removed. */
+template <class T, class IdxT>
+void remove(raft::resources const& res,
+            index<T, IdxT>& idx,
+            raft::device_vector_view<const IdxT, int64_t> ids)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::remove(%zu)", static_cast<size_t>(ids.extent(0)));
+  if (ids.extent(0) == 0) { return; }
+
+  // The bitset does not check the range of the ids it sets.
+  const auto n_rows    = static_cast<uint64_t>(idx.size());
+  const auto n_invalid = thrust::count_if(
+    resource::get_thrust_policy(res),
+    ids.data_handle(),
+    ids.data_handle() + ids.extent(0),
+    [n_rows] __device__(IdxT id) { return static_cast<uint64_t>(id) >= n_rows; });
+  RAFT_EXPECTS(n_invalid == 0,
+               "%zu of the ids to remove are out of the range of the index size (%zu)",
+               static_cast<size_t>(n_invalid),
+               static_cast<size_t>(n_rows));
+
+  auto removed = std::move(idx.removed_bitset());
+  if (!removed.has_value()) {
+    removed.emplace(res, static_cast<IdxT>(idx.size()), true);
+  } else if (removed->size() != static_cast<IdxT>(idx.size())) {
+    removed->resize(res, static_cast<IdxT>(idx.size()), true);
+  }
+  removed->set(res,
+               raft::make_device_vector_view<const IdxT, IdxT>(
+                 ids.data_handle(), static_cast<IdxT>(ids.extent(0))));
+  const IdxT num_removed = static_cast<IdxT>(idx.size()) - removed->count(res);
+  idx.update_removed(std::move(removed), num_removed);
+}
+
+/**
+ * Drop the removed samples from the index.
+ *
+ * The edges of the remaining nodes that point at removed nodes are replaced by the neighbors of
+ * the removed nodes (two-hop edges), so that the graph stays connected around the deleted area.
+ *
+ * @return the mapping from the new to the old sample ids, or std::nullopt if the index has not
+ * been modified because fewer than `min_removed_fraction * idx.size()` samples are removed.
+ */
+template <class T, class IdxT>
+auto compact(raft::resources const& res, index<T, IdxT>& idx, float min_removed_fraction)
+  -> std::optional<raft::device_vector<IdxT, int64_t>>
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::compact(%zu, %zu)",
+    static_cast<size_t>(idx.size()),
+    static_cast<size_t>(idx.num_removed()));
+
+  const int64_t old_size    = idx.size();
+  const int64_t num_removed = idx.num_removed();
+  if (num_removed == 0 || num_removed < min_removed_fraction * old_size) { return std::nullopt; }
+
+  using ds_idx_type  = decltype(idx.data().n_rows());
+  auto* strided_dset = dynamic_cast<const strided_dataset<T, ds_idx_type>*>(&idx.data());
+  RAFT_EXPECTS(strided_dset != nullptr,
+               "cagra::compact only supports an uncompressed dataset attached to the index");
+  RAFT_EXPECTS(num_removed < old_size, "Cannot compact an index where all samples are removed");
+  RAFT_EXPECTS(idx.graph_id_bits() == 0,
+               "The graph is compressed; call cagra::decompress_graph before compacting the index");
+
+  const int64_t new_size = old_size - num_removed;
+  const uint32_t degree  = idx.graph_degree();
+  const uint32_t stride  = strided_dset->stride();
+  auto stream            = resource::get_cuda_stream(res);
+
+  const auto& removed = *idx.removed_bitset();
+  std::vector<uint32_t> h_bits(removed.n_elements());
+  raft::copy(h_bits.data(), removed.data(), h_bits.size(), stream);
+  auto old_graph = raft::make_host_matrix<IdxT, int64_t>(old_size, degree);
+  raft::copy(old_graph.data_handle(), idx.graph().data_handle(), idx.graph().size(), stream);
+  resource::sync_stream(res);
+
+  const auto is_live = [&](uint64_t i) { return (h_bits[i / 32] >> (i % 32)) & 1u; };
+  constexpr auto kInvalid = std::numeric_limits<IdxT>::max();
+  std::vector<IdxT> old_to_new(old_size, kInvalid);
+  auto new_to_old = raft::make_host_vector<IdxT, int64_t>(new_size);
+  for (int64_t i = 0, j = 0; i < old_size; i++) {
+    if (is_live(i)) {
+      old_to_new[i]   = j;
+      new_to_old(j++) = i;
+    }
+  }
+
+  auto new_graph = raft::make_host_matrix<IdxT, int64_t>(new_size, degree);
+#pragma omp parallel for
+  for (int64_t i = 0; i < new_size; i++) {
+    const auto* old_row = old_graph.data_handle() + static_cast<uint64_t>(new_to_old(i)) * degree;
+    auto* new_row       = new_graph.data_handle() + static_cast<uint64_t>(i) * degree;
+    uint32_t n          = 0;
+    const auto append_new = [&](IdxT new_id) {
+      if (new_id == kInvalid || new_id == static_cast<IdxT>(i)) { return; }
+      for (uint32_t k = 0; k < n; k++) {
+        if (new_row[k] == new_id) { return; }
+      }
+      new_row[n++] = new_id;
+    };
+    const auto append = [&](IdxT old_id) {
+      if (old_id < old_size) { append_new(old_to_new[old_id]); }
+    };
+    // Keep the live neighbors in their rank order first.
+    for (uint32_t k = 0; k < degree && n < degree; k++) {
+      append(old_row[k]);
+    }
+    // Refill the slots of the removed neighbors with their own neighbors.
+    for (uint32_t k = 0; k < degree && n < degree; k++) {
+      if (old_row[k] >= old_size || is_live(old_row[k])) { continue; }
+      const auto* two_hop = old_graph.data_handle() + static_cast<uint64_t>(old_row[k]) * degree;
+      for (uint32_t l = 0; l < degree && n < degree; l++) {
+        append(two_hop[l]);
+      }
+    }
+    // Very sparse neighborhoods: fall back to the neighbors of the live neighbors.
+    for (uint32_t k = 0; k < n && n < degree; k++) {
+      const auto* two_hop =
+        old_graph.data_handle() + static_cast<uint64_t>(new_to_old(new_row[k])) * degree;
+      for (uint32_t l = 0; l < degree && n < degree; l++) {
+        append(two_hop[l]);
+      }
+    }
+    // Pad the remaining slots with pseudo-random live nodes, then with the next nodes in order.
+    for (uint64_t r = i, tries = 0; n < degree && tries < degree;
+         r += 1 + new_size / degree, tries++) {
+      append_new(static_cast<IdxT>((r * 2654435761ull + 1) % new_size));
+    }
+    for (int64_t l = 1; l < new_size && n < degree; l++) {
+      append_new(static_cast<IdxT>((i + l) % new_size));
+    }
+    // Fewer live nodes than the degree: repeat the first neighbor (a lone node points at itself).
+    for (; n < degree; n++) {
+      new_row[n] = n > 0 ? new_row[0] : static_cast<IdxT>(i);
+    }
+  }
+
+  auto d_new_to_old = raft::make_device_vector<IdxT, int64_t>(res, new_size);
+  raft::copy(d_new_to_old.data_handle(), new_to_old.data_handle(), new_size, stream);
+
+  auto compacted_dataset = raft::make_device_matrix<T, int64_t>(res, new_size, stride);
+  RAFT_CUDA_TRY(cudaMemsetAsync(
+    compacted_dataset.data_handle(), 0, compacted_dataset.size() * sizeof(T), stream));
+  const uint32_t block_size = 256;
+  const uint64_t num_items  = static_cast<uint64_t>(new_size) * idx.dim();
+  const uint32_t grid_size  = raft::ceildiv<uint64_t>(num_items, block_size);
+  kern_gather_rows<T, IdxT>
+    <<<grid_size, block_size, 0, stream>>>(strided_dset->view().data_handle(),
+                                           d_new_to_old.data_handle(),
+                                           new_size,
+                                           idx.dim(),
+                                           stride,
+                                           compacted_dataset.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  using out_mdarray_type          = decltype(compacted_dataset);
+  using out_layout_type           = typename out_mdarray_type::layout_type;
+  using out_container_policy_type = typename out_mdarray_type::container_policy_type;
+  using out_owning_type = owning_dataset<T, int64_t, out_layout_type, out_container_policy_type>;
+  auto out_layout = make_strided_layout(
+    raft::matrix_extent<int64_t>(new_size, idx.dim()), std::array<int64_t, 2>{stride, 1});
+
+  idx.update_dataset(res,
+                     std::make_unique<out_owning_type>(std::move(compacted_dataset), out_layout));
+  idx.update_graph(res, raft::make_const_mdspan(new_graph.view()));
+  idx.update_removed(std::nullopt, 0);
+  resource::sync_stream(res);
+  return std::make_optional(std::move(d_new_to_old));
+}
+
+}  // namespace raft::neighbors::cagra::detail
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "../../cagra_types.hpp"
+#include "remove_nodes.cuh"
+
+#include <raft/cluster/kmeans_balanced.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::neighbors::cagra::detail {
+
+/** new_graph[i, k] = old_to_new[old_graph[new_to_old[i], k]] */
+template <class IdxT>
+RAFT_KERNEL kern_relabel_graph(const IdxT* const old_graph,   // [size, degree]
+                               const IdxT* const new_to_old,  // [size]
+                               const IdxT* const old_to_new,  // [size]
+                               const int64_t size,
+                               const uint32_t degree,
+                               IdxT* const new_graph)  // [size, degree]
+{
+  const uint64_t i = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (i >= static_cast<uint64_t>(size) * degree) { return; }
+  const uint64_t row = i / degree;
+  const uint64_t col = i % degree;
+  const IdxT old_id  = old_graph[static_cast<uint64_t>(new_to_old[row]) * degree + col];
+  // Keep the invalid (padding) edges as they are
+  new_graph[i] = old_id < size ? old_to_new[old_id] : old_id;
+}
+
+/**
+ * Relabel the nodes of the index in the cluster-major order: the balanced k-means clusters of the
+ * dataset are stored one after another, the nodes of a cluster keeping their relative order.
+ *
+ * @return the mapping from the new to the old sample ids [idx.size()]
+ */
+template <class T, class IdxT>
+auto reorder(raft::resources const& res, const reorder_params& params, index<T, IdxT>& idx)
+  -> raft::device_vector<IdxT, int64_t>
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::reorder(%zu)", static_cast<size_t>(idx.size()));
+
+  using ds_idx_type  = decltype(idx.data().n_rows());
+  auto* strided_dset = dynamic_cast<const strided_dataset<T, ds_idx_type>*>(&idx.data());
+  RAFT_EXPECTS(strided_dset != nullptr,
+               "cagra::reorder only supports an uncompressed dataset attached to the index");
+  RAFT_EXPECTS(idx.num_removed() == 0,
+               "cagra::reorder requires an index without removed samples (see cagra::compact)");
+  RAFT_EXPECTS(params.cluster_size > 0, "cluster_size must be positive");
+  RAFT_EXPECTS(idx.graph_id_bits() == 0,
+               "The graph is compressed; call cagra::decompress_graph before reordering the index");
+
+  const int64_t size    = idx.size();
+  const uint32_t dim    = idx.dim();
+  const uint32_t degree = idx.graph_degree();
+  const uint32_t stride = strided_dset->stride();
+  const T* dataset      = strided_dset->view().data_handle();
+  auto stream           = resource::get_cuda_stream(res);
+  auto policy           = resource::get_thrust_policy(res);
+
+  auto new_to_old = raft::make_device_vector<IdxT, int64_t>(res, size);
+  thrust::sequence(policy, new_to_old.data_handle(), new_to_old.data_handle() + size);
+
+  const auto n_clusters = static_cast<uint32_t>(raft::ceildiv<int64_t>(size, params.cluster_size));
+  if (n_clusters > 1) {
+    raft::cluster::kmeans_balanced_params kmeans_params;
+    kmeans_params.n_iters = params.kmeans_n_iters;
+    auto centers = raft::make_device_matrix<float, int64_t>(res, n_clusters, dim);
+
+    // Train on a strided subsample of the rows, packed without the padding of the dataset
+    const int64_t n_train = std::clamp<int64_t>(
+      static_cast<int64_t>(size * params.kmeans_trainset_fraction), n_clusters, size);
+    const int64_t train_step = size / n_train;
+    auto trainset            = raft::make_device_matrix<T, int64_t>(res, n_train, dim);
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data_handle(),
+                                    sizeof(T) * dim,
+                                    dataset,
+                                    sizeof(T) * stride * train_step,
+                                    sizeof(T) * dim,
+                                    n_train,
+                                    cudaMemcpyDefault,
+                                    stream));
+    raft::cluster::kmeans_balanced::fit(res,
+                                        kmeans_params,
+                                        raft::make_const_mdspan(trainset.view()),
+                                        centers.view(),
+                                        raft::spatial::knn::detail::utils::mapping<float>{});
+
+    // Label all the rows, in batches reusing the training buffer
+    auto labels = raft::make_device_vector<uint32_t, int64_t>(res, size);
+    for (int64_t offset = 0; offset < size; offset += n_train) {
+      const int64_t n_rows = std::min<int64_t>(n_train, size - offset);
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data_handle(),
+                                      sizeof(T) * dim,
+                                      dataset + offset * stride,
+                                      sizeof(T) * stride,
+                                      sizeof(T) * dim,
+                                      n_rows,
+                                      cudaMemcpyDefault,
+                                      stream));
+      raft::cluster::kmeans_balanced::predict(
+        res,
+        kmeans_params,
+        raft::make_device_matrix_view<const T, int64_t>(trainset.data_handle(), n_rows, dim),
+        raft::make_const_mdspan(centers.view()),
+        raft::make_device_vector_view<uint32_t, int64_t>(labels.data_handle() + offset, n_rows),
+        raft::spatial::knn::detail::utils::mapping<float>{});
+    }
+    thrust::stable_sort_by_key(policy,
+                               labels.data_handle(),
+                               labels.data_handle() + size,
+                               new_to_old.data_handle());
+  }
+
+  auto old_to_new = raft::make_device_vector<IdxT, int64_t>(res, size);
+  thrust::scatter(policy,
+                  thrust::make_counting_iterator<IdxT>(0),
+                  thrust::make_counting_iterator<IdxT>(size),
+                  new_to_old.data_handle(),
+                  old_to_new.data_handle());
+
+  const uint32_t block_size = 256;
+  auto new_graph            = raft::make_device_matrix<IdxT, int64_t>(res, size, degree);
+  kern_relabel_graph<IdxT>
+    <<<raft::ceildiv<uint64_t>(static_cast<uint64_t>(size) * degree, block_size),
+       block_size,
+       0,
+       stream>>>(idx.graph().data_handle(),
+                 new_to_old.data_handle(),
+                 old_to_new.data_handle(),
+                 size,
+                 degree,
+                 new_graph.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  auto new_dataset = raft::make_device_matrix<T, int64_t>(res, size, stride);
+  RAFT_CUDA_TRY(
+    cudaMemsetAsync(new_dataset.data_handle(), 0, new_dataset.size() * sizeof(T), stream));
+  kern_gather_rows<T, IdxT>
+    <<<raft::ceildiv<uint64_t>(static_cast<uint64_t>(size) * dim, block_size),
+       block_size,
+       0,
+       stream>>>(
+      dataset, new_to_old.data_handle(), size, dim, stride, new_dataset.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  using out_mdarray_type          = decltype(new_dataset);
+  using out_layout_type           = typename out_mdarray_type::layout_type;
+  using out_container_policy_type = typename out_mdarray_type::container_policy_type;
+  using out_owning_type = owning_dataset<T, int64_t, out_layout_type, out_container_policy_type>;
+  auto out_layout       = make_strided_layout(raft::matrix_extent<int64_t>(size, dim),
+                                        std::array<int64_t, 2>{stride, 1});
+
+  idx.update_dataset(res, std::make_unique<out_owning_type>(std::move(new_dataset), out_layout));
+  idx.update_graph(res, std::move(new_graph));
+  resource::sync_stream(res);
+  return new_to_old;
+}
+
+}  // namespace raft::neighbors::cagra::detail
@@ -33,6 +33,7 @@ template <unsigned TEAM_SIZE,
 void select_and_run(
   DATASET_DESCRIPTOR_T dataset_desc,
   raft::device_matrix_view<const typename DATASET_DESCRIPTOR_T::INDEX_T, int64_t, row_major> graph,
+  uint32_t graph_id_bits,
   typename DATASET_DESCRIPTOR_T::INDEX_T* const topk_indices_ptr,
   typename DATASET_DESCRIPTOR_T::DISTANCE_T* const topk_distances_ptr,
   const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,
@@ -68,6 +69,7 @@ void select_and_run(
     raft::neighbors::cagra::detail::standard_dataset_descriptor_t<DATA_T, INDEX_T, DISTANCE_T>  \
       dataset_desc,                                                                             \
     raft::device_matrix_view<const INDEX_T, int64_t, row_major> graph,                          \
+    uint32_t graph_id_bits,                                                                     \
     INDEX_T* const topk_indices_ptr,                                                            \
     DISTANCE_T* const topk_distances_ptr,                                                       \
     const DATA_T* const queries_ptr,                                                            \
@@ -125,6 +127,39 @@ instantiate_kernel_selection(
 instantiate_kernel_selection(
   32, 512, uint8_t, uint32_t, float, raft::neighbors::filtering::none_cagra_sample_filter);
 
+instantiate_kernel_selection(
+  32, 1024, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  8, 128, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  16, 256, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  32, 512, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  32, 1024, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  8, 128, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  16, 256, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  32, 512, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  32, 1024, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  8, 128, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  16, 256, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  32, 512, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  32, 1024, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  8, 128, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  16, 256, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_kernel_selection(
+  32, 512, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+
 #undef instantiate_kernel_selection
 
 #define instantiate_q_kernel_selection(TEAM_SIZE,                                               \
@@ -153,6 +188,7 @@ instantiate_kernel_selection(
                                                                  DISTANCE_T,                    \
                                                                  INDEX_T> dataset_desc,         \
     raft::device_matrix_view<const INDEX_T, int64_t, row_major> graph,                          \
+    uint32_t graph_id_bits,                                                                     \
     INDEX_T* const topk_indices_ptr,                                                            \
     DISTANCE_T* const topk_distances_ptr,                                                       \
     const DATA_T* const queries_ptr,                                                            \
@@ -139,6 +139,7 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
   const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
   const typename DATASET_DESCRIPTOR_T::INDEX_T* const knn_graph,   // [dataset_size, graph_degree]
   const uint32_t graph_degree,
+  const uint32_t graph_id_bits,  // 0 for the dense graph
   const unsigned num_distilation,
   const uint64_t rand_xor_mask,
   const typename DATASET_DESCRIPTOR_T::INDEX_T* seed_ptr,  // [num_queries, num_seeds]
@@ -283,6 +284,7 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
       dataset_desc,
       knn_graph,
       graph_degree,
+      graph_id_bits,
       local_visited_hashmap_ptr,
       hash_bitlen,
       parent_indices_buffer,
@@ -446,6 +448,7 @@ template <unsigned TEAM_SIZE,
 void select_and_run(
   DATASET_DESCRIPTOR_T dataset_desc,
   raft::device_matrix_view<const typename DATASET_DESCRIPTOR_T::INDEX_T, int64_t, row_major> graph,
+  uint32_t graph_id_bits,
   typename DATASET_DESCRIPTOR_T::INDEX_T* const topk_indices_ptr,       // [num_queries, topk]
   typename DATASET_DESCRIPTOR_T::DISTANCE_T* const topk_distances_ptr,  // [num_queries, topk]
   const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
@@ -501,6 +504,7 @@ void select_and_run(
                                                        queries_ptr,
                                                        graph.data_handle(),
                                                        graph.extent(1),
+                                                       graph_id_bits,
                                                        num_random_samplings,
                                                        rand_xor_mask,
                                                        dev_seed_ptr,
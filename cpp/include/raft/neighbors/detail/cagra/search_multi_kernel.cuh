@@ -87,10 +87,40 @@ void get_value(T* const host_ptr, const T* const dev_ptr, cudaStream_t cuda_stre
   get_value_kernel<T><<<1, 1, 0, cuda_stream>>>(host_ptr, dev_ptr);
 }
 
+/**
+ * Copy the query to the beginning of the shared memory `smem`, followed by the working buffer of
+ * the distance calculation (e.g. the PQ code book of a VPQ dataset).
+ */
+template <unsigned DATASET_BLOCK_DIM, class DATASET_DESCRIPTOR_T>
+_RAFT_DEVICE void load_query_and_smem_buffer(
+  DATASET_DESCRIPTOR_T& dataset_desc,
+  const typename DATASET_DESCRIPTOR_T::DATA_T* const query_ptr,  // [dataset_dim]
+  std::uint8_t* const smem)
+{
+  using QUERY_T = typename DATASET_DESCRIPTOR_T::QUERY_T;
+  const auto query_smem_buffer_length =
+    raft::ceildiv<uint32_t>(dataset_desc.dim, DATASET_BLOCK_DIM) * DATASET_BLOCK_DIM;
+  auto* const query_buffer = reinterpret_cast<QUERY_T*>(smem);
+  dataset_desc.set_smem_ptr(query_buffer + query_smem_buffer_length);
+  dataset_desc.template copy_query<DATASET_BLOCK_DIM>(
+    query_ptr, query_buffer, query_smem_buffer_length);
+  __syncthreads();
+}
+
+/** The size of the shared memory needed by `load_query_and_smem_buffer`. */
+template <unsigned DATASET_BLOCK_DIM, class DATASET_DESCRIPTOR_T>
+auto get_query_and_smem_buffer_size(const DATASET_DESCRIPTOR_T& dataset_desc) -> std::size_t
+{
+  const auto query_smem_buffer_length =
+    raft::ceildiv<uint32_t>(dataset_desc.dim, DATASET_BLOCK_DIM) * DATASET_BLOCK_DIM;
+  return query_smem_buffer_length * sizeof(typename DATASET_DESCRIPTOR_T::QUERY_T) +
+         DATASET_DESCRIPTOR_T::smem_buffer_size_in_byte;
+}
+
 // MAX_DATASET_DIM : must equal to or greater than dataset_dim
 template <unsigned TEAM_SIZE, unsigned DATASET_BLOCK_DIM, class DATASET_DESCRIPTOR_T>
 RAFT_KERNEL random_pickup_kernel(
-  const DATASET_DESCRIPTOR_T dataset_desc,
+  DATASET_DESCRIPTOR_T dataset_desc,
   const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
   const std::size_t num_pickup,
   const unsigned num_distilation,
@@ -107,25 +137,17 @@ RAFT_KERNEL random_pickup_kernel(
   using DATA_T     = typename DATASET_DESCRIPTOR_T::DATA_T;
   using INDEX_T    = typename DATASET_DESCRIPTOR_T::INDEX_T;
   using DISTANCE_T = typename DATASET_DESCRIPTOR_T::DISTANCE_T;
+  using QUERY_T    = typename DATASET_DESCRIPTOR_T::QUERY_T;
 
   const auto ldb               = hashmap::get_size(hash_bitlen);
   const auto global_team_index = (blockIdx.x * blockDim.x + threadIdx.x) / TEAM_SIZE;
   const uint32_t query_id      = blockIdx.y;
+  // Load a query and the working buffer of the distance calculation with the whole block
+  extern __shared__ std::uint8_t smem[];
+  load_query_and_smem_buffer<DATASET_BLOCK_DIM>(
+    dataset_desc, queries_ptr + query_id * dataset_desc.dim, smem);
+  const auto* const query_buffer = reinterpret_cast<const QUERY_T*>(smem);
   if (global_team_index >= num_pickup) { return; }
-  // Load a query
-  extern __shared__ float query_buffer[];
-  const auto query_smem_buffer_length =
-    raft::ceildiv<uint32_t>(dataset_desc.dim, DATASET_BLOCK_DIM) * DATASET_BLOCK_DIM;
-  for (uint32_t i = threadIdx.x; i < query_smem_buffer_length; i += blockDim.x) {
-    unsigned j = device::swizzling(i);
-    if (i < dataset_desc.dim) {
-      query_buffer[j] = spatial::knn::detail::utils::mapping<float>{}(
-        (queries_ptr + query_id * dataset_desc.dim)[i]);
-    } else {
-      query_buffer[j] = 0.0;
-    }
-  }
-  __syncthreads();
 
   INDEX_T best_index_team_local;
   DISTANCE_T best_norm2_team_local = utils::get_max_value<DISTANCE_T>();
@@ -199,9 +221,7 @@ void random_pickup(
   const dim3 grid_size((num_pickup + num_teams_per_threadblock - 1) / num_teams_per_threadblock,
                        num_queries);
 
-  const auto query_smem_buffer_length =
-    raft::ceildiv<uint32_t>(dataset_desc.dim, DATASET_BLOCK_DIM) * DATASET_BLOCK_DIM;
-  const auto smem_size = query_smem_buffer_length * sizeof(float);
+  const auto smem_size = get_query_and_smem_buffer_size<DATASET_BLOCK_DIM>(dataset_desc);
 
   random_pickup_kernel<TEAM_SIZE, DATASET_BLOCK_DIM, DATASET_DESCRIPTOR_T>
     <<<grid_size, block_size, smem_size, cuda_stream>>>(dataset_desc,
@@ -332,10 +352,11 @@ RAFT_KERNEL compute_distance_to_child_nodes_kernel(
     parent_distance_ptr,  // [num_queries, search_width]
   const std::size_t lds,
   const std::uint32_t search_width,
-  const DATASET_DESCRIPTOR_T dataset_desc,
+  DATASET_DESCRIPTOR_T dataset_desc,
   const typename DATASET_DESCRIPTOR_T::INDEX_T* const
     neighbor_graph_ptr,  // [dataset_size, graph_degree]
   const std::uint32_t graph_degree,
+  const std::uint32_t graph_id_bits,  // 0 for the dense graph
   const typename DATASET_DESCRIPTOR_T::DATA_T* query_ptr,  // [num_queries, data_dim]
   typename DATASET_DESCRIPTOR_T::INDEX_T* const
     visited_hashmap_ptr,  // [num_queries, 1 << hash_bitlen]
@@ -348,31 +369,28 @@ RAFT_KERNEL compute_distance_to_child_nodes_kernel(
 {
   using INDEX_T    = typename DATASET_DESCRIPTOR_T::INDEX_T;
   using DISTANCE_T = typename DATASET_DESCRIPTOR_T::DISTANCE_T;
+  using QUERY_T    = typename DATASET_DESCRIPTOR_T::QUERY_T;
 
   const uint32_t ldb        = hashmap::get_size(hash_bitlen);
   const auto tid            = threadIdx.x + blockDim.x * blockIdx.x;
   const auto global_team_id = tid / TEAM_SIZE;
   const auto query_id       = blockIdx.y;
 
-  extern __shared__ float query_buffer[];
-  const auto query_smem_buffer_length =
-    raft::ceildiv<uint32_t>(dataset_desc.dim, DATASET_BLOCK_DIM) * DATASET_BLOCK_DIM;
-  for (uint32_t i = threadIdx.x; i < query_smem_buffer_length; i += blockDim.x) {
-    unsigned j = device::swizzling(i);
-    if (i < dataset_desc.dim) {
-      query_buffer[j] =
-        spatial::knn::detail::utils::mapping<float>{}((query_ptr + query_id * dataset_desc.dim)[i]);
-    } else {
-      query_buffer[j] = 0.0;
-    }
-  }
-  __syncthreads();
+  extern __shared__ std::uint8_t smem[];
+  load_query_and_smem_buffer<DATASET_BLOCK_DIM>(
+    dataset_desc, query_ptr + query_id * dataset_desc.dim, smem);
+  const auto* const query_buffer = reinterpret_cast<const QUERY_T*>(smem);
   if (global_team_id >= search_width * graph_degree) { return; }
 
   const std::size_t parent_list_index =
     parent_node_list[global_team_id / graph_degree + (search_width * blockIdx.y)];
 
-  if (parent_list_index == utils::get_max_value<INDEX_T>()) { return; }
+  if (parent_list_index == utils::get_max_value<INDEX_T>()) {
+    // No parent in this slot: invalidate the candidate so that the stale entry from the previous
+    // iteration is not merged again into the internal top-k.
+    result_distances_ptr[ldd * blockIdx.y + global_team_id] = utils::get_max_value<DISTANCE_T>();
+    return;
+  }
 
   constexpr INDEX_T index_msb_1_mask = utils::gen_index_msb_1_mask<INDEX_T>::value;
   const auto raw_parent_index        = parent_candidates_ptr[parent_list_index + (lds * query_id)];
@@ -383,9 +401,8 @@ RAFT_KERNEL compute_distance_to_child_nodes_kernel(
   }
   const auto parent_index = raw_parent_index & ~index_msb_1_mask;
 
-  const auto neighbor_list_head_ptr = neighbor_graph_ptr + (graph_degree * parent_index);
-
-  const std::size_t child_id = neighbor_list_head_ptr[global_team_id % graph_degree];
+  const std::size_t child_id = device::load_graph_edge(
+    neighbor_graph_ptr, graph_degree, graph_id_bits, parent_index, global_team_id % graph_degree);
 
   const auto compute_distance_flag = hashmap::insert<TEAM_SIZE, INDEX_T>(
     visited_hashmap_ptr + (ldb * blockIdx.y), hash_bitlen, child_id);
@@ -445,6 +462,7 @@ void compute_distance_to_child_nodes(
   const typename DATASET_DESCRIPTOR_T::INDEX_T* const
     neighbor_graph_ptr,  // [dataset_size, graph_degree]
   const std::uint32_t graph_degree,
+  const std::uint32_t graph_id_bits,  // 0 for the dense graph
   const typename DATASET_DESCRIPTOR_T::DATA_T* query_ptr,  // [num_queries, data_dim]
   const std::uint32_t num_queries,
   typename DATASET_DESCRIPTOR_T::INDEX_T* const
@@ -462,11 +480,7 @@ void compute_distance_to_child_nodes(
     (search_width * graph_degree + (block_size / TEAM_SIZE) - 1) / (block_size / TEAM_SIZE),
     num_queries);
 
-  const auto query_smem_buffer_length =
-    raft::ceildiv<uint32_t>(dataset_desc.dim, DATASET_BLOCK_DIM) * DATASET_BLOCK_DIM;
-
-  const auto smem_size =
-    query_smem_buffer_length * sizeof(float) + DATASET_DESCRIPTOR_T::smem_buffer_size_in_byte;
+  const auto smem_size = get_query_and_smem_buffer_size<DATASET_BLOCK_DIM>(dataset_desc);
 
   compute_distance_to_child_nodes_kernel<TEAM_SIZE,
                                          DATASET_BLOCK_DIM,
@@ -480,6 +494,7 @@ void compute_distance_to_child_nodes(
                                                         dataset_desc,
                                                         neighbor_graph_ptr,
                                                         graph_degree,
+                                                        graph_id_bits,
                                                         query_ptr,
                                                         visited_hashmap_ptr,
                                                         hash_bitlen,
@@ -734,6 +749,15 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
     topk_workspace.resize(topk_workspace_size, resource::get_cuda_stream(res));
 
     hashmap.resize(hashmap_size, resource::get_cuda_stream(res));
+
+    // The staging buffers of the large top-k selection are sized for the largest batch here, so
+    // that the search itself does not allocate memory (e.g. when it is captured in a CUDA graph).
+    if (itopk_size > 1024) {
+      input_keys_storage.resize(max_queries * result_buffer_size, resource::get_cuda_stream(res));
+      input_values_storage.resize(max_queries * result_buffer_size, resource::get_cuda_stream(res));
+      output_keys_storage.resize(max_queries * itopk_size, resource::get_cuda_stream(res));
+      output_values_storage.resize(max_queries * itopk_size, resource::get_cuda_stream(res));
+    }
   }
 
   ~search() {}
@@ -784,7 +808,7 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
     }
 
     if (ldIK > numElements) {
-      if (input_keys_storage.size() != sizeBatch * numElements) {
+      if (input_keys_storage.size() < sizeBatch * numElements) {
         input_keys_storage.resize(sizeBatch * numElements, stream);
       }
       batched_memcpy(
@@ -793,7 +817,7 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
     }
 
     if (ldIV > numElements) {
-      if (input_values_storage.size() != sizeBatch * numElements) {
+      if (input_values_storage.size() < sizeBatch * numElements) {
         input_values_storage.resize(sizeBatch * numElements, stream);
       }
 
@@ -802,11 +826,11 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
       inputVals = input_values_storage.data();
     }
 
-    if ((ldOK > topK) && (output_keys_storage.size() != sizeBatch * topK)) {
+    if ((ldOK > topK) && (output_keys_storage.size() < sizeBatch * topK)) {
       output_keys_storage.resize(sizeBatch * topK, stream);
     }
 
-    if ((ldOV > topK) && (output_values_storage.size() != sizeBatch * topK)) {
+    if ((ldOV > topK) && (output_values_storage.size() < sizeBatch * topK)) {
       output_values_storage.resize(sizeBatch * topK, stream);
     }
 
@@ -833,6 +857,7 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
   void operator()(raft::resources const& res,
                   DATASET_DESCRIPTOR_T dataset_desc,
                   raft::device_matrix_view<const INDEX_T, int64_t, row_major> graph,
+                  uint32_t graph_id_bits,
                   INDEX_T* const topk_indices_ptr,       // [num_queries, topk]
                   DISTANCE_T* const topk_distances_ptr,  // [num_queries, topk]
                   const DATA_T* const queries_ptr,       // [num_queries, dataset_dim]
@@ -875,6 +900,13 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
                                                 this->metric,
                                                 stream);
 
+    // The early termination reads the flag on the host, which is not possible while the stream is
+    // captured in a CUDA graph. A captured search runs all max_iterations instead; the iterations
+    // past the convergence find no new parents and leave the results unchanged.
+    cudaStreamCaptureStatus capture_status = cudaStreamCaptureStatusNone;
+    RAFT_CUDA_TRY(cudaStreamIsCapturing(stream, &capture_status));
+    const bool early_termination = capture_status == cudaStreamCaptureStatusNone;
+
     unsigned iter = 0;
     while (1) {
       // Make an index list of internal top-k nodes
@@ -919,7 +951,7 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
                           stream);
 
       // termination (2)
-      if (iter + 1 >= min_iterations && terminate_flag.value(stream)) {
+      if (early_termination && iter + 1 >= min_iterations && terminate_flag.value(stream)) {
         iter++;
         break;
       }
@@ -934,6 +966,7 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
         dataset_desc,
         graph.data_handle(),
         graph.extent(1),
+        graph_id_bits,
         queries_ptr,
         num_queries,
         hashmap.data(),
@@ -1019,70 +1052,5 @@ struct search : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T> {
   }
 };
 
-template <unsigned TEAM_SIZE,
-          unsigned DATASET_BLOCK_DIM,
-          class CODE_BOOK_T,
-          unsigned PQ_BITS,
-          unsigned PQ_CODE_BOOK_DIM,
-          class DATA_T,
-          class DISTANCE_T_,
-          class INDEX_T_,
-          typename SAMPLE_FILTER_T>
-struct search<TEAM_SIZE,
-              DATASET_BLOCK_DIM,
-              cagra_q_dataset_descriptor_t<DATA_T,
-                                           CODE_BOOK_T,
-                                           PQ_BITS,
-                                           PQ_CODE_BOOK_DIM,
-                                           DISTANCE_T_,
-                                           INDEX_T_>,
-              SAMPLE_FILTER_T>
-  : public search_plan_impl<cagra_q_dataset_descriptor_t<DATA_T,
-                                                         CODE_BOOK_T,
-                                                         PQ_BITS,
-                                                         PQ_CODE_BOOK_DIM,
-
-                                                         DISTANCE_T_,
-                                                         INDEX_T_>,
-                            SAMPLE_FILTER_T> {
-  using DATASET_DESCRIPTOR_T = cagra_q_dataset_descriptor_t<DATA_T,
-                                                            CODE_BOOK_T,
-                                                            PQ_BITS,
-                                                            PQ_CODE_BOOK_DIM,
-
-                                                            DISTANCE_T_,
-                                                            INDEX_T_>;
-  using INDEX_T              = typename DATASET_DESCRIPTOR_T::INDEX_T;
-  using DISTANCE_T           = typename DATASET_DESCRIPTOR_T::DISTANCE_T;
-
-  search(raft::resources const& res,
-         search_params params,
-         int64_t dim,
-         int64_t graph_degree,
-         uint32_t topk,
-         raft::distance::DistanceType metric)
-    : search_plan_impl<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T>(
-        res, params, dim, graph_degree, topk, metric)
-  {
-    THROW("The multi-kernel mode does not support VPQ");
-  }
-
-  void set_params(raft::resources const& res) {}
-
-  void operator()(raft::resources const& res,
-                  DATASET_DESCRIPTOR_T dataset_desc,
-                  raft::device_matrix_view<const INDEX_T, int64_t, row_major> graph,
-                  INDEX_T* const topk_indices_ptr,       // [num_queries, topk]
-                  DISTANCE_T* const topk_distances_ptr,  // [num_queries, topk]
-                  const DATA_T* const queries_ptr,       // [num_queries, dataset_dim]
-                  const uint32_t num_queries,
-                  const INDEX_T* dev_seed_ptr,              // [num_queries, num_seeds]
-                  uint32_t* const num_executed_iterations,  // [num_queries,]
-                  uint32_t topk,
-                  SAMPLE_FILTER_T sample_filter)
-  {
-  }
-};
-
 }  // namespace multi_kernel_search
 }  // namespace raft::neighbors::cagra::detail
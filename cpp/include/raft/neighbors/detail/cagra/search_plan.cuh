@@ -37,14 +37,26 @@ struct search_plan_impl_base : public search_params {
   int64_t graph_degree;
   uint32_t topk;
   raft::distance::DistanceType metric;
+  // The parameters as given by the user, before any adjustments (the key of a cached plan).
+  search_params requested_params;
   search_plan_impl_base(search_params params,
                         int64_t dim,
                         int64_t graph_degree,
                         uint32_t topk,
                         raft::distance::DistanceType metric)
-    : search_params(params), dim(dim), graph_degree(graph_degree), topk(topk), metric(metric)
+    : search_params(params),
+      dim(dim),
+      graph_degree(graph_degree),
+      topk(topk),
+      metric(metric),
+      requested_params(params)
   {
     set_dataset_block_and_team_size(dim);
+    if (persistent) {
+      if (algo == search_algo::AUTO) { algo = search_algo::SINGLE_CTA; }
+      RAFT_EXPECTS(algo == search_algo::SINGLE_CTA,
+                   "The persistent search mode is only implemented for the single-cta algorithm");
+    }
     if (algo == search_algo::AUTO) {
       const size_t num_sm = raft::getMultiProcessorCount();
       if (itopk_size <= 512 && search_params::max_queries >= num_sm * 2lu) {
@@ -60,6 +72,28 @@ struct search_plan_impl_base : public search_params {
     }
   }
 
+  /** Whether the plan can be reused for a search with the given configuration. */
+  [[nodiscard]] auto matches(const search_params& params,
+                             int64_t dim,
+                             int64_t graph_degree,
+                             uint32_t topk,
+                             raft::distance::DistanceType metric) const -> bool
+  {
+    const auto& p = requested_params;
+    return this->dim == dim && this->graph_degree == graph_degree && this->topk == topk &&
+           this->metric == metric && p.max_queries == params.max_queries &&
+           p.itopk_size == params.itopk_size && p.max_iterations == params.max_iterations &&
+           p.algo == params.algo && p.team_size == params.team_size &&
+           p.search_width == params.search_width && p.min_iterations == params.min_iterations &&
+           p.thread_block_size == params.thread_block_size &&
+           p.hashmap_mode == params.hashmap_mode &&
+           p.hashmap_min_bitlen == params.hashmap_min_bitlen &&
+           p.hashmap_max_fill_rate == params.hashmap_max_fill_rate &&
+           p.num_random_samplings == params.num_random_samplings &&
+           p.rand_xor_mask == params.rand_xor_mask && p.persistent == params.persistent &&
+           p.persistent_lifetime == params.persistent_lifetime;
+  }
+
   void set_dataset_block_and_team_size(int64_t dim)
   {
     constexpr int64_t max_dataset_block_dim = 512;
@@ -124,6 +158,7 @@ struct search_plan_impl : public search_plan_impl_base {
   virtual void operator()(raft::resources const& res,
                           DATASET_DESCRIPTOR_T dataset_desc,
                           raft::device_matrix_view<const INDEX_T, int64_t, row_major> graph,
+                          uint32_t graph_id_bits,
                           INDEX_T* const result_indices_ptr,       // [num_queries, topk]
                           DISTANCE_T* const result_distances_ptr,  // [num_queries, topk]
                           const DATA_T* const queries_ptr,         // [num_queries, dataset_dim]
@@ -32,6 +32,7 @@ template <unsigned TEAM_SIZE,
 void select_and_run(  // raft::resources const& res,
   DATASET_DESCRIPTOR_T dataset_desc,
   raft::device_matrix_view<const typename DATASET_DESCRIPTOR_T::INDEX_T, int64_t, row_major> graph,
+  uint32_t graph_id_bits,
   typename DATASET_DESCRIPTOR_T::INDEX_T* const topk_indices_ptr,       // [num_queries, topk]
   typename DATASET_DESCRIPTOR_T::DISTANCE_T* const topk_distances_ptr,  // [num_queries, topk]
   const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
@@ -55,6 +56,8 @@ void select_and_run(  // raft::resources const& res,
   size_t max_iterations,
   SAMPLE_FILTER_T sample_filter,
   raft::distance::DistanceType metric,
+  bool persistent,
+  float persistent_lifetime,
   cudaStream_t stream) RAFT_EXPLICIT;
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -69,6 +72,7 @@ void select_and_run(  // raft::resources const& res,
     raft::neighbors::cagra::detail::standard_dataset_descriptor_t<DATA_T, INDEX_T, DISTANCE_T>  \
       dataset,                                                                                  \
     raft::device_matrix_view<const INDEX_T, int64_t, row_major> graph,                          \
+    uint32_t graph_id_bits,                                                                     \
     INDEX_T* const topk_indices_ptr,                                                            \
     DISTANCE_T* const topk_distances_ptr,                                                       \
     const DATA_T* const queries_ptr,                                                            \
@@ -92,6 +96,8 @@ void select_and_run(  // raft::resources const& res,
     size_t max_iterations,                                                                      \
     SAMPLE_FILTER_T sample_filter,                                                              \
     raft::distance::DistanceType metric,                                                        \
+    bool persistent,                                                                            \
+    float persistent_lifetime,                                                                  \
     cudaStream_t stream);
 
 instantiate_single_cta_select_and_run(
@@ -127,6 +133,39 @@ instantiate_single_cta_select_and_run(
 instantiate_single_cta_select_and_run(
   32, 512, uint8_t, uint32_t, float, raft::neighbors::filtering::none_cagra_sample_filter);
 
+instantiate_single_cta_select_and_run(
+  32, 1024, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  8, 128, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  16, 256, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  32, 512, float, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  32, 1024, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  8, 128, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  16, 256, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  32, 512, half, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  32, 1024, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  8, 128, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  16, 256, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  32, 512, int8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  32, 1024, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  8, 128, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  16, 256, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+instantiate_single_cta_select_and_run(
+  32, 512, uint8_t, uint32_t, float, raft::neighbors::filtering::removed_cagra_sample_filter);
+
 #undef instantiate_single_cta_select_and_run
 
 #define instantiate_q_single_cta_select_and_run(TEAM_SIZE,                                      \
@@ -155,6 +194,7 @@ instantiate_single_cta_select_and_run(
                                                                  DISTANCE_T,                    \
                                                                  INDEX_T> dataset,              \
     raft::device_matrix_view<const INDEX_T, int64_t, row_major> graph,                          \
+    uint32_t graph_id_bits,                                                                     \
     INDEX_T* const topk_indices_ptr,                                                            \
     DISTANCE_T* const topk_distances_ptr,                                                       \
     const DATA_T* const queries_ptr,                                                            \
@@ -178,6 +218,8 @@ instantiate_single_cta_select_and_run(
     size_t max_iterations,                                                                      \
     SAMPLE_FILTER_T sample_filter,                                                              \
     raft::distance::DistanceType metric,                                                        \
+    bool persistent,                                                                            \
+    float persistent_lifetime,                                                                  \
     cudaStream_t stream);
 
 instantiate_q_single_cta_select_and_run(
@@ -25,8 +25,11 @@
 #include "utils.hpp"
 
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/device_setter.hpp>
 #include <raft/core/logger.hpp>
+#include <raft/core/pinned_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_id.hpp>
 #include <raft/core/resource/device_properties.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
@@ -35,15 +38,27 @@
 #include <raft/util/cuda_rt_essentials.hpp>
 #include <raft/util/cudart_utils.hpp>  // RAFT_CUDA_TRY_NOT_THROW is used TODO(tfeher): consider moving this to cuda_rt_essentials.hpp
 
+#include <rmm/cuda_stream_view.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <cuda/atomic>
+
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace raft::neighbors::cagra::detail {
@@ -449,7 +464,7 @@ __device__ inline void hashmap_restore(INDEX_T* const hashmap_ptr,
   }
 }
 
-// One query one thread block
+// Search of a single query by the whole thread block
 template <uint32_t TEAM_SIZE,
           uint32_t DATASET_BLOCK_DIM,
           unsigned MAX_ITOPK,
@@ -457,7 +472,7 @@ template <uint32_t TEAM_SIZE,
           unsigned TOPK_BY_BITONIC_SORT,
           class DATASET_DESCRIPTOR_T,
           class SAMPLE_FILTER_T>
-__launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
+__device__ void search_core(
   typename DATASET_DESCRIPTOR_T::INDEX_T* const result_indices_ptr,       // [num_queries, top_k]
   typename DATASET_DESCRIPTOR_T::DISTANCE_T* const result_distances_ptr,  // [num_queries, top_k]
   const std::uint32_t top_k,
@@ -465,12 +480,13 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
   const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
   const typename DATASET_DESCRIPTOR_T::INDEX_T* const knn_graph,   // [dataset_size, graph_degree]
   const std::uint32_t graph_degree,
+  const std::uint32_t graph_id_bits,  // 0 for the dense graph
   const unsigned num_distilation,
   const uint64_t rand_xor_mask,
   const typename DATASET_DESCRIPTOR_T::INDEX_T* seed_ptr,  // [num_queries, num_seeds]
   const uint32_t num_seeds,
   typename DATASET_DESCRIPTOR_T::INDEX_T* const
-    visited_hashmap_ptr,  // [num_queries, 1 << hash_bitlen]
+    visited_hashmap_ptr,  // [1 << hash_bitlen]; the table of this thread block
   const std::uint32_t internal_topk,
   const std::uint32_t search_width,
   const std::uint32_t min_iteration,
@@ -480,7 +496,8 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
   const std::uint32_t small_hash_bitlen,
   const std::uint32_t small_hash_reset_interval,
   SAMPLE_FILTER_T sample_filter,
-  raft::distance::DistanceType metric)
+  raft::distance::DistanceType metric,
+  const std::uint32_t query_id)
 {
   using LOAD_T = device::LOAD_128BIT_T;
 
@@ -489,8 +506,6 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
   using DISTANCE_T = typename DATASET_DESCRIPTOR_T::DISTANCE_T;
   using QUERY_T    = typename DATASET_DESCRIPTOR_T::QUERY_T;
 
-  const auto query_id = blockIdx.y;
-
 #ifdef _CLK_BREAKDOWN
   std::uint64_t clk_init                 = 0;
   std::uint64_t clk_compute_1st_distance = 0;
@@ -557,7 +572,7 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
   if (small_hash_bitlen) {
     local_visited_hashmap_ptr = visited_hash_buffer;
   } else {
-    local_visited_hashmap_ptr = visited_hashmap_ptr + (hashmap::get_size(hash_bitlen) * query_id);
+    local_visited_hashmap_ptr = visited_hashmap_ptr;
   }
   hashmap::init(local_visited_hashmap_ptr, hash_bitlen, 0);
   __syncthreads();
@@ -710,6 +725,7 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
       dataset_desc,
       knn_graph,
       graph_degree,
+      graph_id_bits,
       local_visited_hashmap_ptr,
       hash_bitlen,
       parent_list_buffer,
@@ -811,54 +827,256 @@ __launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
 #endif
 }
 
+// One query one thread block
 template <uint32_t TEAM_SIZE,
+          uint32_t DATASET_BLOCK_DIM,
+          unsigned MAX_ITOPK,
+          unsigned MAX_CANDIDATES,
+          unsigned TOPK_BY_BITONIC_SORT,
+          class DATASET_DESCRIPTOR_T,
+          class SAMPLE_FILTER_T>
+__launch_bounds__(1024, 1) RAFT_KERNEL search_kernel(
+  typename DATASET_DESCRIPTOR_T::INDEX_T* const result_indices_ptr,       // [num_queries, top_k]
+  typename DATASET_DESCRIPTOR_T::DISTANCE_T* const result_distances_ptr,  // [num_queries, top_k]
+  const std::uint32_t top_k,
+  DATASET_DESCRIPTOR_T dataset_desc,
+  const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
+  const typename DATASET_DESCRIPTOR_T::INDEX_T* const knn_graph,   // [dataset_size, graph_degree]
+  const std::uint32_t graph_degree,
+  const std::uint32_t graph_id_bits,  // 0 for the dense graph
+  const unsigned num_distilation,
+  const uint64_t rand_xor_mask,
+  const typename DATASET_DESCRIPTOR_T::INDEX_T* seed_ptr,  // [num_queries, num_seeds]
+  const uint32_t num_seeds,
+  typename DATASET_DESCRIPTOR_T::INDEX_T* const
+    visited_hashmap_ptr,  // [num_queries, 1 << hash_bitlen]
+  const std::uint32_t internal_topk,
+  const std::uint32_t search_width,
+  const std::uint32_t min_iteration,
+  const std::uint32_t max_iteration,
+  std::uint32_t* const num_executed_iterations,  // [num_queries]
+  const std::uint32_t hash_bitlen,
+  const std::uint32_t small_hash_bitlen,
+  const std::uint32_t small_hash_reset_interval,
+  SAMPLE_FILTER_T sample_filter,
+  raft::distance::DistanceType metric)
+{
+  const auto query_id = blockIdx.y;
+  search_core<TEAM_SIZE,
+              DATASET_BLOCK_DIM,
+              MAX_ITOPK,
+              MAX_CANDIDATES,
+              TOPK_BY_BITONIC_SORT,
+              DATASET_DESCRIPTOR_T,
+              SAMPLE_FILTER_T>(
+    result_indices_ptr,
+    result_distances_ptr,
+    top_k,
+    dataset_desc,
+    queries_ptr,
+    knn_graph,
+    graph_degree,
+    graph_id_bits,
+    num_distilation,
+    rand_xor_mask,
+    seed_ptr,
+    num_seeds,
+    visited_hashmap_ptr + hashmap::get_size(hash_bitlen) * static_cast<uint64_t>(query_id),
+    internal_topk,
+    search_width,
+    min_iteration,
+    max_iteration,
+    num_executed_iterations,
+    hash_bitlen,
+    small_hash_bitlen,
+    small_hash_reset_interval,
+    sample_filter,
+    metric,
+    query_id);
+}
+
+/**
+ * All the arguments of a single query search submitted to the persistent kernel.
+ *
+ * The dataset descriptor and the filter are kept as raw bytes, because they are not
+ * default-constructible; both are trivially copyable.
+ */
+template <class DATASET_DESCRIPTOR_T, class SAMPLE_FILTER_T>
+struct persistent_job_t {
+  using DATA_T     = typename DATASET_DESCRIPTOR_T::DATA_T;
+  using INDEX_T    = typename DATASET_DESCRIPTOR_T::INDEX_T;
+  using DISTANCE_T = typename DATASET_DESCRIPTOR_T::DISTANCE_T;
+
+  INDEX_T* result_indices_ptr;             // [num_queries, top_k]
+  DISTANCE_T* result_distances_ptr;        // [num_queries, top_k]
+  const DATA_T* queries_ptr;               // [num_queries, dataset_dim]
+  const INDEX_T* knn_graph;                // [dataset_size, graph_degree]
+  const INDEX_T* seed_ptr;                 // [num_queries, num_seeds]
+  std::uint32_t* num_executed_iterations;  // [num_queries]
+  uint64_t rand_xor_mask;
+  std::uint32_t query_id;
+  std::uint32_t top_k;
+  std::uint32_t graph_degree;
+  std::uint32_t graph_id_bits;
+  std::uint32_t num_distilation;
+  std::uint32_t num_seeds;
+  std::uint32_t internal_topk;
+  std::uint32_t search_width;
+  std::uint32_t min_iteration;
+  std::uint32_t max_iteration;
+  std::uint32_t hash_bitlen;
+  std::uint32_t small_hash_bitlen;
+  std::uint32_t small_hash_reset_interval;
+  raft::distance::DistanceType metric;
+  alignas(DATASET_DESCRIPTOR_T) std::uint8_t dataset_desc[sizeof(DATASET_DESCRIPTOR_T)];
+  alignas(SAMPLE_FILTER_T) std::uint8_t sample_filter[sizeof(SAMPLE_FILTER_T)];
+};
+
+/**
+ * A slot of the job queue of the persistent kernel, located in the pinned host memory.
+ *
+ * The jobs are numbered by tickets; the ticket `t` is served by the slot `t % n_slots`:
+ *   1. the host waits until `free_ticket == t`, writes the job and publishes `ticket = t`;
+ *   2. the worker (thread block) holding the ticket `t` waits for `ticket == t`, runs the search
+ *      and publishes `done_ticket = t`;
+ *   3. the host waits for `done_ticket == t` and releases the slot: `free_ticket = t + n_slots`.
+ */
+template <class JOB_T>
+struct alignas(128) persistent_job_slot_t {
+  JOB_T job;
+  uint64_t ticket;
+  uint64_t done_ticket;
+  uint64_t free_ticket;
+};
+
+// Persistent version of the search kernel: every thread block keeps taking tickets and serves the
+// jobs of the corresponding slots until the stop flag is raised.
+template <uint32_t TEAM_SIZE,
+          uint32_t DATASET_BLOCK_DIM,
+          unsigned MAX_ITOPK,
+          unsigned MAX_CANDIDATES,
+          unsigned TOPK_BY_BITONIC_SORT,
+          class DATASET_DESCRIPTOR_T,
+          class SAMPLE_FILTER_T>
+__launch_bounds__(1024, 1) RAFT_KERNEL search_kernel_p(
+  persistent_job_slot_t<persistent_job_t<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T>>* const
+    slots,  // [n_slots]
+  const std::uint32_t n_slots,
+  unsigned long long int* const head,  // the next ticket to serve
+  std::uint32_t* const stop_flag,
+  typename DATASET_DESCRIPTOR_T::INDEX_T* const
+    visited_hashmap_ptr)  // [gridDim.x, 1 << hash_bitlen]
+{
+  using job_t      = persistent_job_t<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T>;
+  using ticket_ref = cuda::atomic_ref<uint64_t, cuda::thread_scope_system>;
+
+  __shared__ typename std::aligned_storage<sizeof(job_t), alignof(job_t)>::type job_storage;
+  __shared__ std::uint32_t worker_stop;
+  auto& job = *reinterpret_cast<job_t*>(&job_storage);
+
+  uint64_t ticket = 0;
+  while (true) {
+    if (threadIdx.x == 0) {
+      ticket      = atomicAdd(head, 1ull);
+      auto& slot  = slots[ticket % n_slots];
+      worker_stop = 0;
+      while (ticket_ref{slot.ticket}.load(cuda::memory_order_acquire) != ticket) {
+        if (cuda::atomic_ref<std::uint32_t, cuda::thread_scope_system>{*stop_flag}.load(
+              cuda::memory_order_relaxed)) {
+          worker_stop = 1;
+          break;
+        }
+#if __CUDA_ARCH__ >= 700
+        __nanosleep(100);
+#endif
+      }
+      if (!worker_stop) { job = slot.job; }
+    }
+    __syncthreads();
+    if (worker_stop) { return; }
+
+    search_core<TEAM_SIZE,
+                DATASET_BLOCK_DIM,
+                MAX_ITOPK,
+                MAX_CANDIDATES,
+                TOPK_BY_BITONIC_SORT,
+                DATASET_DESCRIPTOR_T,
+                SAMPLE_FILTER_T>(
+      job.result_indices_ptr,
+      job.result_distances_ptr,
+      job.top_k,
+      *reinterpret_cast<const DATASET_DESCRIPTOR_T*>(job.dataset_desc),
+      job.queries_ptr,
+      job.knn_graph,
+      job.graph_degree,
+      job.graph_id_bits,
+      job.num_distilation,
+      job.rand_xor_mask,
+      job.seed_ptr,
+      job.num_seeds,
+      visited_hashmap_ptr + hashmap::get_size(job.hash_bitlen) * static_cast<uint64_t>(blockIdx.x),
+      job.internal_topk,
+      job.search_width,
+      job.min_iteration,
+      job.max_iteration,
+      job.num_executed_iterations,
+      job.hash_bitlen,
+      job.small_hash_bitlen,
+      job.small_hash_reset_interval,
+      *reinterpret_cast<const SAMPLE_FILTER_T*>(job.sample_filter),
+      job.metric,
+      job.query_id);
+    __syncthreads();
+
+    if (threadIdx.x == 0) {
+      // Make the results visible to the host before reporting the job as done.
+      cuda::atomic_thread_fence(cuda::memory_order_release, cuda::thread_scope_system);
+      ticket_ref{slots[ticket % n_slots].done_ticket}.store(ticket, cuda::memory_order_relaxed);
+    }
+  }
+}
+
+template <bool PERSISTENT,
+          uint32_t TEAM_SIZE,
           uint32_t DATASET_BLOCK_DIM,
           typename DATASET_DESCRIPTOR_T,
           typename SAMPLE_FILTER_T>
 struct search_kernel_config {
-  using kernel_t = decltype(&search_kernel<TEAM_SIZE,
-                                           DATASET_BLOCK_DIM,
-                                           64,
-                                           64,
-                                           0,
-                                           DATASET_DESCRIPTOR_T,
-                                           SAMPLE_FILTER_T>);
-
-  template <unsigned MAX_CANDIDATES, unsigned USE_BITONIC_SORT>
-  static auto choose_search_kernel(unsigned itopk_size) -> kernel_t
+  template <unsigned MAX_ITOPK, unsigned MAX_CANDIDATES, unsigned TOPK_BY_BITONIC_SORT>
+  static auto get_kernel()
   {
-    if (itopk_size <= 64) {
+    if constexpr (PERSISTENT) {
+      return search_kernel_p<TEAM_SIZE,
+                             DATASET_BLOCK_DIM,
+                             MAX_ITOPK,
+                             MAX_CANDIDATES,
+                             TOPK_BY_BITONIC_SORT,
+                             DATASET_DESCRIPTOR_T,
+                             SAMPLE_FILTER_T>;
+    } else {
       return search_kernel<TEAM_SIZE,
                            DATASET_BLOCK_DIM,
-                           64,
+                           MAX_ITOPK,
                            MAX_CANDIDATES,
-                           USE_BITONIC_SORT,
+                           TOPK_BY_BITONIC_SORT,
                            DATASET_DESCRIPTOR_T,
                            SAMPLE_FILTER_T>;
+    }
+  }
+
+  using kernel_t = decltype(get_kernel<64, 64, 0>());
+
+  template <unsigned MAX_CANDIDATES, unsigned USE_BITONIC_SORT>
+  static auto choose_search_kernel(unsigned itopk_size) -> kernel_t
+  {
+    if (itopk_size <= 64) {
+      return get_kernel<64, MAX_CANDIDATES, USE_BITONIC_SORT>();
     } else if (itopk_size <= 128) {
-      return search_kernel<TEAM_SIZE,
-                           DATASET_BLOCK_DIM,
-                           128,
-                           MAX_CANDIDATES,
-                           USE_BITONIC_SORT,
-                           DATASET_DESCRIPTOR_T,
-                           SAMPLE_FILTER_T>;
+      return get_kernel<128, MAX_CANDIDATES, USE_BITONIC_SORT>();
     } else if (itopk_size <= 256) {
-      return search_kernel<TEAM_SIZE,
-                           DATASET_BLOCK_DIM,
-                           256,
-                           MAX_CANDIDATES,
-                           USE_BITONIC_SORT,
-                           DATASET_DESCRIPTOR_T,
-                           SAMPLE_FILTER_T>;
+      return get_kernel<256, MAX_CANDIDATES, USE_BITONIC_SORT>();
     } else if (itopk_size <= 512) {
-      return search_kernel<TEAM_SIZE,
-                           DATASET_BLOCK_DIM,
-                           512,
-                           MAX_CANDIDATES,
-                           USE_BITONIC_SORT,
-                           DATASET_DESCRIPTOR_T,
-                           SAMPLE_FILTER_T>;
+      return get_kernel<512, MAX_CANDIDATES, USE_BITONIC_SORT>();
     }
     THROW("No kernel for parametels itopk_size %u, max_candidates %u", itopk_size, MAX_CANDIDATES);
   }
@@ -878,21 +1096,9 @@ struct search_kernel_config {
       // Radix-based topk is used
       constexpr unsigned max_candidates = 32;  // to avoid build failure
       if (itopk_size <= 256) {
-        return search_kernel<TEAM_SIZE,
-                             DATASET_BLOCK_DIM,
-                             256,
-                             max_candidates,
-                             0,
-                             DATASET_DESCRIPTOR_T,
-                             SAMPLE_FILTER_T>;
+        return get_kernel<256, max_candidates, 0>();
       } else if (itopk_size <= 512) {
-        return search_kernel<TEAM_SIZE,
-                             DATASET_BLOCK_DIM,
-                             512,
-                             max_candidates,
-                             0,
-                             DATASET_DESCRIPTOR_T,
-                             SAMPLE_FILTER_T>;
+        return get_kernel<512, max_candidates, 0>();
       }
     }
     THROW("No kernel for parametels itopk_size %u, num_itopk_candidates %u",
@@ -901,6 +1107,281 @@ struct search_kernel_config {
   }
 };
 
+/** Type-erased base of the persistent runners, so that all of them can share one cache slot. */
+struct persistent_runner_base_t {
+  virtual ~persistent_runner_base_t() noexcept = default;
+};
+
+/**
+ * Owner of a running persistent search kernel.
+ *
+ * The kernel is started by the first submission and stays resident on the device until it has
+ * been idle for `lifetime` seconds; the next submission then restarts it.
+ */
+template <class DATASET_DESCRIPTOR_T, class SAMPLE_FILTER_T>
+class persistent_runner_t : public persistent_runner_base_t {
+ public:
+  using INDEX_T    = typename DATASET_DESCRIPTOR_T::INDEX_T;
+  using job_t      = persistent_job_t<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T>;
+  using slot_t     = persistent_job_slot_t<job_t>;
+  using kernel_t   = void (*)(slot_t*, uint32_t, unsigned long long int*, uint32_t*, INDEX_T*);
+  using ticket_ref = cuda::atomic_ref<uint64_t, cuda::thread_scope_system>;
+
+  persistent_runner_t(raft::resources const& res,
+                      kernel_t kernel,
+                      uint32_t block_size,
+                      uint32_t smem_size,
+                      int64_t hash_bitlen,
+                      size_t small_hash_bitlen,
+                      float lifetime)
+    : kernel_{kernel},
+      block_size_{block_size},
+      smem_size_{smem_size},
+      hash_bitlen_{small_hash_bitlen ? 0 : hash_bitlen},
+      lifetime_{lifetime},
+      device_id_{raft::resource::get_device_id(res)},
+      n_workers_{calc_n_workers(kernel, block_size, smem_size)},
+      n_slots_{4 * n_workers_},
+      slots_{raft::make_pinned_vector<slot_t, uint32_t>(res, n_slots_)},
+      stop_flag_{raft::make_pinned_scalar<uint32_t>(res, 0)},
+      head_{1, rmm::cuda_stream_view(stream_.value)},
+      hashmap_{hash_bitlen_ ? n_workers_ * hashmap::get_size(hash_bitlen_) : 0,
+               rmm::cuda_stream_view(stream_.value)},
+      last_touch_{clock_type::now().time_since_epoch().count()}
+  {
+    RAFT_LOG_DEBUG("Persistent search kernel: %u workers, %u slots", n_workers_, n_slots_);
+    watchdog_ = std::thread([this]() { watch(); });
+  }
+
+  ~persistent_runner_t() noexcept override
+  {
+    {
+      std::lock_guard<std::mutex> guard(watchdog_mutex_);
+      watchdog_exit_ = true;
+    }
+    watchdog_cv_.notify_all();
+    watchdog_.join();
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (running_) {
+      cuda::atomic_ref<uint32_t, cuda::thread_scope_system>{*stop_flag_.data_handle()}.store(
+        1, cuda::memory_order_release);
+      RAFT_CUDA_TRY_NO_THROW(cudaStreamSynchronize(stream_.value));
+    }
+  }
+
+  [[nodiscard]] auto matches(kernel_t kernel,
+                             uint32_t block_size,
+                             uint32_t smem_size,
+                             int64_t hash_bitlen,
+                             size_t small_hash_bitlen,
+                             int device_id) const -> bool
+  {
+    return kernel_ == kernel && block_size_ == block_size && smem_size_ == smem_size &&
+           hash_bitlen_ == (small_hash_bitlen ? 0 : hash_bitlen) && device_id_ == device_id;
+  }
+
+  void set_lifetime(float lifetime) { lifetime_.store(lifetime); }
+
+  /**
+   * Run the search for `num_queries` queries, each one described by `job` with its own query_id.
+   * Blocks until all the results are written.
+   */
+  void submit(const job_t& job, uint32_t num_queries, cudaStream_t stream)
+  {
+    if (num_queries == 0) { return; }
+    // The inputs must be ready and the outputs not in use by the caller's stream.
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    while (!running_) {
+      lock.unlock();
+      {
+        std::unique_lock<std::shared_mutex> exclusive_lock(mutex_);
+        if (!running_) { launch(); }
+      }
+      lock.lock();
+    }
+    touch();
+
+    std::vector<uint64_t> tickets(num_queries);
+    uint32_t n_posted = 0;
+    uint32_t n_done   = 0;
+    // Release the slots of the own completed jobs (in the order of submission).
+    auto reap = [&]() {
+      while (n_done < n_posted) {
+        const uint64_t t = tickets[n_done];
+        auto& slot       = slots_(t % n_slots_);
+        if (ticket_ref{slot.done_ticket}.load(cuda::memory_order_acquire) != t) { return; }
+        ticket_ref{slot.free_ticket}.store(t + n_slots_, cuda::memory_order_release);
+        n_done++;
+      }
+    };
+    for (uint32_t i = 0; i < num_queries; i++) {
+      const uint64_t t = tail_.fetch_add(1);
+      auto& slot       = slots_(t % n_slots_);
+      while (ticket_ref{slot.free_ticket}.load(cuda::memory_order_acquire) != t) {
+        reap();
+        std::this_thread::yield();
+      }
+      slot.job          = job;
+      slot.job.query_id = i;
+      ticket_ref{slot.ticket}.store(t, cuda::memory_order_release);
+      tickets[n_posted++] = t;
+    }
+    while (n_done < n_posted) {
+      reap();
+      std::this_thread::yield();
+    }
+    touch();
+  }
+
+ private:
+  using clock_type = std::chrono::steady_clock;
+
+  // The kernel never finishes on its own, hence it must not block the legacy default stream.
+  struct nonblocking_stream_t {
+    cudaStream_t value{};
+    nonblocking_stream_t()
+    {
+      RAFT_CUDA_TRY(cudaStreamCreateWithFlags(&value, cudaStreamNonBlocking));
+    }
+    ~nonblocking_stream_t() noexcept { RAFT_CUDA_TRY_NO_THROW(cudaStreamDestroy(value)); }
+    nonblocking_stream_t(const nonblocking_stream_t&)                    = delete;
+    auto operator=(const nonblocking_stream_t&) -> nonblocking_stream_t& = delete;
+  };
+
+  static auto calc_n_workers(kernel_t kernel, uint32_t block_size, uint32_t smem_size) -> uint32_t
+  {
+    RAFT_CUDA_TRY(
+      cudaFuncSetAttribute(kernel,
+                           cudaFuncAttributeMaxDynamicSharedMemorySize,
+                           smem_size + DATASET_DESCRIPTOR_T::smem_buffer_size_in_byte));
+    int blocks_per_sm = 0;
+    RAFT_CUDA_TRY(
+      cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blocks_per_sm, kernel, block_size, smem_size));
+    RAFT_EXPECTS(blocks_per_sm > 0,
+                 "The persistent search kernel does not fit on the device (block size %u, "
+                 "shared memory %u bytes)",
+                 block_size,
+                 smem_size);
+    return static_cast<uint32_t>(blocks_per_sm * raft::getMultiProcessorCount());
+  }
+
+  void touch() { last_touch_.store(clock_type::now().time_since_epoch().count()); }
+
+  // Requires the exclusive lock.
+  void launch()
+  {
+    raft::device_setter dev(device_id_);
+    for (uint32_t i = 0; i < n_slots_; i++) {
+      auto& slot       = slots_(i);
+      slot.ticket      = std::numeric_limits<uint64_t>::max();
+      slot.done_ticket = std::numeric_limits<uint64_t>::max();
+      slot.free_ticket = i;
+    }
+    *stop_flag_.data_handle() = 0;
+    tail_.store(0);
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(head_.data(), 0, sizeof(unsigned long long int), stream_.value));
+    kernel_<<<n_workers_, block_size_, smem_size_, stream_.value>>>(
+      slots_.data_handle(), n_slots_, head_.data(), stop_flag_.data_handle(), hashmap_.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    running_ = true;
+    touch();
+  }
+
+  // Stops the kernel once it is idle for longer than the lifetime.
+  void watch()
+  {
+    std::unique_lock<std::mutex> guard(watchdog_mutex_);
+    while (!watchdog_exit_) {
+      const auto lifetime = std::chrono::duration<float>(lifetime_.load());
+      watchdog_cv_.wait_for(guard, lifetime / 4);
+      if (watchdog_exit_ || !running_) { continue; }
+      const auto idle = clock_type::now() - clock_type::time_point(clock_type::duration(last_touch_.load()));
+      if (idle < lifetime) { continue; }
+      std::unique_lock<std::shared_mutex> lock(mutex_, std::try_to_lock);
+      if (!lock.owns_lock() || !running_) { continue; }
+      cuda::atomic_ref<uint32_t, cuda::thread_scope_system>{*stop_flag_.data_handle()}.store(
+        1, cuda::memory_order_release);
+      RAFT_CUDA_TRY_NO_THROW(cudaStreamSynchronize(stream_.value));
+      running_ = false;
+      RAFT_LOG_DEBUG("Persistent search kernel stopped after %f s of inactivity",
+                     static_cast<double>(lifetime.count()));
+    }
+  }
+
+  kernel_t kernel_;
+  uint32_t block_size_;
+  uint32_t smem_size_;
+  int64_t hash_bitlen_;
+  std::atomic<float> lifetime_;
+  int device_id_;
+  uint32_t n_workers_;
+  uint32_t n_slots_;
+  nonblocking_stream_t stream_;
+  raft::pinned_vector<slot_t, uint32_t> slots_;
+  raft::pinned_scalar<uint32_t> stop_flag_;
+  rmm::device_uvector<unsigned long long int> head_;
+  rmm::device_uvector<INDEX_T> hashmap_;
+  std::atomic<uint64_t> tail_{0};
+  std::shared_mutex mutex_;
+  std::atomic<bool> running_{false};
+  std::atomic<clock_type::rep> last_touch_;
+  std::mutex watchdog_mutex_;
+  std::condition_variable watchdog_cv_;
+  bool watchdog_exit_{false};
+  std::thread watchdog_;
+};
+
+struct persistent_runner_cache_t {
+  std::mutex mutex;
+  std::shared_ptr<persistent_runner_base_t> runner{nullptr};
+};
+
+/**
+ * The only cached persistent runner. It is created on the first use, that is after the CUDA
+ * runtime is initialized, so that it is destroyed before the runtime at the program exit.
+ */
+inline auto persistent_runner_cache() -> persistent_runner_cache_t&
+{
+  static persistent_runner_cache_t cache;
+  return cache;
+}
+
+/**
+ * Get the running persistent kernel matching the arguments on the current device, or replace the
+ * current one by a new one. Only one persistent kernel is kept at a time, because it occupies the
+ * whole GPU.
+ */
+template <class RunnerT>
+auto get_persistent_runner(typename RunnerT::kernel_t kernel,
+                           uint32_t block_size,
+                           uint32_t smem_size,
+                           int64_t hash_bitlen,
+                           size_t small_hash_bitlen,
+                           float lifetime) -> std::shared_ptr<RunnerT>
+{
+  int device_id;
+  RAFT_CUDA_TRY(cudaGetDevice(&device_id));
+  auto& cache = persistent_runner_cache();
+  std::lock_guard<std::mutex> guard(cache.mutex);
+  auto runner = std::dynamic_pointer_cast<RunnerT>(cache.runner);
+  if (runner &&
+      runner->matches(kernel, block_size, smem_size, hash_bitlen, small_hash_bitlen, device_id)) {
+    runner->set_lifetime(lifetime);
+    return runner;
+  }
+  // Stop the previous kernel (unless it is still used by another thread) to free the device.
+  runner.reset();
+  cache.runner.reset();
+  // The runner only needs a handle for its allocations on the current device.
+  raft::resources res;
+  runner = std::make_shared<RunnerT>(
+    res, kernel, block_size, smem_size, hash_bitlen, small_hash_bitlen, lifetime);
+  cache.runner = runner;
+  return runner;
+}
+
 template <unsigned TEAM_SIZE,
           unsigned DATASET_BLOCK_DIM,
           typename DATASET_DESCRIPTOR_T,
@@ -908,6 +1389,7 @@ template <unsigned TEAM_SIZE,
 void select_and_run(
   DATASET_DESCRIPTOR_T dataset_desc,
   raft::device_matrix_view<const typename DATASET_DESCRIPTOR_T::INDEX_T, int64_t, row_major> graph,
+  uint32_t graph_id_bits,
   typename DATASET_DESCRIPTOR_T::INDEX_T* const topk_indices_ptr,       // [num_queries, topk]
   typename DATASET_DESCRIPTOR_T::DISTANCE_T* const topk_distances_ptr,  // [num_queries, topk]
   const typename DATASET_DESCRIPTOR_T::DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
@@ -931,11 +1413,55 @@ void select_and_run(
   size_t max_iterations,
   SAMPLE_FILTER_T sample_filter,
   raft::distance::DistanceType metric,
+  bool persistent,
+  float persistent_lifetime,
   cudaStream_t stream)
 {
-  auto kernel =
-    search_kernel_config<TEAM_SIZE, DATASET_BLOCK_DIM, DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T>::
+  if (persistent) {
+    using runner_type = persistent_runner_t<DATASET_DESCRIPTOR_T, SAMPLE_FILTER_T>;
+    RAFT_EXPECTS(persistent_lifetime > 0, "persistent_lifetime must be positive");
+    auto kernel = search_kernel_config<true,
+                                       TEAM_SIZE,
+                                       DATASET_BLOCK_DIM,
+                                       DATASET_DESCRIPTOR_T,
+                                       SAMPLE_FILTER_T>::
       choose_itopk_and_mx_candidates(itopk_size, num_itopk_candidates, block_size);
+    auto runner = get_persistent_runner<runner_type>(
+      kernel, block_size, smem_size, hash_bitlen, small_hash_bitlen, persistent_lifetime);
+
+    typename runner_type::job_t job{};
+    job.result_indices_ptr        = topk_indices_ptr;
+    job.result_distances_ptr      = topk_distances_ptr;
+    job.queries_ptr               = queries_ptr;
+    job.knn_graph                 = graph.data_handle();
+    job.seed_ptr                  = dev_seed_ptr;
+    job.num_executed_iterations   = num_executed_iterations;
+    job.rand_xor_mask             = rand_xor_mask;
+    job.top_k                     = topk;
+    job.graph_degree              = graph.extent(1);
+    job.graph_id_bits             = graph_id_bits;
+    job.num_distilation           = num_random_samplings;
+    job.num_seeds                 = num_seeds;
+    job.internal_topk             = itopk_size;
+    job.search_width              = search_width;
+    job.min_iteration             = min_iterations;
+    job.max_iteration             = max_iterations;
+    job.hash_bitlen               = hash_bitlen;
+    job.small_hash_bitlen         = small_hash_bitlen;
+    job.small_hash_reset_interval = small_hash_reset_interval;
+    job.metric                    = metric;
+    std::memcpy(job.dataset_desc, &dataset_desc, sizeof(DATASET_DESCRIPTOR_T));
+    std::memcpy(job.sample_filter, &sample_filter, sizeof(SAMPLE_FILTER_T));
+    runner->submit(job, num_queries, stream);
+    return;
+  }
+
+  auto kernel = search_kernel_config<false,
+                                     TEAM_SIZE,
+                                     DATASET_BLOCK_DIM,
+                                     DATASET_DESCRIPTOR_T,
+                                     SAMPLE_FILTER_T>::
+    choose_itopk_and_mx_candidates(itopk_size, num_itopk_candidates, block_size);
   RAFT_CUDA_TRY(cudaFuncSetAttribute(kernel,
                                      cudaFuncAttributeMaxDynamicSharedMemorySize,
                                      smem_size + DATASET_DESCRIPTOR_T::smem_buffer_size_in_byte));
@@ -950,6 +1476,7 @@ void select_and_run(
                                                          queries_ptr,
                                                          graph.data_handle(),
                                                          graph.extent(1),
+                                                         graph_id_bits,
                                                          num_random_samplings,
                                                          rand_xor_mask,
                                                          dev_seed_ptr,
@@ -18,6 +18,7 @@
 #include <raft/core/detail/macros.hpp>
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/host_mdarray.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
 #include <raft/util/integer_utils.hpp>
 
 #include <rmm/resource_ref.hpp>
@@ -27,6 +28,7 @@
 
 #include <cfloat>
 #include <cstdint>
+#include <tuple>
 #include <type_traits>
 
 namespace raft::neighbors::cagra::detail {
@@ -256,6 +258,51 @@ class host_matrix_view_from_device {
   T* host_ptr;
 };
 
+/**
+ * Utility to make a host buffer directly accessible from the device (zero-copy)
+ *
+ * Unless the buffer is already accessible on the device, it is page-locked and mapped into the
+ * device address space for the lifetime of the object. This allows kernels to access host
+ * arrays which do not fit into device memory, at the cost of reading them over the PCIe bus.
+ */
+template <typename T>
+class device_mapped_host_memory {
+ public:
+  device_mapped_host_memory(T* host_ptr, size_t n_elements)
+  {
+    cudaPointerAttributes attr;
+    RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, host_ptr));
+    if (attr.devicePointer == nullptr) {
+      auto* ptr          = const_cast<std::remove_const_t<T>*>(host_ptr);
+      unsigned int flags = cudaHostRegisterMapped;
+      // Files mmap'd without write permission can only be registered as read-only.
+      if (std::is_const_v<T>) { flags |= cudaHostRegisterReadOnly; }
+      if (cudaHostRegister(ptr, n_elements * sizeof(T), flags) != cudaSuccess) {
+        // Read-only registration is not supported by all devices; clear the error and retry.
+        std::ignore = cudaGetLastError();
+        RAFT_CUDA_TRY(cudaHostRegister(ptr, n_elements * sizeof(T), cudaHostRegisterMapped));
+      }
+      registered_ptr_ = ptr;
+      RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, host_ptr));
+    }
+    device_ptr_ = reinterpret_cast<T*>(attr.devicePointer);
+  }
+
+  ~device_mapped_host_memory() noexcept
+  {
+    if (registered_ptr_ != nullptr) { RAFT_CUDA_TRY_NO_THROW(cudaHostUnregister(registered_ptr_)); }
+  }
+
+  device_mapped_host_memory(const device_mapped_host_memory&)            = delete;
+  device_mapped_host_memory& operator=(const device_mapped_host_memory&) = delete;
+
+  T* data_handle() const { return device_ptr_; }
+
+ private:
+  std::remove_const_t<T>* registered_ptr_ = nullptr;
+  T* device_ptr_;
+};
+
 // Copy matrix src to dst. pad rows with 0 if necessary to make them 16 byte aligned.
 template <typename T, typename data_accessor>
 void copy_with_padding(raft::resources const& res,
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/detail/select_warpsort.cuh>
+#include <raft/neighbors/haversine_grid_types.hpp>
+#include <raft/spatial/knn/detail/haversine_distance.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <thrust/binary_search.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace raft::neighbors::haversine_grid::detail {
+
+constexpr double kPi     = 3.14159265358979323846;
+constexpr double kHalfPi = kPi / 2;
+/** The smallest cell chosen automatically (about 640 m on the Earth). */
+constexpr double kMinAutoCellSize = 1e-4;
+/** Every query is searched by a warp; this many queries per block. */
+constexpr uint32_t kQueriesPerBlock = 4;
+
+/** The latitude band of a point (the points beyond the poles go to the polar bands). */
+_RAFT_HOST_DEVICE inline auto band_of(double lat, uint32_t n_bands, double band_height)
+  -> uint32_t
+{
+  const double b = floor((lat + kHalfPi) / band_height);
+  if (!(b > 0)) { return 0; }
+  return b < n_bands ? static_cast<uint32_t>(b) : n_bands - 1;
+}
+
+/** The number of the cells of a band: the band is cut so that no cell is wider than its height. */
+inline auto cells_in_band(uint32_t band, double band_height) -> uint32_t
+{
+  const double lat_lo  = -kHalfPi + band * band_height;
+  const double lat_hi  = lat_lo + band_height;
+  const double max_cos =
+    (lat_lo <= 0 && lat_hi >= 0) ? 1.0 : std::max(std::cos(lat_lo), std::cos(lat_hi));
+  return std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(2 * kPi * max_cos / band_height)));
+}
+
+/**
+ * The cells of a band covering the longitudes within `half_width` of `lon`, as an interval of the
+ * unwrapped cell ids [lo, hi] (the actual ids are modulo the number of cells in the band).
+ */
+struct lon_interval {
+  int64_t lo;
+  int64_t hi;
+  bool full;
+
+  _RAFT_DEVICE lon_interval(double lon, double half_width, uint32_t n_cells)
+  {
+    full = half_width >= kPi;
+    if (full) { return; }
+    const double cell_width = 2 * kPi / n_cells;
+    lo                      = static_cast<int64_t>(floor((lon + kPi - half_width) / cell_width));
+    hi                      = static_cast<int64_t>(floor((lon + kPi + half_width) / cell_width));
+    full                    = hi - lo + 1 >= int64_t(n_cells);
+  }
+};
+
+/** The latitude bands and the longitude extent of the spherical cap of radius `theta`. */
+struct cap_bounds {
+  uint32_t band_lo;
+  uint32_t band_hi;
+  double half_width;
+
+  _RAFT_DEVICE cap_bounds(double lat, double theta, uint32_t n_bands, double band_height)
+  {
+    band_lo = band_of(lat - theta, n_bands, band_height);
+    band_hi = band_of(lat + theta, n_bands, band_height);
+    if (lat + theta >= kHalfPi || lat - theta <= -kHalfPi) {
+      // The cap contains a pole
+      half_width = kPi;
+      return;
+    }
+    const double s = sin(theta) / cos(lat);
+    half_width     = s >= 1.0 ? kPi : asin(s);
+  }
+};
+
+template <typename T>
+RAFT_KERNEL compute_cells_kernel(const T* points,  // [n_rows, 2]
+                                 int64_t n_rows,
+                                 uint32_t n_bands,
+                                 double band_height,
+                                 const uint32_t* band_offsets,  // [n_bands + 1]
+                                 uint32_t* cells)               // [n_rows]
+{
+  const int64_t i = threadIdx.x + static_cast<int64_t>(blockDim.x) * blockIdx.x;
+  if (i >= n_rows) { return; }
+  const double lat     = points[2 * i];
+  const double lon     = points[2 * i + 1];
+  const uint32_t band  = band_of(lat, n_bands, band_height);
+  const uint32_t first = band_offsets[band];
+  const uint32_t n     = band_offsets[band + 1] - first;
+  double x             = (lon + kPi) / (2 * kPi);
+  x -= floor(x);
+  cells[i] = first + min(static_cast<uint32_t>(x * n), n - 1);
+}
+
+template <typename T>
+RAFT_KERNEL gather_points_kernel(const T* src,  // [n_rows, 2]
+                                 int64_t n_rows,
+                                 const int64_t* indices,  // [n_rows]
+                                 T* dst)                  // [n_rows, 2]
+{
+  const int64_t i = threadIdx.x + static_cast<int64_t>(blockDim.x) * blockIdx.x;
+  if (i >= n_rows) { return; }
+  const int64_t j = indices[i];
+  dst[2 * i]      = src[2 * j];
+  dst[2 * i + 1]  = src[2 * j + 1];
+}
+
+/**
+ * Search the nearest points of a query by a warp, expanding the visited cells ring by ring.
+ *
+ * The ring `r` covers the spherical cap of the radius `(r + 1) * band_height` around the query:
+ * the bands it crosses and, in each band, the cells within the longitude extent of the cap. Only
+ * the cells not covered by the previous ring are visited. All points outside the visited cells are
+ * farther than the cap radius, so once the k-th neighbor found is within the radius, the result is
+ * exact.
+ */
+template <int Capacity, typename T>
+RAFT_KERNEL search_kernel(const T* queries,  // [n_queries, 2]
+                          int64_t n_queries,
+                          const T* points,              // [n_rows, 2]
+                          const uint32_t* band_offsets,  // [n_bands + 1]
+                          const int64_t* cell_offsets,   // [n_cells + 1]
+                          const int64_t* indices,        // [n_rows]
+                          uint32_t n_bands,
+                          double band_height,
+                          uint32_t max_rings,
+                          uint32_t k,
+                          int64_t* neighbors,  // [n_queries, k]
+                          T* distances)        // [n_queries, k]
+{
+  using queue_t = matrix::detail::select::warpsort::warp_sort_filtered<Capacity, true, T, int64_t>;
+  extern __shared__ __align__(256) uint8_t smem[];
+  const uint32_t warp_id = threadIdx.x / WarpSize;
+  const uint32_t lane    = threadIdx.x % WarpSize;
+  const int64_t q        = static_cast<int64_t>(blockIdx.x) * kQueriesPerBlock + warp_id;
+  if (q >= n_queries) { return; }
+  auto* warp_pos  = reinterpret_cast<int64_t*>(smem) + warp_id * Capacity;
+  auto* warp_dist = reinterpret_cast<T*>(smem + kQueriesPerBlock * Capacity * sizeof(int64_t)) +
+                    warp_id * Capacity;
+
+  const T q_lat = queries[2 * q];
+  const T q_lon = queries[2 * q + 1];
+  queue_t queue(k);
+
+  // Add the points of the cells [lo, hi] (unwrapped) of the band to the queue
+  auto visit = [&](uint32_t band, int64_t lo, int64_t hi) {
+    const uint32_t first = band_offsets[band];
+    const int64_t n      = band_offsets[band + 1] - first;
+    for (int64_t u = lo; u <= hi; u++) {
+      const uint32_t cell = first + static_cast<uint32_t>(((u % n) + n) % n);
+      const int64_t begin = cell_offsets[cell];
+      const int64_t end   = cell_offsets[cell + 1];
+      for (int64_t j = begin; j < end; j += WarpSize) {
+        const int64_t i = j + lane;
+        T dist          = queue_t::kDummy;
+        if (i < end) {
+          dist = spatial::knn::detail::compute_haversine(
+            q_lat, points[2 * i], q_lon, points[2 * i + 1]);
+        }
+        queue.add(dist, i);
+      }
+    }
+  };
+
+  double prev_theta = 0;
+  for (uint32_t r = 0; r < max_rings; r++) {
+    const double theta = (r + 1) * band_height;
+    const cap_bounds cap(q_lat, theta, n_bands, band_height);
+    const cap_bounds prev(q_lat, prev_theta, n_bands, band_height);
+    for (uint32_t band = cap.band_lo; band <= cap.band_hi; band++) {
+      const uint32_t n_cells = band_offsets[band + 1] - band_offsets[band];
+      const lon_interval cur(q_lon, cap.half_width, n_cells);
+      const bool had_prev = r > 0 && prev.band_lo <= band && band <= prev.band_hi;
+      if (!had_prev) {
+        if (cur.full) {
+          visit(band, 0, int64_t(n_cells) - 1);
+        } else {
+          visit(band, cur.lo, cur.hi);
+        }
+        continue;
+      }
+      // The cells of the previous ring are inside the current ones; visit only the difference
+      const lon_interval old(q_lon, prev.half_width, n_cells);
+      if (old.full) { continue; }
+      if (cur.full) {
+        visit(band, old.hi + 1, old.lo - 1 + n_cells);
+      } else {
+        visit(band, cur.lo, old.lo - 1);
+        visit(band, old.hi + 1, cur.hi);
+      }
+    }
+    queue.done();
+    queue.store(warp_dist, warp_pos);
+    __syncwarp();
+    const bool exact = warp_dist[k - 1] <= theta;
+    __syncwarp();
+    if (exact || theta >= kPi) { break; }
+    prev_theta = theta;
+  }
+
+  for (uint32_t j = lane; j < k; j += WarpSize) {
+    const T dist         = warp_dist[j];
+    distances[q * k + j] = dist;
+    neighbors[q * k + j] =
+      dist == queue_t::kDummy ? std::numeric_limits<int64_t>::max() : indices[warp_pos[j]];
+  }
+}
+
+/** Pick the smallest warp queue fitting `k` (but no narrower than a warp). */
+template <int Capacity, typename T>
+void launch_search(raft::resources const& res,
+                   const index<T>& idx,
+                   const T* queries,
+                   int64_t n_queries,
+                   uint32_t max_rings,
+                   uint32_t k,
+                   int64_t* neighbors,
+                   T* distances)
+{
+  if constexpr (Capacity > WarpSize) {
+    if (k * 2 <= Capacity) {
+      return launch_search<Capacity / 2, T>(
+        res, idx, queries, n_queries, max_rings, k, neighbors, distances);
+    }
+  }
+  const size_t smem_size = kQueriesPerBlock * Capacity * (sizeof(int64_t) + sizeof(T));
+  const dim3 block(kQueriesPerBlock * WarpSize);
+  const dim3 grid(raft::div_rounding_up_safe<int64_t>(n_queries, kQueriesPerBlock));
+  search_kernel<Capacity, T><<<grid, block, smem_size, resource::get_cuda_stream(res)>>>(
+    queries,
+    n_queries,
+    idx.points().data_handle(),
+    idx.band_offsets().data_handle(),
+    idx.cell_offsets().data_handle(),
+    idx.indices().data_handle(),
+    idx.n_bands(),
+    idx.cell_size(),
+    max_rings,
+    k,
+    neighbors,
+    distances);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename T>
+auto build(raft::resources const& res,
+           const index_params& params,
+           raft::device_matrix_view<const T, int64_t, row_major> dataset) -> index<T>
+{
+  const int64_t n_rows = dataset.extent(0);
+  RAFT_EXPECTS(dataset.extent(1) == 2, "The points must be (latitude, longitude) pairs");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("haversine_grid::build(%zu)",
+                                                            size_t(n_rows));
+  auto stream = resource::get_cuda_stream(res);
+
+  double cell_size = params.cell_size;
+  if (cell_size <= 0) {
+    cell_size = std::sqrt(4 * kPi * std::max<uint32_t>(params.points_per_cell, 1) /
+                          std::max<int64_t>(n_rows, 1));
+    cell_size = std::clamp(cell_size, kMinAutoCellSize, kHalfPi);
+  }
+  RAFT_EXPECTS(cell_size <= kPi, "The cell_size must not exceed pi");
+  const auto n_bands       = static_cast<uint32_t>(std::ceil(kPi / cell_size));
+  const double band_height = kPi / n_bands;
+
+  std::vector<uint32_t> band_offsets(n_bands + 1);
+  uint64_t n_cells = 0;
+  for (uint32_t b = 0; b < n_bands; b++) {
+    band_offsets[b] = static_cast<uint32_t>(n_cells);
+    n_cells += cells_in_band(b, band_height);
+    RAFT_EXPECTS(n_cells < std::numeric_limits<uint32_t>::max(),
+                 "The cell_size is too small: the grid has too many cells");
+  }
+  band_offsets[n_bands] = static_cast<uint32_t>(n_cells);
+
+  index<T> idx(res, band_height, n_bands, static_cast<uint32_t>(n_cells), n_rows);
+  raft::copy(idx.band_offsets().data_handle(), band_offsets.data(), n_bands + 1, stream);
+  if (n_rows == 0) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(
+      idx.cell_offsets().data_handle(), 0, (n_cells + 1) * sizeof(int64_t), stream));
+    resource::sync_stream(res);
+    return idx;
+  }
+
+  // Sort the points by their cells; the positions are sorted in place of the index ids.
+  auto cells            = raft::make_device_vector<uint32_t, int64_t>(res, n_rows);
+  constexpr int kBlock  = 256;
+  const int64_t n_block = raft::div_rounding_up_safe<int64_t>(n_rows, kBlock);
+  compute_cells_kernel<T><<<n_block, kBlock, 0, stream>>>(dataset.data_handle(),
+                                                          n_rows,
+                                                          n_bands,
+                                                          band_height,
+                                                          idx.band_offsets().data_handle(),
+                                                          cells.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  auto policy  = resource::get_thrust_policy(res);
+  auto* ids    = idx.indices().data_handle();
+  auto* c_data = cells.data_handle();
+  thrust::sequence(policy, ids, ids + n_rows);
+  thrust::stable_sort_by_key(policy, c_data, c_data + n_rows, ids);
+  thrust::lower_bound(policy,
+                      c_data,
+                      c_data + n_rows,
+                      thrust::counting_iterator<uint32_t>(0),
+                      thrust::counting_iterator<uint32_t>(n_cells + 1),
+                      idx.cell_offsets().data_handle());
+
+  gather_points_kernel<T><<<n_block, kBlock, 0, stream>>>(
+    dataset.data_handle(), n_rows, ids, idx.points().data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  resource::sync_stream(res);
+  return idx;
+}
+
+template <typename T>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index<T>& idx,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+            raft::device_matrix_view<T, int64_t, row_major> distances)
+{
+  using matrix::detail::select::warpsort::kMaxCapacity;
+  const int64_t n_queries = queries.extent(0);
+  const int64_t k         = neighbors.extent(1);
+  RAFT_EXPECTS(queries.extent(1) == 2, "The queries must be (latitude, longitude) pairs");
+  RAFT_EXPECTS(neighbors.extent(0) == n_queries && distances.extent(0) == n_queries &&
+                 distances.extent(1) == k,
+               "Wrong shape of the output");
+  RAFT_EXPECTS(0 < k && k <= kMaxCapacity, "k must be in [1, %d]", kMaxCapacity);
+  RAFT_EXPECTS(params.max_rings > 0, "max_rings must be positive");
+  if (n_queries == 0) { return; }
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "haversine_grid::search(%zu, %zu)", size_t(n_queries), size_t(k));
+  launch_search<kMaxCapacity, T>(res,
+                                 idx,
+                                 queries.data_handle(),
+                                 n_queries,
+                                 params.max_rings,
+                                 static_cast<uint32_t>(k),
+                                 neighbors.data_handle(),
+                                 distances.data_handle());
+}
+
+}  // namespace raft::neighbors::haversine_grid::detail
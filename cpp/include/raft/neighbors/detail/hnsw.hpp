@@ -16,67 +16,228 @@
 
 #pragma once
 
+#include "hnsw_numa.hpp"
 #include "hnsw_types.hpp"
 
+#include <raft/core/error.hpp>
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
 
 #include <hnswlib/hnswlib.h>
 #include <omp.h>
 
 #include <cstdint>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace raft::neighbors::hnsw::detail {
 
-template <typename T>
+/** The number of queries handed out to a thread at a time. */
+constexpr int64_t kQueriesPerTask = 16;
+
+/**
+ * The entry point of the base layer for a query: the closest of the seeds of the base layer if the
+ * index has no upper layers, otherwise the end of the greedy descent through the upper layers.
+ */
+template <typename dist_t, typename T>
+auto search_entry_point(hnswlib::HierarchicalNSW<dist_t> const* idx, const T* query)
+  -> hnswlib::tableint
+{
+  auto dist = [idx, query](hnswlib::tableint id) {
+    return idx->fstdistfunc_(query, idx->getDataByInternalId(id), idx->dist_func_param_);
+  };
+  hnswlib::tableint cur_obj = idx->enterpoint_node_;
+  dist_t cur_dist           = dist(cur_obj);
+  if (idx->base_layer_only) {
+    for (int i = 0; i < idx->num_seeds; i++) {
+      const auto obj = static_cast<hnswlib::tableint>(i * (idx->max_elements_ / idx->num_seeds));
+      const auto d   = dist(obj);
+      if (d < cur_dist) {
+        cur_dist = d;
+        cur_obj  = obj;
+      }
+    }
+    return cur_obj;
+  }
+  for (int level = idx->maxlevel_; level > 0; level--) {
+    bool changed = true;
+    while (changed) {
+      changed     = false;
+      auto* links = idx->get_linklist(cur_obj, level);
+      const int n = idx->getListCount(links);
+      auto* ids   = reinterpret_cast<hnswlib::tableint*>(links + 1);
+      for (int i = 0; i < n; i++) {
+        const auto d = dist(ids[i]);
+        if (d < cur_dist) {
+          cur_dist = d;
+          cur_obj  = ids[i];
+          changed  = true;
+        }
+      }
+    }
+  }
+  return cur_obj;
+}
+
+/**
+ * The beam search of the base layer that keeps only the samples passing the filter.
+ *
+ * hnswlib 0.6 has no filtering, hence the search is done here, the same way as hnswlib does it for
+ * the deleted elements: the rejected samples are still traversed, so that the graph stays
+ * connected, but they never enter the results. The filter is called with the labels of the
+ * samples, i.e. their indices in the source dataset.
+ */
+template <typename dist_t, typename T, typename filter_t>
+auto search_base_layer_filtered(hnswlib::HierarchicalNSW<dist_t> const* idx,
+                                const T* query,
+                                uint32_t query_ix,
+                                hnswlib::tableint entry_point,
+                                size_t ef,
+                                filter_t filter)
+  -> std::priority_queue<std::pair<dist_t, hnswlib::tableint>>
+{
+  auto dist = [idx, query](hnswlib::tableint id) {
+    return idx->fstdistfunc_(query, idx->getDataByInternalId(id), idx->dist_func_param_);
+  };
+  auto allowed = [idx, query_ix, &filter](hnswlib::tableint id) {
+    return filter(query_ix, static_cast<uint32_t>(idx->getExternalLabel(id)));
+  };
+  auto* visited_list = idx->visited_list_pool_->getFreeVisitedList();
+  auto* visited      = visited_list->mass;
+  const auto tag     = visited_list->curV;
+
+  // The accepted samples (max-heap) and the samples to expand (max-heap of the negated distances)
+  std::priority_queue<std::pair<dist_t, hnswlib::tableint>> top_candidates;
+  std::priority_queue<std::pair<dist_t, hnswlib::tableint>> candidates;
+  dist_t lower_bound = std::numeric_limits<dist_t>::max();
+  const dist_t d0    = dist(entry_point);
+  if (allowed(entry_point)) {
+    top_candidates.emplace(d0, entry_point);
+    lower_bound = d0;
+  }
+  candidates.emplace(-d0, entry_point);
+  visited[entry_point] = tag;
+
+  while (!candidates.empty()) {
+    const auto [neg_dist, cur] = candidates.top();
+    if (-neg_dist > lower_bound && top_candidates.size() == ef) { break; }
+    candidates.pop();
+
+    auto* links = idx->get_linklist0(cur);
+    const int n = idx->getListCount(links);
+    auto* ids   = reinterpret_cast<hnswlib::tableint*>(links + 1);
+    for (int i = 0; i < n; i++) {
+      const auto cand = ids[i];
+      if (visited[cand] == tag) { continue; }
+      visited[cand]  = tag;
+      const dist_t d = dist(cand);
+      if (top_candidates.size() < ef || d < lower_bound) {
+        candidates.emplace(-d, cand);
+        if (allowed(cand)) {
+          top_candidates.emplace(d, cand);
+          if (top_candidates.size() > ef) { top_candidates.pop(); }
+          lower_bound = top_candidates.top().first;
+        }
+      }
+    }
+  }
+  idx->visited_list_pool_->releaseVisitedList(visited_list);
+  return top_candidates;
+}
+
+template <typename T, typename filter_t>
 void get_search_knn_results(hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type> const* idx,
                             const T* query,
+                            uint32_t query_ix,
                             int k,
                             uint64_t* indices,
-                            float* distances)
+                            float* distances,
+                            filter_t filter)
 {
-  auto result = idx->searchKnn(query, k);
-  assert(result.size() >= static_cast<size_t>(k));
+  using dist_t = typename hnsw_dist_t<T>::type;
+  if constexpr (std::is_same_v<filter_t, raft::neighbors::filtering::none_cagra_sample_filter>) {
+    auto result = idx->searchKnn(query, k);
+    assert(result.size() >= static_cast<size_t>(k));
 
-  for (int i = k - 1; i >= 0; --i) {
-    indices[i]   = result.top().second;
-    distances[i] = result.top().first;
-    result.pop();
+    for (int i = k - 1; i >= 0; --i) {
+      indices[i]   = result.top().second;
+      distances[i] = result.top().first;
+      result.pop();
+    }
+  } else {
+    auto result = search_base_layer_filtered<dist_t>(idx,
+                                                     query,
+                                                     query_ix,
+                                                     search_entry_point<dist_t>(idx, query),
+                                                     std::max<size_t>(idx->ef_, k),
+                                                     filter);
+    while (result.size() > static_cast<size_t>(k)) {
+      result.pop();
+    }
+    // Fewer than k samples may pass the filter
+    for (int i = k - 1; i >= 0; --i) {
+      if (static_cast<size_t>(i) >= result.size()) {
+        indices[i]   = std::numeric_limits<uint64_t>::max();
+        distances[i] = std::numeric_limits<float>::max();
+        continue;
+      }
+      indices[i]   = idx->getExternalLabel(result.top().second);
+      distances[i] = result.top().first;
+      result.pop();
+    }
   }
 }
 
-template <typename T>
+template <typename T, typename filter_t>
 void search(raft::resources const& res,
             const search_params& params,
             const index<T>& idx,
             raft::host_matrix_view<const T, int64_t, row_major> queries,
             raft::host_matrix_view<uint64_t, int64_t, row_major> neighbors,
-            raft::host_matrix_view<float, int64_t, row_major> distances)
+            raft::host_matrix_view<float, int64_t, row_major> distances,
+            filter_t filter)
 {
+  using hnsw_t = hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type>;
   idx.set_ef(params.ef);
-  auto const* hnswlib_index =
-    reinterpret_cast<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type> const*>(
-      idx.get_index());
+  std::vector<hnsw_t const*> hnswlib_indices{reinterpret_cast<hnsw_t const*>(idx.get_index())};
 
-  // when num_threads == 0, automatically maximize parallelism
-  if (params.num_threads) {
-#pragma omp parallel for num_threads(params.num_threads)
-    for (int64_t i = 0; i < queries.extent(0); ++i) {
-      get_search_knn_results(hnswlib_index,
-                             queries.data_handle() + i * queries.extent(1),
-                             neighbors.extent(1),
-                             neighbors.data_handle() + i * neighbors.extent(1),
-                             distances.data_handle() + i * distances.extent(1));
-    }
+  // With a single NUMA node, there is nothing to pin the threads to
+  std::vector<numa_node> nodes;
+  if (params.numa_aware) { nodes = get_numa_nodes(); }
+  if (nodes.size() > 1) {
+    auto const* impl = dynamic_cast<index_impl<T> const*>(&idx);
+    RAFT_EXPECTS(impl != nullptr, "NUMA-aware search is not supported by this index");
+    hnswlib_indices = impl->get_numa_replicas(nodes);
   } else {
-#pragma omp parallel for
+    nodes.clear();
+  }
+
+  // when num_threads == 0, automatically maximize parallelism
+  const int num_threads = params.num_threads ? params.num_threads : omp_get_max_threads();
+#pragma omp parallel num_threads(num_threads)
+  {
+    // The threads are spread over the nodes round-robin, each searching the copy of its node
+    const auto node = omp_get_thread_num() % hnswlib_indices.size();
+    cpu_set_t prev_cpus;
+    const bool pinned = !nodes.empty() && pin_this_thread(nodes[node].cpus, &prev_cpus);
+
+#pragma omp for schedule(dynamic, kQueriesPerTask)
     for (int64_t i = 0; i < queries.extent(0); ++i) {
-      get_search_knn_results(hnswlib_index,
+      get_search_knn_results(hnswlib_indices[node],
                              queries.data_handle() + i * queries.extent(1),
+                             static_cast<uint32_t>(i),
                              neighbors.extent(1),
                              neighbors.data_handle() + i * neighbors.extent(1),
-                             distances.data_handle() + i * distances.extent(1));
+                             distances.data_handle() + i * distances.extent(1),
+                             filter);
     }
+
+    // The threads of the OpenMP pool are reused by the later parallel regions
+    if (pinned) { pin_this_thread(prev_cpus); }
   }
 }
 
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "../hnsw_types.hpp"
+#include "hnsw_types.hpp"
+
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/pinned_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/neighbors/detail/cagra/cagra_serialize.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <hnswlib/hnswlib.h>
+#include <omp.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+
+namespace raft::neighbors::hnsw::detail {
+
+/** The size of the pinned staging buffers of the device-to-host copies. */
+constexpr size_t kFromCagraStagingBytes = size_t{64} << 20;
+
+/**
+ * Construct an hnswlib index in place from a CAGRA index.
+ *
+ * The base layer is filled directly in the memory of the hnswlib index: the rows of the graph and
+ * of the dataset are copied from the device in chunks through two pinned staging buffers, so that
+ * the copy of a chunk overlaps with the host writing the previous one. If `include_hierarchy`, the
+ * upper layers are built on the GPU the same way as by `cagra::serialize_to_hnswlib`.
+ */
+template <typename T, typename IdxT>
+std::unique_ptr<index<T>> from_cagra(raft::resources const& res,
+                                     const raft::neighbors::cagra::index<T, IdxT>& cagra_index,
+                                     bool include_hierarchy = true)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("hnsw::from_cagra");
+  RAFT_EXPECTS(cagra_index.num_removed() == 0,
+               "The index has removed samples; call cagra::compact before converting it");
+  RAFT_EXPECTS(cagra_index.graph_id_bits() == 0,
+               "The graph is compressed; call cagra::decompress_graph before converting it");
+  static_assert(sizeof(IdxT) == sizeof(hnswlib::tableint),
+                "The CAGRA graph indices must have the size of the hnswlib ones");
+
+  const auto n_rows = static_cast<int64_t>(cagra_index.size());
+  const auto dim    = static_cast<int64_t>(cagra_index.dim());
+  const auto degree = static_cast<int64_t>(cagra_index.graph_degree());
+  auto dataset      = cagra_index.dataset();
+  auto graph        = cagra_index.graph();
+  auto stream       = resource::get_cuda_stream(res);
+
+  // hnswlib sets the degree of the base layer to 2 * M, which must fit the whole CAGRA graph
+  const auto M = static_cast<size_t>(std::max<int64_t>(1, (degree + 1) / 2));
+  auto hnsw_index =
+    std::make_unique<index_impl<T>>(dim, cagra_index.metric(), std::max<int64_t>(n_rows, 1), M);
+  auto* appr = hnsw_index->get_hnswlib_index();
+
+  include_hierarchy &= M >= 2 && n_rows > 0;
+  std::optional<raft::neighbors::cagra::detail::hnsw_layers<IdxT>> layers;
+  if (include_hierarchy) {
+    // The same seed as for the exported files
+    layers = raft::neighbors::cagra::detail::build_hnsw_layers<T, IdxT>(
+      res, dataset, cagra_index.metric(), M, 100);
+  }
+
+  // The base layer
+  const int64_t row_bytes  = dim * sizeof(T) + degree * sizeof(IdxT);
+  const int64_t chunk_rows =
+    std::clamp<int64_t>(kFromCagraStagingBytes / row_bytes, 1, std::max<int64_t>(n_rows, 1));
+  const int64_t n_chunks   = raft::ceildiv<int64_t>(n_rows, chunk_rows);
+  std::array<std::optional<raft::pinned_matrix<T, int64_t>>, 2> data_buf;
+  std::array<std::optional<raft::pinned_matrix<IdxT, int64_t>>, 2> graph_buf;
+  std::array<cudaEvent_t, 2> copied;
+  for (int b = 0; b < 2; b++) {
+    data_buf[b].emplace(raft::make_pinned_matrix<T, int64_t>(res, chunk_rows, dim));
+    graph_buf[b].emplace(raft::make_pinned_matrix<IdxT, int64_t>(res, chunk_rows, degree));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&copied[b], cudaEventDisableTiming));
+  }
+  auto copy_chunk = [&](int64_t c) {
+    const int b        = c % 2;
+    const int64_t row0 = c * chunk_rows;
+    const int64_t rows = std::min(chunk_rows, n_rows - row0);
+    // Remove the padding of the dataset rows
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(data_buf[b]->data_handle(),
+                                    sizeof(T) * dim,
+                                    dataset.data_handle() + row0 * dataset.stride(0),
+                                    sizeof(T) * dataset.stride(0),
+                                    sizeof(T) * dim,
+                                    rows,
+                                    cudaMemcpyDefault,
+                                    stream));
+    raft::copy(
+      graph_buf[b]->data_handle(), graph.data_handle() + row0 * degree, rows * degree, stream);
+    RAFT_CUDA_TRY(cudaEventRecord(copied[b], stream));
+  };
+
+  if (n_chunks > 0) { copy_chunk(0); }
+  for (int64_t c = 0; c < n_chunks; c++) {
+    // The other buffer has been written to the index in the previous step
+    if (c + 1 < n_chunks) { copy_chunk(c + 1); }
+    const int b        = c % 2;
+    const int64_t row0 = c * chunk_rows;
+    const int64_t rows = std::min(chunk_rows, n_rows - row0);
+    RAFT_CUDA_TRY(cudaEventSynchronize(copied[b]));
+    const T* data_rows     = data_buf[b]->data_handle();
+    const IdxT* graph_rows = graph_buf[b]->data_handle();
+#pragma omp parallel for
+    for (int64_t r = 0; r < rows; r++) {
+      const auto i = static_cast<hnswlib::tableint>(row0 + r);
+      auto* links  = appr->get_linklist0(i);
+      appr->setListCount(links, static_cast<unsigned short>(degree));
+      std::memcpy(links + 1, graph_rows + r * degree, sizeof(IdxT) * degree);
+      std::memcpy(appr->getDataByInternalId(i), data_rows + r * dim, sizeof(T) * dim);
+      appr->setExternalLabel(i, static_cast<hnswlib::labeltype>(i));
+    }
+  }
+  for (int b = 0; b < 2; b++) {
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(copied[b]));
+  }
+
+  appr->cur_element_count = n_rows;
+  appr->label_lookup_.reserve(n_rows);
+  for (int64_t i = 0; i < n_rows; i++) {
+    appr->label_lookup_[static_cast<hnswlib::labeltype>(i)] = static_cast<hnswlib::tableint>(i);
+  }
+
+  // The upper layers
+  for (int64_t i = 0; i < n_rows; i++) {
+    appr->element_levels_[i] = 0;
+    appr->linkLists_[i]      = nullptr;
+  }
+  if (layers.has_value()) {
+    std::vector<size_t> level_pos(layers->max_level, 0);
+    for (int64_t i = 0; i < n_rows; i++) {
+      const int level = layers->node_levels[i];
+      if (level == 0) { continue; }
+      auto* lists = static_cast<char*>(std::calloc(level, appr->size_links_per_element_));
+      RAFT_EXPECTS(lists != nullptr, "Not enough memory for the upper layers");
+      appr->element_levels_[i] = level;
+      appr->linkLists_[i]      = lists;
+      for (int l = 1; l <= level; l++) {
+        // The nodes of a level are sorted, so the next one of the level is the current element.
+        const auto r     = level_pos[l - 1]++;
+        const auto count = layers->level_counts[l - 1][r];
+        auto* links      = appr->get_linklist(static_cast<hnswlib::tableint>(i), l);
+        appr->setListCount(links, static_cast<unsigned short>(count));
+        std::memcpy(
+          links + 1, layers->level_links[l - 1].data_handle() + r * M, sizeof(IdxT) * count);
+      }
+    }
+    appr->maxlevel_        = layers->max_level;
+    appr->enterpoint_node_ = static_cast<hnswlib::tableint>(layers->entrypoint);
+  } else {
+    appr->maxlevel_        = 0;
+    appr->enterpoint_node_ = static_cast<hnswlib::tableint>(n_rows / 2);
+  }
+  appr->base_layer_only = appr->element_levels_[appr->enterpoint_node_] == 0;
+  return hnsw_index;
+}
+
+}  // namespace raft::neighbors::hnsw::detail
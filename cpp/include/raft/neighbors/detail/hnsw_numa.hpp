@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+
+#include <hnswlib/hnswlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace raft::neighbors::hnsw::detail {
+
+/** A NUMA node of the host and its CPUs. */
+struct numa_node {
+  int id;
+  cpu_set_t cpus;
+};
+
+/**
+ * The NUMA nodes of the host that have CPUs, as listed in `/sys/devices/system/node`.
+ * Empty if the information is not available.
+ */
+inline auto get_numa_nodes() -> std::vector<numa_node>
+{
+  namespace fs = std::filesystem;
+  std::vector<numa_node> nodes;
+  std::error_code ec;
+  for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+    const auto name = entry.path().filename().string();
+    if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos) {
+      continue;
+    }
+    std::ifstream file(entry.path() / "cpulist");
+    std::string cpulist;
+    if (!std::getline(file, cpulist)) { continue; }
+
+    // The ranges of the CPUs, e.g. "0-15,32-47"
+    numa_node node{std::stoi(name.substr(4)), {}};
+    CPU_ZERO(&node.cpus);
+    std::stringstream ranges(cpulist);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+      if (range.empty()) { continue; }
+      const auto dash = range.find('-');
+      const int first = std::stoi(range.substr(0, dash));
+      const int last  = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+        CPU_SET(cpu, &node.cpus);
+      }
+    }
+    if (CPU_COUNT(&node.cpus) > 0) { nodes.push_back(node); }
+  }
+  std::sort(nodes.begin(), nodes.end(), [](const numa_node& a, const numa_node& b) {
+    return a.id < b.id;
+  });
+  return nodes;
+}
+
+/**
+ * Pin the calling thread to the given CPUs.
+ *
+ * @param[in] cpus the CPUs to run on
+ * @param[out] previous if not null, the CPUs the thread was allowed to run on before the call
+ * @return whether the affinity was changed
+ */
+inline auto pin_this_thread(const cpu_set_t& cpus, cpu_set_t* previous = nullptr) -> bool
+{
+  if (previous != nullptr &&
+      pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), previous) != 0) {
+    return false;
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus) == 0;
+}
+
+/**
+ * Copy an hnswlib index into the memory of a NUMA node.
+ *
+ * The copy is made by a thread pinned to the node, so that its pages are first touched, hence
+ * allocated, on the node. The replica shares the space of the source index.
+ */
+template <typename dist_t>
+auto replicate_on_numa_node(const hnswlib::HierarchicalNSW<dist_t>& src,
+                            hnswlib::SpaceInterface<dist_t>* space,
+                            const numa_node& node)
+  -> std::unique_ptr<hnswlib::HierarchicalNSW<dist_t>>
+{
+  std::unique_ptr<hnswlib::HierarchicalNSW<dist_t>> dst;
+  std::exception_ptr error;
+  std::thread worker([&]() {
+    try {
+      pin_this_thread(node.cpus);
+      dst = std::make_unique<hnswlib::HierarchicalNSW<dist_t>>(
+        space, src.max_elements_, src.M_, src.ef_construction_);
+
+      // The layout of the base layer is taken from the source, whose degree may differ from 2 * M
+      // if it was loaded from a file.
+      std::free(dst->data_level0_memory_);
+      dst->maxM_                   = src.maxM_;
+      dst->maxM0_                  = src.maxM0_;
+      dst->mult_                   = src.mult_;
+      dst->size_links_level0_      = src.size_links_level0_;
+      dst->size_data_per_element_  = src.size_data_per_element_;
+      dst->size_links_per_element_ = src.size_links_per_element_;
+      dst->offsetData_             = src.offsetData_;
+      dst->offsetLevel0_           = src.offsetLevel0_;
+      dst->label_offset_           = src.label_offset_;
+      dst->data_level0_memory_ =
+        static_cast<char*>(std::malloc(src.max_elements_ * src.size_data_per_element_));
+      RAFT_EXPECTS(dst->data_level0_memory_ != nullptr, "Not enough memory for the replica");
+      std::memcpy(dst->data_level0_memory_,
+                  src.data_level0_memory_,
+                  src.cur_element_count * src.size_data_per_element_);
+
+      dst->element_levels_ = src.element_levels_;
+      for (size_t i = 0; i < src.cur_element_count; i++) {
+        const int level = src.element_levels_[i];
+        if (level == 0) { continue; }
+        dst->linkLists_[i] = static_cast<char*>(std::malloc(src.size_links_per_element_ * level));
+        RAFT_EXPECTS(dst->linkLists_[i] != nullptr, "Not enough memory for the replica");
+        std::memcpy(dst->linkLists_[i], src.linkLists_[i], src.size_links_per_element_ * level);
+      }
+      dst->cur_element_count = src.cur_element_count;
+      dst->maxlevel_         = src.maxlevel_;
+      dst->enterpoint_node_  = src.enterpoint_node_;
+      dst->label_lookup_     = src.label_lookup_;
+      dst->base_layer_only   = src.base_layer_only;
+      dst->num_seeds         = src.num_seeds;
+      dst->ef_               = src.ef_;
+    } catch (...) {
+      error = std::current_exception();
+    }
+  });
+  worker.join();
+  if (error) { std::rethrow_exception(error); }
+  return dst;
+}
+
+}  // namespace raft::neighbors::hnsw::detail
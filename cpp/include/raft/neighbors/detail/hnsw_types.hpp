@@ -17,6 +17,7 @@
 #pragma once
 
 #include "../hnsw_types.hpp"
+#include "hnsw_numa.hpp"
 
 #include <raft/core/error.hpp>
 #include <raft/distance/distance_types.hpp>
@@ -26,7 +27,9 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <type_traits>
+#include <vector>
 
 namespace raft::neighbors::hnsw::detail {
 
@@ -59,33 +62,45 @@ template <typename T>
 struct index_impl : index<T> {
  public:
   /**
-   * @brief load a base-layer-only hnswlib index originally saved from a built CAGRA index
+   * @brief load an hnswlib index originally saved from a built CAGRA index, with or without the
+   * upper layers
    *
    * @param[in] filepath path to the index
    * @param[in] dim dimensions of the training dataset
    * @param[in] metric distance metric to search. Supported metrics ("L2Expanded", "InnerProduct")
    */
   index_impl(std::string filepath, int dim, raft::distance::DistanceType metric)
-    : index<T>{dim, metric}
+    : index<T>{dim, metric}, space_{make_space(dim, metric)}
   {
-    if constexpr (std::is_same_v<T, float>) {
-      if (metric == raft::distance::L2Expanded) {
-        space_ = std::make_unique<hnswlib::L2Space>(dim);
-      } else if (metric == raft::distance::InnerProduct) {
-        space_ = std::make_unique<hnswlib::InnerProductSpace>(dim);
-      }
-    } else if constexpr (std::is_same_v<T, std::int8_t> or std::is_same_v<T, std::uint8_t>) {
-      if (metric == raft::distance::L2Expanded) {
-        space_ = std::make_unique<hnswlib::L2SpaceI<T>>(dim);
-      }
-    }
+    appr_alg_ = std::make_unique<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type>>(
+      space_.get(), filepath);
 
-    RAFT_EXPECTS(space_ != nullptr, "Unsupported metric type was used");
+    // The indices exported without the upper layers are searched from the seeds of the base layer
+    appr_alg_->base_layer_only = appr_alg_->cur_element_count == 0 ||
+                                 appr_alg_->element_levels_[appr_alg_->enterpoint_node_] == 0;
+  }
 
+  /**
+   * @brief create an empty hnswlib index, to be filled in place from a CAGRA index
+   *
+   * @param[in] dim dimensions of the training dataset
+   * @param[in] metric distance metric to search. Supported metrics ("L2Expanded", "InnerProduct")
+   * @param[in] max_elements the capacity of the index
+   * @param[in] M the degree of the upper layers; the base layer has the degree 2 * M
+   */
+  index_impl(int dim, raft::distance::DistanceType metric, size_t max_elements, size_t M)
+    : index<T>{dim, metric}, space_{make_space(dim, metric)}
+  {
     appr_alg_ = std::make_unique<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type>>(
-      space_.get(), filepath);
+      space_.get(), max_elements, M);
+  }
 
-    appr_alg_->base_layer_only = true;
+  /**
+  @brief Get the mutable hnswlib index
+  */
+  auto get_hnswlib_index() -> hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type>*
+  {
+    return appr_alg_.get();
   }
 
   /**
@@ -98,9 +113,55 @@ struct index_impl : index<T> {
   */
   void set_ef(int ef) const override { appr_alg_->ef_ = ef; }
 
+  /**
+  @brief Get the copies of the hnswlib index local to the given NUMA nodes, one per node
+
+  The copies are created on the first call and reused by the following ones.
+  */
+  auto get_numa_replicas(const std::vector<numa_node>& nodes) const
+    -> std::vector<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type> const*>
+  {
+    std::lock_guard<std::mutex> guard(numa_replicas_mutex_);
+    if (numa_replicas_.size() != nodes.size()) {
+      numa_replicas_.clear();
+      for (const auto& node : nodes) {
+        numa_replicas_.push_back(replicate_on_numa_node(*appr_alg_, space_.get(), node));
+      }
+    }
+    std::vector<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type> const*> replicas;
+    for (auto& replica : numa_replicas_) {
+      replica->ef_ = appr_alg_->ef_;
+      replicas.push_back(replica.get());
+    }
+    return replicas;
+  }
+
  private:
-  std::unique_ptr<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type>> appr_alg_;
   std::unique_ptr<hnswlib::SpaceInterface<typename hnsw_dist_t<T>::type>> space_;
+  std::unique_ptr<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type>> appr_alg_;
+  mutable std::vector<std::unique_ptr<hnswlib::HierarchicalNSW<typename hnsw_dist_t<T>::type>>>
+    numa_replicas_;
+  mutable std::mutex numa_replicas_mutex_;
+
+  static auto make_space(int dim, raft::distance::DistanceType metric)
+    -> std::unique_ptr<hnswlib::SpaceInterface<typename hnsw_dist_t<T>::type>>
+  {
+    std::unique_ptr<hnswlib::SpaceInterface<typename hnsw_dist_t<T>::type>> space;
+    if constexpr (std::is_same_v<T, float>) {
+      if (metric == raft::distance::L2Expanded) {
+        space = std::make_unique<hnswlib::L2Space>(dim);
+      } else if (metric == raft::distance::InnerProduct) {
+        space = std::make_unique<hnswlib::InnerProductSpace>(dim);
+      }
+    } else if constexpr (std::is_same_v<T, std::int8_t> or std::is_same_v<T, std::uint8_t>) {
+      if (metric == raft::distance::L2Expanded) {
+        space = std::make_unique<hnswlib::L2SpaceI<T>>(dim);
+      }
+    }
+
+    RAFT_EXPECTS(space != nullptr, "Unsupported metric type was used");
+    return space;
+  }
 };
 
 /**@}*/
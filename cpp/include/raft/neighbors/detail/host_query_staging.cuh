@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace raft::neighbors::detail {
+
+/** The size of the pinned buffers of a batch of queries and their results. */
+constexpr uint64_t kQueryStagingBytes = 32 * 1024 * 1024;
+
+/**
+ * Search host-resident queries and write the results to host memory, by batches staged through
+ * pinned buffers.
+ *
+ * Every batch goes through two slots of pinned and device buffers, so that the copy of the next
+ * batch to the device and the copy of the results of the previous one to the host (on a stream of
+ * the stream pool, if any) run while the current batch is being searched on the main stream.
+ * With the pageable user memory, a plain `raft::copy` would instead block until the whole copy is
+ * done, and would not overlap with the search.
+ *
+ * @param[in] res the raft resources
+ * @param[in] queries a host row-major matrix [n_queries, dim]
+ * @param[out] neighbors a host row-major matrix [n_queries, k]
+ * @param[out] distances a host row-major matrix [n_queries, k]
+ * @param[in] search `search(const T* queries, IdxT* neighbors, DistT* distances, n_rows)` searches
+ *   a batch of `n_rows` device-resident queries on the main stream of `res`
+ */
+template <typename T, typename IdxT, typename DistT, typename MatIdxT, typename SearchF>
+void search_host_queries(raft::resources const& res,
+                         raft::host_matrix_view<const T, MatIdxT, row_major> queries,
+                         raft::host_matrix_view<IdxT, MatIdxT, row_major> neighbors,
+                         raft::host_matrix_view<DistT, MatIdxT, row_major> distances,
+                         SearchF&& search)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("search_host_queries");
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  const uint64_t n_queries = queries.extent(0);
+  const uint64_t dim       = queries.extent(1);
+  const uint64_t k         = neighbors.extent(1);
+  if (n_queries == 0) { return; }
+
+  auto stream      = resource::get_cuda_stream(res);
+  auto copy_stream = resource::get_next_usable_stream(res);
+  auto device_mr   = resource::get_workspace_resource(res);
+  auto pinned_mr   = resource::get_pinned_workspace_resource(res);
+
+  const uint64_t q_row   = dim * sizeof(T);
+  const uint64_t res_row = k * (sizeof(IdxT) + sizeof(DistT));
+  const uint64_t batch   = std::clamp<uint64_t>(
+    std::min<uint64_t>(kQueryStagingBytes, resource::get_pinned_workspace_free_bytes(res) / 4) /
+      std::max<uint64_t>(q_row + res_row, 1),
+    1,
+    n_queries);
+  const uint64_t n_batches = raft::div_rounding_up_safe(n_queries, batch);
+
+  struct slot_t {
+    rmm::device_uvector<T> queries;
+    rmm::device_uvector<IdxT> neighbors;
+    rmm::device_uvector<DistT> distances;
+    rmm::device_uvector<T> queries_h;
+    rmm::device_uvector<IdxT> neighbors_h;
+    rmm::device_uvector<DistT> distances_h;
+  };
+  auto make_slot = [&]() {
+    return slot_t{rmm::device_uvector<T>(batch * dim, stream, device_mr),
+                  rmm::device_uvector<IdxT>(batch * k, stream, device_mr),
+                  rmm::device_uvector<DistT>(batch * k, stream, device_mr),
+                  rmm::device_uvector<T>(batch * dim, stream, pinned_mr),
+                  rmm::device_uvector<IdxT>(batch * k, stream, pinned_mr),
+                  rmm::device_uvector<DistT>(batch * k, stream, pinned_mr)};
+  };
+  std::array<slot_t, 2> slots{make_slot(), make_slot()};
+
+  using event_ptr =
+    std::unique_ptr<std::remove_pointer_t<cudaEvent_t>, cudaError_t (*)(cudaEvent_t)>;
+  auto make_event = [stream]() {
+    cudaEvent_t e;
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&e, cudaEventDisableTiming));
+    // Recorded once, so that the first waits of every slot return immediately.
+    RAFT_CUDA_TRY(cudaEventRecord(e, stream));
+    return event_ptr{e, cudaEventDestroy};
+  };
+  // loaded: the queries are on the device; searched: the search is done; stored: the results are
+  // in the pinned buffers.
+  std::array<event_ptr, 2> loaded{make_event(), make_event()};
+  std::array<event_ptr, 2> searched{make_event(), make_event()};
+  std::array<event_ptr, 2> stored{make_event(), make_event()};
+  // The buffers are used on the copy stream, and the pinned ones on the host.
+  resource::sync_stream(res);
+
+  auto rows = [&](uint64_t b) { return std::min(batch, n_queries - b * batch); };
+  auto load = [&](uint64_t b) {
+    auto& slot = slots[b % 2];
+    // The pinned buffer was read by the copy of the batch b - 2, and the device buffer by its
+    // search.
+    RAFT_CUDA_TRY(cudaEventSynchronize(loaded[b % 2].get()));
+    std::memcpy(slot.queries_h.data(), queries.data_handle() + b * batch * dim, rows(b) * q_row);
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(copy_stream, searched[b % 2].get()));
+    raft::copy(slot.queries.data(), slot.queries_h.data(), rows(b) * dim, copy_stream);
+    RAFT_CUDA_TRY(cudaEventRecord(loaded[b % 2].get(), copy_stream));
+  };
+  auto store = [&](uint64_t b) {
+    auto& slot = slots[b % 2];
+    RAFT_CUDA_TRY(cudaEventSynchronize(stored[b % 2].get()));
+    std::memcpy(neighbors.data_handle() + b * batch * k,
+                slot.neighbors_h.data(),
+                rows(b) * k * sizeof(IdxT));
+    std::memcpy(distances.data_handle() + b * batch * k,
+                slot.distances_h.data(),
+                rows(b) * k * sizeof(DistT));
+  };
+
+  load(0);
+  for (uint64_t b = 0; b < n_batches; b++) {
+    auto& slot = slots[b % 2];
+    // The device results of the batch b - 2 have been copied to the host before `store(b - 2)`.
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, loaded[b % 2].get()));
+    search(slot.queries.data(), slot.neighbors.data(), slot.distances.data(), MatIdxT(rows(b)));
+    RAFT_CUDA_TRY(cudaEventRecord(searched[b % 2].get(), stream));
+    // The next batch is queued on the copy stream before the results of this one, which wait for
+    // the search.
+    if (b + 1 < n_batches) { load(b + 1); }
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(copy_stream, searched[b % 2].get()));
+    raft::copy(slot.neighbors_h.data(), slot.neighbors.data(), rows(b) * k, copy_stream);
+    raft::copy(slot.distances_h.data(), slot.distances.data(), rows(b) * k, copy_stream);
+    RAFT_CUDA_TRY(cudaEventRecord(stored[b % 2].get(), copy_stream));
+    if (b > 0) { store(b - 1); }
+  }
+  store(n_batches - 1);
+  // The buffers are released on the main stream.
+  RAFT_CUDA_TRY(cudaStreamSynchronize(copy_stream));
+}
+
+}  // namespace raft::neighbors::detail
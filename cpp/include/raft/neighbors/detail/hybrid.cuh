@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_event.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/device_properties.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/matrix/detail/select_warpsort.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/neighbors/detail/refine_device.cuh>
+#include <raft/neighbors/hybrid_types.hpp>
+#include <raft/sparse/neighbors/brute_force.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/cuda_stream.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+namespace raft::neighbors::hybrid::detail {
+
+constexpr uint32_t kFuseThreads = 256;
+
+/** Whether a candidate id refers to a row of the dataset (the searches mark the missing ones). */
+template <typename T>
+_RAFT_HOST_DEVICE inline auto is_valid_id(T id, int64_t n_rows) -> bool
+{
+  return static_cast<uint64_t>(id) < static_cast<uint64_t>(n_rows);
+}
+
+/** The per-list parameters of the fusion of a query. */
+struct fusion_list {
+  float weight;
+  // the best and the worst similarities of the list (weighted fusion only)
+  float max_sim;
+  float min_sim;
+};
+
+_RAFT_DEVICE inline auto fused_component(
+  fusion_method method, float rrf_constant, const fusion_list& list, uint32_t rank, float sim)
+  -> float
+{
+  if (method == fusion_method::kRRF) { return list.weight / (rrf_constant + rank + 1); }
+  const float range = list.max_sim - list.min_sim;
+  return list.weight * (range > 0 ? (sim - list.min_sim) / range : 1.0f);
+}
+
+/** The concatenation of the sparse and the dense candidates of every query. */
+template <typename SparseIdxT, typename IdxT>
+RAFT_KERNEL union_kernel(const SparseIdxT* sparse_ids,  // [n_queries, n_sparse]
+                         uint32_t n_sparse,
+                         const IdxT* dense_ids,  // [n_queries, n_dense]
+                         uint32_t n_dense,
+                         int64_t n_queries,
+                         IdxT* out_ids)  // [n_queries, n_sparse + n_dense]
+{
+  const uint32_t n = n_sparse + n_dense;
+  for (int64_t i = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; i < n_queries * n;
+       i += int64_t(blockDim.x) * gridDim.x) {
+    const int64_t q  = i / n;
+    const uint32_t j = i % n;
+    out_ids[i]       = j < n_sparse ? static_cast<IdxT>(sparse_ids[q * n_sparse + j])
+                                    : dense_ids[q * n_dense + j - n_sparse];
+  }
+}
+
+/**
+ * The fused scores of the candidates of a query (one block per query).
+ *
+ * The candidates of both lists are sorted best first. An entry is dropped if its id is not a row
+ * of the dataset or repeats an earlier entry of its list; the rank of an entry counts the kept
+ * entries before it. A candidate found in both lists is output once, at its sparse position, with
+ * both components of its score; the dropped positions get the lowest score.
+ */
+template <typename SparseIdxT, typename IdxT>
+RAFT_KERNEL fuse_kernel(const SparseIdxT* sparse_ids,  // [n_queries, n_sparse]
+                        const float* sparse_distances,  // [n_queries, n_sparse]
+                        uint32_t n_sparse,
+                        float sparse_sign,
+                        const IdxT* dense_ids,  // [n_queries, n_dense]
+                        const float* dense_distances,  // [n_queries, n_dense]
+                        uint32_t n_dense,
+                        float dense_sign,
+                        int64_t n_rows,
+                        fusion_method method,
+                        float rrf_constant,
+                        float sparse_weight,
+                        float dense_weight,
+                        IdxT* out_ids,  // [n_queries, n_sparse + n_dense]
+                        float* out_scores)  // [n_queries, n_sparse + n_dense]
+{
+  constexpr IdxT kInvalid = std::numeric_limits<IdxT>::max();
+  extern __shared__ __align__(16) uint8_t fuse_smem[];
+  __shared__ fusion_list lists[2];
+  const uint32_t n = n_sparse + n_dense;
+  const int64_t q  = blockIdx.x;
+  auto* ids        = reinterpret_cast<IdxT*>(fuse_smem);
+  auto* sims       = reinterpret_cast<float*>(ids + n);
+  auto* ranks      = reinterpret_cast<uint32_t*>(sims + n);
+  auto* valid      = reinterpret_cast<uint8_t*>(ranks + n);
+
+  // The similarities are the distances negated when the smaller distances are better.
+  for (uint32_t i = threadIdx.x; i < n; i += blockDim.x) {
+    if (i < n_sparse) {
+      const auto id = sparse_ids[q * n_sparse + i];
+      ids[i]        = is_valid_id(id, n_rows) ? static_cast<IdxT>(id) : kInvalid;
+      sims[i]       = sparse_sign * sparse_distances[q * n_sparse + i];
+    } else {
+      const auto id = dense_ids[q * n_dense + i - n_sparse];
+      ids[i]        = is_valid_id(id, n_rows) ? id : kInvalid;
+      sims[i]       = dense_sign * dense_distances[q * n_dense + i - n_sparse];
+    }
+  }
+  __syncthreads();
+  for (uint32_t i = threadIdx.x; i < n; i += blockDim.x) {
+    bool keep = ids[i] != kInvalid;
+    for (uint32_t j = i < n_sparse ? 0 : n_sparse; keep && j < i; j++) {
+      keep = ids[j] != ids[i];
+    }
+    valid[i] = keep;
+  }
+  __syncthreads();
+  for (uint32_t i = threadIdx.x; i < n; i += blockDim.x) {
+    uint32_t rank = 0;
+    for (uint32_t j = i < n_sparse ? 0 : n_sparse; j < i; j++) {
+      rank += valid[j];
+    }
+    ranks[i] = rank;
+  }
+  if (threadIdx.x < 2) {
+    const bool sparse   = threadIdx.x == 0;
+    const uint32_t from = sparse ? 0 : n_sparse;
+    const uint32_t to   = sparse ? n_sparse : n;
+    fusion_list list{sparse ? sparse_weight : dense_weight,
+                     raft::lower_bound<float>(),
+                     raft::upper_bound<float>()};
+    for (uint32_t j = from; j < to; j++) {
+      if (valid[j]) {
+        list.max_sim = max(list.max_sim, sims[j]);
+        list.min_sim = min(list.min_sim, sims[j]);
+      }
+    }
+    lists[threadIdx.x] = list;
+  }
+  __syncthreads();
+
+  for (uint32_t i = threadIdx.x; i < n; i += blockDim.x) {
+    IdxT id     = kInvalid;
+    float score = raft::lower_bound<float>();
+    if (valid[i]) {
+      const bool sparse = i < n_sparse;
+      // The same candidate in the other list
+      const uint32_t from = sparse ? n_sparse : 0;
+      const uint32_t to   = sparse ? n : n_sparse;
+      uint32_t match      = to;
+      for (uint32_t j = from; j < to; j++) {
+        if (valid[j] && ids[j] == ids[i]) {
+          match = j;
+          break;
+        }
+      }
+      if (sparse || match == to) {
+        id    = ids[i];
+        score = fused_component(method, rrf_constant, lists[sparse ? 0 : 1], ranks[i], sims[i]);
+        if (match != to) {
+          score += fused_component(method, rrf_constant, lists[1], ranks[match], sims[match]);
+        }
+      }
+    }
+    out_ids[q * n + i]    = id;
+    out_scores[q * n + i] = score;
+  }
+}
+
+/** The shared memory used by `fuse_kernel`. */
+template <typename IdxT>
+auto fuse_smem_size(uint32_t n_candidates) -> size_t
+{
+  return size_t(n_candidates) * (sizeof(IdxT) + sizeof(float) + sizeof(uint32_t) + 1);
+}
+
+template <typename T, typename IdxT, typename SparseIdxT, typename DenseSearchFn>
+void search(raft::resources const& res,
+            const search_params& params,
+            raft::device_csr_matrix_view<const float, SparseIdxT, SparseIdxT, SparseIdxT>
+              sparse_index,
+            raft::device_csr_matrix_view<const float, SparseIdxT, SparseIdxT, SparseIdxT>
+              sparse_queries,
+            raft::device_matrix_view<const T, int64_t, row_major> dense_queries,
+            DenseSearchFn&& dense_search,
+            raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::device_matrix_view<float, int64_t, row_major> scores,
+            std::optional<raft::device_matrix_view<const T, int64_t, row_major>> dense_dataset)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "hybrid::search(n_queries = %zu)", size_t(dense_queries.extent(0)));
+  auto index_structure = sparse_index.structure_view();
+  auto query_structure = sparse_queries.structure_view();
+  const int64_t n_rows    = index_structure.get_n_rows();
+  const int64_t n_queries = dense_queries.extent(0);
+  const int64_t k         = neighbors.extent(1);
+  const uint32_t n_sparse = params.n_sparse_candidates;
+  const uint32_t n_dense  = params.n_dense_candidates;
+  RAFT_EXPECTS(int64_t(query_structure.get_n_rows()) == n_queries,
+               "The sparse and the dense queries must have the same number of rows");
+  RAFT_EXPECTS(query_structure.get_n_cols() == index_structure.get_n_cols(),
+               "The sparse queries and index must have the same number of columns");
+  RAFT_EXPECTS(neighbors.extent(0) == n_queries && scores.extent(0) == n_queries &&
+                 scores.extent(1) == k,
+               "Wrong shape of the output");
+  RAFT_EXPECTS(n_sparse > 0 && int64_t(n_sparse) <= n_rows && n_dense > 0,
+               "The number of the sparse candidates must be within [1, n_rows], and the number "
+               "of the dense candidates must be positive");
+  RAFT_EXPECTS(k <= int64_t(n_sparse) + n_dense, "k must not exceed the number of the candidates");
+  if (dense_dataset.has_value()) {
+    RAFT_EXPECTS(dense_dataset->extent(0) == n_rows, "The dense and sparse datasets must match");
+    RAFT_EXPECTS(dense_dataset->extent(1) == dense_queries.extent(1),
+                 "Wrong dimensionality of the dense queries");
+    RAFT_EXPECTS(n_sparse + n_dense <= raft::matrix::detail::select::warpsort::kMaxCapacity,
+                 "The refined candidates must not exceed %d per query",
+                 raft::matrix::detail::select::warpsort::kMaxCapacity);
+  }
+  if (n_queries == 0) { return; }
+
+  auto stream           = resource::get_cuda_stream(res);
+  auto sparse_neighbors = raft::make_device_matrix<SparseIdxT, int64_t>(res, n_queries, n_sparse);
+  auto sparse_distances = raft::make_device_matrix<float, int64_t>(res, n_queries, n_sparse);
+  auto dense_neighbors  = raft::make_device_matrix<IdxT, int64_t>(res, n_queries, n_dense);
+  auto dense_distances  = raft::make_device_matrix<float, int64_t>(res, n_queries, n_dense);
+
+  // The sparse search runs on a side stream (one of the pool if any, or its own otherwise),
+  // concurrently with the dense search on the main stream.
+  raft::resources sparse_res(res);
+  std::optional<rmm::cuda_stream> own_stream;
+  if (resource::is_stream_pool_initialized(res)) {
+    resource::set_cuda_stream(sparse_res, resource::get_stream_from_stream_pool(res));
+  } else {
+    own_stream.emplace();
+    resource::set_cuda_stream(sparse_res, own_stream->view());
+  }
+  resource::set_cuda_stream_pool(sparse_res, nullptr);
+  auto sparse_stream = resource::get_cuda_stream(sparse_res);
+  sparse_res.add_resource_factory(
+    std::make_shared<resource::thrust_policy_resource_factory>(sparse_stream));
+  resource::cuda_event_resource inputs_ready;
+  resource::cuda_event_resource sparse_done;
+  auto event = [](resource::cuda_event_resource& e) {
+    return *static_cast<cudaEvent_t*>(e.get_resource());
+  };
+
+  // The side stream reads the queries and the buffers allocated on the main stream.
+  RAFT_CUDA_TRY(cudaEventRecord(event(inputs_ready), stream));
+  RAFT_CUDA_TRY(cudaStreamWaitEvent(sparse_stream, event(inputs_ready)));
+  raft::sparse::neighbors::brute_force::knn<SparseIdxT, float>(
+    index_structure.get_indptr().data(),
+    index_structure.get_indices().data(),
+    sparse_index.get_elements().data(),
+    index_structure.get_nnz(),
+    index_structure.get_n_rows(),
+    index_structure.get_n_cols(),
+    query_structure.get_indptr().data(),
+    query_structure.get_indices().data(),
+    sparse_queries.get_elements().data(),
+    query_structure.get_nnz(),
+    query_structure.get_n_rows(),
+    query_structure.get_n_cols(),
+    sparse_neighbors.data_handle(),
+    sparse_distances.data_handle(),
+    n_sparse,
+    sparse_res,
+    2 << 14,
+    2 << 14,
+    params.sparse_metric);
+  RAFT_CUDA_TRY(cudaEventRecord(event(sparse_done), sparse_stream));
+
+  dense_search(res, dense_queries, dense_neighbors.view(), dense_distances.view());
+  RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, event(sparse_done)));
+
+  // With the dataset, the union of the candidates is re-ranked by the exact dense distances, so
+  // the dense list also scores the candidates found by the sparse search only.
+  const IdxT* fused_dense_ids        = dense_neighbors.data_handle();
+  const float* fused_dense_distances = dense_distances.data_handle();
+  uint32_t n_fused_dense             = n_dense;
+  std::optional<raft::device_matrix<IdxT, int64_t, row_major>> refined_neighbors;
+  std::optional<raft::device_matrix<float, int64_t, row_major>> refined_distances;
+  if (dense_dataset.has_value()) {
+    const uint32_t n_union = n_sparse + n_dense;
+    auto candidates        = raft::make_device_matrix<IdxT, int64_t>(res, n_queries, n_union);
+    const int64_t n_blocks = std::min<int64_t>(raft::ceildiv<int64_t>(n_queries * n_union, 256),
+                                               int64_t(std::numeric_limits<int32_t>::max()));
+    union_kernel<<<n_blocks, 256, 0, stream>>>(sparse_neighbors.data_handle(),
+                                               n_sparse,
+                                               dense_neighbors.data_handle(),
+                                               n_dense,
+                                               n_queries,
+                                               candidates.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    refined_neighbors.emplace(raft::make_device_matrix<IdxT, int64_t>(res, n_queries, n_union));
+    refined_distances.emplace(raft::make_device_matrix<float, int64_t>(res, n_queries, n_union));
+    raft::neighbors::detail::refine_device<IdxT, T, float, int64_t>(
+      res,
+      *dense_dataset,
+      dense_queries,
+      raft::make_const_mdspan(candidates.view()),
+      refined_neighbors->view(),
+      refined_distances->view(),
+      params.dense_metric);
+    fused_dense_ids       = refined_neighbors->data_handle();
+    fused_dense_distances = refined_distances->data_handle();
+    n_fused_dense         = n_union;
+  }
+
+  const uint32_t n_fused = n_sparse + n_fused_dense;
+  const size_t smem_size = fuse_smem_size<IdxT>(n_fused);
+  RAFT_EXPECTS(smem_size <= resource::get_device_properties(res).sharedMemPerBlock,
+               "Too many candidates per query (%u)",
+               n_fused);
+  auto fused_ids    = raft::make_device_matrix<IdxT, int64_t>(res, n_queries, n_fused);
+  auto fused_scores = raft::make_device_matrix<float, int64_t>(res, n_queries, n_fused);
+  auto sign         = [](raft::distance::DistanceType metric) {
+    return raft::distance::is_min_close(metric) ? -1.0f : 1.0f;
+  };
+  fuse_kernel<<<n_queries, kFuseThreads, smem_size, stream>>>(sparse_neighbors.data_handle(),
+                                                              sparse_distances.data_handle(),
+                                                              n_sparse,
+                                                              sign(params.sparse_metric),
+                                                              fused_dense_ids,
+                                                              fused_dense_distances,
+                                                              n_fused_dense,
+                                                              sign(params.dense_metric),
+                                                              n_rows,
+                                                              params.fusion,
+                                                              params.rrf_constant,
+                                                              params.sparse_weight,
+                                                              params.dense_weight,
+                                                              fused_ids.data_handle(),
+                                                              fused_scores.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  raft::matrix::select_k<float, IdxT>(res,
+                                      raft::make_const_mdspan(fused_scores.view()),
+                                      raft::make_const_mdspan(fused_ids.view()),
+                                      scores,
+                                      neighbors,
+                                      false,
+                                      true);
+}
+
+}  // namespace raft::neighbors::hybrid::detail
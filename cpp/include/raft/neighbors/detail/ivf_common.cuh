@@ -18,9 +18,13 @@
 
 #include <raft/linalg/unary_op.cuh>
 #include <raft/matrix/detail/select_warpsort.cuh>  // matrix::detail::select::warpsort::warp_sort_distributed
+#include <raft/neighbors/ivf_list_types.hpp>  // raft::neighbors::ivf::adaptive_probing
+#include <raft/util/integer_utils.hpp>
 
 #include <cub/cub.cuh>
 
+#include <limits>
+
 namespace raft::neighbors::ivf::detail {
 
 /**
@@ -43,6 +47,8 @@ struct dummy_block_sort_t {
  * For each query, we calculate a cumulative sum of the cluster sizes that we probe, and return that
  * in chunk_indices. Essentially this is a segmented inclusive scan of the cluster sizes. The total
  * number of samples per query (sum of the cluster sizes that we probe) is returned in n_samples.
+ *
+ * If `n_probes_per_query` is given, the probes past the per-query count get empty chunks.
  */
 template <int BlockDim>
 __launch_bounds__(BlockDim) RAFT_KERNEL
@@ -50,7 +56,8 @@ __launch_bounds__(BlockDim) RAFT_KERNEL
                             const uint32_t* cluster_sizes,      // [n_clusters]
                             const uint32_t* clusters_to_probe,  // [n_queries, n_probes]
                             uint32_t* chunk_indices,            // [n_queries, n_probes]
-                            uint32_t* n_samples                 // [n_queries]
+                            uint32_t* n_samples,                // [n_queries]
+                            const uint32_t* n_probes_per_query  // [n_queries] or nullptr
   )
 {
   using block_scan = cub::BlockScan<uint32_t, BlockDim>;
@@ -59,13 +66,15 @@ __launch_bounds__(BlockDim) RAFT_KERNEL
   // locate the query data
   clusters_to_probe += n_probes * blockIdx.x;
   chunk_indices += n_probes * blockIdx.x;
+  const uint32_t n_query_probes =
+    n_probes_per_query == nullptr ? n_probes : min(n_probes, n_probes_per_query[blockIdx.x]);
 
   // block scan
   const uint32_t n_probes_aligned = Pow2<BlockDim>::roundUp(n_probes);
   uint32_t total                  = 0;
   for (uint32_t probe_ix = threadIdx.x; probe_ix < n_probes_aligned; probe_ix += BlockDim) {
-    auto label = probe_ix < n_probes ? clusters_to_probe[probe_ix] : 0u;
-    auto chunk = probe_ix < n_probes ? cluster_sizes[label] : 0u;
+    auto label = probe_ix < n_query_probes ? clusters_to_probe[probe_ix] : 0u;
+    auto chunk = probe_ix < n_query_probes ? cluster_sizes[label] : 0u;
     if (threadIdx.x == 0) { chunk += total; }
     block_scan(shm).InclusiveSum(chunk, chunk, total);
     __syncthreads();
@@ -87,10 +96,16 @@ struct calc_chunk_indices {
                            const uint32_t* clusters_to_probe,
                            uint32_t* chunk_indices,
                            uint32_t* n_samples,
-                           rmm::cuda_stream_view stream)
+                           rmm::cuda_stream_view stream,
+                           const uint32_t* n_probes_per_query = nullptr)
     {
       void* args[] =  // NOLINT
-        {&n_probes, &cluster_sizes, &clusters_to_probe, &chunk_indices, &n_samples};
+        {&n_probes,
+         &cluster_sizes,
+         &clusters_to_probe,
+         &chunk_indices,
+         &n_samples,
+         &n_probes_per_query};
       RAFT_CUDA_TRY(cudaLaunchKernel(kernel, grid_dim, block_dim, args, 0, stream));
     }
   };
@@ -114,6 +129,77 @@ struct calc_chunk_indices {
   }
 };
 
+/**
+ * Count the clusters to probe for every query, as limited by `params` (see
+ * `ivf::adaptive_probing`); one thread per query.
+ *
+ * NB: the clusters of every query must be sorted by their distance, the closest one first.
+ * The optional `query_norms` are added to the coarse distances, if they lack the query norms.
+ */
+RAFT_KERNEL calc_adaptive_probes_kernel(const float* cluster_dists,         // [n_queries, n_probes]
+                                        const uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                                        const uint32_t* cluster_sizes,      // [n_clusters]
+                                        const float* query_norms,           // [n_queries]
+                                        uint32_t n_queries,
+                                        uint32_t n_probes,
+                                        bool select_min,
+                                        adaptive_probing params,
+                                        uint32_t* n_probes_per_query)  // [n_queries]
+{
+  const uint32_t query_ix = blockIdx.x * blockDim.x + threadIdx.x;
+  if (query_ix >= n_queries) { return; }
+  cluster_dists += size_t(n_probes) * size_t(query_ix);
+  clusters_to_probe += size_t(n_probes) * size_t(query_ix);
+
+  const float shift   = query_norms == nullptr ? 0.0f : query_norms[query_ix];
+  const float best    = cluster_dists[0] + shift;
+  const float max_gap = params.max_distance_ratio > 1.0f
+                          ? (params.max_distance_ratio - 1.0f) * fabsf(best)
+                          : std::numeric_limits<float>::infinity();
+  uint64_t n_candidates = cluster_sizes[clusters_to_probe[0]];
+  uint32_t probe_ix     = 1;
+  for (; probe_ix < n_probes; probe_ix++) {
+    if (probe_ix >= params.min_probes) {
+      const float dist = cluster_dists[probe_ix] + shift;
+      const float gap  = select_min ? dist - best : best - dist;
+      if (gap > max_gap) { break; }
+      if (params.max_distance_gap > 0.0f && gap > params.max_distance_gap) { break; }
+      if (params.max_candidates > 0 && n_candidates >= params.max_candidates) { break; }
+    }
+    n_candidates += cluster_sizes[clusters_to_probe[probe_ix]];
+  }
+  n_probes_per_query[query_ix] = probe_ix;
+}
+
+/** See `calc_adaptive_probes_kernel`. */
+inline void calc_adaptive_probes(const adaptive_probing& params,
+                                 const float* cluster_dists,         // [n_queries, n_probes]
+                                 const uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                                 const uint32_t* cluster_sizes,      // [n_clusters]
+                                 const float* query_norms,           // [n_queries] or nullptr
+                                 uint32_t n_queries,
+                                 uint32_t n_probes,
+                                 bool select_min,
+                                 uint32_t* n_probes_per_query,  // [n_queries]
+                                 rmm::cuda_stream_view stream)
+{
+  constexpr uint32_t kBlockSize = 256;
+  if (n_queries == 0) { return; }
+  calc_adaptive_probes_kernel<<<raft::div_rounding_up_safe(n_queries, kBlockSize),
+                                kBlockSize,
+                                0,
+                                stream>>>(cluster_dists,
+                                          clusters_to_probe,
+                                          cluster_sizes,
+                                          query_norms,
+                                          n_queries,
+                                          n_probes,
+                                          select_min,
+                                          params,
+                                          n_probes_per_query);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 /**
  * Look up the chunk id corresponding to the sample index.
  *
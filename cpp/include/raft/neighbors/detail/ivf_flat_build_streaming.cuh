@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/kmeans_balanced.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/pinned_mdarray.hpp>
+#include <raft/core/resource/cuda_event.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/neighbors/detail/ivf_flat_build.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/integer_utils.hpp>
+
+#include <algorithm>
+#include <array>
+#include <future>
+
+namespace raft::neighbors::ivf_flat::detail {
+
+/**
+ * Read the kmeans trainset through `read_rows`.
+ *
+ * The sampled rows are evenly spaced runs of `kSampleRunRows` contiguous rows, so that a
+ * file-backed reader serves the trainset in a few large reads rather than one read per row.
+ */
+template <typename T, typename IdxT, typename ReadRowsT>
+auto sample_trainset(raft::resources const& handle,
+                     ReadRowsT& read_rows,
+                     IdxT n_rows,
+                     uint32_t dim,
+                     IdxT n_rows_train) -> device_matrix<T, IdxT>
+{
+  constexpr IdxT kSampleRunRows = 256;
+  auto stream                   = resource::get_cuda_stream(handle);
+  auto trainset                 = make_device_matrix<T, IdxT>(handle, n_rows_train, dim);
+  auto run_rows                 = std::min<IdxT>(kSampleRunRows, n_rows_train);
+  auto n_runs                   = raft::div_rounding_up_safe<IdxT>(n_rows_train, run_rows);
+  auto run_stride               = n_rows / n_runs;
+  auto buf                      = make_pinned_matrix<T, IdxT>(handle, run_rows, dim);
+  for (IdxT run = 0; run < n_runs; run++) {
+    auto offset = run * run_rows;
+    auto rows   = std::min<IdxT>(run_rows, n_rows_train - offset);
+    // The pinned buffer is reused by the next run only after its copy is complete.
+    resource::sync_stream(handle);
+    read_rows(buf.data_handle(), run * run_stride, rows);
+    raft::copy(trainset.data_handle() + size_t(offset) * dim,
+               buf.data_handle(),
+               size_t(rows) * dim,
+               stream);
+  }
+  resource::sync_stream(handle);
+  return trainset;
+}
+
+/** See raft::neighbors::ivf_flat::build_streaming docs */
+template <typename T, typename IdxT, typename ReadRowsT>
+auto build_streaming(raft::resources const& handle,
+                     const index_params& params,
+                     ReadRowsT&& read_rows,
+                     IdxT n_rows,
+                     uint32_t dim,
+                     IdxT chunk_rows) -> index<T, IdxT>
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::build_streaming(%zu, %u)", size_t(n_rows), dim);
+  RAFT_EXPECTS(n_rows > 0 && dim > 0, "empty dataset");
+  RAFT_EXPECTS(n_rows >= params.n_lists, "number of rows can't be less than n_lists");
+  RAFT_EXPECTS(chunk_rows > 0, "The chunk size must be positive");
+  auto stream = resource::get_cuda_stream(handle);
+
+  index<T, IdxT> index(handle, params, dim);
+  utils::memzero(
+    index.accum_sorted_sizes().data_handle(), index.accum_sorted_sizes().size(), stream);
+  utils::memzero(index.list_sizes().data_handle(), index.list_sizes().size(), stream);
+  utils::memzero(index.data_ptrs().data_handle(), index.data_ptrs().size(), stream);
+  utils::memzero(index.inds_ptrs().data_handle(), index.inds_ptrs().size(), stream);
+
+  // Train the kmeans clustering on a sample of the rows (the same fraction as in `build`)
+  {
+    auto trainset_ratio = std::max<size_t>(
+      1, n_rows / std::max<size_t>(params.kmeans_trainset_fraction * n_rows, index.n_lists()));
+    IdxT n_rows_train = n_rows / trainset_ratio;
+    auto trainset     = sample_trainset<T, IdxT>(handle, read_rows, n_rows, dim, n_rows_train);
+    auto centers_view = raft::make_device_matrix_view<float, IdxT>(
+      index.centers().data_handle(), index.n_lists(), index.dim());
+    raft::cluster::kmeans_balanced_params kmeans_params;
+    kmeans_params.n_iters = params.kmeans_n_iters;
+    kmeans_params.metric  = index.metric();
+    raft::cluster::kmeans_balanced::fit(handle,
+                                        kmeans_params,
+                                        raft::make_const_mdspan(trainset.view()),
+                                        centers_view,
+                                        utils::mapping<float>{});
+  }
+  if (!params.add_data_on_build) { return index; }
+
+  // Add the data chunk by chunk. The host reads the next chunk into one pinned buffer while the
+  // GPU copies and inserts the current one from the other.
+  chunk_rows       = std::min<IdxT>(chunk_rows, n_rows);
+  auto n_chunks    = raft::div_rounding_up_safe<IdxT>(n_rows, chunk_rows);
+  auto host_chunks = make_pinned_matrix<T, IdxT>(handle, 2 * chunk_rows, dim);
+  auto dev_chunk   = make_device_matrix<T, IdxT>(handle, chunk_rows, dim);
+  auto dev_indices = make_device_vector<IdxT, IdxT>(handle, chunk_rows);
+  std::array<resource::cuda_event_resource, 2> copied;
+  auto copied_event = [&copied](IdxT chunk) {
+    return *static_cast<cudaEvent_t*>(copied[chunk % 2].get_resource());
+  };
+  auto chunk_size = [=](IdxT chunk) {
+    return std::min<IdxT>(chunk_rows, n_rows - chunk * chunk_rows);
+  };
+  auto read_chunk = [&](IdxT chunk) {
+    read_rows(host_chunks.data_handle() + size_t(chunk % 2) * chunk_rows * dim,
+              chunk * chunk_rows,
+              chunk_size(chunk));
+  };
+
+  read_chunk(0);
+  for (IdxT chunk = 0; chunk < n_chunks; chunk++) {
+    auto offset = chunk * chunk_rows;
+    auto rows   = chunk_size(chunk);
+    raft::copy(dev_chunk.data_handle(),
+               host_chunks.data_handle() + size_t(chunk % 2) * chunk_rows * dim,
+               size_t(rows) * dim,
+               stream);
+    RAFT_CUDA_TRY(cudaEventRecord(copied_event(chunk), stream));
+
+    // The buffer of the chunk `c + 1` is the one of the chunk `c - 1`, copied before `c`.
+    std::future<void> next;
+    if (chunk + 1 < n_chunks) {
+      RAFT_CUDA_TRY(cudaEventSynchronize(copied_event(chunk + 1)));
+      next = std::async(std::launch::async, read_chunk, chunk + 1);
+    }
+    raft::linalg::map_offset(
+      handle, dev_indices.view(), [offset] __device__(IdxT i) { return offset + i; });
+    detail::extend<T, IdxT>(
+      handle, &index, dev_chunk.data_handle(), dev_indices.data_handle(), rows);
+    RAFT_LOG_DEBUG("ivf_flat::build_streaming added vectors %zu, %6.1f%% complete",
+                   static_cast<size_t>(offset + rows),
+                   (offset + rows) * 100.0f / n_rows);
+    if (next.valid()) { next.get(); }
+  }
+  return index;
+}
+
+}  // namespace raft::neighbors::ivf_flat::detail
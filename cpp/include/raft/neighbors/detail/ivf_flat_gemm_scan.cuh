@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/gemm.cuh>
+#include <raft/linalg/reduce.cuh>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/matrix/init.cuh>
+#include <raft/neighbors/detail/ivf_common.cuh>
+#include <raft/neighbors/detail/ivf_flat_build.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/resource_ref.hpp>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::detail {
+
+/** The element type of the GEMM operands: the half indices use the tensor cores. */
+template <typename T>
+using gemm_scan_t = std::conditional_t<std::is_same_v<T, half>, half, float>;
+
+/**
+ * Turn the dot products between a group of queries and the records of a list into the distances,
+ * replacing the filtered out records by the `dummy` value.
+ */
+template <typename IvfSampleFilterT>
+RAFT_KERNEL gemm_scan_epilogue_kernel(float* dists,                  // [n_rows, list_size]
+                                      const float* query_norms,      // [n_queries]
+                                      const float* list_norms,       // [list_size]
+                                      const uint32_t* group_probes,  // [n_rows]
+                                      uint32_t n_rows,
+                                      uint32_t list_size,
+                                      uint32_t n_probes,
+                                      uint32_t queries_offset,
+                                      uint32_t label,
+                                      bool is_l2,
+                                      float dummy,
+                                      IvfSampleFilterT sample_filter)
+{
+  const uint64_t i = threadIdx.x + uint64_t(blockDim.x) * uint64_t(blockIdx.x);
+  if (i >= uint64_t(n_rows) * uint64_t(list_size)) { return; }
+  const uint32_t row   = i / uint64_t(list_size);
+  const uint32_t j     = i % uint64_t(list_size);
+  const uint32_t query = group_probes[row] / n_probes;
+  float d              = dists[i];
+  if (is_l2) { d = max(query_norms[query] + list_norms[j] - 2.0f * d, 0.0f); }
+  if (!sample_filter(queries_offset + query, label, j)) { d = dummy; }
+  dists[i] = d;
+}
+
+/**
+ * Write the top-k of a group of queries in a list to the rows of their probes, mapping the
+ * positions in the list onto the source indices.
+ */
+template <typename IdxT>
+RAFT_KERNEL gemm_scan_scatter_kernel(float* probe_dists,            // [n_queries * n_probes, k]
+                                     IdxT* probe_ids,               // [n_queries * n_probes, k]
+                                     const float* dists,            // [n_rows, list_k]
+                                     const uint32_t* positions,     // [n_rows, list_k]
+                                     const uint32_t* group_probes,  // [n_rows]
+                                     const IdxT* list_indices,      // [list_size]
+                                     uint32_t n_rows,
+                                     uint32_t list_k,
+                                     uint32_t k,
+                                     float dummy)
+{
+  const uint64_t i = threadIdx.x + uint64_t(blockDim.x) * uint64_t(blockIdx.x);
+  if (i >= uint64_t(n_rows) * uint64_t(list_k)) { return; }
+  const uint32_t row = i / uint64_t(list_k);
+  const uint32_t j   = i % uint64_t(list_k);
+  const size_t out   = size_t(group_probes[row]) * size_t(k) + j;
+  const float d      = dists[i];
+  probe_dists[out]   = d;
+  probe_ids[out] =
+    d == dummy ? ivf::detail::kOutOfBoundsRecord<IdxT> : list_indices[positions[i]];
+}
+
+/**
+ * Scan the probed lists by grouping the queries by the lists they probe.
+ *
+ * The distances between every group of queries and the records of its list are computed as a
+ * GEMM followed by a distance epilogue and a top-k selection per (query, probe) pair; the per-probe
+ * results are merged into the final top-k at the end. Unlike the interleaved scan, which reads
+ * every list once per query probing it, this reads every list once per batch.
+ */
+template <typename T, typename IdxT, typename IvfSampleFilterT>
+void gemm_scan(raft::resources const& handle,
+               const index<T, IdxT>& index,
+               const T* queries,                    // [n_queries, dim]
+               const uint32_t* coarse_indices,      // [n_queries, n_probes]
+               const uint32_t* n_probes_per_query,  // [n_queries] or nullptr
+               uint32_t n_queries,
+               uint32_t queries_offset,
+               uint32_t k,
+               uint32_t n_probes,
+               bool select_min,
+               IdxT* neighbors,                     // [n_queries, k]
+               float* distances,                    // [n_queries, k]
+               rmm::device_async_resource_ref mr,
+               IvfSampleFilterT sample_filter)
+{
+  using gemm_t = gemm_scan_t<T>;
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::gemm_scan(n_queries = %u, n_probes = %u)", n_queries, n_probes);
+  // The bounds on the size of the GEMM operands per list, the query groups are split to fit them.
+  constexpr uint64_t kMaxGemmOutSize = 1ull << 25;
+  constexpr uint32_t kMaxGroupRows   = 8192;
+  constexpr uint32_t kBlockSize      = 256;
+
+  auto stream             = resource::get_cuda_stream(handle);
+  const uint32_t dim      = index.dim();
+  const uint32_t n_lists  = index.n_lists();
+  const size_t n_qp       = size_t(n_queries) * size_t(n_probes);
+  const bool is_l2        = index.metric() != raft::distance::DistanceType::InnerProduct;
+  const float dummy       = select_min ? raft::upper_bound<float>() : raft::lower_bound<float>();
+  const uint32_t max_size = index.accum_sorted_sizes()(1);
+
+  // Group the (query, probe) pairs by the probed lists on the host; the probes cut off by the
+  // adaptive probing are left out (their results keep the dummy records).
+  std::vector<uint32_t> probed_lists(n_qp);
+  std::vector<uint32_t> list_sizes(n_lists);
+  std::vector<uint32_t> query_probes(n_probes_per_query == nullptr ? 0 : n_queries);
+  raft::copy(probed_lists.data(), coarse_indices, n_qp, stream);
+  raft::copy(list_sizes.data(), index.list_sizes().data_handle(), n_lists, stream);
+  if (n_probes_per_query != nullptr) {
+    raft::copy(query_probes.data(), n_probes_per_query, n_queries, stream);
+  }
+  resource::sync_stream(handle);
+  auto is_probed = [&](size_t i) {
+    return query_probes.empty() || i % n_probes < query_probes[i / n_probes];
+  };
+  std::vector<uint32_t> group_offsets(n_lists + 1, 0);
+  for (size_t i = 0; i < n_qp; i++) {
+    if (is_probed(i)) { group_offsets[probed_lists[i] + 1]++; }
+  }
+  for (uint32_t l = 0; l < n_lists; l++) {
+    group_offsets[l + 1] += group_offsets[l];
+  }
+  std::vector<uint32_t> group_probes(n_qp);
+  {
+    std::vector<uint32_t> fill(group_offsets.begin(), group_offsets.end() - 1);
+    for (size_t i = 0; i < n_qp; i++) {
+      if (is_probed(i)) { group_probes[fill[probed_lists[i]]++] = i; }
+    }
+  }
+  rmm::device_uvector<uint32_t> group_probes_dev(n_qp, stream, mr);
+  raft::copy(group_probes_dev.data(), group_probes.data(), n_qp, stream);
+
+  // The per-probe results, the probes of the empty lists keep the dummy records.
+  rmm::device_uvector<float> probe_dists(n_qp * k, stream, mr);
+  rmm::device_uvector<IdxT> probe_ids(n_qp * k, stream, mr);
+  raft::matrix::fill(
+    handle, raft::make_device_vector_view<float, size_t>(probe_dists.data(), n_qp * k), dummy);
+  raft::matrix::fill(handle,
+                     raft::make_device_vector_view<IdxT, size_t>(probe_ids.data(), n_qp * k),
+                     ivf::detail::kOutOfBoundsRecord<IdxT>);
+
+  rmm::device_uvector<gemm_t> queries_gemm(0, stream, mr);
+  const gemm_t* queries_gemm_ptr = nullptr;
+  if constexpr (std::is_same_v<T, gemm_t>) {
+    queries_gemm_ptr = queries;
+  } else {
+    queries_gemm.resize(size_t(n_queries) * dim, stream);
+    linalg::unaryOp(
+      queries_gemm.data(), queries, size_t(n_queries) * dim, raft::cast_op<gemm_t>{}, stream);
+    queries_gemm_ptr = queries_gemm.data();
+  }
+  // The norms of the raw values (the coarse search norms are the ones of the mapped values).
+  rmm::device_uvector<float> query_norms(is_l2 ? n_queries : 0, stream, mr);
+  if (is_l2) {
+    linalg::reduce(query_norms.data(),
+                   queries,
+                   dim,
+                   n_queries,
+                   0.0f,
+                   true,
+                   true,
+                   stream,
+                   false,
+                   raft::compose_op(raft::sq_op{}, raft::cast_op<float>{}));
+  }
+
+  const uint32_t max_group = std::min<size_t>(kMaxGroupRows, n_qp);
+  auto group_rows = [max_group](uint32_t list_size) -> uint32_t {
+    return std::clamp<uint64_t>(kMaxGemmOutSize / list_size, 1, max_group);
+  };
+  rmm::device_uvector<T> list_data(size_t(max_size) * dim, stream, mr);
+  rmm::device_uvector<gemm_t> list_gemm(std::is_same_v<T, gemm_t> ? 0 : size_t(max_size) * dim,
+                                        stream,
+                                        mr);
+  rmm::device_uvector<float> list_norms(max_size, stream, mr);
+  rmm::device_uvector<gemm_t> group_queries(size_t(max_group) * dim, stream, mr);
+  rmm::device_uvector<float> group_dists(
+    std::min(uint64_t(max_group) * max_size, std::max<uint64_t>(kMaxGemmOutSize, max_size)),
+    stream,
+    mr);
+  rmm::device_uvector<float> group_topk_dists(size_t(max_group) * k, stream, mr);
+  rmm::device_uvector<uint32_t> group_topk_pos(size_t(max_group) * k, stream, mr);
+
+  auto filter_adapter = raft::neighbors::filtering::ivf_to_sample_filter(
+    index.inds_ptrs().data_handle(), sample_filter);
+  const float alpha = 1.0f;
+  const float beta  = 0.0f;
+  for (uint32_t l = 0; l < n_lists; l++) {
+    const uint32_t list_size = list_sizes[l];
+    const uint32_t n_group   = group_offsets[l + 1] - group_offsets[l];
+    if (list_size == 0 || n_group == 0) { continue; }
+
+    // Unpack the list to a row-major matrix once for all the queries probing it.
+    auto list_view = make_device_matrix_view<T, uint32_t>(list_data.data(), list_size, dim);
+    unpack_list_data<T, IdxT>(handle,
+                              make_const_mdspan(index.lists()[l]->data.view()),
+                              index.veclen(),
+                              uint32_t{0},
+                              list_view);
+    const gemm_t* list_gemm_ptr = nullptr;
+    if constexpr (std::is_same_v<T, gemm_t>) {
+      list_gemm_ptr = list_data.data();
+    } else {
+      linalg::unaryOp(list_gemm.data(),
+                      list_data.data(),
+                      size_t(list_size) * dim,
+                      raft::cast_op<gemm_t>{},
+                      stream);
+      list_gemm_ptr = list_gemm.data();
+    }
+    if (is_l2) {
+      linalg::reduce(list_norms.data(),
+                     list_data.data(),
+                     dim,
+                     list_size,
+                     0.0f,
+                     true,
+                     true,
+                     stream,
+                     false,
+                     raft::compose_op(raft::sq_op{}, raft::cast_op<float>{}));
+    }
+
+    const uint32_t list_k = std::min(k, list_size);
+    const uint32_t chunk  = group_rows(list_size);
+    for (uint32_t offset = 0; offset < n_group; offset += chunk) {
+      const uint32_t n_rows  = std::min(chunk, n_group - offset);
+      const uint32_t* probes = group_probes_dev.data() + group_offsets[l] + offset;
+      raft::matrix::gather(queries_gemm_ptr,
+                           dim,
+                           n_queries,
+                           probes,
+                           n_rows,
+                           group_queries.data(),
+                           raft::div_const_op<uint32_t>{n_probes},
+                           stream);
+      // Row-major [n_rows, list_size] dot products.
+      linalg::gemm(handle,
+                   true,
+                   false,
+                   list_size,
+                   n_rows,
+                   dim,
+                   &alpha,
+                   list_gemm_ptr,
+                   dim,
+                   group_queries.data(),
+                   dim,
+                   &beta,
+                   group_dists.data(),
+                   list_size,
+                   stream);
+      auto n_elems = uint64_t(n_rows) * uint64_t(list_size);
+      gemm_scan_epilogue_kernel<<<raft::div_rounding_up_safe<uint64_t>(n_elems, kBlockSize),
+                                  kBlockSize,
+                                  0,
+                                  stream>>>(group_dists.data(),
+                                            query_norms.data(),
+                                            list_norms.data(),
+                                            probes,
+                                            n_rows,
+                                            list_size,
+                                            n_probes,
+                                            queries_offset,
+                                            l,
+                                            is_l2,
+                                            dummy,
+                                            filter_adapter);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      matrix::detail::select_k<float, uint32_t>(handle,
+                                                group_dists.data(),
+                                                nullptr,
+                                                n_rows,
+                                                list_size,
+                                                list_k,
+                                                group_topk_dists.data(),
+                                                group_topk_pos.data(),
+                                                select_min);
+      n_elems = uint64_t(n_rows) * uint64_t(list_k);
+      gemm_scan_scatter_kernel<IdxT>
+        <<<raft::div_rounding_up_safe<uint64_t>(n_elems, kBlockSize), kBlockSize, 0, stream>>>(
+          probe_dists.data(),
+          probe_ids.data(),
+          group_topk_dists.data(),
+          group_topk_pos.data(),
+          probes,
+          index.lists()[l]->indices.data_handle(),
+          n_rows,
+          list_k,
+          k,
+          dummy);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+  }
+
+  // Merge the per-probe results.
+  matrix::detail::select_k<float, IdxT>(handle,
+                                        probe_dists.data(),
+                                        probe_ids.data(),
+                                        n_queries,
+                                        n_probes * k,
+                                        k,
+                                        distances,
+                                        neighbors,
+                                        select_min);
+  ivf::detail::postprocess_distances(
+    distances, distances, index.metric(), n_queries, k, 1.0, false, stream);
+}
+
+}  // namespace raft::neighbors::ivf_flat::detail
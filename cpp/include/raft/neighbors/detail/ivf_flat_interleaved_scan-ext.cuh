@@ -78,10 +78,14 @@ void ivfflat_interleaved_scan(const raft::neighbors::ivf_flat::index<T, IdxT>& i
 instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
   float, float, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
-  half, half, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+  half, float, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
   int8_t, int32_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
   uint8_t, uint32_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
+  float, float, int64_t, raft::neighbors::filtering::label_exclusion_ivf_sample_filter<int>);
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
+  float, float, int64_t, raft::neighbors::filtering::label_exclusion_ivf_sample_filter<int64_t>);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan
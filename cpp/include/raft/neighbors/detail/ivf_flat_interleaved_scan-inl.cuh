@@ -32,6 +32,8 @@
 
 #include <rmm/cuda_stream_view.hpp>
 
+#include <type_traits>
+
 namespace raft::neighbors::ivf_flat::detail {
 
 using namespace raft::spatial::knn::detail;  // NOLINT
@@ -651,6 +653,14 @@ struct flat_block_sort<0, Ascending, T, IdxT>
 template <int Capacity, bool Ascending, typename T, typename IdxT>
 using block_sort_t = typename flat_block_sort<Capacity, Ascending, T, IdxT>::type;
 
+/** The number of the query components the interleaved scan keeps in the shared memory. */
+template <typename T, int Veclen>
+constexpr auto interleaved_scan_query_smem_elems(uint32_t dim) -> uint32_t
+{
+  constexpr uint32_t kMaxQuerySmem = 16384;
+  return std::min<uint32_t>(kMaxQuerySmem / sizeof(T), Pow2<Veclen * WarpSize>::roundUp(dim));
+}
+
 /**
  * Scan clusters for nearest neighbors of the query vectors.
  * See `ivfflat_interleaved_scan` for more information.
@@ -660,8 +670,8 @@ using block_sort_t = typename flat_block_sort<Capacity, Ascending, T, IdxT>::typ
  * calculated, and the top-k nearest neighbors are selected.
  *
  * @param compute_dist distance function
- * @param query_smem_elems number of dimensions of the query vector to fit in a shared memory of a
- * block; this number must be a multiple of `WarpSize * Veclen`.
+ * @param runtime_query_smem_elems number of dimensions of the query vector to fit in a shared memory
+ * of a block; this number must be a multiple of `WarpSize * Veclen` (ignored if `Dim > 0`).
  * @param[in] query a pointer to all queries in a row-major contiguous format [gridDim.y, dim]
  * @param[in] coarse_index a pointer to the cluster indices to search through [n_probes]
  * @param[in] list_indices index<T, IdxT>.indices
@@ -670,13 +680,18 @@ using block_sort_t = typename flat_block_sort<Capacity, Ascending, T, IdxT>::typ
  * @param[in] list_offsets index<T, IdxT>.list_offsets
  * @param n_probes
  * @param k
- * @param dim
+ * @param runtime_dim
  * @param sample_filter
  * @param[out] neighbors
  * @param[out] distances
+ *
+ * @tparam Dim the dimensionality known at compile time, or zero to use the runtime `dim`.
+ *   With a static `Dim`, the loops over the dimensions have constant trip counts the compiler can
+ *   unroll, and the choice between the shared-memory and the shfl code paths is made statically.
  */
 template <int Capacity,
           int Veclen,
+          uint32_t Dim,
           bool Ascending,
           typename T,
           typename AccT,
@@ -687,7 +702,7 @@ template <int Capacity,
 RAFT_KERNEL __launch_bounds__(kThreadsPerBlock)
   interleaved_scan_kernel(Lambda compute_dist,
                           PostLambda post_process,
-                          const uint32_t query_smem_elems,
+                          const uint32_t runtime_query_smem_elems,
                           const T* query,
                           const uint32_t* coarse_index,
                           const T* const* list_data_ptrs,
@@ -697,13 +712,16 @@ RAFT_KERNEL __launch_bounds__(kThreadsPerBlock)
                           const uint32_t k,
                           const uint32_t max_samples,
                           const uint32_t* chunk_indices,
-                          const uint32_t dim,
+                          const uint32_t runtime_dim,
                           IvfSampleFilterT sample_filter,
                           uint32_t* neighbors,
                           float* distances)
 {
   extern __shared__ __align__(256) uint8_t interleaved_scan_kernel_smem[];
   constexpr bool kManageLocalTopK = Capacity > 0;
+  const uint32_t dim              = Dim > 0 ? Dim : runtime_dim;
+  const uint32_t query_smem_elems =
+    Dim > 0 ? interleaved_scan_query_smem_elems<T, Veclen>(Dim) : runtime_query_smem_elems;
   // Using shared memory for the (part of the) query;
   // This allows to save on global memory bandwidth when reading index and query
   // data at the same time.
@@ -743,18 +761,19 @@ RAFT_KERNEL __launch_bounds__(kThreadsPerBlock)
     for (int probe_id = blockIdx.x; probe_id < n_probes; probe_id += gridDim.x) {
       const uint32_t list_id = coarse_index[probe_id];  // The id of cluster(list)
 
-      // The number of vectors in each cluster(list); [nlist]
-      const uint32_t list_length = list_sizes[list_id];
+      uint32_t sample_offset = 0;
+      if (probe_id > 0) { sample_offset = chunk_indices[probe_id - 1]; }
+
+      // The number of vectors to scan in the cluster(list); this is zero for the probes cut off by
+      // the adaptive probing, and the size of the list otherwise.
+      const uint32_t list_length = chunk_indices[probe_id] - sample_offset;
+      assert(list_length == 0 || list_length == list_sizes[list_id]);
+      assert(sample_offset + list_length <= max_samples);
 
       // The number of interleaved groups to be processed
       const uint32_t num_groups =
         align_warp::div(list_length + align_warp::Mask);  // ceildiv by power of 2
 
-      uint32_t sample_offset = 0;
-      if (probe_id > 0) { sample_offset = chunk_indices[probe_id - 1]; }
-      assert(list_length == chunk_indices[probe_id] - sample_offset);
-      assert(sample_offset + list_length <= max_samples);
-
       constexpr int kUnroll        = WarpSize / Veclen;
       constexpr uint32_t kNumWarps = kThreadsPerBlock / WarpSize;
       // Every warp reads WarpSize vectors and computes the distances to them.
@@ -850,6 +869,7 @@ uint32_t configure_launch_x(uint32_t numQueries, uint32_t n_probes, int32_t sMem
 
 template <int Capacity,
           int Veclen,
+          uint32_t Dim,
           bool Ascending,
           typename T,
           typename AccT,
@@ -876,8 +896,11 @@ void launch_kernel(Lambda lambda,
 {
   RAFT_EXPECTS(Veclen == index.veclen(),
                "Configured Veclen does not match the index interleaving pattern.");
-  constexpr auto kKernel   = interleaved_scan_kernel<Capacity,
+  RAFT_EXPECTS(Dim == 0 || Dim == index.dim(),
+               "Configured Dim does not match the dimensionality of the index.");
+  constexpr auto kKernel = interleaved_scan_kernel<Capacity,
                                                    Veclen,
+                                                   Dim,
                                                    Ascending,
                                                    T,
                                                    AccT,
@@ -885,10 +908,8 @@ void launch_kernel(Lambda lambda,
                                                    IvfSampleFilterT,
                                                    Lambda,
                                                    PostLambda>;
-  const int max_query_smem = 16384;
-  int query_smem_elems =
-    std::min<int>(max_query_smem / sizeof(T), Pow2<Veclen * WarpSize>::roundUp(index.dim()));
-  int smem_size = query_smem_elems * sizeof(T);
+  int query_smem_elems = interleaved_scan_query_smem_elems<T, Veclen>(index.dim());
+  int smem_size        = query_smem_elems * sizeof(T);
 
   if constexpr (Capacity > 0) {
     constexpr int kSubwarpSize = std::min<int>(Capacity, WarpSize);
@@ -1002,6 +1023,7 @@ struct inner_prod_dist {
 /** Select the distance computation function and forward the rest of the arguments. */
 template <int Capacity,
           int Veclen,
+          uint32_t Dim,
           bool Ascending,
           typename T,
           typename AccT,
@@ -1015,6 +1037,7 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
     case raft::distance::DistanceType::L2Unexpanded:
       return launch_kernel<Capacity,
                            Veclen,
+                           Dim,
                            Ascending,
                            T,
                            AccT,
@@ -1026,6 +1049,7 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
     case raft::distance::DistanceType::L2SqrtUnexpanded:
       return launch_kernel<Capacity,
                            Veclen,
+                           Dim,
                            Ascending,
                            T,
                            AccT,
@@ -1036,6 +1060,7 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
     case raft::distance::DistanceType::InnerProduct:
       return launch_kernel<Capacity,
                            Veclen,
+                           Dim,
                            Ascending,
                            T,
                            AccT,
@@ -1051,13 +1076,17 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
 /**
  * Lift the `capacity` and `veclen` parameters to the template level,
  * forward the rest of the arguments unmodified to `launch_interleaved_scan_kernel`.
+ *
+ * `Dim` is the static dimensionality of the kernel (zero for the generic one); it is only kept
+ * along with the widest `Veclen`, since the specialized dimensionalities are all multiples of it.
  */
 template <typename T,
           typename AccT,
           typename IdxT,
           typename IvfSampleFilterT,
           int Capacity = matrix::detail::select::warpsort::kMaxCapacity,
-          int Veclen   = std::max<int>(1, 16 / sizeof(T))>
+          int Veclen   = std::max<int>(1, 16 / sizeof(T)),
+          uint32_t Dim = 0>
 struct select_interleaved_scan_kernel {
   /**
    * Recursively reduce the `Capacity` and `Veclen` parameters until they match the
@@ -1070,7 +1099,7 @@ struct select_interleaved_scan_kernel {
   {
     if constexpr (Capacity > 0) {
       if (k_max == 0 || k_max > Capacity) {
-        return select_interleaved_scan_kernel<T, AccT, IdxT, IvfSampleFilterT, 0, Veclen>::run(
+        return select_interleaved_scan_kernel<T, AccT, IdxT, IvfSampleFilterT, 0, Veclen, Dim>::run(
           k_max, veclen, select_min, std::forward<Args>(args)...);
       }
     }
@@ -1081,10 +1110,11 @@ struct select_interleaved_scan_kernel {
                                               IdxT,
                                               IvfSampleFilterT,
                                               Capacity / 2,
-                                              Veclen>::run(k_max,
-                                                           veclen,
-                                                           select_min,
-                                                           std::forward<Args>(args)...);
+                                              Veclen,
+                                              Dim>::run(k_max,
+                                                        veclen,
+                                                        select_min,
+                                                        std::forward<Args>(args)...);
       }
     }
     if constexpr (Veclen > 1) {
@@ -1103,10 +1133,10 @@ struct select_interleaved_scan_kernel {
       veclen == Veclen,
       "Veclen must be power-of-two not bigger than the maximum allowed size for this data type.");
     if (select_min) {
-      launch_with_fixed_consts<Capacity, Veclen, true, T, AccT, IdxT, IvfSampleFilterT>(
+      launch_with_fixed_consts<Capacity, Veclen, Dim, true, T, AccT, IdxT, IvfSampleFilterT>(
         std::forward<Args>(args)...);
     } else {
-      launch_with_fixed_consts<Capacity, Veclen, false, T, AccT, IdxT, IvfSampleFilterT>(
+      launch_with_fixed_consts<Capacity, Veclen, Dim, false, T, AccT, IdxT, IvfSampleFilterT>(
         std::forward<Args>(args)...);
     }
   }
@@ -1165,24 +1195,42 @@ void ivfflat_interleaved_scan(const index<T, IdxT>& index,
 
   auto filter_adapter = raft::neighbors::filtering::ivf_to_sample_filter(
     index.inds_ptrs().data_handle(), sample_filter);
-  select_interleaved_scan_kernel<T, AccT, IdxT, decltype(filter_adapter)>::run(capacity,
-                                                                               index.veclen(),
-                                                                               select_min,
-                                                                               metric,
-                                                                               index,
-                                                                               queries,
-                                                                               coarse_query_results,
-                                                                               n_queries,
-                                                                               queries_offset,
-                                                                               n_probes,
-                                                                               k,
-                                                                               max_samples,
-                                                                               chunk_indices,
-                                                                               filter_adapter,
-                                                                               neighbors,
-                                                                               distances,
-                                                                               grid_dim_x,
-                                                                               stream);
+  auto run = [&](auto static_dim) {
+    select_interleaved_scan_kernel<T,
+                                   AccT,
+                                   IdxT,
+                                   decltype(filter_adapter),
+                                   matrix::detail::select::warpsort::kMaxCapacity,
+                                   std::max<int>(1, 16 / sizeof(T)),
+                                   decltype(static_dim)::value>::run(capacity,
+                                                                     index.veclen(),
+                                                                     select_min,
+                                                                     metric,
+                                                                     index,
+                                                                     queries,
+                                                                     coarse_query_results,
+                                                                     n_queries,
+                                                                     queries_offset,
+                                                                     n_probes,
+                                                                     k,
+                                                                     max_samples,
+                                                                     chunk_indices,
+                                                                     filter_adapter,
+                                                                     neighbors,
+                                                                     distances,
+                                                                     grid_dim_x,
+                                                                     stream);
+  };
+  // The kernels specialized for the dimensionalities of the popular embedding models
+  switch (index.dim()) {
+    case 96: return run(std::integral_constant<uint32_t, 96>{});
+    case 128: return run(std::integral_constant<uint32_t, 128>{});
+    case 384: return run(std::integral_constant<uint32_t, 384>{});
+    case 768: return run(std::integral_constant<uint32_t, 768>{});
+    case 1024: return run(std::integral_constant<uint32_t, 1024>{});
+    case 1536: return run(std::integral_constant<uint32_t, 1536>{});
+    default: return run(std::integral_constant<uint32_t, 0>{});
+  }
 }
 
 }  // namespace raft::neighbors::ivf_flat::detail
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/ivf_common.cuh>
+#include <raft/neighbors/ivf_flat_codepacker.hpp>
+#include <raft/neighbors/ivf_flat_types.hpp>
+#include <raft/util/integer_utils.hpp>
+#include <raft/util/pow2_utils.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sort.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::detail {
+
+/**
+ * Move the records at the `fillers` positions of a list to the `holes` positions (one thread per
+ * record). The holes are all below the fillers, so the moved records never overlap.
+ */
+template <typename T, typename IdxT>
+RAFT_KERNEL fill_holes_kernel(T* list_data,
+                              IdxT* list_indices,
+                              T* codes,  // [n_holes, dim], scratch
+                              const uint32_t* holes,
+                              const uint32_t* fillers,
+                              uint32_t n_holes,
+                              uint32_t dim,
+                              uint32_t veclen)
+{
+  const uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= n_holes) { return; }
+  T* code = codes + size_t(i) * size_t(dim);
+  codepacker::unpack_1(list_data, code, dim, veclen, fillers[i]);
+  codepacker::pack_1(code, list_data, dim, veclen, holes[i]);
+  list_indices[holes[i]] = list_indices[fillers[i]];
+}
+
+/** See raft::neighbors::ivf_flat::remove docs */
+template <typename T, typename IdxT>
+auto remove(raft::resources const& handle, const IdxT* ids, IdxT n_ids, index<T, IdxT>* index)
+  -> IdxT
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::remove(%zu ids, %u lists)", size_t(n_ids), index->n_lists());
+  if (n_ids == 0 || index->size() == 0) { return 0; }
+  constexpr uint32_t kBlockSize = 256;
+
+  auto stream    = resource::get_cuda_stream(handle);
+  auto policy    = resource::get_thrust_policy(handle);
+  auto mr        = resource::get_workspace_resource(handle);
+  auto n_lists   = index->n_lists();
+  const auto dim = index->dim();
+
+  rmm::device_uvector<IdxT> sorted_ids(n_ids, stream, mr);
+  raft::copy(sorted_ids.data(), ids, n_ids, stream);
+  thrust::sort(policy, sorted_ids.begin(), sorted_ids.end());
+
+  std::vector<uint32_t> list_sizes(n_lists);
+  raft::copy(list_sizes.data(), index->list_sizes().data_handle(), n_lists, stream);
+  resource::sync_stream(handle);
+  uint32_t max_size = 0;
+  for (auto s : list_sizes) {
+    max_size = std::max(max_size, s);
+  }
+  rmm::device_uvector<bool> removed(max_size, stream, mr);
+  rmm::device_uvector<uint32_t> holes(max_size, stream, mr);
+  rmm::device_uvector<uint32_t> fillers(max_size, stream, mr);
+  rmm::device_uvector<T> codes(0, stream, mr);
+
+  list_spec<uint32_t, T, IdxT> spec{dim, index->conservative_memory_allocation()};
+  IdxT n_removed = 0;
+  for (uint32_t l = 0; l < n_lists; l++) {
+    auto& list      = index->lists()[l];
+    const auto size = list_sizes[l];
+    if (size == 0) { continue; }
+    auto* list_indices = list->indices.data_handle();
+    thrust::binary_search(policy,
+                          sorted_ids.begin(),
+                          sorted_ids.end(),
+                          list_indices,
+                          list_indices + size,
+                          removed.begin());
+    const uint32_t n_list_removed =
+      thrust::count(policy, removed.begin(), removed.begin() + size, true);
+    if (n_list_removed == 0) { continue; }
+    const uint32_t new_size = size - n_list_removed;
+
+    // The removed records below the new size are replaced by the kept records above it.
+    auto holes_end = thrust::copy_if(policy,
+                                     thrust::make_counting_iterator<uint32_t>(0),
+                                     thrust::make_counting_iterator<uint32_t>(new_size),
+                                     removed.begin(),
+                                     holes.begin(),
+                                     raft::identity_op{});
+    thrust::copy_if(policy,
+                    thrust::make_counting_iterator<uint32_t>(new_size),
+                    thrust::make_counting_iterator<uint32_t>(size),
+                    removed.begin() + new_size,
+                    fillers.begin(),
+                    thrust::logical_not<bool>{});
+    const uint32_t n_holes = holes_end - holes.begin();
+    if (n_holes > 0) {
+      if (codes.size() < size_t(n_holes) * dim) { codes.resize(size_t(n_holes) * dim, stream); }
+      fill_holes_kernel<T, IdxT>
+        <<<raft::div_rounding_up_safe(n_holes, kBlockSize), kBlockSize, 0, stream>>>(
+          list->data.data_handle(),
+          list_indices,
+          codes.data(),
+          holes.data(),
+          fillers.data(),
+          n_holes,
+          dim,
+          index->veclen());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+
+    // Shrink the list only when most of its capacity is unused, so that the interleaved groups are
+    // not reallocated on every call.
+    if (Pow2<kIndexGroupSize>::roundUp(new_size) * 4 <= list->indices.extent(0)) {
+      auto new_list = std::make_shared<list_data<T, IdxT>>(handle, spec, new_size);
+      if (new_size > 0) {
+        raft::copy(new_list->data.data_handle(),
+                   list->data.data_handle(),
+                   size_t(Pow2<kIndexGroupSize>::roundUp(new_size)) * dim,
+                   stream);
+        raft::copy(new_list->indices.data_handle(), list_indices, new_size, stream);
+      }
+      new_list.swap(list);
+    }
+    list->size.store(new_size);
+    list_sizes[l] = new_size;
+    n_removed += n_list_removed;
+  }
+
+  raft::copy(index->list_sizes().data_handle(), list_sizes.data(), n_lists, stream);
+  ivf::detail::recompute_internal_state(handle, *index);
+  return n_removed;
+}
+
+}  // namespace raft::neighbors::ivf_flat::detail
@@ -67,5 +67,9 @@ instantiate_raft_neighbors_ivf_flat_detail_search(
   int8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_search(
   uint8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+instantiate_raft_neighbors_ivf_flat_detail_search(
+  float, int64_t, raft::neighbors::filtering::label_exclusion_ivf_sample_filter<int>);
+instantiate_raft_neighbors_ivf_flat_detail_search(
+  float, int64_t, raft::neighbors::filtering::label_exclusion_ivf_sample_filter<int64_t>);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_search
@@ -25,6 +25,7 @@
 #include <raft/linalg/unary_op.cuh>                             // raft::linalg::unary_op
 #include <raft/matrix/detail/select_k.cuh>                      // matrix::detail::select_k
 #include <raft/neighbors/detail/ivf_common.cuh>                 // raft::neighbors::detail::ivf
+#include <raft/neighbors/detail/ivf_flat_gemm_scan.cuh>         // gemm_scan
 #include <raft/neighbors/detail/ivf_flat_interleaved_scan.cuh>  // interleaved_scan
 #include <raft/neighbors/ivf_flat_types.hpp>                    // raft::neighbors::ivf_flat::index
 #include <raft/neighbors/sample_filter_types.hpp>               // none_ivf_sample_filter
@@ -46,6 +47,8 @@ void search_impl(raft::resources const& handle,
                  uint32_t n_probes,
                  uint32_t max_samples,
                  bool select_min,
+                 list_scan_algo scan_algo,
+                 const ivf::adaptive_probing& adaptive_probes,
                  IdxT* neighbors,
                  AccT* distances,
                  rmm::device_async_resource_ref search_mr,
@@ -63,6 +66,9 @@ void search_impl(raft::resources const& handle,
   rmm::device_uvector<float> coarse_distances_dev(n_queries_probes, stream, search_mr);
   // The topk  index of cluster(list) and queries
   rmm::device_uvector<uint32_t> coarse_indices_dev(n_queries_probes, stream, search_mr);
+  // The number of the probed clusters per query, if the adaptive probing is enabled
+  rmm::device_uvector<uint32_t> n_probes_per_query(
+    adaptive_probes.enabled() ? n_queries : 0, stream, search_mr);
 
   // Optional structures if postprocessing is required
   // The topk distance value of candidate vectors from each cluster(list)
@@ -78,7 +84,7 @@ void search_impl(raft::resources const& handle,
   rmm::device_uvector<uint32_t> neighbors_uint32_buf(0, stream, search_mr);
 
   size_t float_query_size;
-  if constexpr (std::is_integral_v<T>) {
+  if constexpr (!std::is_same_v<T, float>) {
     float_query_size = n_queries * index.dim();
   } else {
     float_query_size = 0;
@@ -150,10 +156,45 @@ void search_impl(raft::resources const& handle,
                                            n_probes,
                                            coarse_distances_dev.data(),
                                            coarse_indices_dev.data(),
-                                           select_min);
+                                           select_min,
+                                           adaptive_probes.enabled());
   RAFT_LOG_TRACE_VEC(coarse_indices_dev.data(), n_probes);
   RAFT_LOG_TRACE_VEC(coarse_distances_dev.data(), n_probes);
 
+  // The probes of a query beyond its adaptive limit are treated as empty lists
+  const uint32_t* n_probes_per_query_ptr = nullptr;
+  if (adaptive_probes.enabled()) {
+    ivf::detail::calc_adaptive_probes(adaptive_probes,
+                                      coarse_distances_dev.data(),
+                                      coarse_indices_dev.data(),
+                                      index.list_sizes().data_handle(),
+                                      nullptr,
+                                      n_queries,
+                                      n_probes,
+                                      select_min,
+                                      n_probes_per_query.data(),
+                                      stream);
+    n_probes_per_query_ptr = n_probes_per_query.data();
+  }
+
+  if (scan_algo == list_scan_algo::GEMM) {
+    gemm_scan<T, IdxT, IvfSampleFilterT>(handle,
+                                         index,
+                                         queries,
+                                         coarse_indices_dev.data(),
+                                         n_probes_per_query_ptr,
+                                         n_queries,
+                                         queries_offset,
+                                         k,
+                                         n_probes,
+                                         select_min,
+                                         neighbors,
+                                         distances,
+                                         search_mr,
+                                         sample_filter);
+    return;
+  }
+
   uint32_t grid_dim_x = 0;
   if (n_probes > 1) {
     // query the gridDimX size to store probes topK output
@@ -185,7 +226,8 @@ void search_impl(raft::resources const& handle,
                                                                   coarse_indices_dev.data(),
                                                                   chunk_index.data(),
                                                                   num_samples.data(),
-                                                                  stream);
+                                                                  stream,
+                                                                  n_probes_per_query_ptr);
 
   auto distances_dev_ptr = distances;
 
@@ -303,6 +345,10 @@ inline void search(raft::resources const& handle,
   uint64_t ws_size_per_query = 4ull * (2 * n_probes + index.n_lists() + index.dim() + 1) +
                                (manage_local_topk ? ((sizeof(IdxT) + 4) * n_probes * k)
                                                   : (4ull * (max_samples + n_probes + 1)));
+  // the GEMM scan keeps the top-k of every probe
+  if (params.scan_algo == list_scan_algo::GEMM) {
+    ws_size_per_query += (sizeof(IdxT) + 8) * n_probes * k;
+  }
 
   const uint32_t max_queries =
     std::min<uint32_t>(n_queries, raft::div_rounding_up_safe(max_ws_size, ws_size_per_query));
@@ -319,6 +365,8 @@ inline void search(raft::resources const& handle,
                                                   n_probes,
                                                   max_samples,
                                                   raft::distance::is_min_close(index.metric()),
+                                                  params.scan_algo,
+                                                  params.adaptive_probes,
                                                   neighbors + offset_q * k,
                                                   distances + offset_q * k,
                                                   mr,
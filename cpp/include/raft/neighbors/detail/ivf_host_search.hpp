@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/distance/distance_types.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+/**
+ * Building blocks of the host (CPU) searches of the IVF indexes.
+ *
+ * All scores are "smaller is better": the inner product is negated while searching and restored
+ * in the output. The inner loops are written for the compiler to vectorize them (`omp simd`), so
+ * the target ISA (AVX2/AVX-512/NEON) follows the compile flags of the caller.
+ */
+namespace raft::neighbors::detail::ivf_host {
+
+/** The versions of the formats of `ivf_flat::serialize` and `ivf_pq::serialize`. */
+constexpr int kIvfFlatSerializationVersion = 4;
+constexpr int kIvfPqSerializationVersion   = 3;
+
+inline void check_metric(raft::distance::DistanceType metric)
+{
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2Unexpanded:
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded:
+    case raft::distance::DistanceType::InnerProduct: return;
+    default: RAFT_FAIL("The host IVF search does not support the metric %d", int(metric));
+  }
+}
+
+/** Turn an internal score into the distance reported by the search. */
+inline auto postprocess_distance(raft::distance::DistanceType metric, float score) -> float
+{
+  switch (metric) {
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded: return std::sqrt(std::max(score, 0.0f));
+    case raft::distance::DistanceType::InnerProduct: return -score;
+    default: return score;
+  }
+}
+
+/** The squared L2 distance or the negated inner product of two float vectors. */
+inline auto score(const float* a, const float* b, uint32_t dim, bool inner_product) -> float
+{
+  float s = 0;
+  if (inner_product) {
+#pragma omp simd reduction(+ : s)
+    for (uint32_t i = 0; i < dim; i++) {
+      s -= a[i] * b[i];
+    }
+  } else {
+#pragma omp simd reduction(+ : s)
+    for (uint32_t i = 0; i < dim; i++) {
+      const float d = a[i] - b[i];
+      s += d * d;
+    }
+  }
+  return s;
+}
+
+/** Select the `n_probes` lists with the smallest scores [n_lists]. */
+inline void select_probes(const std::vector<float>& scores,
+                          uint32_t n_probes,
+                          std::vector<uint32_t>& probes)
+{
+  probes.resize(scores.size());
+  std::iota(probes.begin(), probes.end(), 0u);
+  n_probes = std::min<uint32_t>(n_probes, scores.size());
+  std::partial_sort(probes.begin(),
+                    probes.begin() + n_probes,
+                    probes.end(),
+                    [&scores](uint32_t a, uint32_t b) { return scores[a] < scores[b]; });
+  probes.resize(n_probes);
+}
+
+/** The `k` smallest scores seen so far, kept in a max-heap. */
+template <typename IdxT>
+class topk {
+ public:
+  explicit topk(uint32_t k) : k_(k) { heap_.reserve(k); }
+
+  void clear() { heap_.clear(); }
+
+  /** Anything not smaller than this cannot enter the top-k. */
+  [[nodiscard]] inline auto threshold() const -> float
+  {
+    return heap_.size() < k_ ? std::numeric_limits<float>::max() : heap_.front().first;
+  }
+
+  inline void push(float score, IdxT id)
+  {
+    if (heap_.size() < k_) {
+      heap_.emplace_back(score, id);
+      std::push_heap(heap_.begin(), heap_.end());
+    } else if (score < heap_.front().first) {
+      std::pop_heap(heap_.begin(), heap_.end());
+      heap_.back() = {score, id};
+      std::push_heap(heap_.begin(), heap_.end());
+    }
+  }
+
+  /** Write the sorted results [k]; the missing ones are marked by the max id and distance. */
+  void write(raft::distance::DistanceType metric, IdxT* neighbors, float* distances)
+  {
+    std::sort_heap(heap_.begin(), heap_.end());
+    for (uint32_t i = 0; i < k_; i++) {
+      if (i < heap_.size()) {
+        neighbors[i] = heap_[i].second;
+        distances[i] = postprocess_distance(metric, heap_[i].first);
+      } else {
+        neighbors[i] = std::numeric_limits<IdxT>::max();
+        distances[i] = metric == raft::distance::DistanceType::InnerProduct
+                         ? std::numeric_limits<float>::lowest()
+                         : std::numeric_limits<float>::max();
+      }
+    }
+  }
+
+ private:
+  uint32_t k_;
+  std::vector<std::pair<float, IdxT>> heap_;
+};
+
+}  // namespace raft::neighbors::detail::ivf_host
@@ -30,6 +30,9 @@
 #include <raft/linalg/gemm.cuh>
 #include <raft/linalg/map.cuh>
 #include <raft/linalg/norm.cuh>
+#include <raft/linalg/normalize.cuh>
+#include <raft/linalg/subtract.cuh>
+#include <raft/linalg/svd.cuh>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/matrix/gather.cuh>
 #include <raft/matrix/linewise_op.cuh>
@@ -49,6 +52,7 @@
 #include <rmm/cuda_stream_view.hpp>
 #include <rmm/device_uvector.hpp>
 #include <rmm/mr/device/managed_memory_resource.hpp>
+#include <rmm/mr/pinned_host_memory_resource.hpp>
 #include <rmm/resource_ref.hpp>
 
 #include <cuda_fp16.h>
@@ -391,6 +395,181 @@ void transpose_pq_centers(const resources& handle,
   });
 }
 
+/**
+ * The anisotropic (score-aware) quantization loss of approximating the residual chunk `x` by the
+ * codebook entry `c` (Guo et al., "Accelerating Large-Scale Inference with Anisotropic Vector
+ * Quantization", ICML 2020):
+ *
+ *   |x - c|^2 + (eta - 1) * <u, x - c>^2,
+ *
+ * where `u` is the matching chunk of the normalized data vector. With `eta > 1`, the component of
+ * the error parallel to the data vector, which affects the large inner products the most, is
+ * penalized more than the orthogonal one.
+ */
+__device__ inline auto anisotropic_loss(
+  const float* x, const float* u, const float* c, uint32_t pq_len, float eta) -> float
+{
+  float l2   = 0.0f;
+  float proj = 0.0f;
+  for (uint32_t k = 0; k < pq_len; k++) {
+    auto t = x[k] - c[k];
+    l2 += t * t;
+    proj += u[k] * t;
+  }
+  return l2 + (eta - 1.0f) * proj * proj;
+}
+
+/** Assign every vector to the codebook entry with the smallest anisotropic loss. */
+RAFT_KERNEL anisotropic_assign_kernel(const float* vectors,     // [n_rows, pq_len]
+                                      const float* directions,  // [n_rows, dir_stride]
+                                      uint32_t dir_stride,
+                                      const float* centers,  // [pq_book_size, pq_len]
+                                      size_t n_rows,
+                                      uint32_t pq_book_size,
+                                      uint32_t pq_len,
+                                      float eta,
+                                      uint32_t* labels)  // [n_rows]
+{
+  const size_t i = size_t(blockIdx.x) * size_t(blockDim.x) + size_t(threadIdx.x);
+  if (i >= n_rows) { return; }
+  const float* x = vectors + i * pq_len;
+  const float* u = directions + i * dir_stride;
+  float min_loss = std::numeric_limits<float>::infinity();
+  uint32_t label = 0;
+  for (uint32_t l = 0; l < pq_book_size; l++) {
+    auto loss = anisotropic_loss(x, u, centers + size_t(l) * pq_len, pq_len, eta);
+    if (loss < min_loss) {
+      min_loss = loss;
+      label    = l;
+    }
+  }
+  labels[i] = label;
+}
+
+/**
+ * Accumulate the gradients of the (halved) anisotropic loss w.r.t. the codebook entries, along with
+ * the per-entry upper bounds of the Hessian eigenvalues, `sum(1 + max(eta - 1, 0) * |u|^2)`.
+ */
+RAFT_KERNEL anisotropic_gradient_kernel(const float* vectors,     // [n_rows, pq_len]
+                                        const float* directions,  // [n_rows, dir_stride]
+                                        uint32_t dir_stride,
+                                        const float* centers,    // [pq_book_size, pq_len]
+                                        const uint32_t* labels,  // [n_rows]
+                                        size_t n_rows,
+                                        uint32_t pq_len,
+                                        float eta,
+                                        float* gradients,  // [pq_book_size, pq_len]
+                                        float* weights)    // [pq_book_size]
+{
+  const size_t i = size_t(blockIdx.x) * size_t(blockDim.x) + size_t(threadIdx.x);
+  if (i >= n_rows) { return; }
+  const uint32_t l = labels[i];
+  const float* x   = vectors + i * pq_len;
+  const float* u   = directions + i * dir_stride;
+  const float* c   = centers + size_t(l) * pq_len;
+  float proj       = 0.0f;
+  float u_norm     = 0.0f;
+  for (uint32_t k = 0; k < pq_len; k++) {
+    proj += u[k] * (c[k] - x[k]);
+    u_norm += u[k] * u[k];
+  }
+  proj *= eta - 1.0f;
+  for (uint32_t k = 0; k < pq_len; k++) {
+    atomicAdd(gradients + size_t(l) * pq_len + k, c[k] - x[k] + proj * u[k]);
+  }
+  atomicAdd(weights + l, 1.0f + std::max(eta - 1.0f, 0.0f) * u_norm);
+}
+
+/**
+ * Refine a PQ codebook, trained with the L2 k-means, to minimize the anisotropic loss (see
+ * `anisotropic_loss`) instead of the reconstruction error.
+ *
+ * Every iteration reassigns the vectors to the codebook entries and moves the entries by a gradient
+ * step scaled by the inverse of an upper bound of the Hessian eigenvalues; hence the loss never
+ * increases. In the common case `|u|^2 << 1` (a chunk of a unit vector), the Hessian is close to a
+ * scaled identity and a single step is almost the exact minimizer.
+ *
+ * @param[in] eta the ratio of the parallel and the orthogonal loss weights
+ * @param[in] n_iters the number of refinement iterations
+ * @param[in] vectors the training residual chunks [n_rows, pq_len]
+ * @param[in] directions the matching chunks of the normalized data vectors [n_rows, dir_stride]
+ * @param[inout] centers the codebook [pq_book_size, pq_len]
+ * @param[out] labels the workspace for the assignment [n_rows]
+ */
+inline void refine_anisotropic_codebook(raft::resources const& handle,
+                                        float eta,
+                                        uint32_t n_iters,
+                                        size_t n_rows,
+                                        uint32_t pq_len,
+                                        uint32_t pq_book_size,
+                                        const float* vectors,
+                                        const float* directions,
+                                        uint32_t dir_stride,
+                                        float* centers,
+                                        uint32_t* labels,
+                                        rmm::device_async_resource_ref device_memory)
+{
+  if (n_rows == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<float> gradients(size_t(pq_book_size) * pq_len, stream, device_memory);
+  rmm::device_uvector<float> weights(pq_book_size, stream, device_memory);
+
+  constexpr uint32_t kBlockSize = 256;
+  const dim3 blocks(raft::div_rounding_up_safe<size_t>(n_rows, kBlockSize), 1, 1);
+  const dim3 threads(kBlockSize, 1, 1);
+  auto centers_view = raft::make_device_vector_view<float, size_t>(centers, gradients.size());
+  for (uint32_t iter = 0; iter < n_iters; iter++) {
+    anisotropic_assign_kernel<<<blocks, threads, 0, stream>>>(
+      vectors, directions, dir_stride, centers, n_rows, pq_book_size, pq_len, eta, labels);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    RAFT_CUDA_TRY(cudaMemsetAsync(gradients.data(), 0, sizeof(float) * gradients.size(), stream));
+    RAFT_CUDA_TRY(cudaMemsetAsync(weights.data(), 0, sizeof(float) * weights.size(), stream));
+    anisotropic_gradient_kernel<<<blocks, threads, 0, stream>>>(vectors,
+                                                                directions,
+                                                                dir_stride,
+                                                                centers,
+                                                                labels,
+                                                                n_rows,
+                                                                pq_len,
+                                                                eta,
+                                                                gradients.data(),
+                                                                weights.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // The entries without vectors have zero gradients and weights and stay in place.
+    linalg::map_offset(
+      handle,
+      centers_view,
+      [centers, g = gradients.data(), w = weights.data(), pq_len] __device__(size_t i) {
+        auto weight = w[i / pq_len];
+        return weight > 0.0f ? centers[i] - g[i] / weight : centers[i];
+      });
+  }
+}
+
+/**
+ * Normalize the rotated vectors in place: these are the directions of the anisotropic loss (see
+ * `anisotropic_loss`) [n_rows, rot_dim].
+ */
+inline void normalize_anisotropic_directions(raft::resources const& handle,
+                                             size_t n_rows,
+                                             uint32_t rot_dim,
+                                             float* directions)
+{
+  auto view = raft::make_device_matrix_view<float, size_t>(directions, n_rows, rot_dim);
+  raft::linalg::row_normalize(handle, raft::make_const_mdspan(view), view, raft::linalg::L2Norm);
+}
+
+/**
+ * Train the PQ codebooks of all subspaces.
+ *
+ * If `anisotropic_eta != 1`, the codebooks are refined to minimize the anisotropic loss (see
+ * `refine_anisotropic_codebook`).
+ *
+ * If `reconstruction` is not null, it receives the quantized rotated residuals of the trainset
+ * [n_rows, rot_dim], i.e. the closest codebook entries of every subspace.
+ */
 template <typename IdxT>
 void train_per_subset(raft::resources const& handle,
                       index<IdxT>& index,
@@ -398,7 +577,9 @@ void train_per_subset(raft::resources const& handle,
                       const float* trainset,   // [n_rows, dim]
                       const uint32_t* labels,  // [n_rows]
                       uint32_t kmeans_n_iters,
-                      rmm::device_async_resource_ref managed_memory)
+                      float anisotropic_eta,
+                      rmm::device_async_resource_ref managed_memory,
+                      float* reconstruction = nullptr)  // [n_rows, rot_dim]
 {
   auto stream        = resource::get_cuda_stream(handle);
   auto device_memory = resource::get_workspace_resource(handle);
@@ -409,6 +590,31 @@ void train_per_subset(raft::resources const& handle,
 
   rmm::device_uvector<uint32_t> pq_cluster_sizes(index.pq_book_size(), stream, device_memory);
 
+  // The directions of the anisotropic loss: the rotated and normalized trainset.
+  const bool anisotropic = anisotropic_eta != 1.0f;
+  rmm::device_uvector<float> directions(
+    anisotropic ? n_rows * size_t(index.rot_dim()) : 0, stream, device_memory);
+  if (anisotropic) {
+    float alpha = 1.0;
+    float beta  = 0.0;
+    linalg::gemm(handle,
+                 true,
+                 false,
+                 index.rot_dim(),
+                 n_rows,
+                 index.dim(),
+                 &alpha,
+                 index.rotation_matrix().data_handle(),
+                 index.dim(),
+                 trainset,
+                 index.dim(),
+                 &beta,
+                 directions.data(),
+                 index.rot_dim(),
+                 stream);
+    normalize_anisotropic_directions(handle, n_rows, index.rot_dim(), directions.data());
+  }
+
   for (uint32_t j = 0; j < index.pq_dim(); j++) {
     common::nvtx::range<common::nvtx::domain::raft> pq_per_subspace_scope(
       "ivf_pq::build::per_subspace[%u]", j);
@@ -465,10 +671,144 @@ void train_per_subset(raft::resources const& handle,
                                                             sub_labels_view,
                                                             cluster_sizes_view,
                                                             utils::mapping<float>{});
+    if (anisotropic) {
+      refine_anisotropic_codebook(handle,
+                                  anisotropic_eta,
+                                  kmeans_n_iters,
+                                  n_rows,
+                                  index.pq_len(),
+                                  index.pq_book_size(),
+                                  sub_trainset.data(),
+                                  directions.data() + index.pq_len() * j,
+                                  index.rot_dim(),
+                                  centers_tmp_view.data_handle(),
+                                  sub_labels.data(),
+                                  device_memory);
+    }
+
+    if (reconstruction != nullptr) {
+      auto centers_const_view = raft::make_device_matrix_view<const float, internal_extents_t>(
+        centers_tmp_view.data_handle(), index.pq_book_size(), index.pq_len());
+      raft::cluster::kmeans_balanced::predict(handle,
+                                              kmeans_params,
+                                              sub_trainset_view,
+                                              centers_const_view,
+                                              sub_labels_view,
+                                              utils::mapping<float>{});
+      utils::copy_selected<float, float, size_t, uint32_t>(n_rows,
+                                                           index.pq_len(),
+                                                           centers_tmp_view.data_handle(),
+                                                           sub_labels.data(),
+                                                           index.pq_len(),
+                                                           reconstruction + index.pq_len() * j,
+                                                           index.rot_dim(),
+                                                           stream);
+    }
   }
   transpose_pq_centers(handle, index, pq_centers_tmp.data());
 }
 
+/**
+ * Optimized product quantization (OPQ): learn the rotation matrix of the index by alternating the
+ * training of the per-subspace PQ codebooks with the rotation minimizing the quantization error of
+ * the residuals `x - center` of the trainset (orthogonal Procrustes problem). The rotation matrix
+ * and the rotated centers of the index are updated in place; the codebooks have to be re-trained
+ * afterwards.
+ */
+template <typename IdxT>
+void train_opq_rotation(raft::resources const& handle,
+                        index<IdxT>& index,
+                        size_t n_rows,
+                        const float* trainset,         // [n_rows, dim]
+                        const uint32_t* labels,        // [n_rows]
+                        const float* cluster_centers,  // [n_lists, dim]
+                        uint32_t kmeans_n_iters,
+                        uint32_t opq_n_iters,
+                        rmm::device_async_resource_ref managed_memory)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::train_opq_rotation(%zu, %u)", n_rows, opq_n_iters);
+  auto stream         = resource::get_cuda_stream(handle);
+  auto device_memory  = resource::get_workspace_resource(handle);
+  const uint32_t dim  = index.dim();
+  const uint32_t rdim = index.rot_dim();
+
+  // The residuals of the trainset in the original space.
+  rmm::device_uvector<float> residuals(n_rows * dim, stream, device_memory);
+  utils::copy_selected<float, float, size_t, uint32_t>(
+    n_rows, dim, cluster_centers, labels, dim, residuals.data(), dim, stream);
+  linalg::subtract(residuals.data(), trainset, residuals.data(), n_rows * dim, stream);
+
+  rmm::device_uvector<float> reconstruction(n_rows * rdim, stream, device_memory);
+  rmm::device_uvector<float> correlation(size_t(rdim) * dim, stream, device_memory);
+  rmm::device_uvector<float> sing_vals(dim, stream, device_memory);
+  rmm::device_uvector<float> left_vecs(size_t(rdim) * dim, stream, device_memory);
+  rmm::device_uvector<float> right_vecs_t(size_t(dim) * dim, stream, device_memory);
+
+  for (uint32_t iter = 0; iter < opq_n_iters; iter++) {
+    train_per_subset(handle,
+                     index,
+                     n_rows,
+                     trainset,
+                     labels,
+                     kmeans_n_iters,
+                     1.0f,  // OPQ minimizes the reconstruction error
+                     managed_memory,
+                     reconstruction.data());
+
+    // The column-major correlation `reconstruction^T * residuals` [rot_dim, dim].
+    float alpha = 1.0;
+    float beta  = 0.0;
+    linalg::gemm(handle,
+                 false,
+                 true,
+                 rdim,
+                 dim,
+                 n_rows,
+                 &alpha,
+                 reconstruction.data(),
+                 rdim,
+                 residuals.data(),
+                 dim,
+                 &beta,
+                 correlation.data(),
+                 rdim,
+                 stream);
+
+    // With the SVD `correlation = U * S * V^T`, the optimal rotation is `U * V^T`.
+    linalg::svdQR(handle,
+                  correlation.data(),
+                  rdim,
+                  dim,
+                  sing_vals.data(),
+                  left_vecs.data(),
+                  right_vecs_t.data(),
+                  false,
+                  true,
+                  true,
+                  stream);
+    // The row-major rotation matrix [rot_dim, dim] is the column-major `(U * V^T)^T`.
+    linalg::gemm(handle,
+                 true,
+                 true,
+                 dim,
+                 rdim,
+                 dim,
+                 &alpha,
+                 right_vecs_t.data(),
+                 dim,
+                 left_vecs.data(),
+                 rdim,
+                 &beta,
+                 index.rotation_matrix().data_handle(),
+                 dim,
+                 stream);
+
+    // Rotate the centers accordingly.
+    set_centers(handle, &index, cluster_centers);
+  }
+}
+
 template <typename IdxT>
 void train_per_cluster(raft::resources const& handle,
                        index<IdxT>& index,
@@ -476,6 +816,7 @@ void train_per_cluster(raft::resources const& handle,
                        const float* trainset,   // [n_rows, dim]
                        const uint32_t* labels,  // [n_rows]
                        uint32_t kmeans_n_iters,
+                       float anisotropic_eta,
                        rmm::device_async_resource_ref managed_memory)
 {
   auto stream        = resource::get_cuda_stream(handle);
@@ -505,6 +846,16 @@ void train_per_cluster(raft::resources const& handle,
   rmm::device_uvector<float> rot_vectors(
     size_t(max_cluster_size) * size_t(index.rot_dim()), stream, device_memory);
 
+  // The directions of the anisotropic loss: the rotated and normalized cluster members, obtained as
+  // the residuals w.r.t. the origin.
+  const bool anisotropic = anisotropic_eta != 1.0f;
+  rmm::device_uvector<float> directions(
+    anisotropic ? size_t(max_cluster_size) * size_t(index.rot_dim()) : 0, stream, device_memory);
+  rmm::device_uvector<float> origin(anisotropic ? index.dim() : 0, stream, device_memory);
+  if (anisotropic) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(origin.data(), 0, sizeof(float) * origin.size(), stream));
+  }
+
   resource::sync_stream(handle);  // make sure cluster offsets are up-to-date
   for (uint32_t l = 0; l < index.n_lists(); l++) {
     auto cluster_size = cluster_sizes.data()[l];
@@ -522,6 +873,19 @@ void train_per_cluster(raft::resources const& handle,
                      trainset,
                      indices + cluster_offsets[l],
                      device_memory);
+    if (anisotropic) {
+      select_residuals(handle,
+                       directions.data(),
+                       IdxT(cluster_size),
+                       index.dim(),
+                       index.rot_dim(),
+                       index.rotation_matrix().data_handle(),
+                       origin.data(),
+                       trainset,
+                       indices + cluster_offsets[l],
+                       device_memory);
+      normalize_anisotropic_directions(handle, cluster_size, index.rot_dim(), directions.data());
+    }
 
     // limit the cluster size to bound the training time.
     // [sic] we interpret the data as pq_len-dimensional
@@ -550,6 +914,21 @@ void train_per_cluster(raft::resources const& handle,
                                                             pq_labels_view,
                                                             pq_cluster_sizes_view,
                                                             utils::mapping<float>{});
+    if (anisotropic) {
+      // Both the residuals and the directions are interpreted as [pq_n_rows, pq_len].
+      refine_anisotropic_codebook(handle,
+                                  anisotropic_eta,
+                                  kmeans_n_iters,
+                                  pq_n_rows,
+                                  index.pq_len(),
+                                  index.pq_book_size(),
+                                  rot_vectors.data(),
+                                  directions.data(),
+                                  index.pq_len(),
+                                  centers_tmp_view.data_handle(),
+                                  pq_labels.data(),
+                                  device_memory);
+    }
   }
   transpose_pq_centers(handle, index, pq_centers_tmp.data());
 }
@@ -1447,6 +1826,31 @@ void erase_list(raft::resources const& res, index<IdxT>* index, uint32_t label)
   ivf::detail::recompute_internal_state(res, *index);
 }
 
+/**
+ * Move the data and indices of all lists to the pinned host memory.
+ * See the public interface for the api and usage.
+ */
+template <typename IdxT>
+void move_lists_to_host(raft::resources const& res, index<IdxT>* index)
+{
+  // The resource outlives all indexes, as the lists keep a reference to it.
+  static rmm::mr::pinned_host_memory_resource pinned_mr{};
+  auto stream = resource::get_cuda_stream(res);
+  for (auto& list : index->lists()) {
+    if (!list) { continue; }
+    auto data    = make_device_mdarray<uint8_t>(res, pinned_mr, list->data.extents());
+    auto indices = make_device_mdarray<IdxT>(res, pinned_mr, list->indices.extents());
+    copy(data.data_handle(), list->data.data_handle(), data.size(), stream);
+    copy(indices.data_handle(), list->indices.data_handle(), indices.size(), stream);
+    // Release the device memory list by list, so that the device never holds two copies.
+    resource::sync_stream(res);
+    list->data    = std::move(data);
+    list->indices = std::move(indices);
+  }
+  index->set_host_lists(true);
+  ivf::detail::recompute_internal_state(res, *index);
+}
+
 /** Copy the state of an index into a new index, but share the list data among the two. */
 template <typename IdxT>
 auto clone(const raft::resources& res, const index<IdxT>& source) -> index<IdxT>
@@ -1486,6 +1890,7 @@ auto clone(const raft::resources& res, const index<IdxT>& source) -> index<IdxT>
 
   // Copy shared pointers
   target.lists() = source.lists();
+  target.set_host_lists(source.host_lists());
 
   // Make sure the device pointers point to the new lists
   ivf::detail::recompute_internal_state(res, target);
@@ -1493,6 +1898,46 @@ auto clone(const raft::resources& res, const index<IdxT>& source) -> index<IdxT>
   return target;
 }
 
+/** Classify the data of `vec_batches` by the nearest cluster center of the index. */
+template <typename T, typename IdxT>
+void predict_labels(raft::resources const& handle,
+                    const index<IdxT>& index,
+                    utils::batch_load_iterator<T>& vec_batches,
+                    uint32_t* labels,
+                    rmm::device_async_resource_ref device_memory)
+{
+  auto stream           = resource::get_cuda_stream(handle);
+  const auto n_clusters = index.n_lists();
+  // The cluster centers in the index are stored padded, which is not acceptable by
+  // the kmeans_balanced::predict. Thus, we need the restructuring copy.
+  rmm::device_uvector<float> cluster_centers(
+    size_t(n_clusters) * size_t(index.dim()), stream, device_memory);
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(cluster_centers.data(),
+                                  sizeof(float) * index.dim(),
+                                  index.centers().data_handle(),
+                                  sizeof(float) * index.dim_ext(),
+                                  sizeof(float) * index.dim(),
+                                  n_clusters,
+                                  cudaMemcpyDefault,
+                                  stream));
+  for (const auto& batch : vec_batches) {
+    auto batch_data_view = raft::make_device_matrix_view<const T, internal_extents_t>(
+      batch.data(), batch.size(), index.dim());
+    auto batch_labels_view = raft::make_device_vector_view<uint32_t, internal_extents_t>(
+      labels + batch.offset(), batch.size());
+    auto centers_view = raft::make_device_matrix_view<const float, internal_extents_t>(
+      cluster_centers.data(), n_clusters, index.dim());
+    raft::cluster::kmeans_balanced_params kmeans_params;
+    kmeans_params.metric = index.metric();
+    raft::cluster::kmeans_balanced::predict(handle,
+                                            kmeans_params,
+                                            batch_data_view,
+                                            centers_view,
+                                            batch_labels_view,
+                                            utils::mapping<float>{});
+  }
+}
+
 /**
  * Extend the index in-place.
  * See raft::spatial::knn::ivf_pq::extend docs.
@@ -1577,36 +2022,7 @@ void extend(raft::resources const& handle,
   // temporary buffers before we allocate the index data.
   // This memory could potentially speed up UVM accesses, if any.
   placeholder_list.reset();
-  {
-    // The cluster centers in the index are stored padded, which is not acceptable by
-    // the kmeans_balanced::predict. Thus, we need the restructuring copy.
-    rmm::device_uvector<float> cluster_centers(
-      size_t(n_clusters) * size_t(index->dim()), stream, device_memory);
-    RAFT_CUDA_TRY(cudaMemcpy2DAsync(cluster_centers.data(),
-                                    sizeof(float) * index->dim(),
-                                    index->centers().data_handle(),
-                                    sizeof(float) * index->dim_ext(),
-                                    sizeof(float) * index->dim(),
-                                    n_clusters,
-                                    cudaMemcpyDefault,
-                                    stream));
-    for (const auto& batch : vec_batches) {
-      auto batch_data_view = raft::make_device_matrix_view<const T, internal_extents_t>(
-        batch.data(), batch.size(), index->dim());
-      auto batch_labels_view = raft::make_device_vector_view<uint32_t, internal_extents_t>(
-        new_data_labels.data() + batch.offset(), batch.size());
-      auto centers_view = raft::make_device_matrix_view<const float, internal_extents_t>(
-        cluster_centers.data(), n_clusters, index->dim());
-      raft::cluster::kmeans_balanced_params kmeans_params;
-      kmeans_params.metric = index->metric();
-      raft::cluster::kmeans_balanced::predict(handle,
-                                              kmeans_params,
-                                              batch_data_view,
-                                              centers_view,
-                                              batch_labels_view,
-                                              utils::mapping<float>{});
-    }
-  }
+  predict_labels(handle, *index, vec_batches, new_data_labels.data(), device_memory);
 
   auto list_sizes = index->list_sizes().data_handle();
   // store the current cluster sizes, because we'll need them later
@@ -1693,6 +2109,18 @@ auto build(raft::resources const& handle,
   RAFT_EXPECTS(n_rows > 0 && dim > 0, "empty dataset");
   RAFT_EXPECTS(n_rows >= params.n_lists, "number of rows can't be less than n_lists");
 
+  // The ratio of the parallel and the orthogonal weights of the anisotropic loss (Theorem 3.3 of
+  // Guo et al., 2020); `eta = 1` is the plain reconstruction error.
+  float anisotropic_eta = 1.0f;
+  if (params.anisotropic_quantization_threshold > 0.0f) {
+    RAFT_EXPECTS(params.metric == distance::DistanceType::InnerProduct,
+                 "The anisotropic quantization is only supported with the inner product metric");
+    RAFT_EXPECTS(params.anisotropic_quantization_threshold < 1.0f,
+                 "The anisotropic quantization threshold must be less than one");
+    auto t          = params.anisotropic_quantization_threshold;
+    anisotropic_eta = float(dim - 1) * t * t / (1.0f - t * t);
+  }
+
   auto stream = resource::get_cuda_stream(handle);
 
   index<IdxT> index(handle, params, dim);
@@ -1803,6 +2231,20 @@ auto build(raft::resources const& handle,
 
     set_centers(handle, &index, cluster_centers);
 
+    if (params.opq_n_iters > 0) {
+      RAFT_EXPECTS(index.codebook_kind() == codebook_gen::PER_SUBSPACE,
+                   "OPQ training is only supported with codebook_gen::PER_SUBSPACE");
+      train_opq_rotation(handle,
+                         index,
+                         n_rows_train,
+                         trainset.data(),
+                         labels.data(),
+                         cluster_centers,
+                         params.kmeans_n_iters,
+                         params.opq_n_iters,
+                         &managed_memory_upstream);
+    }
+
     // Train PQ codebooks
     switch (index.codebook_kind()) {
       case codebook_gen::PER_SUBSPACE:
@@ -1812,6 +2254,7 @@ auto build(raft::resources const& handle,
                          trainset.data(),
                          labels.data(),
                          params.kmeans_n_iters,
+                         anisotropic_eta,
                          &managed_memory_upstream);
         break;
       case codebook_gen::PER_CLUSTER:
@@ -1821,6 +2264,7 @@ auto build(raft::resources const& handle,
                           trainset.data(),
                           labels.data(),
                           params.kmeans_n_iters,
+                          anisotropic_eta,
                           &managed_memory_upstream);
         break;
       default: RAFT_FAIL("Unreachable code");
@@ -25,6 +25,7 @@
 #include <raft/util/device_atomics.cuh>            // raft::atomicMin
 #include <raft/util/pow2_utils.cuh>                // raft::Pow2
 #include <raft/util/vectorized.cuh>                // raft::TxN_t
+#include <raft/util/warp_primitives.cuh>           // raft::shfl, raft::laneId
 
 #include <rmm/cuda_stream_view.hpp>  // rmm::cuda_stream_view
 
@@ -188,6 +189,62 @@ __device__ auto ivfpq_compute_score(uint32_t pq_dim,
   return score;
 }
 
+/**
+ * Compute the similarity for one vector in the pq_dataset when `PqBits == 4`, keeping the lookup
+ * table of the current chunk of subspaces in registers.
+ *
+ * A chunk of a 4-bit record holds the codes of 32 subspaces. The LUT rows of two subspaces
+ * (2 x 16 entries) fill exactly one register across the warp, so the warp loads the LUT of the
+ * chunk with 16 coalesced reads and resolves every lookup with a warp shuffle. This halves the
+ * shared memory traffic of the scan, which otherwise performs one read per code and thread.
+ *
+ * All lanes of the warp must call the function together; the lanes with `active == false` compute
+ * a meaningless score, but do not prevent the warp-wide early stop.
+ */
+template <typename OutT, typename LutT, typename VecT>
+__device__ auto ivfpq_compute_score_4bit(uint32_t pq_dim,
+                                         const typename VecT::io_t* pq_head,
+                                         const LutT* lut_scores,
+                                         OutT early_stop_limit,
+                                         bool active) -> OutT
+{
+  constexpr uint32_t kPqBits       = 4;
+  constexpr uint32_t kPqShift      = 1u << kPqBits;
+  constexpr uint32_t kPqMask       = kPqShift - 1u;
+  constexpr uint32_t kChunkSize    = sizeof(VecT) * 8u / kPqBits;
+  constexpr uint32_t kCodesPerWord = sizeof(typename VecT::math_t) * 8u / kPqBits;
+  static_assert(2 * kPqShift == WarpSize, "Two LUT rows must fill the warp");
+  const uint32_t lane     = laneId();
+  const uint32_t lut_size = pq_dim << kPqBits;
+  VecT pq_codes;
+  OutT score{0};
+  for (uint32_t chunk_start = 0; chunk_start < pq_dim; chunk_start += kChunkSize) {
+    *pq_codes.vectorized_data() = *pq_head;
+    pq_head += kIndexGroupSize;
+    // The LUT entry `code` of the subspace `chunk_start + j` is kept by the lane
+    // `code + (j % 2) * kPqShift` in `lut_regs[j / 2]`.
+    float lut_regs[kChunkSize / 2];
+    const uint32_t lut_offset = chunk_start << kPqBits;
+#pragma unroll
+    for (uint32_t j = 0; j < kChunkSize / 2; j++) {
+      const uint32_t ix = lut_offset + j * WarpSize + lane;
+      lut_regs[j]       = ix < lut_size ? float(lut_scores[ix]) : 0.0f;
+    }
+    const uint32_t n_codes = min(kChunkSize, pq_dim - chunk_start);
+#pragma unroll
+    for (uint32_t j = 0; j < kChunkSize; j++) {
+      // NB: `n_codes` is the same for the whole warp.
+      if (j >= n_codes) { break; }
+      const uint32_t code =
+        (pq_codes.val.data[j / kCodesPerWord] >> ((j % kCodesPerWord) * kPqBits)) & kPqMask;
+      score += OutT(shfl(lut_regs[j / 2], code + (j % 2) * kPqShift));
+    }
+    // Early stop when it makes sense (otherwise early_stop_limit is kDummy/infinity).
+    if (__all_sync(0xffffffffu, !active || score >= early_stop_limit)) { break; }
+  }
+  return score;
+}
+
 /**
  * The main kernel that computes similarity scores across multiple queries and probes.
  * When `Capacity > 0`, it also selects top K candidates for each query and probe
@@ -478,13 +535,28 @@ RAFT_KERNEL compute_similarity_kernel(uint32_t dim,
          i += blockDim.x, pq_thread_data += pq_line_width) {
       OutT score = kDummy;
       bool valid = i < n_samples;
-      // Check bounds and that the sample is acceptable for the query
-      if (valid && sample_filter(queries_offset + query_ix, label, i)) {
-        score = ivfpq_compute_score<OutT, LutT, vec_t, PqBits>(
-          pq_dim,
-          reinterpret_cast<const vec_t::io_t*>(pq_thread_data),
-          lut_scores,
-          early_stop_limit);
+      if constexpr (PqBits == 4) {
+        // The lookups are shared by the warp: every lane takes part, whatever its sample is
+        // (NB: the loop bound is the same for the whole warp and the records are allocated in
+        // groups of kIndexGroupSize, so reading past n_samples is safe).
+        const bool active = valid && sample_filter(queries_offset + query_ix, label, i);
+        const OutT warp_score =
+          ivfpq_compute_score_4bit<OutT, LutT, vec_t>(pq_dim,
+                                                      reinterpret_cast<const vec_t::io_t*>(
+                                                        pq_thread_data),
+                                                      lut_scores,
+                                                      early_stop_limit,
+                                                      active);
+        if (active) { score = warp_score; }
+      } else {
+        // Check bounds and that the sample is acceptable for the query
+        if (valid && sample_filter(queries_offset + query_ix, label, i)) {
+          score = ivfpq_compute_score<OutT, LutT, vec_t, PqBits>(
+            pq_dim,
+            reinterpret_cast<const vec_t::io_t*>(pq_thread_data),
+            lut_scores,
+            early_stop_limit);
+        }
       }
       if constexpr (kManageLocalTopK) {
         block_topk.add(score, sample_offset + i);
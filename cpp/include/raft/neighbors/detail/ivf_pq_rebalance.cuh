@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/kmeans_balanced.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/ivf_pq_build.cuh>
+#include <raft/neighbors/ivf_pq_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace raft::neighbors::ivf_pq::detail {
+
+/** See raft::neighbors::ivf_pq::rebalance docs */
+template <typename IdxT>
+auto rebalance(raft::resources const& handle, const rebalance_params& params, index<IdxT>* index)
+  -> uint32_t
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("ivf_pq::rebalance(%u)",
+                                                            index->n_lists());
+  RAFT_EXPECTS(params.max_list_size_ratio > 1.0, "max_list_size_ratio must be greater than one");
+  RAFT_EXPECTS(params.min_list_size_ratio < 1.0, "min_list_size_ratio must be less than one");
+
+  auto stream    = resource::get_cuda_stream(handle);
+  auto n_lists   = index->n_lists();
+  const auto dim = index->dim();
+
+  std::vector<uint32_t> list_sizes(n_lists);
+  raft::copy(list_sizes.data(), index->list_sizes().data_handle(), n_lists, stream);
+  resource::sync_stream(handle);
+  double mean_size = std::accumulate(list_sizes.begin(), list_sizes.end(), 0.0) / n_lists;
+
+  // Pair the largest lists with the smallest ones: the latter ones give up their slots.
+  std::vector<uint32_t> split_labels;
+  std::vector<uint32_t> merge_labels;
+  for (uint32_t l = 0; l < n_lists; l++) {
+    if (list_sizes[l] >= 2 && list_sizes[l] > params.max_list_size_ratio * mean_size) {
+      split_labels.push_back(l);
+    } else if (list_sizes[l] < params.min_list_size_ratio * mean_size) {
+      merge_labels.push_back(l);
+    }
+  }
+  std::sort(split_labels.begin(), split_labels.end(), [&list_sizes](uint32_t a, uint32_t b) {
+    return list_sizes[a] > list_sizes[b];
+  });
+  std::sort(merge_labels.begin(), merge_labels.end(), [&list_sizes](uint32_t a, uint32_t b) {
+    return list_sizes[a] < list_sizes[b];
+  });
+  size_t n_splits = std::min(split_labels.size(), merge_labels.size());
+  if (params.max_splits > 0) { n_splits = std::min<size_t>(n_splits, params.max_splits); }
+  if (n_splits == 0) { return 0; }
+  split_labels.resize(n_splits);
+  merge_labels.resize(n_splits);
+
+  // Decode the records of all the affected lists.
+  std::vector<uint32_t> affected_labels(split_labels);
+  affected_labels.insert(affected_labels.end(), merge_labels.begin(), merge_labels.end());
+  std::vector<IdxT> offsets(affected_labels.size() + 1, 0);
+  for (size_t i = 0; i < affected_labels.size(); i++) {
+    offsets[i + 1] = offsets[i] + list_sizes[affected_labels[i]];
+  }
+  const IdxT n_rows = offsets.back();
+  auto vectors      = make_device_matrix<float, IdxT>(handle, n_rows, dim);
+  auto indices      = make_device_vector<IdxT, IdxT>(handle, n_rows);
+  for (size_t i = 0; i < affected_labels.size(); i++) {
+    auto label = affected_labels[i];
+    auto size  = list_sizes[label];
+    if (size == 0) { continue; }
+    auto vectors_view = make_device_matrix_view<float, uint32_t>(
+      vectors.data_handle() + size_t(offsets[i]) * dim, size, dim);
+    reconstruct_list_data<float, IdxT>(handle, *index, vectors_view, label, uint32_t{0});
+    raft::copy(indices.data_handle() + offsets[i],
+               index->lists()[label]->indices.data_handle(),
+               size,
+               stream);
+  }
+
+  // Split every large list with the balanced k-means; the halves replace the large list and the
+  // small one. The PQ codebooks of the large lists are shared with their halves.
+  auto centers = make_device_matrix<float, uint32_t>(handle, n_lists, dim);
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(centers.data_handle(),
+                                  sizeof(float) * dim,
+                                  index->centers().data_handle(),
+                                  sizeof(float) * index->dim_ext(),
+                                  sizeof(float) * dim,
+                                  n_lists,
+                                  cudaMemcpyDefault,
+                                  stream));
+  auto split_centers = make_device_matrix<float, internal_extents_t>(handle, 2, dim);
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.n_iters = params.kmeans_n_iters;
+  kmeans_params.metric  = index->metric();
+  for (size_t i = 0; i < n_splits; i++) {
+    auto src       = split_labels[i];
+    auto dst       = merge_labels[i];
+    auto list_view = make_device_matrix_view<const float, internal_extents_t>(
+      vectors.data_handle() + size_t(offsets[i]) * dim, list_sizes[src], dim);
+    raft::cluster::kmeans_balanced::fit(
+      handle, kmeans_params, list_view, split_centers.view(), utils::mapping<float>{});
+    raft::copy(centers.data_handle() + size_t(src) * dim, split_centers.data_handle(), dim, stream);
+    raft::copy(
+      centers.data_handle() + size_t(dst) * dim, split_centers.data_handle() + dim, dim, stream);
+    if (index->codebook_kind() == codebook_gen::PER_CLUSTER) {
+      auto codebook_size = index->pq_centers().extent(1) * index->pq_centers().extent(2);
+      raft::copy(index->pq_centers().data_handle() + size_t(dst) * codebook_size,
+                 index->pq_centers().data_handle() + size_t(src) * codebook_size,
+                 codebook_size,
+                 stream);
+    }
+  }
+  set_centers(handle, index, centers.data_handle());
+
+  // Re-encode the decoded records w.r.t. the new centers; the records of the merged lists go to
+  // their closest lists, which may be any lists of the index.
+  for (auto label : affected_labels) {
+    erase_list(handle, index, label);
+  }
+  extend<float, IdxT>(handle, index, vectors.data_handle(), indices.data_handle(), n_rows);
+  return static_cast<uint32_t>(n_splits);
+}
+
+}  // namespace raft::neighbors::ivf_pq::detail
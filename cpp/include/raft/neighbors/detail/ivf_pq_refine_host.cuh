@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_event.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/detail/ivf_pq_search.cuh>
+#include <raft/neighbors/detail/refine_host.hpp>
+#include <raft/neighbors/ivf_pq_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace raft::neighbors::ivf_pq::detail {
+
+/** See raft::neighbors::ivf_pq::search_to_host docs */
+template <typename T, typename IdxT>
+void search_to_host(raft::resources const& handle,
+                    const search_params& params,
+                    const index<IdxT>& index,
+                    const T* queries,
+                    uint32_t n_queries,
+                    uint32_t k,
+                    IdxT* neighbors,
+                    float* distances)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+  rmm::device_uvector<IdxT> neighbors_dev(size_t(n_queries) * k, stream, mr);
+  rmm::device_uvector<float> distances_dev(size_t(n_queries) * k, stream, mr);
+  search<T, IdxT>(handle,
+                  params,
+                  index,
+                  queries,
+                  n_queries,
+                  k,
+                  neighbors_dev.data(),
+                  distances_dev.data(),
+                  raft::neighbors::filtering::none_ivf_sample_filter{});
+  raft::copy(neighbors, neighbors_dev.data(), neighbors_dev.size(), stream);
+  raft::copy(distances, distances_dev.data(), distances_dev.size(), stream);
+}
+
+/** The metric of the host refinement matching the metric of the index. */
+inline auto refine_host_metric(distance::DistanceType metric) -> distance::DistanceType
+{
+  switch (metric) {
+    case distance::DistanceType::L2Expanded:
+    case distance::DistanceType::L2Unexpanded: return distance::DistanceType::L2Expanded;
+    case distance::DistanceType::InnerProduct: return distance::DistanceType::InnerProduct;
+    default: RAFT_FAIL("The host refinement does not support the metric %d", int(metric));
+  }
+}
+
+/** See raft::neighbors::ivf_pq::search_refine_host docs */
+template <typename T, typename IdxT>
+void search_refine_host(raft::resources const& handle,
+                        const search_params& params,
+                        const index<IdxT>& index,
+                        raft::host_matrix_view<const T, IdxT, row_major> dataset,
+                        raft::host_matrix_view<const T, IdxT, row_major> queries,
+                        uint32_t n_candidates,
+                        raft::host_matrix_view<IdxT, IdxT, row_major> neighbors,
+                        raft::host_matrix_view<float, IdxT, row_major> distances,
+                        uint32_t batch_size)
+{
+  const IdxT n_queries = queries.extent(0);
+  const uint32_t dim   = index.dim();
+  const uint32_t k     = neighbors.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::search_refine_host(%zu, %u -> %u)", size_t(n_queries), n_candidates, k);
+  RAFT_EXPECTS(n_candidates >= k, "The number of candidates must not be smaller than k");
+  RAFT_EXPECTS(batch_size > 0, "The batch size must be positive");
+  const auto metric = refine_host_metric(index.metric());
+  if (n_queries == 0) { return; }
+
+  auto stream    = resource::get_cuda_stream(handle);
+  batch_size     = static_cast<uint32_t>(std::min<IdxT>(batch_size, n_queries));
+  auto n_batches = raft::div_rounding_up_safe<IdxT>(n_queries, batch_size);
+
+  // The batches are searched in the stream order, so a single set of device buffers is enough;
+  // the candidates are double-buffered on the host, as the CPU reranks one batch while the GPU
+  // fills the next one.
+  auto queries_dev    = make_device_matrix<T, int64_t>(handle, batch_size, dim);
+  auto candidates_dev = make_device_matrix<IdxT, int64_t>(handle, batch_size, n_candidates);
+  auto distances_dev  = make_device_matrix<float, int64_t>(handle, batch_size, n_candidates);
+  // The host reads the candidates only after the events recorded behind their copies, so the
+  // stream-ordered pinned workspace memory needs no extra synchronization.
+  rmm::device_uvector<IdxT> candidates_host(size_t(2) * batch_size * n_candidates,
+                                            stream,
+                                            resource::get_pinned_workspace_resource(handle));
+  std::array<resource::cuda_event_resource, 2> ready;
+  auto ready_event = [&ready](IdxT batch) {
+    return *static_cast<cudaEvent_t*>(ready[batch % 2].get_resource());
+  };
+  auto batch_rows = [=](IdxT batch) {
+    return std::min<IdxT>(batch_size, n_queries - batch * batch_size);
+  };
+
+  auto search_batch = [&](IdxT batch) {
+    auto offset = batch * batch_size;
+    auto rows   = batch_rows(batch);
+    raft::copy(queries_dev.data_handle(),
+               queries.data_handle() + size_t(offset) * dim,
+               size_t(rows) * dim,
+               stream);
+    search<T, IdxT>(handle,
+                    params,
+                    index,
+                    queries_dev.data_handle(),
+                    rows,
+                    n_candidates,
+                    candidates_dev.data_handle(),
+                    distances_dev.data_handle(),
+                    raft::neighbors::filtering::none_ivf_sample_filter{});
+    raft::copy(candidates_host.data() + size_t(batch % 2) * batch_size * n_candidates,
+               candidates_dev.data_handle(),
+               size_t(rows) * n_candidates,
+               stream);
+    RAFT_CUDA_TRY(cudaEventRecord(ready_event(batch), stream));
+  };
+
+  auto rerank_batch = [&](IdxT batch) {
+    auto offset = batch * batch_size;
+    auto rows   = batch_rows(batch);
+    RAFT_CUDA_TRY(cudaEventSynchronize(ready_event(batch)));
+    // The host refinement is instantiated for the int64_t extents only.
+    raft::neighbors::detail::refine_host<IdxT, T, float, int64_t>(
+      handle,
+      raft::make_host_matrix_view<const T, int64_t>(
+        dataset.data_handle(), dataset.extent(0), dataset.extent(1)),
+      raft::make_host_matrix_view<const T, int64_t>(
+        queries.data_handle() + size_t(offset) * dim, rows, dim),
+      raft::make_host_matrix_view<const IdxT, int64_t>(
+        candidates_host.data() + size_t(batch % 2) * batch_size * n_candidates,
+        rows,
+        n_candidates),
+      raft::make_host_matrix_view<IdxT, int64_t>(
+        neighbors.data_handle() + size_t(offset) * k, rows, k),
+      raft::make_host_matrix_view<float, int64_t>(
+        distances.data_handle() + size_t(offset) * k, rows, k),
+      metric);
+  };
+
+  // The buffer of the batch `b + 1` is the one of the batch `b - 1`, which is reranked before the
+  // search of `b + 1` is submitted.
+  for (IdxT batch = 0; batch < n_batches; batch++) {
+    search_batch(batch);
+    if (batch > 0) { rerank_batch(batch - 1); }
+  }
+  rerank_batch(n_batches - 1);
+}
+
+}  // namespace raft::neighbors::ivf_pq::detail
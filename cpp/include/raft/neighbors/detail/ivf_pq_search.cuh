@@ -22,6 +22,7 @@
 #include <raft/core/nvtx.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/custom_resource.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resource/device_properties.hpp>
@@ -29,6 +30,7 @@
 #include <raft/distance/distance_types.hpp>
 #include <raft/linalg/gemm.cuh>
 #include <raft/linalg/map.cuh>
+#include <raft/linalg/reduce.cuh>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/matrix/detail/select_k.cuh>
 #include <raft/matrix/detail/select_warpsort.cuh>
@@ -43,6 +45,7 @@
 #include <raft/util/device_atomics.cuh>
 #include <raft/util/device_loads_stores.cuh>
 #include <raft/util/pow2_utils.cuh>
+#include <raft/util/reduction.cuh>
 #include <raft/util/vectorized.cuh>
 
 #include <rmm/resource_ref.hpp>
@@ -50,22 +53,110 @@
 #include <cub/cub.cuh>
 #include <cuda_fp16.h>
 
+#include <algorithm>
+#include <array>
 #include <optional>
+#include <vector>
 
 namespace raft::neighbors::ivf_pq::detail {
 
 using namespace raft::spatial::knn::detail;  // NOLINT
 
+/** The largest batch for which `select_clusters` uses the fused kernel. */
+constexpr static inline uint32_t kSelectClustersFusedMaxQueries = 64;
+constexpr static inline uint32_t kSelectClustersFusedBlockDim   = 256;
+
+/**
+ * A fused version of `select_clusters` for small batches: one thread block per query converts
+ * the query to float, computes its distances to all cluster centers (see NOTE[qc_distances]) and
+ * selects the `n_probes` closest clusters, all without leaving the kernel.
+ *
+ * Every warp processes `WarpSize` clusters at a time, one cluster per lane: the lanes compute the
+ * dot products cooperatively (reading the centers in a coalesced manner), and each lane adds the
+ * distance to its cluster to the block-wide top-k queue.
+ */
+template <int Capacity, typename T>
+RAFT_KERNEL __launch_bounds__(kSelectClustersFusedBlockDim)
+  select_clusters_fused_kernel(uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                               float* cluster_dists,         // [n_queries, n_probes]
+                               float* float_queries,         // [n_queries, dim_ext]
+                               uint32_t n_probes,
+                               uint32_t n_lists,
+                               uint32_t dim,
+                               uint32_t dim_ext,
+                               float norm_factor,
+                               bool add_center_norms,
+                               const T* queries,              // [n_queries, dim]
+                               const float* cluster_centers)  // [n_lists, dim_ext]
+{
+  extern __shared__ __align__(256) uint8_t smem_buf[];
+  using block_sort_t = matrix::detail::select::warpsort::block_sort<
+    matrix::detail::select::warpsort::warp_sort_filtered,
+    Capacity,
+    true,
+    float,
+    uint32_t>;
+
+  const uint32_t query_ix = blockIdx.x;
+  queries += size_t(dim) * size_t(query_ix);
+  float_queries += size_t(dim_ext) * size_t(query_ix);
+  auto* query_smem = reinterpret_cast<float*>(smem_buf);  // [dim]
+  for (uint32_t i = threadIdx.x; i < dim_ext; i += blockDim.x) {
+    float x          = i < dim ? utils::mapping<float>{}(queries[i]) : norm_factor;
+    float_queries[i] = x;
+    if (i < dim) { query_smem[i] = x; }
+  }
+  __syncthreads();
+
+  block_sort_t queue(n_probes);
+  const uint32_t lane_id = threadIdx.x % WarpSize;
+  const uint32_t stride  = blockDim.x;
+  for (uint32_t base = threadIdx.x - lane_id; base < n_lists; base += stride) {
+    float dist          = block_sort_t::queue_t::kDummy;
+    const uint32_t n_in = min(uint32_t(WarpSize), n_lists - base);
+    for (uint32_t j = 0; j < n_in; j++) {
+      const float* center = cluster_centers + size_t(dim_ext) * size_t(base + j);
+      float dot           = 0;
+      for (uint32_t i = lane_id; i < dim; i += WarpSize) {
+        dot += query_smem[i] * center[i];
+      }
+      dot = warpReduce(dot);
+      if (lane_id == j) { dist = add_center_norms ? center[dim] - 2.0f * dot : -dot; }
+    }
+    queue.add(dist, base + lane_id);
+  }
+  // The queue merge reuses the shared memory holding the query.
+  __syncthreads();
+  queue.done(smem_buf);
+  queue.store(cluster_dists + size_t(n_probes) * size_t(query_ix),
+              clusters_to_probe + size_t(n_probes) * size_t(query_ix));
+}
+
+/** Pick the smallest queue capacity that fits `n_probes`. */
+template <int Capacity, typename T>
+auto select_clusters_fused_kernel_for(uint32_t n_probes)
+{
+  if constexpr (Capacity > WarpSize) {
+    if (n_probes * 2 <= Capacity) {
+      return select_clusters_fused_kernel_for<(Capacity / 2), T>(n_probes);
+    }
+  }
+  return select_clusters_fused_kernel<Capacity, T>;
+}
+
 /**
  * Select the clusters to probe and, as a side-effect, translate the queries type `T -> float`
  *
  * Assuming the number of clusters is not that big (a few thousands), we do a plain GEMM
- * followed by select_k to select the clusters to probe. There's no need to return the similarity
- * scores here.
+ * followed by select_k to select the clusters to probe. The similarity scores (see
+ * NOTE[qc_distances]) are returned in `cluster_dists`; they are sorted (the closest first) if
+ * `sorted` is set. Small batches are processed by a single fused kernel instead, to save on the
+ * launch latencies (see `select_clusters_fused_kernel`).
  */
 template <typename T>
 void select_clusters(raft::resources const& handle,
                      uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                     float* cluster_dists,         // [n_queries, n_probes]
                      float* float_queries,         // [n_queries, dim_ext]
                      uint32_t n_queries,
                      uint32_t n_probes,
@@ -75,6 +166,7 @@ void select_clusters(raft::resources const& handle,
                      raft::distance::DistanceType metric,
                      const T* queries,              // [n_queries, dim]
                      const float* cluster_centers,  // [n_lists, dim_ext]
+                     bool sorted,
                      rmm::device_async_resource_ref mr)
 {
   common::nvtx::range<common::nvtx::domain::raft> fun_scope(
@@ -102,7 +194,7 @@ void select_clusters(raft::resources const& handle,
 
       This is a negative inner-product distance. We minimize it to find the similar clusters.
 
-      NB: qc_distances is NOT used further in ivfpq_search.
+      NB: qc_distances is NOT used further in ivfpq_search, except for the adaptive probing.
  */
   float norm_factor;
   switch (metric) {
@@ -111,6 +203,34 @@ void select_clusters(raft::resources const& handle,
     case raft::distance::DistanceType::InnerProduct: norm_factor = 0.0; break;
     default: RAFT_FAIL("Unsupported distance type %d.", int(metric));
   }
+
+  // Small batches: avoid the separate launches of the conversion, GEMM, and select_k kernels.
+  const size_t fused_smem_size = std::max<size_t>(
+    sizeof(float) * dim,
+    matrix::detail::select::warpsort::calc_smem_size_for_block_wide<float, uint32_t>(
+      kSelectClustersFusedBlockDim / WarpSize, n_probes));
+  if (n_queries <= kSelectClustersFusedMaxQueries &&
+      n_probes <= matrix::detail::select::warpsort::kMaxCapacity &&
+      fused_smem_size <= resource::get_device_properties(handle).sharedMemPerBlock) {
+    auto kernel =
+      select_clusters_fused_kernel_for<matrix::detail::select::warpsort::kMaxCapacity, T>(
+        n_probes);
+    kernel<<<n_queries, kSelectClustersFusedBlockDim, fused_smem_size, stream>>>(
+      clusters_to_probe,
+      cluster_dists,
+      float_queries,
+      n_probes,
+      n_lists,
+      dim,
+      dim_ext,
+      norm_factor,
+      metric != raft::distance::DistanceType::InnerProduct,
+      queries,
+      cluster_centers);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    return;
+  }
+
   auto float_queries_view =
     raft::make_device_vector_view<float, uint32_t>(float_queries, dim_ext * n_queries);
   linalg::map_offset(
@@ -155,16 +275,16 @@ void select_clusters(raft::resources const& handle,
                stream);
 
   // Select neighbor clusters for each query.
-  rmm::device_uvector<float> cluster_dists(n_queries * n_probes, stream, mr);
   matrix::detail::select_k<float, uint32_t>(handle,
                                             qc_distances.data(),
                                             nullptr,
                                             n_queries,
                                             n_lists,
                                             n_probes,
-                                            cluster_dists.data(),
+                                            cluster_dists,
                                             clusters_to_probe,
-                                            true);
+                                            true,
+                                            sorted);
 }
 
 /**
@@ -251,12 +371,14 @@ struct search_kernel_cache {
 template <typename ScoreT, typename LutT, typename IvfSampleFilterT, typename IdxT>
 void ivfpq_search_worker(raft::resources const& handle,
                          const index<IdxT>& index,
+                         const uint8_t* const* pq_dataset,  // [n_lists], pointers to list data
                          uint32_t max_samples,
                          uint32_t n_probes,
                          uint32_t topK,
                          uint32_t n_queries,
                          uint32_t queries_offset,            // needed for filtering
                          const uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                         const uint32_t* n_probes_per_query,  // [n_queries] or nullptr
                          const float* query,                 // [n_queries, rot_dim]
                          IdxT* neighbors,                    // [n_queries, topK]
                          float* distances,                   // [n_queries, topK]
@@ -309,7 +431,8 @@ void ivfpq_search_worker(raft::resources const& handle,
                                                                   clusters_to_probe,
                                                                   chunk_index.data(),
                                                                   num_samples.data(),
-                                                                  stream);
+                                                                  stream,
+                                                                  n_probes_per_query);
 
   auto coresidency = expected_probe_coresidency(index.n_lists(), n_probes, n_queries);
 
@@ -425,7 +548,7 @@ void ivfpq_search_worker(raft::resources const& handle,
                          max_samples,
                          index.centers_rot().data_handle(),
                          index.pq_centers().data_handle(),
-                         index.data_ptrs().data_handle(),
+                         pq_dataset,
                          clusters_to_probe,
                          chunk_index.data(),
                          query,
@@ -581,6 +704,170 @@ inline auto get_max_batch_size(raft::resources const& res,
   return max_batch_size;
 }
 
+/**
+ * Copies the probed clusters of the host-resident lists (see `helpers::move_lists_to_host`) to the
+ * device before a batch of queries is searched.
+ *
+ * The search kernel could read the pinned host memory directly, but then every probe would read
+ * its cluster over the PCIe bus. Instead, every cluster probed by a batch is copied once into a
+ * device buffer and the kernel receives a table of list pointers into this buffer. There are two
+ * buffers, so that the copies for the next batch (on a stream of the stream pool, if any) run
+ * while the current batch is being searched.
+ */
+template <typename IdxT>
+class host_lists_stager {
+ public:
+  host_lists_stager(raft::resources const& res, const index<IdxT>& index, uint32_t n_probes)
+    : res_(res),
+      index_(index),
+      n_probes_(n_probes),
+      copy_stream_(resource::get_next_usable_stream(res)),
+      buffers_{make_buffer(res, copy_stream_), make_buffer(res, copy_stream_)},
+      ptrs_{make_device_vector<const uint8_t*, uint32_t>(res, index.n_lists()),
+            make_device_vector<const uint8_t*, uint32_t>(res, index.n_lists())},
+      host_ptrs_(index.n_lists()),
+      probed_(index.n_lists(), false)
+  {
+    for (auto* events : {&ready_, &released_}) {
+      for (auto& e : *events) {
+        RAFT_CUDA_TRY(cudaEventCreateWithFlags(&e, cudaEventDisableTiming));
+      }
+    }
+    for (auto e : released_) {
+      RAFT_CUDA_TRY(cudaEventRecord(e, resource::get_cuda_stream(res)));
+    }
+  }
+
+  ~host_lists_stager() noexcept
+  {
+    // The buffers are released on the copy stream, so it must wait for the last searches.
+    for (auto e : released_) {
+      RAFT_CUDA_TRY_NO_THROW(cudaStreamWaitEvent(copy_stream_, e));
+    }
+    for (auto* events : {&ready_, &released_}) {
+      for (auto e : *events) {
+        RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(e));
+      }
+    }
+  }
+
+  host_lists_stager(const host_lists_stager&)            = delete;
+  host_lists_stager& operator=(const host_lists_stager&) = delete;
+
+  /** The size of the device buffer needed to stage the clusters probed by a single query. */
+  static auto bytes_per_query(const index<IdxT>& index, uint32_t max_samples) -> uint64_t
+  {
+    const uint32_t pq_chunk = (kIndexGroupVecLen * 8u) / index.pq_bits();
+    return uint64_t(max_samples) * div_rounding_up_safe(index.pq_dim(), pq_chunk) *
+           kIndexGroupVecLen;
+  }
+
+  /** Fetch the clusters to probe of the next `n_queries` queries to the host. */
+  void set_clusters(const uint32_t* clusters_to_probe, uint32_t n_queries)
+  {
+    clusters_.resize(size_t(n_queries) * n_probes_);
+    raft::copy(
+      clusters_.data(), clusters_to_probe, clusters_.size(), resource::get_cuda_stream(res_));
+    resource::sync_stream(res_);
+  }
+
+  /**
+   * Start copying the clusters probed by the queries [offset, offset + n_queries) to the slot.
+   * The lists that are found in the device memory (e.g. grown by `extend` since they were moved to
+   * the host) are used in place.
+   */
+  void stage(uint32_t slot, uint32_t offset, uint32_t n_queries)
+  {
+    const auto* labels  = clusters_.data() + size_t(offset) * n_probes_;
+    const auto n_labels = size_t(n_queries) * n_probes_;
+    for (size_t i = 0; i < n_labels; i++) {
+      probed_[labels[i]] = true;
+    }
+    // Lay out the probed clusters in the buffer
+    std::vector<uint64_t> offsets(index_.n_lists(), 0);
+    uint64_t total_size = 0;
+    for (uint32_t label = 0; label < index_.n_lists(); label++) {
+      if (probed_[label] && list_on_host(label)) {
+        offsets[label] = total_size;
+        total_size += Pow2<256>::roundUp(list_bytes(label));
+      }
+    }
+    // The buffer may still be read by the search of the batch before the last one.
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(copy_stream_, released_[slot]));
+    auto& buffer = buffers_[slot];
+    if (buffer.size() < total_size) {
+      // NB: the old buffer is released on the copy stream, after the wait above.
+      buffer = rmm::device_uvector<uint8_t>(
+        total_size, copy_stream_, resource::get_workspace_resource(res_));
+    }
+    for (uint32_t label = 0; label < index_.n_lists(); label++) {
+      const auto& list  = index_.lists()[label];
+      host_ptrs_[label] = list ? list->data.data_handle() : nullptr;
+      if (probed_[label] && list_on_host(label)) {
+        host_ptrs_[label] = buffer.data() + offsets[label];
+        RAFT_CUDA_TRY(cudaMemcpyAsync(buffer.data() + offsets[label],
+                                      list->data.data_handle(),
+                                      list_bytes(label),
+                                      cudaMemcpyHostToDevice,
+                                      copy_stream_));
+      }
+      probed_[label] = false;
+    }
+    raft::copy(ptrs_[slot].data_handle(), host_ptrs_.data(), host_ptrs_.size(), copy_stream_);
+    RAFT_CUDA_TRY(cudaEventRecord(ready_[slot], copy_stream_));
+  }
+
+  /** Make the main stream wait for the copies of the slot; returns the list pointers to search. */
+  auto acquire(uint32_t slot) -> const uint8_t* const*
+  {
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(resource::get_cuda_stream(res_), ready_[slot]));
+    return ptrs_[slot].data_handle();
+  }
+
+  /** Mark the slot reusable once the work submitted to the main stream so far is done. */
+  void release(uint32_t slot)
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(released_[slot], resource::get_cuda_stream(res_)));
+  }
+
+ private:
+  raft::resources const& res_;
+  const index<IdxT>& index_;
+  uint32_t n_probes_;
+  rmm::cuda_stream_view copy_stream_;
+  std::array<rmm::device_uvector<uint8_t>, 2> buffers_;
+  std::array<device_vector<const uint8_t*, uint32_t>, 2> ptrs_;
+  std::array<cudaEvent_t, 2> ready_;
+  std::array<cudaEvent_t, 2> released_;
+  std::vector<const uint8_t*> host_ptrs_;
+  std::vector<bool> probed_;
+  std::vector<uint32_t> clusters_;
+
+  static auto make_buffer(raft::resources const& res, rmm::cuda_stream_view stream)
+    -> rmm::device_uvector<uint8_t>
+  {
+    return rmm::device_uvector<uint8_t>(0, stream, resource::get_workspace_resource(res));
+  }
+
+  [[nodiscard]] auto list_bytes(uint32_t label) const -> uint64_t
+  {
+    const auto& list = index_.lists()[label];
+    list_spec<uint32_t, IdxT> spec{
+      index_.pq_bits(), index_.pq_dim(), index_.conservative_memory_allocation()};
+    auto exts = spec.make_list_extents(list->size.load());
+    return uint64_t(exts.extent(0)) * exts.extent(1) * exts.extent(2) * exts.extent(3);
+  }
+
+  [[nodiscard]] auto list_on_host(uint32_t label) const -> bool
+  {
+    const auto& list = index_.lists()[label];
+    if (!list || list->size.load() == 0) { return false; }
+    cudaPointerAttributes attr;
+    RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, list->data.data_handle()));
+    return attr.type == cudaMemoryTypeHost;
+  }
+};
+
 /** See raft::spatial::knn::ivf_pq::search docs */
 template <typename T,
           typename IdxT,
@@ -649,11 +936,31 @@ inline void search(raft::resources const& handle,
   rmm::device_uvector<float> float_queries(max_queries * dim_ext, stream, mr);
   rmm::device_uvector<float> rot_queries(max_queries * index.rot_dim(), stream, mr);
   rmm::device_uvector<uint32_t> clusters_to_probe(max_queries * n_probes, stream, mr);
+  rmm::device_uvector<float> cluster_dists(max_queries * n_probes, stream, mr);
+
+  // The adaptive probing cuts the (sorted) probe lists per query. The coarse L2 scores lack the
+  // query norms (NOTE[qc_distances]), which are needed for the distance ratio only.
+  const auto& adaptive  = params.adaptive_probes;
+  const bool is_l2      = index.metric() != distance::DistanceType::InnerProduct;
+  const bool need_norms = adaptive.enabled() && is_l2 && adaptive.max_distance_ratio > 1.0f;
+  rmm::device_uvector<uint32_t> n_probes_per_query(
+    adaptive.enabled() ? max_queries : 0, stream, mr);
+  rmm::device_uvector<float> query_norms(need_norms ? max_queries : 0, stream, mr);
 
   auto filter_adapter = raft::neighbors::filtering::ivf_to_sample_filter(
     index.inds_ptrs().data_handle(), sample_filter);
   auto search_instance = ivfpq_search<IdxT, decltype(filter_adapter)>::fun(params, index.metric());
 
+  // The host-resident lists are copied to the device batch by batch, in the workspace memory.
+  std::optional<host_lists_stager<IdxT>> stager{std::nullopt};
+  if (index.host_lists()) {
+    const uint64_t per_query = host_lists_stager<IdxT>::bytes_per_query(index, max_samples);
+    const uint64_t budget    = resource::get_workspace_free_bytes(handle) / 4;
+    max_batch_size =
+      std::clamp<uint64_t>(budget / std::max<uint64_t>(per_query, 1), 1, max_batch_size);
+    stager.emplace(handle, index, n_probes);
+  }
+
   for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
     uint32_t queries_batch = min(max_queries, n_queries - offset_q);
     common::nvtx::range<common::nvtx::domain::raft> batch_scope(
@@ -661,6 +968,7 @@ inline void search(raft::resources const& handle,
 
     select_clusters(handle,
                     clusters_to_probe.data(),
+                    cluster_dists.data(),
                     float_queries.data(),
                     queries_batch,
                     n_probes,
@@ -670,8 +978,34 @@ inline void search(raft::resources const& handle,
                     index.metric(),
                     queries + static_cast<size_t>(dim) * offset_q,
                     index.centers().data_handle(),
+                    adaptive.enabled(),
                     mr);
 
+    if (adaptive.enabled()) {
+      if (need_norms) {
+        linalg::reduce(query_norms.data(),
+                       float_queries.data(),
+                       dim_ext,
+                       queries_batch,
+                       0.0f,
+                       true,
+                       true,
+                       stream,
+                       false,
+                       [dim] __device__(float v, uint32_t j) { return j < dim ? v * v : 0.0f; });
+      }
+      ivf::detail::calc_adaptive_probes(adaptive,
+                                        cluster_dists.data(),
+                                        clusters_to_probe.data(),
+                                        index.list_sizes().data_handle(),
+                                        need_norms ? query_norms.data() : nullptr,
+                                        queries_batch,
+                                        n_probes,
+                                        true,
+                                        n_probes_per_query.data(),
+                                        stream);
+    }
+
     // Rotate queries
     float alpha = 1.0;
     float beta  = 0.0;
@@ -691,26 +1025,43 @@ inline void search(raft::resources const& handle,
                  index.rot_dim(),
                  stream);
 
-    for (uint32_t offset_b = 0; offset_b < queries_batch; offset_b += max_batch_size) {
+    if (stager.has_value()) {
+      stager->set_clusters(clusters_to_probe.data(), queries_batch);
+      stager->stage(0, 0, min(max_batch_size, queries_batch));
+    }
+    for (uint32_t offset_b = 0, slot = 0; offset_b < queries_batch;
+         offset_b += max_batch_size, slot ^= 1) {
       uint32_t batch_size = min(max_batch_size, queries_batch - offset_b);
+      const uint8_t* const* pq_dataset = index.data_ptrs().data_handle();
+      if (stager.has_value()) {
+        // Copy the clusters of the next batch while searching the current one.
+        const uint32_t offset_next = offset_b + batch_size;
+        if (offset_next < queries_batch) {
+          stager->stage(slot ^ 1, offset_next, min(max_batch_size, queries_batch - offset_next));
+        }
+        pq_dataset = stager->acquire(slot);
+      }
       /* The distance calculation is done in the rotated/transformed space;
          as long as `index.rotation_matrix()` is orthogonal, the distances and thus results are
          preserved.
        */
       search_instance(handle,
                       index,
+                      pq_dataset,
                       max_samples,
                       n_probes,
                       k,
                       batch_size,
                       offset_q + offset_b,
                       clusters_to_probe.data() + uint64_t(n_probes) * offset_b,
+                      adaptive.enabled() ? n_probes_per_query.data() + offset_b : nullptr,
                       rot_queries.data() + uint64_t(index.rot_dim()) * offset_b,
                       neighbors + uint64_t(k) * (offset_q + offset_b),
                       distances + uint64_t(k) * (offset_q + offset_b),
                       utils::config<T>::kDivisor / utils::config<float>::kDivisor,
                       params.preferred_shmem_carveout,
                       filter_adapter);
+      if (stager.has_value()) { stager->release(slot); }
     }
   }
 }
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_resources_manager.hpp>
+#include <raft/core/device_setter.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/detail/ivf_pq_build.cuh>
+#include <raft/neighbors/detail/ivf_pq_search.cuh>
+#include <raft/neighbors/detail/multi_device.hpp>
+#include <raft/neighbors/detail/sharded_search.cuh>
+#include <raft/neighbors/ivf_pq_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::ivf_pq::detail {
+
+using raft::neighbors::detail::for_each_device;
+
+/**
+ * Extend the sharded index with new host-resident data.
+ * See raft::neighbors::ivf_pq::extend_sharded docs.
+ */
+template <typename T, typename IdxT>
+void extend_sharded(sharded_index<IdxT>* idx,
+                    const T* new_vectors,
+                    const IdxT* new_indices,
+                    IdxT n_rows)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::extend_sharded(%zu, %zu)", size_t(n_rows), idx->n_shards());
+  RAFT_EXPECTS(new_indices != nullptr || idx->size() == 0,
+               "You must pass data indices when the index is non-empty.");
+  if (n_rows == 0) { return; }
+
+  const auto& device_ids = idx->device_ids();
+  const uint32_t dim     = idx->dim();
+
+  // All shards share the cluster centers, so classify the new data once, on the first device.
+  std::vector<uint32_t> labels(n_rows);
+  {
+    raft::device_setter dev(device_ids.front());
+    const auto& res = raft::device_resources_manager::get_device_resources(device_ids.front());
+    auto stream     = resource::get_cuda_stream(res);
+    auto mr         = resource::get_workspace_resource(res);
+    constexpr size_t kReasonableMaxBatchSize = 65536;
+    rmm::device_uvector<uint32_t> d_labels(n_rows, stream, mr);
+    utils::batch_load_iterator<T> vec_batches(
+      new_vectors, n_rows, dim, std::min<size_t>(n_rows, kReasonableMaxBatchSize), stream, mr);
+    predict_labels(res, idx->shard(0), vec_batches, d_labels.data(), mr);
+    raft::copy(labels.data(), d_labels.data(), n_rows, stream);
+    resource::sync_stream(res);
+  }
+
+  // Route every new vector to the shard owning its list.
+  std::vector<std::vector<IdxT>> shard_rows(idx->n_shards());
+  for (IdxT i = 0; i < n_rows; i++) {
+    shard_rows[idx->list_owner(labels[i])].push_back(i);
+  }
+
+  for_each_device(device_ids, [&](size_t i) {
+    const auto& rows = shard_rows[i];
+    if (rows.empty()) { return; }
+    const auto n_shard_rows = static_cast<IdxT>(rows.size());
+    auto shard_vectors      = raft::make_host_matrix<T, IdxT>(n_shard_rows, dim);
+    auto shard_indices      = raft::make_host_vector<IdxT, IdxT>(n_shard_rows);
+    for (IdxT j = 0; j < n_shard_rows; j++) {
+      std::memcpy(shard_vectors.data_handle() + size_t(j) * dim,
+                  new_vectors + size_t(rows[j]) * dim,
+                  sizeof(T) * dim);
+      shard_indices(j) = new_indices != nullptr ? new_indices[rows[j]] : rows[j];
+    }
+    const auto& shard_res = raft::device_resources_manager::get_device_resources(device_ids[i]);
+    extend<T, IdxT>(shard_res,
+                    &idx->shard(i),
+                    shard_vectors.data_handle(),
+                    shard_indices.data_handle(),
+                    n_shard_rows);
+    resource::sync_stream(shard_res);
+  });
+}
+
+/** See raft::neighbors::ivf_pq::build_sharded docs */
+template <typename T, typename IdxT>
+auto build_sharded(const index_params& params,
+                   const std::vector<int>& device_ids,
+                   const T* dataset,
+                   IdxT n_rows,
+                   uint32_t dim) -> sharded_index<IdxT>
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::build_sharded(%zu, %u, %zu)", size_t(n_rows), dim, device_ids.size());
+  RAFT_EXPECTS(!device_ids.empty(), "At least one device is needed to build a sharded index");
+
+  std::vector<std::optional<index<IdxT>>> shards(device_ids.size());
+  {
+    // Train the cluster centers and the codebooks once, on the first device.
+    raft::device_setter dev(device_ids.front());
+    const auto& res = raft::device_resources_manager::get_device_resources(device_ids.front());
+    auto train_params              = params;
+    train_params.add_data_on_build = false;
+    shards[0].emplace(build<T, IdxT>(res, train_params, dataset, n_rows, dim));
+    resource::sync_stream(res);
+  }
+  // Replicate the (still empty) trained index on the other devices.
+  for_each_device(device_ids, [&](size_t i) {
+    if (i == 0) { return; }
+    const auto& shard_res = raft::device_resources_manager::get_device_resources(device_ids[i]);
+    shards[i].emplace(clone(shard_res, *shards[0]));
+    resource::sync_stream(shard_res);
+  });
+
+  std::vector<index<IdxT>> shard_indices;
+  shard_indices.reserve(shards.size());
+  for (auto& shard : shards) {
+    shard_indices.emplace_back(std::move(*shard));
+  }
+  sharded_index<IdxT> idx(device_ids, std::move(shard_indices));
+  if (params.add_data_on_build) {
+    extend_sharded<T, IdxT>(&idx, dataset, nullptr, n_rows);
+  }
+  return idx;
+}
+
+/** See raft::neighbors::ivf_pq::search_sharded docs */
+template <typename T, typename IdxT>
+void search_sharded(raft::resources const& res,
+                    const search_params& params,
+                    const sharded_index<IdxT>& idx,
+                    const T* queries,
+                    uint32_t n_queries,
+                    uint32_t k,
+                    IdxT* neighbors,
+                    float* distances)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::search_sharded(%u, %u, %zu)", n_queries, k, idx.n_shards());
+  if (n_queries == 0) { return; }
+
+  // Every shard runs the coarse search over all the centers, but only scans the probed lists it
+  // owns (the other lists are empty in the shard). Together, the shards scan each probed list
+  // exactly once. The lists store the global ids, so no translation is needed.
+  raft::neighbors::detail::search_shards<T, IdxT, IdxT>(
+    res,
+    idx.device_ids(),
+    [&](size_t i) -> raft::resources const& {
+      return raft::device_resources_manager::get_device_resources(idx.device_ids()[i]);
+    },
+    [&](raft::resources const& dev_res,
+        size_t i,
+        raft::device_matrix_view<const T, int64_t, row_major> shard_queries,
+        raft::device_matrix_view<IdxT, int64_t, row_major> shard_neighbors,
+        raft::device_matrix_view<float, int64_t, row_major> shard_distances) {
+      search<T, IdxT>(dev_res,
+                      params,
+                      idx.shard(i),
+                      shard_queries.data_handle(),
+                      uint32_t(shard_queries.extent(0)),
+                      k,
+                      shard_neighbors.data_handle(),
+                      shard_distances.data_handle(),
+                      raft::neighbors::filtering::none_ivf_sample_filter{});
+    },
+    queries,
+    n_queries,
+    idx.dim(),
+    k,
+    neighbors,
+    distances,
+    n_queries,
+    std::nullopt,
+    raft::distance::is_min_close(idx.metric()),
+    false);
+}
+
+}  // namespace raft::neighbors::ivf_pq::detail
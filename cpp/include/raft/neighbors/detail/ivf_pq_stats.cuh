@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/ivf_pq_build.cuh>
+#include <raft/neighbors/ivf_pq_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/integer_utils.hpp>
+#include <raft/util/reduction.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::ivf_pq::detail {
+
+/**
+ * Add the squared L2 distances between the decoded records of a list and their source vectors
+ * (one warp per record) to `error`.
+ */
+template <typename T, typename IdxT>
+RAFT_KERNEL reconstruction_error_kernel(const float* decoded,  // [n_rows, dim]
+                                        const T* dataset,      // [.., dim]
+                                        const IdxT* ids,       // [n_rows]
+                                        uint32_t n_rows,
+                                        uint32_t dim,
+                                        float* error)
+{
+  const uint32_t lane_id = threadIdx.x % WarpSize;
+  const uint32_t row     = (blockIdx.x * blockDim.x + threadIdx.x) / WarpSize;
+  if (row >= n_rows) { return; }
+  const T* x     = dataset + size_t(ids[row]) * size_t(dim);
+  const float* y = decoded + size_t(row) * size_t(dim);
+  float sq_error = 0.0f;
+  for (uint32_t k = lane_id; k < dim; k += WarpSize) {
+    auto t = utils::mapping<float>{}(x[k]) - y[k];
+    sq_error += t * t;
+  }
+  sq_error = raft::warpReduce(sq_error);
+  if (lane_id == 0) { atomicAdd(error, sq_error); }
+}
+
+/** See raft::neighbors::ivf_pq::helpers::stats docs */
+template <typename T, typename IdxT>
+auto stats(raft::resources const& res,
+           const index<IdxT>& index,
+           std::optional<device_matrix_view<const T, IdxT, row_major>> dataset) -> index_stats
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("ivf_pq::stats(%u)", index.n_lists());
+  auto stream   = resource::get_cuda_stream(res);
+  auto n_lists  = index.n_lists();
+  auto n_chunks = raft::div_rounding_up_safe<uint32_t>(index.pq_dim(),
+                                                       (kIndexGroupVecLen * 8u) / index.pq_bits());
+  index_stats out;
+  out.bytes_per_record = n_chunks * kIndexGroupVecLen + sizeof(IdxT);
+
+  out.list_sizes.resize(n_lists);
+  raft::copy(out.list_sizes.data(), index.list_sizes().data_handle(), n_lists, stream);
+  resource::sync_stream(res);
+  out.max_list_size = *std::max_element(out.list_sizes.begin(), out.list_sizes.end());
+
+  std::vector<float> sq_errors;
+  if (dataset.has_value()) {
+    RAFT_EXPECTS(dataset->extent(1) == index.dim(),
+                 "The dataset should have the same dimension as the index");
+    constexpr uint32_t kReasonableMaxBatchSize = 65536;
+    constexpr uint32_t kBlockSize              = 256;
+
+    const uint32_t max_batch_size = std::min(kReasonableMaxBatchSize, out.max_list_size);
+    rmm::device_uvector<float> d_sq_errors(n_lists, stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(d_sq_errors.data(), 0, sizeof(float) * n_lists, stream));
+    auto decoded = make_device_mdarray<float>(res,
+                                              resource::get_workspace_resource(res),
+                                              make_extents<uint32_t>(max_batch_size, index.dim()));
+    for (uint32_t l = 0; l < n_lists; l++) {
+      for (uint32_t offset = 0; offset < out.list_sizes[l]; offset += max_batch_size) {
+        auto n_rows       = std::min(max_batch_size, out.list_sizes[l] - offset);
+        auto decoded_view = make_device_matrix_view<float, uint32_t>(
+          decoded.data_handle(), n_rows, index.dim());
+        reconstruct_list_data<float, IdxT>(res, index, decoded_view, l, offset);
+        dim3 blocks(raft::div_rounding_up_safe<uint32_t>(n_rows * WarpSize, kBlockSize), 1, 1);
+        dim3 threads(kBlockSize, 1, 1);
+        reconstruction_error_kernel<T, IdxT>
+          <<<blocks, threads, 0, stream>>>(decoded.data_handle(),
+                                           dataset->data_handle(),
+                                           index.lists()[l]->indices.data_handle() + offset,
+                                           n_rows,
+                                           index.dim(),
+                                           d_sq_errors.data() + l);
+        RAFT_CUDA_TRY(cudaPeekAtLastError());
+      }
+    }
+    sq_errors.resize(n_lists);
+    raft::copy(sq_errors.data(), d_sq_errors.data(), n_lists, stream);
+    resource::sync_stream(res);
+  }
+
+  double total_size    = 0.0;
+  double total_sq_size = 0.0;
+  double total_error   = 0.0;
+  for (uint32_t l = 0; l < n_lists; l++) {
+    auto list_size = out.list_sizes[l];
+    auto bin       = list_size == 0 ? 0 : raft::log2(list_size) + 1;
+    if (out.list_size_histogram.size() <= size_t(bin)) { out.list_size_histogram.resize(bin + 1); }
+    out.list_size_histogram[bin]++;
+    total_size += list_size;
+    total_sq_size += double(list_size) * double(list_size);
+    if (dataset.has_value()) {
+      total_error += sq_errors[l];
+      out.list_reconstruction_mse.push_back(list_size == 0 ? 0.0f : sq_errors[l] / list_size);
+    }
+  }
+  if (total_size > 0) {
+    out.reconstruction_mse      = total_error / total_size;
+    out.mean_list_size          = total_size / n_lists;
+    out.expected_scan_per_probe = total_sq_size / total_size;
+    out.imbalance_factor        = out.expected_scan_per_probe / out.mean_list_size;
+  }
+  return out;
+}
+
+}  // namespace raft::neighbors::ivf_pq::detail
@@ -16,6 +16,10 @@
 
 #pragma once
 
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_event.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
@@ -42,9 +46,11 @@
 
 #include <thrust/iterator/transform_iterator.h>
 
+#include <array>
 #include <cstdint>
 #include <iostream>
 #include <set>
+#include <vector>
 
 namespace raft::neighbors::detail {
 using namespace raft::spatial::knn::detail;
@@ -417,12 +423,16 @@ void brute_force_knn_impl(
 
     auto stream = resource::get_next_usable_stream(handle, i);
 
+    // For small k, the top-k are selected inside the distance kernel, without writing out the
+    // distance tiles.
     if (k <= 64 && rowMajorQuery == rowMajorIndex && rowMajorQuery == true &&
         std::is_same_v<DistanceEpilogue, raft::identity_op> &&
         (metric == raft::distance::DistanceType::L2Unexpanded ||
          metric == raft::distance::DistanceType::L2SqrtUnexpanded ||
          metric == raft::distance::DistanceType::L2Expanded ||
-         metric == raft::distance::DistanceType::L2SqrtExpanded)) {
+         metric == raft::distance::DistanceType::L2SqrtExpanded ||
+         metric == raft::distance::DistanceType::InnerProduct ||
+         metric == raft::distance::DistanceType::CosineExpanded)) {
       fusedL2Knn(D,
                  out_i_ptr,
                  out_d_ptr,
@@ -503,7 +513,7 @@ void brute_force_knn_impl(
   if (input.size() > 1 || translations != nullptr) {
     // This is necessary for proper index translations. If there are
     // no translations or partitions to combine, it can be skipped.
-    knn_merge_parts(out_D, out_I, res_D, res_I, n, input.size(), k, userStream, trans.data());
+    knn_merge_parts(handle, out_D, out_I, res_D, res_I, n, input.size(), k, trans.data());
   }
 
   if (translations == nullptr) delete id_ranges;
@@ -548,4 +558,123 @@ void brute_force_search(
                                          norms.size() ? &norms : nullptr,
                                          query_norms ? query_norms->data_handle() : nullptr);
 }
+/**
+ * See raft::neighbors::brute_force::knn_host_dataset docs.
+ *
+ * Every tile of the dataset is searched on one of the two streams (taken from the stream pool if
+ * any) into one of the two merge buffers, each holding [2, n_queries, k] results: the running
+ * top-k of the previous tiles and the top-k of the tile. The merges are done on the main stream in
+ * the order of the tiles, and every merge writes the running top-k into the other buffer.
+ */
+template <typename T, typename IdxT>
+void brute_force_search_host_dataset(
+  raft::resources const& res,
+  raft::host_matrix_view<const T, int64_t, row_major> dataset,
+  raft::device_matrix_view<const T, int64_t, row_major> queries,
+  raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+  raft::device_matrix_view<T, int64_t, row_major> distances,
+  raft::distance::DistanceType metric,
+  float metric_arg,
+  int64_t tile_rows)
+{
+  const int64_t n_rows    = dataset.extent(0);
+  const int64_t dim       = dataset.extent(1);
+  const int64_t n_queries = queries.extent(0);
+  const int64_t k         = neighbors.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::knn_host_dataset(%zu rows, %zu queries, k = %zu)",
+    size_t(n_rows),
+    size_t(n_queries),
+    size_t(k));
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1), "Value of k must match for outputs");
+  RAFT_EXPECTS(neighbors.extent(0) == n_queries && distances.extent(0) == n_queries,
+               "Number of rows in the outputs must match the number of queries");
+  RAFT_EXPECTS(queries.extent(1) == dim, "Number of columns in queries must match the dataset");
+  RAFT_EXPECTS(k <= n_rows, "k must not be larger than the number of rows in the dataset");
+  tile_rows = std::min(std::max(tile_rows, k), n_rows);
+  if (n_queries == 0) { return; }
+
+  // The last tile takes the remainder rows, so that every tile has at least k rows.
+  auto stream                  = resource::get_cuda_stream(res);
+  const int64_t n_tiles        = n_rows / tile_rows;
+  const int64_t last_tile_rows = n_rows - (n_tiles - 1) * tile_rows;
+  const bool select_min        = raft::distance::is_min_close(metric);
+  const size_t n_outs          = size_t(n_queries) * k;
+
+  // The translations of the (running, tile) pairs of every merge
+  std::vector<IdxT> translations_host(2 * n_tiles, 0);
+  for (int64_t tile = 0; tile < n_tiles; tile++) {
+    translations_host[2 * tile + 1] = static_cast<IdxT>(tile * tile_rows);
+  }
+  auto translations = make_device_vector<IdxT, int64_t>(res, 2 * n_tiles);
+  raft::update_device(
+    translations.data_handle(), translations_host.data(), translations_host.size(), stream);
+
+  std::array<device_matrix<T, int64_t>, 2> tiles{
+    make_device_matrix<T, int64_t>(res, last_tile_rows, dim),
+    make_device_matrix<T, int64_t>(res, last_tile_rows, dim)};
+  std::array<rmm::device_uvector<T>, 2> merge_dists{rmm::device_uvector<T>(2 * n_outs, stream),
+                                                    rmm::device_uvector<T>(2 * n_outs, stream)};
+  std::array<rmm::device_uvector<IdxT>, 2> merge_inds{
+    rmm::device_uvector<IdxT>(2 * n_outs, stream), rmm::device_uvector<IdxT>(2 * n_outs, stream)};
+  std::array<resource::cuda_event_resource, 2> searched;
+  std::array<resource::cuda_event_resource, 2> merged;
+  auto event = [](resource::cuda_event_resource& e) {
+    return *static_cast<cudaEvent_t*>(e.get_resource());
+  };
+
+  // The tile streams read the queries and the buffers allocated on the main stream.
+  resource::wait_stream_pool_on_stream(res);
+  for (int64_t tile = 0; tile < n_tiles; tile++) {
+    const int slot        = tile % 2;
+    const int64_t offset  = tile * tile_rows;
+    const int64_t rows    = tile + 1 == n_tiles ? last_tile_rows : tile_rows;
+    auto tile_stream      = resource::get_next_usable_stream(res, slot);
+    // The first tile initializes the running top-k, the others go next to it for the merge.
+    const size_t out_part = tile == 0 ? 0 : n_outs;
+    auto* tile_dists      = merge_dists[tile == 0 ? 1 : slot].data() + out_part;
+    auto* tile_inds       = merge_inds[tile == 0 ? 1 : slot].data() + out_part;
+
+    // The merge buffer of this tile was last read by the merge of the tile `tile - 2`.
+    if (tile >= 2) { RAFT_CUDA_TRY(cudaStreamWaitEvent(tile_stream, event(merged[slot]))); }
+    raft::resources tile_res(res);
+    resource::set_cuda_stream(tile_res, tile_stream);
+    raft::copy(tiles[slot].data_handle(),
+               dataset.data_handle() + offset * dim,
+               size_t(rows) * dim,
+               tile_stream);
+    tiled_brute_force_knn<T, IdxT>(tile_res,
+                                   queries.data_handle(),
+                                   tiles[slot].data_handle(),
+                                   n_queries,
+                                   rows,
+                                   dim,
+                                   k,
+                                   tile_dists,
+                                   tile_inds,
+                                   metric,
+                                   metric_arg);
+    RAFT_CUDA_TRY(cudaEventRecord(event(searched[slot]), tile_stream));
+
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, event(searched[slot])));
+    if (tile > 0) {
+      knn_merge_parts(res,
+                      merge_dists[slot].data(),
+                      merge_inds[slot].data(),
+                      merge_dists[slot ^ 1].data(),
+                      merge_inds[slot ^ 1].data(),
+                      n_queries,
+                      2,
+                      k,
+                      translations.data_handle() + 2 * tile,
+                      select_min);
+      RAFT_CUDA_TRY(cudaEventRecord(event(merged[slot]), stream));
+    }
+  }
+
+  // After the merge of the last tile (or the only tile), the running top-k is in this buffer.
+  const int result = n_tiles % 2;
+  raft::copy(distances.data_handle(), merge_dists[result].data(), n_outs, stream);
+  raft::copy(neighbors.data_handle(), merge_inds[result].data(), n_outs, stream);
+}
 }  // namespace raft::neighbors::detail
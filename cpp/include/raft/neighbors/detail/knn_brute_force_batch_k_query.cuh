@@ -15,11 +15,18 @@
  */
 #pragma once
 
+#include <raft/core/resource/cuda_event.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/linalg/norm.cuh>
 #include <raft/matrix/slice.cuh>
 #include <raft/neighbors/brute_force_types.hpp>
 #include <raft/neighbors/detail/knn_brute_force.cuh>
 
+#include <rmm/cuda_stream.hpp>
+
+#include <optional>
+
 namespace raft::neighbors::brute_force::detail {
 template <typename T, typename IdxT = int64_t>
 class gpu_batch_k_query : public batch_k_query<T, IdxT> {
@@ -27,13 +34,27 @@ class gpu_batch_k_query : public batch_k_query<T, IdxT> {
   gpu_batch_k_query(const raft::resources& res,
                     const raft::neighbors::brute_force::index<T>& index,
                     raft::device_matrix_view<const T, int64_t, row_major> query,
-                    int64_t batch_size)
-    : batch_k_query<T, IdxT>(res, index.size(), query.extent(0), batch_size),
+                    int64_t batch_size,
+                    bool prefetch = false)
+    : batch_k_query<T, IdxT>(res, index.size(), query.extent(0), batch_size, prefetch),
       index(index),
-      query(query)
+      query(query),
+      prefetch_res(res)
   {
     auto metric = index.metric();
 
+    // The prefetching runs on a side stream: one of the pool if any, or its own otherwise. The
+    // search must not use the stream pool, as it synchronizes the pool streams with the host.
+    if (prefetch) {
+      if (resource::is_stream_pool_initialized(res)) {
+        resource::set_cuda_stream(prefetch_res, resource::get_stream_from_stream_pool(res));
+      } else {
+        own_stream.emplace();
+        resource::set_cuda_stream(prefetch_res, own_stream->view());
+      }
+      resource::set_cuda_stream_pool(prefetch_res, nullptr);
+    }
+
     // precompute query norms, and re-use across batches
     if (metric == raft::distance::DistanceType::L2Expanded ||
         metric == raft::distance::DistanceType::L2SqrtExpanded ||
@@ -59,21 +80,53 @@ class gpu_batch_k_query : public batch_k_query<T, IdxT> {
 
  protected:
   void load_batch(int64_t offset, int64_t next_batch_size, batch<T, IdxT>* output) const override
+  {
+    load_batch(this->res, offset, next_batch_size, output);
+  };
+
+  void prefetch_batch(int64_t offset,
+                      int64_t next_batch_size,
+                      batch<T, IdxT>* output) const override
+  {
+    // The side stream waits for all the work so far, including the reads of the previous output.
+    auto stream      = resource::get_cuda_stream(this->res);
+    auto side_stream = resource::get_cuda_stream(prefetch_res);
+    RAFT_CUDA_TRY(cudaEventRecord(event(submitted_event), stream));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(side_stream, event(submitted_event)));
+    load_batch(prefetch_res, offset, next_batch_size, output);
+    RAFT_CUDA_TRY(cudaEventRecord(event(prefetched_event), side_stream));
+  }
+
+  void wait_prefetch() const override
+  {
+    RAFT_CUDA_TRY(
+      cudaStreamWaitEvent(resource::get_cuda_stream(this->res), event(prefetched_event)));
+  }
+
+  void load_batch(const raft::resources& res,
+                  int64_t offset,
+                  int64_t next_batch_size,
+                  batch<T, IdxT>* output) const
   {
     if (offset >= index.size()) { return; }
 
     // we're aiming to load multiple batches here - since we don't know the max iteration
     // grow the size we're loading exponentially
     int64_t batch_size = std::min(std::max(offset * 2, next_batch_size * 2), this->index_size);
-    output->resize(this->res, this->query_size, batch_size);
+    output->resize(res, this->query_size, batch_size);
 
     std::optional<raft::device_vector_view<const float, int64_t>> query_norms_view;
     if (query_norms) { query_norms_view = query_norms->view(); }
 
     raft::neighbors::detail::brute_force_search<T, IdxT>(
-      this->res, index, query, output->indices(), output->distances(), query_norms_view);
+      res, index, query, output->indices(), output->distances(), query_norms_view);
   };
 
+  static auto event(resource::cuda_event_resource& e) -> cudaEvent_t
+  {
+    return *static_cast<cudaEvent_t*>(e.get_resource());
+  }
+
   void slice_batch(const batch<T, IdxT>& input,
                    int64_t offset,
                    int64_t batch_size,
@@ -94,5 +147,11 @@ class gpu_batch_k_query : public batch_k_query<T, IdxT> {
   const raft::neighbors::brute_force::index<T>& index;
   raft::device_matrix_view<const T, int64_t, row_major> query;
   std::optional<device_vector<T, int64_t>> query_norms;
+
+  // the resources of the prefetching, on a side stream
+  raft::resources prefetch_res;
+  std::optional<rmm::cuda_stream> own_stream;
+  mutable resource::cuda_event_resource submitted_event;
+  mutable resource::cuda_event_resource prefetched_event;
 };
 }  // namespace raft::neighbors::brute_force::detail
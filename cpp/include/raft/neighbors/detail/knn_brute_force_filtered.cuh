@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/bitmap.cuh>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/init.cuh>
+#include <raft/neighbors/brute_force_types.hpp>
+#include <raft/neighbors/detail/knn_brute_force_range_search.cuh>
+#include <raft/sparse/linalg/masked_matmul.hpp>
+#include <raft/sparse/matrix/select_k.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+namespace raft::neighbors::detail {
+
+/**
+ * Turn the inner products at the nonzeros of a CSR matrix into distances, one warp per row.
+ */
+template <typename T>
+RAFT_KERNEL filtered_dist_kernel(const int64_t* indptr,
+                                 const int64_t* indices,
+                                 int64_t n_rows,
+                                 range_search_dist_op<T> dist_op,
+                                 T* values)
+{
+  int64_t row = (int64_t(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize;
+  int lane    = threadIdx.x % WarpSize;
+  if (row >= n_rows) { return; }
+  for (int64_t i = indptr[row] + lane; i < indptr[row + 1]; i += WarpSize) {
+    values[i] = dist_op(values[i], row, indices[i]);
+  }
+}
+
+/** See raft::neighbors::brute_force::search_with_filtering docs */
+template <typename T, typename IdxT>
+void brute_force_search_filtered(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<T>& idx,
+  raft::device_matrix_view<const T, int64_t, row_major> queries,
+  raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+  raft::device_matrix_view<T, int64_t, row_major> distances,
+  raft::core::bitmap_view<const uint32_t, int64_t> filter)
+{
+  const int64_t m = queries.extent(0);
+  const int64_t n = idx.dataset().extent(0);
+  const int64_t d = idx.dataset().extent(1);
+  const int64_t k = neighbors.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::search_with_filtering(%zu rows, %zu queries)", size_t(n), size_t(m));
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1), "Value of k must match for outputs");
+  RAFT_EXPECTS(neighbors.extent(0) == m && distances.extent(0) == m,
+               "Number of rows in the outputs must match the number of queries");
+  RAFT_EXPECTS(queries.extent(1) == d, "Number of columns in queries must match brute force index");
+  RAFT_EXPECTS(filter.get_n_rows() == m && filter.get_n_cols() == n,
+               "The filter must be a [n_queries, index size] bitmap");
+
+  // The distances are computed from the inner products at the allowed positions
+  auto metric = idx.metric();
+  switch (metric) {
+    case raft::distance::DistanceType::L2Unexpanded:
+      metric = raft::distance::DistanceType::L2Expanded;
+      break;
+    case raft::distance::DistanceType::L2SqrtUnexpanded:
+      metric = raft::distance::DistanceType::L2SqrtExpanded;
+      break;
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::CosineExpanded:
+    case raft::distance::DistanceType::InnerProduct: break;
+    default: RAFT_FAIL("The filtered search supports the L2, cosine and inner product metrics");
+  }
+  const bool select_min = raft::distance::is_min_close(metric);
+
+  // The rows with less than k allowed ids keep these at their end
+  const T sentinel = select_min ? std::numeric_limits<T>::max() : std::numeric_limits<T>::lowest();
+  raft::matrix::fill(res, distances, sentinel);
+  // The CSR select_k returns int64_t indices
+  std::optional<raft::device_matrix<int64_t, int64_t>> indices_buf;
+  auto out_indices = [&]() {
+    if constexpr (std::is_same_v<IdxT, int64_t>) {
+      return neighbors;
+    } else {
+      indices_buf.emplace(raft::make_device_matrix<int64_t, int64_t>(res, m, k));
+      return indices_buf->view();
+    }
+  }();
+  raft::matrix::fill(res, out_indices, int64_t(-1));
+
+  const int64_t nnz = filter.count(res);
+  if (nnz > 0) {
+    auto stream = resource::get_cuda_stream(res);
+    auto mr     = resource::get_workspace_resource(res);
+
+    auto dists = raft::make_device_csr_matrix<T, int64_t, int64_t, int64_t>(res, m, n);
+    dists.initialize_sparsity(nnz);
+    auto dists_view = dists.view();
+    RAFT_CUDA_TRY(cudaMemsetAsync(dists_view.get_elements().data(), 0, nnz * sizeof(T), stream));
+    raft::sparse::linalg::masked_matmul(res, queries, idx.dataset(), filter, dists_view);
+
+    const T* row_norms = nullptr;
+    const T* col_norms = idx.has_norms() ? idx.norms().data_handle() : nullptr;
+    rmm::device_uvector<T> norms(0, stream, mr);
+    if (metric != raft::distance::DistanceType::InnerProduct) {
+      norms.resize(m + (col_norms ? 0 : n), stream);
+      // cosine needs the l2norm, where as l2 distances needs the squared norm
+      auto norm_rows = [&](const T* data, int64_t n_rows, T* out_norms) {
+        if (metric == raft::distance::DistanceType::CosineExpanded) {
+          raft::linalg::rowNorm(out_norms,
+                                data,
+                                d,
+                                n_rows,
+                                raft::linalg::NormType::L2Norm,
+                                true,
+                                stream,
+                                raft::sqrt_op{});
+        } else {
+          raft::linalg::rowNorm(
+            out_norms, data, d, n_rows, raft::linalg::NormType::L2Norm, true, stream);
+        }
+      };
+      norm_rows(queries.data_handle(), m, norms.data());
+      row_norms = norms.data();
+      if (!col_norms) {
+        norm_rows(idx.dataset().data_handle(), n, norms.data() + m);
+        col_norms = norms.data() + m;
+      }
+
+      constexpr int kBlockSize = 256;
+      auto structure           = dists_view.structure_view();
+      auto n_blocks            = raft::ceildiv<int64_t>(m * WarpSize, kBlockSize);
+      filtered_dist_kernel<T><<<n_blocks, kBlockSize, 0, stream>>>(
+        structure.get_indptr().data(),
+        structure.get_indices().data(),
+        m,
+        range_search_dist_op<T>{metric, row_norms, col_norms},
+        dists_view.get_elements().data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+
+    auto in_val = raft::make_device_csr_matrix_view<const T, int64_t, int64_t, int64_t>(
+      dists_view.get_elements().data(), dists_view.structure_view());
+    raft::sparse::matrix::select_k<T, int64_t>(
+      res, in_val, std::nullopt, distances, out_indices, select_min, true);
+  }
+
+  if constexpr (!std::is_same_v<IdxT, int64_t>) {
+    raft::linalg::map(res, neighbors, raft::cast_op<IdxT>{}, raft::make_const_mdspan(out_indices));
+  }
+}
+
+}  // namespace raft::neighbors::detail
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/gemm.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/reduce.cuh>
+#include <raft/matrix/init.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+namespace raft::neighbors::detail {
+
+/** The type of the dot products computed by cuBLASLt: exact int32 for int8, float otherwise. */
+template <typename T>
+using low_precision_dot_t = std::conditional_t<std::is_same_v<T, int8_t>, int32_t, float>;
+
+/** Squared L2 norms of the rows of a low-precision matrix, accumulated in float. */
+template <typename T>
+void low_precision_sq_norms(raft::resources const& res,
+                            const T* data,
+                            int64_t n_rows,
+                            int64_t dim,
+                            float* norms)
+{
+  linalg::reduce(norms,
+                 data,
+                 dim,
+                 n_rows,
+                 0.0f,
+                 true,
+                 true,
+                 resource::get_cuda_stream(res),
+                 false,
+                 raft::compose_op(raft::sq_op{}, raft::cast_op<float>{}));
+}
+
+/** The distance from the dot product and the squared norms of the query and the dataset row. */
+struct low_precision_distance_op {
+  raft::distance::DistanceType metric;
+
+  template <typename DotT>
+  __device__ inline auto operator()(DotT dot, float qn, float xn) const -> float
+  {
+    const auto d = static_cast<float>(dot);
+    switch (metric) {
+      case raft::distance::DistanceType::InnerProduct: return d;
+      case raft::distance::DistanceType::CosineExpanded:
+        return 1.0f - d / sqrtf(fmaxf(qn * xn, std::numeric_limits<float>::min()));
+      case raft::distance::DistanceType::L2SqrtExpanded:
+      case raft::distance::DistanceType::L2SqrtUnexpanded:
+        return sqrtf(fmaxf(qn + xn - 2.0f * d, 0.0f));
+      default: return fmaxf(qn + xn - 2.0f * d, 0.0f);
+    }
+  }
+};
+
+/** See raft::neighbors::brute_force::knn_low_precision docs */
+template <typename T, typename IdxT>
+void brute_force_search_low_precision(
+  raft::resources const& res,
+  raft::device_matrix_view<const T, int64_t, row_major> dataset,
+  raft::device_matrix_view<const T, int64_t, row_major> queries,
+  raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms)
+{
+  using dot_t = low_precision_dot_t<T>;
+  static_assert(std::is_same_v<T, half> || std::is_same_v<T, nv_bfloat16> ||
+                  std::is_same_v<T, int8_t>,
+                "unsupported data type");
+  const int64_t n_rows    = dataset.extent(0);
+  const int64_t dim       = dataset.extent(1);
+  const int64_t n_queries = queries.extent(0);
+  const int64_t k         = neighbors.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::knn_low_precision(%zu rows, %zu queries, k = %zu)",
+    size_t(n_rows),
+    size_t(n_queries),
+    size_t(k));
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1), "Value of k must match for outputs");
+  RAFT_EXPECTS(neighbors.extent(0) == n_queries && distances.extent(0) == n_queries,
+               "Number of rows in the outputs must match the number of queries");
+  RAFT_EXPECTS(queries.extent(1) == dim, "Number of columns in queries must match the dataset");
+  RAFT_EXPECTS(k <= n_rows, "k must not be larger than the number of rows in the dataset");
+  RAFT_EXPECTS(metric == raft::distance::DistanceType::L2Expanded ||
+                 metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                 metric == raft::distance::DistanceType::L2Unexpanded ||
+                 metric == raft::distance::DistanceType::L2SqrtUnexpanded ||
+                 metric == raft::distance::DistanceType::InnerProduct ||
+                 metric == raft::distance::DistanceType::CosineExpanded,
+               "The low-precision search supports the L2, inner product and cosine metrics only");
+  // The int8 tensor core GEMMs require 4-byte aligned rows.
+  RAFT_EXPECTS(!std::is_same_v<T, int8_t> || dim % 4 == 0,
+               "The dimensionality of the int8 data must be a multiple of 4");
+  RAFT_EXPECTS(!dataset_norms.has_value() || dataset_norms->extent(0) == n_rows,
+               "The number of the dataset norms must match the number of rows");
+  if (n_queries == 0) { return; }
+
+  // The GEMM output of a tile is bounded; the top-k results of the tiles are kept side by side for
+  // the final selection.
+  constexpr int64_t kMaxTileElems = 1ll << 26;
+  constexpr int64_t kMinTileRows  = 32768;
+  auto stream                     = resource::get_cuda_stream(res);
+  auto mr                         = resource::get_workspace_resource(res);
+  const int64_t tile_rows         = std::min(n_rows, std::max(k, kMinTileRows));
+  const int64_t n_tiles           = raft::div_rounding_up_safe(n_rows, tile_rows);
+  const int64_t n_cands           = n_tiles * k;
+  const int64_t query_rows =
+    std::clamp<int64_t>(kMaxTileElems / (tile_rows + 2 * n_cands), 1, n_queries);
+  const bool select_min = raft::distance::is_min_close(metric);
+  const bool need_norms = metric != raft::distance::DistanceType::InnerProduct;
+  const float dummy     = select_min ? raft::upper_bound<float>() : raft::lower_bound<float>();
+
+  rmm::device_uvector<float> data_norms_buf(
+    need_norms && !dataset_norms.has_value() ? n_rows : 0, stream, mr);
+  const float* data_norms = nullptr;
+  if (dataset_norms.has_value()) {
+    data_norms = dataset_norms->data_handle();
+  } else if (need_norms) {
+    low_precision_sq_norms(res, dataset.data_handle(), n_rows, dim, data_norms_buf.data());
+    data_norms = data_norms_buf.data();
+  }
+  rmm::device_uvector<float> query_norms(need_norms ? n_queries : 0, stream, mr);
+  if (need_norms) {
+    low_precision_sq_norms(res, queries.data_handle(), n_queries, dim, query_norms.data());
+  }
+
+  rmm::device_uvector<dot_t> dots(query_rows * tile_rows, stream, mr);
+  rmm::device_uvector<float> tile_dists(
+    std::is_same_v<dot_t, float> ? 0 : query_rows * tile_rows, stream, mr);
+  rmm::device_uvector<float> tile_topk_dists(query_rows * k, stream, mr);
+  rmm::device_uvector<IdxT> tile_topk_inds(query_rows * k, stream, mr);
+  rmm::device_uvector<float> cand_dists(query_rows * n_cands, stream, mr);
+  rmm::device_uvector<IdxT> cand_inds(query_rows * n_cands, stream, mr);
+
+  const dot_t alpha = 1;
+  const dot_t beta  = 0;
+  const low_precision_distance_op dist_op{metric};
+  for (int64_t q0 = 0; q0 < n_queries; q0 += query_rows) {
+    const int64_t q_rows = std::min(query_rows, n_queries - q0);
+    // The candidates of a short last tile do not fill all of its k slots.
+    raft::matrix::fill(
+      res, raft::make_device_vector_view(cand_dists.data(), q_rows * n_cands), dummy);
+    raft::matrix::fill(
+      res, raft::make_device_vector_view(cand_inds.data(), q_rows * n_cands), IdxT{0});
+    for (int64_t tile = 0; tile < n_tiles; tile++) {
+      const int64_t offset = tile * tile_rows;
+      const int64_t rows   = std::min(tile_rows, n_rows - offset);
+      const int64_t tile_k = std::min(rows, k);
+      // Row-major [q_rows, rows] dot products.
+      linalg::gemm(res,
+                   true,
+                   false,
+                   int(rows),
+                   int(q_rows),
+                   int(dim),
+                   &alpha,
+                   dataset.data_handle() + offset * dim,
+                   int(dim),
+                   queries.data_handle() + q0 * dim,
+                   int(dim),
+                   &beta,
+                   dots.data(),
+                   int(rows),
+                   stream);
+      float* dists_ptr = std::is_same_v<dot_t, float> ? reinterpret_cast<float*>(dots.data())
+                                                       : tile_dists.data();
+      const float* qn  = need_norms ? query_norms.data() + q0 : nullptr;
+      const float* xn  = need_norms ? data_norms + offset : nullptr;
+      raft::linalg::map_offset(
+        res,
+        raft::make_device_vector_view<float, int64_t>(dists_ptr, q_rows * rows),
+        [dist_op, qn, xn, rows, dots = dots.data()] __device__(int64_t i) {
+          const int64_t row = i / rows;
+          const int64_t col = i % rows;
+          return dist_op(dots[i], qn == nullptr ? 0.0f : qn[row], xn == nullptr ? 0.0f : xn[col]);
+        });
+      matrix::select_k<float, IdxT>(
+        res,
+        raft::make_device_matrix_view<const float, int64_t>(dists_ptr, q_rows, rows),
+        std::nullopt,
+        raft::make_device_matrix_view<float, int64_t>(tile_topk_dists.data(), q_rows, tile_k),
+        raft::make_device_matrix_view<IdxT, int64_t>(tile_topk_inds.data(), q_rows, tile_k),
+        select_min,
+        false);
+      // Place the tile results at the columns [tile * k, tile * k + tile_k) of the candidates.
+      const float* in_dists = tile_topk_dists.data();
+      const IdxT* in_inds   = tile_topk_inds.data();
+      float* out_dists      = cand_dists.data();
+      IdxT* out_inds        = cand_inds.data();
+      const int64_t col0    = tile * k;
+      auto count            = thrust::make_counting_iterator<int64_t>(0);
+      thrust::for_each(resource::get_thrust_policy(res),
+                       count,
+                       count + q_rows * tile_k,
+                       [=] __device__(int64_t i) {
+                         const int64_t out = (i / tile_k) * n_cands + col0 + i % tile_k;
+                         out_dists[out]    = in_dists[i];
+                         out_inds[out]     = in_inds[i] + static_cast<IdxT>(offset);
+                       });
+    }
+    matrix::select_k<float, IdxT>(
+      res,
+      raft::make_device_matrix_view<const float, int64_t>(cand_dists.data(), q_rows, n_cands),
+      raft::make_device_matrix_view<const IdxT, int64_t>(cand_inds.data(), q_rows, n_cands),
+      raft::make_device_matrix_view<float, int64_t>(
+        distances.data_handle() + q0 * k, q_rows, k),
+      raft::make_device_matrix_view<IdxT, int64_t>(neighbors.data_handle() + q0 * k, q_rows, k),
+      select_min,
+      true);
+  }
+}
+
+}  // namespace raft::neighbors::detail
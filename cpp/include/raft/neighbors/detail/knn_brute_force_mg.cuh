@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/detail/knn_merge_parts.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::brute_force::detail {
+
+/** See raft::neighbors::brute_force::knn_mg docs */
+template <typename T, typename IdxT>
+void knn_mg(raft::resources const& handle,
+            raft::device_matrix_view<const T, IdxT, row_major> index,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::device_matrix_view<T, IdxT, row_major> distances,
+            raft::distance::DistanceType metric,
+            std::optional<float> metric_arg)
+{
+  const auto& comm  = resource::get_comms(handle);
+  auto stream       = resource::get_cuda_stream(handle);
+  const int n_ranks = comm.get_size();
+  const int rank    = comm.get_rank();
+  const IdxT dim    = queries.extent(1);
+  const IdxT k      = neighbors.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::knn_mg(%zu, %d)", size_t(queries.extent(0)), n_ranks);
+  RAFT_EXPECTS(index.extent(1) == dim, "The index and the queries must have the same dimension");
+  RAFT_EXPECTS(neighbors.extent(0) == queries.extent(0) &&
+                 distances.extent(0) == queries.extent(0) && distances.extent(1) == k,
+               "The outputs must be of the shape [n_local_queries, k]");
+  RAFT_EXPECTS(index.extent(0) >= k, "Every rank must hold at least k rows of the index");
+
+  // The sizes of the local partitions of the index and of the queries of all the ranks
+  auto local_sizes = raft::make_device_vector<IdxT, int>(handle, 2);
+  auto all_sizes   = raft::make_device_vector<IdxT, int>(handle, 2 * n_ranks);
+  IdxT local_sizes_host[2] = {index.extent(0), queries.extent(0)};
+  raft::update_device(local_sizes.data_handle(), local_sizes_host, 2, stream);
+  comm.allgather(local_sizes.data_handle(), all_sizes.data_handle(), 2, stream);
+  std::vector<IdxT> all_sizes_host(2 * n_ranks);
+  raft::update_host(all_sizes_host.data(), all_sizes.data_handle(), 2 * n_ranks, stream);
+  RAFT_EXPECTS(comm.sync_stream(stream) == comms::status_t::SUCCESS,
+               "Failed to gather the partition sizes");
+
+  IdxT index_offset = 0;
+  IdxT n_queries    = 0;
+  std::vector<IdxT> query_offsets(n_ranks);
+  for (int r = 0; r < n_ranks; r++) {
+    if (r < rank) { index_offset += all_sizes_host[2 * r]; }
+    query_offsets[r] = n_queries;
+    n_queries += all_sizes_host[2 * r + 1];
+  }
+  const IdxT n_local_queries = queries.extent(0);
+  if (n_queries == 0) { return; }
+
+  // Every rank searches its partition of the index for the queries of all the ranks
+  auto all_queries = raft::make_device_matrix<T, IdxT>(handle, n_queries, dim);
+  {
+    std::vector<size_t> counts(n_ranks);
+    std::vector<size_t> displs(n_ranks);
+    for (int r = 0; r < n_ranks; r++) {
+      counts[r] = size_t(all_sizes_host[2 * r + 1]) * dim;
+      displs[r] = size_t(query_offsets[r]) * dim;
+    }
+    comm.allgatherv(
+      queries.data_handle(), all_queries.data_handle(), counts.data(), displs.data(), stream);
+  }
+  auto part_neighbors = raft::make_device_matrix<IdxT, IdxT>(handle, n_queries, k);
+  auto part_distances = raft::make_device_matrix<T, IdxT>(handle, n_queries, k);
+  std::vector<raft::device_matrix_view<const T, IdxT, row_major>> index_parts{index};
+  brute_force::knn<IdxT, T, IdxT, row_major, row_major>(handle,
+                                                        index_parts,
+                                                        raft::make_const_mdspan(all_queries.view()),
+                                                        part_neighbors.view(),
+                                                        part_distances.view(),
+                                                        metric,
+                                                        metric_arg,
+                                                        std::make_optional(index_offset));
+
+  // Every rank receives the candidates of all the partitions for its own queries, laid out as
+  // [n_ranks, n_local_queries, k] for the merge
+  auto recv_neighbors = raft::make_device_vector<IdxT, int64_t>(
+    handle, int64_t(n_ranks) * n_local_queries * k);
+  auto recv_distances =
+    raft::make_device_vector<T, int64_t>(handle, int64_t(n_ranks) * n_local_queries * k);
+  {
+    std::vector<size_t> send_counts(n_ranks);
+    std::vector<size_t> send_displs(n_ranks);
+    std::vector<size_t> recv_counts(n_ranks, size_t(n_local_queries) * k);
+    std::vector<size_t> recv_displs(n_ranks);
+    for (int r = 0; r < n_ranks; r++) {
+      send_counts[r] = size_t(all_sizes_host[2 * r + 1]) * k;
+      send_displs[r] = size_t(query_offsets[r]) * k;
+      recv_displs[r] = size_t(r) * n_local_queries * k;
+    }
+    comm.alltoallv(part_neighbors.data_handle(),
+                   send_counts.data(),
+                   send_displs.data(),
+                   recv_neighbors.data_handle(),
+                   recv_counts.data(),
+                   recv_displs.data(),
+                   stream);
+    comm.alltoallv(part_distances.data_handle(),
+                   send_counts.data(),
+                   send_displs.data(),
+                   recv_distances.data_handle(),
+                   recv_counts.data(),
+                   recv_displs.data(),
+                   stream);
+  }
+  if (n_local_queries == 0) { return; }
+
+  raft::neighbors::detail::knn_merge_parts<IdxT, T>(handle,
+                                                     recv_distances.data_handle(),
+                                                     recv_neighbors.data_handle(),
+                                                     distances.data_handle(),
+                                                     neighbors.data_handle(),
+                                                     size_t(n_local_queries),
+                                                     n_ranks,
+                                                     int(k),
+                                                     nullptr,
+                                                     raft::distance::is_min_close(metric));
+}
+
+}  // namespace raft::neighbors::brute_force::detail
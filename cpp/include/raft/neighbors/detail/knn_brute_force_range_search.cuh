@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/distance_ops/l2_exp.cuh>
+#include <raft/distance/distance.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/norm.cuh>
+#include <raft/neighbors/brute_force_types.hpp>
+#include <raft/neighbors/detail/faiss_select/DistanceUtils.h>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/cuda_device.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <cub/block/block_scan.cuh>
+#include <thrust/scan.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::neighbors::detail {
+
+/**
+ * The final distance of a pair from the raw output of `pairwise_distance` over a tile: the expanded
+ * L2 and cosine distances are computed as inner products, and completed here with the norms.
+ */
+template <typename T>
+struct range_search_dist_op {
+  raft::distance::DistanceType metric;
+  const T* row_norms;
+  const T* col_norms;
+
+  __device__ inline auto operator()(T raw, int64_t row, int64_t col) const -> T
+  {
+    switch (metric) {
+      case raft::distance::DistanceType::L2Expanded:
+      case raft::distance::DistanceType::L2SqrtExpanded: {
+        raft::distance::detail::ops::l2_exp_cutlass_op<T, T> l2_op(
+          metric == raft::distance::DistanceType::L2SqrtExpanded);
+        return l2_op(row_norms[row], col_norms[col], raw);
+      }
+      case raft::distance::DistanceType::CosineExpanded:
+        return T(1.0) - raw / (row_norms[row] * col_norms[col]);
+      default: return raw;
+    }
+  }
+};
+
+/**
+ * Scan one row of a distance tile per block, in the order of the columns.
+ *
+ * The neighbors of the row `row0 + blockIdx.x` within the radius are written at `cursors[row]` of
+ * the outputs (if `Fill`), and the cursor is advanced by their number. The first pass counts the
+ * neighbors (cursors start at zero), the second one writes them (cursors start at the row offsets).
+ */
+template <typename T, typename IdxT, int BlockSize, bool Fill>
+RAFT_KERNEL __launch_bounds__(BlockSize)
+  range_search_tile_kernel(const T* dists,  // [gridDim.x, n_cols]
+                           int64_t n_cols,
+                           int64_t row0,
+                           int64_t col0,
+                           range_search_dist_op<T> dist_op,
+                           T radius,
+                           bool select_min,
+                           int64_t* cursors,
+                           IdxT* out_indices,
+                           T* out_dists)
+{
+  using block_scan = cub::BlockScan<int, BlockSize>;
+  __shared__ typename block_scan::TempStorage scan_storage;
+
+  const int64_t row  = row0 + blockIdx.x;
+  const T* row_dists = dists + blockIdx.x * n_cols;
+  int64_t cursor     = cursors[row];
+  for (int64_t j0 = 0; j0 < n_cols; j0 += BlockSize) {
+    const int64_t j = j0 + threadIdx.x;
+    T dist          = 0;
+    int in_range    = 0;
+    if (j < n_cols) {
+      dist     = dist_op(row_dists[j], row, col0 + j);
+      in_range = select_min ? dist <= radius : dist >= radius;
+    }
+    int pos, count;
+    block_scan(scan_storage).ExclusiveSum(in_range, pos, count);
+    if (Fill && in_range) {
+      out_indices[cursor + pos] = static_cast<IdxT>(col0 + j);
+      out_dists[cursor + pos]   = dist;
+    }
+    cursor += count;
+    // The temp storage is reused by the next chunk
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) { cursors[row] = cursor; }
+}
+
+/** See raft::neighbors::brute_force::range_search docs */
+template <typename T, typename IdxT>
+void brute_force_range_search(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<T>& idx,
+  raft::device_matrix_view<const T, int64_t, row_major> queries,
+  T radius,
+  raft::device_sparsity_owning_csr_matrix<T, int64_t, IdxT, int64_t>& out,
+  size_t max_row_tile_size = 0,
+  size_t max_col_tile_size = 0)
+{
+  constexpr int kBlockSize = 256;
+  const size_t m           = queries.extent(0);
+  const size_t n           = idx.dataset().extent(0);
+  const size_t d           = idx.dataset().extent(1);
+  const auto metric        = idx.metric();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::range_search(%zu rows, %zu queries)", n, m);
+  auto out_view = out.structure_view();
+  RAFT_EXPECTS(queries.extent(1) == int64_t(d),
+               "Number of columns in queries must match brute force index");
+  RAFT_EXPECTS(out_view.get_n_rows() == int64_t(m) && out_view.get_n_cols() == IdxT(n),
+               "The output must be a [n_queries, index size] matrix");
+  RAFT_EXPECTS(metric != raft::distance::DistanceType::Haversine,
+               "The Haversine distance is not supported by the range search");
+
+  auto stream  = resource::get_cuda_stream(res);
+  auto mr      = resource::get_workspace_resource(res);
+  auto* indptr = out_view.get_indptr().data();
+  RAFT_CUDA_TRY(cudaMemsetAsync(indptr, 0, (m + 1) * sizeof(int64_t), stream));
+  if (m == 0 || n == 0) {
+    out.initialize_sparsity(0);
+    return;
+  }
+
+  size_t tile_rows = 0;
+  size_t tile_cols = 0;
+  faiss_select::chooseTileSize(
+    m, n, d, sizeof(T), rmm::available_device_memory().second, tile_rows, tile_cols);
+  if (max_row_tile_size && (tile_rows > max_row_tile_size)) { tile_rows = max_row_tile_size; }
+  if (max_col_tile_size && (tile_cols > max_col_tile_size)) { tile_cols = max_col_tile_size; }
+
+  // The expanded distances are computed as inner products and completed with the norms
+  auto pairwise_metric = metric;
+  const T* row_norms   = nullptr;
+  const T* col_norms   = idx.has_norms() ? idx.norms().data_handle() : nullptr;
+  const bool expanded  = metric == raft::distance::DistanceType::L2Expanded ||
+                        metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                        metric == raft::distance::DistanceType::CosineExpanded;
+  rmm::device_uvector<T> norms(expanded ? m + (col_norms ? 0 : n) : 0, stream, mr);
+  if (expanded) {
+    // cosine needs the l2norm, where as l2 distances needs the squared norm
+    auto norm_rows = [&](const T* data, size_t n_rows, T* out_norms) {
+      if (metric == raft::distance::DistanceType::CosineExpanded) {
+        raft::linalg::rowNorm(out_norms,
+                              data,
+                              d,
+                              n_rows,
+                              raft::linalg::NormType::L2Norm,
+                              true,
+                              stream,
+                              raft::sqrt_op{});
+      } else {
+        raft::linalg::rowNorm(
+          out_norms, data, d, n_rows, raft::linalg::NormType::L2Norm, true, stream);
+      }
+    };
+    norm_rows(queries.data_handle(), m, norms.data());
+    row_norms = norms.data();
+    if (!col_norms) {
+      norm_rows(idx.dataset().data_handle(), n, norms.data() + m);
+      col_norms = norms.data() + m;
+    }
+    pairwise_metric = raft::distance::DistanceType::InnerProduct;
+  }
+  const range_search_dist_op<T> dist_op{metric, row_norms, col_norms};
+  const bool select_min = raft::distance::is_min_close(metric);
+
+  rmm::device_uvector<T> tile_dists(tile_rows * tile_cols, stream, mr);
+  rmm::device_uvector<int64_t> cursors(m, stream, mr);
+
+  // Both passes compute the same distance tiles: the first one counts the neighbors of every
+  // query, the second one writes them, so that only the output scales with the number of pairs.
+  auto run_pass = [&](auto fill) {
+    constexpr bool kFill = decltype(fill)::value;
+    auto kernel          = range_search_tile_kernel<T, IdxT, kBlockSize, kFill>;
+    // The indices and elements are allocated once the number of neighbors is known
+    IdxT* out_indices = kFill ? out.structure_view().get_indices().data() : nullptr;
+    T* out_dists      = kFill ? out.get_elements().data() : nullptr;
+    for (size_t i = 0; i < m; i += tile_rows) {
+      const size_t rows = std::min(tile_rows, m - i);
+      for (size_t j = 0; j < n; j += tile_cols) {
+        const size_t cols = std::min(tile_cols, n - j);
+        // The tile is small enough for the int32 pairwise_distance instantiations
+        distance::pairwise_distance<T, int>(res,
+                                            queries.data_handle() + i * d,
+                                            idx.dataset().data_handle() + j * d,
+                                            tile_dists.data(),
+                                            rows,
+                                            cols,
+                                            d,
+                                            pairwise_metric,
+                                            true,
+                                            idx.metric_arg());
+        kernel<<<rows, kBlockSize, 0, stream>>>(tile_dists.data(),
+                                                int64_t(cols),
+                                                int64_t(i),
+                                                int64_t(j),
+                                                dist_op,
+                                                radius,
+                                                select_min,
+                                                cursors.data(),
+                                                out_indices,
+                                                out_dists);
+        RAFT_CUDA_TRY(cudaPeekAtLastError());
+      }
+    }
+  };
+
+  RAFT_CUDA_TRY(cudaMemsetAsync(cursors.data(), 0, m * sizeof(int64_t), stream));
+  run_pass(std::false_type{});
+  thrust::inclusive_scan(
+    resource::get_thrust_policy(res), cursors.data(), cursors.data() + m, indptr + 1);
+  int64_t nnz = 0;
+  raft::update_host(&nnz, indptr + m, 1, stream);
+  resource::sync_stream(res);
+  out.initialize_sparsity(nnz);
+  if (nnz == 0) { return; }
+
+  raft::copy(cursors.data(), indptr, m, stream);
+  run_pass(std::true_type{});
+}
+
+}  // namespace raft::neighbors::detail
@@ -13,116 +13,179 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-
 #pragma once
 
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/error.hpp>
-#include <raft/neighbors/detail/faiss_select/DistanceUtils.h>
-#include <raft/neighbors/detail/faiss_select/Select.cuh>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/select_k.cuh>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
-#include <cstdint>
-
-namespace raft::neighbors::detail {
-
-template <typename value_idx = std::int64_t,
-          typename value_t   = float,
-          int warp_q,
-          int thread_q,
-          int tpb>
-RAFT_KERNEL knn_merge_parts_kernel(const value_t* inK,
-                                   const value_idx* inV,
-                                   value_t* outK,
-                                   value_idx* outV,
-                                   size_t n_samples,
-                                   int n_parts,
-                                   value_t initK,
-                                   value_idx initV,
-                                   int k,
-                                   value_idx* translations)
-{
-  constexpr int kNumWarps = tpb / WarpSize;
-
-  __shared__ value_t smemK[kNumWarps * warp_q];
-  __shared__ value_idx smemV[kNumWarps * warp_q];
-
-  /**
-   * Uses shared memory
-   */
-  faiss_select::
-    BlockSelect<value_t, value_idx, false, faiss_select::Comparator<value_t>, warp_q, thread_q, tpb>
-      heap(initK, initV, smemK, smemV, k);
-
-  // Grid is exactly sized to rows available
-  int row     = blockIdx.x;
-  int total_k = k * n_parts;
-
-  int i = threadIdx.x;
-
-  // Get starting pointers for cols in current thread
-  int part       = i / k;
-  size_t row_idx = (row * k) + (part * n_samples * k);
+#include <rmm/device_uvector.hpp>
 
-  int col = i % k;
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
 
-  const value_t* inKStart   = inK + (row_idx + col);
-  const value_idx* inVStart = inV + (row_idx + col);
-
-  int limit             = Pow2<WarpSize>::roundDown(total_k);
-  value_idx translation = 0;
+#include <algorithm>
+#include <cstdint>
+#include <optional>
 
-  for (; i < limit; i += tpb) {
-    translation = translations[part];
-    heap.add(*inKStart, (*inVStart) + translation);
+namespace raft::neighbors::detail {
 
-    part    = (i + tpb) / k;
-    row_idx = (row * k) + (part * n_samples * k);
+/**
+ * The maximum length of the rows selected from in one merge step. The parts are merged in groups of
+ * at most `kMaxMergeRowLen / k` (but at least two), so that the rows stay in the range where
+ * `select_k` performs best; the groups are merged again hierarchically.
+ */
+constexpr int64_t kMaxMergeRowLen = 1 << 16;
+/** The maximum number of elements of the buffer the candidates of a merge step are gathered in. */
+constexpr int64_t kMaxMergeBufferSize = 1 << 24;
 
-    col = (i + tpb) % k;
+/**
+ * Gather the rows [row_begin, row_begin + n_rows) of the parts [part_begin, part_begin + n_group)
+ * of the [n_parts, n_samples, k] inputs side by side into the [n_rows, n_group * k] outputs,
+ * adding the translations of the parts (if not `nullptr`) to the indices.
+ */
+template <typename value_idx, typename value_t>
+void gather_merge_candidates(raft::resources const& res,
+                             const value_t* inK,
+                             const value_idx* inV,
+                             size_t n_samples,
+                             int k,
+                             int part_begin,
+                             int n_group,
+                             size_t row_begin,
+                             size_t n_rows,
+                             const value_idx* translations,
+                             value_t* outK,
+                             value_idx* outV)
+{
+  const int64_t row_len = int64_t(n_group) * k;
+  auto count            = thrust::make_counting_iterator<int64_t>(0);
+  thrust::for_each(resource::get_thrust_policy(res),
+                   count,
+                   count + int64_t(n_rows) * row_len,
+                   [=] __device__(int64_t i) {
+                     const int64_t row  = i / row_len;
+                     const int64_t col  = i % row_len;
+                     const int64_t part = part_begin + col / k;
+                     const int64_t in =
+                       (part * int64_t(n_samples) + int64_t(row_begin) + row) * k + col % k;
+                     const value_idx translation =
+                       translations != nullptr ? translations[part] : value_idx(0);
+                     outK[i] = inK[in];
+                     outV[i] = inV[in] + translation;
+                   });
+}
 
-    inKStart = inK + (row_idx + col);
-    inVStart = inV + (row_idx + col);
+/**
+ * @brief Merge knn distances and index matrix, which have been partitioned
+ * by row, into a single matrix with only the k-nearest neighbors.
+ *
+ * The candidates of (a group of) the parts are gathered into contiguous rows with the translations
+ * applied on the fly and merged with `matrix::select_k`. If there are too many parts for a single
+ * step, the groups are merged into an intermediate [n_groups, n_samples, k] buffer, which is then
+ * merged the same way (a tree merge), so any number of parts and any k are supported.
+ *
+ * @param res raft resources
+ * @param inK partitioned knn distance matrix [n_parts, n_samples, k]
+ * @param inV partitioned knn index matrix [n_parts, n_samples, k]
+ * @param outK merged knn distance matrix [n_samples, k], sorted in ascending order (descending if
+ *   `select_min` is false)
+ * @param outV merged knn index matrix [n_samples, k]
+ * @param n_samples number of samples per partition
+ * @param n_parts number of partitions
+ * @param k number of neighbors per partition (also number of merged neighbors)
+ * @param translations mapping of index offsets for each partition (may be `nullptr`)
+ * @param select_min whether to keep the k smallest (e.g. distances) or the k largest
+ *   (e.g. similarities) values
+ */
+template <typename value_idx = std::int64_t, typename value_t = float>
+inline void knn_merge_parts(raft::resources const& res,
+                            const value_t* inK,
+                            const value_idx* inV,
+                            value_t* outK,
+                            value_idx* outV,
+                            size_t n_samples,
+                            int n_parts,
+                            int k,
+                            const value_idx* translations,
+                            bool select_min = true)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "neighbors::knn_merge_parts(%zu, n_parts = %d, k = %d)", n_samples, n_parts, k);
+  RAFT_EXPECTS(k > 0, "k must be positive");
+  RAFT_EXPECTS(n_parts > 0, "The number of parts must be positive");
+  if (n_samples == 0) { return; }
+
+  auto stream = resource::get_cuda_stream(res);
+  auto mr     = resource::get_workspace_resource(res);
+  const int n_group =
+    int(std::min<int64_t>(n_parts, std::max<int64_t>(2, kMaxMergeRowLen / k)));
+  const int n_groups     = raft::ceildiv(n_parts, n_group);
+  const int64_t row_len  = int64_t(n_group) * k;
+  const size_t row_batch = std::min<size_t>(
+    n_samples, size_t(std::max<int64_t>(1, kMaxMergeBufferSize / row_len)));
+
+  // With several groups, their results are merged again in the next level of the tree.
+  rmm::device_uvector<value_t> level_k(0, stream, mr);
+  rmm::device_uvector<value_idx> level_v(0, stream, mr);
+  if (n_groups > 1) {
+    level_k.resize(size_t(n_groups) * n_samples * k, stream);
+    level_v.resize(size_t(n_groups) * n_samples * k, stream);
   }
 
-  // Handle last remainder fraction of a warp of elements
-  if (i < total_k) {
-    translation = translations[part];
-    heap.addThreadQ(*inKStart, (*inVStart) + translation);
+  rmm::device_uvector<value_t> buf_k(row_batch * row_len, stream, mr);
+  rmm::device_uvector<value_idx> buf_v(row_batch * row_len, stream, mr);
+  for (int group = 0; group < n_groups; group++) {
+    const int part_begin = group * n_group;
+    const int group_size = std::min(n_group, n_parts - part_begin);
+    const int64_t len    = int64_t(group_size) * k;
+    value_t* dstK        = n_groups > 1 ? level_k.data() + size_t(group) * n_samples * k : outK;
+    value_idx* dstV      = n_groups > 1 ? level_v.data() + size_t(group) * n_samples * k : outV;
+    for (size_t row_begin = 0; row_begin < n_samples; row_begin += row_batch) {
+      const size_t n_rows = std::min(row_batch, n_samples - row_begin);
+      gather_merge_candidates(res,
+                              inK,
+                              inV,
+                              n_samples,
+                              k,
+                              part_begin,
+                              group_size,
+                              row_begin,
+                              n_rows,
+                              translations,
+                              buf_k.data(),
+                              buf_v.data());
+      raft::matrix::select_k<value_t, value_idx>(
+        res,
+        raft::make_device_matrix_view<const value_t, int64_t>(buf_k.data(), n_rows, len),
+        raft::make_device_matrix_view<const value_idx, int64_t>(buf_v.data(), n_rows, len),
+        raft::make_device_matrix_view<value_t, int64_t>(dstK + row_begin * k, n_rows, k),
+        raft::make_device_matrix_view<value_idx, int64_t>(dstV + row_begin * k, n_rows, k),
+        select_min,
+        true);
+    }
   }
-
-  heap.reduce();
-
-  for (int i = threadIdx.x; i < k; i += tpb) {
-    outK[row * k + i] = smemK[i];
-    outV[row * k + i] = smemV[i];
+  if (n_groups > 1) {
+    knn_merge_parts<value_idx, value_t>(res,
+                                        level_k.data(),
+                                        level_v.data(),
+                                        outK,
+                                        outV,
+                                        n_samples,
+                                        n_groups,
+                                        k,
+                                        nullptr,
+                                        select_min);
   }
 }
 
-template <typename value_idx = std::int64_t, typename value_t = float, int warp_q, int thread_q>
-inline void knn_merge_parts_impl(const value_t* inK,
-                                 const value_idx* inV,
-                                 value_t* outK,
-                                 value_idx* outV,
-                                 size_t n_samples,
-                                 int n_parts,
-                                 int k,
-                                 cudaStream_t stream,
-                                 value_idx* translations)
-{
-  auto grid = dim3(n_samples);
-
-  constexpr int n_threads = (warp_q < 1024) ? 128 : 64;
-  auto block              = dim3(n_threads);
-
-  auto kInit = std::numeric_limits<value_t>::max();
-  auto vInit = -1;
-  knn_merge_parts_kernel<value_idx, value_t, warp_q, thread_q, n_threads>
-    <<<grid, block, 0, stream>>>(
-      inK, inV, outK, outV, n_samples, n_parts, kInit, vInit, k, translations);
-  RAFT_CUDA_TRY(cudaPeekAtLastError());
-}
-
 /**
  * @brief Merge knn distances and index matrix, which have been partitioned
  * by row, into a single matrix with only the k-nearest neighbors.
@@ -136,6 +199,7 @@ inline void knn_merge_parts_impl(const value_t* inK,
  * @param k number of neighbors per partition (also number of merged neighbors)
  * @param stream CUDA stream to use
  * @param translations mapping of index offsets for each partition
+ * @param select_min whether to keep the k smallest or the k largest values
  */
 template <typename value_idx = std::int64_t, typename value_t = float>
 inline void knn_merge_parts(const value_t* inK,
@@ -146,30 +210,12 @@ inline void knn_merge_parts(const value_t* inK,
                             int n_parts,
                             int k,
                             cudaStream_t stream,
-                            value_idx* translations)
+                            value_idx* translations,
+                            bool select_min = true)
 {
-  if (k == 1)
-    knn_merge_parts_impl<value_idx, value_t, 1, 1>(
-      inK, inV, outK, outV, n_samples, n_parts, k, stream, translations);
-  else if (k <= 32)
-    knn_merge_parts_impl<value_idx, value_t, 32, 2>(
-      inK, inV, outK, outV, n_samples, n_parts, k, stream, translations);
-  else if (k <= 64)
-    knn_merge_parts_impl<value_idx, value_t, 64, 3>(
-      inK, inV, outK, outV, n_samples, n_parts, k, stream, translations);
-  else if (k <= 128)
-    knn_merge_parts_impl<value_idx, value_t, 128, 3>(
-      inK, inV, outK, outV, n_samples, n_parts, k, stream, translations);
-  else if (k <= 256)
-    knn_merge_parts_impl<value_idx, value_t, 256, 4>(
-      inK, inV, outK, outV, n_samples, n_parts, k, stream, translations);
-  else if (k <= 512)
-    knn_merge_parts_impl<value_idx, value_t, 512, 8>(
-      inK, inV, outK, outV, n_samples, n_parts, k, stream, translations);
-  else if (k <= 1024)
-    knn_merge_parts_impl<value_idx, value_t, 1024, 8>(
-      inK, inV, outK, outV, n_samples, n_parts, k, stream, translations);
-  else
-    THROW("Unimplemented for k=%d, knn_merge_parts works for k<=1024", k);
+  raft::resources handle;
+  resource::set_cuda_stream(handle, stream);
+  knn_merge_parts<value_idx, value_t>(
+    handle, inK, inV, outK, outV, n_samples, n_parts, k, translations, select_min);
 }
 }  // namespace raft::neighbors::detail
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_setter.hpp>
+
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace raft::neighbors::detail {
+
+/**
+ * Run `f(i)` for every device `device_ids[i]` on a separate host thread, with the device set as
+ * the current one. The first exception thrown by any of the threads is rethrown once all of them
+ * have finished.
+ */
+template <typename F>
+void for_each_device(const std::vector<int>& device_ids, F&& f)
+{
+  std::vector<std::exception_ptr> errors(device_ids.size());
+  std::vector<std::thread> threads;
+  threads.reserve(device_ids.size());
+  for (size_t i = 0; i < device_ids.size(); i++) {
+    threads.emplace_back([&, i]() {
+      try {
+        raft::device_setter dev(device_ids[i]);
+        f(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& e : errors) {
+    if (e) { std::rethrow_exception(e); }
+  }
+}
+
+}  // namespace raft::neighbors::detail
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_resources.hpp>
+#include <raft/core/device_setter.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/neighbors/detail/multi_device.hpp>
+#include <raft/neighbors/detail/sharded_search.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::mg::detail {
+
+using raft::neighbors::detail::for_each_device;
+
+/** See raft::neighbors::mg::search_replicated docs */
+template <typename T, typename IdxT, typename IndexT, typename SearchF>
+void search_replicated(const std::vector<int>& device_ids,
+                       const std::vector<raft::device_resources>& dev_res,
+                       const std::vector<IndexT>& indices,
+                       SearchF&& search,
+                       raft::host_matrix_view<const T, int64_t, row_major> queries,
+                       raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+                       raft::host_matrix_view<float, int64_t, row_major> distances,
+                       int64_t n_rows_per_batch)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "mg::search_replicated(%zu, %zu)", size_t(queries.extent(0)), device_ids.size());
+  RAFT_EXPECTS(indices.size() == device_ids.size(), "There must be one index per rank");
+  RAFT_EXPECTS(n_rows_per_batch > 0, "n_rows_per_batch must be positive");
+  const int64_t n_queries = queries.extent(0);
+  const int64_t dim       = queries.extent(1);
+  const int64_t k         = neighbors.extent(1);
+  const int64_t n_ranks   = device_ids.size();
+  const int64_t per_rank  = raft::ceildiv<int64_t>(n_queries, n_ranks);
+
+  // Every rank searches its own slice of the queries, copied straight from the host memory: the
+  // queries are not broadcast, as no rank needs the queries of the others.
+  for_each_device(device_ids, [&](size_t rank) {
+    const auto& res = dev_res[rank];
+    auto stream     = resource::get_cuda_stream(res);
+    auto begin      = std::min<int64_t>(rank * per_rank, n_queries);
+    auto end        = std::min<int64_t>(begin + per_rank, n_queries);
+    if (begin == end) { return; }
+    auto batch_size  = std::min(n_rows_per_batch, end - begin);
+    auto d_queries   = raft::make_device_matrix<T, int64_t>(res, batch_size, dim);
+    auto d_neighbors = raft::make_device_matrix<IdxT, int64_t>(res, batch_size, k);
+    auto d_distances = raft::make_device_matrix<float, int64_t>(res, batch_size, k);
+    for (int64_t offset = begin; offset < end; offset += batch_size) {
+      auto n = std::min(batch_size, end - offset);
+      raft::copy(d_queries.data_handle(), queries.data_handle() + offset * dim, n * dim, stream);
+      search(res,
+             indices[rank],
+             raft::make_device_matrix_view<const T, int64_t>(d_queries.data_handle(), n, dim),
+             raft::make_device_matrix_view<IdxT, int64_t>(d_neighbors.data_handle(), n, k),
+             raft::make_device_matrix_view<float, int64_t>(d_distances.data_handle(), n, k));
+      raft::copy(neighbors.data_handle() + offset * k, d_neighbors.data_handle(), n * k, stream);
+      raft::copy(distances.data_handle() + offset * k, d_distances.data_handle(), n * k, stream);
+      resource::sync_stream(res);
+    }
+  });
+}
+
+/** See raft::neighbors::mg::search_sharded docs */
+template <typename T, typename IdxT, typename IndexT, typename SearchF>
+void search_sharded(const std::vector<int>& device_ids,
+                    const std::vector<raft::device_resources>& dev_res,
+                    int root,
+                    const std::vector<IndexT>& shards,
+                    SearchF&& search,
+                    raft::host_matrix_view<const T, int64_t, row_major> queries,
+                    raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+                    raft::host_matrix_view<float, int64_t, row_major> distances,
+                    int64_t n_rows_per_batch,
+                    const std::optional<std::vector<IdxT>>& id_offsets,
+                    bool select_min)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "mg::search_sharded(%zu, %zu)", size_t(queries.extent(0)), device_ids.size());
+  RAFT_EXPECTS(shards.size() == device_ids.size(), "There must be one shard per rank");
+
+  // The batches of queries are broadcast and the results gathered with the collectives of the
+  // ranks, and merged on the root.
+  raft::device_setter dev_root(device_ids[root]);
+  raft::neighbors::detail::search_shards<T, IdxT, IdxT>(
+    dev_res[root],
+    device_ids,
+    [&](size_t rank) -> raft::resources const& { return dev_res[rank]; },
+    [&](raft::resources const&,
+        size_t rank,
+        raft::device_matrix_view<const T, int64_t, row_major> shard_queries,
+        raft::device_matrix_view<IdxT, int64_t, row_major> shard_neighbors,
+        raft::device_matrix_view<float, int64_t, row_major> shard_distances) {
+      search(dev_res[rank], shards[rank], shard_queries, shard_neighbors, shard_distances);
+    },
+    queries.data_handle(),
+    queries.extent(0),
+    queries.extent(1),
+    neighbors.extent(1),
+    neighbors.data_handle(),
+    distances.data_handle(),
+    n_rows_per_batch,
+    id_offsets,
+    select_min,
+    true);
+}
+
+}  // namespace raft::neighbors::mg::detail
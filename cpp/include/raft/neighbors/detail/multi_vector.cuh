@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/matrix/select_k.cuh>
+#include <raft/neighbors/multi_vector_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/reduction.cuh>
+
+#include <thrust/binary_search.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/sort.h>
+#include <thrust/tuple.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+namespace raft::neighbors::multi_vector::detail {
+
+constexpr uint32_t kBlockSize = 256;
+/** Marks the token candidates that are not tokens of the index; they are sorted last. */
+constexpr int64_t kInvalidKey = std::numeric_limits<int64_t>::max();
+
+/** The number of the blocks of a grid-stride loop over `n` elements. */
+inline auto grid_size(int64_t n) -> uint32_t
+{
+  return static_cast<uint32_t>(
+    std::min<int64_t>(raft::ceildiv<int64_t>(n, kBlockSize), std::numeric_limits<int32_t>::max()));
+}
+
+/** The document of a token: the last document that starts not after the token. */
+_RAFT_DEVICE inline auto doc_of_token(const int64_t* doc_offsets, int64_t n_docs, int64_t token)
+  -> int64_t
+{
+  int64_t lo = 0;
+  int64_t hi = n_docs;
+  while (hi - lo > 1) {
+    const int64_t mid = lo + (hi - lo) / 2;
+    if (doc_offsets[mid] <= token) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * The (query, document) key and the similarity of every token candidate. The key is
+ * `query * n_docs + doc`, so that sorting by the keys groups the candidates by the queries.
+ */
+template <typename IdxT>
+RAFT_KERNEL map_to_docs_kernel(const IdxT* token_ids,  // [n_entries]
+                               const float* token_distances,  // [n_entries]
+                               int64_t n_entries,
+                               uint32_t n_token_candidates,
+                               uint32_t n_query_tokens,
+                               const int64_t* doc_offsets,  // [n_docs + 1]
+                               int64_t n_docs,
+                               int64_t n_tokens,
+                               float sign,
+                               int64_t* keys,  // [n_entries]
+                               int64_t* query_tokens,  // [n_entries]
+                               float* sims)  // [n_entries]
+{
+  for (int64_t i = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; i < n_entries;
+       i += int64_t(blockDim.x) * gridDim.x) {
+    const int64_t query_token = i / n_token_candidates;
+    const auto token          = token_ids[i];
+    int64_t key               = kInvalidKey;
+    if (static_cast<uint64_t>(token) < static_cast<uint64_t>(n_tokens)) {
+      key = (query_token / n_query_tokens) * n_docs +
+            doc_of_token(doc_offsets, n_docs, static_cast<int64_t>(token));
+    }
+    keys[i]         = key;
+    query_tokens[i] = query_token;
+    sims[i]         = sign * token_distances[i];
+  }
+}
+
+/** Place the scored documents of every query in its row of the candidate matrix. */
+RAFT_KERNEL scatter_docs_kernel(const int64_t* doc_keys,  // [n_found]
+                                const float* doc_scores,  // [n_found]
+                                int64_t n_found,
+                                const int64_t* query_starts,  // [n_queries]
+                                int64_t n_docs,
+                                uint32_t capacity,
+                                int64_t* out_ids,  // [n_queries, capacity]
+                                float* out_scores)  // [n_queries, capacity]
+{
+  for (int64_t i = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; i < n_found;
+       i += int64_t(blockDim.x) * gridDim.x) {
+    const int64_t q   = doc_keys[i] / n_docs;
+    const int64_t out = q * capacity + (i - query_starts[q]);
+    out_ids[out]      = doc_keys[i] - q * n_docs;
+    out_scores[out]   = doc_scores[i];
+  }
+}
+
+/**
+ * The exact MaxSim of the candidate documents (one warp per candidate; a lane per query token).
+ * The missing candidates get the lowest score.
+ */
+template <typename T>
+RAFT_KERNEL maxsim_kernel(const T* queries,  // [n_queries * n_query_tokens, dim]
+                          uint32_t n_query_tokens,
+                          uint32_t dim,
+                          const T* tokens,  // [n_tokens, dim]
+                          const int64_t* doc_offsets,  // [n_docs + 1]
+                          int64_t n_docs,
+                          const int64_t* candidates,  // [n_queries, n_candidates]
+                          uint32_t n_candidates,
+                          bool inner_product,
+                          float* scores)  // [n_queries, n_candidates]
+{
+  const int64_t i   = blockIdx.x;
+  const int64_t q   = i / n_candidates;
+  const int64_t doc = candidates[i];
+  if (static_cast<uint64_t>(doc) >= static_cast<uint64_t>(n_docs)) {
+    if (threadIdx.x == 0) { scores[i] = raft::lower_bound<float>(); }
+    return;
+  }
+  const int64_t begin = doc_offsets[doc];
+  const int64_t end   = doc_offsets[doc + 1];
+  const auto to_float = spatial::knn::detail::utils::mapping<float>{};
+  float sum           = 0;
+  for (uint32_t t = threadIdx.x; t < n_query_tokens && end > begin; t += blockDim.x) {
+    const T* query = queries + (q * n_query_tokens + t) * dim;
+    float best     = raft::lower_bound<float>();
+    for (int64_t j = begin; j < end; j++) {
+      const T* token = tokens + j * dim;
+      float sim      = 0;
+      for (uint32_t d = 0; d < dim; d++) {
+        const float a = to_float(query[d]);
+        const float b = to_float(token[d]);
+        sim += inner_product ? a * b : -(a - b) * (a - b);
+      }
+      best = max(best, sim);
+    }
+    sum += best;
+  }
+  sum = raft::warpReduce(sum);
+  if (threadIdx.x == 0) { scores[i] = sum; }
+}
+
+inline auto build(raft::resources const& res,
+                  raft::device_vector_view<const int64_t, int64_t> doc_offsets) -> index
+{
+  auto stream = resource::get_cuda_stream(res);
+  RAFT_EXPECTS(doc_offsets.extent(0) > 0, "The offsets must include the total number of tokens");
+  const int64_t n_docs = doc_offsets.extent(0) - 1;
+  int64_t first        = 0;
+  int64_t n_tokens     = 0;
+  raft::copy(&first, doc_offsets.data_handle(), 1, stream);
+  raft::copy(&n_tokens, doc_offsets.data_handle() + n_docs, 1, stream);
+  resource::sync_stream(res);
+  RAFT_EXPECTS(first == 0, "The first document must start at the token zero");
+  RAFT_EXPECTS(thrust::is_sorted(resource::get_thrust_policy(res),
+                                 doc_offsets.data_handle(),
+                                 doc_offsets.data_handle() + n_docs + 1),
+               "The document offsets must not decrease");
+
+  index idx(res, n_docs, n_tokens);
+  raft::copy(idx.doc_offsets().data_handle(), doc_offsets.data_handle(), n_docs + 1, stream);
+  return idx;
+}
+
+template <typename T, typename IdxT, typename TokenSearchFn>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index& idx,
+            TokenSearchFn&& token_search,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            int64_t n_query_tokens,
+            raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+            raft::device_matrix_view<float, int64_t, row_major> scores,
+            std::optional<raft::device_matrix_view<const T, int64_t, row_major>> token_dataset)
+{
+  const int64_t n_queries = neighbors.extent(0);
+  const int64_t k         = neighbors.extent(1);
+  const int64_t n_docs    = idx.n_docs();
+  const uint32_t n_cand   = params.n_token_candidates;
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "multi_vector::search(n_queries = %zu, k = %zu)", size_t(n_queries), size_t(k));
+  RAFT_EXPECTS(n_query_tokens > 0 && queries.extent(0) == n_queries * n_query_tokens,
+               "The queries must have n_query_tokens rows per query");
+  RAFT_EXPECTS(scores.extent(0) == n_queries && scores.extent(1) == k,
+               "The neighbors and scores must have the same shape");
+  RAFT_EXPECTS(n_cand > 0 && int64_t(n_cand) <= idx.n_tokens(),
+               "The number of the token candidates must be within [1, n_tokens]");
+  // Every query token contributes at most n_cand documents.
+  const int64_t capacity = n_query_tokens * n_cand;
+  RAFT_EXPECTS(k <= capacity, "k must not exceed n_query_tokens * n_token_candidates");
+  if (token_dataset.has_value()) {
+    RAFT_EXPECTS(token_dataset->extent(0) == idx.n_tokens(),
+                 "The token dataset must have n_tokens rows");
+    RAFT_EXPECTS(token_dataset->extent(1) == queries.extent(1),
+                 "Wrong dimensionality of the queries");
+    RAFT_EXPECTS(int64_t(params.n_rerank_candidates) >= k, "n_rerank_candidates must be >= k");
+    RAFT_EXPECTS(params.metric == raft::distance::DistanceType::InnerProduct ||
+                   params.metric == raft::distance::DistanceType::L2Expanded ||
+                   params.metric == raft::distance::DistanceType::L2Unexpanded,
+                 "The re-scoring supports the inner product and the squared L2 distance only");
+  }
+  if (n_queries == 0) { return; }
+
+  auto stream      = resource::get_cuda_stream(res);
+  auto exec_policy = resource::get_thrust_policy(res);
+
+  // The token-level search of all query tokens in one batch
+  const int64_t n_query_rows = queries.extent(0);
+  const int64_t n_entries    = n_query_rows * n_cand;
+  auto token_ids       = raft::make_device_matrix<IdxT, int64_t>(res, n_query_rows, n_cand);
+  auto token_distances = raft::make_device_matrix<float, int64_t>(res, n_query_rows, n_cand);
+  token_search(res, queries, token_ids.view(), token_distances.view());
+
+  auto keys         = raft::make_device_vector<int64_t, int64_t>(res, n_entries);
+  auto query_tokens = raft::make_device_vector<int64_t, int64_t>(res, n_entries);
+  auto sims         = raft::make_device_vector<float, int64_t>(res, n_entries);
+  map_to_docs_kernel<<<grid_size(n_entries), kBlockSize, 0, stream>>>(
+    token_ids.data_handle(),
+    token_distances.data_handle(),
+    n_entries,
+    n_cand,
+    uint32_t(n_query_tokens),
+    idx.doc_offsets().data_handle(),
+    n_docs,
+    idx.n_tokens(),
+    raft::distance::is_min_close(params.metric) ? -1.0f : 1.0f,
+    keys.data_handle(),
+    query_tokens.data_handle(),
+    sims.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  // The candidates are ordered by (query, document, query token); the invalid ones go last.
+  thrust::stable_sort_by_key(
+    exec_policy,
+    keys.data_handle(),
+    keys.data_handle() + n_entries,
+    thrust::make_zip_iterator(thrust::make_tuple(query_tokens.data_handle(), sims.data_handle())));
+  const int64_t n_valid =
+    thrust::lower_bound(
+      exec_policy, keys.data_handle(), keys.data_handle() + n_entries, kInvalidKey) -
+    keys.data_handle();
+
+  // The best similarity of every (query, document, query token)
+  auto pair_keys         = raft::make_device_vector<int64_t, int64_t>(res, n_valid);
+  auto pair_query_tokens = raft::make_device_vector<int64_t, int64_t>(res, n_valid);
+  auto pair_sims         = raft::make_device_vector<float, int64_t>(res, n_valid);
+  auto in_pairs =
+    thrust::make_zip_iterator(thrust::make_tuple(keys.data_handle(), query_tokens.data_handle()));
+  auto out_pairs = thrust::make_zip_iterator(
+    thrust::make_tuple(pair_keys.data_handle(), pair_query_tokens.data_handle()));
+  auto pairs_end = thrust::reduce_by_key(exec_policy,
+                                         in_pairs,
+                                         in_pairs + n_valid,
+                                         sims.data_handle(),
+                                         out_pairs,
+                                         pair_sims.data_handle(),
+                                         thrust::equal_to<thrust::tuple<int64_t, int64_t>>(),
+                                         thrust::maximum<float>());
+  const int64_t n_pairs = pairs_end.second - pair_sims.data_handle();
+
+  // The MaxSim of every (query, document): the sum over the query tokens
+  auto doc_keys   = raft::make_device_vector<int64_t, int64_t>(res, n_pairs);
+  auto doc_scores = raft::make_device_vector<float, int64_t>(res, n_pairs);
+  auto docs_end   = thrust::reduce_by_key(exec_policy,
+                                        pair_keys.data_handle(),
+                                        pair_keys.data_handle() + n_pairs,
+                                        pair_sims.data_handle(),
+                                        doc_keys.data_handle(),
+                                        doc_scores.data_handle());
+  const int64_t n_found = docs_end.first - doc_keys.data_handle();
+
+  // One row of the scored documents per query, padded with the lowest scores
+  auto query_starts = raft::make_device_vector<int64_t, int64_t>(res, n_queries);
+  auto query_keys   = thrust::make_transform_iterator(thrust::counting_iterator<int64_t>(0),
+                                                    raft::mul_const_op<int64_t>(n_docs));
+  thrust::lower_bound(exec_policy,
+                      doc_keys.data_handle(),
+                      doc_keys.data_handle() + n_found,
+                      query_keys,
+                      query_keys + n_queries,
+                      query_starts.data_handle());
+  auto doc_ids  = raft::make_device_matrix<int64_t, int64_t>(res, n_queries, capacity);
+  auto doc_sums = raft::make_device_matrix<float, int64_t>(res, n_queries, capacity);
+  thrust::fill(exec_policy,
+               doc_ids.data_handle(),
+               doc_ids.data_handle() + doc_ids.size(),
+               std::numeric_limits<int64_t>::max());
+  thrust::fill(exec_policy,
+               doc_sums.data_handle(),
+               doc_sums.data_handle() + doc_sums.size(),
+               raft::lower_bound<float>());
+  if (n_found > 0) {
+    scatter_docs_kernel<<<grid_size(n_found), kBlockSize, 0, stream>>>(doc_keys.data_handle(),
+                                                                       doc_scores.data_handle(),
+                                                                       n_found,
+                                                                       query_starts.data_handle(),
+                                                                       n_docs,
+                                                                       uint32_t(capacity),
+                                                                       doc_ids.data_handle(),
+                                                                       doc_sums.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  if (!token_dataset.has_value()) {
+    raft::matrix::select_k<float, int64_t>(res,
+                                           raft::make_const_mdspan(doc_sums.view()),
+                                           raft::make_const_mdspan(doc_ids.view()),
+                                           scores,
+                                           neighbors,
+                                           false,
+                                           true);
+    return;
+  }
+
+  // The best documents by the approximate MaxSim are re-scored with all of their tokens.
+  const int64_t n_rerank = std::min<int64_t>(params.n_rerank_candidates, capacity);
+  auto rerank_ids        = raft::make_device_matrix<int64_t, int64_t>(res, n_queries, n_rerank);
+  auto rerank_scores     = raft::make_device_matrix<float, int64_t>(res, n_queries, n_rerank);
+  raft::matrix::select_k<float, int64_t>(res,
+                                         raft::make_const_mdspan(doc_sums.view()),
+                                         raft::make_const_mdspan(doc_ids.view()),
+                                         rerank_scores.view(),
+                                         rerank_ids.view(),
+                                         false);
+  maxsim_kernel<T><<<n_queries * n_rerank, WarpSize, 0, stream>>>(
+    queries.data_handle(),
+    uint32_t(n_query_tokens),
+    uint32_t(queries.extent(1)),
+    token_dataset->data_handle(),
+    idx.doc_offsets().data_handle(),
+    n_docs,
+    rerank_ids.data_handle(),
+    uint32_t(n_rerank),
+    params.metric == raft::distance::DistanceType::InnerProduct,
+    rerank_scores.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  raft::matrix::select_k<float, int64_t>(res,
+                                         raft::make_const_mdspan(rerank_scores.view()),
+                                         raft::make_const_mdspan(rerank_ids.view()),
+                                         scores,
+                                         neighbors,
+                                         false,
+                                         true);
+}
+
+}  // namespace raft::neighbors::multi_vector::detail
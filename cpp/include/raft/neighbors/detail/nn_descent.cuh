@@ -25,10 +25,15 @@
 #include <raft/core/mdspan.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/deadline.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
 #include <raft/matrix/init.cuh>
+#include <raft/matrix/segmented_sort.cuh>
 #include <raft/matrix/slice.cuh>
 #include <raft/neighbors/detail/cagra/device_common.hpp>
+#include <raft/random/rng.cuh>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
 #include <raft/util/arch.cuh>  // raft::util::arch::SM_*
 #include <raft/util/cuda_dev_essentials.cuh>
@@ -36,30 +41,25 @@
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/pow2_utils.cuh>
 
+#include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
 #include <cub/cub.cuh>
 #include <cuda_runtime.h>
 #include <thrust/execution_policy.h>
 #include <thrust/fill.h>
-#include <thrust/host_vector.h>
-#include <thrust/mr/allocator.h>
-#include <thrust/mr/device_memory_resource.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
 
 #include <mma.h>
 #include <omp.h>
 
+#include <chrono>
 #include <limits>
 #include <optional>
-#include <queue>
-#include <random>
 
 namespace raft::neighbors::experimental::nn_descent::detail {
 
-using pinned_memory_resource = thrust::universal_host_pinned_memory_resource;
-template <typename T>
-using pinned_memory_allocator = thrust::mr::stateless_resource_allocator<T, pinned_memory_resource>;
-
 using DistData_t = float;
 constexpr int DEGREE_ON_DEVICE{32};
 constexpr int SEGMENT_SIZE{32};
@@ -224,125 +224,145 @@ struct BuildConfig {
   size_t max_iterations{50};
   float termination_threshold{0.0001};
   size_t output_graph_degree{32};
+  raft::distance::DistanceType metric{raft::distance::DistanceType::L2Expanded};
+  iteration_callback on_iteration{nullptr};
+  double max_time_per_update_us{0};
 };
 
+/**
+ * A Bloom filter of ids per list (row of the graph), in the device memory. The kernels use it
+ * through `view_type`; every list must be updated by a single thread.
+ */
 template <typename Index_t>
 class BloomFilter {
+  static constexpr int num_bits_per_set_ = 512;
+
  public:
-  BloomFilter(size_t nrow, size_t num_sets_per_list, size_t num_hashs)
-    : nrow_(nrow),
-      num_sets_per_list_(num_sets_per_list),
-      num_hashs_(num_hashs),
-      bitsets_(nrow * num_bits_per_set_ * num_sets_per_list)
-  {
-  }
+  struct view_type {
+    uint32_t* bitsets;
+    size_t num_sets_per_list;
+    size_t num_hashs;
+
+    __device__ void add(size_t list_id, Index_t key)
+    {
+      uint32_t hash         = hash_0(key);
+      size_t global_set_idx = set_idx(list_id, key);
+      set_bit(global_set_idx + hash % num_bits_per_set_);
+      for (size_t i = 1; i < num_hashs; i++) {
+        hash = hash + hash_1(key);
+        set_bit(global_set_idx + hash % num_bits_per_set_);
+      }
+    }
 
-  void add(size_t list_id, Index_t key)
-  {
-    if (is_cleared) { is_cleared = false; }
-    uint32_t hash         = hash_0(key);
-    size_t global_set_idx = list_id * num_bits_per_set_ * num_sets_per_list_ +
-                            key % num_sets_per_list_ * num_bits_per_set_;
-    bitsets_[global_set_idx + hash % num_bits_per_set_] = 1;
-    for (size_t i = 1; i < num_hashs_; i++) {
-      hash                                                = hash + hash_1(key);
-      bitsets_[global_set_idx + hash % num_bits_per_set_] = 1;
+    __device__ bool check(size_t list_id, Index_t key) const
+    {
+      uint32_t hash         = hash_0(key);
+      size_t global_set_idx = set_idx(list_id, key);
+      if (!test_bit(global_set_idx + hash % num_bits_per_set_)) { return false; }
+      for (size_t i = 1; i < num_hashs; i++) {
+        hash = hash + hash_1(key);
+        if (!test_bit(global_set_idx + hash % num_bits_per_set_)) { return false; }
+      }
+      return true;
     }
-  }
 
-  bool check(size_t list_id, Index_t key)
-  {
-    bool is_present       = true;
-    uint32_t hash         = hash_0(key);
-    size_t global_set_idx = list_id * num_bits_per_set_ * num_sets_per_list_ +
-                            key % num_sets_per_list_ * num_bits_per_set_;
-    is_present &= bitsets_[global_set_idx + hash % num_bits_per_set_];
-
-    if (!is_present) return false;
-    for (size_t i = 1; i < num_hashs_; i++) {
-      hash = hash + hash_1(key);
-      is_present &= bitsets_[global_set_idx + hash % num_bits_per_set_];
-      if (!is_present) return false;
+   private:
+    __device__ size_t set_idx(size_t list_id, Index_t key) const
+    {
+      return (list_id * num_sets_per_list + key % num_sets_per_list) * num_bits_per_set_;
+    }
+    __device__ void set_bit(size_t i) { bitsets[i / 32] |= 1u << (i % 32); }
+    __device__ bool test_bit(size_t i) const { return (bitsets[i / 32] >> (i % 32)) & 1u; }
+
+    static __device__ uint32_t hash_0(uint32_t value)
+    {
+      value *= 1103515245;
+      value += 12345;
+      value ^= value << 13;
+      value ^= value >> 17;
+      value ^= value << 5;
+      return value;
     }
-    return true;
-  }
 
-  void clear()
-  {
-    if (is_cleared) return;
-#pragma omp parallel for
-    for (size_t i = 0; i < nrow_ * num_bits_per_set_ * num_sets_per_list_; i++) {
-      bitsets_[i] = 0;
+    static __device__ uint32_t hash_1(uint32_t value)
+    {
+      value *= 1664525;
+      value += 1013904223;
+      value ^= value << 13;
+      value ^= value >> 17;
+      value ^= value << 5;
+      return value;
     }
-    is_cleared = true;
-  }
+  };
 
- private:
-  uint32_t hash_0(uint32_t value)
+  BloomFilter(raft::resources const& res, size_t nrow, size_t num_sets_per_list, size_t num_hashs)
+    : num_sets_per_list_(num_sets_per_list),
+      num_hashs_(num_hashs),
+      bitsets_(raft::make_device_vector<uint32_t, size_t>(
+        res, nrow * num_sets_per_list * num_bits_per_set_ / 32))
   {
-    value *= 1103515245;
-    value += 12345;
-    value ^= value << 13;
-    value ^= value >> 17;
-    value ^= value << 5;
-    return value;
   }
 
-  uint32_t hash_1(uint32_t value)
-  {
-    value *= 1664525;
-    value += 1013904223;
-    value ^= value << 13;
-    value ^= value >> 17;
-    value ^= value << 5;
-    return value;
-  }
+  auto view() -> view_type { return {bitsets_.data_handle(), num_sets_per_list_, num_hashs_}; }
 
-  static constexpr int num_bits_per_set_ = 512;
-  bool is_cleared{true};
-  std::vector<bool> bitsets_;
-  size_t nrow_;
+  void clear(raft::resources const& res) { raft::matrix::fill(res, bitsets_.view(), 0u); }
+
+ private:
   size_t num_sets_per_list_;
   size_t num_hashs_;
+  raft::device_vector<uint32_t, size_t> bitsets_;
 };
 
+/**
+ * The kNN lists refined by GNND and their samples for the local join, all kept in the device
+ * memory, so that an iteration does not move the graph between the host and the device. The arrays
+ * are allocated for `nrow` rows; `GNND::build` may use fewer of them.
+ */
 template <typename Index_t>
 struct GnndGraph {
   static constexpr int segment_size = 32;
-  InternalID_t<Index_t>* h_graph;
+  using ID_t                        = InternalID_t<Index_t>;
 
   size_t nrow;
   size_t node_degree;
   int num_samples;
   int num_segments;
 
-  raft::host_matrix<DistData_t, size_t, raft::row_major> h_dists;
+  // The kNN lists [nrow, node_degree]; each segment of 32 neighbors (those with
+  // `id % num_segments == segment`) is ordered by the distance.
+  raft::device_matrix<ID_t, size_t, raft::row_major> d_graph;
+  raft::device_matrix<DistData_t, size_t, raft::row_major> d_dists;
 
-  thrust::host_vector<Index_t, pinned_memory_allocator<Index_t>> h_graph_new;
-  thrust::host_vector<int2, pinned_memory_allocator<int2>> h_list_sizes_new;
-
-  thrust::host_vector<Index_t, pinned_memory_allocator<Index_t>> h_graph_old;
-  thrust::host_vector<int2, pinned_memory_allocator<int2>> h_list_sizes_old;
+  // The samples of the new and old neighbors [nrow, num_samples];
+  // int2.x is the number of forward edges, int2.y is the number of reverse edges
+  raft::device_matrix<Index_t, size_t, raft::row_major> d_graph_new;
+  raft::device_vector<int2, size_t> d_list_sizes_new;
+  raft::device_matrix<Index_t, size_t, raft::row_major> d_graph_old;
+  raft::device_vector<int2, size_t> d_list_sizes_old;
+  // TODO: Create a generic bloom filter utility https://github.com/rapidsai/raft/issues/1827
+  // Use Bloom filter to sample "new" neighbors for local joining
   BloomFilter<Index_t> bloom_filter;
+  rmm::device_scalar<unsigned long long> d_update_counter;
 
   GnndGraph(const GnndGraph&)            = delete;
   GnndGraph& operator=(const GnndGraph&) = delete;
-  GnndGraph(const size_t nrow,
+  GnndGraph(raft::resources const& res,
+            const size_t nrow,
             const size_t node_degree,
             const size_t internal_node_degree,
             const size_t num_samples);
-  void init_random_graph();
-  // TODO: Create a generic bloom filter utility https://github.com/rapidsai/raft/issues/1827
-  // Use Bloom filter to sample "new" neighbors for local joining
-  void sample_graph_new(InternalID_t<Index_t>* new_neighbors, const size_t width);
-  void sample_graph(bool sample_new);
-  void update_graph(const InternalID_t<Index_t>* new_neighbors,
+  void init_random_graph(raft::resources const& res);
+  // Sample the new neighbors among the local join results and mark them old.
+  void sample_graph_new(raft::resources const& res, ID_t* new_neighbors, const size_t width);
+  void sample_graph(raft::resources const& res, bool sample_new);
+  // Merge the local join results into the lists; returns the number of updates on the rows
+  // sampled every `counter_interval`.
+  auto update_graph(raft::resources const& res,
+                    const ID_t* new_neighbors,
                     const DistData_t* new_dists,
-                    const size_t width,
-                    std::atomic<int64_t>& update_counter);
-  void sort_lists();
-  void clear();
-  ~GnndGraph();
+                    const size_t width) -> int64_t;
+  void sort_lists(raft::resources const& res);
+  void clear(raft::resources const& res);
 };
 
 template <typename Data_t      = float,
@@ -366,8 +386,7 @@ class GNND {
 
  private:
   void add_reverse_edges(Index_t* graph_ptr,
-                         Index_t* h_rev_graph_ptr,
-                         Index_t* d_rev_graph_ptr,
+                         Index_t* rev_graph_ptr,
                          int2* list_sizes,
                          cudaStream_t stream = 0);
   void local_join(cudaStream_t stream           = 0,
@@ -377,7 +396,6 @@ class GNND {
 
   BuildConfig build_config_;
   GnndGraph<Index_t> graph_;
-  std::atomic<int64_t> update_counter_;
 
   size_t nrow_;
   size_t ndim_;
@@ -388,19 +406,11 @@ class GNND {
   raft::device_matrix<ID_t, size_t, raft::row_major> graph_buffer_;
   raft::device_matrix<DistData_t, size_t, raft::row_major> dists_buffer_;
 
-  // TODO: Investigate using RMM/RAFT types https://github.com/rapidsai/raft/issues/1827
-  thrust::host_vector<ID_t, pinned_memory_allocator<ID_t>> graph_host_buffer_;
-  thrust::host_vector<DistData_t, pinned_memory_allocator<DistData_t>> dists_host_buffer_;
-
   raft::device_vector<int, size_t> d_locks_;
 
-  thrust::host_vector<Index_t, pinned_memory_allocator<Index_t>> h_rev_graph_new_;
-  thrust::host_vector<Index_t, pinned_memory_allocator<Index_t>> h_graph_old_;
-  thrust::host_vector<Index_t, pinned_memory_allocator<Index_t>> h_rev_graph_old_;
-  // int2.x is the number of forward edges, int2.y is the number of reverse edges
-
-  raft::device_vector<int2, size_t> d_list_sizes_new_;
-  raft::device_vector<int2, size_t> d_list_sizes_old_;
+  // The reverse edges of the sampled new and old neighbors [nrow, NUM_SAMPLES]
+  raft::device_matrix<Index_t, size_t, raft::row_major> d_rev_graph_new_;
+  raft::device_matrix<Index_t, size_t, raft::row_major> d_rev_graph_old_;
 };
 
 constexpr int TILE_ROW_WIDTH = 64;
@@ -463,12 +473,16 @@ __device__ __forceinline__ void load_vec(Data_t* vec_buffer,
 }
 
 // TODO: Replace with RAFT utilities https://github.com/rapidsai/raft/issues/1827
-/** Calculate L2 norm, and cast data to __half */
+/**
+ * Calculate L2 norm, and cast data to __half. For the cosine metric the vectors are normalized
+ * (in fp32, before the cast), so that their dot products are the cosine similarities.
+ */
 template <typename Data_t>
 RAFT_KERNEL preprocess_data_kernel(const Data_t* input_data,
                                    __half* output_data,
                                    int dim,
                                    DistData_t* l2_norms,
+                                   raft::distance::DistanceType metric,
                                    size_t list_offset = 0)
 {
   extern __shared__ char buffer[];
@@ -498,9 +512,11 @@ RAFT_KERNEL preprocess_data_kernel(const Data_t* input_data,
   for (int step = 0; step < ceildiv(dim, raft::warp_size()); step++) {
     int idx = step * raft::warp_size() + threadIdx.x;
     if (idx < dim) {
-      if (l2_norms == nullptr) {
+      if (metric == raft::distance::DistanceType::CosineExpanded) {
+        // A zero vector stays zero rather than turning into NaNs
+        float inv_norm = l2_norm > 0 ? rsqrtf(l2_norm) : 0.0f;
         output_data[list_id * dim + idx] =
-          (float)input_data[(size_t)blockIdx.x * dim + idx] / sqrt(l2_norm);
+          (float)input_data[(size_t)blockIdx.x * dim + idx] * inv_norm;
       } else {
         output_data[list_id * dim + idx] = input_data[(size_t)blockIdx.x * dim + idx];
         if (idx == 0) { l2_norms[list_id] = l2_norm; }
@@ -698,6 +714,23 @@ __device__ __forceinline__ void remove_duplicates(
   }
 }
 
+/**
+ * Convert the dot product of two (preprocessed) vectors to the distance of the build metric.
+ * The distances are minimized, hence the inner product is negated; the cosine metric works on the
+ * normalized vectors (see `preprocess_data_kernel`).
+ */
+__device__ __forceinline__ DistData_t dot_to_distance(DistData_t dot,
+                                                      DistData_t norm_a,
+                                                      DistData_t norm_b,
+                                                      raft::distance::DistanceType metric)
+{
+  switch (metric) {
+    case raft::distance::DistanceType::InnerProduct: return -dot;
+    case raft::distance::DistanceType::CosineExpanded: return 1.0f - dot;
+    default: return norm_a + norm_b - 2.0f * dot;
+  }
+}
+
 // launch_bounds here denote BLOCK_SIZE = 512 and MIN_BLOCKS_PER_SM = 4
 // Per
 // https://docs.nvidia.com/cuda/cuda-c-programming-guide/index.html#features-and-technical-specifications,
@@ -729,6 +762,7 @@ __launch_bounds__(BLOCK_SIZE, 4)
                     int graph_width,
                     int* locks,
                     DistData_t* l2_norms,
+                    raft::distance::DistanceType metric,
                     epilogue_op distance_epilogue)
 {
 #if (__CUDA_ARCH__ >= 700)
@@ -844,13 +878,8 @@ __launch_bounds__(BLOCK_SIZE, 4)
     if (row_idx < list_new_size && col_idx < list_new_size) {
       auto r = new_neighbors[row_idx];
       auto c = new_neighbors[col_idx];
-      if (l2_norms == nullptr) {
-        auto dist_val  = -s_distances[i];
-        s_distances[i] = distance_epilogue(dist_val, r, c);
-      } else {
-        auto dist_val  = l2_norms[r] + l2_norms[c] - 2.0 * s_distances[i];
-        s_distances[i] = distance_epilogue(dist_val, r, c);
-      }
+      auto dist_val  = dot_to_distance(s_distances[i], l2_norms[r], l2_norms[c], metric);
+      s_distances[i] = distance_epilogue(dist_val, r, c);
     } else {
       s_distances[i] = std::numeric_limits<float>::max();
     }
@@ -926,13 +955,8 @@ __launch_bounds__(BLOCK_SIZE, 4)
     if (row_idx < list_old_size && col_idx < list_new_size) {
       auto r = old_neighbors[row_idx];
       auto c = new_neighbors[col_idx];
-      if (l2_norms == nullptr) {
-        auto dist_val  = -s_distances[i];
-        s_distances[i] = distance_epilogue(dist_val, r, c);
-      } else {
-        auto dist_val  = l2_norms[r] + l2_norms[c] - 2.0 * s_distances[i];
-        s_distances[i] = distance_epilogue(dist_val, r, c);
-      }
+      auto dist_val  = dot_to_distance(s_distances[i], l2_norms[r], l2_norms[c], metric);
+      s_distances[i] = distance_epilogue(dist_val, r, c);
     } else {
       s_distances[i] = std::numeric_limits<float>::max();
     }
@@ -963,13 +987,12 @@ __launch_bounds__(BLOCK_SIZE, 4)
 #endif
 }
 
-namespace {
 template <typename Index_t>
-int insert_to_ordered_list(InternalID_t<Index_t>* list,
-                           DistData_t* dist_list,
-                           const int width,
-                           const InternalID_t<Index_t> neighb_id,
-                           const DistData_t dist)
+__device__ int insert_to_ordered_list(InternalID_t<Index_t>* list,
+                                      DistData_t* dist_list,
+                                      const int width,
+                                      const InternalID_t<Index_t> neighb_id,
+                                      const DistData_t dist)
 {
   if (dist > dist_list[width - 1]) { return width; }
 
@@ -984,179 +1007,309 @@ int insert_to_ordered_list(InternalID_t<Index_t>* list,
   }
   if (idx_insert == width) return idx_insert;
 
-  memmove(list + idx_insert + 1, list + idx_insert, sizeof(*list) * (width - idx_insert - 1));
-  memmove(dist_list + idx_insert + 1,
-          dist_list + idx_insert,
-          sizeof(*dist_list) * (width - idx_insert - 1));
-
+  for (int i = width - 1; i > idx_insert; i--) {
+    list[i]      = list[i - 1];
+    dist_list[i] = dist_list[i - 1];
+  }
   list[idx_insert]      = neighb_id;
   dist_list[idx_insert] = dist;
   return idx_insert;
-};
+}
+
+// Fill the segment `seg_idx` of every list with the ids `rand_seq[k] * num_segments + seg_idx`;
+// one thread per neighbor.
+template <typename Index_t, typename ID_t = InternalID_t<Index_t>>
+RAFT_KERNEL init_random_graph_kernel(ID_t* graph,
+                                     DistData_t* dists,
+                                     const Index_t* rand_seq,
+                                     const size_t rand_seq_len,
+                                     const size_t nrow,
+                                     const size_t node_degree,
+                                     const int num_segments,
+                                     const int seg_idx)
+{
+  const size_t tid = threadIdx.x + static_cast<size_t>(blockDim.x) * blockIdx.x;
+  if (tid >= nrow * SEGMENT_SIZE) { return; }
+  const size_t i   = tid / SEGMENT_SIZE;
+  const size_t idx = i * node_degree + seg_idx * SEGMENT_SIZE + tid % SEGMENT_SIZE;
+  Index_t id       = rand_seq[idx % rand_seq_len] * num_segments + seg_idx;
+  if (static_cast<size_t>(id) == i) {
+    id = rand_seq[(idx + SEGMENT_SIZE) % rand_seq_len] * num_segments + seg_idx;
+  }
+  graph[idx].id_with_flag() = id;
+  dists[idx]                = std::numeric_limits<DistData_t>::max();
+}
+
+// Sample the old (and, if `sample_new`, the new) neighbors of every list, interleaving the
+// segments; one thread per list.
+template <typename Index_t, typename ID_t = InternalID_t<Index_t>>
+RAFT_KERNEL sample_graph_kernel(ID_t* graph,
+                                const size_t nrow,
+                                const size_t node_degree,
+                                const int num_segments,
+                                const int num_samples,
+                                const bool sample_new,
+                                Index_t* graph_old,
+                                int2* list_sizes_old,
+                                Index_t* graph_new,
+                                int2* list_sizes_new)
+{
+  const size_t i = threadIdx.x + static_cast<size_t>(blockDim.x) * blockIdx.x;
+  if (i >= nrow) { return; }
+  auto list     = graph + i * node_degree;
+  auto list_old = graph_old + i * num_samples;
+  auto list_new = graph_new + i * num_samples;
+  int num_old   = 0;
+  int num_new   = 0;
+  auto is_full  = [&]() {
+    return num_old == num_samples && (!sample_new || num_new == num_samples);
+  };
+  for (int j = 0; j < SEGMENT_SIZE && !is_full(); j++) {
+    for (int k = 0; k < num_segments && !is_full(); k++) {
+      auto neighbor = list[k * SEGMENT_SIZE + j];
+      if (static_cast<size_t>(neighbor.id()) >= nrow) continue;
+      if (!neighbor.is_new()) {
+        if (num_old < num_samples) { list_old[num_old++] = neighbor.id(); }
+      } else if (sample_new) {
+        if (num_new < num_samples) {
+          list[k * SEGMENT_SIZE + j].mark_old();
+          list_new[num_new++] = neighbor.id();
+        }
+      }
+    }
+  }
+  list_sizes_old[i] = int2{num_old, 0};
+  if (sample_new) { list_sizes_new[i] = int2{num_new, 0}; }
+}
 
-}  // namespace
+// Take the local join results not seen by the Bloom filter as the new samples; one thread per
+// list.
+template <typename Index_t, typename ID_t = InternalID_t<Index_t>>
+RAFT_KERNEL sample_graph_new_kernel(ID_t* new_neighbors,
+                                    const size_t width,
+                                    const size_t nrow,
+                                    const int num_samples,
+                                    typename BloomFilter<Index_t>::view_type bloom_filter,
+                                    Index_t* graph_new,
+                                    int2* list_sizes_new)
+{
+  const size_t i = threadIdx.x + static_cast<size_t>(blockDim.x) * blockIdx.x;
+  if (i >= nrow) { return; }
+  auto list_new = graph_new + i * num_samples;
+  int num_new   = 0;
+  for (size_t j = 0; j < width; j++) {
+    auto new_neighb_id = new_neighbors[i * width + j].id();
+    if (static_cast<size_t>(new_neighb_id) >= nrow) break;
+    if (bloom_filter.check(i, new_neighb_id)) { continue; }
+    bloom_filter.add(i, new_neighb_id);
+    new_neighbors[i * width + j].mark_old();
+    list_new[num_new++] = new_neighb_id;
+    if (num_new == num_samples) break;
+  }
+  list_sizes_new[i] = int2{num_new, 0};
+}
+
+// Insert the local join results into the segments of the lists; one thread per list.
+template <typename Index_t, typename ID_t = InternalID_t<Index_t>>
+RAFT_KERNEL update_graph_kernel(const ID_t* new_neighbors,
+                                const DistData_t* new_dists,
+                                const size_t width,
+                                const size_t nrow,
+                                ID_t* graph,
+                                DistData_t* dists,
+                                const size_t node_degree,
+                                const int num_segments,
+                                unsigned long long* update_counter)
+{
+  const size_t i = threadIdx.x + static_cast<size_t>(blockDim.x) * blockIdx.x;
+  if (i >= nrow) { return; }
+  unsigned long long num_updates = 0;
+  for (size_t j = 0; j < width; j++) {
+    auto new_neighb_id = new_neighbors[i * width + j];
+    auto new_dist      = new_dists[i * width + j];
+    if (new_dist == std::numeric_limits<DistData_t>::max()) break;
+    if (static_cast<size_t>(new_neighb_id.id()) == i) continue;
+    int seg_idx    = new_neighb_id.id() % num_segments;
+    auto list      = graph + i * node_degree + seg_idx * SEGMENT_SIZE;
+    auto dist_list = dists + i * node_degree + seg_idx * SEGMENT_SIZE;
+    int insert_pos =
+      insert_to_ordered_list(list, dist_list, SEGMENT_SIZE, new_neighb_id, new_dist);
+    if (insert_pos != SEGMENT_SIZE) { num_updates++; }
+  }
+  if (i % counter_interval == 0 && num_updates > 0) { atomicAdd(update_counter, num_updates); }
+}
+
+// Copy the ids of the lists to the output graph, replacing the missing neighbors with random ids.
+template <typename Index_t, typename ID_t = InternalID_t<Index_t>>
+RAFT_KERNEL shrink_graph_kernel(const ID_t* graph,
+                                const size_t nrow,
+                                const size_t node_degree,
+                                const size_t output_degree,
+                                Index_t* output_graph)
+{
+  const size_t tid = threadIdx.x + static_cast<size_t>(blockDim.x) * blockIdx.x;
+  if (tid >= nrow * output_degree) { return; }
+  const size_t i   = tid / output_degree;
+  const size_t idx = i * node_degree + tid % output_degree;
+  const auto id    = graph[idx].id();
+  output_graph[tid] = static_cast<size_t>(id) < nrow
+                        ? id
+                        : raft::neighbors::cagra::detail::device::xorshift64(idx) % nrow;
+}
 
 template <typename Index_t>
-GnndGraph<Index_t>::GnndGraph(const size_t nrow,
+GnndGraph<Index_t>::GnndGraph(raft::resources const& res,
+                              const size_t nrow,
                               const size_t node_degree,
                               const size_t internal_node_degree,
                               const size_t num_samples)
   : nrow(nrow),
     node_degree(node_degree),
     num_samples(num_samples),
-    bloom_filter(nrow, internal_node_degree / segment_size, 3),
-    h_dists{raft::make_host_matrix<DistData_t, size_t, raft::row_major>(nrow, node_degree)},
-    h_graph_new(nrow * num_samples),
-    h_list_sizes_new(nrow),
-    h_graph_old(nrow * num_samples),
-    h_list_sizes_old{nrow}
+    num_segments(node_degree / segment_size),
+    d_graph{raft::make_device_matrix<ID_t, size_t, raft::row_major>(res, nrow, node_degree)},
+    d_dists{raft::make_device_matrix<DistData_t, size_t, raft::row_major>(res, nrow, node_degree)},
+    d_graph_new{raft::make_device_matrix<Index_t, size_t, raft::row_major>(res, nrow, num_samples)},
+    d_list_sizes_new{raft::make_device_vector<int2, size_t>(res, nrow)},
+    d_graph_old{raft::make_device_matrix<Index_t, size_t, raft::row_major>(res, nrow, num_samples)},
+    d_list_sizes_old{raft::make_device_vector<int2, size_t>(res, nrow)},
+    bloom_filter(res, nrow, internal_node_degree / segment_size, 3),
+    d_update_counter(raft::resource::get_cuda_stream(res))
 {
   // node_degree must be a multiple of segment_size;
   assert(node_degree % segment_size == 0);
   assert(internal_node_degree % segment_size == 0);
-
-  num_segments = node_degree / segment_size;
-  // To save the CPU memory, graph should be allocated by external function
-  h_graph = nullptr;
 }
 
-// This is the only operation on the CPU that cannot be overlapped.
-// So it should be as fast as possible.
 template <typename Index_t>
-void GnndGraph<Index_t>::sample_graph_new(InternalID_t<Index_t>* new_neighbors, const size_t width)
+void GnndGraph<Index_t>::sample_graph_new(raft::resources const& res,
+                                          ID_t* new_neighbors,
+                                          const size_t width)
 {
-#pragma omp parallel for
-  for (size_t i = 0; i < nrow; i++) {
-    auto list_new         = h_graph_new.data() + i * num_samples;
-    h_list_sizes_new[i].x = 0;
-    h_list_sizes_new[i].y = 0;
-
-    for (size_t j = 0; j < width; j++) {
-      auto new_neighb_id = new_neighbors[i * width + j].id();
-      if ((size_t)new_neighb_id >= nrow) break;
-      if (bloom_filter.check(i, new_neighb_id)) { continue; }
-      bloom_filter.add(i, new_neighb_id);
-      new_neighbors[i * width + j].mark_old();
-      list_new[h_list_sizes_new[i].x++] = new_neighb_id;
-      if (h_list_sizes_new[i].x == num_samples) break;
-    }
-  }
+  constexpr int block_size = 256;
+  sample_graph_new_kernel<<<ceildiv<size_t>(nrow, block_size),
+                            block_size,
+                            0,
+                            raft::resource::get_cuda_stream(res)>>>(new_neighbors,
+                                                                    width,
+                                                                    nrow,
+                                                                    num_samples,
+                                                                    bloom_filter.view(),
+                                                                    d_graph_new.data_handle(),
+                                                                    d_list_sizes_new.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
 }
 
 template <typename Index_t>
-void GnndGraph<Index_t>::init_random_graph()
+void GnndGraph<Index_t>::init_random_graph(raft::resources const& res)
 {
-  for (size_t seg_idx = 0; seg_idx < static_cast<size_t>(num_segments); seg_idx++) {
-    // random sequence (range: 0~nrow)
+  auto stream = raft::resource::get_cuda_stream(res);
+  auto policy = raft::resource::get_thrust_policy(res);
+  // random sequence (range: 0~nrow / num_segments), shuffled by sorting random keys
+  const size_t rand_seq_len = nrow / num_segments;
+  auto rand_seq             = raft::make_device_vector<Index_t, size_t>(res, rand_seq_len);
+  auto rand_keys            = raft::make_device_vector<uint32_t, size_t>(res, rand_seq_len);
+  constexpr int block_size  = 256;
+  for (int seg_idx = 0; seg_idx < num_segments; seg_idx++) {
     // segment_x stores neighbors which id % num_segments == x
-    std::vector<Index_t> rand_seq(nrow / num_segments);
-    std::iota(rand_seq.begin(), rand_seq.end(), 0);
-    auto gen = std::default_random_engine{seg_idx};
-    std::shuffle(rand_seq.begin(), rand_seq.end(), gen);
-
-#pragma omp parallel for
-    for (size_t i = 0; i < nrow; i++) {
-      size_t base_idx      = i * node_degree + seg_idx * segment_size;
-      auto h_neighbor_list = h_graph + base_idx;
-      auto h_dist_list     = h_dists.data_handle() + base_idx;
-      for (size_t j = 0; j < static_cast<size_t>(segment_size); j++) {
-        size_t idx = base_idx + j;
-        Index_t id = rand_seq[idx % rand_seq.size()] * num_segments + seg_idx;
-        if ((size_t)id == i) {
-          id = rand_seq[(idx + segment_size) % rand_seq.size()] * num_segments + seg_idx;
-        }
-        h_neighbor_list[j].id_with_flag() = id;
-        h_dist_list[j]                    = std::numeric_limits<DistData_t>::max();
-      }
-    }
+    raft::random::RngState rng{static_cast<uint64_t>(seg_idx)};
+    raft::random::uniformInt(res,
+                             rng,
+                             rand_keys.data_handle(),
+                             rand_seq_len,
+                             uint32_t{0},
+                             std::numeric_limits<uint32_t>::max());
+    thrust::sequence(policy, rand_seq.data_handle(), rand_seq.data_handle() + rand_seq_len);
+    thrust::sort_by_key(policy,
+                        rand_keys.data_handle(),
+                        rand_keys.data_handle() + rand_seq_len,
+                        rand_seq.data_handle());
+    init_random_graph_kernel<<<ceildiv<size_t>(nrow * segment_size, block_size),
+                               block_size,
+                               0,
+                               stream>>>(d_graph.data_handle(),
+                                         d_dists.data_handle(),
+                                         rand_seq.data_handle(),
+                                         rand_seq_len,
+                                         nrow,
+                                         node_degree,
+                                         num_segments,
+                                         seg_idx);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
   }
 }
 
 template <typename Index_t>
-void GnndGraph<Index_t>::sample_graph(bool sample_new)
+void GnndGraph<Index_t>::sample_graph(raft::resources const& res, bool sample_new)
 {
-#pragma omp parallel for
-  for (size_t i = 0; i < nrow; i++) {
-    h_list_sizes_old[i].x = 0;
-    h_list_sizes_old[i].y = 0;
-    h_list_sizes_new[i].x = 0;
-    h_list_sizes_new[i].y = 0;
-
-    auto list     = h_graph + i * node_degree;
-    auto list_old = h_graph_old.data() + i * num_samples;
-    auto list_new = h_graph_new.data() + i * num_samples;
-    for (int j = 0; j < segment_size; j++) {
-      for (int k = 0; k < num_segments; k++) {
-        auto neighbor = list[k * segment_size + j];
-        if ((size_t)neighbor.id() >= nrow) continue;
-        if (!neighbor.is_new()) {
-          if (h_list_sizes_old[i].x < num_samples) {
-            list_old[h_list_sizes_old[i].x++] = neighbor.id();
-          }
-        } else if (sample_new) {
-          if (h_list_sizes_new[i].x < num_samples) {
-            list[k * segment_size + j].mark_old();
-            list_new[h_list_sizes_new[i].x++] = neighbor.id();
-          }
-        }
-        if (h_list_sizes_old[i].x == num_samples && h_list_sizes_new[i].x == num_samples) { break; }
-      }
-      if (h_list_sizes_old[i].x == num_samples && h_list_sizes_new[i].x == num_samples) { break; }
-    }
-  }
+  constexpr int block_size = 256;
+  sample_graph_kernel<<<ceildiv<size_t>(nrow, block_size),
+                        block_size,
+                        0,
+                        raft::resource::get_cuda_stream(res)>>>(d_graph.data_handle(),
+                                                                nrow,
+                                                                node_degree,
+                                                                num_segments,
+                                                                num_samples,
+                                                                sample_new,
+                                                                d_graph_old.data_handle(),
+                                                                d_list_sizes_old.data_handle(),
+                                                                d_graph_new.data_handle(),
+                                                                d_list_sizes_new.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
 }
 
 template <typename Index_t>
-void GnndGraph<Index_t>::update_graph(const InternalID_t<Index_t>* new_neighbors,
+auto GnndGraph<Index_t>::update_graph(raft::resources const& res,
+                                      const ID_t* new_neighbors,
                                       const DistData_t* new_dists,
-                                      const size_t width,
-                                      std::atomic<int64_t>& update_counter)
-{
-#pragma omp parallel for
-  for (size_t i = 0; i < nrow; i++) {
-    for (size_t j = 0; j < width; j++) {
-      auto new_neighb_id = new_neighbors[i * width + j];
-      auto new_dist      = new_dists[i * width + j];
-      if (new_dist == std::numeric_limits<DistData_t>::max()) break;
-      if ((size_t)new_neighb_id.id() == i) continue;
-      int seg_idx    = new_neighb_id.id() % num_segments;
-      auto list      = h_graph + i * node_degree + seg_idx * segment_size;
-      auto dist_list = h_dists.data_handle() + i * node_degree + seg_idx * segment_size;
-      int insert_pos =
-        insert_to_ordered_list(list, dist_list, segment_size, new_neighb_id, new_dist);
-      if (i % counter_interval == 0 && insert_pos != segment_size) { update_counter++; }
-    }
-  }
-}
-
-template <typename Index_t>
-void GnndGraph<Index_t>::sort_lists()
+                                      const size_t width) -> int64_t
 {
-#pragma omp parallel for
-  for (size_t i = 0; i < nrow; i++) {
-    std::vector<std::pair<DistData_t, Index_t>> new_list;
-    for (size_t j = 0; j < node_degree; j++) {
-      new_list.emplace_back(h_dists.data_handle()[i * node_degree + j],
-                            h_graph[i * node_degree + j].id());
-    }
-    std::sort(new_list.begin(), new_list.end());
-    for (size_t j = 0; j < node_degree; j++) {
-      h_graph[i * node_degree + j].id_with_flag() = new_list[j].second;
-      h_dists.data_handle()[i * node_degree + j]  = new_list[j].first;
-    }
-  }
+  auto stream              = raft::resource::get_cuda_stream(res);
+  constexpr int block_size = 256;
+  d_update_counter.set_value_to_zero_async(stream);
+  update_graph_kernel<<<ceildiv<size_t>(nrow, block_size), block_size, 0, stream>>>(
+    new_neighbors,
+    new_dists,
+    width,
+    nrow,
+    d_graph.data_handle(),
+    d_dists.data_handle(),
+    node_degree,
+    num_segments,
+    d_update_counter.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  return static_cast<int64_t>(d_update_counter.value(stream));
 }
 
 template <typename Index_t>
-void GnndGraph<Index_t>::clear()
+void GnndGraph<Index_t>::sort_lists(raft::resources const& res)
 {
-  bloom_filter.clear();
+  auto graph_view = raft::make_device_matrix_view<const ID_t, int64_t>(
+    d_graph.data_handle(), nrow, node_degree);
+  auto dists_view = raft::make_device_matrix_view<DistData_t, int64_t>(
+    d_dists.data_handle(), nrow, node_degree);
+  auto ids          = raft::make_device_matrix<Index_t, int64_t>(res, nrow, node_degree);
+  auto sorted_dists = raft::make_device_matrix<DistData_t, int64_t>(res, nrow, node_degree);
+  raft::linalg::map(res, ids.view(), [] __device__(ID_t x) { return x.id(); }, graph_view);
+  // The sorted ids overwrite the lists without the flags.
+  raft::matrix::segmented_sort<DistData_t, Index_t>(
+    res,
+    raft::make_const_mdspan(dists_view),
+    raft::make_const_mdspan(ids.view()),
+    sorted_dists.view(),
+    raft::make_device_matrix_view<Index_t, int64_t>(
+      reinterpret_cast<Index_t*>(d_graph.data_handle()), nrow, node_degree));
+  raft::copy(dists_view.data_handle(),
+             sorted_dists.data_handle(),
+             sorted_dists.size(),
+             raft::resource::get_cuda_stream(res));
 }
 
 template <typename Index_t>
-GnndGraph<Index_t>::~GnndGraph()
+void GnndGraph<Index_t>::clear(raft::resources const& res)
 {
-  assert(h_graph == nullptr);
+  bloom_filter.clear(res);
 }
 
 template <typename Data_t, typename Index_t, typename epilogue_op>
@@ -1164,7 +1317,8 @@ GNND<Data_t, Index_t, epilogue_op>::GNND(raft::resources const& res,
                                          const BuildConfig& build_config)
   : res(res),
     build_config_(build_config),
-    graph_(build_config.max_dataset_size,
+    graph_(res,
+           build_config.max_dataset_size,
            align32::roundUp(build_config.node_degree),
            align32::roundUp(build_config.internal_node_degree ? build_config.internal_node_degree
                                                               : build_config.node_degree),
@@ -1178,14 +1332,11 @@ GNND<Data_t, Index_t, epilogue_op>::GNND(raft::resources const& res,
       raft::make_device_matrix<ID_t, size_t, raft::row_major>(res, nrow_, DEGREE_ON_DEVICE)},
     dists_buffer_{
       raft::make_device_matrix<DistData_t, size_t, raft::row_major>(res, nrow_, DEGREE_ON_DEVICE)},
-    graph_host_buffer_(nrow_ * DEGREE_ON_DEVICE),
-    dists_host_buffer_(nrow_ * DEGREE_ON_DEVICE),
     d_locks_{raft::make_device_vector<int, size_t>(res, nrow_)},
-    h_rev_graph_new_(nrow_ * NUM_SAMPLES),
-    h_graph_old_(nrow_ * NUM_SAMPLES),
-    h_rev_graph_old_(nrow_ * NUM_SAMPLES),
-    d_list_sizes_new_{raft::make_device_vector<int2, size_t>(res, nrow_)},
-    d_list_sizes_old_{raft::make_device_vector<int2, size_t>(res, nrow_)}
+    d_rev_graph_new_{
+      raft::make_device_matrix<Index_t, size_t, raft::row_major>(res, nrow_, NUM_SAMPLES)},
+    d_rev_graph_old_{
+      raft::make_device_matrix<Index_t, size_t, raft::row_major>(res, nrow_, NUM_SAMPLES)}
 {
   static_assert(NUM_SAMPLES <= 32);
   raft::matrix::fill(res, dists_buffer_.view(), std::numeric_limits<float>::max());
@@ -1207,15 +1358,12 @@ void GNND<Data_t, Index_t, epilogue_op>::reset(raft::resources const& res)
 
 template <typename Data_t, typename Index_t, typename epilogue_op>
 void GNND<Data_t, Index_t, epilogue_op>::add_reverse_edges(Index_t* graph_ptr,
-                                                           Index_t* h_rev_graph_ptr,
-                                                           Index_t* d_rev_graph_ptr,
+                                                           Index_t* rev_graph_ptr,
                                                            int2* list_sizes,
                                                            cudaStream_t stream)
 {
   add_rev_edges_kernel<<<nrow_, raft::warp_size(), 0, stream>>>(
-    graph_ptr, d_rev_graph_ptr, NUM_SAMPLES, list_sizes);
-  raft::copy(
-    h_rev_graph_ptr, d_rev_graph_ptr, nrow_ * NUM_SAMPLES, raft::resource::get_cuda_stream(res));
+    graph_ptr, rev_graph_ptr, NUM_SAMPLES, list_sizes);
 }
 
 template <typename Data_t, typename Index_t, typename epilogue_op>
@@ -1227,12 +1375,12 @@ void GNND<Data_t, Index_t, epilogue_op>::local_join(cudaStream_t stream,
                dists_buffer_.data_handle() + dists_buffer_.size(),
                std::numeric_limits<float>::max());
   local_join_kernel<<<nrow_, BLOCK_SIZE, 0, stream>>>(
-    thrust::raw_pointer_cast(graph_.h_graph_new.data()),
-    thrust::raw_pointer_cast(h_rev_graph_new_.data()),
-    d_list_sizes_new_.data_handle(),
-    thrust::raw_pointer_cast(h_graph_old_.data()),
-    thrust::raw_pointer_cast(h_rev_graph_old_.data()),
-    d_list_sizes_old_.data_handle(),
+    graph_.d_graph_new.data_handle(),
+    d_rev_graph_new_.data_handle(),
+    graph_.d_list_sizes_new.data_handle(),
+    graph_.d_graph_old.data_handle(),
+    d_rev_graph_old_.data_handle(),
+    graph_.d_list_sizes_old.data_handle(),
     NUM_SAMPLES,
     d_data_.data_handle(),
     ndim_,
@@ -1241,6 +1389,7 @@ void GNND<Data_t, Index_t, epilogue_op>::local_join(cudaStream_t stream,
     DEGREE_ON_DEVICE,
     d_locks_.data_handle(),
     l2_norms_.data_handle(),
+    build_config_.metric,
     distance_epilogue);
 }
 
@@ -1257,7 +1406,6 @@ void GNND<Data_t, Index_t, epilogue_op>::build(Data_t* data,
   cudaStream_t stream = raft::resource::get_cuda_stream(res);
   nrow_               = nrow;
   graph_.nrow         = nrow;
-  graph_.h_graph      = (InternalID_t<Index_t>*)output_graph;
 
   cudaPointerAttributes data_ptr_attr;
   RAFT_CUDA_TRY(cudaPointerGetAttributes(&data_ptr_attr, data));
@@ -1275,6 +1423,7 @@ void GNND<Data_t, Index_t, epilogue_op>::build(Data_t* data,
                 d_data_.data_handle(),
                 build_config_.dataset_dim,
                 l2_norms_.data_handle(),
+                build_config_.metric,
                 batch.offset());
   }
 
@@ -1283,57 +1432,59 @@ void GNND<Data_t, Index_t, epilogue_op>::build(Data_t* data,
                (Index_t*)graph_buffer_.data_handle() + graph_buffer_.size(),
                std::numeric_limits<Index_t>::max());
 
-  graph_.clear();
-  graph_.init_random_graph();
-  graph_.sample_graph(true);
-
-  auto update_and_sample = [&](bool update_graph) {
-    if (update_graph) {
-      update_counter_ = 0;
-      graph_.update_graph(thrust::raw_pointer_cast(graph_host_buffer_.data()),
-                          thrust::raw_pointer_cast(dists_host_buffer_.data()),
-                          DEGREE_ON_DEVICE,
-                          update_counter_);
-      if (update_counter_ < build_config_.termination_threshold * nrow_ *
-                              build_config_.dataset_dim / counter_interval) {
-        update_counter_ = -1;
-      }
-    }
-    graph_.sample_graph(false);
-  };
+  graph_.clear(res);
+  graph_.init_random_graph(res);
+  graph_.sample_graph(res, true);
 
-  for (size_t it = 0; it < build_config_.max_iterations; it++) {
-    raft::copy(d_list_sizes_new_.data_handle(),
-               thrust::raw_pointer_cast(graph_.h_list_sizes_new.data()),
-               nrow_,
-               raft::resource::get_cuda_stream(res));
-    raft::copy(thrust::raw_pointer_cast(h_graph_old_.data()),
-               thrust::raw_pointer_cast(graph_.h_graph_old.data()),
-               nrow_ * NUM_SAMPLES,
-               raft::resource::get_cuda_stream(res));
-    raft::copy(d_list_sizes_old_.data_handle(),
-               thrust::raw_pointer_cast(graph_.h_list_sizes_old.data()),
-               nrow_,
-               raft::resource::get_cuda_stream(res));
-    raft::resource::sync_stream(res);
-
-    std::thread update_and_sample_thread(update_and_sample, it);
+  using ms_t         = std::chrono::duration<double, std::milli>;
+  const auto start   = std::chrono::steady_clock::now();
+  auto iteration_end = start;
+  // Whether the results of the last local join are merged into the graph already
+  bool merged = false;
 
+  for (size_t it = 0; it < build_config_.max_iterations; it++) {
+    raft::resource::check_interrupted(res);
     RAFT_LOG_DEBUG("# GNND iteraton: %lu / %lu", it + 1, build_config_.max_iterations);
 
-    // Reuse dists_buffer_ to save GPU memory. graph_buffer_ cannot be reused, because it
-    // contains some information for local_join.
-    static_assert(DEGREE_ON_DEVICE * sizeof(*(dists_buffer_.data_handle())) >=
-                  NUM_SAMPLES * sizeof(*(graph_buffer_.data_handle())));
-    add_reverse_edges(thrust::raw_pointer_cast(graph_.h_graph_new.data()),
-                      thrust::raw_pointer_cast(h_rev_graph_new_.data()),
-                      (Index_t*)dists_buffer_.data_handle(),
-                      d_list_sizes_new_.data_handle(),
+    if (it > 0) {
+      // Merge the results of the previous local join and sample the old neighbors anew; the new
+      // neighbors have been sampled from the local join results.
+      const int64_t sampled_updates = graph_.update_graph(
+        res, graph_buffer_.data_handle(), dists_buffer_.data_handle(), DEGREE_ON_DEVICE);
+      merged    = true;
+      bool stop = sampled_updates < build_config_.termination_threshold * nrow_ *
+                                      build_config_.dataset_dim / counter_interval;
+      graph_.sample_graph(res, false);
+
+      const auto now = std::chrono::steady_clock::now();
+      iteration_stats stats;
+      stats.iteration    = it;
+      stats.updates      = sampled_updates * counter_interval;
+      stats.update_rate  = static_cast<double>(stats.updates) / (nrow_ * build_config_.dataset_dim);
+      stats.iteration_ms = ms_t(now - iteration_end).count();
+      stats.total_ms     = ms_t(now - start).count();
+      iteration_end      = now;
+      RAFT_LOG_DEBUG("# GNND iteration %lu: %ld updates (rate %g) in %.1f ms",
+                     stats.iteration,
+                     stats.updates,
+                     stats.update_rate,
+                     stats.iteration_ms);
+      if (build_config_.on_iteration && !build_config_.on_iteration(stats)) { stop = true; }
+      if (build_config_.max_time_per_update_us > 0 &&
+          stats.iteration_ms * 1000.0 >
+            build_config_.max_time_per_update_us * static_cast<double>(stats.updates)) {
+        stop = true;
+      }
+      if (stop) { break; }
+    }
+
+    add_reverse_edges(graph_.d_graph_new.data_handle(),
+                      d_rev_graph_new_.data_handle(),
+                      graph_.d_list_sizes_new.data_handle(),
                       stream);
-    add_reverse_edges(thrust::raw_pointer_cast(h_graph_old_.data()),
-                      thrust::raw_pointer_cast(h_rev_graph_old_.data()),
-                      (Index_t*)dists_buffer_.data_handle(),
-                      d_list_sizes_old_.data_handle(),
+    add_reverse_edges(graph_.d_graph_old.data_handle(),
+                      d_rev_graph_old_.data_handle(),
+                      graph_.d_list_sizes_old.data_handle(),
                       stream);
 
     // Tensor operations from `mma.h` are guarded with archicteture
@@ -1351,40 +1502,20 @@ void GNND<Data_t, Index_t, epilogue_op>::build(Data_t* data,
     } else {
       THROW("NN_DESCENT cannot be run for __CUDA_ARCH__ < 700");
     }
+    merged = false;
 
-    update_and_sample_thread.join();
-
-    if (update_counter_ == -1) { break; }
-    raft::copy(thrust::raw_pointer_cast(graph_host_buffer_.data()),
-               graph_buffer_.data_handle(),
-               nrow_ * DEGREE_ON_DEVICE,
-               raft::resource::get_cuda_stream(res));
-    raft::resource::sync_stream(res);
-    raft::copy(thrust::raw_pointer_cast(dists_host_buffer_.data()),
-               dists_buffer_.data_handle(),
-               nrow_ * DEGREE_ON_DEVICE,
-               raft::resource::get_cuda_stream(res));
-
-    graph_.sample_graph_new(thrust::raw_pointer_cast(graph_host_buffer_.data()), DEGREE_ON_DEVICE);
+    graph_.sample_graph_new(res, graph_buffer_.data_handle(), DEGREE_ON_DEVICE);
   }
 
-  graph_.update_graph(thrust::raw_pointer_cast(graph_host_buffer_.data()),
-                      thrust::raw_pointer_cast(dists_host_buffer_.data()),
-                      DEGREE_ON_DEVICE,
-                      update_counter_);
-  raft::resource::sync_stream(res);
-  graph_.sort_lists();
-
-  // Reuse graph_.h_dists as the buffer for shrink the lists in graph
-  static_assert(sizeof(decltype(*(graph_.h_dists.data_handle()))) >= sizeof(Index_t));
+  if (!merged) {
+    graph_.update_graph(
+      res, graph_buffer_.data_handle(), dists_buffer_.data_handle(), DEGREE_ON_DEVICE);
+  }
+  graph_.sort_lists(res);
 
   if (return_distances) {
-    auto graph_d_dists = raft::make_device_matrix<DistData_t, int64_t, raft::row_major>(
-      res, nrow_, build_config_.node_degree);
-    raft::copy(graph_d_dists.data_handle(),
-               graph_.h_dists.data_handle(),
-               nrow_ * build_config_.node_degree,
-               raft::resource::get_cuda_stream(res));
+    auto graph_d_dists = raft::make_device_matrix_view<const DistData_t, int64_t, raft::row_major>(
+      graph_.d_dists.data_handle(), nrow_, graph_.node_degree);
 
     auto output_dist_view = raft::make_device_matrix_view<DistData_t, int64_t, raft::row_major>(
       output_distances, nrow_, build_config_.output_graph_degree);
@@ -1394,34 +1525,45 @@ void GNND<Data_t, Index_t, epilogue_op>::build(Data_t* data,
                                            static_cast<int64_t>(nrow_),
                                            static_cast<int64_t>(build_config_.output_graph_degree)};
     raft::matrix::slice<DistData_t, int64_t, raft::row_major>(
-      res, raft::make_const_mdspan(graph_d_dists.view()), output_dist_view, coords);
-    raft::resource::sync_stream(res);
+      res, graph_d_dists, output_dist_view, coords);
   }
 
-  Index_t* graph_shrink_buffer = (Index_t*)graph_.h_dists.data_handle();
+  // Only the final graph leaves the device.
+  auto output_graph_d = raft::make_device_matrix<Index_t, size_t, raft::row_major>(
+    res, nrow_, build_config_.node_degree);
+  constexpr int block_size = 256;
+  shrink_graph_kernel<<<ceildiv<size_t>(output_graph_d.size(), block_size),
+                        block_size,
+                        0,
+                        stream>>>(graph_.d_graph.data_handle(),
+                                  nrow_,
+                                  graph_.node_degree,
+                                  build_config_.node_degree,
+                                  output_graph_d.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  raft::copy(output_graph, output_graph_d.data_handle(), output_graph_d.size(), stream);
+  raft::resource::sync_stream(res);
+}
 
-#pragma omp parallel for
-  for (size_t i = 0; i < (size_t)nrow_; i++) {
-    for (size_t j = 0; j < build_config_.node_degree; j++) {
-      size_t idx = i * graph_.node_degree + j;
-      int id     = graph_.h_graph[idx].id();
-      if (id < static_cast<int>(nrow_)) {
-        graph_shrink_buffer[i * build_config_.node_degree + j] = id;
-      } else {
-        graph_shrink_buffer[i * build_config_.node_degree + j] =
-          raft::neighbors::cagra::detail::device::xorshift64(idx) % nrow_;
-      }
-    }
-  }
-  graph_.h_graph = nullptr;
+inline void check_metric(raft::distance::DistanceType metric)
+{
+  RAFT_EXPECTS(metric == raft::distance::DistanceType::L2Expanded ||
+                 metric == raft::distance::DistanceType::InnerProduct ||
+                 metric == raft::distance::DistanceType::CosineExpanded,
+               "NN-descent supports only the L2Expanded, InnerProduct and CosineExpanded metrics");
+}
 
-#pragma omp parallel for
-  for (size_t i = 0; i < (size_t)nrow_; i++) {
-    for (size_t j = 0; j < build_config_.node_degree; j++) {
-      output_graph[i * build_config_.node_degree + j] =
-        graph_shrink_buffer[i * build_config_.node_degree + j];
-    }
-  }
+/**
+ * The inner products are negated during the build to be minimized like the other distances;
+ * turn the returned distances back to the inner products.
+ */
+inline void restore_distances(raft::resources const& res,
+                              raft::distance::DistanceType metric,
+                              raft::device_matrix_view<float, int64_t, row_major> distances)
+{
+  if (metric != raft::distance::DistanceType::InnerProduct) { return; }
+  raft::linalg::map(
+    res, distances, raft::mul_const_op<float>(-1.0f), raft::make_const_mdspan(distances));
 }
 
 template <typename T,
@@ -1438,6 +1580,7 @@ void build(raft::resources const& res,
   RAFT_EXPECTS(dataset.extent(0) < std::numeric_limits<int>::max() - 1,
                "The dataset size for GNND should be less than %d",
                std::numeric_limits<int>::max() - 1);
+  check_metric(params.metric);
   size_t intermediate_degree = params.intermediate_graph_degree;
   size_t graph_degree        = params.graph_degree;
 
@@ -1467,13 +1610,16 @@ void build(raft::resources const& res,
   auto int_graph = raft::make_host_matrix<int, int64_t, row_major>(
     dataset.extent(0), static_cast<int64_t>(extended_graph_degree));
 
-  BuildConfig build_config{.max_dataset_size      = static_cast<size_t>(dataset.extent(0)),
-                           .dataset_dim           = static_cast<size_t>(dataset.extent(1)),
-                           .node_degree           = extended_graph_degree,
-                           .internal_node_degree  = extended_intermediate_degree,
-                           .max_iterations        = params.max_iterations,
-                           .termination_threshold = params.termination_threshold,
-                           .output_graph_degree   = params.graph_degree};
+  BuildConfig build_config{.max_dataset_size       = static_cast<size_t>(dataset.extent(0)),
+                           .dataset_dim            = static_cast<size_t>(dataset.extent(1)),
+                           .node_degree            = extended_graph_degree,
+                           .internal_node_degree   = extended_intermediate_degree,
+                           .max_iterations         = params.max_iterations,
+                           .termination_threshold  = params.termination_threshold,
+                           .output_graph_degree    = params.graph_degree,
+                           .metric                 = params.metric,
+                           .on_iteration           = params.on_iteration,
+                           .max_time_per_update_us = params.max_time_per_update_us};
 
   GNND<const T, int, epilogue_op> nnd(res, build_config);
 
@@ -1486,6 +1632,7 @@ void build(raft::resources const& res,
                 .value_or(raft::make_device_matrix<float, int64_t>(res, 0, 0).view())
                 .data_handle(),
               distance_epilogue);
+    if (params.return_distances) { restore_distances(res, params.metric, idx.distances().value()); }
   } else {
     RAFT_EXPECTS(!params.return_distances,
                  "Distance view not allocated. Using return_distances set to true requires "
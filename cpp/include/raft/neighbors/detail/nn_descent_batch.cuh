@@ -22,26 +22,39 @@
 
 #include <raft/cluster/kmeans_balanced.cuh>
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/device_resources_manager.hpp>
+#include <raft/core/error.hpp>
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/managed_mdarray.hpp>
 #include <raft/core/mdspan.hpp>
 #include <raft/core/mdspan_types.hpp>
+#include <raft/core/pinned_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/matrix/detail/gather_inplace.cuh>
 #include <raft/matrix/init.cuh>
 #include <raft/matrix/sample_rows.cuh>
 #include <raft/neighbors/brute_force-inl.cuh>
+#include <raft/neighbors/detail/multi_device.hpp>
 
 #include <cub/cub.cuh>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <vector_types.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
+#include <mutex>
 #include <optional>
 #include <random>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 namespace raft::neighbors::experimental::nn_descent::detail {
 
@@ -250,8 +263,11 @@ RAFT_KERNEL merge_subgraphs(IdxT* cluster_data_indices,
     reinterpret_cast<int16_t*>(&sharedMem[graph_degree * 2 * (sizeof(float) + sizeof(IdxT))]);
 
   if (batch_row < num_cluster_in_batch) {
-    // load batch or global depending on threadIdx
-    size_t global_row = cluster_data_indices[batch_row];
+    // load batch or global depending on threadIdx; without the indices, the global rows of the
+    // batch have been gathered in the same order
+    size_t global_row = cluster_data_indices != nullptr
+                          ? static_cast<size_t>(cluster_data_indices[batch_row])
+                          : batch_row;
 
     KeyValuePair<float, IdxT> threadKeyValuePair[ITEMS_PER_THREAD];
 
@@ -338,6 +354,158 @@ RAFT_KERNEL merge_subgraphs(IdxT* cluster_data_indices,
   }
 }
 
+//
+// A [n_rows, n_cols] matrix in a memory-mapped file created in the given directory. The file is
+// unlinked right after it is created, so it never outlives the process; the OS writes the
+// dirty pages back to the disk under memory pressure, so the matrix does not need to fit in RAM.
+//
+template <typename T>
+class spill_matrix {
+ public:
+  spill_matrix(const std::string& directory, size_t n_rows, size_t n_cols)
+    : n_cols_(n_cols), size_(n_rows * n_cols * sizeof(T))
+  {
+    std::string path = directory + "/raft_nn_descent_XXXXXX";
+    std::vector<char> filename(path.begin(), path.end());
+    filename.push_back('\0');
+    fd_ = ::mkstemp(filename.data());
+    if (fd_ < 0) { RAFT_FAIL("Cannot create a spill file in %s", directory.c_str()); }
+    ::unlink(filename.data());
+    if (size_ > 0) {
+      if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        ::close(fd_);
+        RAFT_FAIL("Cannot allocate %zu bytes for a spill file in %s", size_, directory.c_str());
+      }
+      void* ptr = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+      if (ptr == MAP_FAILED) {
+        ::close(fd_);
+        RAFT_FAIL("Cannot map a spill file in %s", directory.c_str());
+      }
+      data_ = static_cast<T*>(ptr);
+    }
+  }
+
+  ~spill_matrix() noexcept
+  {
+    if (data_ != nullptr) { ::munmap(data_, size_); }
+    if (fd_ >= 0) { ::close(fd_); }
+  }
+
+  spill_matrix(const spill_matrix&)            = delete;
+  spill_matrix& operator=(const spill_matrix&) = delete;
+
+  [[nodiscard]] auto data() noexcept -> T* { return data_; }
+  [[nodiscard]] auto row(size_t i) noexcept -> T* { return data_ + i * n_cols_; }
+
+ private:
+  size_t n_cols_;
+  size_t size_;
+  int fd_  = -1;
+  T* data_ = nullptr;
+};
+
+//
+// The global graph of the batched build kept on disk (`index_params::spill_directory`).
+// Every cluster loads the global rows of its members into device memory before the merge, and
+// stores them back after. The rows are initialized on their first load, hence the files are not
+// written before they are used.
+//
+template <typename IdxT>
+class spilled_graph {
+ public:
+  // The buffers the rows of a cluster are streamed through (one per device)
+  struct staging {
+    staging(raft::resources const& res, size_t max_cluster_size, size_t graph_degree)
+      : indices_h(raft::make_pinned_matrix<IdxT, int64_t>(res, max_cluster_size, graph_degree)),
+        distances_h(raft::make_pinned_matrix<float, int64_t>(res, max_cluster_size, graph_degree)),
+        indices_d(raft::make_device_matrix<IdxT, int64_t>(res, max_cluster_size, graph_degree)),
+        distances_d(raft::make_device_matrix<float, int64_t>(res, max_cluster_size, graph_degree))
+    {
+    }
+
+    raft::pinned_matrix<IdxT, int64_t> indices_h;
+    raft::pinned_matrix<float, int64_t> distances_h;
+    raft::device_matrix<IdxT, int64_t> indices_d;
+    raft::device_matrix<float, int64_t> distances_d;
+  };
+
+  spilled_graph(const std::string& directory, size_t num_rows, size_t graph_degree)
+    : graph_degree_(graph_degree),
+      indices_(directory, num_rows, graph_degree),
+      distances_(directory, num_rows, graph_degree),
+      initialized_(num_rows, 0)
+  {
+  }
+
+  // Gather the global rows of the cluster members into the device buffers of the staging
+  void load(raft::resources const& res, staging& buf, const IdxT* rows, size_t num_rows)
+  {
+    const size_t degree = graph_degree_;
+#pragma omp parallel for
+    for (size_t i = 0; i < num_rows; i++) {
+      const size_t row = rows[i];
+      IdxT* dst_idx    = buf.indices_h.data_handle() + i * degree;
+      float* dst_dist  = buf.distances_h.data_handle() + i * degree;
+      if (initialized_[row]) {
+        std::memcpy(dst_idx, indices_.row(row), degree * sizeof(IdxT));
+        std::memcpy(dst_dist, distances_.row(row), degree * sizeof(float));
+      } else {
+        std::fill(dst_idx, dst_idx + degree, std::numeric_limits<IdxT>::max());
+        std::fill(dst_dist, dst_dist + degree, std::numeric_limits<float>::max());
+      }
+    }
+    auto stream = resource::get_cuda_stream(res);
+    raft::copy(
+      buf.indices_d.data_handle(), buf.indices_h.data_handle(), num_rows * degree, stream);
+    raft::copy(
+      buf.distances_d.data_handle(), buf.distances_h.data_handle(), num_rows * degree, stream);
+  }
+
+  // Scatter the merged rows from the device buffers of the staging back to the files
+  void store(raft::resources const& res, staging& buf, const IdxT* rows, size_t num_rows)
+  {
+    const size_t degree = graph_degree_;
+    auto stream         = resource::get_cuda_stream(res);
+    raft::copy(
+      buf.indices_h.data_handle(), buf.indices_d.data_handle(), num_rows * degree, stream);
+    raft::copy(
+      buf.distances_h.data_handle(), buf.distances_d.data_handle(), num_rows * degree, stream);
+    resource::sync_stream(res);
+#pragma omp parallel for
+    for (size_t i = 0; i < num_rows; i++) {
+      const size_t row = rows[i];
+      std::memcpy(
+        indices_.row(row), buf.indices_h.data_handle() + i * degree, degree * sizeof(IdxT));
+      std::memcpy(
+        distances_.row(row), buf.distances_h.data_handle() + i * degree, degree * sizeof(float));
+      initialized_[row] = 1;
+    }
+  }
+
+  [[nodiscard]] auto indices() noexcept -> IdxT* { return indices_.data(); }
+  [[nodiscard]] auto distances() noexcept -> float* { return distances_.data(); }
+
+ private:
+  size_t graph_degree_;
+  spill_matrix<IdxT> indices_;
+  spill_matrix<float> distances_;
+  std::vector<uint8_t> initialized_;
+};
+
+//
+// The global graph the subgraphs of the clusters are merged into, shared by all the devices
+// building them. Either `indices`/`distances` point to it in managed memory, or it is `spilled`.
+// Since every data point belongs to several clusters, the merges of the clusters processed on
+// different devices are serialized with `merge_mutex` (`nullptr` with a single device).
+//
+template <typename IdxT>
+struct global_graph {
+  IdxT* indices;
+  float* distances;
+  spilled_graph<IdxT>* spilled;
+  std::mutex* merge_mutex;
+};
+
 //
 // builds knn graph using NN Descent and merge with global graph
 //
@@ -355,8 +523,8 @@ void build_and_merge(raft::resources const& res,
                      IdxT* cluster_data_indices,
                      int* int_graph,
                      IdxT* inverted_indices,
-                     IdxT* global_indices_d,
-                     float* global_distances_d,
+                     global_graph<IdxT> global,
+                     typename spilled_graph<IdxT>::staging* staging,
                      IdxT* batch_indices_h,
                      IdxT* batch_indices_d,
                      float* batch_distances_d,
@@ -380,13 +548,27 @@ void build_and_merge(raft::resources const& res,
              num_data_in_cluster * graph_degree,
              raft::resource::get_cuda_stream(res));
 
+  // The global rows are read and written back under the lock, as they are shared with the clusters
+  // merged on the other devices.
+  std::unique_lock<std::mutex> merge_lock;
+  if (global.merge_mutex != nullptr) { merge_lock = std::unique_lock(*global.merge_mutex); }
+  IdxT* merge_rows          = cluster_data_indices;
+  IdxT* global_indices_d    = global.indices;
+  float* global_distances_d = global.distances;
+  if (global.spilled != nullptr) {
+    global.spilled->load(res, *staging, inverted_indices, num_data_in_cluster);
+    merge_rows         = nullptr;
+    global_indices_d   = staging->indices_d.data_handle();
+    global_distances_d = staging->distances_d.data_handle();
+  }
+
   size_t num_elems     = graph_degree * 2;
   size_t sharedMemSize = num_elems * (sizeof(float) + sizeof(IdxT) + sizeof(int16_t));
 
   if (num_elems <= 128) {
     merge_subgraphs<IdxT, 32, 4>
       <<<num_data_in_cluster, 32, sharedMemSize, raft::resource::get_cuda_stream(res)>>>(
-        cluster_data_indices,
+        merge_rows,
         graph_degree,
         num_data_in_cluster,
         global_distances_d,
@@ -396,7 +578,7 @@ void build_and_merge(raft::resources const& res,
   } else if (num_elems <= 512) {
     merge_subgraphs<IdxT, 128, 4>
       <<<num_data_in_cluster, 128, sharedMemSize, raft::resource::get_cuda_stream(res)>>>(
-        cluster_data_indices,
+        merge_rows,
         graph_degree,
         num_data_in_cluster,
         global_distances_d,
@@ -406,7 +588,7 @@ void build_and_merge(raft::resources const& res,
   } else if (num_elems <= 1024) {
     merge_subgraphs<IdxT, 128, 8>
       <<<num_data_in_cluster, 128, sharedMemSize, raft::resource::get_cuda_stream(res)>>>(
-        cluster_data_indices,
+        merge_rows,
         graph_degree,
         num_data_in_cluster,
         global_distances_d,
@@ -416,7 +598,7 @@ void build_and_merge(raft::resources const& res,
   } else if (num_elems <= 2048) {
     merge_subgraphs<IdxT, 256, 8>
       <<<num_data_in_cluster, 256, sharedMemSize, raft::resource::get_cuda_stream(res)>>>(
-        cluster_data_indices,
+        merge_rows,
         graph_degree,
         num_data_in_cluster,
         global_distances_d,
@@ -428,13 +610,50 @@ void build_and_merge(raft::resources const& res,
     RAFT_FAIL("The degree of knn is too large (%lu). It must be smaller than 1024", graph_degree);
   }
   raft::resource::sync_stream(res);
+  if (global.spilled != nullptr) {
+    global.spilled->store(res, *staging, inverted_indices, num_data_in_cluster);
+  }
 }
 
 //
-// For each cluster, gather the data samples that belong to that cluster, and
-// call build_and_merge
+// The buffers a device needs to build and merge the subgraphs of the clusters
 //
-template <typename T, typename IdxT = uint32_t, typename epilogue_op = DistEpilogue<IdxT, T>>
+template <typename IdxT>
+struct cluster_buffers {
+  cluster_buffers(raft::resources const& res,
+                  size_t max_cluster_size,
+                  size_t graph_degree,
+                  size_t extended_graph_degree,
+                  bool spill)
+    : int_graph(raft::make_host_matrix<int, int64_t, row_major>(
+        max_cluster_size, static_cast<int64_t>(extended_graph_degree))),
+      batch_indices_h(
+        raft::make_host_matrix<IdxT, int64_t, row_major>(max_cluster_size, graph_degree)),
+      batch_indices_d(
+        raft::make_device_matrix<IdxT, int64_t, row_major>(res, max_cluster_size, graph_degree)),
+      batch_distances_d(
+        raft::make_device_matrix<float, int64_t, row_major>(res, max_cluster_size, graph_degree)),
+      cluster_data_indices(raft::make_device_vector<IdxT, int64_t>(res, max_cluster_size))
+  {
+    if (spill) { staging.emplace(res, max_cluster_size, graph_degree); }
+  }
+
+  raft::host_matrix<int, int64_t, row_major> int_graph;
+  raft::host_matrix<IdxT, int64_t, row_major> batch_indices_h;
+  raft::device_matrix<IdxT, int64_t, row_major> batch_indices_d;
+  raft::device_matrix<float, int64_t, row_major> batch_distances_d;
+  raft::device_vector<IdxT, int64_t> cluster_data_indices;
+  std::optional<typename spilled_graph<IdxT>::staging> staging;
+};
+
+//
+// For each cluster handed out by `next_cluster`, gather the data samples that belong to that
+// cluster, and call build_and_merge
+//
+template <typename T,
+          typename IdxT        = uint32_t,
+          typename epilogue_op = DistEpilogue<IdxT, T>,
+          typename NextCluster>
 void cluster_nnd(raft::resources const& res,
                  const index_params& params,
                  size_t graph_degree,
@@ -443,26 +662,23 @@ void cluster_nnd(raft::resources const& res,
                  raft::host_matrix_view<const T, int64_t> dataset,
                  IdxT* offsets,
                  IdxT* cluster_size,
-                 IdxT* cluster_data_indices,
-                 int* int_graph,
                  IdxT* inverted_indices,
-                 IdxT* global_indices_h,
-                 float* global_distances_h,
-                 IdxT* batch_indices_h,
-                 IdxT* batch_indices_d,
-                 float* batch_distances_d,
+                 global_graph<IdxT> global,
                  const BuildConfig& build_config,
-                 epilogue_op distance_epilogue)
+                 epilogue_op distance_epilogue,
+                 NextCluster&& next_cluster)
 {
-  size_t num_rows = dataset.extent(0);
   size_t num_cols = dataset.extent(1);
 
   GNND<const T, int, epilogue_op> nnd(res, build_config);
+  cluster_buffers<IdxT> buffers(
+    res, max_cluster_size, graph_degree, extended_graph_degree, global.spilled != nullptr);
 
   auto cluster_data_matrix =
     raft::make_host_matrix<T, int64_t, row_major>(max_cluster_size, num_cols);
 
-  for (size_t cluster_id = 0; cluster_id < params.n_clusters; cluster_id++) {
+  for (size_t cluster_id = next_cluster(); cluster_id < params.n_clusters;
+       cluster_id        = next_cluster()) {
     RAFT_LOG_DEBUG(
       "# Data on host. Running clusters: %lu / %lu", cluster_id + 1, params.n_clusters);
     size_t num_data_in_cluster = cluster_size[cluster_id];
@@ -476,7 +692,12 @@ void cluster_nnd(raft::resources const& res,
       }
     }
 
-    distance_epilogue.preprocess_for_batch(cluster_data_indices + offset, num_data_in_cluster);
+    IdxT* cluster_data_indices = buffers.cluster_data_indices.data_handle();
+    raft::copy(cluster_data_indices,
+               inverted_indices + offset,
+               num_data_in_cluster,
+               resource::get_cuda_stream(res));
+    distance_epilogue.preprocess_for_batch(cluster_data_indices, num_data_in_cluster);
 
     build_and_merge<T, IdxT>(res,
                              params,
@@ -484,21 +705,24 @@ void cluster_nnd(raft::resources const& res,
                              graph_degree,
                              extended_graph_degree,
                              cluster_data_matrix.data_handle(),
-                             cluster_data_indices + offset,
-                             int_graph,
+                             cluster_data_indices,
+                             buffers.int_graph.data_handle(),
                              inverted_indices + offset,
-                             global_indices_h,
-                             global_distances_h,
-                             batch_indices_h,
-                             batch_indices_d,
-                             batch_distances_d,
+                             global,
+                             buffers.staging.has_value() ? &buffers.staging.value() : nullptr,
+                             buffers.batch_indices_h.data_handle(),
+                             buffers.batch_indices_d.data_handle(),
+                             buffers.batch_distances_d.data_handle(),
                              nnd,
                              distance_epilogue);
     nnd.reset(res);
   }
 }
 
-template <typename T, typename IdxT = uint32_t, typename epilogue_op = DistEpilogue<IdxT, T>>
+template <typename T,
+          typename IdxT        = uint32_t,
+          typename epilogue_op = DistEpilogue<IdxT, T>,
+          typename NextCluster>
 void cluster_nnd(raft::resources const& res,
                  const index_params& params,
                  size_t graph_degree,
@@ -507,36 +731,40 @@ void cluster_nnd(raft::resources const& res,
                  raft::device_matrix_view<const T, int64_t> dataset,
                  IdxT* offsets,
                  IdxT* cluster_size,
-                 IdxT* cluster_data_indices,
-                 int* int_graph,
                  IdxT* inverted_indices,
-                 IdxT* global_indices_h,
-                 float* global_distances_h,
-                 IdxT* batch_indices_h,
-                 IdxT* batch_indices_d,
-                 float* batch_distances_d,
+                 global_graph<IdxT> global,
                  const BuildConfig& build_config,
-                 epilogue_op distance_epilogue)
+                 epilogue_op distance_epilogue,
+                 NextCluster&& next_cluster)
 {
   size_t num_rows = dataset.extent(0);
   size_t num_cols = dataset.extent(1);
 
   GNND<const T, int, epilogue_op> nnd(res, build_config);
+  cluster_buffers<IdxT> buffers(
+    res, max_cluster_size, graph_degree, extended_graph_degree, global.spilled != nullptr);
 
   auto cluster_data_matrix =
     raft::make_device_matrix<T, int64_t, row_major>(res, max_cluster_size, num_cols);
 
-  for (size_t cluster_id = 0; cluster_id < params.n_clusters; cluster_id++) {
+  for (size_t cluster_id = next_cluster(); cluster_id < params.n_clusters;
+       cluster_id        = next_cluster()) {
     RAFT_LOG_DEBUG(
       "# Data on device. Running clusters: %lu / %lu", cluster_id + 1, params.n_clusters);
     size_t num_data_in_cluster = cluster_size[cluster_id];
     size_t offset              = offsets[cluster_id];
 
+    IdxT* cluster_data_indices = buffers.cluster_data_indices.data_handle();
+    raft::copy(cluster_data_indices,
+               inverted_indices + offset,
+               num_data_in_cluster,
+               resource::get_cuda_stream(res));
+
     auto cluster_data_view = raft::make_device_matrix_view<T, IdxT>(
       cluster_data_matrix.data_handle(), num_data_in_cluster, num_cols);
-    auto cluster_data_indices_view = raft::make_device_vector_view<const IdxT, IdxT>(
-      cluster_data_indices + offset, num_data_in_cluster);
-    distance_epilogue.preprocess_for_batch(cluster_data_indices + offset, num_data_in_cluster);
+    auto cluster_data_indices_view =
+      raft::make_device_vector_view<const IdxT, IdxT>(cluster_data_indices, num_data_in_cluster);
+    distance_epilogue.preprocess_for_batch(cluster_data_indices, num_data_in_cluster);
 
     auto dataset_IdxT =
       raft::make_device_matrix_view<const T, IdxT>(dataset.data_handle(), num_rows, num_cols);
@@ -548,20 +776,26 @@ void cluster_nnd(raft::resources const& res,
                              graph_degree,
                              extended_graph_degree,
                              cluster_data_view.data_handle(),
-                             cluster_data_indices + offset,
-                             int_graph,
+                             cluster_data_indices,
+                             buffers.int_graph.data_handle(),
                              inverted_indices + offset,
-                             global_indices_h,
-                             global_distances_h,
-                             batch_indices_h,
-                             batch_indices_d,
-                             batch_distances_d,
+                             global,
+                             buffers.staging.has_value() ? &buffers.staging.value() : nullptr,
+                             buffers.batch_indices_h.data_handle(),
+                             buffers.batch_indices_d.data_handle(),
+                             buffers.batch_distances_d.data_handle(),
                              nnd,
                              distance_epilogue);
     nnd.reset(res);
   }
 }
 
+//
+// The batched build. With several `device_ids`, the clusters are handed out dynamically to one
+// host thread per device, each of them running its own GNND on the device; the dataset must then
+// be accessible from all the devices (i.e. in host memory). With no `device_ids`, everything runs
+// on the device of `res`. The kmeans and the resulting index always use `res`.
+//
 template <typename T,
           typename IdxT        = uint32_t,
           typename epilogue_op = DistEpilogue<IdxT, T>,
@@ -570,8 +804,12 @@ template <typename T,
 index<IdxT> batch_build(raft::resources const& res,
                         const index_params& params,
                         mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset,
-                        epilogue_op distance_epilogue = DistEpilogue<IdxT, T>())
+                        epilogue_op distance_epilogue      = DistEpilogue<IdxT, T>(),
+                        const std::vector<int>& device_ids = {})
 {
+  RAFT_EXPECTS(device_ids.size() <= 1 || Accessor::is_host_accessible,
+               "The dataset must be in host memory to build on several devices");
+  check_metric(params.metric);
   size_t graph_degree        = params.graph_degree;
   size_t intermediate_degree = params.intermediate_graph_degree;
 
@@ -580,7 +818,10 @@ index<IdxT> batch_build(raft::resources const& res,
 
   auto centroids =
     raft::make_device_matrix<T, IdxT, raft::row_major>(res, params.n_clusters, num_cols);
-  get_balanced_kmeans_centroids<T, IdxT>(res, params.metric, dataset, centroids.view());
+  // The clustering only groups the nearby points into batches and runs on the L2 kernels, which
+  // are a good proxy for the inner product and cosine metrics as well.
+  const auto cluster_metric = raft::distance::DistanceType::L2Expanded;
+  get_balanced_kmeans_centroids<T, IdxT>(res, cluster_metric, dataset, centroids.view());
 
   size_t k                    = 2;
   auto global_nearest_cluster = raft::make_host_matrix<IdxT, IdxT, raft::row_major>(num_rows, k);
@@ -591,7 +832,7 @@ index<IdxT> batch_build(raft::resources const& res,
                                 dataset.data_handle(),
                                 global_nearest_cluster.view(),
                                 centroids.view(),
-                                params.metric);
+                                cluster_metric);
 
   auto inverted_indices = raft::make_host_vector<IdxT, IdxT, raft::row_major>(num_rows * k);
   auto cluster_size     = raft::make_host_vector<IdxT, IdxT, raft::row_major>(params.n_clusters);
@@ -627,74 +868,101 @@ index<IdxT> batch_build(raft::resources const& res,
   size_t extended_intermediate_degree = align32::roundUp(
     static_cast<size_t>(intermediate_degree * (intermediate_degree <= 32 ? 1.0 : 1.3)));
 
-  auto int_graph = raft::make_host_matrix<int, int64_t, row_major>(
-    max_cluster_size, static_cast<int64_t>(extended_graph_degree));
-
-  BuildConfig build_config{.max_dataset_size      = max_cluster_size,
-                           .dataset_dim           = num_cols,
-                           .node_degree           = extended_graph_degree,
-                           .internal_node_degree  = extended_intermediate_degree,
-                           .max_iterations        = params.max_iterations,
-                           .termination_threshold = params.termination_threshold,
-                           .output_graph_degree   = graph_degree};
-
-  auto global_indices_h   = raft::make_managed_matrix<IdxT, int64_t>(res, num_rows, graph_degree);
-  auto global_distances_h = raft::make_managed_matrix<float, int64_t>(res, num_rows, graph_degree);
+  BuildConfig build_config{.max_dataset_size       = max_cluster_size,
+                           .dataset_dim            = num_cols,
+                           .node_degree            = extended_graph_degree,
+                           .internal_node_degree   = extended_intermediate_degree,
+                           .max_iterations         = params.max_iterations,
+                           .termination_threshold  = params.termination_threshold,
+                           .output_graph_degree    = graph_degree,
+                           .metric                 = params.metric,
+                           .on_iteration           = params.on_iteration,
+                           .max_time_per_update_us = params.max_time_per_update_us};
+
+  // The global graph is either kept in managed memory and merged in place, or spilled to disk and
+  // streamed through the staging buffers of the devices cluster by cluster.
+  const bool spill         = !params.spill_directory.empty();
+  const size_t global_rows = spill ? 0 : num_rows;
+
+  auto global_indices_h = raft::make_managed_matrix<IdxT, int64_t>(res, global_rows, graph_degree);
+  auto global_distances_h =
+    raft::make_managed_matrix<float, int64_t>(res, global_rows, graph_degree);
+  std::optional<spilled_graph<IdxT>> spilled;
+  if (spill) {
+    RAFT_LOG_DEBUG("# Spilling the global graph to %s", params.spill_directory.c_str());
+    spilled.emplace(params.spill_directory, num_rows, graph_degree);
+  }
 
   thrust::fill(thrust::host,
                global_indices_h.data_handle(),
-               global_indices_h.data_handle() + num_rows * graph_degree,
+               global_indices_h.data_handle() + global_rows * graph_degree,
                std::numeric_limits<IdxT>::max());
   thrust::fill(thrust::host,
                global_distances_h.data_handle(),
-               global_distances_h.data_handle() + num_rows * graph_degree,
+               global_distances_h.data_handle() + global_rows * graph_degree,
                std::numeric_limits<float>::max());
 
-  auto batch_indices_h =
-    raft::make_host_matrix<IdxT, int64_t, row_major>(max_cluster_size, graph_degree);
-  auto batch_indices_d =
-    raft::make_device_matrix<IdxT, int64_t, row_major>(res, max_cluster_size, graph_degree);
-  auto batch_distances_d =
-    raft::make_device_matrix<float, int64_t, row_major>(res, max_cluster_size, graph_degree);
-
-  auto cluster_data_indices = raft::make_device_vector<IdxT, IdxT>(res, num_rows * k);
-  raft::copy(cluster_data_indices.data_handle(),
-             inverted_indices.data_handle(),
-             num_rows * k,
-             resource::get_cuda_stream(res));
-
-  cluster_nnd<T, IdxT>(res,
-                       params,
-                       graph_degree,
-                       extended_graph_degree,
-                       max_cluster_size,
-                       dataset,
-                       offset.data_handle(),
-                       cluster_size.data_handle(),
-                       cluster_data_indices.data_handle(),
-                       int_graph.data_handle(),
-                       inverted_indices.data_handle(),
-                       global_indices_h.data_handle(),
-                       global_distances_h.data_handle(),
-                       batch_indices_h.data_handle(),
-                       batch_indices_d.data_handle(),
-                       batch_distances_d.data_handle(),
-                       build_config,
-                       distance_epilogue);
+  const bool multi_device = device_ids.size() > 1;
+  std::mutex merge_mutex;
+  global_graph<IdxT> global{global_indices_h.data_handle(),
+                            global_distances_h.data_handle(),
+                            spilled.has_value() ? &spilled.value() : nullptr,
+                            multi_device ? &merge_mutex : nullptr};
+  std::atomic<size_t> next_cluster{0};
+  auto take_cluster = [&next_cluster]() { return next_cluster.fetch_add(1); };
+
+  if (multi_device) {
+    // The managed global graph must be complete before the other devices touch it.
+    resource::sync_stream(res);
+    raft::neighbors::detail::for_each_device(device_ids, [&](size_t i) {
+      const auto& dev_res = raft::device_resources_manager::get_device_resources(device_ids[i]);
+      cluster_nnd<T, IdxT>(dev_res,
+                           params,
+                           graph_degree,
+                           extended_graph_degree,
+                           max_cluster_size,
+                           dataset,
+                           offset.data_handle(),
+                           cluster_size.data_handle(),
+                           inverted_indices.data_handle(),
+                           global,
+                           build_config,
+                           distance_epilogue,
+                           take_cluster);
+      resource::sync_stream(dev_res);
+    });
+  } else {
+    cluster_nnd<T, IdxT>(res,
+                         params,
+                         graph_degree,
+                         extended_graph_degree,
+                         max_cluster_size,
+                         dataset,
+                         offset.data_handle(),
+                         cluster_size.data_handle(),
+                         inverted_indices.data_handle(),
+                         global,
+                         build_config,
+                         distance_epilogue,
+                         take_cluster);
+  }
 
   index<IdxT> global_idx{
     res, dataset.extent(0), static_cast<int64_t>(graph_degree), params.return_distances};
 
   raft::copy(global_idx.graph().data_handle(),
-             global_indices_h.data_handle(),
+             spill ? spilled->indices() : global_indices_h.data_handle(),
              num_rows * graph_degree,
              raft::resource::get_cuda_stream(res));
   if (params.return_distances && global_idx.distances().has_value()) {
     raft::copy(global_idx.distances().value().data_handle(),
-               global_distances_h.data_handle(),
+               spill ? spilled->distances() : global_distances_h.data_handle(),
                num_rows * graph_degree,
                raft::resource::get_cuda_stream(res));
+    restore_distances(res, params.metric, global_idx.distances().value());
   }
+  // The spill files are released on return
+  if (spill) { raft::resource::sync_stream(res); }
   return global_idx;
 }
 
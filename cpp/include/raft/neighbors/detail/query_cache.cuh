@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/bounded_hash_map.cuh>
+#include <raft/util/cuda_dev_essentials.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/gather.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
+
+#include <cstdint>
+
+namespace raft::neighbors::query_cache::detail {
+
+/** The number of warps per block of the cache kernels (one warp per query). */
+constexpr uint32_t kWarpsPerBlock = 4;
+
+/**
+ * The code of a query component: its value in units of the quantization step (rounded to the
+ * nearest), or the bits of its value if the step is zero (the queries must match exactly).
+ */
+template <typename T>
+_RAFT_DEVICE inline auto quantize(T x, float quantization_step) -> int32_t
+{
+  float v = spatial::knn::detail::utils::mapping<float>{}(x);
+  if (quantization_step > 0.0f) { return __float2int_rn(v / quantization_step); }
+  return __float_as_int(v);
+}
+
+/** The hash of the whole query is the sum of the mixed (position, code) pairs. */
+_RAFT_DEVICE inline auto hash_component(uint32_t j, int32_t code) -> uint64_t
+{
+  return raft::util::hash::fmix{}((uint64_t{j} << 32) | static_cast<uint32_t>(code), 0);
+}
+
+/** The cache set of a query; the low bits of the hash are left for comparing the keys. */
+_RAFT_HOST_DEVICE inline auto set_of(uint64_t hash, uint32_t n_sets) -> uint32_t
+{
+  return static_cast<uint32_t>((hash >> 32) % n_sets);
+}
+
+/**
+ * Quantize and hash every query and look it up in the cache (one warp per query).
+ *
+ * A cache entry matches a query if both its hash and all its codes are equal. The results of a
+ * matching entry are copied to the outputs and its time stamp is set to `time`, which protects it
+ * from the eviction by the misses of the same batch.
+ */
+template <typename T, typename IdxT, typename DistT>
+RAFT_KERNEL lookup_kernel(const T* queries,
+                          int64_t n_queries,
+                          uint32_t dim,
+                          uint32_t k,
+                          float quantization_step,
+                          const uint64_t* keys,
+                          uint32_t* stamps,
+                          const int32_t* codes,
+                          const IdxT* cached_neighbors,
+                          const DistT* cached_distances,
+                          uint32_t n_sets,
+                          uint32_t associativity,
+                          uint32_t time,
+                          int32_t* query_codes,
+                          uint64_t* query_hashes,
+                          IdxT* neighbors,
+                          DistT* distances,
+                          uint8_t* hits)
+{
+  const int64_t i     = (int64_t{blockIdx.x} * blockDim.x + threadIdx.x) / WarpSize;
+  const uint32_t lane = threadIdx.x % WarpSize;
+  if (i >= n_queries) { return; }
+
+  uint64_t hash = 0;
+  for (uint32_t j = lane; j < dim; j += WarpSize) {
+    auto code                = quantize(queries[i * dim + j], quantization_step);
+    query_codes[i * dim + j] = code;
+    hash += hash_component(j, code);
+  }
+  for (uint32_t offset = WarpSize / 2; offset > 0; offset /= 2) {
+    hash += __shfl_xor_sync(0xffffffffu, hash, offset);
+  }
+  // zero marks the empty entries
+  hash |= 1;
+  if (lane == 0) { query_hashes[i] = hash; }
+
+  const uint64_t first_slot = uint64_t{set_of(hash, n_sets)} * associativity;
+  uint32_t candidates =
+    __ballot_sync(0xffffffffu, lane < associativity && keys[first_slot + lane] == hash);
+  int64_t found = -1;
+  while (candidates != 0) {
+    uint64_t slot = first_slot + __ffs(candidates) - 1;
+    candidates &= candidates - 1;
+    bool same = true;
+    for (uint32_t j = lane; j < dim; j += WarpSize) {
+      same = same && codes[slot * dim + j] == query_codes[i * dim + j];
+    }
+    if (__all_sync(0xffffffffu, same)) {
+      found = slot;
+      break;
+    }
+  }
+  if (found >= 0) {
+    for (uint32_t j = lane; j < k; j += WarpSize) {
+      neighbors[i * k + j] = cached_neighbors[found * k + j];
+      distances[i * k + j] = cached_distances[found * k + j];
+    }
+  }
+  if (lane == 0) {
+    if (found >= 0) { stamps[found] = time; }
+    hits[i] = found >= 0;
+  }
+}
+
+/**
+ * Pick the entry replaced by every new query (one warp per new query).
+ *
+ * The new queries are sorted by their cache sets; `rank` is the position of a query among the new
+ * queries of its set. The query of rank `r` replaces the `r`-th least recently used entry of the
+ * set, unless that entry has been used by the current batch (all entries of the set are taken).
+ * The entries are only read here, so the choices of all queries are consistent.
+ */
+RAFT_KERNEL pick_victims_kernel(const uint64_t* hashes,
+                                const uint32_t* ranks,
+                                int64_t n,
+                                const uint32_t* stamps,
+                                uint32_t n_sets,
+                                uint32_t associativity,
+                                uint32_t time,
+                                int64_t* victims)
+{
+  const int64_t i     = (int64_t{blockIdx.x} * blockDim.x + threadIdx.x) / WarpSize;
+  const uint32_t lane = threadIdx.x % WarpSize;
+  if (i >= n) { return; }
+
+  const uint64_t first_slot = uint64_t{set_of(hashes[i], n_sets)} * associativity;
+  // the empty entries have the time stamp zero and come first
+  uint32_t stamp = lane < associativity ? stamps[first_slot + lane] : ~0u;
+  uint32_t order = 0;
+  for (uint32_t l = 0; l < associativity; l++) {
+    uint32_t other = __shfl_sync(0xffffffffu, stamp, l);
+    order += other < stamp || (other == stamp && l < lane);
+  }
+  uint32_t chosen =
+    __ballot_sync(0xffffffffu, lane < associativity && order == ranks[i] && stamp != time);
+  if (lane == 0) { victims[i] = chosen != 0 ? int64_t(first_slot + __ffs(chosen) - 1) : -1; }
+}
+
+/**
+ * Write the new queries and their results to the entries picked by `pick_victims_kernel` (one
+ * warp per new query). `sources[i]` is the row of the i-th new query in the `codes` of the batch,
+ * and `rows[i]` its row in the search results.
+ */
+template <typename IdxT, typename DistT>
+RAFT_KERNEL insert_kernel(const int64_t* victims,
+                          const uint64_t* hashes,
+                          const int64_t* sources,
+                          const int64_t* rows,
+                          int64_t n,
+                          uint32_t dim,
+                          uint32_t k,
+                          uint32_t time,
+                          const int32_t* query_codes,
+                          const IdxT* neighbors,
+                          const DistT* distances,
+                          uint64_t* keys,
+                          uint32_t* stamps,
+                          int32_t* codes,
+                          IdxT* cached_neighbors,
+                          DistT* cached_distances)
+{
+  const int64_t i     = (int64_t{blockIdx.x} * blockDim.x + threadIdx.x) / WarpSize;
+  const uint32_t lane = threadIdx.x % WarpSize;
+  if (i >= n) { return; }
+  const int64_t slot = victims[i];
+  if (slot < 0) { return; }
+
+  const int64_t src = sources[i];
+  const int64_t row = rows[i];
+  for (uint32_t j = lane; j < dim; j += WarpSize) {
+    codes[slot * dim + j] = query_codes[src * dim + j];
+  }
+  for (uint32_t j = lane; j < k; j += WarpSize) {
+    cached_neighbors[slot * k + j] = neighbors[row * k + j];
+    cached_distances[slot * k + j] = distances[row * k + j];
+  }
+  if (lane == 0) {
+    keys[slot]   = hashes[i];
+    stamps[slot] = time;
+  }
+}
+
+/** Copy the search results of the misses to their rows of the outputs (one warp per miss). */
+template <typename IdxT, typename DistT>
+RAFT_KERNEL scatter_results_kernel(const int64_t* rows,
+                                   int64_t n,
+                                   uint32_t k,
+                                   const IdxT* in_neighbors,
+                                   const DistT* in_distances,
+                                   IdxT* neighbors,
+                                   DistT* distances)
+{
+  const int64_t i     = (int64_t{blockIdx.x} * blockDim.x + threadIdx.x) / WarpSize;
+  const uint32_t lane = threadIdx.x % WarpSize;
+  if (i >= n) { return; }
+  const int64_t row = rows[i];
+  for (uint32_t j = lane; j < k; j += WarpSize) {
+    neighbors[row * k + j] = in_neighbors[i * k + j];
+    distances[row * k + j] = in_distances[i * k + j];
+  }
+}
+
+/**
+ * Store the misses of a batch in the cache. The duplicate misses (same hash) are stored once; the
+ * new queries of every cache set replace its least recently used entries, excluding the entries
+ * used by the current batch.
+ */
+template <typename IdxT, typename DistT>
+void insert(raft::resources const& res,
+            uint32_t n_sets,
+            uint32_t associativity,
+            uint32_t time,
+            int64_t dim,
+            int64_t k,
+            const int32_t* query_codes,
+            const uint64_t* query_hashes,
+            const int64_t* miss_rows,
+            int64_t n_misses,
+            const IdxT* miss_neighbors,
+            const DistT* miss_distances,
+            uint64_t* keys,
+            uint32_t* stamps,
+            int32_t* codes,
+            IdxT* cached_neighbors,
+            DistT* cached_distances)
+{
+  auto stream      = resource::get_cuda_stream(res);
+  auto exec_policy = resource::get_thrust_policy(res);
+
+  // Sort the misses by (set, hash)
+  auto sets   = raft::make_device_vector<uint32_t, int64_t>(res, n_misses);
+  auto hashes = raft::make_device_vector<uint64_t, int64_t>(res, n_misses);
+  auto order  = raft::make_device_vector<int64_t, int64_t>(res, n_misses);
+  thrust::gather(
+    exec_policy, miss_rows, miss_rows + n_misses, query_hashes, hashes.data_handle());
+  thrust::transform(exec_policy,
+                    hashes.data_handle(),
+                    hashes.data_handle() + n_misses,
+                    sets.data_handle(),
+                    [n_sets] __device__(uint64_t hash) { return set_of(hash, n_sets); });
+  thrust::sequence(exec_policy, order.data_handle(), order.data_handle() + n_misses);
+  auto sort_keys =
+    thrust::make_zip_iterator(thrust::make_tuple(sets.data_handle(), hashes.data_handle()));
+  thrust::sort_by_key(exec_policy, sort_keys, sort_keys + n_misses, order.data_handle());
+
+  // Keep the first of the duplicates
+  auto unique_sets   = raft::make_device_vector<uint32_t, int64_t>(res, n_misses);
+  auto unique_hashes = raft::make_device_vector<uint64_t, int64_t>(res, n_misses);
+  auto unique_order  = raft::make_device_vector<int64_t, int64_t>(res, n_misses);
+  auto values        = thrust::make_zip_iterator(
+    thrust::make_tuple(sets.data_handle(), hashes.data_handle(), order.data_handle()));
+  auto unique_values = thrust::make_zip_iterator(thrust::make_tuple(
+    unique_sets.data_handle(), unique_hashes.data_handle(), unique_order.data_handle()));
+  auto unique_end    = thrust::copy_if(exec_policy,
+                                    values,
+                                    values + n_misses,
+                                    thrust::counting_iterator<int64_t>(0),
+                                    unique_values,
+                                    [hashes = hashes.data_handle()] __device__(int64_t i) {
+                                      return i == 0 || hashes[i] != hashes[i - 1];
+                                    });
+  int64_t n_new      = unique_end - unique_values;
+
+  // The rank of every new query among the new queries of its set
+  auto ranks = raft::make_device_vector<uint32_t, int64_t>(res, n_new);
+  thrust::exclusive_scan_by_key(exec_policy,
+                                unique_sets.data_handle(),
+                                unique_sets.data_handle() + n_new,
+                                thrust::constant_iterator<uint32_t>(1),
+                                ranks.data_handle());
+
+  constexpr uint32_t kBlockSize = kWarpsPerBlock * WarpSize;
+  const auto n_blocks           = raft::ceildiv<int64_t>(n_new, kWarpsPerBlock);
+  auto victims                  = raft::make_device_vector<int64_t, int64_t>(res, n_new);
+  pick_victims_kernel<<<n_blocks, kBlockSize, 0, stream>>>(unique_hashes.data_handle(),
+                                                           ranks.data_handle(),
+                                                           n_new,
+                                                           stamps,
+                                                           n_sets,
+                                                           associativity,
+                                                           time,
+                                                           victims.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  auto sources = raft::make_device_vector<int64_t, int64_t>(res, n_new);
+  thrust::gather(exec_policy,
+                 unique_order.data_handle(),
+                 unique_order.data_handle() + n_new,
+                 miss_rows,
+                 sources.data_handle());
+  insert_kernel<IdxT, DistT><<<n_blocks, kBlockSize, 0, stream>>>(victims.data_handle(),
+                                                                  unique_hashes.data_handle(),
+                                                                  sources.data_handle(),
+                                                                  unique_order.data_handle(),
+                                                                  n_new,
+                                                                  dim,
+                                                                  k,
+                                                                  time,
+                                                                  query_codes,
+                                                                  miss_neighbors,
+                                                                  miss_distances,
+                                                                  keys,
+                                                                  stamps,
+                                                                  codes,
+                                                                  cached_neighbors,
+                                                                  cached_distances);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::neighbors::query_cache::detail
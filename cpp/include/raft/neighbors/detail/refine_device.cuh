@@ -19,7 +19,9 @@
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_properties.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/matrix/detail/select_warpsort.cuh>
@@ -28,43 +30,244 @@
 #include <raft/neighbors/detail/refine_common.hpp>
 #include <raft/neighbors/sample_filter_types.hpp>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/pow2_utils.cuh>
+#include <raft/util/reduction.cuh>
+#include <raft/util/vectorized.cuh>
+#include <raft/util/warp_primitives.cuh>
 
 #include <thrust/sequence.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
 namespace raft::neighbors::detail {
 
+constexpr int kRefineThreadsPerBlock = 128;
+
+/** The squared euclidean distance, accumulated element by element. */
+struct refine_l2_dist {
+  template <typename AccT>
+  __device__ __forceinline__ void operator()(AccT& acc, AccT x, AccT y) const
+  {
+    const auto diff = x - y;
+    acc += diff * diff;
+  }
+};
+
+/** The inner product, accumulated element by element. */
+struct refine_ip_dist {
+  template <typename AccT>
+  __device__ __forceinline__ void operator()(AccT& acc, AccT x, AccT y) const
+  {
+    acc += x * y;
+  }
+};
+
 /**
- * See raft::neighbors::refine for docs.
+ * Compute the distances from a query to its candidates and select the top-k of them, in one pass.
+ *
+ * Every block processes one query, which is cached in the shared memory. Every warp takes 32
+ * candidates at a time: the rows of the candidates are gathered from the dataset directly via
+ * their ids, one row per iteration of the whole warp with vectorized loads, and the lane `j` keeps
+ * the distance to the `j`-th candidate. Then every lane feeds its candidate to the block-wide
+ * top-k queue.
+ *
+ * The candidates with the ids outside of the dataset (e.g. the padding of the searches that found
+ * fewer than n_candidates neighbors) are skipped: they are never selected ahead of the valid ones.
+ */
+template <int Capacity,
+          int Veclen,
+          bool Ascending,
+          typename DataT,
+          typename AccT,
+          typename IdxT,
+          typename DistT,
+          typename DistF,
+          typename PostF>
+__launch_bounds__(kRefineThreadsPerBlock) RAFT_KERNEL
+  refine_kernel(DistF compute_dist,
+                PostF post_process,
+                const DataT* dataset,
+                IdxT n_rows,
+                uint32_t dim,
+                const DataT* queries,
+                const IdxT* neighbor_candidates,
+                uint32_t n_candidates,
+                uint32_t k,
+                IdxT* indices,
+                DistT* distances)
+{
+  extern __shared__ __align__(256) uint8_t refine_kernel_smem[];
+  namespace warpsort = matrix::detail::select::warpsort;
+  using block_sort_t =
+    warpsort::block_sort<warpsort::warp_sort_filtered, Capacity, Ascending, float, IdxT>;
+  using unsigned_idx_t = std::make_unsigned_t<IdxT>;
+
+  const uint64_t query_ix = blockIdx.x;
+  auto* query             = reinterpret_cast<DataT*>(refine_kernel_smem);
+  for (uint32_t i = threadIdx.x; i < dim; i += blockDim.x) {
+    query[i] = queries[query_ix * dim + i];
+  }
+  neighbor_candidates += query_ix * n_candidates;
+  __syncthreads();
+
+  block_sort_t queue(k);
+  const uint32_t lane_id       = threadIdx.x % WarpSize;
+  constexpr uint32_t kNumWarps = kRefineThreadsPerBlock / WarpSize;
+  for (uint32_t batch = threadIdx.x - lane_id; batch < n_candidates;
+       batch += kNumWarps * WarpSize) {
+    const uint32_t batch_size = min(uint32_t(WarpSize), n_candidates - batch);
+    const IdxT id             = lane_id < batch_size ? neighbor_candidates[batch + lane_id] : 0;
+    float dist                = block_sort_t::queue_t::kDummy;
+    for (uint32_t j = 0; j < batch_size; j++) {
+      const IdxT row_id = shfl(id, j);
+      if (unsigned_idx_t(row_id) >= unsigned_idx_t(n_rows)) { continue; }
+      const DataT* row = dataset + uint64_t(row_id) * dim;
+      AccT acc         = 0;
+      for (uint32_t d = lane_id * Veclen; d < dim; d += WarpSize * Veclen) {
+        TxN_t<DataT, Veclen> x;
+        TxN_t<DataT, Veclen> q;
+        x.load(row, d);
+        q.load(query, d);
+#pragma unroll
+        for (int v = 0; v < Veclen; v++) {
+          compute_dist(acc, AccT(q.val.data[v]), AccT(x.val.data[v]));
+        }
+      }
+      acc = warpReduce(acc);
+      if (lane_id == j) { dist = static_cast<float>(acc); }
+    }
+    queue.add(dist, id);
+  }
+
+  // The query is not needed anymore: the shared memory is reused for merging the queues
+  __syncthreads();
+  queue.done(refine_kernel_smem);
+  queue.store(distances + query_ix * k, indices + query_ix * k, post_process);
+}
+
+/** The shared memory needed by `refine_kernel`. */
+template <int Capacity, typename DataT, typename IdxT>
+auto refine_kernel_smem_size(uint32_t dim, uint32_t k) -> size_t
+{
+  constexpr int kSubwarpSize = std::min<int>(Capacity, WarpSize);
+  const size_t query_size    = Pow2<16>::roundUp(dim * sizeof(DataT));
+  const size_t merge_size =
+    matrix::detail::select::warpsort::calc_smem_size_for_block_wide<float, IdxT>(
+      kRefineThreadsPerBlock / kSubwarpSize, k);
+  return std::max(query_size, merge_size);
+}
+
+template <int Capacity, int Veclen, bool Ascending, typename DataT, typename IdxT, typename DistT>
+void launch_refine_kernel(raft::resources const& handle,
+                          distance::DistanceType metric,
+                          const DataT* dataset,
+                          IdxT n_rows,
+                          uint32_t dim,
+                          const DataT* queries,
+                          uint32_t n_queries,
+                          const IdxT* neighbor_candidates,
+                          uint32_t n_candidates,
+                          uint32_t k,
+                          IdxT* indices,
+                          DistT* distances)
+{
+  using acc_t = typename raft::spatial::knn::detail::utils::config<DataT>::value_t;
+  auto launch = [&](auto compute_dist, auto post_process) {
+    constexpr auto kKernel = refine_kernel<Capacity,
+                                           Veclen,
+                                           Ascending,
+                                           DataT,
+                                           acc_t,
+                                           IdxT,
+                                           DistT,
+                                           decltype(compute_dist),
+                                           decltype(post_process)>;
+    const size_t smem_size = refine_kernel_smem_size<Capacity, DataT, IdxT>(dim, k);
+    RAFT_CUDA_TRY(
+      cudaFuncSetAttribute(kKernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smem_size));
+    kKernel<<<n_queries, kRefineThreadsPerBlock, smem_size, resource::get_cuda_stream(handle)>>>(
+      compute_dist,
+      post_process,
+      dataset,
+      n_rows,
+      dim,
+      queries,
+      neighbor_candidates,
+      n_candidates,
+      k,
+      indices,
+      distances);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  };
+  switch (metric) {
+    case distance::DistanceType::L2Expanded:
+    case distance::DistanceType::L2Unexpanded:
+      return launch(refine_l2_dist{}, raft::identity_op{});
+    case distance::DistanceType::L2SqrtExpanded:
+    case distance::DistanceType::L2SqrtUnexpanded:
+      return launch(refine_l2_dist{}, raft::sqrt_op{});
+    case distance::DistanceType::InnerProduct: return launch(refine_ip_dist{}, raft::identity_op{});
+    default: RAFT_FAIL("The chosen distance metric is not supported (%d)", int(metric));
+  }
+}
+
+/**
+ * Lift the `capacity` and `veclen` parameters to the template level, the same way as
+ * `select_interleaved_scan_kernel` does for the IVF-Flat search.
+ */
+template <typename DataT,
+          typename IdxT,
+          typename DistT,
+          int Capacity = matrix::detail::select::warpsort::kMaxCapacity,
+          int Veclen   = std::max<int>(1, 16 / sizeof(DataT))>
+struct select_refine_kernel {
+  template <typename... Args>
+  static inline void run(uint32_t k, int veclen, bool select_min, Args&&... args)
+  {
+    if constexpr (Capacity > 1) {
+      if (k * 2 <= Capacity) {
+        return select_refine_kernel<DataT, IdxT, DistT, Capacity / 2, Veclen>::run(
+          k, veclen, select_min, std::forward<Args>(args)...);
+      }
+    }
+    if constexpr (Veclen > 1) {
+      if (veclen < Veclen) {
+        return select_refine_kernel<DataT, IdxT, DistT, Capacity, Veclen / 2>::run(
+          k, veclen, select_min, std::forward<Args>(args)...);
+      }
+    }
+    if (select_min) {
+      launch_refine_kernel<Capacity, Veclen, true, DataT, IdxT, DistT>(
+        std::forward<Args>(args)...);
+    } else {
+      launch_refine_kernel<Capacity, Veclen, false, DataT, IdxT, DistT>(
+        std::forward<Args>(args)...);
+    }
+  }
+};
+
+/**
+ * The refinement with the IVF-Flat search, used when the query does not fit in the shared memory
+ * of `refine_kernel`.
  */
 template <typename idx_t, typename data_t, typename distance_t, typename matrix_idx>
-void refine_device(raft::resources const& handle,
-                   raft::device_matrix_view<const data_t, matrix_idx, row_major> dataset,
-                   raft::device_matrix_view<const data_t, matrix_idx, row_major> queries,
-                   raft::device_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,
-                   raft::device_matrix_view<idx_t, matrix_idx, row_major> indices,
-                   raft::device_matrix_view<distance_t, matrix_idx, row_major> distances,
-                   distance::DistanceType metric = distance::DistanceType::L2Unexpanded)
+void refine_device_ivf_flat(
+  raft::resources const& handle,
+  raft::device_matrix_view<const data_t, matrix_idx, row_major> dataset,
+  raft::device_matrix_view<const data_t, matrix_idx, row_major> queries,
+  raft::device_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,
+  raft::device_matrix_view<idx_t, matrix_idx, row_major> indices,
+  raft::device_matrix_view<distance_t, matrix_idx, row_major> distances,
+  distance::DistanceType metric)
 {
   matrix_idx n_candidates = neighbor_candidates.extent(1);
   matrix_idx n_queries    = queries.extent(0);
   matrix_idx dim          = dataset.extent(1);
   uint32_t k              = static_cast<uint32_t>(indices.extent(1));
 
-  // TODO: this restriction could be lifted with some effort
-  RAFT_EXPECTS(k <= raft::matrix::detail::select::warpsort::kMaxCapacity,
-               "k must be less than topk::kMaxCapacity (%d).",
-               raft::matrix::detail::select::warpsort::kMaxCapacity);
-
-  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
-    "neighbors::refine(%zu, %u)", size_t(n_queries), uint32_t(n_candidates));
-
-  refine_check_input(dataset.extents(),
-                     queries.extents(),
-                     neighbor_candidates.extents(),
-                     indices.extents(),
-                     distances.extents(),
-                     metric);
-
   // The refinement search can be mapped to an IVF flat search:
   // - We consider that the candidate vectors form a cluster, separately for each query.
   // - In other words, the n_queries * n_candidates vectors form n_queries clusters, each with
@@ -141,4 +344,67 @@ void refine_device(raft::resources const& handle,
                                      resource::get_cuda_stream(handle));
 }
 
+/**
+ * See raft::neighbors::refine for docs.
+ */
+template <typename idx_t, typename data_t, typename distance_t, typename matrix_idx>
+void refine_device(raft::resources const& handle,
+                   raft::device_matrix_view<const data_t, matrix_idx, row_major> dataset,
+                   raft::device_matrix_view<const data_t, matrix_idx, row_major> queries,
+                   raft::device_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,
+                   raft::device_matrix_view<idx_t, matrix_idx, row_major> indices,
+                   raft::device_matrix_view<distance_t, matrix_idx, row_major> distances,
+                   distance::DistanceType metric = distance::DistanceType::L2Unexpanded)
+{
+  matrix_idx n_candidates = neighbor_candidates.extent(1);
+  matrix_idx n_queries    = queries.extent(0);
+  matrix_idx dim          = dataset.extent(1);
+  uint32_t k              = static_cast<uint32_t>(indices.extent(1));
+
+  RAFT_EXPECTS(k <= raft::matrix::detail::select::warpsort::kMaxCapacity,
+               "k must be less than topk::kMaxCapacity (%d).",
+               raft::matrix::detail::select::warpsort::kMaxCapacity);
+
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "neighbors::refine(%zu, %u)", size_t(n_queries), uint32_t(n_candidates));
+
+  refine_check_input(dataset.extents(),
+                     queries.extents(),
+                     neighbor_candidates.extents(),
+                     indices.extents(),
+                     distances.extents(),
+                     metric);
+  if (n_queries == 0) { return; }
+
+  // The query of a block is cached in the shared memory, which is then reused by the merge of the
+  // top-k (that needs a few KiB at most).
+  const auto& dev_props = resource::get_device_properties(handle);
+  if (Pow2<16>::roundUp(dim * sizeof(data_t)) > dev_props.sharedMemPerBlockOptin) {
+    return refine_device_ivf_flat(
+      handle, dataset, queries, neighbor_candidates, indices, distances, metric);
+  }
+
+  // The rows are loaded with the widest vectors dividing them, up to 16 bytes.
+  int veclen   = std::max<int>(1, 16 / sizeof(data_t));
+  auto row_ptr = reinterpret_cast<uintptr_t>(dataset.data_handle());
+  while (veclen > 1 && (dim % veclen != 0 || row_ptr % (veclen * sizeof(data_t)) != 0)) {
+    veclen /= 2;
+  }
+  select_refine_kernel<data_t, idx_t, distance_t>::run(k,
+                                                       veclen,
+                                                       raft::distance::is_min_close(metric),
+                                                       handle,
+                                                       metric,
+                                                       dataset.data_handle(),
+                                                       idx_t(dataset.extent(0)),
+                                                       uint32_t(dim),
+                                                       queries.data_handle(),
+                                                       uint32_t(n_queries),
+                                                       neighbor_candidates.data_handle(),
+                                                       uint32_t(n_candidates),
+                                                       k,
+                                                       indices.data_handle(),
+                                                       distances.data_handle());
+}
+
 }  // namespace raft::neighbors::detail
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/host_thread_pool.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/refine_host.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::detail {
+
+/** The rows of a contiguous range are read in pieces of at most this size, to balance the I/O. */
+constexpr size_t kRefineFileMaxReadBytes = size_t{1} << 20;
+
+/**
+ * Read the given sorted, unique rows of a file dataset into a row-major matrix.
+ *
+ * The consecutive ids are merged into contiguous ranges, each read with a single `pread` (or a few,
+ * for the longest ones). The reads are issued by the host thread pool in parallel, which keeps
+ * several requests in flight on NVMe drives.
+ */
+template <typename FileDatasetT, typename IdxT>
+void read_file_rows(raft::resources const& res,
+                    const FileDatasetT& dataset,
+                    const std::vector<IdxT>& row_ids,
+                    typename FileDatasetT::value_type* out)
+{
+  const auto rows_per_read =
+    std::max<size_t>(1, kRefineFileMaxReadBytes / static_cast<size_t>(dataset.row_bytes()));
+  // (position in row_ids, number of rows) of every read
+  std::vector<std::pair<size_t, size_t>> reads;
+  for (size_t i = 0; i < row_ids.size();) {
+    size_t n = 1;
+    while (i + n < row_ids.size() && n < rows_per_read && row_ids[i + n] == row_ids[i] + IdxT(n)) {
+      n++;
+    }
+    reads.emplace_back(i, n);
+    i += n;
+  }
+
+  const auto dim = static_cast<size_t>(dataset.dim());
+  resource::get_host_thread_pool(res).parallel_for(0, reads.size(), [&](int64_t r) {
+    const auto [pos, n] = reads[r];
+    dataset.read_rows(row_ids[pos], n, out + pos * dim);
+  });
+}
+
+/**
+ * See raft::neighbors::refine for docs (the overload taking a file_dataset).
+ */
+template <typename IdxT,
+          typename DataT,
+          typename DistanceT,
+          typename ExtentsT,
+          typename FileDatasetT>
+void refine_file(raft::resources const& res,
+                 const FileDatasetT& dataset,
+                 raft::host_matrix_view<const DataT, ExtentsT, row_major> queries,
+                 raft::host_matrix_view<const IdxT, ExtentsT, row_major> neighbor_candidates,
+                 raft::host_matrix_view<IdxT, ExtentsT, row_major> indices,
+                 raft::host_matrix_view<DistanceT, ExtentsT, row_major> distances,
+                 distance::DistanceType metric,
+                 size_t max_batch_bytes)
+{
+  const auto n_queries    = static_cast<size_t>(queries.extent(0));
+  const auto n_candidates = static_cast<size_t>(neighbor_candidates.extent(1));
+  const auto n_rows       = static_cast<size_t>(dataset.n_rows());
+  const auto dim          = static_cast<size_t>(dataset.dim());
+  const auto k            = static_cast<size_t>(indices.extent(1));
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "neighbors::refine_file(%zu, %zu -> %zu)", n_queries, n_candidates, k);
+  RAFT_EXPECTS(static_cast<size_t>(queries.extent(1)) == dim,
+               "Number of columns must be equal for dataset and queries");
+
+  // The batch is sized for the worst case of all its candidates being distinct
+  const size_t batch_size = std::clamp<size_t>(
+    max_batch_bytes / std::max<size_t>(1, n_candidates * dataset.row_bytes()), 1, n_queries);
+
+  std::vector<IdxT> row_ids;
+  std::vector<IdxT> local_candidates;
+  for (size_t offset = 0; offset < n_queries; offset += batch_size) {
+    const size_t batch   = std::min(batch_size, n_queries - offset);
+    const IdxT* cand_ptr = neighbor_candidates.data_handle() + offset * n_candidates;
+
+    // The rows needed by the batch, sorted, so that the file is read in order
+    row_ids.clear();
+    for (size_t i = 0; i < batch * n_candidates; i++) {
+      if (static_cast<size_t>(cand_ptr[i]) < n_rows) { row_ids.push_back(cand_ptr[i]); }
+    }
+    std::sort(row_ids.begin(), row_ids.end());
+    row_ids.erase(std::unique(row_ids.begin(), row_ids.end()), row_ids.end());
+
+    auto rows = raft::make_host_matrix<DataT, ExtentsT>(static_cast<ExtentsT>(row_ids.size()),
+                                                        static_cast<ExtentsT>(dim));
+    read_file_rows(res, dataset, row_ids, rows.data_handle());
+
+    // The candidates as positions in the rows read; the invalid ids stay out of range
+    local_candidates.resize(batch * n_candidates);
+    resource::get_host_thread_pool(res).parallel_for(
+      0,
+      batch * n_candidates,
+      [&](int64_t i) {
+        const IdxT id = cand_ptr[i];
+        if (static_cast<size_t>(id) < n_rows) {
+          local_candidates[i] =
+            IdxT(std::lower_bound(row_ids.begin(), row_ids.end(), id) - row_ids.begin());
+        } else {
+          local_candidates[i] = id;
+        }
+      },
+      n_candidates);
+
+    auto batch_indices = raft::make_host_matrix_view<IdxT, ExtentsT>(
+      indices.data_handle() + offset * k, static_cast<ExtentsT>(batch), static_cast<ExtentsT>(k));
+    auto batch_distances = raft::make_host_matrix_view<DistanceT, ExtentsT>(
+      distances.data_handle() + offset * k, static_cast<ExtentsT>(batch), static_cast<ExtentsT>(k));
+    refine_host<IdxT, DataT, DistanceT, ExtentsT>(
+      res,
+      raft::make_const_mdspan(rows.view()),
+      raft::make_host_matrix_view<const DataT, ExtentsT>(queries.data_handle() + offset * dim,
+                                                         static_cast<ExtentsT>(batch),
+                                                         static_cast<ExtentsT>(dim)),
+      raft::make_host_matrix_view<const IdxT, ExtentsT>(local_candidates.data(),
+                                                        static_cast<ExtentsT>(batch),
+                                                        static_cast<ExtentsT>(n_candidates)),
+      batch_indices,
+      batch_distances,
+      metric);
+
+    // Back to the ids of the dataset
+    for (size_t i = 0; i < batch * k; i++) {
+      auto& id = batch_indices.data_handle()[i];
+      if (static_cast<size_t>(id) < row_ids.size()) { id = row_ids[id]; }
+    }
+  }
+}
+
+}  // namespace raft::neighbors::detail
@@ -18,6 +18,7 @@
 
 #include <raft/core/detail/macros.hpp>       // _RAFT_HAS_CUDA
 #include <raft/core/host_mdspan.hpp>         // raft::host_matrix_view
+#include <raft/core/resources.hpp>           // raft::resources
 #include <raft/distance/distance_types.hpp>  // raft::distance::DistanceType
 #include <raft/util/raft_explicit.hpp>       // RAFT_EXPLICIT
 
@@ -33,6 +34,7 @@ namespace raft::neighbors::detail {
 
 template <typename IdxT, typename DataT, typename DistanceT, typename ExtentsT>
 [[gnu::optimize(3), gnu::optimize("tree-vectorize")]] void refine_host(
+  raft::resources const& res,
   raft::host_matrix_view<const DataT, ExtentsT, row_major> dataset,
   raft::host_matrix_view<const DataT, ExtentsT, row_major> queries,
   raft::host_matrix_view<const IdxT, ExtentsT, row_major> neighbor_candidates,
@@ -46,6 +48,7 @@ template <typename IdxT, typename DataT, typename DistanceT, typename ExtentsT>
 
 #define instantiate_raft_neighbors_refine(IdxT, DataT, DistanceT, ExtentsT)                    \
   extern template void raft::neighbors::detail::refine_host<IdxT, DataT, DistanceT, ExtentsT>( \
+    raft::resources const& res,                                                                \
     raft::host_matrix_view<const DataT, ExtentsT, row_major> dataset,                          \
     raft::host_matrix_view<const DataT, ExtentsT, row_major> queries,                          \
     raft::host_matrix_view<const IdxT, ExtentsT, row_major> neighbor_candidates,               \
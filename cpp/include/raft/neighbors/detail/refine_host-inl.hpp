@@ -18,17 +18,141 @@
 
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/nvtx.hpp>
+#include <raft/core/resource/host_thread_pool.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/neighbors/detail/refine_common.hpp>
 #include <raft/util/integer_utils.hpp>
 
-#include <omp.h>
-
 #include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <vector>
 
 namespace raft::neighbors::detail {
 
+struct distance_comp_l2 {
+  template <typename DistanceT>
+  static inline auto eval(const DistanceT& a, const DistanceT& b) -> DistanceT
+  {
+    auto d = a - b;
+    return d * d;
+  }
+  template <typename DistanceT>
+  static inline auto postprocess(const DistanceT& a) -> DistanceT
+  {
+    return a;
+  }
+};
+
+struct distance_comp_inner {
+  template <typename DistanceT>
+  static inline auto eval(const DistanceT& a, const DistanceT& b) -> DistanceT
+  {
+    return -a * b;
+  }
+  template <typename DistanceT>
+  static inline auto postprocess(const DistanceT& a) -> DistanceT
+  {
+    return -a;
+  }
+};
+
+/**
+ * The number of independent partial sums of a distance: one AVX-512 register of floats, two AVX2
+ * registers, or four NEON registers.
+ */
+constexpr size_t kRefineHostLanes = 16;
+/** The number of candidates whose rows are prefetched ahead of the distance computation. */
+constexpr size_t kRefineHostPrefetchDistance = 2;
+constexpr size_t kRefineHostCacheLineSize    = 64;
+
+/**
+ * The distance between two rows.
+ *
+ * The partial sums are independent, hence the compiler vectorizes the loop for the target of the
+ * caller without having to reorder the floating-point additions.
+ */
+template <typename DC, typename DistanceT, typename DataT>
+[[gnu::always_inline]] inline auto refine_host_distance(const DataT* a, const DataT* b, size_t dim)
+  -> DistanceT
+{
+  DistanceT acc[kRefineHostLanes] = {};
+  size_t i                        = 0;
+  for (; i + kRefineHostLanes <= dim; i += kRefineHostLanes) {
+    for (size_t l = 0; l < kRefineHostLanes; l++) {
+      acc[l] += DC::template eval<DistanceT>(a[i + l], b[i + l]);
+    }
+  }
+  for (; i < dim; i++) {
+    acc[i % kRefineHostLanes] += DC::template eval<DistanceT>(a[i], b[i]);
+  }
+  DistanceT distance = 0;
+  for (size_t l = 0; l < kRefineHostLanes; l++) {
+    distance += acc[l];
+  }
+  return distance;
+}
+
+template <typename DC, typename DistanceT, typename DataT>
+[[gnu::optimize(3), gnu::optimize("tree-vectorize")]] auto refine_host_distance_default(
+  const DataT* a, const DataT* b, size_t dim) -> DistanceT
+{
+  return refine_host_distance<DC, DistanceT>(a, b, dim);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+template <typename DC, typename DistanceT, typename DataT>
+[[gnu::target("avx2,fma"), gnu::optimize(3), gnu::optimize("tree-vectorize")]] auto
+refine_host_distance_avx2(const DataT* a, const DataT* b, size_t dim) -> DistanceT
+{
+  return refine_host_distance<DC, DistanceT>(a, b, dim);
+}
+
+template <typename DC, typename DistanceT, typename DataT>
+[[gnu::target("avx512f,avx512bw,avx512vl,avx512dq"),
+  gnu::optimize(3),
+  gnu::optimize("tree-vectorize")]] auto
+refine_host_distance_avx512(const DataT* a, const DataT* b, size_t dim) -> DistanceT
+{
+  return refine_host_distance<DC, DistanceT>(a, b, dim);
+}
+#endif
+
+/**
+ * Select the widest vector instructions supported by the CPU for the distance computation.
+ *
+ * On x86-64, the AVX-512 and AVX2 versions are chosen at runtime. On aarch64, NEON is part of the
+ * base instruction set, hence the default version is already vectorized with it.
+ */
+template <typename DC, typename DistanceT, typename DataT>
+auto select_refine_host_distance() -> DistanceT (*)(const DataT*, const DataT*, size_t)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq")) {
+    return &refine_host_distance_avx512<DC, DistanceT, DataT>;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return &refine_host_distance_avx2<DC, DistanceT, DataT>;
+  }
+#endif
+  return &refine_host_distance_default<DC, DistanceT, DataT>;
+}
+
+/** Bring a row of the dataset into the cache ahead of its use. */
+template <typename DataT>
+inline void prefetch_row(const DataT* row, size_t dim)
+{
+  const auto* bytes = reinterpret_cast<const char*>(row);
+  for (size_t offset = 0; offset < dim * sizeof(DataT); offset += kRefineHostCacheLineSize) {
+    __builtin_prefetch(bytes + offset, 0, 3);
+  }
+}
+
 template <typename DC, typename IdxT, typename DataT, typename DistanceT, typename ExtentsT>
 [[gnu::optimize(3), gnu::optimize("tree-vectorize")]] void refine_host_impl(
+  raft::resources const& res,
   raft::host_matrix_view<const DataT, ExtentsT, row_major> dataset,
   raft::host_matrix_view<const DataT, ExtentsT, row_major> queries,
   raft::host_matrix_view<const IdxT, ExtentsT, row_major> neighbor_candidates,
@@ -44,48 +168,89 @@ template <typename DC, typename IdxT, typename DataT, typename DistanceT, typena
   common::nvtx::range<common::nvtx::domain::raft> fun_scope(
     "neighbors::refine_host(%zu, %zu -> %zu)", n_queries, orig_k, refined_k);
 
-  auto suggested_n_threads = std::max(1, std::min(omp_get_num_procs(), omp_get_max_threads()));
+  auto& pool        = resource::get_host_thread_pool(res);
+  auto distance_fn  = select_refine_host_distance<DC, DistanceT, DataT>();
+  auto refine_query = [&](size_t i, std::vector<std::tuple<DistanceT, IdxT>>& topk) {
+    // The running top-k of the query: a max-heap of refined_k pairs, so that a candidate is
+    // compared with the worst of them only.
+    const DataT* query = queries.data_handle() + dim * i;
+    topk.clear();
+    for (size_t j = 0; j < std::min(kRefineHostPrefetchDistance, orig_k); j++) {
+      if (static_cast<size_t>(neighbor_candidates(i, j)) < n_rows) {
+        prefetch_row(dataset.data_handle() + dim * neighbor_candidates(i, j), dim);
+      }
+    }
+    for (size_t j = 0; j < orig_k; j++) {
+      const size_t next = j + kRefineHostPrefetchDistance;
+      if (next < orig_k && static_cast<size_t>(neighbor_candidates(i, next)) < n_rows) {
+        prefetch_row(dataset.data_handle() + dim * neighbor_candidates(i, next), dim);
+      }
+      IdxT id            = neighbor_candidates(i, j);
+      DistanceT distance = 0.0;
+      if (static_cast<size_t>(id) >= n_rows) {
+        distance = std::numeric_limits<DistanceT>::max();
+      } else {
+        distance = distance_fn(query, dataset.data_handle() + dim * id, dim);
+      }
+      auto pair = std::make_tuple(distance, id);
+      if (topk.size() < refined_k) {
+        topk.push_back(pair);
+        std::push_heap(topk.begin(), topk.end());
+      } else if (pair < topk.front()) {
+        std::pop_heap(topk.begin(), topk.end());
+        topk.back() = pair;
+        std::push_heap(topk.begin(), topk.end());
+      }
+    }
+    // Sort the query neighbors by their refined distances
+    std::sort_heap(topk.begin(), topk.end());
+    // Store first refined_k neighbors
+    for (size_t j = 0; j < refined_k; j++) {
+      indices(i, j) = std::get<1>(topk[j]);
+      if (distances.data_handle() != nullptr) {
+        distances(i, j) = DC::template postprocess(std::get<0>(topk[j]));
+      }
+    }
+  };
 
   // If the number of queries is small, separate the distance calculation and
   // the top-k calculation into separate loops, and apply finer-grained thread
   // parallelism to the distance calculation loop.
-  if (n_queries < size_t(suggested_n_threads)) {
+  if (n_queries < pool.n_threads()) {
     std::vector<std::vector<std::tuple<DistanceT, IdxT>>> refined_pairs(
       n_queries, std::vector<std::tuple<DistanceT, IdxT>>(orig_k));
 
     // For efficiency, each thread should read a certain amount of array
-    // elements. The number of threads for distance computation is determined
-    // taking this into account.
-    auto n_elements    = std::max(size_t(512), dim);
-    auto max_n_threads = raft::div_rounding_up_safe<size_t>(n_queries * orig_k * dim, n_elements);
-    auto suggested_n_threads_for_distance = std::min(size_t(suggested_n_threads), max_n_threads);
-
-    // The max number of threads for topk computation is the number of queries.
-    auto suggested_n_threads_for_topk = std::min(size_t(suggested_n_threads), n_queries);
+    // elements. The chunks of the distance computation are sized taking this into account.
+    auto n_elements = std::max(size_t(512), dim);
+    auto grain      = raft::div_rounding_up_safe<size_t>(n_elements, std::max<size_t>(dim, 1));
 
     // Compute the refined distance using original dataset vectors
-#pragma omp parallel for collapse(2) num_threads(suggested_n_threads_for_distance)
-    for (size_t i = 0; i < n_queries; i++) {
-      for (size_t j = 0; j < orig_k; j++) {
+    pool.parallel_for(
+      0,
+      n_queries * orig_k,
+      [&](int64_t ij) {
+        const size_t i     = ij / orig_k;
+        const size_t j     = ij % orig_k;
         const DataT* query = queries.data_handle() + dim * i;
         IdxT id            = neighbor_candidates(i, j);
         DistanceT distance = 0.0;
+        if (j + 1 < orig_k && static_cast<size_t>(neighbor_candidates(i, j + 1)) < n_rows) {
+          prefetch_row(dataset.data_handle() + dim * neighbor_candidates(i, j + 1), dim);
+        }
         if (static_cast<size_t>(id) >= n_rows) {
           distance = std::numeric_limits<DistanceT>::max();
         } else {
-          const DataT* row = dataset.data_handle() + dim * id;
-          for (size_t k = 0; k < dim; k++) {
-            distance += DC::template eval<DistanceT>(query[k], row[k]);
-          }
+          distance = distance_fn(query, dataset.data_handle() + dim * id, dim);
         }
         refined_pairs[i][j] = std::make_tuple(distance, id);
-      }
-    }
+      },
+      grain);
 
     // Sort the query neighbors by their refined distances
-#pragma omp parallel for num_threads(suggested_n_threads_for_topk)
-    for (size_t i = 0; i < n_queries; i++) {
-      std::sort(refined_pairs[i].begin(), refined_pairs[i].end());
+    pool.parallel_for(0, n_queries, [&](int64_t i) {
+      std::partial_sort(
+        refined_pairs[i].begin(), refined_pairs[i].begin() + refined_k, refined_pairs[i].end());
       // Store first refined_k neighbors
       for (size_t j = 0; j < refined_k; j++) {
         indices(i, j) = std::get<1>(refined_pairs[i][j]);
@@ -93,71 +258,19 @@ template <typename DC, typename IdxT, typename DataT, typename DistanceT, typena
           distances(i, j) = DC::template postprocess(std::get<0>(refined_pairs[i][j]));
         }
       }
-    }
+    });
     return;
   }
 
-  if (size_t(suggested_n_threads) > n_queries) { suggested_n_threads = n_queries; }
-
-#pragma omp parallel num_threads(suggested_n_threads)
-  {
-    std::vector<std::tuple<DistanceT, IdxT>> refined_pairs(orig_k);
-    for (size_t i = omp_get_thread_num(); i < n_queries; i += omp_get_num_threads()) {
-      // Compute the refined distance using original dataset vectors
-      const DataT* query = queries.data_handle() + dim * i;
-      for (size_t j = 0; j < orig_k; j++) {
-        IdxT id            = neighbor_candidates(i, j);
-        DistanceT distance = 0.0;
-        if (static_cast<size_t>(id) >= n_rows) {
-          distance = std::numeric_limits<DistanceT>::max();
-        } else {
-          const DataT* row = dataset.data_handle() + dim * id;
-          for (size_t k = 0; k < dim; k++) {
-            distance += DC::template eval<DistanceT>(query[k], row[k]);
-          }
-        }
-        refined_pairs[j] = std::make_tuple(distance, id);
-      }
-      // Sort the query neighbors by their refined distances
-      std::sort(refined_pairs.begin(), refined_pairs.end());
-      // Store first refined_k neighbors
-      for (size_t j = 0; j < refined_k; j++) {
-        indices(i, j) = std::get<1>(refined_pairs[j]);
-        if (distances.data_handle() != nullptr) {
-          distances(i, j) = DC::template postprocess(std::get<0>(refined_pairs[j]));
-        }
-      }
+  pool.parallel_for_chunks(0, n_queries, [&](int64_t begin, int64_t end, size_t) {
+    std::vector<std::tuple<DistanceT, IdxT>> topk;
+    topk.reserve(refined_k);
+    for (int64_t i = begin; i < end; i++) {
+      refine_query(i, topk);
     }
-  }
+  });
 }
 
-struct distance_comp_l2 {
-  template <typename DistanceT>
-  static inline auto eval(const DistanceT& a, const DistanceT& b) -> DistanceT
-  {
-    auto d = a - b;
-    return d * d;
-  }
-  template <typename DistanceT>
-  static inline auto postprocess(const DistanceT& a) -> DistanceT
-  {
-    return a;
-  }
-};
-
-struct distance_comp_inner {
-  template <typename DistanceT>
-  static inline auto eval(const DistanceT& a, const DistanceT& b) -> DistanceT
-  {
-    return -a * b;
-  }
-  template <typename DistanceT>
-  static inline auto postprocess(const DistanceT& a) -> DistanceT
-  {
-    return -a;
-  }
-};
-
 /**
  * Naive CPU implementation of refine operation
  *
@@ -165,6 +278,7 @@ struct distance_comp_inner {
  */
 template <typename IdxT, typename DataT, typename DistanceT, typename ExtentsT>
 [[gnu::optimize(3), gnu::optimize("tree-vectorize")]] void refine_host(
+  raft::resources const& res,
   raft::host_matrix_view<const DataT, ExtentsT, row_major> dataset,
   raft::host_matrix_view<const DataT, ExtentsT, row_major> queries,
   raft::host_matrix_view<const IdxT, ExtentsT, row_major> neighbor_candidates,
@@ -182,10 +296,10 @@ template <typename IdxT, typename DataT, typename DistanceT, typename ExtentsT>
   switch (metric) {
     case raft::distance::DistanceType::L2Expanded:
       return refine_host_impl<distance_comp_l2>(
-        dataset, queries, neighbor_candidates, indices, distances);
+        res, dataset, queries, neighbor_candidates, indices, distances);
     case raft::distance::DistanceType::InnerProduct:
       return refine_host_impl<distance_comp_inner>(
-        dataset, queries, neighbor_candidates, indices, distances);
+        res, dataset, queries, neighbor_candidates, indices, distances);
     default: throw raft::logic_error("Unsupported metric");
   }
 }
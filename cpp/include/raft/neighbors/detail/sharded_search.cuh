@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_setter.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/neighbors/detail/knn_merge_parts.cuh>
+#include <raft/neighbors/detail/multi_device.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace raft::neighbors::detail {
+
+/**
+ * Search the queries in all the shards of a multi-GPU index and merge the top-k of the shards.
+ *
+ * The shard `i` lives on the device `device_ids[i]` and is searched by a host thread of its own
+ * with the resources `shard_res(i)`, as `search(shard_res(i), i, queries, neighbors, distances)`
+ * with device matrix views ([n, dim], [n, k] and [n, k]) on that device, writing the results on the
+ * stream of the resources. The shards search the queries by batches of at most `n_rows_per_batch`
+ * rows, whose top-k are gathered on the device of `res`:
+ *   - with `use_comms`, with the collectives of the communicators of the resources: `res` is then
+ *     the root rank of the communicator (e.g. of a NCCL clique), whose rank `i` is the shard `i`,
+ *     and `shard_res(i)` is called on the calling thread as well;
+ *   - otherwise, with (peer) copies issued by the threads of the shards; `shard_res(i)` is only
+ *     called on the thread of the shard (e.g. to get the thread's resources from the
+ *     `device_resources_manager`).
+ * The top-k of the shards are merged with `knn_merge_parts`, keeping the smallest or the largest
+ * distances as per `select_min` and adding the `id_offsets` of the shards (if any) to their ids.
+ *
+ * The queries and the outputs may be in the host memory or in the memory of the device of `res`,
+ * which must be the current device.
+ */
+template <typename T, typename ShardIdxT, typename IdxT, typename ShardResF, typename SearchF>
+void search_shards(raft::resources const& res,
+                   const std::vector<int>& device_ids,
+                   ShardResF&& shard_res,
+                   SearchF&& search,
+                   const T* queries,
+                   int64_t n_queries,
+                   int64_t dim,
+                   int64_t k,
+                   IdxT* neighbors,
+                   float* distances,
+                   int64_t n_rows_per_batch,
+                   const std::optional<std::vector<IdxT>>& id_offsets,
+                   bool select_min,
+                   bool use_comms)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "neighbors::search_shards(%zu, %zu)", size_t(n_queries), device_ids.size());
+  const int n_shards = device_ids.size();
+  RAFT_EXPECTS(n_shards > 0, "At least one shard is needed");
+  RAFT_EXPECTS(!id_offsets.has_value() || id_offsets->size() == device_ids.size(),
+               "There must be one id offset per shard");
+  RAFT_EXPECTS(n_rows_per_batch > 0, "n_rows_per_batch must be positive");
+  const int root = use_comms ? resource::get_comms(res).get_rank() : 0;
+  if (use_comms) {
+    RAFT_EXPECTS(resource::get_comms(res).get_size() == n_shards,
+                 "There must be one shard per rank of the communicator");
+    RAFT_EXPECTS(&shard_res(root) == &res, "res must be the resources of the root rank");
+  }
+  if (n_queries == 0) { return; }
+  const int64_t batch_size = std::min(n_rows_per_batch, n_queries);
+  auto stream              = resource::get_cuda_stream(res);
+
+  // The results of all the shards gathered on the device of `res` [n_shards, merge_rows, k]: the
+  // collectives gather and merge every batch in turn, the copies all the batches at once.
+  constexpr bool kSameIds  = std::is_same_v<ShardIdxT, IdxT>;
+  const int64_t merge_rows = use_comms ? batch_size : n_queries;
+  auto all_neighbors = raft::make_device_matrix<ShardIdxT, int64_t>(res, n_shards * merge_rows, k);
+  auto all_distances = raft::make_device_matrix<float, int64_t>(res, n_shards * merge_rows, k);
+  auto all_ids =
+    raft::make_device_matrix<IdxT, int64_t>(res, kSameIds ? 0 : n_shards * merge_rows, k);
+  auto out_neighbors = raft::make_device_matrix<IdxT, int64_t>(res, merge_rows, k);
+  auto out_distances = raft::make_device_matrix<float, int64_t>(res, merge_rows, k);
+  auto translations  = raft::make_device_vector<IdxT, int64_t>(res, id_offsets ? n_shards : 0);
+  if (id_offsets) { raft::copy(translations.data_handle(), id_offsets->data(), n_shards, stream); }
+  // The queries must be ready before the shards start copying them.
+  resource::sync_stream(res);
+
+  // Merge the gathered top-k of the rows [offset, offset + n) into the outputs.
+  auto merge = [&](int64_t offset, int64_t n) {
+    const IdxT* ids = nullptr;
+    if constexpr (kSameIds) {
+      ids = all_neighbors.data_handle();
+    } else {
+      raft::linalg::unaryOp(all_ids.data_handle(),
+                            all_neighbors.data_handle(),
+                            n_shards * n * k,
+                            raft::cast_op<IdxT>{},
+                            stream);
+      ids = all_ids.data_handle();
+    }
+    knn_merge_parts<IdxT, float>(res,
+                                 all_distances.data_handle(),
+                                 ids,
+                                 out_distances.data_handle(),
+                                 out_neighbors.data_handle(),
+                                 size_t(n),
+                                 n_shards,
+                                 int(k),
+                                 id_offsets ? translations.data_handle() : nullptr,
+                                 select_min);
+    raft::copy(neighbors + offset * k, out_neighbors.data_handle(), n * k, stream);
+    raft::copy(distances + offset * k, out_distances.data_handle(), n * k, stream);
+    resource::sync_stream(res);
+  };
+
+  if (!use_comms) {
+    for_each_device(device_ids, [&](size_t i) {
+      const raft::resources& dev_res = shard_res(i);
+      auto dev_stream                = resource::get_cuda_stream(dev_res);
+      auto d_queries   = raft::make_device_matrix<T, int64_t>(dev_res, batch_size, dim);
+      auto d_neighbors = raft::make_device_matrix<ShardIdxT, int64_t>(dev_res, batch_size, k);
+      auto d_distances = raft::make_device_matrix<float, int64_t>(dev_res, batch_size, k);
+      for (int64_t offset = 0; offset < n_queries; offset += batch_size) {
+        const int64_t n = std::min(batch_size, n_queries - offset);
+        raft::copy(d_queries.data_handle(), queries + offset * dim, n * dim, dev_stream);
+        search(dev_res,
+               i,
+               raft::make_device_matrix_view<const T, int64_t>(d_queries.data_handle(), n, dim),
+               raft::make_device_matrix_view<ShardIdxT, int64_t>(d_neighbors.data_handle(), n, k),
+               raft::make_device_matrix_view<float, int64_t>(d_distances.data_handle(), n, k));
+        raft::copy(all_neighbors.data_handle() + (i * n_queries + offset) * k,
+                   d_neighbors.data_handle(),
+                   n * k,
+                   dev_stream);
+        raft::copy(all_distances.data_handle() + (i * n_queries + offset) * k,
+                   d_distances.data_handle(),
+                   n * k,
+                   dev_stream);
+      }
+      resource::sync_stream(dev_res);
+    });
+    merge(0, n_queries);
+    return;
+  }
+
+  // The per-rank buffers for a batch of queries and its results
+  std::vector<raft::device_matrix<T, int64_t>> d_queries;
+  std::vector<raft::device_matrix<ShardIdxT, int64_t>> d_neighbors;
+  std::vector<raft::device_matrix<float, int64_t>> d_distances;
+  for (int rank = 0; rank < n_shards; rank++) {
+    raft::device_setter dev(device_ids[rank]);
+    const raft::resources& dev_res = shard_res(rank);
+    d_queries.push_back(raft::make_device_matrix<T, int64_t>(dev_res, batch_size, dim));
+    d_neighbors.push_back(raft::make_device_matrix<ShardIdxT, int64_t>(dev_res, batch_size, k));
+    d_distances.push_back(raft::make_device_matrix<float, int64_t>(dev_res, batch_size, k));
+  }
+  // The NCCL calls for several devices from one thread must be grouped.
+  auto const& group_comm = resource::get_comms(res);
+
+  for (int64_t offset = 0; offset < n_queries; offset += batch_size) {
+    const int64_t n = std::min(batch_size, n_queries - offset);
+
+    // broadcast the batch of queries from the root to all the ranks
+    raft::copy(d_queries[root].data_handle(), queries + offset * dim, n * dim, stream);
+    group_comm.group_start();
+    for (int rank = 0; rank < n_shards; rank++) {
+      raft::device_setter dev(device_ids[rank]);
+      const raft::resources& dev_res = shard_res(rank);
+      resource::get_comms(dev_res).bcast(
+        d_queries[rank].data_handle(), n * dim, root, resource::get_cuda_stream(dev_res));
+    }
+    group_comm.group_end();
+
+    // search every shard, each device driven by its own thread
+    for_each_device(device_ids, [&](size_t rank) {
+      search(
+        shard_res(rank),
+        rank,
+        raft::make_device_matrix_view<const T, int64_t>(d_queries[rank].data_handle(), n, dim),
+        raft::make_device_matrix_view<ShardIdxT, int64_t>(d_neighbors[rank].data_handle(), n, k),
+        raft::make_device_matrix_view<float, int64_t>(d_distances[rank].data_handle(), n, k));
+    });
+
+    // gather the top-k of all the shards on the root, in the rank order
+    group_comm.group_start();
+    for (int rank = 0; rank < n_shards; rank++) {
+      raft::device_setter dev(device_ids[rank]);
+      const raft::resources& dev_res = shard_res(rank);
+      auto const& comms              = resource::get_comms(dev_res);
+      auto dev_stream                = resource::get_cuda_stream(dev_res);
+      comms.gather(
+        d_neighbors[rank].data_handle(), all_neighbors.data_handle(), n * k, root, dev_stream);
+      comms.gather(
+        d_distances[rank].data_handle(), all_distances.data_handle(), n * k, root, dev_stream);
+    }
+    group_comm.group_end();
+
+    merge(offset, n);
+  }
+}
+
+}  // namespace raft::neighbors::detail
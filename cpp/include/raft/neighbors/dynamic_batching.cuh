@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/pinned_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_id.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/cuda_stream.hpp>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::dynamic_batching {
+
+/**
+ * @defgroup dynamic_batching Dynamic batching of the concurrent small searches
+ * @{
+ */
+
+struct batcher_params {
+  /** The maximum number of queries searched at once. */
+  int64_t max_batch_size = 128;
+  /**
+   * How long the first query of a batch may wait for more queries (in milliseconds). A batch is
+   * searched once it is full or once this timeout expires, whichever is earlier.
+   */
+  double dispatch_timeout_ms = 1.0;
+};
+
+/**
+ * @brief Gather the small searches coming from many host threads into batches.
+ *
+ * The index searches (`cagra::search`, `ivf_pq::search`, `brute_force::search`, ...) are efficient
+ * only on batches of queries. The batcher accepts the queries of one or a few rows from any number
+ * of threads, stages them in a pinned host buffer and issues one upstream search per batch on a
+ * dedicated thread and CUDA stream. The results are copied back to the host outputs of every
+ * caller, whose futures are then fulfilled.
+ *
+ * There are two staging buffers: the callers fill one while the other one is being searched.
+ *
+ * `search_fn` wraps the upstream index; it is called as `search_fn(res, queries, neighbors,
+ * distances)` on the dispatcher thread, with device matrix views (`[n, dim]`, `[n, k]` and
+ * `[n, k]`, with `int64_t` extents) and must write to the outputs on the stream of `res`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = cagra::build<float, uint32_t>(res, index_params, dataset);
+ *   dynamic_batching::batcher<float, uint32_t> batcher(
+ *     res, dynamic_batching::batcher_params{}, index.dim(), k,
+ *     [&index, search_params](const raft::resources& res, auto q, auto n, auto d) {
+ *       cagra::search(res, search_params, index, q, n, d);
+ *     });
+ *   // On any thread:
+ *   batcher.search(query, neighbors, distances).get();
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @tparam DistT type of the distances
+ */
+template <typename T, typename IdxT, typename DistT = float>
+class batcher {
+ public:
+  using search_fn_type =
+    std::function<void(raft::resources const&,
+                       raft::device_matrix_view<const T, int64_t, raft::row_major>,
+                       raft::device_matrix_view<IdxT, int64_t, raft::row_major>,
+                       raft::device_matrix_view<DistT, int64_t, raft::row_major>)>;
+
+  /**
+   * @param[in] res raft resources; the batcher searches on a copy of it with its own stream
+   * @param[in] params configure the batching
+   * @param[in] dim the dimensionality of the queries
+   * @param[in] k the number of neighbors per query
+   * @param[in] search_fn the upstream search
+   */
+  batcher(raft::resources const& res,
+          const batcher_params& params,
+          int64_t dim,
+          int64_t k,
+          search_fn_type search_fn)
+    : params_(params),
+      dim_(dim),
+      k_(k),
+      search_fn_(std::move(search_fn)),
+      res_(res),
+      slots_{slot{res, params.max_batch_size, dim, k}, slot{res, params.max_batch_size, dim, k}},
+      queries_(raft::make_device_matrix<T, int64_t>(res, params.max_batch_size, dim)),
+      neighbors_(raft::make_device_matrix<IdxT, int64_t>(res, params.max_batch_size, k)),
+      distances_(raft::make_device_matrix<DistT, int64_t>(res, params.max_batch_size, k))
+  {
+    RAFT_EXPECTS(params.max_batch_size > 0, "max_batch_size must be positive");
+    RAFT_EXPECTS(params.dispatch_timeout_ms >= 0, "dispatch_timeout_ms must not be negative");
+    resource::set_cuda_stream(res_, stream_.view());
+    dispatcher_ = std::thread([this, dev_id = resource::get_device_id(res)]() {
+      RAFT_CUDA_TRY(cudaSetDevice(dev_id));
+      dispatch_loop();
+    });
+  }
+
+  batcher(const batcher&)                    = delete;
+  auto operator=(const batcher&) -> batcher& = delete;
+
+  /** Search the pending queries and stop the dispatcher thread. */
+  ~batcher() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_dispatch_.notify_one();
+    dispatcher_.join();
+  }
+
+  /**
+   * @brief Submit the queries for the search; safe to call from any number of threads.
+   *
+   * The queries are copied before the function returns. The outputs must stay alive until the
+   * returned future is ready; if the upstream search throws, the future rethrows the exception.
+   *
+   * @param[in] queries a host matrix view [n_queries, dim], `n_queries <= max_batch_size`
+   * @param[out] neighbors a host matrix view [n_queries, k]
+   * @param[out] distances a host matrix view [n_queries, k]
+   */
+  auto search(raft::host_matrix_view<const T, int64_t, raft::row_major> queries,
+              raft::host_matrix_view<IdxT, int64_t, raft::row_major> neighbors,
+              raft::host_matrix_view<DistT, int64_t, raft::row_major> distances)
+    -> std::future<void>
+  {
+    const int64_t n_queries = queries.extent(0);
+    RAFT_EXPECTS(n_queries <= params_.max_batch_size,
+                 "Too many queries for one request (%zu > max_batch_size = %zu)",
+                 size_t(n_queries),
+                 size_t(params_.max_batch_size));
+    RAFT_EXPECTS(queries.extent(1) == dim_, "Wrong dimensionality of the queries");
+    RAFT_EXPECTS(neighbors.extent(0) == n_queries && neighbors.extent(1) == k_,
+                 "Wrong shape of the neighbors");
+    RAFT_EXPECTS(distances.extent(0) == n_queries && distances.extent(1) == k_,
+                 "Wrong shape of the distances");
+
+    request r{0, n_queries, neighbors.data_handle(), distances.data_handle(), {}};
+    auto result = r.done.get_future();
+    if (n_queries == 0) {
+      r.done.set_value();
+      return result;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Wait until the batch being filled has room for the queries
+    while (slots_[filling_].size + n_queries > params_.max_batch_size) {
+      slots_[filling_].full = true;
+      cv_dispatch_.notify_one();
+      cv_filling_.wait(lock);
+    }
+    auto& s  = slots_[filling_];
+    r.offset = s.size;
+    std::memcpy(s.queries.data_handle() + s.size * dim_,
+                queries.data_handle(),
+                n_queries * dim_ * sizeof(T));
+    if (s.size == 0) {
+      s.deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                                    std::chrono::duration<double, std::milli>(
+                                      params_.dispatch_timeout_ms));
+    }
+    s.size += n_queries;
+    s.requests.push_back(std::move(r));
+    const bool notify = s.requests.size() == 1 || s.size == params_.max_batch_size;
+    lock.unlock();
+    if (notify) { cv_dispatch_.notify_one(); }
+    return result;
+  }
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  struct request {
+    int64_t offset;
+    int64_t n_queries;
+    IdxT* neighbors;
+    DistT* distances;
+    std::promise<void> done;
+  };
+
+  /** A batch staged in the pinned memory. */
+  struct slot {
+    raft::pinned_matrix<T, int64_t, raft::row_major> queries;
+    raft::pinned_matrix<IdxT, int64_t, raft::row_major> neighbors;
+    raft::pinned_matrix<DistT, int64_t, raft::row_major> distances;
+    std::vector<request> requests{};
+    int64_t size{0};
+    bool full{false};
+    clock::time_point deadline{};
+
+    slot(raft::resources const& res, int64_t max_batch_size, int64_t dim, int64_t k)
+      : queries(raft::make_pinned_matrix<T, int64_t>(res, max_batch_size, dim)),
+        neighbors(raft::make_pinned_matrix<IdxT, int64_t>(res, max_batch_size, k)),
+        distances(raft::make_pinned_matrix<DistT, int64_t>(res, max_batch_size, k))
+    {
+    }
+  };
+
+  void dispatch_loop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      auto& s = slots_[filling_];
+      if (s.size == 0) {
+        if (stop_) { return; }
+        cv_dispatch_.wait(lock);
+        continue;
+      }
+      if (!s.full && !stop_ && s.size < params_.max_batch_size && clock::now() < s.deadline) {
+        cv_dispatch_.wait_until(lock, s.deadline);
+        continue;
+      }
+      // The other slot has been searched already; the callers may fill it meanwhile.
+      filling_ ^= 1;
+      lock.unlock();
+      cv_filling_.notify_all();
+      run(s);
+      lock.lock();
+      s.requests.clear();
+      s.size = 0;
+      s.full = false;
+    }
+  }
+
+  void run(slot& s) noexcept
+  {
+    common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+      "dynamic_batching::batcher::run(%zu)", size_t(s.size));
+    try {
+      auto stream = resource::get_cuda_stream(res_);
+      raft::copy(queries_.data_handle(), s.queries.data_handle(), s.size * dim_, stream);
+      search_fn_(res_,
+                 raft::make_device_matrix_view<const T, int64_t>(
+                   queries_.data_handle(), s.size, dim_),
+                 raft::make_device_matrix_view<IdxT, int64_t>(neighbors_.data_handle(), s.size, k_),
+                 raft::make_device_matrix_view<DistT, int64_t>(
+                   distances_.data_handle(), s.size, k_));
+      raft::copy(s.neighbors.data_handle(), neighbors_.data_handle(), s.size * k_, stream);
+      raft::copy(s.distances.data_handle(), distances_.data_handle(), s.size * k_, stream);
+      resource::sync_stream(res_, stream);
+    } catch (...) {
+      for (auto& r : s.requests) {
+        r.done.set_exception(std::current_exception());
+      }
+      return;
+    }
+    for (auto& r : s.requests) {
+      std::memcpy(r.neighbors,
+                  s.neighbors.data_handle() + r.offset * k_,
+                  r.n_queries * k_ * sizeof(IdxT));
+      std::memcpy(r.distances,
+                  s.distances.data_handle() + r.offset * k_,
+                  r.n_queries * k_ * sizeof(DistT));
+      r.done.set_value();
+    }
+  }
+
+  batcher_params params_;
+  int64_t dim_;
+  int64_t k_;
+  search_fn_type search_fn_;
+
+  rmm::cuda_stream stream_;
+  raft::resources res_;
+
+  std::mutex mutex_;
+  // The dispatcher waits for the queries, the callers wait for the room in the batch
+  std::condition_variable cv_dispatch_;
+  std::condition_variable cv_filling_;
+  std::array<slot, 2> slots_;
+  int filling_{0};
+  bool stop_{false};
+
+  // Accessed by the dispatcher thread only
+  raft::device_matrix<T, int64_t, raft::row_major> queries_;
+  raft::device_matrix<IdxT, int64_t, raft::row_major> neighbors_;
+  raft::device_matrix<DistT, int64_t, raft::row_major> distances_;
+
+  std::thread dispatcher_;
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::dynamic_batching
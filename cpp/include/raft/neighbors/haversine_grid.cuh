@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/haversine_grid.cuh>
+#include <raft/neighbors/haversine_grid_types.hpp>
+
+#include <cstdint>
+
+namespace raft::neighbors::haversine_grid {
+
+/**
+ * @defgroup haversine_grid Approximate haversine kNN over a spherical grid
+ * @{
+ */
+
+/**
+ * @brief Build the spherical grid index of the (latitude, longitude) points.
+ *
+ * The points are assigned to their cells and sorted by the cells, so that the points of every cell
+ * form a contiguous list; the index keeps a copy of the points.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   haversine_grid::index_params index_params;
+ *   auto index = haversine_grid::build(handle, index_params, points);
+ *   haversine_grid::search(handle, haversine_grid::search_params{}, index, queries, neighbors,
+ *                          distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ *
+ * @param[in] res
+ * @param[in] params configure the grid
+ * @param[in] dataset a device matrix view to the (latitude, longitude) in radians [n_rows, 2]
+ *
+ * @return the constructed index
+ */
+template <typename T>
+auto build(raft::resources const& res,
+           const index_params& params,
+           raft::device_matrix_view<const T, int64_t, row_major> dataset) -> index<T>
+{
+  return detail::build<T>(res, params, dataset);
+}
+
+/**
+ * @brief Search the nearest neighbors of the queries by the haversine (great circle) distance.
+ *
+ * Every query is searched by a warp, which visits the cells around the query ring by ring: the
+ * ring `r` covers all points within `(r + 1) * idx.cell_size()` radians. The search of a query
+ * stops once its k-th neighbor is within the covered radius (the result is exact), or after
+ * `params.max_rings` rings. In the latter case, the missing neighbors (if fewer than `k` points
+ * have been visited) have the maximum distance and the index `std::numeric_limits<int64_t>::max()`.
+ *
+ * @tparam T data element type
+ *
+ * @param[in] res
+ * @param[in] params configure the search
+ * @param[in] idx the index
+ * @param[in] queries a device matrix view to the (latitude, longitude) in radians [n_queries, 2]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors [n_queries, k]
+ * @param[out] distances a device matrix view to the distances in radians [n_queries, k]
+ */
+template <typename T>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index<T>& idx,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+            raft::device_matrix_view<T, int64_t, row_major> distances)
+{
+  detail::search<T>(res, params, idx, queries, neighbors, distances);
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::haversine_grid
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ann_types.hpp"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resources.hpp>
+
+#include <cstdint>
+
+namespace raft::neighbors::haversine_grid {
+
+/**
+ * @addtogroup haversine_grid
+ * @{
+ */
+
+struct index_params : ann::index_params {
+  /**
+   * The side of a cell, in radians of the great circle (e.g. 1e-3 is about 6.4 km on the Earth).
+   * Zero means it is chosen so that an average cell holds `points_per_cell` points.
+   */
+  double cell_size = 0.0;
+  /** The average number of the points per cell targeted when `cell_size` is zero. */
+  uint32_t points_per_cell = 64;
+};
+
+struct search_params : ann::search_params {
+  /**
+   * The maximum number of the rings of cells visited around a query. The search of a query stops as
+   * soon as the visited cells contain all the points closer than its k-th neighbor (then the result
+   * is exact), or after this many rings (then the neighbors are the nearest of the visited points).
+   */
+  uint32_t max_rings = 8;
+};
+
+/**
+ * @brief An index of the points on the sphere partitioned into cells of a near-uniform area.
+ *
+ * The sphere is cut into `n_bands` latitude bands of the height `cell_size`; every band is split
+ * into cells along the longitude, fewer towards the poles, so that every cell is at most
+ * `cell_size` wide (a reduced lat/lon grid, similar in spirit to the S2 or H3 cells). The
+ * points are stored sorted by their cells, so the points of a cell are a contiguous list.
+ *
+ * The points are (latitude, longitude) pairs in radians, the same as in the brute-force haversine
+ * search; the distances are the central angles (in radians) between the points.
+ *
+ * @tparam T data element type
+ */
+template <typename T>
+struct index : ann::index {
+ public:
+  index(const index&)                    = delete;
+  index(index&&)                         = default;
+  auto operator=(const index&) -> index& = delete;
+  auto operator=(index&&) -> index&      = default;
+  ~index()                               = default;
+
+  /** Construct an index of `n_rows` points on the grid with the given bands. */
+  index(raft::resources const& res,
+        double cell_size,
+        uint32_t n_bands,
+        uint32_t n_cells,
+        int64_t n_rows)
+    : ann::index(),
+      cell_size_(cell_size),
+      band_offsets_(raft::make_device_vector<uint32_t, uint32_t>(res, n_bands + 1)),
+      cell_offsets_(raft::make_device_vector<int64_t, uint32_t>(res, n_cells + 1)),
+      points_(raft::make_device_matrix<T, int64_t>(res, n_rows, 2)),
+      indices_(raft::make_device_vector<int64_t, int64_t>(res, n_rows))
+  {
+  }
+
+  /** The height of a latitude band (and the maximum width of a cell) in radians. */
+  [[nodiscard]] constexpr inline auto cell_size() const noexcept -> double { return cell_size_; }
+  /** The number of the latitude bands. */
+  [[nodiscard]] inline auto n_bands() const noexcept -> uint32_t
+  {
+    return band_offsets_.extent(0) - 1;
+  }
+  /** The total number of the cells. */
+  [[nodiscard]] inline auto n_cells() const noexcept -> uint32_t
+  {
+    return cell_offsets_.extent(0) - 1;
+  }
+  /** Total length of the index (number of points). */
+  [[nodiscard]] inline auto size() const noexcept -> int64_t { return points_.extent(0); }
+
+  /** The id of the first cell of every band, and the total number of the cells [n_bands + 1]. */
+  inline auto band_offsets() noexcept -> device_vector_view<uint32_t, uint32_t>
+  {
+    return band_offsets_.view();
+  }
+  [[nodiscard]] inline auto band_offsets() const noexcept
+    -> device_vector_view<const uint32_t, uint32_t>
+  {
+    return band_offsets_.view();
+  }
+
+  /** The position of the first point of every cell, and the number of the points [n_cells + 1]. */
+  inline auto cell_offsets() noexcept -> device_vector_view<int64_t, uint32_t>
+  {
+    return cell_offsets_.view();
+  }
+  [[nodiscard]] inline auto cell_offsets() const noexcept
+    -> device_vector_view<const int64_t, uint32_t>
+  {
+    return cell_offsets_.view();
+  }
+
+  /** The (latitude, longitude) of the points sorted by their cells [size, 2]. */
+  inline auto points() noexcept -> device_matrix_view<T, int64_t, row_major>
+  {
+    return points_.view();
+  }
+  [[nodiscard]] inline auto points() const noexcept
+    -> device_matrix_view<const T, int64_t, row_major>
+  {
+    return points_.view();
+  }
+
+  /** The ids of the points in the source dataset, in the order of `points()` [size]. */
+  inline auto indices() noexcept -> device_vector_view<int64_t, int64_t>
+  {
+    return indices_.view();
+  }
+  [[nodiscard]] inline auto indices() const noexcept -> device_vector_view<const int64_t, int64_t>
+  {
+    return indices_.view();
+  }
+
+ private:
+  double cell_size_;
+  raft::device_vector<uint32_t, uint32_t> band_offsets_;
+  raft::device_vector<int64_t, uint32_t> cell_offsets_;
+  raft::device_matrix<T, int64_t, row_major> points_;
+  raft::device_vector<int64_t, int64_t> indices_;
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::haversine_grid
@@ -22,6 +22,7 @@
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/neighbors/cagra_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
 
 #include <cstddef>
 #include <cstdint>
@@ -34,10 +35,15 @@ namespace raft::neighbors::hnsw {
  */
 
 /**
- * @brief Construct an hnswlib base-layer-only index from a CAGRA index
- * NOTE: 1. This method uses the filesystem to write the CAGRA index in `/tmp/<random_number>.bin`
- * before reading it as an hnswlib index, then deleting the temporary file.
- *       2. This function is only offered as a compiled symbol in `libraft.so`
+ * @brief Construct an hnswlib index from a CAGRA index
+ *
+ * The CAGRA graph becomes the base layer of the hnswlib index; the upper layers are built on the
+ * GPU (see `cagra::serialize_to_hnswlib`), so that the CPU search starts from a good entry point.
+ *
+ * The hnswlib index is constructed in memory, without going through the filesystem: the rows of the
+ * graph and of the dataset are copied from the device in chunks, straight into the hnswlib index.
+ *
+ * NOTE: This function is only offered as a compiled symbol in `libraft.so`
  *
  * @tparam T data element type
  * @tparam IdxT type of the indices
@@ -54,7 +60,7 @@ namespace raft::neighbors::hnsw {
  *   // create and fill the index from a [N, D] dataset
  *   auto index = cagra::build(res, index_params, dataset);
  *
- *   // Load CAGRA index as base-layer-only hnswlib index
+ *   // Load CAGRA index as hnswlib index
  *   auto hnsw_index = hnsw::from_cagra(res, index);
  * @endcode
  */
@@ -75,7 +81,7 @@ std::unique_ptr<index<uint8_t>> from_cagra(
   raft::resources const& res, raft::neighbors::cagra::index<uint8_t, uint32_t> cagra_index);
 
 /**
- * @brief Search hnswlib base-layer-only index constructed from a CAGRA index
+ * @brief Search hnswlib index constructed from a CAGRA index
  *
  * @tparam T data element type
  * @tparam IdxT type of the indices
@@ -98,10 +104,10 @@ std::unique_ptr<index<uint8_t>> from_cagra(
  *   // create and fill the index from a [N, D] dataset
  *   auto index = cagra::build(res, index_params, dataset);
  *
- *   // Save CAGRA index as base layer only hnswlib index
+ *   // Save CAGRA index as hnswlib index
  *   hnsw::serialize(res, "my_index.bin", index);
  *
- *   // Load CAGRA index as base layer only hnswlib index
+ *   // Load CAGRA index as hnswlib index
  *   raft::neighbors::hnsw::index* hnsw_index;
  *   auto hnsw_index = hnsw::deserialize(res, "my_index.bin", D, raft::distance::L2Expanded);
  *
@@ -110,6 +116,8 @@ std::unique_ptr<index<uint8_t>> from_cagra(
  *   hnsw::search_params search_params;
  *   search_params.ef = 50 // ef >= K;
  *   search_params.num_threads = 10;
+ *   // on multi-socket hosts, search a copy of the index local to the socket of every thread
+ *   search_params.numa_aware = true;
  *   auto neighbors = raft::make_host_matrix<uint32_t>(res, n_queries, k);
  *   auto distances = raft::make_host_matrix<float>(res, n_queries, k);
  *   hnsw::search(res, search_params, *index, queries, neighbors, distances);
@@ -134,7 +142,72 @@ void search(raft::resources const& res,
   RAFT_EXPECTS(queries.extent(1) == idx.dim(),
                "Number of query dimensions should equal number of dimensions in the index.");
 
-  detail::search(res, params, idx, queries, neighbors, distances);
+  detail::search(res,
+                 params,
+                 idx,
+                 queries,
+                 neighbors,
+                 distances,
+                 raft::neighbors::filtering::none_cagra_sample_filter());
+}
+
+/**
+ * @brief Search hnswlib index constructed from a CAGRA index, keeping only the samples that pass
+ * the filter
+ *
+ * The filter is called on the host as `filter(query_ix, sample_ix)`, where `sample_ix` is the
+ * index of a sample in the dataset of the CAGRA index, as for `cagra::search_with_filtering`. For
+ * example, `filtering::bitset_filter` can be used with a bitset view of host memory. The rejected
+ * samples are still traversed by the search, but they are not returned; if fewer than `k` samples
+ * are reachable through the graph, the remaining neighbors are set to the maximum value of
+ * `uint64_t` (and the distances to the maximum value of `float`).
+ *
+ * @tparam T data element type
+ * @tparam filter_t data filter function type
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx cagra index
+ * @param[in] queries a host matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a host matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ * @param[in] sample_filter a filter that greenlights samples for a given query
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto hnsw_index = hnsw::from_cagra(res, index);
+ *
+ *   // Keep the even samples only
+ *   std::vector<uint32_t> bits(raft::ceildiv<size_t>(index.size(), 32), 0x55555555u);
+ *   raft::core::bitset_view<uint32_t, uint32_t> even(bits.data(), index.size());
+ *   hnsw::search_params search_params;
+ *   search_params.ef = 50;
+ *   hnsw::search_with_filtering(res, search_params, *hnsw_index, queries, neighbors, distances,
+ *                               filtering::bitset_filter(even));
+ * @endcode
+ */
+template <typename T, typename filter_t>
+void search_with_filtering(raft::resources const& res,
+                           const search_params& params,
+                           const index<T>& idx,
+                           raft::host_matrix_view<const T, int64_t, row_major> queries,
+                           raft::host_matrix_view<uint64_t, int64_t, row_major> neighbors,
+                           raft::host_matrix_view<float, int64_t, row_major> distances,
+                           filter_t sample_filter)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  detail::search(res, params, idx, queries, neighbors, distances, sample_filter);
 }
 
 /**@}*/
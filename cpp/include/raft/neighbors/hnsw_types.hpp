@@ -34,15 +34,18 @@ namespace raft::neighbors::hnsw {
  */
 
 struct search_params : ann::search_params {
-  int ef;               // size of the candidate list
-  int num_threads = 0;  // number of host threads to use for concurrent searches. Value of 0
-                        // automatically maximizes parallelism
+  int ef;                   // size of the candidate list
+  int num_threads = 0;      // number of host threads to use for concurrent searches. Value of 0
+                            // automatically maximizes parallelism
+  bool numa_aware = false;  // pin the threads to the NUMA nodes of the host, each searching a
+                            // copy of the index local to its node. The copies are made on the
+                            // first NUMA-aware search and kept with the index.
 };
 template <typename T>
 struct index : ann::index {
  public:
   /**
-   * @brief load a base-layer-only hnswlib index originally saved from a built CAGRA index.
+   * @brief load an hnswlib index originally saved from a built CAGRA index.
    *  This is a virtual class and it cannot be used directly. To create an index, use the factory
    *  function `raft::neighbors::hnsw::from_cagra` from the header
    *  `raft/neighbors/hnsw.hpp`
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/hybrid.cuh>
+#include <raft/neighbors/hybrid_types.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace raft::neighbors::hybrid {
+
+/**
+ * @defgroup hybrid Hybrid sparse and dense search with rank fusion
+ * @{
+ */
+
+/**
+ * @brief Search the documents by their sparse (e.g. BM25) and dense (embedding) vectors, and rank
+ * the candidates of both searches together.
+ *
+ * The sparse candidates are found by the sparse brute-force kNN on a side stream (one of the
+ * stream pool of `res` if any), while `dense_search` finds the dense candidates on the main
+ * stream. If `dense_dataset` is given, the union of the candidates is re-ranked by the exact dense
+ * distances, so that the candidates found by the sparse search only get their dense scores too.
+ * The candidates are then fused on the device (see `fusion_method`) and the best `k` are
+ * selected; nothing is copied to the host.
+ *
+ * `dense_search` wraps the dense index like in `dynamic_batching::batcher`: it is called as
+ * `dense_search(res, queries, neighbors, distances)` with device matrix views (`[n_queries, dim]`,
+ * `[n_queries, n_dense_candidates]` and `[n_queries, n_dense_candidates]`, with `int64_t`
+ * extents), and it must return the candidates sorted best first, as all the RAFT searches do.
+ * The ids of both searches refer to the same documents (the rows of `sparse_index`); the ids out
+ * of range mark the missing candidates and are skipped.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = cagra::build<float, uint32_t>(res, cagra::index_params{}, embeddings);
+ *   hybrid::search_params params;
+ *   hybrid::search<float, uint32_t>(
+ *     res, params, bm25_docs, bm25_queries, dense_queries,
+ *     [&index](const raft::resources& res, auto q, auto n, auto d) {
+ *       cagra::search(res, cagra::search_params{}, index, q, n, d);
+ *     },
+ *     neighbors, scores, embeddings);
+ * @endcode
+ *
+ * @tparam T dense data element type
+ * @tparam IdxT type of the dense indices
+ * @tparam SparseIdxT type of the sparse indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search and the fusion
+ * @param[in] sparse_index the sparse vectors of the documents [n_rows, n_terms]
+ * @param[in] sparse_queries the sparse vectors of the queries [n_queries, n_terms]
+ * @param[in] dense_queries the dense vectors of the queries [n_queries, dim]
+ * @param[in] dense_search the search of the dense index
+ * @param[out] neighbors the best documents of every query [n_queries, k]; the missing ones
+ *   (if the searches found fewer than k distinct documents) are `numeric_limits<IdxT>::max()`
+ * @param[out] scores the fused scores of the documents (larger is better) [n_queries, k]
+ * @param[in] dense_dataset optional dense vectors of the documents [n_rows, dim] to re-rank the
+ *   union of the candidates; then `n_sparse_candidates + n_dense_candidates` must not exceed 256.
+ */
+template <typename T, typename IdxT, typename SparseIdxT = int, typename DenseSearchFn>
+void search(raft::resources const& res,
+            const search_params& params,
+            raft::device_csr_matrix_view<const float, SparseIdxT, SparseIdxT, SparseIdxT>
+              sparse_index,
+            raft::device_csr_matrix_view<const float, SparseIdxT, SparseIdxT, SparseIdxT>
+              sparse_queries,
+            raft::device_matrix_view<const T, int64_t, row_major> dense_queries,
+            DenseSearchFn&& dense_search,
+            raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::device_matrix_view<float, int64_t, row_major> scores,
+            std::optional<raft::device_matrix_view<const T, int64_t, row_major>> dense_dataset =
+              std::nullopt)
+{
+  detail::search<T, IdxT, SparseIdxT>(res,
+                                      params,
+                                      sparse_index,
+                                      sparse_queries,
+                                      dense_queries,
+                                      std::forward<DenseSearchFn>(dense_search),
+                                      neighbors,
+                                      scores,
+                                      dense_dataset);
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::hybrid
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ann_types.hpp"
+
+#include <raft/distance/distance_types.hpp>
+
+#include <cstdint>
+
+namespace raft::neighbors::hybrid {
+
+/**
+ * @addtogroup hybrid
+ * @{
+ */
+
+/** How the sparse and the dense candidates of a query are ranked together. */
+enum class fusion_method {
+  /**
+   * Reciprocal rank fusion: a candidate scores `weight / (rrf_constant + rank)` in every list it
+   * is found in, where `rank` starts at one.
+   */
+  kRRF,
+  /**
+   * Weighted score fusion: the similarities of every list are min-max normalized to [0, 1] per
+   * query, and a candidate scores `weight * normalized_similarity` in every list it is found in.
+   */
+  kWeighted
+};
+
+struct search_params : ann::search_params {
+  fusion_method fusion = fusion_method::kRRF;
+  /** The weight of the sparse scores in the fusion. */
+  float sparse_weight = 1.0f;
+  /** The weight of the dense scores in the fusion. */
+  float dense_weight = 1.0f;
+  /** The rank offset of the reciprocal rank fusion. */
+  float rrf_constant = 60.0f;
+  /** The number of the candidates of every query taken from the sparse search. */
+  uint32_t n_sparse_candidates = 100;
+  /** The number of the candidates of every query taken from the dense search. */
+  uint32_t n_dense_candidates = 100;
+  /** The metric of the sparse search (the BM25 scores are the inner products). */
+  raft::distance::DistanceType sparse_metric = raft::distance::DistanceType::InnerProduct;
+  /**
+   * The metric of the dense distances: it tells whether the smaller or the larger dense distances
+   * are better, and it is the metric of the refinement.
+   */
+  raft::distance::DistanceType dense_metric = raft::distance::DistanceType::L2Expanded;
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::hybrid
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <raft/core/device_mdspan.hpp>  // raft::device_matrix_view
+#include <raft/core/host_mdspan.hpp>    // raft::host_matrix_view
 #include <raft/core/resources.hpp>      // raft::resources
 #include <raft/neighbors/ivf_flat_serialize.cuh>
 #include <raft/neighbors/ivf_flat_types.hpp>  // raft::neighbors::ivf_flat::index
@@ -24,6 +25,8 @@
 
 #include <rmm/resource_ref.hpp>
 
+#include <cuda_fp16.h>
+
 #include <cstdint>  // int64_t
 
 #ifdef RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -100,6 +103,11 @@ void extend(raft::resources const& handle,
             std::optional<raft::host_vector_view<const IdxT, IdxT>> new_indices,
             index<T, IdxT>* index) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+auto remove(raft::resources const& handle,
+            raft::device_vector_view<const IdxT, IdxT> ids,
+            index<T, IdxT>* index) -> IdxT RAFT_EXPLICIT;
+
 template <typename T, typename IdxT, typename IvfSampleFilterT>
 void search_with_filtering(raft::resources const& handle,
                            const search_params& params,
@@ -140,6 +148,14 @@ void search(raft::resources const& handle,
             raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
             raft::device_matrix_view<float, IdxT, row_major> distances) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<T, IdxT>& index,
+            raft::host_matrix_view<const T, IdxT, row_major> queries,
+            raft::host_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::host_matrix_view<float, IdxT, row_major> distances) RAFT_EXPLICIT;
+
 }  // namespace raft::neighbors::ivf_flat
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -178,6 +194,7 @@ void search(raft::resources const& handle,
     raft::neighbors::ivf_flat::index<T, IdxT>& idx);
 
 instantiate_raft_neighbors_ivf_flat_build(float, int64_t);
+instantiate_raft_neighbors_ivf_flat_build(half, int64_t);
 instantiate_raft_neighbors_ivf_flat_build(int8_t, int64_t);
 instantiate_raft_neighbors_ivf_flat_build(uint8_t, int64_t);
 #undef instantiate_raft_neighbors_ivf_flat_build
@@ -225,11 +242,26 @@ instantiate_raft_neighbors_ivf_flat_build(uint8_t, int64_t);
     ->raft::neighbors::ivf_flat::index<T, IdxT>;
 
 instantiate_raft_neighbors_ivf_flat_extend(float, int64_t);
+instantiate_raft_neighbors_ivf_flat_extend(half, int64_t);
 instantiate_raft_neighbors_ivf_flat_extend(int8_t, int64_t);
 instantiate_raft_neighbors_ivf_flat_extend(uint8_t, int64_t);
 
 #undef instantiate_raft_neighbors_ivf_flat_extend
 
+#define instantiate_raft_neighbors_ivf_flat_remove(T, IdxT)        \
+  extern template auto raft::neighbors::ivf_flat::remove<T, IdxT>( \
+    raft::resources const& handle,                                 \
+    raft::device_vector_view<const IdxT, IdxT> ids,                \
+    raft::neighbors::ivf_flat::index<T, IdxT>* index)              \
+    ->IdxT;
+
+instantiate_raft_neighbors_ivf_flat_remove(float, int64_t);
+instantiate_raft_neighbors_ivf_flat_remove(half, int64_t);
+instantiate_raft_neighbors_ivf_flat_remove(int8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_remove(uint8_t, int64_t);
+
+#undef instantiate_raft_neighbors_ivf_flat_remove
+
 #define instantiate_raft_neighbors_ivf_flat_search(T, IdxT)        \
   extern template void raft::neighbors::ivf_flat::search<T, IdxT>( \
     raft::resources const& handle,                                 \
@@ -248,9 +280,18 @@ instantiate_raft_neighbors_ivf_flat_extend(uint8_t, int64_t);
     const raft::neighbors::ivf_flat::index<T, IdxT>& index,        \
     raft::device_matrix_view<const T, IdxT, row_major> queries,    \
     raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,     \
-    raft::device_matrix_view<float, IdxT, row_major> distances);
+    raft::device_matrix_view<float, IdxT, row_major> distances);   \
+                                                                   \
+  extern template void raft::neighbors::ivf_flat::search<T, IdxT>( \
+    raft::resources const& handle,                                 \
+    const raft::neighbors::ivf_flat::search_params& params,        \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,        \
+    raft::host_matrix_view<const T, IdxT, row_major> queries,      \
+    raft::host_matrix_view<IdxT, IdxT, row_major> neighbors,       \
+    raft::host_matrix_view<float, IdxT, row_major> distances);
 
 instantiate_raft_neighbors_ivf_flat_search(float, int64_t);
+instantiate_raft_neighbors_ivf_flat_search(half, int64_t);
 instantiate_raft_neighbors_ivf_flat_search(int8_t, int64_t);
 instantiate_raft_neighbors_ivf_flat_search(uint8_t, int64_t);
 
@@ -17,8 +17,11 @@
 #pragma once
 
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/host_query_staging.cuh>
 #include <raft/neighbors/detail/ivf_flat_build.cuh>
+#include <raft/neighbors/detail/ivf_flat_remove.cuh>
 #include <raft/neighbors/detail/ivf_flat_search.cuh>
 #include <raft/neighbors/ivf_flat_serialize.cuh>
 #include <raft/neighbors/ivf_flat_types.hpp>
@@ -401,6 +404,43 @@ void extend(raft::resources const& handle,
          new_indices.has_value() ? new_indices.value().data_handle() : nullptr,
          static_cast<IdxT>(new_vectors.extent(0)));
 }
+
+/**
+ * @brief Remove the records with the given source indices from the index in-place.
+ *
+ * Every list is scanned for the given ids; the removed records are replaced by the last records
+ * of the same list (hence the order of the records in a list changes), and the list size is
+ * reduced. The memory of a list is reallocated only when less than a quarter of its capacity
+ * remains in use, so that the repeated removals (and the following `extend` calls) reuse it.
+ * All records sharing a removed id are removed; the ids not present in the index are ignored.
+ *
+ * NB: the cluster centers are not updated, even with `adaptive_centers`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // drop the records [0, 100) from the index
+ *   auto ids = raft::make_device_vector<int64_t, int64_t>(handle, 100);
+ *   raft::linalg::range(ids.data_handle(), 100, raft::resource::get_cuda_stream(handle));
+ *   auto n_removed = ivf_flat::remove(handle, raft::make_const_mdspan(ids.view()), &index);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle
+ * @param[in] ids a device vector view to the source indices of the records to remove [n_ids]
+ * @param[inout] index pointer to index, to be modified in-place
+ *
+ * @return the number of records removed
+ */
+template <typename T, typename IdxT>
+auto remove(raft::resources const& handle,
+            raft::device_vector_view<const IdxT, IdxT> ids,
+            index<T, IdxT>* index) -> IdxT
+{
+  return detail::remove(handle, ids.data_handle(), ids.extent(0), index);
+}
 /** @} */
 
 /**
@@ -659,6 +699,53 @@ void search(raft::resources const& handle,
                         raft::neighbors::filtering::none_ivf_sample_filter());
 }
 
+/**
+ * @brief Search ANN with host-resident queries, writing the results to host memory.
+ *
+ * The queries are searched by batches, which are staged through pinned buffers of the pinned
+ * workspace (@ref raft::resource::get_pinned_workspace_resource). The transfers of a batch run on a
+ * stream of the stream pool of `handle`, if any, so that they overlap with the search of the
+ * previous batch; without a stream pool, they are still done asynchronously.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] index ivf-flat constructed index
+ * @param[in] queries a host matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a host matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<T, IdxT>& index,
+            raft::host_matrix_view<const T, IdxT, row_major> queries,
+            raft::host_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::host_matrix_view<float, IdxT, row_major> distances)
+{
+  RAFT_EXPECTS(queries.extent(1) == index.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+  const IdxT dim = queries.extent(1);
+  const IdxT k   = neighbors.extent(1);
+  raft::neighbors::detail::search_host_queries(
+    handle,
+    queries,
+    neighbors,
+    distances,
+    [&](const T* queries_d, IdxT* neighbors_d, float* distances_d, IdxT n_rows) {
+      search(handle,
+             params,
+             index,
+             raft::make_device_matrix_view<const T, IdxT>(queries_d, n_rows, dim),
+             raft::make_device_matrix_view<IdxT, IdxT>(neighbors_d, n_rows, k),
+             raft::make_device_matrix_view<float, IdxT>(distances_d, n_rows, k));
+    });
+}
+
 /** @} */
 
 }  // namespace raft::neighbors::ivf_flat
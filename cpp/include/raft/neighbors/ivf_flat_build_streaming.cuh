@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/ivf_flat_build_streaming.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+
+namespace raft::neighbors::ivf_flat {
+
+/**
+ * @addtogroup ivf_flat
+ * @{
+ */
+
+/**
+ * @brief A row reader of the binary dataset files (`.fbin`, `.u8bin`, `.i8bin`, etc).
+ *
+ * The file starts with the number of rows and the number of columns (two `uint32_t`), followed by
+ * the row-major data. The rows are read on demand, so the file does not need to fit in the host
+ * memory. This is the reader expected by `ivf_flat::build_streaming`.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ */
+template <typename T, typename IdxT>
+class bin_file_reader {
+ public:
+  explicit bin_file_reader(const std::string& path) : file_(path, std::ios::binary)
+  {
+    RAFT_EXPECTS(file_.good(), "Cannot open the file %s", path.c_str());
+    uint32_t header[2];
+    file_.read(reinterpret_cast<char*>(header), sizeof(header));
+    RAFT_EXPECTS(file_.good(), "Cannot read the header of the file %s", path.c_str());
+    n_rows_ = header[0];
+    dim_    = header[1];
+  }
+
+  /** The number of rows in the file. */
+  [[nodiscard]] auto n_rows() const noexcept -> IdxT { return n_rows_; }
+  /** The number of columns in the file. */
+  [[nodiscard]] auto dim() const noexcept -> uint32_t { return dim_; }
+
+  /** Read the rows `[offset, offset + n_rows)` to the host buffer `dst` [n_rows, dim]. */
+  void operator()(T* dst, IdxT offset, IdxT n_rows)
+  {
+    RAFT_EXPECTS(offset + n_rows <= n_rows_, "The rows are out of the file bounds");
+    file_.seekg(2 * sizeof(uint32_t) + size_t(offset) * dim_ * sizeof(T));
+    file_.read(reinterpret_cast<char*>(dst), size_t(n_rows) * dim_ * sizeof(T));
+    RAFT_EXPECTS(file_.good(), "Failed to read %zu rows from the file", size_t(n_rows));
+  }
+
+ private:
+  std::ifstream file_;
+  IdxT n_rows_;
+  uint32_t dim_;
+};
+
+/**
+ * @brief Build the index from a dataset read chunk by chunk on the host.
+ *
+ * This is the same as `ivf_flat::build`, except the dataset is never staged as a whole, neither in
+ * the host nor in the device memory. The rows are requested from `read_rows` instead:
+ *
+ *   1. the kmeans clustering is trained on a sample of `kmeans_trainset_fraction` of the rows
+ *      (read as a few evenly spaced runs of contiguous rows);
+ *   2. the dataset is added to the index (if `add_data_on_build`) by chunks of `chunk_rows`.
+ *      The host reads the next chunk into a pinned buffer while the current one is copied to the
+ *      device and inserted into the lists.
+ *
+ * The trainset resides in the device memory, hence set `kmeans_trainset_fraction` low enough for
+ * the large datasets. The records are indexed by their row numbers.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   ivf_flat::bin_file_reader<float, int64_t> reader("base.fbin");
+ *   ivf_flat::index_params index_params;
+ *   index_params.kmeans_trainset_fraction = 0.01;
+ *   auto index = ivf_flat::build_streaming<float, int64_t>(
+ *     handle, index_params, reader, reader.n_rows(), reader.dim());
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @tparam ReadRowsT a callable `void(T* dst, IdxT offset, IdxT n_rows)`, which writes the rows
+ *   `[offset, offset + n_rows)` of the dataset to the host buffer `dst`. The calls are not
+ *   concurrent, but they may be made from a different host thread.
+ *
+ * @param[in] handle
+ * @param[in] params configure the index building
+ * @param[in] read_rows the dataset reader
+ * @param[in] n_rows the number of rows in the dataset
+ * @param[in] dim the dimensionality of the dataset
+ * @param[in] chunk_rows the number of rows read and added at once
+ *
+ * @return the constructed ivf-flat index
+ */
+template <typename T, typename IdxT, typename ReadRowsT>
+auto build_streaming(raft::resources const& handle,
+                     const index_params& params,
+                     ReadRowsT&& read_rows,
+                     IdxT n_rows,
+                     uint32_t dim,
+                     IdxT chunk_rows = 1 << 20) -> index<T, IdxT>
+{
+  return detail::build_streaming<T, IdxT>(
+    handle, params, std::forward<ReadRowsT>(read_rows), n_rows, dim, chunk_rows);
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_flat
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/core/serialize.hpp>
+#include <raft/neighbors/detail/ivf_host_search.hpp>
+#include <raft/neighbors/ivf_flat_codepacker.hpp>
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::host {
+
+/**
+ * @defgroup ivf_flat_host IVF-Flat search on the host
+ * @{
+ */
+
+/**
+ * @brief An IVF-Flat index loaded to the host memory for the search on the CPU.
+ *
+ * The index is read from the files written by `ivf_flat::serialize` (a GPU-built index); the
+ * lists keep the interleaved layout of the device index (see `ivf_flat::index::data`).
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ */
+template <typename T, typename IdxT>
+struct index {
+  struct list {
+    uint32_t size;
+    // interleaved groups of kIndexGroupSize records [round_up(size, kIndexGroupSize), dim]
+    std::vector<T> data;
+    std::vector<IdxT> indices;
+  };
+
+  raft::distance::DistanceType metric;
+  uint32_t dim;
+  uint32_t veclen;
+  IdxT size;
+  // [n_lists, dim]
+  std::vector<float> centers;
+  std::vector<list> lists;
+
+  [[nodiscard]] auto n_lists() const -> uint32_t { return lists.size(); }
+};
+
+/**
+ * @brief Load an index written by `ivf_flat::serialize`.
+ *
+ * No GPU is involved: the stream is parsed on the host.
+ */
+template <typename T, typename IdxT>
+auto deserialize(std::istream& is) -> index<T, IdxT>
+{
+  raft::resources res;
+  char dtype_string[4];
+  is.read(dtype_string, 4);
+  auto ver = deserialize_scalar<int>(res, is);
+  RAFT_EXPECTS(ver == raft::neighbors::detail::ivf_host::kIvfFlatSerializationVersion,
+               "serialization version mismatch, expected %d, got %d",
+               raft::neighbors::detail::ivf_host::kIvfFlatSerializationVersion,
+               ver);
+
+  index<T, IdxT> idx;
+  idx.size     = deserialize_scalar<IdxT>(res, is);
+  idx.dim      = deserialize_scalar<uint32_t>(res, is);
+  auto n_lists = deserialize_scalar<uint32_t>(res, is);
+  idx.metric   = deserialize_scalar<raft::distance::DistanceType>(res, is);
+  deserialize_scalar<bool>(res, is);  // adaptive_centers
+  deserialize_scalar<bool>(res, is);  // conservative_memory_allocation
+  raft::neighbors::detail::ivf_host::check_metric(idx.metric);
+  // NOTE: keep this consistent with ivf_flat::index::calculate_veclen
+  idx.veclen = std::max<uint32_t>(1, 16 / sizeof(T));
+  if (idx.dim % idx.veclen != 0) { idx.veclen = 1; }
+
+  idx.centers.resize(size_t(n_lists) * idx.dim);
+  deserialize_mdspan(
+    res, is, raft::make_host_matrix_view<float, uint32_t>(idx.centers.data(), n_lists, idx.dim));
+  if (deserialize_scalar<bool>(res, is)) {
+    auto center_norms = raft::make_host_vector<float, uint32_t>(n_lists);
+    deserialize_mdspan(res, is, center_norms.view());
+  }
+  auto list_sizes = raft::make_host_vector<uint32_t, uint32_t>(n_lists);
+  deserialize_mdspan(res, is, list_sizes.view());
+
+  idx.lists.resize(n_lists);
+  list_spec<uint32_t, T, IdxT> store_spec{idx.dim, true};
+  for (uint32_t label = 0; label < n_lists; label++) {
+    auto& l           = idx.lists[label];
+    l.size            = list_sizes(label);
+    auto stored_size  = deserialize_scalar<uint32_t>(res, is);
+    if (stored_size == 0) { continue; }
+    auto data_extents = store_spec.make_list_extents(stored_size);
+    l.data.resize(size_t(data_extents.extent(0)) * data_extents.extent(1));
+    l.indices.resize(stored_size);
+    deserialize_mdspan(
+      res,
+      is,
+      raft::make_host_matrix_view<T, uint32_t>(
+        l.data.data(), data_extents.extent(0), data_extents.extent(1)));
+    deserialize_mdspan(
+      res, is, raft::make_host_vector_view<IdxT, uint32_t>(l.indices.data(), stored_size));
+  }
+  return idx;
+}
+
+template <typename T, typename IdxT>
+auto deserialize(const std::string& filename) -> index<T, IdxT>
+{
+  std::ifstream is(filename, std::ios::in | std::ios::binary);
+  if (!is) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+  return deserialize<T, IdxT>(is);
+}
+
+/**
+ * @brief Search the index on the CPU.
+ *
+ * The queries are distributed among the OpenMP threads; every query probes `params.n_probes`
+ * nearest lists and scans their interleaved groups with vectorized loops.
+ *
+ * @param[in] params configure the search (`n_probes`)
+ * @param[in] idx the host index
+ * @param[in] queries a host matrix view [n_queries, dim]
+ * @param[out] neighbors a host matrix view [n_queries, k]
+ * @param[out] distances a host matrix view [n_queries, k]
+ */
+template <typename T, typename IdxT>
+void search(const search_params& params,
+            const index<T, IdxT>& idx,
+            raft::host_matrix_view<const T, int64_t, row_major> queries,
+            raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::host_matrix_view<float, int64_t, row_major> distances)
+{
+  using raft::neighbors::detail::ivf_host::topk;
+  const int64_t n_queries = queries.extent(0);
+  const auto k            = static_cast<uint32_t>(neighbors.extent(1));
+  const uint32_t dim      = idx.dim;
+  const uint32_t veclen   = idx.veclen;
+  const bool ip           = idx.metric == raft::distance::DistanceType::InnerProduct;
+  RAFT_EXPECTS(queries.extent(1) == dim, "Wrong dimensionality of the queries");
+  RAFT_EXPECTS(neighbors.extent(0) == n_queries && distances.extent(0) == n_queries &&
+                 distances.extent(1) == k,
+               "Wrong shape of the outputs");
+
+#pragma omp parallel
+  {
+    std::vector<float> query(dim);
+    std::vector<float> coarse(idx.n_lists());
+    std::vector<uint32_t> probes;
+    topk<IdxT> best(k);
+    float group_scores[kIndexGroupSize];
+
+#pragma omp for schedule(dynamic)
+    for (int64_t q = 0; q < n_queries; q++) {
+      for (uint32_t i = 0; i < dim; i++) {
+        query[i] = static_cast<float>(queries(q, i));
+      }
+      for (uint32_t l = 0; l < idx.n_lists(); l++) {
+        coarse[l] = raft::neighbors::detail::ivf_host::score(
+          query.data(), idx.centers.data() + size_t(l) * dim, dim, ip);
+      }
+      raft::neighbors::detail::ivf_host::select_probes(coarse, params.n_probes, probes);
+
+      best.clear();
+      for (auto label : probes) {
+        const auto& list = idx.lists[label];
+        for (uint32_t group = 0; group * kIndexGroupSize < list.size; group++) {
+          // The group is [dim / veclen, kIndexGroupSize, veclen]
+          const T* block = list.data.data() + size_t(group) * kIndexGroupSize * dim;
+          std::fill(group_scores, group_scores + kIndexGroupSize, 0.0f);
+          for (uint32_t l = 0; l < dim; l += veclen) {
+            const T* chunk = block + l * kIndexGroupSize;
+            for (uint32_t j = 0; j < veclen; j++) {
+              const float qv = query[l + j];
+              if (ip) {
+#pragma omp simd
+                for (uint32_t r = 0; r < kIndexGroupSize; r++) {
+                  group_scores[r] -= qv * static_cast<float>(chunk[r * veclen + j]);
+                }
+              } else {
+#pragma omp simd
+                for (uint32_t r = 0; r < kIndexGroupSize; r++) {
+                  const float d = qv - static_cast<float>(chunk[r * veclen + j]);
+                  group_scores[r] += d * d;
+                }
+              }
+            }
+          }
+          const uint32_t n_valid = std::min(kIndexGroupSize, list.size - group * kIndexGroupSize);
+          for (uint32_t r = 0; r < n_valid; r++) {
+            best.push(group_scores[r], list.indices[group * kIndexGroupSize + r]);
+          }
+        }
+      }
+      best.write(idx.metric, &neighbors(q, 0), &distances(q, 0));
+    }
+  }
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_flat::host
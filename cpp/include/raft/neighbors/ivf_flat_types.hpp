@@ -76,14 +76,54 @@ struct index_params : ann::index_params {
   bool conservative_memory_allocation = false;
 };
 
+/** A type for specifying how the probed lists are scanned during the search. */
+enum class list_scan_algo {  // NOLINT
+  INTERLEAVED = 0,           // NOLINT
+  GEMM        = 1,           // NOLINT
+};
+
 struct search_params : ann::search_params {
   /** The number of clusters to search. */
   uint32_t n_probes = 20;
+  /**
+   * The algorithm scanning the probed lists.
+   *
+   * By default (INTERLEAVED), a single kernel computes the distances between every query and the
+   * records of its probed lists; that is, a list is read once per query probing it.
+   *
+   * The alternative (GEMM) groups the queries by the lists they probe and computes the distances
+   * between every list and its group of queries as a matrix product (on the tensor cores for the
+   * `half` indices), followed by a top-k selection. This pays off for the large batches of queries,
+   * where every list is probed by many queries at once.
+   */
+  list_scan_algo scan_algo = list_scan_algo::INTERLEAVED;
+  /**
+   * Stop probing the clusters of a query early, once the next cluster is far from the closest one
+   * or enough candidates have been collected (disabled by default).
+   *
+   * `n_probes` remains the upper bound of the probed clusters.
+   */
+  ivf::adaptive_probing adaptive_probes;
 };
 
 static_assert(std::is_aggregate_v<index_params>);
 static_assert(std::is_aggregate_v<search_params>);
 
+/**
+ * @brief An affine mapping of float vectors onto int8 codes: `x[j] ~ scale * code[j] + offset[j]`.
+ *
+ * The offsets are per-dimension, whereas the scale is shared by all dimensions. Hence the L2
+ * distances between the codes are the distances between the source vectors divided by `scale^2`
+ * (up to the rounding errors), and an `index<int8_t, IdxT>` built on the codes can be searched
+ * with the codes of the queries (see `helpers::train_scalar_quantizer`).
+ */
+struct scalar_quantizer {
+  /** The step of the quantization grid. */
+  float scale;
+  /** The values mapped onto the zero code [dim]. */
+  device_vector<float, uint32_t> offset;
+};
+
 template <typename SizeT, typename ValueT, typename IdxT>
 struct list_spec {
   using value_type   = ValueT;
@@ -121,6 +161,10 @@ using list_data = ivf::list<list_spec, SizeT, ValueT, IdxT>;
 /**
  * @brief IVF-flat index.
  *
+ * The lists store the data in the type `T`, while the search accumulates the distances in 32-bit
+ * values. Hence the `half` and `int8_t` (see `scalar_quantizer`) indices reduce the memory
+ * footprint and bandwidth of float vectors two and four times, respectively.
+ *
  * @tparam T data element type
  * @tparam IdxT type of the indices in the source dataset
  *
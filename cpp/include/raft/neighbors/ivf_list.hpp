@@ -21,6 +21,7 @@
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/core/serialize.hpp>
@@ -42,7 +43,7 @@ template <template <typename, typename...> typename SpecT,
 list<SpecT, SizeT, SpecExtraArgs...>::list(raft::resources const& res,
                                            const spec_type& spec,
                                            size_type n_rows)
-  : size{n_rows}, data{res}, indices{res}
+  : mr{resource::get_ivf_list_resource(res)}, data{res}, indices{res}, size{n_rows}
 {
   auto capacity = round_up_safe<SizeT>(n_rows, spec.align_max);
   if (n_rows < spec.align_max) {
@@ -50,8 +51,8 @@ list<SpecT, SizeT, SpecExtraArgs...>::list(raft::resources const& res,
     capacity = std::min<SizeT>(capacity, spec.align_max);
   }
   try {
-    data    = make_device_mdarray<value_type>(res, spec.make_list_extents(capacity));
-    indices = make_device_vector<index_type, SizeT>(res, capacity);
+    data    = make_device_mdarray<value_type>(res, mr.get(), spec.make_list_extents(capacity));
+    indices = make_device_mdarray<index_type>(res, mr.get(), make_extents<SizeT>(capacity));
   } catch (std::bad_alloc& e) {
     RAFT_FAIL(
       "ivf::list: failed to allocate a big enough list to hold all data "
@@ -19,8 +19,11 @@
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/resources.hpp>
 
+#include <rmm/mr/device/device_memory_resource.hpp>
+
 #include <atomic>
 #include <limits>
+#include <memory>
 #include <type_traits>
 
 namespace raft::neighbors::ivf {
@@ -34,6 +37,39 @@ template <typename IdxT>
 constexpr static IdxT kInvalidRecord =
   (std::is_signed_v<IdxT> ? IdxT{0} : std::numeric_limits<IdxT>::max()) - 1;
 
+/**
+ * Per-query limits on the number of probed clusters, shared by the search parameters of the IVF
+ * indices.
+ *
+ * Every query probes its `n_probes` closest clusters in the order of their distance, but stops at
+ * the first cluster violating any of the enabled limits below (the zero values disable them).
+ * This way, the queries close to a single cluster (the easy ones) probe fewer clusters than the
+ * queries lying in between several clusters.
+ *
+ * The limits are checked against the coarse distances between the query and the cluster centers
+ * (the squared distances for the L2 metrics); for the inner product, the gap is the decrease of
+ * the similarity w.r.t. the closest cluster.
+ */
+struct adaptive_probing {
+  /**
+   * Stop at a cluster farther than `max_distance_ratio` times the distance to the closest cluster
+   * (enabled for the values greater than one).
+   */
+  float max_distance_ratio = 0.0f;
+  /** Stop at a cluster farther than the closest cluster by more than `max_distance_gap`. */
+  float max_distance_gap = 0.0f;
+  /** Stop once the probed clusters hold at least `max_candidates` records in total. */
+  uint32_t max_candidates = 0;
+  /** The number of clusters probed regardless of the limits. */
+  uint32_t min_probes = 1;
+
+  /** Whether any of the limits is enabled. */
+  [[nodiscard]] constexpr auto enabled() const noexcept -> bool
+  {
+    return max_distance_ratio > 1.0f || max_distance_gap > 0.0f || max_candidates > 0;
+  }
+};
+
 /** The data for a single IVF list. */
 template <template <typename, typename...> typename SpecT,
           typename SizeT,
@@ -45,6 +81,11 @@ struct list {
   using index_type   = typename spec_type::index_type;
   using list_extents = typename spec_type::list_extents;
 
+  /**
+   * The memory resource the list is allocated from (`resource::get_ivf_list_resource`); declared
+   * first to outlive the buffers.
+   */
+  std::shared_ptr<rmm::mr::device_memory_resource> mr;
   /** Possibly encoded data; it's layout is defined by `SpecT`. */
   device_mdarray<value_type, list_extents, row_major> data;
   /** Source indices. */
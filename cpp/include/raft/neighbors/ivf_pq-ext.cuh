@@ -17,6 +17,7 @@
 #pragma once
 
 #include <raft/core/device_mdspan.hpp>      // raft::device_matrix_view
+#include <raft/core/host_mdspan.hpp>        // raft::host_matrix_view
 #include <raft/core/resources.hpp>          // raft::resources
 #include <raft/neighbors/ivf_pq_types.hpp>  // raft::neighbors::ivf_pq::index
 #include <raft/util/raft_explicit.hpp>      // RAFT_EXPLICIT
@@ -44,6 +45,16 @@ void extend(raft::resources const& handle,
             std::optional<raft::device_vector_view<const IdxT, IdxT, row_major>> new_indices,
             index<IdxT>* idx) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void extend(raft::resources const& handle,
+            raft::device_matrix_view<const T, IdxT, row_major> new_vectors,
+            std::optional<raft::device_vector_view<const IdxT, IdxT, row_major>> new_indices,
+            versioned_index<IdxT>* idx) RAFT_EXPLICIT;
+
+template <typename IdxT>
+auto rebalance(raft::resources const& handle, const rebalance_params& params, index<IdxT>* idx)
+  -> uint32_t RAFT_EXPLICIT;
+
 template <typename T, typename IdxT, typename IvfSampleFilterT>
 void search_with_filtering(raft::resources const& handle,
                            const search_params& params,
@@ -61,6 +72,14 @@ void search(raft::resources const& handle,
             raft::device_matrix_view<IdxT, uint32_t, row_major> neighbors,
             raft::device_matrix_view<float, uint32_t, row_major> distances) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<IdxT>& idx,
+            raft::host_matrix_view<const T, uint32_t, row_major> queries,
+            raft::host_matrix_view<IdxT, uint32_t, row_major> neighbors,
+            raft::host_matrix_view<float, uint32_t, row_major> distances) RAFT_EXPLICIT;
+
 template <typename T, typename IdxT = uint32_t>
 auto build(raft::resources const& handle,
            const index_params& params,
@@ -141,6 +160,12 @@ instantiate_raft_neighbors_ivf_pq_build(uint8_t, int64_t);
     std::optional<raft::device_vector_view<const IdxT, IdxT, row_major>> new_indices,            \
     raft::neighbors::ivf_pq::index<IdxT>* idx);                                                  \
                                                                                                  \
+  extern template void raft::neighbors::ivf_pq::extend<T, IdxT>(                                 \
+    raft::resources const& handle,                                                               \
+    raft::device_matrix_view<const T, IdxT, row_major> new_vectors,                              \
+    std::optional<raft::device_vector_view<const IdxT, IdxT, row_major>> new_indices,            \
+    raft::neighbors::ivf_pq::versioned_index<IdxT>* idx);                                        \
+                                                                                                 \
   extern template auto raft::neighbors::ivf_pq::extend<T, IdxT>(                                 \
     raft::resources const& handle,                                                               \
     const raft::neighbors::ivf_pq::index<IdxT>& idx,                                             \
@@ -163,6 +188,11 @@ instantiate_raft_neighbors_ivf_pq_extend(uint8_t, int64_t);
 
 #undef instantiate_raft_neighbors_ivf_pq_extend
 
+extern template auto raft::neighbors::ivf_pq::rebalance<int64_t>(
+  raft::resources const& handle,
+  const raft::neighbors::ivf_pq::rebalance_params& params,
+  raft::neighbors::ivf_pq::index<int64_t>* idx) -> uint32_t;
+
 #define instantiate_raft_neighbors_ivf_pq_search(T, IdxT)            \
   extern template void raft::neighbors::ivf_pq::search<T, IdxT>(     \
     raft::resources const& handle,                                   \
@@ -190,7 +220,15 @@ instantiate_raft_neighbors_ivf_pq_extend(uint8_t, int64_t);
     uint32_t n_queries,                                              \
     uint32_t k,                                                      \
     IdxT* neighbors,                                                 \
-    float* distances)
+    float* distances);                                               \
+                                                                     \
+  extern template void raft::neighbors::ivf_pq::search<T, IdxT>(     \
+    raft::resources const& handle,                                   \
+    const raft::neighbors::ivf_pq::search_params& params,            \
+    const raft::neighbors::ivf_pq::index<IdxT>& idx,                 \
+    raft::host_matrix_view<const T, uint32_t, row_major> queries,    \
+    raft::host_matrix_view<IdxT, uint32_t, row_major> neighbors,     \
+    raft::host_matrix_view<float, uint32_t, row_major> distances)
 
 instantiate_raft_neighbors_ivf_pq_search(float, int64_t);
 instantiate_raft_neighbors_ivf_pq_search(half, int64_t);
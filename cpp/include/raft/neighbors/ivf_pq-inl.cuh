@@ -17,9 +17,13 @@
 #pragma once
 
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/host_query_staging.cuh>
 #include <raft/neighbors/detail/ivf_pq_build.cuh>
+#include <raft/neighbors/detail/ivf_pq_rebalance.cuh>
 #include <raft/neighbors/detail/ivf_pq_search.cuh>
 #include <raft/neighbors/ivf_pq_serialize.cuh>
 #include <raft/neighbors/ivf_pq_types.hpp>
@@ -130,6 +134,59 @@ void extend(raft::resources const& handle,
                         n_rows);
 }
 
+/**
+ * @brief Publish a new version of the index extended with the new data.
+ *
+ * The new version is built out of place on the stream of `handle` (see `versioned_index`), so the
+ * searches on the snapshots of the index can continue on other streams in the meantime. The new
+ * version is published once it is complete; this function blocks until then. Concurrent calls are
+ * serialized.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   ivf_pq::versioned_index<int64_t> index(ivf_pq::build(handle, index_params, dataset));
+ *   // ingestion thread, using its own stream
+ *   ivf_pq::extend(ingest_handle, new_vectors, new_indices, &index);
+ *   // search threads
+ *   auto snapshot = index.snapshot();
+ *   ivf_pq::search(search_handle, search_params, *snapshot, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle
+ * @param[in] new_vectors a device matrix view to a row-major matrix [n_rows, idx.dim()]
+ * @param[in] new_indices a device vector view to a vector of indices [n_rows].
+ *    If the original index is empty (`idx.size() == 0`), you can pass `std::nullopt`
+ *    here to imply a continuous range `[0...n_rows)`.
+ * @param[inout] idx
+ */
+template <typename T, typename IdxT>
+void extend(raft::resources const& handle,
+            raft::device_matrix_view<const T, IdxT, row_major> new_vectors,
+            std::optional<raft::device_vector_view<const IdxT, IdxT>> new_indices,
+            versioned_index<IdxT>* idx)
+{
+  idx->update([&](const index<IdxT>& current) {
+    ASSERT(new_vectors.extent(1) == current.dim(),
+           "new_vectors should have the same dimension as the index");
+    IdxT n_rows = new_vectors.extent(0);
+    if (new_indices.has_value()) {
+      ASSERT(n_rows == new_indices.value().extent(0),
+             "new_vectors and new_indices have different number of rows");
+    }
+    const IdxT* new_indices_ptr =
+      new_indices.has_value() ? new_indices.value().data_handle() : nullptr;
+    auto next =
+      detail::extend(handle, current, new_vectors.data_handle(), new_indices_ptr, n_rows);
+    // The readers may use the new version on any stream.
+    resource::sync_stream(handle);
+    return next;
+  });
+}
+
 /**
  * @brief Search ANN using the constructed index with the given filter.
  *
@@ -232,6 +289,53 @@ void search(raft::resources const& handle,
                         raft::neighbors::filtering::none_ivf_sample_filter{});
 }
 
+/**
+ * @brief Search ANN with host-resident queries, writing the results to host memory.
+ *
+ * The queries are searched by batches, which are staged through pinned buffers of the pinned
+ * workspace (@ref raft::resource::get_pinned_workspace_resource). The transfers of a batch run on a
+ * stream of the stream pool of `handle`, if any, so that they overlap with the search of the
+ * previous batch; without a stream pool, they are still done asynchronously.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] idx ivf-pq constructed index
+ * @param[in] queries a host matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a host matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<IdxT>& idx,
+            raft::host_matrix_view<const T, uint32_t, row_major> queries,
+            raft::host_matrix_view<IdxT, uint32_t, row_major> neighbors,
+            raft::host_matrix_view<float, uint32_t, row_major> distances)
+{
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+  const uint32_t dim = queries.extent(1);
+  const uint32_t k   = neighbors.extent(1);
+  raft::neighbors::detail::search_host_queries(
+    handle,
+    queries,
+    neighbors,
+    distances,
+    [&](const T* queries_d, IdxT* neighbors_d, float* distances_d, uint32_t n_rows) {
+      search(handle,
+             params,
+             idx,
+             raft::make_device_matrix_view<const T, uint32_t>(queries_d, n_rows, dim),
+             raft::make_device_matrix_view<IdxT, uint32_t>(neighbors_d, n_rows, k),
+             raft::make_device_matrix_view<float, uint32_t>(distances_d, n_rows, k));
+    });
+}
+
 /** @} */  // end group ivf_pq
 
 /**
@@ -342,6 +446,43 @@ void extend(raft::resources const& handle,
   detail::extend(handle, idx, new_vectors, new_indices, n_rows);
 }
 
+/**
+ * @brief Rebalance the lists of an index in place, without retraining it.
+ *
+ * The lists grown too large by the repeated calls to `extend` are split in two with the balanced
+ * k-means, and each of them takes over the slot of one of the smallest lists; the records of the
+ * latter ones are merged into their closest lists. Only the records of the affected lists are
+ * decoded, classified against the new centers, and re-encoded; the other lists are merely appended
+ * to. The number of lists and the PQ codebooks stay the same (with `codebook_gen::PER_CLUSTER`,
+ * the halves of a split list share its codebook).
+ *
+ * A list is split at most once per call: call it repeatedly (e.g. while
+ * `helpers::stats(res, index).imbalance_factor` is too high) to split the largest lists further.
+ * NB: the records are re-encoded from their decoded values, which adds to their quantization error.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   ivf_pq::rebalance_params params;
+ *   params.max_list_size_ratio = 3.0;
+ *   auto n_splits = ivf_pq::rebalance(handle, params, &index);
+ * @endcode
+ *
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle
+ * @param[in] params configure the rebalancing
+ * @param[inout] idx
+ *
+ * @return the number of lists split
+ */
+template <typename IdxT>
+auto rebalance(raft::resources const& handle, const rebalance_params& params, index<IdxT>* idx)
+  -> uint32_t
+{
+  return detail::rebalance(handle, params, idx);
+}
+
 /**
  * @brief Search ANN using the constructed index with the given filter.
  *
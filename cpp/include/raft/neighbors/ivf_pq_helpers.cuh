@@ -20,10 +20,12 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/neighbors/detail/ivf_pq_build.cuh>
+#include <raft/neighbors/detail/ivf_pq_stats.cuh>
 #include <raft/neighbors/ivf_pq_types.hpp>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
 
 #include <cstdio>
+#include <optional>
 
 namespace raft::neighbors::ivf_pq::helpers {
 using namespace raft::spatial::knn::detail;  // NOLINT
@@ -596,6 +598,37 @@ void erase_list(raft::resources const& res, index<IdxT>* index, uint32_t label)
   ivf_pq::detail::erase_list(res, index, label);
 }
 
+/**
+ * @brief Public helper API to move the data and indices of all lists to the pinned host memory.
+ *
+ * This allows keeping an index larger than the device memory: the search copies only the clusters
+ * probed by a batch of queries to the device, overlapping the copies of the next batch with the
+ * search of the current one (on a stream of the stream pool, if `res` has one). The lists grown by
+ * a later `extend` are allocated in the device memory again.
+ *
+ * The indices are not copied to the device during the search; they are read directly from the
+ * host memory, which makes the filters depending on the sample ids slower.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::resources res;
+ *   raft::resource::set_cuda_stream_pool(res, std::make_shared<rmm::cuda_stream_pool>(1));
+ *   auto index = ivf_pq::build(res, index_params, dataset);
+ *   ivf_pq::helpers::move_lists_to_host(res, &index);
+ *   ivf_pq::search(res, search_params, index, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam IdxT
+ *
+ * @param[in] res raft resource
+ * @param[inout] index pointer to IVF-PQ index
+ */
+template <typename IdxT>
+void move_lists_to_host(raft::resources const& res, index<IdxT>* index)
+{
+  ivf_pq::detail::move_lists_to_host(res, index);
+}
+
 /**
  * @brief Public helper API to reset the data and indices ptrs, and the list sizes. Useful for
  * externally modifying the index without going through the build stage. The data and indices of the
@@ -788,5 +821,54 @@ void extract_centers(raft::resources const& res,
                                   cudaMemcpyDefault,
                                   stream));
 }
+
+/**
+ * @brief Collect the statistics of an index: the list size distribution, the expected scan cost
+ * of a probe, and (optionally) the reconstruction error of the PQ codes.
+ *
+ * These help tuning `n_lists` and the PQ parameters, and deciding when the lists of an index that
+ * has been extended many times are imbalanced enough to rebuild it (see `index_stats`).
+ *
+ * The reconstruction error is computed on the GPU by decoding every list with
+ * `reconstruct_list_data` and comparing it to the source dataset; hence, it requires the indices
+ * stored in the lists to be the row numbers in `dataset`, which is the case if the index was built
+ * with `add_data_on_build` or extended without explicit indices.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   auto index = ivf_pq::build(res, index_params, dataset);
+ *   auto dataset_view = raft::make_const_mdspan(dataset.view());
+ *   auto s = ivf_pq::helpers::stats(res, index, std::make_optional(dataset_view));
+ *   if (s.imbalance_factor > 1.5) { ... rebuild the index ... }
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res raft resource
+ * @param[in] index IVF-PQ index
+ * @param[in] dataset the indexed vectors [n_rows, index.dim()]; pass `std::nullopt` to skip the
+ *   reconstruction error.
+ *
+ * @return the statistics of the index
+ */
+template <typename T, typename IdxT>
+auto stats(raft::resources const& res,
+           const index<IdxT>& index,
+           std::optional<device_matrix_view<const T, IdxT, row_major>> dataset) -> index_stats
+{
+  return ivf_pq::detail::stats<T, IdxT>(res, index, dataset);
+}
+
+/**
+ * @brief Collect the statistics of an index, without the reconstruction error.
+ *
+ * See the `stats` overload taking a dataset.
+ */
+template <typename IdxT>
+auto stats(raft::resources const& res, const index<IdxT>& index) -> index_stats
+{
+  return ivf_pq::detail::stats<float, IdxT>(res, index, std::nullopt);
+}
 /** @} */
 }  // namespace raft::neighbors::ivf_pq::helpers
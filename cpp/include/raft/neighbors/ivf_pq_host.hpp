@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/core/serialize.hpp>
+#include <raft/neighbors/detail/ivf_host_search.hpp>
+#include <raft/neighbors/ivf_pq_types.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace raft::neighbors::ivf_pq::host {
+
+/**
+ * @defgroup ivf_pq_host IVF-PQ search on the host
+ * @{
+ */
+
+/**
+ * @brief An IVF-PQ index loaded to the host memory for the search on the CPU.
+ *
+ * The index is read from the files written by `ivf_pq::serialize` (a GPU-built index). The codes
+ * are unpacked to one byte per subspace on load, [size, pq_dim] per list, so that the scan reads
+ * the lookup table with plain byte offsets.
+ *
+ * @tparam IdxT type of the indices
+ */
+template <typename IdxT>
+struct index {
+  struct list {
+    uint32_t size;
+    // [size, pq_dim]
+    std::vector<uint8_t> codes;
+    std::vector<IdxT> indices;
+  };
+
+  raft::distance::DistanceType metric;
+  codebook_gen codebook_kind;
+  uint32_t dim;
+  uint32_t pq_bits;
+  uint32_t pq_dim;
+  uint32_t pq_len;
+  IdxT size;
+  // [pq_dim or n_lists, pq_len, 1 << pq_bits]
+  std::vector<float> pq_centers;
+  // [n_lists, rot_dim]
+  std::vector<float> centers_rot;
+  // [rot_dim, dim]
+  std::vector<float> rotation_matrix;
+  std::vector<list> lists;
+
+  [[nodiscard]] auto n_lists() const -> uint32_t { return lists.size(); }
+  [[nodiscard]] auto rot_dim() const -> uint32_t { return pq_len * pq_dim; }
+  [[nodiscard]] auto pq_book_size() const -> uint32_t { return 1u << pq_bits; }
+};
+
+/**
+ * @brief Load an index written by `ivf_pq::serialize`.
+ *
+ * No GPU is involved: the stream is parsed on the host.
+ */
+template <typename IdxT>
+auto deserialize(std::istream& is) -> index<IdxT>
+{
+  raft::resources res;
+  auto ver = deserialize_scalar<int>(res, is);
+  RAFT_EXPECTS(ver == raft::neighbors::detail::ivf_host::kIvfPqSerializationVersion,
+               "serialization version mismatch, expected %d, got %d",
+               raft::neighbors::detail::ivf_host::kIvfPqSerializationVersion,
+               ver);
+
+  index<IdxT> idx;
+  idx.size    = deserialize_scalar<IdxT>(res, is);
+  idx.dim     = deserialize_scalar<uint32_t>(res, is);
+  idx.pq_bits = deserialize_scalar<uint32_t>(res, is);
+  idx.pq_dim  = deserialize_scalar<uint32_t>(res, is);
+  deserialize_scalar<bool>(res, is);  // conservative_memory_allocation
+  idx.metric        = deserialize_scalar<raft::distance::DistanceType>(res, is);
+  idx.codebook_kind = deserialize_scalar<codebook_gen>(res, is);
+  auto n_lists      = deserialize_scalar<uint32_t>(res, is);
+  raft::neighbors::detail::ivf_host::check_metric(idx.metric);
+  idx.pq_len = raft::div_rounding_up_unsafe(idx.dim, idx.pq_dim);
+
+  const uint32_t book_size = idx.pq_book_size();
+  const uint32_t n_books =
+    idx.codebook_kind == codebook_gen::PER_SUBSPACE ? idx.pq_dim : n_lists;
+  idx.pq_centers.resize(size_t(n_books) * idx.pq_len * book_size);
+  deserialize_mdspan(
+    res,
+    is,
+    raft::make_host_mdspan<float, uint32_t, row_major>(
+      idx.pq_centers.data(), make_extents<uint32_t>(n_books, idx.pq_len, book_size)));
+  // The centers in the original space are not needed: the probes are selected in the rotated one.
+  auto centers =
+    raft::make_host_matrix<float, uint32_t>(n_lists, raft::round_up_safe(idx.dim + 1, 8u));
+  deserialize_mdspan(res, is, centers.view());
+  idx.centers_rot.resize(size_t(n_lists) * idx.rot_dim());
+  deserialize_mdspan(
+    res,
+    is,
+    raft::make_host_matrix_view<float, uint32_t>(idx.centers_rot.data(), n_lists, idx.rot_dim()));
+  idx.rotation_matrix.resize(size_t(idx.rot_dim()) * idx.dim);
+  deserialize_mdspan(res,
+                     is,
+                     raft::make_host_matrix_view<float, uint32_t>(
+                       idx.rotation_matrix.data(), idx.rot_dim(), idx.dim));
+  auto list_sizes = raft::make_host_vector<uint32_t, uint32_t>(n_lists);
+  deserialize_mdspan(res, is, list_sizes.view());
+
+  idx.lists.resize(n_lists);
+  list_spec<uint32_t, IdxT> store_spec{idx.pq_bits, idx.pq_dim, true};
+  for (uint32_t label = 0; label < n_lists; label++) {
+    auto& l          = idx.lists[label];
+    auto stored_size = deserialize_scalar<uint32_t>(res, is);
+    l.size           = stored_size;
+    if (stored_size == 0) { continue; }
+    auto packed = raft::make_host_mdarray<uint8_t, uint32_t, row_major>(
+      store_spec.make_list_extents(stored_size));
+    l.indices.resize(stored_size);
+    deserialize_mdspan(res, is, packed.view());
+    deserialize_mdspan(
+      res, is, raft::make_host_vector_view<IdxT, uint32_t>(l.indices.data(), stored_size));
+
+    // Unpack the interleaved bitfields, see `ivf_pq::list_spec` and `bitfield_view_t`.
+    const uint32_t chunk_codes = (kIndexGroupVecLen * 8u) / idx.pq_bits;
+    const uint32_t code_mask   = book_size - 1;
+    l.codes.resize(size_t(stored_size) * idx.pq_dim);
+    for (uint32_t r = 0; r < stored_size; r++) {
+      for (uint32_t j = 0; j < idx.pq_dim; j++) {
+        const uint8_t* chunk =
+          &packed(r / kIndexGroupSize, j / chunk_codes, r % kIndexGroupSize, 0);
+        const uint32_t bit = (j % chunk_codes) * idx.pq_bits;
+        uint32_t pair      = chunk[bit / 8];
+        if (bit % 8 + idx.pq_bits > 8) { pair |= uint32_t(chunk[bit / 8 + 1]) << 8; }
+        l.codes[size_t(r) * idx.pq_dim + j] = uint8_t((pair >> (bit % 8)) & code_mask);
+      }
+    }
+  }
+  return idx;
+}
+
+template <typename IdxT>
+auto deserialize(const std::string& filename) -> index<IdxT>
+{
+  std::ifstream is(filename, std::ios::in | std::ios::binary);
+  if (!is) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+  return deserialize<IdxT>(is);
+}
+
+/**
+ * @brief Search the index on the CPU.
+ *
+ * The queries are distributed among the OpenMP threads. Every query is rotated once, probes
+ * `params.n_probes` nearest lists and, for every probed list, fills a float lookup table
+ * [pq_dim, 1 << pq_bits] of the subspace scores; the codes of the list are then scored by
+ * summing `pq_dim` table entries. The scores match the GPU search with
+ * `lut_dtype = internal_distance_dtype = CUDA_R_32F`; the other fields of `params` are ignored.
+ *
+ * @tparam T data element type of the queries
+ *
+ * @param[in] params configure the search (`n_probes`)
+ * @param[in] idx the host index
+ * @param[in] queries a host matrix view [n_queries, dim]
+ * @param[out] neighbors a host matrix view [n_queries, k]
+ * @param[out] distances a host matrix view [n_queries, k]
+ */
+template <typename T, typename IdxT>
+void search(const search_params& params,
+            const index<IdxT>& idx,
+            raft::host_matrix_view<const T, int64_t, row_major> queries,
+            raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::host_matrix_view<float, int64_t, row_major> distances)
+{
+  using raft::neighbors::detail::ivf_host::topk;
+  const int64_t n_queries  = queries.extent(0);
+  const auto k             = static_cast<uint32_t>(neighbors.extent(1));
+  const uint32_t dim       = idx.dim;
+  const uint32_t rot_dim   = idx.rot_dim();
+  const uint32_t pq_dim    = idx.pq_dim;
+  const uint32_t pq_len    = idx.pq_len;
+  const uint32_t book_size = idx.pq_book_size();
+  const bool ip            = idx.metric == raft::distance::DistanceType::InnerProduct;
+  RAFT_EXPECTS(queries.extent(1) == dim, "Wrong dimensionality of the queries");
+  RAFT_EXPECTS(neighbors.extent(0) == n_queries && distances.extent(0) == n_queries &&
+                 distances.extent(1) == k,
+               "Wrong shape of the outputs");
+
+#pragma omp parallel
+  {
+    std::vector<float> query(dim);
+    std::vector<float> query_rot(rot_dim);
+    std::vector<float> residual(rot_dim);
+    std::vector<float> coarse(idx.n_lists());
+    std::vector<float> lut(size_t(pq_dim) * book_size);
+    std::vector<uint32_t> probes;
+    topk<IdxT> best(k);
+
+#pragma omp for schedule(dynamic)
+    for (int64_t q = 0; q < n_queries; q++) {
+      for (uint32_t i = 0; i < dim; i++) {
+        query[i] = static_cast<float>(queries(q, i));
+      }
+      for (uint32_t i = 0; i < rot_dim; i++) {
+        const float* row = idx.rotation_matrix.data() + size_t(i) * dim;
+        float s          = 0;
+#pragma omp simd reduction(+ : s)
+        for (uint32_t j = 0; j < dim; j++) {
+          s += row[j] * query[j];
+        }
+        query_rot[i] = s;
+      }
+      for (uint32_t l = 0; l < idx.n_lists(); l++) {
+        coarse[l] = raft::neighbors::detail::ivf_host::score(
+          query_rot.data(), idx.centers_rot.data() + size_t(l) * rot_dim, rot_dim, ip);
+      }
+      raft::neighbors::detail::ivf_host::select_probes(coarse, params.n_probes, probes);
+
+      best.clear();
+      for (auto label : probes) {
+        const auto& list = idx.lists[label];
+        if (list.size == 0) { continue; }
+        const float* center = idx.centers_rot.data() + size_t(label) * rot_dim;
+        // The part of the score not depending on the codes
+        float base = 0;
+        for (uint32_t i = 0; i < rot_dim; i++) {
+          if (ip) {
+            base -= query_rot[i] * center[i];
+            residual[i] = query_rot[i];
+          } else {
+            residual[i] = query_rot[i] - center[i];
+          }
+        }
+        // The lookup table [pq_dim, book_size]
+        for (uint32_t j = 0; j < pq_dim; j++) {
+          const float* book =
+            idx.pq_centers.data() +
+            (idx.codebook_kind == codebook_gen::PER_SUBSPACE ? size_t(j) : size_t(label)) *
+              pq_len * book_size;
+          float* lut_row = lut.data() + size_t(j) * book_size;
+          std::fill(lut_row, lut_row + book_size, 0.0f);
+          for (uint32_t i = 0; i < pq_len; i++) {
+            const float r        = residual[j * pq_len + i];
+            const float* book_ci = book + size_t(i) * book_size;
+            if (ip) {
+#pragma omp simd
+              for (uint32_t c = 0; c < book_size; c++) {
+                lut_row[c] -= r * book_ci[c];
+              }
+            } else {
+#pragma omp simd
+              for (uint32_t c = 0; c < book_size; c++) {
+                const float d = r - book_ci[c];
+                lut_row[c] += d * d;
+              }
+            }
+          }
+        }
+        for (uint32_t r = 0; r < list.size; r++) {
+          const uint8_t* code = list.codes.data() + size_t(r) * pq_dim;
+          float s             = base;
+          for (uint32_t j = 0; j < pq_dim; j++) {
+            s += lut[size_t(j) * book_size + code[j]];
+          }
+          best.push(s, list.indices[r]);
+        }
+      }
+      best.write(idx.metric, &neighbors(q, 0), &distances(q, 0));
+    }
+  }
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_pq::host
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/ivf_pq_refine_host.cuh>
+#include <raft/neighbors/ivf_pq_types.hpp>
+
+namespace raft::neighbors::ivf_pq {
+
+/**
+ * @addtogroup ivf_pq
+ * @{
+ */
+
+/**
+ * @brief Search ANN using the constructed index and write the results to host memory.
+ *
+ * This is the same as `ivf_pq::search`, except the neighbors and distances are copied
+ * asynchronously to the host buffers in the stream order; they are ready once the stream of
+ * `handle` is synchronized. Use pinned buffers (e.g. `raft::make_pinned_matrix`) for the copies to
+ * be truly asynchronous.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] idx ivf-pq constructed index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, idx.dim()]
+ * @param[out] neighbors a host matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search_to_host(raft::resources const& handle,
+                    const search_params& params,
+                    const index<IdxT>& idx,
+                    raft::device_matrix_view<const T, uint32_t, row_major> queries,
+                    raft::host_matrix_view<IdxT, uint32_t, row_major> neighbors,
+                    raft::host_matrix_view<float, uint32_t, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  detail::search_to_host<T, IdxT>(handle,
+                                  params,
+                                  idx,
+                                  queries.data_handle(),
+                                  queries.extent(0),
+                                  neighbors.extent(1),
+                                  neighbors.data_handle(),
+                                  distances.data_handle());
+}
+
+/**
+ * @brief Search ANN on the GPU and refine the candidates with the exact distances on the CPU.
+ *
+ * The queries are processed in batches of `batch_size`. Every batch is searched for
+ * `n_candidates` neighbors, whose ids are copied to a pinned host buffer; the host then reranks
+ * the candidates of the batch using the original (host-resident) dataset, see
+ * `raft::neighbors::refine`. Two candidate buffers are used in turns, so the GPU search of a batch
+ * overlaps with the CPU rerank of the previous one.
+ *
+ * This is meant for the datasets that do not fit in the device memory: only the compressed index
+ * resides on the GPU. The metric of the index must be either L2 or the inner product.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // use default index parameters
+ *   ivf_pq::index_params index_params;
+ *   // create and fill the index from a [N, D] host dataset
+ *   auto index = ivf_pq::build(handle, index_params, dataset_host);
+ *   // use default search parameters
+ *   ivf_pq::search_params search_params;
+ *   // search 4 * k candidates on the GPU and rerank them on the CPU
+ *   ivf_pq::search_refine_host(
+ *     handle, search_params, index, dataset_host, queries_host, 4 * k, out_inds, out_dists);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] idx ivf-pq constructed index
+ * @param[in] dataset a host matrix view to the source dataset [n_rows, idx.dim()]
+ * @param[in] queries a host matrix view to a row-major matrix [n_queries, idx.dim()]
+ * @param[in] n_candidates the number of neighbors searched in the index per query (>= k)
+ * @param[out] neighbors a host matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ * @param[in] batch_size the number of queries searched on the GPU at once
+ */
+template <typename T, typename IdxT>
+void search_refine_host(raft::resources const& handle,
+                        const search_params& params,
+                        const index<IdxT>& idx,
+                        raft::host_matrix_view<const T, IdxT, row_major> dataset,
+                        raft::host_matrix_view<const T, IdxT, row_major> queries,
+                        uint32_t n_candidates,
+                        raft::host_matrix_view<IdxT, IdxT, row_major> neighbors,
+                        raft::host_matrix_view<float, IdxT, row_major> distances,
+                        uint32_t batch_size = 1024)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  RAFT_EXPECTS(queries.extent(1) == idx.dim() && dataset.extent(1) == idx.dim(),
+               "Number of query and dataset dimensions should equal the index dimension.");
+
+  detail::search_refine_host<T, IdxT>(
+    handle, params, idx, dataset, queries, n_candidates, neighbors, distances, batch_size);
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_pq
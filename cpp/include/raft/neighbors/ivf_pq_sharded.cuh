@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/ivf_pq_sharded.cuh>
+#include <raft/neighbors/ivf_pq_types.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::ivf_pq {
+
+/**
+ * @addtogroup ivf_pq
+ * @{
+ */
+
+/**
+ * @brief Build an IVF-PQ index with its lists partitioned across multiple GPUs.
+ *
+ * The cluster centers and the PQ codebooks are trained once on `device_ids[0]` and copied to the
+ * other devices; then, if `params.add_data_on_build` is set, every vector of the dataset is added
+ * to the shard owning its list (see `sharded_index::list_owner`). The devices are driven by
+ * separate host threads using the resources returned by
+ * `raft::device_resources_manager::get_device_resources(device_id)`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   int n_devices;
+ *   RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+ *   std::vector<int> device_ids(n_devices);
+ *   std::iota(device_ids.begin(), device_ids.end(), 0);
+ *   ivf_pq::index_params index_params;
+ *   auto index = ivf_pq::build_sharded(index_params, device_ids, raft::make_const_mdspan(dataset));
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] params configure the index building
+ * @param[in] device_ids the devices to place the shards on [n_shards]
+ * @param[in] dataset a host matrix view to a row-major matrix [n_rows, dim]
+ *
+ * @return the sharded ivf-pq index
+ */
+template <typename T, typename IdxT = int64_t>
+auto build_sharded(const index_params& params,
+                   const std::vector<int>& device_ids,
+                   raft::host_matrix_view<const T, IdxT, row_major> dataset)
+  -> sharded_index<IdxT>
+{
+  return detail::build_sharded<T, IdxT>(
+    params, device_ids, dataset.data_handle(), dataset.extent(0), dataset.extent(1));
+}
+
+/**
+ * @brief Extend a sharded index with new data.
+ *
+ * The new vectors are classified once on the first device, and each of them is added to the shard
+ * owning its list.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] new_vectors a host matrix view to a row-major matrix [n_rows, idx.dim()]
+ * @param[in] new_indices a host vector view to a vector of indices [n_rows].
+ *    If the original index is empty (`idx.size() == 0`), you can pass `std::nullopt`
+ *    here to imply a continuous range `[0...n_rows)`.
+ * @param[inout] idx
+ */
+template <typename T, typename IdxT>
+void extend_sharded(raft::host_matrix_view<const T, IdxT, row_major> new_vectors,
+                    std::optional<raft::host_vector_view<const IdxT, IdxT>> new_indices,
+                    sharded_index<IdxT>* idx)
+{
+  RAFT_EXPECTS(new_vectors.extent(1) == idx->dim(),
+               "new_vectors should have the same dimension as the index");
+  IdxT n_rows = new_vectors.extent(0);
+  if (new_indices.has_value()) {
+    RAFT_EXPECTS(n_rows == new_indices.value().extent(0),
+                 "new_vectors and new_indices have different number of rows");
+  }
+  detail::extend_sharded<T, IdxT>(
+    idx,
+    new_vectors.data_handle(),
+    new_indices.has_value() ? new_indices.value().data_handle() : nullptr,
+    n_rows);
+}
+
+/**
+ * @brief Search a sharded IVF-PQ index.
+ *
+ * The queries are searched concurrently in all shards. Each shard selects the `n_probes` closest
+ * clusters among all of them, but scans only the ones it owns; the per-shard top-k are then merged
+ * on the device of `handle` with `knn_merge_parts`. Hence the result is the same as the one of a
+ * single-GPU index holding all the lists.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle raft resources of the device holding the queries and receiving the results
+ * @param[in] params configure the search of every shard
+ * @param[in] idx sharded ivf-pq index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, idx.dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search_sharded(raft::resources const& handle,
+                    const search_params& params,
+                    const sharded_index<IdxT>& idx,
+                    raft::device_matrix_view<const T, uint32_t, row_major> queries,
+                    raft::device_matrix_view<IdxT, uint32_t, row_major> neighbors,
+                    raft::device_matrix_view<float, uint32_t, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  detail::search_sharded<T, IdxT>(handle,
+                                  params,
+                                  idx,
+                                  queries.data_handle(),
+                                  queries.extent(0),
+                                  neighbors.extent(1),
+                                  neighbors.data_handle(),
+                                  distances.data_handle());
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_pq
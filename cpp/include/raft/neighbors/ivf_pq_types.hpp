@@ -17,6 +17,7 @@
 #pragma once
 
 #include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_setter.hpp>
 #include <raft/core/error.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/mdspan_types.hpp>
@@ -29,7 +30,10 @@
 #include <thrust/fill.h>
 
 #include <memory>
+#include <mutex>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace raft::neighbors::ivf_pq {
 
@@ -94,6 +98,28 @@ struct index_params : ann::index_params {
    * regardless of the values of `dim` and `pq_dim`.
    */
   bool force_random_rotation = false;
+  /**
+   * The number of iterations of the optimized product quantization (OPQ) training of the rotation
+   * matrix. When non-zero, the rotation is learned by alternating the training of the PQ codebooks
+   * with an orthogonal Procrustes update of the rotation, which minimizes the quantization error of
+   * the training residuals. This allows a smaller `pq_dim` for the same recall, at the cost of a
+   * longer build.
+   *
+   * NB: only supported with `codebook_gen::PER_SUBSPACE`; the rotation starts from the one selected
+   * by `force_random_rotation`.
+   */
+  uint32_t opq_n_iters = 0;
+  /**
+   * The threshold `T` of the anisotropic (score-aware) quantization loss, relative to the norm of
+   * the data vectors. When non-zero, the PQ codebooks are refined to minimize the error of the
+   * inner products that are larger than `T * |x|` rather than the reconstruction error, favoring
+   * the accuracy of the component of the error parallel to the data vector by the ratio
+   * `eta = (dim - 1) * T^2 / (1 - T^2)`. This improves the recall of the maximum inner product
+   * search at a fixed `pq_dim`; 0.2 is a reasonable value to start with.
+   *
+   * NB: only supported with the `InnerProduct` metric; must be less than 1.
+   */
+  float anisotropic_quantization_threshold = 0.0f;
   /**
    * By default, the algorithm allocates more space than necessary for individual clusters
    * (`list_data`). This allows to amortize the cost of memory allocation and reduce the number of
@@ -173,10 +199,34 @@ struct search_params : ann::search_params {
    * performance if tweaked incorrectly.
    */
   double preferred_shmem_carveout = 1.0;
+  /**
+   * Stop probing the clusters of a query early, once the next cluster is far from the closest one
+   * or enough candidates have been collected (disabled by default).
+   *
+   * `n_probes` remains the upper bound of the probed clusters. Note, the look-up tables of the
+   * skipped clusters are still computed; only their lists are not scanned.
+   */
+  ivf::adaptive_probing adaptive_probes;
+};
+
+/** Parameters of `ivf_pq::rebalance`. */
+struct rebalance_params {
+  /** The lists larger than `max_list_size_ratio` times the mean list size are split in two. */
+  double max_list_size_ratio = 2.0;
+  /**
+   * The lists smaller than `min_list_size_ratio` times the mean list size (including the empty
+   * ones) are merged into their neighbors, which frees their slots for the split lists.
+   */
+  double min_list_size_ratio = 0.25;
+  /** The maximum number of lists to split in one call; zero means no limit. */
+  uint32_t max_splits = 0;
+  /** The number of iterations of the balanced k-means splitting a list. */
+  uint32_t kmeans_n_iters = 20;
 };
 
 static_assert(std::is_aggregate_v<index_params>);
 static_assert(std::is_aggregate_v<search_params>);
+static_assert(std::is_aggregate_v<rebalance_params>);
 
 /** Size of the interleaved group. */
 constexpr static uint32_t kIndexGroupSize = 32;
@@ -352,6 +402,13 @@ struct index : ann::index {
   {
     return conservative_memory_allocation_;
   }
+  /**
+   * Whether the data of the lists may be kept in the pinned host memory
+   * (see ivf_pq::helpers::move_lists_to_host).
+   */
+  [[nodiscard]] constexpr inline auto host_lists() const noexcept -> bool { return host_lists_; }
+  /** Mark the data of the lists as (possibly) kept in the pinned host memory. */
+  void set_host_lists(bool host_lists) noexcept { host_lists_ = host_lists; }
 
   // Don't allow copying the index for performance reasons (try avoiding copying data)
   index(const index&)                    = delete;
@@ -549,6 +606,7 @@ struct index : ann::index {
   uint32_t pq_bits_;
   uint32_t pq_dim_;
   bool conservative_memory_allocation_;
+  bool host_lists_ = false;
 
   // Primary data members
   std::vector<std::shared_ptr<list_data<IdxT>>> lists_;
@@ -603,6 +661,172 @@ struct index : ann::index {
   }
 };
 
+/**
+ * @brief Statistics of an IVF-PQ index (see `ivf_pq::helpers::stats`).
+ *
+ * The scan cost of the search is estimated under the assumption that the queries follow the
+ * distribution of the data: a probe then hits the list `l` with the probability
+ * `list_sizes[l] / size`.
+ */
+struct index_stats {
+  /** The sizes of the lists [n_lists]. */
+  std::vector<uint32_t> list_sizes;
+  /**
+   * The histogram of the list sizes in powers of two: the element `0` counts the empty lists, and
+   * the element `i > 0` counts the lists of size `[2^(i-1), 2^i)`.
+   */
+  std::vector<uint32_t> list_size_histogram;
+  /**
+   * The mean squared reconstruction error (the squared L2 distance between a vector and its
+   * decoded PQ code) of the records of each list [n_lists]; zero for the empty lists.
+   * Empty if no dataset was passed to `ivf_pq::helpers::stats`.
+   */
+  std::vector<float> list_reconstruction_mse;
+  /** The mean squared reconstruction error over all the records of the index. */
+  float reconstruction_mse = 0.0f;
+  /** The size of the largest list. */
+  uint32_t max_list_size = 0;
+  /** The mean size of the lists. */
+  double mean_list_size = 0.0;
+  /** The expected number of records scanned per probed list, `sum(size^2) / sum(size)`. */
+  double expected_scan_per_probe = 0.0;
+  /**
+   * The ratio of `expected_scan_per_probe` and `mean_list_size`: one for perfectly balanced lists,
+   * the slowdown of the search caused by the imbalance otherwise.
+   */
+  double imbalance_factor = 0.0;
+  /** The number of bytes read from the lists per scanned record (the PQ codes and the index). */
+  uint32_t bytes_per_record = 0;
+};
+
+/**
+ * @brief An IVF-PQ index that can be extended while it is being searched.
+ *
+ * The index is kept as a sequence of immutable versions. `snapshot()` returns the current version;
+ * an update (see `ivf_pq::extend` taking a `versioned_index`) builds the next version out of place
+ * and publishes it atomically. The new version shares with the previous one all the lists it does
+ * not reallocate, and the records it appends to a shared list lie beyond the list size recorded by
+ * the previous version. Hence a search running on an older snapshot is never affected by an
+ * update, and the updates do not need to stop the search traffic.
+ *
+ * A version is released when the last snapshot referring to it is dropped; keep the snapshot alive
+ * until the work submitted on it has completed.
+ *
+ * @tparam IdxT type of the indices in the source dataset
+ */
+template <typename IdxT>
+class versioned_index {
+ public:
+  explicit versioned_index(index<IdxT>&& idx)
+    : current_(std::make_shared<const index<IdxT>>(std::move(idx)))
+  {
+  }
+
+  /** The current version of the index. */
+  [[nodiscard]] auto snapshot() const -> std::shared_ptr<const index<IdxT>>
+  {
+    std::lock_guard<std::mutex> guard(current_mutex_);
+    return current_;
+  }
+
+  /**
+   * Replace the current version by `f(current)`, where `f` is a function
+   * `(const index<IdxT>&) -> index<IdxT>`. The updates are serialized, and the new version becomes
+   * visible to the readers only once `f` has returned.
+   */
+  template <typename UpdateF>
+  void update(UpdateF&& f)
+  {
+    std::lock_guard<std::mutex> guard(update_mutex_);
+    auto next = std::make_shared<const index<IdxT>>(f(*snapshot()));
+    std::lock_guard<std::mutex> publish_guard(current_mutex_);
+    current_.swap(next);
+  }
+
+ private:
+  mutable std::mutex current_mutex_;
+  std::mutex update_mutex_;
+  std::shared_ptr<const index<IdxT>> current_;
+};
+
+/**
+ * @brief IVF-PQ index with its lists partitioned across multiple GPUs.
+ *
+ * Every shard is a complete IVF-PQ index residing on its device: all shards share the same
+ * cluster centers and PQ codebooks, but a shard only stores the data of the lists it owns, so the
+ * capacity of the index grows with the number of devices. The list `label` is owned by the shard
+ * `label % n_shards()`. The lists store the global ids of the vectors.
+ *
+ * @tparam IdxT type of the indices in the source dataset
+ */
+template <typename IdxT>
+struct sharded_index : ann::index {
+ public:
+  sharded_index(std::vector<int> device_ids, std::vector<index<IdxT>>&& shards)
+    : device_ids_(std::move(device_ids)), shards_(std::move(shards))
+  {
+    RAFT_EXPECTS(!shards_.empty() && device_ids_.size() == shards_.size(),
+                 "Each shard must have a device id");
+  }
+
+  sharded_index(const sharded_index&)                    = delete;
+  sharded_index(sharded_index&&)                         = default;
+  auto operator=(const sharded_index&) -> sharded_index& = delete;
+  auto operator=(sharded_index&&) -> sharded_index&      = default;
+  ~sharded_index() noexcept
+  {
+    // Release the memory of each shard on its own device.
+    while (!shards_.empty()) {
+      raft::device_setter dev(device_ids_[shards_.size() - 1]);
+      shards_.pop_back();
+    }
+  }
+
+  /** Number of shards (devices). */
+  [[nodiscard]] inline auto n_shards() const noexcept -> size_t { return shards_.size(); }
+  /** Total number of vectors in the index. */
+  [[nodiscard]] inline auto size() const noexcept -> IdxT
+  {
+    IdxT total = 0;
+    for (const auto& shard : shards_) {
+      total += shard.size();
+    }
+    return total;
+  }
+  /** Dimensionality of the data. */
+  [[nodiscard]] inline auto dim() const noexcept -> uint32_t { return shards_.front().dim(); }
+  /** Number of clusters/inverted lists, shared by all shards. */
+  [[nodiscard]] inline auto n_lists() const noexcept -> uint32_t
+  {
+    return shards_.front().n_lists();
+  }
+  /** Distance metric used for clustering. */
+  [[nodiscard]] inline auto metric() const noexcept -> raft::distance::DistanceType
+  {
+    return shards_.front().metric();
+  }
+  /** The shard owning the list `label`. */
+  [[nodiscard]] inline auto list_owner(uint32_t label) const noexcept -> size_t
+  {
+    return label % shards_.size();
+  }
+  /** Ids of the devices holding the shards [n_shards]. */
+  [[nodiscard]] inline auto device_ids() const noexcept -> const std::vector<int>&
+  {
+    return device_ids_;
+  }
+  /** The index of a shard; it resides on the device `device_ids()[i]`. */
+  [[nodiscard]] inline auto shard(size_t i) noexcept -> index<IdxT>& { return shards_[i]; }
+  [[nodiscard]] inline auto shard(size_t i) const noexcept -> const index<IdxT>&
+  {
+    return shards_[i];
+  }
+
+ private:
+  std::vector<int> device_ids_;
+  std::vector<index<IdxT>> shards_;
+};
+
 /** @} */
 
 }  // namespace raft::neighbors::ivf_pq
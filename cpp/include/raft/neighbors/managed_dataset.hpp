@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/managed_mdarray.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_id.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/dataset.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+namespace raft::neighbors {
+
+/**
+ * @defgroup managed_dataset Datasets in the managed memory
+ * @{
+ */
+
+namespace detail {
+
+/** Whether the device migrates the managed memory on demand (and accepts the advice). */
+inline auto managed_memory_hints_supported(int device_id) -> bool
+{
+  int concurrent = 0;
+  RAFT_CUDA_TRY(
+    cudaDeviceGetAttribute(&concurrent, cudaDevAttrConcurrentManagedAccess, device_id));
+  return concurrent != 0;
+}
+
+inline auto is_managed_pointer(const void* ptr) -> bool
+{
+  cudaPointerAttributes attrs;
+  RAFT_CUDA_TRY(cudaPointerGetAttributes(&attrs, ptr));
+  return attrs.type == cudaMemoryTypeManaged;
+}
+
+}  // namespace detail
+
+/**
+ * @brief A dataset in the CUDA managed memory, which may be larger than the device memory.
+ *
+ * Left alone, the managed memory migrates by page faults, which serializes the search kernels on
+ * the fault handling. This dataset advises the driver that the data is read-mostly (so evicting
+ * the device copy costs no write-back) and preferably resides on (and is accessed by) the device;
+ * the searches then call `prefetch_rows` with the rows they are about to touch (e.g. the
+ * candidates of a refinement), which migrates them with a few bulk transfers on the stream.
+ *
+ * On the devices without the concurrent managed access (e.g. on Windows) the hints are no-ops.
+ *
+ * Create with `make_managed_dataset`; the dataset plugs into the indexes taking a
+ * `neighbors::dataset`, e.g. `cagra::index::update_dataset`.
+ *
+ * @tparam DataT data element type
+ * @tparam IdxT type of the row indices
+ */
+template <typename DataT, typename IdxT>
+struct managed_dataset : public strided_dataset<DataT, IdxT> {
+  using index_type = IdxT;
+  using value_type = DataT;
+  using typename strided_dataset<value_type, index_type>::view_type;
+  using storage_type = managed_matrix<value_type, index_type, row_major>;
+
+  /** The rows closer than this many bytes to each other are prefetched by one transfer. */
+  static constexpr size_t kPrefetchMergeBytes = 2 * 1024 * 1024;
+
+  managed_dataset(raft::resources const& res, storage_type&& store, uint32_t dim)
+    : data_{std::move(store)},
+      dim_{dim},
+      device_id_{resource::get_device_id(res)},
+      hints_supported_{detail::managed_memory_hints_supported(device_id_)}
+  {
+    if (!hints_supported_ || data_.size() == 0) { return; }
+    const size_t bytes = data_.size() * sizeof(value_type);
+    RAFT_CUDA_TRY(
+      cudaMemAdvise(data_.data_handle(), bytes, cudaMemAdviseSetReadMostly, device_id_));
+    RAFT_CUDA_TRY(
+      cudaMemAdvise(data_.data_handle(), bytes, cudaMemAdviseSetPreferredLocation, device_id_));
+    RAFT_CUDA_TRY(
+      cudaMemAdvise(data_.data_handle(), bytes, cudaMemAdviseSetAccessedBy, device_id_));
+  }
+
+  [[nodiscard]] auto is_owning() const noexcept -> bool final { return true; }
+  [[nodiscard]] auto view() const noexcept -> view_type final
+  {
+    return make_device_strided_matrix_view<const value_type, index_type>(
+      data_.data_handle(), data_.extent(0), dim_, data_.extent(1));
+  }
+
+  /** Migrate the rows [first_row, first_row + n_rows) to the device on the stream of `res`. */
+  void prefetch(raft::resources const& res, index_type first_row, index_type n_rows) const
+  {
+    if (n_rows <= 0) { return; }
+    RAFT_EXPECTS(uint64_t(first_row) + uint64_t(n_rows) <= uint64_t(data_.extent(0)),
+                 "The rows to prefetch are out of the dataset bounds");
+    prefetch_bytes(res, size_t(first_row) * row_bytes(), size_t(n_rows) * row_bytes(), device_id_);
+  }
+
+  /** Migrate the whole dataset to the device on the stream of `res`. */
+  void prefetch(raft::resources const& res) const { prefetch(res, 0, data_.extent(0)); }
+
+  /**
+   * @brief Migrate the given rows to the device on the stream of `res`.
+   *
+   * The rows are sorted and the ones closer than `kPrefetchMergeBytes` are merged into one range,
+   * so a batch of the candidate ids costs a few large transfers rather than a transfer per row.
+   * The ids outside of the dataset (e.g. the invalid neighbors) are ignored.
+   *
+   * @param[in] res raft resources
+   * @param[in] rows the ids of the rows to prefetch
+   */
+  void prefetch_rows(raft::resources const& res,
+                     raft::host_vector_view<const index_type, int64_t> rows) const
+  {
+    if (!hints_supported_ || rows.extent(0) == 0) { return; }
+    common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+      "managed_dataset::prefetch_rows(%zu)", size_t(rows.extent(0)));
+    const index_type n_rows = data_.extent(0);
+    std::vector<index_type> sorted;
+    sorted.reserve(rows.extent(0));
+    std::copy_if(rows.data_handle(),
+                 rows.data_handle() + rows.extent(0),
+                 std::back_inserter(sorted),
+                 [n_rows](index_type i) { return uint64_t(i) < uint64_t(n_rows); });
+    std::sort(sorted.begin(), sorted.end());
+
+    const size_t rb = row_bytes();
+    size_t begin    = 0;
+    size_t end      = 0;
+    for (auto i : sorted) {
+      const size_t row_begin = size_t(i) * rb;
+      if (end > begin && row_begin <= end + kPrefetchMergeBytes) {
+        end = std::max(end, row_begin + rb);
+        continue;
+      }
+      if (end > begin) { prefetch_bytes(res, begin, end - begin, device_id_); }
+      begin = row_begin;
+      end   = row_begin + rb;
+    }
+    if (end > begin) { prefetch_bytes(res, begin, end - begin, device_id_); }
+  }
+
+  /** Migrate the whole dataset back to the host to free the device memory for other work. */
+  void evict(raft::resources const& res) const
+  {
+    prefetch_bytes(res, 0, data_.size() * sizeof(value_type), cudaCpuDeviceId);
+  }
+
+ private:
+  [[nodiscard]] auto row_bytes() const noexcept -> size_t
+  {
+    return size_t(data_.extent(1)) * sizeof(value_type);
+  }
+
+  void prefetch_bytes(raft::resources const& res, size_t offset, size_t bytes, int device) const
+  {
+    if (!hints_supported_ || bytes == 0) { return; }
+    RAFT_CUDA_TRY(
+      cudaMemPrefetchAsync(reinterpret_cast<const uint8_t*>(data_.data_handle()) + offset,
+                           bytes,
+                           device,
+                           resource::get_cuda_stream(res)));
+  }
+
+  storage_type data_;
+  uint32_t dim_;
+  int device_id_;
+  bool hints_supported_;
+};
+
+/**
+ * @brief Copy a dataset into the managed memory, with the rows aligned to `align_bytes`.
+ *
+ * The source can be in any memory accessible by `cudaMemcpy2D` (e.g. a host matrix).
+ *
+ * @code{.cpp}
+ *   auto dataset = raft::neighbors::make_managed_dataset(res, host_dataset.view());
+ *   index.update_dataset(res, std::move(dataset));
+ * @endcode
+ *
+ * @param[in] res raft resources
+ * @param[in] src the source mdarray or mdspan [n_rows, dim]
+ * @param[in] align_bytes the required byte alignment of the dataset rows
+ */
+template <typename SrcT>
+auto make_managed_dataset(const raft::resources& res, const SrcT& src, uint32_t align_bytes = 16)
+  -> std::unique_ptr<managed_dataset<typename SrcT::value_type, typename SrcT::index_type>>
+{
+  using value_type       = typename SrcT::value_type;
+  using index_type       = typename SrcT::index_type;
+  constexpr size_t kSize = sizeof(value_type);
+  static_assert(SrcT::extents_type::rank() == 2, "The input must be a matrix.");
+  RAFT_EXPECTS(src.stride(1) <= 1, "The input must be row-major");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "make_managed_dataset(%zu, %zu)", size_t(src.extent(0)), size_t(src.extent(1)));
+  const auto stride = static_cast<index_type>(
+    raft::round_up_safe<size_t>(src.extent(1) * kSize, std::lcm(align_bytes, kSize)) / kSize);
+  const size_t src_stride = src.stride(0) > 0 ? src.stride(0) : src.extent(1);
+  auto stream             = resource::get_cuda_stream(res);
+
+  auto store = make_managed_matrix<value_type, index_type>(res, src.extent(0), stride);
+  RAFT_CUDA_TRY(cudaMemsetAsync(store.data_handle(), 0, store.size() * kSize, stream));
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(store.data_handle(),
+                                  kSize * stride,
+                                  src.data_handle(),
+                                  kSize * src_stride,
+                                  kSize * src.extent(1),
+                                  src.extent(0),
+                                  cudaMemcpyDefault,
+                                  stream));
+  return std::make_unique<managed_dataset<value_type, index_type>>(
+    res, std::move(store), static_cast<uint32_t>(src.extent(1)));
+}
+
+/**
+ * @brief Migrate the IVF lists (IVF-Flat or IVF-PQ) the search is about to probe to the device.
+ *
+ * This helps when the lists are allocated in the managed memory to oversubscribe the device
+ * memory, e.g. after
+ * `resource::set_ivf_list_resource(res, std::make_shared<rmm::mr::managed_memory_resource>())`.
+ * The probed lists are known from the coarse search before the fine search starts; the lists that
+ * are not in the managed memory are skipped.
+ *
+ * @param[in] res raft resources
+ * @param[in] lists the lists of the index (`index.lists()`)
+ * @param[in] labels the lists to prefetch (duplicates are fine)
+ */
+template <typename ListT>
+void prefetch_lists(raft::resources const& res,
+                    const std::vector<std::shared_ptr<ListT>>& lists,
+                    raft::host_vector_view<const uint32_t, int64_t> labels)
+{
+  const int device_id = resource::get_device_id(res);
+  if (!detail::managed_memory_hints_supported(device_id)) { return; }
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("ivf::prefetch_lists(%zu)",
+                                                            size_t(labels.extent(0)));
+  auto stream = resource::get_cuda_stream(res);
+  std::unordered_set<uint32_t> done;
+  for (int64_t i = 0; i < labels.extent(0); i++) {
+    const auto label = labels(i);
+    if (label >= lists.size() || !done.insert(label).second) { continue; }
+    const auto& list = lists[label];
+    if (!list || list->data.size() == 0) { continue; }
+    if (!detail::is_managed_pointer(list->data.data_handle())) { continue; }
+    RAFT_CUDA_TRY(cudaMemPrefetchAsync(list->data.data_handle(),
+                                       list->data.size() * sizeof(typename ListT::value_type),
+                                       device_id,
+                                       stream));
+    RAFT_CUDA_TRY(cudaMemPrefetchAsync(list->indices.data_handle(),
+                                       list->indices.size() * sizeof(typename ListT::index_type),
+                                       device_id,
+                                       stream));
+  }
+}
+
+/** @} */
+
+}  // namespace raft::neighbors
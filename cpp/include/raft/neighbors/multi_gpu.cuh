@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/comms/nccl_clique.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/neighbors/detail/multi_gpu.cuh>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::mg {
+
+/**
+ * @defgroup mg_search Single-process multi-GPU search over a NCCL clique
+ * @{
+ */
+
+/**
+ * @brief Search an index replicated on all the GPUs of a NCCL clique.
+ *
+ * The queries are split evenly between the ranks of the clique; every rank copies its slice from
+ * the host by batches of `n_rows_per_batch` rows, searches them with its copy of the index, and
+ * copies the results back to the host. The ranks are driven by separate host threads.
+ *
+ * `search` is called as `search(res, index, queries, neighbors, distances)` on the thread of a
+ * rank, with the `raft::device_resources` of the rank, its index and device matrix views
+ * (`[n, dim]`, `[n, k]` and `[n, k]`, with `int64_t` extents), and must write to the outputs on the
+ * stream of `res`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto& clique = raft::resource::get_nccl_clique(res);
+ *   std::vector<brute_force::index<float>> indices;  // indices[i] lives on clique.device_ids_[i]
+ *   ...
+ *   mg::search_replicated(
+ *     clique,
+ *     indices,
+ *     [](const raft::device_resources& dev_res, const auto& index, auto q, auto n, auto d) {
+ *       brute_force::search(dev_res, index, q, n, d);
+ *     },
+ *     queries,
+ *     neighbors,
+ *     distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @tparam IndexT type of the index
+ * @tparam SearchF type of the search function
+ *
+ * @param[in] clique the NCCL clique whose devices hold the indices
+ * @param[in] indices the copies of the index, `indices[i]` living on `clique.device_ids_[i]`
+ * @param[in] search the search function of the index
+ * @param[in] queries a host matrix view to a row-major matrix [n_queries, dim]
+ * @param[out] neighbors a host matrix view to the indices of the neighbors [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the neighbors [n_queries, k]
+ * @param[in] n_rows_per_batch the number of queries searched at once by a rank
+ */
+template <typename T, typename IdxT, typename IndexT, typename SearchF>
+void search_replicated(const raft::comms::nccl_clique& clique,
+                       const std::vector<IndexT>& indices,
+                       SearchF&& search,
+                       raft::host_matrix_view<const T, int64_t, row_major> queries,
+                       raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+                       raft::host_matrix_view<float, int64_t, row_major> distances,
+                       int64_t n_rows_per_batch = 65536)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  detail::search_replicated<T, IdxT>(clique.device_ids_,
+                                     clique.device_resources_,
+                                     indices,
+                                     search,
+                                     queries,
+                                     neighbors,
+                                     distances,
+                                     n_rows_per_batch);
+}
+
+/**
+ * @brief Search an index sharded over the GPUs of a NCCL clique.
+ *
+ * The queries are processed by batches of `n_rows_per_batch` rows: every batch is copied to the
+ * root rank and broadcast to all the ranks with NCCL, every rank searches its shard (on its own
+ * host thread), and the top-k of the shards are gathered on the root rank with NCCL and merged
+ * there with `knn_merge_parts`. The result is the one of a single index holding all the shards.
+ *
+ * `search` is called as in `search_replicated`. The neighbors are translated to the global ids by
+ * adding the offset of their shard, `id_offsets`, when given (e.g. the number of rows in the
+ * previous shards, when each shard numbers its rows from 0).
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @tparam IndexT type of the index
+ * @tparam SearchF type of the search function
+ *
+ * @param[in] clique the NCCL clique whose devices hold the shards
+ * @param[in] shards the shards of the index, `shards[i]` living on `clique.device_ids_[i]`
+ * @param[in] search the search function of the shards
+ * @param[in] queries a host matrix view to a row-major matrix [n_queries, dim]
+ * @param[out] neighbors a host matrix view to the indices of the neighbors [n_queries, k]
+ * @param[out] distances a host matrix view to the distances to the neighbors [n_queries, k]
+ * @param[in] n_rows_per_batch the number of queries searched at once
+ * @param[in] id_offsets the offset of the ids of every shard [n_shards]
+ * @param[in] select_min whether the neighbors are the smallest distances (or the largest, e.g. for
+ * the inner product)
+ */
+template <typename T, typename IdxT, typename IndexT, typename SearchF>
+void search_sharded(const raft::comms::nccl_clique& clique,
+                    const std::vector<IndexT>& shards,
+                    SearchF&& search,
+                    raft::host_matrix_view<const T, int64_t, row_major> queries,
+                    raft::host_matrix_view<IdxT, int64_t, row_major> neighbors,
+                    raft::host_matrix_view<float, int64_t, row_major> distances,
+                    int64_t n_rows_per_batch                           = 65536,
+                    const std::optional<std::vector<IdxT>>& id_offsets = std::nullopt,
+                    bool select_min                                    = true)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  detail::search_sharded<T, IdxT>(clique.device_ids_,
+                                  clique.device_resources_,
+                                  clique.root_rank_,
+                                  shards,
+                                  search,
+                                  queries,
+                                  neighbors,
+                                  distances,
+                                  n_rows_per_batch,
+                                  id_offsets,
+                                  select_min);
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::mg
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/multi_vector.cuh>
+#include <raft/neighbors/multi_vector_types.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace raft::neighbors::multi_vector {
+
+/**
+ * @defgroup multi_vector Multi-vector (late-interaction) search
+ * @{
+ */
+
+/**
+ * @brief Build the multi-vector index of the documents from the offsets of their tokens.
+ *
+ * The token vectors of all documents are indexed separately (e.g. by IVF-PQ or CAGRA), in the
+ * order of the documents.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // the tokens of the document i are the rows [doc_offsets[i], doc_offsets[i + 1])
+ *   auto token_index = cagra::build<float, uint32_t>(res, cagra::index_params{}, tokens);
+ *   auto index       = multi_vector::build(res, doc_offsets);
+ * @endcode
+ *
+ * @param[in] res raft resources
+ * @param[in] doc_offsets the id of the first token of every document, followed by the total
+ *   number of the tokens [n_docs + 1]; it must start at zero and must not decrease
+ *
+ * @return the constructed index
+ */
+inline auto build(raft::resources const& res,
+                  raft::device_vector_view<const int64_t, int64_t> doc_offsets) -> index
+{
+  return detail::build(res, doc_offsets);
+}
+
+/**
+ * @brief Search the documents with the best MaxSim scores for the multi-vector queries.
+ *
+ * The tokens of all queries are searched by `token_search` in one batch. Every token candidate is
+ * mapped to its document, and the per-document MaxSim is computed on the device by the segmented
+ * reductions of the candidates: the maximum over the tokens of the document for every query token,
+ * then the sum over the query tokens. The query tokens that found no token of a document do not
+ * add to its score (the usual approximation of the late-interaction candidate generation).
+ *
+ * If `token_dataset` is given, the best `n_rerank_candidates` documents of every query are
+ * re-scored by the exact MaxSim over all of their tokens before the final selection.
+ *
+ * `token_search` wraps the token-level index like in `dynamic_batching::batcher`: it is called as
+ * `token_search(res, queries, neighbors, distances)` with device matrix views (`[n_rows, dim]`,
+ * `[n_rows, n_token_candidates]` and `[n_rows, n_token_candidates]`, with `int64_t` extents);
+ * the ids out of range mark the missing candidates and are skipped.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   multi_vector::search<float, uint32_t>(
+ *     res, multi_vector::search_params{}, index,
+ *     [&token_index](const raft::resources& res, auto q, auto n, auto d) {
+ *       cagra::search(res, cagra::search_params{}, token_index, q, n, d);
+ *     },
+ *     query_tokens, 32, neighbors, scores);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the token indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx the multi-vector index
+ * @param[in] token_search the search of the token-level index
+ * @param[in] queries the tokens of the queries, `n_query_tokens` rows per query
+ *   [n_queries * n_query_tokens, dim]
+ * @param[in] n_query_tokens the number of the tokens of every query
+ * @param[out] neighbors the ids of the best documents of every query [n_queries, k]; the missing
+ *   ones (if fewer than k documents were found) are `numeric_limits<int64_t>::max()`
+ * @param[out] scores the MaxSim scores of the documents [n_queries, k]
+ * @param[in] token_dataset optional token vectors of the index [n_tokens, dim] to re-score the
+ *   candidates exactly (with the inner product or the squared L2 similarity only)
+ */
+template <typename T, typename IdxT, typename TokenSearchFn>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index& idx,
+            TokenSearchFn&& token_search,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            int64_t n_query_tokens,
+            raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+            raft::device_matrix_view<float, int64_t, row_major> scores,
+            std::optional<raft::device_matrix_view<const T, int64_t, row_major>> token_dataset =
+              std::nullopt)
+{
+  detail::search<T, IdxT>(res,
+                          params,
+                          idx,
+                          std::forward<TokenSearchFn>(token_search),
+                          queries,
+                          n_query_tokens,
+                          neighbors,
+                          scores,
+                          token_dataset);
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::multi_vector
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ann_types.hpp"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+
+#include <cstdint>
+
+namespace raft::neighbors::multi_vector {
+
+/**
+ * @addtogroup multi_vector
+ * @{
+ */
+
+struct search_params : ann::search_params {
+  /** The number of the tokens searched for every query token (the k of the token search). */
+  uint32_t n_token_candidates = 64;
+  /**
+   * The number of the documents of every query re-scored by the exact MaxSim when the token
+   * vectors are given to the search (at least k).
+   */
+  uint32_t n_rerank_candidates = 256;
+  /**
+   * The metric of the token distances: the similarity of two tokens is their inner product, or
+   * the negated distance for the metrics where the smaller distances are better.
+   */
+  raft::distance::DistanceType metric = raft::distance::DistanceType::InnerProduct;
+};
+
+/**
+ * @brief A multi-vector (late-interaction) index of the documents over a token-level index.
+ *
+ * Every document is a contiguous range of the token vectors, as in ColBERT: the tokens of the
+ * document `i` are the rows `[doc_offsets[i], doc_offsets[i + 1])` of the token-level index (e.g.
+ * IVF-PQ or CAGRA built over all the token vectors). The multi-vector index only keeps these
+ * offsets; the token-level index is searched through a callback.
+ *
+ * The score of a document for a query is the MaxSim: the sum over the query tokens of their best
+ * similarity to a token of the document.
+ */
+struct index : ann::index {
+ public:
+  index(const index&)                    = delete;
+  index(index&&)                         = default;
+  auto operator=(const index&) -> index& = delete;
+  auto operator=(index&&) -> index&      = default;
+  ~index()                               = default;
+
+  /** Construct an index of `n_docs` documents of `n_tokens` tokens in total. */
+  index(raft::resources const& res, int64_t n_docs, int64_t n_tokens)
+    : ann::index(),
+      n_tokens_(n_tokens),
+      doc_offsets_(raft::make_device_vector<int64_t, int64_t>(res, n_docs + 1))
+  {
+  }
+
+  /** The number of the documents. */
+  [[nodiscard]] inline auto n_docs() const noexcept -> int64_t
+  {
+    return doc_offsets_.extent(0) - 1;
+  }
+  /** The total number of the tokens of all documents (the size of the token-level index). */
+  [[nodiscard]] inline auto n_tokens() const noexcept -> int64_t { return n_tokens_; }
+
+  /** The id of the first token of every document, and the number of the tokens [n_docs + 1]. */
+  inline auto doc_offsets() noexcept -> device_vector_view<int64_t, int64_t>
+  {
+    return doc_offsets_.view();
+  }
+  [[nodiscard]] inline auto doc_offsets() const noexcept
+    -> device_vector_view<const int64_t, int64_t>
+  {
+    return doc_offsets_.view();
+  }
+
+ private:
+  int64_t n_tokens_;
+  raft::device_vector<int64_t, int64_t> doc_offsets_;
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::multi_vector
@@ -21,8 +21,12 @@
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdspan.hpp>
+#include <raft/core/logger.hpp>
 #include <raft/neighbors/nn_descent.cuh>
 
+#include <algorithm>
+#include <vector>
+
 namespace raft::neighbors::experimental::nn_descent {
 
 /**
@@ -35,6 +39,8 @@ namespace raft::neighbors::experimental::nn_descent {
  *
  * The following distance metrics are supported:
  * - L2
+ * - InnerProduct
+ * - CosineExpanded
  *
  * Usage example:
  * @code{.cpp}
@@ -77,6 +83,8 @@ index<IdxT> build(raft::resources const& res,
  *
  * The following distance metrics are supported:
  * - L2
+ * - InnerProduct
+ * - CosineExpanded
  *
  * Usage example:
  * @code{.cpp}
@@ -119,6 +127,8 @@ void build(raft::resources const& res,
  *
  * The following distance metrics are supported:
  * - L2
+ * - InnerProduct
+ * - CosineExpanded
  *
  * Usage example:
  * @code{.cpp}
@@ -161,6 +171,8 @@ index<IdxT> build(raft::resources const& res,
  *
  * The following distance metrics are supported:
  * - L2
+ * - InnerProduct
+ * - CosineExpanded
  *
  * Usage example:
  * @code{.cpp}
@@ -198,6 +210,62 @@ void build(raft::resources const& res,
   detail::build<T, IdxT>(res, params, dataset, idx, distance_epilogue);
 }
 
+/**
+ * @brief Build nn-descent Index on several devices with dataset in host memory
+ *
+ * This is the batched build (see `index_params::n_clusters`) distributed over the devices. The data
+ * points are assigned to the clusters once, on the device of `res`. Then one host thread per device
+ * repeatedly takes the next cluster, builds its subgraph with a GNND of its own and merges it into
+ * the global graph shared by all the devices (the merges themselves are serialized). Hence the
+ * build scales with the number of devices as long as there are enough clusters to keep them busy;
+ * `n_clusters` is raised to at least the number of devices (and at least two).
+ *
+ * The resources of the devices are taken from `raft::device_resources_manager`. The distance
+ * epilogue is copied to every device, hence it must not refer to the memory of one device.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors::experimental;
+ *   nn_descent::index_params index_params;
+ *   index_params.n_clusters = 4 * n_devices;
+ *   std::vector<int> device_ids(n_devices);
+ *   std::iota(device_ids.begin(), device_ids.end(), 0);
+ *   // create and fill the index from a [N, D] raft::host_matrix_view dataset
+ *   auto index = nn_descent::build_multi_device(res, index_params, device_ids, dataset);
+ * @endcode
+ *
+ * @tparam T data-type of the input dataset
+ * @tparam IdxT data-type for the output index
+ * @tparam epilogue_op epilogue operation type for distances
+ * @param[in] res raft::resources is an object mangaging resources; the clustering runs and the
+ *               output index is allocated on its device
+ * @param[in] params an instance of nn_descent::index_params that are parameters
+ *               to run the nn-descent algorithm
+ * @param[in] device_ids the devices to build the subgraphs of the clusters on
+ * @param[in] dataset raft::host_matrix_view input dataset expected to be located
+ *                in host memory
+ * @param[in] distance_epilogue epilogue operation for distances
+ * @return index<IdxT> index containing all-neighbors knn graph in host memory
+ */
+template <typename T, typename IdxT = uint32_t, typename epilogue_op = DistEpilogue<IdxT, T>>
+index<IdxT> build_multi_device(raft::resources const& res,
+                               index_params const& params,
+                               const std::vector<int>& device_ids,
+                               raft::host_matrix_view<const T, int64_t, row_major> dataset,
+                               epilogue_op distance_epilogue = DistEpilogue<IdxT, T>())
+{
+  RAFT_EXPECTS(!device_ids.empty(), "At least one device is needed to build the index");
+  auto batch_params         = params;
+  const size_t min_clusters = std::max<size_t>(2, device_ids.size());
+  if (batch_params.n_clusters < min_clusters) {
+    RAFT_LOG_WARN("The multi-device build needs at least %zu clusters, raising n_clusters from %zu",
+                  min_clusters,
+                  params.n_clusters);
+    batch_params.n_clusters = min_clusters;
+  }
+  return detail::batch_build<T, IdxT>(res, batch_params, dataset, distance_epilogue, device_ids);
+}
+
 /** @} */  // end group nn-descent
 
 }  // namespace raft::neighbors::experimental::nn_descent
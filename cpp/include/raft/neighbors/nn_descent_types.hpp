@@ -27,7 +27,10 @@
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
 
+#include <cstdint>
+#include <functional>
 #include <optional>
+#include <string>
 
 namespace raft::neighbors::experimental::nn_descent {
 /**
@@ -35,6 +38,31 @@ namespace raft::neighbors::experimental::nn_descent {
  * @{
  */
 
+/**
+ * @brief The progress of the nn-descent build, reported after each iteration.
+ *
+ * The number of updates is estimated from a sample of the rows, the same way as for the
+ * `termination_threshold`: the build terminates once the `update_rate` falls below it.
+ */
+struct iteration_stats {
+  /** The iteration, starting from 1. */
+  size_t iteration;
+  /** The estimated number of the knn-list updates made by the iteration. */
+  int64_t updates;
+  /** The updates per row and dimension; compared to `index_params::termination_threshold`. */
+  double update_rate;
+  /** The wall time of the iteration [ms]. */
+  double iteration_ms;
+  /** The wall time of all the iterations so far [ms]. */
+  double total_ms;
+};
+
+/**
+ * @brief A callback invoked after each nn-descent iteration. Returning `false` stops the build,
+ * which then finalizes the graph found so far.
+ */
+using iteration_callback = std::function<bool(const iteration_stats&)>;
+
 /**
  * @brief Parameters used to build an nn-descent index
  *
@@ -49,6 +77,9 @@ namespace raft::neighbors::experimental::nn_descent {
  * the graph for. More iterations produce a better quality graph at cost of performance
  * `termination_threshold`: The delta at which nn-descent will terminate its iterations
  * `return_distances`: boolean whether to return distances
+ * `metric`: L2Expanded (default), InnerProduct or CosineExpanded. The build minimizes the
+ * distances, finding the largest inner products; the returned distances of the InnerProduct metric
+ * are the inner products themselves, those of CosineExpanded are `1 - cos`.
  * `n_clusters`: NN Descent offers batching a dataset to save GPU memory usage.
  * Increase `n_clusters` to save GPU memory and run NN Descent with large datasets.
  * Most effective when data is put on CPU memory.
@@ -62,15 +93,30 @@ namespace raft::neighbors::experimental::nn_descent {
  * useful when the dataset is put on host, since only a subset of the data will
  * be on GPU at once, enabling running NN Descent with large datasets that do not
  * fit on the GPU as a whole.)
+ * `on_iteration`: An optional callback receiving the `iteration_stats` of every iteration, e.g. to
+ * monitor the convergence. Returning `false` from it stops the build early. With n_clusters > 1
+ * it is invoked for the iterations of every cluster (concurrently, in a multi-device build).
+ * `max_time_per_update_us`: If positive, the build stops once an iteration takes longer than this
+ * budget (in microseconds) per update, i.e. once the remaining iterations improve the graph too
+ * slowly to be worth their time.
+ * `spill_directory`: With n_clusters > 1, a directory (preferably on a fast local disk, such
+ * as NVMe) for the out-of-core build. The global graph that the cluster subgraphs are merged into
+ * is then kept in memory-mapped files in this directory rather than in managed memory; the rows of
+ * each cluster are streamed to the device for the merge and written back afterwards. Together with
+ * a host dataset backed by a memory-mapped file, this lets the build scale beyond the host memory.
+ * The files are removed automatically. Leave empty (default) to keep the global graph in memory.
  *
  */
 struct index_params : ann::index_params {
-  size_t graph_degree              = 64;      // Degree of output graph.
-  size_t intermediate_graph_degree = 128;     // Degree of input graph for pruning.
-  size_t max_iterations            = 20;      // Number of nn-descent iterations.
-  float termination_threshold      = 0.0001;  // Termination threshold of nn-descent.
-  bool return_distances            = false;   // return distances if true
-  size_t n_clusters                = 1;       // defaults to not using any batching
+  size_t graph_degree              = 64;       // Degree of output graph.
+  size_t intermediate_graph_degree = 128;      // Degree of input graph for pruning.
+  size_t max_iterations            = 20;       // Number of nn-descent iterations.
+  float termination_threshold      = 0.0001;   // Termination threshold of nn-descent.
+  bool return_distances            = false;    // return distances if true
+  size_t n_clusters                = 1;        // defaults to not using any batching
+  std::string spill_directory      = "";       // out-of-core batched build if not empty
+  iteration_callback on_iteration  = nullptr;  // called after each iteration if set
+  double max_time_per_update_us    = 0;        // iteration time budget per update if positive
 };
 
 /**
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/gather.cuh>
+#include <raft/neighbors/detail/query_cache.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace raft::neighbors::query_cache {
+
+/**
+ * @defgroup query_cache Device-side cache of the search results of repeated queries
+ * @{
+ */
+
+struct cache_params {
+  /** The maximum number of the cached queries. */
+  int64_t capacity = 65536;
+  /**
+   * The number of the entries of a cache set (at most 32). A query can be cached only in the set
+   * chosen by its hash; the least recently used entry of the set is replaced by a new query.
+   */
+  uint32_t associativity = 8;
+  /**
+   * The queries are compared after rounding their components to the multiples of this step, so
+   * that the near-duplicate queries share their results. Zero means the queries must be exactly
+   * equal.
+   */
+  float quantization_step = 0.0f;
+};
+
+/**
+ * @brief A cache of the search results in front of any index.
+ *
+ * Every query is quantized and hashed on the device; the queries found in the cache get their
+ * cached results, and only the misses are searched by the upstream index (as one batch). The
+ * results of the misses are then stored in the cache. The cache is set-associative with the least
+ * recently used replacement policy within a set (similar to `raft::cache::Cache`), and a cached
+ * entry is only returned if all the quantized components of its query match, so the hash
+ * collisions never return wrong results.
+ *
+ * The cached results are not invalidated when the index changes: call `clear` after modifying
+ * the index. The cache is not thread-safe; combine it with `dynamic_batching::batcher` to serve
+ * many threads.
+ *
+ * `search_fn` wraps the upstream index like in `dynamic_batching::batcher`: it is called as
+ * `search_fn(res, queries, neighbors, distances)` with device matrix views (`[n, dim]`, `[n, k]`
+ * and `[n, k]`, with `int64_t` extents).
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = cagra::build<float, uint32_t>(res, index_params, dataset);
+ *   query_cache::cache<float, uint32_t> cache(
+ *     res, query_cache::cache_params{}, index.dim(), k,
+ *     [&index, search_params](const raft::resources& res, auto q, auto n, auto d) {
+ *       cagra::search(res, search_params, index, q, n, d);
+ *     });
+ *   cache.search(res, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @tparam DistT type of the distances
+ */
+template <typename T, typename IdxT, typename DistT = float>
+class cache {
+ public:
+  using search_fn_type =
+    std::function<void(raft::resources const&,
+                       raft::device_matrix_view<const T, int64_t, raft::row_major>,
+                       raft::device_matrix_view<IdxT, int64_t, raft::row_major>,
+                       raft::device_matrix_view<DistT, int64_t, raft::row_major>)>;
+
+  /**
+   * @param[in] res raft resources
+   * @param[in] params configure the cache
+   * @param[in] dim the dimensionality of the queries
+   * @param[in] k the number of neighbors per query
+   * @param[in] search_fn the upstream search
+   */
+  cache(raft::resources const& res,
+        const cache_params& params,
+        int64_t dim,
+        int64_t k,
+        search_fn_type search_fn)
+    : params_(params),
+      dim_(dim),
+      k_(k),
+      search_fn_(std::move(search_fn)),
+      n_sets_(static_cast<uint32_t>(raft::ceildiv<int64_t>(params.capacity,
+                                                           std::max(params.associativity, 1u)))),
+      keys_(raft::make_device_vector<uint64_t, int64_t>(res, size())),
+      stamps_(raft::make_device_vector<uint32_t, int64_t>(res, size())),
+      codes_(raft::make_device_matrix<int32_t, int64_t>(res, size(), dim)),
+      neighbors_(raft::make_device_matrix<IdxT, int64_t>(res, size(), k)),
+      distances_(raft::make_device_matrix<DistT, int64_t>(res, size(), k))
+  {
+    RAFT_EXPECTS(params.capacity > 0, "capacity must be positive");
+    RAFT_EXPECTS(params.associativity > 0 && params.associativity <= WarpSize,
+                 "associativity must be within [1, %d]",
+                 WarpSize);
+    RAFT_EXPECTS(params.quantization_step >= 0, "quantization_step must not be negative");
+    RAFT_EXPECTS(dim > 0 && k > 0, "dim and k must be positive");
+    clear(res);
+  }
+
+  /** Remove all the entries, e.g. after the upstream index has been modified. */
+  void clear(raft::resources const& res)
+  {
+    auto stream = resource::get_cuda_stream(res);
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(keys_.data_handle(), 0, keys_.size() * sizeof(uint64_t), stream));
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(stamps_.data_handle(), 0, stamps_.size() * sizeof(uint32_t), stream));
+    time_ = 0;
+  }
+
+  /**
+   * @brief Search the queries: the cached ones are answered from the cache, and the others are
+   * searched by the upstream index and cached.
+   *
+   * @param[in] res raft resources
+   * @param[in] queries a device matrix view [n_queries, dim]
+   * @param[out] neighbors a device matrix view [n_queries, k]
+   * @param[out] distances a device matrix view [n_queries, k]
+   */
+  void search(raft::resources const& res,
+              raft::device_matrix_view<const T, int64_t, raft::row_major> queries,
+              raft::device_matrix_view<IdxT, int64_t, raft::row_major> neighbors,
+              raft::device_matrix_view<DistT, int64_t, raft::row_major> distances)
+  {
+    common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+      "query_cache::search(n_queries = %zu)", size_t(queries.extent(0)));
+    auto n_queries = queries.extent(0);
+    RAFT_EXPECTS(queries.extent(1) == dim_, "Wrong dimensionality of the queries");
+    RAFT_EXPECTS(neighbors.extent(0) == n_queries && neighbors.extent(1) == k_,
+                 "Wrong shape of the neighbors");
+    RAFT_EXPECTS(distances.extent(0) == n_queries && distances.extent(1) == k_,
+                 "Wrong shape of the distances");
+    if (n_queries == 0) { return; }
+
+    auto stream      = resource::get_cuda_stream(res);
+    auto exec_policy = resource::get_thrust_policy(res);
+    // Zero marks the empty entries, so the time stamps start at one.
+    auto time = ++time_;
+
+    auto query_codes  = raft::make_device_matrix<int32_t, int64_t>(res, n_queries, dim_);
+    auto query_hashes = raft::make_device_vector<uint64_t, int64_t>(res, n_queries);
+    auto hits         = raft::make_device_vector<uint8_t, int64_t>(res, n_queries);
+
+    constexpr uint32_t kBlockSize = detail::kWarpsPerBlock * WarpSize;
+    detail::lookup_kernel<T, IdxT, DistT>
+      <<<raft::ceildiv<int64_t>(n_queries, detail::kWarpsPerBlock), kBlockSize, 0, stream>>>(
+        queries.data_handle(),
+        n_queries,
+        dim_,
+        k_,
+        params_.quantization_step,
+        keys_.data_handle(),
+        stamps_.data_handle(),
+        codes_.data_handle(),
+        neighbors_.data_handle(),
+        distances_.data_handle(),
+        n_sets_,
+        params_.associativity,
+        time,
+        query_codes.data_handle(),
+        query_hashes.data_handle(),
+        neighbors.data_handle(),
+        distances.data_handle(),
+        hits.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // The rows of the misses
+    auto miss_rows = raft::make_device_vector<int64_t, int64_t>(res, n_queries);
+    auto miss_end  = thrust::copy_if(exec_policy,
+                                    thrust::counting_iterator<int64_t>(0),
+                                    thrust::counting_iterator<int64_t>(n_queries),
+                                    hits.data_handle(),
+                                    miss_rows.data_handle(),
+                                    [] __device__(uint8_t hit) { return hit == 0; });
+    int64_t n_misses = miss_end - miss_rows.data_handle();
+    hits_ += n_queries - n_misses;
+    misses_ += n_misses;
+    if (n_misses == 0) { return; }
+
+    // Search the misses in one batch
+    auto miss_queries   = raft::make_device_matrix<T, int64_t>(res, n_misses, dim_);
+    auto miss_neighbors = raft::make_device_matrix<IdxT, int64_t>(res, n_misses, k_);
+    auto miss_distances = raft::make_device_matrix<DistT, int64_t>(res, n_misses, k_);
+    raft::matrix::gather(
+      res,
+      queries,
+      raft::make_device_vector_view<const int64_t, int64_t>(miss_rows.data_handle(), n_misses),
+      miss_queries.view());
+    search_fn_(res,
+               raft::make_const_mdspan(miss_queries.view()),
+               miss_neighbors.view(),
+               miss_distances.view());
+    detail::scatter_results_kernel<IdxT, DistT>
+      <<<raft::ceildiv<int64_t>(n_misses, detail::kWarpsPerBlock), kBlockSize, 0, stream>>>(
+        miss_rows.data_handle(),
+        n_misses,
+        k_,
+        miss_neighbors.data_handle(),
+        miss_distances.data_handle(),
+        neighbors.data_handle(),
+        distances.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    detail::insert(res,
+                   n_sets_,
+                   params_.associativity,
+                   time,
+                   dim_,
+                   k_,
+                   query_codes.data_handle(),
+                   query_hashes.data_handle(),
+                   miss_rows.data_handle(),
+                   n_misses,
+                   miss_neighbors.data_handle(),
+                   miss_distances.data_handle(),
+                   keys_.data_handle(),
+                   stamps_.data_handle(),
+                   codes_.data_handle(),
+                   neighbors_.data_handle(),
+                   distances_.data_handle());
+  }
+
+  /** The total number of the slots in the cache (`capacity` rounded up to the full sets). */
+  [[nodiscard]] auto size() const noexcept -> int64_t
+  {
+    return int64_t{n_sets_} * params_.associativity;
+  }
+  /** The number of the queries answered from the cache since the construction. */
+  [[nodiscard]] auto hits() const noexcept -> int64_t { return hits_; }
+  /** The number of the queries searched by the upstream index since the construction. */
+  [[nodiscard]] auto misses() const noexcept -> int64_t { return misses_; }
+
+ private:
+  cache_params params_;
+  int64_t dim_;
+  int64_t k_;
+  search_fn_type search_fn_;
+  uint32_t n_sets_;
+  uint32_t time_  = 0;
+  int64_t hits_   = 0;
+  int64_t misses_ = 0;
+
+  raft::device_vector<uint64_t, int64_t> keys_;
+  raft::device_vector<uint32_t, int64_t> stamps_;
+  raft::device_matrix<int32_t, int64_t, raft::row_major> codes_;
+  raft::device_matrix<IdxT, int64_t, raft::row_major> neighbors_;
+  raft::device_matrix<DistT, int64_t, raft::row_major> distances_;
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::query_cache
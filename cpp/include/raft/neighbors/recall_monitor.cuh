@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/pinned_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/stats/neighborhood_recall.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+namespace raft::neighbors::recall_monitoring {
+
+/**
+ * @defgroup recall_monitoring Online monitoring of the recall of the approximate searches
+ * @{
+ */
+
+struct monitor_params {
+  /** The fraction of the observed queries searched exactly, in [0, 1]. */
+  double sample_fraction = 0.01;
+  /** The maximum number of queries in one exact (shadow) search. */
+  int64_t max_batch_size = 256;
+  /** The number of the most recent sampled queries the rolling recall is computed over. */
+  int64_t window_size = 10000;
+};
+
+struct recall_stats {
+  /** The recall over the rolling window; NaN until the first shadow search finishes. */
+  double recall;
+  /** The number of the sampled queries in the rolling window. */
+  int64_t window_queries;
+  /** The total number of the queries searched exactly. */
+  int64_t sampled_queries;
+  /** The number of the sampled queries skipped because the previous shadow search was running. */
+  int64_t dropped_queries;
+};
+
+/**
+ * @brief Shadow a sample of the production searches with the exact search to track the recall.
+ *
+ * After every search of the monitored index, the caller passes the queries and the found
+ * neighbors to `observe`. A `sample_fraction` of the rows (evenly spaced in the batch) is copied
+ * aside on the stream of the caller, which is the only work added to the critical path; the exact
+ * `brute_force::search` and `stats::neighborhood_recall` of the sample run on a separate stream of
+ * the lowest priority. At most one shadow search is in flight: the samples arriving meanwhile are
+ * dropped (and counted), so the monitor never queues work or allocates memory after construction.
+ *
+ * The finished shadow searches are collected without blocking by `observe` and `stats`; the
+ * latter reports the recall averaged over the last `window_size` sampled queries.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto exact = brute_force::build(res, dataset);
+ *   recall_monitoring::monitor<float, uint32_t> monitor(res, {}, exact, k);
+ *   // the production loop:
+ *   cagra::search(res, search_params, index, queries, neighbors, distances);
+ *   monitor.observe(res, queries, neighbors);
+ *   // from time to time:
+ *   auto recall = monitor.stats().recall;
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices of the monitored index
+ */
+template <typename T, typename IdxT>
+class monitor {
+ public:
+  /**
+   * @param[in] res raft resources
+   * @param[in] params configure the sampling
+   * @param[in] exact_index the exact index over the same dataset as the monitored one; must
+   *   outlive the monitor
+   * @param[in] k the number of neighbors per query of the monitored searches
+   */
+  monitor(raft::resources const& res,
+          const monitor_params& params,
+          const brute_force::index<T>& exact_index,
+          int64_t k)
+    : params_(params),
+      k_(k),
+      dim_(exact_index.dim()),
+      exact_index_(exact_index),
+      res_(res),
+      queries_(raft::make_device_matrix<T, int64_t>(res, params.max_batch_size, dim_)),
+      neighbors_(raft::make_device_matrix<IdxT, int64_t>(res, params.max_batch_size, k)),
+      exact_neighbors_(raft::make_device_matrix<IdxT, int64_t>(res, params.max_batch_size, k)),
+      exact_distances_(raft::make_device_matrix<T, int64_t>(res, params.max_batch_size, k)),
+      recall_(raft::make_device_scalar<float>(res, 0.0f)),
+      recall_host_(raft::make_pinned_vector<float, int64_t>(res, 1))
+  {
+    RAFT_EXPECTS(0.0 <= params.sample_fraction && params.sample_fraction <= 1.0,
+                 "sample_fraction must be in [0, 1]");
+    RAFT_EXPECTS(params.max_batch_size > 0, "max_batch_size must be positive");
+    RAFT_EXPECTS(params.window_size > 0, "window_size must be positive");
+    int least_priority    = 0;
+    int greatest_priority = 0;
+    RAFT_CUDA_TRY(cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+    RAFT_CUDA_TRY(
+      cudaStreamCreateWithPriority(&shadow_stream_, cudaStreamNonBlocking, least_priority));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&staged_, cudaEventDisableTiming));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&done_, cudaEventDisableTiming));
+    resource::set_cuda_stream(res_, rmm::cuda_stream_view{shadow_stream_});
+  }
+
+  monitor(const monitor&)                    = delete;
+  auto operator=(const monitor&) -> monitor& = delete;
+
+  /** Wait for the shadow search in flight and release the stream. */
+  ~monitor() noexcept
+  {
+    RAFT_CUDA_TRY_NO_THROW(cudaStreamSynchronize(shadow_stream_));
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(done_));
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(staged_));
+    RAFT_CUDA_TRY_NO_THROW(cudaStreamDestroy(shadow_stream_));
+  }
+
+  /**
+   * @brief Account a search of the monitored index; thread-safe.
+   *
+   * The sampled rows are copied on the stream of `res` before the function returns (in the stream
+   * order), hence the inputs may be reused by the subsequent work on that stream.
+   *
+   * @param[in] res raft resources; the stream the monitored search ran on
+   * @param[in] queries a device matrix view [n_queries, dim]
+   * @param[in] neighbors a device matrix view to the found neighbors [n_queries, k]
+   */
+  void observe(raft::resources const& res,
+               raft::device_matrix_view<const T, int64_t, row_major> queries,
+               raft::device_matrix_view<const IdxT, int64_t, row_major> neighbors)
+  {
+    const int64_t n_queries = queries.extent(0);
+    RAFT_EXPECTS(queries.extent(1) == dim_, "Wrong dimensionality of the queries");
+    RAFT_EXPECTS(neighbors.extent(0) == n_queries && neighbors.extent(1) == k_,
+                 "Wrong shape of the neighbors");
+    std::lock_guard<std::mutex> lock(mutex_);
+    collect();
+    budget_ = std::min<double>(budget_ + n_queries * params_.sample_fraction,
+                               static_cast<double>(params_.max_batch_size));
+    const auto n_sampled = std::min<int64_t>(n_queries, static_cast<int64_t>(budget_));
+    if (n_sampled == 0) { return; }
+    budget_ -= n_sampled;
+    if (in_flight_ > 0) {
+      dropped_queries_ += n_sampled;
+      return;
+    }
+
+    common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+      "recall_monitoring::monitor::observe(%zu)", size_t(n_sampled));
+    auto stream       = resource::get_cuda_stream(res);
+    const auto stride = n_queries / n_sampled;
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(queries_.data_handle(),
+                                    dim_ * sizeof(T),
+                                    queries.data_handle(),
+                                    stride * dim_ * sizeof(T),
+                                    dim_ * sizeof(T),
+                                    n_sampled,
+                                    cudaMemcpyDeviceToDevice,
+                                    stream));
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(neighbors_.data_handle(),
+                                    k_ * sizeof(IdxT),
+                                    neighbors.data_handle(),
+                                    stride * k_ * sizeof(IdxT),
+                                    k_ * sizeof(IdxT),
+                                    n_sampled,
+                                    cudaMemcpyDeviceToDevice,
+                                    stream));
+    RAFT_CUDA_TRY(cudaEventRecord(staged_, stream));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(shadow_stream_, staged_, 0));
+
+    auto exact_neighbors = raft::make_device_matrix_view<IdxT, int64_t>(
+      exact_neighbors_.data_handle(), n_sampled, k_);
+    brute_force::search<T, IdxT>(
+      res_,
+      exact_index_,
+      raft::make_device_matrix_view<const T, int64_t>(queries_.data_handle(), n_sampled, dim_),
+      exact_neighbors,
+      raft::make_device_matrix_view<T, int64_t>(exact_distances_.data_handle(), n_sampled, k_));
+    raft::stats::neighborhood_recall(
+      res_,
+      raft::make_device_matrix_view<const IdxT, int64_t>(neighbors_.data_handle(), n_sampled, k_),
+      raft::make_const_mdspan(exact_neighbors),
+      recall_.view());
+    raft::copy(recall_host_.data_handle(), recall_.data_handle(), 1, shadow_stream_);
+    RAFT_CUDA_TRY(cudaEventRecord(done_, shadow_stream_));
+    in_flight_ = n_sampled;
+  }
+
+  /** The rolling recall metrics; does not wait for the shadow search in flight. */
+  auto stats() -> recall_stats
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collect();
+    return make_stats();
+  }
+
+  /** Wait for the shadow search in flight, then return the metrics. */
+  auto wait_stats() -> recall_stats
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (in_flight_ > 0) { RAFT_CUDA_TRY(cudaEventSynchronize(done_)); }
+    collect();
+    return make_stats();
+  }
+
+ private:
+  /** Move the result of the finished shadow search to the window. */
+  void collect()
+  {
+    if (in_flight_ == 0) { return; }
+    auto status = cudaEventQuery(done_);
+    if (status == cudaErrorNotReady) { return; }
+    RAFT_CUDA_TRY(status);
+    window_.emplace_back(in_flight_, double(*recall_host_.data_handle()) * in_flight_);
+    window_queries_ += in_flight_;
+    window_matches_ += window_.back().second;
+    sampled_queries_ += in_flight_;
+    in_flight_ = 0;
+    while (window_queries_ - window_.front().first >= params_.window_size) {
+      window_queries_ -= window_.front().first;
+      window_matches_ -= window_.front().second;
+      window_.pop_front();
+    }
+  }
+
+  auto make_stats() const -> recall_stats
+  {
+    return recall_stats{window_queries_ > 0 ? window_matches_ / window_queries_
+                                            : std::numeric_limits<double>::quiet_NaN(),
+                        window_queries_,
+                        sampled_queries_,
+                        dropped_queries_};
+  }
+
+  monitor_params params_;
+  int64_t k_;
+  int64_t dim_;
+  const brute_force::index<T>& exact_index_;
+
+  cudaStream_t shadow_stream_{nullptr};
+  cudaEvent_t staged_{nullptr};
+  cudaEvent_t done_{nullptr};
+  raft::resources res_;
+
+  raft::device_matrix<T, int64_t, row_major> queries_;
+  raft::device_matrix<IdxT, int64_t, row_major> neighbors_;
+  raft::device_matrix<IdxT, int64_t, row_major> exact_neighbors_;
+  raft::device_matrix<T, int64_t, row_major> exact_distances_;
+  raft::device_scalar<float> recall_;
+  raft::pinned_vector<float, int64_t> recall_host_;
+
+  std::mutex mutex_;
+  double budget_{0};
+  int64_t in_flight_{0};
+  // (the number of queries, the sum of their recalls) of the finished shadow searches
+  std::deque<std::pair<int64_t, double>> window_;
+  int64_t window_queries_{0};
+  double window_matches_{0};
+  int64_t sampled_queries_{0};
+  int64_t dropped_queries_{0};
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::recall_monitoring
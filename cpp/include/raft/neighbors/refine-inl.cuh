@@ -97,7 +97,7 @@ void refine(raft::resources const& handle,
             raft::host_matrix_view<distance_t, matrix_idx, row_major> distances,
             distance::DistanceType metric = distance::DistanceType::L2Unexpanded)
 {
-  detail::refine_host(dataset, queries, neighbor_candidates, indices, distances, metric);
+  detail::refine_host(handle, dataset, queries, neighbor_candidates, indices, distances, metric);
 }
 
 /** @} */  // end group ann_refine
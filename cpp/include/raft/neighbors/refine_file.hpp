@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/detail/refine_file.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace raft::neighbors {
+
+/**
+ * @addtogroup ann_refine
+ * @{
+ */
+
+/**
+ * @brief A row-major dataset stored in a file, read on demand.
+ *
+ * The file holds `n_rows * dim` elements of type `T`, without padding, starting at byte `offset`
+ * (e.g. 8 for the `.fbin`/`.u8bin` files of the big-ann-benchmarks, after the header). The rows are
+ * read with `pread`, hence the dataset can be shared by several threads.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the row indices
+ */
+template <typename T, typename IdxT = int64_t>
+class file_dataset {
+ public:
+  using value_type = T;
+  using index_type = IdxT;
+
+  /**
+   * @param[in] path the file to read
+   * @param[in] n_rows number of rows of the dataset
+   * @param[in] dim number of columns of the dataset
+   * @param[in] offset position of the first row in the file, in bytes
+   */
+  file_dataset(const std::string& path, IdxT n_rows, uint32_t dim, size_t offset = 0)
+    : path_(path), n_rows_(n_rows), dim_(dim), offset_(offset)
+  {
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) { RAFT_FAIL("Cannot open the dataset file %s", path.c_str()); }
+    struct stat st {};
+    const size_t size = offset_ + static_cast<size_t>(n_rows_) * row_bytes();
+    if (::fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < size) {
+      ::close(fd_);
+      RAFT_FAIL("The dataset file %s is smaller than the %zu bytes expected", path.c_str(), size);
+    }
+  }
+
+  ~file_dataset() noexcept
+  {
+    if (fd_ >= 0) { ::close(fd_); }
+  }
+
+  file_dataset(const file_dataset&)            = delete;
+  file_dataset& operator=(const file_dataset&) = delete;
+
+  [[nodiscard]] auto n_rows() const noexcept -> IdxT { return n_rows_; }
+  [[nodiscard]] auto dim() const noexcept -> uint32_t { return dim_; }
+  [[nodiscard]] auto row_bytes() const noexcept -> size_t { return sizeof(T) * dim_; }
+
+  /** Read the rows [first, first + count) into `out`, a buffer of `count * dim` elements. */
+  void read_rows(IdxT first, size_t count, T* out) const
+  {
+    auto* dst      = reinterpret_cast<char*>(out);
+    size_t pos     = offset_ + static_cast<size_t>(first) * row_bytes();
+    size_t to_read = count * row_bytes();
+    while (to_read > 0) {
+      const auto n = ::pread(fd_, dst, to_read, static_cast<off_t>(pos));
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n <= 0) { RAFT_FAIL("Cannot read %zu bytes of %s at %zu", to_read, path_.c_str(), pos); }
+      dst += n;
+      pos += n;
+      to_read -= n;
+    }
+  }
+
+ private:
+  std::string path_;
+  IdxT n_rows_;
+  uint32_t dim_;
+  size_t offset_;
+  int fd_ = -1;
+};
+
+/**
+ * @brief Refine nearest neighbor search with the dataset stored in a file.
+ *
+ * Same as the refine overloads taking the dataset in memory, for datasets that do not fit in the
+ * host memory. The queries are processed in batches; the candidates of a batch are sorted and
+ * deduplicated, so that their rows are read from the file in order, and every row once. The reads
+ * of contiguous rows are merged, and they are issued in parallel.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // a dataset of N rows of D floats saved after an 8-byte header
+ *   file_dataset<float, int64_t> dataset("base.fbin", N, D, 8);
+ *   refine(handle, dataset, queries, neighbor_candidates, out_indices, out_dists,
+ *          raft::distance::DistanceType::L2Expanded);
+ * @endcode
+ *
+ * @param[in] handle the raft handle
+ * @param[in] dataset the dataset file [n_rows, dims]
+ * @param[in] queries host matrix of the queries [n_queries, dims]
+ * @param[in] neighbor_candidates host matrix with indices of candidate vectors [n_queries,
+ *   n_candidates], where n_candidates >= k
+ * @param[out] indices host matrix that stores the refined indices [n_queries, k]
+ * @param[out] distances host matrix that stores the refined distances [n_queries, k]
+ * @param[in] metric distance metric to use. Euclidean (L2) is used by default
+ * @param[in] max_batch_bytes the size of the rows read for a batch of queries is at most
+ *   max(this, n_candidates * row size)
+ */
+template <typename idx_t, typename data_t, typename distance_t, typename matrix_idx>
+void refine(raft::resources const& handle,
+            const file_dataset<data_t, idx_t>& dataset,
+            raft::host_matrix_view<const data_t, matrix_idx, row_major> queries,
+            raft::host_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,
+            raft::host_matrix_view<idx_t, matrix_idx, row_major> indices,
+            raft::host_matrix_view<distance_t, matrix_idx, row_major> distances,
+            distance::DistanceType metric = distance::DistanceType::L2Unexpanded,
+            size_t max_batch_bytes        = size_t{256} << 20)
+{
+  detail::refine_file<idx_t, data_t, distance_t, matrix_idx>(
+    handle, dataset, queries, neighbor_candidates, indices, distances, metric, max_batch_bytes);
+}
+
+/** @} */  // end group ann_refine
+
+}  // namespace raft::neighbors
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <raft/core/bitmap.cuh>
 #include <raft/core/bitset.cuh>
 
 #include <cstddef>
@@ -46,4 +47,36 @@ struct bitset_filter {
   }
 };
 
+/**
+ * @brief Filter an index with a bitmap, one bitset row per query
+ *
+ * The bitmap has `n_queries` rows and `n_samples` columns: the sample `j` is kept for the query
+ * `i` if the bit `(i, j)` is set. This allows batching the queries of different users, each with
+ * its own filter, in a single search.
+ *
+ * With the IVF indexes, the filter is applied to the sample ids through `ivf_to_sample_filter`, as
+ * any two-argument filter.
+ *
+ * @tparam bitmap_t Underlying type of the bitmap array
+ * @tparam index_t Indexing type
+ */
+template <typename bitmap_t, typename index_t>
+struct bitmap_filter {
+  // View of the bitmap to use as a filter
+  const raft::core::bitmap_view<bitmap_t, index_t> bitmap_view_;
+
+  bitmap_filter(const raft::core::bitmap_view<bitmap_t, index_t> bitmap_for_filtering)
+    : bitmap_view_{bitmap_for_filtering}
+  {
+  }
+  inline _RAFT_HOST_DEVICE bool operator()(
+    // query index
+    const uint32_t query_ix,
+    // the index of the current sample
+    const uint32_t sample_ix) const
+  {
+    return bitmap_view_.test(query_ix, sample_ix);
+  }
+};
+
 }  // namespace raft::neighbors::filtering
@@ -49,6 +49,48 @@ struct none_cagra_sample_filter {
   }
 };
 
+/**
+ * A filter that excludes the samples removed from a CAGRA index.
+ *
+ * The samples are marked in a bitset of the index size: a cleared bit marks a removed sample.
+ * The filter is applied by `cagra::search` automatically whenever the index has removed samples.
+ */
+struct removed_cagra_sample_filter {
+  const uint32_t* bitset_ptr;
+
+  inline _RAFT_HOST_DEVICE bool operator()(
+    // query index
+    const uint32_t query_ix,
+    // the index of the current sample
+    const uint32_t sample_ix) const
+  {
+    return (bitset_ptr[sample_ix / 32] >> (sample_ix % 32)) & 1u;
+  }
+};
+
+/**
+ * A filter that excludes the samples with the same label as the query, e.g. to search for the
+ * nearest neighbors in the other connected components of a graph.
+ *
+ * @tparam LabelT label type
+ */
+template <typename LabelT>
+struct label_exclusion_ivf_sample_filter {
+  // the labels of the queries of the search [n_queries]
+  const LabelT* query_labels;
+  // the labels of the samples by their source indices [n_samples]
+  const LabelT* sample_labels;
+
+  inline _RAFT_HOST_DEVICE bool operator()(
+    // query index
+    const uint32_t query_ix,
+    // the index of the current sample
+    const int64_t sample_ix) const
+  {
+    return query_labels[query_ix] != sample_labels[sample_ix];
+  }
+};
+
 template <typename filter_t, typename = void>
 struct takes_three_args : std::false_type {};
 template <typename filter_t>
@@ -30,6 +30,7 @@ extern template void rbc_low_dim_pass_one<std::int64_t, float, std::uint32_t, 2>
   const float* query,
   const std::uint32_t n_query_rows,
   std::uint32_t k,
+  std::uint32_t n_probes,
   const std::int64_t* R_knn_inds,
   const float* R_knn_dists,
   DistFunc<float, std::uint32_t>& dfunc,
@@ -58,6 +59,7 @@ extern template void rbc_low_dim_pass_one<std::int64_t, float, std::uint32_t, 3>
   const float* query,
   const std::uint32_t n_query_rows,
   std::uint32_t k,
+  std::uint32_t n_probes,
   const std::int64_t* R_knn_inds,
   const float* R_knn_dists,
   DistFunc<float, std::uint32_t>& dfunc,
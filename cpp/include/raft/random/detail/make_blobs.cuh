@@ -19,6 +19,7 @@
 #include "permute.cuh"
 
 #include <raft/core/handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/linalg/map.cuh>
 #include <raft/random/rng.cuh>
 #include <raft/random/rng_device.cuh>
@@ -256,6 +257,86 @@ void make_blobs_caller(DataT* out,
                 r);
 }
 
+/** Parameters of the row-major blobs generated by batches (see `blobs_generator`). */
+template <typename DataT, typename IdxT>
+struct BlobsDistParams {
+  const DataT* centers;
+  const DataT* cluster_std;
+  DataT cluster_std_scalar;
+  IdxT n_cols;
+  IdxT n_clusters;
+  IdxT a, b;
+  bool shuffle;
+};
+
+/** The label of a row of the blobs only depends on its global index. */
+template <typename IdxT>
+HDI IdxT blob_label(uint64_t row, IdxT n_clusters, IdxT a, IdxT b, bool shuffle)
+{
+  if (shuffle) { row = static_cast<uint64_t>(a) * row + static_cast<uint64_t>(b); }
+  return static_cast<IdxT>(row % static_cast<uint64_t>(n_clusters));
+}
+
+template <typename DataT, typename IdxT>
+HDI void blob_mu_sigma(DataT& mu, DataT& sigma, uint64_t idx, const BlobsDistParams<DataT, IdxT>& p)
+{
+  IdxT label = blob_label<IdxT>(idx / p.n_cols, p.n_clusters, p.a, p.b, p.shuffle);
+  mu         = p.centers[static_cast<uint64_t>(label) * p.n_cols + idx % p.n_cols];
+  sigma      = p.cluster_std == nullptr ? p.cluster_std_scalar : p.cluster_std[label];
+}
+
+template <typename GenType, typename DataT, typename IdxT, typename LenType>
+HDI void custom_next(
+  GenType& gen, DataT* val, BlobsDistParams<DataT, IdxT> params, LenType idx, LenType stride)
+{
+  DataT res1, res2;
+  do {
+    gen.next(res1);
+  } while (res1 == DataT(0.0));
+  gen.next(res2);
+  DataT mu1, sigma1, mu2, sigma2;
+  blob_mu_sigma(mu1, sigma1, static_cast<uint64_t>(idx), params);
+  blob_mu_sigma(mu2, sigma2, static_cast<uint64_t>(idx + stride), params);
+  box_muller_transform<DataT>(res1, res2, sigma1, mu1, sigma2, mu2);
+  *val       = res1;
+  *(val + 1) = res2;
+}
+
+/**
+ * @brief Generate the rows [row_offset, row_offset + n_rows) of row-major blobs with
+ * `total_rows` rows, and their labels (optional).
+ *
+ * The values only depend on `rng_state` and on the global position of the elements, so the
+ * batches can be generated in any order, on any device.
+ */
+template <typename DataT, typename IdxT>
+void generate_blobs_batch(raft::resources const& handle,
+                          raft::random::RngState rng_state,
+                          const BlobsDistParams<DataT, IdxT>& params,
+                          uint64_t total_rows,
+                          uint64_t row_offset,
+                          DataT* out,
+                          IdxT* labels,
+                          IdxT n_rows)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  RngShard shard{row_offset * params.n_cols, total_rows * params.n_cols};
+  int64_t len = static_cast<int64_t>(n_rows) * params.n_cols;
+  RAFT_CALL_RNG_FUNC(
+    rng_state, call_rng_sharded_kernel<2>, rng_state, shard, stream, out, len, params);
+  if (labels != nullptr) {
+    auto n_clusters = params.n_clusters;
+    auto a          = params.a;
+    auto b          = params.b;
+    auto shuffle    = params.shuffle;
+
+    auto op = [=] __device__(IdxT i) {
+      return blob_label<IdxT>(row_offset + i, n_clusters, a, b, shuffle);
+    };
+    linalg::map_offset(handle, raft::make_device_vector_view<IdxT, IdxT>(labels, n_rows), op);
+  }
+}
+
 }  // end namespace detail
 }  // end namespace random
 }  // end namespace raft
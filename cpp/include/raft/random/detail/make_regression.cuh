@@ -20,10 +20,13 @@
 
 #pragma once
 
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/linalg/add.cuh>
 #include <raft/linalg/gemm.cuh>
 #include <raft/linalg/init.cuh>
+#include <raft/linalg/map.cuh>
 #include <raft/linalg/qr.cuh>
 #include <raft/linalg/transpose.cuh>
 #include <raft/matrix/diagonal.cuh>
@@ -34,6 +37,7 @@
 #include <rmm/device_uvector.hpp>
 
 #include <algorithm>
+#include <limits>
 
 namespace raft::random {
 namespace detail {
@@ -277,5 +281,74 @@ void make_regression_caller(raft::resources const& handle,
   }
 }
 
+/**
+ * @brief Generate the rows [row_offset, row_offset + n_batch) of a well conditioned regression
+ * problem with `total_rows` rows (see `regression_generator`).
+ *
+ * The inputs only depend on `x_state` and the noise on `noise_state`, and both only depend on
+ * the global position of the elements, so that the batches can be generated in any order.
+ */
+template <typename DataT, typename IdxT>
+void generate_regression_batch(raft::resources const& handle,
+                               raft::random::RngState x_state,
+                               raft::random::RngState noise_state,
+                               const DataT* coef,
+                               uint64_t total_rows,
+                               uint64_t row_offset,
+                               DataT* out,
+                               DataT* values,
+                               IdxT n_batch,
+                               IdxT n_cols,
+                               IdxT n_informative,
+                               IdxT n_targets,
+                               DataT bias,
+                               DataT noise)
+{
+  auto stream      = resource::get_cuda_stream(handle);
+  auto n_values    = static_cast<int64_t>(n_batch) * n_targets;
+  DataT alpha      = 1.0;
+  DataT beta       = 1.0;
+  RngShard x_shard = {row_offset * n_cols, total_rows * n_cols};
+  normal(x_state, x_shard, out, static_cast<int64_t>(n_batch) * n_cols, DataT(0), DataT(1), stream);
+  if (noise != DataT(0)) {
+    RngShard noise_shard = {row_offset * n_targets, total_rows * n_targets};
+    normal(noise_state, noise_shard, values, n_values, bias, noise, stream);
+  } else if (bias != DataT(0)) {
+    linalg::map(handle,
+                raft::make_device_vector_view<DataT, int64_t>(values, n_values),
+                raft::const_op<DataT>{bias});
+  } else {
+    beta = 0.0;
+  }
+  if (n_informative == 0 || n_batch == 0) {
+    if (beta == DataT(0)) {
+      RAFT_CUDA_TRY(cudaMemsetAsync(values, 0, n_values * sizeof(DataT), stream));
+    }
+    return;
+  }
+
+  // values = out[:, :n_informative] * coef[:n_informative, :] (+ bias and noise), all row-major;
+  // the rows are split in chunks of 32-bit sizes for cuBLAS.
+  const int64_t max_rows = std::numeric_limits<int>::max();
+  for (int64_t i = 0; i < int64_t(n_batch); i += max_rows) {
+    int rows = static_cast<int>(std::min<int64_t>(max_rows, int64_t(n_batch) - i));
+    raft::linalg::gemm(handle,
+                       false,
+                       false,
+                       n_targets,
+                       rows,
+                       n_informative,
+                       &alpha,
+                       coef,
+                       n_targets,
+                       out + i * n_cols,
+                       n_cols,
+                       &beta,
+                       values + i * n_targets,
+                       n_targets,
+                       stream);
+  }
+}
+
 }  // namespace detail
 }  // namespace raft::random
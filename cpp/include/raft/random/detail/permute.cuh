@@ -16,12 +16,24 @@
 
 #pragma once
 
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/random/rng_state.hpp>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/vectorized.cuh>
 
+#include <rmm/device_uvector.hpp>
+
 #include <cooperative_groups.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <memory>
 
 namespace raft::random {
@@ -160,5 +172,209 @@ void permute(IntType* perms,
   }
 }
 
+/** The SplitMix64 finalizer, used to derive the keys and round values of `feistel_bijection`. */
+HDI uint64_t permute_mix(uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * A keyed pseudo-random bijection of [0, n): a 4-round Feistel network on the smallest domain of
+ * 4^half_bits >= n values, with cycle walking to stay within [0, n) (at most four iterations are
+ * expected). The permutations are evaluated on the fly and never stored.
+ */
+struct feistel_bijection {
+  uint64_t n;
+  int half_bits;
+
+  HDI uint64_t operator()(uint64_t key, uint64_t x) const
+  {
+    const uint64_t mask = (uint64_t(1) << half_bits) - 1;
+    do {
+      uint64_t l = x >> half_bits;
+      uint64_t r = x & mask;
+#pragma unroll
+      for (int round = 0; round < 4; round++) {
+        uint64_t f = permute_mix(key ^ (r * 0x9e3779b97f4a7c15ULL + uint64_t(round))) & mask;
+        uint64_t t = l ^ f;
+        l          = r;
+        r          = t;
+      }
+      x = (l << half_bits) | r;
+    } while (x >= n);
+    return x;
+  }
+};
+
+inline feistel_bijection make_feistel_bijection(uint64_t n)
+{
+  int half_bits = 0;
+  while ((uint64_t(1) << (2 * half_bits)) < n) {
+    half_bits++;
+  }
+  return feistel_bijection{n, half_bits};
+}
+
+/**
+ * Gathers `w` columns of the (p, q) grid of rows starting at `rows`, each column `j` being
+ * permuted by its own bijection, keyed after `key` and j:
+ * tmp(i, c) = grid(perm_j(i), j) with j = j0 + c.
+ */
+template <typename T>
+RAFT_KERNEL permute_inplace_col_gather_kernel(const T* rows,
+                                              uint64_t d,
+                                              uint64_t p,
+                                              uint64_t q,
+                                              uint64_t j0,
+                                              uint64_t w,
+                                              uint64_t key,
+                                              feistel_bijection perm,
+                                              T* tmp)
+{
+  for (uint64_t k = blockIdx.x * uint64_t(blockDim.x) + threadIdx.x; k < p * w * d;
+       k += uint64_t(blockDim.x) * gridDim.x) {
+    uint64_t e = k / d;
+    uint64_t i = e / w;
+    uint64_t j = j0 + e % w;
+    tmp[k]     = rows[(perm(permute_mix(key + j), i) * q + j) * d + k % d];
+  }
+}
+
+template <typename T>
+RAFT_KERNEL permute_inplace_col_store_kernel(
+  const T* tmp, uint64_t d, uint64_t p, uint64_t q, uint64_t j0, uint64_t w, T* rows)
+{
+  for (uint64_t k = blockIdx.x * uint64_t(blockDim.x) + threadIdx.x; k < p * w * d;
+       k += uint64_t(blockDim.x) * gridDim.x) {
+    uint64_t e                                   = k / d;
+    rows[((e / w) * q + j0 + e % w) * d + k % d] = tmp[k];
+  }
+}
+
+/**
+ * Gathers `h` rows of the (p, q) grid of rows starting at `rows`, each row `i` being permuted by
+ * its own bijection, keyed after `key` and i:
+ * tmp(r, j) = grid(i, perm_i(j)) with i = i0 + r.
+ */
+template <typename T>
+RAFT_KERNEL permute_inplace_row_gather_kernel(const T* rows,
+                                              uint64_t d,
+                                              uint64_t q,
+                                              uint64_t i0,
+                                              uint64_t h,
+                                              uint64_t key,
+                                              feistel_bijection perm,
+                                              T* tmp)
+{
+  for (uint64_t k = blockIdx.x * uint64_t(blockDim.x) + threadIdx.x; k < h * q * d;
+       k += uint64_t(blockDim.x) * gridDim.x) {
+    uint64_t e = k / d;
+    uint64_t i = i0 + e / q;
+    tmp[k]     = rows[(i * q + perm(permute_mix(key + i), e % q)) * d + k % d];
+  }
+}
+
+/**
+ * @brief Randomly permute the `n` rows of `d` elements of a row-major matrix in place.
+ *
+ * The rows of a window of p * q rows are seen as a (p, q) grid, and shuffled by three passes of
+ * independent pseudo-random permutations: of every column, of every row and of every column again.
+ * Each pass goes through a temporary buffer holding a batch of grid rows or columns, sized after
+ * the free workspace but at least large enough to hold one of them. When n is not a multiple of
+ * q, a second window covering the last p * q rows is shuffled the same way, so that all the rows
+ * are mixed.
+ *
+ * The permutation only depends on `n` and `key`, so it can be replayed on other arrays (e.g. on
+ * the row indices).
+ */
+template <typename T>
+void permute_rows_inplace(
+  raft::resources const& handle, T* inout, uint64_t n, uint64_t d, uint64_t key)
+{
+  if (n <= 1 || d == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+
+  const uint64_t q = std::max<uint64_t>(1, uint64_t(std::sqrt(double(n))));
+  const uint64_t p = n / q;
+
+  uint64_t budget = resource::get_workspace_free_bytes(handle) / (2 * sizeof(T));
+  uint64_t w      = std::clamp<uint64_t>(budget / (p * d), 1, q);
+  uint64_t h      = std::clamp<uint64_t>(budget / (q * d), 1, p);
+  rmm::device_uvector<T> tmp(
+    std::max(p * w, h * q) * d, stream, resource::get_workspace_resource(handle));
+
+  constexpr int kTpb = 256;
+
+  auto n_blocks = [](uint64_t size) {
+    return static_cast<int>(std::min<uint64_t>(raft::ceildiv<uint64_t>(size, kTpb), 65535));
+  };
+  auto col_pass = [&](T* rows, uint64_t pass_key) {
+    auto perm = make_feistel_bijection(p);
+    for (uint64_t j0 = 0; j0 < q; j0 += w) {
+      uint64_t wb = std::min(w, q - j0);
+      permute_inplace_col_gather_kernel<<<n_blocks(p * wb * d), kTpb, 0, stream>>>(
+        rows, d, p, q, j0, wb, pass_key, perm, tmp.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      permute_inplace_col_store_kernel<<<n_blocks(p * wb * d), kTpb, 0, stream>>>(
+        tmp.data(), d, p, q, j0, wb, rows);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+  };
+  auto row_pass = [&](T* rows, uint64_t pass_key) {
+    auto perm = make_feistel_bijection(q);
+    for (uint64_t i0 = 0; i0 < p; i0 += h) {
+      uint64_t hb = std::min(h, p - i0);
+      permute_inplace_row_gather_kernel<<<n_blocks(hb * q * d), kTpb, 0, stream>>>(
+        rows, d, q, i0, hb, pass_key, perm, tmp.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      raft::copy(rows + i0 * q * d, tmp.data(), hb * q * d, stream);
+    }
+  };
+
+  const uint64_t tail = n - p * q;
+  for (int window = 0; window < (tail > 0 ? 2 : 1); window++) {
+    T* rows = inout + (window == 0 ? 0 : tail * d);
+    col_pass(rows, permute_mix(key + 6 * window));
+    row_pass(rows, permute_mix(key + 6 * window + 1));
+    col_pass(rows, permute_mix(key + 6 * window + 2));
+  }
+}
+
+/**
+ * @brief Implementation of `raft::random::permute_inplace`: the rows of a row-major matrix are
+ * permuted together, and the columns of a column-major matrix one after the other with the same
+ * permutation. The permutation indices are obtained by permuting the sequence 0, 1, ..., N - 1.
+ */
+template <typename Type, typename IntType, typename IdxType>
+void permute_inplace(raft::resources const& handle,
+                     RngState& rng_state,
+                     IntType* perms,
+                     Type* inout,
+                     IdxType D,
+                     IdxType N,
+                     bool rowMajor)
+{
+  const auto key   = permute_mix(rng_state.seed ^ permute_mix(rng_state.base_subsequence));
+  const uint64_t n = N;
+  rng_state.advance(1);
+
+  if (perms != nullptr) {
+    linalg::map_offset(handle,
+                       raft::make_device_vector_view<IntType, uint64_t>(perms, n),
+                       raft::cast_op<IntType>{});
+    permute_rows_inplace(handle, perms, n, 1, key);
+  }
+  if (inout == nullptr) { return; }
+  if (rowMajor) {
+    permute_rows_inplace(handle, inout, n, uint64_t(D), key);
+  } else {
+    for (IdxType j = 0; j < D; j++) {
+      permute_rows_inplace(handle, inout + uint64_t(j) * n, n, 1, key);
+    }
+  }
+}
+
 };  // end namespace detail
 };  // end namespace raft::random
\ No newline at end of file
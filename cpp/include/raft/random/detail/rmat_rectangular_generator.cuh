@@ -18,13 +18,30 @@
 
 #include "rmat_rectangular_generator_types.cuh"
 
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
 #include <raft/random/rng_device.cuh>
 #include <raft/random/rng_state.hpp>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+#include <thrust/binary_search.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/remove.h>
+#include <thrust/unique.h>
+
+#include <algorithm>
+#include <cstdint>
+
 namespace raft {
 namespace random {
 namespace detail {
@@ -300,6 +317,197 @@ void rmat_rectangular_gen_impl(raft::resources const& handle,
                                       r);
 }
 
+/** Number of edges generated at once by `rmat_rectangular_gen_csr_impl`. */
+constexpr int64_t kRmatCsrBatchEdges = int64_t(1) << 24;
+
+/**
+ * Key of an edge: the source id in the high bits and the destination id in the `c_scale` low
+ * bits, so that sorting the keys sorts the edges by source, then by destination.
+ */
+struct rmat_edge_key_op {
+  int c_scale;
+  template <typename IdxT>
+  HDI uint64_t operator()(IdxT src, IdxT dst) const
+  {
+    return (uint64_t(src) << c_scale) | uint64_t(dst);
+  }
+};
+
+/** Whether the edge of a key is a self-loop. */
+struct rmat_self_loop_op {
+  int c_scale;
+  HDI bool operator()(uint64_t key) const
+  {
+    return (key >> c_scale) == (key & ((uint64_t(1) << c_scale) - 1));
+  }
+};
+
+/** Destination id of the edge of a key. */
+template <typename IdxT>
+struct rmat_key_dst_op {
+  int c_scale;
+  HDI IdxT operator()(uint64_t key) const { return IdxT(key & ((uint64_t(1) << c_scale) - 1)); }
+};
+
+/** Smallest key of the edges having `src` as source. */
+struct rmat_row_first_key_op {
+  int c_scale;
+  HDI uint64_t operator()(uint64_t src) const { return src << c_scale; }
+};
+
+/**
+ * @brief Generate RMAT edges and store them as a CSR structure.
+ *
+ * The edges are generated in batches of `kRmatCsrBatchEdges` by `gen_batch(src, dst, n)` and
+ * packed into 64-bit keys, which are sorted with a single radix sort limited to the
+ * `r_scale + c_scale` meaningful bits. Self-loops and duplicates are then removed in place and
+ * the row offsets are found by searching the first key of every row in the sorted keys.
+ */
+template <typename IdxT, typename NZType, typename GenBatch>
+void rmat_edges_to_csr(raft::resources const& handle,
+                       GenBatch gen_batch,
+                       IdxT r_scale,
+                       IdxT c_scale,
+                       IdxT n_edges,
+                       bool remove_duplicates,
+                       bool remove_self_loops,
+                       raft::device_compressed_structure<IdxT, IdxT, NZType>& out)
+{
+  static_assert(std::is_integral_v<IdxT>,
+                "rmat_rectangular_gen_csr: "
+                "Template parameter IdxT must be an integral type");
+  RAFT_EXPECTS(r_scale + c_scale <= 62,
+               "rmat_rectangular_gen_csr: r_scale + c_scale must be at most 62");
+  RAFT_EXPECTS(uint64_t(out.get_n_rows()) == uint64_t(1) << r_scale &&
+                 uint64_t(out.get_n_cols()) == uint64_t(1) << c_scale,
+               "rmat_rectangular_gen_csr: the output must have 2^r_scale rows and 2^c_scale "
+               "columns");
+  auto stream        = resource::get_cuda_stream(handle);
+  auto policy        = resource::get_thrust_policy(handle);
+  const int key_bits = int(r_scale + c_scale);
+  const IdxT n_rows  = out.get_n_rows();
+  const IdxT n_batch = IdxT(std::min<int64_t>(n_edges, kRmatCsrBatchEdges));
+  auto mr            = resource::get_workspace_resource(handle);
+  rmat_edge_key_op key_op{int(c_scale)};
+
+  rmm::device_uvector<uint64_t> keys(n_edges, stream);
+  {
+    rmm::device_uvector<IdxT> src(n_batch, stream, mr);
+    rmm::device_uvector<IdxT> dst(n_batch, stream, mr);
+    for (IdxT offset = 0; offset < n_edges; offset += n_batch) {
+      const IdxT n = std::min<IdxT>(n_batch, n_edges - offset);
+      gen_batch(src.data(), dst.data(), n);
+      linalg::map(handle,
+                  raft::make_device_vector_view<uint64_t, int64_t>(keys.data() + offset, n),
+                  key_op,
+                  raft::make_device_vector_view<const IdxT, int64_t>(src.data(), n),
+                  raft::make_device_vector_view<const IdxT, int64_t>(dst.data(), n));
+    }
+  }
+
+  rmm::device_uvector<uint64_t> sorted_keys(n_edges, stream);
+  size_t sort_bytes = 0;
+  RAFT_CUDA_TRY(cub::DeviceRadixSort::SortKeys(
+    nullptr, sort_bytes, keys.data(), sorted_keys.data(), n_edges, 0, key_bits, stream));
+  {
+    rmm::device_uvector<char> sort_workspace(sort_bytes, stream, mr);
+    RAFT_CUDA_TRY(cub::DeviceRadixSort::SortKeys(sort_workspace.data(),
+                                                 sort_bytes,
+                                                 keys.data(),
+                                                 sorted_keys.data(),
+                                                 n_edges,
+                                                 0,
+                                                 key_bits,
+                                                 stream));
+  }
+  keys.release();
+
+  auto keys_end = sorted_keys.begin() + n_edges;
+  if (remove_self_loops) {
+    keys_end = thrust::remove_if(
+      policy, sorted_keys.begin(), keys_end, rmat_self_loop_op{int(c_scale)});
+  }
+  if (remove_duplicates) { keys_end = thrust::unique(policy, sorted_keys.begin(), keys_end); }
+  const auto nnz = static_cast<NZType>(keys_end - sorted_keys.begin());
+
+  out.initialize_sparsity(nnz);
+  auto indptr  = out.get_indptr();
+  auto indices = out.get_indices();
+  if (nnz > 0) {
+    linalg::map(handle,
+                raft::make_device_vector_view<IdxT, int64_t>(indices.data(), nnz),
+                rmat_key_dst_op<IdxT>{int(c_scale)},
+                raft::make_device_vector_view<const uint64_t, int64_t>(sorted_keys.data(), nnz));
+  }
+  auto row_first_keys = thrust::make_transform_iterator(thrust::make_counting_iterator<uint64_t>(0),
+                                                        rmat_row_first_key_op{int(c_scale)});
+  thrust::lower_bound(policy,
+                      sorted_keys.begin(),
+                      keys_end,
+                      row_first_keys,
+                      row_first_keys + (n_rows + 1),
+                      indptr.data());
+}
+
+/**
+ * @brief Implementation of `raft::random::rmat_rectangular_gen_csr`.
+ */
+template <typename IdxT, typename ProbT, typename NZType>
+void rmat_rectangular_gen_csr_impl(raft::resources const& handle,
+                                   raft::random::RngState& r,
+                                   raft::device_vector_view<const ProbT, IdxT> theta,
+                                   raft::device_compressed_structure<IdxT, IdxT, NZType>& out,
+                                   IdxT n_edges,
+                                   IdxT r_scale,
+                                   IdxT c_scale,
+                                   bool remove_duplicates,
+                                   bool remove_self_loops)
+{
+  const IdxT expected_theta_len = IdxT(4) * (r_scale >= c_scale ? r_scale : c_scale);
+  RAFT_EXPECTS(theta.extent(0) == expected_theta_len,
+               "rmat_rectangular_gen_csr: "
+               "theta.extent(0) = %zu != 2 * 2 * max(r_scale = %zu, c_scale = %zu) = %zu",
+               static_cast<std::size_t>(theta.extent(0)),
+               static_cast<std::size_t>(r_scale),
+               static_cast<std::size_t>(c_scale),
+               static_cast<std::size_t>(expected_theta_len));
+  auto stream = resource::get_cuda_stream(handle);
+
+  auto gen_batch = [&](IdxT* src, IdxT* dst, IdxT n) {
+    rmat_rectangular_gen_caller(
+      static_cast<IdxT*>(nullptr), src, dst, theta.data_handle(), r_scale, c_scale, n, stream, r);
+  };
+  rmat_edges_to_csr(
+    handle, gen_batch, r_scale, c_scale, n_edges, remove_duplicates, remove_self_loops, out);
+}
+
+/**
+ * @brief Overload of `rmat_rectangular_gen_csr_impl` that assumes the same
+ *   a, b, c, d probability distributions across all the scales.
+ */
+template <typename IdxT, typename ProbT, typename NZType>
+void rmat_rectangular_gen_csr_impl(raft::resources const& handle,
+                                   raft::random::RngState& r,
+                                   raft::device_compressed_structure<IdxT, IdxT, NZType>& out,
+                                   ProbT a,
+                                   ProbT b,
+                                   ProbT c,
+                                   IdxT n_edges,
+                                   IdxT r_scale,
+                                   IdxT c_scale,
+                                   bool remove_duplicates,
+                                   bool remove_self_loops)
+{
+  auto stream = resource::get_cuda_stream(handle);
+
+  auto gen_batch = [&](IdxT* src, IdxT* dst, IdxT n) {
+    rmat_rectangular_gen_caller(
+      static_cast<IdxT*>(nullptr), src, dst, a, b, c, r_scale, c_scale, n, stream, r);
+  };
+  rmat_edges_to_csr(
+    handle, gen_batch, r_scale, c_scale, n_edges, remove_duplicates, remove_self_loops, out);
+}
+
 }  // end namespace detail
 }  // end namespace random
 }  // end namespace raft
@@ -421,7 +421,7 @@ HDI void custom_next(
 {
   OutType res;
   gen.next(res);
-  params.inIdxPtr[idx]  = idx;
+  if (params.inIdxPtr != nullptr) { params.inIdxPtr[idx] = idx; }
   constexpr OutType one = (OutType)1.0;
   auto exp              = -raft::log(one - res);
   if (params.wts != nullptr) {
@@ -703,6 +703,52 @@ RAFT_KERNEL rngKernel(DeviceState<GenType> rng_state, OutType* ptr, LenType len,
   return;
 }
 
+/**
+ * Layout of the sharded generation: the global array is cut in tiles of
+ * `kShardedTileLanes * kShardedItemsPerLane` elements, and the element `k * kShardedTileLanes + l`
+ * of the tile `t` is the `k`-th number of the subsequence `t * kShardedTileLanes + l`. The value of
+ * an element thus only depends on its global position, and a warp writes consecutive elements.
+ */
+constexpr uint64_t kShardedTileLanes    = 32;
+constexpr uint64_t kShardedItemsPerLane = 16;
+constexpr uint64_t kShardedTileLen      = kShardedTileLanes * kShardedItemsPerLane;
+
+/**
+ * Generate the elements [offset, offset + len) of a global random array into `ptr`. Each group of
+ * `kShardedTileLanes` threads generates whole tiles, and only keeps the elements of the shard.
+ */
+template <int ITEMS_PER_CALL,
+          typename OutType,
+          typename LenType,
+          typename GenType,
+          typename ParamType>
+RAFT_KERNEL rngShardedKernel(
+  DeviceState<GenType> rng_state, uint64_t offset, OutType* ptr, LenType len, ParamType params)
+{
+  static_assert(kShardedItemsPerLane % ITEMS_PER_CALL == 0);
+  const uint64_t tid        = threadIdx.x + static_cast<uint64_t>(blockIdx.x) * blockDim.x;
+  const uint64_t lane       = tid % kShardedTileLanes;
+  const uint64_t n_groups   = static_cast<uint64_t>(gridDim.x) * blockDim.x / kShardedTileLanes;
+  const uint64_t end        = offset + static_cast<uint64_t>(len);
+  const uint64_t end_tile   = (end + kShardedTileLen - 1) / kShardedTileLen;
+  const uint64_t first_tile = offset / kShardedTileLen;
+  for (uint64_t tile = first_tile + tid / kShardedTileLanes; tile < end_tile; tile += n_groups) {
+    GenType gen(rng_state, tile * kShardedTileLanes + lane);
+    const uint64_t base = tile * kShardedTileLen + lane;
+#pragma unroll
+    for (uint64_t k = 0; k < kShardedItemsPerLane; k += ITEMS_PER_CALL) {
+      const uint64_t idx = base + k * kShardedTileLanes;
+      OutType val[ITEMS_PER_CALL];
+      custom_next(gen, val, params, idx, kShardedTileLanes);
+#pragma unroll
+      for (int i = 0; i < ITEMS_PER_CALL; i++) {
+        const uint64_t pos = idx + i * kShardedTileLanes;
+        if (pos >= offset && pos < end) ptr[pos - offset] = val[i];
+      }
+    }
+  }
+}
+
 template <typename GenType, typename OutType, typename WeightType, typename IdxType>
 RAFT_KERNEL sample_with_replacement_kernel(DeviceState<GenType> rng_state,
                                            OutType* out,
@@ -20,7 +20,11 @@
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/math.hpp>
 #include <raft/core/operators.cuh>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/linalg/map.cuh>
+#include <raft/matrix/detail/select_k.cuh>
 #include <raft/random/rng_device.cuh>
 #include <raft/random/rng_state.hpp>
 #include <raft/util/cudart_utils.hpp>
@@ -32,6 +36,9 @@
 #include <cub/cub.cuh>
 #include <cuda_fp16.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace raft {
 namespace random {
 namespace detail {
@@ -243,6 +250,150 @@ void laplace(
   RAFT_CALL_RNG_FUNC(rng_state, call_rng_kernel<1>, rng_state, stream, ptr, len, params);
 }
 
+/**
+ * Advance the state past the subsequences used by a sharded generation of `total_len` elements.
+ * All the shards skip the subsequences of the whole array, whatever their own length.
+ */
+inline void advance_sharded(RngState& rng_state, uint64_t total_len)
+{
+  rng_state.advance(raft::ceildiv<uint64_t>(total_len, kShardedTileLen) * kShardedTileLanes,
+                    kShardedItemsPerLane);
+}
+
+template <int ITEMS_PER_CALL,
+          typename GenType,
+          typename OutType,
+          typename LenType,
+          typename ParamType>
+void call_rng_sharded_kernel(DeviceState<GenType> const& dev_state,
+                             RngState& rng_state,
+                             const RngShard& shard,
+                             cudaStream_t stream,
+                             OutType* ptr,
+                             LenType len,
+                             ParamType params)
+{
+  RAFT_EXPECTS(shard.offset + uint64_t(len) <= shard.total_len,
+               "The shard [%zu, %zu) exceeds the global array of %zu elements",
+               size_t(shard.offset),
+               size_t(shard.offset + uint64_t(len)),
+               size_t(shard.total_len));
+  if (len > 0) {
+    uint64_t end       = shard.offset + uint64_t(len);
+    uint64_t n_tiles   = raft::ceildiv(end, kShardedTileLen) - shard.offset / kShardedTileLen;
+    uint64_t n_threads = 256;
+    uint64_t n_blocks  = std::min<uint64_t>(4 * getMultiProcessorCount(),
+                                            raft::ceildiv(n_tiles * kShardedTileLanes, n_threads));
+    rngShardedKernel<ITEMS_PER_CALL>
+      <<<n_blocks, n_threads, 0, stream>>>(dev_state, shard.offset, ptr, len, params);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  advance_sharded(rng_state, shard.total_len);
+}
+
+template <typename OutType, typename LenType>
+void uniform(RngState& rng_state,
+             const RngShard& shard,
+             OutType* ptr,
+             LenType len,
+             OutType start,
+             OutType end,
+             cudaStream_t stream)
+{
+  static_assert(std::is_floating_point<OutType>::value || std::is_same_v<OutType, half>,
+                "Type for 'uniform' can only be floating point!");
+  UniformDistParams<OutType> params;
+  params.start = start;
+  params.end   = end;
+  RAFT_CALL_RNG_FUNC(
+    rng_state, call_rng_sharded_kernel<1>, rng_state, shard, stream, ptr, len, params);
+}
+
+template <typename OutType, typename LenType>
+void uniformInt(RngState& rng_state,
+                const RngShard& shard,
+                OutType* ptr,
+                LenType len,
+                OutType start,
+                OutType end,
+                cudaStream_t stream)
+{
+  static_assert(std::is_integral<OutType>::value, "Type for 'uniformInt' can only be integer!");
+  ASSERT(end > start, "'end' must be greater than 'start'");
+  if (sizeof(OutType) == 4) {
+    UniformIntDistParams<OutType, uint32_t> params;
+    params.start = start;
+    params.end   = end;
+    params.diff  = uint32_t(params.end - params.start);
+    RAFT_CALL_RNG_FUNC(
+      rng_state, call_rng_sharded_kernel<1>, rng_state, shard, stream, ptr, len, params);
+  } else {
+    UniformIntDistParams<OutType, uint64_t> params;
+    params.start = start;
+    params.end   = end;
+    params.diff  = uint64_t(params.end - params.start);
+    RAFT_CALL_RNG_FUNC(
+      rng_state, call_rng_sharded_kernel<1>, rng_state, shard, stream, ptr, len, params);
+  }
+}
+
+template <typename OutType, typename LenType>
+void normal(RngState& rng_state,
+            const RngShard& shard,
+            OutType* ptr,
+            LenType len,
+            OutType mu,
+            OutType sigma,
+            cudaStream_t stream)
+{
+  static_assert(std::is_floating_point<OutType>::value,
+                "Type for 'normal' can only be floating point!");
+  NormalDistParams<OutType> params;
+  params.mu    = mu;
+  params.sigma = sigma;
+  RAFT_CALL_RNG_FUNC(
+    rng_state, call_rng_sharded_kernel<2>, rng_state, shard, stream, ptr, len, params);
+}
+
+template <typename OutType, typename LenType>
+void normalTable(RngState& rng_state,
+                 const RngShard& shard,
+                 OutType* ptr,
+                 LenType n_rows,
+                 LenType n_cols,
+                 const OutType* mu_vec,
+                 const OutType* sigma_vec,
+                 OutType sigma,
+                 cudaStream_t stream)
+{
+  RAFT_EXPECTS(n_cols > 0 && shard.offset % uint64_t(n_cols) == 0,
+               "The shard of a table must start at the beginning of a row");
+  // the columns are computed from the global positions of the elements
+  NormalTableDistParams<OutType, uint64_t> params;
+  params.n_rows    = shard.total_len / uint64_t(n_cols);
+  params.n_cols    = n_cols;
+  params.mu_vec    = mu_vec;
+  params.sigma     = sigma;
+  params.sigma_vec = sigma_vec;
+  LenType len      = n_rows * n_cols;
+  RAFT_CALL_RNG_FUNC(
+    rng_state, call_rng_sharded_kernel<2>, rng_state, shard, stream, ptr, len, params);
+}
+
+template <typename Type, typename OutType, typename LenType>
+void bernoulli(RngState& rng_state,
+               const RngShard& shard,
+               OutType* ptr,
+               LenType len,
+               Type prob,
+               cudaStream_t stream)
+{
+  BernoulliDistParams<Type> params;
+  params.prob = prob;
+  RAFT_CALL_RNG_FUNC(
+    rng_state, call_rng_sharded_kernel<1>, rng_state, shard, stream, ptr, len, params);
+}
+
 template <typename GenType, typename OutType, typename WeightType, typename IdxType>
 void call_sample_with_replacement_kernel(DeviceState<GenType> const& dev_state,
                                          RngState& rng_state,
@@ -287,32 +438,77 @@ std::enable_if_t<std::is_integral_v<OutType>> discrete(RngState& rng_state,
                      len);
 }
 
-/** Note the memory space requirements are O(4*len) */
-template <typename DataT, typename WeightsT, typename IdxT = int>
-void sampleWithoutReplacement(RngState& rng_state,
-                              DataT* out,
-                              IdxT* outIdx,
-                              const DataT* in,
-                              const WeightsT* wts,
-                              IdxT sampledLen,
-                              IdxT len,
-                              cudaStream_t stream)
+/**
+ * Weighted sampling without replacement (Efraimidis-Spirakis): each item gets the key
+ * `exponential / weight`, and the sample is made of the `sampledLen` items with the smallest keys,
+ * in the order of their keys.
+ *
+ * When the sample is small compared to the population, the keys are selected with
+ * `matrix::select_k` (linear in `len`, plus a sort of the `sampledLen` selected keys) and the
+ * memory space requirements are O(len + sampledLen). Otherwise all the keys are sorted, with
+ * memory space requirements of O(4*len).
+ */
+template <typename DataT, typename WeightsT, typename IdxT>
+void sampleWithoutReplacementImpl(raft::resources const& handle,
+                                  RngState& rng_state,
+                                  DataT* out,
+                                  IdxT* outIdx,
+                                  const DataT* in,
+                                  const WeightsT* wts,
+                                  IdxT sampledLen,
+                                  IdxT len)
 {
   ASSERT(sampledLen <= len, "sampleWithoutReplacement: 'sampledLen' cant be more than 'len'.");
+  if (sampledLen == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
 
   rmm::device_uvector<WeightsT> expWts(len, stream);
+  SamplingParams<WeightsT, IdxT> params;
+  params.wts = wts;
+
+  const bool use_select_k = 2 * int64_t(sampledLen) <= int64_t(len) ||
+                            int64_t(len) > int64_t(std::numeric_limits<int>::max());
+  if (use_select_k) {
+    RAFT_EXPECTS(int64_t(sampledLen) <= int64_t(std::numeric_limits<int>::max()),
+                 "sampleWithoutReplacement: 'sampledLen' must fit the int type.");
+    // generate modified weights, the implied indices are 0...len-1
+    params.inIdxPtr = nullptr;
+    RAFT_CALL_RNG_FUNC(
+      rng_state, call_rng_kernel<1>, rng_state, stream, expWts.data(), len, params);
+
+    auto mr = resource::get_workspace_resource(handle);
+    rmm::device_uvector<WeightsT> selectedWts(sampledLen, stream, mr);
+    rmm::device_uvector<int64_t> selectedIdx(sampledLen, stream, mr);
+    raft::matrix::detail::select_k<WeightsT, int64_t>(handle,
+                                                      expWts.data(),
+                                                      nullptr,
+                                                      1,
+                                                      len,
+                                                      int(sampledLen),
+                                                      selectedWts.data(),
+                                                      selectedIdx.data(),
+                                                      true,
+                                                      true);
+    if (outIdx != nullptr) {
+      linalg::map(handle,
+                  raft::make_device_vector_view<IdxT, int64_t>(outIdx, sampledLen),
+                  raft::cast_op<IdxT>{},
+                  raft::make_device_vector_view<const int64_t, int64_t>(selectedIdx.data(),
+                                                                        sampledLen));
+    }
+    scatter<DataT, int64_t>(out, in, selectedIdx.data(), int64_t(sampledLen), stream);
+    return;
+  }
+
   rmm::device_uvector<WeightsT> sortedWts(len, stream);
   rmm::device_uvector<IdxT> inIdx(len, stream);
   rmm::device_uvector<IdxT> outIdxBuff(len, stream);
   auto* inIdxPtr = inIdx.data();
   // generate modified weights
-  SamplingParams<WeightsT, IdxT> params;
   params.inIdxPtr = inIdxPtr;
-  params.wts      = wts;
 
   RAFT_CALL_RNG_FUNC(rng_state, call_rng_kernel<1>, rng_state, stream, expWts.data(), len, params);
 
-  ///@todo: use a more efficient partitioning scheme instead of full sort
   // sort the array and pick the top sampledLen items
   IdxT* outIdxPtr = outIdxBuff.data();
   rmm::device_uvector<char> workspace(0, stream);
@@ -324,6 +520,21 @@ void sampleWithoutReplacement(RngState& rng_state,
   scatter<DataT, IdxT>(out, in, outIdxPtr, sampledLen, stream);
 }
 
+template <typename DataT, typename WeightsT, typename IdxT = int>
+void sampleWithoutReplacement(RngState& rng_state,
+                              DataT* out,
+                              IdxT* outIdx,
+                              const DataT* in,
+                              const WeightsT* wts,
+                              IdxT sampledLen,
+                              IdxT len,
+                              cudaStream_t stream)
+{
+  raft::resources handle;
+  resource::set_cuda_stream(handle, stream);
+  sampleWithoutReplacementImpl(handle, rng_state, out, outIdx, in, wts, sampledLen, len);
+}
+
 template <typename IdxT>
 void affine_transform_params(RngState const& rng_state, IdxT n, IdxT& a, IdxT& b)
 {
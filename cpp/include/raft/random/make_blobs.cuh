@@ -21,10 +21,17 @@
 
 #include "detail/make_blobs.cuh"
 
+#include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
 
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
 #include <optional>
 
 namespace raft::random {
@@ -183,6 +190,223 @@ void make_blobs(
                             type);
 }
 
+/**
+ * @brief A generator of isotropic Gaussian clusters, which produces the rows of a dataset in
+ * batches.
+ *
+ * The generator holds the parameters of a dataset of `n_rows` rows (the cluster centers are drawn
+ * once, at construction, when they are not given) and generates any range of rows on request,
+ * into device or host (pageable or pinned) memory. A row only depends on the seed and on its
+ * index: the batches can be generated in any order, by several generators on different devices,
+ * and always form the same dataset. This allows creating datasets much larger than the device
+ * memory, e.g. to write them to files batch by batch.
+ *
+ * The data is always row-major, and differs from the one of `make_blobs` with the same seed.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::random::blobs_generator<float, int64_t> gen(handle, n_rows, n_cols, n_clusters);
+ *   auto batch = raft::make_device_matrix<float, int64_t>(handle, batch_size, n_cols);
+ *   for (int64_t offset = 0; offset < n_rows; offset += batch_size) {
+ *     int64_t rows = std::min(batch_size, n_rows - offset);
+ *     auto out = raft::make_device_matrix_view<float, int64_t>(batch.data_handle(), rows, n_cols);
+ *     gen.generate(handle, offset, out);
+ *     // use the batch
+ *   }
+ * @endcode
+ *
+ * @tparam DataT output data type
+ * @tparam IdxT  indexing arithmetic type
+ */
+template <typename DataT, typename IdxT>
+class blobs_generator {
+ public:
+  /**
+   * @param[in] handle             raft handle for managing expensive resources
+   * @param[in] n_rows             number of rows of the whole dataset
+   * @param[in] n_cols             number of columns of the dataset
+   * @param[in] n_clusters         number of clusters (or classes) to generate
+   * @param[in] centers            centers of each of the cluster [dim = n_clusters x n_cols],
+   *                               drawn uniformly in the box [center_box_min, center_box_max]
+   *                               if not given. They are copied by the generator.
+   * @param[in] cluster_std        standard deviation of each cluster [len = n_clusters], or
+   *                               `cluster_std_scalar` for all clusters if not given.
+   * @param[in] cluster_std_scalar standard deviation of all clusters if `cluster_std` is not given
+   * @param[in] shuffle            shuffle the labels of the rows
+   * @param[in] center_box_min     min value of box from which to pick cluster centers
+   * @param[in] center_box_max     max value of box from which to pick cluster centers
+   * @param[in] seed               seed for the RNG
+   * @param[in] type               RNG type
+   */
+  blobs_generator(
+    raft::resources const& handle,
+    IdxT n_rows,
+    IdxT n_cols,
+    IdxT n_clusters                                                         = 5,
+    std::optional<device_matrix_view<const DataT, IdxT, row_major>> centers = std::nullopt,
+    std::optional<device_vector_view<const DataT, IdxT>> cluster_std        = std::nullopt,
+    DataT cluster_std_scalar                                                = DataT(1.0),
+    bool shuffle                                                            = true,
+    DataT center_box_min                                                    = DataT(-10.0),
+    DataT center_box_max                                                    = DataT(10.0),
+    uint64_t seed                                                           = 0ULL,
+    GeneratorType type                                                      = GenPC)
+    : n_rows_(n_rows),
+      n_cols_(n_cols),
+      n_clusters_(n_clusters),
+      cluster_std_scalar_(cluster_std_scalar),
+      shuffle_(shuffle),
+      centers_(raft::make_device_matrix<DataT, IdxT>(handle, n_clusters, n_cols)),
+      cluster_std_(
+        raft::make_device_vector<DataT, IdxT>(handle, cluster_std.has_value() ? n_clusters : 0)),
+      rng_state_(seed, type)
+  {
+    RAFT_EXPECTS(n_clusters > 0, "The number of clusters must be positive");
+    auto stream = resource::get_cuda_stream(handle);
+    if (centers.has_value()) {
+      RAFT_EXPECTS(centers->extent(0) == n_clusters && centers->extent(1) == n_cols,
+                   "The centers must be a [n_clusters, n_cols] matrix");
+      raft::copy(centers_.data_handle(), centers->data_handle(), centers_.size(), stream);
+    } else {
+      detail::uniform(rng_state_,
+                      centers_.data_handle(),
+                      n_clusters * n_cols,
+                      center_box_min,
+                      center_box_max,
+                      stream);
+    }
+    if (cluster_std.has_value()) {
+      RAFT_EXPECTS(cluster_std->extent(0) == n_clusters,
+                   "n_clusters must equal size of cluster_std");
+      raft::copy(cluster_std_.data_handle(), cluster_std->data_handle(), n_clusters, stream);
+    }
+    affine_transform_params(rng_state_, n_clusters, a_, b_);
+  }
+
+  /**
+   * @brief Generate the rows [row_offset, row_offset + out.extent(0)) of the dataset into device
+   * memory.
+   *
+   * @param[in]  handle     raft handle for managing expensive resources
+   * @param[in]  row_offset index of the first row to generate
+   * @param[out] out        the generated rows [dim = n_batch x n_cols]
+   * @param[out] labels     optional labels of the generated rows [len = n_batch]
+   */
+  void generate(raft::resources const& handle,
+                IdxT row_offset,
+                raft::device_matrix_view<DataT, IdxT, row_major> out,
+                std::optional<raft::device_vector_view<IdxT, IdxT>> labels = std::nullopt) const
+  {
+    check_batch(row_offset, out.extent(0), out.extent(1));
+    if (labels.has_value()) {
+      RAFT_EXPECTS(labels->extent(0) == out.extent(0), "One label per row is expected");
+    }
+    detail::generate_blobs_batch(handle,
+                                 rng_state_,
+                                 dist_params(),
+                                 static_cast<uint64_t>(n_rows_),
+                                 static_cast<uint64_t>(row_offset),
+                                 out.data_handle(),
+                                 labels.has_value() ? labels->data_handle() : nullptr,
+                                 out.extent(0));
+  }
+
+  /**
+   * @brief Generate the rows [row_offset, row_offset + out.extent(0)) of the dataset into host
+   * memory.
+   *
+   * The rows are generated on the device by batches, in the workspace memory resource of the
+   * handle, and copied to the host. The function returns when the output is ready.
+   *
+   * @param[in]  handle     raft handle for managing expensive resources
+   * @param[in]  row_offset index of the first row to generate
+   * @param[out] out        the generated rows [dim = n_batch x n_cols]
+   * @param[out] labels     optional labels of the generated rows [len = n_batch]
+   */
+  void generate(raft::resources const& handle,
+                IdxT row_offset,
+                raft::host_matrix_view<DataT, IdxT, row_major> out,
+                std::optional<raft::host_vector_view<IdxT, IdxT>> labels = std::nullopt) const
+  {
+    check_batch(row_offset, out.extent(0), out.extent(1));
+    if (labels.has_value()) {
+      RAFT_EXPECTS(labels->extent(0) == out.extent(0), "One label per row is expected");
+    }
+    IdxT n_batch = out.extent(0);
+    if (n_batch == 0) { return; }
+    auto stream      = resource::get_cuda_stream(handle);
+    auto mr          = resource::get_workspace_resource(handle);
+    size_t row_bytes = sizeof(DataT) * n_cols_ + (labels.has_value() ? sizeof(IdxT) : 0);
+    IdxT batch_size  = static_cast<IdxT>(std::clamp<size_t>(
+      resource::get_workspace_free_bytes(handle) / row_bytes, 1, static_cast<size_t>(n_batch)));
+    rmm::device_uvector<DataT> data_buf(size_t(batch_size) * n_cols_, stream, mr);
+    rmm::device_uvector<IdxT> labels_buf(labels.has_value() ? batch_size : 0, stream, mr);
+    for (IdxT i = 0; i < n_batch; i += batch_size) {
+      IdxT rows = std::min<IdxT>(batch_size, n_batch - i);
+      detail::generate_blobs_batch(handle,
+                                   rng_state_,
+                                   dist_params(),
+                                   static_cast<uint64_t>(n_rows_),
+                                   static_cast<uint64_t>(row_offset + i),
+                                   data_buf.data(),
+                                   labels.has_value() ? labels_buf.data() : nullptr,
+                                   rows);
+      raft::copy(
+        out.data_handle() + size_t(i) * n_cols_, data_buf.data(), size_t(rows) * n_cols_, stream);
+      if (labels.has_value()) {
+        raft::copy(labels->data_handle() + i, labels_buf.data(), rows, stream);
+      }
+    }
+    resource::sync_stream(handle);
+  }
+
+  /** Number of rows of the whole dataset */
+  [[nodiscard]] auto n_rows() const -> IdxT { return n_rows_; }
+  /** Number of columns of the dataset */
+  [[nodiscard]] auto n_cols() const -> IdxT { return n_cols_; }
+  /** Number of clusters */
+  [[nodiscard]] auto n_clusters() const -> IdxT { return n_clusters_; }
+  /** The cluster centers [dim = n_clusters x n_cols] */
+  [[nodiscard]] auto centers() const -> raft::device_matrix_view<const DataT, IdxT, row_major>
+  {
+    return centers_.view();
+  }
+
+ private:
+  void check_batch(IdxT row_offset, IdxT n_batch, IdxT n_cols) const
+  {
+    RAFT_EXPECTS(n_cols == n_cols_, "The output must have n_cols columns");
+    RAFT_EXPECTS(row_offset >= 0 && n_batch >= 0 && row_offset + n_batch <= n_rows_,
+                 "The rows [%zu, %zu) are out of the dataset of %zu rows",
+                 size_t(row_offset),
+                 size_t(row_offset + n_batch),
+                 size_t(n_rows_));
+  }
+
+  auto dist_params() const -> detail::BlobsDistParams<DataT, IdxT>
+  {
+    return {centers_.data_handle(),
+            cluster_std_.size() == 0 ? nullptr : cluster_std_.data_handle(),
+            cluster_std_scalar_,
+            n_cols_,
+            n_clusters_,
+            a_,
+            b_,
+            shuffle_};
+  }
+
+  IdxT n_rows_;
+  IdxT n_cols_;
+  IdxT n_clusters_;
+  DataT cluster_std_scalar_;
+  bool shuffle_;
+  raft::device_matrix<DataT, IdxT, row_major> centers_;
+  raft::device_vector<DataT, IdxT> cluster_std_;
+  RngState rng_state_;
+  IdxT a_{0};
+  IdxT b_{0};
+};
+
 /** @} */  // end group make_blobs
 
 }  // end namespace raft::random
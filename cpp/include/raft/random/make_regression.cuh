@@ -25,9 +25,15 @@
 
 #include "detail/make_regression.cuh"
 
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
 
 #include <algorithm>
 #include <optional>
@@ -185,6 +191,185 @@ void make_regression(raft::resources const& handle,
                                  type);
 }
 
+/**
+ * @brief A generator of a regression problem, which produces the samples of a dataset in batches.
+ *
+ * The generator draws the coefficients of the ground truth model at construction and generates
+ * any range of samples on request, into device or host (pageable or pinned) memory. A sample only
+ * depends on the seed and on its index: the batches can be generated in any order, by several
+ * generators on different devices, and always form the same dataset. This allows creating
+ * datasets much larger than the device memory.
+ *
+ * The inputs are well conditioned (standard normal) and the samples and features are not
+ * shuffled: a low effective rank and the shuffling need the whole dataset, and are only supported
+ * by `make_regression`. The data differs from the one of `make_regression` with the same seed.
+ *
+ * @tparam  DataT  Scalar type
+ * @tparam  IdxT   Index type
+ */
+template <typename DataT, typename IdxT>
+class regression_generator {
+ public:
+  /**
+   * @param[in]   handle          RAFT handle
+   * @param[in]   n_rows          Number of samples of the whole dataset
+   * @param[in]   n_cols          Number of features
+   * @param[in]   n_informative   Number of informative features (non-zero coefficients)
+   * @param[in]   n_targets       Number of targets
+   * @param[in]   bias            A scalar that will be added to the values
+   * @param[in]   noise           Standard deviation of the Gaussian noise applied to the output
+   * @param[in]   seed            Seed for the random number generator
+   * @param[in]   type            Random generator type
+   */
+  regression_generator(raft::resources const& handle,
+                       IdxT n_rows,
+                       IdxT n_cols,
+                       IdxT n_informative,
+                       IdxT n_targets     = 1,
+                       DataT bias         = DataT{},
+                       DataT noise        = DataT{},
+                       uint64_t seed      = 0ULL,
+                       GeneratorType type = GenPC)
+    : n_rows_(n_rows),
+      n_cols_(n_cols),
+      n_informative_(std::min(n_informative, n_cols)),
+      n_targets_(n_targets),
+      bias_(bias),
+      noise_(noise),
+      coef_(raft::make_device_matrix<DataT, IdxT>(handle, n_cols, n_targets)),
+      x_state_(seed, type),
+      noise_state_(seed, type)
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    // Generate a ground truth model with only n_informative features
+    detail::uniform(x_state_,
+                    coef_.data_handle(),
+                    n_informative_ * n_targets,
+                    DataT(1.0),
+                    DataT(100.0),
+                    stream);
+    if (n_informative_ != n_cols) {
+      RAFT_CUDA_TRY(cudaMemsetAsync(coef_.data_handle() + n_informative_ * n_targets,
+                                    0,
+                                    (n_cols - n_informative_) * n_targets * sizeof(DataT),
+                                    stream));
+    }
+    noise_state_ = x_state_;
+    detail::advance_sharded(noise_state_, static_cast<uint64_t>(n_rows) * n_cols);
+  }
+
+  /**
+   * @brief Generate the samples [row_offset, row_offset + out.extent(0)) into device memory.
+   *
+   * @param[in]   handle      RAFT handle
+   * @param[in]   row_offset  Index of the first sample to generate
+   * @param[out]  out         Row-major (batch samples, features) matrix
+   * @param[out]  values      Row-major (batch samples, targets) matrix
+   */
+  void generate(raft::resources const& handle,
+                IdxT row_offset,
+                raft::device_matrix_view<DataT, IdxT, raft::row_major> out,
+                raft::device_matrix_view<DataT, IdxT, raft::row_major> values) const
+  {
+    check_batch(row_offset, out.extent(0), out.extent(1), values.extent(0), values.extent(1));
+    generate_impl(handle, row_offset, out.data_handle(), values.data_handle(), out.extent(0));
+  }
+
+  /**
+   * @brief Generate the samples [row_offset, row_offset + out.extent(0)) into host memory.
+   *
+   * The samples are generated on the device by batches, in the workspace memory resource of the
+   * handle, and copied to the host. The function returns when the output is ready.
+   *
+   * @param[in]   handle      RAFT handle
+   * @param[in]   row_offset  Index of the first sample to generate
+   * @param[out]  out         Row-major (batch samples, features) matrix
+   * @param[out]  values      Row-major (batch samples, targets) matrix
+   */
+  void generate(raft::resources const& handle,
+                IdxT row_offset,
+                raft::host_matrix_view<DataT, IdxT, raft::row_major> out,
+                raft::host_matrix_view<DataT, IdxT, raft::row_major> values) const
+  {
+    check_batch(row_offset, out.extent(0), out.extent(1), values.extent(0), values.extent(1));
+    IdxT n_batch = out.extent(0);
+    if (n_batch == 0) { return; }
+    auto stream      = resource::get_cuda_stream(handle);
+    auto mr          = resource::get_workspace_resource(handle);
+    size_t row_bytes = sizeof(DataT) * (n_cols_ + n_targets_);
+    IdxT batch_size  = static_cast<IdxT>(std::clamp<size_t>(
+      resource::get_workspace_free_bytes(handle) / row_bytes, 1, static_cast<size_t>(n_batch)));
+    rmm::device_uvector<DataT> out_buf(size_t(batch_size) * n_cols_, stream, mr);
+    rmm::device_uvector<DataT> values_buf(size_t(batch_size) * n_targets_, stream, mr);
+    for (IdxT i = 0; i < n_batch; i += batch_size) {
+      IdxT rows = std::min<IdxT>(batch_size, n_batch - i);
+      generate_impl(handle, row_offset + i, out_buf.data(), values_buf.data(), rows);
+      raft::copy(
+        out.data_handle() + size_t(i) * n_cols_, out_buf.data(), size_t(rows) * n_cols_, stream);
+      raft::copy(values.data_handle() + size_t(i) * n_targets_,
+                 values_buf.data(),
+                 size_t(rows) * n_targets_,
+                 stream);
+    }
+    resource::sync_stream(handle);
+  }
+
+  /** Number of samples of the whole dataset */
+  [[nodiscard]] auto n_rows() const -> IdxT { return n_rows_; }
+  /** Number of features */
+  [[nodiscard]] auto n_cols() const -> IdxT { return n_cols_; }
+  /** Number of targets */
+  [[nodiscard]] auto n_targets() const -> IdxT { return n_targets_; }
+  /** The coefficients of the ground truth model, row-major (features, targets) */
+  [[nodiscard]] auto coef() const -> raft::device_matrix_view<const DataT, IdxT, raft::row_major>
+  {
+    return coef_.view();
+  }
+
+ private:
+  void check_batch(
+    IdxT row_offset, IdxT n_batch, IdxT n_cols, IdxT n_value_rows, IdxT n_value_cols) const
+  {
+    RAFT_EXPECTS(n_cols == n_cols_, "The output must have n_cols columns");
+    RAFT_EXPECTS(n_value_rows == n_batch && n_value_cols == n_targets_,
+                 "The values must be a (batch samples, targets) matrix");
+    RAFT_EXPECTS(row_offset >= 0 && n_batch >= 0 && row_offset + n_batch <= n_rows_,
+                 "The samples [%zu, %zu) are out of the dataset of %zu samples",
+                 size_t(row_offset),
+                 size_t(row_offset + n_batch),
+                 size_t(n_rows_));
+  }
+
+  void generate_impl(
+    raft::resources const& handle, IdxT row_offset, DataT* out, DataT* values, IdxT n_batch) const
+  {
+    detail::generate_regression_batch(handle,
+                                      x_state_,
+                                      noise_state_,
+                                      coef_.data_handle(),
+                                      static_cast<uint64_t>(n_rows_),
+                                      static_cast<uint64_t>(row_offset),
+                                      out,
+                                      values,
+                                      n_batch,
+                                      n_cols_,
+                                      n_informative_,
+                                      n_targets_,
+                                      bias_,
+                                      noise_);
+  }
+
+  IdxT n_rows_;
+  IdxT n_cols_;
+  IdxT n_informative_;
+  IdxT n_targets_;
+  DataT bias_;
+  DataT noise_;
+  raft::device_matrix<DataT, IdxT, raft::row_major> coef_;
+  RngState x_state_;
+  RngState noise_state_;
+};
+
 /** @} */  // end group make_regression
 
 }  // namespace raft::random
@@ -24,6 +24,7 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/random/rng_state.hpp>
 
 #include <optional>
 #include <type_traits>
@@ -66,9 +67,10 @@ using perms_out_view_t = typename perms_out_view<T, InputOutputValueType, IdxTyp
 /**
  * @brief Randomly permute the rows of the input matrix.
  *
- * We do not support in-place permutation, so that we can compute
- * in parallel without race conditions.  This function is useful
- * for shuffling input data sets in machine learning algorithms.
+ * This function does not permute in place, so that we can compute
+ * in parallel without race conditions (see `permute_inplace` for that).
+ * This function is useful for shuffling input data sets in machine
+ * learning algorithms.
  *
  * @tparam InputOutputValueType Type of each element of the input matrix,
  *   and the type of each element of the output matrix (if provided)
@@ -171,6 +173,89 @@ void permute(raft::resources const& handle,
   permute(handle, in, permsOut_arg, out_arg);
 }
 
+/**
+ * @brief Randomly permute the rows of a matrix in place.
+ *
+ * Unlike `permute`, no second matrix is needed: the rows are shuffled through a temporary
+ * buffer from the workspace resource, which only needs to hold about sqrt(N) rows. The
+ * permutation is made of keyed Feistel bijections evaluated on the fly, applied to the rows of
+ * a (N / sqrt(N), sqrt(N)) grid of rows by three passes: a shuffle of every grid column, of
+ * every grid row and of every grid column again. The permutation indices are never stored,
+ * unless requested.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  raft::random::RngState rng(1234ULL);
+ *  auto data  = raft::make_device_matrix<float, int64_t>(handle, n_rows, n_cols);
+ *  auto perms = raft::make_device_vector<int64_t, int64_t>(handle, n_rows);
+ *  ...
+ *  // the row i of the new data is the row perms(i) of the old data
+ *  raft::random::permute_inplace(handle, rng, data.view(), std::make_optional(perms.view()));
+ * @endcode
+ *
+ * @tparam InputOutputValueType Type of each element of the matrix
+ * @tparam IntType Integer type of each element of `permsOut`
+ * @tparam IdxType Integer type of the extents of the mdspan parameters
+ * @tparam Layout Either `raft::row_major` or `raft::col_major`
+ *
+ * @param[in] handle RAFT handle containing the CUDA stream
+ *   on which to run.
+ * @param[inout] rng_state random generator state, the same state giving the same permutation
+ *   for the same number of rows
+ * @param[inout] inout matrix whose rows are permuted
+ * @param[out] permsOut If provided, the indices of the permutation, such that the row `i`
+ *   of the output is the row `permsOut(i)` of the input.
+ *
+ * @pre If `permsOut.has_value()` is `true`,
+ *   then `(*permsOut).extent(0) == inout.extent(0)` is `true`.
+ *
+ * @note The three passes read and write the matrix twice each, and a column-major matrix is
+ *   permuted one column at a time. When memory allows it, `permute` is faster.
+ */
+template <typename InputOutputValueType, typename IntType, typename IdxType, typename Layout>
+void permute_inplace(raft::resources const& handle,
+                     raft::random::RngState& rng_state,
+                     raft::device_matrix_view<InputOutputValueType, IdxType, Layout> inout,
+                     std::optional<raft::device_vector_view<IntType, IdxType>> permsOut)
+{
+  static_assert(std::is_integral_v<IntType>,
+                "permute_inplace: The type of each element "
+                "of permsOut (if provided) must be an integral type.");
+  static_assert(std::is_integral_v<IdxType>,
+                "permute_inplace: The index type "
+                "of each mdspan argument must be an integral type.");
+  constexpr bool is_row_major = std::is_same_v<Layout, raft::row_major>;
+  constexpr bool is_col_major = std::is_same_v<Layout, raft::col_major>;
+  static_assert(is_row_major || is_col_major,
+                "permute_inplace: Layout must be either "
+                "raft::row_major or raft::col_major (or one of their aliases)");
+
+  RAFT_EXPECTS(!permsOut.has_value() || (*permsOut).extent(0) == inout.extent(0),
+               "permute_inplace: If 'permsOut' is provided, then its extent(0) "
+               "must equal the number of rows of the matrix 'inout'.");
+
+  IntType* permsOut_ptr = permsOut.has_value() ? (*permsOut).data_handle() : nullptr;
+  detail::permute_inplace<InputOutputValueType, IntType, IdxType>(handle,
+                                                                  rng_state,
+                                                                  permsOut_ptr,
+                                                                  inout.data_handle(),
+                                                                  inout.extent(1),
+                                                                  inout.extent(0),
+                                                                  is_row_major);
+}
+
+/**
+ * @brief Overload of `permute_inplace` that does not output the permutation indices.
+ */
+template <typename InputOutputValueType, typename IdxType, typename Layout>
+void permute_inplace(raft::resources const& handle,
+                     raft::random::RngState& rng_state,
+                     raft::device_matrix_view<InputOutputValueType, IdxType, Layout> inout)
+{
+  permute_inplace(
+    handle, rng_state, inout, std::optional<raft::device_vector_view<IdxType, IdxType>>{});
+}
+
 /** @} */
 
 /**
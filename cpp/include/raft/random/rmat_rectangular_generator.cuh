@@ -18,6 +18,7 @@
 
 #include "detail/rmat_rectangular_generator.cuh"
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/resources.hpp>
 
 namespace raft::random {
@@ -219,6 +220,85 @@ void rmat_rectangular_gen(
   detail::rmat_rectangular_gen_impl(handle, r, output, a, b, c, r_scale, c_scale);
 }
 
+/**
+ * @brief Generate a bipartite RMAT graph directly as a CSR structure.
+ *
+ * This produces the same edges as `rmat_rectangular_gen` for the same `r`, but instead of an
+ * edge list it outputs the adjacency matrix in the compressed sparse row format, with the
+ * destination ids of every row sorted. The edges are generated in batches, packed into 64-bit
+ * keys and sorted once on the `r_scale + c_scale` meaningful bits, so no separate
+ * sort-and-coalesce pass over a COO edge list is needed.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  raft::resources handle;
+ *  raft::random::RngState r(1234ULL);
+ *  auto csr = raft::make_device_compressed_structure<int64_t, int64_t, int64_t>(
+ *    handle, int64_t(1) << r_scale, int64_t(1) << c_scale);
+ *  raft::random::rmat_rectangular_gen_csr(handle, r, theta, csr, n_edges, r_scale, c_scale);
+ *  auto indptr  = csr.get_indptr();   // [2^r_scale + 1]
+ *  auto indices = csr.get_indices();  // [nnz]
+ * @endcode
+ *
+ * @tparam IdxT   Type of each node index, also used for the row offsets
+ * @tparam ProbT  Data type used for probability distributions (either fp32 or fp64)
+ * @tparam NZType Type of the number of nonzeros of the output
+ *
+ * @param[in]  handle            RAFT handle, containing the CUDA stream on which to schedule work
+ * @param[in]  r                 underlying state of the random generator
+ * @param[in]  theta             distribution of each quadrant at each level of resolution
+ *                               [on device] [dim = max(r_scale, c_scale) x 2 x 2]
+ * @param[out] out               sparsity-owning CSR structure of shape 2^r_scale x 2^c_scale;
+ *                               its sparsity is initialized to the number of output edges.
+ * @param[in]  n_edges           number of edges to generate (before the removals)
+ * @param[in]  r_scale           2^r_scale represents the number of source nodes
+ * @param[in]  c_scale           2^c_scale represents the number of destination nodes,
+ *                               `r_scale + c_scale` must be at most 62
+ * @param[in]  remove_duplicates whether to keep a single copy of the repeated edges
+ * @param[in]  remove_self_loops whether to remove the edges whose source and destination ids
+ *                               are equal
+ *
+ * @note Memory usage is about `16 * n_edges` bytes for the keys, plus a batch of edges.
+ */
+template <typename IdxT, typename ProbT, typename NZType>
+void rmat_rectangular_gen_csr(raft::resources const& handle,
+                              raft::random::RngState& r,
+                              raft::device_vector_view<const ProbT, IdxT> theta,
+                              raft::device_compressed_structure<IdxT, IdxT, NZType>& out,
+                              IdxT n_edges,
+                              IdxT r_scale,
+                              IdxT c_scale,
+                              bool remove_duplicates = true,
+                              bool remove_self_loops = true)
+{
+  detail::rmat_rectangular_gen_csr_impl(
+    handle, r, theta, out, n_edges, r_scale, c_scale, remove_duplicates, remove_self_loops);
+}
+
+/**
+ * @brief Overload of `rmat_rectangular_gen_csr` that assumes the same
+ *   a, b, c, d probability distributions across all the scales.
+ *
+ * `a`, `b, and `c` effectively replace the above overload's
+ * `theta` parameter.
+ */
+template <typename IdxT, typename ProbT, typename NZType>
+void rmat_rectangular_gen_csr(raft::resources const& handle,
+                              raft::random::RngState& r,
+                              raft::device_compressed_structure<IdxT, IdxT, NZType>& out,
+                              ProbT a,
+                              ProbT b,
+                              ProbT c,
+                              IdxT n_edges,
+                              IdxT r_scale,
+                              IdxT c_scale,
+                              bool remove_duplicates = true,
+                              bool remove_self_loops = true)
+{
+  detail::rmat_rectangular_gen_csr_impl(
+    handle, r, out, a, b, c, n_edges, r_scale, c_scale, remove_duplicates, remove_self_loops);
+}
+
 /** @} */  // end group rmat
 
 /**
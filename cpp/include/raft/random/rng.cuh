@@ -739,6 +739,202 @@ void laplace(raft::resources const& handle,
   detail::laplace(rng_state, ptr, len, mu, scale, resource::get_cuda_stream(handle));
 }
 
+/**
+ * \defgroup sharded_random_sampling Sharded random sampling
+ *
+ * These overloads generate a slice (`RngShard`) of a global random array. An element of the
+ * global array gets a value which only depends on the RNG state and on its global position, so
+ * several ranks or GPUs can each generate their part of the array without any communication, and
+ * the concatenation of the parts does not depend on the number of parts or on the devices.
+ * All the parts must be generated with the same `RngState` and `RngShard::total_len`; they all
+ * advance the state by the same amount.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  #include <raft/random/rng.cuh>
+ *
+ *  // rank r of n_ranks generates the rows [r * rows_per_rank, (r + 1) * rows_per_rank)
+ *  raft::random::RngState rng(seed);
+ *  raft::random::RngShard shard{r * rows_per_rank * n_cols, n_ranks * rows_per_rank * n_cols};
+ *  auto local = raft::make_device_vector<float, int64_t>(handle, rows_per_rank * n_cols);
+ *  raft::random::normal(handle, rng, shard, local.view(), 0.0f, 1.0f);
+ * @endcode
+ *
+ * Note that the values differ from the ones of the non-sharded overloads, whose output depends
+ * on the number of multiprocessors of the device.
+ * @{
+ */
+
+/**
+ * @brief Generate a shard of a global array of uniformly distributed numbers
+ *
+ * @tparam OutputValueType Data type of output random number
+ * @tparam IndexType Data type used to represent length of the arrays
+ *
+ * @param[in] handle raft handle for resource management
+ * @param[in] rng_state random number generator state
+ * @param[in] shard position of `out` in the global array
+ * @param[out] out the elements [shard.offset, shard.offset + out.extent(0)) of the global array
+ * @param[in] start start of the range
+ * @param[in] end end of the range
+ */
+template <typename OutputValueType, typename IndexType>
+void uniform(raft::resources const& handle,
+             RngState& rng_state,
+             const RngShard& shard,
+             raft::device_vector_view<OutputValueType, IndexType> out,
+             OutputValueType start,
+             OutputValueType end)
+{
+  detail::uniform(rng_state,
+                  shard,
+                  out.data_handle(),
+                  out.extent(0),
+                  start,
+                  end,
+                  resource::get_cuda_stream(handle));
+}
+
+/**
+ * @brief Generate a shard of a global array of uniformly distributed integers
+ *
+ * @tparam OutputValueType Integral type; value type of the output vector
+ * @tparam IndexType Type used to represent length of the output vector
+ *
+ * @param[in] handle raft handle for resource management
+ * @param[in] rng_state random number generator state
+ * @param[in] shard position of `out` in the global array
+ * @param[out] out the elements [shard.offset, shard.offset + out.extent(0)) of the global array
+ * @param[in] start start of the range
+ * @param[in] end end of the range
+ */
+template <typename OutputValueType, typename IndexType>
+void uniformInt(raft::resources const& handle,
+                RngState& rng_state,
+                const RngShard& shard,
+                raft::device_vector_view<OutputValueType, IndexType> out,
+                OutputValueType start,
+                OutputValueType end)
+{
+  static_assert(std::is_integral<OutputValueType>::value,
+                "uniformInt: The elements of the output vector must have integral type.");
+  detail::uniformInt(rng_state,
+                     shard,
+                     out.data_handle(),
+                     out.extent(0),
+                     start,
+                     end,
+                     resource::get_cuda_stream(handle));
+}
+
+/**
+ * @brief Generate a shard of a global array of normal distributed numbers
+ *
+ * @tparam OutputValueType data type of output random number
+ * @tparam IndexType data type used to represent length of the arrays
+ *
+ * @param[in] handle raft handle for resource management
+ * @param[in] rng_state random number generator state
+ * @param[in] shard position of `out` in the global array
+ * @param[out] out the elements [shard.offset, shard.offset + out.extent(0)) of the global array
+ * @param[in] mu mean of the distribution
+ * @param[in] sigma std-dev of the distribution
+ */
+template <typename OutputValueType, typename IndexType>
+void normal(raft::resources const& handle,
+            RngState& rng_state,
+            const RngShard& shard,
+            raft::device_vector_view<OutputValueType, IndexType> out,
+            OutputValueType mu,
+            OutputValueType sigma)
+{
+  detail::normal(rng_state,
+                 shard,
+                 out.data_handle(),
+                 out.extent(0),
+                 mu,
+                 sigma,
+                 resource::get_cuda_stream(handle));
+}
+
+/**
+ * @brief Generate a block of rows of a global normal distributed table (see `normalTable`).
+ *
+ * @tparam OutputValueType data type of output random number
+ * @tparam IndexType data type used to represent length of the arrays
+ *
+ * @param[in] handle raft handle for resource management
+ * @param[in] rng_state random number generator state
+ * @param[in] shard position of `out` in the global table, in elements. `shard.offset` must be a
+ *   multiple of the number of columns.
+ * @param[in] mu_vec mean vector (of length `out.extent(1)`)
+ * @param[in] sigma Either the standard-deviation vector
+ *            (of length `out.extent(1)`) of each component,
+ *            or a scalar standard deviation for all components.
+ * @param[out] out the rows of the global table starting at the row `shard.offset / out.extent(1)`
+ */
+template <typename OutputValueType, typename IndexType>
+void normalTable(
+  raft::resources const& handle,
+  RngState& rng_state,
+  const RngShard& shard,
+  raft::device_vector_view<const OutputValueType, IndexType> mu_vec,
+  std::variant<raft::device_vector_view<const OutputValueType, IndexType>, OutputValueType> sigma,
+  raft::device_matrix_view<OutputValueType, IndexType, raft::row_major> out)
+{
+  const OutputValueType* sigma_vec_ptr = nullptr;
+  OutputValueType sigma_value{};
+
+  using sigma_vec_type = raft::device_vector_view<const OutputValueType, IndexType>;
+  if (std::holds_alternative<sigma_vec_type>(sigma)) {
+    auto sigma_vec = std::get<sigma_vec_type>(sigma);
+    RAFT_EXPECTS(sigma_vec.extent(0) == out.extent(1),
+                 "normalTable: The sigma vector must have one element per column.");
+    sigma_vec_ptr = sigma_vec.extent(0) == 0 ? nullptr : sigma_vec.data_handle();
+  } else {
+    sigma_value = std::get<OutputValueType>(sigma);
+  }
+  RAFT_EXPECTS(mu_vec.extent(0) == out.extent(1),
+               "normalTable: The mu vector must have one element per column.");
+
+  detail::normalTable(rng_state,
+                      shard,
+                      out.data_handle(),
+                      out.extent(0),
+                      out.extent(1),
+                      mu_vec.data_handle(),
+                      sigma_vec_ptr,
+                      sigma_value,
+                      resource::get_cuda_stream(handle));
+}
+
+/**
+ * @brief Generate a shard of a global bernoulli distributed array
+ *
+ * @tparam OutputValueType Type of each element of the output vector;
+ *         must be able to represent boolean values (e.g., `bool`)
+ * @tparam IndexType Integral type of the output vector's length
+ * @tparam Type Data type in which to compute the probabilities
+ *
+ * @param[in] handle raft handle for resource management
+ * @param[in] rng_state random number generator state
+ * @param[in] shard position of `out` in the global array
+ * @param[out] out the elements [shard.offset, shard.offset + out.extent(0)) of the global array
+ * @param[in] prob coin-toss probability for heads
+ */
+template <typename OutputValueType, typename IndexType, typename Type>
+void bernoulli(raft::resources const& handle,
+               RngState& rng_state,
+               const RngShard& shard,
+               raft::device_vector_view<OutputValueType, IndexType> out,
+               Type prob)
+{
+  detail::bernoulli(
+    rng_state, shard, out.data_handle(), out.extent(0), prob, resource::get_cuda_stream(handle));
+}
+
+/** @} */
+
 /**
  * @ingroup univariate_random_sampling
  * @brief Generate random integers, where the probability of i is weights[i]/sum(weights)
@@ -809,8 +1005,8 @@ void sampleWithoutReplacement(raft::resources const& handle,
                               IdxT sampledLen,
                               IdxT len)
 {
-  detail::sampleWithoutReplacement(
-    rng_state, out, outIdx, in, wts, sampledLen, len, resource::get_cuda_stream(handle));
+  detail::sampleWithoutReplacementImpl(
+    handle, rng_state, out, outIdx, in, wts, sampledLen, len);
 }
 
 /** @brief Sample from range 0..N-1.
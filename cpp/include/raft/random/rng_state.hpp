@@ -58,6 +58,22 @@ struct RngState {
   }
 };
 
+/**
+ * A slice of a global random array, generated by one rank (or one GPU, or one call) of a sharded
+ * generation.
+ *
+ * The sharded generators give each element a value which only depends on the RNG state and on the
+ * position of the element in the global array: all the shards of an array, generated
+ * independently with the same `RngState` and the same `total_len`, form the same `total_len`
+ * elements whatever the number of shards and the device they run on.
+ */
+struct RngShard {
+  /** position of the first element of the shard in the global array */
+  uint64_t offset{0};
+  /** number of elements of the global array */
+  uint64_t total_len{0};
+};
+
 };  // end namespace random
 };  // end namespace raft
 
@@ -140,14 +140,14 @@ void sample_without_replacement(raft::resources const& handle,
   }
   const weight_type* wts_ptr = wts_has_value ? (*wts).data_handle() : nullptr;
 
-  detail::sampleWithoutReplacement(rng_state,
-                                   out.data_handle(),
-                                   outIdx_ptr,
-                                   in.data_handle(),
-                                   wts_ptr,
-                                   sampledLen,
-                                   len,
-                                   resource::get_cuda_stream(handle));
+  detail::sampleWithoutReplacementImpl(handle,
+                                       rng_state,
+                                       out.data_handle(),
+                                       outIdx_ptr,
+                                       in.data_handle(),
+                                       wts_ptr,
+                                       sampledLen,
+                                       len);
 }
 
 /**
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/scan.h>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+namespace raft::solver::detail {
+
+template <typename vertex_t>
+struct square_op {
+  __host__ __device__ int64_t operator()(vertex_t n) const { return int64_t(n) * int64_t(n); }
+};
+
+template <typename vertex_t>
+struct plus_one_op {
+  __host__ __device__ int64_t operator()(vertex_t n) const { return int64_t(n) + 1; }
+};
+
+/**
+ * Solve one assignment problem per block with the shortest augmenting path variant of the
+ * Hungarian algorithm (O(n^3), Jonker-Volgenant style potentials).
+ *
+ * The rows are inserted one at a time; every step of the Dijkstra-like search scans the columns
+ * in parallel over the block and picks the closest one with a block-wide argmin, so the whole
+ * solve runs on the device without any convergence check on the host. The work arrays hold
+ * n + 1 entries per problem, entry 0 being the virtual column the search starts from.
+ */
+template <int BlockSize, typename vertex_t, typename weight_t>
+RAFT_KERNEL __launch_bounds__(BlockSize)
+  batched_lap_kernel(const weight_t* costs,
+                     const int64_t* cost_offsets,
+                     const vertex_t* sizes,
+                     const int64_t* offsets,
+                     const int64_t* work_offsets,
+                     weight_t* row_duals,
+                     weight_t* col_duals,
+                     weight_t* min_slacks,
+                     vertex_t* col_rows,
+                     vertex_t* way,
+                     bool* used,
+                     vertex_t* row_assignments,
+                     vertex_t* col_assignments,
+                     weight_t* obj_values)
+{
+  using pair_t   = cub::KeyValuePair<vertex_t, weight_t>;
+  using reduce_t = cub::BlockReduce<pair_t, BlockSize>;
+  __shared__ typename reduce_t::TempStorage reduce_storage;
+  __shared__ typename cub::BlockReduce<weight_t, BlockSize>::TempStorage sum_storage;
+  __shared__ vertex_t s_j0;
+  __shared__ weight_t s_delta;
+
+  constexpr weight_t kInf = std::numeric_limits<weight_t>::max();
+
+  const auto problem = blockIdx.x;
+  const vertex_t n   = sizes[problem];
+  const weight_t* a  = costs + cost_offsets[problem];
+  const auto w_off   = work_offsets[problem];
+  weight_t* u        = row_duals + w_off;
+  weight_t* v        = col_duals + w_off;
+  weight_t* minv     = min_slacks + w_off;
+  vertex_t* p        = col_rows + w_off;
+  vertex_t* w        = way + w_off;
+  bool* in_tree      = used + w_off;
+
+  for (vertex_t j = threadIdx.x; j <= n; j += BlockSize) {
+    u[j] = weight_t(0);
+    v[j] = weight_t(0);
+    p[j] = 0;
+  }
+  __syncthreads();
+
+  for (vertex_t i = 1; i <= n; i++) {
+    for (vertex_t j = threadIdx.x; j <= n; j += BlockSize) {
+      minv[j]    = kInf;
+      in_tree[j] = false;
+    }
+    if (threadIdx.x == 0) {
+      p[0] = i;
+      s_j0 = 0;
+    }
+    __syncthreads();
+
+    while (true) {
+      const vertex_t j0 = s_j0;
+      const vertex_t i0 = p[j0];
+      if (threadIdx.x == 0) { in_tree[j0] = true; }
+      // relax the slacks of the columns outside of the tree through row i0, and pick the closest
+      const weight_t* a_row = a + int64_t(i0 - 1) * n;
+      const weight_t u_i0   = u[i0];
+      pair_t best{n + 1, kInf};
+      for (vertex_t j = threadIdx.x + 1; j <= n; j += BlockSize) {
+        if (j == j0 || in_tree[j]) { continue; }
+        weight_t cur = a_row[j - 1] - u_i0 - v[j];
+        if (cur < minv[j]) {
+          minv[j] = cur;
+          w[j]    = j0;
+        }
+        if (minv[j] < best.value) { best = pair_t{j, minv[j]}; }
+      }
+      best = reduce_t(reduce_storage).Reduce(best, cub::ArgMin());
+      if (threadIdx.x == 0) {
+        s_delta = best.value;
+        s_j0    = best.key;
+      }
+      __syncthreads();
+
+      // shift the potentials so that the closest column becomes tight
+      const weight_t delta = s_delta;
+      const bool reached   = p[s_j0] == 0;
+      for (vertex_t j = threadIdx.x; j <= n; j += BlockSize) {
+        if (in_tree[j]) {
+          u[p[j]] += delta;
+          v[j] -= delta;
+        } else {
+          minv[j] -= delta;
+        }
+      }
+      __syncthreads();
+      if (reached) { break; }
+    }
+
+    // augment along the path ending at the free column found
+    if (threadIdx.x == 0) {
+      vertex_t j0 = s_j0;
+      do {
+        vertex_t j1 = w[j0];
+        p[j0]       = p[j1];
+        j0          = j1;
+      } while (j0 != 0);
+    }
+    __syncthreads();
+  }
+
+  const auto out_off = offsets[problem];
+  weight_t obj       = 0;
+  for (vertex_t j = threadIdx.x + 1; j <= n; j += BlockSize) {
+    const vertex_t row                 = p[j] - 1;
+    row_assignments[out_off + row]     = j - 1;
+    col_assignments[out_off + (j - 1)] = row;
+    obj += a[int64_t(row) * n + (j - 1)];
+  }
+  if (obj_values != nullptr) {
+    obj = cub::BlockReduce<weight_t, BlockSize>(sum_storage).Sum(obj);
+    if (threadIdx.x == 0) { obj_values[problem] = obj; }
+  }
+}
+
+template <typename vertex_t, typename weight_t>
+void batched_lap(raft::resources const& handle,
+                 raft::device_vector_view<const weight_t, int64_t> costs,
+                 raft::device_vector_view<const vertex_t, int64_t> sizes,
+                 raft::device_vector_view<vertex_t, int64_t> row_assignments,
+                 raft::device_vector_view<vertex_t, int64_t> col_assignments,
+                 std::optional<raft::device_vector_view<weight_t, int64_t>> obj_values)
+{
+  const int64_t n_problems = sizes.extent(0);
+  const int64_t n_total    = row_assignments.extent(0);
+  RAFT_EXPECTS(col_assignments.extent(0) == n_total,
+               "row_assignments and col_assignments must have the same size");
+  RAFT_EXPECTS(!obj_values.has_value() || obj_values->extent(0) == n_problems,
+               "obj_values must have one entry per problem");
+  if (n_problems == 0) { return; }
+
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  // where every problem starts in the cost matrices, the outputs and the work arrays
+  rmm::device_uvector<int64_t> cost_offsets(n_problems, stream, mr);
+  rmm::device_uvector<int64_t> offsets(n_problems, stream, mr);
+  rmm::device_uvector<int64_t> work_offsets(n_problems, stream, mr);
+  auto squares = thrust::make_transform_iterator(sizes.data_handle(), square_op<vertex_t>{});
+  auto lengths = thrust::make_transform_iterator(sizes.data_handle(), plus_one_op<vertex_t>{});
+  thrust::exclusive_scan(policy, squares, squares + n_problems, cost_offsets.data(), int64_t(0));
+  thrust::exclusive_scan(policy,
+                         sizes.data_handle(),
+                         sizes.data_handle() + n_problems,
+                         offsets.data(),
+                         int64_t(0));
+  thrust::exclusive_scan(policy, lengths, lengths + n_problems, work_offsets.data(), int64_t(0));
+
+  const size_t n_work = size_t(n_total + n_problems);
+  rmm::device_uvector<weight_t> row_duals(n_work, stream, mr);
+  rmm::device_uvector<weight_t> col_duals(n_work, stream, mr);
+  rmm::device_uvector<weight_t> min_slacks(n_work, stream, mr);
+  rmm::device_uvector<vertex_t> col_rows(n_work, stream, mr);
+  rmm::device_uvector<vertex_t> way(n_work, stream, mr);
+  rmm::device_uvector<bool> used(n_work, stream, mr);
+
+  constexpr int kBlockSize = 128;
+  batched_lap_kernel<kBlockSize, vertex_t, weight_t>
+    <<<static_cast<unsigned>(n_problems), kBlockSize, 0, stream>>>(costs.data_handle(),
+                                            cost_offsets.data(),
+                                            sizes.data_handle(),
+                                            offsets.data(),
+                                            work_offsets.data(),
+                                            row_duals.data(),
+                                            col_duals.data(),
+                                            min_slacks.data(),
+                                            col_rows.data(),
+                                            way.data(),
+                                            used.data(),
+                                            row_assignments.data_handle(),
+                                            col_assignments.data_handle(),
+                                            obj_values.has_value() ? obj_values->data_handle()
+                                                                   : nullptr);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::solver::detail
@@ -30,6 +30,8 @@
 
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/solver/detail/lap_batched.cuh>
 #include <raft/solver/detail/lap_functions.cuh>
 #include <raft/solver/linear_assignment_types.hpp>
 
@@ -38,6 +40,8 @@
 #include <thrust/execution_policy.h>
 #include <thrust/fill.h>
 
+#include <optional>
+
 namespace raft::solver {
 
 /**
@@ -329,6 +333,54 @@ class LinearAssignmentProblem {
   }
 };
 
+/**
+ * @brief Solve a batch of independent square linear assignment problems of different sizes.
+ *
+ * Unlike LinearAssignmentProblem, which solves problems of a single size and checks for
+ * convergence on the host at every step, every problem is solved by its own thread block with a
+ * shortest augmenting path Hungarian algorithm, entirely on the device: all the problems run
+ * concurrently in a single kernel and the call does not synchronize the stream. It suits many
+ * small problems (tens to a few hundreds of rows); prefer LinearAssignmentProblem for large ones.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   // two problems, of sizes 2 and 3: the cost matrices are stored one after the other
+ *   auto costs = raft::make_device_vector<float, int64_t>(handle, 2 * 2 + 3 * 3);
+ *   auto sizes = raft::make_device_vector<int, int64_t>(handle, 2);
+ *   auto rows  = raft::make_device_vector<int, int64_t>(handle, 2 + 3);
+ *   auto cols  = raft::make_device_vector<int, int64_t>(handle, 2 + 3);
+ *   ...
+ *   raft::solver::batched_linear_assignment(
+ *     handle, raft::make_const_mdspan(costs.view()), raft::make_const_mdspan(sizes.view()),
+ *     rows.view(), cols.view());
+ * @endcode
+ *
+ * @tparam vertex_t integer type of the sizes and the assignments
+ * @tparam weight_t type of the costs
+ *
+ * @param[in] handle raft resources
+ * @param[in] costs the row-major n_i x n_i cost matrices of the problems, one after the other
+ *   [sum_i n_i^2]
+ * @param[in] sizes the size n_i of every problem [n_problems]
+ * @param[out] row_assignments the column assigned to every row, relative to its problem, for the
+ *   problems one after the other [sum_i n_i]
+ * @param[out] col_assignments the row assigned to every column, relative to its problem
+ *   [sum_i n_i]
+ * @param[out] obj_values optional, the total cost of the optimal assignment of every problem
+ *   [n_problems]
+ */
+template <typename vertex_t, typename weight_t>
+void batched_linear_assignment(
+  raft::resources const& handle,
+  raft::device_vector_view<const weight_t, int64_t> costs,
+  raft::device_vector_view<const vertex_t, int64_t> sizes,
+  raft::device_vector_view<vertex_t, int64_t> row_assignments,
+  raft::device_vector_view<vertex_t, int64_t> col_assignments,
+  std::optional<raft::device_vector_view<weight_t, int64_t>> obj_values = std::nullopt)
+{
+  detail::batched_lap(handle, costs, sizes, row_assignments, col_assignments, obj_values);
+}
+
 }  // namespace raft::solver
 
 #endif
\ No newline at end of file
@@ -26,15 +26,18 @@ namespace convert {
 
 /**
  * @brief Convert a CSR row_ind array to a COO rows array
+ * @tparam value_idx: type of the rows
+ * @tparam nnz_t: type of the row_ind offsets, which may be wider than the rows (e.g. 64-bit
+ *   offsets for more than 2^31 nonzeros with 32-bit rows)
  * @param row_ind: Input CSR row_ind array
  * @param m: size of row_ind array
  * @param coo_rows: Output COO row array
  * @param nnz: size of output COO row array
  * @param stream: cuda stream to use
  */
-template <typename value_idx = int>
+template <typename value_idx = int, typename nnz_t = value_idx>
 void csr_to_coo(
-  const value_idx* row_ind, value_idx m, value_idx* coo_rows, value_idx nnz, cudaStream_t stream)
+  const nnz_t* row_ind, value_idx m, value_idx* coo_rows, nnz_t nnz, cudaStream_t stream)
 {
   detail::csr_to_coo<value_idx, 32>(row_ind, m, coo_rows, nnz, stream);
 }
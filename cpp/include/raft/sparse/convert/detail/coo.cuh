@@ -36,18 +36,15 @@ namespace sparse {
 namespace convert {
 namespace detail {
 
-template <typename value_idx = int, int TPB_X = 32>
-RAFT_KERNEL csr_to_coo_kernel(const value_idx* row_ind,
-                              value_idx m,
-                              value_idx* coo_rows,
-                              value_idx nnz)
+template <typename value_idx = int, int TPB_X = 32, typename nnz_t = value_idx>
+RAFT_KERNEL csr_to_coo_kernel(const nnz_t* row_ind, value_idx m, value_idx* coo_rows, nnz_t nnz)
 {
   // row-based matrix 1 thread per row
   value_idx row = (blockIdx.x * TPB_X) + threadIdx.x;
   if (row < m) {
-    value_idx start_idx = row_ind[row];
-    value_idx stop_idx  = get_stop_idx(row, m, nnz, row_ind);
-    for (value_idx i = start_idx; i < stop_idx; i++)
+    nnz_t start_idx = row_ind[row];
+    nnz_t stop_idx  = row < m - 1 ? row_ind[row + 1] : nnz;
+    for (nnz_t i = start_idx; i < stop_idx; i++)
       coo_rows[i] = row;
   }
 }
@@ -60,15 +57,15 @@ RAFT_KERNEL csr_to_coo_kernel(const value_idx* row_ind,
  * @param nnz: size of output COO row array
  * @param stream: cuda stream to use
  */
-template <typename value_idx = int, int TPB_X = 32>
+template <typename value_idx = int, int TPB_X = 32, typename nnz_t = value_idx>
 void csr_to_coo(
-  const value_idx* row_ind, value_idx m, value_idx* coo_rows, value_idx nnz, cudaStream_t stream)
+  const nnz_t* row_ind, value_idx m, value_idx* coo_rows, nnz_t nnz, cudaStream_t stream)
 {
   // @TODO: Use cusparse for this.
   dim3 grid(raft::ceildiv(m, (value_idx)TPB_X), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
-  csr_to_coo_kernel<value_idx, TPB_X><<<grid, blk, 0, stream>>>(row_ind, m, coo_rows, nnz);
+  csr_to_coo_kernel<value_idx, TPB_X, nnz_t><<<grid, blk, 0, stream>>>(row_ind, m, coo_rows, nnz);
 
   RAFT_CUDA_TRY(cudaGetLastError());
 }
@@ -37,10 +37,11 @@ namespace sparse {
  *
  * @tparam value_t: the type of the value array.
  * @tparam value_idx: the type of index array
+ * @tparam nnz_t: the type of the number of nonzeros, which may be wider than the index type
  *
  */
-template <typename value_t, typename value_idx = int>
-using COO = detail::COO<value_t, value_idx>;
+template <typename value_t, typename value_idx = int, typename nnz_t = value_idx>
+using COO = detail::COO<value_t, value_idx, nnz_t>;
 
 };  // namespace sparse
 };  // namespace raft
@@ -633,6 +633,71 @@ inline cusparseStatus_t cusparsespmm(cusparseHandle_t handle,
                       static_cast<void*>(externalBuffer));
 }
 
+template <typename T>
+cusparseStatus_t cusparsespmm_preprocess(cusparseHandle_t handle,
+                                         cusparseOperation_t opA,
+                                         cusparseOperation_t opB,
+                                         const T* alpha,
+                                         const cusparseSpMatDescr_t matA,
+                                         const cusparseDnMatDescr_t matB,
+                                         const T* beta,
+                                         cusparseDnMatDescr_t matC,
+                                         cusparseSpMMAlg_t alg,
+                                         T* externalBuffer,
+                                         cudaStream_t stream);
+template <>
+inline cusparseStatus_t cusparsespmm_preprocess(cusparseHandle_t handle,
+                                                cusparseOperation_t opA,
+                                                cusparseOperation_t opB,
+                                                const float* alpha,
+                                                const cusparseSpMatDescr_t matA,
+                                                const cusparseDnMatDescr_t matB,
+                                                const float* beta,
+                                                cusparseDnMatDescr_t matC,
+                                                cusparseSpMMAlg_t alg,
+                                                float* externalBuffer,
+                                                cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpMM_preprocess(handle,
+                                 opA,
+                                 opB,
+                                 static_cast<void const*>(alpha),
+                                 matA,
+                                 matB,
+                                 static_cast<void const*>(beta),
+                                 matC,
+                                 CUDA_R_32F,
+                                 alg,
+                                 static_cast<void*>(externalBuffer));
+}
+template <>
+inline cusparseStatus_t cusparsespmm_preprocess(cusparseHandle_t handle,
+                                                cusparseOperation_t opA,
+                                                cusparseOperation_t opB,
+                                                const double* alpha,
+                                                const cusparseSpMatDescr_t matA,
+                                                const cusparseDnMatDescr_t matB,
+                                                const double* beta,
+                                                cusparseDnMatDescr_t matC,
+                                                cusparseSpMMAlg_t alg,
+                                                double* externalBuffer,
+                                                cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpMM_preprocess(handle,
+                                 opA,
+                                 opB,
+                                 static_cast<void const*>(alpha),
+                                 matA,
+                                 matB,
+                                 static_cast<void const*>(beta),
+                                 matC,
+                                 CUDA_R_64F,
+                                 alg,
+                                 static_cast<void*>(externalBuffer));
+}
+
 template <typename T>
 cusparseStatus_t cusparsesddmm_bufferSize(cusparseHandle_t handle,
                                           cusparseOperation_t opA,
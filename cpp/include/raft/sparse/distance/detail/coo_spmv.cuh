@@ -23,13 +23,18 @@
 #include "coo_spmv_strategies/hash_strategy.cuh"
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/sparse/detail/cusparse_wrappers.h>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
 #include <cusparse_v2.h>
 #include <limits.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/transform_reduce.h>
 
+#include <limits>
 #include <nvfunctional>
 
 namespace raft {
@@ -37,6 +42,38 @@ namespace sparse {
 namespace distance {
 namespace detail {
 
+/**
+ * Whether a strategy should balance the nonzeros of the vector side over the device (see
+ * coo_spmv_strategy::split_nnz), from the lengths of the `n_rows` rows it loads in shared memory.
+ *
+ * Each block loads one row (or one chunk of a row) and scans a chunk of the vector side, the whole
+ * vector side for the default chunk size. This lets most of the device idle when there are fewer
+ * rows than the device runs blocks, or when some rows reach `row_capacity` nonzeros: the hash
+ * strategy splits these into chunks and runs them in a launch of their own, which on power-law row
+ * lengths has a handful of blocks only.
+ */
+template <typename value_idx, typename value_t, int threads_per_block>
+bool nnz_balancing_needed(const distances_config_t<value_idx, value_t>& config_,
+                          const value_idx* indptr,
+                          value_idx n_rows,
+                          value_idx row_capacity = std::numeric_limits<value_idx>::max())
+{
+  using strategy_base_t = coo_spmv_strategy<value_idx, value_t, threads_per_block>;
+  if (n_rows < int64_t(strategy_base_t::balanced_waves) * raft::getMultiProcessorCount()) {
+    return true;
+  }
+  if (row_capacity == std::numeric_limits<value_idx>::max()) { return false; }
+
+  auto max_row_nnz = thrust::transform_reduce(
+    resource::get_thrust_policy(config_.handle),
+    thrust::make_counting_iterator(value_idx(0)),
+    thrust::make_counting_iterator(n_rows),
+    [indptr] __device__(value_idx i) { return indptr[i + 1] - indptr[i]; },
+    value_idx(0),
+    thrust::maximum<value_idx>());
+  return max_row_nnz >= row_capacity;
+}
+
 template <typename value_idx,
           typename value_t,
           int threads_per_block = 1024,
@@ -75,7 +112,9 @@ inline void balanced_coo_pairwise_generalized_spmv(
  * 3. Multiplication by 0 annihilates x. e.g. product(x, 0) = 0
  *
  * Each vector of A is loaded into shared memory in dense form and the
- * non-zeros of B load balanced across the threads of each block.
+ * non-zeros of B load balanced across the threads of each block. When A has
+ * few rows, or a few heavy ones, the non-zeros of B are also split across
+ * blocks so that every launch fills the device (see nnz_balancing_needed).
  * @tparam value_idx index type
  * @tparam value_t value type
  * @tparam threads_per_block block size
@@ -115,9 +154,13 @@ inline void balanced_coo_pairwise_generalized_spmv(
 
   if (max_cols > config_.a_ncols) {
     dense_smem_strategy<value_idx, value_t, threads_per_block> strategy(config_);
+    strategy.set_nnz_balanced(nnz_balancing_needed<value_idx, value_t, threads_per_block>(
+      config_, config_.a_indptr, config_.a_nrows));
     strategy.dispatch(out_dists, coo_rows_b, product_func, accum_func, write_func, chunk_size);
   } else {
     hash_strategy<value_idx, value_t, threads_per_block> strategy(config_);
+    strategy.set_nnz_balanced(nnz_balancing_needed<value_idx, value_t, threads_per_block>(
+      config_, config_.a_indptr, config_.a_nrows, strategy.row_capacity()));
     strategy.dispatch(out_dists, coo_rows_b, product_func, accum_func, write_func, chunk_size);
   }
 };
@@ -198,9 +241,13 @@ inline void balanced_coo_pairwise_generalized_spmv_rev(
 
   if (max_cols > config_.b_ncols) {
     dense_smem_strategy<value_idx, value_t, threads_per_block> strategy(config_);
+    strategy.set_nnz_balanced(nnz_balancing_needed<value_idx, value_t, threads_per_block>(
+      config_, config_.b_indptr, config_.b_nrows));
     strategy.dispatch_rev(out_dists, coo_rows_a, product_func, accum_func, write_func, chunk_size);
   } else {
     hash_strategy<value_idx, value_t, threads_per_block> strategy(config_);
+    strategy.set_nnz_balanced(nnz_balancing_needed<value_idx, value_t, threads_per_block>(
+      config_, config_.b_indptr, config_.b_nrows, strategy.row_capacity()));
     strategy.dispatch_rev(out_dists, coo_rows_a, product_func, accum_func, write_func, chunk_size);
   }
 };
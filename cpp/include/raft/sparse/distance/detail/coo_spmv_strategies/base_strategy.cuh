@@ -22,9 +22,13 @@
 #include "coo_mask_row_iterators.cuh"
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_uvector.hpp>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace raft {
 namespace sparse {
 namespace distance {
@@ -38,6 +42,15 @@ class coo_spmv_strategy {
     smem = raft::getSharedMemPerBlock();
   }
 
+  /** The number of times over a launch should fill the device when balancing the nonzeros. */
+  static constexpr int balanced_waves = 4;
+
+  /**
+   * Split the nonzeros of the vector side evenly over the device rather than in chunks of a fixed
+   * size, see split_nnz().
+   */
+  void set_nnz_balanced(bool nnz_balanced_) { nnz_balanced = nnz_balanced_; }
+
   template <typename strategy_t,
             typename indptr_it,
             typename product_f,
@@ -139,7 +152,33 @@ class coo_spmv_strategy {
   }
 
  protected:
+  /**
+   * The number of blocks over which to split the `nnz` nonzeros of the vector side, for each of
+   * the `n_row_blocks` rows (or row chunks) a launch loads in shared memory.
+   *
+   * Each block scans `chunk_size * tpb` nonzeros, which for the default chunk size means a single
+   * block per row: a launch over a few rows, such as the heavy rows of a power-law matrix that
+   * hash_strategy launches apart, runs a full scan of the vector side on a few SMs while the
+   * others idle. When nnz balancing is set, the nonzeros are rather split so that the launch fills
+   * the device `balanced_waves` times over, with at least `max(tpb, dim)` nonzeros per block to
+   * amortize the initialization of its shared memory. `chunk_size` is updated to match the split.
+   */
+  int split_nnz(value_idx n_row_blocks, value_idx nnz, int dim, int& chunk_size)
+  {
+    int n_blocks_per_row = raft::ceildiv<int64_t>(nnz, int64_t(chunk_size) * tpb);
+    if (!nnz_balanced || n_row_blocks == 0 || nnz == 0) { return n_blocks_per_row; }
+
+    int64_t target    = int64_t(balanced_waves) * raft::getMultiProcessorCount();
+    int64_t max_split = std::max<int64_t>(1, nnz / std::max(tpb, dim));
+    int64_t split     = std::min(raft::ceildiv<int64_t>(target, n_row_blocks), max_split);
+    if (split <= n_blocks_per_row) { return n_blocks_per_row; }
+
+    chunk_size = raft::ceildiv<int64_t>(nnz, split * tpb);
+    return raft::ceildiv<int64_t>(nnz, int64_t(chunk_size) * tpb);
+  }
+
   int smem;
+  bool nnz_balanced = false;
   const distances_config_t<value_idx, value_t>& config;
 };
 
@@ -48,8 +48,9 @@ class dense_smem_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                 write_f write_func,
                 int chunk_size)
   {
-    auto n_blocks_per_row = raft::ceildiv(this->config.b_nnz, chunk_size * 1024);
-    auto n_blocks         = this->config.a_nrows * n_blocks_per_row;
+    auto n_blocks_per_row =
+      this->split_nnz(this->config.a_nrows, this->config.b_nnz, this->config.b_ncols, chunk_size);
+    auto n_blocks = this->config.a_nrows * n_blocks_per_row;
 
     mask_row_it<value_idx> a_indptr(this->config.a_indptr, this->config.a_nrows);
 
@@ -74,8 +75,9 @@ class dense_smem_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                     write_f write_func,
                     int chunk_size)
   {
-    auto n_blocks_per_row = raft::ceildiv(this->config.a_nnz, chunk_size * 1024);
-    auto n_blocks         = this->config.b_nrows * n_blocks_per_row;
+    auto n_blocks_per_row =
+      this->split_nnz(this->config.b_nrows, this->config.a_nnz, this->config.a_ncols, chunk_size);
+    auto n_blocks = this->config.b_nrows * n_blocks_per_row;
 
     mask_row_it<value_idx> b_indptr(this->config.b_indptr, this->config.b_nrows);
 
@@ -58,6 +58,9 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
   {
   }
 
+  /** The rows with as many nonzeros or more are split into chunks that fit in the hash map. */
+  value_idx row_capacity() const { return capacity_threshold * map_size; }
+
   void chunking_needed(const value_idx* indptr,
                        const value_idx n_rows,
                        rmm::device_uvector<value_idx>& mask_indptr,
@@ -91,7 +94,6 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                 write_f write_func,
                 int chunk_size)
   {
-    auto n_blocks_per_row = raft::ceildiv(this->config.b_nnz, chunk_size * tpb);
     rmm::device_uvector<value_idx> mask_indptr(this->config.a_nrows,
                                                resource::get_cuda_stream(this->config.handle));
     std::tuple<value_idx, value_idx> n_rows_divided;
@@ -106,6 +108,9 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
     if (less_rows > 0) {
       mask_row_it<value_idx> less(this->config.a_indptr, less_rows, mask_indptr.data());
 
+      int less_chunk_size = chunk_size;
+      auto n_blocks_per_row =
+        this->split_nnz(less_rows, this->config.b_nnz, map_size, less_chunk_size);
       auto n_less_blocks = less_rows * n_blocks_per_row;
       this->_dispatch_base(*this,
                            map_size,
@@ -115,7 +120,7 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                            product_func,
                            accum_func,
                            write_func,
-                           chunk_size,
+                           less_chunk_size,
                            n_less_blocks,
                            n_blocks_per_row);
     }
@@ -142,6 +147,9 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                                           chunk_indices.data(),
                                           resource::get_cuda_stream(this->config.handle));
 
+      int more_chunk_size = chunk_size;
+      auto n_blocks_per_row =
+        this->split_nnz(more.total_row_blocks, this->config.b_nnz, map_size, more_chunk_size);
       auto n_more_blocks = more.total_row_blocks * n_blocks_per_row;
       this->_dispatch_base(*this,
                            map_size,
@@ -151,7 +159,7 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                            product_func,
                            accum_func,
                            write_func,
-                           chunk_size,
+                           more_chunk_size,
                            n_more_blocks,
                            n_blocks_per_row);
     }
@@ -165,7 +173,6 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                     write_f write_func,
                     int chunk_size)
   {
-    auto n_blocks_per_row = raft::ceildiv(this->config.a_nnz, chunk_size * tpb);
     rmm::device_uvector<value_idx> mask_indptr(this->config.b_nrows,
                                                resource::get_cuda_stream(this->config.handle));
     std::tuple<value_idx, value_idx> n_rows_divided;
@@ -180,6 +187,9 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
     if (less_rows > 0) {
       mask_row_it<value_idx> less(this->config.b_indptr, less_rows, mask_indptr.data());
 
+      int less_chunk_size = chunk_size;
+      auto n_blocks_per_row =
+        this->split_nnz(less_rows, this->config.a_nnz, map_size, less_chunk_size);
       auto n_less_blocks = less_rows * n_blocks_per_row;
       this->_dispatch_base_rev(*this,
                                map_size,
@@ -189,7 +199,7 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                                product_func,
                                accum_func,
                                write_func,
-                               chunk_size,
+                               less_chunk_size,
                                n_less_blocks,
                                n_blocks_per_row);
     }
@@ -216,6 +226,9 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                                           chunk_indices.data(),
                                           resource::get_cuda_stream(this->config.handle));
 
+      int more_chunk_size = chunk_size;
+      auto n_blocks_per_row =
+        this->split_nnz(more.total_row_blocks, this->config.a_nnz, map_size, more_chunk_size);
       auto n_more_blocks = more.total_row_blocks * n_blocks_per_row;
       this->_dispatch_base_rev(*this,
                                map_size,
@@ -225,7 +238,7 @@ class hash_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
                                product_func,
                                accum_func,
                                write_func,
-                               chunk_size,
+                               more_chunk_size,
                                n_more_blocks,
                                n_blocks_per_row);
     }
@@ -33,8 +33,8 @@ namespace linalg {
  * @param results: output result array
  * @param stream: cuda stream to use
  */
-template <typename T = int>
-void coo_degree(const T* rows, int nnz, T* results, cudaStream_t stream)
+template <typename T = int, typename nnz_t = int>
+void coo_degree(const T* rows, nnz_t nnz, T* results, cudaStream_t stream)
 {
   detail::coo_degree<64, T>(rows, nnz, results, stream);
 }
@@ -47,8 +47,8 @@ void coo_degree(const T* rows, int nnz, T* results, cudaStream_t stream)
  * @param results: output array with row counts (size=in->n_rows)
  * @param stream: cuda stream to use
  */
-template <typename T>
-void coo_degree(COO<T>* in, int* results, cudaStream_t stream)
+template <typename T, typename nnz_t>
+void coo_degree(COO<T, int, nnz_t>* in, int* results, cudaStream_t stream)
 {
   coo_degree(in->rows(), in->nnz, results, stream);
 }
@@ -64,9 +64,9 @@ void coo_degree(COO<T>* in, int* results, cudaStream_t stream)
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <typename T>
+template <typename T, typename nnz_t>
 void coo_degree_scalar(
-  const int* rows, const T* vals, int nnz, T scalar, int* results, cudaStream_t stream = 0)
+  const int* rows, const T* vals, nnz_t nnz, T scalar, int* results, cudaStream_t stream = 0)
 {
   detail::coo_degree_scalar<64>(rows, vals, nnz, scalar, results, stream);
 }
@@ -80,8 +80,8 @@ void coo_degree_scalar(
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <typename T>
-void coo_degree_scalar(COO<T>* in, T scalar, int* results, cudaStream_t stream)
+template <typename T, typename nnz_t>
+void coo_degree_scalar(COO<T, int, nnz_t>* in, T scalar, int* results, cudaStream_t stream)
 {
   coo_degree_scalar(in->rows(), in->vals(), in->nnz, scalar, results, stream);
 }
@@ -96,8 +96,8 @@ void coo_degree_scalar(COO<T>* in, T scalar, int* results, cudaStream_t stream)
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <typename T>
-void coo_degree_nz(const int* rows, const T* vals, int nnz, int* results, cudaStream_t stream)
+template <typename T, typename nnz_t>
+void coo_degree_nz(const int* rows, const T* vals, nnz_t nnz, int* results, cudaStream_t stream)
 {
   detail::coo_degree_nz<64>(rows, vals, nnz, results, stream);
 }
@@ -110,8 +110,8 @@ void coo_degree_nz(const int* rows, const T* vals, int nnz, int* results, cudaSt
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <typename T>
-void coo_degree_nz(COO<T>* in, int* results, cudaStream_t stream)
+template <typename T, typename nnz_t>
+void coo_degree_nz(COO<T, int, nnz_t>* in, int* results, cudaStream_t stream)
 {
   coo_degree_nz(in->rows(), in->vals(), in->nnz, results, stream);
 }
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_buffer.hpp>
+#include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+#include <rmm/resource_ref.hpp>
+
+#include <cub/cub.cuh>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace raft {
+namespace sparse {
+namespace linalg {
+namespace detail {
+
+constexpr int spgemm_tpb = 256;
+
+/** atomicCAS on a 32 or 64 bit index type. */
+template <typename index_t>
+__device__ inline index_t spgemm_atomic_cas(index_t* address, index_t compare, index_t val)
+{
+  static_assert(sizeof(index_t) == 4 || sizeof(index_t) == 8, "Unsupported index type");
+  if constexpr (sizeof(index_t) == 4) {
+    return static_cast<index_t>(atomicCAS(reinterpret_cast<unsigned int*>(address),
+                                          static_cast<unsigned int>(compare),
+                                          static_cast<unsigned int>(val)));
+  } else {
+    return static_cast<index_t>(atomicCAS(reinterpret_cast<unsigned long long int*>(address),
+                                          static_cast<unsigned long long int>(compare),
+                                          static_cast<unsigned long long int>(val)));
+  }
+}
+
+/**
+ * The number of products of every row of A * B, sum of the lengths of the rows of B selected by
+ * the row of A: an upper bound of the number of nonzeros of the row of the product. One warp per
+ * row.
+ */
+template <typename index_t, typename nnz_t>
+RAFT_KERNEL spgemm_row_products_kernel(const index_t* a_indptr,
+                                       const index_t* a_indices,
+                                       const index_t* b_indptr,
+                                       index_t n_rows,
+                                       nnz_t* products)
+{
+  index_t row = (index_t(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize;
+  int lane    = threadIdx.x % WarpSize;
+  if (row >= n_rows) { return; }
+  nnz_t acc = 0;
+  for (index_t p = a_indptr[row] + lane; p < a_indptr[row + 1]; p += WarpSize) {
+    index_t k = a_indices[p];
+    acc += b_indptr[k + 1] - b_indptr[k];
+  }
+  acc = raft::warpReduce(acc);
+  if (lane == 0) { products[row] = acc; }
+}
+
+/**
+ * The hash accumulation of the rows [row_begin, row_begin + n_rows) of A * B, one warp per row.
+ *
+ * Each row owns an open addressing table of the slots [slot_offsets[row], slot_offsets[row + 1])
+ * (relative to the first row of the chunk), with twice as many slots as the row can have
+ * nonzeros. The warp inserts the columns of all its products, with linear probing.
+ *
+ * kNumeric = false (symbolic phase): the number of distinct columns of each row is written to
+ *   row_nnz[row].
+ * kNumeric = true (numeric phase): the products are summed into the values of the table, and the
+ *   occupied slots are compacted into out_indices / out_values at the offsets
+ *   c_indptr[row] - c_indptr[row_begin], in the order of the table.
+ */
+template <bool kNumeric, typename value_t, typename index_t, typename nnz_t>
+RAFT_KERNEL spgemm_hash_kernel(const index_t* a_indptr,
+                               const index_t* a_indices,
+                               const value_t* a_values,
+                               const index_t* b_indptr,
+                               const index_t* b_indices,
+                               const value_t* b_values,
+                               index_t row_begin,
+                               index_t n_rows,
+                               const nnz_t* slot_offsets,
+                               index_t* keys,
+                               value_t* vals,
+                               index_t* row_nnz,
+                               const index_t* c_indptr,
+                               index_t* out_indices,
+                               value_t* out_values)
+{
+  constexpr index_t kEmpty = index_t(-1);
+
+  index_t local = (index_t(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize;
+  int lane      = threadIdx.x % WarpSize;
+  if (local >= n_rows) { return; }
+  index_t row        = row_begin + local;
+  nnz_t capacity     = slot_offsets[row + 1] - slot_offsets[row];
+  index_t* row_keys  = keys + (slot_offsets[row] - slot_offsets[row_begin]);
+  value_t* row_vals  = kNumeric ? vals + (slot_offsets[row] - slot_offsets[row_begin]) : nullptr;
+  index_t n_inserted = 0;
+
+  for (nnz_t s = lane; s < capacity; s += WarpSize) {
+    row_keys[s] = kEmpty;
+    if constexpr (kNumeric) { row_vals[s] = value_t(0); }
+  }
+  __syncwarp();
+
+  for (index_t p = a_indptr[row]; p < a_indptr[row + 1]; p++) {
+    index_t k = a_indices[p];
+    value_t a = kNumeric ? a_values[p] : value_t(0);
+    for (index_t q = b_indptr[k] + lane; q < b_indptr[k + 1]; q += WarpSize) {
+      index_t col = b_indices[q];
+      nnz_t slot  = (uint64_t(col) * 2654435761ull) % uint64_t(capacity);
+      while (true) {
+        index_t prev = spgemm_atomic_cas(row_keys + slot, kEmpty, col);
+        if (prev == kEmpty || prev == col) {
+          if (prev == kEmpty) { n_inserted++; }
+          if constexpr (kNumeric) { atomicAdd(row_vals + slot, a * b_values[q]); }
+          break;
+        }
+        slot = slot + 1 == capacity ? 0 : slot + 1;
+      }
+    }
+  }
+  __syncwarp();
+
+  if constexpr (!kNumeric) {
+    n_inserted = raft::warpReduce(n_inserted);
+    if (lane == 0) { row_nnz[row] = n_inserted; }
+  } else {
+    index_t out = c_indptr[row] - c_indptr[row_begin];
+    for (nnz_t s0 = 0; s0 < capacity; s0 += WarpSize) {
+      nnz_t s       = s0 + lane;
+      index_t key   = s < capacity ? row_keys[s] : kEmpty;
+      uint32_t mask = __ballot_sync(0xffffffff, key != kEmpty);
+      if (key != kEmpty) {
+        index_t pos      = out + __popc(mask & ((1u << lane) - 1));
+        out_indices[pos] = key;
+        out_values[pos]  = row_vals[s];
+      }
+      out += __popc(mask);
+    }
+  }
+}
+
+template <typename value_t, typename index_t, typename nnz_t>
+void spgemm(raft::resources const& handle,
+            raft::device_csr_matrix_view<const value_t, index_t, index_t, nnz_t> A,
+            raft::device_csr_matrix_view<const value_t, index_t, index_t, nnz_t> B,
+            raft::device_csr_matrix<value_t, index_t, index_t, nnz_t>& C)
+{
+  static_assert(std::is_same_v<value_t, float> || std::is_same_v<value_t, double>,
+                "The `value_t` of spgemm only supports float/double.");
+
+  auto a_structure = A.structure_view();
+  auto b_structure = B.structure_view();
+  auto c_structure = C.structure_view();
+  RAFT_EXPECTS(a_structure.get_n_cols() == b_structure.get_n_rows(),
+               "Number of columns in A must match the number of rows in B.");
+  RAFT_EXPECTS(c_structure.get_n_rows() == a_structure.get_n_rows(),
+               "Number of rows in C must match the number of rows in A.");
+  RAFT_EXPECTS(c_structure.get_n_cols() == b_structure.get_n_cols(),
+               "Number of columns in C must match the number of columns in B.");
+
+  auto stream              = resource::get_cuda_stream(handle);
+  auto policy              = resource::get_thrust_policy(handle);
+  index_t m                = a_structure.get_n_rows();
+  index_t n                = b_structure.get_n_cols();
+  const index_t* a_indptr  = a_structure.get_indptr().data();
+  const index_t* a_indices = a_structure.get_indices().data();
+  const value_t* a_values  = A.get_elements().data();
+  const index_t* b_indptr  = b_structure.get_indptr().data();
+  const index_t* b_indices = b_structure.get_indices().data();
+  const value_t* b_values  = B.get_elements().data();
+  index_t* c_indptr        = c_structure.get_indptr().data();
+
+  if (m == 0) {
+    C.initialize_sparsity(0);
+    return;
+  }
+  RAFT_CUDA_TRY(cudaMemsetAsync(c_indptr, 0, (m + 1) * sizeof(index_t), stream));
+  if (a_structure.get_nnz() == 0 || b_structure.get_nnz() == 0 || n == 0) {
+    C.initialize_sparsity(0);
+    return;
+  }
+
+  // The hash table of every row has twice as many slots as the row can have nonzeros.
+  rmm::device_uvector<nnz_t> slot_offsets(m + 1, stream);
+  auto row_grid = [](index_t rows) {
+    return raft::ceildiv<int64_t>(int64_t(rows) * WarpSize, spgemm_tpb);
+  };
+  spgemm_row_products_kernel<<<row_grid(m), spgemm_tpb, 0, stream>>>(
+    a_indptr, a_indices, b_indptr, m, slot_offsets.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  thrust::transform(policy,
+                    slot_offsets.data(),
+                    slot_offsets.data() + m,
+                    slot_offsets.data(),
+                    [n_cols = nnz_t(n)] __device__(nnz_t products) {
+                      return 2 * (products < n_cols ? products : n_cols);
+                    });
+  slot_offsets.set_element_to_zero_async(m, stream);
+  thrust::exclusive_scan(
+    policy, slot_offsets.data(), slot_offsets.data() + m + 1, slot_offsets.data());
+  std::vector<nnz_t> slot_offsets_h(m + 1);
+  raft::update_host(slot_offsets_h.data(), slot_offsets.data(), m + 1, stream);
+  resource::sync_stream(handle);
+
+  // The rows are processed in chunks whose tables fit in half of the free workspace, the other
+  // half being left to the unsorted output of the numeric phase. A row whose table alone exceeds
+  // this budget makes a chunk of its own.
+  const size_t budget_slots =
+    std::max<size_t>(1, resource::get_workspace_free_bytes(handle) /
+                          (2 * (sizeof(index_t) + sizeof(value_t))));
+  std::vector<index_t> chunk_bounds{0};
+  nnz_t max_chunk_slots = 0;
+  while (chunk_bounds.back() < m) {
+    index_t begin = chunk_bounds.back();
+    int64_t limit = int64_t(slot_offsets_h[begin]) + int64_t(budget_slots);
+    auto it       = std::upper_bound(slot_offsets_h.begin() + begin + 1,
+                               slot_offsets_h.end(),
+                               limit,
+                               [](int64_t v, nnz_t offset) { return v < int64_t(offset); });
+    index_t end     = std::max<index_t>(begin + 1, (it - slot_offsets_h.begin()) - 1);
+    max_chunk_slots = std::max(max_chunk_slots, slot_offsets_h[end] - slot_offsets_h[begin]);
+    chunk_bounds.push_back(end);
+  }
+
+  // The tables come from the workspace, unless a single row needs more.
+  rmm::device_async_resource_ref mr =
+    size_t(max_chunk_slots) <= budget_slots
+      ? rmm::device_async_resource_ref{resource::get_workspace_resource(handle)}
+      : rmm::device_async_resource_ref{rmm::mr::get_current_device_resource()};
+  rmm::device_uvector<index_t> keys(max_chunk_slots, stream, mr);
+
+  // Symbolic phase: the number of nonzeros of every row, then the indptr of C.
+  for (size_t c = 0; c + 1 < chunk_bounds.size(); c++) {
+    index_t begin = chunk_bounds[c];
+    index_t rows  = chunk_bounds[c + 1] - begin;
+    spgemm_hash_kernel<false, value_t, index_t, nnz_t>
+      <<<row_grid(rows), spgemm_tpb, 0, stream>>>(a_indptr,
+                                                  a_indices,
+                                                  a_values,
+                                                  b_indptr,
+                                                  b_indices,
+                                                  b_values,
+                                                  begin,
+                                                  rows,
+                                                  slot_offsets.data(),
+                                                  keys.data(),
+                                                  nullptr,
+                                                  c_indptr + 1,
+                                                  nullptr,
+                                                  nullptr,
+                                                  nullptr);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  thrust::inclusive_scan(policy, c_indptr + 1, c_indptr + m + 1, c_indptr + 1);
+  std::vector<index_t> c_indptr_h(m + 1);
+  raft::update_host(c_indptr_h.data(), c_indptr, m + 1, stream);
+  resource::sync_stream(handle);
+  C.initialize_sparsity(c_indptr_h[m]);
+  if (c_indptr_h[m] == 0) { return; }
+  auto c_filled      = C.structure_view();
+  index_t* c_indices = c_filled.get_indices().data();
+  value_t* c_values  = C.get_elements().data();
+
+  // Numeric phase: the values of every chunk, sorted by column into C.
+  index_t max_chunk_rows = 0;
+  index_t max_chunk_nnz  = 0;
+  for (size_t c = 0; c + 1 < chunk_bounds.size(); c++) {
+    max_chunk_rows = std::max(max_chunk_rows, chunk_bounds[c + 1] - chunk_bounds[c]);
+    max_chunk_nnz =
+      std::max(max_chunk_nnz, c_indptr_h[chunk_bounds[c + 1]] - c_indptr_h[chunk_bounds[c]]);
+  }
+  rmm::device_uvector<value_t> vals(max_chunk_slots, stream, mr);
+  rmm::device_uvector<index_t> chunk_indices(max_chunk_nnz, stream);
+  rmm::device_uvector<value_t> chunk_values(max_chunk_nnz, stream);
+  rmm::device_uvector<index_t> chunk_offsets(max_chunk_rows + 1, stream);
+  rmm::device_buffer sort_workspace(0, stream);
+
+  for (size_t c = 0; c + 1 < chunk_bounds.size(); c++) {
+    index_t begin = chunk_bounds[c];
+    index_t rows  = chunk_bounds[c + 1] - begin;
+    index_t base  = c_indptr_h[begin];
+    int n_items   = c_indptr_h[chunk_bounds[c + 1]] - base;
+    if (n_items == 0) { continue; }
+    spgemm_hash_kernel<true, value_t, index_t, nnz_t>
+      <<<row_grid(rows), spgemm_tpb, 0, stream>>>(a_indptr,
+                                                  a_indices,
+                                                  a_values,
+                                                  b_indptr,
+                                                  b_indices,
+                                                  b_values,
+                                                  begin,
+                                                  rows,
+                                                  slot_offsets.data(),
+                                                  keys.data(),
+                                                  vals.data(),
+                                                  nullptr,
+                                                  c_indptr,
+                                                  chunk_indices.data(),
+                                                  chunk_values.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    thrust::transform(policy,
+                      c_indptr + begin,
+                      c_indptr + begin + rows + 1,
+                      chunk_offsets.data(),
+                      [base] __device__(index_t offset) { return offset - base; });
+    size_t sort_workspace_bytes = 0;
+    RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairs(nullptr,
+                                                           sort_workspace_bytes,
+                                                           chunk_indices.data(),
+                                                           c_indices + base,
+                                                           chunk_values.data(),
+                                                           c_values + base,
+                                                           n_items,
+                                                           rows,
+                                                           chunk_offsets.data(),
+                                                           chunk_offsets.data() + 1,
+                                                           0,
+                                                           sizeof(index_t) * 8,
+                                                           stream));
+    if (sort_workspace_bytes > sort_workspace.size()) {
+      sort_workspace.resize(sort_workspace_bytes, stream);
+    }
+    RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairs(sort_workspace.data(),
+                                                           sort_workspace_bytes,
+                                                           chunk_indices.data(),
+                                                           c_indices + base,
+                                                           chunk_values.data(),
+                                                           c_values + base,
+                                                           n_items,
+                                                           rows,
+                                                           chunk_offsets.data(),
+                                                           chunk_offsets.data() + 1,
+                                                           0,
+                                                           sizeof(index_t) * 8,
+                                                           stream));
+  }
+}
+
+}  // end namespace detail
+}  // end namespace linalg
+}  // end namespace sparse
+}  // end namespace raft
@@ -20,8 +20,21 @@
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/cusparse_handle.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/sparse/detail/cusparse_wrappers.h>
+#include <raft/sparse/linalg/detail/cusparse_utils.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/transform.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
 
 namespace raft {
 namespace sparse {
@@ -113,6 +126,127 @@ void spmm(raft::resources const& handle,
                                                        resource::get_cuda_stream(handle)));
 }
 
+/**
+ * @brief SPMM of a CSR matrix whose index pointers and indices have different types (e.g. 64-bit
+ * offsets for more than 2^31 nonzeros with 32-bit column indices), which a cuSparse descriptor
+ * does not take. The rows of X are processed in chunks of at most `max_chunk_nnz` nonzeros, whose
+ * index pointers are rebased to the type of the indices.
+ * It computes the following equation: Z = alpha . X * Y + beta . Z
+ * @tparam ValueType Data type of input/output matrices (float/double)
+ * @tparam IndptrType Type of the index pointers of X
+ * @tparam IndicesType Type of the indices of X
+ * @tparam NZType Type of the number of nonzeros of X
+ * @tparam IndexType Type of Y and Z
+ * @tparam LayoutPolicyY layout of Y
+ * @param[in] handle raft handle
+ * @param[in] trans_x transpose operation for X
+ * @param[in] trans_y transpose operation for Y
+ * @param[in] is_row_major data layout of Y,Z
+ * @param[in] alpha scalar
+ * @param[in] x input raft::device_csr_matrix_view
+ * @param[in] y input raft::device_matrix_view
+ * @param[in] beta scalar
+ * @param[out] z output raft::device_matrix_view
+ * @param[in] max_chunk_nnz the largest number of nonzeros in a chunk
+ */
+template <typename ValueType,
+          typename IndptrType,
+          typename IndicesType,
+          typename NZType,
+          typename IndexType,
+          typename LayoutPolicyY>
+void spmm_row_chunks(
+  raft::resources const& handle,
+  const bool trans_x,
+  const bool trans_y,
+  const bool is_row_major,
+  const ValueType* alpha,
+  raft::device_csr_matrix_view<const ValueType, IndptrType, IndicesType, NZType> x,
+  raft::device_matrix_view<const ValueType, IndexType, LayoutPolicyY> y,
+  const ValueType* beta,
+  raft::device_matrix_view<ValueType, IndexType, raft::layout_stride> z,
+  int64_t max_chunk_nnz = std::numeric_limits<IndicesType>::max())
+{
+  auto stream        = resource::get_cuda_stream(handle);
+  auto csr_structure = x.structure_view();
+  auto n_rows        = int64_t(csr_structure.get_n_rows());
+  const auto* indptr = csr_structure.get_indptr().data();
+  std::vector<IndptrType> indptr_h(n_rows + 1);
+  raft::update_host(indptr_h.data(), indptr, n_rows + 1, stream);
+  resource::sync_stream(handle, stream);
+
+  auto strided = [is_row_major](auto* ptr, IndexType rows, IndexType cols, IndexType ld) {
+    using element_t = std::remove_pointer_t<decltype(ptr)>;
+    return is_row_major
+             ? raft::make_device_strided_matrix_view<element_t, IndexType, layout_c_contiguous>(
+                 ptr, rows, cols, ld)
+             : raft::make_device_strided_matrix_view<element_t, IndexType, layout_f_contiguous>(
+                 ptr, rows, cols, ld);
+  };
+  auto ld_y = is_row_major ? y.stride(0) : y.stride(1);
+  auto ld_z = is_row_major ? z.stride(0) : z.stride(1);
+  auto one  = ValueType(1);
+  rmm::device_uvector<IndicesType> chunk_indptr(0, stream);
+  for (int64_t r0 = 0; r0 < n_rows;) {
+    // the most rows from r0 whose nonzeros fit in a chunk, and at least one
+    int64_t limit  = int64_t(indptr_h[r0]) + max_chunk_nnz;
+    auto next      = std::upper_bound(indptr_h.begin() + r0 + 1,
+                                      indptr_h.end(),
+                                      limit,
+                                      [](int64_t v, IndptrType e) { return v < int64_t(e); });
+    int64_t r1     = std::max<int64_t>(next - indptr_h.begin() - 1, r0 + 1);
+    auto base      = indptr_h[r0];
+    auto chunk_nnz = int64_t(indptr_h[r1] - base);
+
+    chunk_indptr.resize(r1 - r0 + 1, stream);
+    thrust::transform(resource::get_thrust_policy(handle),
+                      indptr + r0,
+                      indptr + r1 + 1,
+                      chunk_indptr.data(),
+                      [base] __device__(IndptrType v) { return IndicesType(v - base); });
+    cusparseSpMatDescr_t descr_x;
+    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatecsr(
+      &descr_x,
+      r1 - r0,
+      static_cast<int64_t>(csr_structure.get_n_cols()),
+      chunk_nnz,
+      chunk_indptr.data(),
+      const_cast<IndicesType*>(csr_structure.get_indices().data()) + base,
+      const_cast<ValueType*>(x.get_elements().data()) + base));
+
+    // X * Y gives the chunk rows of Z; X^T * Y sums the products of the chunk rows of op(Y)
+    auto chunk_rows             = IndexType(r1 - r0);
+    const ValueType* y_ptr      = y.data_handle();
+    ValueType* z_ptr            = z.data_handle();
+    IndexType y_rows            = y.extent(0);
+    IndexType y_cols            = y.extent(1);
+    IndexType z_rows            = z.extent(0);
+    const ValueType* beta_chunk = beta;
+    if (!trans_x) {
+      z_ptr += r0 * z.stride(0);
+      z_rows = chunk_rows;
+    } else {
+      if (trans_y) {
+        y_ptr += r0 * y.stride(1);
+        y_cols = chunk_rows;
+      } else {
+        y_ptr += r0 * y.stride(0);
+        y_rows = chunk_rows;
+      }
+      if (r0 > 0) { beta_chunk = &one; }
+    }
+    auto descr_y = create_descriptor(strided(y_ptr, y_rows, y_cols, ld_y));
+    auto descr_z = create_descriptor(strided(z_ptr, z_rows, z.extent(1), ld_z));
+
+    spmm(handle, trans_x, trans_y, is_row_major, alpha, descr_x, descr_y, beta_chunk, descr_z);
+
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(descr_x));
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(descr_y));
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(descr_z));
+    r0 = r1;
+  }
+}
+
 }  // end namespace detail
 }  // end namespace linalg
 }  // end namespace sparse
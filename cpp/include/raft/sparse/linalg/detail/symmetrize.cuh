@@ -17,6 +17,8 @@
 #pragma once
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/sparse/convert/csr.cuh>
 #include <raft/sparse/coo.hpp>
 #include <raft/sparse/detail/cusparse_wrappers.h>
@@ -32,6 +34,7 @@
 
 #include <cuda_runtime.h>
 #include <thrust/device_ptr.h>
+#include <thrust/fill.h>
 #include <thrust/scan.h>
 
 #include <cusparse_v2.h>
@@ -39,6 +42,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace raft {
 namespace sparse {
@@ -322,9 +326,132 @@ void from_knn_symmetrize_matrix(const value_idx* __restrict__ knn_indices,
 }
 
 /**
- * Symmetrizes a COO matrix
+ * Position of col among the k neighbors of row, -1 when it is not one of them.
+ */
+template <typename value_idx>
+__device__ int find_knn_neighbor(const value_idx* knn_indices, value_idx row, int k, value_idx col)
+{
+  const value_idx* neighbors = knn_indices + size_t(row) * k;
+  for (int j = 0; j < k; j++) {
+    if (neighbors[j] == col) { return j; }
+  }
+  return -1;
+}
+
+/**
+ * Counts the reverse edges col -> row of the knn graph which are not already knn edges.
+ */
+template <typename value_idx>
+RAFT_KERNEL knn_reverse_degree_kernel(const value_idx* __restrict__ knn_indices,
+                                      const value_idx n,
+                                      const int k,
+                                      value_idx* __restrict__ degree)
+{
+  const size_t tid = size_t(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (tid >= size_t(n) * k) return;
+
+  const value_idx row = tid / k;
+  const value_idx col = knn_indices[tid];
+  if (find_knn_neighbor(knn_indices, col, k, row) < 0) { atomicAdd(degree + col, value_idx(1)); }
+}
+
+/**
+ * Writes every knn edge row -> col at its position among the first k entries of the row, and its
+ * reverse, when it is not a knn edge too, after them in the row of col. The edges found in both
+ * directions take the max of their two distances.
  */
 template <typename value_idx, typename value_t>
+RAFT_KERNEL knn_symmetric_scatter_kernel(const value_idx* __restrict__ knn_indices,
+                                         const value_t* __restrict__ knn_dists,
+                                         const value_idx n,
+                                         const int k,
+                                         const value_idx* __restrict__ indptr,
+                                         value_idx* __restrict__ reverse_count,
+                                         value_idx* __restrict__ indices,
+                                         value_t* __restrict__ data)
+{
+  const size_t tid = size_t(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (tid >= size_t(n) * k) return;
+
+  const value_idx row = tid / k;
+  const value_idx col = knn_indices[tid];
+  const value_t dist  = knn_dists[tid];
+  const int reverse   = find_knn_neighbor(knn_indices, col, k, row);
+
+  const value_idx forward = indptr[row] + tid % k;
+  indices[forward]        = col;
+  if (reverse >= 0) {
+    data[forward] = raft::max(dist, knn_dists[size_t(col) * k + reverse]);
+  } else {
+    data[forward] = dist;
+
+    const value_idx transpose = indptr[col] + k + atomicAdd(reverse_count + col, value_idx(1));
+    indices[transpose]        = row;
+    data[transpose]           = dist;
+  }
+}
+
+/**
+ * @brief Builds the symmetric CSR graph of raw KNN data directly, without a sort.
+ * The following steps are invoked:
+ * (1) Count the reverse edges of each row which are not knn edges, on top of its k neighbors
+ * (2) Scan the row sizes into the indptr and allocate the output
+ * (3) Scatter the knn edges and their reverses in a single pass
+ */
+template <typename value_idx, typename value_t>
+void from_knn_symmetrize_csr(raft::resources const& handle,
+                             const value_idx* knn_indices,
+                             const value_t* knn_dists,
+                             const value_idx n,
+                             const int k,
+                             rmm::device_uvector<value_idx>& indptr,
+                             rmm::device_uvector<value_idx>& indices,
+                             rmm::device_uvector<value_t>& data)
+{
+  auto stream        = resource::get_cuda_stream(handle);
+  auto thrust_policy = resource::get_thrust_policy(handle);
+  RAFT_EXPECTS(2 * size_t(n) * k <= size_t(std::numeric_limits<value_idx>::max()),
+               "The symmetrized knn graph must be addressable by value_idx");
+
+  constexpr int kBlockSize = 256;
+  const auto n_blocks      = raft::ceildiv<size_t>(size_t(n) * k, kBlockSize);
+
+  // (1) Every row has its k neighbors and the reverse edges which are not knn edges
+  indptr.resize(n + 1, stream);
+  thrust::fill(thrust_policy, indptr.begin(), indptr.begin() + n, value_idx(k));
+  indptr.set_element_to_zero_async(n, stream);
+  if (n_blocks > 0) {
+    knn_reverse_degree_kernel<<<n_blocks, kBlockSize, 0, stream>>>(
+      knn_indices, n, k, indptr.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  // (2) The row sizes are scanned in place, the last entry gets the number of nonzeros
+  thrust::exclusive_scan(thrust_policy, indptr.begin(), indptr.end(), indptr.begin());
+  value_idx nnz = indptr.element(n, stream);
+  indices.resize(nnz, stream);
+  data.resize(nnz, stream);
+
+  // (3) The reverse edges of a row are placed after its neighbors in any order
+  rmm::device_uvector<value_idx> reverse_count(n, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(reverse_count.data(), 0, sizeof(value_idx) * n, stream));
+  if (n_blocks > 0) {
+    knn_symmetric_scatter_kernel<<<n_blocks, kBlockSize, 0, stream>>>(knn_indices,
+                                                                      knn_dists,
+                                                                      n,
+                                                                      k,
+                                                                      indptr.data(),
+                                                                      reverse_count.data(),
+                                                                      indices.data(),
+                                                                      data.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+/**
+ * Symmetrizes a COO matrix
+ */
+template <typename value_idx, typename value_t, typename nnz_t = value_idx>
 void symmetrize(raft::resources const& handle,
                 const value_idx* rows,
                 const value_idx* cols,
@@ -332,7 +459,7 @@ void symmetrize(raft::resources const& handle,
                 size_t m,
                 size_t n,
                 size_t nnz,
-                raft::sparse::COO<value_t, value_idx>& out)
+                raft::sparse::COO<value_t, value_idx, nnz_t>& out)
 {
   auto stream = resource::get_cuda_stream(handle);
 
@@ -352,7 +479,7 @@ void symmetrize(raft::resources const& handle,
   // sort COO
   raft::sparse::op::coo_sort((value_idx)m,
                              (value_idx)n,
-                             (value_idx)nnz * 2,
+                             (nnz_t)nnz * 2,
                              symm_rows.data(),
                              symm_cols.data(),
                              symm_vals.data(),
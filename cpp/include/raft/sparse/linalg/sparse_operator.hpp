@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cusparse_handle.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/detail/cusparse_wrappers.h>
+#include <raft/sparse/linalg/detail/cusparse_utils.hpp>
+#include <raft/sparse/linalg/detail/spmm.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <tuple>
+
+namespace raft {
+namespace sparse {
+namespace linalg {
+
+/**
+ * @brief A CSR matrix bound to its cuSparse descriptors, for repeated SpMV and SpMM products.
+ *
+ * `raft::sparse::linalg::spmm` creates the descriptors, and queries and allocates the external
+ * buffer, at every call, which dominates the products of the iterative solvers (Lanczos,
+ * spectral clustering) on small blocks of vectors. The operator creates the sparse descriptor
+ * once, and keeps the dense descriptors, the buffer and the preprocessing of the last
+ * configuration (operations, shapes and layouts) of each product: a product in the same
+ * configuration only updates the pointer of its input. The buffers only grow.
+ *
+ * The operator refers to the arrays of X, which must outlive it. The values of X may change
+ * between the products, but not its sparsity. The products are ordered on the stream of the
+ * handle, and an operator must not be shared between threads.
+ *
+ * @code{.cpp}
+ *   raft::sparse::linalg::sparse_operator<float, int, int> op(handle, csr_view);
+ *   for (int it = 0; it < n_iter; it++) {
+ *     op.spmm(false, false, &alpha, x_view, &beta, y_view);
+ *   }
+ * @endcode
+ *
+ * @tparam ValueType Data type of the matrices (float/double)
+ * @tparam IndexType Type of the index pointers and indices of X, and of the dense operands
+ * @tparam NZType Type of the number of nonzeros of X
+ */
+template <typename ValueType, typename IndexType, typename NZType>
+class sparse_operator {
+ public:
+  /**
+   * @param[in] handle raft handle, whose stream orders the products
+   * @param[in] x the sparse operand raft::device_csr_matrix_view
+   */
+  sparse_operator(raft::resources const& handle,
+                  raft::device_csr_matrix_view<const ValueType, IndexType, IndexType, NZType> x)
+    : handle_(handle),
+      n_rows_(x.structure_view().get_n_rows()),
+      n_cols_(x.structure_view().get_n_cols()),
+      descr_x_(detail::create_descriptor(x)),
+      mv_buffer_(0, resource::get_cuda_stream(handle)),
+      mv_staging_(0, resource::get_cuda_stream(handle)),
+      mm_buffer_(0, resource::get_cuda_stream(handle)),
+      mm_staging_(0, resource::get_cuda_stream(handle))
+  {
+  }
+
+  sparse_operator(const sparse_operator&)            = delete;
+  sparse_operator& operator=(const sparse_operator&) = delete;
+
+  ~sparse_operator()
+  {
+    if (mv_ready_) {
+      RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnVec(mv_y_));
+      RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnVec(mv_z_));
+    }
+    if (mm_ready_) {
+      RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(mm_y_));
+      RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(mm_z_));
+    }
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(descr_x_));
+  }
+
+  /**
+   * @brief SpMV with the cached descriptors: z = alpha . op(X) * y + beta . z
+   * @param[in] trans_x transpose operation for X
+   * @param[in] alpha scalar
+   * @param[in] y input raft::device_vector_view
+   * @param[in] beta scalar
+   * @param[inout] z input-output raft::device_vector_view
+   * @param[in] alg the cuSparse SpMV algorithm
+   */
+  void spmv(const bool trans_x,
+            const ValueType* alpha,
+            raft::device_vector_view<const ValueType, IndexType> y,
+            const ValueType* beta,
+            raft::device_vector_view<ValueType, IndexType> z,
+            cusparseSpMVAlg_t alg = CUSPARSE_SPMV_CSR_ALG1)
+  {
+    auto cusparse_h = resource::get_cusparse_handle(handle_);
+    auto stream     = resource::get_cuda_stream(handle_);
+    auto op         = trans_x ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+    IndexType size_y = trans_x ? n_rows_ : n_cols_;
+    IndexType size_z = trans_x ? n_cols_ : n_rows_;
+    RAFT_EXPECTS(y.extent(0) == size_y, "y must have a size of the columns of op(X)");
+    RAFT_EXPECTS(z.extent(0) == size_z, "z must have a size of the rows of op(X)");
+
+    auto* y_ptr = const_cast<ValueType*>(y.data_handle());
+    if (mv_ready_ && mv_op_ == op && mv_alg_ == alg) {
+      RAFT_CUSPARSE_TRY(cusparseDnVecSetValues(mv_y_, y_ptr));
+    } else {
+      if (mv_ready_) {
+        RAFT_CUSPARSE_TRY(cusparseDestroyDnVec(mv_y_));
+        RAFT_CUSPARSE_TRY(cusparseDestroyDnVec(mv_z_));
+        mv_ready_ = false;
+      }
+      mv_staging_.resize(size_z, stream);
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatednvec(&mv_y_, size_y, y_ptr));
+      RAFT_CUSPARSE_TRY(
+        raft::sparse::detail::cusparsecreatednvec(&mv_z_, size_z, mv_staging_.data()));
+      mv_ready_ = true;
+      mv_op_    = op;
+      mv_alg_   = alg;
+
+      size_t buffer_size;
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv_buffersize(
+        cusparse_h, op, alpha, descr_x_, mv_y_, beta, mv_z_, alg, &buffer_size, stream));
+      grow(mv_buffer_, buffer_size, stream);
+#if CUDA_VER_12_4_UP
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv_preprocess(
+        cusparse_h, op, alpha, descr_x_, mv_y_, beta, mv_z_, alg, mv_buffer_.data(), stream));
+#endif
+    }
+
+    // z goes through an owned buffer, as in linalg::spmm, to work around a cuSparse alignment bug
+    raft::copy(mv_staging_.data(), z.data_handle(), size_z, stream);
+    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv(
+      cusparse_h, op, alpha, descr_x_, mv_y_, beta, mv_z_, alg, mv_buffer_.data(), stream));
+    raft::copy(z.data_handle(), mv_staging_.data(), size_z, stream);
+  }
+
+  /**
+   * @brief SpMM with the cached descriptors: Z = alpha . op(X) * op(Y) + beta . Z
+   * @tparam LayoutPolicyY layout of Y
+   * @tparam LayoutPolicyZ layout of Z
+   * @param[in] trans_x transpose operation for X
+   * @param[in] trans_y transpose operation for Y
+   * @param[in] alpha scalar
+   * @param[in] y input raft::device_matrix_view
+   * @param[in] beta scalar
+   * @param[inout] z input-output raft::device_matrix_view
+   */
+  template <typename LayoutPolicyY, typename LayoutPolicyZ>
+  void spmm(const bool trans_x,
+            const bool trans_y,
+            const ValueType* alpha,
+            raft::device_matrix_view<const ValueType, IndexType, LayoutPolicyY> y,
+            const ValueType* beta,
+            raft::device_matrix_view<ValueType, IndexType, LayoutPolicyZ> z)
+  {
+    auto cusparse_h   = resource::get_cusparse_handle(handle_);
+    auto stream       = resource::get_cuda_stream(handle_);
+    bool is_row_major = detail::is_row_major(y, z);
+    IndexType ld_y    = is_row_major ? y.stride(0) : y.stride(1);
+    IndexType ld_z    = is_row_major ? z.stride(0) : z.stride(1);
+    auto size_z       = is_row_major ? (z.extent(0) - 1) * ld_z + z.extent(1)
+                                     : (z.extent(1) - 1) * ld_z + z.extent(0);
+    mm_config_t config{trans_x,
+                       trans_y,
+                       is_row_major,
+                       y.extent(0),
+                       y.extent(1),
+                       ld_y,
+                       z.extent(0),
+                       z.extent(1),
+                       ld_z};
+
+    auto* y_ptr = const_cast<ValueType*>(y.data_handle());
+    auto op_x   = trans_x ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+    auto op_y   = trans_y ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+    auto alg    = is_row_major ? CUSPARSE_SPMM_CSR_ALG2 : CUSPARSE_SPMM_CSR_ALG1;
+    if (mm_ready_ && mm_config_ == config) {
+      RAFT_CUSPARSE_TRY(cusparseDnMatSetValues(mm_y_, y_ptr));
+    } else {
+      if (mm_ready_) {
+        RAFT_CUSPARSE_TRY(cusparseDestroyDnMat(mm_y_));
+        RAFT_CUSPARSE_TRY(cusparseDestroyDnMat(mm_z_));
+        mm_ready_ = false;
+      }
+      mm_staging_.resize(size_z, stream);
+      auto* z_tmp = mm_staging_.data();
+      mm_y_       = detail::create_descriptor(y);
+      if (is_row_major) {
+        mm_z_ = detail::create_descriptor(
+          raft::make_device_strided_matrix_view<ValueType, IndexType, layout_c_contiguous>(
+            z_tmp, z.extent(0), z.extent(1), ld_z));
+      } else {
+        mm_z_ = detail::create_descriptor(
+          raft::make_device_strided_matrix_view<ValueType, IndexType, layout_f_contiguous>(
+            z_tmp, z.extent(0), z.extent(1), ld_z));
+      }
+      mm_ready_  = true;
+      mm_config_ = config;
+
+      size_t buffer_size;
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmm_bufferSize(
+        cusparse_h, op_x, op_y, alpha, descr_x_, mm_y_, beta, mm_z_, alg, &buffer_size, stream));
+      grow(mm_buffer_, buffer_size, stream);
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmm_preprocess(cusparse_h,
+                                                                      op_x,
+                                                                      op_y,
+                                                                      alpha,
+                                                                      descr_x_,
+                                                                      mm_y_,
+                                                                      beta,
+                                                                      mm_z_,
+                                                                      alg,
+                                                                      mm_buffer_.data(),
+                                                                      stream));
+    }
+
+    // Z goes through an owned buffer, as in linalg::spmm, to work around a cuSparse alignment bug
+    raft::copy(mm_staging_.data(), z.data_handle(), size_z, stream);
+    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmm(cusparse_h,
+                                                         op_x,
+                                                         op_y,
+                                                         alpha,
+                                                         descr_x_,
+                                                         mm_y_,
+                                                         beta,
+                                                         mm_z_,
+                                                         alg,
+                                                         mm_buffer_.data(),
+                                                         stream));
+    raft::copy(z.data_handle(), mm_staging_.data(), size_z, stream);
+  }
+
+ private:
+  // trans_x, trans_y, row major, the extents and leading dimensions of Y and Z
+  using mm_config_t =
+    std::tuple<bool, bool, bool, IndexType, IndexType, IndexType, IndexType, IndexType, IndexType>;
+
+  static void grow(rmm::device_uvector<ValueType>& buffer, size_t bytes, cudaStream_t stream)
+  {
+    size_t size = (bytes + sizeof(ValueType) - 1) / sizeof(ValueType);
+    if (size > buffer.size()) { buffer.resize(size, stream); }
+  }
+
+  raft::resources const& handle_;
+  IndexType n_rows_;
+  IndexType n_cols_;
+  cusparseSpMatDescr_t descr_x_;
+
+  bool mv_ready_ = false;
+  cusparseOperation_t mv_op_;
+  cusparseSpMVAlg_t mv_alg_;
+  cusparseDnVecDescr_t mv_y_;
+  cusparseDnVecDescr_t mv_z_;
+  rmm::device_uvector<ValueType> mv_buffer_;
+  rmm::device_uvector<ValueType> mv_staging_;
+
+  bool mm_ready_ = false;
+  mm_config_t mm_config_;
+  cusparseDnMatDescr_t mm_y_;
+  cusparseDnMatDescr_t mm_z_;
+  rmm::device_uvector<ValueType> mm_buffer_;
+  rmm::device_uvector<ValueType> mm_staging_;
+};
+
+}  // end namespace linalg
+}  // end namespace sparse
+}  // end namespace raft
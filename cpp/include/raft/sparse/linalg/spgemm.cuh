@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/linalg/detail/spgemm.cuh>
+
+namespace raft {
+namespace sparse {
+namespace linalg {
+
+/**
+ * @defgroup spgemm Sparse-Sparse Matrix Multiplication
+ * @{
+ */
+
+/**
+ * @brief Computes the product C = A * B of two sparse matrices in CSR format.
+ *
+ * The product runs in two phases over chunks of the rows of A. The symbolic phase counts the
+ * nonzeros of every row of C, which sizes C, and the numeric phase computes their values. Both
+ * accumulate the products of a row in a hash table with twice as many slots as the row has
+ * products (at most twice the number of columns of B). The chunks are sized so that their tables
+ * fit in the free memory of the workspace resource of the handle, which bounds the peak memory.
+ * The columns of every row of C are sorted, and the order of the floating point additions is not
+ * deterministic.
+ *
+ * For instance, the co-occurrence matrix A * A^T is computed with the transpose of A from
+ * raft::sparse::linalg::csr_transpose as B.
+ *
+ * @code{.cpp}
+ *   #include <raft/sparse/linalg/spgemm.cuh>
+ *   ...
+ *   auto C = raft::make_device_csr_matrix<float, int, int, int>(handle, m, n);
+ *   raft::sparse::linalg::spgemm(handle, A, B, C);
+ *   auto nnz = C.structure_view().get_nnz();
+ * @endcode
+ *
+ * @tparam value_t Data type of the elements (float or double)
+ * @tparam index_t Type of the indptr and indices
+ * @tparam nnz_t Type used for the number of non-zero entries
+ *
+ * @param[in] handle RAFT handle for resource management
+ * @param[in] A Input sparse matrix (device_csr_matrix_view) with shape [m, k]
+ * @param[in] B Input sparse matrix (device_csr_matrix_view) with shape [k, n]
+ * @param[out] C Output sparse matrix (device_csr_matrix) with shape [m, n], whose sparsity is
+ * initialized by the call
+ */
+template <typename value_t, typename index_t, typename nnz_t>
+void spgemm(raft::resources const& handle,
+            raft::device_csr_matrix_view<const value_t, index_t, index_t, nnz_t> A,
+            raft::device_csr_matrix_view<const value_t, index_t, index_t, nnz_t> B,
+            raft::device_csr_matrix<value_t, index_t, index_t, nnz_t>& C)
+{
+  detail::spgemm(handle, A, B, C);
+}
+
+/** @} */  // end of spgemm
+
+}  // end namespace linalg
+}  // end namespace sparse
+}  // end namespace raft
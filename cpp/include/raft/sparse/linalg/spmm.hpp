@@ -21,6 +21,8 @@
 #include <raft/sparse/linalg/detail/cusparse_utils.hpp>
 #include <raft/sparse/linalg/detail/spmm.hpp>
 
+#include <type_traits>
+
 namespace raft {
 namespace sparse {
 namespace linalg {
@@ -30,11 +32,17 @@ namespace linalg {
  * combinations of operand layouts for cuSparse.
  * It computes the following equation: Z = alpha . X * Y + beta . Z
  * where X is a CSR device matrix view and Y,Z are device matrix views
+ *
+ * The index pointers of X may be wider than its indices, e.g. 64-bit offsets for more than 2^31
+ * nonzeros with 32-bit column indices: the rows of X are then multiplied in chunks whose nonzeros
+ * are addressable by the type of the indices.
  * @tparam ValueType Data type of input/output matrices (float/double)
  * @tparam IndexType Type of Y and Z
  * @tparam NZType Type of X
  * @tparam LayoutPolicyY layout of Y
  * @tparam LayoutPolicyZ layout of Z
+ * @tparam IndptrType Type of the index pointers of X
+ * @tparam IndicesType Type of the indices of X
  * @param[in] handle raft handle
  * @param[in] trans_x transpose operation for X
  * @param[in] trans_y transpose operation for Y
@@ -48,12 +56,14 @@ template <typename ValueType,
           typename IndexType,
           typename NZType,
           typename LayoutPolicyY,
-          typename LayoutPolicyZ>
+          typename LayoutPolicyZ,
+          typename IndptrType  = int,
+          typename IndicesType = int>
 void spmm(raft::resources const& handle,
           const bool trans_x,
           const bool trans_y,
           const ValueType* alpha,
-          raft::device_csr_matrix_view<const ValueType, int, int, NZType> x,
+          raft::device_csr_matrix_view<const ValueType, IndptrType, IndicesType, NZType> x,
           raft::device_matrix_view<const ValueType, IndexType, LayoutPolicyY> y,
           const ValueType* beta,
           raft::device_matrix_view<ValueType, IndexType, LayoutPolicyZ> z)
@@ -74,18 +84,23 @@ void spmm(raft::resources const& handle,
                  : raft::make_device_strided_matrix_view<ValueType, IndexType, layout_f_contiguous>(
                      z_tmp.data(), z.extent(0), z.extent(1), z.stride(1));
 
-  auto descr_x = detail::create_descriptor(x);
-  auto descr_y = detail::create_descriptor(y);
-  auto descr_z = detail::create_descriptor(z_tmp_view);
+  if constexpr (std::is_same_v<IndptrType, IndicesType>) {
+    auto descr_x = detail::create_descriptor(x);
+    auto descr_y = detail::create_descriptor(y);
+    auto descr_z = detail::create_descriptor(z_tmp_view);
+
+    detail::spmm(handle, trans_x, trans_y, is_row_major, alpha, descr_x, descr_y, beta, descr_z);
 
-  detail::spmm(handle, trans_x, trans_y, is_row_major, alpha, descr_x, descr_y, beta, descr_z);
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(descr_x));
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(descr_y));
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(descr_z));
+  } else {
+    detail::spmm_row_chunks(handle, trans_x, trans_y, is_row_major, alpha, x, y, beta, z_tmp_view);
+  }
 
   // WARNING: Do not remove the following copy unless you can, with certainty, say that
   // the underlying cuSPARSE issue affecting CUDA 12.2+ has been resolved.
   raft::copy(z.data_handle(), z_tmp.data(), z_tmp.size(), raft::resource::get_cuda_stream(handle));
-  RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(descr_x));
-  RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(descr_y));
-  RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(descr_z));
   RAFT_CUDA_TRY(cudaPeekAtLastError());
 }
 
@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include <raft/core/resources.hpp>
 #include <raft/sparse/coo.hpp>
 #include <raft/sparse/linalg/detail/symmetrize.cuh>
 
+#include <rmm/device_uvector.hpp>
+
 namespace raft {
 namespace sparse {
 namespace linalg {
@@ -146,9 +149,44 @@ void from_knn_symmetrize_matrix(const value_idx* __restrict__ knn_indices,
 }
 
 /**
- * Symmetrizes a COO matrix
+ * @brief Builds the symmetric CSR graph max(data, data.T) of raw KNN data.
+ *
+ * The fixed out-degree k of the knn graph sizes every row without a sort: the reverse edges which
+ * are not knn edges are counted per row on top of its k neighbors, the counts are scanned into
+ * the indptr and the edges are scattered in a single pass. The edges found in both directions
+ * take the max of their two distances, as in `symmetrize()`.
+ *
+ * The first k entries of row i are the k neighbors of i in their knn order, followed by the
+ * reverse edges of i in no particular order. The neighbors of each row are expected to be
+ * distinct.
+ *
+ * @param[in] handle raft handle
+ * @param[in] knn_indices: Input knn indices(n, k)
+ * @param[in] knn_dists: Input knn distances(n, k)
+ * @param[in] n: Number of rows
+ * @param[in] k: Number of n_neighbors
+ * @param[out] indptr: Output CSR indptr, resized to n + 1
+ * @param[out] indices: Output CSR column indices, resized to the number of nonzeros
+ * @param[out] data: Output CSR values, resized to the number of nonzeros
  */
 template <typename value_idx, typename value_t>
+void from_knn_symmetrize_csr(raft::resources const& handle,
+                             const value_idx* knn_indices,
+                             const value_t* knn_dists,
+                             const value_idx n,
+                             const int k,
+                             rmm::device_uvector<value_idx>& indptr,
+                             rmm::device_uvector<value_idx>& indices,
+                             rmm::device_uvector<value_t>& data)
+{
+  detail::from_knn_symmetrize_csr(handle, knn_indices, knn_dists, n, k, indptr, indices, data);
+}
+
+/**
+ * Symmetrizes a COO matrix. The nonzeros of the output are counted in nnz_t, which may be
+ * wider than value_idx when the symmetrized matrix has more than 2^31 nonzeros.
+ */
+template <typename value_idx, typename value_t, typename nnz_t = value_idx>
 void symmetrize(raft::resources const& handle,
                 const value_idx* rows,
                 const value_idx* cols,
@@ -156,7 +194,7 @@ void symmetrize(raft::resources const& handle,
                 size_t m,
                 size_t n,
                 size_t nnz,
-                raft::sparse::COO<value_t, value_idx>& out)
+                raft::sparse::COO<value_t, value_idx, nnz_t>& out)
 {
   detail::symmetrize(handle, rows, cols, vals, m, n, nnz, out);
 }
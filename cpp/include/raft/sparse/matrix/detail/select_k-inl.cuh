@@ -23,6 +23,7 @@
 #include <raft/core/operators.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/linalg/map.cuh>
+#include <raft/matrix/detail/segmented_select_k.cuh>
 #include <raft/matrix/detail/select_k-inl.cuh>
 #include <raft/matrix/select_k_types.hpp>
 
@@ -103,123 +104,19 @@ void select_k(raft::resources const& handle,
   }
   RAFT_EXPECTS(IdxT(k) == out_idx.extent(1), "value and index output lengths must be equal");
 
-  if (algo == SelectAlgo::kAuto) { algo = choose_select_k_algorithm(batch_size, len, k); }
-
-  auto indptr = csr_view.get_indptr().data();
-
-  switch (algo) {
-    case SelectAlgo::kRadix8bits:
-    case SelectAlgo::kRadix11bits:
-    case SelectAlgo::kRadix11bitsExtraPass: {
-      if (algo == SelectAlgo::kRadix8bits) {
-        select::radix::select_k<T, IdxT, 8, 512, false>(
-          handle,
-          in_val.get_elements().data(),
-          (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
-          batch_size,
-          len,
-          k,
-          out_val.data_handle(),
-          out_idx.data_handle(),
-          select_min,
-          true,
-          indptr);
-      } else {
-        bool fused_last_filter = algo == SelectAlgo::kRadix11bits;
-        select::radix::select_k<T, IdxT, 11, 512, false>(
-          handle,
-          in_val.get_elements().data(),
-          (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
-          batch_size,
-          len,
-          k,
-          out_val.data_handle(),
-          out_idx.data_handle(),
-          select_min,
-          fused_last_filter,
-          indptr);
-      }
-
-      if (sorted) {
-        auto offsets = make_device_mdarray<IdxT, IdxT>(
-          handle, resource::get_workspace_resource(handle), make_extents<IdxT>(batch_size + 1));
-        raft::linalg::map_offset(handle, offsets.view(), mul_const_op<IdxT>(k));
-
-        auto keys =
-          raft::make_device_vector_view<T, IdxT>(out_val.data_handle(), (IdxT)(batch_size * k));
-        auto vals =
-          raft::make_device_vector_view<IdxT, IdxT>(out_idx.data_handle(), (IdxT)(batch_size * k));
-
-        segmented_sort_by_key<T, IdxT>(
-          handle, raft::make_const_mdspan(offsets.view()), keys, vals, select_min);
-      }
-
-      return;
-    }
-    case SelectAlgo::kWarpDistributed:
-      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_distributed>(
-        handle,
-        in_val.get_elements().data(),
-        (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
-        batch_size,
-        len,
-        k,
-        out_val.data_handle(),
-        out_idx.data_handle(),
-        select_min,
-        indptr);
-    case SelectAlgo::kWarpDistributedShm:
-      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_distributed_ext>(
-        handle,
-        in_val.get_elements().data(),
-        (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
-        batch_size,
-        len,
-        k,
-        out_val.data_handle(),
-        out_idx.data_handle(),
-        select_min,
-        indptr);
-    case SelectAlgo::kWarpAuto:
-      return select::warpsort::select_k<T, IdxT>(
-        handle,
-        in_val.get_elements().data(),
-        (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
-        batch_size,
-        len,
-        k,
-        out_val.data_handle(),
-        out_idx.data_handle(),
-        select_min,
-        indptr);
-    case SelectAlgo::kWarpImmediate:
-      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_immediate>(
-        handle,
-        in_val.get_elements().data(),
-        (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
-        batch_size,
-        len,
-        k,
-        out_val.data_handle(),
-        out_idx.data_handle(),
-        select_min,
-        indptr);
-    case SelectAlgo::kWarpFiltered:
-      return select::warpsort::select_k_impl<T, IdxT, select::warpsort::warp_sort_filtered>(
-        handle,
-        in_val.get_elements().data(),
-        (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
-        batch_size,
-        len,
-        k,
-        out_val.data_handle(),
-        out_idx.data_handle(),
-        select_min,
-        indptr);
-    default: RAFT_FAIL("K-selection Algorithm not supported.");
-  }
-
-  return;
+  select_k_segments<T, IdxT>(
+    handle,
+    in_val.get_elements().data(),
+    (in_idx.has_value() ? in_idx->data_handle() : csr_view.get_indices().data()),
+    csr_view.get_indptr().data(),
+    batch_size,
+    len,
+    k,
+    out_val.data_handle(),
+    out_idx.data_handle(),
+    select_min,
+    sorted,
+    algo);
 }
 
 }  // namespace raft::sparse::matrix::detail
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/detail/select_radix.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/device_atomics.cuh>
+
+#include <cub/cub.cuh>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+
+namespace raft::sparse::matrix::detail {
+
+/**
+ * Select the k[row] smallest or largest transformed values of every CSR row, a block per row.
+ *
+ * The k-th key of the row is found one byte at a time from the most significant one, with a
+ * histogram of the keys which share the bytes found so far, as in the radix select. The
+ * transformed values are recomputed in every pass instead of being stored. The selected values,
+ * i.e. the keys below the k-th one and as many keys equal to it as needed, are then compacted in
+ * the order of the row, which keeps the columns of a sorted row sorted.
+ */
+template <typename T, typename IdxT, typename TransformOp, int BlockSize>
+RAFT_KERNEL select_k_per_row_kernel(const IdxT* indptr,
+                                    const IdxT* indices,
+                                    const T* values,
+                                    const IdxT* out_indptr,
+                                    IdxT* out_indices,
+                                    T* out_values,
+                                    bool select_min,
+                                    TransformOp transform_op)
+{
+  using bits_t             = typename cub::Traits<T>::UnsignedBits;
+  using block_scan         = cub::BlockScan<IdxT, BlockSize>;
+  constexpr int kNumPasses = sizeof(T);
+  constexpr int kBuckets   = 256;
+
+  __shared__ typename block_scan::TempStorage scan_storage;
+  __shared__ IdxT histogram[kBuckets];
+  __shared__ bits_t kth_prefix;
+  __shared__ IdxT kth_remaining;
+
+  const IdxT row   = blockIdx.x;
+  const IdxT begin = indptr[row];
+  const IdxT end   = indptr[row + 1];
+  const IdxT k     = out_indptr[row + 1] - out_indptr[row];
+  out_indices += out_indptr[row];
+  out_values += out_indptr[row];
+  if (k == 0) { return; }
+
+  auto transformed = [&](IdxT i) { return T(transform_op(values[i], row, indices[i])); };
+  if (k == end - begin) {
+    for (IdxT i = begin + threadIdx.x; i < end; i += BlockSize) {
+      out_indices[i - begin] = indices[i];
+      out_values[i - begin]  = transformed(i);
+    }
+    return;
+  }
+
+  // The bits of the k-th key, and how many keys equal to it are selected
+  bits_t prefix      = 0;
+  bits_t prefix_mask = 0;
+  IdxT remaining     = k;
+  for (int pass = 0; pass < kNumPasses; pass++) {
+    const int shift = (kNumPasses - 1 - pass) * 8;
+    for (int b = threadIdx.x; b < kBuckets; b += BlockSize) {
+      histogram[b] = 0;
+    }
+    __syncthreads();
+    for (IdxT i = begin + threadIdx.x; i < end; i += BlockSize) {
+      auto bits = select::radix::impl::twiddle_in(transformed(i), select_min);
+      if ((bits & prefix_mask) == prefix) {
+        atomicAdd(histogram + ((bits >> shift) & 0xff), IdxT(1));
+      }
+    }
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      IdxT below = 0;
+      int b      = 0;
+      for (; below + histogram[b] < remaining; b++) {
+        below += histogram[b];
+      }
+      kth_prefix    = prefix | (bits_t(b) << shift);
+      kth_remaining = remaining - below;
+    }
+    __syncthreads();
+    prefix    = kth_prefix;
+    remaining = kth_remaining;
+    prefix_mask |= bits_t(0xff) << shift;
+  }
+
+  IdxT n_selected = 0;
+  IdxT n_ties     = 0;
+  for (IdxT tile = begin; tile < end; tile += BlockSize) {
+    const IdxT i     = tile + threadIdx.x;
+    const bool valid = i < end;
+    T value{};
+    bits_t bits = 0;
+    if (valid) {
+      value = transformed(i);
+      bits  = select::radix::impl::twiddle_in(value, select_min);
+    }
+    IdxT is_tie = valid && bits == prefix;
+    IdxT tie_rank, tile_ties;
+    block_scan(scan_storage).ExclusiveSum(is_tie, tie_rank, tile_ties);
+    __syncthreads();
+    IdxT take = valid && (bits < prefix || (is_tie && n_ties + tie_rank < remaining));
+    IdxT pos, tile_taken;
+    block_scan(scan_storage).ExclusiveSum(take, pos, tile_taken);
+    __syncthreads();
+    if (take) {
+      out_indices[n_selected + pos] = indices[i];
+      out_values[n_selected + pos]  = value;
+    }
+    n_selected += tile_taken;
+    n_ties += tile_ties;
+  }
+}
+
+/** See raft::sparse::matrix::select_k_per_row docs */
+template <typename T, typename IdxT, typename TransformOp>
+void select_k_per_row(raft::resources const& handle,
+                      raft::device_csr_matrix_view<const T, IdxT, IdxT, IdxT> in_val,
+                      raft::device_vector_view<const IdxT, IdxT> row_k,
+                      raft::device_csr_matrix<T, IdxT, IdxT, IdxT>& out,
+                      bool select_min,
+                      TransformOp transform_op)
+{
+  auto in_structure  = in_val.structure_view();
+  auto out_structure = out.structure_view();
+  auto n_rows        = in_structure.get_n_rows();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "sparse::matrix::select_k_per_row(n_rows = %zu)", size_t(n_rows));
+  RAFT_EXPECTS(row_k.extent(0) == n_rows, "row_k must have an entry per row of in_val");
+  RAFT_EXPECTS(out_structure.get_n_rows() == n_rows &&
+                 out_structure.get_n_cols() == in_structure.get_n_cols(),
+               "out must have the shape of in_val");
+
+  auto stream           = resource::get_cuda_stream(handle);
+  auto policy           = resource::get_thrust_policy(handle);
+  const IdxT* indptr    = in_structure.get_indptr().data();
+  IdxT* out_indptr      = out_structure.get_indptr().data();
+  const IdxT* k_per_row = row_k.data_handle();
+
+  // Every row keeps min(k[row], row length) values
+  RAFT_CUDA_TRY(cudaMemsetAsync(out_indptr, 0, sizeof(IdxT), stream));
+  thrust::transform(policy,
+                    thrust::make_counting_iterator<IdxT>(0),
+                    thrust::make_counting_iterator<IdxT>(n_rows),
+                    out_indptr + 1,
+                    [indptr, k_per_row] __device__(IdxT row) {
+                      IdxT len = indptr[row + 1] - indptr[row];
+                      IdxT k   = k_per_row[row];
+                      return k < len ? k : len;
+                    });
+  thrust::inclusive_scan(policy, out_indptr + 1, out_indptr + n_rows + 1, out_indptr + 1);
+  IdxT nnz = 0;
+  if (n_rows > 0) { raft::update_host(&nnz, out_indptr + n_rows, 1, stream); }
+  resource::sync_stream(handle);
+  out.initialize_sparsity(nnz);
+  if (nnz == 0) { return; }
+
+  auto out_filled          = out.structure_view();
+  constexpr int kBlockSize = 256;
+  select_k_per_row_kernel<T, IdxT, TransformOp, kBlockSize>
+    <<<n_rows, kBlockSize, 0, stream>>>(indptr,
+                                        in_structure.get_indices().data(),
+                                        in_val.get_elements().data(),
+                                        out_indptr,
+                                        out_filled.get_indices().data(),
+                                        out.get_elements().data(),
+                                        select_min,
+                                        transform_op);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::sparse::matrix::detail
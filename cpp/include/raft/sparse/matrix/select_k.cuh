@@ -19,10 +19,12 @@
 #include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/matrix/select_k_types.hpp>
 #include <raft/sparse/matrix/detail/select_k.cuh>
+#include <raft/sparse/matrix/detail/select_k_per_row.cuh>
 
 #include <optional>
 
@@ -82,6 +84,58 @@ void select_k(raft::resources const& handle,
   return detail::select_k<T, IdxT>(
     handle, in_val, in_idx, out_val, out_idx, select_min, sorted, algo);
 }
+
+/**
+ * Selects the k[i] smallest or largest transformed values from each row i of a CSR matrix, into a
+ * CSR matrix.
+ *
+ * The selection ranks the values `transform_op(value, row, col)` of every row, e.g. the weights of
+ * a Gaussian kernel of the distances of a graph, which are computed on the fly and never
+ * materialized as a CSR matrix. The rows with at most k[i] values keep all of them. The selected
+ * values keep their order within the row, so the columns of the rows of a sorted `in_val` stay
+ * sorted, and the ties at the k-th value are broken by that order.
+ *
+ * @code{.cpp}
+ *   // keep the deg[i] strongest Gaussian affinities of every row i of a distance graph
+ *   auto out = raft::make_device_csr_matrix<float, int, int, int>(handle, n_rows, n_cols);
+ *   raft::sparse::matrix::select_k_per_row(
+ *     handle, dists, raft::make_const_mdspan(deg.view()), out, false,
+ *     [sigma] __device__(float d, int, int) { return expf(-d * d / (sigma * sigma)); });
+ * @endcode
+ *
+ * @tparam T
+ *   Type of the elements being compared (keys).
+ * @tparam IdxT
+ *   Type of the indices associated with the keys.
+ * @tparam TransformOp
+ *   Device functor `T(T value, IdxT row, IdxT col)`.
+ *
+ * @param[in] handle
+ *   Container for managing reusable resources.
+ * @param[in] in_val
+ *   Input matrix in CSR format with a logical dense shape of [n_rows, n_cols].
+ * @param[in] row_k
+ *   Number of values [n_rows] to select in each row.
+ * @param[out] out
+ *   Output CSR matrix [n_rows, n_cols] of the selected transformed values. Its sparsity is
+ *   initialized to the sum over the rows of min(k[i], row length).
+ * @param[in] select_min
+ *   Flag indicating whether to select the k smallest (true) or largest (false) elements.
+ * @param[in] transform_op
+ *   Elementwise transform applied to the values before their selection.
+ */
+template <typename T, typename IdxT, typename TransformOp = raft::identity_op>
+void select_k_per_row(raft::resources const& handle,
+                      raft::device_csr_matrix_view<const T, IdxT, IdxT, IdxT> in_val,
+                      raft::device_vector_view<const IdxT, IdxT> row_k,
+                      raft::device_csr_matrix<T, IdxT, IdxT, IdxT>& out,
+                      bool select_min,
+                      TransformOp transform_op = raft::identity_op{})
+{
+  detail::select_k_per_row<T, IdxT, TransformOp>(
+    handle, in_val, row_k, out, select_min, transform_op);
+}
+
 /** @} */  // end of group select_k
 
 }  // namespace raft::sparse::matrix
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2023, NVIDIA CORPORATION.
+ * Copyright (c) 2018-2024, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -19,6 +19,7 @@
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/sparse/coo.hpp>
+#include <raft/sparse/neighbors/cross_component_nn_types.hpp>
 #include <raft/sparse/neighbors/detail/cross_component_nn.cuh>
 
 namespace raft::sparse::neighbors {
@@ -96,4 +97,50 @@ void cross_component_nn(
                              metric);
 }
 
+/**
+ * Connects the components of an otherwise unconnected knn graph like the exact
+ * `cross_component_nn`, but finds the cross-component nearest neighbors approximately: the rows
+ * of X are indexed with IVF-Flat and every row is searched for its `params.n_candidates` nearest
+ * neighbors in the other components by a filter excluding its own component. The candidates of a
+ * row are reduced with `reduction_op`. This avoids the exhaustive distances between all pairs of
+ * the rows, which dominate the exact version on large datasets with many small components.
+ *
+ * Not every row gets an edge, but the components none of whose rows found a neighbor are searched
+ * again with more probes, so that every component gets at least one edge. The reduction op is
+ * always applied to the original row order; its `gather` and `scatter` functions are not used.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::sparse::neighbors::cross_component_nn_ann_params params;
+ *   params.index_params.n_lists = 4096;
+ *   params.search_params.n_probes = 32;
+ *   raft::sparse::neighbors::cross_component_nn<int, float>(
+ *     handle, out, X, colors, n_rows, n_cols, red_op, params);
+ * @endcode
+ *
+ * @tparam value_idx
+ * @tparam value_t data element type; only float is supported
+ * @param[in] handle raft handle
+ * @param[out] out output edge list containing nearest cross-component
+ *             edges.
+ * @param[in] X original (row-major) dense matrix for which knn graph should be constructed.
+ * @param[in] orig_colors array containing component number for each row of X
+ * @param[in] n_rows number of rows in X
+ * @param[in] n_cols number of cols in X
+ * @param[in] reduction_op reduction operation for computing nearest neighbors
+ * @param[in] params parameters of the approximate search
+ */
+template <typename value_idx, typename value_t, typename red_op>
+void cross_component_nn(raft::resources const& handle,
+                        raft::sparse::COO<value_t, value_idx>& out,
+                        const value_t* X,
+                        const value_idx* orig_colors,
+                        size_t n_rows,
+                        size_t n_cols,
+                        red_op reduction_op,
+                        const cross_component_nn_ann_params& params)
+{
+  detail::cross_component_nn(handle, out, X, orig_colors, n_rows, n_cols, reduction_op, params);
+}
+
 };  // end namespace raft::sparse::neighbors
\ No newline at end of file
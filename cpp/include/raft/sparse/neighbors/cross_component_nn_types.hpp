@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace raft::sparse::neighbors {
+
+/**
+ * Parameters of the approximate cross-component nearest neighbors search.
+ *
+ * The points are indexed with IVF-Flat, and every point is searched for its nearest candidates in
+ * the other components by filtering out the points of its own component. A component none of whose
+ * points found a candidate is searched again with twice as many probes, until all lists are probed.
+ */
+struct cross_component_nn_ann_params {
+  /**
+   * Parameters of the IVF-Flat index of the points. The metric is always L2SqrtExpanded, and
+   * `n_lists` is clamped to the number of the points.
+   */
+  raft::neighbors::ivf_flat::index_params index_params;
+  /** Parameters of the first search of every point. */
+  raft::neighbors::ivf_flat::search_params search_params;
+  /** The number of the other-component candidates of every point passed to the reduction op. */
+  uint32_t n_candidates = 8;
+  /**
+   * The number of the points searched at once; it bounds the size of the candidate buffers.
+   * Zero means all points are searched at once.
+   */
+  size_t batch_size = 65536;
+};
+
+}  // namespace raft::sparse::neighbors
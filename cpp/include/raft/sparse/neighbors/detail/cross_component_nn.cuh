@@ -19,6 +19,7 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/kvp.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/distance/masked_nn.cuh>
@@ -27,9 +28,13 @@
 #include <raft/linalg/norm.cuh>
 #include <raft/matrix/gather.cuh>
 #include <raft/matrix/scatter.cuh>
+#include <raft/neighbors/detail/ivf_flat_search.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/sample_filter_types.hpp>
 #include <raft/sparse/convert/csr.cuh>
 #include <raft/sparse/coo.hpp>
 #include <raft/sparse/linalg/symmetrize.cuh>
+#include <raft/sparse/neighbors/cross_component_nn_types.hpp>
 #include <raft/sparse/op/reduce.cuh>
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/fast_int_div.cuh>
@@ -39,6 +44,8 @@
 #include <cub/cub.cuh>
 #include <thrust/copy.h>
 #include <thrust/device_ptr.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
 #include <thrust/gather.h>
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
@@ -48,8 +55,10 @@
 #include <thrust/transform.h>
 #include <thrust/tuple.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <type_traits>
 
 namespace raft::sparse::neighbors::detail {
 
@@ -336,6 +345,200 @@ void perform_1nn(raft::resources const& handle,
   thrust::transform(exec_policy, kvp, kvp + n_rows, nn_colors, extract_colors_op);
 }
 
+/**
+ * Search the nearest candidates of a batch of rows of X in the other components, and reduce them
+ * into the cross-component 1-nn of the rows with the reduction op.
+ * @tparam value_idx
+ * @tparam value_t
+ * @param[in] handle raft handle
+ * @param[in] index IVF-Flat index of X
+ * @param[in] params search parameters
+ * @param[out] kvp closest neighbor vertex and distance of every row of X; only the rows of the
+ * batch are written
+ * @param[in] colors components of each vertex
+ * @param[in] queries the rows of the batch (contiguous)
+ * @param[in] rows the indices of the rows of the batch in X
+ * @param[in] n_queries number of rows in the batch
+ * @param[in] k number of candidates per row
+ * @param[in] reduction_op reduction operation for computing nearest neighbors
+ */
+template <typename value_idx, typename value_t, typename red_op>
+void search_other_components(raft::resources const& handle,
+                             const raft::neighbors::ivf_flat::index<value_t, int64_t>& index,
+                             const raft::neighbors::ivf_flat::search_params& params,
+                             raft::KeyValuePair<value_idx, value_t>* kvp,
+                             const value_idx* colors,
+                             const value_t* queries,
+                             const value_idx* rows,
+                             size_t n_queries,
+                             uint32_t k,
+                             red_op reduction_op)
+{
+  using OutT       = raft::KeyValuePair<value_idx, value_t>;
+  auto exec_policy = resource::get_thrust_policy(handle);
+
+  auto query_colors = raft::make_device_vector<value_idx, int64_t>(handle, n_queries);
+  auto neighbors    = raft::make_device_matrix<int64_t, int64_t>(handle, n_queries, k);
+  auto distances    = raft::make_device_matrix<float, int64_t>(handle, n_queries, k);
+  thrust::gather(exec_policy, rows, rows + n_queries, colors, query_colors.data_handle());
+
+  raft::neighbors::filtering::label_exclusion_ivf_sample_filter<value_idx> filter{
+    query_colors.data_handle(), colors};
+  raft::neighbors::ivf_flat::detail::search(handle,
+                                            params,
+                                            index,
+                                            queries,
+                                            static_cast<uint32_t>(n_queries),
+                                            k,
+                                            neighbors.data_handle(),
+                                            distances.data_handle(),
+                                            resource::get_workspace_resource(handle),
+                                            filter);
+
+  // The missing candidates (all probed points are in the same component) have invalid indices.
+  thrust::for_each_n(exec_policy,
+                     thrust::counting_iterator<size_t>(0),
+                     n_queries,
+                     [kvp,
+                      rows,
+                      reduction_op,
+                      k,
+                      n_rows    = index.size(),
+                      neighbors = neighbors.data_handle(),
+                      distances = distances.data_handle()] __device__(size_t i) {
+                       value_idx row = rows[i];
+                       OutT out;
+                       reduction_op.init(&out, std::numeric_limits<value_t>::max());
+                       for (uint32_t j = 0; j < k; j++) {
+                         int64_t nbr = neighbors[i * k + j];
+                         if (nbr < 0 || nbr >= n_rows) { continue; }
+                         reduction_op(row, &out, OutT(value_idx(nbr), distances[i * k + j]));
+                       }
+                       kvp[row] = out;
+                     });
+}
+
+/**
+ * Compute the approximate cross-component 1-nearest neighbors for each row in X using an
+ * IVF-Flat index of X and a filter excluding the points of the same component.
+ *
+ * Every row is searched with `params.search_params` first. The rows of the components, none of
+ * whose rows found a candidate in another component, are searched again with twice as many probes,
+ * until all lists are probed; every component therefore gets at least one outgoing edge. The other
+ * rows without a candidate are left with the key set by `reduction_op.init` (-1).
+ * @tparam value_idx
+ * @tparam value_t
+ * @param[in] handle raft handle
+ * @param[out] kvp closest neighbor vertex and distance for each vertex
+ * @param[in] colors components of each vertex, drawn from a monotonically increasing set
+ * @param[in] X original dense data
+ * @param[in] n_rows number of rows in original dense data
+ * @param[in] n_cols number of columns in original dense data
+ * @param[in] reduction_op reduction operation for computing nearest neighbors
+ * @param[in] params parameters of the approximate search
+ */
+template <typename value_idx, typename value_t, typename red_op>
+void perform_1nn_ann(raft::resources const& handle,
+                     raft::KeyValuePair<value_idx, value_t>* kvp,
+                     const value_idx* colors,
+                     const value_t* X,
+                     size_t n_rows,
+                     size_t n_cols,
+                     red_op reduction_op,
+                     const cross_component_nn_ann_params& params)
+{
+  static_assert(std::is_same_v<value_t, float>,
+                "The approximate cross_component_nn supports only float data.");
+  auto stream      = resource::get_cuda_stream(handle);
+  auto exec_policy = resource::get_thrust_policy(handle);
+
+  RAFT_EXPECTS(params.n_candidates > 0, "The number of candidates must be positive.");
+  RAFT_EXPECTS(params.search_params.n_probes > 0, "The number of probes must be positive.");
+
+  value_idx n_components = get_n_components(const_cast<value_idx*>(colors), n_rows, stream);
+  RAFT_EXPECTS(n_components > 1, "There must be at least two components to connect.");
+
+  auto index_params              = params.index_params;
+  index_params.metric            = raft::distance::DistanceType::L2SqrtExpanded;
+  index_params.add_data_on_build = true;
+  index_params.n_lists           = std::min<size_t>(index_params.n_lists, n_rows);
+  auto index                     = raft::neighbors::ivf_flat::build(
+    handle, index_params, raft::make_device_matrix_view<const value_t, int64_t>(X, n_rows, n_cols));
+
+  uint32_t k        = std::min<size_t>(params.n_candidates, n_rows);
+  size_t batch_size = params.batch_size == 0 ? n_rows : std::min(params.batch_size, n_rows);
+
+  auto batch_rows = raft::make_device_vector<value_idx, int64_t>(handle, batch_size);
+  for (size_t offset = 0; offset < n_rows; offset += batch_size) {
+    size_t n_queries = std::min(batch_size, n_rows - offset);
+    raft::linalg::map_offset(
+      handle,
+      raft::make_device_vector_view<value_idx, int64_t>(batch_rows.data_handle(), n_queries),
+      [offset] __device__(int64_t i) { return value_idx(offset + i); });
+    search_other_components(handle,
+                            index,
+                            params.search_params,
+                            kvp,
+                            colors,
+                            X + offset * n_cols,
+                            batch_rows.data_handle(),
+                            n_queries,
+                            k,
+                            reduction_op);
+  }
+
+  // Search the rows of the components without an edge again, probing more lists every time.
+  auto search_params = params.search_params;
+  auto covered       = raft::make_device_vector<bool, int64_t>(handle, n_components);
+  auto pending       = raft::make_device_vector<value_idx, int64_t>(handle, n_rows);
+  auto X_view = raft::make_device_matrix_view<const value_t, int64_t>(X, n_rows, n_cols);
+  while (search_params.n_probes < index.n_lists()) {
+    thrust::fill(
+      exec_policy, covered.data_handle(), covered.data_handle() + n_components, false);
+    thrust::for_each_n(
+      exec_policy,
+      thrust::counting_iterator<value_idx>(0),
+      n_rows,
+      [kvp, colors, n_rows, covered = covered.data_handle()] __device__(value_idx row) {
+        auto key = kvp[row].key;
+        if (key >= 0 && size_t(key) < n_rows) { covered[colors[row]] = true; }
+      });
+    auto pending_end = thrust::copy_if(
+      exec_policy,
+      thrust::counting_iterator<value_idx>(0),
+      thrust::counting_iterator<value_idx>(n_rows),
+      pending.data_handle(),
+      [colors, covered = covered.data_handle()] __device__(value_idx row) {
+        return !covered[colors[row]];
+      });
+    size_t n_pending = pending_end - pending.data_handle();
+    if (n_pending == 0) { break; }
+
+    search_params.n_probes = std::min<uint32_t>(2 * search_params.n_probes, index.n_lists());
+    auto queries = raft::make_device_matrix<value_t, int64_t>(
+      handle, std::min(batch_size, n_pending), n_cols);
+    for (size_t offset = 0; offset < n_pending; offset += batch_size) {
+      size_t n_queries = std::min(batch_size, n_pending - offset);
+      auto rows        = pending.data_handle() + offset;
+      raft::matrix::gather(
+        handle,
+        X_view,
+        raft::make_device_vector_view<const value_idx, int64_t>(rows, n_queries),
+        raft::make_device_matrix_view<value_t, int64_t>(queries.data_handle(), n_queries, n_cols));
+      search_other_components(handle,
+                              index,
+                              search_params,
+                              kvp,
+                              colors,
+                              queries.data_handle(),
+                              rows,
+                              n_queries,
+                              k,
+                              reduction_op);
+    }
+  }
+}
+
 /**
  * Sort nearest neighboring components wrt component of source vertices
  * @tparam value_idx
@@ -418,6 +621,82 @@ void min_components_by_color(raft::sparse::COO<value_t, value_idx>& coo,
     coo.rows(), coo.cols(), coo.vals(), out_index, indices, kvp, nnz);
 }
 
+/**
+ * Reduces the cross-component 1-nn of the vertices to the set of smallest edges between
+ * each source component and its neighboring components, and symmetrizes them.
+ * @tparam value_idx
+ * @tparam value_t
+ * @param[in] handle raft handle
+ * @param[out] out output edge list containing nearest cross-component edges.
+ * @param[inout] colors components of the source vertices [n]
+ * @param[inout] nn_colors components of the nearest neighbors [n]
+ * @param[inout] kvp nearest neighbor vertex / distance of the source vertices [n]
+ * @param[out] src_indices scratch space for the source vertex indices [n]
+ * @param[in] row_ids the source vertices of the `n` entries, or nullptr if the entries are all
+ * vertices in order
+ * @param[in] n number of the source vertices
+ * @param[in] n_rows number of the vertices in the graph
+ */
+template <typename value_idx, typename value_t>
+void min_cross_component_edges(raft::resources const& handle,
+                               raft::sparse::COO<value_t, value_idx>& out,
+                               value_idx* colors,
+                               value_idx* nn_colors,
+                               raft::KeyValuePair<value_idx, value_t>* kvp,
+                               value_idx* src_indices,
+                               const value_idx* row_ids,
+                               size_t n,
+                               size_t n_rows)
+{
+  auto stream = resource::get_cuda_stream(handle);
+
+  /**
+   * Sort data points by color (neighbors are not sorted)
+   */
+  // max_color + 1 = number of connected components
+  // sort nn_colors by key w/ original colors
+  sort_by_color(handle, colors, nn_colors, kvp, src_indices, n);
+  if (row_ids != nullptr) {
+    rmm::device_uvector<value_idx> sorted_rows(n, stream);
+    thrust::gather(resource::get_thrust_policy(handle),
+                   src_indices,
+                   src_indices + n,
+                   row_ids,
+                   sorted_rows.data());
+    raft::copy_async(src_indices, sorted_rows.data(), n, stream);
+  }
+
+  /**
+   * Take the min for any duplicate colors
+   */
+  // Compute mask of duplicates
+  rmm::device_uvector<value_idx> out_index(n + 1, stream);
+  raft::sparse::op::compute_duplicates_mask(out_index.data(), colors, nn_colors, n, stream);
+
+  thrust::exclusive_scan(resource::get_thrust_policy(handle),
+                         out_index.data(),
+                         out_index.data() + out_index.size(),
+                         out_index.data());
+
+  // compute final size
+  value_idx size = 0;
+  raft::update_host(&size, out_index.data() + (out_index.size() - 1), 1, stream);
+  resource::sync_stream(handle, stream);
+
+  size++;
+
+  raft::sparse::COO<value_t, value_idx> min_edges(stream);
+  min_edges.allocate(size, n_rows, n_rows, true, stream);
+
+  min_components_by_color(min_edges, out_index.data(), src_indices, kvp, n, stream);
+
+  /**
+   * Symmetrize resulting edge list
+   */
+  raft::sparse::linalg::symmetrize(
+    handle, min_edges.rows(), min_edges.cols(), min_edges.vals(), n_rows, n_rows, size, out);
+}
+
 /**
  * Connects the components of an otherwise unconnected knn graph
  * by computing a 1-nn to neighboring components of each data point
@@ -497,45 +776,93 @@ void cross_component_nn(
               col_batch_size,
               reduction_op);
 
-  /**
-   * Sort data points by color (neighbors are not sorted)
-   */
-  // max_color + 1 = number of connected components
-  // sort nn_colors by key w/ original colors
-  sort_by_color(
-    handle, colors.data(), nn_colors.data(), temp_inds_dists.data(), src_indices.data(), n_rows);
-
-  /**
-   * Take the min for any duplicate colors
-   */
-  // Compute mask of duplicates
-  rmm::device_uvector<value_idx> out_index(n_rows + 1, stream);
-  raft::sparse::op::compute_duplicates_mask(
-    out_index.data(), colors.data(), nn_colors.data(), n_rows, stream);
-
-  thrust::exclusive_scan(resource::get_thrust_policy(handle),
-                         out_index.data(),
-                         out_index.data() + out_index.size(),
-                         out_index.data());
-
-  // compute final size
-  value_idx size = 0;
-  raft::update_host(&size, out_index.data() + (out_index.size() - 1), 1, stream);
-  resource::sync_stream(handle, stream);
+  min_cross_component_edges(handle,
+                            out,
+                            colors.data(),
+                            nn_colors.data(),
+                            temp_inds_dists.data(),
+                            src_indices.data(),
+                            static_cast<const value_idx*>(nullptr),
+                            n_rows,
+                            n_rows);
+}
 
-  size++;
+/**
+ * Connects the components of an otherwise unconnected knn graph like `cross_component_nn` above,
+ * but finds the cross-component nearest neighbors approximately with an IVF-Flat index of X
+ * instead of the exhaustive masked distances. Only the rows which found a neighbor in another
+ * component contribute edges; every component gets at least one edge.
+ * @tparam value_idx
+ * @tparam value_t
+ * @param[in] handle raft handle
+ * @param[out] out output edge list containing nearest cross-component
+ *             edges.
+ * @param[in] X original (row-major) dense matrix for which knn graph should be constructed.
+ * @param[in] orig_colors array containing component number for each row of X
+ * @param[in] n_rows number of rows in X
+ * @param[in] n_cols number of cols in X
+ * @param[in] reduction_op reduction operation for computing nearest neighbors
+ * @param[in] params parameters of the approximate search
+ */
+template <typename value_idx, typename value_t, typename red_op>
+void cross_component_nn(raft::resources const& handle,
+                        raft::sparse::COO<value_t, value_idx>& out,
+                        const value_t* X,
+                        const value_idx* orig_colors,
+                        size_t n_rows,
+                        size_t n_cols,
+                        red_op reduction_op,
+                        const cross_component_nn_ann_params& params)
+{
+  using OutT       = raft::KeyValuePair<value_idx, value_t>;
+  auto stream      = resource::get_cuda_stream(handle);
+  auto exec_policy = resource::get_thrust_policy(handle);
 
-  raft::sparse::COO<value_t, value_idx> min_edges(stream);
-  min_edges.allocate(size, n_rows, n_rows, true, stream);
+  rmm::device_uvector<value_idx> colors(n_rows, stream);
 
-  min_components_by_color(
-    min_edges, out_index.data(), src_indices.data(), temp_inds_dists.data(), n_rows, stream);
+  // Normalize colors so they are drawn from a monotonically increasing set
+  constexpr bool zero_based = true;
+  raft::label::make_monotonic(
+    colors.data(), const_cast<value_idx*>(orig_colors), n_rows, stream, zero_based);
 
-  /**
-   * Symmetrize resulting edge list
-   */
-  raft::sparse::linalg::symmetrize(
-    handle, min_edges.rows(), min_edges.cols(), min_edges.vals(), n_rows, n_rows, size, out);
+  rmm::device_uvector<OutT> temp_inds_dists(n_rows, stream);
+  perform_1nn_ann(
+    handle, temp_inds_dists.data(), colors.data(), X, n_rows, n_cols, reduction_op, params);
+
+  // Keep only the rows which found a neighbor in another component
+  rmm::device_uvector<value_idx> row_ids(n_rows, stream);
+  auto row_ids_end = thrust::copy_if(
+    exec_policy,
+    thrust::counting_iterator<value_idx>(0),
+    thrust::counting_iterator<value_idx>(n_rows),
+    row_ids.data(),
+    [kvp = temp_inds_dists.data(), n_rows] __device__(value_idx row) {
+      return kvp[row].key >= 0 && size_t(kvp[row].key) < n_rows;
+    });
+  size_t n = row_ids_end - row_ids.data();
+
+  rmm::device_uvector<value_idx> src_colors(n, stream);
+  rmm::device_uvector<value_idx> nn_colors(n, stream);
+  rmm::device_uvector<OutT> src_inds_dists(n, stream);
+  rmm::device_uvector<value_idx> src_indices(n, stream);
+  thrust::gather(exec_policy, row_ids.data(), row_ids_end, colors.data(), src_colors.data());
+  thrust::gather(
+    exec_policy, row_ids.data(), row_ids_end, temp_inds_dists.data(), src_inds_dists.data());
+  thrust::transform(exec_policy,
+                    src_inds_dists.data(),
+                    src_inds_dists.data() + n,
+                    nn_colors.data(),
+                    LookupColorOp<value_idx, value_t>(colors.data()));
+
+  min_cross_component_edges(handle,
+                            out,
+                            src_colors.data(),
+                            nn_colors.data(),
+                            src_inds_dists.data(),
+                            src_indices.data(),
+                            row_ids.data(),
+                            n,
+                            n_rows);
 }
 
 };  // end namespace raft::sparse::neighbors::detail
@@ -16,10 +16,16 @@
 
 #pragma once
 
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_event.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/matrix/select_k.cuh>
+#include <raft/neighbors/detail/knn_merge_parts.cuh>
 #include <raft/sparse/coo.hpp>
 #include <raft/sparse/csr.hpp>
 #include <raft/sparse/detail/utils.h>
@@ -29,8 +35,15 @@
 #include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_uvector.hpp>
+#include <rmm/exec_policy.hpp>
+
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/transform.h>
 
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
 
 namespace raft::sparse::neighbors::detail {
 
@@ -54,8 +67,41 @@ struct csr_batcher_t {
   {
   }
 
+  /**
+   * Read the offsets of the nonzeros of all the `n_batches` batches at once, so that slicing the
+   * batches does not synchronize the stream anymore.
+   */
+  void fetch_batch_offsets(int n_batches, cudaStream_t stream)
+  {
+    rmm::device_uvector<value_idx> offsets(n_batches + 1, stream);
+    thrust::transform(rmm::exec_policy(stream),
+                      thrust::make_counting_iterator<value_idx>(0),
+                      thrust::make_counting_iterator<value_idx>(n_batches + 1),
+                      offsets.data(),
+                      [indptr     = csr_indptr_,
+                       batch_size = batch_size_,
+                       n_rows     = total_rows_] __device__(value_idx batch) {
+                        value_idx row = batch * batch_size;
+                        return indptr[row < n_rows ? row : n_rows];
+                      });
+    batch_offsets_.resize(n_batches + 1);
+    raft::update_host(batch_offsets_.data(), offsets.data(), n_batches + 1, stream);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  }
+
+  /** The largest number of nonzeros of a batch, after fetch_batch_offsets. */
+  value_idx max_batch_nnz() const
+  {
+    value_idx max_nnz = 0;
+    for (size_t i = 0; i + 1 < batch_offsets_.size(); i++) {
+      max_nnz = std::max(max_nnz, batch_offsets_[i + 1] - batch_offsets_[i]);
+    }
+    return max_nnz;
+  }
+
   void set_batch(int batch_num)
   {
+    batch_num_   = batch_num;
     batch_start_ = batch_num * batch_size_;
     batch_stop_  = batch_start_ + batch_size_ - 1;  // zero-based indexing
 
@@ -66,6 +112,18 @@ struct csr_batcher_t {
 
   value_idx get_batch_csr_indptr_nnz(value_idx* batch_indptr, cudaStream_t stream)
   {
+    if (!batch_offsets_.empty()) {
+      batch_csr_start_offset_ = batch_offsets_[batch_num_];
+      batch_csr_stop_offset_  = batch_offsets_[batch_num_ + 1];
+      raft::copy_async(batch_indptr, csr_indptr_ + batch_start_, batch_rows_ + 1, stream);
+      raft::linalg::unaryOp<value_idx>(batch_indptr,
+                                       batch_indptr,
+                                       batch_rows_ + 1,
+                                       raft::sub_const_op<value_idx>(batch_csr_start_offset_),
+                                       stream);
+      return batch_csr_stop_offset_ - batch_csr_start_offset_;
+    }
+
     raft::sparse::op::csr_row_slice_indptr(batch_start_,
                                            batch_stop_,
                                            csr_indptr_,
@@ -96,6 +154,7 @@ struct csr_batcher_t {
 
  private:
   value_idx batch_size_;
+  int batch_num_ = 0;
   value_idx batch_start_;
   value_idx batch_stop_;
   value_idx batch_rows_;
@@ -108,6 +167,9 @@ struct csr_batcher_t {
 
   value_idx batch_csr_start_offset_;
   value_idx batch_csr_stop_offset_;
+
+  // the offsets of the nonzeros of every batch, when fetched beforehand
+  std::vector<value_idx> batch_offsets_;
 };
 
 template <typename value_idx, typename value_t>
@@ -156,13 +218,70 @@ class sparse_knn_t {
   {
   }
 
+  /**
+   * The index batches of every query batch are searched alternately on two streams (taken from the
+   * stream pool if any), each with its own buffers for the slice of the batch and its distances
+   * (twice the memory of a serial search for these, when the two streams differ), so that slicing
+   * and searching a batch overlaps with the batch before. The top-k of every batch
+   * goes into one of the two merge buffers, each holding [2, n_batch_queries, k] results: the
+   * running top-k of the previous batches and the top-k of the batch. The merges are done on the
+   * main stream in the order of the batches, and every merge writes the running top-k into the
+   * other buffer.
+   */
   void run()
   {
     using namespace raft::sparse;
 
+    auto stream = resource::get_cuda_stream(handle);
+
     int n_batches_query = raft::ceildiv((size_t)n_query_rows, batch_size_query);
     csr_batcher_t<value_idx, value_t> query_batcher(
       batch_size_query, n_query_rows, queryIndptr, queryIndices, queryData);
+    query_batcher.fetch_batch_offsets(n_batches_query, stream);
+
+    int n_batches_idx = raft::ceildiv((size_t)n_idx_rows, batch_size_index);
+    csr_batcher_t<value_idx, value_t> idx_batcher(
+      batch_size_index, n_idx_rows, idxIndptr, idxIndices, idxData);
+    idx_batcher.fetch_batch_offsets(n_batches_idx, stream);
+
+    const bool select_min = raft::distance::is_min_close(metric);
+
+    // The translations of the (running, batch) pairs of every merge
+    std::vector<value_idx> translations_host(2 * n_batches_idx, 0);
+    for (int j = 0; j < n_batches_idx; j++) {
+      translations_host[2 * j + 1] = static_cast<value_idx>(j * batch_size_index);
+    }
+    rmm::device_uvector<value_idx> translations(2 * n_batches_idx, stream);
+    raft::update_device(
+      translations.data(), translations_host.data(), translations_host.size(), stream);
+
+    // The handles of the two batch streams, whose thrust policies are bound to them
+    std::array<raft::resources, 2> batch_res{raft::resources(handle), raft::resources(handle)};
+    for (int slot = 0; slot < 2; slot++) {
+      auto batch_stream = resource::get_next_usable_stream(handle, slot);
+      resource::set_cuda_stream(batch_res[slot], batch_stream);
+      batch_res[slot].add_resource_factory(
+        std::make_shared<resource::thrust_policy_resource_factory>(batch_stream));
+    }
+
+    // The slices of the index batches and their distances, one set per distinct stream
+    const bool distinct_streams =
+      resource::get_cuda_stream(batch_res[0]) != resource::get_cuda_stream(batch_res[1]);
+    const int n_buffers = distinct_streams ? 2 : 1;
+    std::vector<idx_batch_buffers> buffers;
+    for (int b = 0; b < n_buffers; b++) {
+      buffers.emplace_back(std::min<size_t>(batch_size_index, n_idx_rows),
+                           idx_batcher.max_batch_nnz(),
+                           std::min<size_t>(batch_size_query, n_query_rows) *
+                             std::min<size_t>(batch_size_index, n_idx_rows),
+                           stream);
+    }
+
+    std::array<resource::cuda_event_resource, 2> searched;
+    std::array<resource::cuda_event_resource, 2> merged;
+    auto event = [](resource::cuda_event_resource& e) {
+      return *static_cast<cudaEvent_t*>(e.get_resource());
+    };
 
     size_t rows_processed = 0;
 
@@ -176,173 +295,137 @@ class sparse_knn_t {
        * Slice CSR to rows in batch
        */
 
-      rmm::device_uvector<value_idx> query_batch_indptr(query_batcher.batch_rows() + 1,
-                                                        resource::get_cuda_stream(handle));
+      rmm::device_uvector<value_idx> query_batch_indptr(query_batcher.batch_rows() + 1, stream);
 
-      value_idx n_query_batch_nnz = query_batcher.get_batch_csr_indptr_nnz(
-        query_batch_indptr.data(), resource::get_cuda_stream(handle));
+      value_idx n_query_batch_nnz =
+        query_batcher.get_batch_csr_indptr_nnz(query_batch_indptr.data(), stream);
 
-      rmm::device_uvector<value_idx> query_batch_indices(n_query_batch_nnz,
-                                                         resource::get_cuda_stream(handle));
-      rmm::device_uvector<value_t> query_batch_data(n_query_batch_nnz,
-                                                    resource::get_cuda_stream(handle));
+      rmm::device_uvector<value_idx> query_batch_indices(n_query_batch_nnz, stream);
+      rmm::device_uvector<value_t> query_batch_data(n_query_batch_nnz, stream);
 
       query_batcher.get_batch_csr_indices_data(
-        query_batch_indices.data(), query_batch_data.data(), resource::get_cuda_stream(handle));
-
-      // A 3-partition temporary merge space to scale the batching. 2 parts for subsequent
-      // batches and 1 space for the results of the merge, which get copied back to the top
-      rmm::device_uvector<value_idx> merge_buffer_indices(0, resource::get_cuda_stream(handle));
-      rmm::device_uvector<value_t> merge_buffer_dists(0, resource::get_cuda_stream(handle));
+        query_batch_indices.data(), query_batch_data.data(), stream);
 
-      value_t* dists_merge_buffer_ptr;
-      value_idx* indices_merge_buffer_ptr;
+      value_idx batch_rows = query_batcher.batch_rows();
+      const size_t n_outs  = size_t(batch_rows) * k;
+      std::array<rmm::device_uvector<value_t>, 2> merge_dists{
+        rmm::device_uvector<value_t>(2 * n_outs, stream),
+        rmm::device_uvector<value_t>(2 * n_outs, stream)};
+      std::array<rmm::device_uvector<value_idx>, 2> merge_indices{
+        rmm::device_uvector<value_idx>(2 * n_outs, stream),
+        rmm::device_uvector<value_idx>(2 * n_outs, stream)};
 
-      int n_batches_idx = raft::ceildiv((size_t)n_idx_rows, batch_size_index);
-      csr_batcher_t<value_idx, value_t> idx_batcher(
-        batch_size_index, n_idx_rows, idxIndptr, idxIndices, idxData);
+      // The batch streams read the query batch and the buffers allocated on the main stream.
+      resource::wait_stream_pool_on_stream(handle);
 
       for (int j = 0; j < n_batches_idx; j++) {
+        const int slot    = j % 2;
+        auto& res         = batch_res[slot];
+        auto& buf         = buffers[slot % n_buffers];
+        auto batch_stream = resource::get_cuda_stream(res);
         idx_batcher.set_batch(j);
+        // The first batch initializes the running top-k, the others go next to it for the merge.
+        const size_t out_part   = j == 0 ? 0 : n_outs;
+        auto* batch_out_dists   = merge_dists[j == 0 ? 1 : slot].data() + out_part;
+        auto* batch_out_indices = merge_indices[j == 0 ? 1 : slot].data() + out_part;
 
-        merge_buffer_indices.resize(query_batcher.batch_rows() * k * 3,
-                                    resource::get_cuda_stream(handle));
-        merge_buffer_dists.resize(query_batcher.batch_rows() * k * 3,
-                                  resource::get_cuda_stream(handle));
+        // The merge buffer of this batch was last read by the merge of the batch `j - 2`.
+        if (j >= 2) { RAFT_CUDA_TRY(cudaStreamWaitEvent(batch_stream, event(merged[slot]))); }
 
         /**
          * Slice CSR to rows in batch
          */
-        rmm::device_uvector<value_idx> idx_batch_indptr(idx_batcher.batch_rows() + 1,
-                                                        resource::get_cuda_stream(handle));
-        rmm::device_uvector<value_idx> idx_batch_indices(0, resource::get_cuda_stream(handle));
-        rmm::device_uvector<value_t> idx_batch_data(0, resource::get_cuda_stream(handle));
-
-        value_idx idx_batch_nnz = idx_batcher.get_batch_csr_indptr_nnz(
-          idx_batch_indptr.data(), resource::get_cuda_stream(handle));
+        value_idx idx_batch_nnz =
+          idx_batcher.get_batch_csr_indptr_nnz(buf.indptr.data(), batch_stream);
 
-        idx_batch_indices.resize(idx_batch_nnz, resource::get_cuda_stream(handle));
-        idx_batch_data.resize(idx_batch_nnz, resource::get_cuda_stream(handle));
-
-        idx_batcher.get_batch_csr_indices_data(
-          idx_batch_indices.data(), idx_batch_data.data(), resource::get_cuda_stream(handle));
+        idx_batcher.get_batch_csr_indices_data(buf.indices.data(), buf.data.data(), batch_stream);
 
         /**
          * Compute distances
          */
-        uint64_t dense_size =
-          (uint64_t)idx_batcher.batch_rows() * (uint64_t)query_batcher.batch_rows();
-        rmm::device_uvector<value_t> batch_dists(dense_size, resource::get_cuda_stream(handle));
-
-        RAFT_CUDA_TRY(cudaMemset(batch_dists.data(), 0, batch_dists.size() * sizeof(value_t)));
+        value_idx batch_cols = idx_batcher.batch_rows();
+        uint64_t dense_size  = (uint64_t)batch_cols * (uint64_t)batch_rows;
+        RAFT_CUDA_TRY(
+          cudaMemsetAsync(buf.dists.data(), 0, dense_size * sizeof(value_t), batch_stream));
 
-        compute_distances(idx_batcher,
+        compute_distances(res,
+                          idx_batcher,
                           query_batcher,
                           idx_batch_nnz,
                           n_query_batch_nnz,
-                          idx_batch_indptr.data(),
-                          idx_batch_indices.data(),
-                          idx_batch_data.data(),
+                          buf.indptr.data(),
+                          buf.indices.data(),
+                          buf.data.data(),
                           query_batch_indptr.data(),
                           query_batch_indices.data(),
                           query_batch_data.data(),
-                          batch_dists.data());
-
-        // Build batch indices array
-        rmm::device_uvector<value_idx> batch_indices(batch_dists.size(),
-                                                     resource::get_cuda_stream(handle));
+                          buf.dists.data());
 
         // populate batch indices array
-        value_idx batch_rows = query_batcher.batch_rows(), batch_cols = idx_batcher.batch_rows();
-
-        iota_fill(batch_indices.data(), batch_rows, batch_cols, resource::get_cuda_stream(handle));
+        iota_fill(buf.dist_indices.data(), batch_rows, batch_cols, batch_stream);
 
         /**
          * Perform k-selection on batch & merge with other k-selections
          */
-        size_t merge_buffer_offset = batch_rows * k;
-        dists_merge_buffer_ptr     = merge_buffer_dists.data() + merge_buffer_offset;
-        indices_merge_buffer_ptr   = merge_buffer_indices.data() + merge_buffer_offset;
-
-        perform_k_selection(idx_batcher,
+        perform_k_selection(res,
+                            idx_batcher,
                             query_batcher,
-                            batch_dists.data(),
-                            batch_indices.data(),
-                            dists_merge_buffer_ptr,
-                            indices_merge_buffer_ptr);
-
-        value_t* dists_merge_buffer_tmp_ptr     = dists_merge_buffer_ptr;
-        value_idx* indices_merge_buffer_tmp_ptr = indices_merge_buffer_ptr;
-
-        // Merge results of difference batches if necessary
-        if (idx_batcher.batch_start() > 0) {
-          size_t merge_buffer_tmp_out  = batch_rows * k * 2;
-          dists_merge_buffer_tmp_ptr   = merge_buffer_dists.data() + merge_buffer_tmp_out;
-          indices_merge_buffer_tmp_ptr = merge_buffer_indices.data() + merge_buffer_tmp_out;
-
-          merge_batches(idx_batcher,
-                        query_batcher,
-                        merge_buffer_dists.data(),
-                        merge_buffer_indices.data(),
-                        dists_merge_buffer_tmp_ptr,
-                        indices_merge_buffer_tmp_ptr);
+                            buf.dists.data(),
+                            buf.dist_indices.data(),
+                            batch_out_dists,
+                            batch_out_indices);
+        RAFT_CUDA_TRY(cudaEventRecord(event(searched[slot]), batch_stream));
+
+        RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, event(searched[slot])));
+        if (j > 0) {
+          raft::neighbors::detail::knn_merge_parts(handle,
+                                                   merge_dists[slot].data(),
+                                                   merge_indices[slot].data(),
+                                                   merge_dists[slot ^ 1].data(),
+                                                   merge_indices[slot ^ 1].data(),
+                                                   batch_rows,
+                                                   2,
+                                                   k,
+                                                   translations.data() + 2 * j,
+                                                   select_min);
+          RAFT_CUDA_TRY(cudaEventRecord(event(merged[slot]), stream));
         }
-
-        // copy merged output back into merge buffer partition for next iteration
-        raft::copy_async<value_idx>(merge_buffer_indices.data(),
-                                    indices_merge_buffer_tmp_ptr,
-                                    batch_rows * k,
-                                    resource::get_cuda_stream(handle));
-        raft::copy_async<value_t>(merge_buffer_dists.data(),
-                                  dists_merge_buffer_tmp_ptr,
-                                  batch_rows * k,
-                                  resource::get_cuda_stream(handle));
       }
 
+      // After the merge of the last batch (or the only batch), the running top-k is in this buffer.
+      const int result = n_batches_idx % 2;
+
       // Copy final merged batch to output array
-      raft::copy_async<value_idx>(output_indices + (rows_processed * k),
-                                  merge_buffer_indices.data(),
-                                  query_batcher.batch_rows() * k,
-                                  resource::get_cuda_stream(handle));
-      raft::copy_async<value_t>(output_dists + (rows_processed * k),
-                                merge_buffer_dists.data(),
-                                query_batcher.batch_rows() * k,
-                                resource::get_cuda_stream(handle));
+      raft::copy_async<value_idx>(
+        output_indices + (rows_processed * k), merge_indices[result].data(), n_outs, stream);
+      raft::copy_async<value_t>(
+        output_dists + (rows_processed * k), merge_dists[result].data(), n_outs, stream);
 
       rows_processed += query_batcher.batch_rows();
     }
   }
 
  private:
-  void merge_batches(csr_batcher_t<value_idx, value_t>& idx_batcher,
-                     csr_batcher_t<value_idx, value_t>& query_batcher,
-                     value_t* merge_buffer_dists,
-                     value_idx* merge_buffer_indices,
-                     value_t* out_dists,
-                     value_idx* out_indices)
-  {
-    // build translation buffer to shift resulting indices by the batch
-    std::vector<value_idx> id_ranges;
-    id_ranges.push_back(0);
-    id_ranges.push_back(idx_batcher.batch_start());
-
-    rmm::device_uvector<value_idx> trans(id_ranges.size(), resource::get_cuda_stream(handle));
-    raft::update_device(
-      trans.data(), id_ranges.data(), id_ranges.size(), resource::get_cuda_stream(handle));
-
-    // combine merge buffers only if there's more than 1 partition to combine
-    raft::spatial::knn::knn_merge_parts(merge_buffer_dists,
-                                        merge_buffer_indices,
-                                        out_dists,
-                                        out_indices,
-                                        query_batcher.batch_rows(),
-                                        2,
-                                        k,
-                                        resource::get_cuda_stream(handle),
-                                        trans.data());
-  }
+  /** The slice of an index batch, and its distances to the query batch. */
+  struct idx_batch_buffers {
+    rmm::device_uvector<value_idx> indptr;
+    rmm::device_uvector<value_idx> indices;
+    rmm::device_uvector<value_t> data;
+    rmm::device_uvector<value_t> dists;
+    rmm::device_uvector<value_idx> dist_indices;
+
+    idx_batch_buffers(size_t max_rows, size_t max_nnz, size_t max_dists, cudaStream_t stream)
+      : indptr(max_rows + 1, stream),
+        indices(max_nnz, stream),
+        data(max_nnz, stream),
+        dists(max_dists, stream),
+        dist_indices(max_dists, stream)
+    {
+    }
+  };
 
-  void perform_k_selection(csr_batcher_t<value_idx, value_t> idx_batcher,
+  void perform_k_selection(raft::resources const& res,
+                           csr_batcher_t<value_idx, value_t> idx_batcher,
                            csr_batcher_t<value_idx, value_t> query_batcher,
                            value_t* batch_dists,
                            value_idx* batch_indices,
@@ -365,7 +448,7 @@ class sparse_knn_t {
 
     // kernel to slice first (min) k cols and copy into batched merge buffer
     raft::matrix::select_k<value_t, value_idx>(
-      handle,
+      res,
       make_device_matrix_view<const value_t, int64_t>(batch_dists, batch_rows, batch_cols),
       make_device_matrix_view<const value_idx, int64_t>(batch_indices, batch_rows, batch_cols),
       make_device_matrix_view<value_t, int64_t>(out_dists, batch_rows, n_neighbors),
@@ -374,7 +457,8 @@ class sparse_knn_t {
       true);
   }
 
-  void compute_distances(csr_batcher_t<value_idx, value_t>& idx_batcher,
+  void compute_distances(raft::resources const& res,
+                         csr_batcher_t<value_idx, value_t>& idx_batcher,
                          csr_batcher_t<value_idx, value_t>& query_batcher,
                          size_t idx_batch_nnz,
                          size_t query_batch_nnz,
@@ -389,7 +473,7 @@ class sparse_knn_t {
     /**
      * Compute distances
      */
-    raft::sparse::distance::detail::distances_config_t<value_idx, value_t> dist_config(handle);
+    raft::sparse::distance::detail::distances_config_t<value_idx, value_t> dist_config(res);
     dist_config.b_nrows = idx_batcher.batch_rows();
     dist_config.b_ncols = n_idx_cols;
     dist_config.b_nnz   = idx_batch_nnz;
@@ -75,6 +75,54 @@ void conv_indices(in_t* inds, out_t* out, size_t size, cudaStream_t stream)
   conv_indices_kernel<<<blocks, tpb, 0, stream>>>(inds, out, size);
 }
 
+/**
+ * Computes the k nearest neighbors of every row of X among the rows of X.
+ *
+ * @param[out] indices neighbor indices, size m * k
+ * @param[out] data neighbor distances, size m * k
+ */
+template <typename value_idx, typename value_t>
+void knn_graph_neighbors(raft::resources const& handle,
+                         const value_t* X,
+                         size_t m,
+                         size_t n,
+                         raft::distance::DistanceType metric,
+                         size_t k,
+                         value_idx* indices,
+                         value_t* data)
+{
+  auto stream = resource::get_cuda_stream(handle);
+
+  size_t nnz = m * k;
+
+  std::vector<value_t*> inputs;
+  inputs.push_back(const_cast<value_t*>(X));
+
+  std::vector<size_t> sizes;
+  sizes.push_back(m);
+
+  // This is temporary. Once faiss is updated, we should be able to
+  // pass value_idx through to knn.
+  rmm::device_uvector<int64_t> int64_indices(nnz, stream);
+
+  raft::spatial::knn::brute_force_knn<int64_t, value_t, size_t>(handle,
+                                                                inputs,
+                                                                sizes,
+                                                                n,
+                                                                const_cast<value_t*>(X),
+                                                                m,
+                                                                int64_indices.data(),
+                                                                data,
+                                                                k,
+                                                                true,
+                                                                true,
+                                                                nullptr,
+                                                                metric);
+
+  // convert from current knn's 64-bit to 32-bit.
+  conv_indices(int64_indices.data(), indices, nnz, stream);
+}
+
 /**
  * Constructs a (symmetrized) knn graph edge list from
  * dense input vectors.
@@ -114,35 +162,44 @@ void knn_graph(raft::resources const& handle,
   size_t blocks = ceildiv(nnz, (size_t)256);
   fill_indices<value_idx><<<blocks, 256, 0, stream>>>(rows.data(), k, nnz);
 
-  std::vector<value_t*> inputs;
-  inputs.push_back(const_cast<value_t*>(X));
+  knn_graph_neighbors(handle, X, m, n, metric, k, indices.data(), data.data());
 
-  std::vector<size_t> sizes;
-  sizes.push_back(m);
+  raft::sparse::linalg::symmetrize(
+    handle, rows.data(), indices.data(), data.data(), m, k, nnz, out);
+}
 
-  // This is temporary. Once faiss is updated, we should be able to
-  // pass value_idx through to knn.
-  rmm::device_uvector<int64_t> int64_indices(nnz, stream);
+/**
+ * Constructs a symmetrized knn graph in CSR format from dense input vectors, with
+ * raft::sparse::linalg::from_knn_symmetrize_csr.
+ */
+template <typename value_idx = int, typename value_t = float>
+void knn_graph(raft::resources const& handle,
+               const value_t* X,
+               size_t m,
+               size_t n,
+               raft::distance::DistanceType metric,
+               rmm::device_uvector<value_idx>& indptr,
+               rmm::device_uvector<value_idx>& indices,
+               rmm::device_uvector<value_t>& data,
+               int c = 15)
+{
+  size_t k = build_k(m, c);
 
-  raft::spatial::knn::brute_force_knn<int64_t, value_t, size_t>(handle,
-                                                                inputs,
-                                                                sizes,
-                                                                n,
-                                                                const_cast<value_t*>(X),
-                                                                m,
-                                                                int64_indices.data(),
-                                                                data.data(),
-                                                                k,
-                                                                true,
-                                                                true,
-                                                                nullptr,
-                                                                metric);
+  auto stream = resource::get_cuda_stream(handle);
 
-  // convert from current knn's 64-bit to 32-bit.
-  conv_indices(int64_indices.data(), indices.data(), nnz, stream);
+  rmm::device_uvector<value_idx> knn_indices(m * k, stream);
+  rmm::device_uvector<value_t> knn_dists(m * k, stream);
 
-  raft::sparse::linalg::symmetrize(
-    handle, rows.data(), indices.data(), data.data(), m, k, nnz, out);
+  knn_graph_neighbors(handle, X, m, n, metric, k, knn_indices.data(), knn_dists.data());
+
+  raft::sparse::linalg::from_knn_symmetrize_csr(handle,
+                                                knn_indices.data(),
+                                                knn_dists.data(),
+                                                value_idx(m),
+                                                int(k),
+                                                indptr,
+                                                indices,
+                                                data);
 }
 
 };  // namespace raft::sparse::neighbors::detail
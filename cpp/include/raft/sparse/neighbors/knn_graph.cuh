@@ -20,6 +20,8 @@
 #include <raft/sparse/coo.hpp>
 #include <raft/sparse/neighbors/detail/knn_graph.cuh>
 
+#include <rmm/device_uvector.hpp>
+
 #include <cstdint>
 
 namespace raft::sparse::neighbors {
@@ -52,4 +54,39 @@ void knn_graph(raft::resources const& handle,
   detail::knn_graph(handle, X, m, n, metric, out, c);
 }
 
+/**
+ * Constructs a symmetrized knn graph in CSR format from dense input vectors.
+ *
+ * Unlike the edge list version, the graph is built from the knn output without a sort, see
+ * raft::sparse::linalg::from_knn_symmetrize_csr: the first k entries of every row are its k
+ * neighbors, followed by its reverse edges in no particular order.
+ *
+ * Note: The resulting KNN graph is not guaranteed to be connected.
+ *
+ * @tparam value_idx
+ * @tparam value_t
+ * @param[in] handle raft handle
+ * @param[in] X dense matrix of input data samples and observations
+ * @param[in] m number of data samples (rows) in X
+ * @param[in] n number of observations (columns) in X
+ * @param[in] metric distance metric to use when constructing neighborhoods
+ * @param[out] indptr output CSR indptr, resized to m + 1
+ * @param[out] indices output CSR column indices, resized to the number of edges
+ * @param[out] data output CSR edge weights, resized to the number of edges
+ * @param c
+ */
+template <typename value_idx = int, typename value_t = float>
+void knn_graph(raft::resources const& handle,
+               const value_t* X,
+               std::size_t m,
+               std::size_t n,
+               raft::distance::DistanceType metric,
+               rmm::device_uvector<value_idx>& indptr,
+               rmm::device_uvector<value_idx>& indices,
+               rmm::device_uvector<value_t>& data,
+               int c = 15)
+{
+  detail::knn_graph(handle, X, m, n, metric, indptr, indices, data, c);
+}
+
 };  // namespace raft::sparse::neighbors
@@ -44,34 +44,34 @@ namespace sparse {
 namespace op {
 namespace detail {
 
-template <typename value_idx>
+template <typename value_idx, typename mask_t = value_idx>
 RAFT_KERNEL compute_duplicates_diffs_kernel(const value_idx* rows,
                                             const value_idx* cols,
-                                            value_idx* diff,
+                                            mask_t* diff,
                                             size_t nnz)
 {
-  size_t tid = blockDim.x * blockIdx.x + threadIdx.x;
+  size_t tid = size_t(blockDim.x) * blockIdx.x + threadIdx.x;
   if (tid >= nnz) return;
 
-  value_idx d = 1;
+  mask_t d = 1;
   if (tid == 0 || (rows[tid - 1] == rows[tid] && cols[tid - 1] == cols[tid])) d = 0;
   diff[tid] = d;
 }
 
-template <typename value_idx, typename value_t>
+template <typename value_idx, typename value_t, typename nnz_t = value_idx>
 RAFT_KERNEL max_duplicates_kernel(const value_idx* src_rows,
                                   const value_idx* src_cols,
                                   const value_t* src_vals,
-                                  const value_idx* index,
+                                  const nnz_t* index,
                                   value_idx* out_rows,
                                   value_idx* out_cols,
                                   value_t* out_vals,
                                   size_t nnz)
 {
-  size_t tid = blockDim.x * blockIdx.x + threadIdx.x;
+  size_t tid = size_t(blockDim.x) * blockIdx.x + threadIdx.x;
 
   if (tid < nnz) {
-    value_idx idx = index[tid];
+    nnz_t idx = index[tid];
     atomicMax(&out_vals[idx], src_vals[tid]);
     out_rows[idx] = src_rows[tid];
     out_cols[idx] = src_cols[tid];
@@ -92,17 +92,18 @@ RAFT_KERNEL max_duplicates_kernel(const value_idx* src_rows,
  * is always a 1 otherwise.
  *
  * @tparam value_idx
+ * @tparam mask_t type of the mask, wide enough to hold its exclusive scan (nnz)
  * @param[out] mask output mask, size nnz
  * @param[in] rows COO rows array, size nnz
  * @param[in] cols COO cols array, size nnz
  * @param[in] nnz number of nonzeros in input arrays
  * @param[in] stream cuda ops will be ordered wrt this stream
  */
-template <typename value_idx>
+template <typename value_idx, typename mask_t = value_idx>
 void compute_duplicates_mask(
-  value_idx* mask, const value_idx* rows, const value_idx* cols, size_t nnz, cudaStream_t stream)
+  mask_t* mask, const value_idx* rows, const value_idx* cols, size_t nnz, cudaStream_t stream)
 {
-  RAFT_CUDA_TRY(cudaMemsetAsync(mask, 0, nnz * sizeof(value_idx), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(mask, 0, nnz * sizeof(mask_t), stream));
 
   compute_duplicates_diffs_kernel<<<raft::ceildiv(nnz, (size_t)256), 256, 0, stream>>>(
     rows, cols, mask, nnz);
@@ -115,6 +116,7 @@ void compute_duplicates_mask(
  * the sorting of values.
  * @tparam value_idx
  * @tparam value_t
+ * @tparam nnz_t type of the number of nonzeros of the output COO
  * @param[out] out output COO, the nnz will be computed allocate() will be called in this function.
  * @param[in] rows COO rows array, size nnz
  * @param[in] cols COO cols array, size nnz
@@ -124,9 +126,9 @@ void compute_duplicates_mask(
  * @param[in] n number of columns in COO input matrix
  * @param[in] stream cuda ops will be ordered wrt this stream
  */
-template <typename value_idx, typename value_t>
+template <typename value_idx, typename value_t, typename nnz_t = value_idx>
 void max_duplicates(raft::resources const& handle,
-                    raft::sparse::COO<value_t, value_idx>& out,
+                    raft::sparse::COO<value_t, value_idx, nnz_t>& out,
                     const value_idx* rows,
                     const value_idx* cols,
                     const value_t* vals,
@@ -138,14 +140,14 @@ void max_duplicates(raft::resources const& handle,
   auto thrust_policy = resource::get_thrust_policy(handle);
 
   // compute diffs & take exclusive scan
-  rmm::device_uvector<value_idx> diff(nnz + 1, stream);
+  rmm::device_uvector<nnz_t> diff(nnz + 1, stream);
 
   compute_duplicates_mask(diff.data(), rows, cols, nnz, stream);
 
   thrust::exclusive_scan(thrust_policy, diff.data(), diff.data() + diff.size(), diff.data());
 
   // compute final size
-  value_idx size = 0;
+  nnz_t size = 0;
   raft::update_host(&size, diff.data() + (diff.size() - 1), 1, stream);
   resource::sync_stream(handle, stream);
   size++;
@@ -39,15 +39,16 @@ namespace op {
  * is always a 1 otherwise.
  *
  * @tparam value_idx
+ * @tparam mask_t type of the mask, wide enough to hold its exclusive scan (nnz)
  * @param[out] mask output mask, size nnz
  * @param[in] rows COO rows array, size nnz
  * @param[in] cols COO cols array, size nnz
  * @param[in] nnz number of nonzeros in input arrays
  * @param[in] stream cuda ops will be ordered wrt this stream
  */
-template <typename value_idx>
+template <typename value_idx, typename mask_t = value_idx>
 void compute_duplicates_mask(
-  value_idx* mask, const value_idx* rows, const value_idx* cols, size_t nnz, cudaStream_t stream)
+  mask_t* mask, const value_idx* rows, const value_idx* cols, size_t nnz, cudaStream_t stream)
 {
   detail::compute_duplicates_mask(mask, rows, cols, nnz, stream);
 }
@@ -59,6 +60,7 @@ void compute_duplicates_mask(
  * the sorting of values.
  * @tparam value_idx
  * @tparam value_t
+ * @tparam nnz_t type of the number of nonzeros of the output COO
  * @param[in] handle
  * @param[out] out output COO, the nnz will be computed allocate() will be called in this function.
  * @param[in] rows COO rows array, size nnz
@@ -68,9 +70,9 @@ void compute_duplicates_mask(
  * @param[in] m number of rows in COO input matrix
  * @param[in] n number of columns in COO input matrix
  */
-template <typename value_idx, typename value_t>
+template <typename value_idx, typename value_t, typename nnz_t = value_idx>
 void max_duplicates(raft::resources const& handle,
-                    raft::sparse::COO<value_t, value_idx>& out,
+                    raft::sparse::COO<value_t, value_idx, nnz_t>& out,
                     const value_idx* rows,
                     const value_idx* cols,
                     const value_t* vals,
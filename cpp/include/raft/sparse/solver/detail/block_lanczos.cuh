@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/resource/cublas_handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/detail/cublas_wrappers.hpp>
+#include <raft/linalg/eig.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/spectral/detail/warn_dbg.hpp>
+#include <raft/spectral/matrix_wrappers.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace raft::sparse::solver::detail {
+
+/**
+ *  @brief  Project nCols consecutive columns out of the nPrev columns which precede them
+ *    Two passes of (block) classical Gram-Schmidt: w = w - P*(P'*w), where P is the n x nPrev
+ *    column-major matrix stored right before w.
+ *  @param handle the raft handle.
+ *  @param w (Input/output, device memory, n*nCols entries) Columns to orthogonalize.
+ *  @param n Number of rows.
+ *  @param nCols Number of columns of w.
+ *  @param nPrev Number of orthonormal columns stored before w.
+ *  @param proj_dev (Workspace, device memory, nPrev*nCols entries)
+ *  @param coords_host (Output, host memory, nPrev*nCols entries, may be null) Incremented by
+ *    the coordinates P'*w of w, as a column-major matrix.
+ */
+template <typename index_type_t, typename value_type_t>
+void projectOutPrevious(raft::resources const& handle,
+                        value_type_t* w,
+                        index_type_t n,
+                        index_type_t nCols,
+                        index_type_t nPrev,
+                        value_type_t* proj_dev,
+                        value_type_t* coords_host)
+{
+  if (nPrev == 0) { return; }
+  auto cublas_h = resource::get_cublas_handle(handle);
+  auto stream   = resource::get_cuda_stream(handle);
+
+  const value_type_t one       = 1;
+  const value_type_t zero      = 0;
+  const value_type_t minus_one = -1;
+  const value_type_t* P        = w - size_t(nPrev) * n;
+
+  std::vector<value_type_t> proj_host(coords_host != nullptr ? size_t(nPrev) * nCols : 0);
+  for (int pass = 0; pass < 2; ++pass) {
+    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemm(cublas_h,
+                                                     CUBLAS_OP_T,
+                                                     CUBLAS_OP_N,
+                                                     nPrev,
+                                                     nCols,
+                                                     n,
+                                                     &one,
+                                                     P,
+                                                     n,
+                                                     w,
+                                                     n,
+                                                     &zero,
+                                                     proj_dev,
+                                                     nPrev,
+                                                     stream));
+    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemm(cublas_h,
+                                                     CUBLAS_OP_N,
+                                                     CUBLAS_OP_N,
+                                                     n,
+                                                     nCols,
+                                                     nPrev,
+                                                     &minus_one,
+                                                     P,
+                                                     n,
+                                                     proj_dev,
+                                                     nPrev,
+                                                     &one,
+                                                     w,
+                                                     n,
+                                                     stream));
+    if (coords_host != nullptr) {
+      raft::update_host(proj_host.data(), proj_dev, proj_host.size(), stream);
+      RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+      for (size_t i = 0; i < proj_host.size(); ++i) {
+        coords_host[i] += proj_host[i];
+      }
+    }
+  }
+}
+
+/**
+ *  @brief  Orthonormalize a block of vectors against a basis and itself
+ *    The block W, stored right after the nBasis orthonormal columns of V, is orthogonalized
+ *    against them, then its columns are orthonormalized one after the other. A column whose
+ *    norm falls under breakdownTol is in the span of the previous ones: it is replaced with a
+ *    random vector orthonormal to all of them, and gets a zero diagonal entry in R.
+ *  @param handle the raft handle.
+ *  @param V (Input/output, device memory, n*(nBasis+blockSize) entries) Basis, followed by W.
+ *  @param n Number of rows of V.
+ *  @param nBasis Number of orthonormal columns of V before W.
+ *  @param blockSize Number of columns of W.
+ *  @param breakdownTol Norm under which a column of W is considered dependent.
+ *  @param rng Random state of the replacement columns.
+ *  @param proj_dev (Workspace, device memory, (nBasis+blockSize)*blockSize entries)
+ *  @param H_host (Output, host memory, nBasis*blockSize entries) Coordinates of W on the basis,
+ *    as a column-major matrix.
+ *  @param R_host (Output, host memory, blockSize*blockSize entries) Upper triangular factor of
+ *    the orthogonalized W, as a column-major matrix.
+ */
+template <typename index_type_t, typename value_type_t>
+void orthonormalizeBlock(raft::resources const& handle,
+                         value_type_t* V,
+                         index_type_t n,
+                         index_type_t nBasis,
+                         index_type_t blockSize,
+                         value_type_t breakdownTol,
+                         raft::random::RngState& rng,
+                         value_type_t* proj_dev,
+                         value_type_t* H_host,
+                         value_type_t* R_host)
+{
+  auto cublas_h = resource::get_cublas_handle(handle);
+  auto stream   = resource::get_cuda_stream(handle);
+
+  value_type_t* W = V + size_t(nBasis) * n;
+  std::fill(H_host, H_host + size_t(nBasis) * blockSize, value_type_t(0));
+  std::fill(R_host, R_host + size_t(blockSize) * blockSize, value_type_t(0));
+
+  projectOutPrevious(handle, W, n, blockSize, nBasis, proj_dev, H_host);
+
+  for (index_type_t c = 0; c < blockSize; ++c) {
+    value_type_t* w = W + size_t(c) * n;
+    projectOutPrevious(handle, w, n, 1, c, proj_dev, R_host + size_t(c) * blockSize);
+
+    value_type_t norm;
+    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasdot(cublas_h, n, w, 1, w, 1, &norm, stream));
+    norm = std::sqrt(norm);
+    if (norm <= breakdownTol) {
+      raft::random::normal(handle, rng, w, n, value_type_t(0), value_type_t(1));
+      projectOutPrevious(handle, w, n, 1, nBasis + c, proj_dev, (value_type_t*)nullptr);
+      RAFT_CUBLAS_TRY(raft::linalg::detail::cublasdot(cublas_h, n, w, 1, w, 1, &norm, stream));
+      norm                              = std::sqrt(norm);
+      R_host[c + size_t(c) * blockSize] = 0;
+    } else {
+      R_host[c + size_t(c) * blockSize] = norm;
+    }
+    value_type_t scale = 1 / norm;
+    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasscal(cublas_h, n, &scale, w, 1, stream));
+  }
+}
+
+/**
+ *  @brief  Compute extreme eigenvectors of a symmetric matrix with a block Lanczos method
+ *    The Krylov basis is expanded by blocks of blockSize vectors, i.e. with one sparse
+ *    matrix-matrix product (A.mm) per iteration, and fully reorthogonalized. The projection
+ *    T = V'*A*V of the matrix on the basis V is kept explicitly. Once the basis has restartIter
+ *    vectors, the Ritz pairs of T are computed and the basis is thick-restarted with the Ritz
+ *    vectors closest to the wanted end of the spectrum, followed by the last block. A Ritz pair
+ *    (theta, y) has converged when ||A*y - theta*y|| <= tol*||A||, with ||A|| estimated from
+ *    the iterations.
+ *  @param largest Whether to compute the largest eigenpairs (by iterating on -A) instead of the
+ *    smallest.
+ *  @return error flag.
+ */
+template <typename index_type_t, typename value_type_t>
+int computeEigenvectorsBlockLanczos(
+  raft::resources const& handle,
+  spectral::matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+  index_type_t nEigVecs,
+  index_type_t blockSize,
+  index_type_t maxIter,
+  index_type_t restartIter,
+  value_type_t tol,
+  index_type_t& iter,
+  value_type_t* __restrict__ eigVals_dev,
+  value_type_t* __restrict__ eigVecs_dev,
+  unsigned long long seed,
+  bool largest)
+{
+  // Matrix dimension
+  index_type_t n = A.nrows_;
+
+  // The basis holds at most maxBasis vectors, followed by the block being expanded
+  index_type_t maxBasis = std::min(restartIter, n - blockSize);
+
+  // Check that parameters are valid
+  RAFT_EXPECTS(nEigVecs > 0 && nEigVecs <= n, "Invalid number of eigenvectors.");
+  RAFT_EXPECTS(blockSize > 0 && blockSize <= n, "Invalid blockSize.");
+  RAFT_EXPECTS(tol > 0, "Invalid tolerance.");
+  RAFT_EXPECTS(maxIter > 0, "Invalid maxIter.");
+  RAFT_EXPECTS(maxBasis >= nEigVecs + blockSize,
+               "Invalid restartIter, the basis must hold nEigVecs + blockSize vectors.");
+
+  auto cublas_h = resource::get_cublas_handle(handle);
+  auto stream   = resource::get_cuda_stream(handle);
+
+  const value_type_t one  = 1;
+  const value_type_t zero = 0;
+  const value_type_t sign = largest ? -1 : 1;
+  const value_type_t eps  = std::numeric_limits<value_type_t>::epsilon();
+
+  // Device memory
+  rmm::device_uvector<value_type_t> basis_dev(size_t(n) * (maxBasis + blockSize), stream);
+  rmm::device_uvector<value_type_t> work_dev(size_t(n) * maxBasis, stream);
+  rmm::device_uvector<value_type_t> proj_dev(size_t(maxBasis + blockSize) * blockSize, stream);
+  rmm::device_uvector<value_type_t> T_dev(size_t(maxBasis) * maxBasis, stream);
+  rmm::device_uvector<value_type_t> ritzVecs_dev(size_t(maxBasis) * maxBasis, stream);
+  rmm::device_uvector<value_type_t> ritzVals_dev(maxBasis, stream);
+  value_type_t* V = basis_dev.data();
+
+  // Host memory: projection T, with the couplings of the block being expanded in its last rows
+  const size_t ldt = maxBasis + blockSize;
+  std::vector<value_type_t> T(ldt * ldt, 0);
+  std::vector<value_type_t> H(ldt * blockSize);
+  std::vector<value_type_t> R(size_t(blockSize) * blockSize);
+  std::vector<value_type_t> ritzVals(maxBasis);
+  std::vector<value_type_t> ritzVecs(size_t(maxBasis) * maxBasis);
+  std::vector<value_type_t> coupling(size_t(blockSize) * maxBasis);
+
+  // Random orthonormal starting block
+  raft::random::RngState rng(seed);
+  raft::random::normal(handle, rng, V, size_t(n) * blockSize, zero, one);
+  orthonormalizeBlock(
+    handle, V, n, index_type_t(0), blockSize, zero, rng, proj_dev.data(), H.data(), R.data());
+
+  value_type_t anorm  = 0;
+  index_type_t nBasis = 0;
+  bool converged      = false;
+  iter                = 0;
+  while (true) {
+    // W = A*P, with P the latest block
+    value_type_t* P = V + size_t(nBasis) * n;
+    value_type_t* W = P + size_t(blockSize) * n;
+    A.mm(sign, P, zero, W, blockSize);
+    ++iter;
+
+    for (index_type_t c = 0; c < blockSize; ++c) {
+      value_type_t norm2;
+      RAFT_CUBLAS_TRY(raft::linalg::detail::cublasdot(
+        cublas_h, n, W + size_t(c) * n, 1, W + size_t(c) * n, 1, &norm2, stream));
+      anorm = std::max(anorm, std::sqrt(norm2));
+    }
+
+    // W = V*H + W'*R, with V the basis including P
+    index_type_t nCols = nBasis + blockSize;
+    orthonormalizeBlock(
+      handle, V, n, nCols, blockSize, 100 * eps * anorm, rng, proj_dev.data(), H.data(), R.data());
+
+    // T(:, P) = H, and the couplings of W' are R on P and zero elsewhere
+    for (index_type_t c = 0; c < blockSize; ++c) {
+      for (index_type_t r = 0; r < nCols; ++r) {
+        T[r + (nBasis + c) * ldt] = H[r + size_t(c) * nCols];
+        T[(nBasis + c) + r * ldt] = H[r + size_t(c) * nCols];
+      }
+    }
+    for (index_type_t c = 0; c < blockSize; ++c) {
+      for (index_type_t r = 0; r < c; ++r) {
+        value_type_t avg =
+          (H[nBasis + r + size_t(c) * nCols] + H[nBasis + c + size_t(r) * nCols]) / 2;
+        T[(nBasis + r) + (nBasis + c) * ldt] = avg;
+        T[(nBasis + c) + (nBasis + r) * ldt] = avg;
+      }
+    }
+    for (index_type_t r = 0; r < blockSize; ++r) {
+      for (index_type_t c = 0; c < nCols; ++c) {
+        value_type_t coef        = c >= nBasis ? R[r + size_t(c - nBasis) * blockSize] : 0;
+        T[(nCols + r) + c * ldt] = coef;
+        T[c + (nCols + r) * ldt] = coef;
+      }
+    }
+    nBasis = nCols;
+    if (nBasis + blockSize <= maxBasis && iter < maxIter) { continue; }
+
+    // Ritz pairs of T, in ascending order
+    for (index_type_t c = 0; c < nBasis; ++c) {
+      std::copy(&T[c * ldt], &T[c * ldt] + nBasis, &ritzVecs[size_t(c) * nBasis]);
+    }
+    raft::update_device(T_dev.data(), ritzVecs.data(), size_t(nBasis) * nBasis, stream);
+    raft::linalg::eigDC(
+      handle, T_dev.data(), nBasis, nBasis, ritzVecs_dev.data(), ritzVals_dev.data(), stream);
+    raft::update_host(ritzVecs.data(), ritzVecs_dev.data(), size_t(nBasis) * nBasis, stream);
+    raft::update_host(ritzVals.data(), ritzVals_dev.data(), nBasis, stream);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    anorm = std::max({anorm, std::abs(ritzVals[0]), std::abs(ritzVals[nBasis - 1])});
+
+    // The residual of the Ritz pair i is W'*(C*s_i), with C the couplings of W'
+    for (index_type_t i = 0; i < nBasis; ++i) {
+      for (index_type_t r = 0; r < blockSize; ++r) {
+        value_type_t sum = 0;
+        for (index_type_t c = 0; c < nBasis; ++c) {
+          sum += T[(nBasis + r) + c * ldt] * ritzVecs[c + size_t(i) * nBasis];
+        }
+        coupling[r + size_t(i) * blockSize] = sum;
+      }
+    }
+    converged = true;
+    for (index_type_t i = 0; i < nEigVecs; ++i) {
+      value_type_t res2 = 0;
+      for (index_type_t r = 0; r < blockSize; ++r) {
+        res2 += coupling[r + size_t(i) * blockSize] * coupling[r + size_t(i) * blockSize];
+      }
+      if (std::sqrt(res2) > tol * anorm) { converged = false; }
+    }
+    if (converged || iter >= maxIter) { break; }
+
+    // Thick restart: the nKeep first Ritz vectors, followed by W'
+    index_type_t nKeep = std::min(maxBasis - blockSize, nEigVecs + (maxBasis - nEigVecs) / 2);
+    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemm(cublas_h,
+                                                     CUBLAS_OP_N,
+                                                     CUBLAS_OP_N,
+                                                     n,
+                                                     nKeep,
+                                                     nBasis,
+                                                     &one,
+                                                     V,
+                                                     n,
+                                                     ritzVecs_dev.data(),
+                                                     nBasis,
+                                                     &zero,
+                                                     work_dev.data(),
+                                                     n,
+                                                     stream));
+    raft::copy(V, work_dev.data(), size_t(n) * nKeep, stream);
+    raft::copy(V + size_t(nKeep) * n, V + size_t(nBasis) * n, size_t(n) * blockSize, stream);
+
+    std::fill(T.begin(), T.end(), value_type_t(0));
+    for (index_type_t i = 0; i < nKeep; ++i) {
+      T[i + i * ldt] = ritzVals[i];
+      for (index_type_t r = 0; r < blockSize; ++r) {
+        T[(nKeep + r) + i * ldt] = coupling[r + size_t(i) * blockSize];
+        T[i + (nKeep + r) * ldt] = coupling[r + size_t(i) * blockSize];
+      }
+    }
+    nBasis = nKeep;
+  }
+  if (!converged) WARNING("block Lanczos failed to converge");
+
+  // The wanted Ritz pairs, in ascending order of the eigenvalues of A
+  std::vector<value_type_t> eigVals(nEigVecs);
+  std::vector<value_type_t> eigCoords(size_t(nBasis) * nEigVecs);
+  for (index_type_t i = 0; i < nEigVecs; ++i) {
+    index_type_t src = largest ? nEigVecs - 1 - i : i;
+    eigVals[i]       = sign * ritzVals[src];
+    std::copy(&ritzVecs[size_t(src) * nBasis],
+              &ritzVecs[size_t(src) * nBasis] + nBasis,
+              &eigCoords[size_t(i) * nBasis]);
+  }
+  raft::update_device(eigVals_dev, eigVals.data(), nEigVecs, stream);
+  raft::update_device(T_dev.data(), eigCoords.data(), eigCoords.size(), stream);
+  RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemm(cublas_h,
+                                                   CUBLAS_OP_N,
+                                                   CUBLAS_OP_N,
+                                                   n,
+                                                   nEigVecs,
+                                                   nBasis,
+                                                   &one,
+                                                   V,
+                                                   n,
+                                                   T_dev.data(),
+                                                   nBasis,
+                                                   &zero,
+                                                   eigVecs_dev,
+                                                   n,
+                                                   stream));
+  RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  return 0;
+}
+
+}  // namespace raft::sparse::solver::detail
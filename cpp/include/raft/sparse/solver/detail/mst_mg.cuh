@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/math.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/convert/coo.cuh>
+#include <raft/sparse/solver/mst_solver.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/sequence.h>
+#include <thrust/tuple.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft::sparse::solver::detail {
+
+/**
+ * The edges of a distributed Boruvka step are ordered by (weight, min endpoint, max endpoint),
+ * which makes the minimum outgoing edge of every supervertex unique without altering the weights.
+ * The minimum is reduced one key at a time, each over the local edges then over the ranks.
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+RAFT_KERNEL mg_min_edge_weight_kernel(const vertex_t* rows,
+                                      const vertex_t* cols,
+                                      const weight_t* weights,
+                                      edge_t e,
+                                      const vertex_t* color,
+                                      weight_t* min_weight)
+{
+  for (edge_t i = edge_t(blockIdx.x) * blockDim.x + threadIdx.x; i < e;
+       i += edge_t(blockDim.x) * gridDim.x) {
+    vertex_t c = color[rows[i]];
+    if (c != color[cols[i]]) { myAtomicMin(min_weight + c, weights[i]); }
+  }
+}
+
+template <typename vertex_t, typename edge_t, typename weight_t>
+RAFT_KERNEL mg_min_edge_lo_kernel(const vertex_t* rows,
+                                  const vertex_t* cols,
+                                  const weight_t* weights,
+                                  edge_t e,
+                                  const vertex_t* color,
+                                  const weight_t* min_weight,
+                                  vertex_t* min_lo)
+{
+  for (edge_t i = edge_t(blockIdx.x) * blockDim.x + threadIdx.x; i < e;
+       i += edge_t(blockDim.x) * gridDim.x) {
+    vertex_t u = rows[i];
+    vertex_t w = cols[i];
+    vertex_t c = color[u];
+    if (c != color[w] && weights[i] == min_weight[c]) {
+      myAtomicMin(min_lo + c, raft::min(u, w));
+    }
+  }
+}
+
+template <typename vertex_t, typename edge_t, typename weight_t>
+RAFT_KERNEL mg_min_edge_hi_kernel(const vertex_t* rows,
+                                  const vertex_t* cols,
+                                  const weight_t* weights,
+                                  edge_t e,
+                                  const vertex_t* color,
+                                  const weight_t* min_weight,
+                                  const vertex_t* min_lo,
+                                  vertex_t* min_hi)
+{
+  for (edge_t i = edge_t(blockIdx.x) * blockDim.x + threadIdx.x; i < e;
+       i += edge_t(blockDim.x) * gridDim.x) {
+    vertex_t u = rows[i];
+    vertex_t w = cols[i];
+    vertex_t c = color[u];
+    if (c != color[w] && weights[i] == min_weight[c] && raft::min(u, w) == min_lo[c]) {
+      myAtomicMin(min_hi + c, raft::max(u, w));
+    }
+  }
+}
+
+/**
+ * Hook every supervertex onto the supervertex at the other end of its minimum edge. When two
+ * supervertices pick the same edge, the smaller one stays a root and the edge is added once.
+ */
+template <typename vertex_t, typename weight_t>
+RAFT_KERNEL mg_hook_kernel(vertex_t v,
+                           const vertex_t* color,
+                           const weight_t* min_weight,
+                           const vertex_t* min_lo,
+                           const vertex_t* min_hi,
+                           vertex_t* parent,
+                           bool* new_edge)
+{
+  for (vertex_t c = vertex_t(blockIdx.x) * blockDim.x + threadIdx.x; c < v;
+       c += vertex_t(blockDim.x) * gridDim.x) {
+    parent[c]   = c;
+    new_edge[c] = false;
+    if (color[c] != c || min_weight[c] == std::numeric_limits<weight_t>::max()) { continue; }
+    vertex_t lo    = min_lo[c];
+    vertex_t hi    = min_hi[c];
+    vertex_t other = color[lo] == c ? color[hi] : color[lo];
+    bool mutual =
+      min_weight[other] == min_weight[c] && min_lo[other] == lo && min_hi[other] == hi;
+    if (!mutual || other < c) {
+      parent[c]   = other;
+      new_edge[c] = true;
+    }
+  }
+}
+
+template <typename vertex_t>
+RAFT_KERNEL mg_pointer_jump_kernel(vertex_t v, vertex_t* parent, bool* done)
+{
+  for (vertex_t c = vertex_t(blockIdx.x) * blockDim.x + threadIdx.x; c < v;
+       c += vertex_t(blockDim.x) * gridDim.x) {
+    vertex_t p  = parent[c];
+    vertex_t gp = parent[p];
+    if (p != gp) {
+      parent[c] = gp;
+      *done     = false;
+    }
+  }
+}
+
+template <typename vertex_t>
+RAFT_KERNEL mg_relabel_kernel(vertex_t v, const vertex_t* parent, vertex_t* color)
+{
+  for (vertex_t u = vertex_t(blockIdx.x) * blockDim.x + threadIdx.x; u < v;
+       u += vertex_t(blockDim.x) * gridDim.x) {
+    color[u] = parent[color[u]];
+  }
+}
+
+/** See raft::sparse::solver::mst_mg docs */
+template <typename vertex_t, typename edge_t, typename weight_t>
+Graph_COO<vertex_t, edge_t, weight_t> mst_mg(raft::resources const& handle,
+                                             const edge_t* offsets,
+                                             const vertex_t* indices,
+                                             const weight_t* weights,
+                                             vertex_t v,
+                                             edge_t e,
+                                             vertex_t* color,
+                                             bool symmetrize_output,
+                                             int iterations)
+{
+  RAFT_EXPECTS(v > 0, "0 vertices");
+  RAFT_EXPECTS(e == 0 || (offsets != nullptr && indices != nullptr && weights != nullptr),
+               "Null local edges.");
+  const auto& comm = resource::get_comms(handle);
+  auto stream      = resource::get_cuda_stream(handle);
+  auto policy      = resource::get_thrust_policy(handle);
+
+  constexpr int kBlockSize = 256;
+  constexpr int kMaxBlocks = 65535;
+  auto edge_blocks =
+    static_cast<int>(std::min<edge_t>(raft::ceildiv<edge_t>(e, kBlockSize), kMaxBlocks));
+  auto vertex_blocks =
+    static_cast<int>(std::min<vertex_t>(raft::ceildiv<vertex_t>(v, kBlockSize), kMaxBlocks));
+
+  rmm::device_uvector<vertex_t> rows(e, stream);
+  if (e > 0) { raft::sparse::convert::csr_to_coo(offsets, v, rows.data(), e, stream); }
+
+  // The color of every vertex is the representative vertex of its supervertex. It is replicated on
+  // all the ranks, which take the same decisions from the same reduced minimum edges.
+  thrust::sequence(policy, color, color + v, vertex_t(0));
+  rmm::device_uvector<weight_t> min_weight(v, stream);
+  rmm::device_uvector<vertex_t> min_lo(v, stream);
+  rmm::device_uvector<vertex_t> min_hi(v, stream);
+  rmm::device_uvector<vertex_t> parent(v, stream);
+  rmm::device_uvector<bool> new_edge(v, stream);
+  rmm::device_scalar<bool> done(stream);
+  const bool true_val = true;
+
+  auto max_mst_edges = symmetrize_output ? 2 * v - 2 : v - 1;
+  Graph_COO<vertex_t, edge_t, weight_t> mst_result(max_mst_edges, stream);
+  edge_t n_edges = 0;
+
+  auto mst_iterations = iterations > 0 ? iterations : v;
+  for (auto i = 0; i < mst_iterations; i++) {
+    thrust::fill(
+      policy, min_weight.begin(), min_weight.end(), std::numeric_limits<weight_t>::max());
+    thrust::fill(policy, min_lo.begin(), min_lo.end(), std::numeric_limits<vertex_t>::max());
+    thrust::fill(policy, min_hi.begin(), min_hi.end(), std::numeric_limits<vertex_t>::max());
+
+    if (e > 0) {
+      mg_min_edge_weight_kernel<<<edge_blocks, kBlockSize, 0, stream>>>(
+        rows.data(), indices, weights, e, color, min_weight.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+    comm.allreduce(min_weight.data(), min_weight.data(), v, comms::op_t::MIN, stream);
+    if (e > 0) {
+      mg_min_edge_lo_kernel<<<edge_blocks, kBlockSize, 0, stream>>>(
+        rows.data(), indices, weights, e, color, min_weight.data(), min_lo.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+    comm.allreduce(min_lo.data(), min_lo.data(), v, comms::op_t::MIN, stream);
+    if (e > 0) {
+      mg_min_edge_hi_kernel<<<edge_blocks, kBlockSize, 0, stream>>>(rows.data(),
+                                                                   indices,
+                                                                   weights,
+                                                                   e,
+                                                                   color,
+                                                                   min_weight.data(),
+                                                                   min_lo.data(),
+                                                                   min_hi.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+    comm.allreduce(min_hi.data(), min_hi.data(), v, comms::op_t::MIN, stream);
+    RAFT_EXPECTS(comm.sync_stream(stream) == comms::status_t::SUCCESS, "allreduce failed");
+
+    mg_hook_kernel<<<vertex_blocks, kBlockSize, 0, stream>>>(v,
+                                                             color,
+                                                             min_weight.data(),
+                                                             min_lo.data(),
+                                                             min_hi.data(),
+                                                             parent.data(),
+                                                             new_edge.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    auto n_new = static_cast<edge_t>(thrust::count(policy, new_edge.begin(), new_edge.end(), true));
+    // exit here when reaching steady state
+    if (n_new == 0) { break; }
+    auto n_out = symmetrize_output ? 2 * n_new : n_new;
+    RAFT_EXPECTS(n_edges + n_out <= max_mst_edges,
+                 "Number of edges found by MST is invalid. The graph may not be symmetric.");
+
+    // append the newly found MST edges to the final output
+    auto found = thrust::make_zip_iterator(
+      thrust::make_tuple(min_lo.begin(), min_hi.begin(), min_weight.begin()));
+    auto out = thrust::make_zip_iterator(thrust::make_tuple(mst_result.src.begin() + n_edges,
+                                                            mst_result.dst.begin() + n_edges,
+                                                            mst_result.weights.begin() + n_edges));
+    thrust::copy_if(policy, found, found + v, new_edge.begin(), out, thrust::identity<bool>{});
+    if (symmetrize_output) {
+      auto reversed = thrust::make_zip_iterator(
+        thrust::make_tuple(min_hi.begin(), min_lo.begin(), min_weight.begin()));
+      thrust::copy_if(
+        policy, reversed, reversed + v, new_edge.begin(), out + n_new, thrust::identity<bool>{});
+    }
+    n_edges += n_out;
+
+    // merge the hooked supervertices into their root
+    do {
+      done.set_value_async(true_val, stream);
+      mg_pointer_jump_kernel<<<vertex_blocks, kBlockSize, 0, stream>>>(
+        v, parent.data(), done.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    } while (!done.value(stream));
+    mg_relabel_kernel<<<vertex_blocks, kBlockSize, 0, stream>>>(v, parent.data(), color);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  // result packaging
+  mst_result.n_edges = n_edges;
+  mst_result.src.resize(n_edges, stream);
+  mst_result.dst.resize(n_edges, stream);
+  mst_result.weights.resize(n_edges, stream);
+
+  return mst_result;
+}
+
+}  // namespace raft::sparse::solver::detail
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <raft/sparse/solver/detail/block_lanczos.cuh>
 #include <raft/sparse/solver/detail/lanczos.cuh>
 #include <raft/spectral/matrix_wrappers.hpp>
 
@@ -155,6 +156,118 @@ int computeLargestEigenvectors(
                                             seed);
 }
 
+/**
+ *  @brief  Compute smallest eigenvectors of symmetric matrix with a block Lanczos method
+ *    Expands the Krylov basis by blocks of blockSize vectors, i.e. with a single sparse
+ *    matrix-matrix product per iteration instead of blockSize matrix-vector products. The basis
+ *    is fully reorthogonalized and thick-restarted with the wanted Ritz vectors once it holds
+ *    restartIter vectors, so that the memory footprint is (restartIter+blockSize)*n entries.
+ *    A block larger than the multiplicity of the wanted eigenvalues finds clustered or repeated
+ *    eigenvalues, which the single vector Lanczos method may miss or resolve slowly.
+ *  @tparam index_type_t the type of data used for indexing.
+ *  @tparam value_type_t the type of data used for weights, distances.
+ *  @param handle the raft handle.
+ *  @param A Matrix.
+ *  @param nEigVecs Number of eigenvectors to compute.
+ *  @param blockSize Number of vectors of a block.
+ *  @param maxIter Maximum number of block Lanczos steps.
+ *  @param restartIter Maximum size of the basis before performing a thick restart. Should be
+ *    at least nEigVecs+blockSize.
+ *  @param tol Convergence tolerance. The block Lanczos iteration will terminate when the
+ *    residual norms of the Ritz pairs are less than tol*||A||, where ||A|| is estimated from the
+ *    iterations.
+ *  @param iter On exit, pointer to total number of block Lanczos iterations performed.
+ *  @param eigVals_dev (Output, device memory, nEigVecs entries)
+ *    Smallest eigenvalues of matrix.
+ *  @param eigVecs_dev (Output, device memory, n*nEigVecs entries)
+ *    Eigenvectors corresponding to smallest eigenvalues of
+ *    matrix. Vectors are stored as columns of a column-major matrix
+ *    with dimensions n x nEigVecs.
+ *  @param seed random seed.
+ *  @return error flag.
+ */
+template <typename index_type_t, typename value_type_t>
+int computeSmallestEigenvectorsBlock(
+  raft::resources const& handle,
+  raft::spectral::matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+  index_type_t nEigVecs,
+  index_type_t blockSize,
+  index_type_t maxIter,
+  index_type_t restartIter,
+  value_type_t tol,
+  index_type_t& iter,
+  value_type_t* __restrict__ eigVals_dev,
+  value_type_t* __restrict__ eigVecs_dev,
+  unsigned long long seed = 1234567)
+{
+  return detail::computeEigenvectorsBlockLanczos(handle,
+                                                 A,
+                                                 nEigVecs,
+                                                 blockSize,
+                                                 maxIter,
+                                                 restartIter,
+                                                 tol,
+                                                 iter,
+                                                 eigVals_dev,
+                                                 eigVecs_dev,
+                                                 seed,
+                                                 false);
+}
+
+/**
+ *  @brief  Compute largest eigenvectors of symmetric matrix with a block Lanczos method
+ *    Runs the block Lanczos method of computeSmallestEigenvectorsBlock on -A. The eigenvalues are
+ *    returned in ascending order, as with computeLargestEigenvectors.
+ *  @tparam index_type_t the type of data used for indexing.
+ *  @tparam value_type_t the type of data used for weights, distances.
+ *  @param handle the raft handle.
+ *  @param A Matrix.
+ *  @param nEigVecs Number of eigenvectors to compute.
+ *  @param blockSize Number of vectors of a block.
+ *  @param maxIter Maximum number of block Lanczos steps.
+ *  @param restartIter Maximum size of the basis before performing a thick restart. Should be
+ *    at least nEigVecs+blockSize.
+ *  @param tol Convergence tolerance. The block Lanczos iteration will terminate when the
+ *    residual norms of the Ritz pairs are less than tol*||A||, where ||A|| is estimated from the
+ *    iterations.
+ *  @param iter On exit, pointer to total number of block Lanczos iterations performed.
+ *  @param eigVals_dev (Output, device memory, nEigVecs entries)
+ *    Largest eigenvalues of matrix.
+ *  @param eigVecs_dev (Output, device memory, n*nEigVecs entries)
+ *    Eigenvectors corresponding to largest eigenvalues of
+ *    matrix. Vectors are stored as columns of a column-major matrix
+ *    with dimensions n x nEigVecs.
+ *  @param seed random seed.
+ *  @return error flag.
+ */
+template <typename index_type_t, typename value_type_t>
+int computeLargestEigenvectorsBlock(
+  raft::resources const& handle,
+  raft::spectral::matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+  index_type_t nEigVecs,
+  index_type_t blockSize,
+  index_type_t maxIter,
+  index_type_t restartIter,
+  value_type_t tol,
+  index_type_t& iter,
+  value_type_t* __restrict__ eigVals_dev,
+  value_type_t* __restrict__ eigVecs_dev,
+  unsigned long long seed = 1234567)
+{
+  return detail::computeEigenvectorsBlockLanczos(handle,
+                                                 A,
+                                                 nEigVecs,
+                                                 blockSize,
+                                                 maxIter,
+                                                 restartIter,
+                                                 tol,
+                                                 iter,
+                                                 eigVals_dev,
+                                                 eigVecs_dev,
+                                                 seed,
+                                                 true);
+}
+
 }  // namespace raft::sparse::solver
 
 #endif
\ No newline at end of file
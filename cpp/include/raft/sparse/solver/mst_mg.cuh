@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/resources.hpp>
+#include <raft/sparse/solver/detail/mst_mg.cuh>
+#include <raft/sparse/solver/mst_solver.cuh>
+
+namespace raft::sparse::solver {
+
+/**
+ * Compute the minimum spanning tree (MST) or minimum spanning forest (MSF) of a graph whose
+ * edges are partitioned over the ranks of a communicator (multi-node multi-GPU).
+ *
+ * Every rank holds a subset of the edges, as a CSR over all the v vertices of the graph, and
+ * calls this function collectively. The union of the local edges must be symmetric, but the two
+ * directions of an edge may live on different ranks. In each Boruvka iteration the ranks find the
+ * minimum outgoing edge of every supervertex among their own edges, and reduce them with
+ * allreduces of v entries, so that the edges never leave their rank. Only per-vertex arrays are
+ * replicated on every rank, which makes graphs with more edges than one device can hold
+ * tractable.
+ *
+ * The ties between equal weights are broken by the vertex ids of the edges, instead of the random
+ * alteration of `mst()`, so that all the ranks pick the same edges. On exit all the ranks hold the
+ * same MST edges and colors.
+ *
+ * @code{.cpp}
+ *   #include <raft/comms/std_comms.hpp>
+ *   #include <raft/sparse/solver/mst_mg.cuh>
+ *   ...
+ *   raft::resources handle;
+ *   raft::comms::build_comms_nccl_only(&handle, nccl_comm, n_ranks, rank);
+ *   // the local edges, as a CSR over the v vertices
+ *   rmm::device_uvector<int> color(v, stream);
+ *   auto mst_edges = raft::sparse::solver::mst_mg(
+ *     handle, offsets.data(), indices.data(), weights.data(), v, e_local, color.data());
+ * @endcode
+ *
+ * @tparam vertex_t integral type for precision of vertex indexing
+ * @tparam edge_t integral type for precision of edge indexing
+ * @tparam weight_t type of weights array
+ *
+ * @param handle the raft handle, with an initialized communicator
+ * @param offsets csr inptr array of row offsets of the local edges (size v+1)
+ * @param indices csr array of column indices of the local edges (size e)
+ * @param weights csr array of weights of the local edges (size e)
+ * @param v number of vertices in graph, the same on all the ranks
+ * @param e number of local edges
+ * @param color array to store resulting colors for MSF, the representative vertex of the tree
+ *   of every vertex (size v)
+ * @param symmetrize_output should the resulting output edge list should be symmetrized?
+ * @param iterations maximum number of iterations to perform
+ * @return a list of edges containing the mst (or a subset of the edges guaranteed to be in the mst
+ * when an msf is encountered)
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+Graph_COO<vertex_t, edge_t, weight_t> mst_mg(raft::resources const& handle,
+                                             edge_t const* offsets,
+                                             vertex_t const* indices,
+                                             weight_t const* weights,
+                                             vertex_t const v,
+                                             edge_t const e,
+                                             vertex_t* color,
+                                             bool symmetrize_output = true,
+                                             int iterations         = 0)
+{
+  return detail::mst_mg(
+    handle, offsets, indices, weights, v, e, color, symmetrize_output, iterations);
+}
+
+}  // end namespace raft::sparse::solver
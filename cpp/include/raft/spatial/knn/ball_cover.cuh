@@ -49,10 +49,11 @@ void rbc_all_knn_query(raft::resources const& handle,
                        idx_t* inds,
                        value_t* dists,
                        bool perform_post_filtering = true,
-                       float weight                = 1.0)
+                       float weight                = 1.0,
+                       int_t n_probes              = 0)
 {
   raft::neighbors::ball_cover::all_knn_query(
-    handle, index, k, inds, dists, perform_post_filtering, weight);
+    handle, index, k, inds, dists, perform_post_filtering, weight, n_probes);
 }
 
 template <typename idx_t, typename value_t, typename int_t>
@@ -64,9 +65,10 @@ void rbc_knn_query(raft::resources const& handle,
                    idx_t* inds,
                    value_t* dists,
                    bool perform_post_filtering = true,
-                   float weight                = 1.0)
+                   float weight                = 1.0,
+                   int_t n_probes              = 0)
 {
   raft::neighbors::ball_cover::knn_query(
-    handle, index, k, query, n_query_pts, inds, dists, perform_post_filtering, weight);
+    handle, index, k, query, n_query_pts, inds, dists, perform_post_filtering, weight, n_probes);
 }
 }  // namespace raft::spatial::knn
@@ -151,7 +151,8 @@ struct config<float> {
 };
 template <>
 struct config<half> {
-  using value_t                    = half;
+  // The values are accumulated in fp32: the half precision is lost in the storage only.
+  using value_t                    = float;
   static constexpr double kDivisor = 1.0;
 };
 template <>
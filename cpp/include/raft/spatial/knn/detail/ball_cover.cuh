@@ -19,6 +19,7 @@
 #include "../ball_cover_types.hpp"
 #include "ball_cover/common.cuh"
 #include "ball_cover/registers.cuh"
+#include "ball_cover/tiled.cuh"
 #include "haversine_distance.cuh"
 
 #include <raft/core/resource/cuda_stream.hpp>
@@ -31,6 +32,7 @@
 #include <raft/random/rng.cuh>
 #include <raft/sparse/convert/csr.cuh>
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_uvector.hpp>
 #include <rmm/exec_policy.hpp>
@@ -47,6 +49,7 @@
 
 #include <limits.h>
 
+#include <algorithm>
 #include <cstdint>
 
 namespace raft {
@@ -245,6 +248,8 @@ void compute_landmark_radii(raft::resources const& handle,
  * of distances y from R (only if d(q, r) < 3 * distance to closest r) and
  * marking the distance to be computed between x, y only
  * if knn[k].distance >= d(x_i, R_k) + d(R_k, y)
+ *
+ * R_knn_inds and R_knn_dists hold the n_probes closest landmarks of every query.
  */
 template <typename value_idx,
           typename value_t,
@@ -256,6 +261,7 @@ void perform_rbc_query(raft::resources const& handle,
                        const value_t* query,
                        value_int n_query_pts,
                        value_int k,
+                       value_int n_probes,
                        const value_idx* R_knn_inds,
                        const value_t* R_knn_dists,
                        dist_func dfunc,
@@ -283,6 +289,7 @@ void perform_rbc_query(raft::resources const& handle,
                                                                        query,
                                                                        n_query_pts,
                                                                        k,
+                                                                       n_probes,
                                                                        R_knn_inds,
                                                                        R_knn_dists,
                                                                        dfunc,
@@ -313,6 +320,7 @@ void perform_rbc_query(raft::resources const& handle,
                                                                        query,
                                                                        n_query_pts,
                                                                        k,
+                                                                       n_probes,
                                                                        R_knn_inds,
                                                                        R_knn_dists,
                                                                        dfunc,
@@ -335,6 +343,34 @@ void perform_rbc_query(raft::resources const& handle,
                                                                          weight,
                                                                          post_dists_counter);
     }
+  } else {
+    // Any other number of dimensions, with the points in shared memory
+    rbc_tiled_pass_one<value_idx, value_t, value_int, matrix_idx>(handle,
+                                                                  index,
+                                                                  query,
+                                                                  n_query_pts,
+                                                                  k,
+                                                                  n_probes,
+                                                                  R_knn_inds,
+                                                                  R_knn_dists,
+                                                                  dfunc,
+                                                                  inds,
+                                                                  dists,
+                                                                  weight);
+
+    if (perform_post_filtering) {
+      rbc_tiled_pass_two<value_idx, value_t, value_int, matrix_idx>(handle,
+                                                                    index,
+                                                                    query,
+                                                                    n_query_pts,
+                                                                    k,
+                                                                    R_knn_inds,
+                                                                    R_knn_dists,
+                                                                    dfunc,
+                                                                    inds,
+                                                                    dists,
+                                                                    weight);
+    }
   }
 }
 
@@ -461,6 +497,70 @@ void rbc_build_index(raft::resources const& handle,
   compute_landmark_radii(handle, index);
 }
 
+/**
+ * Adds the points following the current ones in `X` to a trained index, keeping its landmarks:
+ * the new points are assigned to their closest landmark, and the 1-nn index and the radii are
+ * rebuilt for all the points.
+ */
+template <typename value_idx,
+          typename value_t,
+          typename value_int  = std::int64_t,
+          typename matrix_idx = std::int64_t>
+void rbc_extend(raft::resources const& handle,
+                BallCoverIndex<value_idx, value_t, value_int, matrix_idx>& index,
+                raft::device_matrix_view<const value_t, matrix_idx, row_major> X)
+{
+  ASSERT(index.is_index_trained(), "index must be previously trained");
+  ASSERT(X.extent(1) == index.n, "the new points must have the dimensions of the index");
+  ASSERT(X.extent(0) >= index.m, "X must start with the points of the index");
+
+  auto stream        = resource::get_cuda_stream(handle);
+  const value_int m0 = index.m;
+  const value_int m1 = X.extent(0);
+
+  // The closest landmark of each point, and the distance to it, ordered by point
+  rmm::device_uvector<value_idx> R_1nn_inds(m1, stream);
+  rmm::device_uvector<value_t> R_1nn_dists(m1, stream);
+
+  // The current points, from the neighborhoods of the landmarks
+  const value_idx* R_indptr_ptr   = index.get_R_indptr().data_handle();
+  const value_idx* R_1nn_cols_ptr = index.get_R_1nn_cols().data_handle();
+  value_idx* R_1nn_inds_ptr       = R_1nn_inds.data();
+  auto landmarks                  = thrust::make_counting_iterator<value_idx>(0);
+  thrust::for_each(resource::get_thrust_policy(handle),
+                   landmarks,
+                   landmarks + index.n_landmarks,
+                   [=] __device__(value_idx landmark) {
+                     const value_idx end = R_indptr_ptr[landmark + 1];
+                     for (value_idx j = R_indptr_ptr[landmark]; j < end; j++) {
+                       R_1nn_inds_ptr[R_1nn_cols_ptr[j]] = landmark;
+                     }
+                   });
+  raft::copy(R_1nn_dists.data(), index.get_R_closest_landmark_dists().data_handle(), m0, stream);
+
+  // The new points
+  if (m1 > m0) {
+    value_int k = 1;
+    k_closest_landmarks(handle,
+                        index,
+                        X.data_handle() + m0 * index.n,
+                        m1 - m0,
+                        k,
+                        R_1nn_inds.data() + m0,
+                        R_1nn_dists.data() + m0);
+  }
+
+  index.set_X(X);
+  raft::copy(index.get_R_closest_landmark_dists().data_handle(), R_1nn_dists.data(), m1, stream);
+  thrust::sequence(resource::get_thrust_policy(handle),
+                   index.get_R_1nn_cols().data_handle(),
+                   index.get_R_1nn_cols().data_handle() + m1,
+                   (value_idx)0);
+
+  construct_landmark_1nn(handle, R_1nn_inds.data(), R_1nn_dists.data(), (value_int)1, index);
+  compute_landmark_radii(handle, index);
+}
+
 /**
  * Performs an all neighbors knn query (e.g. index == query)
  */
@@ -477,14 +577,22 @@ void rbc_all_knn_query(raft::resources const& handle,
                        distance_func dfunc,
                        // approximate nn options
                        bool perform_post_filtering = true,
-                       float weight                = 1.0)
+                       float weight                = 1.0,
+                       value_int n_probes          = 0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
-  ASSERT(index.n_landmarks >= k, "number of landmark samples must be >= k");
+  if (n_probes > 0) {
+    // Approximate search: only the n_probes closest landmarks are visited, without post-filtering
+    n_probes               = std::min<value_int>(n_probes, index.n_landmarks);
+    perform_post_filtering = false;
+  } else {
+    ASSERT(index.n_landmarks >= k, "number of landmark samples must be >= k");
+    n_probes = k;
+  }
   ASSERT(!index.is_index_trained(), "index cannot be previously trained");
 
-  rmm::device_uvector<value_idx> R_knn_inds(k * index.m, resource::get_cuda_stream(handle));
-  rmm::device_uvector<value_t> R_knn_dists(k * index.m, resource::get_cuda_stream(handle));
+  rmm::device_uvector<value_idx> R_knn_inds(n_probes * index.m,
+                                            resource::get_cuda_stream(handle));
+  rmm::device_uvector<value_t> R_knn_dists(n_probes * index.m, resource::get_cuda_stream(handle));
 
   // Initialize the uvectors
   thrust::fill(resource::get_thrust_policy(handle),
@@ -511,10 +619,15 @@ void rbc_all_knn_query(raft::resources const& handle,
 
   sample_landmarks<value_idx, value_t>(handle, index);
 
-  k_closest_landmarks(
-    handle, index, index.get_X().data_handle(), index.m, k, R_knn_inds.data(), R_knn_dists.data());
+  k_closest_landmarks(handle,
+                      index,
+                      index.get_X().data_handle(),
+                      index.m,
+                      n_probes,
+                      R_knn_inds.data(),
+                      R_knn_dists.data());
 
-  construct_landmark_1nn(handle, R_knn_inds.data(), R_knn_dists.data(), k, index);
+  construct_landmark_1nn(handle, R_knn_inds.data(), R_knn_dists.data(), n_probes, index);
 
   compute_landmark_radii(handle, index);
 
@@ -523,6 +636,7 @@ void rbc_all_knn_query(raft::resources const& handle,
                     index.get_X().data_handle(),
                     index.m,
                     k,
+                    n_probes,
                     R_knn_inds.data(),
                     R_knn_dists.data(),
                     dfunc,
@@ -553,14 +667,23 @@ void rbc_knn_query(raft::resources const& handle,
                    distance_func dfunc,
                    // approximate nn options
                    bool perform_post_filtering = true,
-                   float weight                = 1.0)
+                   float weight                = 1.0,
+                   value_int n_probes          = 0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
-  ASSERT(index.n_landmarks >= k, "number of landmark samples must be >= k");
+  if (n_probes > 0) {
+    // Approximate search: only the n_probes closest landmarks are visited, without post-filtering
+    n_probes               = std::min<value_int>(n_probes, index.n_landmarks);
+    perform_post_filtering = false;
+  } else {
+    ASSERT(index.n_landmarks >= k, "number of landmark samples must be >= k");
+    n_probes = k;
+  }
   ASSERT(index.is_index_trained(), "index must be previously trained");
 
-  rmm::device_uvector<value_idx> R_knn_inds(k * n_query_pts, resource::get_cuda_stream(handle));
-  rmm::device_uvector<value_t> R_knn_dists(k * n_query_pts, resource::get_cuda_stream(handle));
+  rmm::device_uvector<value_idx> R_knn_inds(n_probes * n_query_pts,
+                                            resource::get_cuda_stream(handle));
+  rmm::device_uvector<value_t> R_knn_dists(n_probes * n_query_pts,
+                                           resource::get_cuda_stream(handle));
 
   // Initialize the uvectors
   thrust::fill(resource::get_thrust_policy(handle),
@@ -581,7 +704,8 @@ void rbc_knn_query(raft::resources const& handle,
                dists + (k * n_query_pts),
                std::numeric_limits<value_t>::max());
 
-  k_closest_landmarks(handle, index, query, n_query_pts, k, R_knn_inds.data(), R_knn_dists.data());
+  k_closest_landmarks(
+    handle, index, query, n_query_pts, n_probes, R_knn_inds.data(), R_knn_dists.data());
 
   // For debugging / verification. Remove before releasing
   rmm::device_uvector<value_int> dists_counter(index.m, resource::get_cuda_stream(handle));
@@ -600,6 +724,7 @@ void rbc_knn_query(raft::resources const& handle,
                     query,
                     n_query_pts,
                     k,
+                    n_probes,
                     R_knn_inds.data(),
                     R_knn_dists.data(),
                     dfunc,
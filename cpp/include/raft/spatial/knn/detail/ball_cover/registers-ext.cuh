@@ -38,6 +38,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
                           const value_t* query,
                           const value_int n_query_rows,
                           value_int k,
+                          value_int n_probes,
                           const value_idx* R_knn_inds,
                           const value_t* R_knn_dists,
                           dist_func& dfunc,
@@ -110,6 +111,7 @@ void rbc_eps_pass(raft::resources const& handle,
       const Mvalue_t* query,                                                      \
       const Mvalue_int n_query_rows,                                              \
       Mvalue_int k,                                                               \
+      Mvalue_int n_probes,                                                        \
       const Mvalue_idx* R_knn_inds,                                               \
       const Mvalue_t* R_knn_dists,                                                \
       Mdist_func<Mvalue_t, Mvalue_int>& dfunc,                                    \
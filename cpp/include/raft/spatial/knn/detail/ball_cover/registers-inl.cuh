@@ -301,6 +301,7 @@ RAFT_KERNEL compute_final_dists_registers(const value_t* X_reordered,
  * @param R_knn_dists
  * @param m
  * @param k
+ * @param n_probes number of closest landmarks of every query, the row size of R_knn
  * @param R_indptr
  * @param R_1nn_cols
  * @param R_1nn_dists
@@ -320,6 +321,7 @@ RAFT_KERNEL block_rbc_kernel_registers(const value_t* X_reordered,
                                        const value_t* R_knn_dists,
                                        value_int m,
                                        value_int k,
+                                       value_int n_probes,  // number of columns of R_knn
                                        const value_idx* R_indptr,
                                        const value_idx* R_1nn_cols,
                                        const value_t* R_1nn_dists,
@@ -357,23 +359,25 @@ RAFT_KERNEL block_rbc_kernel_registers(const value_t* X_reordered,
     shared_memV,
     k);
 
-  value_t min_R_dist         = R_knn_dists[blockIdx.x * k + (k - 1)];
+  const value_int n_closest  = k < n_probes ? k : n_probes;
+  value_t min_R_dist         = R_knn_dists[blockIdx.x * n_probes + (n_closest - 1)];
   value_int n_dists_computed = 0;
 
   /**
-   * First add distances for k closest neighbors of R
+   * First add distances for the n_probes closest neighbors of R
    * to the heap
    */
   // Start iterating through elements of each set from closest R elements,
   // determining if the distance could even potentially be in the heap.
-  for (value_int cur_k = 0; cur_k < k; ++cur_k) {
+  for (value_int cur_k = 0; cur_k < n_probes; ++cur_k) {
     // index and distance to current blockIdx.x's closest landmark
-    value_t cur_R_dist  = R_knn_dists[blockIdx.x * k + cur_k];
-    value_idx cur_R_ind = R_knn_inds[blockIdx.x * k + cur_k];
+    value_t cur_R_dist  = R_knn_dists[blockIdx.x * n_probes + cur_k];
+    value_idx cur_R_ind = R_knn_inds[blockIdx.x * n_probes + cur_k];
 
     // Equation (2) in Cayton's paper- prune out R's which are > 3 * p(q, r_q)
     if (cur_R_dist > weight * (min_R_dist + R_radius[cur_R_ind])) continue;
-    if (cur_R_dist > 3 * min_R_dist) return;
+    // The landmarks are sorted by distance, none of the next ones can be closer
+    if (cur_R_dist > 3 * min_R_dist) break;
 
     // The whole warp should iterate through the elements in the current R
     value_idx R_start_offset = R_indptr[cur_R_ind];
@@ -1025,6 +1029,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
                           const value_t* query,
                           const value_int n_query_rows,
                           value_int k,
+                          value_int n_probes,
                           const value_idx* R_knn_inds,
                           const value_t* R_knn_dists,
                           dist_func& dfunc,
@@ -1043,6 +1048,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
         R_knn_dists,
         index.m,
         k,
+        n_probes,
         index.get_R_indptr().data_handle(),
         index.get_R_1nn_cols().data_handle(),
         index.get_R_1nn_dists().data_handle(),
@@ -1063,6 +1069,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
         R_knn_dists,
         index.m,
         k,
+        n_probes,
         index.get_R_indptr().data_handle(),
         index.get_R_1nn_cols().data_handle(),
         index.get_R_1nn_dists().data_handle(),
@@ -1082,6 +1089,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
         R_knn_dists,
         index.m,
         k,
+        n_probes,
         index.get_R_indptr().data_handle(),
         index.get_R_1nn_cols().data_handle(),
         index.get_R_1nn_dists().data_handle(),
@@ -1102,6 +1110,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
         R_knn_dists,
         index.m,
         k,
+        n_probes,
         index.get_R_indptr().data_handle(),
         index.get_R_1nn_cols().data_handle(),
         index.get_R_1nn_dists().data_handle(),
@@ -1122,6 +1131,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
         R_knn_dists,
         index.m,
         k,
+        n_probes,
         index.get_R_indptr().data_handle(),
         index.get_R_1nn_cols().data_handle(),
         index.get_R_1nn_dists().data_handle(),
@@ -1142,6 +1152,7 @@ void rbc_low_dim_pass_one(raft::resources const& handle,
         R_knn_dists,
         index.m,
         k,
+        n_probes,
         index.get_R_indptr().data_handle(),
         index.get_R_1nn_cols().data_handle(),
         index.get_R_1nn_dists().data_handle(),
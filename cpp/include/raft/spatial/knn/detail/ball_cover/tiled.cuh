@@ -0,0 +1,680 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "../../ball_cover_types.hpp"
+#include "common.cuh"
+#include "registers_types.cuh"  // DistFunc
+
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_properties.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/neighbors/detail/faiss_select/key_value_block_select.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/pow2_utils.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+/*
+ * Random ball cover kernels for any number of dimensions.
+ *
+ * The register kernels keep the query and every candidate in registers, which limits them to 2 or
+ * 3 dimensions. Here the query is kept in shared memory, and the points of a ball, which are
+ * contiguous in X_reordered, are loaded in tiles of up to one row per thread with coalesced reads.
+ * The rows of a tile are padded to an odd stride, so that the threads reading their own row do not
+ * collide on the shared memory banks.
+ */
+
+namespace raft {
+namespace spatial {
+namespace knn {
+namespace detail {
+
+/** The stride of the rows in shared memory: odd, to avoid bank conflicts. */
+template <typename value_int>
+__host__ __device__ inline auto rbc_tiled_row_stride(value_int n_cols) -> value_int
+{
+  return n_cols % 2 == 0 ? n_cols + 1 : n_cols;
+}
+
+/**
+ * Load `n_rows` contiguous rows of `src` into the shared memory tile `dst`, with the rows padded to
+ * `row_stride`.
+ */
+template <typename value_t, typename value_int>
+__device__ inline void rbc_tiled_load_rows(
+  value_t* dst, const value_t* src, value_int n_rows, value_int n_cols, value_int row_stride)
+{
+  const value_int n_elems = n_rows * n_cols;
+  for (value_int e = threadIdx.x; e < n_elems; e += blockDim.x) {
+    const value_int r                    = e / n_cols;
+    dst[r * row_stride + e - r * n_cols] = src[e];
+  }
+}
+
+/**
+ * Add the points of a ball to the k-select heap of the block, in tiles of `tile_rows` rows.
+ *
+ * The triangle inequality bound on the distance of a point is evaluated first, and its distance is
+ * only computed if the point could be one of the k nearest neighbors.
+ */
+template <typename value_idx,
+          typename value_t,
+          typename value_int,
+          typename heap_t,
+          typename dist_func>
+__device__ inline void rbc_tiled_add_ball(heap_t& heap,
+                                          const value_t* X_reordered,
+                                          value_int n_cols,
+                                          value_int row_stride,
+                                          value_int tile_rows,
+                                          const value_t* query,
+                                          value_t* tile,
+                                          value_idx R_start_offset,
+                                          value_idx R_size,
+                                          const value_idx* R_1nn_cols,
+                                          const value_t* R_1nn_dists,
+                                          dist_func& dfunc)
+{
+  // All the lanes of a warp are either before or after this limit (tile_rows is a multiple of the
+  // warp size), hence the warp-wide heap.add below.
+  const value_idx limit = Pow2<WarpSize>::roundDown(R_size);
+  for (value_idx t = 0; t < R_size; t += tile_rows) {
+    const auto n_rows = static_cast<value_int>(R_size - t < tile_rows ? R_size - t : tile_rows);
+    __syncthreads();
+    rbc_tiled_load_rows(
+      tile, X_reordered + (R_start_offset + t) * n_cols, n_rows, n_cols, row_stride);
+    __syncthreads();
+    if (threadIdx.x >= tile_rows) { continue; }
+
+    const value_idx i = t + threadIdx.x;
+    if (i >= R_size) { continue; }
+    value_idx cur_candidate_ind = R_1nn_cols[R_start_offset + i];
+    value_t cur_candidate_dist  = R_1nn_dists[R_start_offset + i];
+
+    value_t z = heap.warpKTopRDist == 0.00 ? 0.0
+                                           : (abs(heap.warpKTop - heap.warpKTopRDist) *
+                                                abs(heap.warpKTopRDist - cur_candidate_dist) -
+                                              heap.warpKTop * cur_candidate_dist) /
+                                               heap.warpKTopRDist;
+    z            = isnan(z) || isinf(z) ? 0.0 : z;
+    value_t dist = std::numeric_limits<value_t>::max();
+    if (z <= heap.warpKTop) { dist = dfunc(query, tile + threadIdx.x * row_stride, n_cols); }
+
+    if (i < limit) {
+      heap.add(dist, cur_candidate_dist, cur_candidate_ind);
+    } else {
+      heap.addThreadQ(dist, cur_candidate_dist, cur_candidate_ind);
+    }
+  }
+}
+
+/**
+ * First pass, any number of dimensions: the k nearest neighbors of every query among the points of
+ * its n_probes closest landmarks (see block_rbc_kernel_registers).
+ */
+template <typename value_idx,
+          typename value_t,
+          int warp_q,
+          int thread_q,
+          int tpb,
+          typename value_int,
+          typename distance_func>
+RAFT_KERNEL block_rbc_kernel_tiled(const value_t* X_reordered,
+                                   const value_t* X,
+                                   value_int n_cols,
+                                   value_int tile_rows,
+                                   const value_idx* R_knn_inds,
+                                   const value_t* R_knn_dists,
+                                   value_int k,
+                                   value_int n_probes,
+                                   const value_idx* R_indptr,
+                                   const value_idx* R_1nn_cols,
+                                   const value_t* R_1nn_dists,
+                                   value_idx* out_inds,
+                                   value_t* out_dists,
+                                   const value_t* R_radius,
+                                   distance_func dfunc,
+                                   float weight)
+{
+  static constexpr value_int kNumWarps = tpb / WarpSize;
+
+  __shared__ value_t shared_memK[kNumWarps * warp_q];
+  __shared__ KeyValuePair<value_t, value_idx> shared_memV[kNumWarps * warp_q];
+  extern __shared__ __align__(16) std::uint8_t rbc_tiled_smem[];
+
+  const value_int row_stride = rbc_tiled_row_stride(n_cols);
+  auto* query                = reinterpret_cast<value_t*>(rbc_tiled_smem);
+  auto* tile                 = query + row_stride;
+  for (value_int j = threadIdx.x; j < n_cols; j += tpb) {
+    query[j] = X[static_cast<size_t>(n_cols) * blockIdx.x + j];
+  }
+
+  using namespace raft::neighbors::detail::faiss_select;
+  KeyValueBlockSelect<value_t, value_idx, false, Comparator<value_t>, warp_q, thread_q, tpb> heap(
+    std::numeric_limits<value_t>::max(),
+    std::numeric_limits<value_t>::max(),
+    -1,
+    shared_memK,
+    shared_memV,
+    k);
+
+  const value_int n_closest = k < n_probes ? k : n_probes;
+  const value_t min_R_dist  = R_knn_dists[blockIdx.x * n_probes + (n_closest - 1)];
+  for (value_int cur_k = 0; cur_k < n_probes; ++cur_k) {
+    const value_t cur_R_dist  = R_knn_dists[blockIdx.x * n_probes + cur_k];
+    const value_idx cur_R_ind = R_knn_inds[blockIdx.x * n_probes + cur_k];
+
+    // Equation (2) in Cayton's paper- prune out R's which are > 3 * p(q, r_q)
+    if (cur_R_dist > weight * (min_R_dist + R_radius[cur_R_ind])) continue;
+    if (cur_R_dist > 3 * min_R_dist) break;
+
+    const value_idx R_start_offset = R_indptr[cur_R_ind];
+    const value_idx R_size         = R_indptr[cur_R_ind + 1] - R_start_offset;
+    rbc_tiled_add_ball<value_idx, value_t, value_int>(heap,
+                                                      X_reordered,
+                                                      n_cols,
+                                                      row_stride,
+                                                      tile_rows,
+                                                      query,
+                                                      tile,
+                                                      R_start_offset,
+                                                      R_size,
+                                                      R_1nn_cols,
+                                                      R_1nn_dists,
+                                                      dfunc);
+  }
+
+  heap.reduce();
+
+  for (value_int i = threadIdx.x; i < k; i += tpb) {
+    out_dists[blockIdx.x * k + i] = shared_memK[i];
+    out_inds[blockIdx.x * k + i]  = shared_memV[i].value;
+  }
+}
+
+/**
+ * Second pass, any number of dimensions: mark the landmarks whose ball may hold a nearer neighbor
+ * than the ones found (see perform_post_filter_registers). The landmarks are read in tiles.
+ */
+template <typename value_idx, typename value_t, typename value_int, int tpb, typename distance_func>
+RAFT_KERNEL perform_post_filter_tiled(const value_t* X,
+                                      value_int n_cols,
+                                      value_int tile_rows,
+                                      const value_idx* R_knn_inds,
+                                      const value_t* R_knn_dists,
+                                      const value_t* R_radius,
+                                      const value_t* landmarks,
+                                      value_int n_landmarks,
+                                      value_int bitset_size,
+                                      value_int k,
+                                      distance_func dfunc,
+                                      std::uint32_t* output,
+                                      float weight)
+{
+  extern __shared__ __align__(16) std::uint8_t rbc_tiled_smem[];
+
+  // The bitset is followed by the query and the tile
+  const value_int row_stride = rbc_tiled_row_stride(n_cols);
+  const size_t bitset_bytes  = Pow2<16>::roundUp(bitset_size * sizeof(std::uint32_t));
+  auto* bitset               = reinterpret_cast<std::uint32_t*>(rbc_tiled_smem);
+  auto* query                = reinterpret_cast<value_t*>(rbc_tiled_smem + bitset_bytes);
+  auto* tile                 = query + row_stride;
+
+  for (value_int i = threadIdx.x; i < bitset_size; i += tpb) {
+    bitset[i] = 0xffffffff;
+  }
+  for (value_int j = threadIdx.x; j < n_cols; j += tpb) {
+    query[j] = X[static_cast<size_t>(n_cols) * blockIdx.x + j];
+  }
+
+  __syncthreads();
+
+  const value_t closest_R_dist = R_knn_dists[blockIdx.x * k + (k - 1)];
+
+  // zero out bits for closest k landmarks
+  for (value_int j = threadIdx.x; j < k; j += tpb) {
+    _zero_bit(bitset, (std::uint32_t)R_knn_inds[blockIdx.x * k + j]);
+  }
+
+  // Discard any landmarks where p(q, r) > p(q, r_q) + radius(r)
+  for (value_int l0 = 0; l0 < n_landmarks; l0 += tile_rows) {
+    const value_int n_rows = n_landmarks - l0 < tile_rows ? n_landmarks - l0 : tile_rows;
+    __syncthreads();
+    rbc_tiled_load_rows(
+      tile, landmarks + static_cast<size_t>(l0) * n_cols, n_rows, n_cols, row_stride);
+    __syncthreads();
+    if (threadIdx.x >= n_rows) { continue; }
+    const value_int l  = l0 + threadIdx.x;
+    const value_t dist = dfunc(query, tile + threadIdx.x * row_stride, n_cols);
+    if (dist > weight * (closest_R_dist + R_radius[l]) || dist > 3 * closest_R_dist) {
+      _zero_bit(bitset, l);
+    }
+  }
+
+  __syncthreads();
+
+  for (value_int l = threadIdx.x; l < bitset_size; l += tpb) {
+    output[blockIdx.x * bitset_size + l] = bitset[l];
+  }
+}
+
+/**
+ * Second pass, any number of dimensions: merge the points of the marked balls into the k nearest
+ * neighbors of every query (see compute_final_dists_registers).
+ */
+template <typename value_idx,
+          typename value_t,
+          int warp_q,
+          int thread_q,
+          int tpb,
+          typename value_int,
+          typename distance_func>
+RAFT_KERNEL compute_final_dists_tiled(const value_t* X_reordered,
+                                      const value_t* X,
+                                      value_int n_cols,
+                                      value_int tile_rows,
+                                      std::uint32_t* bitset,
+                                      value_int bitset_size,
+                                      const value_t* R_closest_landmark_dists,
+                                      const value_idx* R_indptr,
+                                      const value_idx* R_1nn_cols,
+                                      const value_t* R_1nn_dists,
+                                      value_idx* knn_inds,
+                                      value_t* knn_dists,
+                                      value_int n_landmarks,
+                                      value_int k,
+                                      distance_func dfunc)
+{
+  static constexpr int kNumWarps = tpb / WarpSize;
+
+  __shared__ value_t shared_memK[kNumWarps * warp_q];
+  __shared__ KeyValuePair<value_t, value_idx> shared_memV[kNumWarps * warp_q];
+  extern __shared__ __align__(16) std::uint8_t rbc_tiled_smem[];
+
+  const value_int row_stride = rbc_tiled_row_stride(n_cols);
+  auto* query                = reinterpret_cast<value_t*>(rbc_tiled_smem);
+  auto* tile                 = query + row_stride;
+  for (value_int j = threadIdx.x; j < n_cols; j += tpb) {
+    query[j] = X[static_cast<size_t>(n_cols) * blockIdx.x + j];
+  }
+
+  using namespace raft::neighbors::detail::faiss_select;
+  KeyValueBlockSelect<value_t, value_idx, false, Comparator<value_t>, warp_q, thread_q, tpb> heap(
+    std::numeric_limits<value_t>::max(),
+    std::numeric_limits<value_t>::max(),
+    -1,
+    shared_memK,
+    shared_memV,
+    k);
+
+  const value_int n_k = Pow2<WarpSize>::roundDown(k);
+  value_int i         = threadIdx.x;
+  for (; i < n_k; i += tpb) {
+    value_idx ind = knn_inds[blockIdx.x * k + i];
+    heap.add(knn_dists[blockIdx.x * k + i], R_closest_landmark_dists[ind], ind);
+  }
+
+  if (i < k) {
+    value_idx ind = knn_inds[blockIdx.x * k + i];
+    heap.addThreadQ(knn_dists[blockIdx.x * k + i], R_closest_landmark_dists[ind], ind);
+  }
+
+  heap.checkThreadQ();
+
+  for (value_int cur_R_ind = 0; cur_R_ind < n_landmarks; ++cur_R_ind) {
+    if (!_get_val(bitset + (blockIdx.x * bitset_size), cur_R_ind)) { continue; }
+    const value_idx R_start_offset = R_indptr[cur_R_ind];
+    const value_idx R_size         = R_indptr[cur_R_ind + 1] - R_start_offset;
+    rbc_tiled_add_ball<value_idx, value_t, value_int>(heap,
+                                                      X_reordered,
+                                                      n_cols,
+                                                      row_stride,
+                                                      tile_rows,
+                                                      query,
+                                                      tile,
+                                                      R_start_offset,
+                                                      R_size,
+                                                      R_1nn_cols,
+                                                      R_1nn_dists,
+                                                      dfunc);
+  }
+
+  heap.reduce();
+
+  for (value_int i = threadIdx.x; i < k; i += tpb) {
+    knn_dists[blockIdx.x * k + i] = shared_memK[i];
+    knn_inds[blockIdx.x * k + i]  = shared_memV[i].value;
+  }
+}
+
+/**
+ * The number of rows of the tiles of a kernel, and its dynamic shared memory size.
+ *
+ * The tiles have one row per thread, or fewer (a multiple of the warp size) if they do not fit in
+ * the shared memory left by the heap of the kernel.
+ */
+template <typename value_t, typename value_int, typename KernelT>
+auto rbc_tiled_smem_config(raft::resources const& handle,
+                           KernelT kernel,
+                           int tpb,
+                           value_int n_cols,
+                           size_t fixed_bytes) -> std::pair<value_int, size_t>
+{
+  cudaFuncAttributes attr;
+  RAFT_CUDA_TRY(cudaFuncGetAttributes(&attr, kernel));
+  const size_t max_smem =
+    resource::get_device_properties(handle).sharedMemPerBlockOptin - attr.sharedSizeBytes;
+  const size_t row_bytes = rbc_tiled_row_stride(n_cols) * sizeof(value_t);
+  // The tile, and the query
+  const size_t max_rows = max_smem > fixed_bytes + row_bytes
+                            ? (max_smem - fixed_bytes - row_bytes) / row_bytes
+                            : 0;
+  const auto tile_rows  = static_cast<value_int>(
+    std::min<size_t>(tpb, Pow2<WarpSize>::roundDown(max_rows)));
+  RAFT_EXPECTS(tile_rows > 0,
+               "The random ball cover does not support %zu dimensions",
+               static_cast<size_t>(n_cols));
+  const size_t smem_size = fixed_bytes + (tile_rows + 1) * row_bytes;
+  RAFT_CUDA_TRY(
+    cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smem_size));
+  return {tile_rows, smem_size};
+}
+
+template <typename value_idx,
+          typename value_t,
+          int warp_q,
+          int thread_q,
+          int tpb,
+          typename value_int,
+          typename matrix_idx,
+          typename dist_func>
+void launch_rbc_tiled_pass_one(
+  raft::resources const& handle,
+  const BallCoverIndex<value_idx, value_t, value_int, matrix_idx>& index,
+  const value_t* query,
+  value_int n_query_rows,
+  value_int k,
+  value_int n_probes,
+  const value_idx* R_knn_inds,
+  const value_t* R_knn_dists,
+  dist_func& dfunc,
+  value_idx* inds,
+  value_t* dists,
+  float weight)
+{
+  auto kernel =
+    block_rbc_kernel_tiled<value_idx, value_t, warp_q, thread_q, tpb, value_int, dist_func>;
+  const value_int n_cols      = index.n;
+  auto [tile_rows, smem_size] = rbc_tiled_smem_config<value_t>(handle, kernel, tpb, n_cols, 0);
+  kernel<<<n_query_rows, tpb, smem_size, resource::get_cuda_stream(handle)>>>(
+    index.get_X_reordered().data_handle(),
+    query,
+    n_cols,
+    tile_rows,
+    R_knn_inds,
+    R_knn_dists,
+    k,
+    n_probes,
+    index.get_R_indptr().data_handle(),
+    index.get_R_1nn_cols().data_handle(),
+    index.get_R_1nn_dists().data_handle(),
+    inds,
+    dists,
+    index.get_R_radius().data_handle(),
+    dfunc,
+    weight);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename value_idx,
+          typename value_t,
+          int warp_q,
+          int thread_q,
+          int tpb,
+          typename value_int,
+          typename matrix_idx,
+          typename dist_func>
+void launch_rbc_tiled_final_dists(
+  raft::resources const& handle,
+  const BallCoverIndex<value_idx, value_t, value_int, matrix_idx>& index,
+  const value_t* query,
+  value_int n_query_rows,
+  value_int k,
+  std::uint32_t* bitset,
+  value_int bitset_size,
+  dist_func& dfunc,
+  value_idx* inds,
+  value_t* dists)
+{
+  auto kernel =
+    compute_final_dists_tiled<value_idx, value_t, warp_q, thread_q, tpb, value_int, dist_func>;
+  const value_int n_cols      = index.n;
+  auto [tile_rows, smem_size] = rbc_tiled_smem_config<value_t>(handle, kernel, tpb, n_cols, 0);
+  kernel<<<n_query_rows, tpb, smem_size, resource::get_cuda_stream(handle)>>>(
+    index.get_X_reordered().data_handle(),
+    query,
+    n_cols,
+    tile_rows,
+    bitset,
+    bitset_size,
+    index.get_R_closest_landmark_dists().data_handle(),
+    index.get_R_indptr().data_handle(),
+    index.get_R_1nn_cols().data_handle(),
+    index.get_R_1nn_dists().data_handle(),
+    inds,
+    dists,
+    static_cast<value_int>(index.n_landmarks),
+    k,
+    dfunc);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * First pass of the search for any number of dimensions (see rbc_low_dim_pass_one).
+ */
+template <typename value_idx,
+          typename value_t,
+          typename value_int  = std::int64_t,
+          typename matrix_idx = std::int64_t,
+          typename dist_func>
+void rbc_tiled_pass_one(raft::resources const& handle,
+                        const BallCoverIndex<value_idx, value_t, value_int, matrix_idx>& index,
+                        const value_t* query,
+                        const value_int n_query_rows,
+                        value_int k,
+                        value_int n_probes,
+                        const value_idx* R_knn_inds,
+                        const value_t* R_knn_dists,
+                        dist_func& dfunc,
+                        value_idx* inds,
+                        value_t* dists,
+                        float weight)
+{
+  // The same heap configurations as the register kernels
+  if (k <= 32) {
+    launch_rbc_tiled_pass_one<value_idx, value_t, 32, 2, 128>(handle,
+                                                              index,
+                                                              query,
+                                                              n_query_rows,
+                                                              k,
+                                                              n_probes,
+                                                              R_knn_inds,
+                                                              R_knn_dists,
+                                                              dfunc,
+                                                              inds,
+                                                              dists,
+                                                              weight);
+  } else if (k <= 64) {
+    launch_rbc_tiled_pass_one<value_idx, value_t, 64, 3, 128>(handle,
+                                                              index,
+                                                              query,
+                                                              n_query_rows,
+                                                              k,
+                                                              n_probes,
+                                                              R_knn_inds,
+                                                              R_knn_dists,
+                                                              dfunc,
+                                                              inds,
+                                                              dists,
+                                                              weight);
+  } else if (k <= 128) {
+    launch_rbc_tiled_pass_one<value_idx, value_t, 128, 3, 128>(handle,
+                                                               index,
+                                                               query,
+                                                               n_query_rows,
+                                                               k,
+                                                               n_probes,
+                                                               R_knn_inds,
+                                                               R_knn_dists,
+                                                               dfunc,
+                                                               inds,
+                                                               dists,
+                                                               weight);
+  } else if (k <= 256) {
+    launch_rbc_tiled_pass_one<value_idx, value_t, 256, 4, 128>(handle,
+                                                               index,
+                                                               query,
+                                                               n_query_rows,
+                                                               k,
+                                                               n_probes,
+                                                               R_knn_inds,
+                                                               R_knn_dists,
+                                                               dfunc,
+                                                               inds,
+                                                               dists,
+                                                               weight);
+  } else if (k <= 512) {
+    launch_rbc_tiled_pass_one<value_idx, value_t, 512, 8, 64>(handle,
+                                                              index,
+                                                              query,
+                                                              n_query_rows,
+                                                              k,
+                                                              n_probes,
+                                                              R_knn_inds,
+                                                              R_knn_dists,
+                                                              dfunc,
+                                                              inds,
+                                                              dists,
+                                                              weight);
+  } else if (k <= 1024) {
+    launch_rbc_tiled_pass_one<value_idx, value_t, 1024, 8, 64>(handle,
+                                                               index,
+                                                               query,
+                                                               n_query_rows,
+                                                               k,
+                                                               n_probes,
+                                                               R_knn_inds,
+                                                               R_knn_dists,
+                                                               dfunc,
+                                                               inds,
+                                                               dists,
+                                                               weight);
+  } else {
+    RAFT_FAIL("The random ball cover supports k <= 1024");
+  }
+}
+
+/**
+ * Second pass of the search for any number of dimensions (see rbc_low_dim_pass_two).
+ */
+template <typename value_idx,
+          typename value_t,
+          typename value_int  = std::int64_t,
+          typename matrix_idx = std::int64_t,
+          typename dist_func>
+void rbc_tiled_pass_two(raft::resources const& handle,
+                        const BallCoverIndex<value_idx, value_t, value_int, matrix_idx>& index,
+                        const value_t* query,
+                        const value_int n_query_rows,
+                        value_int k,
+                        const value_idx* R_knn_inds,
+                        const value_t* R_knn_dists,
+                        dist_func& dfunc,
+                        value_idx* inds,
+                        value_t* dists,
+                        float weight)
+{
+  constexpr int kPostFilterTpb = 128;
+  const auto n_landmarks       = static_cast<value_int>(index.n_landmarks);
+  const value_int bitset_size  = raft::ceildiv<value_int>(n_landmarks, 32);
+
+  rmm::device_uvector<std::uint32_t> bitset(bitset_size * n_query_rows,
+                                            resource::get_cuda_stream(handle));
+  thrust::fill(
+    resource::get_thrust_policy(handle), bitset.data(), bitset.data() + bitset.size(), 0);
+
+  auto filter_kernel =
+    perform_post_filter_tiled<value_idx, value_t, value_int, kPostFilterTpb, dist_func>;
+  auto [tile_rows, smem_size] =
+    rbc_tiled_smem_config<value_t>(handle,
+                                   filter_kernel,
+                                   kPostFilterTpb,
+                                   static_cast<value_int>(index.n),
+                                   Pow2<16>::roundUp(bitset_size * sizeof(std::uint32_t)));
+  filter_kernel<<<n_query_rows, kPostFilterTpb, smem_size, resource::get_cuda_stream(handle)>>>(
+    query,
+    static_cast<value_int>(index.n),
+    tile_rows,
+    R_knn_inds,
+    R_knn_dists,
+    index.get_R_radius().data_handle(),
+    index.get_R().data_handle(),
+    n_landmarks,
+    bitset_size,
+    k,
+    dfunc,
+    bitset.data(),
+    weight);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  if (k <= 32) {
+    launch_rbc_tiled_final_dists<value_idx, value_t, 32, 2, 128>(
+      handle, index, query, n_query_rows, k, bitset.data(), bitset_size, dfunc, inds, dists);
+  } else if (k <= 64) {
+    launch_rbc_tiled_final_dists<value_idx, value_t, 64, 3, 128>(
+      handle, index, query, n_query_rows, k, bitset.data(), bitset_size, dfunc, inds, dists);
+  } else if (k <= 128) {
+    launch_rbc_tiled_final_dists<value_idx, value_t, 128, 3, 128>(
+      handle, index, query, n_query_rows, k, bitset.data(), bitset_size, dfunc, inds, dists);
+  } else if (k <= 256) {
+    launch_rbc_tiled_final_dists<value_idx, value_t, 256, 4, 128>(
+      handle, index, query, n_query_rows, k, bitset.data(), bitset_size, dfunc, inds, dists);
+  } else if (k <= 512) {
+    launch_rbc_tiled_final_dists<value_idx, value_t, 512, 8, 64>(
+      handle, index, query, n_query_rows, k, bitset.data(), bitset_size, dfunc, inds, dists);
+  } else if (k <= 1024) {
+    launch_rbc_tiled_final_dists<value_idx, value_t, 1024, 8, 64>(
+      handle, index, query, n_query_rows, k, bitset.data(), bitset_size, dfunc, inds, dists);
+  } else {
+    RAFT_FAIL("The random ball cover supports k <= 1024");
+  }
+}
+
+};  // namespace detail
+};  // namespace knn
+};  // namespace spatial
+};  // namespace raft
@@ -15,6 +15,7 @@
  */
 #pragma once
 #include <raft/linalg/norm.cuh>
+#include <raft/linalg/unary_op.cuh>
 #include <raft/neighbors/detail/faiss_select/Select.cuh>
 
 #include <cub/cub.cuh>
@@ -23,8 +24,10 @@
 // TODO: Need to hide the PairwiseDistance class impl and expose to public API
 #include "processing.cuh"
 
+#include <raft/core/error.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/distance/detail/distance.cuh>
+#include <raft/distance/detail/distance_ops/cosine.cuh>
 #include <raft/distance/detail/distance_ops/l2_exp.cuh>
 #include <raft/distance/detail/distance_ops/l2_unexp.cuh>
 #include <raft/distance/detail/pairwise_distance_base.cuh>
@@ -517,28 +520,76 @@ __launch_bounds__(Policy::Nthreads, 2) RAFT_KERNEL fusedL2kNN(const DataT* x,
   obj.run();
 }
 
+/**
+ * @brief The inner product, negated so that the most similar rows are the ones kept by the
+ * (min-selecting) warp queues of the fused kNN kernel.
+ */
+template <typename DataType, typename AccType, typename IdxType>
+struct neg_inner_product_distance_op {
+  using DataT = DataType;
+  using AccT  = AccType;
+  using IdxT  = IdxType;
+
+  static constexpr bool use_norms            = false;
+  static constexpr bool expensive_inner_loop = false;
+
+  template <typename Policy>
+  static constexpr size_t shared_mem_size()
+  {
+    return Policy::SmemSize;
+  }
+
+  DI void core(AccT& acc, DataT& x, DataT& y) const { acc += x * y; };
+
+  template <typename Policy>
+  DI void epilog(AccT acc[Policy::AccRowsPerTh][Policy::AccColsPerTh],
+                 DataT* regxn,
+                 DataT* regyn,
+                 IdxT gridStrideX,
+                 IdxT gridStrideY) const
+  {
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+#pragma unroll
+      for (int j = 0; j < Policy::AccColsPerTh; ++j) {
+        acc[i][j] = -acc[i][j];
+      }
+    }
+  };
+};
+
+/**
+ * Launch the fused kNN kernel with the given distance op. The norms `xn` and `yn` are only read if
+ * the op uses them. The distances of the op are selected by their min.
+ *
+ * The kernel needs a workspace for the mutexes if the grid has more than one column of blocks; in
+ * that case, if `worksize` is too small, it is set to the required size and nothing is launched.
+ */
 template <typename DataT,
           typename AccT,
           typename OutT,
           typename IdxT,
           int VecLen,
           bool usePrevTopKs,
-          bool isRowMajor>
-void fusedL2UnexpKnnImpl(const DataT* x,
-                         const DataT* y,
-                         IdxT m,
-                         IdxT n,
-                         IdxT k,
-                         IdxT lda,
-                         IdxT ldb,
-                         IdxT ldd,
-                         bool sqrt,
-                         OutT* out_dists,
-                         IdxT* out_inds,
-                         IdxT numOfNN,
-                         cudaStream_t stream,
-                         void* workspace,
-                         size_t& worksize)
+          bool isRowMajor,
+          typename OpT>
+void fusedDistanceKnnImpl(const DataT* x,
+                          const DataT* y,
+                          const DataT* xn,
+                          const DataT* yn,
+                          IdxT m,
+                          IdxT n,
+                          IdxT k,
+                          IdxT lda,
+                          IdxT ldb,
+                          IdxT ldd,
+                          OpT distance_op,
+                          OutT* out_dists,
+                          IdxT* out_inds,
+                          IdxT numOfNN,
+                          cudaStream_t stream,
+                          void* workspace,
+                          size_t& worksize)
 {
   typedef typename raft::linalg::Policy2x8<DataT, 1>::Policy RowPolicy;
   typedef typename raft::linalg::Policy4x4<DataT, VecLen>::ColPolicy ColPolicy;
@@ -551,36 +602,35 @@ void fusedL2UnexpKnnImpl(const DataT* x,
   // Accumulation operation lambda
   typedef cub::KeyValuePair<uint32_t, AccT> Pair;
 
-  raft::distance::detail::ops::l2_unexp_distance_op<DataT, AccT, IdxT> distance_op{sqrt};
   raft::identity_op fin_op{};
 
   if constexpr (isRowMajor) {
-    constexpr auto fusedL2UnexpKnn32RowMajor = fusedL2kNN<DataT,
-                                                          OutT,
-                                                          IdxT,
-                                                          KPolicy,
-                                                          decltype(distance_op),
-                                                          decltype(fin_op),
-                                                          32,
-                                                          2,
-                                                          usePrevTopKs,
-                                                          isRowMajor>;
-    constexpr auto fusedL2UnexpKnn64RowMajor = fusedL2kNN<DataT,
-                                                          OutT,
-                                                          IdxT,
-                                                          KPolicy,
-                                                          decltype(distance_op),
-                                                          decltype(fin_op),
-                                                          64,
-                                                          3,
-                                                          usePrevTopKs,
-                                                          isRowMajor>;
-
-    auto fusedL2UnexpKnnRowMajor = fusedL2UnexpKnn32RowMajor;
+    constexpr auto fusedKnn32RowMajor = fusedL2kNN<DataT,
+                                                   OutT,
+                                                   IdxT,
+                                                   KPolicy,
+                                                   OpT,
+                                                   decltype(fin_op),
+                                                   32,
+                                                   2,
+                                                   usePrevTopKs,
+                                                   isRowMajor>;
+    constexpr auto fusedKnn64RowMajor = fusedL2kNN<DataT,
+                                                   OutT,
+                                                   IdxT,
+                                                   KPolicy,
+                                                   OpT,
+                                                   decltype(fin_op),
+                                                   64,
+                                                   3,
+                                                   usePrevTopKs,
+                                                   isRowMajor>;
+
+    auto fusedKnnRowMajor = fusedKnn32RowMajor;
     if (numOfNN <= 32) {
-      fusedL2UnexpKnnRowMajor = fusedL2UnexpKnn32RowMajor;
+      fusedKnnRowMajor = fusedKnn32RowMajor;
     } else if (numOfNN <= 64) {
-      fusedL2UnexpKnnRowMajor = fusedL2UnexpKnn64RowMajor;
+      fusedKnnRowMajor = fusedKnn64RowMajor;
     } else {
       ASSERT(numOfNN <= 64, "fusedL2kNN: num of nearest neighbors must be <= 64");
     }
@@ -588,8 +638,8 @@ void fusedL2UnexpKnnImpl(const DataT* x,
     const auto sharedMemSize =
       distance_op.template shared_mem_size<KPolicy>() + KPolicy::Mblk * numOfNN * sizeof(Pair);
 
-    dim3 grid = raft::distance::detail::launchConfigGenerator<KPolicy>(
-      m, n, sharedMemSize, fusedL2UnexpKnnRowMajor);
+    dim3 grid =
+      raft::distance::detail::launchConfigGenerator<KPolicy>(m, n, sharedMemSize, fusedKnnRowMajor);
 
     if (grid.x > 1) {
       const auto numMutexes = raft::ceildiv<int>(m, KPolicy::Mblk);
@@ -601,22 +651,22 @@ void fusedL2UnexpKnnImpl(const DataT* x,
       }
     }
 
-    fusedL2UnexpKnnRowMajor<<<grid, blk, sharedMemSize, stream>>>(x,
-                                                                  y,
-                                                                  nullptr,
-                                                                  nullptr,
-                                                                  m,
-                                                                  n,
-                                                                  k,
-                                                                  lda,
-                                                                  ldb,
-                                                                  ldd,
-                                                                  distance_op,
-                                                                  fin_op,
-                                                                  (uint32_t)numOfNN,
-                                                                  (int*)workspace,
-                                                                  out_dists,
-                                                                  out_inds);
+    fusedKnnRowMajor<<<grid, blk, sharedMemSize, stream>>>(x,
+                                                           y,
+                                                           xn,
+                                                           yn,
+                                                           m,
+                                                           n,
+                                                           k,
+                                                           lda,
+                                                           ldb,
+                                                           ldd,
+                                                           distance_op,
+                                                           fin_op,
+                                                           (uint32_t)numOfNN,
+                                                           (int*)workspace,
+                                                           out_dists,
+                                                           out_inds);
   } else {
   }
 
@@ -628,36 +678,41 @@ template <typename DataT,
           typename OutT,
           typename IdxT,
           bool usePrevTopKs,
-          bool isRowMajor>
-void fusedL2UnexpKnn(IdxT m,
-                     IdxT n,
-                     IdxT k,
-                     IdxT lda,
-                     IdxT ldb,
-                     IdxT ldd,
-                     const DataT* x,
-                     const DataT* y,
-                     bool sqrt,
-                     OutT* out_dists,
-                     IdxT* out_inds,
-                     IdxT numOfNN,
-                     cudaStream_t stream,
-                     void* workspace,
-                     size_t& worksize)
+          bool isRowMajor,
+          typename OpT>
+void fusedDistanceKnn(IdxT m,
+                      IdxT n,
+                      IdxT k,
+                      IdxT lda,
+                      IdxT ldb,
+                      IdxT ldd,
+                      const DataT* x,
+                      const DataT* y,
+                      const DataT* xn,
+                      const DataT* yn,
+                      OpT distance_op,
+                      OutT* out_dists,
+                      IdxT* out_inds,
+                      IdxT numOfNN,
+                      cudaStream_t stream,
+                      void* workspace,
+                      size_t& worksize)
 {
   size_t bytesA = sizeof(DataT) * lda;
   size_t bytesB = sizeof(DataT) * ldb;
   if (16 % sizeof(DataT) == 0 && bytesA % 16 == 0 && bytesB % 16 == 0) {
-    fusedL2UnexpKnnImpl<DataT, AccT, OutT, IdxT, 16 / sizeof(DataT), usePrevTopKs, isRowMajor>(
+    fusedDistanceKnnImpl<DataT, AccT, OutT, IdxT, 16 / sizeof(DataT), usePrevTopKs, isRowMajor>(
       x,
       y,
+      xn,
+      yn,
       m,
       n,
       k,
       lda,
       ldb,
       ldd,
-      sqrt,
+      distance_op,
       out_dists,
       out_inds,
       numOfNN,
@@ -665,16 +720,18 @@ void fusedL2UnexpKnn(IdxT m,
       workspace,
       worksize);
   } else if (8 % sizeof(DataT) == 0 && bytesA % 8 == 0 && bytesB % 8 == 0) {
-    fusedL2UnexpKnnImpl<DataT, AccT, OutT, IdxT, 8 / sizeof(DataT), usePrevTopKs, isRowMajor>(
+    fusedDistanceKnnImpl<DataT, AccT, OutT, IdxT, 8 / sizeof(DataT), usePrevTopKs, isRowMajor>(
       x,
       y,
+      xn,
+      yn,
       m,
       n,
       k,
       lda,
       ldb,
       ldd,
-      sqrt,
+      distance_op,
       out_dists,
       out_inds,
       numOfNN,
@@ -682,24 +739,68 @@ void fusedL2UnexpKnn(IdxT m,
       workspace,
       worksize);
   } else {
-    fusedL2UnexpKnnImpl<DataT, AccT, OutT, IdxT, 1, usePrevTopKs, isRowMajor>(x,
-                                                                              y,
-                                                                              m,
-                                                                              n,
-                                                                              k,
-                                                                              lda,
-                                                                              ldb,
-                                                                              ldd,
-                                                                              sqrt,
-                                                                              out_dists,
-                                                                              out_inds,
-                                                                              numOfNN,
-                                                                              stream,
-                                                                              workspace,
-                                                                              worksize);
+    fusedDistanceKnnImpl<DataT, AccT, OutT, IdxT, 1, usePrevTopKs, isRowMajor>(x,
+                                                                               y,
+                                                                               xn,
+                                                                               yn,
+                                                                               m,
+                                                                               n,
+                                                                               k,
+                                                                               lda,
+                                                                               ldb,
+                                                                               ldd,
+                                                                               distance_op,
+                                                                               out_dists,
+                                                                               out_inds,
+                                                                               numOfNN,
+                                                                               stream,
+                                                                               workspace,
+                                                                               worksize);
   }
 }
 
+template <typename DataT,
+          typename AccT,
+          typename OutT,
+          typename IdxT,
+          bool usePrevTopKs,
+          bool isRowMajor>
+void fusedL2UnexpKnn(IdxT m,
+                     IdxT n,
+                     IdxT k,
+                     IdxT lda,
+                     IdxT ldb,
+                     IdxT ldd,
+                     const DataT* x,
+                     const DataT* y,
+                     bool sqrt,
+                     OutT* out_dists,
+                     IdxT* out_inds,
+                     IdxT numOfNN,
+                     cudaStream_t stream,
+                     void* workspace,
+                     size_t& worksize)
+{
+  raft::distance::detail::ops::l2_unexp_distance_op<DataT, AccT, IdxT> distance_op{sqrt};
+  fusedDistanceKnn<DataT, AccT, OutT, IdxT, usePrevTopKs, isRowMajor>(m,
+                                                                      n,
+                                                                      k,
+                                                                      lda,
+                                                                      ldb,
+                                                                      ldd,
+                                                                      x,
+                                                                      y,
+                                                                      nullptr,
+                                                                      nullptr,
+                                                                      distance_op,
+                                                                      out_dists,
+                                                                      out_inds,
+                                                                      numOfNN,
+                                                                      stream,
+                                                                      workspace,
+                                                                      worksize);
+}
+
 template <typename DataT,
           typename AccT,
           typename OutT,
@@ -919,7 +1020,11 @@ void fusedL2ExpKnn(IdxT m,
 }
 
 /**
- * Compute the k-nearest neighbors using L2 expanded/unexpanded distance.
+ * Compute the k-nearest neighbors using L2 expanded/unexpanded, inner product or cosine distance.
+ *
+ * The distances are computed tile by tile, and the top-k are kept in the warp queues of the kernel
+ * (k <= 64); the distance matrix is never written to the global memory. For the cosine distance,
+ * the norms (if given) are the L2 norms of the rows; for the L2 expanded distance, their squares.
 
  * @tparam value_idx
  * @tparam value_t
@@ -1059,7 +1164,92 @@ void fusedL2Knn(size_t D,
                                                                                   worksize);
       }
       break;
-    default: printf("only L2 distance metric is supported\n"); break;
+    case raft::distance::DistanceType::InnerProduct:
+    case raft::distance::DistanceType::CosineExpanded: {
+      // The cosine distance needs the L2 norms of the rows (not squared)
+      const bool cosine = metric == raft::distance::DistanceType::CosineExpanded;
+      rmm::device_uvector<value_t> norms(
+        cosine ? (query_norms ? 0 : n_query_rows) + (index_norms ? 0 : n_index_rows) : 0, stream);
+      if (cosine && !query_norms) {
+        raft::linalg::rowNorm(norms.data(),
+                              query,
+                              D,
+                              n_query_rows,
+                              raft::linalg::L2Norm,
+                              true,
+                              stream,
+                              raft::sqrt_op{});
+        query_norms = norms.data();
+      }
+      if (cosine && !index_norms) {
+        value_t* index_norms_ = norms.data() + (norms.size() - n_index_rows);
+        raft::linalg::rowNorm(index_norms_,
+                              index,
+                              D,
+                              n_index_rows,
+                              raft::linalg::L2Norm,
+                              true,
+                              stream,
+                              raft::sqrt_op{});
+        index_norms = index_norms_;
+      }
+      // The inner products are negated in the kernel, so that the warp queues keep the largest.
+      auto negate = [=](value_t* dists) {
+        raft::linalg::unaryOp(
+          dists, dists, n_query_rows * k, raft::mul_const_op<value_t>(value_t(-1)), stream);
+      };
+      if (!cosine && usePrevTopKs) { negate(out_dists); }
+      auto run = [&]() {
+        if (cosine) {
+          raft::distance::detail::ops::cosine_distance_op<value_t, value_t, value_idx> op{};
+          fusedDistanceKnn<value_t, value_t, value_t, value_idx, usePrevTopKs, true>(
+            n_query_rows,
+            n_index_rows,
+            D,
+            lda,
+            ldb,
+            ldd,
+            query,
+            index,
+            query_norms,
+            index_norms,
+            op,
+            out_dists,
+            out_inds,
+            k,
+            stream,
+            workspace.data(),
+            worksize);
+        } else {
+          neg_inner_product_distance_op<value_t, value_t, value_idx> op{};
+          fusedDistanceKnn<value_t, value_t, value_t, value_idx, usePrevTopKs, true>(
+            n_query_rows,
+            n_index_rows,
+            D,
+            lda,
+            ldb,
+            ldd,
+            query,
+            index,
+            nullptr,
+            nullptr,
+            op,
+            out_dists,
+            out_inds,
+            k,
+            stream,
+            workspace.data(),
+            worksize);
+        }
+      };
+      run();
+      if (worksize) {
+        workspace.resize(worksize, stream);
+        run();
+      }
+      if (!cosine) { negate(out_dists); }
+    } break;
+    default: RAFT_FAIL("only L2, inner product and cosine distance metrics are supported");
   };
 }
 
@@ -20,8 +20,12 @@
 #include <raft/core/resource/cusparse_handle.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
 #include <raft/linalg/detail/cublas_wrappers.hpp>
 #include <raft/sparse/detail/cusparse_wrappers.h>
+#include <raft/sparse/linalg/sparse_operator.hpp>
+#include <raft/sparse/linalg/spmm.hpp>
 #include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_uvector.hpp>
@@ -33,6 +37,7 @@
 #include <thrust/system/cuda/execution_policy.h>
 
 #include <algorithm>
+#include <memory>
 
 // =========================================================
 // Useful macros
@@ -64,6 +69,24 @@ RAFT_KERNEL diagmv(IndexType_ n,
   }
 }
 
+// Apply diagonal matrix to the n_vecs columns of a column-major matrix:
+//
+template <typename IndexType_, typename ValueType_>
+RAFT_KERNEL diagmm(IndexType_ n,
+                   IndexType_ n_vecs,
+                   ValueType_ alpha,
+                   const ValueType_* __restrict__ D,
+                   const ValueType_* __restrict__ x,
+                   ValueType_* __restrict__ y)
+{
+  size_t size = size_t(n) * n_vecs;
+  size_t i    = threadIdx.x + size_t(blockIdx.x) * blockDim.x;
+  while (i < size) {
+    y[i] += alpha * D[i % n] * x[i];
+    i += size_t(blockDim.x) * gridDim.x;
+  }
+}
+
 // specifies type of algorithm used
 // for SpMv:
 //
@@ -202,65 +225,21 @@ struct sparse_matrix_t {
     RAFT_EXPECTS(x != nullptr, "Null x buffer.");
     RAFT_EXPECTS(y != nullptr, "Null y buffer.");
 
-    auto cusparse_h = resource::get_cusparse_handle(handle_);
-    auto stream     = resource::get_cuda_stream(handle_);
-
-    cusparseOperation_t trans = transpose ? CUSPARSE_OPERATION_TRANSPOSE :  // transpose
-                                  CUSPARSE_OPERATION_NON_TRANSPOSE;         // non-transpose
-
 #if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
     auto size_x = transpose ? nrows_ : ncols_;
     auto size_y = transpose ? ncols_ : nrows_;
 
-    cusparseSpMVAlg_t spmv_alg = translate_algorithm(alg);
-
-    // create descriptors:
-    //(below casts are necessary, because
-    // cusparseCreateCsr(...) takes non-const
-    // void*; the casts should be harmless)
-    //
-    cusparseSpMatDescr_t matA;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatecsr(&matA,
-                                                              nrows_,
-                                                              ncols_,
-                                                              nnz_,
-                                                              const_cast<index_type*>(row_offsets_),
-                                                              const_cast<index_type*>(col_indices_),
-                                                              const_cast<value_type*>(values_)));
-
-    cusparseDnVecDescr_t vecX;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatednvec(&vecX, size_x, x));
-
-    rmm::device_uvector<value_type> y_tmp(size_y, stream);
-    raft::copy(y_tmp.data(), y, size_y, stream);
-
-    cusparseDnVecDescr_t vecY;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatednvec(&vecY, size_y, y_tmp.data()));
-
-    // get (scratch) external device buffer size:
-    //
-    size_t bufferSize;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv_buffersize(
-      cusparse_h, trans, &alpha, matA, vecX, &beta, vecY, spmv_alg, &bufferSize, stream));
-
-    // allocate external buffer:
-    //
-    vector_t<value_type> external_buffer(handle_, bufferSize);
+    // the descriptors and the buffer are created by the first product and reused by the next ones
+    auto x_view = raft::make_device_vector_view<const value_type, index_type>(x, size_x);
+    auto y_view = raft::make_device_vector_view<value_type, index_type>(y, size_y);
+    get_operator().spmv(transpose, &alpha, x_view, &beta, y_view, translate_algorithm(alg));
+#else
+    auto cusparse_h = resource::get_cusparse_handle(handle_);
+    auto stream     = resource::get_cuda_stream(handle_);
 
-    // finally perform SpMV:
-    //
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv(
-      cusparse_h, trans, &alpha, matA, vecX, &beta, vecY, spmv_alg, external_buffer.raw(), stream));
+    cusparseOperation_t trans = transpose ? CUSPARSE_OPERATION_TRANSPOSE :  // transpose
+                                  CUSPARSE_OPERATION_NON_TRANSPOSE;         // non-transpose
 
-    // FIXME: This is a workaround for a cusparse issue being encountered in CUDA 12
-    raft::copy(y, y_tmp.data(), size_y, stream);
-    // free descriptors:
-    //(TODO: maybe wrap them in a RAII struct?)
-    //
-    RAFT_CUSPARSE_TRY(cusparseDestroyDnVec(vecY));
-    RAFT_CUSPARSE_TRY(cusparseDestroyDnVec(vecX));
-    RAFT_CUSPARSE_TRY(cusparseDestroySpMat(matA));
-#else
     RAFT_CUSPARSE_TRY(
       raft::sparse::detail::cusparsesetpointermode(cusparse_h, CUSPARSE_POINTER_MODE_HOST, stream));
     cusparseMatDescr_t descr = 0;
@@ -289,8 +268,48 @@ struct sparse_matrix_t {
 #endif
   }
 
+  // Y = alpha*A*X + beta*Y, with the n_vecs columns of X and Y stored as column-major matrices
+  // (with SpMM, i.e. one sparse product for all the columns)
+  //
+  virtual void mm(value_type alpha,
+                  value_type const* __restrict__ x,
+                  value_type beta,
+                  value_type* __restrict__ y,
+                  index_type n_vecs) const
+  {
+    RAFT_EXPECTS(x != nullptr, "Null x buffer.");
+    RAFT_EXPECTS(y != nullptr, "Null y buffer.");
+
+    auto x_view = raft::make_device_matrix_view<const value_type, index_type, col_major>(
+      x, ncols_, n_vecs);
+    auto y_view =
+      raft::make_device_matrix_view<value_type, index_type, col_major>(y, nrows_, n_vecs);
+    get_operator().spmm(false, false, &alpha, x_view, &beta, y_view);
+  }
+
   resources const& get_handle(void) const { return handle_; }
 
+  // The cuSparse descriptors and buffers of the products, created on the first product and shared
+  // by the copies of the matrix, which refer to the same arrays
+  //
+  raft::sparse::linalg::sparse_operator<value_type, index_type, index_type>& get_operator(
+    void) const
+  {
+    if (!operator_) {
+      auto structure =
+        raft::make_device_compressed_structure_view<index_type, index_type, index_type>(
+          const_cast<index_type*>(row_offsets_),
+          const_cast<index_type*>(col_indices_),
+          nrows_,
+          ncols_,
+          nnz_);
+      auto csr  = raft::make_device_csr_matrix_view<const value_type>(values_, structure);
+      operator_ = std::make_shared<
+        raft::sparse::linalg::sparse_operator<value_type, index_type, index_type>>(handle_, csr);
+    }
+    return *operator_;
+  }
+
 #if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
   cusparseSpMVAlg_t translate_algorithm(sparse_mv_alg_t alg) const
   {
@@ -312,6 +331,9 @@ struct sparse_matrix_t {
   index_type const nrows_;
   index_type const ncols_;
   index_type const nnz_;
+
+  mutable std::shared_ptr<raft::sparse::linalg::sparse_operator<value_type, index_type, index_type>>
+    operator_;
 };
 
 template <typename index_type, typename value_type>
@@ -385,6 +407,43 @@ struct laplacian_matrix_t : sparse_matrix_t<index_type, value_type> {
     sparse_matrix_t<index_type, value_type>::mv(-alpha, x, 1, y, alg, transpose, symmetric);
   }
 
+  // Y = alpha*A*X + beta*Y
+  //
+  void mm(value_type alpha,
+          value_type const* __restrict__ x,
+          value_type beta,
+          value_type* __restrict__ y,
+          index_type n_vecs) const override
+  {
+    constexpr int BLOCK_SIZE = 1024;
+    auto n                   = sparse_matrix_t<index_type, value_type>::nrows_;
+
+    auto handle   = sparse_matrix_t<index_type, value_type>::get_handle();
+    auto cublas_h = resource::get_cublas_handle(handle);
+    auto stream   = resource::get_cuda_stream(handle);
+
+    // scales Y by beta:
+    //
+    if (beta == 0) {
+      RAFT_CUDA_TRY(cudaMemsetAsync(y, 0, size_t(n) * n_vecs * sizeof(value_type), stream));
+    } else if (beta != 1) {
+      RAFT_CUBLAS_TRY(raft::linalg::detail::cublasscal(cublas_h, n * n_vecs, &beta, y, 1, stream));
+    }
+
+    // Apply diagonal matrix
+    //
+    dim3 gridDim{
+      std::min<unsigned int>((size_t(n) * n_vecs + BLOCK_SIZE - 1) / BLOCK_SIZE, 65535), 1, 1};
+
+    dim3 blockDim{BLOCK_SIZE, 1, 1};
+    diagmm<<<gridDim, blockDim, 0, stream>>>(n, n_vecs, alpha, diagonal_.raw(), x, y);
+    RAFT_CHECK_CUDA(stream);
+
+    // Apply adjacency matrix
+    //
+    sparse_matrix_t<index_type, value_type>::mm(-alpha, x, 1, y, n_vecs);
+  }
+
   vector_t<value_type> diagonal_;
 };
 
@@ -459,6 +518,40 @@ struct modularity_matrix_t : laplacian_matrix_t<index_type, value_type> {
                                        stream));
   }
 
+  // Y = alpha*B*X + beta*Y, with B = A - d*d'/edge_sum the modularity matrix
+  //
+  void mm(value_type alpha,
+          value_type const* __restrict__ x,
+          value_type beta,
+          value_type* __restrict__ y,
+          index_type n_vecs) const override
+  {
+    auto n = sparse_matrix_t<index_type, value_type>::nrows_;
+
+    auto handle   = sparse_matrix_t<index_type, value_type>::get_handle();
+    auto cublas_h = resource::get_cublas_handle(handle);
+    auto stream   = resource::get_cuda_stream(handle);
+    auto diagonal = laplacian_matrix_t<index_type, value_type>::diagonal_.raw();
+
+    // Y = alpha*A*X + beta*Y
+    //
+    sparse_matrix_t<index_type, value_type>::mm(alpha, x, beta, y, n_vecs);
+
+    // gamma = X'*d
+    //
+    vector_t<value_type> gamma{handle, n_vecs};
+    value_type one  = 1;
+    value_type zero = 0;
+    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemv(
+      cublas_h, CUBLAS_OP_T, n, n_vecs, &one, x, n, diagonal, 1, &zero, gamma.raw(), 1, stream));
+
+    // Y = Y - (alpha/edge_sum)*d*gamma'
+    //
+    value_type scale = -alpha / edge_sum_;
+    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasger(
+      cublas_h, n, n_vecs, &scale, diagonal, 1, gamma.raw(), 1, y, n, stream));
+  }
+
   value_type edge_sum_;
 };
 
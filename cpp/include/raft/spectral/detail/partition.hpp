@@ -22,6 +22,7 @@
 #include <raft/spectral/detail/spectral_util.cuh>
 #include <raft/spectral/eigen_solvers.cuh>
 #include <raft/spectral/matrix_wrappers.hpp>
+#include <raft/util/cudart_utils.hpp>
 
 #include <cuda.h>
 #include <thrust/fill.h>
@@ -32,6 +33,7 @@
 #include <stdio.h>
 
 #include <tuple>
+#include <vector>
 
 namespace raft {
 namespace spectral {
@@ -142,41 +144,34 @@ void analyzePartition(raft::resources const& handle,
 {
   RAFT_EXPECTS(clusters != nullptr, "Null clusters buffer.");
 
-  vertex_t i;
-  vertex_t n = csr_m.nrows_;
-
-  auto stream   = resource::get_cuda_stream(handle);
-  auto cublas_h = resource::get_cublas_handle(handle);
-
-  weight_t partEdgesCut, clustersize;
+  vertex_t n  = csr_m.nrows_;
+  auto stream = resource::get_cuda_stream(handle);
 
-  // Device memory
-  spectral::matrix::vector_t<weight_t> part_i(handle, n);
-  spectral::matrix::vector_t<weight_t> Lx(handle, n);
+  // The weight of the edges leaving every partition (i.e. x^T L x for its indicator vector x) and
+  // the size of every partition, accumulated on the device in a single pass over the graph.
+  spectral::matrix::vector_t<weight_t> part_cuts(handle, nClusters);
+  spectral::matrix::vector_t<weight_t> part_sizes(handle, nClusters);
+  compute_partition_cuts(handle, csr_m, nClusters, clusters, part_cuts, part_sizes);
 
-  // Initialize cuBLAS
-  RAFT_CUBLAS_TRY(
-    raft::linalg::detail::cublassetpointermode(cublas_h, CUBLAS_POINTER_MODE_HOST, stream));
-
-  // Initialize Laplacian
-  /// sparse_matrix_t<vertex_t, weight_t> A{handle, graph};
-  spectral::matrix::laplacian_matrix_t<vertex_t, weight_t> L{handle, csr_m};
+  std::vector<weight_t> h_cuts(nClusters), h_sizes(nClusters);
+  raft::update_host(h_cuts.data(), part_cuts.raw(), nClusters, stream);
+  raft::update_host(h_sizes.data(), part_sizes.raw(), nClusters, stream);
+  resource::sync_stream(handle, stream);
 
   // Initialize output
   cost    = 0;
   edgeCut = 0;
 
   // Iterate through partitions
-  for (i = 0; i < nClusters; ++i) {
-    // Construct indicator vector for ith partition
-    if (!construct_indicator(handle, i, n, clustersize, partEdgesCut, clusters, part_i, Lx, L)) {
+  for (vertex_t i = 0; i < nClusters; ++i) {
+    if (h_sizes[i] < 0.5) {
       WARNING("empty partition");
       continue;
     }
 
     // Record results
-    cost += partEdgesCut / clustersize;
-    edgeCut += partEdgesCut / 2;
+    cost += h_cuts[i] / h_sizes[i];
+    edgeCut += h_cuts[i] / 2;
   }
 }
 
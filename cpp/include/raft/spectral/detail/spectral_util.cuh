@@ -16,13 +16,18 @@
 
 #pragma once
 
+#include <raft/core/detail/macros.hpp>
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/linalg/detail/cublas_wrappers.hpp>
+#include <raft/linalg/map.cuh>
 #include <raft/spectral/matrix_wrappers.hpp>
+#include <raft/stats/mean.cuh>
+#include <raft/stats/stddev.cuh>
 #include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
 
 #include <thrust/device_ptr.h>
 #include <thrust/fill.h>
@@ -39,78 +44,109 @@
 namespace raft {
 namespace spectral {
 
+/// Functor whitening and transposing the eigenvector matrix
+/** For use in raft::linalg::map_offset over the output, row-major n x nEigVecs
+ */
+template <typename index_type_t, typename value_type_t>
+struct whiten_transpose_op {
+  const value_type_t* eigVecs;
+  const value_type_t* mean;
+  const value_type_t* std;
+  index_type_t n;
+  index_type_t nEigVecs;
+
+  __device__ value_type_t operator()(index_type_t idx) const
+  {
+    auto i = idx / nEigVecs;
+    auto j = idx % nEigVecs;
+    return (eigVecs[IDX(i, j, n)] - mean[j]) / std[j];
+  }
+};
+
+/// Whiten the eigenvector matrix and transpose it in place
+/** The columns of the column-major n x nEigVecs matrix are centered and scaled to a unit
+ *  (population) standard deviation, and the result is stored in row-major order, as expected by the
+ *  cluster solvers. All the steps are stream-ordered: the column statistics stay on the device.
+ */
 template <typename vertex_t, typename edge_t, typename weight_t>
 void transform_eigen_matrix(raft::resources const& handle,
                             edge_t n,
                             vertex_t nEigVecs,
                             weight_t* eigVecs)
 {
-  auto stream             = resource::get_cuda_stream(handle);
-  auto cublas_h           = resource::get_cublas_handle(handle);
-  auto thrust_exec_policy = resource::get_thrust_policy(handle);
+  auto stream = resource::get_cuda_stream(handle);
+  auto d      = static_cast<edge_t>(nEigVecs);
 
-  const weight_t zero{0.0};
-  const weight_t one{1.0};
-
-  // Whiten eigenvector matrix
-  for (auto i = 0; i < nEigVecs; ++i) {
-    weight_t mean, std;
-
-    mean = thrust::reduce(thrust_exec_policy,
-                          thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                          thrust::device_pointer_cast(eigVecs + IDX(0, i + 1, n)));
-    RAFT_CHECK_CUDA(stream);
-    mean /= n;
-    thrust::transform(thrust_exec_policy,
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i + 1, n)),
-                      thrust::make_constant_iterator(mean),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::minus<weight_t>());
-    RAFT_CHECK_CUDA(stream);
-
-    // TODO: Call from public API when ready
-    RAFT_CUBLAS_TRY(
-      raft::linalg::detail::cublasnrm2(cublas_h, n, eigVecs + IDX(0, i, n), 1, &std, stream));
-
-    std /= std::sqrt(static_cast<weight_t>(n));
-
-    thrust::transform(thrust_exec_policy,
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i + 1, n)),
-                      thrust::make_constant_iterator(std),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::divides<weight_t>());
-    RAFT_CHECK_CUDA(stream);
-  }
+  raft::spectral::matrix::vector_t<weight_t> mean(handle, nEigVecs);
+  raft::spectral::matrix::vector_t<weight_t> std(handle, nEigVecs);
+  raft::stats::mean(mean.raw(), eigVecs, d, n, false, false, stream);
+  raft::stats::stddev(std.raw(), eigVecs, mean.raw(), d, n, false, false, stream);
 
-  // Transpose eigenvector matrix
   //   TODO: in-place transpose
-  {
-    raft::spectral::matrix::vector_t<weight_t> work(handle, nEigVecs * n);
-    // TODO: Call from public API when ready
-    RAFT_CUBLAS_TRY(
-      raft::linalg::detail::cublassetpointermode(cublas_h, CUBLAS_POINTER_MODE_HOST, stream));
-
-    // TODO: Call from public API when ready
-    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgeam(cublas_h,
-                                                     CUBLAS_OP_T,
-                                                     CUBLAS_OP_N,
-                                                     nEigVecs,
-                                                     n,
-                                                     &one,
-                                                     eigVecs,
-                                                     n,
-                                                     &zero,
-                                                     (weight_t*)NULL,
-                                                     nEigVecs,
-                                                     work.raw(),
-                                                     nEigVecs,
-                                                     stream));
-
-    RAFT_CUDA_TRY(cudaMemcpyAsync(
-      eigVecs, work.raw(), nEigVecs * n * sizeof(weight_t), cudaMemcpyDeviceToDevice, stream));
+  raft::spectral::matrix::vector_t<weight_t> work(handle, nEigVecs * n);
+  raft::linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<weight_t, edge_t>(work.raw(), n * d),
+    whiten_transpose_op<edge_t, weight_t>{eigVecs, mean.raw(), std.raw(), n, d});
+
+  RAFT_CUDA_TRY(cudaMemcpyAsync(
+    eigVecs, work.raw(), nEigVecs * n * sizeof(weight_t), cudaMemcpyDeviceToDevice, stream));
+}
+
+/// Accumulate the weight of the edges leaving every partition, and the size of the partitions
+/** One thread per vertex of the CSR graph; the vertices assigned outside of [0, nClusters) are
+ *  ignored.
+ */
+template <typename vertex_t, typename weight_t>
+RAFT_KERNEL partition_cut_kernel(const vertex_t* row_offsets,
+                                 const vertex_t* col_indices,
+                                 const weight_t* values,
+                                 vertex_t n,
+                                 vertex_t nClusters,
+                                 const vertex_t* clusters,
+                                 weight_t* part_cuts,
+                                 weight_t* part_sizes)
+{
+  vertex_t row = blockIdx.x * blockDim.x + threadIdx.x;
+  if (row >= n) { return; }
+  vertex_t part = clusters[row];
+  if (part < 0 || part >= nClusters) { return; }
+  weight_t cut = 0;
+  for (auto e = row_offsets[row]; e < row_offsets[row + 1]; e++) {
+    if (clusters[col_indices[e]] != part) { cut += values[e]; }
   }
+  atomicAdd(part_sizes + part, weight_t(1));
+  if (cut != 0) { atomicAdd(part_cuts + part, cut); }
+}
+
+/// Compute the weight of the edges leaving every partition, and the size of the partitions
+/** i.e. x^T L x and x^T x for the indicator vector x of every partition, for the Laplacian L of
+ *  the graph `csr_m`, in a single stream-ordered pass over the graph.
+ */
+template <typename vertex_t, typename weight_t>
+void compute_partition_cuts(raft::resources const& handle,
+                            spectral::matrix::sparse_matrix_t<vertex_t, weight_t> const& csr_m,
+                            vertex_t nClusters,
+                            vertex_t const* __restrict__ clusters,
+                            spectral::matrix::vector_t<weight_t>& part_cuts,
+                            spectral::matrix::vector_t<weight_t>& part_sizes)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  vertex_t n  = csr_m.nrows_;
+  RAFT_CUDA_TRY(cudaMemsetAsync(part_cuts.raw(), 0, nClusters * sizeof(weight_t), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(part_sizes.raw(), 0, nClusters * sizeof(weight_t), stream));
+  if (n == 0) { return; }
+  constexpr int kBlockSize = 256;
+  partition_cut_kernel<vertex_t, weight_t>
+    <<<raft::ceildiv<vertex_t>(n, kBlockSize), kBlockSize, 0, stream>>>(csr_m.row_offsets_,
+                                                                      csr_m.col_indices_,
+                                                                      csr_m.values_,
+                                                                      n,
+                                                                      nClusters,
+                                                                      clusters,
+                                                                      part_cuts.raw(),
+                                                                      part_sizes.raw());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
 }
 
 namespace {
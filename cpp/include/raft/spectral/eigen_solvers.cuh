@@ -39,6 +39,10 @@ struct eigen_solver_config_t {
     1234567};  // CAVEAT: this default value is now common to all instances of using seed in
                // Lanczos; was not the case before: there were places where a default seed = 123456
                // was used; this may trigger slightly different # solver iterations
+
+  // number of vectors of a block Lanczos step; 1 runs the implicitly restarted Lanczos method,
+  // larger blocks the block Lanczos method, which finds repeated eigenvalues
+  size_type_t block_size{1};
 };
 
 template <typename index_type_t, typename value_type_t, typename size_type_t = index_type_t>
@@ -58,6 +62,20 @@ struct lanczos_solver_t {
     RAFT_EXPECTS(eigVals != nullptr, "Null eigVals buffer.");
     RAFT_EXPECTS(eigVecs != nullptr, "Null eigVecs buffer.");
     index_type_t iters{};
+    if (config_.block_size > 1) {
+      sparse::solver::computeSmallestEigenvectorsBlock(handle,
+                                                       A,
+                                                       config_.n_eigVecs,
+                                                       config_.block_size,
+                                                       config_.maxIter,
+                                                       config_.restartIter,
+                                                       config_.tol,
+                                                       iters,
+                                                       eigVals,
+                                                       eigVecs,
+                                                       config_.seed);
+      return iters;
+    }
     sparse::solver::computeSmallestEigenvectors(handle,
                                                 A,
                                                 config_.n_eigVecs,
@@ -81,6 +99,20 @@ struct lanczos_solver_t {
     RAFT_EXPECTS(eigVals != nullptr, "Null eigVals buffer.");
     RAFT_EXPECTS(eigVecs != nullptr, "Null eigVecs buffer.");
     index_type_t iters{};
+    if (config_.block_size > 1) {
+      sparse::solver::computeLargestEigenvectorsBlock(handle,
+                                                      A,
+                                                      config_.n_eigVecs,
+                                                      config_.block_size,
+                                                      config_.maxIter,
+                                                      config_.restartIter,
+                                                      config_.tol,
+                                                      iters,
+                                                      eigVals,
+                                                      eigVecs,
+                                                      config_.seed);
+      return iters;
+    }
     sparse::solver::computeLargestEigenvectors(handle,
                                                A,
                                                config_.n_eigVecs,
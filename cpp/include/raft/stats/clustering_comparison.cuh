@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/stats/detail/clustering_comparison.cuh>
+#include <raft/stats/stats_types.hpp>
+
+#include <type_traits>
+
+namespace raft {
+namespace stats {
+
+/**
+ * @defgroup stats_clustering_comparison Clustering comparison
+ * @{
+ */
+
+/**
+ * @brief Compute the adjusted Rand index, the mutual information, the entropies, the
+ *   homogeneity, the completeness and the v-measure of two labelings at once.
+ *
+ * The contingency matrix of the labelings is built in a single pass over the labels and shared by
+ * all the metrics, instead of being rebuilt by every one of `adjusted_rand_index`,
+ * `mutual_info_score`, `homogeneity_score`, `completeness_score` and `v_measure`, whose results it
+ * reproduces. The labels need not be contiguous: when the range of label pairs is large, only the
+ * non-empty cells of the matrix are stored (in a hash table of O(n) slots), so the memory does not
+ * grow with the number of classes.
+ *
+ * @tparam value_t integral type of the labels
+ * @tparam idx_t integer type used for addressing
+ * @param[in] handle the raft handle
+ * @param[in] truth the ground truth labels [n]
+ * @param[in] pred the predicted labels [n]
+ * @param[in] beta the weight of the homogeneity in the v-measure
+ * @return all the metrics
+ */
+template <typename value_t, typename idx_t>
+clustering_comparison compare_clusterings(raft::resources const& handle,
+                                          raft::device_vector_view<const value_t, idx_t> truth,
+                                          raft::device_vector_view<const value_t, idx_t> pred,
+                                          double beta = 1.0)
+{
+  static_assert(std::is_integral_v<value_t>, "the labels must be of an integral type");
+  RAFT_EXPECTS(truth.extent(0) == pred.extent(0), "Size mismatch between truth and pred");
+  RAFT_EXPECTS(truth.is_exhaustive(), "truth must be contiguous");
+  RAFT_EXPECTS(pred.is_exhaustive(), "pred must be contiguous");
+  RAFT_EXPECTS(truth.extent(0) >= 2, "at least two samples are needed");
+
+  return detail::compare_clusterings(
+    handle, truth.data_handle(), pred.data_handle(), int64_t(truth.extent(0)), beta);
+}
+
+/** @} */  // end group stats_clustering_comparison
+
+}  // end namespace stats
+}  // end namespace raft
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/stats/stats_types.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/device_atomics.cuh>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+#include <thrust/extrema.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft {
+namespace stats {
+namespace detail {
+
+/** Sums over the contingency matrix and its marginals, from which all the metrics follow. */
+struct contingency_sums {
+  /** sum over the cells of nij choose 2 */
+  unsigned long long cell_pairs;
+  /** sums over the classes of ai choose 2 and bj choose 2 */
+  unsigned long long truth_pairs, pred_pairs;
+  /** numbers of non-empty classes */
+  unsigned long long truth_unique, pred_unique;
+  /** sum over the cells of nij * log(n * nij / (ai * bj)) */
+  double mi;
+  /** sums over the classes of -ai/n * log(ai/n) and -bj/n log(bj/n) */
+  double truth_entropy, pred_entropy;
+};
+
+/**
+ * The non-empty cells of a contingency matrix with `n_pred` columns. The cell (i, j) has the key
+ * `i * n_pred + j`; it is either stored densely at `counts[key]`, or in an open-addressing hash
+ * table of `mask + 1` slots (a power of two) with linear probing.
+ */
+struct contingency_cells {
+  static constexpr unsigned long long kEmpty = ~0ull;
+
+  unsigned long long* keys;
+  int* counts;
+  unsigned long long mask;
+  unsigned long long n_pred;
+  bool hashed;
+
+  DI static unsigned long long hash(unsigned long long key)
+  {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    return key ^ (key >> 33);
+  }
+
+  /** The slot of the cell `key`, which is inserted in the table if missing. */
+  DI unsigned long long find_or_insert(unsigned long long key) const
+  {
+    if (!hashed) { return key; }
+    unsigned long long slot = hash(key) & mask;
+    while (true) {
+      unsigned long long old = keys[slot];
+      if (old == kEmpty) { old = atomicCAS(keys + slot, kEmpty, key); }
+      if (old == kEmpty || old == key) { return slot; }
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  DI unsigned long long key_of(unsigned long long slot) const
+  {
+    return hashed ? keys[slot] : slot;
+  }
+};
+
+static const int ContingencyThreadsPerBlock = 256;
+
+template <typename T>
+RAFT_KERNEL contingency_count_kernel(
+  const T* truth, const T* pred, int64_t n, T min_truth, T min_pred, contingency_cells cells)
+{
+  int64_t stride = int64_t(blockDim.x) * gridDim.x;
+  for (int64_t k = threadIdx.x + int64_t(blockIdx.x) * blockDim.x; k < n; k += stride) {
+    auto key = (unsigned long long)(truth[k] - min_truth) * cells.n_pred +
+               (unsigned long long)(pred[k] - min_pred);
+    atomicAdd(cells.counts + cells.find_or_insert(key), 1);
+  }
+}
+
+/** Accumulate the marginals and the sum of nij choose 2 of the cells. */
+RAFT_KERNEL contingency_marginals_kernel(contingency_cells cells,
+                                         unsigned long long n_slots,
+                                         int* truth_counts,
+                                         int* pred_counts,
+                                         contingency_sums* sums)
+{
+  typedef cub::BlockReduce<unsigned long long, ContingencyThreadsPerBlock> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  unsigned long long pairs  = 0;
+  unsigned long long stride = (unsigned long long)blockDim.x * gridDim.x;
+  for (auto s = threadIdx.x + (unsigned long long)blockIdx.x * blockDim.x; s < n_slots;
+       s += stride) {
+    int c = cells.counts[s];
+    if (c == 0) continue;
+    auto key = cells.key_of(s);
+    atomicAdd(truth_counts + key / cells.n_pred, c);
+    atomicAdd(pred_counts + key % cells.n_pred, c);
+    pairs += (unsigned long long)c * (c - 1) / 2;
+  }
+  pairs = BlockReduce(temp_storage).Sum(pairs);
+  if (threadIdx.x == 0) { atomicAdd(&sums->cell_pairs, pairs); }
+}
+
+/** Accumulate the mutual information terms of the cells. */
+RAFT_KERNEL contingency_mi_kernel(contingency_cells cells,
+                                  unsigned long long n_slots,
+                                  const int* truth_counts,
+                                  const int* pred_counts,
+                                  int64_t n,
+                                  contingency_sums* sums)
+{
+  typedef cub::BlockReduce<double, ContingencyThreadsPerBlock> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  double mi                 = 0.0;
+  unsigned long long stride = (unsigned long long)blockDim.x * gridDim.x;
+  for (auto s = threadIdx.x + (unsigned long long)blockIdx.x * blockDim.x; s < n_slots;
+       s += stride) {
+    int c = cells.counts[s];
+    if (c == 0) continue;
+    auto key = cells.key_of(s);
+    double a = truth_counts[key / cells.n_pred];
+    double b = pred_counts[key % cells.n_pred];
+    mi += double(c) * (log(double(n) * double(c)) - log(a * b));
+  }
+  mi = BlockReduce(temp_storage).Sum(mi);
+  if (threadIdx.x == 0) { raft::myAtomicAdd(&sums->mi, mi); }
+}
+
+/** Accumulate the pairs, the non-empty classes and the entropy of a marginal. */
+RAFT_KERNEL contingency_class_kernel(const int* class_counts,
+                                     int64_t n_classes,
+                                     int64_t n,
+                                     unsigned long long* pairs_out,
+                                     unsigned long long* unique_out,
+                                     double* entropy_out)
+{
+  typedef cub::BlockReduce<unsigned long long, ContingencyThreadsPerBlock> BlockReduceInt;
+  typedef cub::BlockReduce<double, ContingencyThreadsPerBlock> BlockReduceDouble;
+  __shared__ typename BlockReduceInt::TempStorage temp_int;
+  __shared__ typename BlockReduceDouble::TempStorage temp_double;
+  unsigned long long pairs = 0, unique = 0;
+  double entropy           = 0.0;
+  int64_t stride           = int64_t(blockDim.x) * gridDim.x;
+  for (int64_t k = threadIdx.x + int64_t(blockIdx.x) * blockDim.x; k < n_classes; k += stride) {
+    int c = class_counts[k];
+    if (c == 0) continue;
+    double p = double(c) / double(n);
+    pairs += (unsigned long long)c * (c - 1) / 2;
+    unique += 1;
+    entropy -= p * log(p);
+  }
+  pairs = BlockReduceInt(temp_int).Sum(pairs);
+  __syncthreads();
+  unique = BlockReduceInt(temp_int).Sum(unique);
+  double block_entropy = BlockReduceDouble(temp_double).Sum(entropy);
+  if (threadIdx.x == 0) {
+    atomicAdd(pairs_out, pairs);
+    atomicAdd(unique_out, unique);
+    raft::myAtomicAdd(entropy_out, block_entropy);
+  }
+}
+
+/** Enough blocks of the grid-stride kernels to fill the GPU, but no more than needed. */
+inline unsigned int contingency_grid_size(unsigned long long n_items)
+{
+  auto n_blocks   = raft::ceildiv<unsigned long long>(n_items, ContingencyThreadsPerBlock);
+  auto max_blocks = 8ull * raft::getMultiProcessorCount();
+  return unsigned(std::max(1ull, std::min(n_blocks, max_blocks)));
+}
+
+/**
+ * @brief Compute the sums over the contingency matrix of two labelings and its marginals.
+ *
+ * The labels are read once to fill the non-empty cells of the contingency matrix: densely if it
+ * is small, otherwise in a hash table with as many slots as twice the number of samples (rounded
+ * to a power of two), so that neither sorting nor a dense matrix of all the label pairs is needed
+ * for large label counts. The marginals and all the sums are then computed from the cells.
+ */
+template <typename T>
+contingency_sums contingency_matrix_sums(raft::resources const& handle,
+                                         const T* truth,
+                                         const T* pred,
+                                         int64_t n)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  auto truth_range = thrust::minmax_element(policy, truth, truth + n);
+  auto pred_range  = thrust::minmax_element(policy, pred, pred + n);
+  T min_truth, max_truth, min_pred, max_pred;
+  raft::update_host(&min_truth, truth_range.first, 1, stream);
+  raft::update_host(&max_truth, truth_range.second, 1, stream);
+  raft::update_host(&min_pred, pred_range.first, 1, stream);
+  raft::update_host(&max_pred, pred_range.second, 1, stream);
+  resource::sync_stream(handle, stream);
+  auto n_truth = int64_t(max_truth - min_truth) + 1;
+  auto n_pred  = int64_t(max_pred - min_pred) + 1;
+
+  // dense cells as long as they take no more memory than the hash table
+  auto n_cells = (unsigned long long)n_truth * (unsigned long long)n_pred;
+  auto n_slots = 1ull;
+  while (n_slots < 2ull * (unsigned long long)n) {
+    n_slots <<= 1;
+  }
+  bool hashed = n_cells > 3ull * n_slots;
+  if (!hashed) { n_slots = n_cells; }
+
+  rmm::device_uvector<unsigned long long> keys(hashed ? n_slots : 0, stream, mr);
+  rmm::device_uvector<int> counts(n_slots, stream, mr);
+  RAFT_CUDA_TRY(cudaMemsetAsync(counts.data(), 0, n_slots * sizeof(int), stream));
+  if (hashed) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(keys.data(), 0xff, keys.size() * sizeof(*keys.data()), stream));
+  }
+  contingency_cells cells{
+    keys.data(), counts.data(), n_slots - 1, (unsigned long long)n_pred, hashed};
+
+  rmm::device_uvector<int> truth_counts(n_truth, stream, mr);
+  rmm::device_uvector<int> pred_counts(n_pred, stream, mr);
+  RAFT_CUDA_TRY(cudaMemsetAsync(truth_counts.data(), 0, n_truth * sizeof(int), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(pred_counts.data(), 0, n_pred * sizeof(int), stream));
+  rmm::device_scalar<contingency_sums> d_sums(stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(d_sums.data(), 0, sizeof(contingency_sums), stream));
+  auto* sums = d_sums.data();
+
+  // the only pass over the labels
+  auto n_blocks = contingency_grid_size(n);
+  contingency_count_kernel<<<n_blocks, ContingencyThreadsPerBlock, 0, stream>>>(
+    truth, pred, n, min_truth, min_pred, cells);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  n_blocks = contingency_grid_size(n_slots);
+  contingency_marginals_kernel<<<n_blocks, ContingencyThreadsPerBlock, 0, stream>>>(
+    cells, n_slots, truth_counts.data(), pred_counts.data(), sums);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  contingency_mi_kernel<<<n_blocks, ContingencyThreadsPerBlock, 0, stream>>>(
+    cells, n_slots, truth_counts.data(), pred_counts.data(), n, sums);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  n_blocks = contingency_grid_size(n_truth);
+  contingency_class_kernel<<<n_blocks, ContingencyThreadsPerBlock, 0, stream>>>(
+    truth_counts.data(), n_truth, n, &sums->truth_pairs, &sums->truth_unique, &sums->truth_entropy);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  n_blocks = contingency_grid_size(n_pred);
+  contingency_class_kernel<<<n_blocks, ContingencyThreadsPerBlock, 0, stream>>>(
+    pred_counts.data(), n_pred, n, &sums->pred_pairs, &sums->pred_unique, &sums->pred_entropy);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  return d_sums.value(stream);
+}
+
+/**
+ * @brief Compute all the metrics comparing two labelings from a single contingency matrix.
+ *
+ * The metrics have the same definitions and edge cases as `adjusted_rand_index`,
+ * `mutual_info_score`, `entropy`, `homogeneity_score`, `completeness_score` and `v_measure`.
+ */
+template <typename T>
+clustering_comparison compare_clusterings(
+  raft::resources const& handle, const T* truth, const T* pred, int64_t n, double beta)
+{
+  auto sums = contingency_matrix_sums(handle, truth, pred, n);
+  clustering_comparison res;
+
+  // the Rand index, corrected for chance
+  if (sums.truth_unique == sums.pred_unique &&
+      (sums.truth_unique == 1 || sums.truth_unique == (unsigned long long)n)) {
+    res.adjusted_rand_index = 1.0;
+  } else {
+    double n_pairs        = double(n) * double(n - 1) / 2.0;
+    double expected_index = double(sums.truth_pairs) * double(sums.pred_pairs) / n_pairs;
+    double max_index      = (double(sums.truth_pairs) + double(sums.pred_pairs)) / 2.0;
+    double index          = double(sums.cell_pairs);
+    res.adjusted_rand_index =
+      max_index - expected_index ? (index - expected_index) / (max_index - expected_index) : 0.0;
+  }
+
+  res.mutual_info   = sums.mi / double(n);
+  res.truth_entropy = sums.truth_entropy;
+  res.pred_entropy  = sums.pred_entropy;
+  res.homogeneity   = res.truth_entropy ? res.mutual_info / res.truth_entropy : 1.0;
+  res.completeness  = res.pred_entropy ? res.mutual_info / res.pred_entropy : 1.0;
+  if (res.homogeneity + res.completeness == 0.0) {
+    res.v_measure = 0.0;
+  } else {
+    res.v_measure = (1 + beta) * res.homogeneity * res.completeness /
+                    (beta * res.homogeneity + res.completeness);
+  }
+  return res;
+}
+
+}  // namespace detail
+}  // namespace stats
+}  // namespace raft
@@ -159,6 +159,61 @@ void smemHist(int* bins,
     <<<blks, ThreadsPerBlock, smemSize, stream>>>(bins, data, nrows, nbins, binner);
 }
 
+template <typename DataT, typename BinnerOp, typename IdxT, int VecLen>
+RAFT_KERNEL smemTiledHistKernel(
+  int* bins, const DataT* data, IdxT nrows, IdxT nbins, BinnerOp binner, int tileBins)
+{
+  extern __shared__ unsigned sbins[];
+  // the bins [tileStart, tileStart + tileLen) are counted by the blocks of slice blockIdx.z
+  IdxT tileStart = IdxT(blockIdx.z) * tileBins;
+  int tileLen    = int(raft::min<IdxT>(tileBins, nbins - tileStart));
+  for (auto i = threadIdx.x; i < tileLen; i += blockDim.x) {
+    sbins[i] = 0;
+  }
+  __syncthreads();
+  auto op = [=] __device__(int binId, IdxT row, IdxT col) {
+    if (row >= nrows) return;
+    auto tileBin = unsigned(binId - tileStart);
+    if (tileBin < unsigned(tileLen)) { raft::myAtomicAdd<unsigned int>(sbins + tileBin, 1); }
+  };
+  IdxT col = blockIdx.y;
+  histCoreOp<DataT, BinnerOp, IdxT, VecLen>(data, nrows, nbins, binner, op, col);
+  __syncthreads();
+  auto binOffset = col * nbins + tileStart;
+  for (auto i = threadIdx.x; i < tileLen; i += blockDim.x) {
+    auto val = sbins[i];
+    if (val > 0) { raft::myAtomicAdd<unsigned int>((unsigned int*)bins + binOffset + i, val); }
+  }
+}
+
+/** number of bins of a tile of `HistTypeSmemTiled` */
+inline int computeTiledHistTileBins()
+{
+  return raft::getSharedMemPerBlockOptin() / sizeof(unsigned);
+}
+
+template <typename DataT, typename BinnerOp, typename IdxT, int VecLen>
+void smemTiledHist(int* bins,
+                   IdxT nbins,
+                   const DataT* data,
+                   IdxT nrows,
+                   IdxT ncols,
+                   BinnerOp binner,
+                   cudaStream_t stream)
+{
+  auto kernel     = smemTiledHistKernel<DataT, BinnerOp, IdxT, VecLen>;
+  int tileBins    = std::min<IdxT>(computeTiledHistTileBins(), nbins);
+  int nTiles      = raft::ceildiv<IdxT>(nbins, tileBins);
+  size_t smemSize = tileBins * sizeof(unsigned);
+  RAFT_CUDA_TRY(
+    cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smemSize));
+  auto blks = computeGridDim<IdxT, VecLen>(nrows, ncols, (const void*)kernel);
+  // the blocks of a column are shared out among its tiles, all of which read the whole column
+  blks.x = std::max<unsigned>(1, blks.x / nTiles);
+  blks.z = nTiles;
+  kernel<<<blks, ThreadsPerBlock, smemSize, stream>>>(bins, data, nrows, nbins, binner, tileBins);
+}
+
 template <unsigned _BIN_BITS>
 struct BitsInfo {
   static unsigned const BIN_BITS  = _BIN_BITS;
@@ -409,6 +464,9 @@ void histogramVecLen(HistType type,
     case HistTypeSmemHash:
       smemHashHist<DataT, BinnerOp, IdxT, VecLen>(bins, nbins, data, nrows, ncols, binner, stream);
       break;
+    case HistTypeSmemTiled:
+      smemTiledHist<DataT, BinnerOp, IdxT, VecLen>(bins, nbins, data, nrows, ncols, binner, stream);
+      break;
     default: ASSERT(false, "histogram: Invalid type passed '%d'!", type);
   };
   RAFT_CUDA_TRY(cudaGetLastError());
@@ -458,6 +516,37 @@ HistType selectBestHistAlgo(IdxT nbins)
   return HistTypeGmem;
 }
 
+/**
+ * @brief Choose the histogram algorithm after the number of bins and the shape of the data.
+ *
+ * Privatizing the bins in shared memory costs the clearing and the flushing of all the bins by
+ * every block, which only pays off when each block counts at least about as many values as there
+ * are bins; otherwise the global atomics are used. Then, from the cheapest to the most expensive:
+ * full counters in shared memory, 16b counters, full counters by tiles of bins (one pass over the
+ * data per tile, as long as there are few tiles), and narrower counters, whose frequent overflows
+ * go to the global memory.
+ */
+template <typename IdxT>
+HistType selectBestHistAlgo(IdxT nbins, IdxT nrows, IdxT ncols)
+{
+  static constexpr int maxTiles = 8;
+  // about two resident blocks per SM, shared out among the columns
+  size_t blocksPerCol = raft::ceildiv<size_t>(2 * raft::getMultiProcessorCount(), ncols);
+  size_t rowsPerBlock =
+    std::max<size_t>(ThreadsPerBlock, raft::ceildiv<size_t>(nrows, blocksPerCol));
+  if (2 * rowsPerBlock < size_t(nbins)) { return HistTypeGmem; }
+
+  size_t smem = raft::getSharedMemPerBlock();
+  if (nbins * sizeof(unsigned) <= smem) { return HistTypeSmem; }
+  if (raft::alignTo<size_t>(raft::ceildiv<size_t>(16 * nbins, 8), sizeof(unsigned)) <= smem) {
+    return HistTypeSmemBits16;
+  }
+  if (raft::ceildiv<size_t>(nbins, computeTiledHistTileBins()) <= maxTiles) {
+    return HistTypeSmemTiled;
+  }
+  return selectBestHistAlgo(nbins);
+}
+
 /**
  * @brief Perform histogram on the input data. It chooses the right load size
  * based on the input data vector length. It also supports large-bin cases
@@ -487,7 +576,7 @@ void histogram(HistType type,
                BinnerOp binner = IdentityBinner<DataT, IdxT>())
 {
   HistType computedType = type;
-  if (type == HistTypeAuto) { computedType = selectBestHistAlgo(nbins); }
+  if (type == HistTypeAuto) { computedType = selectBestHistAlgo(nbins, nrows, ncols); }
   histogramImpl<DataT, BinnerOp, IdxT>(
     computedType, bins, nbins, data, nrows, ncols, stream, binner);
 }
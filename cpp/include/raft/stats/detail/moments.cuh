@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+
+namespace raft::stats::detail {
+
+/**
+ * Count, mean and centered sums of powers (up to the fourth) of a set of values.
+ *
+ * Sets are combined with the pairwise formulas of Chan et al. and Pébay, "Formulas for robust,
+ * one-pass parallel computation of covariances and arbitrary-order statistical moments" (2008).
+ * The members are all of type T, so that an array of states can be sent as an array of T.
+ */
+template <typename T>
+struct moments {
+  T n{0};
+  T mean{0};
+  T m2{0};
+  T m3{0};
+  T m4{0};
+
+  /** Add a single value. */
+  HDI void add(T x)
+  {
+    T n1      = n + T(1);
+    T delta   = x - mean;
+    T delta_n = delta / n1;
+    T d_n2    = delta_n * delta_n;
+    T term1   = delta * delta_n * n;
+    mean += delta_n;
+    m4 += term1 * d_n2 * (n1 * n1 - T(3) * n1 + T(3)) + T(6) * d_n2 * m2 - T(4) * delta_n * m3;
+    m3 += term1 * delta_n * (n1 - T(2)) - T(3) * delta_n * m2;
+    m2 += term1;
+    n = n1;
+  }
+
+  /** Combine the moments of two sets (associative and commutative). */
+  HDI auto operator+=(moments<T> const& b) & -> moments<T>&
+  {
+    const T na = n;
+    const T nb = b.n;
+    const T nc = na + nb;
+    if (nb == T(0)) return *this;
+    if (na == T(0)) {
+      *this = b;
+      return *this;
+    }
+    const T d  = b.mean - mean;
+    const T d2 = d * d;
+    const T fa = na / nc;
+    const T fb = nb / nc;
+    m4 += b.m4 + d2 * d2 * na * fb * (fa * fa - fa * fb + fb * fb) +
+          T(6) * d2 * (fa * fa * b.m2 + fb * fb * m2) + T(4) * d * (fa * b.m3 - fb * m3);
+    m3 += b.m3 + d2 * d * na * fb * (fa - fb) + T(3) * d * (fa * b.m2 - fb * m2);
+    m2 += b.m2 + d2 * na * fb;
+    mean += d * fb;
+    n = nc;
+    return *this;
+  }
+};
+
+struct moments_mean_op {
+  template <typename T>
+  HDI T operator()(moments<T> const& s) const
+  {
+    return s.mean;
+  }
+};
+
+struct moments_var_op {
+  bool sample;
+  template <typename T>
+  HDI T operator()(moments<T> const& s) const
+  {
+    return s.m2 / raft::max(T(1), sample ? s.n - T(1) : s.n);
+  }
+};
+
+/** Population skewness: sqrt(n) m3 / m2^(3/2), zero for constant data. */
+struct moments_skewness_op {
+  template <typename T>
+  HDI T operator()(moments<T> const& s) const
+  {
+    return s.m2 > T(0) ? raft::sqrt(s.n) * s.m3 / (s.m2 * raft::sqrt(s.m2)) : T(0);
+  }
+};
+
+/** Population excess kurtosis: n m4 / m2^2 - 3, zero for constant data. */
+struct moments_kurtosis_op {
+  template <typename T>
+  HDI T operator()(moments<T> const& s) const
+  {
+    return s.m2 > T(0) ? s.n * s.m4 / (s.m2 * s.m2) - T(3) : T(0);
+  }
+};
+
+/**
+ * Moments of a slab of columns of a row-major matrix: threadIdx.x goes along the columns and
+ * threadIdx.y along the rows, and the block writes the moments of its rows to `partials`
+ * [gridDim.y, D].
+ */
+template <typename T, typename I, int BlockSize>
+RAFT_KERNEL __launch_bounds__(BlockSize)
+  moments_kernel_rowmajor(const T* data, I D, I N, moments<T>* partials)
+{
+  const I col = threadIdx.x + blockDim.x * blockIdx.x;
+  moments<T> acc;
+  if (col < D) {
+    for (I row = threadIdx.y + blockDim.y * blockIdx.y; row < N; row += blockDim.y * gridDim.y) {
+      acc.add(data[size_t(row) * D + col]);
+    }
+  }
+
+  __shared__ uint8_t shm_bytes[BlockSize * sizeof(moments<T>)];
+  auto shm = reinterpret_cast<moments<T>*>(shm_bytes);
+  int tid  = threadIdx.x + threadIdx.y * blockDim.x;
+  shm[tid] = acc;
+  for (int bs = BlockSize >> 1; bs >= int(blockDim.x); bs = bs >> 1) {
+    __syncthreads();
+    if (tid < bs) { shm[tid] += shm[tid + bs]; }
+  }
+  if (threadIdx.y == 0 && col < D) { partials[size_t(blockIdx.y) * D + col] = shm[tid]; }
+}
+
+/**
+ * Moments of a slab of rows of a column of a column-major matrix: blockIdx.x is the column, and
+ * the block writes the moments of its rows to `partials` [gridDim.y, D].
+ */
+template <typename T, typename I, int BlockSize>
+RAFT_KERNEL __launch_bounds__(BlockSize)
+  moments_kernel_colmajor(const T* data, I D, I N, moments<T>* partials)
+{
+  const T* col_data = data + size_t(N) * blockIdx.x;
+  moments<T> acc;
+  for (I row = threadIdx.x + BlockSize * blockIdx.y; row < N; row += BlockSize * gridDim.y) {
+    acc.add(col_data[row]);
+  }
+
+  __shared__ uint8_t shm_bytes[BlockSize * sizeof(moments<T>)];
+  auto shm         = reinterpret_cast<moments<T>*>(shm_bytes);
+  shm[threadIdx.x] = acc;
+  for (int bs = BlockSize >> 1; bs >= 1; bs = bs >> 1) {
+    __syncthreads();
+    if (int(threadIdx.x) < bs) { shm[threadIdx.x] += shm[threadIdx.x + bs]; }
+  }
+  if (threadIdx.x == 0) { partials[size_t(blockIdx.y) * D + blockIdx.x] = shm[0]; }
+}
+
+/** Merge the `n_parts` rows of `parts` [n_parts, D] into `state` [D], in the order of the rows. */
+template <typename T, typename I>
+RAFT_KERNEL moments_merge_kernel(moments<T>* state, const moments<T>* parts, I D, I n_parts)
+{
+  I col = threadIdx.x + blockDim.x * blockIdx.x;
+  if (col >= D) return;
+  moments<T> acc = state[col];
+  for (I p = 0; p < n_parts; p++) {
+    acc += parts[size_t(p) * D + col];
+  }
+  state[col] = acc;
+}
+
+template <typename T, typename I, int BlockSize = 256>
+void moments_merge(moments<T>* state, const moments<T>* parts, I D, I n_parts, cudaStream_t stream)
+{
+  if (D == 0 || n_parts == 0) return;
+  moments_merge_kernel<T, I>
+    <<<raft::ceildiv<I>(D, BlockSize), BlockSize, 0, stream>>>(state, parts, D, n_parts);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Add the rows of a matrix [N, D] to the per-column moments `state` [D].
+ *
+ * The blocks compute the moments of slabs of rows in a workspace buffer (one state per slab and
+ * column, no atomics), which are then merged into `state` in a fixed order, so the result is
+ * deterministic.
+ */
+template <typename T, typename I, int BlockSize = 256>
+void moments_update(
+  raft::resources const& handle, moments<T>* state, const T* data, I D, I N, bool rowMajor)
+{
+  if (D == 0 || N == 0) return;
+  auto stream = resource::get_cuda_stream(handle);
+  // enough blocks to occupy the GPU a few times over
+  const I n_target = I(8 * raft::getMultiProcessorCount());
+
+  if (rowMajor) {
+    static_assert(BlockSize >= WarpSize, "Block size must be not smaller than the warp size.");
+    const dim3 bs(WarpSize, BlockSize / WarpSize, 1);
+    const I gx = raft::ceildiv<I>(D, I(bs.x));
+    const I gy = std::min<I>({raft::ceildiv<I>(N, I(bs.y)),
+                              std::max<I>(1, raft::ceildiv<I>(n_target, gx)),
+                              I(65535)});
+    rmm::device_uvector<moments<T>> partials(
+      size_t(gy) * D, stream, resource::get_workspace_resource(handle));
+    moments_kernel_rowmajor<T, I, BlockSize>
+      <<<dim3(gx, gy, 1), bs, 0, stream>>>(data, D, N, partials.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    moments_merge<T, I>(state, partials.data(), D, gy, stream);
+  } else {
+    const I gy = std::min<I>({raft::ceildiv<I>(N, I(BlockSize)),
+                              std::max<I>(1, raft::ceildiv<I>(n_target, D)),
+                              I(65535)});
+    rmm::device_uvector<moments<T>> partials(
+      size_t(gy) * D, stream, resource::get_workspace_resource(handle));
+    moments_kernel_colmajor<T, I, BlockSize>
+      <<<dim3(D, gy, 1), BlockSize, 0, stream>>>(data, D, N, partials.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    moments_merge<T, I>(state, partials.data(), D, gy, stream);
+  }
+}
+
+/**
+ * Replace the moments `state` [D] of every rank by the moments of the union of the data of all
+ * the ranks. The states are gathered, then merged in the order of the ranks, so that all the
+ * ranks obtain the same result.
+ */
+template <typename T, typename I>
+void moments_allreduce(raft::resources const& handle, moments<T>* state, I D)
+{
+  const auto& comm = resource::get_comms(handle);
+  auto stream      = resource::get_cuda_stream(handle);
+  const I n_ranks  = comm.get_size();
+  rmm::device_uvector<moments<T>> all(
+    size_t(n_ranks) * D, stream, resource::get_workspace_resource(handle));
+  constexpr size_t kFields = sizeof(moments<T>) / sizeof(T);
+  comm.allgather(reinterpret_cast<const T*>(state),
+                 reinterpret_cast<T*>(all.data()),
+                 size_t(D) * kFields,
+                 stream);
+  RAFT_EXPECTS(comm.sync_stream(stream) == comms::status_t::SUCCESS, "allgather failed");
+  RAFT_CUDA_TRY(cudaMemsetAsync(state, 0, sizeof(moments<T>) * D, stream));
+  moments_merge<T, I>(state, all.data(), D, n_ranks, stream);
+}
+
+}  // namespace raft::stats::detail
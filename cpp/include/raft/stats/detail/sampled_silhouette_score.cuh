@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/reduce_cols_by_key.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/random/rng_state.hpp>
+#include <raft/random/sample_without_replacement.cuh>
+#include <raft/stats/detail/moments.cuh>
+#include <raft/stats/detail/silhouette_score.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/gather.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace raft::stats::detail {
+
+/**
+ * Silhouette of every sampled point, given the sums of its distances to the points of every
+ * cluster `sums` [n_samples, n_labels] and the size of the clusters.
+ */
+template <typename value_t, typename label_t, typename idx_t>
+RAFT_KERNEL sampled_silhouette_kernel(const value_t* sums,
+                                      const int* cluster_counts,
+                                      const label_t* sample_labels,
+                                      idx_t n_samples,
+                                      label_t n_labels,
+                                      value_t* scores)
+{
+  idx_t i = threadIdx.x + idx_t(blockIdx.x) * blockDim.x;
+  if (i >= n_samples) { return; }
+  const value_t* row = sums + size_t(i) * n_labels;
+  label_t own        = sample_labels[i];
+  int own_count      = cluster_counts[own];
+  // the silhouette of a point alone in its cluster is 0
+  if (own_count <= 1) {
+    scores[i] = value_t(0);
+    return;
+  }
+  value_t a = row[own] / value_t(own_count - 1);
+  value_t b = std::numeric_limits<value_t>::max();
+  for (label_t l = 0; l < n_labels; l++) {
+    if (l != own && cluster_counts[l] > 0) {
+      b = raft::min(b, row[l] / value_t(cluster_counts[l]));
+    }
+  }
+  scores[i] = SilOp<value_t>{}(a, b);
+}
+
+/** The two-sided standard normal quantile of `confidence`, i.e. z such that P(|Z| < z). */
+inline double normal_two_sided_quantile(double confidence)
+{
+  double lo = 0.0, hi = 40.0;
+  for (int iter = 0; iter < 100; iter++) {
+    double mid = 0.5 * (lo + hi);
+    if (std::erf(mid / std::sqrt(2.0)) < confidence) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0.5 * (lo + hi);
+}
+
+/**
+ * Estimate the silhouette score from the exact silhouettes of `n_samples` points drawn uniformly
+ * without replacement.
+ *
+ * The silhouette of a sampled point needs its mean distance to every cluster, so the distances
+ * from the sampled points to all the points are computed by tiles of `batch_size` reference rows
+ * and reduced by cluster on the fly (`reduce_cols_by_key`): the work is O(n_samples * n_rows) and
+ * the memory O(n_samples * (batch_size + n_labels)). The tiles are materialized rather than
+ * reduced in the epilogue of `pairwise_distance_reduce`, which would need a global atomic per pair
+ * on the few per-cluster sums of each row; `reduce_cols_by_key` accumulates them in shared memory.
+ * The mean and the variance of the sampled silhouettes give the estimate and its standard error
+ * (with the finite population correction).
+ */
+template <typename value_t, typename label_t, typename idx_t>
+void sampled_silhouette_score(raft::resources const& handle,
+                              raft::random::RngState& rng_state,
+                              const value_t* X,
+                              idx_t n_rows,
+                              idx_t n_cols,
+                              const label_t* labels,
+                              label_t n_labels,
+                              idx_t n_samples,
+                              idx_t batch_size,
+                              raft::distance::DistanceType metric,
+                              double confidence,
+                              value_t* score,
+                              value_t* std_error,
+                              value_t* lower,
+                              value_t* upper)
+{
+  ASSERT(n_labels >= 2 && n_labels <= (n_rows - 1),
+         "silhouette Score not defined for the given number of labels!");
+  RAFT_EXPECTS(n_samples > 0, "n_samples must be positive");
+  RAFT_EXPECTS(confidence > 0 && confidence < 1, "confidence must be in (0, 1)");
+  RAFT_EXPECTS(n_rows <= idx_t(std::numeric_limits<int>::max()),
+               "the number of rows must fit in int");
+  n_samples   = std::min(n_samples, n_rows);
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  // draw the points whose silhouette is computed
+  rmm::device_uvector<idx_t> sample_ids(n_samples, stream, mr);
+  {
+    rmm::device_uvector<idx_t> all_ids(n_rows, stream, mr);
+    raft::linalg::map_offset(handle,
+                             raft::make_device_vector_view<idx_t, idx_t>(all_ids.data(), n_rows),
+                             raft::identity_op{});
+    raft::random::sample_without_replacement(
+      handle,
+      rng_state,
+      raft::make_device_vector_view<const idx_t, idx_t>(all_ids.data(), n_rows),
+      std::nullopt,
+      raft::make_device_vector_view<idx_t, idx_t>(sample_ids.data(), n_samples),
+      std::nullopt);
+  }
+
+  rmm::device_uvector<value_t> sample_X(size_t(n_samples) * n_cols, stream, mr);
+  rmm::device_uvector<label_t> sample_labels(n_samples, stream, mr);
+  raft::matrix::gather(X, n_cols, n_rows, sample_ids.data(), n_samples, sample_X.data(), stream);
+  thrust::gather(policy, sample_ids.begin(), sample_ids.end(), labels, sample_labels.begin());
+
+  rmm::device_uvector<int> cluster_counts(n_labels, stream, mr);
+  rmm::device_uvector<char> workspace(1, stream, mr);
+  countLabels(labels, cluster_counts.data(), int(n_rows), int(n_labels), workspace, stream);
+
+  // sums of the distances of the sampled points to every cluster
+  rmm::device_uvector<value_t> sums(size_t(n_samples) * n_labels, stream, mr);
+  RAFT_CUDA_TRY(cudaMemsetAsync(sums.data(), 0, sums.size() * sizeof(value_t), stream));
+  if (batch_size <= 0) {
+    // tiles of at most a quarter of the free workspace, and at most 2^28 distances
+    size_t tile_elems = std::min<size_t>(resource::get_workspace_free_bytes(handle) / 4 /
+                                           sizeof(value_t),
+                                         size_t(1) << 28);
+    batch_size = idx_t(std::max<size_t>(tile_elems / n_samples, 1));
+  }
+  // the distance tiles are indexed with int
+  batch_size = std::min({batch_size, n_rows, std::max<idx_t>(1, idx_t(INT_MAX / n_samples))});
+  rmm::device_uvector<value_t> distances(size_t(n_samples) * batch_size, stream, mr);
+  for (idx_t j = 0; j < n_rows; j += batch_size) {
+    int n_ref = int(std::min(batch_size, n_rows - j));
+    raft::distance::pairwise_distance(handle,
+                                      sample_X.data(),
+                                      X + size_t(j) * n_cols,
+                                      distances.data(),
+                                      int(n_samples),
+                                      n_ref,
+                                      int(n_cols),
+                                      metric);
+    raft::linalg::reduce_cols_by_key(distances.data(),
+                                     labels + j,
+                                     sums.data(),
+                                     int(n_samples),
+                                     n_ref,
+                                     int(n_labels),
+                                     stream,
+                                     false);
+  }
+
+  rmm::device_uvector<value_t> scores(n_samples, stream, mr);
+  constexpr int kBlockSize = 256;
+  sampled_silhouette_kernel<value_t, label_t, idx_t>
+    <<<raft::ceildiv<idx_t>(n_samples, kBlockSize), kBlockSize, 0, stream>>>(
+      sums.data(), cluster_counts.data(), sample_labels.data(), n_samples, n_labels, scores.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  // mean and variance of the sampled silhouettes
+  rmm::device_uvector<moments<value_t>> state(1, stream, mr);
+  RAFT_CUDA_TRY(cudaMemsetAsync(state.data(), 0, sizeof(moments<value_t>), stream));
+  moments_update<value_t, idx_t>(handle, state.data(), scores.data(), idx_t(1), n_samples, true);
+  moments<value_t> state_h;
+  raft::update_host(&state_h, state.data(), 1, stream);
+  resource::sync_stream(handle, stream);
+
+  double var  = n_samples > 1 ? double(state_h.m2) / double(n_samples - 1) : 0.0;
+  double fpc  = n_rows > 1 ? double(n_rows - n_samples) / double(n_rows - 1) : 0.0;
+  double se   = std::sqrt(var / double(n_samples) * fpc);
+  double half = normal_two_sided_quantile(confidence) * se;
+  *score      = state_h.mean;
+  *std_error  = value_t(se);
+  *lower      = value_t(std::max(double(state_h.mean) - half, -1.0));
+  *upper      = value_t(std::min(double(state_h.mean) + half, 1.0));
+}
+
+}  // namespace raft::stats::detail
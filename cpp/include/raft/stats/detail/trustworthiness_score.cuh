@@ -16,12 +16,21 @@
 
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/distance/distance.cuh>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/matrix/col_wise_sort.cuh>
+#include <raft/matrix/segmented_sort.cuh>
 #include <raft/spatial/knn/knn.cuh>
 
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <thrust/reduce.h>
+
+#include <algorithm>
+#include <optional>
+
 #define N_THREADS 512
 
 namespace raft {
@@ -216,6 +225,139 @@ double trustworthiness_score(const raft::resources& h,
   return t;
 }
 
+/**
+ * @brief Position of `id` in the sorted neighbor ids of a row, or -1 if it is not there
+ * @param[in] ids: Sorted neighbor ids of the row
+ * @param[in] pos: Positions of the sorted ids in the original neighbor list
+ * @param n_ids: Number of neighbors in the row
+ * @param id: The id to look for
+ */
+template <typename knn_index_t>
+DI int find_neighbor_position(const knn_index_t* ids, const int* pos, int n_ids, knn_index_t id)
+{
+  int lo = 0, hi = n_ids;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (ids[mid] < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < n_ids && ids[lo] == id ? pos[lo] : -1;
+}
+
+/**
+ * @brief Compute the trustworthiness penalty of every row of a batch from kNN lists
+ * @param[out] penalties: Sum over the embedding neighbors j of the row i of max(0, r(i, j) - k),
+ *                r(i, j) being the rank of j among the original neighbors of i (1 for the nearest)
+ * @param[in] orig_ids: Original neighbor ids of the rows of the batch, sorted per row
+ * @param[in] orig_pos: Positions of the sorted ids in the original neighbor lists
+ * @param n_orig: Number of original neighbors per row
+ * @param[in] emb_ind: Embedding neighbor ids of all the rows
+ * @param n_emb: Number of embedding neighbors per row
+ * @param row_offset: Index of the first row of the batch
+ * @param n_rows: Number of rows in the batch
+ * @param n_neighbors: Number of neighbors considered by trustworthiness score
+ */
+template <typename knn_index_t>
+RAFT_KERNEL compute_knn_rank_penalty(int64_t* penalties,
+                                     const knn_index_t* orig_ids,
+                                     const int* orig_pos,
+                                     int n_orig,
+                                     const knn_index_t* emb_ind,
+                                     int n_emb,
+                                     int64_t row_offset,
+                                     int64_t n_rows,
+                                     int n_neighbors)
+{
+  int64_t r = blockIdx.x * int64_t(blockDim.x) + threadIdx.x;
+  if (r >= n_rows) return;
+
+  const knn_index_t* ids = orig_ids + r * n_orig;
+  const int* pos         = orig_pos + r * n_orig;
+  const int64_t i        = row_offset + r;
+
+  // the point itself may or may not be in its neighbor lists, it does not count in the ranks
+  int self_pos   = find_neighbor_position(ids, pos, n_orig, knn_index_t(i));
+  int n_others   = self_pos < 0 ? n_orig : n_orig - 1;
+  int64_t result = 0;
+  int count      = 0;
+  for (int t = 0; t < n_emb && count < n_neighbors; t++) {
+    knn_index_t j = emb_ind[i * n_emb + t];
+    if (int64_t(j) == i) continue;
+    count++;
+    int p = find_neighbor_position(ids, pos, n_orig, j);
+    // the neighbors missing from the original list are ranked right after it
+    int rank = p < 0 ? n_others + 1 : p + 1 - (self_pos >= 0 && self_pos < p ? 1 : 0);
+    if (rank > n_neighbors) { result += rank - n_neighbors; }
+  }
+  penalties[r] = result;
+}
+
+/**
+ * @brief Compute the trustworthiness score from precomputed kNN graphs
+ * @param h Raft handle
+ * @param[in] orig_ind: Neighbors in the original space, each row sorted by distance [n, n_orig]
+ * @param n_orig: Number of neighbors per row in the original space
+ * @param[in] emb_ind: Neighbors in the embedding, each row sorted by distance [n, n_emb]
+ * @param n_emb: Number of neighbors per row in the embedding
+ * @param n: Number of samples
+ * @param n_neighbors Number of neighbors considered by trustworthiness score
+ * @param batchSize Number of rows whose ranks are computed at once
+ * @return Trustworthiness score
+ */
+template <typename knn_index_t>
+double trustworthiness_score_knn(const raft::resources& h,
+                                 const knn_index_t* orig_ind,
+                                 int n_orig,
+                                 const knn_index_t* emb_ind,
+                                 int n_emb,
+                                 int64_t n,
+                                 int n_neighbors,
+                                 int64_t batchSize)
+{
+  cudaStream_t stream = resource::get_cuda_stream(h);
+  auto policy         = resource::get_thrust_policy(h);
+  auto mr             = resource::get_workspace_resource(h);
+  batchSize           = std::min(batchSize, n);
+
+  rmm::device_uvector<knn_index_t> sorted_ids(batchSize * n_orig, stream, mr);
+  rmm::device_uvector<int> sorted_pos(batchSize * n_orig, stream, mr);
+  rmm::device_uvector<int64_t> penalties(batchSize, stream, mr);
+
+  int64_t t = 0;
+  for (int64_t row = 0; row < n; row += batchSize) {
+    int64_t curBatchSize = std::min(batchSize, n - row);
+
+    // sort the original neighbors of every row by id, to look them up by binary search
+    raft::matrix::segmented_sort<knn_index_t, int>(
+      h,
+      raft::make_device_matrix_view<const knn_index_t, int64_t>(
+        orig_ind + row * n_orig, curBatchSize, n_orig),
+      std::nullopt,
+      raft::make_device_matrix_view<knn_index_t, int64_t>(sorted_ids.data(), curBatchSize, n_orig),
+      raft::make_device_matrix_view<int, int64_t>(sorted_pos.data(), curBatchSize, n_orig));
+
+    int n_blocks = raft::ceildiv<int64_t>(curBatchSize, N_THREADS);
+    compute_knn_rank_penalty<<<n_blocks, N_THREADS, 0, stream>>>(penalties.data(),
+                                                                 sorted_ids.data(),
+                                                                 sorted_pos.data(),
+                                                                 n_orig,
+                                                                 emb_ind,
+                                                                 n_emb,
+                                                                 row,
+                                                                 curBatchSize,
+                                                                 n_neighbors);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    t += thrust::reduce(policy, penalties.data(), penalties.data() + curBatchSize, int64_t(0));
+  }
+
+  double k = n_neighbors;
+  return 1.0 - ((2.0 / ((double(n) * k) * ((2.0 * double(n)) - (3.0 * k) - 1.0))) * double(t));
+}
+
 }  // namespace detail
 }  // namespace stats
 }  // namespace raft
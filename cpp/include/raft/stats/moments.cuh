@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/stats/detail/moments.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <type_traits>
+
+namespace raft::stats {
+
+/**
+ * @defgroup stats_moments Streaming moments
+ * @{
+ */
+
+/**
+ * @brief Accumulator of the per-column mean, variance, skewness and kurtosis of a dataset
+ *   given by batches of rows.
+ *
+ * The state of every column (count, mean and centered sums of the second to fourth powers) is
+ * kept on the device and updated with the pairwise formulas of Chan et al. and Pébay, which are
+ * numerically stable. The states of several accumulators, e.g. of batches processed on
+ * different streams or of the ranks of a communicator, can be merged: the result is the same
+ * as if all the rows had been given to a single accumulator (up to rounding).
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  raft::stats::moments_accumulator<float> acc(handle, n_cols);
+ *  for (auto& batch : batches) {
+ *    acc.update(handle, batch);  // device_matrix_view<const float, int64_t, row_major>
+ *  }
+ *  acc.allreduce(handle);  // optional: the statistics of the data of all the ranks
+ *  acc.mean(handle, mean.view());
+ *  acc.var(handle, var.view(), true);
+ * @endcode
+ *
+ * @tparam value_t the data type
+ * @tparam idx_t the index type
+ */
+template <typename value_t, typename idx_t = int64_t>
+class moments_accumulator {
+  static_assert(std::is_floating_point_v<value_t>, "value_t must be a floating point type");
+
+ public:
+  /**
+   * @brief Create an empty accumulator.
+   *
+   * @param[in] handle the raft handle
+   * @param[in] n_cols number of columns of the data
+   */
+  moments_accumulator(raft::resources const& handle, idx_t n_cols)
+    : n_cols_(n_cols), state_(n_cols, resource::get_cuda_stream(handle))
+  {
+    reset(handle);
+  }
+
+  /** @brief Forget all the rows added so far. */
+  void reset(raft::resources const& handle)
+  {
+    RAFT_CUDA_TRY(cudaMemsetAsync(state_.data(),
+                                  0,
+                                  sizeof(detail::moments<value_t>) * n_cols_,
+                                  resource::get_cuda_stream(handle)));
+  }
+
+  /**
+   * @brief Add a batch of rows.
+   *
+   * @tparam layout_t Layout type of the input matrix.
+   * @param[in] handle the raft handle
+   * @param[in] batch the rows to add [n_rows, n_cols]
+   */
+  template <typename layout_t>
+  void update(raft::resources const& handle,
+              raft::device_matrix_view<const value_t, idx_t, layout_t> batch)
+  {
+    static_assert(
+      std::is_same_v<layout_t, raft::row_major> || std::is_same_v<layout_t, raft::col_major>,
+      "Data layout not supported");
+    RAFT_EXPECTS(batch.extent(1) == n_cols_, "Size mismatch between batch and accumulator");
+    RAFT_EXPECTS(batch.is_exhaustive(), "batch must be contiguous");
+    detail::moments_update<value_t, idx_t>(handle,
+                                           state_.data(),
+                                           batch.data_handle(),
+                                           batch.extent(1),
+                                           batch.extent(0),
+                                           std::is_same_v<layout_t, raft::row_major>);
+  }
+
+  /**
+   * @brief Merge the rows of another accumulator into this one.
+   *
+   * The work of `other` must be complete or ordered before the stream of `handle`.
+   *
+   * @param[in] handle the raft handle
+   * @param[in] other an accumulator with the same number of columns
+   */
+  void merge(raft::resources const& handle, const moments_accumulator& other)
+  {
+    RAFT_EXPECTS(other.n_cols_ == n_cols_, "Size mismatch between the accumulators");
+    detail::moments_merge<value_t, idx_t>(
+      state_.data(), other.state_.data(), n_cols_, idx_t(1), resource::get_cuda_stream(handle));
+  }
+
+  /**
+   * @brief Merge the accumulators of all the ranks of the communicator of `handle`.
+   *
+   * This is a collective operation: every rank must call it, and every rank then holds the
+   * moments of the rows added on all the ranks. The states are gathered and merged in the order
+   * of the ranks, so that all the ranks obtain exactly the same statistics.
+   *
+   * @param[in] handle the raft handle, with an initialized communicator
+   */
+  void allreduce(raft::resources const& handle)
+  {
+    detail::moments_allreduce<value_t, idx_t>(handle, state_.data(), n_cols_);
+  }
+
+  /**
+   * @brief Get the per-column mean.
+   *
+   * @param[in] handle the raft handle
+   * @param[out] out the mean of every column [n_cols]
+   */
+  void mean(raft::resources const& handle, raft::device_vector_view<value_t, idx_t> out) const
+  {
+    finalize(handle, out, detail::moments_mean_op{});
+  }
+
+  /**
+   * @brief Get the per-column variance.
+   *
+   * @param[in] handle the raft handle
+   * @param[out] out the variance of every column [n_cols]
+   * @param[in] sample whether to produce the sample variance (divide by `N - 1` instead of `N`)
+   */
+  void var(raft::resources const& handle,
+           raft::device_vector_view<value_t, idx_t> out,
+           bool sample) const
+  {
+    finalize(handle, out, detail::moments_var_op{sample});
+  }
+
+  /**
+   * @brief Get the per-column skewness `sqrt(N) * m3 / m2^(3/2)`, where `mk` is the sum of the
+   *   k-th powers of the deviations from the mean (population estimate, 0 for constant columns).
+   *
+   * @param[in] handle the raft handle
+   * @param[out] out the skewness of every column [n_cols]
+   */
+  void skewness(raft::resources const& handle, raft::device_vector_view<value_t, idx_t> out) const
+  {
+    finalize(handle, out, detail::moments_skewness_op{});
+  }
+
+  /**
+   * @brief Get the per-column excess kurtosis `N * m4 / m2^2 - 3` (population estimate, 0 for
+   *   constant columns).
+   *
+   * @param[in] handle the raft handle
+   * @param[out] out the excess kurtosis of every column [n_cols]
+   */
+  void kurtosis(raft::resources const& handle, raft::device_vector_view<value_t, idx_t> out) const
+  {
+    finalize(handle, out, detail::moments_kurtosis_op{});
+  }
+
+  /** @brief Number of columns of the data. */
+  [[nodiscard]] auto n_cols() const -> idx_t { return n_cols_; }
+
+ private:
+  template <typename op_t>
+  void finalize(raft::resources const& handle,
+                raft::device_vector_view<value_t, idx_t> out,
+                op_t op) const
+  {
+    RAFT_EXPECTS(out.extent(0) == n_cols_, "Size mismatch between output and accumulator");
+    raft::linalg::map(handle,
+                      out,
+                      op,
+                      raft::make_device_vector_view<const detail::moments<value_t>, idx_t>(
+                        state_.data(), n_cols_));
+  }
+
+  idx_t n_cols_;
+  rmm::device_uvector<detail::moments<value_t>> state_;
+};
+
+/** @} */  // end group stats_moments
+
+}  // namespace raft::stats
@@ -20,7 +20,9 @@
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/random/rng_state.hpp>
 #include <raft/stats/detail/batched/silhouette_score.cuh>
+#include <raft/stats/detail/sampled_silhouette_score.cuh>
 #include <raft/stats/detail/silhouette_score.cuh>
 
 namespace raft {
@@ -177,6 +179,85 @@ value_t silhouette_score_batched(
                                            metric);
 }
 
+/**
+ * @brief Estimate of the silhouette score, with its standard error and a confidence interval.
+ */
+template <typename value_t>
+struct silhouette_estimate {
+  /** The mean silhouette of the sampled points. */
+  value_t score;
+  /** Standard error of the estimate (0 when all the points are sampled). */
+  value_t std_error;
+  /** Lower bound of the confidence interval of the silhouette score. */
+  value_t lower;
+  /** Upper bound of the confidence interval of the silhouette score. */
+  value_t upper;
+};
+
+/**
+ * @brief function that estimates the average silhouette score of a clustering from a uniform
+ * sample of the points
+ *
+ * The exact silhouette of `n_samples` points drawn without replacement is computed against all the
+ * points, by tiles of `batch_size` rows whose distances are reduced by cluster on the fly, so the
+ * work is O(n_samples * n_rows) instead of O(n_rows^2). The returned interval is the normal
+ * confidence interval of the mean of the sampled silhouettes.
+ *
+ * @tparam value_t: type of the data samples
+ * @tparam label_t: type of the labels
+ * @tparam idx_t index type
+ * @param[in]  handle: raft handle for managing expensive resources
+ * @param[inout] rng_state: random number generator state used to draw the sample
+ * @param[in]  X: input matrix Data in row-major format (nRows x nCols)
+ * @param[in]  labels: the pointer to the array containing labels for every data sample (length:
+ * nRows)
+ * @param[in]  n_unique_labels: number of unique labels in the labels array
+ * @param[in]  n_samples: number of sampled points; the score is exact if it is at least nRows
+ * @param[in]  confidence: level of the confidence interval, in (0, 1)
+ * @param[in]  batch_size: number of rows per distance tile, 0 to size the tiles after the free
+ * workspace memory
+ * @param[in]  metric: the numerical value that maps to the type of distance metric to be used in
+ * the calculations
+ * @return: The estimated silhouette score and its confidence interval.
+ */
+template <typename value_t, typename label_t, typename idx_t>
+silhouette_estimate<value_t> silhouette_score_sampled(
+  raft::resources const& handle,
+  raft::random::RngState& rng_state,
+  raft::device_matrix_view<const value_t, idx_t, raft::row_major> X,
+  raft::device_vector_view<const label_t, idx_t> labels,
+  idx_t n_unique_labels,
+  idx_t n_samples,
+  double confidence                   = 0.95,
+  idx_t batch_size                    = 0,
+  raft::distance::DistanceType metric = raft::distance::DistanceType::L2Unexpanded)
+{
+  static_assert(std::is_integral_v<idx_t>,
+                "silhouette_score_sampled: The index type "
+                "of each mdspan argument must be an integral type.");
+  static_assert(std::is_integral_v<label_t>,
+                "silhouette_score_sampled: The label type must be an integral type.");
+  RAFT_EXPECTS(labels.extent(0) == X.extent(0), "Size mismatch between labels and data");
+
+  silhouette_estimate<value_t> res;
+  detail::sampled_silhouette_score(handle,
+                                   rng_state,
+                                   X.data_handle(),
+                                   X.extent(0),
+                                   X.extent(1),
+                                   labels.data_handle(),
+                                   label_t(n_unique_labels),
+                                   n_samples,
+                                   batch_size,
+                                   metric,
+                                   confidence,
+                                   &res.score,
+                                   &res.std_error,
+                                   &res.lower,
+                                   &res.upper);
+  return res;
+}
+
 /** @} */  // end group stats_silhouette_score
 
 /**
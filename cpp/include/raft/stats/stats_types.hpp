@@ -55,6 +55,12 @@ enum HistType {
   HistTypeSmemMatchAny,
   /** builds a hashmap of active bins in shared mem */
   HistTypeSmemHash,
+  /**
+   * privatizes the bins in shared mem by tiles of as many bins as fit in the (opt-in) shared mem
+   * of a block, each tile being computed by its own blocks in a separate pass over the data.
+   * This keeps full 32b counters for up to a few 100k bins.
+   */
+  HistTypeSmemTiled,
   /** decide at runtime the best algo for the given inputs */
   HistTypeAuto
 };
@@ -73,4 +79,32 @@ enum IC_Type { AIC, AICc, BIC };
 
 /** @} */
 
+/**
+ * @ingroup stats_clustering_comparison
+ * @{
+ */
+
+/**
+ * @brief The metrics comparing two labelings of the same samples, as computed by
+ *   `compare_clusterings`. The entropies and the mutual information are in nats.
+ */
+struct clustering_comparison {
+  /** the adjusted Rand index */
+  double adjusted_rand_index;
+  /** the mutual information of the two labelings */
+  double mutual_info;
+  /** the entropy of the ground truth labeling */
+  double truth_entropy;
+  /** the entropy of the predicted labeling */
+  double pred_entropy;
+  /** the homogeneity score: mutual_info / truth_entropy */
+  double homogeneity;
+  /** the completeness score: mutual_info / pred_entropy */
+  double completeness;
+  /** the v-measure: weighted harmonic mean of the homogeneity and the completeness */
+  double v_measure;
+};
+
+/** @} */
+
 };  // end namespace raft::stats
@@ -93,6 +93,68 @@ double trustworthiness_score(
     batch_size);
 }
 
+/**
+ * @brief Compute the trustworthiness score from the kNN graphs of the data and its embedding
+ *
+ * Unlike the overload above, the neighbors of the original space are given rather than computed
+ * by exact pairwise distances, so they can come from an approximate index (IVF-PQ, CAGRA...) and
+ * the score scales to large datasets. The rank of an embedding neighbor is its position in the
+ * original neighbor list of the point; the neighbors missing from the list are ranked right after
+ * it. Hence the score is exact when `orig_neighbors` holds all the points, and otherwise an upper
+ * bound which tightens as the list grows (a few times `n_neighbors` is typically enough).
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  // original-space neighbors from an approximate index, embedding neighbors from brute force
+ *  auto index = raft::neighbors::ivf_pq::build(handle, index_params, X);
+ *  raft::neighbors::ivf_pq::search(handle, search_params, index, X, orig_nbrs, orig_dists);
+ *  raft::neighbors::brute_force::knn(handle, emb_index, X_embedded, emb_nbrs, emb_dists);
+ *  double t = raft::stats::trustworthiness_score_knn(
+ *    handle, raft::make_const_mdspan(orig_nbrs), raft::make_const_mdspan(emb_nbrs), n_neighbors);
+ * @endcode
+ *
+ * The point itself is ignored wherever it appears in the lists.
+ *
+ * @tparam idx_t the neighbor index type
+ * @param[in] handle the raft handle
+ * @param[in] orig_neighbors: neighbors of every point in the original space, sorted by distance
+ *   [n_samples, n_orig]
+ * @param[in] emb_neighbors: neighbors of every point in the embedding, sorted by distance
+ *   [n_samples, n_emb]; the first `n_neighbors` of them (other than the point) are used.
+ * @param[in] n_neighbors Number of neighbors considered by trustworthiness score
+ * @param[in] batch_size Number of points whose ranks are computed at once
+ * @return Trustworthiness score
+ */
+template <typename idx_t>
+double trustworthiness_score_knn(
+  raft::resources const& handle,
+  raft::device_matrix_view<const idx_t, int64_t, raft::row_major> orig_neighbors,
+  raft::device_matrix_view<const idx_t, int64_t, raft::row_major> emb_neighbors,
+  int n_neighbors,
+  int64_t batch_size = 65536)
+{
+  const int64_t n = orig_neighbors.extent(0);
+  RAFT_EXPECTS(emb_neighbors.extent(0) == n,
+               "Size mismatch between orig_neighbors and emb_neighbors");
+  RAFT_EXPECTS(n_neighbors > 0 && 3.0 * n_neighbors < 2.0 * n - 1,
+               "n_neighbors must be positive and smaller than (2 * n_samples - 1) / 3");
+  RAFT_EXPECTS(emb_neighbors.extent(1) >= n_neighbors,
+               "emb_neighbors must hold at least n_neighbors neighbors per point");
+  RAFT_EXPECTS(orig_neighbors.extent(1) <= std::numeric_limits<int>::max() &&
+                 emb_neighbors.extent(1) <= std::numeric_limits<int>::max(),
+               "Too many neighbors per point");
+  RAFT_EXPECTS(batch_size > 0, "batch_size must be positive");
+
+  return detail::trustworthiness_score_knn(handle,
+                                           orig_neighbors.data_handle(),
+                                           int(orig_neighbors.extent(1)),
+                                           emb_neighbors.data_handle(),
+                                           int(emb_neighbors.extent(1)),
+                                           n,
+                                           n_neighbors,
+                                           batch_size);
+}
+
 /** @} */  // end group stats_trustworthiness
 
 }  // namespace stats
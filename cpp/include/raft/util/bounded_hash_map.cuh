@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/util/cuda_dev_essentials.cuh>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Open addressing hash sets and maps of integer keys, for use inside kernels.
+ *
+ * The tables are non-owning views over `2^bitlen` slots, which may live in shared memory (e.g. a
+ * per-block set of visited nodes) or in global memory (e.g. one table per query, or a single
+ * device-wide table): the caller provides the storage (`storage_bytes` gives its size) and picks
+ * its bounded size through `bitlen`, which may be smaller than the storage to only reset and probe
+ * the part that is needed. The keys are claimed with a compare-and-swap, so that any number of
+ * threads may insert concurrently. A slot holding `EmptyKey` is free: that key cannot be inserted.
+ *
+ * Every operation has a single-thread version, and a cooperative one where the `TeamSize` lanes of
+ * an aligned group of the warp probe `TeamSize` consecutive slots at once and vote on the result,
+ * which cuts the latency of long probe sequences in heavily loaded tables.
+ *
+ * @code{.cpp}
+ *   __shared__ uint32_t visited_storage[1 << 10];
+ *   raft::util::bounded_hash_set<uint32_t> visited{visited_storage, 10};
+ *   visited.reset();
+ *   __syncthreads();
+ *   ...
+ *   if (visited.insert(node)) { ... }  // true on the first insert of node only
+ * @endcode
+ */
+namespace raft::util {
+
+namespace hash {
+
+/** The finalizer of MurmurHash3: mixes all the bits of the key, the default. */
+struct fmix {
+  template <typename KeyT>
+  _RAFT_HOST_DEVICE inline uint64_t operator()(KeyT key, uint32_t) const
+  {
+    using bits_t = std::conditional_t<sizeof(KeyT) == 4, uint32_t, uint64_t>;
+    auto h       = static_cast<uint64_t>(static_cast<bits_t>(key));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+};
+
+/** Folds the high bits of the key onto the low `bitlen` ones: cheap, for well spread keys. */
+struct xor_fold {
+  template <typename KeyT>
+  _RAFT_HOST_DEVICE inline uint64_t operator()(KeyT key, uint32_t bitlen) const
+  {
+    return static_cast<uint64_t>(key ^ (key >> bitlen));
+  }
+};
+
+}  // namespace hash
+
+namespace detail {
+
+template <typename KeyT>
+_RAFT_DEVICE inline KeyT atomic_cas_key(KeyT* address, KeyT compare, KeyT val)
+{
+  static_assert(sizeof(KeyT) == 4 || sizeof(KeyT) == 8, "keys must be 4 or 8 bytes long");
+  if constexpr (sizeof(KeyT) == 4) {
+    return static_cast<KeyT>(atomicCAS(reinterpret_cast<unsigned int*>(address),
+                                       static_cast<unsigned int>(compare),
+                                       static_cast<unsigned int>(val)));
+  } else {
+    return static_cast<KeyT>(atomicCAS(reinterpret_cast<unsigned long long int*>(address),
+                                       static_cast<unsigned long long int>(compare),
+                                       static_cast<unsigned long long int>(val)));
+  }
+}
+
+/** The mask of the aligned group of `TeamSize` lanes the calling lane belongs to. */
+template <uint32_t TeamSize>
+_RAFT_DEVICE inline uint32_t team_mask()
+{
+  static_assert(TeamSize > 0 && TeamSize <= 32 && (TeamSize & (TeamSize - 1)) == 0,
+                "TeamSize must be a power of two, at most the warp size");
+  if constexpr (TeamSize == 32) {
+    return 0xffffffffu;
+  } else {
+    return ((1u << TeamSize) - 1) << (raft::laneId() & ~(TeamSize - 1));
+  }
+}
+
+}  // namespace detail
+
+/**
+ * @brief A hash set of integer keys over `2^bitlen` caller-provided slots.
+ *
+ * @tparam KeyT integer type of the keys, 4 or 8 bytes long
+ * @tparam IdxT unsigned type of the slot indices
+ * @tparam Hash hash functor, called as `Hash{}(key, bitlen)`
+ * @tparam EmptyKey the key marking the free slots
+ */
+template <typename KeyT,
+          typename IdxT = uint32_t,
+          typename Hash = hash::fmix,
+          KeyT EmptyKey = ~KeyT(0)>
+struct bounded_hash_set {
+  static_assert(std::is_integral_v<KeyT>, "keys must be integers");
+
+  static constexpr KeyT empty_key = EmptyKey;
+  /** Returned by `find` for a missing key. */
+  static constexpr IdxT npos = ~IdxT(0);
+
+  KeyT* keys;
+  uint32_t bitlen;
+
+  /** The number of slots of a table of the given bit length. */
+  _RAFT_HOST_DEVICE static constexpr IdxT size(uint32_t bitlen) { return IdxT(1) << bitlen; }
+  /** The size of the storage of a table of the given bit length, in bytes. */
+  _RAFT_HOST_DEVICE static constexpr size_t storage_bytes(uint32_t bitlen)
+  {
+    return sizeof(KeyT) * size_t(size(bitlen));
+  }
+
+  _RAFT_HOST_DEVICE inline IdxT size() const { return size(bitlen); }
+
+  /** Empty the table, the `n_threads` calling threads clearing every `n_threads`-th slot. */
+  _RAFT_DEVICE inline void reset(uint32_t thread_rank, uint32_t n_threads) const
+  {
+    for (IdxT i = thread_rank; i < size(); i += n_threads) {
+      keys[i] = EmptyKey;
+    }
+  }
+  /** Empty the table with all the threads of the block; synchronize before using it. */
+  _RAFT_DEVICE inline void reset() const { reset(threadIdx.x, blockDim.x); }
+
+  /**
+   * Insert a key.
+   * @return whether the key was inserted, i.e. false when it was already there or the table is full
+   */
+  _RAFT_DEVICE inline bool insert(KeyT key) const
+  {
+    bool inserted = false;
+    insert_slot(key, &inserted);
+    return inserted;
+  }
+
+  /** The slot of a key, or `npos` when it is not in the table. */
+  _RAFT_DEVICE inline IdxT find(KeyT key) const
+  {
+    const IdxT mask = size() - 1;
+    IdxT slot       = static_cast<IdxT>(Hash{}(key, bitlen)) & mask;
+    for (IdxT i = 0; i < size(); i++, slot = (slot + 1) & mask) {
+      KeyT cur = load(slot);
+      if (cur == key) { return slot; }
+      if (cur == EmptyKey) { return npos; }
+    }
+    return npos;
+  }
+
+  _RAFT_DEVICE inline bool contains(KeyT key) const { return find(key) != npos; }
+
+  /**
+   * Insert a key with the `TeamSize` lanes of an aligned group of the warp, which must all call it
+   * with the same key; the result is returned to all of them.
+   */
+  template <uint32_t TeamSize>
+  _RAFT_DEVICE inline bool insert_cooperative(KeyT key) const
+  {
+    bool inserted = false;
+    probe_cooperative<TeamSize, true>(key, &inserted);
+    return inserted;
+  }
+
+  /** Find a key with the `TeamSize` lanes of an aligned group of the warp, see `find`. */
+  template <uint32_t TeamSize>
+  _RAFT_DEVICE inline IdxT find_cooperative(KeyT key) const
+  {
+    return probe_cooperative<TeamSize, false>(key, nullptr);
+  }
+
+  template <uint32_t TeamSize>
+  _RAFT_DEVICE inline bool contains_cooperative(KeyT key) const
+  {
+    return find_cooperative<TeamSize>(key) != npos;
+  }
+
+ protected:
+  _RAFT_DEVICE inline KeyT load(IdxT slot) const
+  {
+    return static_cast<volatile KeyT*>(keys)[slot];
+  }
+
+  /** Insert a key if it is not there yet, and return its slot (`npos` when the table is full). */
+  _RAFT_DEVICE inline IdxT insert_slot(KeyT key, bool* inserted) const
+  {
+    const IdxT mask = size() - 1;
+    IdxT slot       = static_cast<IdxT>(Hash{}(key, bitlen)) & mask;
+    for (IdxT i = 0; i < size(); i++, slot = (slot + 1) & mask) {
+      // keys are often inserted again: look the slot up before trying to claim it
+      KeyT cur = load(slot);
+      if (cur == key) { return slot; }
+      if (cur == EmptyKey) {
+        cur = detail::atomic_cas_key(keys + slot, EmptyKey, key);
+        if (cur == EmptyKey) {
+          *inserted = true;
+          return slot;
+        }
+        if (cur == key) { return slot; }
+      }
+    }
+    return npos;
+  }
+
+  /**
+   * Probe the table by windows of `TeamSize` consecutive slots until the key or a free slot is
+   * found, and claim a free slot when inserting. Returns the slot of the key, or `npos`.
+   */
+  template <uint32_t TeamSize, bool Insert>
+  _RAFT_DEVICE inline IdxT probe_cooperative(KeyT key, bool* inserted) const
+  {
+    const uint32_t team = detail::team_mask<TeamSize>();
+    const IdxT lane     = raft::laneId() % TeamSize;
+    const IdxT mask     = size() - 1;
+    const IdxT base     = static_cast<IdxT>(Hash{}(key, bitlen)) & mask;
+    for (IdxT probed = 0; probed < size(); probed += TeamSize) {
+      const IdxT slot = (base + probed + lane) & mask;
+      KeyT cur        = load(slot);
+      uint32_t found  = __ballot_sync(team, cur == key);
+      if (found) { return __shfl_sync(team, slot, __ffs(found) - 1); }
+      uint32_t empty = __ballot_sync(team, cur == EmptyKey);
+      if constexpr (!Insert) {
+        if (empty) { return npos; }
+      } else {
+        // try the free slots of the window in order, the lane owning each one claiming it
+        while (empty) {
+          const int owner = __ffs(empty) - 1;
+          int outcome     = 0;  // 0: taken by another key, 1: claimed, 2: inserted meanwhile
+          if (raft::laneId() == owner) {
+            cur     = detail::atomic_cas_key(keys + slot, EmptyKey, key);
+            outcome = cur == EmptyKey ? 1 : (cur == key ? 2 : 0);
+          }
+          outcome = __shfl_sync(team, outcome, owner);
+          if (outcome != 0) {
+            *inserted = outcome == 1;
+            return __shfl_sync(team, slot, owner);
+          }
+          empty &= empty - 1;
+        }
+      }
+    }
+    return npos;
+  }
+};
+
+/**
+ * @brief A hash map from integer keys to values over `2^bitlen` caller-provided slots.
+ *
+ * The values live next to the keys (`values[slot]` belongs to `keys[slot]`), and are set to an
+ * initial value by `reset` rather than on insertion: a thread finding a key inserted concurrently
+ * by another one therefore always sees a valid value, and the values can be updated atomically in
+ * place, e.g. to accumulate per-key sums with `atomicAdd(map.find_or_insert(key), x)`.
+ *
+ * @tparam ValueT type of the values
+ * @see bounded_hash_set for the other template parameters
+ */
+template <typename KeyT,
+          typename ValueT,
+          typename IdxT = uint32_t,
+          typename Hash = hash::fmix,
+          KeyT EmptyKey = ~KeyT(0)>
+struct bounded_hash_map : public bounded_hash_set<KeyT, IdxT, Hash, EmptyKey> {
+  using set_type = bounded_hash_set<KeyT, IdxT, Hash, EmptyKey>;
+  using set_type::npos;
+
+  ValueT* values;
+
+  _RAFT_HOST_DEVICE bounded_hash_map(KeyT* keys, ValueT* values, uint32_t bitlen)
+    : set_type{keys, bitlen}, values{values}
+  {
+  }
+
+  _RAFT_HOST_DEVICE static constexpr size_t storage_bytes(uint32_t bitlen)
+  {
+    return (sizeof(KeyT) + sizeof(ValueT)) * size_t(set_type::size(bitlen));
+  }
+
+  /** Empty the table and set all the values to `init`. */
+  _RAFT_DEVICE inline void reset(uint32_t thread_rank, uint32_t n_threads, ValueT init) const
+  {
+    for (IdxT i = thread_rank; i < this->size(); i += n_threads) {
+      this->keys[i] = EmptyKey;
+      values[i]     = init;
+    }
+  }
+  _RAFT_DEVICE inline void reset(ValueT init) const { reset(threadIdx.x, blockDim.x, init); }
+
+  /** The value of a key, inserting the key if needed; nullptr when the table is full. */
+  _RAFT_DEVICE inline ValueT* find_or_insert(KeyT key) const
+  {
+    bool inserted;
+    return value_at(this->insert_slot(key, &inserted));
+  }
+
+  /** The value of a key, or nullptr when it is not in the table. */
+  _RAFT_DEVICE inline ValueT* find_value(KeyT key) const { return value_at(this->find(key)); }
+
+  /** Cooperative `find_or_insert`, see `bounded_hash_set::insert_cooperative`. */
+  template <uint32_t TeamSize>
+  _RAFT_DEVICE inline ValueT* find_or_insert_cooperative(KeyT key) const
+  {
+    bool inserted;
+    return value_at(this->template probe_cooperative<TeamSize, true>(key, &inserted));
+  }
+
+  /** Cooperative `find_value`, see `bounded_hash_set::find_cooperative`. */
+  template <uint32_t TeamSize>
+  _RAFT_DEVICE inline ValueT* find_value_cooperative(KeyT key) const
+  {
+    return value_at(this->template find_cooperative<TeamSize>(key));
+  }
+
+ private:
+  _RAFT_DEVICE inline ValueT* value_at(IdxT slot) const
+  {
+    return slot == npos ? nullptr : values + slot;
+  }
+};
+
+}  // namespace raft::util
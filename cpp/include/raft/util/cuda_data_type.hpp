@@ -15,7 +15,12 @@
  */
 #pragma once
 
+#include <cuda_bf16.h>
 #include <cuda_fp16.hpp>
+#include <cuda_runtime_api.h>
+#if CUDART_VERSION >= 11080
+#include <cuda_fp8.h>
+#endif
 
 #include <library_types.h>
 
@@ -72,6 +77,23 @@ inline constexpr auto get_cuda_data_type<half>() -> cudaDataType_t
   return CUDA_R_16F;
 }
 template <>
+inline constexpr auto get_cuda_data_type<nv_bfloat16>() -> cudaDataType_t
+{
+  return CUDA_R_16BF;
+}
+#if CUDART_VERSION >= 11080
+template <>
+inline constexpr auto get_cuda_data_type<__nv_fp8_e4m3>() -> cudaDataType_t
+{
+  return CUDA_R_8F_E4M3;
+}
+template <>
+inline constexpr auto get_cuda_data_type<__nv_fp8_e5m2>() -> cudaDataType_t
+{
+  return CUDA_R_8F_E5M2;
+}
+#endif
+template <>
 inline constexpr auto get_cuda_data_type<float>() -> cudaDataType_t
 {
   return CUDA_R_32F;
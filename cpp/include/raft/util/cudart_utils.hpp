@@ -269,6 +269,17 @@ inline int getSharedMemPerBlock()
   return smemPerBlk;
 }
 
+/** helper method to get max shared mem per block a kernel can opt in to use */
+inline int getSharedMemPerBlockOptin()
+{
+  int devId;
+  RAFT_CUDA_TRY(cudaGetDevice(&devId));
+  int smemPerBlk;
+  RAFT_CUDA_TRY(
+    cudaDeviceGetAttribute(&smemPerBlk, cudaDevAttrMaxSharedMemoryPerBlockOptin, devId));
+  return smemPerBlk;
+}
+
 /** helper method to get multi-processor count parameter */
 inline int getMultiProcessorCount()
 {
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/init.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/util/cache.cuh>
+#include <raft/util/cache_util.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+
+#include <cstdint>
+#include <limits>
+
+namespace raft::cache {
+
+/**
+ * @brief Device cache of the frequently accessed rows of a host-resident dataset.
+ *
+ * The dataset stays in host memory: pinned (or registered) memory, pageable memory or a memory
+ * mapped file. The rows requested through `get_rows` are kept in a set-associative LRU cache in
+ * device memory (see `Cache`), so that the hot part of the dataset, e.g. the neighborhood of the
+ * entry points of a graph search, is served from HBM. All the rows missing from the cache in a
+ * call are fetched from the host in one batch and inserted into the cache:
+ *
+ *   - if the host memory is accessible from the device, a kernel reads the rows directly;
+ *   - otherwise the rows are gathered by the host in pinned buffers and copied to the device
+ *     (see `raft::matrix::gather`).
+ *
+ * Example usage:
+ * @code{.cpp}
+ *   // dataset: host_matrix_view<const float, int64_t>, e.g. over a memory mapped file
+ *   raft::cache::host_backed_cache<float> cache(res, dataset, 1024);
+ *   // ids: device_vector_view<const int, int64_t> of the rows visited by the search
+ *   auto rows = raft::make_device_matrix<float, int64_t>(res, ids.extent(0), dataset.extent(1));
+ *   cache.get_rows(ids, rows.view());
+ * @endcode
+ *
+ * @note The keys of the cache are `int`, hence the dataset can have at most 2^31 - 1 rows.
+ * @note The object is not thread safe; the calls are ordered on the stream of `res`.
+ *
+ * @tparam T data type of the dataset
+ * @tparam associativity number of rows in a cache set
+ */
+template <typename T, int associativity = 32>
+class host_backed_cache : public Cache<T, associativity> {
+  using cache_type = Cache<T, associativity>;
+
+ public:
+  /**
+   * @brief Construct a cache over a host dataset.
+   *
+   * @param[in] res raft resources, the stream of which orders all the operations of the cache
+   * @param[in] dataset host matrix [n_rows, dim]; it must outlive the cache
+   * @param[in] cache_size size of the device cache in MiB
+   */
+  host_backed_cache(raft::resources const& res,
+                    raft::host_matrix_view<const T, int64_t, row_major> dataset,
+                    float cache_size = 200)
+    : cache_type(resource::get_cuda_stream(res), dataset.extent(1), cache_size),
+      res_(res),
+      dataset_(dataset)
+  {
+    RAFT_EXPECTS(dataset.extent(0) <= std::numeric_limits<int>::max(),
+                 "The cache is indexed by int keys, the dataset has too many rows.");
+    cudaPointerAttributes attr;
+    RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, dataset.data_handle()));
+    dataset_dev_ptr_ = reinterpret_cast<const T*>(attr.devicePointer);
+  }
+
+  /**
+   * @brief Collect rows of the dataset, serving them from the cache where possible.
+   *
+   * On exit out[k, :] = dataset[keys[k], :]. The rows that were not cached are fetched from the
+   * host in a single batch, and stored in the least recently used entries of their cache set.
+   *
+   * @param[in] keys device array of row indices, size [n]; duplicates are allowed
+   * @param[out] out device matrix [n, dim]
+   */
+  void get_rows(raft::device_vector_view<const int, int64_t> keys,
+                raft::device_matrix_view<T, int64_t, row_major> out)
+  {
+    common::nvtx::range<common::nvtx::domain::raft> fun_scope("host_backed_cache::get_rows(%zu)",
+                                                              size_t(keys.extent(0)));
+    RAFT_EXPECTS(out.extent(0) == keys.extent(0), "Number of output rows must equal n_keys");
+    RAFT_EXPECTS(out.extent(1) == dataset_.extent(1), "Output and dataset dims must match");
+    RAFT_EXPECTS(keys.extent(0) <= std::numeric_limits<int>::max(), "Too many keys in a batch");
+    int n = keys.extent(0);
+    if (n == 0) { return; }
+    if (this->n_cache_sets == 0) {
+      // The cache could not hold a single set of rows: fetch everything from the host.
+      fetch(keys.data_handle(), n, out.data_handle());
+      n_misses_ += n;
+      return;
+    }
+
+    auto stream = resource::get_cuda_stream(res_);
+    auto mr     = resource::get_workspace_resource(res_);
+
+    rmm::device_uvector<int> positions(n, stream, mr);
+    rmm::device_uvector<int> positions_part(n, stream, mr);
+    rmm::device_uvector<int> cache_idx(n, stream, mr);
+    rmm::device_uvector<int> cache_idx_part(n, stream, mr);
+    rmm::device_uvector<bool> is_cached(n, stream, mr);
+    rmm::device_uvector<int> n_hits_dev(1, stream, mr);
+
+    // get_cache_idx only reads the keys.
+    this->GetCacheIdx(
+      const_cast<int*>(keys.data_handle()), n, cache_idx.data(), is_cached.data(), stream);
+
+    // Group the positions and cache indices as [cached, non_cached].
+    raft::linalg::range(positions.data(), n, stream);
+    size_t part_bytes = 0;
+    cub::DevicePartition::Flagged(nullptr,
+                                  part_bytes,
+                                  positions.data(),
+                                  is_cached.data(),
+                                  positions_part.data(),
+                                  n_hits_dev.data(),
+                                  n,
+                                  stream);
+    rmm::device_uvector<char> cub_workspace(part_bytes, stream, mr);
+    cub::DevicePartition::Flagged(cub_workspace.data(),
+                                  part_bytes,
+                                  positions.data(),
+                                  is_cached.data(),
+                                  positions_part.data(),
+                                  n_hits_dev.data(),
+                                  n,
+                                  stream);
+    cub::DevicePartition::Flagged(cub_workspace.data(),
+                                  part_bytes,
+                                  cache_idx.data(),
+                                  is_cached.data(),
+                                  cache_idx_part.data(),
+                                  n_hits_dev.data(),
+                                  n,
+                                  stream);
+    int n_hits = 0;
+    raft::update_host(&n_hits, n_hits_dev.data(), 1, stream);
+    raft::interruptible::synchronize(stream);
+    int n_miss = n - n_hits;
+    n_hits_ += n_hits;
+    n_misses_ += n_miss;
+
+    // Copy the cached rows to their positions: out[positions[k]] = cache[cache_idx[k]].
+    if (n_hits > 0) {
+      scatter_rows(this->cache.data(),
+                       this->GetSize(),
+                       cache_idx_part.data(),
+                       n_hits,
+                       positions_part.data(),
+                       out.data_handle(),
+                       n);
+    }
+    if (n_miss == 0) { return; }
+
+    // The misses come with their cache set. assign_cache_idx expects them sorted by set, and we
+    // need to know where each of them goes in the output, hence we sort the positions by set.
+    int* miss_sets      = cache_idx_part.data() + n_hits;
+    int* miss_positions = positions_part.data() + n_hits;
+    rmm::device_uvector<int> sets_sorted(n_miss, stream, mr);
+    rmm::device_uvector<int> positions_sorted(n_miss, stream, mr);
+    size_t sort_bytes = 0;
+    cub::DeviceRadixSort::SortPairs(nullptr,
+                                    sort_bytes,
+                                    miss_sets,
+                                    sets_sorted.data(),
+                                    miss_positions,
+                                    positions_sorted.data(),
+                                    n_miss,
+                                    0,
+                                    sizeof(int) * 8,
+                                    stream);
+    if (sort_bytes > cub_workspace.size()) { cub_workspace.resize(sort_bytes, stream); }
+    cub::DeviceRadixSort::SortPairs(cub_workspace.data(),
+                                    sort_bytes,
+                                    miss_sets,
+                                    sets_sorted.data(),
+                                    miss_positions,
+                                    positions_sorted.data(),
+                                    n_miss,
+                                    0,
+                                    sizeof(int) * 8,
+                                    stream);
+
+    // The keys of the misses in the same order (a row of one element per key).
+    rmm::device_uvector<int> miss_keys(n_miss, stream, mr);
+    get_vecs<<<raft::ceildiv(n_miss, kTpb), kTpb, 0, stream>>>(
+      keys.data_handle(), 1, positions_sorted.data(), n_miss, miss_keys.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // Assign cache locations; the input is already sorted by set, the keys that cannot be cached
+    // in this iteration get -1.
+    rmm::device_uvector<int> slots(n_miss, stream, mr);
+    RAFT_CUDA_TRY(cudaMemsetAsync(slots.data(), 255, n_miss * sizeof(int), stream));
+    constexpr int nthreads = associativity <= 32 ? associativity : 32;
+    assign_cache_idx<nthreads, associativity>
+      <<<this->n_cache_sets, nthreads, 0, stream>>>(miss_keys.data(),
+                                                    n_miss,
+                                                    sets_sorted.data(),
+                                                    this->cached_keys.data(),
+                                                    this->n_cache_sets,
+                                                    this->cache_time.data(),
+                                                    this->n_iter,
+                                                    slots.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // Fetch the missing rows in one batch, insert them into the cache and scatter them to out.
+    rmm::device_uvector<T> tile(size_t(n_miss) * this->n_vec, stream, mr);
+    fetch(miss_keys.data(), n_miss, tile.data());
+    this->StoreVecs(tile.data(), n_miss, n_miss, slots.data(), stream);
+    scatter_rows(tile.data(), n_miss, nullptr, n_miss, positions_sorted.data(), out.data_handle(), n);
+  }
+
+  /** Number of rows served from the device cache since construction. */
+  [[nodiscard]] auto get_hit_count() const -> int64_t { return n_hits_; }
+
+  /** Number of rows fetched from the host since construction. */
+  [[nodiscard]] auto get_miss_count() const -> int64_t { return n_misses_; }
+
+ private:
+  static constexpr int kTpb = 256;
+
+  raft::resources const& res_;
+  raft::host_matrix_view<const T, int64_t, row_major> dataset_;
+  // Device address of the dataset, if the host memory is accessible from the device.
+  const T* dataset_dev_ptr_ = nullptr;
+  int64_t n_hits_           = 0;
+  int64_t n_misses_         = 0;
+
+  /** dst[dst_idx[k]] = src[src_idx[k]] (or src[k] if src_idx == nullptr) for k in [0, n). */
+  void scatter_rows(
+    const T* src, int n_src, const int* src_idx, int n, const int* dst_idx, T* dst, int n_dst) const
+  {
+    auto stream = resource::get_cuda_stream(res_);
+    store_vecs<<<raft::ceildiv(n * this->n_vec, kTpb), kTpb, 0, stream>>>(
+      src, n_src, this->n_vec, src_idx, n, dst_idx, dst, n_dst);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  /** Fetch the rows of the dataset in keys from the host: out[k] = dataset[keys[k]]. */
+  void fetch(const int* keys, int n, T* out)
+  {
+    int64_t dim = dataset_.extent(1);
+    auto map    = raft::make_device_vector_view<const int, int64_t>(keys, n);
+    auto dst    = raft::make_device_matrix_view<T, int64_t>(out, n, dim);
+    if (dataset_dev_ptr_ != nullptr) {
+      raft::matrix::gather(
+        res_,
+        raft::make_device_matrix_view<const T, int64_t>(dataset_dev_ptr_, dataset_.extent(0), dim),
+        map,
+        dst);
+    } else {
+      raft::matrix::gather(res_, dataset_, map, dst);
+    }
+  }
+};
+
+}  // namespace raft::cache
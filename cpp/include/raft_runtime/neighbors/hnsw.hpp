@@ -25,7 +25,8 @@ namespace raft::runtime::neighbors::hnsw {
 
 #define RAFT_INST_HNSW_FUNCS(T, IdxT)                                         \
   std::unique_ptr<raft::neighbors::hnsw::index<T>> from_cagra(                \
-    raft::resources const& res, raft::neighbors::cagra::index<T, IdxT>);      \
+    raft::resources const& res,                                               \
+    const raft::neighbors::cagra::index<T, IdxT>& cagra_index);               \
   void search(raft::resources const& handle,                                  \
               raft::neighbors::hnsw::search_params const& params,             \
               raft::neighbors::hnsw::index<T> const& index,                   \
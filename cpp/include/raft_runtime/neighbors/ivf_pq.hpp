@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022-2023, NVIDIA CORPORATION.
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <raft/core/host_mdspan.hpp>
 #include <raft/neighbors/ivf_pq_types.hpp>
 
 namespace raft::runtime::neighbors::ivf_pq {
@@ -23,6 +24,10 @@ namespace raft::runtime::neighbors::ivf_pq {
 // We define overloads for build and extend with void return type. This is used in the Cython
 // wrappers, where exception handling is not compatible with return type that has nontrivial
 // constructor.
+//
+// The host overloads never copy the whole input to the device: the training set is sampled with
+// strided copies and the data is added to the index in batches, so the input may be larger than the
+// device memory (e.g. a memory-mapped file).
 #define RAFT_DECL_BUILD_EXTEND(T, IdxT)                                              \
   [[nodiscard]] raft::neighbors::ivf_pq::index<IdxT> build(                          \
     raft::resources const& handle,                                                   \
@@ -43,6 +48,16 @@ namespace raft::runtime::neighbors::ivf_pq {
   void extend(raft::resources const& handle,                                         \
               raft::device_matrix_view<const T, IdxT, row_major> new_vectors,        \
               std::optional<raft::device_vector_view<const IdxT, IdxT>> new_indices, \
+              raft::neighbors::ivf_pq::index<IdxT>* idx);                            \
+                                                                                     \
+  void build(raft::resources const& handle,                                          \
+             const raft::neighbors::ivf_pq::index_params& params,                    \
+             raft::host_matrix_view<const T, IdxT, row_major> dataset,               \
+             raft::neighbors::ivf_pq::index<IdxT>* idx);                             \
+                                                                                     \
+  void extend(raft::resources const& handle,                                         \
+              raft::host_matrix_view<const T, IdxT, row_major> new_vectors,          \
+              std::optional<raft::host_vector_view<const IdxT, IdxT>> new_indices,   \
               raft::neighbors::ivf_pq::index<IdxT>* idx);
 
 RAFT_DECL_BUILD_EXTEND(float, int64_t);
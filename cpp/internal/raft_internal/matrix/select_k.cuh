@@ -33,6 +33,7 @@ struct params {
   bool use_same_leading_bits = false;
   bool use_memory_pool       = true;
   double frac_infinities     = 0.0;
+  bool sorted                = false;
 };
 
 inline auto operator<<(std::ostream& os, const params& ss) -> std::ostream&
@@ -44,6 +45,7 @@ inline auto operator<<(std::ostream& os, const params& ss) -> std::ostream&
   if (!ss.use_index_input) { os << ", no-input-index"; }
   if (ss.use_same_leading_bits) { os << ", same-leading-bits"; }
   if (ss.frac_infinities > 0) { os << ", infs: " << ss.frac_infinities; }
+  if (ss.sorted) { os << ", sorted"; }
   os << "}";
   return os;
 }
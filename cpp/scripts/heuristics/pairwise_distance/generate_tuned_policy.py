@@ -0,0 +1,173 @@
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Generates the tuned policy table of the pairwise distance dispatch
+
+The table (cpp/include/raft/distance/detail/pairwise_matrix/tuned_policy_table.hpp)
+holds the fastest vec_len of each distance op for each device architecture and
+shape bucket. It is generated from the timings of the tuning benchmark:
+
+    ./cpp/build/TUNE_DISTANCE --benchmark_filter=tuning_bench \
+        --benchmark_out_format=json \
+        --benchmark_out=tune_distance_sm80.json
+
+    python generate_tuned_policy.py tune_distance_sm80.json tune_distance_sm90.json
+
+Each input file may come from a different GPU; the entries of all of them end
+up in the table.
+"""
+
+import argparse
+import json
+import math
+import os
+from collections import defaultdict
+
+DEFAULT_OUTPUT = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)),
+    "..",
+    "..",
+    "..",
+    "include",
+    "raft",
+    "distance",
+    "detail",
+    "pairwise_matrix",
+    "tuned_policy_table.hpp",
+)
+
+HEADER = """/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is generated by cpp/scripts/heuristics/pairwise_distance/generate_tuned_policy.py
+// from the results of the TUNE_DISTANCE benchmark. Do not edit it by hand.
+
+#pragma once
+
+#include <array>  // std::array
+
+namespace raft::distance::detail {
+
+/** The tuned vec_len of a distance op on one architecture and shape bucket. */
+struct tuned_policy_entry {
+  // the name of the distance op, see `tuning_name` in tuned_policy.cuh
+  const char* op;
+  // sizeof(DataT)
+  int data_bytes;
+  // the compute capability of the device, 10 * major + minor
+  int sm;
+  // see `tuning_shape_bucket` in tuned_policy.cuh
+  int shape_bucket;
+  int vec_len;
+};
+"""
+
+FOOTER = """
+}  // namespace raft::distance::detail
+"""
+
+
+def load_timings(filenames):
+    """Returns {(op, data_bytes, sm, bucket): {shape: {vec_len: time}}}"""
+    timings = defaultdict(lambda: defaultdict(dict))
+    for filename in filenames:
+        with open(filename) as f:
+            benchmarks = json.load(f)["benchmarks"]
+        for bench in benchmarks:
+            if not bench["name"].startswith("tuning_bench"):
+                continue
+            if bench.get("run_type", "iteration") != "iteration":
+                continue
+            fields = bench["label"].split("#")
+            op = fields[0]
+            shape = tuple(fields[2:])
+            key = (
+                op,
+                int(bench["data_bytes"]),
+                int(bench["sm"]),
+                int(bench["shape_bucket"]),
+            )
+            timings[key][shape][int(bench["vec_len"])] = bench["real_time"]
+    return timings
+
+
+def best_vec_len(shapes):
+    """The vec_len with the smallest geometric mean of the times relative to
+    the fastest vec_len of each shape."""
+    log_ratio = defaultdict(float)
+    count = defaultdict(int)
+    for times in shapes.values():
+        fastest = min(times.values())
+        for vec_len, time in times.items():
+            log_ratio[vec_len] += math.log(time / fastest)
+            count[vec_len] += 1
+    # Only compare the vec_len measured on every shape of the bucket
+    n_shapes = max(count.values())
+    candidates = [v for v in log_ratio if count[v] == n_shapes]
+    return min(candidates, key=lambda v: (log_ratio[v], -v))
+
+
+def generate(timings):
+    entries = [
+        (op, data_bytes, sm, bucket, best_vec_len(shapes))
+        for (op, data_bytes, sm, bucket), shapes in sorted(timings.items())
+    ]
+    declaration = (
+        "inline constexpr std::array<tuned_policy_entry, %d> tuned_policy_table"
+        % len(entries)
+    )
+    lines = [HEADER]
+    if entries:
+        lines.append(declaration + "{{")
+        for op, data_bytes, sm, bucket, vec_len in entries:
+            lines.append(
+                '  {"%s", %d, %d, %d, %d},'
+                % (op, data_bytes, sm, bucket, vec_len)
+            )
+        lines.append("}};")
+    else:
+        lines.append(declaration + "{};")
+    lines.append(FOOTER)
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument(
+        "inputs", nargs="+", help="JSON outputs of the TUNE_DISTANCE benchmark"
+    )
+    parser.add_argument(
+        "--output", default=DEFAULT_OUTPUT, help="the generated header"
+    )
+    args = parser.parse_args()
+
+    with open(args.output, "w") as f:
+        f.write(generate(load_timings(args.inputs)))
+
+
+if __name__ == "__main__":
+    main()
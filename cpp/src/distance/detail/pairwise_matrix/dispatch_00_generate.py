@@ -93,12 +93,12 @@ op_instances = [
     dict(
         path_prefix="cosine",
         OpT="raft::distance::detail::ops::cosine_distance_op",
-        archs = [60, 80],
+        archs = [60, 80, 90],
     ),
     dict(
         path_prefix="dice",
         OpT="raft::distance::detail::ops::dice_distance_op",
-        archs = [60, 80],
+        archs = [60, 80, 90],
     ),
     dict(
         path_prefix="hamming_unexpanded",
@@ -108,7 +108,7 @@ op_instances = [
     dict(
         path_prefix="hellinger_expanded",
         OpT="raft::distance::detail::ops::hellinger_distance_op",
-        archs = [60],
+        archs = [60, 80, 90],
     ),
     # inner product is handled by cublas.
     dict(
@@ -129,7 +129,7 @@ op_instances = [
     dict(
         path_prefix="l2_expanded",
         OpT="raft::distance::detail::ops::l2_exp_distance_op",
-        archs = [60, 80],
+        archs = [60, 80, 90],
     ),
     dict(
         path_prefix="l2_unexpanded",
@@ -149,7 +149,7 @@ op_instances = [
     dict(
         path_prefix="russel_rao",
         OpT="raft::distance::detail::ops::russel_rao_distance_op",
-        archs = [60],
+        archs = [60, 80, 90],
      ),
 ]
 
@@ -27,6 +27,8 @@
 #include <raft/distance/detail/distance_ops/all_ops.cuh>          // ops::*
 #include <raft/distance/detail/pairwise_matrix/dispatch-inl.cuh>  // dispatch
 #include <raft/distance/detail/pairwise_matrix/dispatch_sm60.cuh>
+#include <raft/distance/detail/pairwise_matrix/dispatch_sm80.cuh>
+#include <raft/distance/detail/pairwise_matrix/dispatch_sm90.cuh>
 #define instantiate_raft_distance_detail_pairwise_matrix_dispatch(                     \
   OpT, DataT, AccT, OutT, FinOpT, IdxT)                                                \
   template void raft::distance::detail::                                               \
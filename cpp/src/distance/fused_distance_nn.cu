@@ -51,3 +51,24 @@ instantiate_raft_distance_fusedDistanceNNMinReduce(float,
 #undef COMMA
 
 #undef instantiate_raft_distance_fusedDistanceNNMinReduce
+
+#define instantiate_raft_distance_fusedDistanceNNTopK(DataT, IdxT) \
+  template void raft::distance::fusedDistanceNNTopK<DataT, IdxT>(  \
+    IdxT * out_idx,                                                \
+    DataT * out_dist,                                              \
+    const DataT* x,                                                \
+    const DataT* y,                                                \
+    const DataT* xn,                                               \
+    const DataT* yn,                                               \
+    IdxT m,                                                        \
+    IdxT n,                                                        \
+    IdxT k,                                                        \
+    int topk,                                                      \
+    bool isRowMajor,                                               \
+    raft::distance::DistanceType metric,                           \
+    cudaStream_t stream)
+
+instantiate_raft_distance_fusedDistanceNNTopK(float, int);
+instantiate_raft_distance_fusedDistanceNNTopK(float, int64_t);
+
+#undef instantiate_raft_distance_fusedDistanceNNTopK
@@ -23,6 +23,11 @@
     raft::resources const& handle,                                                                 \
     raft::neighbors::ball_cover::BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index);      \
                                                                                                    \
+  template void raft::neighbors::ball_cover::extend<idx_t, value_t, int_t, matrix_idx_t>(          \
+    raft::resources const& handle,                                                                 \
+    raft::neighbors::ball_cover::BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index,       \
+    raft::device_matrix_view<const value_t, matrix_idx_t, row_major> X);                           \
+                                                                                                   \
   template void raft::neighbors::ball_cover::eps_nn<idx_t, value_t, int_t, matrix_idx_t>(          \
     raft::resources const& handle,                                                                 \
     const raft::neighbors::ball_cover::BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index, \
@@ -48,7 +53,8 @@
     idx_t* inds,                                                                                   \
     value_t* dists,                                                                                \
     bool perform_post_filtering,                                                                   \
-    float weight);                                                                                 \
+    float weight,                                                                                  \
+    int_t n_probes);                                                                               \
                                                                                                    \
   template void raft::neighbors::ball_cover::all_knn_query<idx_t, value_t, int_t, matrix_idx_t>(   \
     raft::resources const& handle,                                                                 \
@@ -57,7 +63,8 @@
     raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,                              \
     int_t k,                                                                                       \
     bool perform_post_filtering,                                                                   \
-    float weight);                                                                                 \
+    float weight,                                                                                  \
+    int_t n_probes);                                                                               \
                                                                                                    \
   template void raft::neighbors::ball_cover::knn_query<idx_t, value_t, int_t, matrix_idx_t>(       \
     raft::resources const& handle,                                                                 \
@@ -68,7 +75,8 @@
     idx_t* inds,                                                                                   \
     value_t* dists,                                                                                \
     bool perform_post_filtering,                                                                   \
-    float weight);                                                                                 \
+    float weight,                                                                                  \
+    int_t n_probes);                                                                               \
                                                                                                    \
   template void raft::neighbors::ball_cover::knn_query<idx_t, value_t, int_t, matrix_idx_t>(       \
     raft::resources const& handle,                                                                 \
@@ -78,7 +86,8 @@
     raft::device_matrix_view<value_t, matrix_idx_t, row_major> dists,                              \
     int_t k,                                                                                       \
     bool perform_post_filtering,                                                                   \
-    float weight);
+    float weight,
+    int_t n_probes);
 
 instantiate_raft_neighbors_ball_cover(int64_t, float, int64_t, int64_t);
 
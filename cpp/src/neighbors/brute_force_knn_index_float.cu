@@ -15,6 +15,8 @@
  * limitations under the License.
  */
 
+#include <raft/core/bitmap.hpp>
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/resources.hpp>
@@ -52,6 +54,20 @@ template void raft::neighbors::brute_force::search<float, int64_t>(
   raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
   raft::device_matrix_view<float, int64_t, row_major> distances);
 
+template void raft::neighbors::brute_force::search<float, int>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::host_matrix_view<const float, int64_t, row_major> queries,
+  raft::host_matrix_view<int, int64_t, row_major> neighbors,
+  raft::host_matrix_view<float, int64_t, row_major> distances);
+
+template void raft::neighbors::brute_force::search<float, int64_t>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::host_matrix_view<const float, int64_t, row_major> queries,
+  raft::host_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::host_matrix_view<float, int64_t, row_major> distances);
+
 template raft::neighbors::brute_force::index<float> raft::neighbors::brute_force::
   build<float, raft::host_matrix_view<const float, int64_t, raft::row_major>::accessor_type>(
     raft::resources const& res,
@@ -77,3 +93,28 @@ template raft::neighbors::brute_force::index<float> raft::neighbors::brute_force
     raft::resources const& res,
     raft::neighbors::brute_force::index_params const& params,
     raft::device_matrix_view<const float, int64_t, raft::row_major> dataset);
+
+template void raft::neighbors::brute_force::knn_host_dataset<float, int64_t>(
+  raft::resources const& res,
+  raft::host_matrix_view<const float, int64_t, row_major> dataset,
+  raft::device_matrix_view<const float, int64_t, row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, row_major> distances,
+  raft::distance::DistanceType metric,
+  float metric_arg,
+  int64_t tile_rows);
+
+template void raft::neighbors::brute_force::range_search<float, int64_t>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::device_matrix_view<const float, int64_t, raft::row_major> queries,
+  float radius,
+  raft::device_sparsity_owning_csr_matrix<float, int64_t, int64_t, int64_t>& out);
+
+template void raft::neighbors::brute_force::search_with_filtering<float, int64_t>(
+  raft::resources const& res,
+  const raft::neighbors::brute_force::index<float>& idx,
+  raft::device_matrix_view<const float, int64_t, raft::row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, raft::row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, raft::row_major> distances,
+  raft::core::bitmap_view<const uint32_t, int64_t> filter);
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force-inl.cuh>
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <cstdint>
+#include <optional>
+
+template void raft::neighbors::brute_force::knn_low_precision<half, int64_t>(
+  raft::resources const& res,
+  raft::device_matrix_view<const half, int64_t, raft::row_major> dataset,
+  raft::device_matrix_view<const half, int64_t, raft::row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, raft::row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, raft::row_major> distances,
+  raft::distance::DistanceType metric,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms);
+
+template void raft::neighbors::brute_force::knn_low_precision<nv_bfloat16, int64_t>(
+  raft::resources const& res,
+  raft::device_matrix_view<const nv_bfloat16, int64_t, raft::row_major> dataset,
+  raft::device_matrix_view<const nv_bfloat16, int64_t, raft::row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, raft::row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, raft::row_major> distances,
+  raft::distance::DistanceType metric,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms);
+
+template void raft::neighbors::brute_force::knn_low_precision<int8_t, int64_t>(
+  raft::resources const& res,
+  raft::device_matrix_view<const int8_t, int64_t, raft::row_major> dataset,
+  raft::device_matrix_view<const int8_t, int64_t, raft::row_major> queries,
+  raft::device_matrix_view<int64_t, int64_t, raft::row_major> neighbors,
+  raft::device_matrix_view<float, int64_t, raft::row_major> distances,
+  raft::distance::DistanceType metric,
+  std::optional<raft::device_vector_view<const float, int64_t>> dataset_norms);
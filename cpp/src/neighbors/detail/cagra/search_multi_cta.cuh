@@ -23,6 +23,7 @@ namespace raft::neighbors::cagra::detail::multi_cta_search {
   template void select_and_run<TEAM_SIZE, MAX_DATASET_DIM, DATASET_DESC_T, SAMPLE_FILTER_T>(      \
     DATASET_DESC_T dataset_desc,                                                                  \
     raft::device_matrix_view<const typename DATASET_DESC_T::INDEX_T, int64_t, row_major> graph,   \
+    uint32_t graph_id_bits,                                                                       \
     typename DATASET_DESC_T::INDEX_T* const topk_indices_ptr,                                     \
     typename DATASET_DESC_T::DISTANCE_T* const topk_distances_ptr,                                \
     const typename DATASET_DESC_T::DATA_T* const queries_ptr,                                     \
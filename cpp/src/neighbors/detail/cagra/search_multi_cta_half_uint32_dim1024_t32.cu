@@ -33,5 +33,10 @@ instantiate_kernel_selection(
   1024,
   raft::neighbors::cagra::detail::standard_dataset_descriptor_t<half COMMA uint32_t COMMA float>,
   raft::neighbors::filtering::none_cagra_sample_filter);
+instantiate_kernel_selection(
+  32,
+  1024,
+  raft::neighbors::cagra::detail::standard_dataset_descriptor_t<half COMMA uint32_t COMMA float>,
+  raft::neighbors::filtering::removed_cagra_sample_filter);
 
 }  // namespace raft::neighbors::cagra::detail::multi_cta_search
@@ -23,6 +23,7 @@ namespace raft::neighbors::cagra::detail::single_cta_search {
   template void select_and_run<TEAM_SIZE, MAX_DATASET_DIM, DATASET_DESC_T, SAMPLE_FILTER_T>(      \
     DATASET_DESC_T dataset_desc,                                                                  \
     raft::device_matrix_view<const typename DATASET_DESC_T::INDEX_T, int64_t, row_major> graph,   \
+    uint32_t graph_id_bits,                                                                       \
     typename DATASET_DESC_T::INDEX_T* const topk_indices_ptr,                                     \
     typename DATASET_DESC_T::DISTANCE_T* const topk_distances_ptr,                                \
     const typename DATASET_DESC_T::DATA_T* const queries_ptr,                                     \
@@ -46,6 +47,8 @@ namespace raft::neighbors::cagra::detail::single_cta_search {
     size_t max_iterations,                                                                        \
     SAMPLE_FILTER_T sample_filter,                                                                \
     raft::distance::DistanceType metric,                                                          \
+    bool persistent,                                                                              \
+    float persistent_lifetime,                                                                    \
     cudaStream_t stream);
 
 #define COMMA ,
@@ -49,6 +49,8 @@ trailer = """
 """
 
 mxdim_team = [(128, 8), (256, 16), (512, 32), (1024, 32)]
+# the removed filter is applied automatically when samples have been removed from the index
+sample_filters = ["none_cagra_sample_filter", "removed_cagra_sample_filter"]
 # block = [(64, 16), (128, 8), (256, 4), (512, 2), (1024, 1)]
 # itopk_candidates = [64, 128, 256]
 # itopk_size = [64, 128, 256, 512]
@@ -73,9 +75,10 @@ for type_path, (data_t, idx_t, distance_t) in search_types.items():
         path = f"search_single_cta_{type_path}_dim{mxdim}_t{team}.cu"
         with open(path, "w") as f:
             f.write(header)
-            f.write(
-                    f"instantiate_kernel_selection(\n  {team}, {mxdim}, raft::neighbors::cagra::detail::standard_dataset_descriptor_t<{data_t} COMMA {idx_t} COMMA  {distance_t}>, raft::neighbors::filtering::none_cagra_sample_filter);\n"
-            )
+            for sample_filter in sample_filters:
+                f.write(
+                        f"instantiate_kernel_selection(\n  {team}, {mxdim}, raft::neighbors::cagra::detail::standard_dataset_descriptor_t<{data_t} COMMA {idx_t} COMMA  {distance_t}>, raft::neighbors::filtering::{sample_filter});\n"
+                )
 
             f.write(trailer)
             # For pasting into CMakeLists.txt
@@ -41,6 +41,6 @@
     rmm::cuda_stream_view stream)
 
 instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
-  half, half, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+  half, float, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan
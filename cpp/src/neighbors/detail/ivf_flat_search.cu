@@ -19,6 +19,8 @@
 
 #include <rmm/resource_ref.hpp>
 
+#include <cuda_fp16.h>
+
 #define instantiate_raft_neighbors_ivf_flat_detail_search(T, IdxT, IvfSampleFilterT)  \
   template void raft::neighbors::ivf_flat::detail::search<T, IdxT, IvfSampleFilterT>( \
     raft::resources const& handle,                                                    \
@@ -34,9 +36,15 @@
 
 instantiate_raft_neighbors_ivf_flat_detail_search(
   float, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+instantiate_raft_neighbors_ivf_flat_detail_search(
+  half, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_search(
   int8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_search(
   uint8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+instantiate_raft_neighbors_ivf_flat_detail_search(
+  float, int64_t, raft::neighbors::filtering::label_exclusion_ivf_sample_filter<int>);
+instantiate_raft_neighbors_ivf_flat_detail_search(
+  float, int64_t, raft::neighbors::filtering::label_exclusion_ivf_sample_filter<int64_t>);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_search
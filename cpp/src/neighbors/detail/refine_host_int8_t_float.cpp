@@ -18,6 +18,7 @@
 
 #define instantiate_raft_neighbors_refine(IdxT, DataT, DistanceT, ExtentsT)             \
   template void raft::neighbors::detail::refine_host<IdxT, DataT, DistanceT, ExtentsT>( \
+    raft::resources const& res,                                                         \
     raft::host_matrix_view<const DataT, ExtentsT, row_major> dataset,                   \
     raft::host_matrix_view<const DataT, ExtentsT, row_major> queries,                   \
     raft::host_matrix_view<const IdxT, ExtentsT, row_major> neighbor_candidates,        \
@@ -42,6 +42,7 @@ header = """/*
 
 types = dict(
     float_int64_t=("float", "int64_t"),
+    half_int64_t=("half", "int64_t"),
     int8_t_int64_t=("int8_t", "int64_t"),
     uint8_t_int64_t=("uint8_t", "int64_t"),
 )
@@ -144,7 +145,15 @@ search_macro = """
     const raft::neighbors::ivf_flat::index<T, IdxT>& index,        \\
     raft::device_matrix_view<const T, IdxT, row_major> queries,    \\
     raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,     \\
-    raft::device_matrix_view<float, IdxT, row_major> distances);
+    raft::device_matrix_view<float, IdxT, row_major> distances);   \\
+                                                                   \\
+  template void raft::neighbors::ivf_flat::search<T, IdxT>(        \\
+    raft::resources const& handle,                                 \\
+    const raft::neighbors::ivf_flat::search_params& params,        \\
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,        \\
+    raft::host_matrix_view<const T, IdxT, row_major> queries,      \\
+    raft::host_matrix_view<IdxT, IdxT, row_major> neighbors,       \\
+    raft::host_matrix_view<float, IdxT, row_major> distances);
 """
 
 macros = dict(
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft/neighbors/ivf_flat-inl.cuh>
+
+#define instantiate_raft_neighbors_ivf_flat_remove(T, IdxT) \
+  template auto raft::neighbors::ivf_flat::remove<T, IdxT>( \
+    raft::resources const& handle,                          \
+    raft::device_vector_view<const IdxT, IdxT> ids,         \
+    raft::neighbors::ivf_flat::index<T, IdxT>* index)       \
+    ->IdxT;
+
+instantiate_raft_neighbors_ivf_flat_remove(float, int64_t);
+instantiate_raft_neighbors_ivf_flat_remove(half, int64_t);
+instantiate_raft_neighbors_ivf_flat_remove(int8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_remove(uint8_t, int64_t);
+
+#undef instantiate_raft_neighbors_ivf_flat_remove
@@ -30,6 +30,12 @@
     std::optional<raft::device_vector_view<const IdxT, IdxT, row_major>> new_indices,     \
     raft::neighbors::ivf_pq::index<IdxT>* idx);                                           \
                                                                                           \
+  template void raft::neighbors::ivf_pq::extend<T, IdxT>(                                 \
+    raft::resources const& handle,                                                        \
+    raft::device_matrix_view<const T, IdxT, row_major> new_vectors,                       \
+    std::optional<raft::device_vector_view<const IdxT, IdxT, row_major>> new_indices,     \
+    raft::neighbors::ivf_pq::versioned_index<IdxT>* idx);                                 \
+                                                                                          \
   template auto raft::neighbors::ivf_pq::extend<T, IdxT>(                                 \
     raft::resources const& handle,                                                        \
     const raft::neighbors::ivf_pq::index<IdxT>& idx,                                      \
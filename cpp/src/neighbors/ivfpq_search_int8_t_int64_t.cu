@@ -36,7 +36,15 @@
     uint32_t n_queries,                                              \
     uint32_t k,                                                      \
     IdxT* neighbors,                                                 \
-    float* distances)
+    float* distances);                                               \
+                                                                     \
+  template void raft::neighbors::ivf_pq::search<T, IdxT>(            \
+    raft::resources const& handle,                                   \
+    const raft::neighbors::ivf_pq::search_params& params,            \
+    const raft::neighbors::ivf_pq::index<IdxT>& idx,                 \
+    raft::host_matrix_view<const T, uint32_t, row_major> queries,    \
+    raft::host_matrix_view<IdxT, uint32_t, row_major> neighbors,     \
+    raft::host_matrix_view<float, uint32_t, row_major> distances)
 
 instantiate_raft_neighbors_ivf_pq_search(int8_t, int64_t);
 
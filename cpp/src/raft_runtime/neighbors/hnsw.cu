@@ -14,32 +14,19 @@
  * limitations under the License.
  */
 
+#include <raft/neighbors/detail/hnsw_from_cagra.cuh>
 #include <raft/neighbors/hnsw.hpp>
 #include <raft/neighbors/hnsw_serialize.hpp>
 
-#include <raft_runtime/neighbors/cagra.hpp>
 #include <raft_runtime/neighbors/hnsw.hpp>
 
-#include <filesystem>
-#include <random>
-#include <string>
-
 namespace raft::neighbors::hnsw {
 #define RAFT_INST_HNSW(T)                                                               \
   template <>                                                                           \
   std::unique_ptr<raft::neighbors::hnsw::index<T>> from_cagra(                          \
     raft::resources const& res, raft::neighbors::cagra::index<T, uint32_t> cagra_index) \
   {                                                                                     \
-    std::random_device dev;                                                             \
-    std::mt19937 rng(dev());                                                            \
-    std::uniform_int_distribution<std::mt19937::result_type> dist(0);                   \
-    auto uuid            = std::to_string(dist(rng));                                   \
-    std::string filepath = "/tmp/" + uuid + ".bin";                                     \
-    raft::runtime::neighbors::cagra::serialize_to_hnswlib(res, filepath, cagra_index);  \
-    auto hnsw_index = raft::runtime::neighbors::hnsw::deserialize_file<T>(              \
-      res, filepath, cagra_index.dim(), cagra_index.metric());                          \
-    std::filesystem::remove(filepath);                                                  \
-    return hnsw_index;                                                                  \
+    return raft::neighbors::hnsw::detail::from_cagra<T, uint32_t>(res, cagra_index);    \
   }
 
 RAFT_INST_HNSW(float);
@@ -51,6 +38,13 @@ RAFT_INST_HNSW(uint8_t);
 namespace raft::runtime::neighbors::hnsw {
 
 #define RAFT_INST_HNSW(T)                                                                   \
+  std::unique_ptr<raft::neighbors::hnsw::index<T>> from_cagra(                              \
+    raft::resources const& res,                                                             \
+    const raft::neighbors::cagra::index<T, uint32_t>& cagra_index)                          \
+  {                                                                                         \
+    return raft::neighbors::hnsw::detail::from_cagra<T, uint32_t>(res, cagra_index);        \
+  }                                                                                         \
+                                                                                            \
   void search(raft::resources const& handle,                                                \
               raft::neighbors::hnsw::search_params const& params,                           \
               const raft::neighbors::hnsw::index<T>& index,                                 \
@@ -49,6 +49,31 @@ namespace raft::runtime::neighbors::ivf_pq {
               raft::neighbors::ivf_pq::index<IdxT>* idx)                                    \
   {                                                                                         \
     raft::neighbors::ivf_pq::extend<T, IdxT>(handle, new_vectors, new_indices, idx);        \
+  }                                                                                         \
+  void build(raft::resources const& handle,                                                 \
+             const raft::neighbors::ivf_pq::index_params& params,                           \
+             raft::host_matrix_view<const T, IdxT, row_major> dataset,                      \
+             raft::neighbors::ivf_pq::index<IdxT>* idx)                                     \
+  {                                                                                         \
+    *idx = raft::neighbors::ivf_pq::build<T, IdxT>(                                         \
+      handle, params, dataset.data_handle(), dataset.extent(0), dataset.extent(1));         \
+  }                                                                                         \
+  void extend(raft::resources const& handle,                                                \
+              raft::host_matrix_view<const T, IdxT, row_major> new_vectors,                 \
+              std::optional<raft::host_vector_view<const IdxT, IdxT>> new_indices,          \
+              raft::neighbors::ivf_pq::index<IdxT>* idx)                                    \
+  {                                                                                         \
+    RAFT_EXPECTS(new_vectors.extent(1) == idx->dim(),                                       \
+                 "new_vectors should have the same dimension as the index");                \
+    RAFT_EXPECTS(!new_indices.has_value() ||                                                \
+                   new_indices->extent(0) == new_vectors.extent(0),                         \
+                 "new_vectors and new_indices have different number of rows");              \
+    raft::neighbors::ivf_pq::extend<T, IdxT>(                                               \
+      handle,                                                                               \
+      idx,                                                                                  \
+      new_vectors.data_handle(),                                                            \
+      new_indices.has_value() ? new_indices->data_handle() : nullptr,                       \
+      new_vectors.extent(0));                                                               \
   }
 
 RAFT_INST_BUILD_EXTEND(float, int64_t);
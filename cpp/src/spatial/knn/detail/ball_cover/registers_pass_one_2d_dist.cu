@@ -36,6 +36,7 @@
       const Mvalue_t* query,                                                      \
       const Mvalue_int n_query_rows,                                              \
       Mvalue_int k,                                                               \
+      Mvalue_int n_probes,                                                        \
       const Mvalue_idx* R_knn_inds,                                               \
       const Mvalue_t* R_knn_dists,                                                \
       Mdist_func<Mvalue_t, Mvalue_int>& dfunc,                                    \
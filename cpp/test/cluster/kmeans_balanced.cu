@@ -21,17 +21,24 @@
 #include <raft/core/handle.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/deadline.hpp>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/random/make_blobs.cuh>
+#include <raft/random/rng.cuh>
 #include <raft/stats/adjusted_rand_index.cuh>
 #include <raft/util/cuda_utils.cuh>
 
+#include <rmm/cuda_stream_pool.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <cuda_fp16.h>
 #include <thrust/fill.h>
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -49,6 +56,8 @@ struct KmeansBalancedInputs {
   IdxT n_clusters;
   raft::cluster::kmeans_balanced_params kb_params;
   MathT tol;
+  // the size of the stream pool, to train the fine clusters concurrently
+  size_t n_streams = 0;
 };
 
 template <typename MathT, typename IdxT>
@@ -75,6 +84,9 @@ class KmeansBalancedTest : public ::testing::TestWithParam<KmeansBalancedInputs<
     MappingOpT op{};
 
     auto p = ::testing::TestWithParam<KmeansBalancedInputs<MathT, IdxT>>::GetParam();
+    if (p.n_streams > 0) {
+      resource::set_cuda_stream_pool(handle, std::make_shared<rmm::cuda_stream_pool>(p.n_streams));
+    }
 
     auto X           = raft::make_device_matrix<DataT, IdxT>(handle, p.n_rows, p.n_cols);
     auto blob_labels = raft::make_device_vector<IdxT, IdxT>(handle, p.n_rows);
@@ -153,10 +165,11 @@ class KmeansBalancedTest : public ::testing::TestWithParam<KmeansBalancedInputs<
 };
 
 template <typename MathT, typename IdxT>
-std::vector<KmeansBalancedInputs<MathT, IdxT>> get_kmeans_balanced_inputs()
+std::vector<KmeansBalancedInputs<MathT, IdxT>> get_kmeans_balanced_inputs(size_t n_streams = 0)
 {
   std::vector<KmeansBalancedInputs<MathT, IdxT>> out;
   KmeansBalancedInputs<MathT, IdxT> p;
+  p.n_streams         = n_streams;
   p.kb_params.n_iters = 20;
   p.kb_params.metric  = raft::distance::DistanceType::L2Expanded;
   p.tol               = MathT{0.0001};
@@ -180,6 +193,9 @@ const auto inputsd_i32 = get_kmeans_balanced_inputs<double, int>();
 const auto inputsf_i64 = get_kmeans_balanced_inputs<float, int64_t>();
 const auto inputsd_i64 = get_kmeans_balanced_inputs<double, int64_t>();
 
+// the fine clusters are trained concurrently on the streams of the pool
+const auto inputsf_i32_pool = get_kmeans_balanced_inputs<float, int>(4);
+
 #define KB_TEST(test_type, test_name, test_inputs)         \
   typedef RAFT_DEPAREN(test_type) test_name;               \
   TEST_P(test_name, Result) { ASSERT_TRUE(score == 1.0); } \
@@ -213,6 +229,9 @@ KB_TEST((KmeansBalancedTest<float, float, int64_t, int, raft::identity_op>),
 KB_TEST((KmeansBalancedTest<float, float, int64_t, int64_t, raft::identity_op>),
         KmeansBalancedTestFFI64I64,
         inputsf_i64);
+KB_TEST((KmeansBalancedTest<float, float, uint32_t, int, raft::identity_op>),
+        KmeansBalancedTestFFU32I32Pool,
+        inputsf_i32_pool);
 
 /*
  * Second set of tests: integer dataset with conversion
@@ -237,4 +256,41 @@ KB_TEST((KmeansBalancedTest<int8_t, double, uint32_t, int, i2f_scaler<int8_t, do
         KmeansBalancedTestDI8U32I32,
         inputsd_i32);
 
+/*
+ * Third set of tests: half-precision dataset with conversion
+ */
+
+template <typename MathT>
+struct h2f_cast {
+  const raft::cast_op<MathT> op{};
+  const raft::cast_op<half> reverse_op{};
+
+  RAFT_INLINE_FUNCTION auto operator()(const half& x) const { return op(x); };
+};
+
+KB_TEST((KmeansBalancedTest<half, float, uint32_t, int, h2f_cast<float>>),
+        KmeansBalancedTestFHU32I32,
+        inputsf_i32);
+
+TEST(KmeansBalancedDeadline, Expired)
+{
+  raft::resources handle;
+  auto X       = raft::make_device_matrix<float, int>(handle, 10000, 32);
+  auto centers = raft::make_device_matrix<float, int>(handle, 100, 32);
+  raft::random::RngState rng(1234ULL);
+  raft::random::uniform(handle, rng, X.data_handle(), X.size(), -1.0f, 1.0f);
+  raft::cluster::kmeans_balanced_params params;
+  params.n_iters = 20;
+
+  // the build stops at its first iteration once the deadline has passed
+  resource::set_deadline(handle, std::chrono::steady_clock::now());
+  ASSERT_THROW(raft::cluster::kmeans_balanced::fit(
+                 handle, params, raft::make_const_mdspan(X.view()), centers.view()),
+               raft::interrupted_exception);
+
+  resource::set_deadline(handle, std::nullopt);
+  ASSERT_NO_THROW(raft::cluster::kmeans_balanced::fit(
+    handle, params, raft::make_const_mdspan(X.view()), centers.view()));
+}
+
 }  // namespace raft
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/cluster/kmeans.cuh>
+#include <raft/core/cudart_utils.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/make_blobs.cuh>
+#include <raft/stats/adjusted_rand_index.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <optional>
+#include <vector>
+
+namespace raft {
+
+template <typename T>
+struct KmeansBoundsInputs {
+  int n_row;
+  int n_col;
+  int n_clusters;
+  bool sqrt_metric;
+  T tol;
+  bool inertia_check;
+  // the fit must stop on the tolerance, before max_iter, while the centroids still move
+  bool early_stop;
+};
+
+template <typename T>
+class KmeansBoundsTest : public ::testing::TestWithParam<KmeansBoundsInputs<T>> {
+ protected:
+  KmeansBoundsTest()
+    : stream(resource::get_cuda_stream(handle)),
+      d_labels(0, stream),
+      d_labels_ref(0, stream),
+      d_centroids(0, stream),
+      d_centroids_ref(0, stream)
+  {
+  }
+
+  void fit_predict(
+    bool use_bounds, T* centroids_ptr, int* labels_ptr, T& inertia, T& pred_inertia, int& n_iter)
+  {
+    auto p       = params;
+    p.use_bounds = use_bounds;
+    auto centroids =
+      raft::make_device_matrix_view<T, int>(centroids_ptr, params.n_clusters, X.extent(1));
+    // the same initial centroids for both fits: the first samples, as make_blobs shuffles them
+    raft::copy(centroids_ptr, X.data_handle(), centroids.size(), stream);
+    raft::cluster::kmeans_fit<T, int>(handle,
+                                      p,
+                                      raft::make_const_mdspan(X.view()),
+                                      std::nullopt,
+                                      centroids,
+                                      raft::make_host_scalar_view<T>(&inertia),
+                                      raft::make_host_scalar_view<int>(&n_iter));
+    raft::cluster::kmeans_predict<T, int>(
+      handle,
+      params,
+      raft::make_const_mdspan(X.view()),
+      std::nullopt,
+      raft::make_const_mdspan(centroids),
+      raft::make_device_vector_view<int, int>(labels_ptr, X.extent(0)),
+      true,
+      raft::make_host_scalar_view<T>(&pred_inertia));
+    resource::sync_stream(handle, stream);
+  }
+
+  void basicTest()
+  {
+    testparams = ::testing::TestWithParam<KmeansBoundsInputs<T>>::GetParam();
+
+    int n_samples     = testparams.n_row;
+    int n_features    = testparams.n_col;
+    params.n_clusters = testparams.n_clusters;
+    params.init       = raft::cluster::KMeansParams::InitMethod::Array;
+    params.max_iter      = 20;
+    params.tol           = testparams.tol;
+    params.inertia_check = testparams.inertia_check;
+    params.metric        = testparams.sqrt_metric ? raft::distance::DistanceType::L2SqrtExpanded
+                                                  : raft::distance::DistanceType::L2Expanded;
+
+    X = raft::make_device_matrix<T, int>(handle, n_samples, n_features);
+    d_labels.resize(n_samples, stream);
+    d_labels_ref.resize(n_samples, stream);
+    d_centroids.resize(params.n_clusters * n_features, stream);
+    d_centroids_ref.resize(params.n_clusters * n_features, stream);
+
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     d_labels.data(),
+                                     n_samples,
+                                     n_features,
+                                     params.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(1.0),
+                                     true,
+                                     (T)-10.0f,
+                                     (T)10.0f,
+                                     (uint64_t)1234);
+
+    fit_predict(false,
+                d_centroids_ref.data(),
+                d_labels_ref.data(),
+                inertia_ref,
+                pred_inertia_ref,
+                n_iter_ref);
+    fit_predict(true, d_centroids.data(), d_labels.data(), inertia, pred_inertia, n_iter);
+
+    score = raft::stats::adjusted_rand_index(
+      d_labels_ref.data(), d_labels.data(), n_samples, resource::get_cuda_stream(handle));
+    if (score < 1.0) { std::cout << "Score = " << score << '\n'; }
+  }
+
+  void SetUp() override { basicTest(); }
+
+ protected:
+  raft::resources handle;
+  cudaStream_t stream;
+  KmeansBoundsInputs<T> testparams;
+  raft::device_matrix<T, int> X = raft::make_device_matrix<T, int>(handle, 0, 0);
+  rmm::device_uvector<int> d_labels;
+  rmm::device_uvector<int> d_labels_ref;
+  rmm::device_uvector<T> d_centroids;
+  rmm::device_uvector<T> d_centroids_ref;
+  T inertia          = 0;
+  T inertia_ref      = 0;
+  T pred_inertia     = 0;
+  T pred_inertia_ref = 0;
+  int n_iter         = 0;
+  int n_iter_ref     = 0;
+  double score;
+  raft::cluster::KMeansParams params;
+};
+
+// The pruning is exact: from the same initial centroids, both fits find the same clusters.
+// The cases with a large tolerance stop while the centroids still move, so the final assignment
+// of the fit must account for the last move of the centroids.
+const std::vector<KmeansBoundsInputs<float>> inputsf2 = {
+  {1000, 16, 5, false, 1e-4, false, false},
+  {1000, 16, 5, true, 1e-4, false, false},
+  {10000, 32, 50, false, 1e-4, false, false},
+  {10000, 32, 50, true, 1e-4, false, false},
+  {20000, 8, 1000, false, 1e-4, false, false},
+  {10000, 16, 100, false, 10.0, false, true},
+  {10000, 16, 100, true, 1.0, false, true},
+  {10000, 16, 100, false, 1e-2, true, true}};
+
+const std::vector<KmeansBoundsInputs<double>> inputsd2 = {
+  {1000, 16, 5, false, 1e-4, false, false},
+  {1000, 16, 5, true, 1e-4, false, false},
+  {10000, 32, 50, false, 1e-4, false, false},
+  {20000, 8, 1000, true, 1e-4, false, false},
+  {10000, 16, 100, false, 10.0, false, true},
+  {10000, 16, 100, false, 1e-2, true, true}};
+
+typedef KmeansBoundsTest<float> KmeansBoundsTestF;
+TEST_P(KmeansBoundsTestF, Result)
+{
+  ASSERT_GT(score, 0.99);
+  if (testparams.early_stop) { ASSERT_LT(n_iter, params.max_iter); }
+  ASSERT_NEAR(inertia, inertia_ref, 1e-3 * std::abs(inertia_ref));
+  // The inertia of the fit is the cost of the exact assignment to the final centroids.
+  ASSERT_NEAR(inertia, pred_inertia, 1e-3 * std::abs(pred_inertia));
+}
+
+typedef KmeansBoundsTest<double> KmeansBoundsTestD;
+TEST_P(KmeansBoundsTestD, Result)
+{
+  ASSERT_GT(score, 0.99);
+  if (testparams.early_stop) { ASSERT_LT(n_iter, params.max_iter); }
+  ASSERT_NEAR(inertia, inertia_ref, 1e-6 * std::abs(inertia_ref));
+  ASSERT_NEAR(inertia, pred_inertia, 1e-6 * std::abs(pred_inertia));
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansBoundsTests, KmeansBoundsTestF, ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(KmeansBoundsTests, KmeansBoundsTestD, ::testing::ValuesIn(inputsd2));
+
+}  // namespace raft
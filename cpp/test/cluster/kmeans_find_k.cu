@@ -19,12 +19,16 @@
 #include <raft/cluster/kmeans.cuh>
 #include <raft/core/cudart_utils.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/random/make_blobs.cuh>
 #include <raft/util/cuda_utils.cuh>
 
+#include <rmm/cuda_stream_pool.hpp>
+
 #include <gtest/gtest.h>
 
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -37,6 +41,8 @@ struct KmeansFindKInputs {
   int n_clusters;
   T tol;
   bool weighted;
+  // the size of the stream pool, to fit the candidates ahead
+  size_t n_streams = 0;
 };
 
 template <typename T>
@@ -50,6 +56,10 @@ class KmeansFindKTest : public ::testing::TestWithParam<KmeansFindKInputs<T>> {
   void basicTest()
   {
     testparams = ::testing::TestWithParam<KmeansFindKInputs<T>>::GetParam();
+    if (testparams.n_streams > 0) {
+      resource::set_cuda_stream_pool(handle,
+                                     std::make_shared<rmm::cuda_stream_pool>(testparams.n_streams));
+    }
 
     int n_samples  = testparams.n_row;
     int n_features = testparams.n_col;
@@ -116,6 +126,11 @@ const std::vector<KmeansFindKInputs<double>> inputsd2 = {{1000, 32, 5, 0.0001, t
                                                          {10000, 500, 100, 0.0001, true},
                                                          {10000, 500, 100, 0.0001, false}};
 
+// the same searches, with the candidates fit ahead on a stream pool
+const std::vector<KmeansFindKInputs<float>> inputsf2_pool = {{1000, 32, 8, 0.001f, false, 2},
+                                                             {10000, 32, 10, 0.001f, false, 2},
+                                                             {10000, 100, 50, 0.001f, false, 4}};
+
 typedef KmeansFindKTest<float> KmeansFindKTestF;
 TEST_P(KmeansFindKTestF, Result)
 {
@@ -139,4 +154,6 @@ INSTANTIATE_TEST_CASE_P(KmeansFindKTests, KmeansFindKTestF, ::testing::ValuesIn(
 
 INSTANTIATE_TEST_CASE_P(KmeansFindKTests, KmeansFindKTestD, ::testing::ValuesIn(inputsd2));
 
+INSTANTIATE_TEST_CASE_P(KmeansFindKPoolTests, KmeansFindKTestF, ::testing::ValuesIn(inputsf2_pool));
+
 }  // namespace raft
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../loopback_comms.hpp"
+#include "../test_utils.cuh"
+
+#include <raft/cluster/kmeans.cuh>
+#include <raft/cluster/kmeans_mg.cuh>
+#include <raft/core/comms.hpp>
+#include <raft/core/cudart_utils.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/make_blobs.cuh>
+#include <raft/stats/adjusted_rand_index.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace raft {
+
+template <typename T>
+struct KmeansMGInputs {
+  int n_row;
+  int n_col;
+  int n_clusters;
+  T tol;
+  bool weighted;
+};
+
+template <typename T>
+class KmeansMGTest : public ::testing::TestWithParam<KmeansMGInputs<T>> {
+ protected:
+  KmeansMGTest()
+    : stream(resource::get_cuda_stream(handle)),
+      d_labels(0, stream),
+      d_labels_ref(0, stream),
+      d_centroids(0, stream),
+      d_centroids_ref(0, stream)
+  {
+    resource::set_comms(handle,
+                        std::make_shared<comms::comms_t>(std::make_unique<loopback_comms>()));
+  }
+
+  void basicTest()
+  {
+    testparams = ::testing::TestWithParam<KmeansMGInputs<T>>::GetParam();
+
+    int n_samples              = testparams.n_row;
+    int n_features             = testparams.n_col;
+    params.n_clusters          = testparams.n_clusters;
+    params.tol                 = testparams.tol;
+    params.n_init              = 5;
+    params.rng_state.seed      = 1;
+    params.oversampling_factor = 2.0;
+
+    auto X = raft::make_device_matrix<T, int>(handle, n_samples, n_features);
+    d_labels.resize(n_samples, stream);
+    d_labels_ref.resize(n_samples, stream);
+    d_centroids.resize(params.n_clusters * n_features, stream);
+    d_centroids_ref.resize(params.n_clusters * n_features, stream);
+
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     d_labels_ref.data(),
+                                     n_samples,
+                                     n_features,
+                                     params.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(1.0),
+                                     false,
+                                     (T)-10.0f,
+                                     (T)10.0f,
+                                     (uint64_t)1234);
+    auto X_view = raft::make_const_mdspan(X.view());
+
+    rmm::device_uvector<T> d_sample_weight(0, stream);
+    std::optional<raft::device_vector_view<const T, int>> d_sw = std::nullopt;
+    if (testparams.weighted) {
+      d_sample_weight.resize(n_samples, stream);
+      thrust::fill(thrust::cuda::par.on(stream),
+                   d_sample_weight.data(),
+                   d_sample_weight.data() + n_samples,
+                   2);
+      d_sw = std::make_optional(
+        raft::make_device_vector_view<const T, int>(d_sample_weight.data(), n_samples));
+    }
+
+    auto centroids =
+      raft::make_device_matrix_view<T, int>(d_centroids.data(), params.n_clusters, n_features);
+    T inertia  = 0;
+    int n_iter = 0;
+    raft::cluster::kmeans::fit_mg<T, int>(handle,
+                                          params,
+                                          X_view,
+                                          d_sw,
+                                          centroids,
+                                          raft::make_host_scalar_view<T>(&inertia),
+                                          raft::make_host_scalar_view<int>(&n_iter));
+
+    T pred_inertia = 0;
+    raft::cluster::kmeans_predict<T, int>(
+      handle,
+      params,
+      X_view,
+      d_sw,
+      raft::make_const_mdspan(centroids),
+      raft::make_device_vector_view<int, int>(d_labels.data(), n_samples),
+      true,
+      raft::make_host_scalar_view<T>(&pred_inertia));
+    resource::sync_stream(handle, stream);
+
+    score = raft::stats::adjusted_rand_index(
+      d_labels_ref.data(), d_labels.data(), n_samples, resource::get_cuda_stream(handle));
+    if (score < 1.0) { std::cout << "Score = " << score << '\n'; }
+
+    // Starting from the same centroids, the Lloyd iterations must match the single-GPU ones
+    auto centroids_ref =
+      raft::make_device_matrix_view<T, int>(d_centroids_ref.data(), params.n_clusters, n_features);
+    raft::copy(d_centroids_ref.data(), d_centroids.data(), d_centroids.size(), stream);
+    raft::cluster::KMeansParams array_params = params;
+    array_params.init                        = raft::cluster::KMeansParams::InitMethod::Array;
+    array_params.max_iter                    = 5;
+    T inertia_ref                            = 0;
+    raft::cluster::kmeans_fit<T, int>(handle,
+                                      array_params,
+                                      X_view,
+                                      d_sw,
+                                      centroids_ref,
+                                      raft::make_host_scalar_view<T>(&inertia_ref),
+                                      raft::make_host_scalar_view<int>(&n_iter));
+    raft::cluster::kmeans::fit_mg<T, int>(handle,
+                                          array_params,
+                                          X_view,
+                                          d_sw,
+                                          centroids,
+                                          raft::make_host_scalar_view<T>(&inertia),
+                                          raft::make_host_scalar_view<int>(&n_iter));
+    resource::sync_stream(handle, stream);
+    centroids_match = devArrMatch(d_centroids_ref.data(),
+                                  d_centroids.data(),
+                                  d_centroids.size(),
+                                  CompareApprox<T>(1e-3),
+                                  stream);
+    inertia_match   = CompareApprox<T>(1e-3)(inertia_ref / n_samples, inertia / n_samples);
+  }
+
+  void SetUp() override { basicTest(); }
+
+ protected:
+  raft::resources handle;
+  cudaStream_t stream;
+  KmeansMGInputs<T> testparams;
+  rmm::device_uvector<int> d_labels;
+  rmm::device_uvector<int> d_labels_ref;
+  rmm::device_uvector<T> d_centroids;
+  rmm::device_uvector<T> d_centroids_ref;
+  double score;
+  testing::AssertionResult centroids_match = testing::AssertionSuccess();
+  bool inertia_match;
+  raft::cluster::KMeansParams params;
+};
+
+const std::vector<KmeansMGInputs<float>> inputsf2 = {{1000, 32, 5, 0.0001f, true},
+                                                     {1000, 32, 5, 0.0001f, false},
+                                                     {1000, 100, 20, 0.0001f, false},
+                                                     {10000, 32, 10, 0.0001f, true},
+                                                     {10000, 100, 50, 0.0001f, false}};
+
+const std::vector<KmeansMGInputs<double>> inputsd2 = {{1000, 32, 5, 0.0001, true},
+                                                      {1000, 32, 5, 0.0001, false},
+                                                      {1000, 100, 20, 0.0001, false},
+                                                      {10000, 32, 10, 0.0001, true},
+                                                      {10000, 100, 50, 0.0001, false}};
+
+typedef KmeansMGTest<float> KmeansMGTestF;
+TEST_P(KmeansMGTestF, Result)
+{
+  ASSERT_TRUE(score == 1.0);
+  ASSERT_TRUE(centroids_match);
+  ASSERT_TRUE(inertia_match);
+}
+
+typedef KmeansMGTest<double> KmeansMGTestD;
+TEST_P(KmeansMGTestD, Result)
+{
+  ASSERT_TRUE(score == 1.0);
+  ASSERT_TRUE(centroids_match);
+  ASSERT_TRUE(inertia_match);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansMGTests, KmeansMGTestF, ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(KmeansMGTests, KmeansMGTestD, ::testing::ValuesIn(inputsd2));
+
+}  // namespace raft
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/cluster/kmeans.cuh>
+#include <raft/core/cudart_utils.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/make_blobs.cuh>
+#include <raft/stats/adjusted_rand_index.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <vector>
+
+namespace raft {
+
+template <typename T>
+struct KmeansMiniBatchInputs {
+  int n_row;
+  int n_col;
+  int n_clusters;
+  int batch_samples;
+  int max_iter;
+};
+
+template <typename T>
+class KmeansMiniBatchTest : public ::testing::TestWithParam<KmeansMiniBatchInputs<T>> {
+ protected:
+  KmeansMiniBatchTest()
+    : stream(resource::get_cuda_stream(handle)),
+      d_labels(0, stream),
+      d_labels_ref(0, stream),
+      d_centroids(0, stream)
+  {
+  }
+
+  void basicTest()
+  {
+    testparams = ::testing::TestWithParam<KmeansMiniBatchInputs<T>>::GetParam();
+
+    int n_samples              = testparams.n_row;
+    int n_features             = testparams.n_col;
+    params.n_clusters          = testparams.n_clusters;
+    params.batch_samples       = testparams.batch_samples;
+    params.max_iter            = testparams.max_iter;
+    params.tol                 = 1e-4;
+    params.rng_state.seed      = 1;
+    params.oversampling_factor = 0;
+
+    auto X = raft::make_device_matrix<T, int>(handle, n_samples, n_features);
+    d_labels.resize(n_samples, stream);
+    d_labels_ref.resize(n_samples, stream);
+    d_centroids.resize(params.n_clusters * n_features, stream);
+
+    // make_blobs shuffles the samples, as the mini-batches require
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     d_labels_ref.data(),
+                                     n_samples,
+                                     n_features,
+                                     params.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(0.5),
+                                     true,
+                                     (T)-10.0f,
+                                     (T)10.0f,
+                                     (uint64_t)1234);
+
+    auto X_host = raft::make_host_matrix<T, int>(n_samples, n_features);
+    raft::copy(X_host.data_handle(), X.data_handle(), X.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    auto centroids =
+      raft::make_device_matrix_view<T, int>(d_centroids.data(), params.n_clusters, n_features);
+    T inertia  = 0;
+    int n_iter = 0;
+    raft::cluster::kmeans::fit_minibatch<T, int>(handle,
+                                                 params,
+                                                 raft::make_const_mdspan(X_host.view()),
+                                                 centroids,
+                                                 raft::make_host_scalar_view<T>(&inertia),
+                                                 raft::make_host_scalar_view<int>(&n_iter));
+    ASSERT_GE(n_iter, 1);
+    ASSERT_LE(n_iter, params.max_iter);
+
+    T pred_inertia = 0;
+    raft::cluster::kmeans_predict<T, int>(
+      handle,
+      params,
+      raft::make_const_mdspan(X.view()),
+      std::nullopt,
+      raft::make_const_mdspan(centroids),
+      raft::make_device_vector_view<int, int>(d_labels.data(), n_samples),
+      true,
+      raft::make_host_scalar_view<T>(&pred_inertia));
+    resource::sync_stream(handle, stream);
+
+    score = raft::stats::adjusted_rand_index(
+      d_labels_ref.data(), d_labels.data(), n_samples, resource::get_cuda_stream(handle));
+    if (score < 1.0) { std::cout << "Score = " << score << '\n'; }
+  }
+
+  void SetUp() override { basicTest(); }
+
+ protected:
+  raft::resources handle;
+  cudaStream_t stream;
+  KmeansMiniBatchInputs<T> testparams;
+  rmm::device_uvector<int> d_labels;
+  rmm::device_uvector<int> d_labels_ref;
+  rmm::device_uvector<T> d_centroids;
+  double score;
+  raft::cluster::KMeansParams params;
+};
+
+// A single pass over the data must be enough for well separated blobs
+const std::vector<KmeansMiniBatchInputs<float>> inputsf2 = {{10000, 32, 5, 1000, 1},
+                                                            {10000, 32, 5, 1000, 10},
+                                                            {10000, 100, 20, 2000, 1},
+                                                            {10000, 100, 20, 999, 10},
+                                                            {100000, 32, 10, 4096, 1}};
+
+const std::vector<KmeansMiniBatchInputs<double>> inputsd2 = {{10000, 32, 5, 1000, 1},
+                                                             {10000, 32, 5, 1000, 10},
+                                                             {10000, 100, 20, 2000, 1},
+                                                             {10000, 100, 20, 999, 10}};
+
+typedef KmeansMiniBatchTest<float> KmeansMiniBatchTestF;
+TEST_P(KmeansMiniBatchTestF, Result) { ASSERT_GT(score, 0.99); }
+
+typedef KmeansMiniBatchTest<double> KmeansMiniBatchTestD;
+TEST_P(KmeansMiniBatchTestD, Result) { ASSERT_GT(score, 0.99); }
+
+INSTANTIATE_TEST_CASE_P(KmeansMiniBatchTests, KmeansMiniBatchTestF, ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(KmeansMiniBatchTests, KmeansMiniBatchTestD, ::testing::ValuesIn(inputsd2));
+
+}  // namespace raft
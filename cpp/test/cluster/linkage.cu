@@ -25,6 +25,7 @@
 
 #include "../test_utils.cuh"
 
+#include <raft/cluster/detail/agglomerative.cuh>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/distance/distance_types.hpp>
@@ -37,6 +38,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <numeric>
+#include <random>
 #include <vector>
 
 namespace raft {
@@ -671,4 +675,91 @@ typedef LinkageTest<float, int> LinkageTestF_Int;
 TEST_P(LinkageTestF_Int, Result) { EXPECT_TRUE(score == 1.0); }
 
 INSTANTIATE_TEST_CASE_P(LinkageTest, LinkageTestF_Int, ::testing::ValuesIn(linkage_inputsf2));
+
+enum class TreeShape { kRandom, kChain, kStar };
+
+struct DendrogramInputs {
+  int n_leaves;
+  TreeShape shape;
+};
+
+/** The device dendrogram must match the host union-find on the same sorted MST. */
+class DendrogramTest : public ::testing::TestWithParam<DendrogramInputs> {
+ protected:
+  void SetUp() override
+  {
+    auto p      = ::testing::TestWithParam<DendrogramInputs>::GetParam();
+    auto stream = resource::get_cuda_stream(handle);
+    int n_edges = p.n_leaves - 1;
+
+    // a spanning tree of the leaves, its edges listed in increasing weight order
+    std::mt19937 rng(42);
+    std::vector<int> rows_h(n_edges), cols_h(n_edges), order(n_edges);
+    std::vector<float> data_h(n_edges);
+    std::iota(order.begin(), order.end(), 0);
+    if (p.shape == TreeShape::kRandom) { std::shuffle(order.begin(), order.end(), rng); }
+    for (int v = 1; v < p.n_leaves; v++) {
+      int u = 0;
+      if (p.shape == TreeShape::kChain) { u = v - 1; }
+      if (p.shape == TreeShape::kRandom) { u = std::uniform_int_distribution<int>(0, v - 1)(rng); }
+      int e     = order[v - 1];
+      rows_h[e] = v;
+      cols_h[e] = u;
+      data_h[e] = e;
+    }
+
+    rmm::device_uvector<int> rows(n_edges, stream), cols(n_edges, stream);
+    rmm::device_uvector<float> data(n_edges, stream);
+    raft::update_device(rows.data(), rows_h.data(), n_edges, stream);
+    raft::update_device(cols.data(), cols_h.data(), n_edges, stream);
+    raft::update_device(data.data(), data_h.data(), n_edges, stream);
+
+    rmm::device_uvector<int> children_ref(2 * n_edges, stream), children(2 * n_edges, stream);
+    rmm::device_uvector<int> size_ref(n_edges, stream), size(n_edges, stream);
+    rmm::device_uvector<float> delta_ref(n_edges, stream), delta(n_edges, stream);
+    raft::cluster::detail::build_dendrogram_host<int, float>(handle,
+                                                              rows.data(),
+                                                              cols.data(),
+                                                              data.data(),
+                                                              n_edges,
+                                                              children_ref.data(),
+                                                              delta_ref.data(),
+                                                              size_ref.data());
+    raft::cluster::detail::build_dendrogram_device<int, float>(handle,
+                                                                rows.data(),
+                                                                cols.data(),
+                                                                data.data(),
+                                                                n_edges,
+                                                                children.data(),
+                                                                delta.data(),
+                                                                size.data());
+
+    match_children = devArrMatch(
+      children_ref.data(), children.data(), 2 * n_edges, raft::Compare<int>(), stream);
+    match_size  = devArrMatch(size_ref.data(), size.data(), n_edges, raft::Compare<int>(), stream);
+    match_delta = devArrMatch(
+      delta_ref.data(), delta.data(), n_edges, raft::Compare<float>(), stream);
+  }
+
+  raft::resources handle;
+  testing::AssertionResult match_children = testing::AssertionSuccess();
+  testing::AssertionResult match_size     = testing::AssertionSuccess();
+  testing::AssertionResult match_delta    = testing::AssertionSuccess();
+};
+
+TEST_P(DendrogramTest, Result)
+{
+  EXPECT_TRUE(match_children);
+  EXPECT_TRUE(match_size);
+  EXPECT_TRUE(match_delta);
+}
+
+// the chain and the star merge one edge per round on device, and are finished on host
+const std::vector<DendrogramInputs> dendrogram_inputs = {{2, TreeShape::kRandom},
+                                                         {100, TreeShape::kRandom},
+                                                         {100000, TreeShape::kRandom},
+                                                         {1000, TreeShape::kChain},
+                                                         {100000, TreeShape::kStar}};
+
+INSTANTIATE_TEST_CASE_P(LinkageTest, DendrogramTest, ::testing::ValuesIn(dendrogram_inputs));
 }  // end namespace raft
@@ -238,6 +238,43 @@ class BitsetTest : public testing::TestWithParam<test_spec_bitset> {
       ASSERT_EQ(sparsity_result, sparsity_ref);
     }
 
+    // test combine, to_indices and estimate_selectivity
+    {
+      auto other = raft::core::bitset<bitset_t, index_t>(
+        res, raft::make_const_mdspan(mask_device.view()), index_t(spec.bitset_len), false);
+      auto combined = raft::core::bitset<bitset_t, index_t>(res, index_t(spec.bitset_len));
+      std::vector<bool> other_ref(spec.bitset_len, false);
+      for (auto idx : mask_cpu) {
+        other_ref[idx] = true;
+      }
+      for (auto op : {bitset_op::AND, bitset_op::OR, bitset_op::XOR, bitset_op::AND_NOT}) {
+        raft::copy(combined.data(), my_bitset.data(), combined.n_elements(), stream);
+        combined.combine(res, other.view(), op);
+        std::vector<index_t> indices_ref;
+        for (index_t i = 0; i < index_t(spec.bitset_len); i++) {
+          bool a = (bitset_ref[i / bitset_element_size] >> (i % bitset_element_size)) & 1;
+          bool b = other_ref[i];
+          bool c = op == bitset_op::AND  ? a && b
+                   : op == bitset_op::OR ? a || b
+                   : op == bitset_op::XOR ? a != b
+                                          : a && !b;
+          if (c) { indices_ref.push_back(i); }
+        }
+        auto indices = raft::make_device_vector<index_t, index_t>(res, spec.bitset_len);
+        auto n_set   = combined.view().to_indices(res, indices.view());
+        ASSERT_EQ(n_set, indices_ref.size());
+        ASSERT_TRUE(devArrMatchHost(
+          indices_ref.data(), indices.data_handle(), n_set, raft::Compare<index_t>(), stream));
+
+        const double selectivity_ref = double(n_set) / double(spec.bitset_len);
+        ASSERT_EQ(combined.view().estimate_selectivity(res, combined.n_elements()),
+                  selectivity_ref);
+        if (combined.n_elements() > 256) {
+          ASSERT_NEAR(combined.view().estimate_selectivity(res, 256), selectivity_ref, 0.05);
+        }
+      }
+    }
+
     // Flip the bitset and re-test
     auto bitset_count = my_bitset.count(res);
     my_bitset.flip(res);
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../loopback_comms.hpp"
+#include "../test_utils.cuh"
+
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+
+#include <rmm/cuda_stream_pool.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace raft::comms {
+
+struct CollectivePipelineInputs {
+  int64_t n;
+  int64_t chunk;
+};
+
+class CollectivePipelineTest : public ::testing::TestWithParam<CollectivePipelineInputs> {
+ public:
+  CollectivePipelineTest()
+    : params(::testing::TestWithParam<CollectivePipelineInputs>::GetParam()),
+      comm(std::make_unique<loopback_comms>())
+  {
+    resource::set_cuda_stream_pool(handle, std::make_shared<rmm::cuda_stream_pool>(1));
+  }
+
+ protected:
+  // compute the chunks one after the other and reduce (or gather) each as soon as it is ready
+  void Run(bool gather)
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    auto input  = raft::make_device_vector<float, int64_t>(handle, params.n);
+    auto output = raft::make_device_vector<float, int64_t>(handle, params.n);
+    {
+      collective_pipeline pipeline(comm, stream, resource::get_stream_from_stream_pool(handle));
+      for (int64_t offset = 0; offset < params.n; offset += params.chunk) {
+        auto count = std::min(params.chunk, params.n - offset);
+        raft::linalg::map_offset(
+          handle,
+          raft::make_device_vector_view<float, int64_t>(input.data_handle() + offset, count),
+          raft::add_const_op<float>(float(offset)));
+        if (gather) {
+          pipeline.allgather(
+            input.data_handle() + offset, output.data_handle(), offset, count, params.n);
+        } else {
+          pipeline.allreduce(
+            input.data_handle() + offset, output.data_handle() + offset, count, op_t::SUM);
+        }
+      }
+      pipeline.wait();
+    }
+
+    std::vector<float> expected(params.n);
+    std::iota(expected.begin(), expected.end(), 0.0f);
+    ASSERT_TRUE(devArrMatchHost(
+      expected.data(), output.data_handle(), params.n, CompareApprox<float>(1e-6f), stream));
+  }
+
+  raft::resources handle;
+  CollectivePipelineInputs params;
+  comms_t comm;
+};
+
+const std::vector<CollectivePipelineInputs> inputs = {
+  {1, 1}, {1000, 1000}, {1000, 7}, {100000, 4096}, {100000, 100001}};
+
+TEST_P(CollectivePipelineTest, Allreduce) { Run(false); }
+TEST_P(CollectivePipelineTest, Allgather) { Run(true); }
+INSTANTIATE_TEST_CASE_P(CollectivePipelineTests,
+                        CollectivePipelineTest,
+                        ::testing::ValuesIn(inputs));
+
+}  // namespace raft::comms
@@ -29,6 +29,7 @@
 #include <omp.h>
 
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <set>
 
@@ -141,4 +142,47 @@ TEST(DeviceResourcesManager, ObeysSetters)
   EXPECT_EQ(pools_per_device, unique_pools[devices[1]].size());
 }
 
+// Relies on the three streams per device requested in ObeysSetters, as the manager is a singleton.
+TEST(DeviceResourcesManager, DispatchesToLeastLoadedStream)
+{
+  auto device  = get_test_device_ids()[0];
+  auto release = std::atomic<bool>{false};
+  // Keep the first stream busy until released
+  auto busy_stream = device_resources_manager::dispatch(
+    [&release](device_resources const& res) {
+      RAFT_CUDA_TRY(cudaLaunchHostFunc(
+        res.get_stream(),
+        [](void* flag) {
+          while (!static_cast<std::atomic<bool>*>(flag)->load()) {}
+        },
+        &release));
+      return res.get_stream().value();
+    },
+    device);
+
+  // The next submissions avoid the busy stream, and go to distinct streams while they run
+  auto seen = std::set<cudaStream_t>{};
+  device_resources_manager::dispatch(
+    [&](device_resources const& res) {
+      seen.insert(res.get_stream().value());
+      device_resources_manager::dispatch(
+        [&](device_resources const& inner) { seen.insert(inner.get_stream().value()); }, device);
+    },
+    device);
+  EXPECT_EQ(2u, seen.size());
+  EXPECT_EQ(0u, seen.count(busy_stream));
+
+  release = true;
+  RAFT_CUDA_TRY(cudaStreamSynchronize(busy_stream));
+  // Once all the work has completed, every stream is a valid choice again
+  auto stream = device_resources_manager::dispatch(
+    [](device_resources const& res) {
+      res.sync_stream();
+      return res.get_stream().value();
+    },
+    device);
+  seen.insert(busy_stream);
+  EXPECT_EQ(1u, seen.count(stream));
+}
+
 }  // namespace raft
@@ -32,6 +32,7 @@
 #include <gtest/gtest.h>
 
 #include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <unordered_map>
@@ -61,6 +62,16 @@ class mock_comms : public comms_iface {
 
   void irecv(void* buf, size_t size, int source, int tag, request_t* request) const {}
 
+  void device_isend(
+    const void* buf, size_t size, int dest, int tag, request_t* request, cudaStream_t stream) const
+  {
+  }
+
+  void device_irecv(
+    void* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const
+  {
+  }
+
   void waitall(int count, request_t array_of_requests[]) const {}
 
   void allreduce(const void* sendbuff,
@@ -139,6 +150,25 @@ class mock_comms : public comms_iface {
   {
   }
 
+  void alltoall(const void* sendbuff,
+                void* recvbuff,
+                size_t count,
+                datatype_t datatype,
+                cudaStream_t stream) const
+  {
+  }
+
+  void alltoallv(const void* sendbuf,
+                 const size_t* sendcounts,
+                 const size_t* sdispls,
+                 void* recvbuf,
+                 const size_t* recvcounts,
+                 const size_t* rdispls,
+                 datatype_t datatype,
+                 cudaStream_t stream) const
+  {
+  }
+
   status_t sync_stream(cudaStream_t stream) const { return status_t::SUCCESS; }
 
   // if a thread is sending & receiving at the same time, use device_sendrecv to avoid deadlock
@@ -314,6 +344,69 @@ TEST(Raft, WorkspaceResource)
   ASSERT_THROW((rmm::device_buffer{max_size, stream, new_mr}), rmm::bad_alloc);
 }
 
+TEST(Raft, PinnedWorkspaceResource)
+{
+  raft::handle_t handle;
+  auto stream = resource::get_cuda_stream(handle);
+
+  // A tiny pinned workspace of 1MB
+  size_t max_size = 1024 * 1024;
+  resource::set_pinned_workspace_resource(handle, nullptr, max_size);
+  auto mr = resource::get_pinned_workspace_resource(handle);
+  ASSERT_EQ(max_size, resource::get_pinned_workspace_total_bytes(handle));
+
+  void* first_ptr = nullptr;
+  {
+    rmm::device_buffer buf(max_size / 2, stream, mr);
+    ASSERT_EQ(max_size - buf.size(), resource::get_pinned_workspace_free_bytes(handle));
+    first_ptr = buf.data();
+
+    // the memory is accessible from the host
+    resource::sync_stream(handle, stream);
+    std::memset(buf.data(), 1, buf.size());
+
+    // this should throw, because we partially used the space.
+    ASSERT_THROW((rmm::device_buffer{max_size, stream, mr}), rmm::bad_alloc);
+  }
+  ASSERT_EQ(max_size, resource::get_pinned_workspace_free_bytes(handle));
+
+  // the released memory stays in the pool and is handed out again
+  rmm::device_buffer buf(max_size / 2, stream, mr);
+  ASSERT_EQ(first_ptr, buf.data());
+  cudaPointerAttributes attrs;
+  RAFT_CUDA_TRY(cudaPointerGetAttributes(&attrs, buf.data()));
+  ASSERT_EQ(cudaMemoryTypeHost, attrs.type);
+
+  // the device workspace is not affected
+  ASSERT_NE(rmm::device_async_resource_ref{mr},
+            rmm::device_async_resource_ref{resource::get_workspace_resource(handle)});
+}
+
+TEST(Raft, IvfListResource)
+{
+  std::shared_ptr<rmm::mr::device_memory_resource> mr;
+  {
+    raft::handle_t handle;
+    // By default, the lists are allocated from the current device resource
+    ASSERT_EQ(rmm::mr::get_current_device_resource(),
+              resource::get_ivf_list_resource(handle).get());
+
+    resource::set_ivf_list_to_pool_resource(handle, 1024 * 1024);
+    mr = resource::get_ivf_list_resource(handle);
+    ASSERT_NE(rmm::mr::get_current_device_resource(), mr.get());
+    ASSERT_EQ(mr, resource::get_ivf_list_resource(handle));
+  }
+  // The pool outlives the handle, and the released blocks are reused
+  auto stream     = rmm::cuda_stream_view{};
+  void* first_ptr = nullptr;
+  {
+    rmm::device_buffer buf(4096, stream, mr.get());
+    first_ptr = buf.data();
+  }
+  rmm::device_buffer buf(4096, stream, mr.get());
+  ASSERT_EQ(first_ptr, buf.data());
+}
+
 TEST(Raft, WorkspaceResourceCopy)
 {
   raft::handle_t res;
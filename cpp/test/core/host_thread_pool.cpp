@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft/core/host_thread_pool.hpp>
+#include <raft/core/resource/host_thread_pool.hpp>
+#include <raft/core/resources.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace raft {
+
+TEST(HostThreadPool, ParallelFor)
+{
+  for (size_t n_threads : {1, 2, 4, 7}) {
+    host_thread_pool pool(n_threads);
+    ASSERT_EQ(pool.n_threads(), n_threads);
+    for (int64_t n : {0, 1, 5, 1000, 100003}) {
+      std::vector<int> visited(n, 0);
+      pool.parallel_for(10, 10 + n, [&](int64_t i) { visited[i - 10]++; }, 3);
+      ASSERT_EQ(std::accumulate(visited.begin(), visited.end(), int64_t{0}), n);
+      ASSERT_TRUE(std::all_of(visited.begin(), visited.end(), [](int v) { return v == 1; }));
+    }
+  }
+}
+
+TEST(HostThreadPool, ThreadIndex)
+{
+  host_thread_pool pool(4);
+  std::vector<std::atomic<int>> busy(pool.n_threads());
+  std::atomic<bool> overlap{false};
+  pool.parallel_for_chunks(0, 10000, [&](int64_t, int64_t, size_t thread_index) {
+    ASSERT_LT(thread_index, pool.n_threads());
+    if (busy[thread_index].fetch_add(1) != 0) { overlap = true; }
+    std::this_thread::yield();
+    busy[thread_index].fetch_sub(1);
+  });
+  ASSERT_FALSE(overlap.load());
+}
+
+TEST(HostThreadPool, Nested)
+{
+  host_thread_pool pool(4);
+  const int64_t n = 64;
+  std::vector<int64_t> sums(n, 0);
+  pool.parallel_for(0, n, [&](int64_t i) {
+    std::atomic<int64_t> sum{0};
+    pool.parallel_for(0, 1000, [&](int64_t j) { sum += j; });
+    sums[i] = sum.load();
+  });
+  for (auto s : sums) {
+    ASSERT_EQ(s, 999 * 1000 / 2);
+  }
+}
+
+TEST(HostThreadPool, ConcurrentCallers)
+{
+  host_thread_pool pool(4);
+  std::vector<std::thread> callers;
+  std::vector<int64_t> sums(8, 0);
+  for (size_t c = 0; c < sums.size(); c++) {
+    callers.emplace_back([&pool, &sums, c]() {
+      std::vector<int64_t> partial(pool.n_threads(), 0);
+      pool.parallel_for_chunks(0, 100000, [&](int64_t begin, int64_t end, size_t thread_index) {
+        for (int64_t i = begin; i < end; i++) {
+          partial[thread_index] += i;
+        }
+      });
+      sums[c] = std::accumulate(partial.begin(), partial.end(), int64_t{0});
+    });
+  }
+  for (auto& t : callers) {
+    t.join();
+  }
+  for (auto s : sums) {
+    ASSERT_EQ(s, int64_t{99999} * 100000 / 2);
+  }
+}
+
+TEST(HostThreadPool, Exception)
+{
+  host_thread_pool pool(4);
+  EXPECT_THROW(pool.parallel_for(0,
+                                 1000,
+                                 [](int64_t i) {
+                                   if (i == 500) { throw std::runtime_error("failed"); }
+                                 }),
+               std::runtime_error);
+  // The pool is still usable
+  std::atomic<int64_t> count{0};
+  pool.parallel_for(0, 1000, [&](int64_t) { count++; });
+  ASSERT_EQ(count.load(), 1000);
+}
+
+TEST(HostThreadPool, Resource)
+{
+  raft::resources res;
+  ASSERT_EQ(&resource::get_host_thread_pool(res), host_thread_pool::default_pool().get());
+
+  resource::set_host_thread_budget(res, 3);
+  ASSERT_EQ(resource::get_host_thread_pool(res).n_threads(), 3u);
+
+  auto shared = std::make_shared<host_thread_pool>(2);
+  raft::resources other;
+  resource::set_host_thread_pool(res, shared);
+  resource::set_host_thread_pool(other, shared);
+  ASSERT_EQ(&resource::get_host_thread_pool(res), shared.get());
+  ASSERT_EQ(&resource::get_host_thread_pool(other), shared.get());
+
+  resource::set_host_thread_pool(res, nullptr);
+  ASSERT_EQ(&resource::get_host_thread_pool(res), host_thread_pool::default_pool().get());
+}
+
+}  // namespace raft
@@ -17,12 +17,15 @@
 #include <raft/common/nvtx.hpp>
 #include <raft/core/detail/macros.hpp>
 #include <raft/core/interruptible.hpp>
+#include <raft/core/resource/deadline.hpp>
+#include <raft/core/resources.hpp>
 
 #include <rmm/cuda_stream.hpp>
 
 #include <gtest/gtest.h>
 #include <omp.h>
 
+#include <chrono>
 #include <cstddef>
 #include <iostream>
 #include <memory>
@@ -145,4 +148,24 @@ TEST(Raft, InterruptibleOpenMP)
   ASSERT_EQ(n_finished, n_expected_succeed);
   ASSERT_EQ(n_cancelled, n_threads - n_expected_succeed);
 }
+
+TEST(Raft, InterruptibleDeadline)
+{
+  raft::resources res;
+  ASSERT_FALSE(resource::get_deadline(res).has_value());
+  ASSERT_NO_THROW(resource::check_interrupted(res));
+
+  resource::set_timeout(res, std::chrono::hours(1));
+  ASSERT_TRUE(resource::get_deadline(res).has_value());
+  ASSERT_NO_THROW(resource::check_interrupted(res));
+
+  resource::set_deadline(res, std::chrono::steady_clock::now() - std::chrono::milliseconds(1));
+  ASSERT_THROW(resource::check_interrupted(res), interrupted_exception);
+
+  // a cancelled thread is interrupted at the checkpoints too
+  resource::set_deadline(res, std::nullopt);
+  interruptible::get_token()->cancel();
+  ASSERT_THROW(resource::check_interrupted(res), interrupted_exception);
+  ASSERT_NO_THROW(resource::check_interrupted(res));
+}
 }  // namespace raft
@@ -114,4 +114,30 @@ TEST_F(loggerTest, flush)
   ASSERT_EQ(1, flushCount);
 }
 
+TEST_F(loggerTest, async)
+{
+  auto& log = logger::get(RAFT_NAME);
+  log.set_callback(exampleCallback);
+  log.set_flush(exampleFlush);
+  log.set_async(true, 64);
+  ASSERT_TRUE(log.is_async());
+
+  for (int i = 0; i < 32; i++) {
+    RAFT_LOG_INFO("async message %d", i);
+  }
+  // the messages are passed to the callback by the background thread
+  log.flush();
+  ASSERT_TRUE(check_if_logged("async message 31", RAFT_LEVEL_INFO));
+  ASSERT_EQ(1, flushCount);
+  ASSERT_EQ(0u, log.dropped_messages());
+
+  RAFT_LOG_WARN("last async message");
+  log.set_async(false);
+  ASSERT_FALSE(log.is_async());
+  ASSERT_TRUE(check_if_logged("last async message", RAFT_LEVEL_WARN));
+
+  RAFT_LOG_INFO("synchronous again");
+  ASSERT_TRUE(check_if_logged("synchronous again", RAFT_LEVEL_INFO));
+}
+
 }  // namespace raft
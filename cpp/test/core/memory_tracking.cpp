@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/memory_tracking.hpp>
+#include <raft/core/resources.hpp>
+
+#include <rmm/device_buffer.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+
+namespace raft::resource {
+
+TEST(MemoryTracking, Scopes)
+{
+  raft::resources res;
+  auto stream  = get_cuda_stream(res);
+  auto tracker = std::make_shared<memory_tracker>();
+  auto limit   = get_workspace_total_bytes(res);
+  set_tracked_workspace_resources(res, tracker);
+  ASSERT_EQ(limit, get_workspace_total_bytes(res));
+
+  auto* ws       = get_workspace_resource(res);
+  auto* large_ws = get_large_workspace_resource(res);
+  {
+    common::nvtx::range<common::nvtx::domain::raft> build_scope("algo::build(%d)", 42);
+    rmm::device_buffer a(1000, stream, ws);
+    {
+      common::nvtx::range<common::nvtx::domain::raft> train_scope("algo::train");
+      rmm::device_buffer b(5000, stream, large_ws);
+      rmm::device_buffer c(3000, stream, ws);
+      ASSERT_EQ(9000u, tracker->usage("algo::build").current_bytes);
+      ASSERT_EQ(8000u, tracker->usage("algo::build/algo::train").current_bytes);
+    }
+    rmm::device_buffer d(2000, stream, ws);
+    ASSERT_EQ(3000u, tracker->usage("algo::build").current_bytes);
+  }
+  {
+    common::nvtx::range<common::nvtx::domain::raft> search_scope("algo::search");
+    rmm::device_buffer e(500, stream, ws);
+  }
+
+  auto build = tracker->usage("algo::build");
+  EXPECT_EQ(0u, build.current_bytes);
+  EXPECT_EQ(9000u, build.peak_bytes);
+  EXPECT_EQ(4u, build.n_allocations);
+  auto train = tracker->usage("algo::build/algo::train");
+  EXPECT_EQ(8000u, train.peak_bytes);
+  EXPECT_EQ(2u, train.n_allocations);
+  EXPECT_EQ(500u, tracker->usage("algo::search").peak_bytes);
+  EXPECT_EQ(0u, tracker->total().current_bytes);
+  EXPECT_EQ(9000u, tracker->total().peak_bytes);
+  EXPECT_EQ(4u, tracker->report().size());
+
+  tracker->reset_peaks();
+  EXPECT_EQ(0u, tracker->usage("algo::build").peak_bytes);
+}
+
+TEST(MemoryTracking, NoTracker)
+{
+  // The ranges are not recorded without a tracker, but the scopes stay balanced.
+  { common::nvtx::range<common::nvtx::domain::raft> outer("outer"); }
+  auto tracker = std::make_shared<memory_tracker>();
+  raft::resources res;
+  set_tracked_workspace_resources(res, tracker);
+  rmm::device_buffer a(1000, get_cuda_stream(res), get_workspace_resource(res));
+  EXPECT_EQ(1000u, tracker->total().current_bytes);
+  EXPECT_EQ(1u, tracker->report().size());
+}
+
+}  // namespace raft::resource
@@ -14,19 +14,32 @@
  * limitations under the License.
  */
 
+#include <raft/core/detail/cufile.hpp>
+#include <raft/core/detail/mapped_file.hpp>
+#include <raft/core/detail/mdspan_numpy_file.hpp>
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/managed_mdspan.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/core/serialize.hpp>
 
 #include <thrust/device_vector.h>
+#include <thrust/equal.h>
+#include <thrust/execution_policy.h>
 #include <thrust/host_vector.h>
+#include <thrust/sequence.h>
 #include <thrust/universal_vector.h>
 
 #include <gtest/gtest.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <complex>
 #include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -36,6 +49,18 @@ namespace {
 template <class IndexType, std::size_t Rank>
 using dextents = std::experimental::dextents<IndexType, Rank>;
 
+/** A temporary file removed at the end of the test. */
+struct temp_file {
+  temp_file()
+  {
+    int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    close(fd);
+  }
+  ~temp_file() { unlink(path); }
+  char path[32] = "/tmp/raft_numpy_XXXXXX";
+};
+
 }  // anonymous namespace
 
 namespace raft {
@@ -118,6 +143,123 @@ TEST(NumPySerializerMDSpan, ManagedMDSpan)
   test_mdspan_roundtrip<managed_mdspan_matrix2d_c_layout>(handle, vec, 2, 2, 2);
 }
 
+TEST(NumPySerializerMDSpan, FileRoundTrip)
+{
+  raft::resources handle{};
+  temp_file file;
+  thrust::host_vector<float> vec = std::vector<float>{1, 2, 3, 4, 5, 6, 7, 8};
+  thrust::host_vector<float> vec2(vec.size());
+  auto span  = raft::make_host_matrix_view<float, int64_t, raft::col_major>(vec.data(), 2, 4);
+  auto span2 = raft::make_host_matrix_view<float, int64_t, raft::col_major>(vec2.data(), 2, 4);
+  serialize_mdspan_file(handle, file.path, span);
+  deserialize_mdspan_file(handle, file.path, span2);
+  EXPECT_EQ(vec, vec2);
+
+  // The files are the same as those written to a stream
+  std::ostringstream oss;
+  serialize_mdspan(handle, oss, span);
+  std::ifstream is(file.path, std::ios::in | std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(oss.str(), content);
+
+  auto span3 = raft::make_host_matrix_view<float, int64_t, raft::row_major>(vec2.data(), 2, 4);
+  EXPECT_THROW(deserialize_mdspan_file(handle, file.path, span3), raft::exception);
+  auto span4 = raft::make_host_matrix_view<float, int64_t, raft::col_major>(vec2.data(), 4, 2);
+  EXPECT_THROW(deserialize_mdspan_file(handle, file.path, span4), raft::exception);
+}
+
+TEST(NumPySerializerMDSpan, DeviceFileRoundTrip)
+{
+  raft::resources handle{};
+  temp_file file;
+  // More than one staging buffer
+  const int64_t n_rows = 9 * 1024 * 1024;
+  const int64_t n_cols = 2;
+  thrust::device_vector<std::int32_t> vec(n_rows * n_cols);
+  thrust::device_vector<std::int32_t> vec2(vec.size());
+  thrust::sequence(vec.begin(), vec.end());
+  serialize_mdspan_file(
+    handle,
+    file.path,
+    raft::make_device_matrix_view<const std::int32_t, int64_t>(
+      thrust::raw_pointer_cast(vec.data()), n_rows, n_cols));
+  deserialize_mdspan_file(handle,
+                          file.path,
+                          raft::make_device_matrix_view<std::int32_t, int64_t>(
+                            thrust::raw_pointer_cast(vec2.data()), n_rows, n_cols));
+  EXPECT_TRUE(thrust::equal(thrust::device, vec.begin(), vec.end(), vec2.begin()));
+
+  // The file can also be read with the stream deserializer
+  auto host = raft::make_host_matrix<std::int32_t, int64_t>(n_rows, n_cols);
+  std::ifstream is(file.path, std::ios::in | std::ios::binary);
+  deserialize_mdspan(handle, is, host.view());
+  EXPECT_EQ(host(n_rows - 1, n_cols - 1), n_rows * n_cols - 1);
+}
+
+TEST(NumPySerializerMDSpan, DeviceFileFallbackRoundTrip)
+{
+  using detail::numpy_serializer::kFileStagingChunkSize;
+  raft::resources handle{};
+  temp_file file;
+#ifndef RAFT_CUFILE_ENABLED
+  // Without GPUDirect Storage the transfers are left to the copies through host memory.
+  EXPECT_FALSE(detail::cufile_available());
+  EXPECT_FALSE(detail::cufile_transfer(file.path, true, nullptr, 1, 0, 0));
+#endif
+
+  // The copies through the pinned staging buffers, as done when GDS is not usable: three chunks,
+  // the last one partial, so that a staging buffer is reused, at an offset in the file.
+  const uint64_t offset  = 128;
+  const uint64_t n_bytes = 2 * kFileStagingChunkSize + 4097;
+  thrust::device_vector<std::uint8_t> vec(n_bytes);
+  thrust::device_vector<std::uint8_t> vec2(n_bytes);
+  thrust::sequence(vec.begin(), vec.end());
+  {
+    detail::file_descriptor fd(file.path, O_WRONLY | O_CREAT | O_TRUNC);
+    detail::numpy_serializer::write_device_bytes(
+      handle, fd, thrust::raw_pointer_cast(vec.data()), n_bytes, offset);
+  }
+  {
+    detail::file_descriptor fd(file.path, O_RDONLY);
+    ASSERT_EQ(fd.size(), offset + n_bytes);
+    detail::numpy_serializer::read_device_bytes(
+      handle, fd, thrust::raw_pointer_cast(vec2.data()), n_bytes, offset);
+  }
+  EXPECT_TRUE(thrust::equal(thrust::device, vec.begin(), vec.end(), vec2.begin()));
+}
+
+TEST(NumPySerializerMDSpan, MappedFile)
+{
+  raft::resources handle{};
+  temp_file file;
+  std::vector<double> vec{1, 2, 3, 4, 5, 6};
+  serialize_mdspan_file(
+    handle, file.path, raft::make_host_matrix_view<double, int64_t>(vec.data(), 3, 2));
+
+  auto mapped = deserialize_mdspan_mmap<double, raft::matrix_extent<int64_t>>(file.path);
+  auto view   = mapped.view();
+  ASSERT_EQ(view.extent(0), 3);
+  ASSERT_EQ(view.extent(1), 2);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(view.data_handle()) % 64, 0);
+  for (int64_t i = 0; i < 3; i++) {
+    for (int64_t j = 0; j < 2; j++) {
+      EXPECT_EQ(view(i, j), vec[i * 2 + j]);
+    }
+  }
+
+  using static_extents = std::experimental::extents<int64_t, std::experimental::dynamic_extent, 2>;
+  auto mapped2         = deserialize_mdspan_mmap<double, static_extents>(file.path);
+  EXPECT_EQ(mapped2.view()(2, 1), 6);
+  using wrong_extents = std::experimental::extents<int64_t, std::experimental::dynamic_extent, 3>;
+  EXPECT_THROW((deserialize_mdspan_mmap<double, wrong_extents>(file.path)), raft::exception);
+  EXPECT_THROW((deserialize_mdspan_mmap<float, raft::matrix_extent<int64_t>>(file.path)),
+               raft::exception);
+  EXPECT_THROW(
+    (deserialize_mdspan_mmap<double, raft::matrix_extent<int64_t>, raft::layout_f_contiguous>(
+      file.path)),
+    raft::exception);
+}
+
 TEST(NumPySerializerMDSpan, Tuple2String)
 {
   {
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/scope_profiling.hpp>
+#include <raft/core/resources.hpp>
+
+#include <rmm/device_buffer.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace raft::resource {
+
+TEST(ScopeProfiling, Scopes)
+{
+  raft::resources res;
+  auto stream = get_cuda_stream(res);
+  rmm::device_buffer buf(64 << 20, stream);
+  // not recorded: the profiler is not installed yet
+  { common::nvtx::range<common::nvtx::domain::raft> before("algo::before"); }
+
+  scope_profiler profiler(res);
+  for (int i = 0; i < 3; i++) {
+    common::nvtx::range<common::nvtx::domain::raft> search_scope("algo::search(%d)", i);
+    {
+      common::nvtx::range<common::nvtx::domain::raft> select_scope("algo::select");
+      RAFT_CUDA_TRY(cudaMemsetAsync(buf.data(), i, buf.size(), stream));
+    }
+    RAFT_CUDA_TRY(cudaMemsetAsync(buf.data(), i + 1, buf.size(), stream));
+  }
+
+  auto report = profiler.report();
+  ASSERT_EQ(2u, report.size());
+  auto search = profiler.timing("algo::search");
+  auto select = profiler.timing("algo::search/algo::select");
+  EXPECT_EQ(3u, search.n_calls);
+  EXPECT_EQ(3u, select.n_calls);
+  EXPECT_GT(select.total_ms, 0.0);
+  EXPECT_GE(search.total_ms, select.total_ms);
+  EXPECT_LE(search.min_ms, search.mean_ms());
+  EXPECT_LE(search.mean_ms(), search.max_ms);
+  EXPECT_EQ(0u, profiler.timing("algo::before").n_calls);
+  EXPECT_NE(std::string::npos, profiler.to_string().find("  algo::select: 3 calls"));
+
+  profiler.reset();
+  EXPECT_TRUE(profiler.report().empty());
+}
+
+TEST(ScopeProfiling, Uninstalled)
+{
+  raft::resources res;
+  {
+    scope_profiler profiler(res);
+    common::nvtx::range<common::nvtx::domain::raft> scope("algo::build");
+  }
+  // the ranges are not recorded once the profiler is destroyed
+  { common::nvtx::range<common::nvtx::domain::raft> scope("algo::build"); }
+  EXPECT_EQ(nullptr, detail::thread_scope_listener());
+}
+
+}  // namespace raft::resource
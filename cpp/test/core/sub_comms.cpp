@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../loopback_comms.hpp"
+
+#include <raft/core/comms.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/sub_comms.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace raft {
+
+TEST(SubComms, Topology)
+{
+  raft::resources res;
+  resource::set_comms(res, std::make_shared<comms::comms_t>(std::make_unique<loopback_comms>()));
+  resource::init_topology_subcomms(res);
+
+  // a single rank is alone on its node, and alone across the nodes
+  auto const& node_comm  = resource::get_subcomm(res, resource::node_subcomm_key);
+  auto const& cross_comm = resource::get_subcomm(res, resource::cross_node_subcomm_key);
+  ASSERT_EQ(node_comm.get_size(), 1);
+  ASSERT_EQ(node_comm.get_rank(), 0);
+  ASSERT_EQ(cross_comm.get_size(), 1);
+  ASSERT_EQ(cross_comm.get_rank(), 0);
+
+  auto stream = resource::get_cuda_stream(res);
+  std::vector<float> h_in(1000);
+  std::iota(h_in.begin(), h_in.end(), 0.0f);
+  rmm::device_uvector<float> in(h_in.size(), stream), out(h_in.size(), stream);
+  raft::update_device(in.data(), h_in.data(), h_in.size(), stream);
+  resource::hierarchical_allreduce(
+    res, in.data(), out.data(), out.size(), comms::op_t::SUM, stream);
+  std::vector<float> h_out(h_in.size());
+  raft::update_host(h_out.data(), out.data(), out.size(), stream);
+  resource::sync_stream(res, stream);
+  ASSERT_EQ(h_in, h_out);
+}
+
+}  // namespace raft
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "distance_base.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/distance/pairwise_distance_reduce.cuh>
+
+#include <thrust/count.h>
+
+#include <cstddef>
+
+namespace raft {
+namespace distance {
+
+// Writes every distance to its place in the distance matrix, and counts the calls for each pair
+template <typename DataType>
+struct scatter_distance_op {
+  DataType* dist;
+  int* calls;
+  int m;
+  int n;
+  bool row_major;
+
+  __device__ void operator()(int row, int col, DataType d) const
+  {
+    const auto idx = row_major ? std::size_t(row) * n + col : std::size_t(col) * m + row;
+    dist[idx]      = d;
+    atomicAdd(calls + idx, 1);
+  }
+};
+
+template <raft::distance::DistanceType distanceType, typename DataType>
+class DistanceReduceTest : public ::testing::TestWithParam<DistanceInputs<DataType>> {
+ public:
+  DistanceReduceTest()
+    : params(::testing::TestWithParam<DistanceInputs<DataType>>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(params.m * params.k, stream),
+      y(params.n * params.k, stream),
+      dist_ref(params.m * params.n, stream),
+      dist(params.m * params.n, stream),
+      calls(params.m * params.n, stream)
+  {
+  }
+
+ protected:
+  template <typename layout>
+  void run_reduce()
+  {
+    auto x_v = make_device_matrix_view<const DataType, int, layout>(x.data(), params.m, params.k);
+    auto y_v = make_device_matrix_view<const DataType, int, layout>(y.data(), params.n, params.k);
+    scatter_distance_op<DataType> op{
+      dist.data(), calls.data(), params.m, params.n, params.isRowMajor};
+    pairwise_distance_reduce<distanceType>(handle, x_v, y_v, op, params.metric_arg);
+  }
+
+  void basicTest()
+  {
+    raft::random::RngState r(params.seed);
+    uniform(handle, r, x.data(), params.m * params.k, DataType(-1.0), DataType(1.0));
+    uniform(handle, r, y.data(), params.n * params.k, DataType(-1.0), DataType(1.0));
+    naiveDistance(dist_ref.data(),
+                  x.data(),
+                  y.data(),
+                  params.m,
+                  params.n,
+                  params.k,
+                  distanceType,
+                  params.isRowMajor,
+                  params.metric_arg,
+                  stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(calls.data(), 0, calls.size() * sizeof(int), stream));
+
+    if (params.isRowMajor) {
+      run_reduce<layout_c_contiguous>();
+    } else {
+      run_reduce<layout_f_contiguous>();
+    }
+
+    // Every pair must be reduced exactly once
+    auto n_once = thrust::count(resource::get_thrust_policy(handle), calls.begin(), calls.end(), 1);
+    ASSERT_EQ(n_once, static_cast<decltype(n_once)>(calls.size()));
+    ASSERT_TRUE(raft::devArrMatch(dist_ref.data(),
+                                  dist.data(),
+                                  params.m,
+                                  params.n,
+                                  raft::CompareApprox<DataType>(params.tolerance),
+                                  stream));
+  }
+
+  raft::resources handle;
+  cudaStream_t stream;
+
+  DistanceInputs<DataType> params;
+  rmm::device_uvector<DataType> x, y, dist_ref, dist;
+  rmm::device_uvector<int> calls;
+};
+
+const std::vector<DistanceInputs<float>> inputsf = {
+  {0.001f, 1024, 1024, 32, true, 1234ULL},
+  {0.001f, 1000, 37, 129, true, 1234ULL},
+  {0.001f, 33, 1001, 64, true, 1234ULL, 3.0f},
+  {0.001f, 1024, 1024, 32, false, 1234ULL},
+  {0.001f, 1000, 37, 129, false, 1234ULL},
+  {0.001f, 33, 1001, 64, false, 1234ULL, 3.0f},
+};
+
+const std::vector<DistanceInputs<double>> inputsd = {
+  {0.001, 1024, 1024, 32, true, 1234ULL},
+  {0.001, 1000, 37, 129, true, 1234ULL},
+  {0.001, 33, 1001, 64, false, 1234ULL, 3.0},
+};
+
+typedef DistanceReduceTest<raft::distance::DistanceType::L2SqrtExpanded, float>
+  DistanceReduceL2SqrtExpF;
+TEST_P(DistanceReduceL2SqrtExpF, Result) { basicTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceReduceTests,
+                        DistanceReduceL2SqrtExpF,
+                        ::testing::ValuesIn(inputsf));
+
+typedef DistanceReduceTest<raft::distance::DistanceType::CosineExpanded, float>
+  DistanceReduceCosineF;
+TEST_P(DistanceReduceCosineF, Result) { basicTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceReduceTests, DistanceReduceCosineF, ::testing::ValuesIn(inputsf));
+
+typedef DistanceReduceTest<raft::distance::DistanceType::L1, float> DistanceReduceL1F;
+TEST_P(DistanceReduceL1F, Result) { basicTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceReduceTests, DistanceReduceL1F, ::testing::ValuesIn(inputsf));
+
+typedef DistanceReduceTest<raft::distance::DistanceType::LpUnexpanded, float>
+  DistanceReduceLpUnexpF;
+TEST_P(DistanceReduceLpUnexpF, Result) { basicTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceReduceTests, DistanceReduceLpUnexpF, ::testing::ValuesIn(inputsf));
+
+typedef DistanceReduceTest<raft::distance::DistanceType::L2Unexpanded, double>
+  DistanceReduceL2UnexpD;
+TEST_P(DistanceReduceL2UnexpD, Result) { basicTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceReduceTests, DistanceReduceL2UnexpD, ::testing::ValuesIn(inputsd));
+
+}  // end namespace distance
+}  // end namespace raft
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/distance/fused_distance_nn.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace raft {
+namespace distance {
+
+struct FusedDistanceNNTopKInputs {
+  int m, n, k, topk;
+  raft::distance::DistanceType metric;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const FusedDistanceNNTopKInputs& p)
+{
+  os << "m=" << p.m << " n=" << p.n << " k=" << p.k << " topk=" << p.topk
+     << " metric=" << static_cast<int>(p.metric);
+  return os;
+}
+
+template <typename DataT>
+DataT host_distance(const DataT* a, const DataT* b, int k, raft::distance::DistanceType metric)
+{
+  DataT ip = 0, aa = 0, bb = 0;
+  for (int d = 0; d < k; d++) {
+    ip += a[d] * b[d];
+    aa += a[d] * a[d];
+    bb += b[d] * b[d];
+  }
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded: return std::max<DataT>(aa + bb - 2 * ip, 0);
+    case raft::distance::DistanceType::L2SqrtExpanded:
+      return std::sqrt(std::max<DataT>(aa + bb - 2 * ip, 0));
+    case raft::distance::DistanceType::CosineExpanded:
+      return 1 - ip / (std::sqrt(aa) * std::sqrt(bb));
+    default: return ip;
+  }
+}
+
+template <typename DataT, typename IdxT>
+class FusedDistanceNNTopKTest : public ::testing::TestWithParam<FusedDistanceNNTopKInputs> {
+ public:
+  FusedDistanceNNTopKTest()
+    : params(::testing::TestWithParam<FusedDistanceNNTopKInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(params.m * params.k, stream),
+      y(params.n * params.k, stream),
+      xn(params.m, stream),
+      yn(params.n, stream),
+      out_idx(params.m * params.topk, stream),
+      out_dist(params.m * params.topk, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(params.seed);
+    uniform(handle, r, x.data(), params.m * params.k, DataT(-1.0), DataT(1.0));
+    uniform(handle, r, y.data(), params.n * params.k, DataT(-1.0), DataT(1.0));
+
+    // The L2 norms for cosine, the squared ones otherwise
+    if (params.metric == raft::distance::DistanceType::CosineExpanded) {
+      raft::linalg::rowNorm(xn.data(),
+                            x.data(),
+                            params.k,
+                            params.m,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream,
+                            raft::sqrt_op{});
+      raft::linalg::rowNorm(yn.data(),
+                            y.data(),
+                            params.k,
+                            params.n,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream,
+                            raft::sqrt_op{});
+    } else {
+      raft::linalg::rowNorm(
+        xn.data(), x.data(), params.k, params.m, raft::linalg::L2Norm, true, stream);
+      raft::linalg::rowNorm(
+        yn.data(), y.data(), params.k, params.n, raft::linalg::L2Norm, true, stream);
+    }
+
+    fusedDistanceNNTopK<DataT, IdxT>(out_idx.data(),
+                                     out_dist.data(),
+                                     x.data(),
+                                     y.data(),
+                                     xn.data(),
+                                     yn.data(),
+                                     params.m,
+                                     params.n,
+                                     params.k,
+                                     params.topk,
+                                     true,
+                                     params.metric,
+                                     stream);
+  }
+
+  void check()
+  {
+    std::vector<DataT> x_h(x.size()), y_h(y.size()), dist_h(out_dist.size());
+    std::vector<IdxT> idx_h(out_idx.size());
+    raft::update_host(x_h.data(), x.data(), x.size(), stream);
+    raft::update_host(y_h.data(), y.data(), y.size(), stream);
+    raft::update_host(dist_h.data(), out_dist.data(), out_dist.size(), stream);
+    raft::update_host(idx_h.data(), out_idx.data(), out_idx.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    bool select_min = params.metric != raft::distance::DistanceType::InnerProduct;
+    auto match      = raft::CompareApprox<DataT>(1e-4);
+    std::vector<DataT> row(params.n);
+    std::vector<int> order(params.n);
+    for (int i = 0; i < params.m; i++) {
+      for (int j = 0; j < params.n; j++) {
+        row[j] = host_distance(&x_h[i * params.k], &y_h[j * params.k], params.k, params.metric);
+      }
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return select_min ? row[a] < row[b] : row[a] > row[b];
+      });
+      for (int t = 0; t < params.topk; t++) {
+        IdxT id    = idx_h[i * params.topk + t];
+        DataT dist = dist_h[i * params.topk + t];
+        ASSERT_TRUE(match(row[order[t]], dist)) << "row " << i << ", neighbor " << t;
+        ASSERT_TRUE(id >= 0 && id < params.n) << "row " << i << ", neighbor " << t;
+        // The index may differ in case of ties, its distance may not
+        ASSERT_TRUE(match(row[id], dist)) << "row " << i << ", neighbor " << t;
+      }
+    }
+  }
+
+  FusedDistanceNNTopKInputs params;
+  raft::resources handle;
+  cudaStream_t stream;
+  rmm::device_uvector<DataT> x;
+  rmm::device_uvector<DataT> y;
+  rmm::device_uvector<DataT> xn;
+  rmm::device_uvector<DataT> yn;
+  rmm::device_uvector<IdxT> out_idx;
+  rmm::device_uvector<DataT> out_dist;
+};
+
+const std::vector<FusedDistanceNNTopKInputs> inputs = {
+  {137, 203, 32, 1, raft::distance::DistanceType::L2Expanded, 1234ULL},
+  {137, 203, 32, 2, raft::distance::DistanceType::L2Expanded, 1234ULL},
+  {137, 203, 7, 5, raft::distance::DistanceType::L2SqrtExpanded, 1234ULL},
+  {1000, 64, 16, 17, raft::distance::DistanceType::L2Expanded, 1234ULL},
+  {1000, 64, 33, 32, raft::distance::DistanceType::L2SqrtExpanded, 1234ULL},
+  {137, 203, 32, 2, raft::distance::DistanceType::CosineExpanded, 1234ULL},
+  {517, 99, 13, 10, raft::distance::DistanceType::CosineExpanded, 1234ULL},
+  {137, 203, 32, 2, raft::distance::DistanceType::InnerProduct, 1234ULL},
+  {517, 99, 64, 32, raft::distance::DistanceType::InnerProduct, 1234ULL},
+  {3, 2, 4, 2, raft::distance::DistanceType::L2Expanded, 1234ULL},
+};
+
+typedef FusedDistanceNNTopKTest<float, int> FusedDistanceNNTopKTestF_Int;
+TEST_P(FusedDistanceNNTopKTestF_Int, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(FusedDistanceNNTopKTests,
+                        FusedDistanceNNTopKTestF_Int,
+                        ::testing::ValuesIn(inputs));
+
+typedef FusedDistanceNNTopKTest<float, int64_t> FusedDistanceNNTopKTestF_Int64;
+TEST_P(FusedDistanceNNTopKTestF_Int64, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(FusedDistanceNNTopKTests,
+                        FusedDistanceNNTopKTestF_Int64,
+                        ::testing::ValuesIn(inputs));
+
+}  // end namespace distance
+}  // end namespace raft
@@ -27,6 +27,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
@@ -171,4 +172,115 @@ typedef GramMatrixTest<double> GramMatrixTestDouble;
 TEST_P(GramMatrixTestFloat, Gram) { runTest(); }
 
 INSTANTIATE_TEST_SUITE_P(GramMatrixTests, GramMatrixTestFloat, ::testing::ValuesIn(inputs));
+
+struct KernelCacheInputs {
+  int n_rows;
+  int n_cols;
+  bool is_row_major;
+  KernelParams kernel;
+  // size of the cache in MiB, zero disables the cache
+  float cache_size;
+};
+
+std::ostream& operator<<(std::ostream& os, const KernelCacheInputs& p)
+{
+  std::vector<std::string> kernel_names{"linear", "poly", "rbf", "tanh"};
+  os << "/" << p.n_rows << "x" << p.n_cols << "/" << (p.is_row_major ? "RowMajor/" : "ColMajor/")
+     << kernel_names[p.kernel.kernel] << "/cache_" << p.cache_size;
+  return os;
+}
+
+const std::vector<KernelCacheInputs> kernel_cache_inputs = {
+  {137, 5, false, {KernelType::LINEAR}, 1},
+  {137, 5, true, {KernelType::LINEAR}, 1},
+  {137, 5, false, {KernelType::POLYNOMIAL, 2, 0.5, 2.4}, 1},
+  {137, 5, true, {KernelType::TANH, 0, 0.5, 2.4}, 1},
+  {137, 5, false, {KernelType::RBF, 0, 0.5}, 1},
+  {137, 5, true, {KernelType::RBF, 0, 0.5}, 1},
+  // a single cache set: some of the rows cannot be cached
+  {1000, 5, false, {KernelType::RBF, 0, 0.5}, 0.13},
+  {137, 5, true, {KernelType::POLYNOMIAL, 2, 0.5, 2.4}, 0},
+};
+
+template <typename math_t>
+class KernelCacheTest : public ::testing::TestWithParam<KernelCacheInputs> {
+ protected:
+  KernelCacheTest()
+    : params(GetParam()),
+      handle(),
+      x(size_t(params.n_rows) * params.n_cols, resource::get_cuda_stream(handle)),
+      gram(size_t(params.n_rows) * params.n_rows, resource::get_cuda_stream(handle))
+  {
+    raft::random::RngState rng(42137ULL);
+    raft::random::uniform(handle, rng, x.data(), x.size(), math_t(0), math_t(1));
+  }
+
+  void runTest()
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    std::unique_ptr<GramMatrixBase<math_t>> kernel =
+      std::unique_ptr<GramMatrixBase<math_t>>(KernelFactory<math_t>::create(params.kernel));
+
+    auto x_span =
+      params.is_row_major
+        ? raft::make_device_strided_matrix_view<const math_t, int, raft::layout_c_contiguous>(
+            x.data(), params.n_rows, params.n_cols, 0)
+        : raft::make_device_strided_matrix_view<const math_t, int, raft::layout_f_contiguous>(
+            x.data(), params.n_rows, params.n_cols, 0);
+    // The full kernel matrix as the reference, it is symmetric
+    auto gram_span =
+      params.is_row_major
+        ? raft::make_device_strided_matrix_view<math_t, int, raft::layout_c_contiguous>(
+            gram.data(), params.n_rows, params.n_rows, 0)
+        : raft::make_device_strided_matrix_view<math_t, int, raft::layout_f_contiguous>(
+            gram.data(), params.n_rows, params.n_rows, 0);
+    (*kernel)(handle, x_span, x_span, gram_span);
+    std::vector<math_t> gram_host(gram.size());
+    raft::update_host(gram_host.data(), gram.data(), gram.size(), stream);
+
+    KernelCache<math_t> cache(handle, kernel.get(), x_span, params.cache_size);
+
+    // Overlapping working sets, so that the later ones are partially served by the cache
+    int n_ws = std::min(64, params.n_rows);
+    std::vector<int> ws_host(n_ws);
+    rmm::device_uvector<int> ws(n_ws, stream);
+    rmm::device_uvector<math_t> rows(size_t(params.n_rows) * n_ws, stream);
+    std::vector<math_t> rows_host(rows.size());
+    for (int iter = 0; iter < 4; iter++) {
+      for (int j = 0; j < n_ws; j++) {
+        ws_host[j] = (j * 7 + iter * 13) % params.n_rows;
+      }
+      raft::update_device(ws.data(), ws_host.data(), n_ws, stream);
+      cache.get_rows(handle,
+                     raft::make_device_vector_view<const int, int>(ws.data(), n_ws),
+                     raft::make_device_matrix_view<math_t, int, raft::col_major>(
+                       rows.data(), params.n_rows, n_ws));
+      raft::update_host(rows_host.data(), rows.data(), rows.size(), stream);
+      resource::sync_stream(handle, stream);
+
+      for (int j = 0; j < n_ws; j++) {
+        for (int i = 0; i < params.n_rows; i++) {
+          math_t expected = gram_host[size_t(ws_host[j]) * params.n_rows + i];
+          ASSERT_TRUE(raft::CompareApprox<math_t>(1e-6f)(expected,
+                                                         rows_host[size_t(j) * params.n_rows + i]))
+            << "iter " << iter << ", row " << i << ", ws " << j;
+        }
+      }
+    }
+  }
+
+  KernelCacheInputs params;
+  raft::resources handle;
+
+  rmm::device_uvector<math_t> x;
+  rmm::device_uvector<math_t> gram;
+};
+
+typedef KernelCacheTest<float> KernelCacheTestFloat;
+
+TEST_P(KernelCacheTestFloat, Rows) { runTest(); }
+
+INSTANTIATE_TEST_SUITE_P(GramMatrixTests,
+                         KernelCacheTestFloat,
+                         ::testing::ValuesIn(kernel_cache_inputs));
 };  // end namespace raft::distance::kernels
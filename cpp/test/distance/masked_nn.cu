@@ -16,6 +16,7 @@
 
 #include "../test_utils.h"
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/kvp.hpp>
@@ -30,7 +31,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 namespace raft::distance::masked_nn {
 
@@ -290,6 +293,77 @@ auto run_masked_nn(const raft::handle_t& handle, Inputs<DataT> inp, const Params
   return out;
 }
 
+// Same as run_masked_nn, with the adjacency converted to the CSR format
+template <typename DataT, typename OutT = raft::KeyValuePair<int, DataT>>
+auto run_masked_nn_csr(const raft::handle_t& handle, Inputs<DataT> inp, const Params& p)
+  -> raft::device_vector<OutT, int>
+{
+  using IdxT  = int;
+  auto stream = resource::get_cuda_stream(handle);
+
+  // Compute norms:
+  auto x_norm = raft::make_device_vector<DataT, int>(handle, p.m);
+  auto y_norm = raft::make_device_vector<DataT, int>(handle, p.n);
+
+  raft::linalg::norm(handle,
+                     std::as_const(inp.x).view(),
+                     x_norm.view(),
+                     raft::linalg::L2Norm,
+                     raft::linalg::Apply::ALONG_ROWS);
+  raft::linalg::norm(handle,
+                     std::as_const(inp.y).view(),
+                     y_norm.view(),
+                     raft::linalg::L2Norm,
+                     raft::linalg::Apply::ALONG_ROWS);
+
+  // Convert the dense adjacency on the host
+  std::vector<char> adj_h(size_t(p.m) * p.num_groups);
+  raft::update_host(
+    reinterpret_cast<bool*>(adj_h.data()), inp.adj.data_handle(), adj_h.size(), stream);
+  resource::sync_stream(handle);
+  std::vector<IdxT> indptr_h(p.m + 1, 0);
+  std::vector<IdxT> indices_h;
+  for (int i = 0; i < p.m; i++) {
+    for (int g = 0; g < p.num_groups; g++) {
+      if (adj_h[size_t(i) * p.num_groups + g]) { indices_h.push_back(g); }
+    }
+    indptr_h[i + 1] = indices_h.size();
+  }
+  IdxT nnz     = indices_h.size();
+  auto indptr  = raft::make_device_vector<IdxT, IdxT>(handle, p.m + 1);
+  auto indices = raft::make_device_vector<IdxT, IdxT>(handle, std::max(nnz, 1));
+  raft::update_device(indptr.data_handle(), indptr_h.data(), indptr_h.size(), stream);
+  raft::update_device(indices.data_handle(), indices_h.data(), nnz, stream);
+  auto adj = raft::make_device_compressed_structure_view<IdxT, IdxT, IdxT>(
+    indptr.data_handle(), indices.data_handle(), p.m, p.num_groups, nnz);
+
+  // Create parameters for masked_l2_nn
+  using RedOpT     = MinAndDistanceReduceOp<int, DataT>;
+  using PairRedOpT = raft::distance::KVPMinReduce<int, DataT>;
+  using ParamT     = raft::distance::masked_l2_nn_params<RedOpT, PairRedOpT>;
+
+  bool init_out = true;
+  ParamT masked_l2_params{RedOpT{}, PairRedOpT{}, p.sqrt, init_out};
+
+  // Create output
+  auto out = raft::make_device_vector<OutT, IdxT, raft::layout_c_contiguous>(handle, p.m);
+
+  // Launch kernel
+  raft::distance::masked_l2_nn<DataT, OutT, IdxT>(handle,
+                                                  masked_l2_params,
+                                                  inp.x.view(),
+                                                  inp.y.view(),
+                                                  x_norm.view(),
+                                                  y_norm.view(),
+                                                  adj,
+                                                  inp.group_idxs.view(),
+                                                  out.view());
+
+  resource::sync_stream(handle);
+
+  return out;
+}
+
 template <typename T>
 struct CompareApproxAbsKVP {
   typedef typename raft::KeyValuePair<int, T> KVP;
@@ -433,6 +507,27 @@ TEST_P(MaskedL2NNTest, ReferenceCheckDouble)
                           resource::get_cuda_stream(handle)));
 }
 
+TEST_P(MaskedL2NNTest, ReferenceCheckCsrFloat)
+{
+  using DataT = float;
+
+  // Get parameters; create handle and input data.
+  Params p = GetParam();
+  raft::handle_t handle{};
+  Inputs<DataT> inputs{handle, p};
+
+  // Calculate reference and test output
+  auto out_reference = reference(handle, inputs, p);
+  auto out_fast      = run_masked_nn_csr(handle, inputs, p);
+
+  // Check for differences.
+  ASSERT_TRUE(devArrMatch(out_reference.data_handle(),
+                          out_fast.data_handle(),
+                          p.m,
+                          CompareApproxAbsKVP<DataT>(p.tolerance),
+                          resource::get_cuda_stream(handle)));
+}
+
 INSTANTIATE_TEST_CASE_P(MaskedL2NNTests, MaskedL2NNTest, ::testing::ValuesIn(gen_params()));
 
 }  // end namespace raft::distance::masked_nn
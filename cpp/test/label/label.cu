@@ -22,7 +22,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <random>
 #include <vector>
 
 namespace raft {
@@ -91,5 +94,56 @@ TEST(labelTest, Classlabels)
   EXPECT_TRUE(
     devArrMatchHost(y_relabeled_exp, y_relabeled_d.data(), n_rows, raft::Compare<float>(), stream));
 }
+// Integer labels go through the hash table: compare with a host reference on many repeated labels
+// spread over a large range, including the largest representable one.
+template <typename value_t>
+void hashed_labels_test(size_t n, int n_distinct)
+{
+  cudaStream_t stream;
+  RAFT_CUDA_TRY(cudaStreamCreate(&stream));
+
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<int64_t> value_dist(-1000000000, 1000000000);
+  std::vector<value_t> distinct(n_distinct);
+  for (auto& v : distinct) {
+    v = value_t(value_dist(gen));
+  }
+  distinct[0] = std::numeric_limits<value_t>::max();
+  std::uniform_int_distribution<int> pick(0, n_distinct - 1);
+  std::vector<value_t> data_h(n);
+  for (auto& v : data_h) {
+    v = distinct[pick(gen)];
+  }
+
+  std::vector<value_t> unique_h(data_h);
+  std::sort(unique_h.begin(), unique_h.end());
+  unique_h.erase(std::unique(unique_h.begin(), unique_h.end()), unique_h.end());
+  std::vector<value_t> expected_h(n);
+  for (size_t i = 0; i < n; i++) {
+    expected_h[i] =
+      value_t(std::lower_bound(unique_h.begin(), unique_h.end(), data_h[i]) - unique_h.begin());
+  }
+
+  rmm::device_uvector<value_t> data(n, stream);
+  rmm::device_uvector<value_t> actual(n, stream);
+  raft::update_device(data.data(), data_h.data(), n, stream);
+
+  rmm::device_uvector<value_t> unique(0, stream);
+  int n_unique = getUniquelabels(unique, data.data(), n, stream);
+  ASSERT_EQ(size_t(n_unique), unique_h.size());
+  EXPECT_TRUE(
+    devArrMatchHost(unique_h.data(), unique.data(), n_unique, raft::Compare<value_t>(), stream));
+
+  make_monotonic(actual.data(), data.data(), n, stream, true);
+  EXPECT_TRUE(
+    devArrMatchHost(expected_h.data(), actual.data(), n, raft::Compare<value_t>(), stream));
+
+  RAFT_CUDA_TRY(cudaStreamDestroy(stream));
+}
+
+TEST(labelTest, HashedLabelsInt) { hashed_labels_test<int>(1000000, 5000); }
+
+TEST(labelTest, HashedLabelsInt64) { hashed_labels_test<int64_t>(1000000, 100000); }
+
 };  // namespace label
 };  // namespace raft
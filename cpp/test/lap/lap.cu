@@ -22,16 +22,21 @@
  *          for the Linear Assignment Problem." Parallel Computing 57 (2016): 52-72.
  *
  */
+#include <raft/core/device_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/solver/linear_assignment.cuh>
+#include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_uvector.hpp>
 
 #include <gtest/gtest.h>
 #include <omp.h>
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <random>
+#include <vector>
 
 #define PROBLEMSIZE  1000  // Number of rows/columns
 #define BATCHSIZE    10    // Number of problems in the batch
@@ -149,4 +154,98 @@ TEST(Raft, HungarianLongLong)
   hungarian_test<long, long>(PROBLEMSIZE, COSTRANGE, PROBLEMCOUNT, REPETITIONS, BATCHSIZE, long{0});
 }
 
+// Solve a batch of problems of random sizes in [min_size, max_size] with the batched solver, and
+// check that every assignment is a permutation reaching the optimal cost. The reference cost is
+// found by enumerating the permutations for tiny problems, and with LinearAssignmentProblem
+// otherwise.
+template <typename vertex_t, typename weight_t>
+void batched_hungarian_test(int n_problems, int min_size, int max_size, int costrange)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+
+  std::uniform_int_distribution<int> size_dist(min_size, max_size);
+  std::vector<vertex_t> h_sizes(n_problems);
+  std::vector<int64_t> h_offsets(n_problems + 1, 0), h_cost_offsets(n_problems + 1, 0);
+  for (int k = 0; k < n_problems; k++) {
+    h_sizes[k]            = size_dist(generator);
+    h_offsets[k + 1]      = h_offsets[k] + h_sizes[k];
+    h_cost_offsets[k + 1] = h_cost_offsets[k] + int64_t(h_sizes[k]) * h_sizes[k];
+  }
+  std::vector<weight_t> h_costs(h_cost_offsets[n_problems]);
+  std::uniform_int_distribution<int> cost_dist(0, costrange);
+  for (auto& c : h_costs) {
+    c = weight_t(cost_dist(generator));
+  }
+
+  auto costs = raft::make_device_vector<weight_t, int64_t>(handle, h_costs.size());
+  auto sizes = raft::make_device_vector<vertex_t, int64_t>(handle, n_problems);
+  auto rows  = raft::make_device_vector<vertex_t, int64_t>(handle, h_offsets[n_problems]);
+  auto cols  = raft::make_device_vector<vertex_t, int64_t>(handle, h_offsets[n_problems]);
+  auto objs  = raft::make_device_vector<weight_t, int64_t>(handle, n_problems);
+  raft::update_device(costs.data_handle(), h_costs.data(), h_costs.size(), stream);
+  raft::update_device(sizes.data_handle(), h_sizes.data(), n_problems, stream);
+
+  raft::solver::batched_linear_assignment(handle,
+                                          raft::make_const_mdspan(costs.view()),
+                                          raft::make_const_mdspan(sizes.view()),
+                                          rows.view(),
+                                          cols.view(),
+                                          std::make_optional(objs.view()));
+
+  std::vector<vertex_t> h_rows(h_offsets[n_problems]), h_cols(h_offsets[n_problems]);
+  std::vector<weight_t> h_objs(n_problems);
+  raft::update_host(h_rows.data(), rows.data_handle(), h_rows.size(), stream);
+  raft::update_host(h_cols.data(), cols.data_handle(), h_cols.size(), stream);
+  raft::update_host(h_objs.data(), objs.data_handle(), n_problems, stream);
+  resource::sync_stream(handle, stream);
+
+  for (int k = 0; k < n_problems; k++) {
+    const vertex_t n  = h_sizes[k];
+    const weight_t* a = h_costs.data() + h_cost_offsets[k];
+    const vertex_t* r = h_rows.data() + h_offsets[k];
+    const vertex_t* c = h_cols.data() + h_offsets[k];
+    weight_t cost     = 0;
+    for (vertex_t i = 0; i < n; i++) {
+      ASSERT_TRUE(r[i] >= 0 && r[i] < n) << "problem " << k;
+      ASSERT_EQ(c[r[i]], i) << "problem " << k;
+      cost += a[int64_t(i) * n + r[i]];
+    }
+    ASSERT_EQ(cost, h_objs[k]) << "problem " << k;
+
+    weight_t ref = 0;
+    if (n <= 7) {
+      std::vector<vertex_t> perm(n);
+      std::iota(perm.begin(), perm.end(), vertex_t(0));
+      ref = cost;
+      do {
+        weight_t c_perm = 0;
+        for (vertex_t i = 0; i < n; i++) {
+          c_perm += a[int64_t(i) * n + perm[i]];
+        }
+        ref = std::min(ref, c_perm);
+      } while (std::next_permutation(perm.begin(), perm.end()));
+    } else {
+      rmm::device_uvector<vertex_t> row_v(n, stream), col_v(n, stream);
+      raft::solver::LinearAssignmentProblem<vertex_t, weight_t> lpx(handle, n, 1, weight_t(0));
+      lpx.solve(costs.data_handle() + h_cost_offsets[k], row_v.data(), col_v.data());
+      ref = lpx.getPrimalObjectiveValue(0);
+    }
+    ASSERT_EQ(cost, ref) << "problem " << k;
+  }
+}
+
+TEST(Raft, BatchedHungarianTinyIntFloat) { batched_hungarian_test<int, float>(200, 1, 7, 100); }
+
+TEST(Raft, BatchedHungarianTinyLongLong) { batched_hungarian_test<long, long>(200, 1, 7, 100); }
+
+TEST(Raft, BatchedHungarianIntFloat) { batched_hungarian_test<int, float>(20, 50, 300, COSTRANGE); }
+
+TEST(Raft, BatchedHungarianIntDouble)
+{
+  batched_hungarian_test<int, double>(20, 50, 300, COSTRANGE);
+}
+
+TEST(Raft, BatchedHungarianLongLong) { batched_hungarian_test<long, long>(20, 50, 300, COSTRANGE); }
+
 }  // namespace raft
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/gemm.hpp>
+#include <raft/linalg/qr.cuh>
+#include <raft/linalg/svd.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+struct BatchedInputs {
+  int m;
+  int n;
+  int k;
+  int batch_size;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const BatchedInputs& p)
+{
+  os << " m: " << p.m << ", n: " << p.n << ", k: " << p.k << ", batch_size: " << p.batch_size;
+  return os;
+}
+
+template <typename T>
+class BatchedTest : public ::testing::TestWithParam<BatchedInputs> {
+ public:
+  BatchedTest()
+    : params(::testing::TestWithParam<BatchedInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      gen(params.seed)
+  {
+  }
+
+ protected:
+  /** A batch of column-major matrices, with a shifted diagonal to keep them well conditioned */
+  std::vector<T> random_batch(int rows, int cols, T shift = T(0))
+  {
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    std::vector<T> out(size_t(rows) * cols * params.batch_size);
+    for (size_t i = 0; i < out.size(); i++) {
+      out[i] = dist(gen);
+    }
+    for (int b = 0; b < params.batch_size; b++) {
+      for (int i = 0; i < std::min(rows, cols); i++) {
+        out[size_t(b) * rows * cols + i + size_t(i) * rows] += shift;
+      }
+    }
+    return out;
+  }
+
+  auto batch_view(T* ptr, int rows, int cols)
+  {
+    return raft::make_mdspan<T, int, raft::col_major, false, true>(
+      ptr, raft::make_extents<int>(rows, cols, params.batch_size));
+  }
+
+  auto const_batch_view(const T* ptr, int rows, int cols)
+  {
+    return raft::make_mdspan<const T, int, raft::col_major, false, true>(
+      ptr, raft::make_extents<int>(rows, cols, params.batch_size));
+  }
+
+  std::vector<T> to_host(const rmm::device_uvector<T>& d)
+  {
+    std::vector<T> h(d.size());
+    raft::update_host(h.data(), d.data(), d.size(), stream);
+    resource::sync_stream(handle, stream);
+    return h;
+  }
+
+  // the products op(a) * op(b) of the column-major batches, op(a) of size rows x inner and op(b)
+  // of size inner x cols
+  std::vector<T> host_gemm(const std::vector<T>& a,
+                           bool trans_a,
+                           const std::vector<T>& b,
+                           bool trans_b,
+                           int rows,
+                           int cols,
+                           int inner)
+  {
+    std::vector<T> c(size_t(rows) * cols * params.batch_size);
+    for (int bi = 0; bi < params.batch_size; bi++) {
+      const T* pa = a.data() + size_t(bi) * rows * inner;
+      const T* pb = b.data() + size_t(bi) * inner * cols;
+      T* pc       = c.data() + size_t(bi) * rows * cols;
+      for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+          double acc = 0;
+          for (int l = 0; l < inner; l++) {
+            double va = trans_a ? pa[l + size_t(i) * inner] : pa[i + size_t(l) * rows];
+            double vb = trans_b ? pb[j + size_t(l) * cols] : pb[l + size_t(j) * inner];
+            acc += va * vb;
+          }
+          pc[i + size_t(j) * rows] = T(acc);
+        }
+      }
+    }
+    return c;
+  }
+
+  void test_gemm(bool trans_x)
+  {
+    int m = params.m, n = params.n, k = params.k;
+    auto x_h = random_batch(trans_x ? k : m, trans_x ? m : k);
+    auto y_h = random_batch(k, n);
+    rmm::device_uvector<T> x(x_h.size(), stream);
+    rmm::device_uvector<T> y(y_h.size(), stream);
+    rmm::device_uvector<T> z(size_t(m) * n * params.batch_size, stream);
+    raft::update_device(x.data(), x_h.data(), x_h.size(), stream);
+    raft::update_device(y.data(), y_h.data(), y_h.size(), stream);
+
+    T alpha = 2;
+    raft::linalg::gemm_batched(handle,
+                               trans_x,
+                               false,
+                               const_batch_view(x.data(), trans_x ? k : m, trans_x ? m : k),
+                               const_batch_view(y.data(), k, n),
+                               batch_view(z.data(), m, n),
+                               std::make_optional(raft::make_host_scalar_view(&alpha)));
+
+    auto expected = host_gemm(x_h, trans_x, y_h, false, m, n, k);
+    for (auto& v : expected) {
+      v *= alpha;
+    }
+    ASSERT_TRUE(hostVecMatch(expected, to_host(z), CompareApprox<T>(1e-4)));
+  }
+
+  void test_qr()
+  {
+    int m = params.m, n = params.n;
+    if (m < n) { GTEST_SKIP(); }
+    auto a_h = random_batch(m, n);
+    rmm::device_uvector<T> a(a_h.size(), stream);
+    rmm::device_uvector<T> q(a_h.size(), stream);
+    rmm::device_uvector<T> r(size_t(n) * n * params.batch_size, stream);
+    raft::update_device(a.data(), a_h.data(), a_h.size(), stream);
+
+    raft::linalg::qr_get_qr_batched(handle,
+                                    const_batch_view(a.data(), m, n),
+                                    batch_view(q.data(), m, n),
+                                    batch_view(r.data(), n, n));
+    auto q_h = to_host(q);
+    auto r_h = to_host(r);
+
+    // R is upper triangular, Q has orthonormal columns and Q * R = A
+    for (int b = 0; b < params.batch_size; b++) {
+      for (int j = 0; j < n; j++) {
+        for (int i = j + 1; i < n; i++) {
+          ASSERT_EQ(r_h[size_t(b) * n * n + i + size_t(j) * n], T(0));
+        }
+      }
+    }
+    auto qtq = host_gemm(q_h, true, q_h, false, n, n, m);
+    for (int b = 0; b < params.batch_size; b++) {
+      for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) {
+          ASSERT_NEAR(qtq[size_t(b) * n * n + i + size_t(j) * n], T(i == j), 1e-4);
+        }
+      }
+    }
+    auto qr = host_gemm(q_h, false, r_h, false, m, n, n);
+    ASSERT_TRUE(hostVecMatch(a_h, qr, CompareApprox<T>(1e-4)));
+  }
+
+  void test_svd()
+  {
+    int m = params.m, n = params.n;
+    if (m < n) { GTEST_SKIP(); }
+    auto a_h = random_batch(m, n, T(n));
+    rmm::device_uvector<T> a(a_h.size(), stream);
+    rmm::device_uvector<T> s(size_t(n) * params.batch_size, stream);
+    rmm::device_uvector<T> u(a_h.size(), stream);
+    rmm::device_uvector<T> v(size_t(n) * n * params.batch_size, stream);
+    raft::update_device(a.data(), a_h.data(), a_h.size(), stream);
+
+    raft::linalg::svd_batched(
+      handle,
+      const_batch_view(a.data(), m, n),
+      raft::make_device_matrix_view<T, int, raft::col_major>(s.data(), n, params.batch_size),
+      batch_view(u.data(), m, n),
+      batch_view(v.data(), n, n));
+    auto s_h = to_host(s);
+    auto u_h = to_host(u);
+    auto v_h = to_host(v);
+
+    // the singular values are sorted in descending order, and U * diag(S) * V^T = A
+    for (int b = 0; b < params.batch_size; b++) {
+      for (int j = 0; j < n; j++) {
+        if (j > 0) { ASSERT_GE(s_h[size_t(b) * n + j - 1], s_h[size_t(b) * n + j]); }
+        for (int i = 0; i < m; i++) {
+          u_h[size_t(b) * m * n + i + size_t(j) * m] *= s_h[size_t(b) * n + j];
+        }
+      }
+    }
+    auto usv = host_gemm(u_h, false, v_h, true, m, n, n);
+    ASSERT_TRUE(hostVecMatch(a_h, usv, CompareApprox<T>(1e-3)));
+  }
+
+  raft::resources handle;
+  BatchedInputs params;
+  cudaStream_t stream;
+  std::mt19937 gen;
+};
+
+// the SVD of the matrices with more than 32 rows goes through the approximate batched solver
+const std::vector<BatchedInputs> inputs = {{8, 8, 8, 100, 1234ULL},
+                                           {16, 4, 9, 37, 1235ULL},
+                                           {32, 32, 32, 10, 1236ULL},
+                                           {4, 16, 5, 3, 1237ULL},
+                                           {64, 64, 64, 200, 1238ULL},
+                                           {100, 20, 30, 17, 1239ULL}};
+
+using BatchedTestF = BatchedTest<float>;
+TEST_P(BatchedTestF, Gemm) { test_gemm(false); }
+TEST_P(BatchedTestF, GemmTransX) { test_gemm(true); }
+TEST_P(BatchedTestF, QR) { test_qr(); }
+TEST_P(BatchedTestF, SVD) { test_svd(); }
+INSTANTIATE_TEST_CASE_P(BatchedTests, BatchedTestF, ::testing::ValuesIn(inputs));
+
+using BatchedTestD = BatchedTest<double>;
+TEST_P(BatchedTestD, Gemm) { test_gemm(false); }
+TEST_P(BatchedTestD, GemmTransX) { test_gemm(true); }
+TEST_P(BatchedTestD, QR) { test_qr(); }
+TEST_P(BatchedTestD, SVD) { test_svd(); }
+INSTANTIATE_TEST_CASE_P(BatchedTests, BatchedTestD, ::testing::ValuesIn(inputs));
+
+}  // end namespace linalg
+}  // end namespace raft
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/cholesky_rk_update.cuh>
+#include <raft/linalg/lstsq.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+struct CholeskyRkInputs {
+  int n;
+  int k;
+  bool downdate;
+  bool upper;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const CholeskyRkInputs& p)
+{
+  os << " n: " << p.n << ", k: " << p.k << ", downdate: " << p.downdate << ", upper: " << p.upper;
+  return os;
+}
+
+/** Lower Cholesky factor of the column major (n, n) matrix a */
+std::vector<double> host_cholesky(const std::vector<double>& a, int n)
+{
+  std::vector<double> l(size_t(n) * n, 0.0);
+  for (int j = 0; j < n; j++) {
+    double d = a[j + size_t(j) * n];
+    for (int p = 0; p < j; p++) {
+      d -= l[j + size_t(p) * n] * l[j + size_t(p) * n];
+    }
+    l[j + size_t(j) * n] = std::sqrt(d);
+    for (int i = j + 1; i < n; i++) {
+      double s = a[i + size_t(j) * n];
+      for (int p = 0; p < j; p++) {
+        s -= l[i + size_t(p) * n] * l[j + size_t(p) * n];
+      }
+      l[i + size_t(j) * n] = s / l[j + size_t(j) * n];
+    }
+  }
+  return l;
+}
+
+template <typename T>
+class CholeskyRkTest : public ::testing::TestWithParam<CholeskyRkInputs> {
+ public:
+  CholeskyRkTest()
+    : params(::testing::TestWithParam<CholeskyRkInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    const int n = params.n, k = params.k;
+    std::mt19937 gen(params.seed);
+    std::normal_distribution<double> dist;
+    std::vector<double> x(size_t(2 * n) * n), v(size_t(n) * k);
+    for (auto& e : x) {
+      e = dist(gen);
+    }
+    for (auto& e : v) {
+      e = dist(gen);
+    }
+    // B = X^T X / (2 n) + I is well conditioned, and A' = A +/- V V^T with A = B or B + V V^T
+    std::vector<double> b(size_t(n) * n), vvt(size_t(n) * n);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        double s = 0, t = 0;
+        for (int r = 0; r < 2 * n; r++) {
+          s += x[r + size_t(i) * 2 * n] * x[r + size_t(j) * 2 * n];
+        }
+        for (int c = 0; c < k; c++) {
+          t += v[i + size_t(c) * n] * v[j + size_t(c) * n];
+        }
+        b[i + size_t(j) * n]   = s / (2 * n) + (i == j);
+        vvt[i + size_t(j) * n] = t;
+      }
+    }
+    std::vector<double> a(b), a_new(b);
+    for (size_t i = 0; i < a.size(); i++) {
+      (params.downdate ? a : a_new)[i] += vvt[i];
+    }
+    auto l_in  = host_cholesky(a, n);
+    auto l_exp = host_cholesky(a_new, n);
+
+    // the unreferenced triangle holds a marker which must stay untouched
+    constexpr T kMarker = T(-12345);
+    std::vector<T> l_h(size_t(n) * n), v_h(v.begin(), v.end());
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        T val = i >= j ? T(l_in[i + size_t(j) * n]) : kMarker;
+        l_h[params.upper ? j + size_t(i) * n : i + size_t(j) * n] = val;
+      }
+    }
+    rmm::device_uvector<T> l_d(l_h.size(), stream);
+    rmm::device_uvector<T> v_d(v_h.size(), stream);
+    raft::update_device(l_d.data(), l_h.data(), l_h.size(), stream);
+    raft::update_device(v_d.data(), v_h.data(), v_h.size(), stream);
+
+    cholesky_rank_k_update(handle,
+                           raft::make_device_matrix_view<T, int, raft::col_major>(l_d.data(), n, n),
+                           raft::make_device_matrix_view<const T, int, raft::col_major>(
+                             v_d.data(), n, k),
+                           params.downdate,
+                           params.upper ? FillMode::UPPER : FillMode::LOWER);
+    raft::update_host(l_h.data(), l_d.data(), l_h.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    const double tol = std::is_same_v<T, float> ? 1e-3 : 1e-9;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        T val = l_h[params.upper ? j + size_t(i) * n : i + size_t(j) * n];
+        if (i >= j) {
+          ASSERT_NEAR(val, l_exp[i + size_t(j) * n], tol * std::sqrt(double(n + k)))
+            << "at " << i << ", " << j;
+        } else {
+          ASSERT_EQ(val, kMarker) << "at " << i << ", " << j;
+        }
+      }
+    }
+  }
+
+  raft::resources handle;
+  CholeskyRkInputs params;
+  cudaStream_t stream;
+};
+
+// the blocks of 64 columns and the chunks of 64 ranks do not divide n and k evenly
+const std::vector<CholeskyRkInputs> inputs = {{1, 1, false, false, 1234ULL},
+                                              {10, 1, false, false, 1234ULL},
+                                              {10, 3, true, false, 1234ULL},
+                                              {10, 3, false, true, 1234ULL},
+                                              {10, 3, true, true, 1234ULL},
+                                              {64, 64, false, false, 1234ULL},
+                                              {100, 7, false, false, 1234ULL},
+                                              {100, 7, true, false, 1234ULL},
+                                              {100, 7, false, true, 1234ULL},
+                                              {100, 7, true, true, 1234ULL},
+                                              {150, 130, false, false, 1234ULL},
+                                              {150, 130, true, true, 1234ULL},
+                                              {30, 200, false, true, 1234ULL},
+                                              {30, 200, true, false, 1234ULL}};
+
+using CholeskyRkTestF = CholeskyRkTest<float>;
+TEST_P(CholeskyRkTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(CholeskyRkTests, CholeskyRkTestF, ::testing::ValuesIn(inputs));
+
+using CholeskyRkTestD = CholeskyRkTest<double>;
+TEST_P(CholeskyRkTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(CholeskyRkTests, CholeskyRkTestD, ::testing::ValuesIn(inputs));
+
+TEST(CholeskyRkErrorTest, DowndateNotPositiveDefinite)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  // L = I and V V^T = 4 e_0 e_0^T
+  std::vector<double> l_h{1, 0, 0, 1}, v_h{2, 0};
+  rmm::device_uvector<double> l_d(4, stream);
+  rmm::device_uvector<double> v_d(2, stream);
+  raft::update_device(l_d.data(), l_h.data(), 4, stream);
+  raft::update_device(v_d.data(), v_h.data(), 2, stream);
+  auto l = raft::make_device_matrix_view<double, int, raft::col_major>(l_d.data(), 2, 2);
+  auto v = raft::make_device_matrix_view<const double, int, raft::col_major>(v_d.data(), 2, 1);
+  ASSERT_THROW(cholesky_rank_k_update(handle, l, v, true), raft::exception);
+}
+
+struct LstsqCholeskyInputs {
+  int n_cols;
+  int batch;
+  int n_batches;
+  // the number of batches removed again at the end
+  int n_removed;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const LstsqCholeskyInputs& p)
+{
+  os << " n_cols: " << p.n_cols << ", batch: " << p.batch << ", n_batches: " << p.n_batches
+     << ", n_removed: " << p.n_removed;
+  return os;
+}
+
+template <typename T>
+class LstsqCholeskyTest : public ::testing::TestWithParam<LstsqCholeskyInputs> {
+ public:
+  LstsqCholeskyTest()
+    : params(::testing::TestWithParam<LstsqCholeskyInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    const int n = params.n_cols, m = params.batch;
+    const double alpha = 1e-2;
+    std::mt19937 gen(params.seed);
+    std::normal_distribution<double> dist;
+    std::vector<double> w_true(n);
+    for (auto& e : w_true) {
+      e = dist(gen);
+    }
+    std::vector<std::vector<T>> a_batches(params.n_batches), b_batches(params.n_batches);
+    for (int bt = 0; bt < params.n_batches; bt++) {
+      a_batches[bt].resize(size_t(m) * n);
+      b_batches[bt].resize(m);
+      for (auto& e : a_batches[bt]) {
+        e = T(dist(gen));
+      }
+      for (int r = 0; r < m; r++) {
+        double s = 0.1 * dist(gen);
+        for (int c = 0; c < n; c++) {
+          s += a_batches[bt][r + size_t(c) * m] * w_true[c];
+        }
+        b_batches[bt][r] = T(s);
+      }
+    }
+
+    // L = sqrt(alpha) I, Ab = 0
+    std::vector<T> l_h(size_t(n) * n, T(0));
+    for (int i = 0; i < n; i++) {
+      l_h[i + size_t(i) * n] = T(std::sqrt(alpha));
+    }
+    rmm::device_uvector<T> l(l_h.size(), stream);
+    rmm::device_uvector<T> ab(n, stream);
+    rmm::device_uvector<T> w(n, stream);
+    rmm::device_uvector<T> a_d(size_t(m) * n, stream);
+    rmm::device_uvector<T> b_d(m, stream);
+    raft::update_device(l.data(), l_h.data(), l_h.size(), stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(ab.data(), 0, n * sizeof(T), stream));
+    auto update = [&](int bt, bool downdate) {
+      raft::update_device(a_d.data(), a_batches[bt].data(), a_d.size(), stream);
+      raft::update_device(b_d.data(), b_batches[bt].data(), m, stream);
+      lstsq_cholesky_update(
+        handle,
+        raft::make_device_matrix_view<const T, int, raft::col_major>(a_d.data(), m, n),
+        raft::make_device_vector_view<const T, int>(b_d.data(), m),
+        raft::make_device_matrix_view<T, int, raft::col_major>(l.data(), n, n),
+        raft::make_device_vector_view<T, int>(ab.data(), n),
+        raft::make_device_vector_view<T, int>(w.data(), n),
+        downdate);
+    };
+    for (int bt = 0; bt < params.n_batches; bt++) {
+      update(bt, false);
+    }
+    for (int bt = 0; bt < params.n_removed; bt++) {
+      update(bt, true);
+    }
+
+    // (A^T A + alpha I) w = A^T b over the remaining batches, solved on the host
+    std::vector<double> ata(size_t(n) * n, 0.0), atb(n, 0.0);
+    for (int i = 0; i < n; i++) {
+      ata[i + size_t(i) * n] = alpha;
+    }
+    for (int bt = params.n_removed; bt < params.n_batches; bt++) {
+      const auto& ab_ = a_batches[bt];
+      for (int r = 0; r < m; r++) {
+        for (int i = 0; i < n; i++) {
+          atb[i] += double(ab_[r + size_t(i) * m]) * b_batches[bt][r];
+          for (int j = 0; j < n; j++) {
+            ata[i + size_t(j) * n] += double(ab_[r + size_t(i) * m]) * ab_[r + size_t(j) * m];
+          }
+        }
+      }
+    }
+    auto lc = host_cholesky(ata, n);
+    std::vector<double> w_exp(atb);
+    for (int i = 0; i < n; i++) {
+      for (int p = 0; p < i; p++) {
+        w_exp[i] -= lc[i + size_t(p) * n] * w_exp[p];
+      }
+      w_exp[i] /= lc[i + size_t(i) * n];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+      for (int p = i + 1; p < n; p++) {
+        w_exp[i] -= lc[p + size_t(i) * n] * w_exp[p];
+      }
+      w_exp[i] /= lc[i + size_t(i) * n];
+    }
+
+    std::vector<T> w_h(n);
+    raft::update_host(w_h.data(), w.data(), n, stream);
+    resource::sync_stream(handle, stream);
+    const double tol = std::is_same_v<T, float> ? 1e-3 : 1e-9;
+    for (int i = 0; i < n; i++) {
+      ASSERT_NEAR(w_h[i], w_exp[i], tol * std::max(1.0, std::abs(w_exp[i]))) << "at " << i;
+    }
+  }
+
+  raft::resources handle;
+  LstsqCholeskyInputs params;
+  cudaStream_t stream;
+};
+
+const std::vector<LstsqCholeskyInputs> lstsq_inputs = {{5, 20, 1, 0, 1234ULL},
+                                                       {5, 20, 3, 1, 1234ULL},
+                                                       {50, 100, 4, 2, 1234ULL},
+                                                       {100, 256, 3, 0, 1234ULL},
+                                                       {100, 256, 5, 2, 1234ULL}};
+
+using LstsqCholeskyTestF = LstsqCholeskyTest<float>;
+TEST_P(LstsqCholeskyTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(LstsqCholeskyTests,
+                        LstsqCholeskyTestF,
+                        ::testing::ValuesIn(lstsq_inputs));
+
+using LstsqCholeskyTestD = LstsqCholeskyTest<double>;
+TEST_P(LstsqCholeskyTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(LstsqCholeskyTests,
+                        LstsqCholeskyTestD,
+                        ::testing::ValuesIn(lstsq_inputs));
+
+}  // end namespace linalg
+}  // end namespace raft
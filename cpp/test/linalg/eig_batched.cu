@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/eig.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+struct EigBatchedInputs {
+  int n;
+  int batch_size;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const EigBatchedInputs& p)
+{
+  os << " n: " << p.n << ", batch_size: " << p.batch_size;
+  return os;
+}
+
+template <typename T>
+class EigBatchedTest : public ::testing::TestWithParam<EigBatchedInputs> {
+ public:
+  EigBatchedTest()
+    : params(::testing::TestWithParam<EigBatchedInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    const int n              = params.n;
+    const int batch_size     = params.batch_size;
+    const size_t matrix_size = size_t(n) * n;
+    std::mt19937 gen(params.seed);
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    std::vector<T> in_h(matrix_size * batch_size);
+    for (int b = 0; b < batch_size; b++) {
+      for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+          T v = dist(gen);
+          in_h[b * matrix_size + i + size_t(j) * n] = v;
+          in_h[b * matrix_size + j + size_t(i) * n] = v;
+        }
+      }
+    }
+    rmm::device_uvector<T> in(in_h.size(), stream);
+    rmm::device_uvector<T> vecs(in_h.size(), stream);
+    rmm::device_uvector<T> vals(size_t(n) * batch_size, stream);
+    raft::update_device(in.data(), in_h.data(), in_h.size(), stream);
+
+    eig_jacobi_batched(
+      handle,
+      raft::make_mdspan<const T, int, raft::col_major, false, true>(
+        in.data(), raft::make_extents<int>(n, n, batch_size)),
+      raft::make_mdspan<T, int, raft::col_major, false, true>(
+        vecs.data(), raft::make_extents<int>(n, n, batch_size)),
+      raft::make_device_matrix_view<T, int, raft::col_major>(vals.data(), n, batch_size),
+      std::is_same_v<T, float> ? T(1e-7) : T(1e-14),
+      100);
+
+    std::vector<T> vecs_h(vecs.size()), vals_h(vals.size());
+    raft::update_host(vecs_h.data(), vecs.data(), vecs.size(), stream);
+    raft::update_host(vals_h.data(), vals.data(), vals.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    // ascending eigen values, orthonormal eigenvectors and A v = lambda v
+    const double tol = std::is_same_v<T, float> ? 1e-4 : 1e-10;
+    for (int b = 0; b < batch_size; b++) {
+      const T* a   = in_h.data() + b * matrix_size;
+      const T* v   = vecs_h.data() + b * matrix_size;
+      const T* lam = vals_h.data() + size_t(b) * n;
+      for (int i = 0; i < n; i++) {
+        if (i > 0) { ASSERT_LE(lam[i - 1], lam[i] + tol); }
+        for (int j = 0; j <= i; j++) {
+          double dot = 0;
+          for (int r = 0; r < n; r++) {
+            dot += double(v[r + size_t(i) * n]) * v[r + size_t(j) * n];
+          }
+          ASSERT_NEAR(dot, double(i == j), tol * n) << "vectors " << i << ", " << j;
+        }
+        for (int r = 0; r < n; r++) {
+          double av = 0;
+          for (int c = 0; c < n; c++) {
+            av += double(a[r + size_t(c) * n]) * v[c + size_t(i) * n];
+          }
+          ASSERT_NEAR(av, double(lam[i]) * v[r + size_t(i) * n], tol * n)
+            << "matrix " << b << ", vector " << i << ", row " << r;
+        }
+      }
+    }
+  }
+
+  raft::resources handle;
+  EigBatchedInputs params;
+  cudaStream_t stream;
+};
+
+// up to 32 rows the matrices are decomposed in a single batched call
+const std::vector<EigBatchedInputs> inputs = {{1, 5, 1234ULL},
+                                              {4, 1, 1234ULL},
+                                              {4, 100, 1234ULL},
+                                              {17, 33, 1234ULL},
+                                              {32, 64, 1234ULL},
+                                              {33, 5, 1234ULL},
+                                              {100, 3, 1234ULL}};
+
+using EigBatchedTestF = EigBatchedTest<float>;
+TEST_P(EigBatchedTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(EigBatchedTests, EigBatchedTestF, ::testing::ValuesIn(inputs));
+
+using EigBatchedTestD = EigBatchedTest<double>;
+TEST_P(EigBatchedTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(EigBatchedTests, EigBatchedTestD, ::testing::ValuesIn(inputs));
+
+}  // end namespace linalg
+}  // end namespace raft
@@ -34,6 +34,7 @@ struct EigSelInputs {
   int len;
   int n;
   int n_eigen_vals;
+  EigVecMemUsage mem_usage;
 };
 
 template <typename T>
@@ -97,7 +98,7 @@ class EigSelTest : public ::testing::TestWithParam<EigSelInputs<T>> {
                                    eig_vectors_view,
                                    eig_vals_view,
                                    static_cast<std::size_t>(params.n_eigen_vals),
-                                   EigVecMemUsage::OVERWRITE_INPUT);
+                                   params.mem_usage);
     resource::sync_stream(handle);
   }
 
@@ -113,9 +114,13 @@ class EigSelTest : public ::testing::TestWithParam<EigSelInputs<T>> {
   rmm::device_uvector<T> eig_vals_ref;
 };
 
-const std::vector<EigSelInputs<float>> inputsf2 = {{0.001f, 4 * 4, 4, 3}};
+const std::vector<EigSelInputs<float>> inputsf2 = {
+  {0.001f, 4 * 4, 4, 3, EigVecMemUsage::OVERWRITE_INPUT},
+  {0.001f, 4 * 4, 4, 3, EigVecMemUsage::COPY_INPUT}};
 
-const std::vector<EigSelInputs<double>> inputsd2 = {{0.001, 4 * 4, 4, 3}};
+const std::vector<EigSelInputs<double>> inputsd2 = {
+  {0.001, 4 * 4, 4, 3, EigVecMemUsage::OVERWRITE_INPUT},
+  {0.001, 4 * 4, 4, 3, EigVecMemUsage::COPY_INPUT}};
 
 typedef EigSelTest<float> EigSelTestValF;
 TEST_P(EigSelTestValF, Result)
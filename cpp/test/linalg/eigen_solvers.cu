@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020-2023, NVIDIA CORPORATION.
+ * Copyright (c) 2020-2024, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -14,18 +14,27 @@
  * limitations under the License.
  */
 
+#include "../test_utils.cuh"
+
 #include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/device_id.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/spectral/eigen_solvers.cuh>
 #include <raft/spectral/partition.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <iostream>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace raft {
 namespace spectral {
@@ -115,5 +124,81 @@ TEST(Raft, SpectralSolvers)
   EXPECT_ANY_THROW(spectral::analyzePartition(h, sm, k, clusters, edgeCut, cost));
 }
 
+// The Laplacian of a cycle has the eigenvalues 2 - 2 * cos(2 * pi * j / n), all of them double
+// but 0 and, for an even n, 4: the block Lanczos method has to find both copies.
+TEST(Raft, BlockLanczosCycleLaplacian)
+{
+  common::nvtx::range fun_scope("test::BlockLanczosCycleLaplacian");
+  using namespace matrix;
+  using index_type = int;
+  using value_type = double;
+
+  raft::resources h;
+  auto stream = resource::get_cuda_stream(h);
+
+  const index_type n = 64;
+  std::vector<index_type> ro_h(n + 1);
+  std::vector<index_type> ci_h(2 * n);
+  std::vector<value_type> vs_h(2 * n, 1);
+  for (index_type i = 0; i < n; ++i) {
+    ro_h[i]         = 2 * i;
+    ci_h[2 * i]     = (i + n - 1) % n;
+    ci_h[2 * i + 1] = (i + 1) % n;
+  }
+  ro_h[n] = 2 * n;
+  std::sort(ci_h.begin() + 2 * (n - 1), ci_h.end());
+  std::sort(ci_h.begin(), ci_h.begin() + 2);
+
+  rmm::device_uvector<index_type> ro(n + 1, stream);
+  rmm::device_uvector<index_type> ci(2 * n, stream);
+  rmm::device_uvector<value_type> vs(2 * n, stream);
+  update_device(ro.data(), ro_h.data(), n + 1, stream);
+  update_device(ci.data(), ci_h.data(), 2 * n, stream);
+  update_device(vs.data(), vs_h.data(), 2 * n, stream);
+  laplacian_matrix_t<index_type, value_type> L{h, ro.data(), ci.data(), vs.data(), n, 2 * n};
+
+  std::vector<value_type> spectrum(n);
+  for (index_type j = 0; j < n; ++j) {
+    spectrum[j] = 2 - 2 * std::cos(2 * M_PI * j / n);
+  }
+  std::sort(spectrum.begin(), spectrum.end());
+
+  const index_type neigvs = 5;
+  eigen_solver_config_t<index_type, value_type> cfg{neigvs, 500, 40, 1.0e-10, false, 1234567, 4};
+  lanczos_solver_t<index_type, value_type> eig_solver{cfg};
+
+  rmm::device_uvector<value_type> eigvals(neigvs, stream);
+  rmm::device_uvector<value_type> eigvecs(n * neigvs, stream);
+  std::vector<value_type> eigvals_h(neigvs);
+  std::vector<value_type> eigvecs_h(n * neigvs);
+  auto check = [&](const std::vector<value_type>& expected) {
+    update_host(eigvals_h.data(), eigvals.data(), neigvs, stream);
+    update_host(eigvecs_h.data(), eigvecs.data(), n * neigvs, stream);
+    resource::sync_stream(h);
+    ASSERT_TRUE(hostVecMatch(expected, eigvals_h, CompareApprox<value_type>(1e-6)));
+    // the residuals of the eigenpairs, and the norms of the eigenvectors
+    for (index_type c = 0; c < neigvs; ++c) {
+      const value_type* v = eigvecs_h.data() + c * n;
+      value_type res2     = 0;
+      value_type norm2    = 0;
+      for (index_type i = 0; i < n; ++i) {
+        value_type r = 2 * v[i] - v[(i + n - 1) % n] - v[(i + 1) % n] - eigvals_h[c] * v[i];
+        res2 += r * r;
+        norm2 += v[i] * v[i];
+      }
+      ASSERT_LT(std::sqrt(res2), 1e-6) << "eigenvector " << c;
+      ASSERT_NEAR(norm2, 1, 1e-6) << "eigenvector " << c;
+    }
+  };
+
+  index_type iters = eig_solver.solve_smallest_eigenvectors(h, L, eigvals.data(), eigvecs.data());
+  ASSERT_GT(iters, 0);
+  check(std::vector<value_type>(spectrum.begin(), spectrum.begin() + neigvs));
+
+  iters = eig_solver.solve_largest_eigenvectors(h, L, eigvals.data(), eigvecs.data());
+  ASSERT_GT(iters, 0);
+  check(std::vector<value_type>(spectrum.end() - neigvs, spectrum.end()));
+}
+
 }  // namespace spectral
 }  // namespace raft
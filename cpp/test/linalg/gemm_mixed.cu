@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/gemm.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+struct GemmMixedInputs {
+  int m;
+  int n;
+  int k;
+  bool x_row_major;
+  bool y_row_major;
+  bool z_row_major;
+  Epilogue epilogue;
+  float alpha;
+  float beta;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const GemmMixedInputs& p)
+{
+  os << " m: " << p.m << ", n: " << p.n << ", k: " << p.k << ", x_row_major: " << p.x_row_major
+     << ", y_row_major: " << p.y_row_major << ", z_row_major: " << p.z_row_major
+     << ", epilogue: " << int(p.epilogue) << ", alpha: " << p.alpha << ", beta: " << p.beta;
+  return os;
+}
+
+template <typename InT, typename OutT>
+class GemmMixedTest : public ::testing::TestWithParam<GemmMixedInputs> {
+ public:
+  GemmMixedTest()
+    : params(::testing::TestWithParam<GemmMixedInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  template <typename T>
+  std::vector<T> random(size_t size, std::mt19937& gen)
+  {
+    // small integers and halves, which all the input types and the products represent exactly
+    std::uniform_int_distribution<int> dist(-8, 8);
+    std::vector<T> out(size);
+    for (auto& v : out) {
+      v = T(float(dist(gen)) / 2.0f);
+    }
+    return out;
+  }
+
+  template <typename T>
+  rmm::device_uvector<T> to_device(const std::vector<T>& h)
+  {
+    rmm::device_uvector<T> d(h.size(), stream);
+    raft::update_device(d.data(), h.data(), h.size(), stream);
+    return d;
+  }
+
+  template <typename T, typename F>
+  auto matrix_view(T* ptr, int rows, int cols, bool row_major, F run)
+  {
+    if (row_major) {
+      return run(raft::make_device_matrix_view<T, int, raft::row_major>(ptr, rows, cols));
+    } else {
+      return run(raft::make_device_matrix_view<T, int, raft::col_major>(ptr, rows, cols));
+    }
+  }
+
+  void Run()
+  {
+    constexpr bool kFp8 = detail::is_fp8_v<InT>;
+    if constexpr (kFp8) {
+      int dev, major, minor;
+      RAFT_CUDA_TRY(cudaGetDevice(&dev));
+      RAFT_CUDA_TRY(cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, dev));
+      RAFT_CUDA_TRY(cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, dev));
+      // fp8 needs sm_89, the TN layout and dimensions aligned to 16 elements
+      bool aligned = params.m % 16 == 0 && params.n % 16 == 0 && params.k % 16 == 0;
+      if (major * 10 + minor < 89 || !params.x_row_major || params.y_row_major || !aligned) {
+        GTEST_SKIP();
+      }
+    }
+    using bias_t    = detail::matmul_bias_t<InT, OutT>;
+    const int m     = params.m, n = params.n, k = params.k;
+    const bool bias = detail::epilogue_has_bias(detail::get_cublaslt_epilogue(params.epilogue));
+    const bool relu = params.epilogue == Epilogue::RELU || params.epilogue == Epilogue::RELU_BIAS;
+    ASSERT_TRUE(params.epilogue != Epilogue::GELU && params.epilogue != Epilogue::GELU_BIAS);
+
+    std::mt19937 gen(params.seed);
+    auto x_h    = random<InT>(size_t(m) * k, gen);
+    auto y_h    = random<InT>(size_t(k) * n, gen);
+    auto z_h    = random<OutT>(size_t(m) * n, gen);
+    auto bias_h = random<bias_t>(params.z_row_major ? n : m, gen);
+    auto x      = to_device(x_h);
+    auto y      = to_device(y_h);
+    auto z      = to_device(z_h);
+    auto bias_d = to_device(bias_h);
+
+    auto at = [](const auto& v, int i, int j, int rows, int cols, bool row_major) {
+      return double(float(row_major ? v[size_t(i) * cols + j] : v[i + size_t(j) * rows]));
+    };
+    std::vector<OutT> expected(z_h.size());
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        double acc = 0;
+        for (int l = 0; l < k; l++) {
+          acc += at(x_h, i, l, m, k, params.x_row_major) * at(y_h, l, j, k, n, params.y_row_major);
+        }
+        acc = params.alpha * acc + params.beta * at(z_h, i, j, m, n, params.z_row_major);
+        if (bias) { acc += double(float(bias_h[params.z_row_major ? j : i])); }
+        if (relu) { acc = std::max(acc, 0.0); }
+        expected[params.z_row_major ? size_t(i) * n + j : i + size_t(j) * m] = OutT(float(acc));
+      }
+    }
+
+    std::optional<gemm_bias_view<InT, OutT, int>> bias_view = std::nullopt;
+    if (bias) {
+      bias_view = raft::make_device_vector_view<const bias_t, int>(bias_d.data(), bias_h.size());
+    }
+    matrix_view(x.data(), m, k, params.x_row_major, [&](auto x_view) {
+      return matrix_view(y.data(), k, n, params.y_row_major, [&](auto y_view) {
+        return matrix_view(z.data(), m, n, params.z_row_major, [&](auto z_view) {
+          using x_layout = typename decltype(x_view)::layout_type;
+          using y_layout = typename decltype(y_view)::layout_type;
+          constexpr bool kSupported =
+            !kFp8 || (std::is_same_v<x_layout, raft::row_major> &&
+                      std::is_same_v<y_layout, raft::col_major>);
+          if constexpr (kSupported) {
+            gemm(handle,
+                 raft::make_const_mdspan(x_view),
+                 raft::make_const_mdspan(y_view),
+                 z_view,
+                 params.epilogue,
+                 bias_view,
+                 params.alpha,
+                 params.beta);
+          }
+          return 0;
+        });
+      });
+    });
+
+    std::vector<OutT> actual(z_h.size());
+    raft::update_host(actual.data(), z.data(), z.size(), stream);
+    resource::sync_stream(handle, stream);
+    // the inputs are exact, only the rounding of the sums to the output type differs
+    const double tol = std::is_same_v<OutT, float> ? 1e-5 : 1e-2;
+    for (size_t i = 0; i < expected.size(); i++) {
+      double e = float(expected[i]), a = float(actual[i]);
+      ASSERT_NEAR(e, a, tol * std::max(1.0, std::abs(e))) << "at " << i;
+    }
+  }
+
+  raft::resources handle;
+  GemmMixedInputs params;
+  cudaStream_t stream;
+};
+
+const std::vector<GemmMixedInputs> inputs = {
+  {64, 32, 48, true, false, true, Epilogue::NONE, 1.0f, 0.0f, 1234ULL},
+  {64, 32, 48, true, false, false, Epilogue::NONE, 1.0f, 0.0f, 1234ULL},
+  {33, 17, 65, false, true, true, Epilogue::RELU, 2.0f, 0.0f, 1234ULL},
+  {33, 17, 65, false, false, false, Epilogue::BIAS, 1.0f, 1.0f, 1234ULL},
+  {128, 64, 32, true, false, true, Epilogue::RELU_BIAS, 0.5f, 0.0f, 1234ULL},
+  {128, 64, 32, true, false, false, Epilogue::RELU_BIAS, 1.0f, 0.5f, 1234ULL},
+  {16, 256, 128, true, true, true, Epilogue::BIAS, 1.0f, 0.0f, 1234ULL},
+  {256, 16, 16, false, true, false, Epilogue::NONE, 1.0f, 1.0f, 1234ULL}};
+
+using GemmMixedTestHF = GemmMixedTest<half, float>;
+TEST_P(GemmMixedTestHF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(GemmMixedTests, GemmMixedTestHF, ::testing::ValuesIn(inputs));
+
+using GemmMixedTestHH = GemmMixedTest<half, half>;
+TEST_P(GemmMixedTestHH, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(GemmMixedTests, GemmMixedTestHH, ::testing::ValuesIn(inputs));
+
+using GemmMixedTestBF = GemmMixedTest<nv_bfloat16, float>;
+TEST_P(GemmMixedTestBF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(GemmMixedTests, GemmMixedTestBF, ::testing::ValuesIn(inputs));
+
+using GemmMixedTestBB = GemmMixedTest<nv_bfloat16, nv_bfloat16>;
+TEST_P(GemmMixedTestBB, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(GemmMixedTests, GemmMixedTestBB, ::testing::ValuesIn(inputs));
+
+#if CUDART_VERSION >= 11080
+using GemmMixedTestF8F = GemmMixedTest<__nv_fp8_e4m3, float>;
+TEST_P(GemmMixedTestF8F, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(GemmMixedTests, GemmMixedTestF8F, ::testing::ValuesIn(inputs));
+#endif
+
+}  // end namespace linalg
+}  // end namespace raft
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/multi_reduce.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+struct MultiReduceInputs {
+  int rows;
+  int cols;
+  bool row_major;
+  bool along_rows;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const MultiReduceInputs& p)
+{
+  os << " rows: " << p.rows << ", cols: " << p.cols << ", row_major: " << p.row_major
+     << ", along_rows: " << p.along_rows;
+  return os;
+}
+
+/** The position of the element in the reduced dimension, kept for the last reduced element */
+struct last_index_op {
+  template <typename T>
+  HDI int operator()(T, int j) const
+  {
+    return j;
+  }
+};
+
+template <typename T>
+class MultiReduceTest : public ::testing::TestWithParam<MultiReduceInputs> {
+ public:
+  MultiReduceTest()
+    : params(::testing::TestWithParam<MultiReduceInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    const int rows = params.rows, cols = params.cols;
+    std::mt19937 gen(params.seed);
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    std::vector<T> data_h(size_t(rows) * cols);
+    for (auto& v : data_h) {
+      v = dist(gen);
+    }
+    rmm::device_uvector<T> data(data_h.size(), stream);
+    raft::update_device(data.data(), data_h.data(), data_h.size(), stream);
+
+    const int n_out = params.along_rows ? rows : cols;
+    const int len   = params.along_rows ? cols : rows;
+    rmm::device_uvector<T> sums(n_out, stream);
+    rmm::device_uvector<T> norms(n_out, stream);
+    rmm::device_uvector<T> mins(n_out, stream);
+    rmm::device_uvector<T> maxs(n_out, stream);
+    rmm::device_uvector<int> last(n_out, stream);
+    auto dots = std::make_tuple(raft::make_device_vector_view(sums.data(), n_out),
+                                raft::make_device_vector_view(norms.data(), n_out),
+                                raft::make_device_vector_view(mins.data(), n_out),
+                                raft::make_device_vector_view(maxs.data(), n_out),
+                                raft::make_device_vector_view(last.data(), n_out));
+    auto apply = params.along_rows ? Apply::ALONG_ROWS : Apply::ALONG_COLUMNS;
+    auto ops   = std::make_tuple(
+      make_reduction_op(T(0)),
+      make_reduction_op(T(0), raft::sq_op{}, raft::add_op{}, raft::sqrt_op{}),
+      make_reduction_op(std::numeric_limits<T>::max(), raft::identity_op{}, raft::min_op{}),
+      make_reduction_op(std::numeric_limits<T>::lowest(), raft::identity_op{}, raft::max_op{}),
+      make_reduction_op(-1, last_index_op{}, raft::max_op{}));
+    std::apply(
+      [&](auto... op) {
+        if (params.row_major) {
+          auto view = raft::make_device_matrix_view<const T, int, raft::row_major>(
+            data.data(), rows, cols);
+          multi_reduce(handle, view, dots, apply, op...);
+        } else {
+          auto view = raft::make_device_matrix_view<const T, int, raft::col_major>(
+            data.data(), rows, cols);
+          multi_reduce(handle, view, dots, apply, op...);
+        }
+      },
+      ops);
+
+    std::vector<T> sums_exp(n_out), norms_exp(n_out), mins_exp(n_out), maxs_exp(n_out);
+    std::vector<int> last_exp(n_out, len - 1);
+    for (int o = 0; o < n_out; o++) {
+      double sum = 0, sq = 0;
+      T mn = std::numeric_limits<T>::max(), mx = std::numeric_limits<T>::lowest();
+      for (int j = 0; j < len; j++) {
+        int r = params.along_rows ? o : j;
+        int c = params.along_rows ? j : o;
+        T v   = params.row_major ? data_h[size_t(r) * cols + c] : data_h[r + size_t(c) * rows];
+        sum += v;
+        sq += double(v) * v;
+        mn = std::min(mn, v);
+        mx = std::max(mx, v);
+      }
+      sums_exp[o]  = T(sum);
+      norms_exp[o] = T(std::sqrt(sq));
+      mins_exp[o]  = mn;
+      maxs_exp[o]  = mx;
+    }
+
+    const T tol = std::is_same_v<T, float> ? T(1e-4) : T(1e-10);
+    ASSERT_TRUE(devArrMatchHost(
+      sums_exp.data(), sums.data(), n_out, CompareApprox<T>(tol * len), stream));
+    ASSERT_TRUE(
+      devArrMatchHost(norms_exp.data(), norms.data(), n_out, CompareApprox<T>(tol), stream));
+    ASSERT_TRUE(devArrMatchHost(mins_exp.data(), mins.data(), n_out, Compare<T>(), stream));
+    ASSERT_TRUE(devArrMatchHost(maxs_exp.data(), maxs.data(), n_out, Compare<T>(), stream));
+    ASSERT_TRUE(devArrMatchHost(last_exp.data(), last.data(), n_out, Compare<int>(), stream));
+  }
+
+  raft::resources handle;
+  MultiReduceInputs params;
+  cudaStream_t stream;
+};
+
+// the thin and medium rows, and the skinny matrices whose columns are split in chunks of rows
+const std::vector<MultiReduceInputs> inputs = {{1, 1, true, true, 1234ULL},
+                                                {100, 7, true, true, 1234ULL},
+                                                {100, 7, true, false, 1234ULL},
+                                                {100, 7, false, true, 1234ULL},
+                                                {100, 7, false, false, 1234ULL},
+                                                {37, 2000, true, true, 1234ULL},
+                                                {37, 2000, false, false, 1234ULL},
+                                                {2000, 37, true, false, 1234ULL},
+                                                {2000, 37, false, true, 1234ULL},
+                                                {100000, 3, true, false, 1234ULL},
+                                                {100000, 3, false, true, 1234ULL},
+                                                {3, 100000, true, true, 1234ULL},
+                                                {300, 511, true, true, 1234ULL},
+                                                {300, 512, true, true, 1234ULL},
+                                                {1000, 1000, true, false, 1234ULL},
+                                                {1000, 1000, false, false, 1234ULL},
+                                                {0, 10, true, false, 1234ULL},
+                                                {10, 0, true, true, 1234ULL}};
+
+using MultiReduceTestF = MultiReduceTest<float>;
+TEST_P(MultiReduceTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(MultiReduceTests, MultiReduceTestF, ::testing::ValuesIn(inputs));
+
+using MultiReduceTestD = MultiReduceTest<double>;
+TEST_P(MultiReduceTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(MultiReduceTests, MultiReduceTestD, ::testing::ValuesIn(inputs));
+
+}  // end namespace linalg
+}  // end namespace raft
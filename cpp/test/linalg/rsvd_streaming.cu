@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/rsvd.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/cuda_stream_pool.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+struct RsvdStreamingInputs {
+  int64_t n_rows;
+  int64_t n_cols;
+  int rank;
+  int64_t k;
+  int64_t p;
+  int n_power_iters;
+  int64_t block_rows;
+  // the ratio of consecutive singular values of the input
+  double decay;
+  int n_streams;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const RsvdStreamingInputs& p)
+{
+  os << " n_rows: " << p.n_rows << ", n_cols: " << p.n_cols << ", rank: " << p.rank
+     << ", k: " << p.k << ", p: " << p.p << ", n_power_iters: " << p.n_power_iters
+     << ", block_rows: " << p.block_rows << ", decay: " << p.decay
+     << ", n_streams: " << p.n_streams;
+  return os;
+}
+
+template <typename T>
+class RsvdStreamingTest : public ::testing::TestWithParam<RsvdStreamingInputs> {
+ public:
+  RsvdStreamingTest()
+    : params(::testing::TestWithParam<RsvdStreamingInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+    if (params.n_streams > 0) {
+      resource::set_cuda_stream_pool(handle,
+                                     std::make_shared<rmm::cuda_stream_pool>(params.n_streams));
+    }
+  }
+
+ protected:
+  /** Column major (rows, rank) matrix with orthonormal columns */
+  std::vector<double> random_orthonormal(int64_t rows, std::mt19937& gen)
+  {
+    std::normal_distribution<double> dist;
+    std::vector<double> q(rows * params.rank);
+    for (auto& v : q) {
+      v = dist(gen);
+    }
+    for (int j = 0; j < params.rank; j++) {
+      double* qj = q.data() + j * rows;
+      for (int i = 0; i < j; i++) {
+        const double* qi = q.data() + i * rows;
+        double dot       = 0;
+        for (int64_t r = 0; r < rows; r++) {
+          dot += qi[r] * qj[r];
+        }
+        for (int64_t r = 0; r < rows; r++) {
+          qj[r] -= dot * qi[r];
+        }
+      }
+      double norm = 0;
+      for (int64_t r = 0; r < rows; r++) {
+        norm += qj[r] * qj[r];
+      }
+      for (int64_t r = 0; r < rows; r++) {
+        qj[r] /= std::sqrt(norm);
+      }
+    }
+    return q;
+  }
+
+  void Run()
+  {
+    const int64_t m = params.n_rows, n = params.n_cols, k = params.k;
+    std::mt19937 gen(params.seed);
+    auto u0 = random_orthonormal(m, gen);
+    auto v0 = random_orthonormal(n, gen);
+    std::vector<double> s0(params.rank);
+    for (int i = 0; i < params.rank; i++) {
+      s0[i] = 10.0 * std::pow(params.decay, i);
+    }
+    // A = U0 diag(S0) V0^T, row major
+    auto a = raft::make_host_matrix<T, int64_t>(m, n);
+    for (int64_t r = 0; r < m; r++) {
+      for (int64_t c = 0; c < n; c++) {
+        double acc = 0;
+        for (int i = 0; i < params.rank; i++) {
+          acc += u0[r + i * m] * s0[i] * v0[c + i * n];
+        }
+        a(r, c) = T(acc);
+      }
+    }
+
+    auto s_d = raft::make_device_vector<T, int64_t>(handle, k);
+    auto u   = raft::make_host_matrix<T, int64_t>(m, k);
+    auto v_d = raft::make_device_matrix<T, int64_t, raft::col_major>(handle, n, k);
+    raft::linalg::rsvd_streaming(handle,
+                                 raft::make_const_mdspan(a.view()),
+                                 s_d.view(),
+                                 params.p,
+                                 u.view(),
+                                 v_d.view(),
+                                 params.n_power_iters,
+                                 params.block_rows,
+                                 params.seed);
+    std::vector<T> s(k);
+    std::vector<T> v(n * k);
+    raft::update_host(s.data(), s_d.data_handle(), k, stream);
+    raft::update_host(v.data(), v_d.data_handle(), n * k, stream);
+    resource::sync_stream(handle, stream);
+
+    const double tol = std::is_same_v<T, float> ? 1e-3 : 1e-8;
+    for (int64_t i = 0; i < k; i++) {
+      ASSERT_NEAR(s[i], s0[i], tol * s0[0]) << "singular value " << i;
+    }
+    // U and V have orthonormal columns, and A v_i = s_i u_i
+    for (int64_t i = 0; i < k; i++) {
+      for (int64_t j = 0; j <= i; j++) {
+        double uu = 0, vv = 0;
+        for (int64_t r = 0; r < m; r++) {
+          uu += double(u(r, i)) * u(r, j);
+        }
+        for (int64_t c = 0; c < n; c++) {
+          vv += double(v[c + i * n]) * v[c + j * n];
+        }
+        ASSERT_NEAR(uu, double(i == j), 10 * tol) << "columns " << i << ", " << j << " of U";
+        ASSERT_NEAR(vv, double(i == j), 10 * tol) << "columns " << i << ", " << j << " of V";
+      }
+      for (int64_t r = 0; r < m; r++) {
+        double av = 0;
+        for (int64_t c = 0; c < n; c++) {
+          av += double(a(r, c)) * v[c + i * n];
+        }
+        ASSERT_NEAR(av, double(s[i]) * u(r, i), 10 * tol * s0[0]) << "row " << r << " of U";
+      }
+    }
+  }
+
+  raft::resources handle;
+  RsvdStreamingInputs params;
+  cudaStream_t stream;
+};
+
+// the blocks do not divide the rows evenly, and the ranks above k + p are only partly captured
+const std::vector<RsvdStreamingInputs> inputs = {
+  {2000, 64, 8, 8, 4, 0, 300, 0.5, 0, 1234ULL},
+  {2000, 64, 8, 8, 4, 2, 300, 0.5, 1, 1235ULL},
+  {1000, 100, 100, 10, 10, 2, 128, 0.7, 0, 1236ULL},
+  {1000, 100, 100, 10, 10, 2, 128, 0.7, 2, 1237ULL},
+  {517, 33, 20, 5, 5, 3, 1000, 0.6, 0, 1238ULL},
+  {4096, 256, 32, 16, 16, 1, 4096, 0.8, 1, 1239ULL}};
+
+using RsvdStreamingTestF = RsvdStreamingTest<float>;
+TEST_P(RsvdStreamingTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(RsvdStreamingTests, RsvdStreamingTestF, ::testing::ValuesIn(inputs));
+
+using RsvdStreamingTestD = RsvdStreamingTest<double>;
+TEST_P(RsvdStreamingTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(RsvdStreamingTests, RsvdStreamingTestD, ::testing::ValuesIn(inputs));
+
+}  // end namespace linalg
+}  // end namespace raft
@@ -18,6 +18,7 @@
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/linalg/transpose.cuh>
 #include <raft/util/cuda_utils.cuh>
@@ -29,6 +30,7 @@
 
 #include <gtest/gtest.h>
 
+#include <optional>
 #include <type_traits>
 
 namespace std {
@@ -384,6 +386,70 @@ TEST(TransposeTest, MDSpanHalf)
   }
 }
 
+template <typename T, typename LayoutPolicy>
+void test_transpose_inplace(const TransposeMdspanInputs<T>& param,
+                            std::optional<size_t> workspace_limit = std::nullopt)
+{
+  auto len = param.n_row * param.n_col;
+  std::vector<T> in_h(len);
+  std::vector<T> out_ref_h(len);
+
+  initialize_array(in_h.data(), len);
+
+  raft::resources handle;
+  if (workspace_limit.has_value()) {
+    resource::set_workspace_to_global_resource(handle, workspace_limit);
+  }
+  auto stream = resource::get_cuda_stream(handle);
+  auto inout  = make_device_matrix<T, size_t, LayoutPolicy>(handle, param.n_row, param.n_col);
+  if constexpr (std::is_same_v<LayoutPolicy, layout_c_contiguous>) {
+    cpu_transpose_row_major(in_h.data(), out_ref_h.data(), param.n_row, param.n_col);
+  } else {
+    cpu_transpose_col_major(in_h.data(), out_ref_h.data(), param.n_row, param.n_col);
+  }
+  raft::copy(inout.data_handle(), in_h.data(), len, stream);
+
+  auto out = transpose_inplace(handle, inout.view());
+  static_assert(std::is_same_v<LayoutPolicy, typename decltype(out)::layout_type>);
+  ASSERT_EQ(out.data_handle(), inout.data_handle());
+  ASSERT_EQ(out.extent(0), inout.extent(1));
+  ASSERT_EQ(out.extent(1), inout.extent(0));
+  std::vector<T> out_h(len);
+  raft::copy(out_h.data(), out.data_handle(), len, stream);
+  resource::sync_stream(handle, stream);
+  // elements are only moved, the result is exact
+  for (int i = 0; i < len; i++) {
+    ASSERT_EQ(float(out_ref_h[i]), float(out_h[i])) << "at " << i;
+  }
+}
+
+TEST(TransposeTest, InplaceFloat)
+{
+  for (const auto& p : inputs_mdspan_f) {
+    test_transpose_inplace<float, layout_c_contiguous>(p);
+    test_transpose_inplace<float, layout_f_contiguous>(p);
+  }
+  // a small workspace forces batches of a few rows and columns
+  for (const auto& p : std::vector<TransposeMdspanInputs<float>>{{12, 18}, {1000, 3333}}) {
+    test_transpose_inplace<float, layout_c_contiguous>(p, 64 * 1024);
+    test_transpose_inplace<float, layout_f_contiguous>(p, 64 * 1024);
+  }
+}
+TEST(TransposeTest, InplaceDouble)
+{
+  for (const auto& p : inputs_mdspan_d) {
+    test_transpose_inplace<double, layout_c_contiguous>(p);
+    test_transpose_inplace<double, layout_f_contiguous>(p);
+  }
+}
+TEST(TransposeTest, InplaceHalf)
+{
+  for (const auto& p : inputs_mdspan_h) {
+    test_transpose_inplace<half, layout_c_contiguous>(p);
+    test_transpose_inplace<half, layout_f_contiguous>(p);
+  }
+}
+
 template <typename T>
 struct TransposeSubmatrixInputs {
   int n_row;
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/error.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace raft {
+
+/**
+ * A communicator of a single rank, without NCCL: the collectives copy their input to their output.
+ * It runs the distributed algorithms in a single process, where they must match the single-GPU
+ * ones.
+ */
+class loopback_comms : public comms::comms_iface {
+ public:
+  int get_size() const override { return 1; }
+  int get_rank() const override { return 0; }
+  std::unique_ptr<comms::comms_iface> comm_split(int, int) const override
+  {
+    return std::make_unique<loopback_comms>();
+  }
+  void barrier() const override {}
+  comms::status_t sync_stream(cudaStream_t stream) const override
+  {
+    return cudaStreamSynchronize(stream) == cudaSuccess ? comms::status_t::SUCCESS
+                                                        : comms::status_t::ERROR;
+  }
+  void isend(const void*, size_t, int, int, comms::request_t*) const override
+  {
+    RAFT_FAIL("isend is not supported by loopback_comms");
+  }
+  void irecv(void*, size_t, int, int, comms::request_t*) const override
+  {
+    RAFT_FAIL("irecv is not supported by loopback_comms");
+  }
+  void device_isend(const void*, size_t, int, int, comms::request_t*, cudaStream_t) const override
+  {
+    RAFT_FAIL("device_isend is not supported by loopback_comms");
+  }
+  void device_irecv(void*, size_t, int, int, comms::request_t*, cudaStream_t) const override
+  {
+    RAFT_FAIL("device_irecv is not supported by loopback_comms");
+  }
+  void waitall(int, comms::request_t[]) const override {}
+  void allreduce(const void* sendbuff,
+                 void* recvbuff,
+                 size_t count,
+                 comms::datatype_t datatype,
+                 comms::op_t,
+                 cudaStream_t stream) const override
+  {
+    copy(sendbuff, recvbuff, count, datatype, stream);
+  }
+  void bcast(void*, size_t, comms::datatype_t, int, cudaStream_t) const override {}
+  void bcast(const void* sendbuff,
+             void* recvbuff,
+             size_t count,
+             comms::datatype_t datatype,
+             int,
+             cudaStream_t stream) const override
+  {
+    copy(sendbuff, recvbuff, count, datatype, stream);
+  }
+  void reduce(const void* sendbuff,
+              void* recvbuff,
+              size_t count,
+              comms::datatype_t datatype,
+              comms::op_t,
+              int,
+              cudaStream_t stream) const override
+  {
+    copy(sendbuff, recvbuff, count, datatype, stream);
+  }
+  void allgather(const void* sendbuff,
+                 void* recvbuff,
+                 size_t sendcount,
+                 comms::datatype_t datatype,
+                 cudaStream_t stream) const override
+  {
+    copy(sendbuff, recvbuff, sendcount, datatype, stream);
+  }
+  void allgatherv(const void* sendbuf,
+                  void* recvbuf,
+                  const size_t* recvcounts,
+                  const size_t* displs,
+                  comms::datatype_t datatype,
+                  cudaStream_t stream) const override
+  {
+    copy(sendbuf, offset(recvbuf, displs[0], datatype), recvcounts[0], datatype, stream);
+  }
+  void gather(const void* sendbuff,
+              void* recvbuff,
+              size_t sendcount,
+              comms::datatype_t datatype,
+              int,
+              cudaStream_t stream) const override
+  {
+    copy(sendbuff, recvbuff, sendcount, datatype, stream);
+  }
+  void gatherv(const void* sendbuf,
+               void* recvbuf,
+               size_t sendcount,
+               const size_t*,
+               const size_t* displs,
+               comms::datatype_t datatype,
+               int,
+               cudaStream_t stream) const override
+  {
+    copy(sendbuf, offset(recvbuf, displs[0], datatype), sendcount, datatype, stream);
+  }
+  void reducescatter(const void* sendbuff,
+                     void* recvbuff,
+                     size_t recvcount,
+                     comms::datatype_t datatype,
+                     comms::op_t,
+                     cudaStream_t stream) const override
+  {
+    copy(sendbuff, recvbuff, recvcount, datatype, stream);
+  }
+  void alltoall(const void* sendbuff,
+                void* recvbuff,
+                size_t count,
+                comms::datatype_t datatype,
+                cudaStream_t stream) const override
+  {
+    copy(sendbuff, recvbuff, count, datatype, stream);
+  }
+  void alltoallv(const void* sendbuf,
+                 const size_t* sendcounts,
+                 const size_t* sdispls,
+                 void* recvbuf,
+                 const size_t*,
+                 const size_t* rdispls,
+                 comms::datatype_t datatype,
+                 cudaStream_t stream) const override
+  {
+    copy(offset(sendbuf, sdispls[0], datatype),
+         offset(recvbuf, rdispls[0], datatype),
+         sendcounts[0],
+         datatype,
+         stream);
+  }
+  void device_send(const void*, size_t, int, cudaStream_t) const override
+  {
+    RAFT_FAIL("device_send is not supported by loopback_comms");
+  }
+  void device_recv(void*, size_t, int, cudaStream_t) const override
+  {
+    RAFT_FAIL("device_recv is not supported by loopback_comms");
+  }
+  void device_sendrecv(const void* sendbuf,
+                       size_t sendsize,
+                       int,
+                       void* recvbuf,
+                       size_t,
+                       int,
+                       cudaStream_t stream) const override
+  {
+    copy(sendbuf, recvbuf, sendsize, comms::datatype_t::CHAR, stream);
+  }
+  void device_multicast_sendrecv(const void*,
+                                 std::vector<size_t> const&,
+                                 std::vector<size_t> const&,
+                                 std::vector<int> const&,
+                                 void*,
+                                 std::vector<size_t> const&,
+                                 std::vector<size_t> const&,
+                                 std::vector<int> const&,
+                                 cudaStream_t) const override
+  {
+    RAFT_FAIL("device_multicast_sendrecv is not supported by loopback_comms");
+  }
+  void group_start() const override {}
+  void group_end() const override {}
+
+ private:
+  static size_t type_size(comms::datatype_t datatype)
+  {
+    switch (datatype) {
+      case comms::datatype_t::CHAR: return sizeof(char);
+      case comms::datatype_t::UINT8: return sizeof(uint8_t);
+      case comms::datatype_t::INT32: return sizeof(int);
+      case comms::datatype_t::UINT32: return sizeof(unsigned int);
+      case comms::datatype_t::INT64: return sizeof(int64_t);
+      case comms::datatype_t::UINT64: return sizeof(uint64_t);
+      case comms::datatype_t::FLOAT32: return sizeof(float);
+      case comms::datatype_t::FLOAT64: return sizeof(double);
+      default: RAFT_FAIL("Unsupported datatype.");
+    }
+  }
+  static void* offset(void* ptr, size_t count, comms::datatype_t datatype)
+  {
+    return static_cast<char*>(ptr) + count * type_size(datatype);
+  }
+  static const void* offset(const void* ptr, size_t count, comms::datatype_t datatype)
+  {
+    return static_cast<const char*>(ptr) + count * type_size(datatype);
+  }
+  static void copy(
+    const void* src, void* dst, size_t count, comms::datatype_t datatype, cudaStream_t stream)
+  {
+    if (src == dst || count == 0) { return; }
+    RAFT_CUDA_TRY(
+      cudaMemcpyAsync(dst, src, count * type_size(datatype), cudaMemcpyDefault, stream));
+  }
+};
+
+}  // namespace raft
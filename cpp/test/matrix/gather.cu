@@ -29,6 +29,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 namespace raft {
 
 template <bool Conditional,
@@ -84,7 +86,9 @@ template <bool Conditional,
           bool Inplace,
           typename MatrixT,
           typename MapT,
-          typename IdxT>
+          typename IdxT,
+          bool HostInput = false,
+          bool SortedMap = false>
 class GatherTest : public ::testing::TestWithParam<GatherInputs<IdxT>> {
  protected:
   GatherTest()
@@ -119,6 +123,11 @@ class GatherTest : public ::testing::TestWithParam<GatherInputs<IdxT>> {
     h_map.resize(map_length);
     raft::random::uniformInt(handle, r_int, d_map.data(), map_length, (MapT)0, (MapT)params.nrows);
     raft::update_host(h_map.data(), d_map.data(), map_length, stream);
+    if (SortedMap) {
+      resource::sync_stream(handle, stream);
+      std::sort(h_map.begin(), h_map.end());
+      raft::update_device(d_map.data(), h_map.data(), map_length, stream);
+    }
 
     // stencil setup
     if (Conditional) {
@@ -173,6 +182,10 @@ class GatherTest : public ::testing::TestWithParam<GatherInputs<IdxT>> {
       raft::matrix::gather(handle, in_view, map_view, out_view, transform_op);
     } else if (Inplace) {
       raft::matrix::gather(handle, inout_view, map_view, params.col_batch_size);
+    } else if (HostInput) {
+      auto h_in_view = raft::make_host_matrix_view<const MatrixT, IdxT, row_major>(
+        h_in.data(), params.nrows, params.ncols);
+      raft::matrix::gather(handle, h_in_view, map_view, out_view);
     } else {
       raft::matrix::gather(handle, in_view, map_view, out_view);
     }
@@ -246,4 +259,13 @@ GATHER_TEST((GatherTest<false, false, true, float, uint32_t, int64_t>),
 GATHER_TEST((GatherTest<false, false, true, float, int64_t, int64_t>),
             GatherInplaceTestFI64I64,
             inplace_inputs_i64);
+GATHER_TEST((GatherTest<false, false, false, float, int64_t, int64_t, true>),
+            GatherHostTestFI64I64,
+            inputs_i64);
+GATHER_TEST((GatherTest<false, false, false, float, int64_t, int64_t, true, true>),
+            GatherHostSortedTestFI64I64,
+            inputs_i64);
+GATHER_TEST((GatherTest<false, false, false, double, int, int, true>),
+            GatherHostTestDI32I32,
+            inputs_i32);
 }  // end namespace raft
\ No newline at end of file
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/pinned_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/gather.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cuda_fp16.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace matrix {
+
+struct GatherTransformInputs {
+  int n_rows;
+  int n_cols;
+  int map_length;
+  bool pinned;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const GatherTransformInputs& p)
+{
+  os << " n_rows: " << p.n_rows << ", n_cols: " << p.n_cols << ", map_length: " << p.map_length
+     << ", pinned: " << p.pinned;
+  return os;
+}
+
+// L2-normalize the row, then subtract a per-column offset
+struct normalize_center_op {
+  const float* offsets;
+  __device__ float operator()(float x, float norm, int j) const
+  {
+    return (norm > 1e-8f ? x / norm : x) - offsets[j];
+  }
+};
+
+template <typename OutT>
+class GatherTransformTest : public ::testing::TestWithParam<GatherTransformInputs> {
+ public:
+  GatherTransformTest()
+    : params(::testing::TestWithParam<GatherTransformInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    const int n_rows = params.n_rows, n_cols = params.n_cols, map_length = params.map_length;
+    std::mt19937 gen(params.seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> idx_dist(0, n_rows - 1);
+    std::vector<float> in_h(size_t(n_rows) * n_cols), offsets_h(n_cols);
+    std::vector<int> map_h(map_length);
+    for (auto& v : in_h) {
+      v = dist(gen);
+    }
+    for (auto& v : offsets_h) {
+      v = dist(gen);
+    }
+    for (auto& v : map_h) {
+      v = idx_dist(gen);
+    }
+    // a zero row, left unnormalized
+    if (n_rows > 1) { std::fill(in_h.begin(), in_h.begin() + n_cols, 0.0f); }
+
+    rmm::device_uvector<float> in(in_h.size(), stream);
+    rmm::device_uvector<float> offsets(n_cols, stream);
+    rmm::device_uvector<int> map(map_length, stream);
+    rmm::device_uvector<OutT> out(size_t(map_length) * n_cols, stream);
+    raft::update_device(in.data(), in_h.data(), in_h.size(), stream);
+    raft::update_device(offsets.data(), offsets_h.data(), n_cols, stream);
+    raft::update_device(map.data(), map_h.data(), map_length, stream);
+
+    auto map_view = raft::make_device_vector_view<const int, int>(map.data(), map_length);
+    auto out_view =
+      raft::make_device_matrix_view<OutT, int, row_major>(out.data(), map_length, n_cols);
+    normalize_center_op elem_op{offsets.data()};
+    if (params.pinned) {
+      auto in_pinned = raft::make_pinned_matrix<float, int, row_major>(handle, n_rows, n_cols);
+      std::copy(in_h.begin(), in_h.end(), in_pinned.data_handle());
+      gather_transform(handle,
+                       raft::make_const_mdspan(in_pinned.view()),
+                       map_view,
+                       out_view,
+                       0.0f,
+                       raft::sq_op(),
+                       raft::add_op(),
+                       raft::sqrt_op(),
+                       elem_op);
+      resource::sync_stream(handle, stream);
+    } else {
+      gather_transform(
+        handle,
+        raft::make_device_matrix_view<const float, int, row_major>(in.data(), n_rows, n_cols),
+        map_view,
+        out_view,
+        0.0f,
+        raft::sq_op(),
+        raft::add_op(),
+        raft::sqrt_op(),
+        elem_op);
+    }
+
+    std::vector<OutT> out_h(out.size());
+    raft::update_host(out_h.data(), out.data(), out.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    const double tol = std::is_same_v<OutT, float> ? 1e-5 : 4e-3;
+    for (int i = 0; i < map_length; i++) {
+      const float* row = in_h.data() + size_t(map_h[i]) * n_cols;
+      double norm      = 0;
+      for (int j = 0; j < n_cols; j++) {
+        norm += double(row[j]) * row[j];
+      }
+      norm = std::sqrt(norm);
+      for (int j = 0; j < n_cols; j++) {
+        double expected = (norm > 1e-8 ? row[j] / norm : row[j]) - offsets_h[j];
+        ASSERT_NEAR(expected, double(float(out_h[size_t(i) * n_cols + j])), tol)
+          << "row " << i << ", col " << j;
+      }
+    }
+  }
+
+  raft::resources handle;
+  GatherTransformInputs params;
+  cudaStream_t stream;
+};
+
+const std::vector<GatherTransformInputs> inputs = {{1, 1, 1, false, 1234ULL},
+                                                   {100, 2, 50, false, 1234ULL},
+                                                   {100, 7, 300, false, 1234ULL},
+                                                   {1000, 16, 256, true, 1234ULL},
+                                                   {1000, 96, 1000, false, 1234ULL},
+                                                   {1000, 96, 1000, true, 1234ULL},
+                                                   {500, 1000, 77, false, 1234ULL},
+                                                   {200, 3000, 33, true, 1234ULL}};
+
+using GatherTransformTestF = GatherTransformTest<float>;
+TEST_P(GatherTransformTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(GatherTransformTests, GatherTransformTestF, ::testing::ValuesIn(inputs));
+
+using GatherTransformTestH = GatherTransformTest<half>;
+TEST_P(GatherTransformTestH, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(GatherTransformTests, GatherTransformTestH, ::testing::ValuesIn(inputs));
+
+}  // end namespace matrix
+}  // end namespace raft
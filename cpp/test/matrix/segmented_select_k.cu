@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/segmented_select_k.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace raft::matrix {
+
+struct SegmentedSelectKInputs {
+  int n_segments;
+  int max_len;
+  int k;
+  bool select_min;
+  SelectAlgo algo;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const SegmentedSelectKInputs& p)
+{
+  os << "{n_segments: " << p.n_segments << ", max_len: " << p.max_len << ", k: " << p.k
+     << ", select_min: " << p.select_min << ", algo: " << p.algo << "}";
+  return os;
+}
+
+template <typename T, typename IdxT>
+class SegmentedSelectKTest : public ::testing::TestWithParam<SegmentedSelectKInputs> {
+ public:
+  SegmentedSelectKTest()
+    : stream(resource::get_cuda_stream(handle)),
+      params(::testing::TestWithParam<SegmentedSelectKInputs>::GetParam())
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    // The lengths span several buckets, including the empty segments and the ones shorter than k.
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> log_len(0, 20);
+    std::uniform_real_distribution<T> value(-1000, 1000);
+    std::vector<IdxT> offsets_h(params.n_segments + 1, 0);
+    for (int i = 0; i < params.n_segments; i++) {
+      offsets_h[i + 1] = offsets_h[i] + std::min(params.max_len, (1 << log_len(gen)) - 1);
+    }
+    std::vector<T> in_h(offsets_h.back());
+    for (auto& v : in_h) {
+      v = value(gen);
+    }
+    std::vector<IdxT> ids_h(in_h.size());
+    for (size_t i = 0; i < ids_h.size(); i++) {
+      ids_h[i] = IdxT(ids_h.size() - i);
+    }
+
+    auto in_d      = make_device_vector<T, int64_t>(handle, in_h.size());
+    auto ids_d     = make_device_vector<IdxT, int64_t>(handle, ids_h.size());
+    auto offsets_d = make_device_vector<IdxT, int64_t>(handle, offsets_h.size());
+    raft::update_device(in_d.data_handle(), in_h.data(), in_h.size(), stream);
+    raft::update_device(ids_d.data_handle(), ids_h.data(), ids_h.size(), stream);
+    raft::update_device(offsets_d.data_handle(), offsets_h.data(), offsets_h.size(), stream);
+
+    auto out_val = make_device_matrix<T, int64_t>(handle, params.n_segments, params.k);
+    auto out_idx = make_device_matrix<IdxT, int64_t>(handle, params.n_segments, params.k);
+    for (bool custom_ids : {false, true}) {
+      segmented_select_k<T, IdxT>(
+        handle,
+        raft::make_const_mdspan(in_d.view()),
+        custom_ids ? std::make_optional(raft::make_const_mdspan(ids_d.view())) : std::nullopt,
+        raft::make_const_mdspan(offsets_d.view()),
+        out_val.view(),
+        out_idx.view(),
+        params.select_min,
+        true,
+        params.algo);
+
+      std::vector<T> out_val_h(out_val.size());
+      std::vector<IdxT> out_idx_h(out_idx.size());
+      raft::update_host(out_val_h.data(), out_val.data_handle(), out_val.size(), stream);
+      raft::update_host(out_idx_h.data(), out_idx.data_handle(), out_idx.size(), stream);
+      resource::sync_stream(handle, stream);
+
+      for (int i = 0; i < params.n_segments; i++) {
+        const IdxT begin = offsets_h[i];
+        const IdxT len   = offsets_h[i + 1] - begin;
+        std::vector<T> ref(in_h.begin() + begin, in_h.begin() + begin + len);
+        if (params.select_min) {
+          std::sort(ref.begin(), ref.end());
+        } else {
+          std::sort(ref.begin(), ref.end(), std::greater<T>());
+        }
+        for (int j = 0; j < std::min<int>(len, params.k); j++) {
+          const T val   = out_val_h[size_t(i) * params.k + j];
+          const IdxT id = out_idx_h[size_t(i) * params.k + j];
+          ASSERT_EQ(val, ref[j]) << "segment " << i << ", position " << j;
+          // The payload must point to the selected value
+          const IdxT pos = custom_ids ? IdxT(ids_h.size()) - id - begin : id;
+          ASSERT_TRUE(pos >= 0 && pos < len) << "segment " << i << ", position " << j;
+          ASSERT_EQ(in_h[begin + pos], val) << "segment " << i << ", position " << j;
+        }
+      }
+    }
+  }
+
+  raft::resources handle;
+  cudaStream_t stream;
+  SegmentedSelectKInputs params;
+};
+
+const std::vector<SegmentedSelectKInputs> inputs = {
+  {100, 1 << 20, 10, true, SelectAlgo::kAuto},
+  {100, 1 << 20, 10, false, SelectAlgo::kAuto},
+  {300, 5000, 32, true, SelectAlgo::kAuto},
+  {50, 1 << 20, 300, true, SelectAlgo::kAuto},
+  {50, 1 << 20, 300, false, SelectAlgo::kAuto},
+  {200, 1 << 16, 64, true, SelectAlgo::kRadix11bits},
+  {200, 1 << 16, 64, false, SelectAlgo::kWarpImmediate},
+  {200, 1 << 16, 64, true, SelectAlgo::kWarpDistributedShm},
+  {200, 1000, 16, true, SelectAlgo::kAuto},
+};
+
+using SegmentedSelectKTestF = SegmentedSelectKTest<float, int64_t>;
+TEST_P(SegmentedSelectKTestF, Result) { Run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(SegmentedSelectKTest,     // NOLINT
+                        SegmentedSelectKTestF,
+                        ::testing::ValuesIn(inputs));
+
+TEST(SegmentedSelectK, AllEmptySegments)  // NOLINT
+{
+  raft::resources handle;
+  auto stream              = resource::get_cuda_stream(handle);
+  constexpr int n_segments = 5;
+  constexpr int k          = 7;
+  constexpr int64_t kNoIdx = std::numeric_limits<int64_t>::max();
+  std::vector<int64_t> offsets_h(n_segments + 1, 0);
+  auto in_d      = make_device_vector<float, int64_t>(handle, 0);
+  auto offsets_d = make_device_vector<int64_t, int64_t>(handle, offsets_h.size());
+  raft::update_device(offsets_d.data_handle(), offsets_h.data(), offsets_h.size(), stream);
+
+  for (bool select_min : {true, false}) {
+    // Start from garbage, to make sure every output is written.
+    std::vector<float> out_val_h(n_segments * k, 42.0f);
+    std::vector<int64_t> out_idx_h(n_segments * k, 42);
+    auto out_val = make_device_matrix<float, int64_t>(handle, n_segments, k);
+    auto out_idx = make_device_matrix<int64_t, int64_t>(handle, n_segments, k);
+    raft::update_device(out_val.data_handle(), out_val_h.data(), out_val_h.size(), stream);
+    raft::update_device(out_idx.data_handle(), out_idx_h.data(), out_idx_h.size(), stream);
+
+    segmented_select_k<float, int64_t>(handle,
+                                       raft::make_const_mdspan(in_d.view()),
+                                       std::nullopt,
+                                       raft::make_const_mdspan(offsets_d.view()),
+                                       out_val.view(),
+                                       out_idx.view(),
+                                       select_min);
+
+    raft::update_host(out_val_h.data(), out_val.data_handle(), out_val.size(), stream);
+    raft::update_host(out_idx_h.data(), out_idx.data_handle(), out_idx.size(), stream);
+    resource::sync_stream(handle, stream);
+    const float bound = select_min ? upper_bound<float>() : lower_bound<float>();
+    for (size_t i = 0; i < out_val_h.size(); i++) {
+      ASSERT_EQ(out_val_h[i], bound) << "position " << i;
+      ASSERT_EQ(out_idx_h[i], kNoIdx) << "position " << i;
+    }
+  }
+}
+
+}  // namespace raft::matrix
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/segmented_sort.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace raft::matrix {
+
+struct SegmentedSortInputs {
+  int64_t n_rows;
+  int64_t n_cols;
+  bool ascending;
+  bool with_values;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const SegmentedSortInputs& p)
+{
+  os << " n_rows: " << p.n_rows << ", n_cols: " << p.n_cols << ", ascending: " << p.ascending
+     << ", with_values: " << p.with_values;
+  return os;
+}
+
+// sort the [begin, end) range of the pairs with std::stable_sort
+template <typename KeyT, typename ValT>
+void stable_sort_ref(std::vector<KeyT>& keys,
+                     std::vector<ValT>& vals,
+                     int64_t begin,
+                     int64_t end,
+                     bool ascending)
+{
+  std::vector<int64_t> order(end - begin);
+  std::iota(order.begin(), order.end(), begin);
+  std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return ascending ? keys[a] < keys[b] : keys[a] > keys[b];
+  });
+  std::vector<KeyT> k(order.size());
+  std::vector<ValT> v(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    k[i] = keys[order[i]];
+    v[i] = vals[order[i]];
+  }
+  std::copy(k.begin(), k.end(), keys.begin() + begin);
+  std::copy(v.begin(), v.end(), vals.begin() + begin);
+}
+
+template <typename KeyT, typename ValT>
+class SegmentedSortTest : public ::testing::TestWithParam<SegmentedSortInputs> {
+ public:
+  SegmentedSortTest()
+    : params(::testing::TestWithParam<SegmentedSortInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    const int64_t n_rows = params.n_rows, n_cols = params.n_cols;
+    const size_t len     = n_rows * n_cols;
+    std::mt19937 gen(params.seed);
+    // few distinct keys, to check that the sort is stable
+    std::uniform_int_distribution<int> dist(-50, 50);
+    std::vector<KeyT> keys_h(len);
+    std::vector<ValT> vals_h(len);
+    for (size_t i = 0; i < len; i++) {
+      keys_h[i] = KeyT(dist(gen)) / KeyT(4);
+      vals_h[i] = params.with_values ? ValT(i * 7 % 1000003) : ValT(i % n_cols);
+    }
+
+    rmm::device_uvector<KeyT> in_keys(len, stream), out_keys(len, stream);
+    rmm::device_uvector<ValT> in_vals(len, stream), out_vals(len, stream);
+    raft::update_device(in_keys.data(), keys_h.data(), len, stream);
+    raft::update_device(in_vals.data(), vals_h.data(), len, stream);
+
+    auto in_vals_view = std::make_optional(
+      raft::make_device_matrix_view<const ValT, int64_t>(in_vals.data(), n_rows, n_cols));
+    if (!params.with_values) { in_vals_view = std::nullopt; }
+    segmented_sort<KeyT, ValT>(
+      handle,
+      raft::make_device_matrix_view<const KeyT, int64_t>(in_keys.data(), n_rows, n_cols),
+      in_vals_view,
+      raft::make_device_matrix_view<KeyT, int64_t>(out_keys.data(), n_rows, n_cols),
+      raft::make_device_matrix_view<ValT, int64_t>(out_vals.data(), n_rows, n_cols),
+      params.ascending);
+
+    for (int64_t r = 0; r < n_rows; r++) {
+      stable_sort_ref(keys_h, vals_h, r * n_cols, (r + 1) * n_cols, params.ascending);
+    }
+    std::vector<KeyT> out_keys_h(len);
+    std::vector<ValT> out_vals_h(len);
+    raft::update_host(out_keys_h.data(), out_keys.data(), len, stream);
+    raft::update_host(out_vals_h.data(), out_vals.data(), len, stream);
+    resource::sync_stream(handle, stream);
+    for (size_t i = 0; i < len; i++) {
+      ASSERT_EQ(keys_h[i], out_keys_h[i]) << "at " << i;
+      ASSERT_EQ(vals_h[i], out_vals_h[i]) << "at " << i;
+    }
+  }
+
+  raft::resources handle;
+  SegmentedSortInputs params;
+  cudaStream_t stream;
+};
+
+// row lengths covering the warp, block and device-wide sorts
+const std::vector<SegmentedSortInputs> inputs = {{1, 1, true, false, 1234ULL},
+                                                 {100, 7, true, true, 1234ULL},
+                                                 {100, 32, false, false, 1234ULL},
+                                                 {33, 100, true, true, 1234ULL},
+                                                 {33, 256, false, true, 1234ULL},
+                                                 {20, 257, true, false, 1234ULL},
+                                                 {20, 1000, false, true, 1234ULL},
+                                                 {10, 2048, true, true, 1234ULL},
+                                                 {10, 4000, false, false, 1234ULL},
+                                                 {5, 5000, true, true, 1234ULL},
+                                                 {3, 100000, false, true, 1234ULL}};
+
+using SegmentedSortTestF = SegmentedSortTest<float, int64_t>;
+TEST_P(SegmentedSortTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SegmentedSortTests, SegmentedSortTestF, ::testing::ValuesIn(inputs));
+
+using SegmentedSortTestD = SegmentedSortTest<double, int>;
+TEST_P(SegmentedSortTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SegmentedSortTests, SegmentedSortTestD, ::testing::ValuesIn(inputs));
+
+TEST(SegmentedSortCsrTest, Result)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  std::mt19937 gen(1234ULL);
+  std::uniform_int_distribution<int> len_dist(0, 3000);
+  std::uniform_int_distribution<int> key_dist(-100, 100);
+  std::vector<int> offsets_h{0};
+  for (int i = 0; i < 50; i++) {
+    offsets_h.push_back(offsets_h.back() + len_dist(gen));
+  }
+  const int64_t n_items = offsets_h.back();
+  std::vector<float> keys_h(n_items);
+  std::vector<int> vals_h(n_items);
+  for (int64_t i = 0; i < n_items; i++) {
+    keys_h[i] = float(key_dist(gen));
+    vals_h[i] = int(i);
+  }
+
+  rmm::device_uvector<float> in_keys(n_items, stream), out_keys(n_items, stream);
+  rmm::device_uvector<int> in_vals(n_items, stream), out_vals(n_items, stream);
+  rmm::device_uvector<int> offsets(offsets_h.size(), stream);
+  raft::update_device(in_keys.data(), keys_h.data(), n_items, stream);
+  raft::update_device(in_vals.data(), vals_h.data(), n_items, stream);
+  raft::update_device(offsets.data(), offsets_h.data(), offsets_h.size(), stream);
+
+  segmented_sort<float, int, int>(
+    handle,
+    raft::make_device_vector_view<const float, int64_t>(in_keys.data(), n_items),
+    raft::make_device_vector_view<const int, int64_t>(in_vals.data(), n_items),
+    raft::make_device_vector_view<const int, int64_t>(offsets.data(), offsets_h.size()),
+    raft::make_device_vector_view<float, int64_t>(out_keys.data(), n_items),
+    raft::make_device_vector_view<int, int64_t>(out_vals.data(), n_items),
+    false);
+
+  for (size_t s = 0; s + 1 < offsets_h.size(); s++) {
+    stable_sort_ref(keys_h, vals_h, offsets_h[s], offsets_h[s + 1], false);
+  }
+  std::vector<float> out_keys_h(n_items);
+  std::vector<int> out_vals_h(n_items);
+  raft::update_host(out_keys_h.data(), out_keys.data(), n_items, stream);
+  raft::update_host(out_vals_h.data(), out_vals.data(), n_items, stream);
+  resource::sync_stream(handle, stream);
+  ASSERT_EQ(keys_h, out_keys_h);
+  ASSERT_EQ(vals_h, out_vals_h);
+}
+
+}  // namespace raft::matrix
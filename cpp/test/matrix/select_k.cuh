@@ -29,6 +29,7 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <functional>
 #include <numeric>
 
 namespace raft::matrix {
@@ -131,7 +132,7 @@ struct io_computed {
       raft::make_device_matrix_view<KeyT, int64_t>(out_dists_d.data(), spec.batch_size, spec.k),
       raft::make_device_matrix_view<IdxT, int64_t>(out_ids_d.data(), spec.batch_size, spec.k),
       spec.select_min,
-      false,
+      spec.sorted,
       algo);
 
     update_host(out_dists_.data(), out_dists_d.data(), out_dists_.size(), stream);
@@ -139,6 +140,16 @@ struct io_computed {
 
     interruptible::synchronize(stream);
 
+    if (spec.sorted) {
+      for (size_t i = 0; i < spec.batch_size; i++) {
+        auto row_begin = out_dists_.begin() + i * spec.k;
+        auto row_end   = row_begin + spec.k;
+        EXPECT_TRUE(spec.select_min ? std::is_sorted(row_begin, row_end)
+                                    : std::is_sorted(row_begin, row_end, std::greater<KeyT>()))
+          << "the selected values of the row " << i << " are not sorted";
+      }
+    }
+
     auto p = topk_sort_permutation(out_dists_, out_ids_, spec.k, spec.select_min);
     apply_permutation(out_dists_, p);
     apply_permutation(out_ids_, p);
@@ -24,6 +24,13 @@ auto inputs_random_largek = testing::Values(select::params{100, 100000, 1000, tr
                                             select::params{100, 100000, 2048, false},
                                             select::params{100, 100000, 1237, true});
 
+// The sorted outputs are ordered within a block, or by the segmented sort for the longest rows.
+auto inputs_random_largek_sorted = testing::Values(
+  select::params{100, 100000, 1500, true, true, false, true, 0.0, true},
+  select::params{100, 100000, 4096, false, true, false, true, 0.0, true},
+  select::params{50, 100000, 8192, true, true, false, true, 0.0, true},
+  select::params{10, 100000, 16384, false, true, false, true, 0.0, true});
+
 using ReferencedRandomFloatSizeT =
   SelectK<float, int64_t, with_ref<SelectAlgo::kRadix8bits>::params_random>;
 TEST_P(ReferencedRandomFloatSizeT, LargeK) { run(); }  // NOLINT
@@ -33,4 +40,13 @@ INSTANTIATE_TEST_CASE_P(SelectK,                       // NOLINT
                                          testing::Values(SelectAlgo::kRadix11bits,
                                                          SelectAlgo::kRadix11bitsExtraPass)));
 
+using ReferencedRandomFloatSizeTSorted =
+  SelectK<float, int64_t, with_ref<SelectAlgo::kRadix8bits>::params_random>;
+TEST_P(ReferencedRandomFloatSizeTSorted, LargeKSorted) { run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(SelectK,                                   // NOLINT
+                        ReferencedRandomFloatSizeTSorted,
+                        testing::Combine(inputs_random_largek_sorted,
+                                         testing::Values(SelectAlgo::kAuto,
+                                                         SelectAlgo::kRadix11bits)));
+
 }  // namespace raft::matrix
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/matrix/topk_accumulator.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <optional>
+#include <vector>
+
+namespace raft::matrix {
+
+struct TopkAccumulatorInputs {
+  int64_t n_rows;
+  int k;
+  bool select_min;
+  bool with_ids;
+  std::vector<int64_t> chunk_lens;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const TopkAccumulatorInputs& p)
+{
+  os << "{n_rows: " << p.n_rows << ", k: " << p.k << ", select_min: " << p.select_min
+     << ", with_ids: " << p.with_ids << ", n_chunks: " << p.chunk_lens.size() << "}";
+  return os;
+}
+
+template <typename T, typename IdxT>
+class TopkAccumulatorTest : public ::testing::TestWithParam<TopkAccumulatorInputs> {
+ public:
+  TopkAccumulatorTest()
+    : stream(resource::get_cuda_stream(handle)),
+      params(::testing::TestWithParam<TopkAccumulatorInputs>::GetParam())
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    int64_t n_cols = 0;
+    for (auto len : params.chunk_lens) {
+      n_cols += len;
+    }
+    // The chunks are stored one after another, each being a row-major [n_rows, len] matrix.
+    auto chunks = make_device_vector<T, int64_t>(handle, params.n_rows * n_cols);
+    auto ids    = make_device_vector<IdxT, int64_t>(handle, params.n_rows * n_cols);
+    raft::random::RngState r(1234ULL);
+    raft::random::uniform(handle, r, chunks.data_handle(), chunks.size(), T(-1.0), T(1.0));
+    raft::linalg::map_offset(handle, ids.view(), [] __device__(int64_t i) { return IdxT(3 * i); });
+
+    // The reference: the selection over all the chunks side by side in one matrix.
+    auto all_val      = make_device_matrix<T, int64_t>(handle, params.n_rows, n_cols);
+    auto all_idx      = make_device_matrix<IdxT, int64_t>(handle, params.n_rows, n_cols);
+    int64_t chunk_off = 0;
+    int64_t col_off   = 0;
+    for (auto len : params.chunk_lens) {
+      const T* chunk_val    = chunks.data_handle() + chunk_off;
+      const IdxT* chunk_idx = ids.data_handle() + chunk_off;
+      const bool with_ids   = params.with_ids;
+      const int64_t offset  = col_off;
+      T* dst_val            = all_val.data_handle();
+      IdxT* dst_idx         = all_idx.data_handle();
+      auto count            = thrust::make_counting_iterator<int64_t>(0);
+      thrust::for_each(resource::get_thrust_policy(handle),
+                       count,
+                       count + params.n_rows * len,
+                       [=, n_cols = n_cols] __device__(int64_t i) {
+                         const int64_t row = i / len;
+                         const int64_t col = i % len;
+                         dst_val[row * n_cols + offset + col] = chunk_val[i];
+                         dst_idx[row * n_cols + offset + col] =
+                           with_ids ? chunk_idx[i] : IdxT(offset + col);
+                       });
+      chunk_off += params.n_rows * len;
+      col_off += len;
+    }
+    auto ref_val = make_device_matrix<T, int64_t>(handle, params.n_rows, params.k);
+    auto ref_idx = make_device_matrix<IdxT, int64_t>(handle, params.n_rows, params.k);
+    select_k<T, IdxT>(handle,
+                      make_const_mdspan(all_val.view()),
+                      make_const_mdspan(all_idx.view()),
+                      ref_val.view(),
+                      ref_idx.view(),
+                      params.select_min,
+                      true);
+
+    topk_accumulator<T, IdxT> acc(handle, params.n_rows, params.k, params.select_min);
+    chunk_off = 0;
+    col_off   = 0;
+    for (auto len : params.chunk_lens) {
+      auto chunk_val = make_device_matrix_view<const T, int64_t>(
+        chunks.data_handle() + chunk_off, params.n_rows, len);
+      std::optional<device_matrix_view<const IdxT, int64_t>> chunk_idx = std::nullopt;
+      if (params.with_ids) {
+        chunk_idx = make_device_matrix_view<const IdxT, int64_t>(
+          ids.data_handle() + chunk_off, params.n_rows, len);
+      }
+      acc.push(handle, chunk_val, chunk_idx, IdxT(col_off));
+      chunk_off += params.n_rows * len;
+      col_off += len;
+    }
+    auto out_val = make_device_matrix<T, int64_t>(handle, params.n_rows, params.k);
+    auto out_idx = make_device_matrix<IdxT, int64_t>(handle, params.n_rows, params.k);
+    acc.finalize(handle, out_val.view(), out_idx.view());
+
+    ASSERT_TRUE(devArrMatch(ref_val.data_handle(),
+                            out_val.data_handle(),
+                            out_val.size(),
+                            CompareApprox<T>(1e-6),
+                            stream));
+    ASSERT_TRUE(devArrMatch(
+      ref_idx.data_handle(), out_idx.data_handle(), out_idx.size(), Compare<IdxT>(), stream));
+  }
+
+  raft::resources handle;
+  cudaStream_t stream;
+  TopkAccumulatorInputs params;
+};
+
+const std::vector<TopkAccumulatorInputs> inputs = {
+  {100, 32, true, false, {1000, 7, 3000, 32, 64}},
+  {100, 32, false, true, {1000, 7, 3000, 32, 64}},
+  {20, 300, true, false, {5000, 100, 300, 20000}},
+  {20, 300, false, true, {5000, 100, 300, 20000}},
+  {1000, 10, true, false, {128}},
+  {1000, 10, true, true, {3, 3, 3, 3, 3}},
+};
+
+using TopkAccumulatorTestF = TopkAccumulatorTest<float, int64_t>;
+TEST_P(TopkAccumulatorTestF, Result) { Run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(TopkAccumulatorTest,     // NOLINT
+                        TopkAccumulatorTestF,
+                        ::testing::ValuesIn(inputs));
+
+}  // namespace raft::matrix
@@ -23,9 +23,11 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/device_resources.hpp>
 #include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/linalg/add.cuh>
+#include <raft/linalg/map.cuh>
 #include <raft/linalg/normalize.cuh>
 #include <raft/neighbors/cagra.cuh>
 #include <raft/neighbors/cagra_serialize.cuh>
@@ -37,6 +39,7 @@
 
 #include <raft_internal/neighbors/naive_knn.cuh>
 
+#include <rmm/cuda_stream.hpp>
 #include <rmm/device_buffer.hpp>
 
 #include <cuda_fp16.h>
@@ -45,7 +48,10 @@
 #include <gtest/gtest.h>
 
 #include <cstddef>
+#include <fstream>
 #include <iostream>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -281,6 +287,8 @@ struct AnnCagraInputs {
   bool include_serialized_dataset;
   // std::optional<double>
   double min_recall;  // = std::nullopt;
+  bool out_of_core = false;
+  bool persistent  = false;
 };
 
 inline ::std::ostream& operator<<(::std::ostream& os, const AnnCagraInputs& p)
@@ -291,7 +299,9 @@ inline ::std::ostream& operator<<(::std::ostream& os, const AnnCagraInputs& p)
      << ", k=" << p.k << ", " << algo.at((int)p.algo) << ", max_queries=" << p.max_queries
      << ", itopk_size=" << p.itopk_size << ", search_width=" << p.search_width
      << ", metric=" << static_cast<int>(p.metric) << (p.host_dataset ? ", host" : ", device")
-     << ", build_algo=" << build_algo.at((int)p.build_algo) << '}' << std::endl;
+     << ", build_algo=" << build_algo.at((int)p.build_algo)
+     << (p.out_of_core ? ", out_of_core" : "") << (p.persistent ? ", persistent" : "") << '}'
+     << std::endl;
   return os;
 }
 
@@ -309,11 +319,6 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
  protected:
   void testCagra()
   {
-    // TODO (tarang-jain): remove when NN Descent index building support InnerProduct. Reference
-    // issue: https://github.com/rapidsai/raft/issues/2276
-    if (ps.metric == distance::InnerProduct && ps.build_algo == graph_build_algo::NN_DESCENT)
-      GTEST_SKIP();
-
     size_t queries_size = ps.n_queries * ps.k;
     std::vector<IdxT> indices_Cagra(queries_size);
     std::vector<IdxT> indices_naive(queries_size);
@@ -347,11 +352,16 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
         index_params.metric = ps.metric;  // Note: currently ony the cagra::index_params metric is
                                           // not used for knn_graph building.
         index_params.build_algo = ps.build_algo;
+        index_params.out_of_core = ps.out_of_core;
         cagra::search_params search_params;
         search_params.algo        = ps.algo;
         search_params.max_queries = ps.max_queries;
         search_params.team_size   = ps.team_size;
         search_params.itopk_size  = ps.itopk_size;
+        search_params.persistent  = ps.persistent;
+        // A short lifetime lets the persistent kernel stop before the device-wide
+        // synchronization of the cleanup.
+        if (ps.persistent) { search_params.persistent_lifetime = 0.1; }
 
         auto database_view = raft::make_device_matrix_view<const DataT, int64_t>(
           (const DataT*)database.data(), ps.n_rows, ps.dim);
@@ -385,6 +395,123 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
         update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
         update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
         resource::sync_stream(handle_);
+
+        if (ps.algo == search_algo::SINGLE_CTA && ps.max_queries == 10) {
+          // The search reusing a workspace must give the same results as the plain search.
+          cagra::search_workspace workspace;
+          rmm::device_uvector<DistanceT> ws_distances_dev(queries_size, stream_);
+          rmm::device_uvector<IdxT> ws_indices_dev(queries_size, stream_);
+          auto ws_indices_view =
+            raft::make_device_matrix_view<IdxT, int64_t>(ws_indices_dev.data(), ps.n_queries, ps.k);
+          auto ws_dists_view = raft::make_device_matrix_view<DistanceT, int64_t>(
+            ws_distances_dev.data(), ps.n_queries, ps.k);
+          for (int i = 0; i < 2; i++) {
+            cagra::search(handle_,
+                          search_params,
+                          index,
+                          search_queries_view,
+                          ws_indices_view,
+                          ws_dists_view,
+                          workspace);
+            ASSERT_FALSE(workspace.empty());
+            ASSERT_TRUE(raft::devArrMatch(indices_dev.data(),
+                                          ws_indices_dev.data(),
+                                          queries_size,
+                                          raft::Compare<IdxT>(),
+                                          stream_));
+          }
+        }
+
+        if (ps.algo == search_algo::SINGLE_CTA && ps.max_queries == 0) {
+          // The memory-mapped layout must load the same index, with either dataset placement.
+          cagra::serialize_mmap(handle_, "cagra_index_mmap", index);
+          rmm::device_uvector<DistanceT> mm_distances_dev(queries_size, stream_);
+          rmm::device_uvector<IdxT> mm_indices_dev(queries_size, stream_);
+          auto mm_indices_view =
+            raft::make_device_matrix_view<IdxT, int64_t>(mm_indices_dev.data(), ps.n_queries, ps.k);
+          auto mm_dists_view = raft::make_device_matrix_view<DistanceT, int64_t>(
+            mm_distances_dev.data(), ps.n_queries, ps.k);
+          for (auto mode :
+               {cagra::mmap_dataset_mode::DEVICE, cagra::mmap_dataset_mode::HOST_MAPPED}) {
+            auto mm_index = cagra::deserialize_mmap<DataT, IdxT>(handle_, "cagra_index_mmap", mode);
+            ASSERT_EQ(mm_index.size(), index.size());
+            ASSERT_EQ(mm_index.graph_degree(), index.graph_degree());
+            cagra::search(handle_,
+                          search_params,
+                          mm_index,
+                          search_queries_view,
+                          mm_indices_view,
+                          mm_dists_view);
+            ASSERT_TRUE(raft::devArrMatch(indices_dev.data(),
+                                          mm_indices_dev.data(),
+                                          queries_size,
+                                          raft::Compare<IdxT>(),
+                                          stream_));
+          }
+          // A file with a dataset stride smaller than dim is rejected (a zero stride means
+          // no dataset).
+          if (ps.dim > 1) {
+            {
+              std::fstream file("cagra_index_mmap",
+                                std::ios::in | std::ios::out | std::ios::binary);
+              const uint32_t bad_stride = ps.dim - 1;
+              file.seekp(offsetof(cagra::detail::mmap_file_header, dataset_stride));
+              file.write(reinterpret_cast<const char*>(&bad_stride), sizeof(bad_stride));
+            }
+            EXPECT_THROW(cagra::deserialize_mmap<DataT, IdxT>(
+                           handle_, "cagra_index_mmap", cagra::mmap_dataset_mode::DEVICE),
+                         raft::logic_error);
+          }
+        }
+
+        if (ps.algo == search_algo::MULTI_KERNEL && ps.max_queries == 10) {
+          // Capture the search prepared in a workspace in a CUDA graph and replay it.
+          rmm::cuda_stream capture_stream;
+          raft::resources capture_res;
+          resource::set_cuda_stream(capture_res, capture_stream.view());
+          cagra::search_workspace workspace;
+          rmm::device_uvector<DistanceT> cg_distances_dev(queries_size, stream_);
+          rmm::device_uvector<IdxT> cg_indices_dev(queries_size, stream_);
+          auto cg_indices_view =
+            raft::make_device_matrix_view<IdxT, int64_t>(cg_indices_dev.data(), ps.n_queries, ps.k);
+          auto cg_dists_view = raft::make_device_matrix_view<DistanceT, int64_t>(
+            cg_distances_dev.data(), ps.n_queries, ps.k);
+          resource::sync_stream(handle_);
+
+          cagra::prepare_search(capture_res, search_params, index, ps.n_queries, ps.k, workspace);
+          resource::sync_stream(capture_res);
+          cudaGraph_t graph;
+          cudaGraphExec_t graph_exec;
+          RAFT_CUDA_TRY(
+            cudaStreamBeginCapture(capture_stream.value(), cudaStreamCaptureModeThreadLocal));
+          cagra::search(capture_res,
+                        search_params,
+                        index,
+                        search_queries_view,
+                        cg_indices_view,
+                        cg_dists_view,
+                        workspace);
+          RAFT_CUDA_TRY(cudaStreamEndCapture(capture_stream.value(), &graph));
+          RAFT_CUDA_TRY(cudaGraphInstantiate(&graph_exec, graph, nullptr, nullptr, 0));
+          RAFT_CUDA_TRY(cudaGraphLaunch(graph_exec, capture_stream.value()));
+          resource::sync_stream(capture_res);
+          RAFT_CUDA_TRY(cudaGraphExecDestroy(graph_exec));
+          RAFT_CUDA_TRY(cudaGraphDestroy(graph));
+
+          std::vector<IdxT> cg_indices(queries_size);
+          std::vector<DistanceT> cg_distances(queries_size);
+          update_host(cg_distances.data(), cg_distances_dev.data(), queries_size, stream_);
+          update_host(cg_indices.data(), cg_indices_dev.data(), queries_size, stream_);
+          resource::sync_stream(handle_);
+          EXPECT_TRUE(eval_neighbours(indices_naive,
+                                      cg_indices,
+                                      distances_naive,
+                                      cg_distances,
+                                      ps.n_queries,
+                                      ps.k,
+                                      0.003,
+                                      ps.min_recall));
+        }
       }
 
       // for (int i = 0; i < min(ps.n_queries, 10); i++) {
@@ -454,9 +581,6 @@ class AnnCagraSortTest : public ::testing::TestWithParam<AnnCagraInputs> {
  protected:
   void testCagraSort()
   {
-    if (ps.metric == distance::InnerProduct && ps.build_algo == graph_build_algo::NN_DESCENT)
-      GTEST_SKIP();
-
     {
       // Step 1: Build a sorted KNN graph by CAGRA knn build
       auto database_view = raft::make_device_matrix_view<const DataT, int64_t>(
@@ -484,6 +608,7 @@ class AnnCagraSortTest : public ::testing::TestWithParam<AnnCagraInputs> {
         auto nn_descent_idx_params                      = experimental::nn_descent::index_params{};
         nn_descent_idx_params.graph_degree              = index_params.intermediate_graph_degree;
         nn_descent_idx_params.intermediate_graph_degree = index_params.intermediate_graph_degree;
+        nn_descent_idx_params.metric                    = ps.metric;
 
         if (ps.host_dataset) {
           cagra::build_knn_graph<DataT, IdxT>(
@@ -504,6 +629,13 @@ class AnnCagraSortTest : public ::testing::TestWithParam<AnnCagraInputs> {
         handle_.sync_stream();
 
         ASSERT_TRUE(CheckOrder<DistanceT>(knn_graph.view(), database_host.view(), ps.metric));
+
+        // Sort again reading the dataset from the host memory (out-of-core mode).
+        RandomSuffle(knn_graph.view());
+        cagra::detail::graph::sort_knn_graph(handle_, database_host_view, knn_graph.view(), true);
+        handle_.sync_stream();
+
+        ASSERT_TRUE(CheckOrder<DistanceT>(knn_graph.view(), database_host.view(), ps.metric));
       }
     }
   }
@@ -533,6 +665,712 @@ class AnnCagraSortTest : public ::testing::TestWithParam<AnnCagraInputs> {
   rmm::device_uvector<DataT> database;
 };
 
+template <typename DistanceT, typename DataT, typename IdxT>
+class AnnCagraOptimizeTest : public ::testing::TestWithParam<AnnCagraInputs> {
+ public:
+  AnnCagraOptimizeTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<AnnCagraInputs>::GetParam()),
+      database(0, stream_),
+      search_queries(0, stream_)
+  {
+  }
+
+ protected:
+  /** Search the dataset using the given graph and return the recall against the naive kNN. */
+  auto search_recall(raft::host_matrix_view<const IdxT, int64_t> graph,
+                     const std::vector<IdxT>& indices_naive) -> double
+  {
+    size_t queries_size = ps.n_queries * ps.k;
+    rmm::device_uvector<DistanceT> distances_dev(queries_size, stream_);
+    rmm::device_uvector<IdxT> indices_dev(queries_size, stream_);
+    std::vector<IdxT> indices_Cagra(queries_size);
+
+    auto database_view = raft::make_device_matrix_view<const DataT, int64_t>(
+      (const DataT*)database.data(), ps.n_rows, ps.dim);
+    cagra::index<DataT, IdxT> index(handle_, ps.metric, database_view, graph);
+
+    cagra::search_params search_params;
+    search_params.algo        = ps.algo;
+    search_params.max_queries = ps.max_queries;
+    search_params.team_size   = ps.team_size;
+    search_params.itopk_size  = ps.itopk_size;
+    cagra::search(handle_,
+                  search_params,
+                  index,
+                  raft::make_device_matrix_view<const DataT, int64_t>(
+                    search_queries.data(), ps.n_queries, ps.dim),
+                  raft::make_device_matrix_view<IdxT, int64_t>(
+                    indices_dev.data(), ps.n_queries, ps.k),
+                  raft::make_device_matrix_view<DistanceT, int64_t>(
+                    distances_dev.data(), ps.n_queries, ps.k));
+    update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
+    resource::sync_stream(handle_);
+    EXPECT_TRUE(eval_recall(indices_naive, indices_Cagra, ps.n_queries, ps.k, 0.01, ps.min_recall));
+    return std::get<0>(calc_recall(indices_naive, indices_Cagra, ps.n_queries, ps.k));
+  }
+
+  /** The device-resident graph optimization must agree with the host path (out-of-core mode). */
+  void testCagraOptimize()
+  {
+    size_t queries_size = ps.n_queries * ps.k;
+    std::vector<IdxT> indices_naive(queries_size);
+    {
+      rmm::device_uvector<DistanceT> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+      naive_knn<DistanceT, DataT, IdxT>(handle_,
+                                        distances_naive_dev.data(),
+                                        indices_naive_dev.data(),
+                                        search_queries.data(),
+                                        database.data(),
+                                        ps.n_queries,
+                                        ps.n_rows,
+                                        ps.dim,
+                                        ps.k,
+                                        ps.metric);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    auto database_view = raft::make_device_matrix_view<const DataT, int64_t>(
+      (const DataT*)database.data(), ps.n_rows, ps.dim);
+    cagra::index_params index_params;
+    auto knn_graph =
+      raft::make_host_matrix<IdxT, int64_t>(ps.n_rows, index_params.intermediate_graph_degree);
+    if (ps.build_algo == graph_build_algo::IVF_PQ) {
+      auto build_params = ivf_pq::index_params::from_dataset(database_view, ps.metric);
+      cagra::build_knn_graph<DataT, IdxT>(
+        handle_, database_view, knn_graph.view(), 2, build_params);
+    } else {
+      auto nn_descent_idx_params                      = experimental::nn_descent::index_params{};
+      nn_descent_idx_params.graph_degree              = index_params.intermediate_graph_degree;
+      nn_descent_idx_params.intermediate_graph_degree = index_params.intermediate_graph_degree;
+      nn_descent_idx_params.metric                    = ps.metric;
+      cagra::build_knn_graph<DataT, IdxT>(
+        handle_, database_view, knn_graph.view(), nn_descent_idx_params);
+    }
+
+    const int64_t degree = index_params.graph_degree;
+    auto graph_device    = raft::make_host_matrix<IdxT, int64_t>(ps.n_rows, degree);
+    auto graph_host      = raft::make_host_matrix<IdxT, int64_t>(ps.n_rows, degree);
+    cagra::detail::graph::optimize<IdxT>(handle_, knn_graph.view(), graph_device.view(), false);
+    cagra::detail::graph::optimize<IdxT>(handle_, knn_graph.view(), graph_host.view(), true);
+
+    // The pruning is deterministic, hence the protected first half of every row must match; the
+    // reverse edges merged into the rest depend on the order of the atomics of both paths.
+    for (int64_t i = 0; i < ps.n_rows; i++) {
+      for (int64_t j = 0; j < degree / 2; j++) {
+        ASSERT_EQ(graph_device(i, j), graph_host(i, j)) << "row " << i << ", edge " << j;
+      }
+    }
+
+    auto recall_device = search_recall(raft::make_const_mdspan(graph_device.view()), indices_naive);
+    auto recall_host   = search_recall(raft::make_const_mdspan(graph_host.view()), indices_naive);
+    ASSERT_NEAR(recall_device, recall_host, 0.005);
+  }
+
+  void SetUp() override
+  {
+    database.resize(((size_t)ps.n_rows) * ps.dim, stream_);
+    search_queries.resize(ps.n_queries * ps.dim, stream_);
+    raft::random::RngState r(1234ULL);
+    InitDataset(handle_, database.data(), ps.n_rows, ps.dim, ps.metric, r);
+    InitDataset(handle_, search_queries.data(), ps.n_queries, ps.dim, ps.metric, r);
+    resource::sync_stream(handle_);
+  }
+
+  void TearDown() override
+  {
+    resource::sync_stream(handle_);
+    database.resize(0, stream_);
+    search_queries.resize(0, stream_);
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  AnnCagraInputs ps;
+  rmm::device_uvector<DataT> database;
+  rmm::device_uvector<DataT> search_queries;
+};
+
+template <typename DistanceT, typename DataT, typename IdxT>
+class AnnCagraExtendTest : public ::testing::TestWithParam<AnnCagraInputs> {
+ public:
+  AnnCagraExtendTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<AnnCagraInputs>::GetParam()),
+      database(0, stream_),
+      search_queries(0, stream_)
+  {
+  }
+
+ protected:
+  void testCagraExtend()
+  {
+    // The initial index must be large enough to provide 2 * graph_degree candidates.
+    if (ps.n_rows < 2000 || ps.k >= 1024) { GTEST_SKIP(); }
+
+    size_t queries_size = ps.n_queries * ps.k;
+    std::vector<IdxT> indices_Cagra(queries_size);
+    std::vector<IdxT> indices_naive(queries_size);
+    std::vector<DistanceT> distances_Cagra(queries_size);
+    std::vector<DistanceT> distances_naive(queries_size);
+
+    {
+      rmm::device_uvector<DistanceT> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+      naive_knn<DistanceT, DataT, IdxT>(handle_,
+                                        distances_naive_dev.data(),
+                                        indices_naive_dev.data(),
+                                        search_queries.data(),
+                                        database.data(),
+                                        ps.n_queries,
+                                        ps.n_rows,
+                                        ps.dim,
+                                        ps.k,
+                                        ps.metric);
+      update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    {
+      rmm::device_uvector<DistanceT> distances_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_dev(queries_size, stream_);
+
+      cagra::index_params index_params;
+      index_params.metric     = ps.metric;
+      index_params.build_algo = ps.build_algo;
+      cagra::search_params search_params;
+      search_params.algo        = ps.algo;
+      search_params.max_queries = ps.max_queries;
+      search_params.team_size   = ps.team_size;
+      search_params.itopk_size  = ps.itopk_size;
+
+      // Build the index on a part of the dataset and add the rest of the vectors with extend.
+      const int64_t n_initial = ps.n_rows / 2;
+      const int64_t n_add     = ps.n_rows - n_initial;
+      auto initial_view       = raft::make_device_matrix_view<const DataT, int64_t>(
+        (const DataT*)database.data(), n_initial, ps.dim);
+      auto index = cagra::build<DataT, IdxT>(handle_, index_params, initial_view);
+
+      cagra::extend_params extend_params;
+      extend_params.max_chunk_size = 128;
+      if (ps.host_dataset) {
+        auto additional_host = raft::make_host_matrix<DataT, int64_t>(n_add, ps.dim);
+        raft::copy(additional_host.data_handle(),
+                   database.data() + n_initial * ps.dim,
+                   additional_host.size(),
+                   stream_);
+        resource::sync_stream(handle_);
+        cagra::extend(
+          handle_, extend_params, raft::make_const_mdspan(additional_host.view()), index);
+      } else {
+        auto additional_view = raft::make_device_matrix_view<const DataT, int64_t>(
+          (const DataT*)database.data() + n_initial * ps.dim, n_add, ps.dim);
+        cagra::extend(handle_, extend_params, additional_view, index);
+      }
+      ASSERT_EQ(index.size(), IdxT(ps.n_rows));
+      ASSERT_EQ(index.graph().extent(0), ps.n_rows);
+
+      auto search_queries_view = raft::make_device_matrix_view<const DataT, int64_t>(
+        search_queries.data(), ps.n_queries, ps.dim);
+      auto indices_out_view =
+        raft::make_device_matrix_view<IdxT, int64_t>(indices_dev.data(), ps.n_queries, ps.k);
+      auto dists_out_view = raft::make_device_matrix_view<DistanceT, int64_t>(
+        distances_dev.data(), ps.n_queries, ps.k);
+
+      cagra::search(
+        handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
+      update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+
+      // The recall of an extended graph is slightly lower than that of a rebuilt one.
+      double min_recall = ps.min_recall - 0.02;
+      EXPECT_TRUE(eval_neighbours(indices_naive,
+                                  indices_Cagra,
+                                  distances_naive,
+                                  distances_Cagra,
+                                  ps.n_queries,
+                                  ps.k,
+                                  0.003,
+                                  min_recall));
+      EXPECT_TRUE(eval_distances(handle_,
+                                 database.data(),
+                                 search_queries.data(),
+                                 indices_dev.data(),
+                                 distances_dev.data(),
+                                 ps.n_rows,
+                                 ps.dim,
+                                 ps.n_queries,
+                                 ps.k,
+                                 ps.metric,
+                                 1.0e-4));
+    }
+  }
+
+  void SetUp() override
+  {
+    database.resize(((size_t)ps.n_rows) * ps.dim, stream_);
+    search_queries.resize(ps.n_queries * ps.dim, stream_);
+    raft::random::RngState r(1234ULL);
+    InitDataset(handle_, database.data(), ps.n_rows, ps.dim, ps.metric, r);
+    InitDataset(handle_, search_queries.data(), ps.n_queries, ps.dim, ps.metric, r);
+    resource::sync_stream(handle_);
+  }
+
+  void TearDown() override
+  {
+    resource::sync_stream(handle_);
+    database.resize(0, stream_);
+    search_queries.resize(0, stream_);
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  AnnCagraInputs ps;
+  rmm::device_uvector<DataT> database;
+  rmm::device_uvector<DataT> search_queries;
+};
+
+template <typename DistanceT, typename DataT, typename IdxT>
+class AnnCagraRemoveTest : public ::testing::TestWithParam<AnnCagraInputs> {
+ public:
+  AnnCagraRemoveTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<AnnCagraInputs>::GetParam()),
+      database(0, stream_),
+      search_queries(0, stream_)
+  {
+  }
+
+ protected:
+  void testCagraRemove()
+  {
+    if (ps.k >= 1024) { GTEST_SKIP(); }
+
+    // The first `offset` samples are removed from the index.
+    const IdxT n_removed = test_cagra_sample_filter::offset;
+    size_t queries_size  = ps.n_queries * ps.k;
+    std::vector<IdxT> indices_Cagra(queries_size);
+    std::vector<IdxT> indices_naive(queries_size);
+    std::vector<DistanceT> distances_Cagra(queries_size);
+    std::vector<DistanceT> distances_naive(queries_size);
+
+    rmm::device_uvector<DistanceT> distances_naive_dev(queries_size, stream_);
+    rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+    naive_knn<DistanceT, DataT, IdxT>(handle_,
+                                      distances_naive_dev.data(),
+                                      indices_naive_dev.data(),
+                                      search_queries.data(),
+                                      database.data() + n_removed * ps.dim,
+                                      ps.n_queries,
+                                      ps.n_rows - n_removed,
+                                      ps.dim,
+                                      ps.k,
+                                      ps.metric);
+    update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+    resource::sync_stream(handle_);
+
+    rmm::device_uvector<DistanceT> distances_dev(queries_size, stream_);
+    rmm::device_uvector<IdxT> indices_dev(queries_size, stream_);
+
+    cagra::index_params index_params;
+    index_params.metric     = ps.metric;
+    index_params.build_algo = ps.build_algo;
+    cagra::search_params search_params;
+    search_params.algo         = ps.algo;
+    search_params.max_queries  = ps.max_queries;
+    search_params.team_size    = ps.team_size;
+    search_params.hashmap_mode = cagra::hash_mode::HASH;
+
+    auto database_view = raft::make_device_matrix_view<const DataT, int64_t>(
+      (const DataT*)database.data(), ps.n_rows, ps.dim);
+    auto index = cagra::build<DataT, IdxT>(handle_, index_params, database_view);
+
+    auto removed_indices = raft::make_device_vector<IdxT, int64_t>(handle_, n_removed);
+    thrust::sequence(
+      resource::get_thrust_policy(handle_),
+      thrust::device_pointer_cast(removed_indices.data_handle()),
+      thrust::device_pointer_cast(removed_indices.data_handle() + removed_indices.extent(0)));
+    cagra::remove(handle_, index, raft::make_const_mdspan(removed_indices.view()));
+    ASSERT_EQ(index.num_removed(), n_removed);
+    ASSERT_EQ(index.size(), IdxT(ps.n_rows));
+
+    // An id out of the index range is rejected without modifying the removed set.
+    {
+      auto invalid_ids = raft::make_device_vector<IdxT, int64_t>(handle_, 1);
+      raft::linalg::map(handle_, invalid_ids.view(), raft::const_op<IdxT>{IdxT(ps.n_rows)});
+      EXPECT_THROW(cagra::remove(handle_, index, raft::make_const_mdspan(invalid_ids.view())),
+                   raft::logic_error);
+      ASSERT_EQ(index.num_removed(), n_removed);
+    }
+
+    auto search_queries_view = raft::make_device_matrix_view<const DataT, int64_t>(
+      search_queries.data(), ps.n_queries, ps.dim);
+    auto indices_out_view =
+      raft::make_device_matrix_view<IdxT, int64_t>(indices_dev.data(), ps.n_queries, ps.k);
+    auto dists_out_view =
+      raft::make_device_matrix_view<DistanceT, int64_t>(distances_dev.data(), ps.n_queries, ps.k);
+
+    // The removed samples are skipped without passing a filter.
+    {
+      raft::linalg::addScalar(indices_naive_dev.data(),
+                              indices_naive_dev.data(),
+                              IdxT(n_removed),
+                              queries_size,
+                              stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      cagra::search(
+        handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
+      update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+
+      EXPECT_TRUE(eval_neighbours(indices_naive,
+                                  indices_Cagra,
+                                  distances_naive,
+                                  distances_Cagra,
+                                  ps.n_queries,
+                                  ps.k,
+                                  0.003,
+                                  ps.min_recall,
+                                  false));
+      EXPECT_TRUE(eval_distances(handle_,
+                                 database.data(),
+                                 search_queries.data(),
+                                 indices_dev.data(),
+                                 distances_dev.data(),
+                                 ps.n_rows,
+                                 ps.dim,
+                                 ps.n_queries,
+                                 ps.k,
+                                 ps.metric,
+                                 1.0e-4));
+    }
+
+    // Below the threshold the index is left untouched.
+    ASSERT_FALSE(cagra::compact(handle_, index, 0.5f).has_value());
+    ASSERT_EQ(index.size(), IdxT(ps.n_rows));
+
+    // After the compaction the remaining samples are renumbered from zero.
+    {
+      auto new_to_old = cagra::compact(handle_, index);
+      ASSERT_TRUE(new_to_old.has_value());
+      ASSERT_EQ(index.size(), IdxT(ps.n_rows - n_removed));
+      ASSERT_EQ(index.num_removed(), IdxT(0));
+      ASSERT_EQ(new_to_old->extent(0), int64_t(ps.n_rows - n_removed));
+
+      for (auto& i : indices_naive) {
+        i -= n_removed;
+      }
+      cagra::search(
+        handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
+      update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+
+      // Rewiring the graph around the removed nodes costs a bit of recall.
+      double min_recall = ps.min_recall - 0.02;
+      EXPECT_TRUE(eval_neighbours(indices_naive,
+                                  indices_Cagra,
+                                  distances_naive,
+                                  distances_Cagra,
+                                  ps.n_queries,
+                                  ps.k,
+                                  0.003,
+                                  min_recall));
+      EXPECT_TRUE(eval_distances(handle_,
+                                 database.data() + n_removed * ps.dim,
+                                 search_queries.data(),
+                                 indices_dev.data(),
+                                 distances_dev.data(),
+                                 ps.n_rows - n_removed,
+                                 ps.dim,
+                                 ps.n_queries,
+                                 ps.k,
+                                 ps.metric,
+                                 1.0e-4));
+    }
+
+    // After the reordering the results are mapped back to the previous ids.
+    {
+      cagra::reorder_params reorder_params;
+      reorder_params.cluster_size = 128;
+      auto new_to_old             = cagra::reorder(handle_, reorder_params, index);
+      ASSERT_EQ(index.size(), IdxT(ps.n_rows - n_removed));
+      ASSERT_EQ(new_to_old.extent(0), int64_t(ps.n_rows - n_removed));
+      std::vector<IdxT> new_to_old_host(new_to_old.size());
+      update_host(new_to_old_host.data(), new_to_old.data_handle(), new_to_old.size(), stream_);
+
+      cagra::search(
+        handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
+      update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+      for (auto& i : indices_Cagra) {
+        if (i < new_to_old_host.size()) { i = new_to_old_host[i]; }
+      }
+
+      double min_recall = ps.min_recall - 0.02;
+      EXPECT_TRUE(eval_neighbours(indices_naive,
+                                  indices_Cagra,
+                                  distances_naive,
+                                  distances_Cagra,
+                                  ps.n_queries,
+                                  ps.k,
+                                  0.003,
+                                  min_recall));
+
+      // The compressed graph is decoded on the fly by the search and restored exactly.
+      std::vector<IdxT> graph_host(index.graph().size());
+      update_host(graph_host.data(), index.graph().data_handle(), graph_host.size(), stream_);
+      const auto graph_degree = index.graph_degree();
+      cagra::compress_graph(handle_, index);
+      ASSERT_GT(index.graph_id_bits(), 0u);
+      ASSERT_LT(index.graph_id_bits(), 8 * sizeof(IdxT));
+      ASSERT_EQ(index.graph_degree(), graph_degree);
+      ASSERT_EQ(index.size(), IdxT(ps.n_rows - n_removed));
+
+      cagra::search(
+        handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
+      update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+      for (auto& i : indices_Cagra) {
+        if (i < new_to_old_host.size()) { i = new_to_old_host[i]; }
+      }
+      EXPECT_TRUE(eval_neighbours(indices_naive,
+                                  indices_Cagra,
+                                  distances_naive,
+                                  distances_Cagra,
+                                  ps.n_queries,
+                                  ps.k,
+                                  0.003,
+                                  min_recall));
+
+      cagra::decompress_graph(handle_, index);
+      ASSERT_EQ(index.graph_id_bits(), 0u);
+      std::vector<IdxT> graph_restored(index.graph().size());
+      update_host(
+        graph_restored.data(), index.graph().data_handle(), graph_restored.size(), stream_);
+      resource::sync_stream(handle_);
+      EXPECT_EQ(graph_restored, graph_host);
+
+      // The graph saved bit-packed is unpacked on the device by the deserialization.
+      for (bool compressed_in_index : {false, true}) {
+        if (compressed_in_index) { cagra::compress_graph(handle_, index); }
+        std::stringstream ss;
+        cagra::serialize(handle_, ss, index, false, true);
+        auto loaded = cagra::deserialize<DataT, IdxT>(handle_, ss);
+        ASSERT_EQ(loaded.graph_id_bits(), 0u);
+        ASSERT_EQ(loaded.graph_degree(), graph_degree);
+        std::vector<IdxT> graph_loaded(loaded.graph().size());
+        update_host(
+          graph_loaded.data(), loaded.graph().data_handle(), graph_loaded.size(), stream_);
+        resource::sync_stream(handle_);
+        EXPECT_EQ(graph_loaded, graph_host);
+      }
+    }
+  }
+
+  /** Compacting down to a handful of nodes pads the rows without self-loops or duplicates. */
+  void testCagraCompactPadding()
+  {
+    cagra::index_params index_params;
+    index_params.metric     = ps.metric;
+    index_params.build_algo = ps.build_algo;
+    auto database_view      = raft::make_device_matrix_view<const DataT, int64_t>(
+      (const DataT*)database.data(), ps.n_rows, ps.dim);
+    const int64_t degree = index_params.graph_degree;
+    if (ps.n_rows <= degree + 1) { GTEST_SKIP(); }
+
+    // Enough live nodes to fill the rows, and fewer than the degree.
+    for (int64_t n_keep : {degree + 1, std::max<int64_t>(degree / 2, 2)}) {
+      auto index = cagra::build<DataT, IdxT>(handle_, index_params, database_view);
+      auto removed_indices =
+        raft::make_device_vector<IdxT, int64_t>(handle_, ps.n_rows - n_keep);
+      thrust::sequence(
+        resource::get_thrust_policy(handle_),
+        thrust::device_pointer_cast(removed_indices.data_handle()),
+        thrust::device_pointer_cast(removed_indices.data_handle() + removed_indices.extent(0)),
+        IdxT(n_keep));
+      cagra::remove(handle_, index, raft::make_const_mdspan(removed_indices.view()));
+      ASSERT_TRUE(cagra::compact(handle_, index).has_value());
+      ASSERT_EQ(index.size(), IdxT(n_keep));
+      ASSERT_EQ(index.graph_degree(), degree);
+
+      std::vector<IdxT> graph(index.graph().size());
+      update_host(graph.data(), index.graph().data_handle(), graph.size(), stream_);
+      resource::sync_stream(handle_);
+      for (int64_t i = 0; i < n_keep; i++) {
+        std::set<IdxT> row(graph.begin() + i * degree, graph.begin() + (i + 1) * degree);
+        ASSERT_EQ(row.count(IdxT(i)), 0u) << "self-loop in the row " << i;
+        ASSERT_LT(*row.rbegin(), IdxT(n_keep));
+        // A row links to as many distinct nodes as the other live nodes allow.
+        ASSERT_EQ(int64_t(row.size()), std::min(degree, n_keep - 1))
+          << "duplicates in the row " << i;
+      }
+    }
+  }
+
+  void SetUp() override
+  {
+    database.resize(((size_t)ps.n_rows) * ps.dim, stream_);
+    search_queries.resize(ps.n_queries * ps.dim, stream_);
+    raft::random::RngState r(1234ULL);
+    InitDataset(handle_, database.data(), ps.n_rows, ps.dim, ps.metric, r);
+    InitDataset(handle_, search_queries.data(), ps.n_queries, ps.dim, ps.metric, r);
+    resource::sync_stream(handle_);
+  }
+
+  void TearDown() override
+  {
+    resource::sync_stream(handle_);
+    database.resize(0, stream_);
+    search_queries.resize(0, stream_);
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  AnnCagraInputs ps;
+  rmm::device_uvector<DataT> database;
+  rmm::device_uvector<DataT> search_queries;
+};
+
+template <typename DistanceT, typename DataT, typename IdxT>
+class AnnCagraShardedTest : public ::testing::TestWithParam<AnnCagraInputs> {
+ public:
+  AnnCagraShardedTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<AnnCagraInputs>::GetParam()),
+      database(0, stream_),
+      search_queries(0, stream_)
+  {
+  }
+
+ protected:
+  void testCagraSharded()
+  {
+    if (ps.n_rows < 2000 || ps.k >= 1024) { GTEST_SKIP(); }
+
+    size_t queries_size = ps.n_queries * ps.k;
+    std::vector<int64_t> indices_Cagra(queries_size);
+    std::vector<int64_t> indices_naive(queries_size);
+    std::vector<DistanceT> distances_Cagra(queries_size);
+    std::vector<DistanceT> distances_naive(queries_size);
+
+    {
+      rmm::device_uvector<DistanceT> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<int64_t> indices_naive_dev(queries_size, stream_);
+      naive_knn<DistanceT, DataT, int64_t>(handle_,
+                                           distances_naive_dev.data(),
+                                           indices_naive_dev.data(),
+                                           search_queries.data(),
+                                           database.data(),
+                                           ps.n_queries,
+                                           ps.n_rows,
+                                           ps.dim,
+                                           ps.k,
+                                           ps.metric);
+      update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    {
+      rmm::device_uvector<DistanceT> distances_dev(queries_size, stream_);
+      rmm::device_uvector<int64_t> indices_dev(queries_size, stream_);
+
+      cagra::index_params index_params;
+      index_params.metric     = ps.metric;
+      index_params.build_algo = ps.build_algo;
+      cagra::search_params search_params;
+      search_params.algo        = ps.algo;
+      search_params.max_queries = ps.max_queries;
+      search_params.team_size   = ps.team_size;
+      search_params.itopk_size  = ps.itopk_size;
+
+      // Shard the index over all the devices, using at least two shards to exercise the merge.
+      int n_devices = 0;
+      RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+      std::vector<int> device_ids(std::max(n_devices, 2));
+      for (size_t i = 0; i < device_ids.size(); i++) {
+        device_ids[i] = i % n_devices;
+      }
+
+      auto database_host = raft::make_host_matrix<DataT, int64_t>(ps.n_rows, ps.dim);
+      raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
+      resource::sync_stream(handle_);
+      auto index = cagra::build_sharded<DataT, IdxT>(
+        index_params, device_ids, raft::make_const_mdspan(database_host.view()));
+      ASSERT_EQ(index.n_shards(), device_ids.size());
+      ASSERT_EQ(index.size(), int64_t(ps.n_rows));
+
+      auto search_queries_view = raft::make_device_matrix_view<const DataT, int64_t>(
+        search_queries.data(), ps.n_queries, ps.dim);
+      auto indices_out_view =
+        raft::make_device_matrix_view<int64_t, int64_t>(indices_dev.data(), ps.n_queries, ps.k);
+      auto dists_out_view = raft::make_device_matrix_view<DistanceT, int64_t>(
+        distances_dev.data(), ps.n_queries, ps.k);
+
+      cagra::search_sharded(
+        handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
+      update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+
+      EXPECT_TRUE(eval_neighbours(indices_naive,
+                                  indices_Cagra,
+                                  distances_naive,
+                                  distances_Cagra,
+                                  ps.n_queries,
+                                  ps.k,
+                                  0.003,
+                                  ps.min_recall));
+      EXPECT_TRUE(eval_distances(handle_,
+                                 database.data(),
+                                 search_queries.data(),
+                                 indices_dev.data(),
+                                 distances_dev.data(),
+                                 ps.n_rows,
+                                 ps.dim,
+                                 ps.n_queries,
+                                 ps.k,
+                                 ps.metric,
+                                 1.0e-4));
+    }
+  }
+
+  void SetUp() override
+  {
+    database.resize(((size_t)ps.n_rows) * ps.dim, stream_);
+    search_queries.resize(ps.n_queries * ps.dim, stream_);
+    raft::random::RngState r(1234ULL);
+    InitDataset(handle_, database.data(), ps.n_rows, ps.dim, ps.metric, r);
+    InitDataset(handle_, search_queries.data(), ps.n_queries, ps.dim, ps.metric, r);
+    resource::sync_stream(handle_);
+  }
+
+  void TearDown() override
+  {
+    resource::sync_stream(handle_);
+    database.resize(0, stream_);
+    search_queries.resize(0, stream_);
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  AnnCagraInputs ps;
+  rmm::device_uvector<DataT> database;
+  rmm::device_uvector<DataT> search_queries;
+};
+
 template <typename DistanceT, typename DataT, typename IdxT>
 class AnnCagraFilterTest : public ::testing::TestWithParam<AnnCagraInputs> {
  public:
@@ -547,9 +1385,6 @@ class AnnCagraFilterTest : public ::testing::TestWithParam<AnnCagraInputs> {
  protected:
   void testCagraFilter()
   {
-    if (ps.metric == distance::InnerProduct && ps.build_algo == graph_build_algo::NN_DESCENT)
-      GTEST_SKIP();
-
     size_t queries_size = ps.n_queries * ps.k;
     std::vector<IdxT> indices_Cagra(queries_size);
     std::vector<IdxT> indices_naive(queries_size);
@@ -672,9 +1507,6 @@ class AnnCagraFilterTest : public ::testing::TestWithParam<AnnCagraInputs> {
 
   void testCagraRemoved()
   {
-    if (ps.metric == distance::InnerProduct && ps.build_algo == graph_build_algo::NN_DESCENT)
-      GTEST_SKIP();
-
     size_t queries_size = ps.n_queries * ps.k;
     std::vector<IdxT> indices_Cagra(queries_size);
     std::vector<IdxT> indices_naive(queries_size);
@@ -767,6 +1599,48 @@ class AnnCagraFilterTest : public ::testing::TestWithParam<AnnCagraInputs> {
         update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
         update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
         resource::sync_stream(handle_);
+
+        // Per-query filters in one batch: the even queries remove the same samples as above, the
+        // odd ones also remove the next `offset` samples.
+        const IdxT n_filtered = test_cagra_sample_filter::offset;
+        std::vector<IdxT> bitmap_removed_host;
+        for (IdxT q = 0; q < IdxT(ps.n_queries); q++) {
+          const IdxT n = std::min<IdxT>(n_filtered * (1 + q % 2), ps.n_rows);
+          for (IdxT j = 0; j < n; j++) {
+            bitmap_removed_host.push_back(q * ps.n_rows + j);
+          }
+        }
+        auto bitmap_removed =
+          raft::make_device_vector<IdxT, IdxT>(handle_, IdxT(bitmap_removed_host.size()));
+        raft::copy(bitmap_removed.data_handle(),
+                   bitmap_removed_host.data(),
+                   bitmap_removed_host.size(),
+                   stream_);
+        raft::core::bitset<std::uint32_t, IdxT> removed_indices_bitmap(
+          handle_, raft::make_const_mdspan(bitmap_removed.view()), ps.n_queries * ps.n_rows);
+        auto bitmap = raft::core::bitmap_view<const std::uint32_t, IdxT>(
+          removed_indices_bitmap.data(), ps.n_queries, ps.n_rows);
+        rmm::device_uvector<DistanceT> bm_distances_dev(queries_size, stream_);
+        rmm::device_uvector<IdxT> bm_indices_dev(queries_size, stream_);
+        cagra::search_with_filtering(
+          handle_,
+          search_params,
+          index,
+          search_queries_view,
+          raft::make_device_matrix_view<IdxT, int64_t>(bm_indices_dev.data(), ps.n_queries, ps.k),
+          raft::make_device_matrix_view<DistanceT, int64_t>(
+            bm_distances_dev.data(), ps.n_queries, ps.k),
+          raft::neighbors::filtering::bitmap_filter(bitmap));
+        std::vector<IdxT> bm_indices(queries_size);
+        update_host(bm_indices.data(), bm_indices_dev.data(), queries_size, stream_);
+        resource::sync_stream(handle_);
+        for (int q = 0; q < ps.n_queries; q++) {
+          for (int j = 0; j < ps.k; j++) {
+            const size_t i = size_t(q) * ps.k + j;
+            ASSERT_GE(bm_indices[i], IdxT(n_filtered * (1 + q % 2)));
+            if (q % 2 == 0) { ASSERT_EQ(bm_indices[i], indices_Cagra[i]); }
+          }
+        }
       }
 
       double min_recall = ps.min_recall;
@@ -941,9 +1815,65 @@ inline std::vector<AnnCagraInputs> generate_inputs()
     {0.995});
   inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
 
+  // The out-of-core build (IVF_PQ only), from the host and the device datasets
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {32},
+    {10},
+    {graph_build_algo::IVF_PQ},
+    {search_algo::AUTO},
+    {10},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded, raft::distance::DistanceType::InnerProduct},
+    {false, true},
+    {false},
+    {0.995},
+    {true});  // out_of_core
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // The persistent single-cta kernel
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {1000},
+    {1, 8, 17, 1599},
+    {16},  // k
+    {graph_build_algo::IVF_PQ},
+    {search_algo::SINGLE_CTA},
+    {1, 100},  // query size
+    {0},
+    {256},
+    {1},
+    {raft::distance::DistanceType::L2Expanded, raft::distance::DistanceType::InnerProduct},
+    {false},
+    {true},
+    {0.995},
+    {false},
+    {true});  // persistent
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
   return inputs;
 }
 
 const std::vector<AnnCagraInputs> inputs = generate_inputs();
 
+// The device and the host graph optimization compared on a fixed seed
+const std::vector<AnnCagraInputs> optimize_inputs = raft::util::itertools::product<AnnCagraInputs>(
+  {100},
+  {10000},
+  {32},
+  {10},
+  {graph_build_algo::IVF_PQ, graph_build_algo::NN_DESCENT},
+  {search_algo::AUTO},
+  {10},
+  {0},
+  {64},
+  {1},
+  {raft::distance::DistanceType::L2Expanded},
+  {false},
+  {false},
+  {0.995});
+
 }  // namespace raft::neighbors::cagra
@@ -26,6 +26,19 @@ TEST_P(AnnCagraTestF_U32, AnnCagra) { this->testCagra(); }
 typedef AnnCagraSortTest<float, float, std::uint32_t> AnnCagraSortTestF_U32;
 TEST_P(AnnCagraSortTestF_U32, AnnCagraSort) { this->testCagraSort(); }
 
+typedef AnnCagraOptimizeTest<float, float, std::uint32_t> AnnCagraOptimizeTestF_U32;
+TEST_P(AnnCagraOptimizeTestF_U32, AnnCagraOptimize) { this->testCagraOptimize(); }
+
+typedef AnnCagraExtendTest<float, float, std::uint32_t> AnnCagraExtendTestF_U32;
+TEST_P(AnnCagraExtendTestF_U32, AnnCagraExtend) { this->testCagraExtend(); }
+
+typedef AnnCagraRemoveTest<float, float, std::uint32_t> AnnCagraRemoveTestF_U32;
+TEST_P(AnnCagraRemoveTestF_U32, AnnCagraRemove) { this->testCagraRemove(); }
+TEST_P(AnnCagraRemoveTestF_U32, AnnCagraCompactPadding) { this->testCagraCompactPadding(); }
+
+typedef AnnCagraShardedTest<float, float, std::uint32_t> AnnCagraShardedTestF_U32;
+TEST_P(AnnCagraShardedTestF_U32, AnnCagraSharded) { this->testCagraSharded(); }
+
 typedef AnnCagraFilterTest<float, float, std::uint32_t> AnnCagraFilterTestF_U32;
 TEST_P(AnnCagraFilterTestF_U32, AnnCagraFilter)
 {
@@ -35,6 +48,14 @@ TEST_P(AnnCagraFilterTestF_U32, AnnCagraFilter)
 
 INSTANTIATE_TEST_CASE_P(AnnCagraTest, AnnCagraTestF_U32, ::testing::ValuesIn(inputs));
 INSTANTIATE_TEST_CASE_P(AnnCagraSortTest, AnnCagraSortTestF_U32, ::testing::ValuesIn(inputs));
+INSTANTIATE_TEST_CASE_P(AnnCagraOptimizeTest,
+                        AnnCagraOptimizeTestF_U32,
+                        ::testing::ValuesIn(optimize_inputs));
+INSTANTIATE_TEST_CASE_P(AnnCagraExtendTest, AnnCagraExtendTestF_U32, ::testing::ValuesIn(inputs));
+INSTANTIATE_TEST_CASE_P(AnnCagraRemoveTest, AnnCagraRemoveTestF_U32, ::testing::ValuesIn(inputs));
+INSTANTIATE_TEST_CASE_P(AnnCagraShardedTest,
+                        AnnCagraShardedTestF_U32,
+                        ::testing::ValuesIn(inputs));
 INSTANTIATE_TEST_CASE_P(AnnCagraFilterTest, AnnCagraFilterTestF_U32, ::testing::ValuesIn(inputs));
 
 }  // namespace raft::neighbors::cagra
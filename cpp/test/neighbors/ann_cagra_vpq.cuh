@@ -315,22 +315,22 @@ class AnnCagraVpqTest : public ::testing::TestWithParam<AnnCagraVpqInputs> {
 };
 
 const std::vector<AnnCagraVpqInputs> vpq_inputs = raft::util::itertools::product<AnnCagraVpqInputs>(
-  {100},                                              // n_queries
-  {1000, 10000},                                      // n_rows
-  {128, 132, 192, 256, 512, 768},                     // dim
-  {8, 12},                                            // k
-  {2, 4},                                             // pq_len
-  {8},                                                // pq_bits
-  {graph_build_algo::NN_DESCENT},                     // build_algo
-  {search_algo::SINGLE_CTA, search_algo::MULTI_CTA},  // algo
-  {0},                                                // max_queries
-  {0},                                                // team_size
-  {512},                                              // itopk_size
-  {1},                                                // search_width
-  {raft::distance::DistanceType::L2Expanded},         // metric
-  {false},                                            // host_dataset
-  {true},                                             // include_serialized_dataset
-  {0.8}                                               // min_recall
+  {100},                                                                         // n_queries
+  {1000, 10000},                                                                 // n_rows
+  {128, 132, 192, 256, 512, 768},                                                // dim
+  {8, 12},                                                                       // k
+  {2, 4},                                                                        // pq_len
+  {8},                                                                           // pq_bits
+  {graph_build_algo::NN_DESCENT},                                                // build_algo
+  {search_algo::SINGLE_CTA, search_algo::MULTI_CTA, search_algo::MULTI_KERNEL},  // algo
+  {0},                                                                           // max_queries
+  {0},                                                                           // team_size
+  {512},                                                                         // itopk_size
+  {1},                                                                           // search_width
+  {raft::distance::DistanceType::L2Expanded},                                    // metric
+  {false},                                                                       // host_dataset
+  {true},  // include_serialized_dataset
+  {0.8}    // min_recall
 );
 
 }  // namespace raft::neighbors::cagra
@@ -29,7 +29,9 @@
 #include <raft/distance/distance_types.hpp>
 #include <raft/linalg/map.cuh>
 #include <raft/matrix/gather.cuh>
+#include <raft/neighbors/attribute_filter.cuh>
 #include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_flat_build_streaming.cuh>
 #include <raft/neighbors/ivf_flat_helpers.cuh>
 #include <raft/neighbors/ivf_flat_types.hpp>
 #include <raft/neighbors/ivf_list.hpp>
@@ -53,6 +55,7 @@
 #include <gtest/gtest.h>
 
 #include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -265,6 +268,34 @@ class AnnIVFFlatTest : public ::testing::TestWithParam<AnnIvfFlatInputs<IdxT>> {
         update_host(indices_ivfflat.data(), indices_ivfflat_dev.data(), queries_size, stream_);
         resource::sync_stream(handle_);
 
+        if (ps.host_dataset) {
+          // The host queries must give the same neighbors as the device ones
+          auto host_queries = raft::make_host_matrix<DataT, IdxT>(ps.num_queries, ps.dim);
+          auto host_indices = raft::make_host_matrix<IdxT, IdxT>(ps.num_queries, ps.k);
+          auto host_dists   = raft::make_host_matrix<T, IdxT>(ps.num_queries, ps.k);
+          raft::copy(
+            host_queries.data_handle(), search_queries.data(), ps.num_queries * ps.dim, stream_);
+          resource::sync_stream(handle_);
+          ivf_flat::search(handle_,
+                           search_params,
+                           index_loaded,
+                           raft::make_const_mdspan(host_queries.view()),
+                           host_indices.view(),
+                           host_dists.view());
+          std::vector<IdxT> indices_host(host_indices.data_handle(),
+                                         host_indices.data_handle() + queries_size);
+          std::vector<T> distances_host(host_dists.data_handle(),
+                                        host_dists.data_handle() + queries_size);
+          ASSERT_TRUE(eval_neighbours(indices_ivfflat,
+                                      indices_host,
+                                      distances_ivfflat,
+                                      distances_host,
+                                      ps.num_queries,
+                                      ps.k,
+                                      0.001,
+                                      0.99));
+        }
+
         // Test the centroid invariants
         if (index_2.adaptive_centers()) {
           // The centers must be up-to-date with the corresponding data
@@ -532,7 +563,282 @@ class AnnIVFFlatTest : public ::testing::TestWithParam<AnnIvfFlatInputs<IdxT>> {
         update_host(
           indices_ivfflat.data(), indices_ivfflat_dev.data_handle(), queries_size, stream_);
         resource::sync_stream(handle_);
+        ASSERT_TRUE(eval_neighbours(indices_naive,
+                                    indices_ivfflat,
+                                    distances_naive,
+                                    distances_ivfflat,
+                                    ps.num_queries,
+                                    ps.k,
+                                    0.001,
+                                    min_recall));
+
+        // The same samples removed by a predicate on the attributes: a "timestamp" growing with
+        // the sample id and a category, which every sample passes.
+        raft::neighbors::filtering::attribute_store attrs(handle_, ps.num_db_vecs, 2);
+        raft::linalg::map_offset(handle_, attrs.column(0), raft::mul_const_op<int64_t>(10));
+        raft::linalg::map_offset(handle_, attrs.column(1), raft::mod_const_op<int64_t>(4));
+        auto attr_filter = attrs.filter()
+                             .and_range(0,
+                                        int64_t(test_ivf_sample_filter::offset) * 10,
+                                        std::numeric_limits<int64_t>::max())
+                             .and_categories(1, {0, 1, 2, 3});
+        ivf_flat::search_with_filtering(handle_,
+                                        search_params,
+                                        index,
+                                        search_queries_view,
+                                        indices_ivfflat_dev.view(),
+                                        distances_ivfflat_dev.view(),
+                                        attr_filter);
+
+        update_host(
+          distances_ivfflat.data(), distances_ivfflat_dev.data_handle(), queries_size, stream_);
+        update_host(
+          indices_ivfflat.data(), indices_ivfflat_dev.data_handle(), queries_size, stream_);
+        resource::sync_stream(handle_);
+        ASSERT_TRUE(eval_neighbours(indices_naive,
+                                    indices_ivfflat,
+                                    distances_naive,
+                                    distances_ivfflat,
+                                    ps.num_queries,
+                                    ps.k,
+                                    0.001,
+                                    min_recall));
+      }
+    }
+  }
+
+  /** Search the float data stored in the half and in the scalar-quantized int8 indices. */
+  void testCompressedStorage()
+  {
+    if constexpr (std::is_same_v<DataT, float>) {
+      size_t queries_size = ps.num_queries * ps.k;
+      std::vector<IdxT> indices_naive(queries_size);
+      std::vector<T> distances_naive(queries_size);
+      {
+        rmm::device_uvector<T> distances_naive_dev(queries_size, stream_);
+        rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+        naive_knn<T, DataT, IdxT>(handle_,
+                                  distances_naive_dev.data(),
+                                  indices_naive_dev.data(),
+                                  search_queries.data(),
+                                  database.data(),
+                                  ps.num_queries,
+                                  ps.num_db_vecs,
+                                  ps.dim,
+                                  ps.k,
+                                  ps.metric);
+        update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+        update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+        resource::sync_stream(handle_);
       }
+      double min_recall = static_cast<double>(ps.nprobe) / static_cast<double>(ps.nlist);
+
+      ivf_flat::index_params index_params;
+      ivf_flat::search_params search_params;
+      index_params.n_lists          = ps.nlist;
+      index_params.metric           = ps.metric;
+      index_params.adaptive_centers = ps.adaptive_centers;
+      search_params.n_probes        = ps.nprobe;
+
+      auto database_view = raft::make_device_matrix_view<const float, IdxT>(
+        database.data(), ps.num_db_vecs, ps.dim);
+      auto queries_view = raft::make_device_matrix_view<const float, IdxT>(
+        search_queries.data(), ps.num_queries, ps.dim);
+      auto indices_dev   = raft::make_device_matrix<IdxT, IdxT>(handle_, ps.num_queries, ps.k);
+      auto distances_dev = raft::make_device_matrix<T, IdxT>(handle_, ps.num_queries, ps.k);
+      std::vector<IdxT> indices_ivfflat(queries_size);
+      std::vector<T> distances_ivfflat(queries_size);
+
+      // fp16 storage
+      {
+        auto database_half = raft::make_device_matrix<half, IdxT>(handle_, ps.num_db_vecs, ps.dim);
+        auto queries_half  = raft::make_device_matrix<half, IdxT>(handle_, ps.num_queries, ps.dim);
+        raft::linalg::map(handle_, database_half.view(), raft::cast_op<half>{}, database_view);
+        raft::linalg::map(handle_, queries_half.view(), raft::cast_op<half>{}, queries_view);
+        auto index =
+          ivf_flat::build(handle_, index_params, raft::make_const_mdspan(database_half.view()));
+        ivf_flat::search(handle_,
+                         search_params,
+                         index,
+                         raft::make_const_mdspan(queries_half.view()),
+                         indices_dev.view(),
+                         distances_dev.view());
+        update_host(distances_ivfflat.data(), distances_dev.data_handle(), queries_size, stream_);
+        update_host(indices_ivfflat.data(), indices_dev.data_handle(), queries_size, stream_);
+        resource::sync_stream(handle_);
+        ASSERT_TRUE(eval_neighbours(indices_naive,
+                                    indices_ivfflat,
+                                    distances_naive,
+                                    distances_ivfflat,
+                                    ps.num_queries,
+                                    ps.k,
+                                    0.01,
+                                    min_recall));
+      }
+
+      // int8 storage; the quantizer preserves the L2 distances only
+      if (ps.metric != raft::distance::DistanceType::InnerProduct) {
+        auto quantizer = ivf_flat::helpers::train_scalar_quantizer(handle_, database_view);
+        auto database_int8 =
+          raft::make_device_matrix<int8_t, IdxT>(handle_, ps.num_db_vecs, ps.dim);
+        auto queries_int8 =
+          raft::make_device_matrix<int8_t, IdxT>(handle_, ps.num_queries, ps.dim);
+        ivf_flat::helpers::scalar_quantize(handle_, quantizer, database_view, database_int8.view());
+        ivf_flat::helpers::scalar_quantize(handle_, quantizer, queries_view, queries_int8.view());
+        auto index =
+          ivf_flat::build(handle_, index_params, raft::make_const_mdspan(database_int8.view()));
+        ivf_flat::search(handle_,
+                         search_params,
+                         index,
+                         raft::make_const_mdspan(queries_int8.view()),
+                         indices_dev.view(),
+                         distances_dev.view());
+        update_host(distances_ivfflat.data(), distances_dev.data_handle(), queries_size, stream_);
+        update_host(indices_ivfflat.data(), indices_dev.data_handle(), queries_size, stream_);
+        resource::sync_stream(handle_);
+        const bool is_sqrt = ps.metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                             ps.metric == raft::distance::DistanceType::L2SqrtUnexpanded;
+        const T scale = is_sqrt ? quantizer.scale : quantizer.scale * quantizer.scale;
+        for (auto& d : distances_ivfflat) {
+          d *= scale;
+        }
+        ASSERT_TRUE(eval_neighbours(indices_naive,
+                                    indices_ivfflat,
+                                    distances_naive,
+                                    distances_ivfflat,
+                                    ps.num_queries,
+                                    ps.k,
+                                    0.05,
+                                    min_recall));
+      }
+    }
+  }
+
+  /** Search the index with the list scan grouping the queries by the probed lists. */
+  void testGemmScan()
+  {
+    size_t queries_size = ps.num_queries * ps.k;
+    std::vector<IdxT> indices_ivfflat(queries_size);
+    std::vector<IdxT> indices_naive(queries_size);
+    std::vector<T> distances_ivfflat(queries_size);
+    std::vector<T> distances_naive(queries_size);
+
+    {
+      rmm::device_uvector<T> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+      naive_knn<T, DataT, IdxT>(handle_,
+                                distances_naive_dev.data(),
+                                indices_naive_dev.data(),
+                                search_queries.data(),
+                                database.data(),
+                                ps.num_queries,
+                                ps.num_db_vecs,
+                                ps.dim,
+                                ps.k,
+                                ps.metric);
+      update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    double min_recall = static_cast<double>(ps.nprobe) / static_cast<double>(ps.nlist);
+
+    ivf_flat::index_params index_params;
+    ivf_flat::search_params search_params;
+    index_params.n_lists          = ps.nlist;
+    index_params.metric           = ps.metric;
+    index_params.adaptive_centers = ps.adaptive_centers;
+    search_params.n_probes        = ps.nprobe;
+    search_params.scan_algo       = ivf_flat::list_scan_algo::GEMM;
+
+    auto database_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      (const DataT*)database.data(), ps.num_db_vecs, ps.dim);
+    auto index = ivf_flat::build(handle_, index_params, database_view);
+
+    auto search_queries_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      search_queries.data(), ps.num_queries, ps.dim);
+    auto distances_ivfflat_dev = raft::make_device_matrix<T, IdxT>(handle_, ps.num_queries, ps.k);
+    auto indices_ivfflat_dev = raft::make_device_matrix<IdxT, IdxT>(handle_, ps.num_queries, ps.k);
+    ivf_flat::search(handle_,
+                     search_params,
+                     index,
+                     search_queries_view,
+                     indices_ivfflat_dev.view(),
+                     distances_ivfflat_dev.view());
+    update_host(
+      distances_ivfflat.data(), distances_ivfflat_dev.data_handle(), queries_size, stream_);
+    update_host(indices_ivfflat.data(), indices_ivfflat_dev.data_handle(), queries_size, stream_);
+    resource::sync_stream(handle_);
+
+    ASSERT_TRUE(eval_neighbours(indices_naive,
+                                indices_ivfflat,
+                                distances_naive,
+                                distances_ivfflat,
+                                ps.num_queries,
+                                ps.k,
+                                0.001,
+                                min_recall));
+  }
+
+  /** Search with the adaptive probing, which probes at least half of `ps.nprobe` clusters. */
+  void testAdaptiveProbing()
+  {
+    size_t queries_size = ps.num_queries * ps.k;
+    std::vector<IdxT> indices_ivfflat(queries_size);
+    std::vector<IdxT> indices_naive(queries_size);
+    std::vector<T> distances_ivfflat(queries_size);
+    std::vector<T> distances_naive(queries_size);
+
+    {
+      rmm::device_uvector<T> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+      naive_knn<T, DataT, IdxT>(handle_,
+                                distances_naive_dev.data(),
+                                indices_naive_dev.data(),
+                                search_queries.data(),
+                                database.data(),
+                                ps.num_queries,
+                                ps.num_db_vecs,
+                                ps.dim,
+                                ps.k,
+                                ps.metric);
+      update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    ivf_flat::index_params index_params;
+    ivf_flat::search_params search_params;
+    index_params.n_lists                             = ps.nlist;
+    index_params.metric                              = ps.metric;
+    index_params.adaptive_centers                    = ps.adaptive_centers;
+    search_params.n_probes                           = ps.nprobe;
+    search_params.adaptive_probes.max_distance_ratio = 2.0f;
+    search_params.adaptive_probes.min_probes         = std::max<uint32_t>(1, ps.nprobe / 2);
+    double min_recall =
+      static_cast<double>(search_params.adaptive_probes.min_probes) / static_cast<double>(ps.nlist);
+
+    auto database_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      (const DataT*)database.data(), ps.num_db_vecs, ps.dim);
+    auto index = ivf_flat::build(handle_, index_params, database_view);
+
+    auto search_queries_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      search_queries.data(), ps.num_queries, ps.dim);
+    auto distances_ivfflat_dev = raft::make_device_matrix<T, IdxT>(handle_, ps.num_queries, ps.k);
+    auto indices_ivfflat_dev = raft::make_device_matrix<IdxT, IdxT>(handle_, ps.num_queries, ps.k);
+    for (auto scan_algo : {ivf_flat::list_scan_algo::INTERLEAVED, ivf_flat::list_scan_algo::GEMM}) {
+      search_params.scan_algo = scan_algo;
+      ivf_flat::search(handle_,
+                       search_params,
+                       index,
+                       search_queries_view,
+                       indices_ivfflat_dev.view(),
+                       distances_ivfflat_dev.view());
+      update_host(
+        distances_ivfflat.data(), distances_ivfflat_dev.data_handle(), queries_size, stream_);
+      update_host(indices_ivfflat.data(), indices_ivfflat_dev.data_handle(), queries_size, stream_);
+      resource::sync_stream(handle_);
+
       ASSERT_TRUE(eval_neighbours(indices_naive,
                                   indices_ivfflat,
                                   distances_naive,
@@ -544,6 +850,165 @@ class AnnIVFFlatTest : public ::testing::TestWithParam<AnnIvfFlatInputs<IdxT>> {
     }
   }
 
+  /** Build the index from a host dataset read in several chunks. */
+  void testBuildStreaming()
+  {
+    size_t queries_size = ps.num_queries * ps.k;
+    std::vector<IdxT> indices_ivfflat(queries_size);
+    std::vector<IdxT> indices_naive(queries_size);
+    std::vector<T> distances_ivfflat(queries_size);
+    std::vector<T> distances_naive(queries_size);
+
+    {
+      rmm::device_uvector<T> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+      naive_knn<T, DataT, IdxT>(handle_,
+                                distances_naive_dev.data(),
+                                indices_naive_dev.data(),
+                                search_queries.data(),
+                                database.data(),
+                                ps.num_queries,
+                                ps.num_db_vecs,
+                                ps.dim,
+                                ps.k,
+                                ps.metric);
+      update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    double min_recall = static_cast<double>(ps.nprobe) / static_cast<double>(ps.nlist);
+
+    ivf_flat::index_params index_params;
+    ivf_flat::search_params search_params;
+    index_params.n_lists          = ps.nlist;
+    index_params.metric           = ps.metric;
+    index_params.adaptive_centers = ps.adaptive_centers;
+    search_params.n_probes        = ps.nprobe;
+
+    std::vector<DataT> database_host(size_t(ps.num_db_vecs) * ps.dim);
+    update_host(database_host.data(), database.data(), database_host.size(), stream_);
+    resource::sync_stream(handle_);
+    IdxT n_rows_read = 0;
+    auto read_rows   = [&](DataT* dst, IdxT offset, IdxT n_rows) {
+      n_rows_read += n_rows;
+      std::memcpy(dst,
+                  database_host.data() + size_t(offset) * ps.dim,
+                  sizeof(DataT) * size_t(n_rows) * ps.dim);
+    };
+    IdxT chunk_rows = raft::div_rounding_up_safe<IdxT>(ps.num_db_vecs, 3);
+    auto index      = ivf_flat::build_streaming<DataT, IdxT>(
+      handle_, index_params, read_rows, IdxT(ps.num_db_vecs), uint32_t(ps.dim), chunk_rows);
+    ASSERT_EQ(index.size(), IdxT(ps.num_db_vecs));
+    // The trainset and the whole dataset
+    ASSERT_GT(n_rows_read, IdxT(ps.num_db_vecs));
+
+    auto search_queries_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      search_queries.data(), ps.num_queries, ps.dim);
+    auto distances_ivfflat_dev = raft::make_device_matrix<T, IdxT>(handle_, ps.num_queries, ps.k);
+    auto indices_ivfflat_dev = raft::make_device_matrix<IdxT, IdxT>(handle_, ps.num_queries, ps.k);
+    ivf_flat::search(handle_,
+                     search_params,
+                     index,
+                     search_queries_view,
+                     indices_ivfflat_dev.view(),
+                     distances_ivfflat_dev.view());
+    update_host(
+      distances_ivfflat.data(), distances_ivfflat_dev.data_handle(), queries_size, stream_);
+    update_host(indices_ivfflat.data(), indices_ivfflat_dev.data_handle(), queries_size, stream_);
+    resource::sync_stream(handle_);
+
+    ASSERT_TRUE(eval_neighbours(indices_naive,
+                                indices_ivfflat,
+                                distances_naive,
+                                distances_ivfflat,
+                                ps.num_queries,
+                                ps.k,
+                                0.001,
+                                min_recall));
+  }
+
+  /** Remove the first records from the index and search the rest of them. */
+  void testRemove()
+  {
+    size_t queries_size = ps.num_queries * ps.k;
+    std::vector<IdxT> indices_ivfflat(queries_size);
+    std::vector<IdxT> indices_naive(queries_size);
+    std::vector<T> distances_ivfflat(queries_size);
+    std::vector<T> distances_naive(queries_size);
+    const IdxT n_removed = test_ivf_sample_filter::offset;
+
+    {
+      rmm::device_uvector<T> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+      naive_knn<T, DataT, IdxT>(handle_,
+                                distances_naive_dev.data(),
+                                indices_naive_dev.data(),
+                                search_queries.data(),
+                                database.data() + n_removed * ps.dim,
+                                ps.num_queries,
+                                ps.num_db_vecs - n_removed,
+                                ps.dim,
+                                ps.k,
+                                ps.metric);
+      raft::linalg::addScalar(
+        indices_naive_dev.data(), indices_naive_dev.data(), n_removed, queries_size, stream_);
+      update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    double min_recall = static_cast<double>(ps.nprobe) / static_cast<double>(ps.nlist);
+
+    ivf_flat::index_params index_params;
+    ivf_flat::search_params search_params;
+    index_params.n_lists          = ps.nlist;
+    index_params.metric           = ps.metric;
+    index_params.adaptive_centers = ps.adaptive_centers;
+    search_params.n_probes        = ps.nprobe;
+
+    auto database_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      (const DataT*)database.data(), ps.num_db_vecs, ps.dim);
+    auto index = ivf_flat::build(handle_, index_params, database_view);
+
+    // Remove the first half of the ids, then all of them: the ones removed already are ignored.
+    auto ids = raft::make_device_vector<IdxT, IdxT>(handle_, n_removed);
+    thrust::sequence(resource::get_thrust_policy(handle_),
+                     thrust::device_pointer_cast(ids.data_handle()),
+                     thrust::device_pointer_cast(ids.data_handle() + n_removed));
+    auto half_ids =
+      raft::make_device_vector_view<const IdxT, IdxT>(ids.data_handle(), n_removed / 2);
+    ASSERT_EQ(ivf_flat::remove(handle_, half_ids, &index), n_removed / 2);
+    ASSERT_EQ(ivf_flat::remove(handle_, raft::make_const_mdspan(ids.view()), &index),
+              n_removed - n_removed / 2);
+    ASSERT_EQ(index.size(), ps.num_db_vecs - n_removed);
+
+    auto search_queries_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      search_queries.data(), ps.num_queries, ps.dim);
+    auto distances_ivfflat_dev = raft::make_device_matrix<T, IdxT>(handle_, ps.num_queries, ps.k);
+    auto indices_ivfflat_dev =
+      raft::make_device_matrix<IdxT, IdxT>(handle_, ps.num_queries, ps.k);
+    ivf_flat::search(handle_,
+                     search_params,
+                     index,
+                     search_queries_view,
+                     indices_ivfflat_dev.view(),
+                     distances_ivfflat_dev.view());
+    update_host(
+      distances_ivfflat.data(), distances_ivfflat_dev.data_handle(), queries_size, stream_);
+    update_host(indices_ivfflat.data(), indices_ivfflat_dev.data_handle(), queries_size, stream_);
+    resource::sync_stream(handle_);
+
+    ASSERT_TRUE(eval_neighbours(indices_naive,
+                                indices_ivfflat,
+                                distances_naive,
+                                distances_ivfflat,
+                                ps.num_queries,
+                                ps.k,
+                                0.001,
+                                min_recall));
+  }
+
   void SetUp() override
   {
     database.resize(ps.num_db_vecs * ps.dim, stream_);
@@ -599,6 +1064,17 @@ const std::vector<AnnIvfFlatInputs<int64_t>> inputs = {
   {1000, 10000, 2053, 16, 40, 1024, raft::distance::DistanceType::L2Expanded, true},
   {1000, 10000, 2056, 16, 40, 1024, raft::distance::DistanceType::L2Expanded, true},
 
+  // test dims with the compile-time specializations of the interleaved scan
+  {1000, 10000, 96, 16, 40, 1024, raft::distance::DistanceType::L2Expanded, false},
+  {1000, 10000, 128, 16, 40, 1024, raft::distance::DistanceType::L2Expanded, false},
+  {1000, 10000, 128, 16, 40, 1024, raft::distance::DistanceType::InnerProduct, true},
+  {1000, 10000, 384, 16, 40, 1024, raft::distance::DistanceType::InnerProduct, false},
+  {1000, 10000, 768, 16, 40, 1024, raft::distance::DistanceType::L2SqrtExpanded, false},
+  {1000, 10000, 1024, 16, 40, 1024, raft::distance::DistanceType::InnerProduct, false},
+  {1000, 10000, 1536, 16, 40, 1024, raft::distance::DistanceType::L2Expanded, true},
+  {1000, 10000, 1536, 16, 40, 1024, raft::distance::DistanceType::InnerProduct, false},
+  {1000, 10000, 1536, 300, 40, 1024, raft::distance::DistanceType::L2Expanded, false},
+
   // various random combinations
   {1000, 10000, 16, 10, 40, 1024, raft::distance::DistanceType::L2Expanded, false},
   {1000, 10000, 16, 10, 50, 1024, raft::distance::DistanceType::L2Expanded, false},
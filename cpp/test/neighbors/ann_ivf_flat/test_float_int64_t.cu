@@ -25,6 +25,11 @@ TEST_P(AnnIVFFlatTestF, AnnIVFFlat)
 {
   this->testIVFFlat();
   this->testPacker();
+  this->testGemmScan();
+  this->testAdaptiveProbing();
+  this->testBuildStreaming();
+  this->testRemove();
+  this->testCompressedStorage();
 }
 
 INSTANTIATE_TEST_CASE_P(AnnIVFFlatTest, AnnIVFFlatTestF, ::testing::ValuesIn(inputs));
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "ann_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_flat_host.hpp>
+#include <raft/neighbors/ivf_flat_serialize.cuh>
+#include <raft/neighbors/ivf_pq.cuh>
+#include <raft/neighbors/ivf_pq_host.hpp>
+#include <raft/neighbors/ivf_pq_serialize.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+namespace raft::neighbors {
+
+struct IvfHostInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  uint32_t dim;
+  uint32_t k;
+  uint32_t n_lists;
+  uint32_t n_probes;
+  uint32_t pq_bits;
+  raft::distance::DistanceType metric;
+};
+
+inline auto operator<<(std::ostream& os, const IvfHostInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", dim=" << p.dim
+     << ", k=" << p.k << ", n_lists=" << p.n_lists << ", n_probes=" << p.n_probes
+     << ", pq_bits=" << p.pq_bits << ", metric=" << static_cast<int>(p.metric) << "}";
+  return os;
+}
+
+/** The host search of a serialized GPU index must find the same neighbors as the GPU search. */
+class IvfHostTest : public ::testing::TestWithParam<IvfHostInputs> {
+ public:
+  IvfHostTest()
+    : params_(::testing::TestWithParam<IvfHostInputs>::GetParam()),
+      stream_(resource::get_cuda_stream(handle_)),
+      dataset_(raft::make_device_matrix<float, int64_t>(handle_, params_.n_rows, params_.dim)),
+      queries_(raft::make_device_matrix<float, int64_t>(handle_, params_.n_queries, params_.dim)),
+      queries_h_(raft::make_host_matrix<float, int64_t>(params_.n_queries, params_.dim))
+  {
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, dataset_.data_handle(), dataset_.size(), -1.0f, 1.0f);
+    raft::random::uniform(handle_, rng, queries_.data_handle(), queries_.size(), -1.0f, 1.0f);
+    raft::copy(queries_h_.data_handle(), queries_.data_handle(), queries_.size(), stream_);
+    resource::sync_stream(handle_);
+  }
+
+ protected:
+  template <typename SearchGpu, typename SearchHost>
+  void compare(SearchGpu search_gpu, SearchHost search_host)
+  {
+    auto n_queries   = params_.n_queries;
+    auto k           = params_.k;
+    auto neighbors   = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances   = raft::make_device_matrix<float, int64_t>(handle_, n_queries, k);
+    auto neighbors_h = raft::make_host_matrix<int64_t, int64_t>(n_queries, k);
+    auto distances_h = raft::make_host_matrix<float, int64_t>(n_queries, k);
+    search_gpu(neighbors.view(), distances.view());
+    search_host(neighbors_h.view(), distances_h.view());
+
+    std::vector<int64_t> expected_idx(neighbors.size());
+    std::vector<float> expected_dist(distances.size());
+    raft::copy(expected_idx.data(), neighbors.data_handle(), neighbors.size(), stream_);
+    raft::copy(expected_dist.data(), distances.data_handle(), distances.size(), stream_);
+    resource::sync_stream(handle_);
+    std::vector<int64_t> actual_idx(neighbors_h.data_handle(),
+                                    neighbors_h.data_handle() + neighbors_h.size());
+    std::vector<float> actual_dist(distances_h.data_handle(),
+                                   distances_h.data_handle() + distances_h.size());
+    ASSERT_TRUE(eval_neighbours(
+      expected_idx, actual_idx, expected_dist, actual_dist, n_queries, k, 0.001, 0.99));
+  }
+
+  void testFlat()
+  {
+    ivf_flat::index_params index_params;
+    index_params.n_lists = params_.n_lists;
+    index_params.metric  = params_.metric;
+    auto idx = ivf_flat::build(handle_, index_params, raft::make_const_mdspan(dataset_.view()));
+    std::stringstream ss;
+    ivf_flat::serialize(handle_, ss, idx);
+    auto host_idx = ivf_flat::host::deserialize<float, int64_t>(ss);
+    ASSERT_EQ(host_idx.n_lists(), params_.n_lists);
+    ASSERT_EQ(host_idx.size, params_.n_rows);
+
+    ivf_flat::search_params search_params;
+    search_params.n_probes = params_.n_probes;
+    compare(
+      [&](auto neighbors, auto distances) {
+        ivf_flat::search(handle_,
+                         search_params,
+                         idx,
+                         raft::make_const_mdspan(queries_.view()),
+                         neighbors,
+                         distances);
+      },
+      [&](auto neighbors, auto distances) {
+        ivf_flat::host::search(search_params,
+                               host_idx,
+                               raft::make_const_mdspan(queries_h_.view()),
+                               neighbors,
+                               distances);
+      });
+  }
+
+  void testPq()
+  {
+    ivf_pq::index_params index_params;
+    index_params.n_lists = params_.n_lists;
+    index_params.metric  = params_.metric;
+    index_params.pq_bits = params_.pq_bits;
+    auto idx = ivf_pq::build(handle_, index_params, raft::make_const_mdspan(dataset_.view()));
+    std::stringstream ss;
+    ivf_pq::serialize(handle_, ss, idx);
+    auto host_idx = ivf_pq::host::deserialize<int64_t>(ss);
+    ASSERT_EQ(host_idx.n_lists(), params_.n_lists);
+    ASSERT_EQ(host_idx.rot_dim(), idx.rot_dim());
+
+    ivf_pq::search_params search_params;
+    search_params.n_probes                = params_.n_probes;
+    search_params.lut_dtype               = CUDA_R_32F;
+    search_params.internal_distance_dtype = CUDA_R_32F;
+    compare(
+      [&](auto neighbors, auto distances) {
+        ivf_pq::search(handle_,
+                       search_params,
+                       idx,
+                       raft::make_const_mdspan(queries_.view()),
+                       neighbors,
+                       distances);
+      },
+      [&](auto neighbors, auto distances) {
+        ivf_pq::host::search(search_params,
+                             host_idx,
+                             raft::make_const_mdspan(queries_h_.view()),
+                             neighbors,
+                             distances);
+      });
+  }
+
+  raft::resources handle_;
+  IvfHostInputs params_;
+  rmm::cuda_stream_view stream_;
+  raft::device_matrix<float, int64_t> dataset_;
+  raft::device_matrix<float, int64_t> queries_;
+  raft::host_matrix<float, int64_t> queries_h_;
+};
+
+const std::vector<IvfHostInputs> inputs = {
+  {5000, 100, 16, 10, 32, 8, 8, raft::distance::DistanceType::L2Expanded},
+  {5000, 100, 64, 32, 64, 16, 8, raft::distance::DistanceType::L2SqrtExpanded},
+  {5000, 100, 100, 10, 50, 50, 5, raft::distance::DistanceType::L2Expanded},
+  {3000, 50, 33, 20, 16, 4, 7, raft::distance::DistanceType::InnerProduct},
+  {2000, 20, 128, 64, 20, 20, 4, raft::distance::DistanceType::InnerProduct}};
+
+TEST_P(IvfHostTest, Flat) { this->testFlat(); }
+TEST_P(IvfHostTest, Pq) { this->testPq(); }
+INSTANTIATE_TEST_CASE_P(IvfHostTest, IvfHostTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors
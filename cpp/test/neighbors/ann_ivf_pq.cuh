@@ -26,12 +26,15 @@
 #include <raft/matrix/gather.cuh>
 #include <raft/neighbors/ivf_pq.cuh>
 #include <raft/neighbors/ivf_pq_helpers.cuh>
+#include <raft/neighbors/ivf_pq_refine_host.cuh>
 #include <raft/neighbors/ivf_pq_serialize.cuh>
+#include <raft/neighbors/ivf_pq_sharded.cuh>
 #include <raft/neighbors/sample_filter.cuh>
 #include <raft/random/rng.cuh>
 
 #include <raft_internal/neighbors/naive_knn.cuh>
 
+#include <rmm/cuda_stream.hpp>
 #include <rmm/cuda_stream_view.hpp>
 #include <rmm/device_buffer.hpp>
 #include <rmm/device_vector.hpp>
@@ -45,7 +48,10 @@
 #include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <optional>
+#include <utility>
 #include <vector>
 
 namespace raft::neighbors::ivf_pq {
@@ -112,6 +118,8 @@ inline auto operator<<(std::ostream& os, const ivf_pq_inputs& p) -> std::ostream
   PRINT_DIFF(.index_params.pq_dim);
   PRINT_DIFF(.index_params.codebook_kind);
   PRINT_DIFF(.index_params.force_random_rotation);
+  PRINT_DIFF(.index_params.opq_n_iters);
+  PRINT_DIFF(.index_params.anisotropic_quantization_threshold);
   PRINT_DIFF(.search_params.n_probes);
   PRINT_DIFF_V(.search_params.lut_dtype, print_dtype{p.search_params.lut_dtype});
   PRINT_DIFF_V(.search_params.internal_distance_dtype,
@@ -253,6 +261,63 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     return idx;
   }
 
+  auto build_versioned_extends()
+  {
+    auto db_indices = make_device_vector<IdxT>(handle_, ps.num_db_vecs);
+    linalg::map_offset(handle_, db_indices.view(), identity_op{});
+    resource::sync_stream(handle_);
+    auto size_1 = IdxT(ps.num_db_vecs) / 2;
+    auto size_2 = IdxT(ps.num_db_vecs) - size_1;
+    auto vecs_1 = database.data();
+    auto vecs_2 = database.data() + size_t(size_1) * size_t(ps.dim);
+    auto inds_1 = db_indices.data_handle();
+    auto inds_2 = db_indices.data_handle() + size_t(size_1);
+
+    auto ipams              = ps.index_params;
+    ipams.add_data_on_build = false;
+
+    auto database_view =
+      raft::make_device_matrix_view<const DataT, IdxT>(database.data(), ps.num_db_vecs, ps.dim);
+    ivf_pq::versioned_index<IdxT> idx(ivf_pq::build<DataT, IdxT>(handle_, ipams, database_view));
+
+    auto vecs_1_view = raft::make_device_matrix_view<const DataT, IdxT>(vecs_1, size_1, ps.dim);
+    auto inds_1_view = raft::make_device_vector_view<const IdxT, IdxT>(inds_1, size_1);
+    ivf_pq::extend<DataT, IdxT>(handle_, vecs_1_view, inds_1_view, &idx);
+    auto first = idx.snapshot();
+
+    // Ingest the second half on a side stream; the older snapshot must stay intact.
+    raft::resources side_handle;
+    resource::set_cuda_stream(side_handle, side_stream_.view());
+    auto vecs_2_view = raft::make_device_matrix_view<const DataT, IdxT>(vecs_2, size_2, ps.dim);
+    auto inds_2_view = raft::make_device_vector_view<const IdxT, IdxT>(inds_2, size_2);
+    ivf_pq::extend<DataT, IdxT>(side_handle, vecs_2_view, inds_2_view, &idx);
+
+    EXPECT_EQ(first->size(), size_1);
+    EXPECT_EQ(idx.snapshot()->size(), IdxT(ps.num_db_vecs));
+    return ivf_pq::detail::clone(handle_, *idx.snapshot());
+  }
+
+  auto build_rebalanced()
+  {
+    auto index = build_only();
+    ivf_pq::rebalance_params params;
+    params.max_list_size_ratio = 1.5;
+    params.min_list_size_ratio = 0.5;
+    auto imbalance_before      = ivf_pq::helpers::stats(handle_, index).imbalance_factor;
+    auto n_splits              = ivf_pq::rebalance(handle_, params, &index);
+    auto s                     = ivf_pq::helpers::stats(handle_, index);
+    EXPECT_EQ(index.size(), IdxT(ps.num_db_vecs));
+    if (n_splits > 0) { EXPECT_LE(s.imbalance_factor, imbalance_before * 1.01); }
+    return index;
+  }
+
+  auto build_host_lists()
+  {
+    auto index = build_only();
+    ivf_pq::helpers::move_lists_to_host(handle_, &index);
+    return index;
+  }
+
   auto build_serialize()
   {
     ivf_pq::serialize<IdxT>(handle_, "ivf_pq_index", build_only());
@@ -288,6 +353,31 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     compare_vectors_l2(handle_, rec_data.view(), orig_data.view(), label, compression_ratio, 0.06);
   }
 
+  void check_stats(const index<IdxT>& index, double compression_ratio)
+  {
+    auto database_view =
+      raft::make_device_matrix_view<const DataT, IdxT>(database.data(), ps.num_db_vecs, ps.dim);
+    auto s = ivf_pq::helpers::stats(handle_, index, std::make_optional(database_view));
+
+    ASSERT_EQ(s.list_sizes.size(), index.n_lists());
+    ASSERT_EQ(s.list_reconstruction_mse.size(), index.n_lists());
+    ASSERT_EQ(std::accumulate(s.list_sizes.begin(), s.list_sizes.end(), IdxT{0}), index.size());
+    ASSERT_EQ(std::accumulate(s.list_size_histogram.begin(), s.list_size_histogram.end(), 0u),
+              index.n_lists());
+    ASSERT_EQ(s.max_list_size, *std::max_element(s.list_sizes.begin(), s.list_sizes.end()));
+    if (index.size() == 0) { return; }
+    ASSERT_GE(s.imbalance_factor, 1.0 - 1e-6);
+    ASSERT_GE(s.expected_scan_per_probe, s.mean_list_size * (1.0 - 1e-6));
+    ASSERT_LE(s.expected_scan_per_probe, s.max_list_size * (1.0 + 1e-6));
+    // The mean error must satisfy the bound used for the individual vectors in
+    // `compare_vectors_l2`.
+    double max_rms = 1.2 * 0.06 * std::pow(2.0, compression_ratio);
+    for (uint32_t label = 0; label < index.n_lists(); label++) {
+      ASSERT_LE(std::sqrt(s.list_reconstruction_mse[label] / index.dim()), max_rms)
+        << " (label = " << label << ")";
+    }
+  }
+
   void check_reconstruct_extend(index<IdxT>* index, double compression_ratio, uint32_t label)
   {
     // NB: this is not reference, the list is retained; the index will have to create a new list on
@@ -466,6 +556,8 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     double compression_ratio =
       static_cast<double>(ps.dim * 8) / static_cast<double>(index.pq_dim() * index.pq_bits());
 
+    check_stats(index, compression_ratio);
+
     for (uint32_t label = 0; label < index.n_lists(); label++) {
       switch (label % 3) {
         case 0: {
@@ -559,6 +651,190 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     }
   }
 
+  void run_sharded()
+  {
+    // Shard the lists over all the devices, using at least two shards to exercise the merge.
+    int n_devices = 0;
+    RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+    std::vector<int> device_ids(std::max(n_devices, 2));
+    for (size_t i = 0; i < device_ids.size(); i++) {
+      device_ids[i] = i % n_devices;
+    }
+
+    auto ipams              = ps.index_params;
+    ipams.add_data_on_build = true;
+    auto database_host      = raft::make_host_matrix<DataT, IdxT>(ps.num_db_vecs, ps.dim);
+    raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
+    resource::sync_stream(handle_);
+    auto index = ivf_pq::build_sharded<DataT, IdxT>(
+      ipams, device_ids, raft::make_const_mdspan(database_host.view()));
+    ASSERT_EQ(index.n_shards(), device_ids.size());
+    ASSERT_EQ(index.size(), IdxT(ps.num_db_vecs));
+    for (size_t i = 0; i < index.n_shards(); i++) {
+      for (uint32_t label = 0; label < index.n_lists(); label++) {
+        const auto& list = index.shard(i).lists()[label];
+        if (index.list_owner(label) != i) { ASSERT_TRUE(!list || list->size.load() == 0); }
+      }
+    }
+
+    size_t queries_size = ps.num_queries * ps.k;
+    std::vector<IdxT> indices_ivf_pq(queries_size);
+    std::vector<EvalT> distances_ivf_pq(queries_size);
+
+    rmm::device_uvector<EvalT> distances_ivf_pq_dev(queries_size, stream_);
+    rmm::device_uvector<IdxT> indices_ivf_pq_dev(queries_size, stream_);
+
+    auto query_view = raft::make_device_matrix_view<const DataT, uint32_t>(
+      search_queries.data(), ps.num_queries, ps.dim);
+    auto inds_view = raft::make_device_matrix_view<IdxT, uint32_t>(
+      indices_ivf_pq_dev.data(), ps.num_queries, ps.k);
+    auto dists_view = raft::make_device_matrix_view<EvalT, uint32_t>(
+      distances_ivf_pq_dev.data(), ps.num_queries, ps.k);
+
+    ivf_pq::search_sharded<DataT, IdxT>(
+      handle_, ps.search_params, index, query_view, inds_view, dists_view);
+
+    update_host(distances_ivf_pq.data(), distances_ivf_pq_dev.data(), queries_size, stream_);
+    update_host(indices_ivf_pq.data(), indices_ivf_pq_dev.data(), queries_size, stream_);
+    resource::sync_stream(handle_);
+
+    const auto& shard_0      = index.shard(0);
+    double compression_ratio = static_cast<double>(ps.dim * 8) /
+                               static_cast<double>(shard_0.pq_dim() * shard_0.pq_bits());
+    double min_recall =
+      static_cast<double>(ps.search_params.n_probes) / static_cast<double>(ps.index_params.n_lists);
+    min_recall =
+      std::min(std::erfc(0.05 * compression_ratio / std::max(min_recall, 0.5)), min_recall);
+    min_recall = ps.min_recall.value_or(min_recall);
+
+    ASSERT_TRUE(eval_neighbours(indices_ref,
+                                indices_ivf_pq,
+                                distances_ref,
+                                distances_ivf_pq,
+                                ps.num_queries,
+                                ps.k,
+                                0.0001 * compression_ratio,
+                                min_recall))
+      << ps;
+  }
+
+  void run_refine_host()
+  {
+    if (ps.index_params.metric != distance::DistanceType::L2Expanded &&
+        ps.index_params.metric != distance::DistanceType::InnerProduct) {
+      GTEST_SKIP() << "The host refinement does not support the metric";
+    }
+    auto index = build_only();
+
+    auto database_host = raft::make_host_matrix<DataT, IdxT>(ps.num_db_vecs, ps.dim);
+    auto queries_host  = raft::make_host_matrix<DataT, IdxT>(ps.num_queries, ps.dim);
+    raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
+    raft::copy(queries_host.data_handle(), search_queries.data(), search_queries.size(), stream_);
+    resource::sync_stream(handle_);
+
+    size_t queries_size = ps.num_queries * ps.k;
+    std::vector<IdxT> indices_ivf_pq(queries_size);
+    std::vector<EvalT> distances_ivf_pq(queries_size);
+    // Use a few batches to exercise the double buffering.
+    uint32_t batch_size = raft::div_rounding_up_safe<uint32_t>(ps.num_queries, 3);
+    ivf_pq::search_refine_host<DataT, IdxT>(
+      handle_,
+      ps.search_params,
+      index,
+      raft::make_const_mdspan(database_host.view()),
+      raft::make_const_mdspan(queries_host.view()),
+      2 * ps.k,
+      raft::make_host_matrix_view<IdxT, IdxT>(indices_ivf_pq.data(), ps.num_queries, ps.k),
+      raft::make_host_matrix_view<EvalT, IdxT>(distances_ivf_pq.data(), ps.num_queries, ps.k),
+      batch_size);
+
+    // The refined distances are exact, and the recall is not worse than the one of the search.
+    double compression_ratio =
+      static_cast<double>(ps.dim * 8) / static_cast<double>(index.pq_dim() * index.pq_bits());
+    double min_recall =
+      static_cast<double>(ps.search_params.n_probes) / static_cast<double>(ps.index_params.n_lists);
+    min_recall =
+      std::min(std::erfc(0.05 * compression_ratio / std::max(min_recall, 0.5)), min_recall);
+    min_recall = ps.min_recall.value_or(min_recall);
+
+    ASSERT_TRUE(eval_neighbours(indices_ref,
+                                indices_ivf_pq,
+                                distances_ref,
+                                distances_ivf_pq,
+                                ps.num_queries,
+                                ps.k,
+                                0.0001,
+                                min_recall))
+      << ps;
+  }
+
+  /**
+   * Search with the adaptive probing, which probes between `min_probes` and `n_probes` clusters
+   * per query. The limits that never trigger must give the results of the fixed `n_probes`, and
+   * the limits that always trigger must give the results of the fixed `min_probes`.
+   */
+  void run_adaptive_probing()
+  {
+    auto index = build_only();
+
+    size_t queries_size = ps.num_queries * ps.k;
+    using result_t      = std::pair<std::vector<IdxT>, std::vector<EvalT>>;
+    auto search         = [&](const ivf_pq::search_params& params) -> result_t {
+      result_t res{std::vector<IdxT>(queries_size), std::vector<EvalT>(queries_size)};
+      rmm::device_uvector<EvalT> distances_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_dev(queries_size, stream_);
+      auto query_view = raft::make_device_matrix_view<const DataT, uint32_t>(
+        search_queries.data(), ps.num_queries, ps.dim);
+      auto inds_view =
+        raft::make_device_matrix_view<IdxT, uint32_t>(indices_dev.data(), ps.num_queries, ps.k);
+      auto dists_view =
+        raft::make_device_matrix_view<EvalT, uint32_t>(distances_dev.data(), ps.num_queries, ps.k);
+      ivf_pq::search<DataT, IdxT>(handle_, params, index, query_view, inds_view, dists_view);
+      update_host(res.first.data(), indices_dev.data(), queries_size, stream_);
+      update_host(res.second.data(), distances_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+      return res;
+    };
+    auto recall = [&](const result_t& res) {
+      return std::get<0>(calc_recall(indices_ref, res.first, ps.num_queries, ps.k));
+    };
+    auto same = [&](const result_t& res, const result_t& res_fixed) {
+      return eval_neighbours(res_fixed.first,
+                             res.first,
+                             res_fixed.second,
+                             res.second,
+                             ps.num_queries,
+                             ps.k,
+                             0.0001,
+                             0.99);
+    };
+
+    const uint32_t min_probes = std::max<uint32_t>(1, ps.search_params.n_probes / 4);
+    auto params_min           = ps.search_params;
+    params_min.n_probes       = min_probes;
+    auto res_max              = search(ps.search_params);
+    auto res_min              = search(params_min);
+
+    // The candidate budget is never reached: all the n_probes clusters are probed.
+    auto params                           = ps.search_params;
+    params.adaptive_probes.min_probes     = min_probes;
+    params.adaptive_probes.max_candidates = std::numeric_limits<uint32_t>::max();
+    ASSERT_TRUE(same(search(params), res_max)) << ps;
+
+    // Every cluster past the closest ones is too far: only min_probes clusters are probed.
+    params.adaptive_probes.max_candidates   = 1;
+    params.adaptive_probes.max_distance_gap = std::numeric_limits<float>::min();
+    ASSERT_TRUE(same(search(params), res_min)) << ps;
+
+    // In between, the recall lies between the ones of the fixed probing.
+    params.adaptive_probes.max_candidates     = 0;
+    params.adaptive_probes.max_distance_gap   = 0.0f;
+    params.adaptive_probes.max_distance_ratio = 2.0f;
+    auto res_adaptive                         = search(params);
+    ASSERT_GE(recall(res_adaptive), recall(res_min) - 0.01) << ps;
+    ASSERT_LE(recall(res_adaptive), recall(res_max) + 0.01) << ps;
+  }
+
   void SetUp() override  // NOLINT
   {
     gen_data();
@@ -576,6 +852,7 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
  private:
   raft::resources handle_;
   rmm::cuda_stream_view stream_;
+  rmm::cuda_stream side_stream_;
   ivf_pq_inputs ps;                           // NOLINT
   rmm::device_uvector<DataT> database;        // NOLINT
   rmm::device_uvector<DataT> search_queries;  // NOLINT
@@ -877,6 +1154,15 @@ inline auto enum_variety() -> test_cases_t
     x.index_params.force_random_rotation = false;
     x.min_recall                         = 0.86;
   });
+  ADD_CASE({
+    x.index_params.opq_n_iters = 4;
+    x.min_recall               = 0.86;
+  });
+  ADD_CASE({
+    x.index_params.opq_n_iters           = 4;
+    x.index_params.force_random_rotation = true;
+    x.min_recall                         = 0.86;
+  });
 
   ADD_CASE({
     x.search_params.lut_dtype = CUDA_R_32F;
@@ -915,7 +1201,7 @@ inline auto enum_variety_l2() -> test_cases_t
 
 inline auto enum_variety_ip() -> test_cases_t
 {
-  return map<ivf_pq_inputs>(enum_variety(), [](const ivf_pq_inputs& x) {
+  auto xs = map<ivf_pq_inputs>(enum_variety(), [](const ivf_pq_inputs& x) {
     ivf_pq_inputs y(x);
     if (y.min_recall.has_value()) {
       if (y.search_params.lut_dtype == CUDA_R_8U) {
@@ -931,6 +1217,21 @@ inline auto enum_variety_ip() -> test_cases_t
     y.index_params.metric = distance::DistanceType::InnerProduct;
     return y;
   });
+
+  // The anisotropic quantization loss is specific to the inner product.
+  ADD_CASE({
+    x.index_params.metric                             = distance::DistanceType::InnerProduct;
+    x.index_params.anisotropic_quantization_threshold = 0.2;
+    x.min_recall                                      = 0.8;
+  });
+  ADD_CASE({
+    x.index_params.metric                             = distance::DistanceType::InnerProduct;
+    x.index_params.codebook_kind                      = ivf_pq::codebook_gen::PER_CLUSTER;
+    x.index_params.anisotropic_quantization_threshold = 0.2;
+    x.min_recall                                      = 0.8;
+  });
+
+  return xs;
 }
 
 inline auto enum_variety_l2sqrt() -> test_cases_t
@@ -1040,6 +1341,29 @@ inline auto special_cases() -> test_cases_t
     x.search_params.n_probes     = 100;
   });
 
+  // Small batches select the clusters with a fused kernel.
+  ADD_CASE({
+    x.num_db_vecs                = 20000;
+    x.dim                        = 96;
+    x.num_queries                = 7;
+    x.k                          = 16;
+    x.index_params.metric        = distance::DistanceType::L2Expanded;
+    x.index_params.codebook_kind = ivf_pq::codebook_gen::PER_SUBSPACE;
+    x.index_params.n_lists       = 256;
+    x.search_params.n_probes     = 200;
+  });
+
+  ADD_CASE({
+    x.num_db_vecs                = 20000;
+    x.dim                        = 33;
+    x.num_queries                = 64;
+    x.k                          = 10;
+    x.index_params.metric        = distance::DistanceType::InnerProduct;
+    x.index_params.codebook_kind = ivf_pq::codebook_gen::PER_SUBSPACE;
+    x.index_params.n_lists       = 100;
+    x.search_params.n_probes     = 20;
+  });
+
   ADD_CASE({
     x.num_db_vecs                = 4335;
     x.dim                        = 4;
@@ -1066,6 +1390,16 @@ inline auto special_cases() -> test_cases_t
     x.search_params.n_probes     = 69;
   });
 
+  // 4-bit codes with a partially filled last chunk of 32 subspaces (warp-wide LUT lookups).
+  ADD_CASE({
+    x.dim                        = 80;
+    x.index_params.codebook_kind = ivf_pq::codebook_gen::PER_SUBSPACE;
+    x.index_params.pq_dim        = 40;
+    x.index_params.pq_bits       = 4;
+    x.search_params.lut_dtype    = CUDA_R_16F;
+    x.min_recall                 = 0.79;
+  });
+
   return xs;
 }
 
@@ -1083,12 +1417,48 @@ inline auto special_cases() -> test_cases_t
     this->run([this]() { return this->build_2_extends(); }); \
   }
 
+#define TEST_BUILD_VERSIONED_EXTEND_SEARCH(type)                     \
+  TEST_P(type, build_versioned_extend_search) /* NOLINT */           \
+  {                                                                  \
+    this->run([this]() { return this->build_versioned_extends(); }); \
+  }
+
+#define TEST_BUILD_REBALANCE_SEARCH(type)                     \
+  TEST_P(type, build_rebalance_search) /* NOLINT */           \
+  {                                                           \
+    this->run([this]() { return this->build_rebalanced(); }); \
+  }
+
 #define TEST_BUILD_SERIALIZE_SEARCH(type)                    \
   TEST_P(type, build_serialize_search) /* NOLINT */          \
   {                                                          \
     this->run([this]() { return this->build_serialize(); }); \
   }
 
+#define TEST_BUILD_HOST_LISTS_SEARCH(type)                    \
+  TEST_P(type, build_host_lists_search) /* NOLINT */          \
+  {                                                           \
+    this->run([this]() { return this->build_host_lists(); }); \
+  }
+
+#define TEST_BUILD_SHARDED_SEARCH(type)           \
+  TEST_P(type, build_sharded_search) /* NOLINT */ \
+  {                                               \
+    this->run_sharded();                          \
+  }
+
+#define TEST_BUILD_REFINE_HOST_SEARCH(type)           \
+  TEST_P(type, build_refine_host_search) /* NOLINT */ \
+  {                                                   \
+    this->run_refine_host();                          \
+  }
+
+#define TEST_BUILD_ADAPTIVE_PROBING_SEARCH(type)           \
+  TEST_P(type, build_adaptive_probing_search) /* NOLINT */ \
+  {                                                        \
+    this->run_adaptive_probing();                          \
+  }
+
 #define INSTANTIATE(type, vals) \
   INSTANTIATE_TEST_SUITE_P(IvfPq, type, ::testing::ValuesIn(vals)); /* NOLINT */
 
@@ -21,7 +21,13 @@ namespace raft::neighbors::ivf_pq {
 using f32_f32_i64 = ivf_pq_test<float, float, int64_t>;
 
 TEST_BUILD_EXTEND_SEARCH(f32_f32_i64)
+TEST_BUILD_VERSIONED_EXTEND_SEARCH(f32_f32_i64)
+TEST_BUILD_REBALANCE_SEARCH(f32_f32_i64)
 TEST_BUILD_SERIALIZE_SEARCH(f32_f32_i64)
+TEST_BUILD_HOST_LISTS_SEARCH(f32_f32_i64)
+TEST_BUILD_SHARDED_SEARCH(f32_f32_i64)
+TEST_BUILD_REFINE_HOST_SEARCH(f32_f32_i64)
+TEST_BUILD_ADAPTIVE_PROBING_SEARCH(f32_f32_i64)
 INSTANTIATE(f32_f32_i64, defaults() + small_dims() + big_dims_moderate_lut());
 
 }  // namespace raft::neighbors::ivf_pq
@@ -26,8 +26,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -49,6 +51,8 @@ struct AnnNNDescentBatchInputs {
   int graph_degree;
   raft::distance::DistanceType metric;
   bool host_dataset;
+  bool spill;
+  bool multi_device;
 };
 
 inline ::std::ostream& operator<<(::std::ostream& os, const AnnNNDescentInputs& p)
@@ -63,7 +67,8 @@ inline ::std::ostream& operator<<(::std::ostream& os, const AnnNNDescentBatchInp
 {
   os << "dataset shape=" << p.n_rows << "x" << p.dim << ", graph_degree=" << p.graph_degree
      << ", metric=" << static_cast<int>(p.metric) << (p.host_dataset ? ", host" : ", device")
-     << ", clusters=" << p.recall_cluster.second << std::endl;
+     << ", clusters=" << p.recall_cluster.second << (p.spill ? ", spill" : "")
+     << (p.multi_device ? ", multi-device" : "") << std::endl;
   return os;
 }
 
@@ -234,6 +239,7 @@ class AnnNNDescentBatchTest : public ::testing::TestWithParam<AnnNNDescentBatchI
         index_params.max_iterations            = 10;
         index_params.return_distances          = true;
         index_params.n_clusters                = ps.recall_cluster.second;
+        if (ps.spill) { index_params.spill_directory = ::testing::TempDir(); }
 
         auto database_view = raft::make_device_matrix_view<const DataT, int64_t>(
           (const DataT*)database.data(), ps.n_rows, ps.dim);
@@ -244,13 +250,26 @@ class AnnNNDescentBatchTest : public ::testing::TestWithParam<AnnNNDescentBatchI
             raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
             auto database_host_view = raft::make_host_matrix_view<const DataT, int64_t>(
               (const DataT*)database_host.data_handle(), ps.n_rows, ps.dim);
-            auto index = nn_descent::build<DataT, IdxT>(
-              handle_, index_params, database_host_view, DistEpilogue<IdxT, DataT>());
+            std::optional<nn_descent::index<IdxT>> index;
+            if (ps.multi_device) {
+              // Reuse the available devices, so that the test runs on a single GPU as well.
+              int n_devices = 0;
+              RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+              std::vector<int> device_ids(std::max(n_devices, 2));
+              for (size_t i = 0; i < device_ids.size(); i++) {
+                device_ids[i] = i % n_devices;
+              }
+              index.emplace(nn_descent::build_multi_device<DataT, IdxT>(
+                handle_, index_params, device_ids, database_host_view));
+            } else {
+              index.emplace(nn_descent::build<DataT, IdxT>(
+                handle_, index_params, database_host_view, DistEpilogue<IdxT, DataT>()));
+            }
             raft::copy(
-              indices_NNDescent.data(), index.graph().data_handle(), queries_size, stream_);
-            if (index.distances().has_value()) {
+              indices_NNDescent.data(), index->graph().data_handle(), queries_size, stream_);
+            if (index->distances().has_value()) {
               raft::copy(distances_NNDescent.data(),
-                         index.distances().value().data_handle(),
+                         index->distances().value().data_handle(),
                          queries_size,
                          stream_);
             }
@@ -314,7 +333,7 @@ const std::vector<AnnNNDescentInputs> inputs = raft::util::itertools::product<An
   {1000, 2000},                                              // n_rows
   {3, 5, 7, 8, 17, 64, 128, 137, 192, 256, 512, 619, 1024},  // dim
   {32, 64},                                                  // graph_degree
-  {raft::distance::DistanceType::L2Expanded},
+  {raft::distance::DistanceType::L2Expanded, raft::distance::DistanceType::InnerProduct},
   {false, true},
   {0.90});
 
@@ -327,6 +346,43 @@ const std::vector<AnnNNDescentInputs> inputs = raft::util::itertools::product<An
 //     {192, 512},                                            // dim
 //     {32, 64},                                              // graph_degree
 //     {raft::distance::DistanceType::L2Expanded},
-//     {false, true});
+//     {false, true},   // host_dataset
+//     {false, true},   // spill
+//     {false});        // multi_device
+//
+// const std::vector<AnnNNDescentBatchInputs> inputsBatchMultiDevice =
+//   raft::util::itertools::product<AnnNNDescentBatchInputs>(
+//     {std::make_pair(0.9, 4lu)},  // min_recall, n_clusters
+//     {5000},                      // n_rows
+//     {192},                       // dim
+//     {32, 64},                    // graph_degree
+//     {raft::distance::DistanceType::L2Expanded},
+//     {true},          // host_dataset
+//     {false, true},   // spill
+//     {true});         // multi_device
+
+// Small out-of-core and multi-device batched builds, enabled while the suite above is disabled.
+// The multi-device build lists the available devices twice, so it runs on a single GPU as well.
+const std::vector<AnnNNDescentBatchInputs> inputsBatchSpill =
+  raft::util::itertools::product<AnnNNDescentBatchInputs>(
+    {std::make_pair(0.8, 2lu)},  // min_recall, n_clusters
+    {2000},                      // n_rows
+    {64},                        // dim
+    {32},                        // graph_degree
+    {raft::distance::DistanceType::L2Expanded},
+    {false, true},  // host_dataset
+    {true},         // spill
+    {false});       // multi_device
+
+const std::vector<AnnNNDescentBatchInputs> inputsBatchSmallMultiDevice =
+  raft::util::itertools::product<AnnNNDescentBatchInputs>(
+    {std::make_pair(0.8, 2lu)},  // min_recall, n_clusters
+    {2000},                      // n_rows
+    {64},                        // dim
+    {32},                        // graph_degree
+    {raft::distance::DistanceType::L2Expanded},
+    {true},         // host_dataset
+    {false, true},  // spill
+    {true});        // multi_device
 
 }  // namespace raft::neighbors::experimental::nn_descent
@@ -26,5 +26,8 @@ TEST_P(AnnNNDescentBatchTestF_U32, AnnNNDescentBatch) { this->testNNDescentBatch
 INSTANTIATE_TEST_CASE_P(AnnNNDescentBatchTest,
                         AnnNNDescentBatchTestF_U32,
                         ::testing::ValuesIn(inputsBatch));
+INSTANTIATE_TEST_CASE_P(AnnNNDescentBatchMultiDeviceTest,
+                        AnnNNDescentBatchTestF_U32,
+                        ::testing::ValuesIn(inputsBatchMultiDevice));
 
 }  // namespace raft::neighbors::experimental::nn_descent
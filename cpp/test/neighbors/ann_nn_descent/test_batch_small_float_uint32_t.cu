@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../ann_nn_descent.cuh"
+
+#include <gtest/gtest.h>
+
+namespace raft::neighbors::experimental::nn_descent {
+
+typedef AnnNNDescentBatchTest<float, float, std::uint32_t> AnnNNDescentBatchSmallTestF_U32;
+TEST_P(AnnNNDescentBatchSmallTestF_U32, AnnNNDescentBatch) { this->testNNDescentBatch(); }
+
+INSTANTIATE_TEST_CASE_P(AnnNNDescentBatchSpillTest,
+                        AnnNNDescentBatchSmallTestF_U32,
+                        ::testing::ValuesIn(inputsBatchSpill));
+INSTANTIATE_TEST_CASE_P(AnnNNDescentBatchSmallMultiDeviceTest,
+                        AnnNNDescentBatchSmallTestF_U32,
+                        ::testing::ValuesIn(inputsBatchSmallMultiDevice));
+
+}  // namespace raft::neighbors::experimental::nn_descent
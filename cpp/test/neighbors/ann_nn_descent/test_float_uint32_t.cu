@@ -25,4 +25,37 @@ TEST_P(AnnNNDescentTestF_U32, AnnNNDescent) { this->testNNDescent(); }
 
 INSTANTIATE_TEST_CASE_P(AnnNNDescentTest, AnnNNDescentTestF_U32, ::testing::ValuesIn(inputs));
 
+TEST(AnnNNDescentTest, IterationCallback)
+{
+  raft::resources handle;
+  const int64_t n_rows = 2000;
+  const int64_t dim    = 64;
+  auto database        = raft::make_device_matrix<float, int64_t>(handle, n_rows, dim);
+  raft::random::RngState r(1234ULL);
+  raft::random::normal(handle, r, database.data_handle(), database.size(), 0.1f, 2.0f);
+
+  std::vector<iteration_stats> history;
+  index_params params;
+  params.graph_degree              = 32;
+  params.intermediate_graph_degree = 64;
+  params.max_iterations            = 20;
+  params.termination_threshold     = 0;
+  params.on_iteration              = [&history](const iteration_stats& stats) {
+    history.push_back(stats);
+    return stats.iteration < 3;
+  };
+  auto idx = nn_descent::build<float, std::uint32_t>(
+    handle, params, raft::make_const_mdspan(database.view()));
+
+  // The build stops as soon as the callback returns false
+  ASSERT_EQ(history.size(), size_t(3));
+  for (size_t i = 0; i < history.size(); i++) {
+    EXPECT_EQ(history[i].iteration, i + 1);
+    EXPECT_GE(history[i].updates, 0);
+    EXPECT_GE(history[i].iteration_ms, 0);
+    EXPECT_GE(history[i].total_ms, history[i].iteration_ms);
+  }
+  ASSERT_EQ(idx.graph().extent(0), n_rows);
+}
+
 }  // namespace raft::neighbors::experimental::nn_descent
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/nn_descent.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::experimental::nn_descent {
+
+struct GnndGraphInputs {
+  size_t nrow;
+  size_t node_degree;
+  int num_samples;
+  size_t width;
+};
+
+inline ::std::ostream& operator<<(::std::ostream& os, const GnndGraphInputs& p)
+{
+  os << "{nrow=" << p.nrow << ", node_degree=" << p.node_degree
+     << ", num_samples=" << p.num_samples << ", width=" << p.width << '}' << std::endl;
+  return os;
+}
+
+namespace {
+
+using ID_t                        = detail::InternalID_t<int>;
+using DistData_t                  = detail::DistData_t;
+constexpr int kSegmentSize        = detail::SEGMENT_SIZE;
+constexpr DistData_t kMaxDistance = std::numeric_limits<DistData_t>::max();
+
+/**
+ * The kNN lists of GNND and their samples updated on the host, the way GnndGraph did before the
+ * sampling and the update moved to the device.
+ */
+struct host_gnnd_graph {
+  size_t nrow;
+  size_t node_degree;
+  int num_samples;
+  int num_segments;
+  std::vector<ID_t> graph;
+  std::vector<DistData_t> dists;
+  std::vector<int> graph_old;
+  std::vector<int2> list_sizes_old;
+  std::vector<int> graph_new;
+  std::vector<int2> list_sizes_new;
+
+  static auto insert_to_ordered_list(
+    ID_t* list, DistData_t* dist_list, const int width, const ID_t neighb_id, const DistData_t dist)
+    -> int
+  {
+    if (dist > dist_list[width - 1]) { return width; }
+
+    int idx_insert      = width;
+    bool position_found = false;
+    for (int i = 0; i < width; i++) {
+      if (list[i].id() == neighb_id.id()) { return width; }
+      if (!position_found && dist_list[i] > dist) {
+        idx_insert     = i;
+        position_found = true;
+      }
+    }
+    if (idx_insert == width) return idx_insert;
+
+    std::copy_backward(list + idx_insert, list + width - 1, list + width);
+    std::copy_backward(dist_list + idx_insert, dist_list + width - 1, dist_list + width);
+    list[idx_insert]      = neighb_id;
+    dist_list[idx_insert] = dist;
+    return idx_insert;
+  }
+
+  void sample_graph(bool sample_new)
+  {
+    for (size_t i = 0; i < nrow; i++) {
+      auto& size_old = list_sizes_old[i];
+      auto& size_new = list_sizes_new[i];
+      size_old       = int2{0, 0};
+      if (sample_new) { size_new = int2{0, 0}; }
+
+      auto list     = graph.data() + i * node_degree;
+      auto list_old = graph_old.data() + i * num_samples;
+      auto list_new = graph_new.data() + i * num_samples;
+      for (int j = 0; j < kSegmentSize; j++) {
+        for (int k = 0; k < num_segments; k++) {
+          auto neighbor = list[k * kSegmentSize + j];
+          if ((size_t)neighbor.id() >= nrow) continue;
+          if (!neighbor.is_new()) {
+            if (size_old.x < num_samples) { list_old[size_old.x++] = neighbor.id(); }
+          } else if (sample_new) {
+            if (size_new.x < num_samples) {
+              list[k * kSegmentSize + j].mark_old();
+              list_new[size_new.x++] = neighbor.id();
+            }
+          }
+        }
+      }
+    }
+  }
+
+  auto update_graph(const ID_t* new_neighbors, const DistData_t* new_dists, const size_t width)
+    -> int64_t
+  {
+    int64_t update_counter = 0;
+    for (size_t i = 0; i < nrow; i++) {
+      for (size_t j = 0; j < width; j++) {
+        auto new_neighb_id = new_neighbors[i * width + j];
+        auto new_dist      = new_dists[i * width + j];
+        if (new_dist == kMaxDistance) break;
+        if ((size_t)new_neighb_id.id() == i) continue;
+        int seg_idx    = new_neighb_id.id() % num_segments;
+        auto list      = graph.data() + i * node_degree + seg_idx * kSegmentSize;
+        auto dist_list = dists.data() + i * node_degree + seg_idx * kSegmentSize;
+        int insert_pos =
+          insert_to_ordered_list(list, dist_list, kSegmentSize, new_neighb_id, new_dist);
+        if (i % detail::counter_interval == 0 && insert_pos != kSegmentSize) { update_counter++; }
+      }
+    }
+    return update_counter;
+  }
+
+  void sort_lists()
+  {
+    for (size_t i = 0; i < nrow; i++) {
+      std::vector<std::pair<DistData_t, int>> new_list;
+      for (size_t j = 0; j < node_degree; j++) {
+        new_list.emplace_back(dists[i * node_degree + j], graph[i * node_degree + j].id());
+      }
+      std::sort(new_list.begin(), new_list.end());
+      for (size_t j = 0; j < node_degree; j++) {
+        graph[i * node_degree + j].id_with_flag() = new_list[j].second;
+        dists[i * node_degree + j]                = new_list[j].first;
+      }
+    }
+  }
+};
+
+}  // namespace
+
+class GnndGraphTest : public ::testing::TestWithParam<GnndGraphInputs> {
+ public:
+  GnndGraphTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<GnndGraphInputs>::GetParam())
+  {
+  }
+
+ protected:
+  template <typename T>
+  auto to_host(const T* ptr, size_t size) -> std::vector<T>
+  {
+    std::vector<T> out(size);
+    raft::update_host(out.data(), ptr, size, stream_);
+    resource::sync_stream(handle_);
+    return out;
+  }
+
+  /** Fill in the local join results of every row: `width` slots, past a random count empty. */
+  void generate_new_neighbors(std::mt19937& gen,
+                              int iteration,
+                              std::vector<ID_t>& new_neighbors,
+                              std::vector<DistData_t>& new_dists)
+  {
+    std::uniform_int_distribution<int> id_dist(0, static_cast<int>(ps.nrow) - 1);
+    std::uniform_int_distribution<size_t> count_dist(0, ps.width);
+    std::vector<int> ranks(ps.width);
+    for (size_t i = 0; i < ps.nrow; i++) {
+      // The distances are distinct within a row over both iterations, hence the order of the
+      // sorted lists does not depend on the tie breaking.
+      std::iota(ranks.begin(), ranks.end(), 0);
+      std::shuffle(ranks.begin(), ranks.end(), gen);
+      const size_t count = count_dist(gen);
+      for (size_t j = 0; j < ps.width; j++) {
+        auto& id          = new_neighbors[i * ps.width + j];
+        id.id_with_flag() = id_dist(gen);
+        if (gen() % 2) { id.mark_old(); }
+        new_dists[i * ps.width + j] =
+          j < count ? static_cast<DistData_t>(2 * ranks[j] + iteration) : kMaxDistance;
+      }
+    }
+  }
+
+  void expect_equal_lists(const detail::GnndGraph<int>& graph, host_gnnd_graph& ref)
+  {
+    auto ids   = to_host(graph.d_graph.data_handle(), graph.d_graph.size());
+    auto dists = to_host(graph.d_dists.data_handle(), graph.d_dists.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+      ASSERT_EQ(ids[i].id_with_flag(), ref.graph[i].id_with_flag()) << "at " << i;
+      ASSERT_EQ(dists[i], ref.dists[i]) << "at " << i;
+    }
+  }
+
+  void expect_equal_samples(const detail::GnndGraph<int>& graph,
+                            host_gnnd_graph& ref,
+                            bool sample_new)
+  {
+    auto sizes_old = to_host(graph.d_list_sizes_old.data_handle(), ps.nrow);
+    auto sizes_new = to_host(graph.d_list_sizes_new.data_handle(), ps.nrow);
+    auto lists_old = to_host(graph.d_graph_old.data_handle(), graph.d_graph_old.size());
+    auto lists_new = to_host(graph.d_graph_new.data_handle(), graph.d_graph_new.size());
+    for (size_t i = 0; i < ps.nrow; i++) {
+      ASSERT_EQ(sizes_old[i].x, ref.list_sizes_old[i].x) << "row " << i;
+      for (int j = 0; j < sizes_old[i].x; j++) {
+        ASSERT_EQ(lists_old[i * ps.num_samples + j], ref.graph_old[i * ps.num_samples + j])
+          << "row " << i;
+      }
+      if (!sample_new) { continue; }
+      ASSERT_EQ(sizes_new[i].x, ref.list_sizes_new[i].x) << "row " << i;
+      for (int j = 0; j < sizes_new[i].x; j++) {
+        ASSERT_EQ(lists_new[i * ps.num_samples + j], ref.graph_new[i * ps.num_samples + j])
+          << "row " << i;
+      }
+    }
+  }
+
+  /** The device sampling and update of the kNN lists give the same lists as the host path. */
+  void testDeviceUpdate()
+  {
+    detail::GnndGraph<int> graph(handle_, ps.nrow, ps.node_degree, ps.node_degree, ps.num_samples);
+    graph.init_random_graph(handle_);
+
+    host_gnnd_graph ref{ps.nrow,
+                        ps.node_degree,
+                        ps.num_samples,
+                        graph.num_segments,
+                        to_host(graph.d_graph.data_handle(), graph.d_graph.size()),
+                        to_host(graph.d_dists.data_handle(), graph.d_dists.size()),
+                        std::vector<int>(ps.nrow * ps.num_samples),
+                        std::vector<int2>(ps.nrow),
+                        std::vector<int>(ps.nrow * ps.num_samples),
+                        std::vector<int2>(ps.nrow)};
+
+    std::mt19937 gen(42);
+    std::vector<ID_t> new_neighbors(ps.nrow * ps.width);
+    std::vector<DistData_t> new_dists(ps.nrow * ps.width);
+    rmm::device_uvector<ID_t> d_new_neighbors(new_neighbors.size(), stream_);
+    rmm::device_uvector<DistData_t> d_new_dists(new_dists.size(), stream_);
+    for (int iteration = 0; iteration < 2; iteration++) {
+      graph.sample_graph(handle_, true);
+      ref.sample_graph(true);
+      expect_equal_samples(graph, ref, true);
+      expect_equal_lists(graph, ref);
+
+      generate_new_neighbors(gen, iteration, new_neighbors, new_dists);
+      raft::update_device(
+        d_new_neighbors.data(), new_neighbors.data(), new_neighbors.size(), stream_);
+      raft::update_device(d_new_dists.data(), new_dists.data(), new_dists.size(), stream_);
+      auto updates =
+        graph.update_graph(handle_, d_new_neighbors.data(), d_new_dists.data(), ps.width);
+      auto ref_updates = ref.update_graph(new_neighbors.data(), new_dists.data(), ps.width);
+      ASSERT_EQ(updates, ref_updates);
+      expect_equal_lists(graph, ref);
+
+      graph.sample_graph(handle_, false);
+      ref.sample_graph(false);
+      expect_equal_samples(graph, ref, false);
+    }
+
+    // The empty slots share the maximum distance, hence only their ids may come in another order.
+    graph.sort_lists(handle_);
+    ref.sort_lists();
+    auto ids   = to_host(graph.d_graph.data_handle(), graph.d_graph.size());
+    auto dists = to_host(graph.d_dists.data_handle(), graph.d_dists.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+      ASSERT_EQ(dists[i], ref.dists[i]) << "at " << i;
+      if (dists[i] != kMaxDistance) { ASSERT_EQ(ids[i].id(), ref.graph[i].id()) << "at " << i; }
+    }
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  GnndGraphInputs ps;
+};
+
+const std::vector<GnndGraphInputs> gnnd_graph_inputs = {
+  {2000, 64, 32, 32},
+  {3001, 96, 16, 64},
+};
+
+TEST_P(GnndGraphTest, DeviceUpdate) { this->testDeviceUpdate(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(GnndGraphTest, GnndGraphTest, ::testing::ValuesIn(gnnd_graph_inputs));
+
+}  // namespace raft::neighbors::experimental::nn_descent
@@ -15,6 +15,7 @@
  */
 
 #include "../test_utils.cuh"
+#include "ann_utils.cuh"
 #include "spatial_data.h"
 
 #include <raft/core/device_mdspan.hpp>
@@ -22,6 +23,7 @@
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/ball_cover.cuh>
+#include <raft/neighbors/ball_cover_serialize.cuh>
 #include <raft/neighbors/brute_force.cuh>
 #include <raft/random/make_blobs.cuh>
 #include <raft/util/cudart_utils.hpp>
@@ -37,6 +39,7 @@
 
 #include <cstdint>
 #include <iostream>
+#include <sstream>
 #include <vector>
 
 namespace raft::neighbors::ball_cover {
@@ -141,7 +144,7 @@ struct BallCoverInputs {
 template <typename value_idx, typename value_t, typename value_int = std::int64_t>
 class BallCoverKNNQueryTest : public ::testing::TestWithParam<BallCoverInputs<value_int>> {
  protected:
-  void basicTest()
+  void basicTest(value_int n_probes = 0, bool incremental = false)
   {
     params = ::testing::TestWithParam<BallCoverInputs<value_int>>::GetParam();
     raft::resources handle;
@@ -214,13 +217,48 @@ class BallCoverKNNQueryTest : public ::testing::TestWithParam<BallCoverInputs<va
     auto d_pred_D_view =
       raft::make_device_matrix_view<value_t, value_int>(d_pred_D.data(), params.n_query, k);
 
-    BallCoverIndex<value_idx, value_t, value_int, value_int> index(handle, X_view, metric);
-
-    build_index(handle, index);
-    knn_query<value_idx, value_t, value_int, value_int>(
-      handle, index, X2_view, d_pred_I_view, d_pred_D_view, k, true);
+    if (!incremental) {
+      BallCoverIndex<value_idx, value_t, value_int, value_int> index(handle, X_view, metric);
+
+      build_index(handle, index);
+      knn_query<value_idx, value_t, value_int, value_int>(
+        handle, index, X2_view, d_pred_I_view, d_pred_D_view, k, true, 1.0, n_probes);
+    } else {
+      // Build on the first half of the points, add the others, and query the index once saved and
+      // loaded again
+      auto X_all = raft::make_const_mdspan(X_view);
+      BallCoverIndex<value_idx, value_t, value_int, value_int> index(
+        handle,
+        raft::make_device_matrix_view<const value_t, value_int>(
+          X.data(), params.n_rows / 2, params.n_cols),
+        metric);
+
+      build_index(handle, index);
+      extend(handle, index, X_all);
+
+      std::stringstream ss;
+      serialize(handle, ss, index);
+      auto loaded = deserialize<value_idx, value_t, value_int, value_int>(handle, ss, X_all);
+      ASSERT_EQ(loaded.m, params.n_rows);
+      ASSERT_EQ(loaded.n_landmarks, index.n_landmarks);
+      knn_query<value_idx, value_t, value_int, value_int>(
+        handle, loaded, X2_view, d_pred_I_view, d_pred_D_view, k, true, 1.0, n_probes);
+    }
 
     resource::sync_stream(handle);
+
+    if (n_probes > 0) {
+      // The approximate search only has to find most of the neighbors
+      std::vector<value_idx> ref_I(d_ref_I.size());
+      std::vector<value_idx> pred_I(d_pred_I.size());
+      raft::update_host(
+        ref_I.data(), d_ref_I.data(), ref_I.size(), resource::get_cuda_stream(handle));
+      raft::update_host(
+        pred_I.data(), d_pred_I.data(), pred_I.size(), resource::get_cuda_stream(handle));
+      resource::sync_stream(handle);
+      ASSERT_TRUE(eval_recall(ref_I, pred_I, params.n_query, k, 0.001, 0.8, false));
+      return;
+    }
     // What we really want are for the distances to match exactly. The
     // indices may or may not match exactly, depending upon the ordering which
     // can be nondeterministic.
@@ -372,5 +410,28 @@ INSTANTIATE_TEST_CASE_P(BallCoverKNNQueryTest,
 
 TEST_P(BallCoverAllKNNTestF, Fit) { basicTest(); }
 TEST_P(BallCoverKNNQueryTestF, Fit) { basicTest(); }
+TEST_P(BallCoverKNNQueryTestF, FitApprox) { basicTest(8); }
+TEST_P(BallCoverKNNQueryTestF, ExtendSerialize) { basicTest(0, true); }
+
+// The dimensions handled by the tiled kernels
+typedef BallCoverAllKNNTest<int64_t, float> BallCoverAllKNNHighDimTestF;
+typedef BallCoverKNNQueryTest<int64_t, float> BallCoverKNNQueryHighDimTestF;
+
+const std::vector<BallCoverInputs<std::int64_t>> ballcover_high_dim_inputs = {
+  {5, 5000, 1, 1.0, 5000, raft::distance::DistanceType::L2SqrtUnexpanded},
+  {11, 5000, 8, 1.0, 5000, raft::distance::DistanceType::L2SqrtUnexpanded},
+  {25, 8000, 16, 1.0, 5000, raft::distance::DistanceType::L2SqrtUnexpanded},
+  {50, 4000, 32, 1.0, 2000, raft::distance::DistanceType::L2SqrtUnexpanded},
+  {11, 4000, 130, 1.0, 2000, raft::distance::DistanceType::L2SqrtUnexpanded}};
+
+INSTANTIATE_TEST_CASE_P(BallCoverAllKNNTest,
+                        BallCoverAllKNNHighDimTestF,
+                        ::testing::ValuesIn(ballcover_high_dim_inputs));
+INSTANTIATE_TEST_CASE_P(BallCoverKNNQueryTest,
+                        BallCoverKNNQueryHighDimTestF,
+                        ::testing::ValuesIn(ballcover_high_dim_inputs));
+
+TEST_P(BallCoverAllKNNHighDimTestF, Fit) { basicTest(); }
+TEST_P(BallCoverKNNQueryHighDimTestF, Fit) { basicTest(); }
 
 }  // namespace raft::neighbors::ball_cover
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/binary_quantized.cuh>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+namespace raft::neighbors::binary_quantized {
+
+struct BinaryQuantizedInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  int64_t dim;
+  int64_t k;
+  binarization thresholds;
+};
+
+inline auto operator<<(std::ostream& os, const BinaryQuantizedInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", dim=" << p.dim
+     << ", k=" << p.k << ", thresholds=" << static_cast<int>(p.thresholds) << "}";
+  return os;
+}
+
+template <typename T>
+class BinaryQuantizedTest : public ::testing::TestWithParam<BinaryQuantizedInputs> {
+ public:
+  BinaryQuantizedTest() : params_(::testing::TestWithParam<BinaryQuantizedInputs>::GetParam())
+  {
+  }
+
+ protected:
+  void run()
+  {
+    auto stream    = resource::get_cuda_stream(handle_);
+    auto n_rows    = params_.n_rows;
+    auto n_queries = params_.n_queries;
+    auto dim       = params_.dim;
+    auto k         = params_.k;
+    auto dataset   = raft::make_device_matrix<T, int64_t>(handle_, n_rows, dim);
+    auto queries   = raft::make_device_matrix<T, int64_t>(handle_, n_queries, dim);
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, dataset.data_handle(), dataset.size(), T(-1), T(2));
+    raft::random::uniform(handle_, rng, queries.data_handle(), queries.size(), T(-1), T(2));
+
+    index_params index_params;
+    index_params.metric     = raft::distance::DistanceType::L2Expanded;
+    index_params.thresholds = params_.thresholds;
+    auto idx = build(handle_, index_params, raft::make_const_mdspan(dataset.view()));
+    ASSERT_EQ(idx.size(), n_rows);
+    ASSERT_EQ(idx.dim(), dim);
+
+    // The reference codes and Hamming distances on the host
+    auto dataset_h = raft::make_host_matrix<T, int64_t>(n_rows, dim);
+    auto queries_h = raft::make_host_matrix<T, int64_t>(n_queries, dim);
+    auto codes_h   = raft::make_host_matrix<uint64_t, int64_t>(n_rows, idx.code_words());
+    std::vector<float> thresholds_h(dim);
+    raft::copy(dataset_h.data_handle(), dataset.data_handle(), dataset.size(), stream);
+    raft::copy(queries_h.data_handle(), queries.data_handle(), queries.size(), stream);
+    raft::copy(codes_h.data_handle(), idx.codes().data_handle(), codes_h.size(), stream);
+    raft::copy(thresholds_h.data(), idx.thresholds().data_handle(), dim, stream);
+    resource::sync_stream(handle_);
+
+    for (int64_t j = 0; j < dim; j++) {
+      float expected = 0;
+      if (params_.thresholds == binarization::kMean) {
+        for (int64_t i = 0; i < n_rows; i++) {
+          expected += static_cast<float>(dataset_h(i, j));
+        }
+        expected /= n_rows;
+      }
+      ASSERT_NEAR(thresholds_h[j], expected, 1e-3) << "dimension " << j;
+    }
+    auto binarize = [&](const T* x) {
+      std::vector<uint64_t> code(idx.code_words(), 0);
+      for (int64_t j = 0; j < dim; j++) {
+        if (static_cast<float>(x[j]) > thresholds_h[j]) { code[j / 64] |= uint64_t{1} << (j % 64); }
+      }
+      return code;
+    };
+    auto hamming = [&](const std::vector<uint64_t>& a, const uint64_t* b) {
+      int d = 0;
+      for (size_t w = 0; w < a.size(); w++) {
+        d += std::bitset<64>(a[w] ^ b[w]).count();
+      }
+      return float(d);
+    };
+    for (int64_t i = 0; i < n_rows; i++) {
+      auto code = binarize(&dataset_h(i, 0));
+      // The values exactly at the threshold are not expected in the random data.
+      ASSERT_EQ(hamming(code, &codes_h(i, 0)), 0.0f) << "row " << i;
+    }
+
+    // The Hamming search: the ties make the ids ambiguous, but not the distances.
+    search_params search_params;
+    auto neighbors = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances = raft::make_device_matrix<float, int64_t>(handle_, n_queries, k);
+    search(handle_,
+           search_params,
+           idx,
+           raft::make_const_mdspan(queries.view()),
+           neighbors.view(),
+           distances.view());
+    auto neighbors_h = raft::make_host_matrix<int64_t, int64_t>(n_queries, k);
+    auto distances_h = raft::make_host_matrix<float, int64_t>(n_queries, k);
+    raft::copy(neighbors_h.data_handle(), neighbors.data_handle(), neighbors.size(), stream);
+    raft::copy(distances_h.data_handle(), distances.data_handle(), distances.size(), stream);
+    resource::sync_stream(handle_);
+    for (int64_t q = 0; q < n_queries; q++) {
+      auto query_code = binarize(&queries_h(q, 0));
+      std::vector<float> expected(n_rows);
+      for (int64_t i = 0; i < n_rows; i++) {
+        expected[i] = hamming(query_code, &codes_h(i, 0));
+      }
+      std::partial_sort(expected.begin(), expected.begin() + k, expected.end());
+      for (int64_t j = 0; j < k; j++) {
+        ASSERT_EQ(distances_h(q, j), expected[j]) << "query " << q << ", neighbor " << j;
+        auto id = neighbors_h(q, j);
+        ASSERT_TRUE(0 <= id && id < n_rows);
+        ASSERT_EQ(hamming(query_code, &codes_h(id, 0)), expected[j]);
+      }
+    }
+
+    // With all rows as the candidates, the refined search is exact.
+    search_params.refine_ratio = n_rows;
+    auto neighbors_ref         = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances_ref         = raft::make_device_matrix<float, int64_t>(handle_, n_queries, k);
+    auto bf_index              = brute_force::build(
+      handle_, raft::make_const_mdspan(dataset.view()), index_params.metric);
+    brute_force::search<T, int64_t>(handle_,
+                                    bf_index,
+                                    raft::make_const_mdspan(queries.view()),
+                                    neighbors_ref.view(),
+                                    distances_ref.view());
+    search_refined(handle_,
+                   search_params,
+                   idx,
+                   raft::make_const_mdspan(dataset.view()),
+                   raft::make_const_mdspan(queries.view()),
+                   neighbors.view(),
+                   distances.view());
+    resource::sync_stream(handle_);
+    ASSERT_TRUE(devArrMatch(distances_ref.data_handle(),
+                            distances.data_handle(),
+                            distances.size(),
+                            CompareApprox<float>(1e-3),
+                            stream));
+    ASSERT_TRUE(devArrMatch(neighbors_ref.data_handle(),
+                            neighbors.data_handle(),
+                            neighbors.size(),
+                            Compare<int64_t>(),
+                            stream));
+  }
+
+  raft::resources handle_;
+  BinaryQuantizedInputs params_;
+};
+
+const std::vector<BinaryQuantizedInputs> inputs = {
+  {1000, 100, 16, 10, binarization::kSign},
+  {1000, 100, 64, 10, binarization::kMean},
+  {2000, 50, 100, 32, binarization::kSign},
+  {2000, 50, 129, 32, binarization::kMean},
+  {500, 20, 512, 64, binarization::kMean}};
+
+using BinaryQuantizedTestF = BinaryQuantizedTest<float>;
+TEST_P(BinaryQuantizedTestF, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(BinaryQuantizedTest, BinaryQuantizedTestF, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::binary_quantized
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../loopback_comms.hpp"
+#include "../test_utils.cuh"
+
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/brute_force_mg.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace raft::neighbors::brute_force {
+
+struct KnnMGInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  int64_t dim;
+  int64_t k;
+  raft::distance::DistanceType metric;
+};
+
+inline auto operator<<(std::ostream& os, const KnnMGInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", dim=" << p.dim
+     << ", k=" << p.k << ", metric=" << static_cast<int>(p.metric) << "}";
+  return os;
+}
+
+template <typename T>
+class KnnMGTest : public ::testing::TestWithParam<KnnMGInputs> {
+ public:
+  KnnMGTest() : params_(::testing::TestWithParam<KnnMGInputs>::GetParam())
+  {
+    resource::set_comms(handle_,
+                        std::make_shared<comms::comms_t>(std::make_unique<loopback_comms>()));
+  }
+
+ protected:
+  void run()
+  {
+    auto stream  = resource::get_cuda_stream(handle_);
+    auto index   = raft::make_device_matrix<T, int64_t>(handle_, params_.n_rows, params_.dim);
+    auto queries = raft::make_device_matrix<T, int64_t>(handle_, params_.n_queries, params_.dim);
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, index.data_handle(), index.size(), T(-1), T(1));
+    raft::random::uniform(handle_, rng, queries.data_handle(), queries.size(), T(-1), T(1));
+
+    auto n_queries = params_.n_queries;
+    auto k         = params_.k;
+    auto neighbors = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances = raft::make_device_matrix<T, int64_t>(handle_, n_queries, k);
+    auto neighbors_ref = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances_ref = raft::make_device_matrix<T, int64_t>(handle_, n_queries, k);
+
+    knn_mg<T, int64_t>(handle_,
+                       raft::make_const_mdspan(index.view()),
+                       raft::make_const_mdspan(queries.view()),
+                       neighbors.view(),
+                       distances.view(),
+                       params_.metric);
+
+    std::vector<raft::device_matrix_view<const T, int64_t, row_major>> index_parts{
+      raft::make_const_mdspan(index.view())};
+    knn<int64_t, T, int64_t, row_major, row_major>(handle_,
+                                                   index_parts,
+                                                   raft::make_const_mdspan(queries.view()),
+                                                   neighbors_ref.view(),
+                                                   distances_ref.view(),
+                                                   params_.metric);
+    resource::sync_stream(handle_);
+
+    ASSERT_TRUE(devArrMatch(distances_ref.data_handle(),
+                            distances.data_handle(),
+                            distances.size(),
+                            CompareApprox<T>(1e-4),
+                            stream));
+    ASSERT_TRUE(devArrMatch(neighbors_ref.data_handle(),
+                            neighbors.data_handle(),
+                            neighbors.size(),
+                            Compare<int64_t>(),
+                            stream));
+  }
+
+  raft::resources handle_;
+  KnnMGInputs params_;
+};
+
+const std::vector<KnnMGInputs> inputs = {
+  {1000, 100, 16, 10, raft::distance::DistanceType::L2Unexpanded},
+  {1000, 100, 16, 10, raft::distance::DistanceType::L2Expanded},
+  {1000, 100, 16, 10, raft::distance::DistanceType::InnerProduct},
+  {5000, 1, 64, 32, raft::distance::DistanceType::L2SqrtExpanded},
+  {5000, 3, 64, 32, raft::distance::DistanceType::L2Expanded},
+  {100, 500, 8, 100, raft::distance::DistanceType::InnerProduct}};
+
+using KnnMGTestF = KnnMGTest<float>;
+TEST_P(KnnMGTestF, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(KnnMGTest, KnnMGTestF, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::brute_force
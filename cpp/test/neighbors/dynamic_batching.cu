@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/dynamic_batching.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace raft::neighbors::dynamic_batching {
+
+struct BatcherInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  int64_t dim;
+  int64_t k;
+  int n_threads;
+  // the number of queries per request
+  int64_t request_size;
+  int64_t max_batch_size;
+  double dispatch_timeout_ms;
+};
+
+inline auto operator<<(std::ostream& os, const BatcherInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", dim=" << p.dim
+     << ", k=" << p.k << ", n_threads=" << p.n_threads << ", request_size=" << p.request_size
+     << ", max_batch_size=" << p.max_batch_size << ", timeout=" << p.dispatch_timeout_ms << "}";
+  return os;
+}
+
+template <typename T>
+class BatcherTest : public ::testing::TestWithParam<BatcherInputs> {
+ public:
+  BatcherTest() : params_(::testing::TestWithParam<BatcherInputs>::GetParam()) {}
+
+ protected:
+  void run()
+  {
+    auto stream  = resource::get_cuda_stream(handle_);
+    auto dataset = raft::make_device_matrix<T, int64_t>(handle_, params_.n_rows, params_.dim);
+    auto queries = raft::make_device_matrix<T, int64_t>(handle_, params_.n_queries, params_.dim);
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, dataset.data_handle(), dataset.size(), T(-1), T(1));
+    raft::random::uniform(handle_, rng, queries.data_handle(), queries.size(), T(-1), T(1));
+    auto index = brute_force::build(handle_, raft::make_const_mdspan(dataset.view()));
+
+    auto n_queries     = params_.n_queries;
+    auto k             = params_.k;
+    auto neighbors_ref = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances_ref = raft::make_device_matrix<T, int64_t>(handle_, n_queries, k);
+    brute_force::search<T, int64_t>(handle_,
+                                    index,
+                                    raft::make_const_mdspan(queries.view()),
+                                    neighbors_ref.view(),
+                                    distances_ref.view());
+
+    auto queries_h   = raft::make_host_matrix<T, int64_t>(n_queries, params_.dim);
+    auto neighbors_h = raft::make_host_matrix<int64_t, int64_t>(n_queries, k);
+    auto distances_h = raft::make_host_matrix<T, int64_t>(n_queries, k);
+    raft::copy(queries_h.data_handle(), queries.data_handle(), queries.size(), stream);
+    resource::sync_stream(handle_);
+
+    {
+      batcher<T, int64_t, T> b(
+        handle_,
+        batcher_params{params_.max_batch_size, params_.dispatch_timeout_ms},
+        params_.dim,
+        k,
+        [&index](const raft::resources& res, auto q, auto n, auto d) {
+          brute_force::search<T, int64_t>(res, index, q, n, d);
+        });
+
+      // Every thread submits its share of the requests one by one and waits for each of them.
+      std::vector<std::thread> threads;
+      for (int t = 0; t < params_.n_threads; t++) {
+        threads.emplace_back([&, t]() {
+          for (int64_t i = t * params_.request_size; i < n_queries;
+               i += params_.n_threads * params_.request_size) {
+            auto n    = std::min(params_.request_size, n_queries - i);
+            auto done = b.search(raft::make_host_matrix_view<const T, int64_t>(
+                                   queries_h.data_handle() + i * params_.dim, n, params_.dim),
+                                 raft::make_host_matrix_view<int64_t, int64_t>(
+                                   neighbors_h.data_handle() + i * k, n, k),
+                                 raft::make_host_matrix_view<T, int64_t>(
+                                   distances_h.data_handle() + i * k, n, k));
+            done.get();
+          }
+        });
+      }
+      for (auto& t : threads) {
+        t.join();
+      }
+    }
+
+    auto neighbors = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances = raft::make_device_matrix<T, int64_t>(handle_, n_queries, k);
+    raft::copy(neighbors.data_handle(), neighbors_h.data_handle(), neighbors.size(), stream);
+    raft::copy(distances.data_handle(), distances_h.data_handle(), distances.size(), stream);
+    resource::sync_stream(handle_);
+
+    ASSERT_TRUE(devArrMatch(distances_ref.data_handle(),
+                            distances.data_handle(),
+                            distances.size(),
+                            CompareApprox<T>(1e-4),
+                            stream));
+    ASSERT_TRUE(devArrMatch(neighbors_ref.data_handle(),
+                            neighbors.data_handle(),
+                            neighbors.size(),
+                            Compare<int64_t>(),
+                            stream));
+  }
+
+  raft::resources handle_;
+  BatcherInputs params_;
+};
+
+const std::vector<BatcherInputs> inputs = {{1000, 100, 16, 10, 1, 1, 32, 1.0},
+                                           {1000, 500, 16, 10, 16, 1, 32, 1.0},
+                                           {1000, 500, 16, 10, 16, 3, 32, 0.1},
+                                           {5000, 256, 64, 32, 8, 4, 4, 5.0},
+                                           {5000, 1000, 64, 32, 64, 1, 128, 0.0}};
+
+using BatcherTestF = BatcherTest<float>;
+TEST_P(BatcherTestF, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(BatcherTest, BatcherTestF, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::dynamic_batching
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "ann_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/haversine_grid.cuh>
+#include <raft/spatial/knn/detail/haversine_distance.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace raft::neighbors::haversine_grid {
+
+struct HaversineGridInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  int64_t k;
+  double cell_size;
+  uint32_t max_rings;
+  // the expected recall; 1.0 means the search must be exact
+  double min_recall;
+};
+
+inline auto operator<<(std::ostream& os, const HaversineGridInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", k=" << p.k
+     << ", cell_size=" << p.cell_size << ", max_rings=" << p.max_rings << "}";
+  return os;
+}
+
+class HaversineGridTest : public ::testing::TestWithParam<HaversineGridInputs> {
+ public:
+  HaversineGridTest() : params_(::testing::TestWithParam<HaversineGridInputs>::GetParam()) {}
+
+ protected:
+  /** Uniform points on the sphere, plus the poles and the antimeridian. */
+  auto make_points(int64_t n, uint64_t seed) -> std::vector<float>
+  {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> z(-1.0, 1.0);
+    std::uniform_real_distribution<double> lon(-M_PI, M_PI);
+    std::vector<float> points(2 * n);
+    for (int64_t i = 0; i < n; i++) {
+      points[2 * i]     = std::asin(z(rng));
+      points[2 * i + 1] = lon(rng);
+    }
+    const float special[] = {M_PI_2, 0.0f, -M_PI_2, 1.0f, 0.1f, -M_PI, 0.1f, M_PI};
+    for (int i = 0; i < 8 && i < 2 * n; i++) {
+      points[i] = special[i];
+    }
+    return points;
+  }
+
+  void run()
+  {
+    auto stream = resource::get_cuda_stream(handle_);
+    auto n_rows = params_.n_rows;
+    auto n_q    = params_.n_queries;
+    auto k      = params_.k;
+
+    auto points_h  = make_points(n_rows, 42);
+    auto queries_h = make_points(n_q, 7);
+    auto points    = raft::make_device_matrix<float, int64_t>(handle_, n_rows, 2);
+    auto queries   = raft::make_device_matrix<float, int64_t>(handle_, n_q, 2);
+    raft::copy(points.data_handle(), points_h.data(), points_h.size(), stream);
+    raft::copy(queries.data_handle(), queries_h.data(), queries_h.size(), stream);
+
+    index_params index_params;
+    index_params.cell_size = params_.cell_size;
+    auto index = build(handle_, index_params, raft::make_const_mdspan(points.view()));
+    ASSERT_EQ(index.size(), n_rows);
+    ASSERT_GT(index.n_cells(), 0u);
+
+    search_params search_params;
+    search_params.max_rings = params_.max_rings;
+    auto neighbors          = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q, k);
+    auto distances          = raft::make_device_matrix<float, int64_t>(handle_, n_q, k);
+    search(handle_,
+           search_params,
+           index,
+           raft::make_const_mdspan(queries.view()),
+           neighbors.view(),
+           distances.view());
+
+    auto exact_neighbors = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q, k);
+    auto exact_distances = raft::make_device_matrix<float, int64_t>(handle_, n_q, k);
+    raft::spatial::knn::detail::haversine_knn(exact_neighbors.data_handle(),
+                                              exact_distances.data_handle(),
+                                              points.data_handle(),
+                                              queries.data_handle(),
+                                              n_rows,
+                                              n_q,
+                                              k,
+                                              stream);
+
+    std::vector<int64_t> actual_idx(neighbors.size());
+    std::vector<float> actual_dist(distances.size());
+    std::vector<int64_t> expected_idx(exact_neighbors.size());
+    std::vector<float> expected_dist(exact_distances.size());
+    raft::copy(actual_idx.data(), neighbors.data_handle(), neighbors.size(), stream);
+    raft::copy(actual_dist.data(), distances.data_handle(), distances.size(), stream);
+    raft::copy(expected_idx.data(), exact_neighbors.data_handle(), exact_neighbors.size(), stream);
+    raft::copy(expected_dist.data(), exact_distances.data_handle(), exact_distances.size(), stream);
+    resource::sync_stream(handle_);
+
+    if (params_.min_recall >= 1.0) {
+      for (size_t i = 0; i < actual_dist.size(); i++) {
+        ASSERT_NEAR(actual_dist[i], expected_dist[i], 1e-5) << "at " << i;
+      }
+    }
+    ASSERT_TRUE(eval_neighbours(
+      expected_idx, actual_idx, expected_dist, actual_dist, n_q, k, 1e-5, params_.min_recall));
+  }
+
+  raft::resources handle_;
+  HaversineGridInputs params_;
+};
+
+const std::vector<HaversineGridInputs> inputs = {
+  // exact: enough rings to cover the whole sphere
+  {10000, 500, 10, 0.05, 1000, 1.0},
+  {10000, 500, 64, 0.2, 1000, 1.0},
+  {5000, 300, 1, 0.01, 1000, 1.0},
+  {2000, 100, 200, 1.0, 1000, 1.0},
+  // the automatic cell size
+  {20000, 500, 16, 0.0, 1000, 1.0},
+  // bounded expansion
+  {20000, 500, 10, 0.0, 3, 0.95}};
+
+TEST_P(HaversineGridTest, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(HaversineGridTest, HaversineGridTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::haversine_grid
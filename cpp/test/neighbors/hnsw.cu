@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "ann_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/cagra.cuh>
+#include <raft/neighbors/cagra_serialize.cuh>
+#include <raft/neighbors/detail/hnsw_types.hpp>
+#include <raft/neighbors/hnsw.hpp>
+#include <raft/neighbors/hnsw_serialize.hpp>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <raft_internal/neighbors/naive_knn.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::hnsw {
+
+struct HnswInputs {
+  int64_t n_rows;
+  int64_t dim;
+  int64_t n_queries;
+  int64_t k;
+  uint32_t graph_degree;
+  int ef;
+  raft::distance::DistanceType metric;
+  double min_recall;
+};
+
+inline auto operator<<(std::ostream& os, const HnswInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", dim=" << p.dim << ", n_queries=" << p.n_queries
+     << ", k=" << p.k << ", graph_degree=" << p.graph_degree << ", ef=" << p.ef
+     << ", metric=" << int(p.metric) << "}";
+  return os;
+}
+
+template <typename T>
+class HnswTest : public ::testing::TestWithParam<HnswInputs> {
+ public:
+  using hnswlib_index_t = hnswlib::HierarchicalNSW<typename detail::hnsw_dist_t<T>::type>;
+
+  HnswTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps_(::testing::TestWithParam<HnswInputs>::GetParam()),
+      database_(raft::make_device_matrix<T, int64_t>(handle_, ps_.n_rows, ps_.dim)),
+      queries_(raft::make_host_matrix<T, int64_t>(ps_.n_queries, ps_.dim))
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    auto queries_d = raft::make_device_matrix<T, int64_t>(handle_, ps_.n_queries, ps_.dim);
+    raft::random::RngState r(1234ULL);
+    raft::random::normal(handle_, r, database_.data_handle(), database_.size(), T(0.1), T(2.0));
+    raft::random::normal(handle_, r, queries_d.data_handle(), queries_d.size(), T(0.1), T(2.0));
+    raft::copy(queries_.data_handle(), queries_d.data_handle(), queries_d.size(), stream_);
+
+    auto distances_d = raft::make_device_matrix<float, int64_t>(handle_, ps_.n_queries, ps_.k);
+    auto indices_d   = raft::make_device_matrix<uint32_t, int64_t>(handle_, ps_.n_queries, ps_.k);
+    naive_knn<float, T, uint32_t>(handle_,
+                                  distances_d.data_handle(),
+                                  indices_d.data_handle(),
+                                  queries_d.data_handle(),
+                                  database_.data_handle(),
+                                  ps_.n_queries,
+                                  ps_.n_rows,
+                                  ps_.dim,
+                                  ps_.k,
+                                  ps_.metric);
+    std::vector<uint32_t> indices_h(indices_d.size());
+    raft::update_host(indices_h.data(), indices_d.data_handle(), indices_d.size(), stream_);
+    resource::sync_stream(handle_);
+    indices_naive_.assign(indices_h.begin(), indices_h.end());
+  }
+
+  auto build_cagra() -> cagra::index<T, uint32_t>
+  {
+    cagra::index_params index_params;
+    index_params.metric                    = ps_.metric;
+    index_params.graph_degree              = ps_.graph_degree;
+    index_params.intermediate_graph_degree = 2 * ps_.graph_degree;
+    return cagra::build<T, uint32_t>(
+      handle_, index_params, raft::make_const_mdspan(database_.view()));
+  }
+
+  auto search(const index<T>& hnsw_index) -> std::vector<uint64_t>
+  {
+    search_params params;
+    params.ef          = ps_.ef;
+    params.num_threads = 1;
+    auto neighbors     = raft::make_host_matrix<uint64_t, int64_t>(ps_.n_queries, ps_.k);
+    auto distances     = raft::make_host_matrix<float, int64_t>(ps_.n_queries, ps_.k);
+    hnsw::search(handle_,
+                 params,
+                 hnsw_index,
+                 raft::make_const_mdspan(queries_.view()),
+                 neighbors.view(),
+                 distances.view());
+    return std::vector<uint64_t>(neighbors.data_handle(),
+                                 neighbors.data_handle() + neighbors.size());
+  }
+
+  auto temp_file(const std::string& name) -> std::string
+  {
+    return ::testing::TempDir() + "/raft_hnsw_test_" + name + ".bin";
+  }
+
+  /** The exported file holds the upper layers, which hnswlib searches from their entry point. */
+  void testSerializeWithHierarchy()
+  {
+    auto cagra_index = build_cagra();
+    auto filename    = temp_file("hierarchy");
+    cagra::serialize_to_hnswlib<T, uint32_t>(handle_, filename, cagra_index, true);
+    auto hnsw_index = deserialize<T>(handle_, filename, ps_.dim, ps_.metric);
+    std::remove(filename.c_str());
+
+    const auto* appr = static_cast<const hnswlib_index_t*>(hnsw_index->get_index());
+    ASSERT_EQ(appr->cur_element_count, size_t(ps_.n_rows));
+    // The levels shrink by a factor of M, hence some of this many rows are on an upper level
+    ASSERT_GT(appr->maxlevel_, 0);
+    ASSERT_LT(appr->enterpoint_node_, appr->cur_element_count);
+    ASSERT_EQ(appr->element_levels_[appr->enterpoint_node_], appr->maxlevel_);
+    ASSERT_FALSE(appr->base_layer_only);
+    // The links of the entry point stay within the nodes of its levels
+    for (int l = 1; l <= appr->maxlevel_; l++) {
+      auto* links      = appr->get_linklist(appr->enterpoint_node_, l);
+      const auto count = appr->getListCount(links);
+      const auto* ids  = reinterpret_cast<const hnswlib::tableint*>(links + 1);
+      for (size_t j = 0; j < count; j++) {
+        ASSERT_LT(ids[j], appr->cur_element_count) << "level " << l;
+        ASSERT_GE(appr->element_levels_[ids[j]], l) << "level " << l;
+      }
+    }
+
+    auto neighbors = search(*hnsw_index);
+    ASSERT_TRUE(
+      eval_recall(indices_naive_, neighbors, ps_.n_queries, ps_.k, 0.01, ps_.min_recall));
+  }
+
+  /** The in-memory conversion builds the same index as a round trip through a file. */
+  void testFromCagra()
+  {
+    auto cagra_index = build_cagra();
+    auto filename    = temp_file("from_cagra");
+    cagra::serialize_to_hnswlib<T, uint32_t>(handle_, filename, cagra_index);
+    auto hnsw_file = deserialize<T>(handle_, filename, ps_.dim, ps_.metric);
+    std::remove(filename.c_str());
+    auto hnsw_memory = from_cagra<T, uint32_t>(handle_, std::move(cagra_index));
+
+    const auto* appr_file   = static_cast<const hnswlib_index_t*>(hnsw_file->get_index());
+    const auto* appr_memory = static_cast<const hnswlib_index_t*>(hnsw_memory->get_index());
+    ASSERT_EQ(appr_memory->cur_element_count, appr_file->cur_element_count);
+    ASSERT_EQ(appr_memory->maxlevel_, appr_file->maxlevel_);
+    ASSERT_EQ(appr_memory->enterpoint_node_, appr_file->enterpoint_node_);
+
+    auto neighbors_file   = search(*hnsw_file);
+    auto neighbors_memory = search(*hnsw_memory);
+    ASSERT_EQ(neighbors_memory, neighbors_file);
+    ASSERT_TRUE(
+      eval_recall(indices_naive_, neighbors_memory, ps_.n_queries, ps_.k, 0.01, ps_.min_recall));
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  HnswInputs ps_;
+  raft::device_matrix<T, int64_t> database_;
+  raft::host_matrix<T, int64_t> queries_;
+  std::vector<uint64_t> indices_naive_;
+};
+
+const std::vector<HnswInputs> inputs = {
+  {5000, 32, 100, 10, 32, 64, raft::distance::DistanceType::L2Expanded, 0.9},
+  {8000, 64, 100, 10, 64, 128, raft::distance::DistanceType::L2Expanded, 0.9},
+};
+
+using HnswTestF = HnswTest<float>;
+TEST_P(HnswTestF, SerializeWithHierarchy) { this->testSerializeWithHierarchy(); }  // NOLINT
+TEST_P(HnswTestF, FromCagra) { this->testFromCagra(); }                            // NOLINT
+INSTANTIATE_TEST_CASE_P(HnswTest, HnswTestF, ::testing::ValuesIn(inputs));         // NOLINT
+
+}  // namespace raft::neighbors::hnsw
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/hybrid.cuh>
+#include <raft/neighbors/refine.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/sparse/neighbors/brute_force.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace raft::neighbors::hybrid {
+
+struct HybridInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  int n_terms;
+  int64_t dim;
+  int64_t k;
+  uint32_t n_sparse_candidates;
+  uint32_t n_dense_candidates;
+  fusion_method fusion;
+  bool refine;
+};
+
+inline auto operator<<(std::ostream& os, const HybridInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", n_terms=" << p.n_terms
+     << ", dim=" << p.dim << ", k=" << p.k << ", n_sparse=" << p.n_sparse_candidates
+     << ", n_dense=" << p.n_dense_candidates
+     << ", fusion=" << (p.fusion == fusion_method::kRRF ? "rrf" : "weighted")
+     << ", refine=" << p.refine << "}";
+  return os;
+}
+
+/** A random sparse matrix in the CSR format on the host. */
+struct host_csr {
+  std::vector<int> indptr;
+  std::vector<int> indices;
+  std::vector<float> values;
+};
+
+/** The fused scores of the best candidates of a query, computed from both candidate lists. */
+inline auto fuse_reference(const search_params& params,
+                           const std::vector<int64_t>& sparse_ids,
+                           const std::vector<float>& sparse_distances,
+                           const std::vector<int64_t>& dense_ids,
+                           const std::vector<float>& dense_distances,
+                           int64_t n_rows,
+                           int64_t k) -> std::vector<float>
+{
+  struct entry {
+    int64_t id;
+    float sim;
+  };
+  auto keep = [n_rows](const std::vector<int64_t>& ids,
+                       const std::vector<float>& distances,
+                       bool min_close) {
+    std::vector<entry> list;
+    std::set<int64_t> seen;
+    for (size_t i = 0; i < ids.size(); i++) {
+      if (ids[i] < 0 || ids[i] >= n_rows || !seen.insert(ids[i]).second) { continue; }
+      list.push_back({ids[i], min_close ? -distances[i] : distances[i]});
+    }
+    return list;
+  };
+  auto sparse = keep(sparse_ids, sparse_distances, distance::is_min_close(params.sparse_metric));
+  auto dense  = keep(dense_ids, dense_distances, distance::is_min_close(params.dense_metric));
+  auto component = [&params](const std::vector<entry>& list, size_t rank, float weight) {
+    if (params.fusion == fusion_method::kRRF) {
+      return weight / (params.rrf_constant + rank + 1);
+    }
+    float max_sim = list.front().sim;
+    float min_sim = list.front().sim;
+    for (const auto& e : list) {
+      max_sim = std::max(max_sim, e.sim);
+      min_sim = std::min(min_sim, e.sim);
+    }
+    float range = max_sim - min_sim;
+    return weight * (range > 0 ? (list[rank].sim - min_sim) / range : 1.0f);
+  };
+  std::unordered_map<int64_t, float> scores;
+  for (size_t r = 0; r < sparse.size(); r++) {
+    scores[sparse[r].id] += component(sparse, r, params.sparse_weight);
+  }
+  for (size_t r = 0; r < dense.size(); r++) {
+    scores[dense[r].id] += component(dense, r, params.dense_weight);
+  }
+  std::vector<float> best;
+  for (const auto& [id, score] : scores) {
+    best.push_back(score);
+  }
+  std::sort(best.begin(), best.end(), std::greater<float>());
+  best.resize(k, std::numeric_limits<float>::lowest());
+  return best;
+}
+
+class HybridTest : public ::testing::TestWithParam<HybridInputs> {
+ public:
+  HybridTest()
+    : params_(::testing::TestWithParam<HybridInputs>::GetParam()),
+      stream_(resource::get_cuda_stream(handle_))
+  {
+  }
+
+ protected:
+  auto make_csr(int64_t n, int nnz_per_row, uint64_t seed) -> host_csr
+  {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> term(0, params_.n_terms - 1);
+    std::uniform_real_distribution<float> weight(0.1f, 2.0f);
+    host_csr csr;
+    csr.indptr.push_back(0);
+    for (int64_t i = 0; i < n; i++) {
+      std::set<int> terms;
+      while (int(terms.size()) < nnz_per_row) {
+        terms.insert(term(rng));
+      }
+      for (int t : terms) {
+        csr.indices.push_back(t);
+        csr.values.push_back(weight(rng));
+      }
+      csr.indptr.push_back(csr.indices.size());
+    }
+    return csr;
+  }
+
+  template <typename T>
+  auto to_device(const std::vector<T>& v) -> rmm::device_uvector<T>
+  {
+    rmm::device_uvector<T> d(v.size(), stream_);
+    raft::copy(d.data(), v.data(), v.size(), stream_);
+    return d;
+  }
+
+  template <typename T>
+  auto to_host(const T* ptr, size_t size) -> std::vector<T>
+  {
+    std::vector<T> h(size);
+    raft::copy(h.data(), ptr, size, stream_);
+    resource::sync_stream(handle_);
+    return h;
+  }
+
+  void run()
+  {
+    auto n_rows = params_.n_rows;
+    auto n_q    = params_.n_queries;
+    auto k      = params_.k;
+    auto n_s    = params_.n_sparse_candidates;
+    auto n_d    = params_.n_dense_candidates;
+
+    auto docs_h         = make_csr(n_rows, 20, 42);
+    auto queries_h      = make_csr(n_q, 4, 7);
+    auto docs_indptr    = to_device(docs_h.indptr);
+    auto docs_indices   = to_device(docs_h.indices);
+    auto docs_values    = to_device(docs_h.values);
+    auto queries_indptr = to_device(queries_h.indptr);
+    auto queries_ind    = to_device(queries_h.indices);
+    auto queries_values = to_device(queries_h.values);
+    auto docs           = raft::make_device_csr_matrix_view<const float>(
+      docs_values.data(),
+      raft::make_device_compressed_structure_view<int, int, int>(docs_indptr.data(),
+                                                                 docs_indices.data(),
+                                                                 int(n_rows),
+                                                                 params_.n_terms,
+                                                                 int(docs_values.size())));
+    auto sparse_queries = raft::make_device_csr_matrix_view<const float>(
+      queries_values.data(),
+      raft::make_device_compressed_structure_view<int, int, int>(queries_indptr.data(),
+                                                                 queries_ind.data(),
+                                                                 int(n_q),
+                                                                 params_.n_terms,
+                                                                 int(queries_values.size())));
+
+    auto dataset       = raft::make_device_matrix<float, int64_t>(handle_, n_rows, params_.dim);
+    auto dense_queries = raft::make_device_matrix<float, int64_t>(handle_, n_q, params_.dim);
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, dataset.data_handle(), dataset.size(), -1.0f, 1.0f);
+    raft::random::uniform(
+      handle_, rng, dense_queries.data_handle(), dense_queries.size(), -1.0f, 1.0f);
+    auto index = brute_force::build(handle_, raft::make_const_mdspan(dataset.view()));
+    auto dense_search = [&index](const raft::resources& res, auto q, auto n, auto d) {
+      brute_force::search<float, int64_t>(res, index, q, n, d);
+    };
+
+    search_params params;
+    params.fusion              = params_.fusion;
+    params.sparse_weight       = 0.7f;
+    params.dense_weight        = 1.3f;
+    params.n_sparse_candidates = n_s;
+    params.n_dense_candidates  = n_d;
+    auto neighbors             = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q, k);
+    auto scores                = raft::make_device_matrix<float, int64_t>(handle_, n_q, k);
+    std::optional<raft::device_matrix_view<const float, int64_t, row_major>> dense_dataset;
+    if (params_.refine) { dense_dataset = raft::make_const_mdspan(dataset.view()); }
+    search<float, int64_t>(handle_,
+                           params,
+                           docs,
+                           sparse_queries,
+                           raft::make_const_mdspan(dense_queries.view()),
+                           dense_search,
+                           neighbors.view(),
+                           scores.view(),
+                           dense_dataset);
+
+    // The candidate lists of the reference are produced by the same searches.
+    auto sparse_ids       = raft::make_device_matrix<int, int64_t>(handle_, n_q, n_s);
+    auto sparse_distances = raft::make_device_matrix<float, int64_t>(handle_, n_q, n_s);
+    raft::sparse::neighbors::brute_force::knn<int, float>(docs_indptr.data(),
+                                                          docs_indices.data(),
+                                                          docs_values.data(),
+                                                          docs_values.size(),
+                                                          int(n_rows),
+                                                          params_.n_terms,
+                                                          queries_indptr.data(),
+                                                          queries_ind.data(),
+                                                          queries_values.data(),
+                                                          queries_values.size(),
+                                                          int(n_q),
+                                                          params_.n_terms,
+                                                          sparse_ids.data_handle(),
+                                                          sparse_distances.data_handle(),
+                                                          n_s,
+                                                          handle_,
+                                                          2 << 14,
+                                                          2 << 14,
+                                                          params.sparse_metric);
+    auto dense_ids       = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q, n_d);
+    auto dense_distances = raft::make_device_matrix<float, int64_t>(handle_, n_q, n_d);
+    dense_search(handle_,
+                 raft::make_const_mdspan(dense_queries.view()),
+                 dense_ids.view(),
+                 dense_distances.view());
+    auto sparse_ids_h       = to_host(sparse_ids.data_handle(), sparse_ids.size());
+    auto sparse_distances_h = to_host(sparse_distances.data_handle(), sparse_distances.size());
+    auto dense_ids_h        = to_host(dense_ids.data_handle(), dense_ids.size());
+    auto dense_distances_h  = to_host(dense_distances.data_handle(), dense_distances.size());
+    uint32_t n_dense_list   = n_d;
+    if (params_.refine) {
+      // The union of the candidates re-ranked by the exact dense distances
+      n_dense_list = n_s + n_d;
+      std::vector<int64_t> union_h(n_q * n_dense_list);
+      for (int64_t q = 0; q < n_q; q++) {
+        for (uint32_t j = 0; j < n_dense_list; j++) {
+          union_h[q * n_dense_list + j] =
+            j < n_s ? sparse_ids_h[q * n_s + j] : dense_ids_h[q * n_d + j - n_s];
+        }
+      }
+      auto candidates = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q, n_dense_list);
+      auto refined_ids = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q, n_dense_list);
+      auto refined_distances =
+        raft::make_device_matrix<float, int64_t>(handle_, n_q, n_dense_list);
+      raft::copy(candidates.data_handle(), union_h.data(), union_h.size(), stream_);
+      raft::neighbors::refine<int64_t, float, float, int64_t>(
+        handle_,
+        raft::make_const_mdspan(dataset.view()),
+        raft::make_const_mdspan(dense_queries.view()),
+        raft::make_const_mdspan(candidates.view()),
+        refined_ids.view(),
+        refined_distances.view(),
+        params.dense_metric);
+      dense_ids_h       = to_host(refined_ids.data_handle(), refined_ids.size());
+      dense_distances_h = to_host(refined_distances.data_handle(), refined_distances.size());
+    }
+
+    auto neighbors_h = to_host(neighbors.data_handle(), neighbors.size());
+    auto scores_h    = to_host(scores.data_handle(), scores.size());
+    for (int64_t q = 0; q < n_q; q++) {
+      auto row = [q](const auto& v, size_t n) {
+        return std::vector<int64_t>(v.begin() + q * n, v.begin() + (q + 1) * n);
+      };
+      std::vector<int64_t> s_ids = row(sparse_ids_h, n_s);
+      std::vector<float> s_dist(sparse_distances_h.begin() + q * n_s,
+                                sparse_distances_h.begin() + (q + 1) * n_s);
+      std::vector<int64_t> d_ids = row(dense_ids_h, n_dense_list);
+      std::vector<float> d_dist(dense_distances_h.begin() + q * n_dense_list,
+                                dense_distances_h.begin() + (q + 1) * n_dense_list);
+      auto expected = fuse_reference(params, s_ids, s_dist, d_ids, d_dist, n_rows, k);
+
+      std::set<int64_t> found;
+      for (int64_t j = 0; j < k; j++) {
+        auto score = scores_h[q * k + j];
+        auto id    = neighbors_h[q * k + j];
+        if (expected[j] == std::numeric_limits<float>::lowest()) {
+          ASSERT_EQ(score, expected[j]) << "query " << q << ", rank " << j;
+          ASSERT_EQ(id, std::numeric_limits<int64_t>::max()) << "query " << q << ", rank " << j;
+          continue;
+        }
+        ASSERT_NEAR(score, expected[j], 1e-5) << "query " << q << ", rank " << j;
+        ASSERT_TRUE(id >= 0 && id < n_rows) << "query " << q << ", rank " << j;
+        ASSERT_TRUE(found.insert(id).second) << "duplicate " << id << " of query " << q;
+      }
+    }
+  }
+
+  raft::resources handle_;
+  HybridInputs params_;
+  rmm::cuda_stream_view stream_;
+};
+
+const std::vector<HybridInputs> inputs = {
+  {2000, 100, 500, 16, 10, 50, 50, fusion_method::kRRF, false},
+  {2000, 100, 500, 16, 10, 50, 50, fusion_method::kWeighted, false},
+  {2000, 100, 500, 16, 10, 64, 64, fusion_method::kRRF, true},
+  {2000, 100, 500, 16, 10, 64, 64, fusion_method::kWeighted, true},
+  {5000, 300, 2000, 64, 32, 100, 200, fusion_method::kRRF, false},
+  {5000, 300, 2000, 64, 32, 128, 128, fusion_method::kWeighted, true},
+  // fewer distinct candidates than k
+  {1000, 50, 200, 8, 10, 5, 5, fusion_method::kRRF, false},
+  {1000, 50, 200, 8, 10, 5, 5, fusion_method::kWeighted, true}};
+
+TEST_P(HybridTest, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(HybridTest, HybridTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::hybrid
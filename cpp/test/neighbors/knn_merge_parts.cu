@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace raft::neighbors::brute_force {
+
+struct KnnMergePartsInputs {
+  int64_t n_samples;
+  int64_t n_parts;
+  int64_t k;
+  bool with_translations;
+  bool select_min = true;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const KnnMergePartsInputs& p)
+{
+  os << "{n_samples: " << p.n_samples << ", n_parts: " << p.n_parts << ", k: " << p.k
+     << ", with_translations: " << p.with_translations << ", select_min: " << p.select_min
+     << "}";
+  return os;
+}
+
+template <typename T, typename IdxT>
+class KnnMergePartsTest : public ::testing::TestWithParam<KnnMergePartsInputs> {
+ public:
+  KnnMergePartsTest()
+    : stream(resource::get_cuda_stream(handle)),
+      params(::testing::TestWithParam<KnnMergePartsInputs>::GetParam())
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    const int64_t part_size = params.n_samples * params.k;
+    const int64_t n_elems   = params.n_parts * part_size;
+
+    // The ids are chosen such that the (translated) id of a candidate is its position in the input.
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<T> value(0, 1000);
+    std::vector<T> keys_h(n_elems);
+    std::vector<IdxT> values_h(n_elems);
+    std::vector<IdxT> translations_h(params.n_parts);
+    for (int64_t i = 0; i < n_elems; i++) {
+      keys_h[i]   = value(gen);
+      values_h[i] = params.with_translations ? IdxT(i % part_size) : IdxT(i);
+    }
+    for (int64_t p = 0; p < params.n_parts; p++) {
+      translations_h[p] = IdxT(p * part_size);
+    }
+
+    const int64_t n_rows = params.n_parts * params.n_samples;
+    auto in_keys         = raft::make_device_matrix<T, IdxT>(handle, n_rows, params.k);
+    auto in_values       = raft::make_device_matrix<IdxT, IdxT>(handle, n_rows, params.k);
+    auto translations = raft::make_device_vector<IdxT, IdxT>(handle, params.n_parts);
+    auto out_keys     = raft::make_device_matrix<T, IdxT>(handle, params.n_samples, params.k);
+    auto out_values   = raft::make_device_matrix<IdxT, IdxT>(handle, params.n_samples, params.k);
+    raft::update_device(in_keys.data_handle(), keys_h.data(), n_elems, stream);
+    raft::update_device(in_values.data_handle(), values_h.data(), n_elems, stream);
+    raft::update_device(
+      translations.data_handle(), translations_h.data(), translations_h.size(), stream);
+
+    knn_merge_parts<T, IdxT>(
+      handle,
+      raft::make_const_mdspan(in_keys.view()),
+      raft::make_const_mdspan(in_values.view()),
+      out_keys.view(),
+      out_values.view(),
+      params.n_samples,
+      params.with_translations ? std::make_optional(translations.view()) : std::nullopt,
+      params.select_min);
+
+    std::vector<T> out_keys_h(out_keys.size());
+    std::vector<IdxT> out_values_h(out_values.size());
+    raft::update_host(out_keys_h.data(), out_keys.data_handle(), out_keys.size(), stream);
+    raft::update_host(out_values_h.data(), out_values.data_handle(), out_values.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    for (int64_t row = 0; row < params.n_samples; row++) {
+      std::vector<T> ref;
+      for (int64_t p = 0; p < params.n_parts; p++) {
+        auto begin = keys_h.begin() + p * part_size + row * params.k;
+        ref.insert(ref.end(), begin, begin + params.k);
+      }
+      if (params.select_min) {
+        std::sort(ref.begin(), ref.end());
+      } else {
+        std::sort(ref.begin(), ref.end(), std::greater<T>{});
+      }
+      for (int64_t j = 0; j < params.k; j++) {
+        const T key   = out_keys_h[row * params.k + j];
+        const IdxT id = out_values_h[row * params.k + j];
+        ASSERT_EQ(key, ref[j]) << "row " << row << ", position " << j;
+        ASSERT_TRUE(id >= 0 && id < n_elems) << "row " << row << ", position " << j;
+        ASSERT_EQ(keys_h[id], key) << "row " << row << ", position " << j;
+      }
+    }
+  }
+
+  raft::resources handle;
+  cudaStream_t stream;
+  KnnMergePartsInputs params;
+};
+
+const std::vector<KnnMergePartsInputs> inputs = {
+  {100, 2, 1, false},
+  {100, 2, 32, true},
+  {1000, 7, 10, true},
+  {50, 16, 300, false},
+  // k above 1024, which the block-select based merge did not support
+  {20, 5, 2000, true},
+  // many parts, merged in a tree of several levels
+  {10, 300, 512, true},
+  {30, 1000, 256, false},
+  // keeping the largest values (similarities)
+  {100, 2, 32, true, false},
+  {20, 5, 2000, false, false},
+  {10, 300, 512, true, false},
+};
+
+using KnnMergePartsTestF = KnnMergePartsTest<float, int64_t>;
+TEST_P(KnnMergePartsTestF, Result) { Run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(KnnMergePartsTest,     // NOLINT
+                        KnnMergePartsTestF,
+                        ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::brute_force
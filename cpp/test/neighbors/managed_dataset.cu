@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "ann_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/managed_dataset.hpp>
+#include <raft/random/rng.cuh>
+
+#include <rmm/mr/device/managed_memory_resource.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace raft::neighbors {
+
+TEST(ManagedDataset, CopyAndPrefetch)
+{
+  raft::resources res;
+  auto stream          = resource::get_cuda_stream(res);
+  const int64_t n_rows = 1000;
+  const int64_t dim    = 37;
+  auto src             = raft::make_host_matrix<float, int64_t>(n_rows, dim);
+  for (int64_t i = 0; i < src.size(); i++) {
+    src.data_handle()[i] = static_cast<float>(i);
+  }
+
+  auto dataset = make_managed_dataset(res, raft::make_const_mdspan(src.view()));
+  ASSERT_EQ(dataset->n_rows(), n_rows);
+  ASSERT_EQ(dataset->dim(), uint32_t(dim));
+  ASSERT_EQ(dataset->stride(), 40u);
+  ASSERT_TRUE(dataset->is_owning());
+
+  // Unsorted, duplicate and out-of-range ids
+  std::vector<int64_t> rows{999, 3, 3, 500, -1, n_rows, 0, 1, 2};
+  dataset->prefetch_rows(
+    res, raft::make_host_vector_view<const int64_t, int64_t>(rows.data(), rows.size()));
+  dataset->prefetch(res, 10, 20);
+  dataset->evict(res);
+  dataset->prefetch(res);
+
+  auto view = dataset->view();
+  std::vector<float> actual(n_rows * dim);
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(actual.data(),
+                                  dim * sizeof(float),
+                                  view.data_handle(),
+                                  view.stride(0) * sizeof(float),
+                                  dim * sizeof(float),
+                                  n_rows,
+                                  cudaMemcpyDefault,
+                                  stream));
+  resource::sync_stream(res);
+  std::vector<float> expected(src.data_handle(), src.data_handle() + src.size());
+  ASSERT_EQ(actual, expected);
+}
+
+TEST(ManagedDataset, PrefetchIvfLists)
+{
+  raft::resources res;
+  resource::set_ivf_list_resource(res, std::make_shared<rmm::mr::managed_memory_resource>());
+  auto stream             = resource::get_cuda_stream(res);
+  const int64_t n_rows    = 5000;
+  const int64_t n_queries = 100;
+  const int64_t dim       = 32;
+  const int64_t k         = 10;
+  const uint32_t n_lists  = 50;
+  auto dataset            = raft::make_device_matrix<float, int64_t>(res, n_rows, dim);
+  auto queries            = raft::make_device_matrix<float, int64_t>(res, n_queries, dim);
+  raft::random::RngState rng(1234ULL);
+  raft::random::uniform(res, rng, dataset.data_handle(), dataset.size(), -1.0f, 1.0f);
+  raft::random::uniform(res, rng, queries.data_handle(), queries.size(), -1.0f, 1.0f);
+
+  ivf_flat::index_params index_params;
+  index_params.n_lists = n_lists;
+  auto index = ivf_flat::build(res, index_params, raft::make_const_mdspan(dataset.view()));
+  std::vector<uint32_t> labels(n_lists);
+  for (uint32_t l = 0; l < n_lists; l++) {
+    labels[l] = l;
+  }
+  prefetch_lists(res,
+                 index.lists(),
+                 raft::make_host_vector_view<const uint32_t, int64_t>(labels.data(), n_lists));
+
+  // Probing all the lists gives the exact neighbors
+  ivf_flat::search_params search_params;
+  search_params.n_probes = n_lists;
+  auto neighbors         = raft::make_device_matrix<int64_t, int64_t>(res, n_queries, k);
+  auto distances         = raft::make_device_matrix<float, int64_t>(res, n_queries, k);
+  ivf_flat::search(res,
+                   search_params,
+                   index,
+                   raft::make_const_mdspan(queries.view()),
+                   neighbors.view(),
+                   distances.view());
+  auto exact_index     = brute_force::build(res, raft::make_const_mdspan(dataset.view()));
+  auto exact_neighbors = raft::make_device_matrix<int64_t, int64_t>(res, n_queries, k);
+  auto exact_distances = raft::make_device_matrix<float, int64_t>(res, n_queries, k);
+  brute_force::search<float, int64_t>(res,
+                                      exact_index,
+                                      raft::make_const_mdspan(queries.view()),
+                                      exact_neighbors.view(),
+                                      exact_distances.view());
+
+  std::vector<int64_t> actual_idx(neighbors.size());
+  std::vector<float> actual_dist(distances.size());
+  std::vector<int64_t> expected_idx(exact_neighbors.size());
+  std::vector<float> expected_dist(exact_distances.size());
+  raft::copy(actual_idx.data(), neighbors.data_handle(), neighbors.size(), stream);
+  raft::copy(actual_dist.data(), distances.data_handle(), distances.size(), stream);
+  raft::copy(expected_idx.data(), exact_neighbors.data_handle(), exact_neighbors.size(), stream);
+  raft::copy(expected_dist.data(), exact_distances.data_handle(), exact_distances.size(), stream);
+  resource::sync_stream(res);
+  ASSERT_TRUE(eval_neighbours(
+    expected_idx, actual_idx, expected_dist, actual_dist, n_queries, k, 0.001, 0.99));
+}
+
+}  // namespace raft::neighbors
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../loopback_comms.hpp"
+#include "../test_utils.cuh"
+#include "ann_utils.cuh"
+
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_resources.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/detail/multi_gpu.cuh>
+#include <raft/neighbors/detail/sharded_search.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::mg {
+
+struct MultiGpuInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  int64_t dim;
+  int64_t k;
+  int n_shards;
+  int64_t n_rows_per_batch;
+  raft::distance::DistanceType metric;
+};
+
+inline auto operator<<(std::ostream& os, const MultiGpuInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", dim=" << p.dim
+     << ", k=" << p.k << ", n_shards=" << p.n_shards << ", n_rows_per_batch=" << p.n_rows_per_batch
+     << ", metric=" << static_cast<int>(p.metric) << "}";
+  return os;
+}
+
+/**
+ * The multi-GPU searches run all their ranks or shards on the current device here: they must find
+ * the neighbors of a brute-force search over the whole dataset.
+ */
+template <typename T>
+class MultiGpuTest : public ::testing::TestWithParam<MultiGpuInputs> {
+ public:
+  MultiGpuTest()
+    : params_(::testing::TestWithParam<MultiGpuInputs>::GetParam()),
+      stream_(resource::get_cuda_stream(handle_)),
+      dataset_(raft::make_device_matrix<T, int64_t>(handle_, params_.n_rows, params_.dim)),
+      queries_(raft::make_device_matrix<T, int64_t>(handle_, params_.n_queries, params_.dim)),
+      queries_host_(raft::make_host_matrix<T, int64_t>(params_.n_queries, params_.dim))
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, dataset_.data_handle(), dataset_.size(), T(-1), T(1));
+    raft::random::uniform(handle_, rng, queries_.data_handle(), queries_.size(), T(-1), T(1));
+    raft::copy(queries_host_.data_handle(), queries_.data_handle(), queries_.size(), stream_);
+
+    const auto n_results = params_.n_queries * params_.k;
+    auto neighbors =
+      raft::make_device_matrix<int64_t, int64_t>(handle_, params_.n_queries, params_.k);
+    auto distances = raft::make_device_matrix<T, int64_t>(handle_, params_.n_queries, params_.k);
+    auto index =
+      brute_force::build(handle_, raft::make_const_mdspan(dataset_.view()), params_.metric);
+    brute_force::search<T, int64_t>(handle_,
+                                    index,
+                                    raft::make_const_mdspan(queries_.view()),
+                                    neighbors.view(),
+                                    distances.view());
+    neighbors_ref_.resize(n_results);
+    distances_ref_.resize(n_results);
+    raft::copy(neighbors_ref_.data(), neighbors.data_handle(), n_results, stream_);
+    raft::copy(distances_ref_.data(), distances.data_handle(), n_results, stream_);
+    resource::sync_stream(handle_);
+  }
+
+  /** The brute-force indices of the contiguous shards of the dataset and their first rows */
+  auto make_shards(int n_shards) -> std::vector<brute_force::index<T>>
+  {
+    std::vector<brute_force::index<T>> shards;
+    shard_offsets_.clear();
+    for (int i = 0; i < n_shards; i++) {
+      const int64_t begin = params_.n_rows * i / n_shards;
+      const int64_t end   = params_.n_rows * (i + 1) / n_shards;
+      shard_offsets_.push_back(begin);
+      shards.push_back(brute_force::build(handle_,
+                                          raft::make_device_matrix_view<const T, int64_t>(
+                                            dataset_.data_handle() + begin * params_.dim,
+                                            end - begin,
+                                            params_.dim),
+                                          params_.metric));
+    }
+    resource::sync_stream(handle_);
+    return shards;
+  }
+
+  void check(const std::vector<int64_t>& neighbors, const std::vector<T>& distances)
+  {
+    ASSERT_TRUE(eval_neighbours(neighbors_ref_,
+                                neighbors,
+                                distances_ref_,
+                                distances,
+                                params_.n_queries,
+                                params_.k,
+                                0.001,
+                                0.999));
+  }
+
+  /** The shared fan-out of the sharded indices, with peer copies between the shards. */
+  void testSearchShards()
+  {
+    auto shards = make_shards(params_.n_shards);
+    std::vector<raft::resources> shard_res(params_.n_shards);
+    std::vector<int> device_ids(params_.n_shards, device_setter::get_current_device());
+
+    const auto n_results = params_.n_queries * params_.k;
+    auto neighbors       = raft::make_device_vector<int64_t, int64_t>(handle_, n_results);
+    auto distances       = raft::make_device_vector<T, int64_t>(handle_, n_results);
+    raft::neighbors::detail::search_shards<T, int64_t, int64_t>(
+      handle_,
+      device_ids,
+      [&](size_t i) -> raft::resources const& { return shard_res[i]; },
+      [&](raft::resources const& res,
+          size_t i,
+          raft::device_matrix_view<const T, int64_t, row_major> q,
+          raft::device_matrix_view<int64_t, int64_t, row_major> n,
+          raft::device_matrix_view<T, int64_t, row_major> d) {
+        brute_force::search<T, int64_t>(res, shards[i], q, n, d);
+      },
+      queries_.data_handle(),
+      params_.n_queries,
+      params_.dim,
+      params_.k,
+      neighbors.data_handle(),
+      distances.data_handle(),
+      params_.n_rows_per_batch,
+      std::make_optional(shard_offsets_),
+      raft::distance::is_min_close(params_.metric),
+      false);
+
+    std::vector<int64_t> neighbors_host(n_results);
+    std::vector<T> distances_host(n_results);
+    raft::copy(neighbors_host.data(), neighbors.data_handle(), n_results, stream_);
+    raft::copy(distances_host.data(), distances.data_handle(), n_results, stream_);
+    resource::sync_stream(handle_);
+    check(neighbors_host, distances_host);
+  }
+
+  /** mg::search_sharded over a single rank with a loopback communicator */
+  void testSearchSharded()
+  {
+    auto shards = make_shards(1);
+    std::vector<raft::device_resources> dev_res(1);
+    resource::set_comms(dev_res[0],
+                        std::make_shared<comms::comms_t>(std::make_unique<loopback_comms>()));
+
+    const auto n_results = params_.n_queries * params_.k;
+    auto neighbors = raft::make_host_matrix<int64_t, int64_t>(params_.n_queries, params_.k);
+    auto distances = raft::make_host_matrix<T, int64_t>(params_.n_queries, params_.k);
+    detail::search_sharded<T, int64_t>(
+      {device_setter::get_current_device()},
+      dev_res,
+      0,
+      shards,
+      [](const raft::device_resources& res, const auto& index, auto q, auto n, auto d) {
+        brute_force::search<T, int64_t>(res, index, q, n, d);
+      },
+      raft::make_const_mdspan(queries_host_.view()),
+      neighbors.view(),
+      distances.view(),
+      params_.n_rows_per_batch,
+      std::make_optional(shard_offsets_),
+      raft::distance::is_min_close(params_.metric));
+    check(std::vector<int64_t>(neighbors.data_handle(), neighbors.data_handle() + n_results),
+          std::vector<T>(distances.data_handle(), distances.data_handle() + n_results));
+  }
+
+  /** mg::search_replicated with every rank holding the whole index */
+  void testSearchReplicated()
+  {
+    std::vector<brute_force::index<T>> indices;
+    for (int i = 0; i < params_.n_shards; i++) {
+      indices.push_back(brute_force::build(
+        handle_, raft::make_const_mdspan(dataset_.view()), params_.metric));
+    }
+    resource::sync_stream(handle_);
+    std::vector<raft::device_resources> dev_res(params_.n_shards);
+    std::vector<int> device_ids(params_.n_shards, device_setter::get_current_device());
+
+    const auto n_results = params_.n_queries * params_.k;
+    auto neighbors = raft::make_host_matrix<int64_t, int64_t>(params_.n_queries, params_.k);
+    auto distances = raft::make_host_matrix<T, int64_t>(params_.n_queries, params_.k);
+    detail::search_replicated<T, int64_t>(
+      device_ids,
+      dev_res,
+      indices,
+      [](const raft::device_resources& res, const auto& index, auto q, auto n, auto d) {
+        brute_force::search<T, int64_t>(res, index, q, n, d);
+      },
+      raft::make_const_mdspan(queries_host_.view()),
+      neighbors.view(),
+      distances.view(),
+      params_.n_rows_per_batch);
+    check(std::vector<int64_t>(neighbors.data_handle(), neighbors.data_handle() + n_results),
+          std::vector<T>(distances.data_handle(), distances.data_handle() + n_results));
+  }
+
+  MultiGpuInputs params_;
+  raft::resources handle_;
+  cudaStream_t stream_;
+  raft::device_matrix<T, int64_t> dataset_;
+  raft::device_matrix<T, int64_t> queries_;
+  raft::host_matrix<T, int64_t> queries_host_;
+  std::vector<int64_t> neighbors_ref_;
+  std::vector<T> distances_ref_;
+  std::vector<int64_t> shard_offsets_;
+};
+
+const std::vector<MultiGpuInputs> inputs = {
+  {1000, 100, 16, 10, 2, 100, raft::distance::DistanceType::L2Expanded},
+  {1000, 100, 16, 10, 3, 32, raft::distance::DistanceType::InnerProduct},
+  {5000, 77, 64, 32, 4, 10, raft::distance::DistanceType::L2SqrtExpanded},
+  {5000, 1, 64, 32, 5, 1000, raft::distance::DistanceType::InnerProduct},
+  {300, 500, 8, 100, 3, 128, raft::distance::DistanceType::L2Unexpanded}};
+
+using MultiGpuTestF = MultiGpuTest<float>;
+TEST_P(MultiGpuTestF, SearchShards) { this->testSearchShards(); }          // NOLINT
+TEST_P(MultiGpuTestF, SearchSharded) { this->testSearchSharded(); }        // NOLINT
+TEST_P(MultiGpuTestF, SearchReplicated) { this->testSearchReplicated(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(MultiGpuTest, MultiGpuTestF, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::mg
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/multi_vector.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace raft::neighbors::multi_vector {
+
+struct MultiVectorInputs {
+  int64_t n_docs;
+  // the documents have from zero to this many tokens
+  int max_doc_tokens;
+  int64_t dim;
+  int64_t n_queries;
+  int64_t n_query_tokens;
+  int64_t k;
+  // zero means all the tokens, then the MaxSim of the candidates is exact
+  uint32_t n_token_candidates;
+  bool rerank;
+  raft::distance::DistanceType metric;
+};
+
+inline auto operator<<(std::ostream& os, const MultiVectorInputs& p) -> std::ostream&
+{
+  os << "{n_docs=" << p.n_docs << ", max_doc_tokens=" << p.max_doc_tokens << ", dim=" << p.dim
+     << ", n_queries=" << p.n_queries << ", n_query_tokens=" << p.n_query_tokens
+     << ", k=" << p.k << ", n_token_candidates=" << p.n_token_candidates
+     << ", rerank=" << p.rerank << ", metric=" << int(p.metric) << "}";
+  return os;
+}
+
+class MultiVectorTest : public ::testing::TestWithParam<MultiVectorInputs> {
+ public:
+  MultiVectorTest() : params_(::testing::TestWithParam<MultiVectorInputs>::GetParam()) {}
+
+ protected:
+  auto similarity(const float* a, const float* b) -> double
+  {
+    double sim = 0;
+    for (int64_t d = 0; d < params_.dim; d++) {
+      sim += params_.metric == raft::distance::DistanceType::InnerProduct
+               ? double(a[d]) * b[d]
+               : -(double(a[d]) - b[d]) * (double(a[d]) - b[d]);
+    }
+    return sim;
+  }
+
+  void run()
+  {
+    auto stream = resource::get_cuda_stream(handle_);
+    auto n_q    = params_.n_queries;
+    auto n_qt   = params_.n_query_tokens;
+    auto k      = params_.k;
+    auto dim    = params_.dim;
+
+    std::mt19937_64 rng_h(42);
+    std::uniform_int_distribution<int> doc_size(0, params_.max_doc_tokens);
+    std::vector<int64_t> offsets_h{0};
+    for (int64_t i = 0; i < params_.n_docs; i++) {
+      offsets_h.push_back(offsets_h.back() + doc_size(rng_h));
+    }
+    auto n_tokens = offsets_h.back();
+    auto offsets  = raft::make_device_vector<int64_t, int64_t>(handle_, offsets_h.size());
+    raft::copy(offsets.data_handle(), offsets_h.data(), offsets_h.size(), stream);
+
+    auto tokens  = raft::make_device_matrix<float, int64_t>(handle_, n_tokens, dim);
+    auto queries = raft::make_device_matrix<float, int64_t>(handle_, n_q * n_qt, dim);
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, tokens.data_handle(), tokens.size(), -1.0f, 1.0f);
+    raft::random::uniform(handle_, rng, queries.data_handle(), queries.size(), -1.0f, 1.0f);
+    auto token_index =
+      brute_force::build(handle_, raft::make_const_mdspan(tokens.view()), params_.metric);
+    auto token_search = [&token_index](const raft::resources& res, auto q, auto n, auto d) {
+      brute_force::search<float, int64_t>(res, token_index, q, n, d);
+    };
+
+    auto index = build(handle_, raft::make_const_mdspan(offsets.view()));
+    ASSERT_EQ(index.n_docs(), params_.n_docs);
+    ASSERT_EQ(index.n_tokens(), n_tokens);
+
+    search_params search_params;
+    search_params.metric              = params_.metric;
+    search_params.n_token_candidates  = params_.n_token_candidates == 0
+                                          ? uint32_t(n_tokens)
+                                          : params_.n_token_candidates;
+    search_params.n_rerank_candidates = 4 * k;
+    auto neighbors = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q, k);
+    auto scores    = raft::make_device_matrix<float, int64_t>(handle_, n_q, k);
+    std::optional<raft::device_matrix_view<const float, int64_t, row_major>> token_dataset;
+    if (params_.rerank) { token_dataset = raft::make_const_mdspan(tokens.view()); }
+    search<float, int64_t>(handle_,
+                           search_params,
+                           index,
+                           token_search,
+                           raft::make_const_mdspan(queries.view()),
+                           n_qt,
+                           neighbors.view(),
+                           scores.view(),
+                           token_dataset);
+
+    // The candidates of the approximate MaxSim are produced by the same token search.
+    auto n_cand          = search_params.n_token_candidates;
+    auto token_ids       = raft::make_device_matrix<int64_t, int64_t>(handle_, n_q * n_qt, n_cand);
+    auto token_distances = raft::make_device_matrix<float, int64_t>(handle_, n_q * n_qt, n_cand);
+    token_search(handle_,
+                 raft::make_const_mdspan(queries.view()),
+                 token_ids.view(),
+                 token_distances.view());
+
+    std::vector<float> tokens_h(tokens.size());
+    std::vector<float> queries_h(queries.size());
+    std::vector<int64_t> token_ids_h(token_ids.size());
+    std::vector<float> token_distances_h(token_distances.size());
+    std::vector<int64_t> neighbors_h(neighbors.size());
+    std::vector<float> scores_h(scores.size());
+    raft::copy(tokens_h.data(), tokens.data_handle(), tokens.size(), stream);
+    raft::copy(queries_h.data(), queries.data_handle(), queries.size(), stream);
+    raft::copy(token_ids_h.data(), token_ids.data_handle(), token_ids.size(), stream);
+    raft::copy(
+      token_distances_h.data(), token_distances.data_handle(), token_distances.size(), stream);
+    raft::copy(neighbors_h.data(), neighbors.data_handle(), neighbors.size(), stream);
+    raft::copy(scores_h.data(), scores.data_handle(), scores.size(), stream);
+    resource::sync_stream(handle_);
+
+    std::vector<int64_t> token_docs(n_tokens);
+    for (int64_t d = 0; d < params_.n_docs; d++) {
+      std::fill(token_docs.begin() + offsets_h[d], token_docs.begin() + offsets_h[d + 1], d);
+    }
+    auto exact_maxsim = [&](int64_t q, int64_t doc) {
+      double sum = 0;
+      for (int64_t t = 0; t < n_qt; t++) {
+        double best = std::numeric_limits<double>::lowest();
+        for (int64_t j = offsets_h[doc]; j < offsets_h[doc + 1]; j++) {
+          best = std::max(best, similarity(&queries_h[(q * n_qt + t) * dim], &tokens_h[j * dim]));
+        }
+        sum += best;
+      }
+      return sum;
+    };
+    const bool min_close = raft::distance::is_min_close(params_.metric);
+    auto tolerance       = [](double x) { return 1e-4 * std::max(10.0, std::abs(x)); };
+
+    for (int64_t q = 0; q < n_q; q++) {
+      // The approximate MaxSim of the documents found by the token search
+      std::map<int64_t, std::map<int64_t, float>> best;
+      for (int64_t t = 0; t < n_qt; t++) {
+        for (uint32_t j = 0; j < n_cand; j++) {
+          auto e     = (q * n_qt + t) * n_cand + j;
+          auto token = token_ids_h[e];
+          if (token < 0 || token >= n_tokens) { continue; }
+          float sim  = min_close ? -token_distances_h[e] : token_distances_h[e];
+          auto& slot = best[token_docs[token]];
+          if (slot.count(t) == 0 || slot[t] < sim) { slot[t] = sim; }
+        }
+      }
+      std::vector<double> expected;
+      for (const auto& [doc, per_token] : best) {
+        if (params_.rerank || params_.n_token_candidates == 0) {
+          expected.push_back(exact_maxsim(q, doc));
+        } else {
+          double sum = 0;
+          for (const auto& token_sim : per_token) {
+            sum += token_sim.second;
+          }
+          expected.push_back(sum);
+        }
+      }
+      std::sort(expected.begin(), expected.end(), std::greater<double>());
+
+      std::set<int64_t> found;
+      for (int64_t j = 0; j < k; j++) {
+        auto score = scores_h[q * k + j];
+        auto id    = neighbors_h[q * k + j];
+        if (j >= int64_t(expected.size())) {
+          ASSERT_EQ(score, std::numeric_limits<float>::lowest()) << "query " << q << ", " << j;
+          ASSERT_EQ(id, std::numeric_limits<int64_t>::max()) << "query " << q << ", " << j;
+          continue;
+        }
+        ASSERT_TRUE(id >= 0 && id < params_.n_docs) << "query " << q << ", rank " << j;
+        ASSERT_TRUE(found.insert(id).second) << "duplicate " << id << " of query " << q;
+        if (params_.rerank) {
+          // The re-scored documents get their exact MaxSim.
+          auto exact = exact_maxsim(q, id);
+          ASSERT_NEAR(score, exact, tolerance(exact)) << "query " << q << ", rank " << j;
+          if (j > 0) { ASSERT_LE(score, scores_h[q * k + j - 1]); }
+        }
+        // Without the re-scoring, or when all tokens are candidates, the order is exact.
+        if (!params_.rerank || params_.n_token_candidates == 0) {
+          ASSERT_NEAR(score, expected[j], tolerance(expected[j]))
+            << "query " << q << ", rank " << j;
+        }
+      }
+    }
+  }
+
+  raft::resources handle_;
+  MultiVectorInputs params_;
+};
+
+const std::vector<MultiVectorInputs> inputs = {
+  // all tokens are candidates: the exact MaxSim
+  {200, 8, 16, 20, 4, 10, 0, false, raft::distance::DistanceType::InnerProduct},
+  {200, 8, 16, 20, 4, 10, 0, true, raft::distance::DistanceType::InnerProduct},
+  {100, 5, 8, 10, 3, 5, 0, false, raft::distance::DistanceType::L2Expanded},
+  // the approximate MaxSim
+  {1000, 16, 32, 50, 8, 10, 32, false, raft::distance::DistanceType::InnerProduct},
+  {1000, 16, 32, 50, 8, 10, 32, false, raft::distance::DistanceType::L2Expanded},
+  {2000, 32, 64, 30, 32, 20, 16, false, raft::distance::DistanceType::InnerProduct},
+  // the approximate candidates re-scored exactly
+  {1000, 16, 32, 50, 8, 10, 32, true, raft::distance::DistanceType::InnerProduct},
+  {1000, 16, 32, 50, 8, 10, 16, true, raft::distance::DistanceType::L2Expanded},
+  // fewer documents found than k
+  {500, 4, 16, 20, 1, 10, 3, false, raft::distance::DistanceType::InnerProduct},
+  {500, 4, 16, 20, 2, 10, 2, true, raft::distance::DistanceType::InnerProduct}};
+
+TEST_P(MultiVectorTest, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(MultiVectorTest, MultiVectorTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::multi_vector
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/query_cache.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace raft::neighbors::query_cache {
+
+struct QueryCacheInputs {
+  int64_t n_rows;
+  int64_t dim;
+  int64_t k;
+  // the number of the distinct queries
+  int64_t n_unique;
+  // the number of the queries of a batch; they repeat the distinct queries
+  int64_t n_queries;
+  int64_t capacity;
+  uint32_t associativity;
+  float quantization_step;
+};
+
+inline auto operator<<(std::ostream& os, const QueryCacheInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", dim=" << p.dim << ", k=" << p.k
+     << ", n_unique=" << p.n_unique << ", n_queries=" << p.n_queries
+     << ", capacity=" << p.capacity << ", associativity=" << p.associativity
+     << ", quantization_step=" << p.quantization_step << "}";
+  return os;
+}
+
+class QueryCacheTest : public ::testing::TestWithParam<QueryCacheInputs> {
+ public:
+  QueryCacheTest() : params_(::testing::TestWithParam<QueryCacheInputs>::GetParam()) {}
+
+ protected:
+  /**
+   * The batch of the queries repeating the distinct ones. With the quantization, the distinct
+   * queries lie on the quantization grid, and the repeats are perturbed within a quarter step.
+   */
+  auto make_queries(uint64_t seed, bool perturb) -> std::vector<float>
+  {
+    std::mt19937_64 rng(1234ULL);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    auto step = params_.quantization_step;
+    std::vector<float> unique(params_.n_unique * params_.dim);
+    for (auto& x : unique) {
+      x = value(rng);
+      if (step > 0) { x = std::round(x / step) * step; }
+    }
+    std::mt19937_64 noise_rng(seed);
+    std::uniform_real_distribution<float> noise(-0.25f * step, 0.25f * step);
+    std::vector<float> queries(params_.n_queries * params_.dim);
+    for (int64_t i = 0; i < params_.n_queries; i++) {
+      for (int64_t j = 0; j < params_.dim; j++) {
+        auto x = unique[(i % params_.n_unique) * params_.dim + j];
+        queries[i * params_.dim + j] = perturb && step > 0 ? x + noise(noise_rng) : x;
+      }
+    }
+    return queries;
+  }
+
+  void check_batch(cache<float, int64_t>& c,
+                   const std::vector<float>& queries_h,
+                   const raft::device_matrix<int64_t, int64_t>& neighbors_ref,
+                   const raft::device_matrix<float, int64_t>& distances_ref)
+  {
+    auto stream    = resource::get_cuda_stream(handle_);
+    auto n_queries = params_.n_queries;
+    auto k         = params_.k;
+    auto queries   = raft::make_device_matrix<float, int64_t>(handle_, n_queries, params_.dim);
+    auto neighbors = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances = raft::make_device_matrix<float, int64_t>(handle_, n_queries, k);
+    raft::copy(queries.data_handle(), queries_h.data(), queries_h.size(), stream);
+    c.search(handle_, raft::make_const_mdspan(queries.view()), neighbors.view(), distances.view());
+
+    ASSERT_TRUE(devArrMatch(neighbors_ref.data_handle(),
+                            neighbors.data_handle(),
+                            neighbors.size(),
+                            Compare<int64_t>(),
+                            stream));
+    ASSERT_TRUE(devArrMatch(distances_ref.data_handle(),
+                            distances.data_handle(),
+                            distances.size(),
+                            CompareApprox<float>(1e-4),
+                            stream));
+  }
+
+  void run()
+  {
+    auto stream    = resource::get_cuda_stream(handle_);
+    auto n_queries = params_.n_queries;
+    auto k         = params_.k;
+    auto dataset   = raft::make_device_matrix<float, int64_t>(handle_, params_.n_rows, params_.dim);
+    raft::random::RngState rng(42ULL);
+    raft::random::uniform(handle_, rng, dataset.data_handle(), dataset.size(), -1.0f, 1.0f);
+    auto index = brute_force::build(handle_, raft::make_const_mdspan(dataset.view()));
+
+    // The reference results of the unperturbed queries
+    auto queries_h     = make_queries(0, false);
+    auto queries       = raft::make_device_matrix<float, int64_t>(handle_, n_queries, params_.dim);
+    auto neighbors_ref = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances_ref = raft::make_device_matrix<float, int64_t>(handle_, n_queries, k);
+    raft::copy(queries.data_handle(), queries_h.data(), queries_h.size(), stream);
+    brute_force::search<float, int64_t>(handle_,
+                                        index,
+                                        raft::make_const_mdspan(queries.view()),
+                                        neighbors_ref.view(),
+                                        distances_ref.view());
+
+    int64_t n_upstream = 0;
+    cache<float, int64_t> c(
+      handle_,
+      cache_params{params_.capacity, params_.associativity, params_.quantization_step},
+      params_.dim,
+      k,
+      [&index, &n_upstream](const raft::resources& res, auto q, auto n, auto d) {
+        n_upstream += q.extent(0);
+        brute_force::search<float, int64_t>(res, index, q, n, d);
+      });
+    ASSERT_GE(c.size(), params_.capacity);
+
+    // The first batch misses everything, including the repeats within the batch.
+    check_batch(c, queries_h, neighbors_ref, distances_ref);
+    ASSERT_EQ(c.hits(), 0);
+    ASSERT_EQ(c.misses(), n_queries);
+    ASSERT_EQ(n_upstream, n_queries);
+
+    // The next batches are answered from the cache (apart from the set overflows).
+    for (uint64_t seed = 1; seed <= 2; seed++) {
+      auto hits_before = c.hits();
+      check_batch(c, make_queries(seed, true), neighbors_ref, distances_ref);
+      ASSERT_GE(c.hits() - hits_before, int64_t(0.9 * n_queries));
+      ASSERT_EQ(c.hits() + c.misses(), (seed + 1) * n_queries);
+      ASSERT_EQ(n_upstream, c.misses());
+    }
+
+    // Nothing is found after clearing the cache.
+    c.clear(handle_);
+    auto misses_before = c.misses();
+    check_batch(c, queries_h, neighbors_ref, distances_ref);
+    ASSERT_EQ(c.misses() - misses_before, n_queries);
+  }
+
+  raft::resources handle_;
+  QueryCacheInputs params_;
+};
+
+const std::vector<QueryCacheInputs> inputs = {
+  // exact matches
+  {5000, 32, 10, 100, 400, 4096, 8, 0.0f},
+  {5000, 7, 1, 1000, 1000, 65536, 16, 0.0f},
+  {2000, 128, 32, 50, 1000, 1024, 1, 0.0f},
+  // near-duplicates
+  {5000, 16, 10, 200, 1000, 4096, 8, 0.05f},
+  {5000, 3, 5, 300, 600, 8192, 32, 0.01f}};
+
+TEST_P(QueryCacheTest, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(QueryCacheTest, QueryCacheTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::query_cache
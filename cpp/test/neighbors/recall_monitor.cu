@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/recall_monitor.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace raft::neighbors::recall_monitoring {
+
+struct RecallMonitorInputs {
+  int64_t n_rows;
+  int64_t n_queries;
+  int64_t dim;
+  int64_t k;
+  // the number of the correct neighbors per query in the "approximate" results
+  int64_t n_correct;
+  double sample_fraction;
+  int64_t max_batch_size;
+  int64_t window_size;
+};
+
+inline auto operator<<(std::ostream& os, const RecallMonitorInputs& p) -> std::ostream&
+{
+  os << "{n_rows=" << p.n_rows << ", n_queries=" << p.n_queries << ", dim=" << p.dim
+     << ", k=" << p.k << ", n_correct=" << p.n_correct << ", fraction=" << p.sample_fraction
+     << ", max_batch_size=" << p.max_batch_size << ", window_size=" << p.window_size << "}";
+  return os;
+}
+
+class RecallMonitorTest : public ::testing::TestWithParam<RecallMonitorInputs> {
+ public:
+  RecallMonitorTest() : params_(::testing::TestWithParam<RecallMonitorInputs>::GetParam()) {}
+
+ protected:
+  void run()
+  {
+    auto stream    = resource::get_cuda_stream(handle_);
+    auto n_queries = params_.n_queries;
+    auto k         = params_.k;
+    auto dataset = raft::make_device_matrix<float, int64_t>(handle_, params_.n_rows, params_.dim);
+    auto queries = raft::make_device_matrix<float, int64_t>(handle_, n_queries, params_.dim);
+    raft::random::RngState rng(1234ULL);
+    raft::random::uniform(handle_, rng, dataset.data_handle(), dataset.size(), -1.0f, 1.0f);
+    raft::random::uniform(handle_, rng, queries.data_handle(), queries.size(), -1.0f, 1.0f);
+    auto index = brute_force::build(handle_, raft::make_const_mdspan(dataset.view()));
+
+    // The "approximate" results: the exact ones with all but `n_correct` neighbors spoiled
+    auto neighbors = raft::make_device_matrix<int64_t, int64_t>(handle_, n_queries, k);
+    auto distances = raft::make_device_matrix<float, int64_t>(handle_, n_queries, k);
+    brute_force::search<float, int64_t>(handle_,
+                                        index,
+                                        raft::make_const_mdspan(queries.view()),
+                                        neighbors.view(),
+                                        distances.view());
+    auto neighbors_h = raft::make_host_matrix<int64_t, int64_t>(n_queries, k);
+    raft::copy(neighbors_h.data_handle(), neighbors.data_handle(), neighbors.size(), stream);
+    resource::sync_stream(handle_);
+    for (int64_t i = 0; i < n_queries; i++) {
+      for (int64_t j = params_.n_correct; j < k; j++) {
+        neighbors_h(i, j) = params_.n_rows + j;
+      }
+    }
+    raft::copy(neighbors.data_handle(), neighbors_h.data_handle(), neighbors.size(), stream);
+
+    monitor_params monitor_params;
+    monitor_params.sample_fraction = params_.sample_fraction;
+    monitor_params.max_batch_size  = params_.max_batch_size;
+    monitor_params.window_size     = params_.window_size;
+    monitor<float, int64_t> monitor(handle_, monitor_params, index, k);
+    ASSERT_TRUE(std::isnan(monitor.stats().recall));
+
+    // Observe the results by batches, waiting for every shadow search to have no drops
+    int64_t expected_sampled = 0;
+    double budget            = 0;
+    const int64_t batch_size = 100;
+    for (int64_t offset = 0; offset < n_queries; offset += batch_size) {
+      auto n = std::min(batch_size, n_queries - offset);
+      monitor.observe(handle_,
+                      raft::make_device_matrix_view<const float, int64_t>(
+                        queries.data_handle() + offset * params_.dim, n, params_.dim),
+                      raft::make_device_matrix_view<const int64_t, int64_t>(
+                        neighbors.data_handle() + offset * k, n, k));
+      budget = std::min<double>(budget + n * params_.sample_fraction, params_.max_batch_size);
+      auto m = std::min<int64_t>(n, static_cast<int64_t>(budget));
+      budget -= m;
+      expected_sampled += m;
+      auto stats = monitor.wait_stats();
+      ASSERT_EQ(stats.sampled_queries, expected_sampled);
+      ASSERT_EQ(stats.dropped_queries, 0);
+      ASSERT_LE(stats.window_queries, params_.window_size + params_.max_batch_size);
+      if (stats.sampled_queries > 0) {
+        ASSERT_NEAR(stats.recall, double(params_.n_correct) / double(k), 1e-6);
+      }
+    }
+    ASSERT_GT(expected_sampled, 0);
+
+    // Without waiting, the samples coming while a shadow search is running are dropped.
+    int64_t total = monitor.stats().sampled_queries + monitor.stats().dropped_queries;
+    for (int i = 0; i < 10; i++) {
+      monitor.observe(handle_,
+                      raft::make_const_mdspan(queries.view()),
+                      raft::make_const_mdspan(neighbors.view()));
+    }
+    auto stats = monitor.wait_stats();
+    ASSERT_GT(stats.sampled_queries + stats.dropped_queries, total);
+    ASSERT_NEAR(stats.recall, double(params_.n_correct) / double(k), 1e-6);
+  }
+
+  raft::resources handle_;
+  RecallMonitorInputs params_;
+};
+
+const std::vector<RecallMonitorInputs> inputs = {{2000, 1000, 16, 10, 10, 1.0, 100, 300},
+                                                 {2000, 1000, 16, 10, 5, 0.5, 64, 100},
+                                                 {5000, 1000, 32, 32, 8, 0.05, 16, 1000},
+                                                 {1000, 500, 8, 4, 0, 0.3, 256, 10000}};
+
+TEST_P(RecallMonitorTest, Result) { this->run(); }
+INSTANTIATE_TEST_CASE_P(RecallMonitorTest, RecallMonitorTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::recall_monitoring
@@ -23,6 +23,7 @@
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/detail/refine.cuh>
 #include <raft/neighbors/refine.cuh>
+#include <raft/neighbors/refine_file.hpp>
 #include <raft/spatial/knn/ann.cuh>
 #include <raft/util/itertools.hpp>
 
@@ -32,6 +33,10 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
 #include <vector>
 
 namespace raft::neighbors {
@@ -98,14 +103,58 @@ class RefineTest : public ::testing::TestWithParam<RefineInputs<IdxT>> {
                                                  min_recall));
   }
 
+  void testRefineFile()
+  {
+    if (!data.p.host_data) { GTEST_SKIP(); }
+    resource::sync_stream(handle_);
+    char path[] = "/tmp/raft_refine_XXXXXX";
+    int fd      = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    FILE* file = fdopen(fd, "wb");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(
+      std::fwrite(data.dataset_host.data_handle(), sizeof(DataT), data.dataset_host.size(), file),
+      data.dataset_host.size());
+    std::fclose(file);
+
+    std::vector<IdxT> indices(data.p.n_queries * data.p.k);
+    std::vector<DistanceT> distances(data.p.n_queries * data.p.k);
+    {
+      raft::neighbors::file_dataset<DataT, IdxT> dataset(path, data.p.n_rows, data.p.dim);
+      // Several batches of queries
+      const size_t max_batch_bytes = 5 * data.p.k0 * dataset.row_bytes();
+      raft::neighbors::refine<IdxT, DataT, DistanceT, IdxT>(
+        handle_,
+        dataset,
+        data.queries_host.view(),
+        data.candidates_host.view(),
+        raft::make_host_matrix_view<IdxT, IdxT>(indices.data(), data.p.n_queries, data.p.k),
+        raft::make_host_matrix_view<DistanceT, IdxT>(distances.data(), data.p.n_queries, data.p.k),
+        data.p.metric,
+        max_batch_bytes);
+    }
+    unlink(path);
+
+    double min_recall = 1;
+
+    ASSERT_TRUE(raft::neighbors::eval_neighbours(data.true_refined_indices_host,
+                                                 indices,
+                                                 data.true_refined_distances_host,
+                                                 distances,
+                                                 data.p.n_queries,
+                                                 data.p.k,
+                                                 0.001,
+                                                 min_recall));
+  }
+
  public:
   raft::resources handle_;
   rmm::cuda_stream_view stream_;
   RefineHelper<DataT, DistanceT, IdxT> data;
 };
 
-const std::vector<RefineInputs<int64_t>> inputs =
-  raft::util::itertools::product<RefineInputs<int64_t>>(
+const std::vector<RefineInputs<int64_t>> inputs = []() {
+  auto inputs = raft::util::itertools::product<RefineInputs<int64_t>>(
     {static_cast<int64_t>(137)},
     {static_cast<int64_t>(1000)},
     {static_cast<int64_t>(16)},
@@ -113,14 +162,28 @@ const std::vector<RefineInputs<int64_t>> inputs =
     {static_cast<int64_t>(33)},
     {raft::distance::DistanceType::L2Expanded, raft::distance::DistanceType::InnerProduct},
     {false, true});
+  // The dimensions not divisible by the vector loads, and the capacities of the device top-k
+  auto device_inputs = raft::util::itertools::product<RefineInputs<int64_t>>(
+    {static_cast<int64_t>(137)},
+    {static_cast<int64_t>(1000)},
+    {static_cast<int64_t>(1), static_cast<int64_t>(3), static_cast<int64_t>(130)},
+    {static_cast<int64_t>(7), static_cast<int64_t>(100), static_cast<int64_t>(256)},
+    {static_cast<int64_t>(300)},
+    {raft::distance::DistanceType::L2Expanded, raft::distance::DistanceType::InnerProduct},
+    {false});
+  inputs.insert(inputs.end(), device_inputs.begin(), device_inputs.end());
+  return inputs;
+}();
 
 typedef RefineTest<float, float, std::int64_t> RefineTestF;
 TEST_P(RefineTestF, AnnRefine) { this->testRefine(); }
+TEST_P(RefineTestF, AnnRefineFile) { this->testRefineFile(); }
 
 INSTANTIATE_TEST_CASE_P(RefineTest, RefineTestF, ::testing::ValuesIn(inputs));
 
 typedef RefineTest<uint8_t, float, std::int64_t> RefineTestF_uint8;
 TEST_P(RefineTestF_uint8, AnnRefine) { this->testRefine(); }
+TEST_P(RefineTestF_uint8, AnnRefineFile) { this->testRefineFile(); }
 INSTANTIATE_TEST_CASE_P(RefineTest, RefineTestF_uint8, ::testing::ValuesIn(inputs));
 
 typedef RefineTest<int8_t, float, std::int64_t> RefineTestF_int8;
@@ -18,22 +18,32 @@
 #include "./ann_utils.cuh"
 #include "./knn_utils.cuh"
 
+#include <raft/core/bitmap.hpp>
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/logger.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/distance/distance.cuh>  // raft::distance::pairwise_distance
 #include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
 #include <raft/linalg/transpose.cuh>
 #include <raft/matrix/init.cuh>
 #include <raft/neighbors/brute_force.cuh>
 #include <raft/neighbors/detail/knn_brute_force.cuh>  // raft::neighbors::detail::brute_force_knn_impl
 
+#include <rmm/cuda_stream_pool.hpp>
 #include <rmm/device_buffer.hpp>
 
+#include <cuda_fp16.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <vector>
 
 namespace raft::neighbors::brute_force {
@@ -180,6 +190,99 @@ class TiledKNNTest : public ::testing::TestWithParam<TiledKNNInputs> {
                                                        stream_,
                                                        true));
 
+    // Also test out the search over a host dataset, copied to the device in tiles
+    if (params_.row_major) {
+      std::vector<T> database_host(database.size());
+      raft::update_host(database_host.data(), database.data(), database.size(), stream_);
+      resource::sync_stream(handle_);
+      raft::resources pool_handle(handle_);
+      resource::set_cuda_stream_pool(pool_handle, std::make_shared<rmm::cuda_stream_pool>(2));
+
+      neighbors::detail::brute_force_search_host_dataset<T, int>(
+        pool_handle,
+        raft::make_host_matrix_view<const T, int64_t>(
+          database_host.data(), params_.num_db_vecs, params_.dim),
+        raft::make_device_matrix_view<const T, int64_t>(
+          search_queries.data(), params_.num_queries, params_.dim),
+        raft::make_device_matrix_view<int, int64_t>(
+          raft_indices_.data(), params_.num_queries, params_.k),
+        raft::make_device_matrix_view<T, int64_t>(
+          raft_distances_.data(), params_.num_queries, params_.k),
+        metric,
+        metric_arg,
+        std::max(params_.col_tiles, 1));
+
+      ASSERT_TRUE(raft::spatial::knn::devArrMatchKnnPair(ref_indices_.data(),
+                                                         raft_indices_.data(),
+                                                         ref_distances_.data(),
+                                                         raft_distances_.data(),
+                                                         num_queries,
+                                                         k_,
+                                                         float(0.001),
+                                                         stream_,
+                                                         true));
+    }
+
+    // Also test out the range search, against the full distance matrix
+    if (params_.row_major && size_t(num_queries) * num_db_vecs <= (size_t(1) << 24)) {
+      auto idx =
+        raft::neighbors::brute_force::build<T>(handle_,
+                                               raft::make_device_matrix_view<const T, int64_t>(
+                                                 database.data(), params_.num_db_vecs, params_.dim),
+                                               metric,
+                                               metric_arg);
+      // the radius is the distance to the (k/2)-th neighbor of the first query
+      T radius;
+      raft::update_host(&radius, ref_distances_.data() + k_ / 2, 1, stream_);
+      auto result = raft::make_device_csr_matrix<T, int64_t, int, int64_t>(
+        handle_, int64_t(num_queries), num_db_vecs);
+      neighbors::detail::brute_force_range_search<T, int>(
+        handle_,
+        idx,
+        raft::make_device_matrix_view<const T, int64_t>(
+          search_queries.data(), params_.num_queries, params_.dim),
+        radius,
+        result,
+        params_.row_tiles,
+        params_.col_tiles);
+
+      auto view = result.structure_view();
+      std::vector<T> all_dists(size_t(num_queries) * num_db_vecs);
+      std::vector<int64_t> indptr(num_queries + 1);
+      std::vector<int> indices(view.get_nnz());
+      std::vector<T> dists(view.get_nnz());
+      raft::update_host(all_dists.data(), temp_dist, all_dists.size(), stream_);
+      raft::update_host(indptr.data(), view.get_indptr().data(), indptr.size(), stream_);
+      if (view.get_nnz() > 0) {
+        raft::update_host(indices.data(), view.get_indices().data(), indices.size(), stream_);
+        raft::update_host(dists.data(), result.get_elements().data(), dists.size(), stream_);
+      }
+      resource::sync_stream(handle_);
+
+      // the pairs near the radius may be found or not, depending on the rounding
+      const bool select_min = raft::distance::is_min_close(metric);
+      const T eps           = T(0.001) * std::max<T>(T(1), std::abs(radius));
+      ASSERT_EQ(indptr.back(), int64_t(indices.size()));
+      std::vector<bool> found(num_db_vecs);
+      for (int q = 0; q < num_queries; q++) {
+        std::fill(found.begin(), found.end(), false);
+        const T* row_dists = all_dists.data() + size_t(q) * num_db_vecs;
+        for (int64_t i = indptr[q]; i < indptr[q + 1]; i++) {
+          const int j = indices[i];
+          ASSERT_TRUE(j >= 0 && j < num_db_vecs);
+          ASSERT_TRUE(i == indptr[q] || indices[i - 1] < j) << "the indices must be sorted";
+          ASSERT_NEAR(dists[i], row_dists[j], eps);
+          ASSERT_TRUE(select_min ? row_dists[j] <= radius + eps : row_dists[j] >= radius - eps);
+          found[j] = true;
+        }
+        for (int j = 0; j < num_db_vecs; j++) {
+          const bool in_range =
+            select_min ? row_dists[j] < radius - eps : row_dists[j] > radius + eps;
+          ASSERT_TRUE(!in_range || found[j]) << "missing neighbor " << j << " of query " << q;
+        }
+      }
+    }
+
     // Also test out the 'index' api - where we can use precomputed norms
     if (params_.row_major) {
       auto idx =
@@ -210,6 +313,74 @@ class TiledKNNTest : public ::testing::TestWithParam<TiledKNNInputs> {
                                                          float(0.001),
                                                          stream_,
                                                          true));
+      // also test out the search restricted by a bitmap, against the full distance matrix
+      const bool dot_metric = metric == raft::distance::DistanceType::L2Expanded ||
+                              metric == raft::distance::DistanceType::L2Unexpanded ||
+                              metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                              metric == raft::distance::DistanceType::L2SqrtUnexpanded ||
+                              metric == raft::distance::DistanceType::CosineExpanded ||
+                              metric == raft::distance::DistanceType::InnerProduct;
+      if (dot_metric && size_t(num_queries) * num_db_vecs <= (size_t(1) << 24)) {
+        std::vector<T> all_dists(size_t(num_queries) * num_db_vecs);
+        raft::update_host(all_dists.data(), temp_dist, all_dists.size(), stream_);
+        // a selective filter, with less than k allowed ids for some queries, and a dense one
+        for (double density : {0.01, 0.5}) {
+          std::mt19937 gen(42);
+          std::bernoulli_distribution allowed(density);
+          size_t n_bits = size_t(num_queries) * num_db_vecs;
+          std::vector<uint32_t> bits_h(raft::ceildiv<size_t>(n_bits, 32), 0);
+          for (size_t i = 0; i < n_bits; i++) {
+            if (allowed(gen)) { bits_h[i / 32] |= uint32_t(1) << (i % 32); }
+          }
+          rmm::device_uvector<uint32_t> bits(bits_h.size(), stream_);
+          raft::update_device(bits.data(), bits_h.data(), bits_h.size(), stream_);
+          auto filter = raft::core::bitmap_view<const uint32_t, int64_t>(
+            bits.data(), num_queries, num_db_vecs);
+
+          raft::neighbors::brute_force::search_with_filtering<T, int>(
+            handle_,
+            idx,
+            query_view,
+            raft::make_device_matrix_view<int, int64_t>(
+              raft_indices_.data(), params_.num_queries, params_.k),
+            raft::make_device_matrix_view<T, int64_t>(
+              raft_distances_.data(), params_.num_queries, params_.k),
+            filter);
+
+          std::vector<int> indices(size_t(num_queries) * k_);
+          std::vector<T> dists(size_t(num_queries) * k_);
+          raft::update_host(indices.data(), raft_indices_.data(), indices.size(), stream_);
+          raft::update_host(dists.data(), raft_distances_.data(), dists.size(), stream_);
+          resource::sync_stream(handle_);
+
+          const bool select_min = raft::distance::is_min_close(metric);
+          for (int q = 0; q < num_queries; q++) {
+            const T* row_dists = all_dists.data() + size_t(q) * num_db_vecs;
+            std::vector<T> expected;
+            for (int j = 0; j < num_db_vecs; j++) {
+              size_t bit = size_t(q) * num_db_vecs + j;
+              if (bits_h[bit / 32] >> (bit % 32) & 1) { expected.push_back(row_dists[j]); }
+            }
+            std::sort(expected.begin(), expected.end());
+            if (!select_min) { std::reverse(expected.begin(), expected.end()); }
+            for (int i = 0; i < k_; i++) {
+              const int j  = indices[size_t(q) * k_ + i];
+              const T dist = dists[size_t(q) * k_ + i];
+              if (i >= int(expected.size())) {
+                ASSERT_EQ(j, -1) << "query " << q;
+                continue;
+              }
+              const T eps = T(0.001) * std::max<T>(T(1), std::abs(expected[i]));
+              ASSERT_TRUE(j >= 0 && j < num_db_vecs) << "query " << q;
+              size_t bit = size_t(q) * num_db_vecs + j;
+              ASSERT_TRUE(bits_h[bit / 32] >> (bit % 32) & 1) << "filtered out neighbor " << j;
+              ASSERT_NEAR(dist, expected[i], eps) << "query " << q;
+              ASSERT_NEAR(dist, row_dists[j], eps) << "query " << q;
+            }
+          }
+        }
+      }
+
       // also test out the batch api. First get new reference results (all k, up to a certain
       // max size)
       auto all_size      = std::min(params_.num_db_vecs, 1024);
@@ -218,31 +389,38 @@ class TiledKNNTest : public ::testing::TestWithParam<TiledKNNInputs> {
       raft::neighbors::brute_force::search<T, int>(
         handle_, idx, query_view, all_indices.view(), all_distances.view());
 
+      // the batches are the same with the next ones computed in the background
       int64_t offset = 0;
-      auto query     = make_batch_k_query<T, int>(handle_, idx, query_view, k_);
-      for (auto batch : *query) {
-        auto batch_size = batch.batch_size();
-        auto indices    = raft::make_device_matrix<int, int64_t>(handle_, num_queries, batch_size);
-        auto distances  = raft::make_device_matrix<T, int64_t>(handle_, num_queries, batch_size);
-
-        matrix::slice_coordinates<int64_t> coords{0, offset, num_queries, offset + batch_size};
-
-        matrix::slice(handle_, raft::make_const_mdspan(all_indices.view()), indices.view(), coords);
-        matrix::slice(
-          handle_, raft::make_const_mdspan(all_distances.view()), distances.view(), coords);
-
-        ASSERT_TRUE(raft::spatial::knn::devArrMatchKnnPair(indices.data_handle(),
-                                                           batch.indices().data_handle(),
-                                                           distances.data_handle(),
-                                                           batch.distances().data_handle(),
-                                                           num_queries,
-                                                           batch_size,
-                                                           float(0.001),
-                                                           stream_,
-                                                           true));
-
-        offset += batch_size;
-        if (offset + batch_size > all_size) break;
+      std::shared_ptr<batch_k_query<T, int>> query;
+      for (bool prefetch : {false, true}) {
+        offset = 0;
+        query  = make_batch_k_query<T, int>(handle_, idx, query_view, k_, prefetch);
+        for (auto batch : *query) {
+          auto batch_size = batch.batch_size();
+          auto indices =
+            raft::make_device_matrix<int, int64_t>(handle_, num_queries, batch_size);
+          auto distances = raft::make_device_matrix<T, int64_t>(handle_, num_queries, batch_size);
+
+          matrix::slice_coordinates<int64_t> coords{0, offset, num_queries, offset + batch_size};
+
+          matrix::slice(
+            handle_, raft::make_const_mdspan(all_indices.view()), indices.view(), coords);
+          matrix::slice(
+            handle_, raft::make_const_mdspan(all_distances.view()), distances.view(), coords);
+
+          ASSERT_TRUE(raft::spatial::knn::devArrMatchKnnPair(indices.data_handle(),
+                                                             batch.indices().data_handle(),
+                                                             distances.data_handle(),
+                                                             batch.distances().data_handle(),
+                                                             num_queries,
+                                                             batch_size,
+                                                             float(0.001),
+                                                             stream_,
+                                                             true));
+
+          offset += batch_size;
+          if (offset + batch_size > all_size) break;
+        }
       }
 
       // also test out with variable batch sizes
@@ -280,6 +458,68 @@ class TiledKNNTest : public ::testing::TestWithParam<TiledKNNInputs> {
     }
   }
 
+  void testLowPrecision()
+  {
+    if (!params_.row_major ||
+        (metric != raft::distance::DistanceType::L2Expanded &&
+         metric != raft::distance::DistanceType::L2SqrtExpanded &&
+         metric != raft::distance::DistanceType::InnerProduct &&
+         metric != raft::distance::DistanceType::CosineExpanded)) {
+      GTEST_SKIP();
+    }
+    auto database_half = raft::make_device_matrix<half, int64_t>(handle_, num_db_vecs, dim);
+    auto queries_half  = raft::make_device_matrix<half, int64_t>(handle_, num_queries, dim);
+    raft::linalg::map(handle_,
+                      database_half.view(),
+                      raft::cast_op<half>{},
+                      raft::make_device_matrix_view<const T, int64_t>(
+                        database.data(), num_db_vecs, dim));
+    raft::linalg::map(handle_,
+                      queries_half.view(),
+                      raft::cast_op<half>{},
+                      raft::make_device_matrix_view<const T, int64_t>(
+                        search_queries.data(), num_queries, dim));
+
+    // The reference is the float search over the same (rounded to half) data
+    auto database_rounded = raft::make_device_matrix<T, int64_t>(handle_, num_db_vecs, dim);
+    auto queries_rounded  = raft::make_device_matrix<T, int64_t>(handle_, num_queries, dim);
+    raft::linalg::map(handle_,
+                      database_rounded.view(),
+                      raft::cast_op<T>{},
+                      raft::make_const_mdspan(database_half.view()));
+    raft::linalg::map(handle_,
+                      queries_rounded.view(),
+                      raft::cast_op<T>{},
+                      raft::make_const_mdspan(queries_half.view()));
+    auto idx = raft::neighbors::brute_force::build<T>(
+      handle_, raft::make_const_mdspan(database_rounded.view()), metric);
+    raft::neighbors::brute_force::search<T, int>(
+      handle_,
+      idx,
+      raft::make_const_mdspan(queries_rounded.view()),
+      raft::make_device_matrix_view<int, int64_t>(ref_indices_.data(), num_queries, k_),
+      raft::make_device_matrix_view<T, int64_t>(ref_distances_.data(), num_queries, k_));
+
+    neighbors::detail::brute_force_search_low_precision<half, int>(
+      handle_,
+      raft::make_const_mdspan(database_half.view()),
+      raft::make_const_mdspan(queries_half.view()),
+      raft::make_device_matrix_view<int, int64_t>(raft_indices_.data(), num_queries, k_),
+      raft::make_device_matrix_view<float, int64_t>(raft_distances_.data(), num_queries, k_),
+      metric,
+      std::nullopt);
+
+    ASSERT_TRUE(raft::spatial::knn::devArrMatchKnnPair(ref_indices_.data(),
+                                                       raft_indices_.data(),
+                                                       ref_distances_.data(),
+                                                       raft_distances_.data(),
+                                                       num_queries,
+                                                       k_,
+                                                       float(0.01),
+                                                       stream_,
+                                                       true));
+  }
+
   void SetUp() override
   {
     num_queries = params_.num_queries;
@@ -343,10 +583,14 @@ const std::vector<TiledKNNInputs> random_inputs = {
   {1000, 500000, 128, 128, 0, 0, raft::distance::DistanceType::L2Expanded, false},
   {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::LpUnexpanded, true},
   {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::L2SqrtExpanded, false},
-  {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::InnerProduct, false}};
+  {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::InnerProduct, false},
+  // k <= 64 selects the top-k inside the distance kernel
+  {1000, 5000, 128, 32, 0, 0, raft::distance::DistanceType::InnerProduct, true},
+  {1000, 5000, 128, 64, 0, 0, raft::distance::DistanceType::CosineExpanded, true}};
 
 typedef TiledKNNTest<float> TiledKNNTestF;
 TEST_P(TiledKNNTestF, BruteForce) { this->testBruteForce(); }
+TEST_P(TiledKNNTestF, LowPrecision) { this->testLowPrecision(); }
 
 INSTANTIATE_TEST_CASE_P(TiledKNNTest, TiledKNNTestF, ::testing::ValuesIn(random_inputs));
 }  // namespace raft::neighbors::brute_force
@@ -17,6 +17,7 @@
 #include "../test_utils.cuh"
 
 #include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/random/make_blobs.cuh>
@@ -27,6 +28,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
+
 namespace raft {
 namespace random {
 
@@ -217,5 +223,100 @@ INSTANTIATE_TEST_CASE_P(MakeBlobsTests, MakeBlobsTestD_RowMajor, ::testing::Valu
 TEST_P(MakeBlobsTestD_ColMajor, Result) { check(); }
 INSTANTIATE_TEST_CASE_P(MakeBlobsTests, MakeBlobsTestD_ColMajor, ::testing::ValuesIn(inputsd_t));
 
+struct BlobsGeneratorInputs {
+  int64_t n_rows, n_cols, n_clusters, batch_size;
+  bool shuffle;
+  GeneratorType gtype;
+  uint64_t seed;
+};
+
+template <typename T>
+class BlobsGeneratorTest : public ::testing::TestWithParam<BlobsGeneratorInputs> {
+ protected:
+  void check()
+  {
+    auto stream    = resource::get_cuda_stream(handle);
+    const auto len = params.n_rows * params.n_cols;
+    const T sigma  = T(0.5);
+    blobs_generator<T, int64_t> gen(handle,
+                                    params.n_rows,
+                                    params.n_cols,
+                                    params.n_clusters,
+                                    std::nullopt,
+                                    std::nullopt,
+                                    sigma,
+                                    params.shuffle,
+                                    T(-10.0),
+                                    T(10.0),
+                                    params.seed,
+                                    params.gtype);
+
+    // the whole dataset on the device at once
+    auto data   = raft::make_device_matrix<T, int64_t>(handle, params.n_rows, params.n_cols);
+    auto labels = raft::make_device_vector<int64_t, int64_t>(handle, params.n_rows);
+    gen.generate(handle, 0, data.view(), std::make_optional(labels.view()));
+    std::vector<T> data_h(len);
+    std::vector<int64_t> labels_h(params.n_rows);
+    raft::update_host(data_h.data(), data.data_handle(), len, stream);
+    raft::update_host(labels_h.data(), labels.data_handle(), params.n_rows, stream);
+
+    // the same dataset in batches on the host, generated in reverse order
+    std::vector<T> batches_h(len);
+    std::vector<int64_t> batch_labels_h(params.n_rows);
+    for (int64_t end = params.n_rows; end > 0; end -= params.batch_size) {
+      int64_t begin = std::max<int64_t>(0, end - params.batch_size);
+      gen.generate(handle,
+                   begin,
+                   raft::make_host_matrix_view<T, int64_t>(
+                     batches_h.data() + begin * params.n_cols, end - begin, params.n_cols),
+                   std::make_optional(raft::make_host_vector_view<int64_t, int64_t>(
+                     batch_labels_h.data() + begin, end - begin)));
+    }
+    std::vector<T> centers_h(params.n_clusters * params.n_cols);
+    raft::update_host(centers_h.data(), gen.centers().data_handle(), centers_h.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    ASSERT_EQ(data_h, batches_h);
+    ASSERT_EQ(labels_h, batch_labels_h);
+
+    // the rows are drawn around the centers of their cluster
+    double sum = 0, sum_sq = 0;
+    for (int64_t i = 0; i < params.n_rows; i++) {
+      ASSERT_TRUE(0 <= labels_h[i] && labels_h[i] < params.n_clusters);
+      for (int64_t j = 0; j < params.n_cols; j++) {
+        double d = data_h[i * params.n_cols + j] - centers_h[labels_h[i] * params.n_cols + j];
+        sum += d;
+        sum_sq += d * d;
+      }
+    }
+    // 5 standard errors of the estimators
+    double mean = sum / len;
+    double var  = sum_sq / len - mean * mean;
+    ASSERT_NEAR(0.0, mean, 5 * sigma / std::sqrt(double(len)));
+    ASSERT_NEAR(double(sigma) * sigma, var, 5 * sigma * sigma * std::sqrt(2.0 / len));
+  }
+
+  BlobsGeneratorInputs params{::testing::TestWithParam<BlobsGeneratorInputs>::GetParam()};
+  raft::resources handle;
+};
+
+const std::vector<BlobsGeneratorInputs> inputs_generator = {
+  {1000, 3, 4, 100, true, GenPC, 1234ULL},
+  {20000, 17, 5, 3333, true, GenPhilox, 1234ULL},
+  {20000, 32, 7, 20000, false, GenPC, 1234ULL},
+  {5000, 128, 10, 777, true, GenPC, 4321ULL}};
+
+using BlobsGeneratorTestF = BlobsGeneratorTest<float>;
+TEST_P(BlobsGeneratorTestF, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(BlobsGeneratorTests,
+                        BlobsGeneratorTestF,
+                        ::testing::ValuesIn(inputs_generator));
+
+using BlobsGeneratorTestD = BlobsGeneratorTest<double>;
+TEST_P(BlobsGeneratorTestD, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(BlobsGeneratorTests,
+                        BlobsGeneratorTestD,
+                        ::testing::ValuesIn(inputs_generator));
+
 }  // end namespace random
 }  // end namespace raft
@@ -16,6 +16,8 @@
 
 #include "../test_utils.cuh"
 
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
@@ -32,6 +34,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace raft::random {
 
 template <typename T>
@@ -303,4 +309,107 @@ INSTANTIATE_TEST_CASE_P(MakeRegressionMdspanTests,
                         MakeRegressionMdspanTestD,
                         ::testing::ValuesIn(inputsd_t));
 
+struct RegressionGeneratorInputs {
+  int64_t n_rows, n_cols, n_informative, n_targets, batch_size;
+  double bias, noise;
+  raft::random::GeneratorType gtype;
+  uint64_t seed;
+};
+
+template <typename T>
+class RegressionGeneratorTest : public ::testing::TestWithParam<RegressionGeneratorInputs> {
+ protected:
+  void check()
+  {
+    auto stream       = resource::get_cuda_stream(handle);
+    const auto n_rows = params.n_rows, n_cols = params.n_cols, n_targets = params.n_targets;
+    regression_generator<T, int64_t> gen(handle,
+                                         n_rows,
+                                         n_cols,
+                                         params.n_informative,
+                                         n_targets,
+                                         T(params.bias),
+                                         T(params.noise),
+                                         params.seed,
+                                         params.gtype);
+
+    // the whole dataset on the device at once
+    auto data   = raft::make_device_matrix<T, int64_t>(handle, n_rows, n_cols);
+    auto values = raft::make_device_matrix<T, int64_t>(handle, n_rows, n_targets);
+    gen.generate(handle, 0, data.view(), values.view());
+    std::vector<T> data_h(n_rows * n_cols), values_h(n_rows * n_targets);
+    std::vector<T> coef_h(n_cols * n_targets);
+    raft::update_host(data_h.data(), data.data_handle(), data_h.size(), stream);
+    raft::update_host(values_h.data(), values.data_handle(), values_h.size(), stream);
+    raft::update_host(coef_h.data(), gen.coef().data_handle(), coef_h.size(), stream);
+
+    // the same dataset in batches on the host
+    std::vector<T> batch_data_h(data_h.size()), batch_values_h(values_h.size());
+    for (int64_t begin = 0; begin < n_rows; begin += params.batch_size) {
+      int64_t rows = std::min(params.batch_size, n_rows - begin);
+      gen.generate(
+        handle,
+        begin,
+        raft::make_host_matrix_view<T, int64_t>(batch_data_h.data() + begin * n_cols, rows, n_cols),
+        raft::make_host_matrix_view<T, int64_t>(
+          batch_values_h.data() + begin * n_targets, rows, n_targets));
+    }
+    resource::sync_stream(handle, stream);
+
+    // the inputs are identical, the values up to the summation order of the GEMM
+    ASSERT_EQ(data_h, batch_data_h);
+    for (size_t i = 0; i < values_h.size(); i++) {
+      ASSERT_NEAR(values_h[i], batch_values_h[i], 1e-5 * (1 + std::abs(values_h[i]))) << "at " << i;
+    }
+
+    // only the informative features have a coefficient
+    for (int64_t j = 0; j < n_cols * n_targets; j++) {
+      ASSERT_EQ(j < params.n_informative * n_targets, coef_h[j] != T(0)) << "at " << j;
+    }
+    // the residuals are the noise
+    double sum = 0, sum_sq = 0;
+    for (int64_t i = 0; i < n_rows; i++) {
+      for (int64_t t = 0; t < n_targets; t++) {
+        double expected = params.bias;
+        for (int64_t j = 0; j < n_cols; j++) {
+          expected += double(data_h[i * n_cols + j]) * coef_h[j * n_targets + t];
+        }
+        double r = values_h[i * n_targets + t] - expected;
+        if (params.noise == 0) {
+          ASSERT_NEAR(expected, values_h[i * n_targets + t], 1e-3 * (1 + std::abs(expected)));
+        }
+        sum += r;
+        sum_sq += r * r;
+      }
+    }
+    if (params.noise != 0) {
+      double mean = sum / values_h.size();
+      double var  = sum_sq / values_h.size() - mean * mean;
+      ASSERT_NEAR(0.0, mean, 0.05 * params.noise);
+      ASSERT_NEAR(params.noise * params.noise, var, 0.05 * params.noise * params.noise);
+    }
+  }
+
+  RegressionGeneratorInputs params{::testing::TestWithParam<RegressionGeneratorInputs>::GetParam()};
+  raft::resources handle;
+};
+
+const std::vector<RegressionGeneratorInputs> inputs_generator = {
+  {1000, 10, 10, 1, 99, 0.0, 0.0, raft::random::GenPC, 1234ULL},
+  {5000, 40, 13, 3, 1234, 2.5, 0.0, raft::random::GenPhilox, 1234ULL},
+  {20000, 16, 4, 2, 6000, -1.0, 3.0, raft::random::GenPC, 1234ULL},
+  {3000, 20, 0, 2, 500, 1.0, 0.0, raft::random::GenPC, 4321ULL}};
+
+using RegressionGeneratorTestF = RegressionGeneratorTest<float>;
+TEST_P(RegressionGeneratorTestF, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(RegressionGeneratorTests,
+                        RegressionGeneratorTestF,
+                        ::testing::ValuesIn(inputs_generator));
+
+using RegressionGeneratorTestD = RegressionGeneratorTest<double>;
+TEST_P(RegressionGeneratorTestD, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(RegressionGeneratorTests,
+                        RegressionGeneratorTestD,
+                        ::testing::ValuesIn(inputs_generator));
+
 }  // end namespace raft::random
@@ -17,6 +17,7 @@
 #include "../test_utils.cuh"
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/random/permute.cuh>
 #include <raft/random/rng.cuh>
@@ -24,6 +25,7 @@
 #include <raft/util/cudart_utils.hpp>
 
 #include <algorithm>
+#include <optional>
 #include <vector>
 
 namespace raft {
@@ -175,6 +177,77 @@ class PermMdspanTest : public ::testing::TestWithParam<PermInputs<T>> {
   int* outPerms_ptr = nullptr;
 };
 
+template <typename T>
+class PermInplaceTest : public ::testing::TestWithParam<PermInputs<T>> {
+ public:
+  using test_data_type = T;
+
+ protected:
+  PermInplaceTest()
+    : in(0, resource::get_cuda_stream(handle)),
+      out(0, resource::get_cuda_stream(handle)),
+      outPerms(0, resource::get_cuda_stream(handle))
+  {
+  }
+
+  void SetUp() override
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    params      = ::testing::TestWithParam<PermInputs<T>>::GetParam();
+    // the data is always permuted in place, and the permutation checked against it
+    params.needPerms   = true;
+    params.needShuffle = true;
+    raft::random::RngState r(params.seed);
+    int N   = params.N;
+    int D   = params.D;
+    int len = N * D;
+    outPerms.resize(N, stream);
+    in.resize(len, stream);
+    out.resize(len, stream);
+    outPerms_ptr = outPerms.data();
+    in_ptr       = in.data();
+    out_ptr      = out.data();
+    uniform(handle, r, in_ptr, len, T(-1.0), T(1.0));
+    raft::copy(out_ptr, in_ptr, len, stream);
+
+    // the same permutation with a workspace too small to process a whole pass at once
+    raft::resources small_handle;
+    resource::set_workspace_to_global_resource(small_handle, 1024 * 1024);
+    rmm::device_uvector<T> out_small(len, stream);
+    raft::copy(out_small.data(), in_ptr, len, stream);
+    resource::sync_stream(handle);
+
+    auto permute_in_place = [&](auto layout) {
+      using layout_type = std::decay_t<decltype(layout)>;
+      RngState r_small{r};
+      permute_inplace(handle,
+                      r,
+                      raft::make_device_matrix_view<T, int, layout_type>(out_ptr, N, D),
+                      std::make_optional(raft::make_device_vector_view(outPerms_ptr, N)));
+      permute_inplace(
+        small_handle,
+        r_small,
+        raft::make_device_matrix_view<T, int, layout_type>(out_small.data(), N, D));
+    };
+    if (params.rowMajor) {
+      permute_in_place(raft::row_major{});
+    } else {
+      permute_in_place(raft::col_major{});
+    }
+    resource::sync_stream(small_handle);
+    ASSERT_TRUE(devArrMatch(out_ptr, out_small.data(), len, raft::Compare<T>(), stream));
+  }
+
+ protected:
+  raft::resources handle;
+  PermInputs<T> params;
+  rmm::device_uvector<T> in, out;
+  T* in_ptr  = nullptr;
+  T* out_ptr = nullptr;
+  rmm::device_uvector<int> outPerms;
+  int* outPerms_ptr = nullptr;
+};
+
 template <typename T, typename L>
 ::testing::AssertionResult devArrMatchRange(
   const T* actual, size_t size, T start, L eq_compare, bool doSort = true, cudaStream_t stream = 0)
@@ -295,6 +368,14 @@ TEST_P(PermMdspanTestF, Result)
 }
 INSTANTIATE_TEST_CASE_P(PermMdspanTests, PermMdspanTestF, ::testing::ValuesIn(inputsf));
 
+using PermInplaceTestF = PermInplaceTest<float>;
+TEST_P(PermInplaceTestF, Result)
+{
+  using test_data_type = PermInplaceTestF::test_data_type;
+  _PERMTEST_BODY(test_data_type);
+}
+INSTANTIATE_TEST_CASE_P(PermInplaceTests, PermInplaceTestF, ::testing::ValuesIn(inputsf));
+
 const std::vector<PermInputs<double>> inputsd = {
   // only generate permutations
   {32, 8, true, false, true, 1234ULL},
@@ -349,5 +430,13 @@ TEST_P(PermMdspanTestD, Result)
 }
 INSTANTIATE_TEST_CASE_P(PermMdspanTests, PermMdspanTestD, ::testing::ValuesIn(inputsd));
 
+using PermInplaceTestD = PermInplaceTest<double>;
+TEST_P(PermInplaceTestD, Result)
+{
+  using test_data_type = PermInplaceTestD::test_data_type;
+  _PERMTEST_BODY(test_data_type);
+}
+INSTANTIATE_TEST_CASE_P(PermInplaceTests, PermInplaceTestD, ::testing::ValuesIn(inputsd));
+
 }  // end namespace random
 }  // end namespace raft
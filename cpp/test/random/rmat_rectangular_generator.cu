@@ -28,6 +28,8 @@
 #include <gtest/gtest.h>
 #include <sys/timeb.h>
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 namespace raft {
@@ -362,6 +364,128 @@ class RmatGenMdspanTest : public ::testing::TestWithParam<RmatInputs> {
   size_t max_scale;
 };
 
+class RmatGenCsrTest : public ::testing::TestWithParam<RmatInputs> {
+ public:
+  RmatGenCsrTest()
+    : handle{},
+      stream{resource::get_cuda_stream(handle)},
+      params{::testing::TestWithParam<RmatInputs>::GetParam()},
+      out_src{params.n_edges, stream},
+      out_dst{params.n_edges, stream},
+      theta{0, stream},
+      h_theta{},
+      state{params.seed, GeneratorType::GenPC},
+      max_scale{std::max(params.r_scale, params.c_scale)}
+  {
+    theta.resize(4 * max_scale, stream);
+    uniform<float>(handle, state, theta.data(), theta.size(), 0.0f, 1.0f);
+    normalize<float, float>(theta.data(),
+                            theta.data(),
+                            max_scale,
+                            params.r_scale,
+                            params.c_scale,
+                            params.r_scale != params.c_scale,
+                            params.theta_array,
+                            stream);
+    h_theta.resize(theta.size());
+    raft::update_host(h_theta.data(), theta.data(), theta.size(), stream);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  }
+
+ protected:
+  // the CSR output must hold the edges of the COO output of the same state, sorted by source
+  // then by destination, after the requested removals
+  void validate(bool remove_duplicates, bool remove_self_loops)
+  {
+    using index_type = size_t;
+    RngState coo_state{state};
+    auto csr = raft::make_device_compressed_structure<index_type, index_type, index_type>(
+      handle, index_type(1) << params.r_scale, index_type(1) << params.c_scale);
+    if (params.theta_array) {
+      raft::device_vector_view<const float, index_type> theta_view(theta.data(), theta.size());
+      rmat_rectangular_gen(handle,
+                           coo_state,
+                           theta_view,
+                           raft::make_device_vector_view(out_src.data(), out_src.size()),
+                           raft::make_device_vector_view(out_dst.data(), out_dst.size()),
+                           params.r_scale,
+                           params.c_scale);
+      rmat_rectangular_gen_csr(handle,
+                               state,
+                               theta_view,
+                               csr,
+                               params.n_edges,
+                               params.r_scale,
+                               params.c_scale,
+                               remove_duplicates,
+                               remove_self_loops);
+    } else {
+      rmat_rectangular_gen(handle,
+                           coo_state,
+                           raft::make_device_vector_view(out_src.data(), out_src.size()),
+                           raft::make_device_vector_view(out_dst.data(), out_dst.size()),
+                           h_theta[0],
+                           h_theta[1],
+                           h_theta[2],
+                           params.r_scale,
+                           params.c_scale);
+      rmat_rectangular_gen_csr(handle,
+                               state,
+                               csr,
+                               h_theta[0],
+                               h_theta[1],
+                               h_theta[2],
+                               params.n_edges,
+                               params.r_scale,
+                               params.c_scale,
+                               remove_duplicates,
+                               remove_self_loops);
+    }
+    ASSERT_EQ(coo_state.base_subsequence, state.base_subsequence);
+
+    std::vector<index_type> h_src(params.n_edges), h_dst(params.n_edges);
+    raft::update_host(h_src.data(), out_src.data(), params.n_edges, stream);
+    raft::update_host(h_dst.data(), out_dst.data(), params.n_edges, stream);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    std::vector<std::pair<index_type, index_type>> expected;
+    for (size_t i = 0; i < params.n_edges; i++) {
+      if (remove_self_loops && h_src[i] == h_dst[i]) { continue; }
+      expected.emplace_back(h_src[i], h_dst[i]);
+    }
+    std::sort(expected.begin(), expected.end());
+    if (remove_duplicates) {
+      expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+    }
+
+    ASSERT_EQ(index_type(expected.size()), csr.get_nnz());
+    std::vector<index_type> h_indptr(csr.get_n_rows() + 1), h_indices(csr.get_nnz());
+    raft::update_host(h_indptr.data(), csr.get_indptr().data(), h_indptr.size(), stream);
+    if (csr.get_nnz() > 0) {
+      raft::update_host(h_indices.data(), csr.get_indices().data(), h_indices.size(), stream);
+    }
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    ASSERT_EQ(h_indptr.front(), index_type(0));
+    ASSERT_EQ(h_indptr.back(), csr.get_nnz());
+    for (index_type row = 0; row < csr.get_n_rows(); row++) {
+      for (index_type j = h_indptr[row]; j < h_indptr[row + 1]; j++) {
+        ASSERT_EQ(expected[j].first, row) << "at " << j;
+        ASSERT_EQ(expected[j].second, h_indices[j]) << "at " << j;
+      }
+    }
+  }
+
+ protected:
+  raft::resources handle;
+  cudaStream_t stream;
+
+  RmatInputs params;
+  rmm::device_uvector<size_t> out_src, out_dst;
+  rmm::device_uvector<float> theta;
+  std::vector<float> h_theta;
+  RngState state;
+  size_t max_scale;
+};
+
 static const float TOLERANCE = 0.01f;
 
 const std::vector<RmatInputs> inputs = {
@@ -399,5 +523,9 @@ INSTANTIATE_TEST_SUITE_P(RmatGenTests, RmatGenTest, ::testing::ValuesIn(inputs))
 TEST_P(RmatGenMdspanTest, Result) { validate(); }
 INSTANTIATE_TEST_SUITE_P(RmatGenMdspanTests, RmatGenMdspanTest, ::testing::ValuesIn(inputs));
 
+TEST_P(RmatGenCsrTest, Result) { validate(true, true); }
+TEST_P(RmatGenCsrTest, KeepAllEdges) { validate(false, false); }
+INSTANTIATE_TEST_SUITE_P(RmatGenCsrTests, RmatGenCsrTest, ::testing::ValuesIn(inputs));
+
 }  // namespace random
 }  // namespace raft
@@ -801,5 +801,122 @@ const std::vector<RngAffineInputs> inputs_affine = {
 TEST_P(RngAffineTest, Result) { check(); }
 INSTANTIATE_TEST_SUITE_P(RngAffineTests, RngAffineTest, ::testing::ValuesIn(inputs_affine));
 
+/** sharded generation tests */
+struct RngShardedInputs {
+  int64_t len;
+  int n_shards;
+  GeneratorType gtype;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const RngShardedInputs& p)
+{
+  os << " len: " << p.len << ", n_shards: " << p.n_shards << ", gtype: " << int(p.gtype);
+  return os;
+}
+
+template <typename T>
+class RngShardedTest : public ::testing::TestWithParam<RngShardedInputs> {
+ public:
+  RngShardedTest()
+    : params(::testing::TestWithParam<RngShardedInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      whole(params.len, stream),
+      parts(params.len, stream)
+  {
+  }
+
+ protected:
+  // Generate the whole array at once, then as uneven shards with independent copies of the state
+  template <typename GenFunc>
+  void check(GenFunc gen)
+  {
+    RngState whole_state(params.seed, params.gtype);
+    gen(whole_state,
+        RngShard{0, uint64_t(params.len)},
+        raft::make_device_vector_view<T, int64_t>(whole.data(), params.len));
+
+    int64_t offset = 0;
+    for (int s = 0; s < params.n_shards; s++) {
+      // shards of growing sizes, whose boundaries are not aligned
+      int64_t end = s + 1 == params.n_shards
+                      ? params.len
+                      : params.len * (s + 1) * (s + 2) / (params.n_shards * (params.n_shards + 1));
+      RngState part_state(params.seed, params.gtype);
+      gen(part_state,
+          RngShard{uint64_t(offset), uint64_t(params.len)},
+          raft::make_device_vector_view<T, int64_t>(parts.data() + offset, end - offset));
+      ASSERT_EQ(whole_state.base_subsequence, part_state.base_subsequence);
+      offset = end;
+    }
+    ASSERT_TRUE(devArrMatch(whole.data(), parts.data(), params.len, Compare<T>(), stream));
+  }
+
+  raft::resources handle;
+  RngShardedInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<T> whole, parts;
+};
+
+const std::vector<RngShardedInputs> inputs_sharded = {{1, 1, GenPhilox, 1234ULL},
+                                                      {1000, 3, GenPhilox, 1234ULL},
+                                                      {1000, 3, GenPC, 1234ULL},
+                                                      {512 * 1024 + 17, 7, GenPhilox, 1234ULL},
+                                                      {512 * 1024 + 17, 7, GenPC, 1234ULL},
+                                                      {3000000, 4, GenPC, 4321ULL}};
+
+using RngShardedTestF = RngShardedTest<float>;
+TEST_P(RngShardedTestF, Uniform)
+{
+  check([this](RngState& r, const RngShard& shard, auto out) {
+    uniform(handle, r, shard, out, -1.0f, 2.0f);
+  });
+}
+TEST_P(RngShardedTestF, Normal)
+{
+  check([this](RngState& r, const RngShard& shard, auto out) {
+    normal(handle, r, shard, out, 1.0f, 2.0f);
+  });
+}
+INSTANTIATE_TEST_SUITE_P(RngShardedTests, RngShardedTestF, ::testing::ValuesIn(inputs_sharded));
+
+using RngShardedTestI = RngShardedTest<int64_t>;
+TEST_P(RngShardedTestI, UniformInt)
+{
+  check([this](RngState& r, const RngShard& shard, auto out) {
+    uniformInt(handle, r, shard, out, int64_t(-5), int64_t(1000));
+  });
+}
+INSTANTIATE_TEST_SUITE_P(RngShardedTests, RngShardedTestI, ::testing::ValuesIn(inputs_sharded));
+
+TEST(RngSharded, NormalMeanVar)
+{
+  raft::resources handle;
+  auto stream     = resource::get_cuda_stream(handle);
+  const int len   = 1 << 20;
+  const int shard = len / 4;
+  rmm::device_uvector<double> data(len, stream), stats(2, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(stats.data(), 0, 2 * sizeof(double), stream));
+  for (int s = 0; s < 4; s++) {
+    RngState r(1234ULL, GenPhilox);
+    normal(handle,
+           r,
+           RngShard{uint64_t(s) * shard, uint64_t(len)},
+           raft::make_device_vector_view<double, int>(data.data() + s * shard, shard),
+           3.0,
+           2.0);
+  }
+  static const int threads = 128;
+  meanKernel<double, threads>
+    <<<raft::ceildiv(len, threads), threads, 0, stream>>>(stats.data(), data.data(), len);
+  double h_stats[2];
+  update_host<double>(h_stats, stats.data(), 2, stream);
+  RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  double mean = h_stats[0] / len;
+  double var  = h_stats[1] / len - mean * mean;
+  ASSERT_NEAR(3.0, mean, 0.02);
+  ASSERT_NEAR(4.0, var, 0.05);
+}
+
 }  // namespace random
 }  // namespace raft
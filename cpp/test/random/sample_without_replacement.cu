@@ -178,6 +178,8 @@ const std::vector<SWoRInputs<float>> inputsf = {{1024, 512, -1, 0.f, GenPhilox,
                                                 {1024 + 2, 512 + 2, -1, 0.f, GenPhilox, 1234ULL},
                                                 {1024 + 2, 1024 + 2, -1, 0.f, GenPhilox, 1234ULL},
                                                 {1024, 512, 10, 100000.f, GenPhilox, 1234ULL},
+                                                {1 << 20, 100, 12345, 1e9f, GenPhilox, 1234ULL},
+                                                {100000, 3, 777, 1e9f, GenPhilox, 1234ULL},
 
                                                 {1024, 512, -1, 0.f, GenPC, 1234ULL},
                                                 {1024, 1024, -1, 0.f, GenPC, 1234ULL},
@@ -197,7 +199,9 @@ const std::vector<SWoRInputs<float>> inputsf = {{1024, 512, -1, 0.f, GenPhilox,
                                                 {1024 + 2, 1024 + 1, -1, 0.f, GenPC, 1234ULL},
                                                 {1024 + 2, 512 + 2, -1, 0.f, GenPC, 1234ULL},
                                                 {1024 + 2, 1024 + 2, -1, 0.f, GenPC, 1234ULL},
-                                                {1024, 512, 10, 100000.f, GenPC, 1234ULL}};
+                                                {1024, 512, 10, 100000.f, GenPC, 1234ULL},
+                                                {1 << 20, 100, 12345, 1e9f, GenPC, 1234ULL},
+                                                {100000, 3, 777, 1e9f, GenPC, 1234ULL}};
 
 // This needs to be a macro because it has to live in the scope
 // of the class whose name is the first parameter of TEST_P.
@@ -253,6 +257,8 @@ const std::vector<SWoRInputs<double>> inputsd = {{1024, 512, -1, 0.0, GenPhilox,
                                                  {1024 + 2, 512 + 2, -1, 0.0, GenPhilox, 1234ULL},
                                                  {1024 + 2, 1024 + 2, -1, 0.0, GenPhilox, 1234ULL},
                                                  {1024, 512, 10, 100000.0, GenPhilox, 1234ULL},
+                                                 {1 << 20, 100, 12345, 1e9, GenPhilox, 1234ULL},
+                                                 {100000, 3, 777, 1e9, GenPhilox, 1234ULL},
 
                                                  {1024, 512, -1, 0.0, GenPC, 1234ULL},
                                                  {1024, 1024, -1, 0.0, GenPC, 1234ULL},
@@ -272,7 +278,9 @@ const std::vector<SWoRInputs<double>> inputsd = {{1024, 512, -1, 0.0, GenPhilox,
                                                  {1024 + 2, 1024 + 1, -1, 0.0, GenPC, 1234ULL},
                                                  {1024 + 2, 512 + 2, -1, 0.0, GenPC, 1234ULL},
                                                  {1024 + 2, 1024 + 2, -1, 0.0, GenPC, 1234ULL},
-                                                 {1024, 512, 10, 100000.0, GenPC, 1234ULL}};
+                                                 {1024, 512, 10, 100000.0, GenPC, 1234ULL},
+                                                 {1 << 20, 100, 12345, 1e9, GenPC, 1234ULL},
+                                                 {100000, 3, 777, 1e9, GenPC, 1234ULL}};
 
 using SWoRTestD = SWoRTest<double>;
 TEST_P(SWoRTestD, Result) { _RAFT_SWOR_TEST_CONTENTS(); }
@@ -30,6 +30,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
 #include <type_traits>
 
 namespace raft {
@@ -63,6 +67,7 @@ struct SparseDistanceCOOSPMVInputs {
 
   float capacity_threshold = 0.5;
   int map_size             = detail::hash_strategy<value_idx, value_t, 1024>::get_map_size();
+  bool nnz_balanced        = false;
 };
 
 template <typename value_idx, typename value_t, typename strategy_t>
@@ -89,13 +94,17 @@ class SparseDistanceCOOSPMVTest
   template <typename U, std::enable_if_t<std::is_same_v<U, hash_strategy_t>>* = nullptr>
   U make_strategy()
   {
-    return strategy_t(dist_config, params.capacity_threshold, params.map_size);
+    strategy_t strategy(dist_config, params.capacity_threshold, params.map_size);
+    strategy.set_nnz_balanced(params.nnz_balanced);
+    return strategy;
   }
 
   template <typename U, std::enable_if_t<std::is_same_v<U, dense_smem_strategy_t>>* = nullptr>
   U make_strategy()
   {
-    return strategy_t(dist_config);
+    strategy_t strategy(dist_config);
+    strategy.set_nnz_balanced(params.nnz_balanced);
+    return strategy;
   }
 
   template <typename reduce_f, typename accum_f, typename write_f>
@@ -651,6 +660,58 @@ const InputConfiguration<int, float> input_l1 = {4,
                                                  raft::distance::DistanceType::L1,
                                                  0.0};
 
+/**
+ * A matrix with power-law row lengths, the row i having max(1, max_row_nnz / (i + 1)) nonzeros,
+ * and its dense pairwise distances computed on host.
+ */
+InputConfiguration<int, float> make_power_law_input(int n_rows,
+                                                    int n_cols,
+                                                    int max_row_nnz,
+                                                    raft::distance::DistanceType metric)
+{
+  InputConfiguration<int, float> input;
+  input.n_cols = n_cols;
+  input.metric = metric;
+
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<float> value_dist(0.1f, 1.0f);
+  std::vector<int> cols(n_cols);
+  std::vector<float> dense(size_t(n_rows) * n_cols, 0.0f);
+  input.indptr_h.push_back(0);
+  for (int i = 0; i < n_rows; i++) {
+    int row_nnz = std::max(1, max_row_nnz / (i + 1));
+    std::iota(cols.begin(), cols.end(), 0);
+    std::shuffle(cols.begin(), cols.end(), gen);
+    std::sort(cols.begin(), cols.begin() + row_nnz);
+    for (int k = 0; k < row_nnz; k++) {
+      float value = value_dist(gen);
+      input.indices_h.push_back(cols[k]);
+      input.data_h.push_back(value);
+      dense[size_t(i) * n_cols + cols[k]] = value;
+    }
+    input.indptr_h.push_back(input.indices_h.size());
+  }
+
+  for (int i = 0; i < n_rows; i++) {
+    for (int j = 0; j < n_rows; j++) {
+      double acc = 0;
+      for (int k = 0; k < n_cols; k++) {
+        double a = dense[size_t(i) * n_cols + k];
+        double b = dense[size_t(j) * n_cols + k];
+        acc += metric == raft::distance::DistanceType::L1 ? std::abs(a - b) : a * b;
+      }
+      input.out_dists_ref_h.push_back(acc);
+    }
+  }
+  return input;
+}
+
+// few rows, with lengths spanning three orders of magnitude
+const InputConfiguration<int, float> input_power_law_ip =
+  make_power_law_input(48, 8000, 4000, raft::distance::DistanceType::InnerProduct);
+const InputConfiguration<int, float> input_power_law_l1 =
+  make_power_law_input(48, 8000, 4000, raft::distance::DistanceType::L1);
+
 // test dense smem strategy
 const std::vector<SparseDistanceCOOSPMVInputs<int, float, dense_smem_strategy_t>>
   inputs_dense_strategy = {{input_inner_product},
@@ -658,7 +719,11 @@ const std::vector<SparseDistanceCOOSPMVInputs<int, float, dense_smem_strategy_t>
                            {input_canberra},
                            {input_lp_unexpanded},
                            {input_linf},
-                           {input_l1}};
+                           {input_l1},
+                           {input_power_law_ip},
+                           {input_power_law_ip, 0.5, 0, true},
+                           {input_power_law_l1},
+                           {input_power_law_l1, 0.5, 0, true}};
 
 typedef SparseDistanceCOOSPMVTest<int, float, dense_smem_strategy_t>
   SparseDistanceCOOSPMVTestDenseStrategyF;
@@ -683,7 +748,11 @@ const std::vector<SparseDistanceCOOSPMVInputs<int, float, hash_strategy_t>> inpu
   {input_linf, 0.5, 2},
   {input_linf, 0.5, 6},
   {input_l1},
-  {input_l1, 0.5, 2}};
+  {input_l1, 0.5, 2},
+  {input_power_law_ip, 0.5, 1024},
+  {input_power_law_ip, 0.5, 1024, true},
+  {input_power_law_l1, 0.5, 1024},
+  {input_power_law_l1, 0.5, 1024, true}};
 
 typedef SparseDistanceCOOSPMVTest<int, float, hash_strategy_t>
   SparseDistanceCOOSPMVTestHashStrategyF;
@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
+#include "../loopback_comms.hpp"
 #include "../test_utils.cuh"
 
+#include <raft/core/resource/comms.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/sparse/mst/mst.cuh>
+#include <raft/sparse/solver/mst_mg.cuh>
 #include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_buffer.hpp>
@@ -33,6 +36,7 @@
 
 #include <cstddef>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 template <typename vertex_t, typename edge_t, typename weight_t>
@@ -379,6 +383,38 @@ TEST_P(MSTTestSequential, Sequential)
   ASSERT_TRUE(raft::match(prims_result, non_symmetric_sum, raft::CompareApprox<float>(0.1)));
 }
 
+// the distributed MST over a single rank, which holds all the edges
+TEST_P(MSTTestSequential, MultiGPU)
+{
+  resource::set_comms(handle, std::make_shared<comms::comms_t>(std::make_unique<loopback_comms>()));
+  auto stream = resource::get_cuda_stream(handle);
+
+  int* offsets   = static_cast<int*>(csr_d.offsets.data());
+  int* indices   = static_cast<int*>(csr_d.indices.data());
+  float* weights = static_cast<float*>(csr_d.weights.data());
+  v              = static_cast<int>((csr_d.offsets.size() / sizeof(int)) - 1);
+  e              = static_cast<int>(csr_d.indices.size() / sizeof(int));
+  rmm::device_uvector<int> color(v, stream);
+
+  auto prims_result = prims(mst_input.csr_h);
+  for (bool symmetrize_output : {true, false}) {
+    auto result = raft::sparse::solver::mst_mg(
+      handle, offsets, indices, weights, v, e, color.data(), symmetrize_output);
+    ASSERT_EQ(result.n_edges, symmetrize_output ? 2 * v - 2 : v - 1);
+    auto sum = thrust::reduce(
+      thrust::device, result.weights.data(), result.weights.data() + result.n_edges);
+    auto expected = symmetrize_output ? 2 * prims_result : prims_result;
+    ASSERT_TRUE(raft::match(expected, sum, raft::CompareApprox<float>(0.1)));
+
+    // a spanning tree puts all the vertices in the same tree
+    std::vector<int> color_h(v);
+    raft::update_host(color_h.data(), color.data(), v, stream);
+    resource::sync_stream(handle);
+    ASSERT_TRUE(std::all_of(
+      color_h.begin(), color_h.end(), [&](int c) { return c == color_h[0]; }));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(MSTTests, MSTTestSequential, ::testing::ValuesIn(csr_in_h));
 
 }  // namespace mst
@@ -17,13 +17,18 @@
 #include "../../test_utils.cuh"
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/sparse/neighbors/knn.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <rmm/cuda_stream_pool.hpp>
+
 #include <cusparse_v2.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
 namespace raft {
 namespace sparse {
 namespace selection {
@@ -48,6 +53,9 @@ struct SparseKNNInputs {
   int batch_size_query = 2;
 
   raft::distance::DistanceType metric = raft::distance::DistanceType::L2SqrtExpanded;
+
+  // the size of the stream pool the index batches are searched on, none if 0
+  int n_streams = 0;
 };
 
 template <typename value_idx, typename value_t>
@@ -78,6 +86,11 @@ class SparseKNNTest : public ::testing::TestWithParam<SparseKNNInputs<value_idx,
     nnz    = params.indices_h.size();
     k      = params.k;
 
+    if (params.n_streams > 0) {
+      resource::set_cuda_stream_pool(handle,
+                                     std::make_shared<rmm::cuda_stream_pool>(params.n_streams));
+    }
+
     make_data();
 
     raft::sparse::neighbors::brute_force_knn<value_idx, value_t>(indptr.data(),
@@ -169,7 +182,31 @@ const std::vector<SparseKNNInputs<int, float>> inputs_i32_f = {
    2,
    2,
    2,
-   raft::distance::DistanceType::L2SqrtExpanded}};
+   raft::distance::DistanceType::L2SqrtExpanded},
+  // batches searched on the two streams of a pool, with several batches of queries
+  {9,
+   {0, 2, 4, 6, 8},
+   {0, 4, 0, 3, 0, 2, 0, 8},
+   {0.0f, 1.0f, 5.0f, 6.0f, 5.0f, 6.0f, 0.0f, 1.0f},
+   {0, 1.41421, 0, 7.87401, 0, 7.87401, 0, 1.41421},
+   {0, 3, 1, 0, 2, 0, 3, 0},
+   2,
+   2,
+   1,
+   raft::distance::DistanceType::L2SqrtExpanded,
+   2},
+  // more index batches than streams, every merge buffer is reused
+  {9,
+   {0, 2, 4, 6, 8},
+   {0, 4, 0, 3, 0, 2, 0, 8},
+   {0.0f, 1.0f, 5.0f, 6.0f, 5.0f, 6.0f, 0.0f, 1.0f},
+   {0, 0, 0, 0},
+   {0, 1, 2, 3},
+   1,
+   1,
+   2,
+   raft::distance::DistanceType::L2SqrtExpanded,
+   2}};
 typedef SparseKNNTest<int, float> SparseKNNTestF;
 TEST_P(SparseKNNTestF, Result) { compare(); }
 INSTANTIATE_TEST_CASE_P(SparseKNNTest, SparseKNNTestF, ::testing::ValuesIn(inputs_i32_f));
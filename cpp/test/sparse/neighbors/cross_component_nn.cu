@@ -150,6 +150,40 @@ class ConnectComponentsTest
     ASSERT_TRUE(devArrMatch(
       out_edges.vals(), out_edges_batched.vals(), out_edges.nnz, CompareApprox<float>(1e-4)));
 
+    /**
+     * Approximate cross_component_nn, probing too few lists for the first search so that some
+     * components are searched again
+     */
+    raft::sparse::COO<value_t, value_idx> out_edges_ann(stream);
+    raft::sparse::neighbors::cross_component_nn_ann_params ann_params;
+    ann_params.index_params.n_lists   = 4;
+    ann_params.search_params.n_probes = 1;
+    ann_params.n_candidates           = 2;
+    ann_params.batch_size             = params.n_row / 3 + 1;
+    raft::linkage::cross_component_nn<value_idx, value_t>(handle,
+                                                          out_edges_ann,
+                                                          data.data(),
+                                                          colors.data(),
+                                                          params.n_row,
+                                                          params.n_col,
+                                                          red_op,
+                                                          ann_params);
+
+    // Every approximate edge connects different components
+    ASSERT_GT(out_edges_ann.nnz, 0);
+    std::vector<value_idx> colors_h(params.n_row);
+    std::vector<value_idx> ann_rows(out_edges_ann.nnz);
+    std::vector<value_idx> ann_cols(out_edges_ann.nnz);
+    raft::update_host(colors_h.data(), colors.data(), params.n_row, stream);
+    raft::update_host(ann_rows.data(), out_edges_ann.rows(), out_edges_ann.nnz, stream);
+    raft::update_host(ann_cols.data(), out_edges_ann.cols(), out_edges_ann.nnz, stream);
+    resource::sync_stream(handle, stream);
+    for (value_idx i = 0; i < out_edges_ann.nnz; i++) {
+      ASSERT_NE(colors_h[ann_rows[i]], colors_h[ann_cols[i]]);
+    }
+    rmm::device_uvector<value_idx> colors_ann(params.n_row, stream);
+    raft::copy(colors_ann.data(), colors.data(), params.n_row, stream);
+
     /**
      * Construct final edge list
      */
@@ -169,10 +203,26 @@ class ConnectComponentsTest
                                                                     false,
                                                                     false);
 
+    rmm::device_uvector<value_idx> indptr_ann(params.n_row + 1, stream);
+    raft::sparse::convert::sorted_coo_to_csr(
+      out_edges_ann.rows(), out_edges_ann.nnz, indptr_ann.data(), params.n_row + 1, stream);
+
+    auto output_mst_ann = raft::mst::mst<value_idx, value_idx, value_t>(handle,
+                                                                        indptr_ann.data(),
+                                                                        out_edges_ann.cols(),
+                                                                        out_edges_ann.vals(),
+                                                                        params.n_row,
+                                                                        out_edges_ann.nnz,
+                                                                        colors_ann.data(),
+                                                                        stream,
+                                                                        false,
+                                                                        false);
+
     resource::sync_stream(handle, stream);
 
     // The sum of edges for both MST runs should be n_rows - 1
-    final_edges = output_mst.n_edges + mst_coo.n_edges;
+    final_edges     = output_mst.n_edges + mst_coo.n_edges;
+    final_edges_ann = output_mst_ann.n_edges + mst_coo.n_edges;
   }
 
   void SetUp() override { basicTest(); }
@@ -183,6 +233,7 @@ class ConnectComponentsTest
   ConnectComponentsInputs<value_t, value_idx> params;
 
   value_idx final_edges;
+  value_idx final_edges_ann;
 };
 
 const std::vector<ConnectComponentsInputs<float, int>> fix_conn_inputsf2 = {
@@ -378,6 +429,7 @@ TEST_P(ConnectComponentsTestF_Int, Result)
    * Verify the src & dst vertices on each edge have different colors
    */
   EXPECT_TRUE(final_edges == params.n_row - 1);
+  EXPECT_TRUE(final_edges_ann == params.n_row - 1);
 }
 
 INSTANTIATE_TEST_CASE_P(ConnectComponentsTest,
@@ -26,7 +26,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 namespace raft {
 namespace sparse {
@@ -65,7 +68,10 @@ class KNNGraphTest : public ::testing::TestWithParam<KNNGraphInputs<value_idx, v
   KNNGraphTest()
     : params(::testing::TestWithParam<KNNGraphInputs<value_idx, value_t>>::GetParam()),
       stream(resource::get_cuda_stream(handle)),
-      X(0, stream)
+      X(0, stream),
+      csr_indptr(0, stream),
+      csr_indices(0, stream),
+      csr_data(0, stream)
   {
     X.resize(params.X.size(), stream);
   }
@@ -91,6 +97,45 @@ class KNNGraphTest : public ::testing::TestWithParam<KNNGraphInputs<value_idx, v
 
     sum_h = sum.value(stream);
     resource::sync_stream(handle, stream);
+
+    raft::sparse::neighbors::knn_graph(handle,
+                                       X.data(),
+                                       params.m,
+                                       params.n,
+                                       raft::distance::DistanceType::L2Unexpanded,
+                                       csr_indptr,
+                                       csr_indices,
+                                       csr_data);
+  }
+
+  /**
+   * The dense adjacency of the edge list and of the CSR graph, -1 where there is no edge.
+   */
+  void to_dense(std::vector<value_t>& coo_dense, std::vector<value_t>& csr_dense)
+  {
+    std::vector<value_idx> rows_h(out->nnz), cols_h(out->nnz);
+    std::vector<value_t> vals_h(out->nnz);
+    update_host(rows_h.data(), out->rows(), out->nnz, stream);
+    update_host(cols_h.data(), out->cols(), out->nnz, stream);
+    update_host(vals_h.data(), out->vals(), out->nnz, stream);
+
+    std::vector<value_idx> indptr_h(csr_indptr.size()), indices_h(csr_indices.size());
+    std::vector<value_t> data_h(csr_data.size());
+    update_host(indptr_h.data(), csr_indptr.data(), csr_indptr.size(), stream);
+    update_host(indices_h.data(), csr_indices.data(), csr_indices.size(), stream);
+    update_host(data_h.data(), csr_data.data(), csr_data.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    coo_dense.assign(params.m * params.m, value_t(-1));
+    csr_dense.assign(params.m * params.m, value_t(-1));
+    for (size_t i = 0; i < rows_h.size(); i++) {
+      coo_dense[rows_h[i] * params.m + cols_h[i]] = vals_h[i];
+    }
+    for (value_idx row = 0; row < params.m; row++) {
+      for (value_idx i = indptr_h[row]; i < indptr_h[row + 1]; i++) {
+        csr_dense[row * params.m + indices_h[i]] = data_h[i];
+      }
+    }
   }
 
   void TearDown() override { delete out; }
@@ -104,14 +149,34 @@ class KNNGraphTest : public ::testing::TestWithParam<KNNGraphInputs<value_idx, v
 
   rmm::device_uvector<value_t> X;
 
+  rmm::device_uvector<value_idx> csr_indptr, csr_indices;
+  rmm::device_uvector<value_t> csr_data;
+
   value_idx sum_h;
 
   KNNGraphInputs<value_idx, value_t> params;
 };
 
+/**
+ * m points on a spiral, whose knn graph (k < m) has edges in a single direction.
+ */
+KNNGraphInputs<int, float> spiral_inputs(int m)
+{
+  // the k of knn_graph, with its default c = 15
+  int k = std::min(m, int(std::floor(std::log2(m))) + 15);
+  KNNGraphInputs<int, float> inputs{m, 2, std::vector<float>(2 * m), k};
+  for (int i = 0; i < m; i++) {
+    inputs.X[2 * i]     = i * std::cos(0.5f * i);
+    inputs.X[2 * i + 1] = i * std::sin(0.5f * i);
+  }
+  return inputs;
+}
+
 const std::vector<KNNGraphInputs<int, float>> knn_graph_inputs_fint = {
   // Test n_clusters == n_points
-  {4, 2, {0, 100, 0.01, 0.02, 5000, 10000, -5, -2}, 2}};
+  {4, 2, {0, 100, 0.01, 0.02, 5000, 10000, -5, -2}, 2},
+  spiral_inputs(100),
+  spiral_inputs(1000)};
 
 typedef KNNGraphTest<int, float> KNNGraphTestF_int;
 TEST_P(KNNGraphTestF_int, Result)
@@ -119,6 +184,13 @@ TEST_P(KNNGraphTestF_int, Result)
   // nnz should not be larger than twice m * k
   ASSERT_TRUE(out->nnz <= (params.m * params.k * 2));
   ASSERT_TRUE(sum_h == 0);
+
+  // the CSR graph has the same edges and weights as the edge list
+  ASSERT_EQ(csr_indptr.size(), size_t(params.m + 1));
+  ASSERT_EQ(csr_indices.size(), size_t(out->nnz));
+  std::vector<value_t> coo_dense, csr_dense;
+  to_dense(coo_dense, csr_dense);
+  ASSERT_TRUE(hostVecMatch(coo_dense, csr_dense, CompareApprox<value_t>(1e-5)));
 }
 
 INSTANTIATE_TEST_CASE_P(KNNGraphTest,
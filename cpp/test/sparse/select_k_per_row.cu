@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/matrix/select_k.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace sparse {
+
+template <typename index_t>
+struct SelectKPerRowInputs {
+  index_t n_rows;
+  index_t n_cols;
+  float density;
+  index_t max_k;
+  bool select_min;
+  // select the Gaussian weights exp(-x * x) instead of the values
+  bool gaussian;
+};
+
+template <typename index_t>
+::std::ostream& operator<<(::std::ostream& os, const SelectKPerRowInputs<index_t>& params)
+{
+  os << " n_rows: " << params.n_rows << "\tn_cols: " << params.n_cols
+     << "\tdensity: " << params.density << "\tmax_k: " << params.max_k
+     << "\tselect_min: " << params.select_min << "\tgaussian: " << params.gaussian;
+  return os;
+}
+
+template <typename value_t>
+struct gaussian_op {
+  __host__ __device__ value_t operator()(value_t x, int, int) const { return exp(-x * x); }
+};
+
+template <typename value_t, typename index_t>
+class SelectKPerRowTest : public ::testing::TestWithParam<SelectKPerRowInputs<index_t>> {
+ public:
+  SelectKPerRowTest()
+    : params(::testing::TestWithParam<SelectKPerRowInputs<index_t>>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      indptr_d(0, stream),
+      indices_d(0, stream),
+      values_d(0, stream),
+      row_k_d(0, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    std::mt19937 gen(1234ULL);
+    std::uniform_real_distribution<float> keep(0.0f, 1.0f);
+    // the values are multiples of 1/64, with many ties in the long rows
+    std::uniform_int_distribution<int> value(0, 64);
+    std::uniform_int_distribution<index_t> k(0, params.max_k);
+    indptr_h.push_back(0);
+    for (index_t i = 0; i < params.n_rows; i++) {
+      for (index_t j = 0; j < params.n_cols; j++) {
+        if (keep(gen) < params.density) {
+          indices_h.push_back(j);
+          values_h.push_back(value_t(value(gen)) / value_t(64));
+        }
+      }
+      indptr_h.push_back(indices_h.size());
+      row_k_h.push_back(k(gen));
+    }
+
+    indptr_d.resize(indptr_h.size(), stream);
+    indices_d.resize(indices_h.size(), stream);
+    values_d.resize(values_h.size(), stream);
+    row_k_d.resize(row_k_h.size(), stream);
+    update_device(indptr_d.data(), indptr_h.data(), indptr_h.size(), stream);
+    update_device(indices_d.data(), indices_h.data(), indices_h.size(), stream);
+    update_device(values_d.data(), values_h.data(), values_h.size(), stream);
+    update_device(row_k_d.data(), row_k_h.data(), row_k_h.size(), stream);
+  }
+
+  void Run()
+  {
+    auto structure = raft::make_device_compressed_structure_view<index_t, index_t, index_t>(
+      indptr_d.data(), indices_d.data(), params.n_rows, params.n_cols, index_t(values_d.size()));
+    auto in    = raft::make_device_csr_matrix_view<const value_t>(values_d.data(), structure);
+    auto row_k = raft::make_device_vector_view<const index_t>(row_k_d.data(), params.n_rows);
+    auto out   = raft::make_device_csr_matrix<value_t, index_t, index_t, index_t>(
+      handle, params.n_rows, params.n_cols);
+    if (params.gaussian) {
+      raft::sparse::matrix::select_k_per_row(
+        handle, in, row_k, out, params.select_min, gaussian_op<value_t>{});
+    } else {
+      raft::sparse::matrix::select_k_per_row(handle, in, row_k, out, params.select_min);
+    }
+
+    auto out_structure = out.structure_view();
+    index_t nnz        = out_structure.get_nnz();
+    std::vector<index_t> out_indptr(params.n_rows + 1);
+    std::vector<index_t> out_indices(nnz);
+    std::vector<value_t> out_values(nnz);
+    update_host(out_indptr.data(), out_structure.get_indptr().data(), params.n_rows + 1, stream);
+    update_host(out_indices.data(), out_structure.get_indices().data(), nnz, stream);
+    update_host(out_values.data(), out.get_elements().data(), nnz, stream);
+    resource::sync_stream(handle);
+
+    // the reference selection ranks the positions of every row by transformed value, then by
+    // position, and keeps the selected ones in the order of the row
+    std::vector<index_t> expected_indptr{0};
+    std::vector<index_t> expected_indices;
+    std::vector<value_t> expected_values;
+    for (index_t i = 0; i < params.n_rows; i++) {
+      std::vector<value_t> row_values;
+      for (index_t p = indptr_h[i]; p < indptr_h[i + 1]; p++) {
+        row_values.push_back(params.gaussian ? gaussian_op<value_t>{}(values_h[p], i, 0)
+                                             : values_h[p]);
+      }
+      std::vector<index_t> order(row_values.size());
+      std::iota(order.begin(), order.end(), index_t(0));
+      std::stable_sort(order.begin(), order.end(), [&](index_t a, index_t b) {
+        return params.select_min ? row_values[a] < row_values[b] : row_values[a] > row_values[b];
+      });
+      order.resize(std::min<size_t>(order.size(), row_k_h[i]));
+      std::sort(order.begin(), order.end());
+      for (auto p : order) {
+        expected_indices.push_back(indices_h[indptr_h[i] + p]);
+        expected_values.push_back(row_values[p]);
+      }
+      expected_indptr.push_back(expected_indices.size());
+    }
+
+    ASSERT_TRUE(hostVecMatch(expected_indptr, out_indptr, Compare<index_t>()));
+    ASSERT_TRUE(hostVecMatch(expected_indices, out_indices, Compare<index_t>()));
+    ASSERT_TRUE(hostVecMatch(expected_values, out_values, CompareApprox<value_t>(1e-5)));
+  }
+
+  raft::resources handle;
+  SelectKPerRowInputs<index_t> params;
+  cudaStream_t stream;
+
+  std::vector<index_t> indptr_h, indices_h, row_k_h;
+  std::vector<value_t> values_h;
+  rmm::device_uvector<index_t> indptr_d, indices_d, row_k_d;
+  rmm::device_uvector<value_t> values_d;
+};
+
+const std::vector<SelectKPerRowInputs<int>> inputs = {
+  {1, 1, 1.0f, 1, true, false},
+  {10, 32, 0.5f, 8, true, false},
+  {10, 32, 0.5f, 8, false, true},
+  {100, 1000, 0.1f, 50, true, false},
+  {100, 1000, 0.1f, 50, false, true},
+  {200, 300, 0.9f, 300, true, true},
+  {50, 5000, 0.8f, 1000, false, false},
+  {50, 5000, 0.8f, 1000, true, true},
+  {300, 100, 0.0f, 10, true, false},
+};
+
+using SelectKPerRowTestF = SelectKPerRowTest<float, int>;
+TEST_P(SelectKPerRowTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SelectKPerRowTest, SelectKPerRowTestF, ::testing::ValuesIn(inputs));
+
+using SelectKPerRowTestD = SelectKPerRowTest<double, int>;
+TEST_P(SelectKPerRowTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SelectKPerRowTest, SelectKPerRowTestD, ::testing::ValuesIn(inputs));
+
+}  // namespace sparse
+}  // namespace raft
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/linalg/spgemm.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/cuda_memory_resource.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace sparse {
+
+template <typename value_t, typename index_t>
+struct SpgemmInputs {
+  index_t m;
+  index_t k;
+  index_t n;
+
+  float density_a;
+  float density_b;
+
+  // the workspace limit in bytes, 0 for the default workspace
+  size_t workspace_limit;
+
+  unsigned long long int seed;
+};
+
+template <typename value_t, typename index_t>
+::std::ostream& operator<<(::std::ostream& os, const SpgemmInputs<value_t, index_t>& params)
+{
+  os << " m: " << params.m << "\tk: " << params.k << "\tn: " << params.n
+     << "\tdensity_a: " << params.density_a << "\tdensity_b: " << params.density_b
+     << "\tworkspace_limit: " << params.workspace_limit;
+  return os;
+}
+
+template <typename value_t, typename index_t>
+struct host_csr {
+  std::vector<index_t> indptr;
+  std::vector<index_t> indices;
+  std::vector<value_t> values;
+};
+
+template <typename value_t, typename index_t>
+host_csr<value_t, index_t> make_host_csr(index_t n_rows,
+                                         index_t n_cols,
+                                         float density,
+                                         std::mt19937& gen)
+{
+  std::uniform_real_distribution<float> keep(0.0f, 1.0f);
+  std::uniform_real_distribution<value_t> value(-1.0, 1.0);
+  host_csr<value_t, index_t> out;
+  out.indptr.push_back(0);
+  for (index_t i = 0; i < n_rows; i++) {
+    for (index_t j = 0; j < n_cols; j++) {
+      if (keep(gen) < density) {
+        out.indices.push_back(j);
+        out.values.push_back(value(gen));
+      }
+    }
+    out.indptr.push_back(out.indices.size());
+  }
+  return out;
+}
+
+template <typename value_t, typename index_t>
+class SpgemmTest : public ::testing::TestWithParam<SpgemmInputs<value_t, index_t>> {
+ public:
+  SpgemmTest()
+    : params(::testing::TestWithParam<SpgemmInputs<value_t, index_t>>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      a_indptr(0, stream),
+      a_indices(0, stream),
+      a_values(0, stream),
+      b_indptr(0, stream),
+      b_indices(0, stream),
+      b_values(0, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    std::mt19937 gen(params.seed);
+    a_h = make_host_csr<value_t, index_t>(params.m, params.k, params.density_a, gen);
+    b_h = make_host_csr<value_t, index_t>(params.k, params.n, params.density_b, gen);
+
+    to_device(a_h, a_indptr, a_indices, a_values);
+    to_device(b_h, b_indptr, b_indices, b_values);
+
+    if (params.workspace_limit > 0) {
+      resource::set_workspace_resource(
+        handle, std::make_shared<rmm::mr::cuda_memory_resource>(), params.workspace_limit);
+    }
+  }
+
+  void to_device(const host_csr<value_t, index_t>& h,
+                 rmm::device_uvector<index_t>& indptr,
+                 rmm::device_uvector<index_t>& indices,
+                 rmm::device_uvector<value_t>& values)
+  {
+    indptr.resize(h.indptr.size(), stream);
+    indices.resize(h.indices.size(), stream);
+    values.resize(h.values.size(), stream);
+    update_device(indptr.data(), h.indptr.data(), h.indptr.size(), stream);
+    update_device(indices.data(), h.indices.data(), h.indices.size(), stream);
+    update_device(values.data(), h.values.data(), h.values.size(), stream);
+  }
+
+  void Run()
+  {
+    auto a_structure = raft::make_device_compressed_structure_view<index_t, index_t, index_t>(
+      a_indptr.data(), a_indices.data(), params.m, params.k, index_t(a_values.size()));
+    auto b_structure = raft::make_device_compressed_structure_view<index_t, index_t, index_t>(
+      b_indptr.data(), b_indices.data(), params.k, params.n, index_t(b_values.size()));
+    auto A = raft::make_device_csr_matrix_view<const value_t>(a_values.data(), a_structure);
+    auto B = raft::make_device_csr_matrix_view<const value_t>(b_values.data(), b_structure);
+
+    auto C = raft::make_device_csr_matrix<value_t, index_t, index_t, index_t>(
+      handle, params.m, params.n);
+    raft::sparse::linalg::spgemm(handle, A, B, C);
+
+    auto c_structure = C.structure_view();
+    index_t nnz      = c_structure.get_nnz();
+    std::vector<index_t> c_indptr(params.m + 1);
+    std::vector<index_t> c_indices(nnz);
+    std::vector<value_t> c_values(nnz);
+    update_host(c_indptr.data(), c_structure.get_indptr().data(), params.m + 1, stream);
+    update_host(c_indices.data(), c_structure.get_indices().data(), nnz, stream);
+    update_host(c_values.data(), C.get_elements().data(), nnz, stream);
+    resource::sync_stream(handle);
+
+    // the reference product, and its number of structural nonzeros
+    std::vector<value_t> expected(size_t(params.m) * params.n, value_t(0));
+    std::vector<bool> structural(size_t(params.m) * params.n, false);
+    for (index_t i = 0; i < params.m; i++) {
+      for (index_t p = a_h.indptr[i]; p < a_h.indptr[i + 1]; p++) {
+        index_t l = a_h.indices[p];
+        for (index_t q = b_h.indptr[l]; q < b_h.indptr[l + 1]; q++) {
+          index_t j = b_h.indices[q];
+          expected[size_t(i) * params.n + j] += a_h.values[p] * b_h.values[q];
+          structural[size_t(i) * params.n + j] = true;
+        }
+      }
+    }
+    index_t expected_nnz = std::count(structural.begin(), structural.end(), true);
+    ASSERT_EQ(nnz, expected_nnz);
+    ASSERT_EQ(c_indptr[0], 0);
+    ASSERT_EQ(c_indptr[params.m], nnz);
+
+    std::vector<value_t> actual(size_t(params.m) * params.n, value_t(0));
+    for (index_t i = 0; i < params.m; i++) {
+      for (index_t p = c_indptr[i]; p < c_indptr[i + 1]; p++) {
+        if (p > c_indptr[i]) { ASSERT_LT(c_indices[p - 1], c_indices[p]) << "row " << i; }
+        ASSERT_TRUE(structural[size_t(i) * params.n + c_indices[p]]) << "row " << i;
+        actual[size_t(i) * params.n + c_indices[p]] = c_values[p];
+      }
+    }
+    ASSERT_TRUE(hostVecMatch(expected, actual, CompareApprox<value_t>(1e-4)));
+  }
+
+  raft::resources handle;
+  SpgemmInputs<value_t, index_t> params;
+  cudaStream_t stream;
+
+  host_csr<value_t, index_t> a_h, b_h;
+  rmm::device_uvector<index_t> a_indptr, a_indices;
+  rmm::device_uvector<value_t> a_values;
+  rmm::device_uvector<index_t> b_indptr, b_indices;
+  rmm::device_uvector<value_t> b_values;
+};
+
+const std::vector<SpgemmInputs<float, int>> inputs_f = {
+  {1, 1, 1, 1.0f, 1.0f, 0, 1234ULL},
+  {32, 64, 48, 0.1f, 0.1f, 0, 1234ULL},
+  {200, 100, 300, 0.05f, 0.2f, 0, 1234ULL},
+  {100, 300, 50, 0.3f, 0.3f, 0, 1234ULL},
+  {300, 200, 400, 0.0f, 0.1f, 0, 1234ULL},
+  // a small workspace splits the rows in several chunks
+  {500, 200, 400, 0.05f, 0.1f, 64 * 1024, 1234ULL},
+  {64, 500, 2000, 0.2f, 0.2f, 64 * 1024, 1234ULL},
+};
+
+const std::vector<SpgemmInputs<double, int>> inputs_d = {
+  {32, 64, 48, 0.1f, 0.1f, 0, 1234ULL},
+  {500, 200, 400, 0.05f, 0.1f, 64 * 1024, 1234ULL},
+};
+
+using SpgemmTestF = SpgemmTest<float, int>;
+TEST_P(SpgemmTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SpgemmTest, SpgemmTestF, ::testing::ValuesIn(inputs_f));
+
+using SpgemmTestD = SpgemmTest<double, int>;
+TEST_P(SpgemmTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SpgemmTest, SpgemmTestD, ::testing::ValuesIn(inputs_d));
+
+}  // namespace sparse
+}  // namespace raft
@@ -19,13 +19,20 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/random/rng.cuh>
+#include <raft/sparse/linalg/sparse_operator.hpp>
 #include <raft/sparse/linalg/spmm.hpp>
 #include <raft/util/cuda_utils.cuh>
 
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
 #include <thrust/fill.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace raft {
 namespace sparse {
 namespace linalg {
@@ -146,7 +153,12 @@ class SpmmTest : public ::testing::TestWithParam<SpmmInputs<T>> {
     return {ldx, ldy, ldz, x_size, y_size, z_size};
   }
 
-  void runTest()
+  /**
+   * wide_indptr runs X with 64-bit index pointers and 32-bit indices, and a positive
+   * max_chunk_nnz splits its rows in chunks of at most that many nonzeros. cached runs the
+   * product twice with a sparse_operator, the second time on copies of Y and Z.
+   */
+  void runTest(bool wide_indptr = false, int64_t max_chunk_nnz = 0, bool cached = false)
   {
     auto stream = resource::get_cuda_stream(handle);
 
@@ -165,18 +177,23 @@ class SpmmTest : public ::testing::TestWithParam<SpmmInputs<T>> {
     auto X_csr = raft::device_csr_matrix_view<const T, int, int, int>(
       raft::device_span<const T>(X_data, X_csr_structure.get_nnz()), X_csr_structure);
 
-    auto y_stride_view =
-      params.row_major
-        ? raft::make_device_strided_matrix_view<const T, int, layout_c_contiguous>(
-            Y, params.trans_y ? params.N : params.K, params.trans_y ? params.K : params.N, ldy)
-        : raft::make_device_strided_matrix_view<const T, int, layout_f_contiguous>(
-            Y, params.trans_y ? params.N : params.K, params.trans_y ? params.K : params.N, ldy);
-
-    auto z_stride_view = params.row_major
-                           ? raft::make_device_strided_matrix_view<T, int, layout_c_contiguous>(
-                               Z, params.M, params.N, ldz)
-                           : raft::make_device_strided_matrix_view<T, int, layout_f_contiguous>(
-                               Z, params.M, params.N, ldz);
+    int y_rows     = params.trans_y ? params.N : params.K;
+    int y_cols     = params.trans_y ? params.K : params.N;
+    auto y_view_of = [&, ldy = ldy](const T* ptr) {
+      return params.row_major
+               ? raft::make_device_strided_matrix_view<const T, int, layout_c_contiguous>(
+                   ptr, y_rows, y_cols, ldy)
+               : raft::make_device_strided_matrix_view<const T, int, layout_f_contiguous>(
+                   ptr, y_rows, y_cols, ldy);
+    };
+    auto z_view_of = [&, ldz = ldz](T* ptr) {
+      return params.row_major ? raft::make_device_strided_matrix_view<T, int, layout_c_contiguous>(
+                                  ptr, params.M, params.N, ldz)
+                              : raft::make_device_strided_matrix_view<T, int, layout_f_contiguous>(
+                                  ptr, params.M, params.N, ldz);
+    };
+    auto y_stride_view = y_view_of(Y);
+    auto z_stride_view = z_view_of(Z);
 
     T alpha = params.alpha;
     T beta  = params.beta;
@@ -200,8 +217,62 @@ class SpmmTest : public ::testing::TestWithParam<SpmmInputs<T>> {
                                               ldz,
                                               params.row_major);
 
-    spmm(
-      handle, params.trans_x, params.trans_y, &alpha, X_csr, y_stride_view, &beta, z_stride_view);
+    if (cached) {
+      sparse_operator<T, int, int> op(handle, X_csr);
+      rmm::device_uvector<T> Y_copy(y_size, stream);
+      rmm::device_uvector<T> Z_copy(z_size, stream);
+      raft::copy(Y_copy.data(), Y, y_size, stream);
+      raft::copy(Z_copy.data(), Z, z_size, stream);
+      op.spmm(params.trans_x, params.trans_y, &alpha, y_stride_view, &beta, z_stride_view);
+      // the descriptors of the first product only get the new pointer of Y
+      op.spmm(params.trans_x,
+              params.trans_y,
+              &alpha,
+              y_view_of(Y_copy.data()),
+              &beta,
+              z_view_of(Z_copy.data()));
+      ASSERT_TRUE(
+        raft::devArrMatch(Z_ref, Z_copy.data(), z_size, raft::CompareApprox<T>(1e-3f), stream));
+    } else if (!wide_indptr) {
+      spmm(
+        handle, params.trans_x, params.trans_y, &alpha, X_csr, y_stride_view, &beta, z_stride_view);
+    } else {
+      int n_rows = X_csr_structure.get_n_rows();
+      rmm::device_uvector<int64_t> X_indptr_wide(n_rows + 1, stream);
+      thrust::copy(resource::get_thrust_policy(handle),
+                   X_indptr,
+                   X_indptr + n_rows + 1,
+                   X_indptr_wide.data());
+      auto X_wide_structure = raft::make_device_compressed_structure_view<int64_t, int, int64_t>(
+        X_indptr_wide.data(),
+        X_indices,
+        int64_t(n_rows),
+        X_csr_structure.get_n_cols(),
+        int64_t(X_nnz));
+      auto X_wide = raft::device_csr_matrix_view<const T, int64_t, int, int64_t>(
+        raft::device_span<const T>(X_data, X_nnz), X_wide_structure);
+      if (max_chunk_nnz > 0) {
+        detail::spmm_row_chunks(handle,
+                                params.trans_x,
+                                params.trans_y,
+                                params.row_major,
+                                &alpha,
+                                X_wide,
+                                y_stride_view,
+                                &beta,
+                                z_stride_view,
+                                max_chunk_nnz);
+      } else {
+        spmm(handle,
+             params.trans_x,
+             params.trans_y,
+             &alpha,
+             X_wide,
+             y_stride_view,
+             &beta,
+             z_stride_view);
+      }
+    }
 
     resource::sync_stream(handle, stream);
 
@@ -314,9 +385,14 @@ const std::vector<SpmmInputs<double>> inputsd = {
 
 typedef SpmmTest<float> SpmmTestF;
 TEST_P(SpmmTestF, Result) { runTest(); }
+TEST_P(SpmmTestF, WideIndptr) { runTest(true); }
+TEST_P(SpmmTestF, RowChunks) { runTest(true, std::max(X_nnz / 5, 1)); }
+TEST_P(SpmmTestF, CachedOperator) { runTest(false, 0, true); }
 
 typedef SpmmTest<double> SpmmTestD;
 TEST_P(SpmmTestD, Result) { runTest(); }
+TEST_P(SpmmTestD, RowChunks) { runTest(true, std::max(X_nnz / 5, 1)); }
+TEST_P(SpmmTestD, CachedOperator) { runTest(false, 0, true); }
 
 INSTANTIATE_TEST_SUITE_P(SpmmTests, SpmmTestF, ::testing::ValuesIn(inputsf));
 
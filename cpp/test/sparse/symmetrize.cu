@@ -32,11 +32,11 @@
 namespace raft {
 namespace sparse {
 
-template <typename value_idx, typename value_t>
+template <typename value_idx, typename value_t, typename nnz_t>
 RAFT_KERNEL assert_symmetry(
-  value_idx* rows, value_idx* cols, value_t* vals, value_idx nnz, value_idx* sum)
+  value_idx* rows, value_idx* cols, value_t* vals, nnz_t nnz, value_idx* sum)
 {
-  int tid = blockDim.x * blockIdx.x + threadIdx.x;
+  nnz_t tid = nnz_t(blockDim.x) * blockIdx.x + threadIdx.x;
 
   if (tid >= nnz) return;
 
@@ -60,7 +60,7 @@ template <typename value_idx, typename value_t>
   return os;
 }
 
-template <typename value_idx, typename value_t>
+template <typename value_idx, typename value_t, typename nnz_t = value_idx>
 class SparseSymmetrizeTest
   : public ::testing::TestWithParam<SparseSymmetrizeInputs<value_idx, value_t>> {
  public:
@@ -101,7 +101,7 @@ class SparseSymmetrizeTest
 
     raft::sparse::convert::csr_to_coo(indptr.data(), m, coo_rows.data(), nnz, stream);
 
-    raft::sparse::COO<value_t, value_idx> out(stream);
+    raft::sparse::COO<value_t, value_idx, nnz_t> out(stream);
 
     raft::sparse::linalg::symmetrize(
       handle, coo_rows.data(), indices.data(), data.data(), m, n, coo_rows.size(), out);
@@ -109,7 +109,7 @@ class SparseSymmetrizeTest
     rmm::device_scalar<value_idx> sum(stream);
     sum.set_value_to_zero_async(stream);
 
-    assert_symmetry<<<raft::ceildiv(out.nnz, 256), 256, 0, stream>>>(
+    assert_symmetry<<<raft::ceildiv<nnz_t>(out.nnz, 256), 256, 0, stream>>>(
       out.rows(), out.cols(), out.vals(), out.nnz, sum.data());
 
     sum_h = sum.value(stream);
@@ -218,5 +218,13 @@ INSTANTIATE_TEST_CASE_P(SparseSymmetrizeTest,
                         SparseSymmetrizeTestF_int,
                         ::testing::ValuesIn(symm_inputs_fint));
 
+// 64-bit nonzeros with 32-bit indices
+typedef SparseSymmetrizeTest<int, float, int64_t> SparseSymmetrizeTestF_int_int64;
+TEST_P(SparseSymmetrizeTestF_int_int64, Result) { ASSERT_TRUE(sum_h == 0); }
+
+INSTANTIATE_TEST_CASE_P(SparseSymmetrizeTest,
+                        SparseSymmetrizeTestF_int_int64,
+                        ::testing::ValuesIn(symm_inputs_fint));
+
 }  // namespace sparse
 }  // namespace raft
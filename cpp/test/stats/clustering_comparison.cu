@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/stats/adjusted_rand_index.cuh>
+#include <raft/stats/clustering_comparison.cuh>
+#include <raft/stats/v_measure.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace raft {
+namespace stats {
+
+struct ClusteringComparisonInputs {
+  int n;
+  int lower_label, upper_label;
+  // fraction of the predicted labels copied from the truth
+  double agreement;
+  double beta;
+  unsigned long long seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const ClusteringComparisonInputs& ps)
+{
+  return os << "n: " << ps.n << "; labels: [" << ps.lower_label << ", " << ps.upper_label
+            << "]; agreement: " << ps.agreement << "; beta: " << ps.beta;
+}
+
+// reference metrics computed on the host in double precision
+inline clustering_comparison reference_comparison(const std::vector<int>& truth,
+                                                  const std::vector<int>& pred,
+                                                  double beta)
+{
+  const double n = truth.size();
+  std::map<std::pair<int, int>, double> cells;
+  std::map<int, double> a, b;
+  for (size_t k = 0; k < truth.size(); k++) {
+    cells[{truth[k], pred[k]}] += 1;
+    a[truth[k]] += 1;
+    b[pred[k]] += 1;
+  }
+  auto choose2 = [](double c) { return c * (c - 1) / 2; };
+  double index = 0, mi = 0, sum_a = 0, sum_b = 0, h_truth = 0, h_pred = 0;
+  for (auto& [key, c] : cells) {
+    index += choose2(c);
+    mi += c / n * std::log(n * c / (a[key.first] * b[key.second]));
+  }
+  for (auto& [l, c] : a) {
+    sum_a += choose2(c);
+    h_truth -= c / n * std::log(c / n);
+  }
+  for (auto& [l, c] : b) {
+    sum_b += choose2(c);
+    h_pred -= c / n * std::log(c / n);
+  }
+
+  clustering_comparison res;
+  if (a.size() == b.size() && (a.size() == 1 || a.size() == truth.size())) {
+    res.adjusted_rand_index = 1.0;
+  } else {
+    double expected         = sum_a * sum_b / choose2(n);
+    double max_index        = (sum_a + sum_b) / 2;
+    res.adjusted_rand_index =
+      max_index != expected ? (index - expected) / (max_index - expected) : 0.0;
+  }
+  res.mutual_info   = mi;
+  res.truth_entropy = h_truth;
+  res.pred_entropy  = h_pred;
+  res.homogeneity   = h_truth ? mi / h_truth : 1.0;
+  res.completeness  = h_pred ? mi / h_pred : 1.0;
+  res.v_measure     = res.homogeneity + res.completeness == 0
+                        ? 0.0
+                        : (1 + beta) * res.homogeneity * res.completeness /
+                        (beta * res.homogeneity + res.completeness);
+  return res;
+}
+
+template <typename T>
+class ClusteringComparisonTest : public ::testing::TestWithParam<ClusteringComparisonInputs> {
+ protected:
+  ClusteringComparisonTest()
+    : params(::testing::TestWithParam<ClusteringComparisonInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+  void Run()
+  {
+    std::mt19937 gen(params.seed);
+    std::uniform_int_distribution<int> label_dist(params.lower_label, params.upper_label);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::vector<int> truth_h(params.n), pred_h(params.n);
+    for (int k = 0; k < params.n; k++) {
+      truth_h[k] = label_dist(gen);
+      pred_h[k]  = coin(gen) < params.agreement ? truth_h[k] : label_dist(gen);
+    }
+    auto ref = reference_comparison(truth_h, pred_h, params.beta);
+
+    auto truth = raft::make_device_vector<T, int>(handle, params.n);
+    auto pred  = raft::make_device_vector<T, int>(handle, params.n);
+    std::vector<T> truth_t(truth_h.begin(), truth_h.end()), pred_t(pred_h.begin(), pred_h.end());
+    raft::update_device(truth.data_handle(), truth_t.data(), params.n, stream);
+    raft::update_device(pred.data_handle(), pred_t.data(), params.n, stream);
+
+    auto res = compare_clusterings(handle,
+                                   raft::make_const_mdspan(truth.view()),
+                                   raft::make_const_mdspan(pred.view()),
+                                   params.beta);
+
+    const double tol = 1e-6;
+    ASSERT_NEAR(ref.adjusted_rand_index, res.adjusted_rand_index, tol);
+    ASSERT_NEAR(ref.mutual_info, res.mutual_info, tol);
+    ASSERT_NEAR(ref.truth_entropy, res.truth_entropy, tol);
+    ASSERT_NEAR(ref.pred_entropy, res.pred_entropy, tol);
+    ASSERT_NEAR(ref.homogeneity, res.homogeneity, tol);
+    ASSERT_NEAR(ref.completeness, res.completeness, tol);
+    ASSERT_NEAR(ref.v_measure, res.v_measure, tol);
+
+    // the individual metrics, when their dense contingency matrix fits
+    if (params.upper_label - params.lower_label < 1000) {
+      double ari = adjusted_rand_index<T, unsigned long long>(
+        truth.data_handle(), pred.data_handle(), params.n, stream);
+      double v = v_measure(truth.data_handle(),
+                           pred.data_handle(),
+                           params.n,
+                           T(params.lower_label),
+                           T(params.upper_label),
+                           stream,
+                           params.beta);
+      ASSERT_NEAR(ari, res.adjusted_rand_index, tol);
+      ASSERT_NEAR(v, res.v_measure, tol);
+    }
+  }
+
+  raft::resources handle;
+  ClusteringComparisonInputs params;
+  cudaStream_t stream;
+};
+
+const std::vector<ClusteringComparisonInputs> inputs = {
+  // dense contingency matrix
+  {2, 0, 1, 1.0, 1.0, 1234ULL},
+  {1000, 0, 0, 0.0, 1.0, 1234ULL},
+  {1000, 0, 9, 1.0, 1.0, 1234ULL},
+  {1000, 0, 9, 0.0, 1.0, 1234ULL},
+  {10000, 1, 20, 0.7, 1.0, 1234ULL},
+  {10000, -10, 10, 0.7, 0.5, 1234ULL},
+  {100000, 0, 99, 0.3, 2.0, 1234ULL},
+  // hashed cells: many more label pairs than samples
+  {10000, 0, 4999, 0.5, 1.0, 1234ULL},
+  {100000, 0, 99999, 0.9, 1.0, 1234ULL},
+  {100000, 0, 99999, 0.0, 1.0, 1234ULL},
+  {200000, 100, 1000099, 0.5, 1.0, 1234ULL}};
+
+using ClusteringComparisonTestI = ClusteringComparisonTest<int>;
+TEST_P(ClusteringComparisonTestI, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(ClusteringComparisonTests,
+                        ClusteringComparisonTestI,
+                        ::testing::ValuesIn(inputs));
+
+using ClusteringComparisonTestL = ClusteringComparisonTest<int64_t>;
+TEST_P(ClusteringComparisonTestL, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(ClusteringComparisonTests,
+                        ClusteringComparisonTestL,
+                        ::testing::ValuesIn(inputs));
+
+}  // end namespace stats
+}  // end namespace raft
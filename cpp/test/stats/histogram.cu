@@ -276,6 +276,19 @@ const std::vector<HistInputs> inputs = {
   {oneM + 2, 21, 2 * oneK, false, HistTypeSmemHash, 0, 2 * oneK, 1234ULL},
   {oneM + 2, 21, 2 * oneK, true, HistTypeSmemHash, 1000, 50, 1234ULL},
 
+  {oneM, 1, 2 * oneK, false, HistTypeSmemTiled, 0, 2 * oneK, 1234ULL},
+  {oneM, 1, 2 * oneK, true, HistTypeSmemTiled, 1000, 50, 1234ULL},
+  {oneM + 1, 1, 64 * oneK, false, HistTypeSmemTiled, 0, 64 * oneK, 1234ULL},
+  {oneM + 1, 1, 64 * oneK, true, HistTypeSmemTiled, 1000, 50, 1234ULL},
+  {oneM + 2, 1, 2 * oneM, false, HistTypeSmemTiled, 0, 2 * oneM, 1234ULL},
+  {oneM + 2, 1, 2 * oneM, true, HistTypeSmemTiled, 1000, 50, 1234ULL},
+  {oneM, 21, 64 * oneK, false, HistTypeSmemTiled, 0, 64 * oneK, 1234ULL},
+  {oneM, 21, 64 * oneK, true, HistTypeSmemTiled, 1000, 50, 1234ULL},
+  {oneM + 1, 21, 2 * oneK, false, HistTypeSmemTiled, 0, 2 * oneK, 1234ULL},
+  {oneM + 1, 21, 2 * oneK, true, HistTypeSmemTiled, 1000, 50, 1234ULL},
+  {oneM + 2, 21, 64 * oneK, false, HistTypeSmemTiled, 0, 64 * oneK, 1234ULL},
+  {oneM + 2, 21, 64 * oneK, true, HistTypeSmemTiled, 1000, 50, 1234ULL},
+
   {oneM, 1, 2 * oneM, false, HistTypeAuto, 0, 2 * oneM, 1234ULL},
   {oneM, 1, 2 * oneM, true, HistTypeAuto, 1000, 50, 1234ULL},
   {oneM + 1, 1, 2 * oneM, false, HistTypeAuto, 0, 2 * oneM, 1234ULL},
@@ -300,6 +313,9 @@ const std::vector<HistInputs> inputs = {
   {oneM + 1, 21, 2 * oneK, true, HistTypeAuto, 1000, 50, 1234ULL},
   {oneM + 2, 21, 2 * oneK, false, HistTypeAuto, 0, 2 * oneK, 1234ULL},
   {oneM + 2, 21, 2 * oneK, true, HistTypeAuto, 1000, 50, 1234ULL},
+  {oneM, 1, 64 * oneK, false, HistTypeAuto, 0, 64 * oneK, 1234ULL},
+  {oneM, 21, 64 * oneK, true, HistTypeAuto, 1000, 50, 1234ULL},
+  {oneK, 21, 64 * oneK, false, HistTypeAuto, 0, 64 * oneK, 1234ULL},
 };
 
 TEST_P(HistTest, Result)
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../loopback_comms.hpp"
+#include "../test_utils.cuh"
+
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/stats/moments.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace stats {
+
+struct MomentsInputs {
+  int64_t rows, cols, batch_rows;
+  bool rowMajor;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const MomentsInputs& ps)
+{
+  return os << "rows: " << ps.rows << "; cols: " << ps.cols << "; batch_rows: " << ps.batch_rows
+            << "; " << (ps.rowMajor ? "row-major" : "col-major");
+}
+
+template <typename T>
+class MomentsTest : public ::testing::TestWithParam<MomentsInputs> {
+ public:
+  MomentsTest()
+    : params(::testing::TestWithParam<MomentsInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+    resource::set_comms(handle,
+                        std::make_shared<comms::comms_t>(std::make_unique<loopback_comms>()));
+  }
+
+ protected:
+  // add the rows [row0, row0 + n_rows) of the host data to the accumulator
+  void add_rows(moments_accumulator<T>& acc, const std::vector<T>& data_h, int64_t row0, int64_t n)
+  {
+    const int64_t cols = params.cols;
+    std::vector<T> batch_h(n * cols);
+    for (int64_t i = 0; i < n; i++) {
+      for (int64_t j = 0; j < cols; j++) {
+        auto pos     = params.rowMajor ? i * cols + j : j * n + i;
+        batch_h[pos] = data_h[(row0 + i) * cols + j];
+      }
+    }
+    auto batch = raft::make_device_vector<T, int64_t>(handle, n * cols);
+    raft::update_device(batch.data_handle(), batch_h.data(), batch_h.size(), stream);
+    if (params.rowMajor) {
+      acc.update(handle,
+                 raft::make_device_matrix_view<const T, int64_t, raft::row_major>(
+                   batch.data_handle(), n, cols));
+    } else {
+      acc.update(handle,
+                 raft::make_device_matrix_view<const T, int64_t, raft::col_major>(
+                   batch.data_handle(), n, cols));
+    }
+    resource::sync_stream(handle, stream);
+  }
+
+  void Run()
+  {
+    const int64_t rows = params.rows, cols = params.cols;
+    std::mt19937 gen(params.seed);
+    // skewed columns with different scales and offsets
+    std::gamma_distribution<double> dist(2.0, 1.0);
+    std::vector<T> data_h(rows * cols);
+    for (int64_t i = 0; i < rows; i++) {
+      for (int64_t j = 0; j < cols; j++) {
+        data_h[i * cols + j] = T((j % 3 + 1) * dist(gen) + 100.0 * (j % 5));
+      }
+    }
+
+    // two-pass reference in double precision
+    std::vector<T> mean_ref(cols), var_ref(cols), skew_ref(cols), kurt_ref(cols);
+    for (int64_t j = 0; j < cols; j++) {
+      double mu = 0;
+      for (int64_t i = 0; i < rows; i++) {
+        mu += data_h[i * cols + j];
+      }
+      mu /= rows;
+      double m2 = 0, m3 = 0, m4 = 0;
+      for (int64_t i = 0; i < rows; i++) {
+        double d = data_h[i * cols + j] - mu;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+      }
+      mean_ref[j] = T(mu);
+      var_ref[j]  = T(m2 / (rows - 1));
+      skew_ref[j] = T(std::sqrt(double(rows)) * m3 / std::pow(m2, 1.5));
+      kurt_ref[j] = T(rows * m4 / (m2 * m2) - 3.0);
+    }
+
+    // the first half of the batches in one accumulator, the rest in another, then merged
+    moments_accumulator<T> acc(handle, cols), acc2(handle, cols);
+    for (int64_t row0 = 0; row0 < rows; row0 += params.batch_rows) {
+      auto n = std::min(params.batch_rows, rows - row0);
+      add_rows(row0 < rows / 2 ? acc : acc2, data_h, row0, n);
+    }
+    acc.merge(handle, acc2);
+    acc.allreduce(handle);
+
+    auto mean = raft::make_device_vector<T, int64_t>(handle, cols);
+    auto var  = raft::make_device_vector<T, int64_t>(handle, cols);
+    auto skew = raft::make_device_vector<T, int64_t>(handle, cols);
+    auto kurt = raft::make_device_vector<T, int64_t>(handle, cols);
+    acc.mean(handle, mean.view());
+    acc.var(handle, var.view(), true);
+    acc.skewness(handle, skew.view());
+    acc.kurtosis(handle, kurt.view());
+
+    const T tol = std::is_same_v<T, float> ? T(1e-3) : T(1e-8);
+    ASSERT_TRUE(devArrMatchHost(
+      mean_ref.data(), mean.data_handle(), cols, CompareApprox<T>(tol), stream));
+    ASSERT_TRUE(devArrMatchHost(
+      var_ref.data(), var.data_handle(), cols, CompareApprox<T>(tol), stream));
+    ASSERT_TRUE(devArrMatchHost(
+      skew_ref.data(), skew.data_handle(), cols, CompareApprox<T>(tol), stream));
+    ASSERT_TRUE(devArrMatchHost(
+      kurt_ref.data(), kurt.data_handle(), cols, CompareApprox<T>(tol), stream));
+  }
+
+  raft::resources handle;
+  MomentsInputs params;
+  cudaStream_t stream;
+};
+
+const std::vector<MomentsInputs> inputs = {{2, 1, 1, true, 1234ULL},
+                                           {1000, 7, 1000, true, 1234ULL},
+                                           {1000, 7, 1000, false, 1234ULL},
+                                           {10000, 33, 777, true, 1234ULL},
+                                           {10000, 33, 777, false, 1234ULL},
+                                           {100000, 5, 30000, true, 1234ULL},
+                                           {100000, 5, 30000, false, 1234ULL},
+                                           {20000, 300, 4096, true, 1234ULL},
+                                           {20000, 300, 4096, false, 1234ULL}};
+
+using MomentsTestF = MomentsTest<float>;
+TEST_P(MomentsTestF, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(MomentsTests, MomentsTestF, ::testing::ValuesIn(inputs));
+
+using MomentsTestD = MomentsTest<double>;
+TEST_P(MomentsTestD, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(MomentsTests, MomentsTestD, ::testing::ValuesIn(inputs));
+
+}  // end namespace stats
+}  // end namespace raft
@@ -17,6 +17,7 @@
 
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/distance/distance_types.hpp>
+#include <raft/random/rng_state.hpp>
 #include <raft/stats/silhouette_score.cuh>
 #include <raft/util/cudart_utils.hpp>
 
@@ -27,6 +28,7 @@
 #include <algorithm>
 #include <iostream>
 #include <random>
+#include <vector>
 
 namespace raft {
 namespace stats {
@@ -189,6 +191,21 @@ class silhouetteScoreTest : public ::testing::TestWithParam<silhouetteScoreParam
       nLabels,
       chunk,
       params.metric);
+
+    // sampling all the points gives the exact score
+    raft::random::RngState rng(1234ULL);
+    auto estimate = raft::stats::silhouette_score_sampled(
+      handle,
+      rng,
+      raft::make_device_matrix_view<const DataT>(d_X.data(), nRows, nCols),
+      raft::make_device_vector_view<const LabelT>(d_labels.data(), nRows),
+      nLabels,
+      nRows,
+      0.95,
+      chunk,
+      params.metric);
+    sampledSilhouetteScore = estimate.score;
+    sampledStdError        = estimate.std_error;
   }
 
   // declaring the data values
@@ -204,6 +221,8 @@ class silhouetteScoreTest : public ::testing::TestWithParam<silhouetteScoreParam
   double truthSilhouetteScore    = 0;
   double computedSilhouetteScore = 0;
   double batchedSilhouetteScore  = 0;
+  double sampledSilhouetteScore  = 0;
+  double sampledStdError         = 0;
   int chunk;
 };
 
@@ -223,8 +242,52 @@ TEST_P(silhouetteScoreTestClass, Result)
 {
   ASSERT_NEAR(computedSilhouetteScore, truthSilhouetteScore, params.tolerance);
   ASSERT_NEAR(batchedSilhouetteScore, truthSilhouetteScore, params.tolerance);
+  ASSERT_NEAR(sampledSilhouetteScore, truthSilhouetteScore, params.tolerance);
+  ASSERT_EQ(sampledStdError, 0.0);
 }
 INSTANTIATE_TEST_CASE_P(silhouetteScore, silhouetteScoreTestClass, ::testing::ValuesIn(inputs));
 
+// the confidence interval of a sampled estimate contains the exact score
+TEST(silhouetteScoreSampled, ConfidenceInterval)
+{
+  raft::resources handle;
+  auto stream        = resource::get_cuda_stream(handle);
+  const int n_rows   = 20000;
+  const int n_cols   = 8;
+  const int n_labels = 6;
+  std::default_random_engine dre(42);
+  std::uniform_int_distribution<int> label_dist(0, n_labels - 1);
+  std::uniform_real_distribution<float> center_dist(-4.0f, 4.0f);
+  std::normal_distribution<float> noise_dist(0.0f, 1.5f);
+  std::vector<float> centers(n_labels * n_cols);
+  std::generate(centers.begin(), centers.end(), [&]() { return center_dist(dre); });
+  std::vector<float> h_X(n_rows * n_cols);
+  std::vector<int> h_labels(n_rows);
+  for (int i = 0; i < n_rows; i++) {
+    h_labels[i] = label_dist(dre);
+    for (int j = 0; j < n_cols; j++) {
+      h_X[i * n_cols + j] = centers[h_labels[i] * n_cols + j] + noise_dist(dre);
+    }
+  }
+  rmm::device_uvector<float> d_X(h_X.size(), stream);
+  rmm::device_uvector<int> d_labels(n_rows, stream);
+  raft::update_device(d_X.data(), h_X.data(), h_X.size(), stream);
+  raft::update_device(d_labels.data(), h_labels.data(), n_rows, stream);
+  auto X      = raft::make_device_matrix_view<const float>(d_X.data(), n_rows, n_cols);
+  auto labels = raft::make_device_vector_view<const int>(d_labels.data(), n_rows);
+  auto metric = raft::distance::DistanceType::L2SqrtExpanded;
+
+  float exact = raft::stats::silhouette_score_batched(
+    handle, X, labels, std::nullopt, n_labels, 4096, metric);
+  raft::random::RngState rng(1234ULL);
+  auto estimate =
+    raft::stats::silhouette_score_sampled(handle, rng, X, labels, n_labels, 2000, 0.999, 0, metric);
+
+  ASSERT_GT(estimate.std_error, 0.0f);
+  ASSERT_LE(estimate.lower, exact);
+  ASSERT_GE(estimate.upper, exact);
+  ASSERT_NEAR(estimate.score, exact, 0.05f);
+}
+
 }  // end namespace stats
 }  // end namespace raft
@@ -333,6 +333,47 @@ class TrustworthinessScoreTest : public ::testing::Test {
       raft::make_device_matrix_view<const float>(
         d_X_embedded.data(), n_sample, n_features_embedded),
       5);
+
+    // the same score from kNN graphs, with all the points as original neighbors
+    rmm::device_uvector<int64_t> orig_ind(n_sample * n_sample, stream);
+    rmm::device_uvector<float> orig_dist(n_sample * n_sample, stream);
+    rmm::device_uvector<int64_t> emb_ind(n_sample * 6, stream);
+    rmm::device_uvector<float> emb_dist(n_sample * 6, stream);
+    detail::run_knn<raft::distance::DistanceType::L2SqrtUnexpanded>(
+      handle, d_X.data(), n_sample, n_features_origin, n_sample, orig_ind.data(), orig_dist.data());
+    detail::run_knn<raft::distance::DistanceType::L2SqrtUnexpanded>(handle,
+                                                                    d_X_embedded.data(),
+                                                                    n_sample,
+                                                                    n_features_embedded,
+                                                                    6,
+                                                                    emb_ind.data(),
+                                                                    emb_dist.data());
+    auto emb_view =
+      raft::make_device_matrix_view<const int64_t, int64_t>(emb_ind.data(), n_sample, 6);
+    knn_score = trustworthiness_score_knn(
+      handle,
+      raft::make_device_matrix_view<const int64_t, int64_t>(orig_ind.data(), n_sample, n_sample),
+      emb_view,
+      5,
+      16);
+
+    // truncated original neighbor lists, as returned by an approximate index
+    std::vector<int64_t> orig_ind_h(n_sample * n_sample);
+    raft::update_host(orig_ind_h.data(), orig_ind.data(), orig_ind_h.size(), stream);
+    resource::sync_stream(handle, stream);
+    std::vector<int64_t> truncated_h;
+    for (int i = 0; i < n_sample; i++) {
+      truncated_h.insert(truncated_h.end(),
+                         orig_ind_h.begin() + i * n_sample,
+                         orig_ind_h.begin() + i * n_sample + 10);
+    }
+    rmm::device_uvector<int64_t> truncated(truncated_h.size(), stream);
+    raft::update_device(truncated.data(), truncated_h.data(), truncated_h.size(), stream);
+    truncated_knn_score = trustworthiness_score_knn(
+      handle,
+      raft::make_device_matrix_view<const int64_t, int64_t>(truncated.data(), n_sample, 10),
+      emb_view,
+      5);
   }
 
   void SetUp() override { basicTest(); }
@@ -346,9 +387,18 @@ class TrustworthinessScoreTest : public ::testing::Test {
   rmm::device_uvector<float> d_X_embedded;
 
   double score;
+  double knn_score;
+  double truncated_knn_score;
 };
 
 typedef TrustworthinessScoreTest TrustworthinessScoreTestF;
-TEST_F(TrustworthinessScoreTestF, Result) { ASSERT_TRUE(0.9375 < score && score < 0.9379); }
+TEST_F(TrustworthinessScoreTestF, Result)
+{
+  ASSERT_TRUE(0.9375 < score && score < 0.9379);
+  ASSERT_NEAR(knn_score, score, 1e-9);
+  // the missing ranks are underestimated, so the score is an upper bound
+  ASSERT_GE(truncated_knn_score, knn_score);
+  ASSERT_LE(truncated_knn_score, 1.0);
+}
 };  // namespace stats
 };  // namespace raft
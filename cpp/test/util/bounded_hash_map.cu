@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/bounded_hash_map.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace raft::util {
+
+struct BoundedHashMapInputs {
+  int n_keys;
+  int n_distinct;
+  uint32_t bitlen;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const BoundedHashMapInputs& p)
+{
+  return os << "n_keys: " << p.n_keys << "; n_distinct: " << p.n_distinct
+            << "; bitlen: " << p.bitlen;
+}
+
+// Every team of TeamSize lanes inserts one key into a global memory set, and counts the insertions
+template <uint32_t TeamSize, typename KeyT>
+RAFT_KERNEL insert_global_kernel(
+  bounded_hash_set<KeyT> set, const KeyT* keys, int n_keys, int* n_inserted, bool* found)
+{
+  int i = (threadIdx.x + blockIdx.x * blockDim.x) / TeamSize;
+  if (i >= n_keys) { return; }
+  bool inserted;
+  if constexpr (TeamSize == 1) {
+    inserted = set.insert(keys[i]);
+  } else {
+    inserted = set.template insert_cooperative<TeamSize>(keys[i]);
+  }
+  bool present = TeamSize == 1 ? set.contains(keys[i])
+                               : set.template contains_cooperative<TeamSize>(keys[i]);
+  if (threadIdx.x % TeamSize == 0) {
+    if (inserted) { atomicAdd(n_inserted, 1); }
+    found[i] = present;
+  }
+}
+
+// Every block counts the occurrences of the keys of its chunk in a map in shared memory
+template <uint32_t TeamSize, typename KeyT>
+RAFT_KERNEL count_shared_kernel(
+  const KeyT* keys, int chunk, int n_keys, uint32_t bitlen, KeyT* out_keys, int* out_counts)
+{
+  extern __shared__ char smem[];
+  auto* smem_keys = reinterpret_cast<KeyT*>(smem);
+  auto* smem_vals = reinterpret_cast<int*>(smem_keys + bounded_hash_set<KeyT>::size(bitlen));
+  bounded_hash_map<KeyT, int> map{smem_keys, smem_vals, bitlen};
+  map.reset(0);
+  __syncthreads();
+
+  const int begin = blockIdx.x * chunk;
+  const int end   = min(begin + chunk, n_keys);
+  for (int i = begin + int(threadIdx.x / TeamSize); i < end; i += blockDim.x / TeamSize) {
+    int* count = TeamSize == 1 ? map.find_or_insert(keys[i])
+                               : map.template find_or_insert_cooperative<TeamSize>(keys[i]);
+    if (threadIdx.x % TeamSize == 0) { atomicAdd(count, 1); }
+  }
+  __syncthreads();
+
+  const auto size = map.size();
+  for (uint32_t s = threadIdx.x; s < size; s += blockDim.x) {
+    out_keys[blockIdx.x * size + s]   = map.keys[s];
+    out_counts[blockIdx.x * size + s] = map.values[s];
+  }
+}
+
+template <typename KeyT>
+class BoundedHashMapTest : public ::testing::TestWithParam<BoundedHashMapInputs> {
+ public:
+  BoundedHashMapTest()
+    : params(::testing::TestWithParam<BoundedHashMapInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      keys(params.n_keys, stream)
+  {
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int64_t> value_dist(0, int64_t(1) << 30);
+    std::vector<KeyT> distinct(params.n_distinct);
+    for (auto& k : distinct) {
+      k = KeyT(value_dist(gen));
+    }
+    std::uniform_int_distribution<int> pick(0, params.n_distinct - 1);
+    keys_h.resize(params.n_keys);
+    for (auto& k : keys_h) {
+      k = distinct[pick(gen)];
+    }
+    raft::update_device(keys.data(), keys_h.data(), params.n_keys, stream);
+  }
+
+ protected:
+  // insert all the keys into a single device-wide set
+  template <uint32_t TeamSize>
+  void check_global()
+  {
+    using set_t = bounded_hash_set<KeyT>;
+    // all bits set: the empty key
+    rmm::device_uvector<KeyT> storage(set_t::size(params.bitlen), stream);
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(storage.data(), 0xff, set_t::storage_bytes(params.bitlen), stream));
+    rmm::device_uvector<int> n_inserted(1, stream);
+    rmm::device_uvector<bool> found(params.n_keys, stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(n_inserted.data(), 0, sizeof(int), stream));
+
+    constexpr int kBlockSize = 256;
+    int n_blocks             = raft::ceildiv<int>(params.n_keys * TeamSize, kBlockSize);
+    insert_global_kernel<TeamSize>
+      <<<n_blocks, kBlockSize, 0, stream>>>(set_t{storage.data(), params.bitlen},
+                                            keys.data(),
+                                            params.n_keys,
+                                            n_inserted.data(),
+                                            found.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    std::unordered_map<KeyT, int> counts;
+    for (auto k : keys_h) {
+      counts[k]++;
+    }
+    int n_inserted_h;
+    raft::update_host(&n_inserted_h, n_inserted.data(), 1, stream);
+    resource::sync_stream(handle, stream);
+    ASSERT_EQ(n_inserted_h, int(counts.size()));
+    ASSERT_TRUE(devArrMatch(true, found.data(), params.n_keys, raft::Compare<bool>(), stream));
+  }
+
+  // count the keys of every chunk in a map in shared memory
+  template <uint32_t TeamSize>
+  void check_shared()
+  {
+    constexpr int kChunk      = 1024;
+    constexpr uint32_t bitlen = 11;
+    using map_t               = bounded_hash_map<KeyT, int>;
+    const auto size           = map_t::size(bitlen);
+    int n_chunks              = raft::ceildiv<int>(params.n_keys, kChunk);
+    rmm::device_uvector<KeyT> out_keys(size_t(n_chunks) * size, stream);
+    rmm::device_uvector<int> out_counts(size_t(n_chunks) * size, stream);
+    count_shared_kernel<TeamSize><<<n_chunks, 128, map_t::storage_bytes(bitlen), stream>>>(
+      keys.data(), kChunk, params.n_keys, bitlen, out_keys.data(), out_counts.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    std::vector<KeyT> out_keys_h(out_keys.size());
+    std::vector<int> out_counts_h(out_counts.size());
+    raft::update_host(out_keys_h.data(), out_keys.data(), out_keys.size(), stream);
+    raft::update_host(out_counts_h.data(), out_counts.data(), out_counts.size(), stream);
+    resource::sync_stream(handle, stream);
+    for (int c = 0; c < n_chunks; c++) {
+      std::unordered_map<KeyT, int> counts;
+      for (int i = c * kChunk; i < std::min((c + 1) * kChunk, params.n_keys); i++) {
+        counts[keys_h[i]]++;
+      }
+      size_t n_found = 0;
+      for (uint32_t s = 0; s < size; s++) {
+        auto k = out_keys_h[size_t(c) * size + s];
+        if (k == map_t::empty_key) { continue; }
+        n_found++;
+        ASSERT_EQ(out_counts_h[size_t(c) * size + s], counts[k]) << "chunk " << c;
+      }
+      ASSERT_EQ(n_found, counts.size()) << "chunk " << c;
+    }
+  }
+
+  void Run()
+  {
+    check_global<1>();
+    check_global<4>();
+    check_global<32>();
+    check_shared<1>();
+    check_shared<8>();
+  }
+
+  raft::resources handle;
+  BoundedHashMapInputs params;
+  cudaStream_t stream;
+  std::vector<KeyT> keys_h;
+  rmm::device_uvector<KeyT> keys;
+};
+
+// tables filled from a few percent up to three quarters
+const std::vector<BoundedHashMapInputs> inputs = {
+  {1000, 10, 10}, {100000, 1000, 12}, {100000, 3000, 12}, {1000000, 50000, 16}, {300000, 6000, 13}};
+
+using BoundedHashMapTestU32 = BoundedHashMapTest<uint32_t>;
+TEST_P(BoundedHashMapTestU32, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(BoundedHashMapTests, BoundedHashMapTestU32, ::testing::ValuesIn(inputs));
+
+using BoundedHashMapTestI64 = BoundedHashMapTest<int64_t>;
+TEST_P(BoundedHashMapTestI64, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(BoundedHashMapTests, BoundedHashMapTestI64, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::util
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/pinned_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/host_backed_cache.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace raft::cache {
+
+struct HostBackedCacheInputs {
+  int n_rows;
+  int dim;
+  int batch_size;
+  int n_batches;
+  int n_hot;  // the batches pick half of their rows among the first n_hot rows
+  float cache_size;
+  bool pinned;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const HostBackedCacheInputs& p)
+{
+  return os << "n_rows: " << p.n_rows << "; dim: " << p.dim << "; batch_size: " << p.batch_size
+            << "; n_batches: " << p.n_batches << "; n_hot: " << p.n_hot
+            << "; cache_size: " << p.cache_size << "; pinned: " << p.pinned;
+}
+
+class HostBackedCacheTest : public ::testing::TestWithParam<HostBackedCacheInputs> {
+ public:
+  HostBackedCacheTest()
+    : params(::testing::TestWithParam<HostBackedCacheInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      host_data(raft::make_host_matrix<float, int64_t>(params.pinned ? 0 : params.n_rows,
+                                                       params.dim)),
+      pinned_data(raft::make_pinned_matrix<float, int64_t>(
+        handle, params.pinned ? params.n_rows : 0, params.dim))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    float* data = params.pinned ? pinned_data.data_handle() : host_data.data_handle();
+    for (int64_t i = 0; i < int64_t(params.n_rows) * params.dim; i++) {
+      data[i] = float(i);
+    }
+    auto dataset =
+      raft::make_host_matrix_view<const float, int64_t>(data, params.n_rows, params.dim);
+    host_backed_cache<float> cache(handle, dataset, params.cache_size);
+
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> hot_dist(0, params.n_hot - 1);
+    std::uniform_int_distribution<int> cold_dist(0, params.n_rows - 1);
+    std::vector<int> keys_h(params.batch_size);
+    std::vector<float> expected(size_t(params.batch_size) * params.dim);
+    auto keys = raft::make_device_vector<int, int64_t>(handle, params.batch_size);
+    auto out  = raft::make_device_matrix<float, int64_t>(handle, params.batch_size, params.dim);
+
+    for (int b = 0; b < params.n_batches; b++) {
+      for (int k = 0; k < params.batch_size; k++) {
+        keys_h[k] = k % 2 == 0 ? hot_dist(gen) : cold_dist(gen);
+        for (int j = 0; j < params.dim; j++) {
+          expected[size_t(k) * params.dim + j] = data[int64_t(keys_h[k]) * params.dim + j];
+        }
+      }
+      raft::update_device(keys.data_handle(), keys_h.data(), params.batch_size, stream);
+      cache.get_rows(raft::make_const_mdspan(keys.view()), out.view());
+      ASSERT_TRUE(devArrMatchHost(expected.data(),
+                                  out.data_handle(),
+                                  expected.size(),
+                                  raft::Compare<float>(),
+                                  stream))
+        << "batch " << b;
+    }
+
+    ASSERT_EQ(cache.get_hit_count() + cache.get_miss_count(),
+              int64_t(params.batch_size) * params.n_batches);
+    // The hot rows fit into the cache: after the first batch most of them are hits.
+    if (cache.GetSize() >= 4 * params.n_hot) {
+      ASSERT_GT(cache.get_hit_count(),
+                int64_t(params.batch_size / 4) * (params.n_batches - 1));
+    }
+  }
+
+  raft::resources handle;
+  HostBackedCacheInputs params;
+  cudaStream_t stream;
+  raft::host_matrix<float, int64_t> host_data;
+  raft::pinned_matrix<float, int64_t> pinned_data;
+};
+
+const std::vector<HostBackedCacheInputs> inputs = {
+  // cache too small for a single set: every row comes from the host
+  {1000, 128, 100, 3, 10, 0.001f, false},
+  {10000, 32, 1000, 5, 100, 4, false},
+  {10000, 32, 1000, 5, 100, 4, true},
+  {50000, 96, 4096, 8, 500, 16, false},
+  {50000, 96, 4096, 8, 500, 16, true},
+  // the batch is larger than the cache
+  {20000, 64, 8192, 4, 8192, 1, false}};
+
+TEST_P(HostBackedCacheTest, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(HostBackedCacheTests, HostBackedCacheTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::cache
@@ -17,7 +17,7 @@ from .ai_wrapper import ai_wrapper
 from .cai_wrapper import cai_wrapper
 from .cuda import Stream
 from .device_ndarray import device_ndarray
-from .handle import DeviceResources, Handle
+from .handle import DeviceResources, DeviceResourcesManager, Handle
 from .outputs import auto_convert_output
 
-__all__ = ["DeviceResources", "Handle", "Stream"]
+__all__ = ["DeviceResources", "DeviceResourcesManager", "Handle", "Stream"]
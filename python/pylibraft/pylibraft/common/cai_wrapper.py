@@ -16,6 +16,7 @@
 from types import SimpleNamespace
 
 from pylibraft.common.ai_wrapper import ai_wrapper
+from pylibraft.common.dlpack import from_dlpack
 
 
 class cai_wrapper(ai_wrapper):
@@ -27,17 +28,38 @@ class cai_wrapper(ai_wrapper):
 
     def __init__(self, cai_arr):
         """
-        Constructor accepts a CUDA array interface compliant array
+        Constructor accepts a CUDA array interface compliant array, or an
+        array exporting device memory through DLPack (`__dlpack__`)
 
         Parameters
         ----------
         cai_arr : CUDA array interface array
         """
+        self.stream_ = None
+        if not hasattr(cai_arr, "__cuda_array_interface__") and hasattr(
+            cai_arr, "__dlpack__"
+        ):
+            # The imported tensor lives as long as the wrapper. The producer
+            # orders its pending work before the legacy default stream.
+            self.dlpack_ = from_dlpack(cai_arr)
+            cai_arr = self.dlpack_
+            self.stream_ = 1
         helper = SimpleNamespace(
             __array_interface__=cai_arr.__cuda_array_interface__
         )
         super().__init__(helper)
         self.from_cai = True
+        if self.stream_ is None:
+            self.stream_ = self.ai_.get("stream")
+
+    @property
+    def stream(self):
+        """
+        Returns the stream of the pending work of the producer of the array
+        (the "stream" entry of the CUDA array interface version 3), or None
+        if the array is ready to use
+        """
+        return self.stream_
 
 
 def wrap_array(array):
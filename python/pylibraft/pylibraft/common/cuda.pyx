@@ -21,6 +21,11 @@
 
 from cuda.ccudart cimport (
     cudaError_t,
+    cudaEvent_t,
+    cudaEventCreateWithFlags,
+    cudaEventDestroy,
+    cudaEventDisableTiming,
+    cudaEventRecord,
     cudaGetErrorName,
     cudaGetErrorString,
     cudaGetLastError,
@@ -28,6 +33,7 @@ from cuda.ccudart cimport (
     cudaStreamCreate,
     cudaStreamDestroy,
     cudaStreamSynchronize,
+    cudaStreamWaitEvent,
     cudaSuccess,
 )
 from libc.stdint cimport uintptr_t
@@ -87,3 +93,30 @@ cdef class Stream:
         Return the uintptr_t pointer of the underlying cudaStream_t handle
         """
         return <uintptr_t>self.s
+
+
+def stream_wait(consumer, producer):
+    """
+    Order the work submitted to the `consumer` stream from now on after the
+    work already submitted to the `producer` stream, without blocking the
+    host.
+
+    Both streams are integer cudaStream_t handles, with the conventions of
+    the CUDA array interface and DLPack: 1 is the legacy default stream and
+    2 the per-thread default stream. A `producer` of None has nothing to wait
+    for.
+    """
+    if producer is None or producer == consumer:
+        return
+    cdef cudaEvent_t event
+    cdef cudaError_t e = cudaEventCreateWithFlags(&event,
+                                                  cudaEventDisableTiming)
+    if e != cudaSuccess:
+        raise CudaRuntimeError("Event create")
+    e = cudaEventRecord(event, <cudaStream_t><uintptr_t>producer)
+    if e == cudaSuccess:
+        e = cudaStreamWaitEvent(<cudaStream_t><uintptr_t>consumer, event, 0)
+    # Destroying the event does not cancel the pending wait
+    cudaEventDestroy(event)
+    if e != cudaSuccess:
+        raise CudaRuntimeError("Stream wait")
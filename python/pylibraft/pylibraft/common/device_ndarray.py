@@ -17,6 +17,9 @@ import numpy as np
 
 import rmm
 
+from pylibraft.common import dlpack
+from pylibraft.common.cuda import stream_wait
+
 
 class device_ndarray:
     """
@@ -83,6 +86,10 @@ class device_ndarray:
                 "np_ndarray should be or contain __array_interface__"
             )
 
+        # The stream of the pending work writing this array, if any (see
+        # `__cuda_array_interface__` and `__dlpack__`).
+        self.stream = None
+
         order = "C" if self.c_contiguous else "F"
         if copy:
             self.device_buffer_ = rmm.DeviceBuffer.to_device(
@@ -162,9 +169,36 @@ class device_ndarray:
         device_cai = self.device_buffer_.__cuda_array_interface__
         host_cai = self.__array_interface__.copy()
         host_cai["data"] = (device_cai["data"][0], device_cai["data"][1])
+        if self.stream is not None:
+            # Version 3 tells the consumer to order its work after this stream
+            host_cai["version"] = 3
+            host_cai["stream"] = self.stream
 
         return host_cai
 
+    def __dlpack__(self, stream=None):
+        """
+        Exports this array as a DLPack capsule without a copy.
+
+        Parameters
+        ----------
+        stream : Optional integer handle of the CUDA stream the consumer is
+                 going to use the array on. The pending work writing this
+                 array is ordered before it without blocking the host. None
+                 stands for the legacy default stream, -1 skips the ordering.
+        """
+        if stream != -1:
+            stream_wait(1 if stream is None else stream, self.stream)
+        return dlpack.to_dlpack(self, self.__cuda_array_interface__)
+
+    def __dlpack_device__(self):
+        """
+        Returns the DLPack (device_type, device_id) of this array
+        """
+        return dlpack.dlpack_device(
+            self.device_buffer_.__cuda_array_interface__["data"][0]
+        )
+
     def copy_to_host(self):
         """
         Returns a new numpy.ndarray object on host with the current contents of
@@ -0,0 +1,259 @@
+#
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# cython: profile=False
+# distutils: language = c++
+# cython: embedsignature = True
+# cython: language_level = 3
+
+"""
+Zero-copy exchange of arrays through DLPack
+(https://dmlc.github.io/dlpack/latest/).
+
+The structures below follow the stable DLPack ABI (`dlpack.h`, version 0.8),
+which is the one exchanged by `__dlpack__` capsules named "dltensor".
+"""
+
+import numpy as np
+
+from cpython.pycapsule cimport (
+    PyCapsule_GetPointer,
+    PyCapsule_IsValid,
+    PyCapsule_New,
+    PyCapsule_SetName,
+)
+from cpython.ref cimport Py_DECREF, Py_INCREF
+from cuda.ccudart cimport (
+    cudaError_t,
+    cudaMemoryTypeDevice,
+    cudaMemoryTypeHost,
+    cudaMemoryTypeManaged,
+    cudaPointerAttributes,
+    cudaPointerGetAttributes,
+    cudaSuccess,
+)
+from libc.stdint cimport (
+    int32_t,
+    int64_t,
+    uint8_t,
+    uint16_t,
+    uint64_t,
+    uintptr_t,
+)
+from libc.stdlib cimport free, malloc
+
+from .cuda import CudaRuntimeError
+
+# DLDeviceType
+kDLCPU = 1
+kDLCUDA = 2
+kDLCUDAHost = 3
+kDLCUDAManaged = 13
+
+# DLDataTypeCode
+cdef dict _DL_TYPE_KINDS = {0: "i", 1: "u", 2: "f", 5: "c", 6: "b"}
+cdef dict _NP_TYPE_CODES = {"i": 0, "u": 1, "f": 2, "c": 5, "b": 6}
+
+
+ctypedef struct DLDevice:
+    int32_t device_type
+    int32_t device_id
+
+ctypedef struct DLDataType:
+    uint8_t code
+    uint8_t bits
+    uint16_t lanes
+
+ctypedef struct DLTensor:
+    void* data
+    DLDevice device
+    int32_t ndim
+    DLDataType dtype
+    int64_t* shape
+    int64_t* strides
+    uint64_t byte_offset
+
+ctypedef struct DLManagedTensor:
+    DLTensor dl_tensor
+    void* manager_ctx
+    void (*deleter)(DLManagedTensor*) noexcept
+
+
+def dlpack_device(ptr):
+    """
+    Returns the DLPack (device_type, device_id) of the memory at the given
+    address.
+    """
+    cdef cudaPointerAttributes attrs
+    cdef cudaError_t e = cudaPointerGetAttributes(&attrs,
+                                                  <void*><uintptr_t>ptr)
+    if e != cudaSuccess:
+        raise CudaRuntimeError("cudaPointerGetAttributes")
+    if attrs.type == cudaMemoryTypeDevice:
+        return (kDLCUDA, attrs.device)
+    if attrs.type == cudaMemoryTypeManaged:
+        return (kDLCUDAManaged, attrs.device)
+    if attrs.type == cudaMemoryTypeHost:
+        return (kDLCUDAHost, 0)
+    return (kDLCPU, 0)
+
+
+cdef void _managed_tensor_deleter(DLManagedTensor* tensor) noexcept with gil:
+    # The owner of the memory was kept alive by the tensor
+    Py_DECREF(<object>tensor.manager_ctx)
+    # The shape and the strides share the allocation of the tensor
+    free(tensor)
+
+
+cdef void _capsule_destructor(object capsule) noexcept:
+    # A capsule that was never consumed still owns its tensor
+    cdef DLManagedTensor* tensor
+    if PyCapsule_IsValid(capsule, "dltensor"):
+        tensor = <DLManagedTensor*>PyCapsule_GetPointer(capsule, "dltensor")
+        if tensor.deleter != NULL:
+            tensor.deleter(tensor)
+
+
+def to_dlpack(owner, array_interface):
+    """
+    Exports the memory described by a (CUDA) array interface dict as a DLPack
+    capsule. `owner` is kept alive until the consumer releases the tensor.
+    """
+    dtype = np.dtype(array_interface["typestr"])
+    if dtype.kind not in _NP_TYPE_CODES:
+        raise TypeError("dtype %s cannot be exported to DLPack" % dtype)
+    shape = tuple(array_interface["shape"])
+    strides = array_interface.get("strides")
+    if strides is None:
+        # compact row-major
+        strides = []
+        stride = dtype.itemsize
+        for extent in reversed(shape):
+            strides.insert(0, stride)
+            stride *= extent
+    ptr = array_interface["data"][0]
+    device_type, device_id = dlpack_device(ptr)
+
+    cdef int ndim = len(shape)
+    cdef DLManagedTensor* tensor = <DLManagedTensor*>malloc(
+        sizeof(DLManagedTensor) + 2 * ndim * sizeof(int64_t))
+    if tensor == NULL:
+        raise MemoryError()
+    cdef int64_t* dims = <int64_t*>(<char*>tensor + sizeof(DLManagedTensor))
+    cdef int i
+    for i in range(ndim):
+        dims[i] = shape[i]
+        # DLPack strides count the elements, not the bytes
+        dims[ndim + i] = strides[i] // dtype.itemsize
+
+    tensor.dl_tensor.data = <void*><uintptr_t>ptr
+    tensor.dl_tensor.device.device_type = device_type
+    tensor.dl_tensor.device.device_id = device_id
+    tensor.dl_tensor.ndim = ndim
+    tensor.dl_tensor.dtype.code = _NP_TYPE_CODES[dtype.kind]
+    tensor.dl_tensor.dtype.bits = 8 * dtype.itemsize
+    tensor.dl_tensor.dtype.lanes = 1
+    tensor.dl_tensor.shape = dims
+    tensor.dl_tensor.strides = dims + ndim
+    tensor.dl_tensor.byte_offset = 0
+    Py_INCREF(owner)
+    tensor.manager_ctx = <void*>owner
+    tensor.deleter = _managed_tensor_deleter
+    return PyCapsule_New(<void*>tensor, "dltensor", _capsule_destructor)
+
+
+cdef class dlpack_array:
+    """
+    An array imported from a DLPack capsule, exposing the
+    `__cuda_array_interface__` (device memory) or the `__array_interface__`
+    (host memory) of the tensor. The tensor is released when this object is
+    destroyed.
+    """
+    cdef DLManagedTensor* tensor
+    cdef dict interface
+    cdef bint on_device
+
+    def __cinit__(self, capsule):
+        if not PyCapsule_IsValid(capsule, "dltensor"):
+            raise ValueError("expected an unconsumed DLPack capsule")
+        self.tensor = <DLManagedTensor*>PyCapsule_GetPointer(capsule,
+                                                              "dltensor")
+        # The capsule is consumed: from now on this object owns the tensor
+        PyCapsule_SetName(capsule, "used_dltensor")
+
+        cdef DLTensor* t = &self.tensor.dl_tensor
+        if t.dtype.lanes != 1 or t.dtype.code not in _DL_TYPE_KINDS:
+            raise TypeError("unsupported DLPack dtype (code %d, bits %d, "
+                            "lanes %d)" % (t.dtype.code, t.dtype.bits,
+                                           t.dtype.lanes))
+        dtype = np.dtype("%s%d" % (_DL_TYPE_KINDS[t.dtype.code],
+                                   t.dtype.bits // 8))
+        cdef int i
+        shape = []
+        strides = []
+        for i in range(t.ndim):
+            shape.append(t.shape[i])
+            if t.strides != NULL:
+                strides.append(t.strides[i] * dtype.itemsize)
+        self.on_device = t.device.device_type in (kDLCUDA, kDLCUDAHost,
+                                                  kDLCUDAManaged)
+        self.interface = {
+            "shape": tuple(shape),
+            "typestr": dtype.str,
+            "data": (<uintptr_t>t.data + t.byte_offset, False),
+            "strides": tuple(strides) if t.strides != NULL else None,
+            "version": 3,
+        }
+        if self.on_device:
+            # The producer has ordered its work before the consumer stream
+            self.interface["stream"] = None
+
+    def __dealloc__(self):
+        if self.tensor != NULL and self.tensor.deleter != NULL:
+            self.tensor.deleter(self.tensor)
+        self.tensor = NULL
+
+    @property
+    def __cuda_array_interface__(self):
+        if not self.on_device:
+            raise AttributeError("the DLPack tensor is in host memory")
+        return self.interface
+
+    @property
+    def __array_interface__(self):
+        if self.on_device:
+            raise AttributeError("the DLPack tensor is in device memory")
+        return self.interface
+
+
+def from_dlpack(obj, stream=None):
+    """
+    Imports an object implementing `__dlpack__` (e.g. a JAX array or a
+    PyTorch tensor) without a copy.
+
+    Parameters
+    ----------
+    obj : object with `__dlpack__`
+    stream : Optional integer handle of the CUDA stream the array is going to
+             be used on. The producer orders its pending work on the array
+             before the work submitted to this stream afterwards.
+             None stands for the legacy default stream.
+    """
+    if stream is None:
+        capsule = obj.__dlpack__()
+    else:
+        capsule = obj.__dlpack__(stream=stream)
+    return dlpack_array(capsule)
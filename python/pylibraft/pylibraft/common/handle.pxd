@@ -1,5 +1,5 @@
 #
-# Copyright (c) 2022-2023, NVIDIA CORPORATION.
+# Copyright (c) 2022-2024, NVIDIA CORPORATION.
 #
 # Licensed under the Apache License, Version 2.0 (the "License");
 # you may not use this file except in compliance with the License.
@@ -44,9 +44,24 @@ cdef extern from "raft/core/device_resources.hpp" namespace "raft" nogil:
         device_resources(cuda_stream_view stream_view) except +
         device_resources(cuda_stream_view stream_view,
                          shared_ptr[cuda_stream_pool] stream_pool) except +
+        device_resources(const device_resources& other) except +
         cuda_stream_view get_stream() except +
         void sync_stream() except +
 
+
+cdef extern from "raft/core/device_resources_manager.hpp" \
+        namespace "raft" nogil:
+    cdef cppclass device_resources_manager:
+        @staticmethod
+        const device_resources& get_device_resources() except +
+        @staticmethod
+        void set_streams_per_device(size_t num_streams) except +
+        @staticmethod
+        void set_stream_pools_per_device(size_t num_pools,
+                                         size_t num_streams) except +
+        @staticmethod
+        void set_workspace_allocation_limit(size_t memory_limit) except +
+
 cdef class DeviceResources:
     cdef unique_ptr[device_resources] c_obj
     cdef shared_ptr[cuda_stream_pool] stream_pool
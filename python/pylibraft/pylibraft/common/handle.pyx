@@ -1,5 +1,5 @@
 #
-# Copyright (c) 2022-2023, NVIDIA CORPORATION.
+# Copyright (c) 2022-2024, NVIDIA CORPORATION.
 #
 # Licensed under the Apache License, Version 2.0 (the "License");
 # you may not use this file except in compliance with the License.
@@ -28,7 +28,7 @@ from rmm._lib.cuda_stream_view cimport cuda_stream_per_thread, cuda_stream_view
 
 from .cuda cimport Stream
 
-from .cuda import CudaRuntimeError
+from .cuda import CudaRuntimeError, stream_wait
 
 
 cdef class DeviceResources:
@@ -123,6 +123,24 @@ cdef class DeviceResources:
         """
         return <size_t> self.c_obj.get()
 
+    def get_stream_ptr(self):
+        """
+        Return the uintptr_t pointer of the cudaStream_t this instance
+        orders its work on
+        """
+        return <uintptr_t> self.c_obj.get()[0].get_stream().value()
+
+    def wait_for_arrays(self, *arrays):
+        """
+        Order the work submitted to this instance from now on after the
+        pending work of the producers of the given arrays (wrapped with
+        `pylibraft.common.cai_wrapper`), without blocking the host. The
+        producer stream of an array is the "stream" entry of its CUDA array
+        interface (version 3); arrays without one are ready to use.
+        """
+        for array in arrays:
+            stream_wait(self.get_stream_ptr(), getattr(array, "stream", None))
+
     def __getstate__(self):
         return self.n_streams
 
@@ -196,13 +214,92 @@ cdef class Handle(DeviceResources):
                                       self.stream_pool))
 
 
+class DeviceResourcesManager:
+    """
+    Python binding of `raft::device_resources_manager`, which hands every
+    host thread the resources (the stream, the stream pool and the workspace
+    memory) assigned to it out of a limited set shared by the process.
+
+    The algorithms release the GIL while they run, so Python threads
+    calling them with their own `DeviceResources` from this manager drive
+    several CUDA streams concurrently. All the methods are thread-safe; the
+    settings take effect only if made before the first call of
+    `get_device_resources` in the process.
+
+    Examples
+    --------
+
+    Searching from a thread pool; call `set_streams_per_device` first to
+    bound the number of streams the threads share:
+
+    >>> import cupy as cp
+    >>> from concurrent.futures import ThreadPoolExecutor
+    >>> from pylibraft.common import DeviceResourcesManager
+    >>> from pylibraft.neighbors import cagra
+    >>> dataset = cp.random.random_sample((2000, 16), dtype=cp.float32)
+    >>> index = cagra.build(cagra.IndexParams(), dataset)
+    >>> def search(queries):
+    ...     handle = DeviceResourcesManager.get_device_resources()
+    ...     _, neighbors = cagra.search(cagra.SearchParams(), index, queries,
+    ...                                 10, handle=handle)
+    ...     handle.sync()
+    ...     return neighbors
+    >>> batches = [cp.random.random_sample((100, 16), dtype=cp.float32)
+    ...            for _ in range(8)]
+    >>> with ThreadPoolExecutor(max_workers=4) as pool:
+    ...     results = list(pool.map(search, batches))
+    """
+
+    @staticmethod
+    def get_device_resources():
+        """
+        Returns the DeviceResources assigned to the calling thread on the
+        current device. Repeated calls from the same thread return handles
+        sharing the same stream and stream pool.
+        """
+        cdef DeviceResources handle = DeviceResources()
+        handle.c_obj.reset(new device_resources(
+            device_resources_manager.get_device_resources()))
+        return handle
+
+    @staticmethod
+    def set_streams_per_device(n_streams):
+        """
+        Sets the number of CUDA streams per device shared by the threads.
+        By default every thread uses its own default stream per thread.
+        """
+        device_resources_manager.set_streams_per_device(n_streams)
+
+    @staticmethod
+    def set_stream_pools_per_device(n_pools, n_streams):
+        """
+        Sets the number of stream pools per device shared by the threads,
+        each of `n_streams` streams.
+        """
+        device_resources_manager.set_stream_pools_per_device(n_pools,
+                                                             n_streams)
+
+    @staticmethod
+    def set_workspace_allocation_limit(memory_limit):
+        """
+        Sets the limit (in bytes) of the temporary workspace of each
+        device_resources.
+        """
+        device_resources_manager.set_workspace_allocation_limit(
+            memory_limit)
+
+
 _HANDLE_PARAM_DOCSTRING = """
      handle : Optional RAFT resource handle for reusing CUDA resources.
         If a handle isn't supplied, CUDA resources will be
         allocated inside this function and synchronized before the
         function exits. If a handle is supplied, you will need to
         explicitly synchronize yourself by calling `handle.sync()`
-        before accessing the output.
+        before accessing the output, or consume the output on a
+        stream ordered after the stream of the handle (the outputs
+        allocated by the function carry it in the "stream" entry of
+        their `__cuda_array_interface__` and honor the `stream`
+        argument of `__dlpack__`).
 """.strip()
 
 
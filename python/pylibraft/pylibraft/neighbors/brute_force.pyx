@@ -153,14 +153,18 @@ def knn(dataset, queries, k=None, indices=None, distances=None,
 
     if indices is None:
         indices = device_ndarray.empty((n_queries, k), dtype='int64')
+        indices.stream = handle.get_stream_ptr()
 
     if distances is None:
         distances = device_ndarray.empty((n_queries, k), dtype='float32')
+        distances.stream = handle.get_stream_ptr()
 
     cdef DistanceType c_metric = DISTANCE_TYPES[metric]
 
     distances_cai = cai_wrapper(distances)
     indices_cai = cai_wrapper(indices)
+    handle.wait_for_arrays(dataset_cai, queries_cai, distances_cai,
+                           indices_cai)
 
     cdef optional[float] c_metric_arg = <float>metric_arg
     cdef optional[int64_t] c_global_offset = <int64_t>global_id_offset
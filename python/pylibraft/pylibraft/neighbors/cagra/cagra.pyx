@@ -722,6 +722,7 @@ def search(SearchParams search_params,
 
     if neighbors is None:
         neighbors = device_ndarray.empty((n_queries, k), dtype='uint32')
+        neighbors.stream = handle.get_stream_ptr()
 
     neighbors_cai = cai_wrapper(neighbors)
     _check_input_array(neighbors_cai, [np.dtype('uint32')],
@@ -729,43 +730,62 @@ def search(SearchParams search_params,
 
     if distances is None:
         distances = device_ndarray.empty((n_queries, k), dtype='float32')
+        distances.stream = handle.get_stream_ptr()
 
     distances_cai = cai_wrapper(distances)
     _check_input_array(distances_cai, [np.dtype('float32')],
                        exp_rows=n_queries, exp_cols=k)
 
+    handle.wait_for_arrays(queries_cai, neighbors_cai, distances_cai)
+
     cdef c_cagra.search_params params = search_params.params
     cdef IndexFloat idx_float
     cdef IndexInt8 idx_int8
     cdef IndexUint8 idx_uint8
-
+    cdef device_matrix_view[float, int64_t, row_major] queries_float
+    cdef device_matrix_view[int8_t, int64_t, row_major] queries_int8
+    cdef device_matrix_view[uint8_t, int64_t, row_major] queries_uint8
+    cdef device_matrix_view[uint32_t, int64_t, row_major] neighbors_view = \
+        get_dmv_uint32(neighbors_cai, check_shape=True)
+    cdef device_matrix_view[float, int64_t, row_major] distances_view = \
+        get_dmv_float(distances_cai, check_shape=True)
+
+    # The GIL is released during the search, so that the Python threads
+    # searching with their own handles (see `DeviceResourcesManager`) run
+    # concurrently
     if queries_dt == np.float32:
         idx_float = index
+        queries_float = get_dmv_float(queries_cai, check_shape=True)
         with cuda_interruptible():
-            c_cagra.search(deref(handle_),
-                           params,
-                           deref(idx_float.index),
-                           get_dmv_float(queries_cai, check_shape=True),
-                           get_dmv_uint32(neighbors_cai, check_shape=True),
-                           get_dmv_float(distances_cai, check_shape=True))
+            with nogil:
+                c_cagra.search(deref(handle_),
+                               params,
+                               deref(idx_float.index),
+                               queries_float,
+                               neighbors_view,
+                               distances_view)
     elif queries_dt == np.byte:
         idx_int8 = index
+        queries_int8 = get_dmv_int8(queries_cai, check_shape=True)
         with cuda_interruptible():
-            c_cagra.search(deref(handle_),
-                           params,
-                           deref(idx_int8.index),
-                           get_dmv_int8(queries_cai, check_shape=True),
-                           get_dmv_uint32(neighbors_cai, check_shape=True),
-                           get_dmv_float(distances_cai, check_shape=True))
+            with nogil:
+                c_cagra.search(deref(handle_),
+                               params,
+                               deref(idx_int8.index),
+                               queries_int8,
+                               neighbors_view,
+                               distances_view)
     elif queries_dt == np.ubyte:
         idx_uint8 = index
+        queries_uint8 = get_dmv_uint8(queries_cai, check_shape=True)
         with cuda_interruptible():
-            c_cagra.search(deref(handle_),
-                           params,
-                           deref(idx_uint8.index),
-                           get_dmv_uint8(queries_cai, check_shape=True),
-                           get_dmv_uint32(neighbors_cai, check_shape=True),
-                           get_dmv_float(distances_cai, check_shape=True))
+            with nogil:
+                c_cagra.search(deref(handle_),
+                               params,
+                               deref(idx_uint8.index),
+                               queries_uint8,
+                               neighbors_view,
+                               distances_view)
     else:
         raise ValueError("query dtype %s not supported" % queries_dt)
 
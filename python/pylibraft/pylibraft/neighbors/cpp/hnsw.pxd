@@ -19,6 +19,7 @@
 # cython: language_level = 3
 
 from libc.stdint cimport int8_t, int64_t, uint8_t, uint32_t, uint64_t
+from libcpp cimport bool
 from libcpp.memory cimport unique_ptr
 from libcpp.string cimport string
 
@@ -29,6 +30,7 @@ from pylibraft.common.cpp.mdspan cimport (
 )
 from pylibraft.common.handle cimport device_resources
 from pylibraft.distance.distance_type cimport DistanceType
+from pylibraft.neighbors.cagra.cpp.c_cagra cimport index as cagra_index
 from pylibraft.neighbors.ivf_pq.cpp.c_ivf_pq cimport (
     ann_index,
     ann_search_params,
@@ -41,6 +43,7 @@ cdef extern from "raft/neighbors/hnsw.hpp" \
     cpdef cppclass search_params(ann_search_params):
         int ef
         int num_threads
+        bool numa_aware
 
     cdef cppclass index[T](ann_index):
         index(int dim, DistanceType metric)
@@ -75,6 +78,18 @@ cdef extern from "raft_runtime/neighbors/hnsw.hpp" \
         host_matrix_view[uint64_t, int64_t, row_major] neighbors,
         host_matrix_view[float, int64_t, row_major] distances) except +
 
+    cdef unique_ptr[index[float]] from_cagra(
+        const device_resources& handle,
+        const cagra_index[float, uint32_t]& cagra_index) except +
+
+    cdef unique_ptr[index[int8_t]] from_cagra(
+        const device_resources& handle,
+        const cagra_index[int8_t, uint32_t]& cagra_index) except +
+
+    cdef unique_ptr[index[uint8_t]] from_cagra(
+        const device_resources& handle,
+        const cagra_index[uint8_t, uint32_t]& cagra_index) except +
+
     cdef unique_ptr[index[T]] deserialize_file[T](
         const device_resources& handle,
         const string& filename,
@@ -51,9 +51,6 @@ from pylibraft.common.mdspan cimport (
 )
 from pylibraft.neighbors.common cimport _get_metric_string
 
-import os
-import uuid
-
 import numpy as np
 
 
@@ -290,14 +287,10 @@ def load(filename, dim, dtype, metric="sqeuclidean", handle=None):
 @auto_sync_handle
 def from_cagra(Index index, handle=None):
     """
-    Returns an hnswlib base-layer-only index from a CAGRA index.
-
-    NOTE: This method uses the filesystem to write the CAGRA index in
-          `/tmp/<random_number>.bin` before reading it as an hnswlib index,
-          then deleting the temporary file.
+    Returns an hnswlib index from a CAGRA index.
 
-    Saving / loading the index is experimental. The serialization format is
-    subject to change.
+    The hnswlib index is constructed in memory: the CAGRA graph becomes its
+    base layer and the upper layers are built on the GPU.
 
     Parameters
     ----------
@@ -318,16 +311,55 @@ def from_cagra(Index index, handle=None):
     >>> # Build index
     >>> handle = DeviceResources()
     >>> index = cagra.build(cagra.IndexParams(), dataset, handle=handle)
-    >>> # Serialize the CAGRA index to hnswlib base layer only index format
+    >>> # Convert the CAGRA index to an hnswlib index
     >>> hnsw_index = hnsw.from_cagra(index, handle=handle)
     """
-    uuid_num = uuid.uuid4()
-    filename = f"/tmp/{uuid_num}.bin"
-    save(filename, index, handle=handle)
-    hnsw_index = load(filename, index.dim, np.dtype(index.active_index_type),
-                      _get_metric_string(index.metric), handle=handle)
-    os.remove(filename)
-    return hnsw_index
+    if not index.trained:
+        raise ValueError("Index need to be built before converting it.")
+
+    if handle is None:
+        handle = DeviceResources()
+    cdef device_resources* handle_ = \
+        <device_resources*><size_t>handle.getHandle()
+
+    cdef IndexFloat idx_float
+    cdef IndexInt8 idx_int8
+    cdef IndexUint8 idx_uint8
+    cdef HnswIndexFloat hnsw_float
+    cdef HnswIndexInt8 hnsw_int8
+    cdef HnswIndexUint8 hnsw_uint8
+
+    if index.active_index_type == "float32":
+        idx_float = index
+        hnsw_float = HnswIndexFloat()
+        hnsw_float.index = c_hnsw.from_cagra(
+            deref(handle_),
+            deref(<c_cagra.index[float, uint32_t] *><size_t> idx_float.index))
+        hnsw_float.trained = True
+        hnsw_float.active_index_type = 'float32'
+        return hnsw_float
+    elif index.active_index_type == "byte":
+        idx_int8 = index
+        hnsw_int8 = HnswIndexInt8()
+        hnsw_int8.index = c_hnsw.from_cagra(
+            deref(handle_),
+            deref(<c_cagra.index[int8_t, uint32_t] *><size_t> idx_int8.index))
+        hnsw_int8.trained = True
+        hnsw_int8.active_index_type = 'byte'
+        return hnsw_int8
+    elif index.active_index_type == "ubyte":
+        idx_uint8 = index
+        hnsw_uint8 = HnswIndexUint8()
+        hnsw_uint8.index = c_hnsw.from_cagra(
+            deref(handle_),
+            deref(<c_cagra.index[uint8_t, uint32_t] *><size_t>
+                  idx_uint8.index))
+        hnsw_uint8.trained = True
+        hnsw_uint8.active_index_type = 'ubyte'
+        return hnsw_uint8
+    else:
+        raise ValueError(
+            "Index dtype %s not supported" % index.active_index_type)
 
 
 cdef class SearchParams:
@@ -342,17 +374,22 @@ cdef class SearchParams:
     num_threads: int, default=1
         Number of host threads to use to search the hnswlib index
         and increase concurrency
+    numa_aware: bool, default=False
+        Pin the threads to the NUMA nodes of the host, each thread searching
+        a copy of the index local to its node. The copies are made on the
+        first NUMA-aware search and kept with the index.
     """
     cdef c_hnsw.search_params params
 
-    def __init__(self, ef=200, num_threads=1):
+    def __init__(self, ef=200, num_threads=1, numa_aware=False):
         self.params.ef = ef
         self.params.num_threads = num_threads
+        self.params.numa_aware = numa_aware
 
     def __repr__(self):
         attr_str = [attr + "=" + str(getattr(self, attr))
                     for attr in [
-                        "ef", "num_threads"]]
+                        "ef", "num_threads", "numa_aware"]]
         return "SearchParams(type=hnsw, " + (
             ", ".join(attr_str)) + ")"
 
@@ -364,6 +401,10 @@ cdef class SearchParams:
     def num_threads(self):
         return self.params.num_threads
 
+    @property
+    def numa_aware(self):
+        return self.params.numa_aware
+
 
 @auto_sync_handle
 @auto_convert_output
@@ -628,6 +628,7 @@ def search(SearchParams search_params,
 
     if neighbors is None:
         neighbors = device_ndarray.empty((n_queries, k), dtype='int64')
+        neighbors.stream = handle.get_stream_ptr()
 
     neighbors_cai = cai_wrapper(neighbors)
     _check_input_array(neighbors_cai, [np.dtype('int64')],
@@ -635,11 +636,14 @@ def search(SearchParams search_params,
 
     if distances is None:
         distances = device_ndarray.empty((n_queries, k), dtype='float32')
+        distances.stream = handle.get_stream_ptr()
 
     distances_cai = cai_wrapper(distances)
     _check_input_array(distances_cai, [np.dtype('float32')],
                        exp_rows=n_queries, exp_cols=k)
 
+    handle.wait_for_arrays(queries_cai, neighbors_cai, distances_cai)
+
     cdef c_ivf_flat.search_params params = search_params.params
     cdef IndexFloat idx_float
     cdef IndexInt8 idx_int8
@@ -32,6 +32,8 @@ from rmm._lib.memory_resource cimport device_memory_resource
 from pylibraft.common.cpp.mdspan cimport (
     device_matrix_view,
     device_vector_view,
+    host_matrix_view,
+    host_vector_view,
     row_major,
 )
 from pylibraft.common.handle cimport device_resources
@@ -77,6 +79,8 @@ cdef extern from "raft/neighbors/ivf_pq_types.hpp" \
         uint32_t pq_dim
         codebook_gen codebook_kind
         bool force_random_rotation
+        uint32_t opq_n_iters
+        float anisotropic_quantization_threshold
         bool conservative_memory_allocation
 
     cdef cppclass index[IdxT](ann_index):
@@ -145,6 +149,42 @@ cdef extern from "raft_runtime/neighbors/ivf_pq.hpp" \
         optional[device_vector_view[int64_t, int64_t]] new_indices,
         index[int64_t]* index) except +
 
+    cdef void build(
+        const device_resources& handle,
+        const index_params& params,
+        host_matrix_view[float, int64_t, row_major] dataset,
+        index[int64_t]* index) except +
+
+    cdef void build(
+        const device_resources& handle,
+        const index_params& params,
+        host_matrix_view[int8_t, int64_t, row_major] dataset,
+        index[int64_t]* index) except +
+
+    cdef void build(
+        const device_resources& handle,
+        const index_params& params,
+        host_matrix_view[uint8_t, int64_t, row_major] dataset,
+        index[int64_t]* index) except +
+
+    cdef void extend(
+        const device_resources& handle,
+        host_matrix_view[float, int64_t, row_major] new_vectors,
+        optional[host_vector_view[int64_t, int64_t]] new_indices,
+        index[int64_t]* index) except +
+
+    cdef void extend(
+        const device_resources& handle,
+        host_matrix_view[int8_t, int64_t, row_major] new_vectors,
+        optional[host_vector_view[int64_t, int64_t]] new_indices,
+        index[int64_t]* index) except +
+
+    cdef void extend(
+        const device_resources& handle,
+        host_matrix_view[uint8_t, int64_t, row_major] new_vectors,
+        optional[host_vector_view[int64_t, int64_t]] new_indices,
+        index[int64_t]* index) except +
+
     cdef void search(
         const device_resources& handle,
         const search_params& params,
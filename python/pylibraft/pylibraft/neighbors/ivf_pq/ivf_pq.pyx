@@ -23,7 +23,14 @@ import warnings
 import numpy as np
 
 from cython.operator cimport dereference as deref
-from libc.stdint cimport int32_t, int64_t, uint32_t, uintptr_t
+from libc.stdint cimport (
+    int8_t,
+    int32_t,
+    int64_t,
+    uint8_t,
+    uint32_t,
+    uintptr_t,
+)
 from libcpp cimport bool, nullptr
 from libcpp.string cimport string
 
@@ -58,7 +65,10 @@ from pylibraft.neighbors.common import _check_input_array, _get_metric
 from pylibraft.common.cpp.mdspan cimport (
     device_matrix_view,
     device_vector_view,
+    host_matrix_view,
+    host_vector_view,
     make_device_vector_view,
+    make_host_vector_view,
     row_major,
 )
 from pylibraft.common.mdspan cimport (
@@ -66,6 +76,9 @@ from pylibraft.common.mdspan cimport (
     get_dmv_int8,
     get_dmv_int64,
     get_dmv_uint8,
+    get_hmv_float,
+    get_hmv_int8,
+    get_hmv_uint8,
     make_optional_view_int64,
 )
 from pylibraft.neighbors.common cimport _get_metric_string
@@ -144,6 +157,20 @@ cdef class IndexParams:
         initialized with the identity matrix. When
         `force_random_rotation == True`, a random orthogonal transform
         matrix is generated regardless of the values of `dim` and `pq_dim`.
+    opq_n_iters : int, default = 0
+        The number of iterations of the optimized product quantization
+        (OPQ) training of the rotation matrix. When non-zero, the rotation
+        is learned by alternating the training of the PQ codebooks with an
+        orthogonal Procrustes update of the rotation, which allows a
+        smaller `pq_dim` for the same recall. Only supported with
+        codebook_kind="subspace".
+    anisotropic_quantization_threshold : float, default = 0
+        The threshold of the anisotropic (score-aware) quantization loss,
+        relative to the norm of the data vectors. When non-zero, the PQ
+        codebooks are refined to favor the accuracy of the large inner
+        products over the reconstruction error, which improves the recall
+        of the maximum inner product search; 0.2 is a reasonable value to
+        start with. Only supported with metric="inner_product".
     add_data_on_build : bool, default = True
         After training the coarse and fine quantizers, we will populate
         the index with the dataset if add_data_on_build == True, otherwise
@@ -166,6 +193,8 @@ cdef class IndexParams:
                  pq_dim=0,
                  codebook_kind="subspace",
                  force_random_rotation=False,
+                 opq_n_iters=0,
+                 anisotropic_quantization_threshold=0,
                  add_data_on_build=True,
                  conservative_memory_allocation=False):
         self.params.n_lists = n_lists
@@ -182,6 +211,9 @@ cdef class IndexParams:
         else:
             raise ValueError("Incorrect codebook kind %s" % codebook_kind)
         self.params.force_random_rotation = force_random_rotation
+        self.params.opq_n_iters = opq_n_iters
+        self.params.anisotropic_quantization_threshold = \
+            anisotropic_quantization_threshold
         self.params.add_data_on_build = add_data_on_build
         self.params.conservative_memory_allocation = \
             conservative_memory_allocation
@@ -218,6 +250,14 @@ cdef class IndexParams:
     def force_random_rotation(self):
         return self.params.force_random_rotation
 
+    @property
+    def opq_n_iters(self):
+        return self.params.opq_n_iters
+
+    @property
+    def anisotropic_quantization_threshold(self):
+        return self.params.anisotropic_quantization_threshold
+
     @property
     def add_data_on_build(self):
         return self.params.add_data_on_build
@@ -314,7 +354,11 @@ def build(IndexParams index_params, dataset, handle=None):
     Builds an IVF-PQ index that can be later used for nearest neighbor search.
 
     The input array can be either CUDA array interface compliant matrix or
-    array interface compliant matrix in host memory.
+    array interface compliant matrix in host memory. A host dataset is not
+    copied to the device as a whole: the k-means training set is sampled
+    from it (see `kmeans_trainset_fraction`) and the data is added to the
+    index in batches, so a `numpy.memmap` larger than the device memory can
+    be indexed.
 
     Parameters
     ----------
@@ -371,7 +415,42 @@ def build(IndexParams index_params, dataset, handle=None):
 
     idx = Index()
 
-    if dataset_dt == np.float32:
+    cdef host_matrix_view[float, int64_t, row_major] dataset_float_host
+    cdef host_matrix_view[int8_t, int64_t, row_major] dataset_int8_host
+    cdef host_matrix_view[uint8_t, int64_t, row_major] dataset_uint8_host
+
+    if not dataset_cai.from_cai:
+        # The host dataset is never copied to the device as a whole: the
+        # k-means training set is sampled from it and the data is added to
+        # the index in batches.
+        if dataset_dt == np.float32:
+            dataset_float_host = get_hmv_float(dataset_cai, check_shape=True)
+            with cuda_interruptible():
+                with nogil:
+                    c_ivf_pq.build(deref(handle_),
+                                   index_params.params,
+                                   dataset_float_host,
+                                   idx.index)
+        elif dataset_dt == np.byte:
+            dataset_int8_host = get_hmv_int8(dataset_cai, check_shape=True)
+            with cuda_interruptible():
+                with nogil:
+                    c_ivf_pq.build(deref(handle_),
+                                   index_params.params,
+                                   dataset_int8_host,
+                                   idx.index)
+        elif dataset_dt == np.ubyte:
+            dataset_uint8_host = get_hmv_uint8(dataset_cai, check_shape=True)
+            with cuda_interruptible():
+                with nogil:
+                    c_ivf_pq.build(deref(handle_),
+                                   index_params.params,
+                                   dataset_uint8_host,
+                                   idx.index)
+        else:
+            raise TypeError("dtype %s not supported" % dataset_dt)
+        idx.trained = True
+    elif dataset_dt == np.float32:
         with cuda_interruptible():
             c_ivf_pq.build(deref(handle_),
                            index_params.params,
@@ -463,6 +542,7 @@ def extend(Index index, new_vectors, new_indices, handle=None):
     vecs_cai = wrap_array(new_vectors)
     vecs_dt = vecs_cai.dtype
     cdef optional[device_vector_view[int64_t, int64_t]] new_indices_opt
+    cdef optional[host_vector_view[int64_t, int64_t]] new_indices_host_opt
     cdef int64_t n_rows = vecs_cai.shape[0]
     cdef uint32_t dim = vecs_cai.shape[1]
 
@@ -476,28 +556,76 @@ def extend(Index index, new_vectors, new_indices, handle=None):
         raise ValueError("Indices array is expected to be 1D")
 
     if index.index.size() > 0:
+        # The residency of the indices is checked on their own, they may
+        # be on the other side of the vectors
         new_indices_opt = make_device_vector_view(
             <int64_t *><uintptr_t>idx_cai.data,
             <int64_t>idx_cai.shape[0])
+        new_indices_host_opt = make_host_vector_view(
+            <int64_t *><uintptr_t>idx_cai.data,
+            <int64_t>idx_cai.shape[0])
 
-    if vecs_dt == np.float32:
+    cdef device_matrix_view[float, int64_t, row_major] vecs_float
+    cdef device_matrix_view[int8_t, int64_t, row_major] vecs_int8
+    cdef device_matrix_view[uint8_t, int64_t, row_major] vecs_uint8
+    cdef host_matrix_view[float, int64_t, row_major] vecs_float_host
+    cdef host_matrix_view[int8_t, int64_t, row_major] vecs_int8_host
+    cdef host_matrix_view[uint8_t, int64_t, row_major] vecs_uint8_host
+
+    # The index is extended in place without the GIL. It must not be
+    # searched concurrently from other threads. The host vectors are
+    # copied to the device in batches.
+    if not vecs_cai.from_cai:
+        if vecs_dt == np.float32:
+            vecs_float_host = get_hmv_float(vecs_cai, check_shape=True)
+            with cuda_interruptible():
+                with nogil:
+                    c_ivf_pq.extend(deref(handle_),
+                                    vecs_float_host,
+                                    new_indices_host_opt,
+                                    index.index)
+        elif vecs_dt == np.int8:
+            vecs_int8_host = get_hmv_int8(vecs_cai, check_shape=True)
+            with cuda_interruptible():
+                with nogil:
+                    c_ivf_pq.extend(deref(handle_),
+                                    vecs_int8_host,
+                                    new_indices_host_opt,
+                                    index.index)
+        elif vecs_dt == np.uint8:
+            vecs_uint8_host = get_hmv_uint8(vecs_cai, check_shape=True)
+            with cuda_interruptible():
+                with nogil:
+                    c_ivf_pq.extend(deref(handle_),
+                                    vecs_uint8_host,
+                                    new_indices_host_opt,
+                                    index.index)
+        else:
+            raise TypeError("query dtype %s not supported" % vecs_dt)
+    elif vecs_dt == np.float32:
+        vecs_float = get_dmv_float(vecs_cai, check_shape=True)
         with cuda_interruptible():
-            c_ivf_pq.extend(deref(handle_),
-                            get_dmv_float(vecs_cai, check_shape=True),
-                            new_indices_opt,
-                            index.index)
+            with nogil:
+                c_ivf_pq.extend(deref(handle_),
+                                vecs_float,
+                                new_indices_opt,
+                                index.index)
     elif vecs_dt == np.int8:
+        vecs_int8 = get_dmv_int8(vecs_cai, check_shape=True)
         with cuda_interruptible():
-            c_ivf_pq.extend(deref(handle_),
-                            get_dmv_int8(vecs_cai, check_shape=True),
-                            new_indices_opt,
-                            index.index)
+            with nogil:
+                c_ivf_pq.extend(deref(handle_),
+                                vecs_int8,
+                                new_indices_opt,
+                                index.index)
     elif vecs_dt == np.uint8:
+        vecs_uint8 = get_dmv_uint8(vecs_cai, check_shape=True)
         with cuda_interruptible():
-            c_ivf_pq.extend(deref(handle_),
-                            get_dmv_uint8(vecs_cai, check_shape=True),
-                            new_indices_opt,
-                            index.index)
+            with nogil:
+                c_ivf_pq.extend(deref(handle_),
+                                vecs_uint8,
+                                new_indices_opt,
+                                index.index)
     else:
         raise TypeError("query dtype %s not supported" % vecs_dt)
 
@@ -650,6 +778,7 @@ def search(SearchParams search_params,
 
     if neighbors is None:
         neighbors = device_ndarray.empty((n_queries, k), dtype='int64')
+        neighbors.stream = handle.get_stream_ptr()
 
     neighbors_cai = cai_wrapper(neighbors)
     _check_input_array(neighbors_cai, [np.dtype('int64')],
@@ -657,11 +786,14 @@ def search(SearchParams search_params,
 
     if distances is None:
         distances = device_ndarray.empty((n_queries, k), dtype='float32')
+        distances.stream = handle.get_stream_ptr()
 
     distances_cai = cai_wrapper(distances)
     _check_input_array(distances_cai, [np.dtype('float32')],
                        exp_rows=n_queries, exp_cols=k)
 
+    handle.wait_for_arrays(queries_cai, neighbors_cai, distances_cai)
+
     cdef c_ivf_pq.search_params params = search_params.params
 
     cdef uintptr_t neighbors_ptr = neighbors_cai.data
@@ -671,30 +803,47 @@ def search(SearchParams search_params,
     if memory_resource is not None:
         mr_ptr = memory_resource.get_mr()
 
+    cdef device_matrix_view[float, int64_t, row_major] queries_float
+    cdef device_matrix_view[int8_t, int64_t, row_major] queries_int8
+    cdef device_matrix_view[uint8_t, int64_t, row_major] queries_uint8
+    cdef device_matrix_view[int64_t, int64_t, row_major] neighbors_view = \
+        get_dmv_int64(neighbors_cai, check_shape=True)
+    cdef device_matrix_view[float, int64_t, row_major] distances_view = \
+        get_dmv_float(distances_cai, check_shape=True)
+
+    # The GIL is released during the search, so that the Python threads
+    # searching with their own handles (see `DeviceResourcesManager`) run
+    # concurrently
     if queries_dt == np.float32:
+        queries_float = get_dmv_float(queries_cai, check_shape=True)
         with cuda_interruptible():
-            c_ivf_pq.search(deref(handle_),
-                            params,
-                            deref(index.index),
-                            get_dmv_float(queries_cai, check_shape=True),
-                            get_dmv_int64(neighbors_cai, check_shape=True),
-                            get_dmv_float(distances_cai, check_shape=True))
+            with nogil:
+                c_ivf_pq.search(deref(handle_),
+                                params,
+                                deref(index.index),
+                                queries_float,
+                                neighbors_view,
+                                distances_view)
     elif queries_dt == np.byte:
+        queries_int8 = get_dmv_int8(queries_cai, check_shape=True)
         with cuda_interruptible():
-            c_ivf_pq.search(deref(handle_),
-                            params,
-                            deref(index.index),
-                            get_dmv_int8(queries_cai, check_shape=True),
-                            get_dmv_int64(neighbors_cai, check_shape=True),
-                            get_dmv_float(distances_cai, check_shape=True))
+            with nogil:
+                c_ivf_pq.search(deref(handle_),
+                                params,
+                                deref(index.index),
+                                queries_int8,
+                                neighbors_view,
+                                distances_view)
     elif queries_dt == np.ubyte:
+        queries_uint8 = get_dmv_uint8(queries_cai, check_shape=True)
         with cuda_interruptible():
-            c_ivf_pq.search(deref(handle_),
-                            params,
-                            deref(index.index),
-                            get_dmv_uint8(queries_cai, check_shape=True),
-                            get_dmv_int64(neighbors_cai, check_shape=True),
-                            get_dmv_float(distances_cai, check_shape=True))
+            with nogil:
+                c_ivf_pq.search(deref(handle_),
+                                params,
+                                deref(index.index),
+                                queries_uint8,
+                                neighbors_view,
+                                distances_view)
     else:
         raise ValueError("query dtype %s not supported" % queries_dt)
 
@@ -16,7 +16,7 @@
 import numpy as np
 import pytest
 
-from pylibraft.common import device_ndarray
+from pylibraft.common import cai_wrapper, device_ndarray
 
 
 @pytest.mark.parametrize("order", ["F", "C"])
@@ -61,3 +61,44 @@ def test_empty(order, dtype):
     assert a.data.f_contiguous == db_host.data.f_contiguous
     assert a.data.c_contiguous == db.c_contiguous
     assert a.data.c_contiguous == db_host.data.c_contiguous
+
+
+class _dlpack_only:
+    """Exposes only the DLPack protocol of the wrapped array"""
+
+    def __init__(self, arr):
+        self.arr = arr
+
+    def __dlpack__(self, stream=None):
+        return self.arr.__dlpack__(stream=stream)
+
+    def __dlpack_device__(self):
+        return self.arr.__dlpack_device__()
+
+
+@pytest.mark.parametrize("order", ["F", "C"])
+@pytest.mark.parametrize("dtype", [np.float32, np.int64])
+def test_dlpack_roundtrip(order, dtype):
+
+    a = np.asarray(np.random.random((50, 7)) * 100, dtype=dtype, order=order)
+    db = device_ndarray(a)
+
+    wrapped = cai_wrapper(_dlpack_only(db))
+
+    assert wrapped.shape == a.shape
+    assert wrapped.dtype == dtype
+    assert wrapped.c_contiguous == (order == "C")
+    assert wrapped.f_contiguous == (order == "F")
+    assert wrapped.data == db.__cuda_array_interface__["data"][0]
+    assert db.__dlpack_device__() == (2, 0)
+
+
+def test_cai_stream():
+
+    db = device_ndarray.empty((10, 5), dtype=np.float32)
+    assert "stream" not in db.__cuda_array_interface__
+    assert cai_wrapper(db).stream is None
+
+    db.stream = 2
+    assert db.__cuda_array_interface__["version"] == 3
+    assert cai_wrapper(db).stream == 2
@@ -42,3 +42,36 @@ def test_handle_external_stream(stream):
 
     with pytest.raises(ValueError):
         handle = DeviceResources(stream=1.0)
+
+
+def test_device_resources_manager_threads():
+    from concurrent.futures import ThreadPoolExecutor
+
+    from pylibraft.common import DeviceResourcesManager
+    from pylibraft.neighbors import ivf_pq
+
+    dataset = device_ndarray(
+        np.random.random_sample((5000, 16)).astype(np.float32)
+    )
+    index = ivf_pq.build(ivf_pq.IndexParams(n_lists=16), dataset)
+    batches = [
+        device_ndarray(np.random.random_sample((100, 16)).astype(np.float32))
+        for _ in range(8)
+    ]
+
+    def search(queries, handle):
+        _, neighbors = ivf_pq.search(
+            ivf_pq.SearchParams(n_probes=16), index, queries, 10, handle=handle
+        )
+        handle.sync()
+        return neighbors.copy_to_host()
+
+    def search_in_thread(queries):
+        return search(queries, DeviceResourcesManager.get_device_resources())
+
+    with ThreadPoolExecutor(max_workers=4) as pool:
+        results = list(pool.map(search_in_thread, batches))
+
+    for queries, result in zip(batches, results):
+        expected = search(queries, DeviceResources())
+        np.testing.assert_array_equal(result, expected)
@@ -96,3 +96,15 @@ def test_hnsw(dtype, k, ef, num_threads, metric, build_algo):
         build_algo=build_algo,
         search_params={"ef": ef, "num_threads": num_threads},
     )
+
+
+@pytest.mark.parametrize("num_threads", [0, 4])
+def test_hnsw_numa_aware(num_threads):
+    # On a single NUMA node, the search falls back to the regular one.
+    run_hnsw_build_search_test(
+        search_params={
+            "ef": 30,
+            "num_threads": num_threads,
+            "numa_aware": True,
+        },
+    )
@@ -548,3 +548,46 @@ def test_save_load():
 
     assert np.all(neighbors == neighbors2)
     assert np.allclose(dist, dist2, rtol=1e-6)
+
+
+@pytest.mark.parametrize("add_data_on_build", [True, False])
+def test_build_memmap(tmp_path, add_data_on_build):
+    n_rows = 10000
+    n_cols = 16
+    n_queries = 100
+    k = 10
+    dtype = np.float32
+
+    dataset = np.memmap(
+        tmp_path / "dataset.bin",
+        dtype=dtype,
+        mode="w+",
+        shape=(n_rows, n_cols),
+    )
+    dataset[:] = generate_data((n_rows, n_cols), dtype)
+    dataset.flush()
+
+    build_params = ivf_pq.IndexParams(
+        n_lists=100,
+        metric="sqeuclidean",
+        kmeans_trainset_fraction=0.1,
+        add_data_on_build=add_data_on_build,
+    )
+    index = ivf_pq.build(build_params, dataset)
+    if not add_data_on_build:
+        new_indices = np.arange(n_rows, dtype=np.int64)
+        index = ivf_pq.extend(index, dataset, new_indices)
+    assert index.size == n_rows
+
+    queries = generate_data((n_queries, n_cols), dtype)
+    _, out_idx = ivf_pq.search(
+        ivf_pq.SearchParams(n_probes=100),
+        index,
+        device_ndarray(queries),
+        k,
+    )
+
+    nn_skl = NearestNeighbors(n_neighbors=k, algorithm="brute")
+    nn_skl.fit(np.asarray(dataset))
+    skl_idx = nn_skl.kneighbors(queries, return_distance=False)
+    assert calc_recall(out_idx.copy_to_host(), skl_idx) > 0.7
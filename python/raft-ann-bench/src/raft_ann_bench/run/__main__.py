@@ -153,6 +153,7 @@ def run_build_and_search(
     search_threads,
     mode="throughput",
     raft_log_level="info",
+    target_qps=None,
 ):
     for (
         executable,
@@ -238,6 +239,9 @@ def run_build_and_search(
             if search_threads:
                 cmd = cmd + ["--threads=%s" % search_threads]
 
+            if target_qps:
+                cmd = cmd + ["--target_qps=%s" % target_qps]
+
             cmd = cmd + [temp_conf_filename]
             if dry_run:
                 print(
@@ -349,11 +353,20 @@ def main():
     parser.add_argument(
         "-m",
         "--search-mode",
-        help="run search in 'latency' (measure individual batches) or "
-        "'throughput' (pipeline batches and measure end-to-end) mode",
+        help="run search in 'latency' (measure individual batches), "
+        "'throughput' (pipeline batches and measure end-to-end) or "
+        "'open_loop' (queries arrive at --target-qps, report latency "
+        "percentiles) mode",
         default="latency",
     )
 
+    parser.add_argument(
+        "--target-qps",
+        help="total arrival rate of the queries in the 'open_loop' search "
+        "mode; the batch size is the largest micro-batch.",
+        default=None,
+    )
+
     parser.add_argument(
         "-t",
         "--search-threads",
@@ -607,6 +620,7 @@ def main():
         args.search_threads,
         mode,
         args.raft_log_level,
+        args.target_qps,
     )
 
 
@@ -0,0 +1,176 @@
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import numpy as np
+from dask.distributed import get_worker
+
+from pylibraft.common import device_ndarray
+
+from raft_dask.common import mnmg
+from raft_dask.common.comms import get_persistent_comms, local_handle
+from raft_dask.common.utils import (
+    get_client,
+    persist_row_chunks,
+    to_device_array,
+)
+
+# raft::cluster::KMeansParams::InitMethod
+_INIT_METHODS = {"k-means||": 0, "random": 1, "array": 2}
+
+
+def fit(
+    X,
+    n_clusters,
+    sample_weight=None,
+    init="k-means||",
+    centroids=None,
+    max_iter=300,
+    tol=1e-4,
+    oversampling_factor=2.0,
+    seed=0,
+    client=None,
+):
+    """
+    Finds the centroids of k-means clusters of the rows of a dask array,
+    with the NCCL collectives of the workers holding its chunks (see
+    `raft::cluster::kmeans::fit_mg`). Every iteration only reduces the
+    partial sums of the clusters over the workers; the samples never move.
+
+    Parameters
+    ----------
+    X : dask.array.Array of float32 of shape (n_samples, n_features)
+        Its chunks must span all the columns
+    n_clusters : int
+    sample_weight : dask.array.Array of float32 of shape (n_samples,)
+        [optional] Chunked like the rows of X
+    init : string
+        "k-means||", "random" or "array" (the given `centroids`)
+    centroids : array of shape (n_clusters, n_features) [optional]
+        The initial centroids, implies init="array"
+    max_iter : int
+    tol : float
+    oversampling_factor : float
+        The oversampling of k-means||
+    seed : int
+    client : dask.distributed.Client [optional]
+        Dask client to use
+
+    Returns
+    -------
+    centroids : numpy.ndarray of float32 of shape (n_clusters, n_features)
+    inertia : float
+    n_iter : int
+
+    Examples
+    --------
+    .. code-block:: python
+
+        import dask.array as da
+        from raft_dask.cluster import kmeans
+
+        X = da.random.random((10_000_000, 32), chunks=(1_000_000, 32))
+        centroids, inertia, n_iter = kmeans.fit(X.astype("float32"), 100)
+    """
+    if centroids is not None:
+        init = "array"
+        centroids = np.ascontiguousarray(centroids, dtype=np.float32)
+        if centroids.shape != (n_clusters, X.shape[1]):
+            raise ValueError(
+                "centroids must be of the shape (n_clusters, n_features)"
+            )
+    elif init == "array":
+        raise ValueError("init='array' requires the initial centroids")
+    if init not in _INIT_METHODS:
+        raise ValueError(
+            f"init must be one of: {tuple(_INIT_METHODS.keys())}"
+        )
+    client = get_client(client)
+    n_features = X.shape[1]
+
+    X_chunks = persist_row_chunks(client, X)
+    weight_parts = None
+    if sample_weight is not None:
+        if sample_weight.chunks[0] != X.chunks[0]:
+            raise ValueError("sample_weight must be chunked like X")
+        weight_parts = [
+            part
+            for _, part, _, _ in persist_row_chunks(client, sample_weight)
+        ]
+    workers = list(dict.fromkeys(w for w, _, _, _ in X_chunks))
+    comms = get_persistent_comms(client, workers)
+
+    futures = [
+        client.submit(
+            _func_fit,
+            comms.sessionId,
+            [part for worker, part, _, _ in X_chunks if worker == w],
+            None
+            if weight_parts is None
+            else [
+                part
+                for (worker, _, _, _), part in zip(X_chunks, weight_parts)
+                if worker == w
+            ],
+            n_features,
+            n_clusters,
+            _INIT_METHODS[init],
+            centroids,
+            max_iter,
+            tol,
+            oversampling_factor,
+            seed,
+            workers=[w],
+            pure=False,
+        )
+        for w in workers
+    ]
+    # All the workers end with the same centroids
+    return client.gather(futures)[0]
+
+
+def _func_fit(
+    sessionId,
+    X_parts,
+    weight_parts,
+    n_features,
+    n_clusters,
+    init,
+    centroids,
+    max_iter,
+    tol,
+    oversampling_factor,
+    seed,
+):
+    handle = local_handle(sessionId, get_worker())
+    X = to_device_array(X_parts, n_features)
+    weight = None
+    if weight_parts is not None:
+        weight = to_device_array(weight_parts)
+    if centroids is None:
+        centroids = np.zeros((n_clusters, n_features), dtype=np.float32)
+    centroids = device_ndarray(centroids)
+    inertia, n_iter = mnmg.kmeans_fit(
+        handle,
+        X,
+        centroids,
+        sample_weight=weight,
+        init=init,
+        max_iter=max_iter,
+        tol=tol,
+        oversampling_factor=oversampling_factor,
+        seed=seed,
+    )
+    handle.sync()
+    return centroids.copy_to_host(), inertia, n_iter
@@ -1,4 +1,4 @@
-# Copyright (c) 2020-2022, NVIDIA CORPORATION.
+# Copyright (c) 2020-2024, NVIDIA CORPORATION.
 #
 # Licensed under the Apache License, Version 2.0 (the "License");
 # you may not use this file except in compliance with the License.
@@ -13,14 +13,22 @@
 # limitations under the License.
 #
 
-from .comms import Comms, local_handle
+from .comms import (
+    Comms,
+    destroy_persistent_comms,
+    get_persistent_comms,
+    local_handle,
+)
 from .comms_utils import (
     inject_comms_on_handle,
     inject_comms_on_handle_coll_only,
     perform_test_comm_split,
     perform_test_comms_allgather,
     perform_test_comms_allreduce,
+    perform_test_comms_alltoall,
+    perform_test_comms_alltoallv,
     perform_test_comms_bcast,
+    perform_test_comms_device_isend_irecv,
     perform_test_comms_device_multicast_sendrecv,
     perform_test_comms_device_send_or_recv,
     perform_test_comms_device_sendrecv,
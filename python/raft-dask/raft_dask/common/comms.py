@@ -217,6 +217,18 @@ class Comms:
         if self.verbose:
             print("Initialization complete.")
 
+    def ranks(self):
+        """
+        Returns the rank of every worker of the initialized session, by
+        worker address.
+        """
+        return self.client.run(
+            _func_get_rank,
+            self.sessionId,
+            workers=self.worker_addresses,
+            wait=True,
+        )
+
     def destroy(self):
         """
         Shuts down initialized comms and cleans up resources. This will
@@ -244,6 +256,97 @@ class Comms:
         self.ucx_initialized = False
 
 
+# The initialized persistent comms, by `_persistent_comms_key`
+_persistent_comms = {}
+
+
+def _persistent_comms_key(client, workers, **kwargs):
+    return (client.scheduler.address, tuple(workers)) + tuple(
+        sorted(kwargs.items())
+    )
+
+
+def get_persistent_comms(
+    client=None,
+    workers=None,
+    comms_p2p=False,
+    streams_per_handle=0,
+    nccl_root_location="scheduler",
+    verbose=False,
+):
+    """
+    Returns initialized comms for the given set of workers, reusing the
+    ones created by an earlier call with the same workers and settings.
+
+    Creating the NCCL clique and the UCX endpoints of a `Comms` takes
+    seconds on large clusters; the algorithms called repeatedly on the same
+    workers can instead share one session, whose handles stay on the
+    workers (see `local_handle`). The session is recreated if any of its
+    workers has left the cluster. The sessions live until
+    `destroy_persistent_comms` is called.
+
+    Parameters
+    ----------
+    client : dask.distributed.Client [optional]
+             Dask client to use
+    workers : Sequence [optional]
+              Unique collection of workers for initializing comms, all the
+              workers of the cluster by default
+    comms_p2p, streams_per_handle, nccl_root_location, verbose :
+              See `Comms`
+
+    Returns
+    -------
+    comms : Comms
+    """
+    client = client if client is not None else default_client()
+    cluster_workers = client.scheduler_info()["workers"].keys()
+    workers = list(
+        OrderedDict.fromkeys(cluster_workers if workers is None else workers)
+    )
+    key = _persistent_comms_key(
+        client,
+        workers,
+        comms_p2p=comms_p2p,
+        streams_per_handle=streams_per_handle,
+        nccl_root_location=nccl_root_location,
+    )
+
+    comms = _persistent_comms.get(key)
+    if comms is not None and not set(workers).issubset(cluster_workers):
+        # A worker of the clique has gone, the session is unusable
+        del _persistent_comms[key]
+        comms.worker_addresses = [
+            w for w in comms.worker_addresses if w in cluster_workers
+        ]
+        comms.destroy()
+        comms = None
+
+    if comms is None:
+        comms = Comms(
+            comms_p2p=comms_p2p,
+            client=client,
+            verbose=verbose,
+            streams_per_handle=streams_per_handle,
+            nccl_root_location=nccl_root_location,
+        )
+        comms.init(workers=workers)
+        _persistent_comms[key] = comms
+    return comms
+
+
+def destroy_persistent_comms(client=None):
+    """
+    Destroys the comms created by `get_persistent_comms`, only those of the
+    given client if one is passed.
+    """
+    for key in list(_persistent_comms.keys()):
+        comms = _persistent_comms[key]
+        if client is None or comms.client is client:
+            del _persistent_comms[key]
+            comms.destroy()
+
+
 def local_handle(sessionId, dask_worker=None):
     """
     Simple helper function for retrieving the local handle_t instance
@@ -610,6 +713,11 @@ def _func_build_handle(
     raft_comm_state["handle"] = handle
 
 
+def _func_get_rank(sessionId, dask_worker=None):
+    state = get_raft_comm_state(sessionId=sessionId, state_object=dask_worker)
+    return state["wid"]
+
+
 def _func_store_initial_state(
     nworkers, sessionId, uniqueId, wid, dask_worker=None
 ):
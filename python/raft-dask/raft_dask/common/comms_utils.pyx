@@ -65,8 +65,14 @@ cdef extern from "raft/comms/comms_test.hpp" namespace "raft::comms":
     bool test_collective_gatherv(const device_resources &h, int root) except +
     bool test_collective_reducescatter(const device_resources &h, int root) \
         except +
+    bool test_collective_alltoall(const device_resources &h, int root) \
+        except +
+    bool test_collective_alltoallv(const device_resources &h, int root) \
+        except +
     bool test_pointToPoint_simple_send_recv(const device_resources &h,
                                             int numTrials) except +
+    bool test_pointToPoint_device_isend_irecv(const device_resources &h,
+                                              int numTrials) except +
     bool test_pointToPoint_device_send_or_recv(const device_resources &h,
                                                int numTrials) except +
     bool test_pointToPoint_device_sendrecv(const device_resources &h,
@@ -118,6 +124,34 @@ def perform_test_comms_reducescatter(handle, root):
     return test_collective_reducescatter(deref(h), root)
 
 
+def perform_test_comms_alltoall(handle, root):
+    """
+    Performs an alltoall on the current worker
+
+    Parameters
+    ----------
+    handle : raft.common.Handle
+             handle containing comms_t to use
+    """
+    cdef const device_resources* h = \
+        <device_resources*><size_t>handle.getHandle()
+    return test_collective_alltoall(deref(h), root)
+
+
+def perform_test_comms_alltoallv(handle, root):
+    """
+    Performs an alltoallv on the current worker
+
+    Parameters
+    ----------
+    handle : raft.common.Handle
+             handle containing comms_t to use
+    """
+    cdef const device_resources* h = \
+        <device_resources*><size_t>handle.getHandle()
+    return test_collective_alltoallv(deref(h), root)
+
+
 def perform_test_comms_bcast(handle, root):
     """
     Performs an broadcast on the current worker
@@ -194,6 +228,22 @@ def perform_test_comms_send_recv(handle, n_trials):
     return test_pointToPoint_simple_send_recv(deref(h), <int>n_trials)
 
 
+def perform_test_comms_device_isend_irecv(handle, n_trials):
+    """
+    Performs a p2p device isend/irecv over UCX on the current worker
+
+    Parameters
+    ----------
+    handle : raft.common.Handle
+             handle containing comms_t to use
+    n_trilas : int
+               Number of test trials
+    """
+    cdef const device_resources *h = \
+        <device_resources*><size_t>handle.getHandle()
+    return test_pointToPoint_device_isend_irecv(deref(h), <int>n_trials)
+
+
 def perform_test_comms_device_send_or_recv(handle, n_trials):
     """
     Performs a p2p device send or recv on the current worker
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mnmg.hpp"
+
+#include <raft/cluster/kmeans_mg.cuh>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force_mg.cuh>
+
+#include <optional>
+
+namespace raft_dask::mnmg {
+
+void knn(raft::device_resources const& handle,
+         const float* index,
+         int64_t n_index_rows,
+         const float* queries,
+         int64_t n_queries,
+         int64_t dim,
+         int64_t k,
+         int64_t* neighbors,
+         float* distances,
+         int metric,
+         float metric_arg)
+{
+  raft::neighbors::brute_force::knn_mg<float, int64_t>(
+    handle,
+    raft::make_device_matrix_view<const float, int64_t>(index, n_index_rows, dim),
+    raft::make_device_matrix_view<const float, int64_t>(queries, n_queries, dim),
+    raft::make_device_matrix_view<int64_t, int64_t>(neighbors, n_queries, k),
+    raft::make_device_matrix_view<float, int64_t>(distances, n_queries, k),
+    static_cast<raft::distance::DistanceType>(metric),
+    std::make_optional(metric_arg));
+}
+
+void kmeans_fit(raft::device_resources const& handle,
+                int n_clusters,
+                int init,
+                int max_iter,
+                double tol,
+                double oversampling_factor,
+                uint64_t seed,
+                const float* X,
+                int n_rows,
+                int n_features,
+                const float* sample_weight,
+                float* centroids,
+                float* inertia,
+                int* n_iter)
+{
+  raft::cluster::KMeansParams params;
+  params.n_clusters          = n_clusters;
+  params.init                = static_cast<raft::cluster::KMeansParams::InitMethod>(init);
+  params.max_iter            = max_iter;
+  params.tol                 = tol;
+  params.oversampling_factor = oversampling_factor;
+  params.rng_state.seed      = seed;
+
+  std::optional<raft::device_vector_view<const float, int>> weight = std::nullopt;
+  if (sample_weight != nullptr) {
+    weight = raft::make_device_vector_view<const float, int>(sample_weight, n_rows);
+  }
+  raft::cluster::kmeans::fit_mg<float, int>(
+    handle,
+    params,
+    raft::make_device_matrix_view<const float, int>(X, n_rows, n_features),
+    weight,
+    raft::make_device_matrix_view<float, int>(centroids, n_clusters, n_features),
+    raft::make_host_scalar_view<float>(inertia),
+    raft::make_host_scalar_view<int>(n_iter));
+}
+
+}  // namespace raft_dask::mnmg
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_resources.hpp>
+
+#include <cstdint>
+
+/**
+ * The multi-GPU algorithms of raft used by raft-dask, instantiated for the float data in
+ * mnmg.cu so that the Cython module does not need to compile the CUDA headers. All the functions
+ * are collective over the communicator of the handle.
+ */
+namespace raft_dask::mnmg {
+
+/** See raft::neighbors::brute_force::knn_mg; `metric` is a raft::distance::DistanceType. */
+void knn(raft::device_resources const& handle,
+         const float* index,
+         int64_t n_index_rows,
+         const float* queries,
+         int64_t n_queries,
+         int64_t dim,
+         int64_t k,
+         int64_t* neighbors,
+         float* distances,
+         int metric,
+         float metric_arg);
+
+/**
+ * See raft::cluster::kmeans::fit_mg; `init` is a raft::cluster::KMeansParams::InitMethod and
+ * `sample_weight` may be null.
+ */
+void kmeans_fit(raft::device_resources const& handle,
+                int n_clusters,
+                int init,
+                int max_iter,
+                double tol,
+                double oversampling_factor,
+                uint64_t seed,
+                const float* X,
+                int n_rows,
+                int n_features,
+                const float* sample_weight,
+                float* centroids,
+                float* inertia,
+                int* n_iter);
+
+}  // namespace raft_dask::mnmg
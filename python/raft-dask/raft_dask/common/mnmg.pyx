@@ -0,0 +1,212 @@
+#
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# cython: profile=False
+# distutils: language = c++
+# cython: embedsignature = True
+# cython: language_level = 3
+
+import numpy as np
+
+from cython.operator cimport dereference as deref
+from libc.stdint cimport int64_t, uint64_t, uintptr_t
+
+from pylibraft.common import cai_wrapper
+
+
+cdef extern from "raft/core/device_resources.hpp" namespace "raft":
+    cdef cppclass device_resources:
+        device_resources() except +
+
+cdef extern from "mnmg.hpp" namespace "raft_dask::mnmg" nogil:
+
+    void c_knn "raft_dask::mnmg::knn" (
+        const device_resources &handle,
+        const float* index,
+        int64_t n_index_rows,
+        const float* queries,
+        int64_t n_queries,
+        int64_t dim,
+        int64_t k,
+        int64_t* neighbors,
+        float* distances,
+        int metric,
+        float metric_arg) except +
+
+    void c_kmeans_fit "raft_dask::mnmg::kmeans_fit" (
+        const device_resources &handle,
+        int n_clusters,
+        int init,
+        int max_iter,
+        double tol,
+        double oversampling_factor,
+        uint64_t seed,
+        const float* X,
+        int n_rows,
+        int n_features,
+        const float* sample_weight,
+        float* centroids,
+        float* inertia,
+        int* n_iter) except +
+
+
+def _float_matrix(arr, name, n_cols=None):
+    arr_cai = cai_wrapper(arr)
+    arr_cai.validate_shape_dtype(expected_dims=2,
+                                 expected_dtype=np.float32)
+    if not arr_cai.c_contiguous:
+        raise ValueError(f"{name} must be row-major")
+    if n_cols is not None and arr_cai.shape[1] != n_cols:
+        raise ValueError(f"{name} must have {n_cols} columns")
+    return arr_cai
+
+
+def knn(handle, index, queries, k, metric, metric_arg, neighbors,
+        distances):
+    """
+    Finds the k nearest neighbors of the queries of all the workers in the
+    index partitioned among them, collectively on all the workers of the
+    comms session of the handle. See
+    `raft::neighbors::brute_force::knn_mg`.
+
+    Parameters
+    ----------
+    handle : the handle of the comms session on this worker
+    index : float32 CUDA array interface compliant matrix
+        The rows of the index on this worker, at least k. They follow the
+        rows of the workers of the lower ranks.
+    queries : float32 CUDA array interface compliant matrix
+        The queries of this worker, possibly none
+    k : int
+    metric : int
+        The value of a raft::distance::DistanceType
+    metric_arg : float
+    neighbors : int64 CUDA array interface compliant matrix (n_queries, k)
+        The ids of the neighbors in the whole index
+    distances : float32 CUDA array interface compliant matrix (n_queries, k)
+    """
+    index_cai = _float_matrix(index, "index")
+    dim = index_cai.shape[1]
+    queries_cai = _float_matrix(queries, "queries", dim)
+    distances_cai = _float_matrix(distances, "distances", k)
+    neighbors_cai = cai_wrapper(neighbors)
+    neighbors_cai.validate_shape_dtype(expected_dims=2,
+                                       expected_dtype=np.int64)
+    n_queries = queries_cai.shape[0]
+    if neighbors_cai.shape != (n_queries, k) or \
+            distances_cai.shape[0] != n_queries:
+        raise ValueError("The outputs must be of the shape (n_queries, k)")
+
+    cdef device_resources* h = \
+        <device_resources*><size_t>handle.getHandle()
+    cdef const float* index_ptr = <const float*><uintptr_t>index_cai.data
+    cdef const float* queries_ptr = \
+        <const float*><uintptr_t>queries_cai.data
+    cdef int64_t* neighbors_ptr = <int64_t*><uintptr_t>neighbors_cai.data
+    cdef float* distances_ptr = <float*><uintptr_t>distances_cai.data
+    cdef int64_t n_index_rows = index_cai.shape[0]
+    cdef int64_t c_n_queries = n_queries
+    cdef int64_t c_dim = dim
+    cdef int64_t c_k = k
+    cdef int c_metric = metric
+    cdef float c_metric_arg = metric_arg
+
+    # The collectives block until all the workers have joined
+    with nogil:
+        c_knn(deref(h),
+              index_ptr,
+              n_index_rows,
+              queries_ptr,
+              c_n_queries,
+              c_dim,
+              c_k,
+              neighbors_ptr,
+              distances_ptr,
+              c_metric,
+              c_metric_arg)
+
+
+def kmeans_fit(handle, X, centroids, sample_weight=None, init=0,
+               max_iter=300, tol=1e-4, oversampling_factor=2.0, seed=0):
+    """
+    Fits the centroids of k-means on the samples of all the workers,
+    collectively on all the workers of the comms session of the handle. See
+    `raft::cluster::kmeans::fit_mg`.
+
+    Parameters
+    ----------
+    handle : the handle of the comms session on this worker
+    X : float32 CUDA array interface compliant matrix
+        The samples of this worker
+    centroids : float32 CUDA array interface compliant matrix
+        (n_clusters, n_features). The initial centroids when `init` is
+        array (taken from the rank 0), the fitted ones on exit.
+    sample_weight : float32 CUDA array interface compliant vector [optional]
+    init : int
+        The value of a raft::cluster::KMeansParams::InitMethod
+    max_iter, tol, oversampling_factor, seed :
+        See raft::cluster::KMeansParams
+
+    Returns
+    -------
+    inertia : float
+        The inertia of the samples of all the workers
+    n_iter : int
+    """
+    X_cai = _float_matrix(X, "X")
+    n_features = X_cai.shape[1]
+    centroids_cai = _float_matrix(centroids, "centroids", n_features)
+
+    cdef const float* weight_ptr = NULL
+    if sample_weight is not None:
+        weight_cai = cai_wrapper(sample_weight)
+        weight_cai.validate_shape_dtype(expected_dims=1,
+                                        expected_dtype=np.float32)
+        if weight_cai.shape[0] != X_cai.shape[0]:
+            raise ValueError("sample_weight must have a weight per sample")
+        weight_ptr = <const float*><uintptr_t>weight_cai.data
+
+    cdef device_resources* h = \
+        <device_resources*><size_t>handle.getHandle()
+    cdef const float* X_ptr = <const float*><uintptr_t>X_cai.data
+    cdef float* centroids_ptr = <float*><uintptr_t>centroids_cai.data
+    cdef int c_n_clusters = centroids_cai.shape[0]
+    cdef int c_init = init
+    cdef int c_max_iter = max_iter
+    cdef double c_tol = tol
+    cdef double c_oversampling_factor = oversampling_factor
+    cdef uint64_t c_seed = seed
+    cdef int n_rows = X_cai.shape[0]
+    cdef int c_n_features = n_features
+    cdef float inertia = 0
+    cdef int n_iter = 0
+
+    with nogil:
+        c_kmeans_fit(deref(h),
+                     c_n_clusters,
+                     c_init,
+                     c_max_iter,
+                     c_tol,
+                     c_oversampling_factor,
+                     c_seed,
+                     X_ptr,
+                     n_rows,
+                     c_n_features,
+                     weight_ptr,
+                     centroids_ptr,
+                     &inertia,
+                     &n_iter)
+    return inertia, n_iter
@@ -13,7 +13,10 @@
 # limitations under the License.
 #
 
-from dask.distributed import default_client
+import numpy as np
+from dask.distributed import default_client, futures_of, wait
+
+from pylibraft.common import device_ndarray
 
 
 def get_client(client=None):
@@ -37,3 +40,53 @@ def parse_host_port(address):
     host, port = address.split(":")
     port = int(port)
     return host, port
+
+
+def persist_row_chunks(client, array):
+    """
+    Persists a dask array whose chunks span all the columns, if any, and
+    locates its row chunks.
+
+    Parameters
+    ----------
+    client : dask.distributed.Client
+    array : dask.array.Array of shape (n_rows, n_cols) or (n_rows,)
+
+    Returns
+    -------
+    chunks : list of (worker address, future, first row, n_rows)
+        In the order of the rows
+    """
+    if array.ndim == 2 and len(array.chunks[1]) != 1:
+        raise ValueError("The chunks of the array must span all columns")
+    array = array.persist()
+    parts = futures_of(array)
+    wait(parts)
+    # The keys of the futures hold the indices of the row chunks
+    parts = sorted(parts, key=lambda f: f.key[1])
+    who_has = client.who_has(parts)
+    first_rows = np.cumsum((0,) + array.chunks[0][:-1])
+    return [
+        (who_has[part.key][0], part, int(first_row), int(n_rows))
+        for part, first_row, n_rows in zip(
+            parts, first_rows, array.chunks[0]
+        )
+    ]
+
+
+def to_device_array(parts, n_cols=None, dtype=np.float32):
+    """
+    Concatenates the row chunks of a worker into one C-contiguous array in
+    the device memory: a matrix of `n_cols` columns, or a vector if
+    `n_cols` is None. An empty list gives an array of zero rows.
+    """
+    if parts and all(hasattr(p, "__cuda_array_interface__") for p in parts):
+        import cupy as cp
+
+        return cp.ascontiguousarray(cp.concatenate(parts), dtype=dtype)
+    if not parts:
+        shape = (0,) if n_cols is None else (0, n_cols)
+        return device_ndarray(np.empty(shape, dtype=dtype))
+    return device_ndarray(
+        np.ascontiguousarray(np.concatenate(parts), dtype=dtype)
+    )
@@ -0,0 +1,180 @@
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import numpy as np
+from dask.distributed import get_worker
+
+from pylibraft.common import device_ndarray
+from pylibraft.distance.pairwise_distance import DISTANCE_TYPES
+
+from raft_dask.common import mnmg
+from raft_dask.common.comms import get_persistent_comms, local_handle
+from raft_dask.common.utils import (
+    get_client,
+    persist_row_chunks,
+    to_device_array,
+)
+
+SUPPORTED_DISTANCES = ["euclidean", "l2", "sqeuclidean", "inner_product"]
+
+
+def knn(index, queries, k, metric="sqeuclidean", metric_arg=2.0, client=None):
+    """
+    Exact k nearest neighbors of the rows of a dask array in another one,
+    with the NCCL collectives of the workers (see
+    `raft::neighbors::brute_force::knn_mg`).
+
+    The workers holding the chunks of the index form a comms session (see
+    `get_persistent_comms`). Every worker searches its chunks of the index
+    for the queries of all the workers, and sends each worker the
+    candidates of its own queries, which it merges; the index never moves.
+
+    Parameters
+    ----------
+    index : dask.array.Array of shape (n_rows, dim)
+        Its chunks must span all the columns. Every worker holding chunks
+        must hold at least k rows.
+    queries : dask.array.Array of shape (n_queries, dim)
+        Its chunks must span all the columns
+    k : int
+        The number of neighbors
+    metric : string
+        One of "sqeuclidean", "euclidean" ("l2") or "inner_product"
+    metric_arg : float
+    client : dask.distributed.Client [optional]
+        Dask client to use
+
+    Returns
+    -------
+    distances : numpy.ndarray of float32 of shape (n_queries, k)
+    neighbors : numpy.ndarray of int64 of shape (n_queries, k)
+        The row ids in the index
+
+    Examples
+    --------
+    .. code-block:: python
+
+        import dask.array as da
+        from raft_dask.neighbors import brute_force
+
+        index = da.random.random((10_000_000, 96), chunks=(1_000_000, 96))
+        queries = da.random.random((100_000, 96), chunks=(10_000, 96))
+        distances, neighbors = brute_force.knn(
+            index.astype("float32"), queries.astype("float32"), 10
+        )
+    """
+    if metric not in SUPPORTED_DISTANCES:
+        raise ValueError(f"metric {metric} is not supported")
+    if index.shape[1] != queries.shape[1]:
+        raise ValueError("The index and the queries must have the same dim")
+    client = get_client(client)
+    dim = index.shape[1]
+
+    index_chunks = persist_row_chunks(client, index)
+    workers = list(dict.fromkeys(w for w, _, _, _ in index_chunks))
+    rows_per_worker = {w: 0 for w in workers}
+    for w, _, _, n_rows in index_chunks:
+        rows_per_worker[w] += n_rows
+    if min(rows_per_worker.values()) < k:
+        raise ValueError(
+            f"Every worker must hold at least k={k} rows of the index"
+        )
+    comms = get_persistent_comms(client, workers)
+    ranks = comms.ranks()
+
+    # The ranks number the rows of their chunks after those of the lower
+    # ranks: the segments map these ids back to the rows of the index
+    segments = []
+    offset = 0
+    for w in sorted(workers, key=ranks.get):
+        for worker, _, first_row, n_rows in index_chunks:
+            if worker == w:
+                segments.append((offset, first_row))
+                offset += n_rows
+    segments = np.asarray(segments, dtype=np.int64)
+
+    # The query chunks held outside of the session are spread over it
+    query_chunks = {w: [] for w in workers}
+    for i, (w, part, _, _) in enumerate(persist_row_chunks(client, queries)):
+        owner = w if w in query_chunks else workers[i % len(workers)]
+        query_chunks[owner].append((i, part))
+
+    futures = [
+        client.submit(
+            _func_knn,
+            comms.sessionId,
+            [part for worker, part, _, _ in index_chunks if worker == w],
+            [part for _, part in query_chunks[w]],
+            dim,
+            k,
+            DISTANCE_TYPES[metric],
+            metric_arg,
+            segments,
+            workers=[w],
+            pure=False,
+        )
+        for w in workers
+    ]
+    results = client.gather(futures)
+
+    # Back in the order of the query chunks
+    ordered = sorted(
+        (i, result)
+        for w, worker_results in zip(workers, results)
+        for (i, _), result in zip(query_chunks[w], worker_results)
+    )
+    distances = [d for _, (d, _) in ordered]
+    neighbors = [n for _, (_, n) in ordered]
+    if not ordered:
+        return (
+            np.empty((0, k), dtype=np.float32),
+            np.empty((0, k), dtype=np.int64),
+        )
+    return np.concatenate(distances), np.concatenate(neighbors)
+
+
+def _func_knn(
+    sessionId,
+    index_parts,
+    query_parts,
+    dim,
+    k,
+    metric,
+    metric_arg,
+    segments,
+):
+    handle = local_handle(sessionId, get_worker())
+    index = to_device_array(index_parts, dim)
+    queries = to_device_array(query_parts, dim)
+    n_queries = queries.shape[0]
+    neighbors = device_ndarray.empty((n_queries, k), dtype="int64")
+    distances = device_ndarray.empty((n_queries, k), dtype="float32")
+    mnmg.knn(
+        handle, index, queries, k, metric, metric_arg, neighbors, distances
+    )
+    handle.sync()
+
+    distances = distances.copy_to_host()
+    ids = neighbors.copy_to_host()
+    seg = np.searchsorted(segments[:, 0], ids, side="right") - 1
+    ids = ids - segments[seg, 0] + segments[seg, 1]
+
+    results = []
+    first = 0
+    for part in query_parts:
+        last = first + part.shape[0]
+        results.append((distances[first:last], ids[first:last]))
+        first = last
+    return results
@@ -0,0 +1,245 @@
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import uuid
+
+import numpy as np
+from dask.distributed import default_client, futures_of, get_worker, wait
+
+from pylibraft.common import DeviceResources, device_ndarray
+from pylibraft.neighbors import cagra, ivf_flat, ivf_pq
+
+_ALGOS = {"ivf_flat": ivf_flat, "ivf_pq": ivf_pq, "cagra": cagra}
+
+
+class ShardedIndex:
+    """
+    An approximate nearest neighbors index distributed over the workers of
+    a Dask cluster, one shard per chunk of rows of the dataset.
+
+    Each shard is a pylibraft index built by the worker holding the chunk
+    and kept in the memory of that worker until `destroy()`, so repeated
+    searches only send the queries to the workers: the dataset and the
+    indices are never moved again. Every shard returns its `k` best
+    candidates, with the row ids in the whole dataset, and the client
+    merges them.
+
+    Parameters
+    ----------
+    algo : string
+        One of "ivf_flat", "ivf_pq" or "cagra"
+    index_params : dict [optional]
+        The keyword arguments of the IndexParams of the algorithm, used for
+        the index of every shard
+    client : dask.distributed.Client [optional]
+        Dask client to use
+
+    Examples
+    --------
+    .. code-block:: python
+
+        import dask.array as da
+        from raft_dask.neighbors import ShardedIndex
+
+        dataset = da.random.random((10_000_000, 96), chunks=(1_000_000, 96))
+        index = ShardedIndex("ivf_pq", {"n_lists": 1024})
+        index.build(dataset.astype("float32"))
+
+        for queries in query_batches:
+            distances, neighbors = index.search(queries, 10, {"n_probes": 50})
+
+        index.destroy()
+    """
+
+    def __init__(self, algo, index_params=None, client=None):
+        if algo not in _ALGOS:
+            raise ValueError(
+                f"algo must be one of: {tuple(_ALGOS.keys())}, got '{algo}'"
+            )
+        self.algo = algo
+        self.index_params = dict(index_params or {})
+        self.client = client if client is not None else default_client()
+        self.index_id = uuid.uuid4().hex
+        # [(worker address, shard id, first row)] in the order of the rows
+        self.shards = []
+
+    def build(self, dataset):
+        """
+        Builds the index of every chunk of rows of the dataset on the
+        worker holding it.
+
+        Parameters
+        ----------
+        dataset : dask.array.Array of shape (n_rows, dim)
+            Its chunks must span all the columns. Supported dtypes are
+            those of the algorithm.
+        """
+        if self.shards:
+            raise ValueError("The index has already been built.")
+        if len(dataset.chunks[1]) != 1:
+            raise ValueError("The chunks of the dataset must span all columns")
+
+        dataset = dataset.persist()
+        parts = futures_of(dataset)
+        wait(parts)
+        # The futures of a 2D array are in the order of the row chunks
+        parts = sorted(parts, key=lambda f: f.key[1])
+        who_has = self.client.who_has(parts)
+
+        first_rows = np.cumsum((0,) + dataset.chunks[0][:-1])
+        builds = []
+        for shard_id, (part, first_row) in enumerate(zip(parts, first_rows)):
+            worker = who_has[part.key][0]
+            self.shards.append((worker, shard_id, int(first_row)))
+            builds.append(
+                self.client.submit(
+                    _func_build_shard,
+                    self.algo,
+                    self.index_params,
+                    self.index_id,
+                    shard_id,
+                    part,
+                    workers=[worker],
+                    pure=False,
+                )
+            )
+        wait(builds)
+        # Raise the errors of the workers, if any
+        self.client.gather(builds)
+        return self
+
+    def search(self, queries, k, search_params=None):
+        """
+        Finds the k nearest neighbors of the queries in the whole dataset.
+
+        Parameters
+        ----------
+        queries : array interface compliant matrix in host memory
+        k : int
+            The number of neighbors, at most the number of rows of a shard
+        search_params : dict [optional]
+            The keyword arguments of the SearchParams of the algorithm
+
+        Returns
+        -------
+        distances : numpy.ndarray of shape (n_queries, k)
+        neighbors : numpy.ndarray of int64 of shape (n_queries, k)
+            The row ids in the dataset
+        """
+        if not self.shards:
+            raise ValueError("The index needs to be built before search.")
+
+        queries = np.asarray(queries)
+        queries_f = self.client.scatter(
+            queries,
+            workers=list({w for w, _, _ in self.shards}),
+            broadcast=True,
+        )
+        futures = [
+            self.client.submit(
+                _func_search_shard,
+                self.algo,
+                dict(search_params or {}),
+                self.index_id,
+                shard_id,
+                first_row,
+                queries_f,
+                k,
+                workers=[worker],
+                pure=False,
+            )
+            for worker, shard_id, first_row in self.shards
+        ]
+        results = self.client.gather(futures)
+        distances = np.concatenate([d for d, _ in results], axis=1)
+        neighbors = np.concatenate([n for _, n in results], axis=1)
+        metric = self.index_params.get("metric", "sqeuclidean")
+        return _merge_top_k(distances, neighbors, k, metric)
+
+    def destroy(self):
+        """
+        Frees the shards on the workers.
+        """
+        workers = list({w for w, _, _ in self.shards})
+        if workers:
+            self.client.run(
+                _func_destroy_shards, self.index_id, workers=workers
+            )
+        self.shards = []
+
+
+def _merge_top_k(distances, neighbors, k, metric):
+    """Selects the best k of the candidates of all the shards per query"""
+    keys = -distances if metric == "inner_product" else distances
+    best = np.argsort(keys, axis=1, kind="stable")[:, :k]
+    return (
+        np.take_along_axis(distances, best, axis=1),
+        np.take_along_axis(neighbors, best, axis=1),
+    )
+
+
+def _get_ann_state(dask_worker):
+    if not hasattr(dask_worker, "_raft_ann_state"):
+        # A handle per worker is shared by the builds and searches of all
+        # the sharded indices
+        dask_worker._raft_ann_state = {"handle": DeviceResources()}
+    return dask_worker._raft_ann_state
+
+
+def _func_build_shard(algo, index_params, index_id, shard_id, part):
+    state = _get_ann_state(get_worker())
+    handle = state["handle"]
+    module = _ALGOS[algo]
+    if algo == "ivf_flat" and not hasattr(part, "__cuda_array_interface__"):
+        # IVF-Flat builds from the device memory only
+        part = device_ndarray(np.ascontiguousarray(part))
+    index = module.build(
+        module.IndexParams(**index_params), part, handle=handle
+    )
+    handle.sync()
+    state.setdefault(index_id, {})[shard_id] = index
+
+
+def _func_search_shard(
+    algo, search_params, index_id, shard_id, first_row, queries, k
+):
+    state = _get_ann_state(get_worker())
+    handle = state["handle"]
+    module = _ALGOS[algo]
+    index = state[index_id][shard_id]
+    n_queries = queries.shape[0]
+    distances = device_ndarray.empty((n_queries, k), dtype="float32")
+    neighbors = device_ndarray.empty(
+        (n_queries, k), dtype="uint32" if algo == "cagra" else "int64"
+    )
+    module.search(
+        module.SearchParams(**search_params),
+        index,
+        device_ndarray(queries),
+        k,
+        neighbors=neighbors,
+        distances=distances,
+        handle=handle,
+    )
+    handle.sync()
+    return (
+        distances.copy_to_host(),
+        neighbors.copy_to_host().astype(np.int64) + first_row,
+    )
+
+
+def _func_destroy_shards(index_id, dask_worker=None):
+    state = _get_ann_state(dask_worker)
+    state.pop(index_id, None)
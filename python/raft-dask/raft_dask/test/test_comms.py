@@ -23,11 +23,16 @@ from dask_cuda import LocalCUDACluster
 try:
     from raft_dask.common import (
         Comms,
+        destroy_persistent_comms,
+        get_persistent_comms,
         local_handle,
         perform_test_comm_split,
         perform_test_comms_allgather,
         perform_test_comms_allreduce,
+        perform_test_comms_alltoall,
+        perform_test_comms_alltoallv,
         perform_test_comms_bcast,
+        perform_test_comms_device_isend_irecv,
         perform_test_comms_device_multicast_sendrecv,
         perform_test_comms_device_send_or_recv,
         perform_test_comms_device_sendrecv,
@@ -85,6 +90,33 @@ def test_comms_init_no_p2p(cluster):
         client.close()
 
 
+def test_persistent_comms(cluster):
+    client = create_client(cluster)
+    try:
+        cb = get_persistent_comms(client=client)
+        assert cb.nccl_initialized is True
+
+        # The same workers and settings share the session
+        assert get_persistent_comms(client=client) is cb
+        assert (
+            get_persistent_comms(client=client, workers=cb.worker_addresses)
+            is cb
+        )
+        assert get_persistent_comms(client=client, comms_p2p=True) is not cb
+
+        handles = client.run(
+            lambda dask_worker: local_handle(cb.sessionId, dask_worker)
+            is not None,
+            workers=cb.worker_addresses,
+        )
+        assert all(handles.values())
+
+    finally:
+        destroy_persistent_comms(client)
+        assert cb.nccl_initialized is False
+        client.close()
+
+
 def func_test_collective(func, sessionId, root):
     handle = local_handle(sessionId, dask_worker=get_worker())
     return func(handle, root)
@@ -95,6 +127,11 @@ def func_test_send_recv(sessionId, n_trials):
     return perform_test_comms_send_recv(handle, n_trials)
 
 
+def func_test_device_isend_irecv(sessionId, n_trials):
+    handle = local_handle(sessionId, dask_worker=get_worker())
+    return perform_test_comms_device_isend_irecv(handle, n_trials)
+
+
 def func_test_device_send_or_recv(sessionId, n_trials):
     handle = local_handle(sessionId, dask_worker=get_worker())
     return perform_test_comms_device_send_or_recv(handle, n_trials)
@@ -173,6 +210,8 @@ if pytestmark.markname != "skip":
     functions = [
         perform_test_comms_allgather,
         perform_test_comms_allreduce,
+        perform_test_comms_alltoall,
+        perform_test_comms_alltoallv,
         perform_test_comms_bcast,
         perform_test_comms_gather,
         perform_test_comms_gatherv,
@@ -365,6 +404,44 @@ def test_send_recv_protocol_ucxx(n_trials, request):
     _test_send_recv_protocol(n_trials, _get_client("ucxx_client", request))
 
 
+def _test_device_isend_irecv(n_trials, client):
+
+    cb = Comms(comms_p2p=True, verbose=True)
+    cb.init()
+
+    dfs = [
+        client.submit(
+            func_test_device_isend_irecv,
+            cb.sessionId,
+            n_trials,
+            pure=False,
+            workers=[w],
+        )
+        for w in cb.worker_addresses
+    ]
+
+    wait(dfs, timeout=5)
+
+    assert list(map(lambda x: x.result(), dfs))
+
+
+@pytest.mark.parametrize("n_trials", [1, 5])
+def test_device_isend_irecv(n_trials, request):
+    _test_device_isend_irecv(n_trials, _get_client("client", request))
+
+
+@pytest.mark.parametrize("n_trials", [1, 5])
+@pytest.mark.ucx
+def test_device_isend_irecv_ucx(n_trials, request):
+    _test_device_isend_irecv(n_trials, _get_client("ucx_client", request))
+
+
+@pytest.mark.parametrize("n_trials", [1, 5])
+@pytest.mark.ucxx
+def test_device_isend_irecv_ucxx(n_trials, request):
+    _test_device_isend_irecv(n_trials, _get_client("ucxx_client", request))
+
+
 def _test_device_send_or_recv(n_trials, client):
 
     cb = Comms(comms_p2p=True, verbose=True)
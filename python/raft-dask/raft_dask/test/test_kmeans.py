@@ -0,0 +1,68 @@
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import numpy as np
+import pytest
+
+try:
+    import dask.array as da
+
+    from raft_dask.cluster import kmeans
+
+    pytestmark = pytest.mark.mg
+except ImportError:
+    pytestmark = pytest.mark.skip
+
+
+@pytest.mark.parametrize("weighted", [False, True])
+def test_kmeans_fit(client, weighted):
+    n_clusters, n_features, per_cluster = 8, 16, 1000
+    rng = np.random.default_rng(42)
+    centers = rng.uniform(-100, 100, (n_clusters, n_features))
+    X = np.concatenate(
+        [c + rng.standard_normal((per_cluster, n_features)) for c in centers]
+    ).astype(np.float32)
+    X = X[rng.permutation(X.shape[0])]
+    sample_weight = None
+    if weighted:
+        sample_weight = da.from_array(
+            np.full(X.shape[0], 2, dtype=np.float32), chunks=2000
+        )
+
+    centroids, inertia, n_iter = kmeans.fit(
+        da.from_array(X, chunks=(2000, n_features)),
+        n_clusters,
+        sample_weight=sample_weight,
+        seed=1,
+        client=client,
+    )
+    assert centroids.shape == (n_clusters, n_features)
+    assert n_iter >= 1
+
+    # Every true center is found
+    dist = ((centers[:, None, :] - centroids[None, :, :]) ** 2).sum(axis=2)
+    assert np.all(dist.min(axis=1) < 1.0)
+    expected = ((X[:, None, :] - centroids[None]) ** 2).sum(axis=2).min(1)
+    # The weights are normalized to sum to the number of samples
+    np.testing.assert_allclose(inertia, expected.sum(), rtol=1e-2)
+
+    # Starting from the fitted centroids
+    refit, _, _ = kmeans.fit(
+        da.from_array(X, chunks=(2000, n_features)),
+        n_clusters,
+        centroids=centroids,
+        client=client,
+    )
+    np.testing.assert_allclose(refit, centroids, atol=1e-2)
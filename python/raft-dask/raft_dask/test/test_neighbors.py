@@ -0,0 +1,94 @@
+# Copyright (c) 2024, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import numpy as np
+import pytest
+
+try:
+    import dask.array as da
+
+    from raft_dask.neighbors import ShardedIndex, brute_force
+
+    pytestmark = pytest.mark.mg
+except ImportError:
+    pytestmark = pytest.mark.skip
+
+
+def _recall(neighbors, expected):
+    n = 0
+    for i in range(neighbors.shape[0]):
+        n += np.intersect1d(neighbors[i, :], expected[i, :]).size
+    return n / neighbors.size
+
+
+@pytest.mark.parametrize("algo", ["ivf_flat", "ivf_pq", "cagra"])
+def test_sharded_index(client, algo):
+    n_rows, dim, n_queries, k = 20000, 16, 100, 10
+    rng = np.random.default_rng(42)
+    dataset = rng.random((n_rows, dim), dtype=np.float32)
+    queries = rng.random((n_queries, dim), dtype=np.float32)
+
+    index_params = {"cagra": {}}.get(algo, {"n_lists": 32})
+    search_params = {"cagra": {}}.get(algo, {"n_probes": 32})
+
+    index = ShardedIndex(algo, index_params, client=client)
+    index.build(da.from_array(dataset, chunks=(5000, dim)))
+    assert len(index.shards) == 4
+
+    # The index stays on the workers between the searches
+    for _ in range(2):
+        distances, neighbors = index.search(queries, k, search_params)
+        assert distances.shape == (n_queries, k)
+        assert neighbors.dtype == np.int64
+
+        dist = (dataset**2).sum(axis=1)[None, :] - 2 * queries @ dataset.T
+        expected = np.argsort(dist, axis=1)[:, :k]
+        assert _recall(neighbors, expected) > 0.8
+
+    index.destroy()
+    assert index.shards == []
+
+
+@pytest.mark.parametrize("metric", ["sqeuclidean", "inner_product"])
+def test_brute_force_knn(client, metric):
+    n_rows, dim, n_queries, k = 10000, 16, 300, 10
+    rng = np.random.default_rng(42)
+    dataset = rng.random((n_rows, dim), dtype=np.float32)
+    queries = rng.random((n_queries, dim), dtype=np.float32)
+
+    distances, neighbors = brute_force.knn(
+        da.from_array(dataset, chunks=(2500, dim)),
+        da.from_array(queries, chunks=(70, dim)),
+        k,
+        metric=metric,
+        client=client,
+    )
+    assert distances.shape == (n_queries, k)
+    assert neighbors.dtype == np.int64
+
+    if metric == "inner_product":
+        dist = -queries @ dataset.T
+    else:
+        dist = (
+            (queries**2).sum(axis=1)[:, None]
+            + (dataset**2).sum(axis=1)[None, :]
+            - 2 * queries @ dataset.T
+        )
+    expected = np.argsort(dist, axis=1)[:, :k]
+    assert _recall(neighbors, expected) > 0.99
+    expected_dist = np.take_along_axis(dist, neighbors, axis=1)
+    if metric == "inner_product":
+        expected_dist = -expected_dist
+    np.testing.assert_allclose(distances, expected_dist, atol=1e-3)